@@ -47,6 +47,7 @@
 #include "SDL_loadso.h"
 #include "SDL_log.h"
 #include "SDL_messagebox.h"
+#include "SDL_metrics.h"
 #include "SDL_mutex.h"
 #include "SDL_power.h"
 #include "SDL_render.h"
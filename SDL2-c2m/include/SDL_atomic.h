@@ -47,13 +47,12 @@
  * http://www.1024cores.net/home/lock-free-algorithms
  * http://preshing.com/
  *
- * These operations may or may not actually be implemented using
- * processor specific atomic operations. When possible they are
- * implemented as true processor specific atomic operations. When that
- * is not possible the are implemented using locks that *do* use the
- * available atomic operations.
+ * These operations are implemented as processor specific atomic
+ * operations.  They are never emulated with locks, a platform without
+ * them doesn't build.
  *
- * All of the atomic operations that modify memory are full memory barriers.
+ * All of the atomic operations that modify memory are full memory barriers,
+ * except the native ones taking an explicit SDL_MemoryOrder.
  */
 
 #ifndef _SDL_atomic_h_
@@ -182,6 +181,20 @@ extern DECLSPEC void SDLCALL SDL_MemoryBarrierAcquire();
 #endif
 #endif
 
+/**
+ * A hint to the CPU that it's in a spin loop, so it can save power and give
+ * its resources to a hyperthread sibling.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#define SDL_CPUPauseInstruction()   __asm__ __volatile__ ("pause")
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__aarch64__) || defined(__ARM_ARCH_7A__))
+#define SDL_CPUPauseInstruction()   __asm__ __volatile__ ("yield")
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define SDL_CPUPauseInstruction()   _mm_pause()
+#else
+#define SDL_CPUPauseInstruction()   SDL_CompilerBarrier()
+#endif
+
 /**
  * \brief A type representing an atomic integer value.  It is a struct
  *        so people don't accidentally use numeric operations on it.
@@ -256,6 +269,243 @@ extern DECLSPEC void* SDLCALL SDL_AtomicSetPtr(void **a, void* v);
  */
 extern DECLSPEC void* SDLCALL SDL_AtomicGetPtr(void **a);
 
+/**
+ *  \name Native atomics
+ *
+ *  Inline operations taking an explicit memory order, each compiled to the
+ *  CPU's atomic instruction (or a plain load or store where the order allows
+ *  it).  They never fall back to a lock: they're only defined where the
+ *  compiler has atomic builtins (::SDL_HAS_NATIVE_ATOMICS), the 64-bit ones
+ *  where those are lock-free (::SDL_HAS_ATOMIC64) and the 128-bit compare and
+ *  exchange where the CPU has one (::SDL_HAS_ATOMIC128, x86-64 needs -mcx16).
+ *
+ *  The orders are C11's.  A compare and exchange that fails loads the current
+ *  value into \c expected, with the strongest order allowed on failure.
+ */
+/* @{ */
+typedef enum
+{
+    SDL_MEMORY_ORDER_RELAXED = 0,
+    SDL_MEMORY_ORDER_ACQUIRE = 2,
+    SDL_MEMORY_ORDER_RELEASE = 3,
+    SDL_MEMORY_ORDER_ACQ_REL = 4,
+    SDL_MEMORY_ORDER_SEQ_CST = 5
+} SDL_MemoryOrder;
+
+/**
+ * \brief A 64-bit atomic integer, aligned so it's never split across lines.
+ */
+#if defined(_MSC_VER)
+typedef struct { __declspec(align(8)) Sint64 value; } SDL_atomic64_t;
+#else
+typedef struct { Sint64 value __attribute__((aligned(8))); } SDL_atomic64_t;
+#endif
+
+/**
+ * \brief Two 64-bit words swapped together, for tagged pointers and the like.
+ */
+#if defined(_MSC_VER)
+typedef struct __declspec(align(16)) { Uint64 lo, hi; } SDL_atomic128_t;
+#else
+typedef struct { Uint64 lo, hi; } __attribute__((aligned(16))) SDL_atomic128_t;
+#endif
+
+#if defined(__ATOMIC_SEQ_CST) && defined(__GCC_ATOMIC_INT_LOCK_FREE)
+/* GCC 4.7+ and clang: the orders are the builtins' own values. */
+#define SDL_HAS_NATIVE_ATOMICS 1
+#if __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+#define SDL_HAS_ATOMIC64 1
+#endif
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define SDL_HAS_ATOMIC128 1
+#endif
+
+/* The order to load with when a compare and exchange fails. */
+#define SDL_ATOMIC_FAILURE_ORDER_(o) \
+    ((o) == SDL_MEMORY_ORDER_SEQ_CST ? __ATOMIC_SEQ_CST : \
+     (o) == SDL_MEMORY_ORDER_RELAXED || (o) == SDL_MEMORY_ORDER_RELEASE ? \
+     __ATOMIC_RELAXED : __ATOMIC_ACQUIRE)
+
+#define SDL_ATOMIC_OPS_(T, name, type, at) \
+SDL_FORCE_INLINE T SDL_AtomicLoad##name(type *a, SDL_MemoryOrder order) \
+{ return __atomic_load_n(&(at), (int)order); } \
+SDL_FORCE_INLINE void SDL_AtomicStore##name(type *a, T v, SDL_MemoryOrder order) \
+{ __atomic_store_n(&(at), v, (int)order); } \
+SDL_FORCE_INLINE T SDL_AtomicExchange##name(type *a, T v, SDL_MemoryOrder order) \
+{ return __atomic_exchange_n(&(at), v, (int)order); } \
+SDL_FORCE_INLINE SDL_bool SDL_AtomicCompareExchange##name(type *a, T *expected, \
+    T desired, SDL_MemoryOrder order) \
+{ \
+    return __atomic_compare_exchange_n(&(at), expected, desired, 0, \
+        (int)order, SDL_ATOMIC_FAILURE_ORDER_(order)) ? SDL_TRUE : SDL_FALSE; \
+}
+
+#define SDL_ATOMIC_FETCH_OPS_(T, name, type) \
+SDL_FORCE_INLINE T SDL_AtomicFetchAdd##name(type *a, T v, SDL_MemoryOrder order) \
+{ return __atomic_fetch_add(&a->value, v, (int)order); } \
+SDL_FORCE_INLINE T SDL_AtomicFetchOr##name(type *a, T v, SDL_MemoryOrder order) \
+{ return __atomic_fetch_or(&a->value, v, (int)order); } \
+SDL_FORCE_INLINE T SDL_AtomicFetchAnd##name(type *a, T v, SDL_MemoryOrder order) \
+{ return __atomic_fetch_and(&a->value, v, (int)order); }
+
+SDL_ATOMIC_OPS_(int, , SDL_atomic_t, a->value)
+SDL_ATOMIC_FETCH_OPS_(int, , SDL_atomic_t)
+SDL_ATOMIC_OPS_(void *, Ptr, void *, *a)
+#ifdef SDL_HAS_ATOMIC64
+SDL_ATOMIC_OPS_(Sint64, 64, SDL_atomic64_t, a->value)
+SDL_ATOMIC_FETCH_OPS_(Sint64, 64, SDL_atomic64_t)
+#endif
+
+#define SDL_AtomicThreadFence(order) __atomic_thread_fence((int)(order))
+
+#ifdef SDL_HAS_ATOMIC128
+/* cmpxchg16b (or the CPU's equivalent) is a full barrier. */
+SDL_FORCE_INLINE SDL_bool SDL_AtomicCompareExchange128(SDL_atomic128_t *a,
+    SDL_atomic128_t *expected, SDL_atomic128_t desired)
+{
+    __extension__ typedef unsigned __int128 SDL_uint128_;
+    __extension__ union { SDL_atomic128_t s; SDL_uint128_ v; } old, want, was;
+
+    old.s = *expected;
+    want.s = desired;
+    was.v = __sync_val_compare_and_swap((SDL_uint128_ *)(void *)a,
+        old.v, want.v);
+    if (was.v == old.v) {
+        return SDL_TRUE;
+    }
+    *expected = was.s;
+    return SDL_FALSE;
+}
+#endif
+
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+/* x86 is strongly ordered: loads acquire and stores release as they are, a
+   sequentially consistent store is an exchange.  The compiler barriers keep
+   MSVC from moving other accesses across (volatile alone doesn't with
+   /volatile:iso). */
+#include <intrin.h>
+#define SDL_HAS_NATIVE_ATOMICS 1
+#ifdef _M_X64
+#define SDL_HAS_ATOMIC64 1
+#define SDL_HAS_ATOMIC128 1
+#endif
+
+SDL_FORCE_INLINE int SDL_AtomicLoad(SDL_atomic_t *a, SDL_MemoryOrder order)
+{
+    int v = *(volatile int *)&a->value;
+    (void)order;
+    _ReadWriteBarrier();
+    return v;
+}
+SDL_FORCE_INLINE void SDL_AtomicStore(SDL_atomic_t *a, int v, SDL_MemoryOrder order)
+{
+    if (order == SDL_MEMORY_ORDER_SEQ_CST) {
+        _InterlockedExchange((long *)&a->value, v);
+    } else {
+        _ReadWriteBarrier();
+        *(volatile int *)&a->value = v;
+    }
+}
+SDL_FORCE_INLINE int SDL_AtomicExchange(SDL_atomic_t *a, int v, SDL_MemoryOrder order)
+{ (void)order; return _InterlockedExchange((long *)&a->value, v); }
+SDL_FORCE_INLINE SDL_bool SDL_AtomicCompareExchange(SDL_atomic_t *a,
+    int *expected, int desired, SDL_MemoryOrder order)
+{
+    int was = _InterlockedCompareExchange((long *)&a->value, desired, *expected);
+    (void)order;
+    if (was == *expected) {
+        return SDL_TRUE;
+    }
+    *expected = was;
+    return SDL_FALSE;
+}
+SDL_FORCE_INLINE int SDL_AtomicFetchAdd(SDL_atomic_t *a, int v, SDL_MemoryOrder order)
+{ (void)order; return _InterlockedExchangeAdd((long *)&a->value, v); }
+SDL_FORCE_INLINE int SDL_AtomicFetchOr(SDL_atomic_t *a, int v, SDL_MemoryOrder order)
+{ (void)order; return _InterlockedOr((long *)&a->value, v); }
+SDL_FORCE_INLINE int SDL_AtomicFetchAnd(SDL_atomic_t *a, int v, SDL_MemoryOrder order)
+{ (void)order; return _InterlockedAnd((long *)&a->value, v); }
+
+SDL_FORCE_INLINE void *SDL_AtomicLoadPtr(void **a, SDL_MemoryOrder order)
+{
+    void *v = *(void * volatile *)a;
+    (void)order;
+    _ReadWriteBarrier();
+    return v;
+}
+SDL_FORCE_INLINE void SDL_AtomicStorePtr(void **a, void *v, SDL_MemoryOrder order)
+{
+    if (order == SDL_MEMORY_ORDER_SEQ_CST) {
+        _InterlockedExchangePointer(a, v);
+    } else {
+        _ReadWriteBarrier();
+        *(void * volatile *)a = v;
+    }
+}
+SDL_FORCE_INLINE void *SDL_AtomicExchangePtr(void **a, void *v, SDL_MemoryOrder order)
+{ (void)order; return _InterlockedExchangePointer(a, v); }
+SDL_FORCE_INLINE SDL_bool SDL_AtomicCompareExchangePtr(void **a,
+    void **expected, void *desired, SDL_MemoryOrder order)
+{
+    void *was = _InterlockedCompareExchangePointer(a, desired, *expected);
+    (void)order;
+    if (was == *expected) {
+        return SDL_TRUE;
+    }
+    *expected = was;
+    return SDL_FALSE;
+}
+
+#ifdef SDL_HAS_ATOMIC64
+SDL_FORCE_INLINE Sint64 SDL_AtomicLoad64(SDL_atomic64_t *a, SDL_MemoryOrder order)
+{
+    Sint64 v = *(volatile Sint64 *)&a->value;
+    (void)order;
+    _ReadWriteBarrier();
+    return v;
+}
+SDL_FORCE_INLINE void SDL_AtomicStore64(SDL_atomic64_t *a, Sint64 v, SDL_MemoryOrder order)
+{
+    if (order == SDL_MEMORY_ORDER_SEQ_CST) {
+        _InterlockedExchange64(&a->value, v);
+    } else {
+        _ReadWriteBarrier();
+        *(volatile Sint64 *)&a->value = v;
+    }
+}
+SDL_FORCE_INLINE Sint64 SDL_AtomicExchange64(SDL_atomic64_t *a, Sint64 v, SDL_MemoryOrder order)
+{ (void)order; return _InterlockedExchange64(&a->value, v); }
+SDL_FORCE_INLINE SDL_bool SDL_AtomicCompareExchange64(SDL_atomic64_t *a,
+    Sint64 *expected, Sint64 desired, SDL_MemoryOrder order)
+{
+    Sint64 was = _InterlockedCompareExchange64(&a->value, desired, *expected);
+    (void)order;
+    if (was == *expected) {
+        return SDL_TRUE;
+    }
+    *expected = was;
+    return SDL_FALSE;
+}
+SDL_FORCE_INLINE Sint64 SDL_AtomicFetchAdd64(SDL_atomic64_t *a, Sint64 v, SDL_MemoryOrder order)
+{ (void)order; return _InterlockedExchangeAdd64(&a->value, v); }
+SDL_FORCE_INLINE Sint64 SDL_AtomicFetchOr64(SDL_atomic64_t *a, Sint64 v, SDL_MemoryOrder order)
+{ (void)order; return _InterlockedOr64(&a->value, v); }
+SDL_FORCE_INLINE Sint64 SDL_AtomicFetchAnd64(SDL_atomic64_t *a, Sint64 v, SDL_MemoryOrder order)
+{ (void)order; return _InterlockedAnd64(&a->value, v); }
+
+SDL_FORCE_INLINE SDL_bool SDL_AtomicCompareExchange128(SDL_atomic128_t *a,
+    SDL_atomic128_t *expected, SDL_atomic128_t desired)
+{
+    return _InterlockedCompareExchange128((Sint64 *)a, (Sint64)desired.hi,
+        (Sint64)desired.lo, (Sint64 *)expected) ? SDL_TRUE : SDL_FALSE;
+}
+#endif
+
+#define SDL_AtomicThreadFence(order) \
+    ((order) == SDL_MEMORY_ORDER_SEQ_CST ? _mm_mfence() : _ReadWriteBarrier())
+#endif
+/* @} *//* Native atomics */
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
@@ -429,6 +429,90 @@ extern DECLSPEC SDL_AudioSpec *SDLCALL SDL_LoadWAV_RW(SDL_RWops * src,
  */
 extern DECLSPEC void SDLCALL SDL_FreeWAV(Uint8 * audio_buf);
 
+/**
+ *  An opened WAVE file, from SDL_OpenWAV_RW(), which decodes its audio as
+ *  it's asked for rather than all at once.
+ */
+struct SDL_WAV;
+typedef struct SDL_WAV SDL_WAV;
+
+/**
+ *  This function opens a WAVE from the data source, reading only its
+ *  headers.  The data source has to stay open while the SDL_WAV is; if
+ *  \c freesrc is non-zero, SDL_CloseWAV() closes it (as does this function,
+ *  if it fails).
+ *
+ *  If the data source is a memory stream, such as one from
+ *  SDL_RWFromFileMapped(), the audio data is used where it is:
+ *  SDL_GetWAVData() of raw PCM is a view into that memory, with no copy,
+ *  and ADPCM blocks are decoded from there as they're read.  From any
+ *  other data source, the audio data is read as it's needed.
+ *
+ *  \param src      The data source.
+ *  \param freesrc  Non-zero to close \c src with the SDL_WAV.
+ *  \param spec     Filled with the audio data format of the wave data.
+ *  \param audio_len Set to the length of the decoded audio, in bytes (if
+ *                  not NULL).
+ *  \return The opened WAVE, or NULL (and the SDL error message is set) if
+ *          the wave file cannot be opened, uses an unknown data format, or
+ *          is corrupt.
+ *
+ *  \sa SDL_GetWAVData
+ *  \sa SDL_ReadWAV
+ *  \sa SDL_CloseWAV
+ */
+extern DECLSPEC SDL_WAV *SDLCALL SDL_OpenWAV_RW(SDL_RWops * src,
+                                               int freesrc,
+                                               SDL_AudioSpec * spec,
+                                               Uint32 * audio_len);
+
+/**
+ *  Opens a WAV file, memory mapped where the platform supports it.
+ */
+#define SDL_OpenWAV(file, spec, audio_len) \
+    SDL_OpenWAV_RW(SDL_RWFromFileMapped(file), 1, spec, audio_len)
+
+/**
+ *  Get all of a WAVE's decoded audio.
+ *
+ *  Raw PCM from a memory stream is returned in place; anything else is
+ *  decoded (or read) into a buffer the first time this is called.  The
+ *  audio stays valid until SDL_CloseWAV().
+ *
+ *  \param wav       The WAVE.
+ *  \param audio_len Set to the length of the audio, in bytes (if not NULL).
+ *  \return The audio, or NULL on error.
+ */
+extern DECLSPEC const Uint8 *SDLCALL SDL_GetWAVData(SDL_WAV * wav,
+                                                    Uint32 * audio_len);
+
+/**
+ *  Read a WAVE's decoded audio, from where the last read ended (or where
+ *  SDL_SeekWAV() put it), decoding only the ADPCM blocks it needs.
+ *
+ *  \param wav  The WAVE.
+ *  \param buf  The buffer to fill.
+ *  \param len  The most bytes to read.
+ *  \return The bytes read, 0 at the end of the audio or on error.
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_ReadWAV(SDL_WAV * wav, void *buf,
+                                           Uint32 len);
+
+/**
+ *  Set where in a WAVE's decoded audio SDL_ReadWAV() reads next.
+ *
+ *  \param wav  The WAVE.
+ *  \param pos  The byte to read next, up to the audio's length.
+ *  \return 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_SeekWAV(SDL_WAV * wav, Uint32 pos);
+
+/**
+ *  Close a WAVE from SDL_OpenWAV_RW(), freeing its audio, and its data
+ *  source if it was opened to.
+ */
+extern DECLSPEC void SDLCALL SDL_CloseWAV(SDL_WAV * wav);
+
 /**
  *  This function takes a source format and rate and a destination format
  *  and rate, and initializes the \c cvt structure with information needed
@@ -458,6 +542,149 @@ extern DECLSPEC int SDLCALL SDL_BuildAudioCVT(SDL_AudioCVT * cvt,
  */
 extern DECLSPEC int SDLCALL SDL_ConvertAudio(SDL_AudioCVT * cvt);
 
+/**
+ *  \brief A resampler for audio given a bit at a time, e.g. as it's decoded.
+ *
+ *  \sa SDL_NewAudioResampler()
+ */
+struct SDL_AudioResampler;
+typedef struct SDL_AudioResampler SDL_AudioResampler;
+
+/**
+ *  \brief Create a resampler of audio from one rate to another.
+ *
+ *  \param format   The samples' format, ::AUDIO_S16SYS or ::AUDIO_F32SYS.
+ *  \param channels The number of channels, interleaved.
+ *  \param src_rate The rate of the audio put in.
+ *  \param dst_rate The rate of the audio to give out.
+ *
+ *  \return The resampler, or NULL on error.
+ *
+ *  \sa SDL_ResampleAudio()
+ *  \sa SDL_FreeAudioResampler()
+ */
+extern DECLSPEC SDL_AudioResampler * SDLCALL SDL_NewAudioResampler(SDL_AudioFormat format,
+                                                                   Uint8 channels,
+                                                                   int src_rate,
+                                                                   int dst_rate);
+
+/**
+ *  \brief Put audio into a resampler and get what's resampled out of it.
+ *
+ *  \param resampler The resampler.
+ *  \param src       The audio to put in, which may be NULL if src_len is 0.
+ *  \param src_len   The bytes of it, a whole number of frames.
+ *  \param dst       Where to put the resampled audio.
+ *  \param dst_len   The bytes there's room for there.
+ *
+ *  \return The bytes put in dst, or -1 on error.
+ *
+ *  The audio resampled is as if all that's been put in was put in at once,
+ *  so it can be given in buffers of any size, with no clicks between them.
+ *  What doesn't fit in dst comes out of the next calls, which can put in
+ *  nothing more.  A few milliseconds of the audio put in are needed to
+ *  resample what's before them, so the last of it comes out once that
+ *  much more audio, or silence, has been put in.
+ */
+extern DECLSPEC int SDLCALL SDL_ResampleAudio(SDL_AudioResampler * resampler,
+                                              const void *src, int src_len,
+                                              void *dst, int dst_len);
+
+/**
+ *  \brief Free a resampler made with SDL_NewAudioResampler().
+ */
+extern DECLSPEC void SDLCALL SDL_FreeAudioResampler(SDL_AudioResampler * resampler);
+
+/**
+ *  \brief A converter of audio put in a bit at a time, as it's decoded or
+ *         received, to be got out in another format, channels and rate.
+ *
+ *  \sa SDL_NewAudioStream()
+ */
+struct SDL_AudioStream;
+typedef struct SDL_AudioStream SDL_AudioStream;
+
+/**
+ *  \brief Create a stream converting audio.
+ *
+ *  \param src_format   The format of the audio put in.
+ *  \param src_channels Its channels.
+ *  \param src_rate     Its rate.
+ *  \param dst_format   The format of the audio to get out.
+ *  \param dst_channels Its channels.
+ *  \param dst_rate     Its rate.
+ *
+ *  \return The stream, or NULL on error.
+ *
+ *  The channels are converted as SDL_BuildAudioCVT() does, and the rate as
+ *  an SDL_AudioResampler does.
+ *
+ *  \sa SDL_AudioStreamPut()
+ *  \sa SDL_AudioStreamGet()
+ *  \sa SDL_AudioStreamAvailable()
+ *  \sa SDL_AudioStreamFlush()
+ *  \sa SDL_AudioStreamClear()
+ *  \sa SDL_FreeAudioStream()
+ */
+extern DECLSPEC SDL_AudioStream * SDLCALL SDL_NewAudioStream(SDL_AudioFormat src_format,
+                                                             Uint8 src_channels,
+                                                             int src_rate,
+                                                             SDL_AudioFormat dst_format,
+                                                             Uint8 dst_channels,
+                                                             int dst_rate);
+
+/**
+ *  \brief Put audio into a stream, to be converted.
+ *
+ *  \param stream The stream.
+ *  \param buf    The audio, which may be NULL if len is 0.
+ *  \param len    The bytes of it, which needn't be whole frames: the rest
+ *                of a frame can be put in next.
+ *
+ *  \return 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamPut(SDL_AudioStream * stream,
+                                               const void *buf, int len);
+
+/**
+ *  \brief Get converted audio out of a stream.
+ *
+ *  \param stream The stream.
+ *  \param buf    Where to put the audio.
+ *  \param len    The bytes there's room for there.
+ *
+ *  \return The bytes put in buf, whole frames, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamGet(SDL_AudioStream * stream,
+                                               void *buf, int len);
+
+/**
+ *  \brief The bytes of converted audio a stream has to get.
+ *
+ *  Converting a rate needs a few milliseconds of the audio put in after
+ *  what it converts, so that much doesn't come out until more is put in,
+ *  or SDL_AudioStreamFlush() is called.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamAvailable(SDL_AudioStream * stream);
+
+/**
+ *  \brief End the audio put in a stream: all of it's converted, to be got,
+ *         and what's put in next starts anew.
+ *
+ *  \return 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_AudioStreamFlush(SDL_AudioStream * stream);
+
+/**
+ *  \brief Drop all the audio a stream has, converted or not.
+ */
+extern DECLSPEC void SDLCALL SDL_AudioStreamClear(SDL_AudioStream * stream);
+
+/**
+ *  \brief Free a stream made with SDL_NewAudioStream().
+ */
+extern DECLSPEC void SDLCALL SDL_FreeAudioStream(SDL_AudioStream * stream);
+
 #define SDL_MIX_MAXVOLUME 128
 /**
  *  This takes two audio buffers of the playing audio format and mixes
@@ -479,6 +706,27 @@ extern DECLSPEC void SDLCALL SDL_MixAudioFormat(Uint8 * dst,
                                                 SDL_AudioFormat format,
                                                 Uint32 len, int volume);
 
+/**
+ *  This mixes a number of audio buffers, of the same format, into dst, as
+ *  many calls of SDL_MixAudioFormat() would, but in one pass over dst.
+ *  Each voice is adjusted to its volume as SDL_MixAudioFormat() does, but
+ *  the sums are clipped once, at the end, instead of after each voice.
+ *
+ *  \param dst      The buffer to mix into, \c len bytes long.
+ *  \param srcs     The \c num_srcs buffers to mix, each \c len bytes long.
+ *  \param volumes  Each one's volume, from 0 to ::SDL_MIX_MAXVOLUME, or NULL
+ *                  for ::SDL_MIX_MAXVOLUME for all.
+ *  \param num_srcs The number of buffers to mix.
+ *  \param format   Their format.
+ *  \param len      The bytes in each buffer.
+ */
+extern DECLSPEC void SDLCALL SDL_MixAudioMany(Uint8 * dst,
+                                              const Uint8 * const * srcs,
+                                              const int *volumes,
+                                              int num_srcs,
+                                              SDL_AudioFormat format,
+                                              Uint32 len);
+
 /**
  *  Queue more audio on non-callback devices.
  *
@@ -497,7 +745,8 @@ extern DECLSPEC void SDLCALL SDL_MixAudioFormat(Uint8 * dst,
  *  This function copies the supplied data, so you are safe to free it when
  *  the function returns. This function is thread-safe, but queueing to the
  *  same device from two threads at once does not promise which buffer will
- *  be queued first.
+ *  be queued first. The audio device's thread takes queued data without a
+ *  lock, so queueing never waits on it, nor it on you.
  *
  *  You may not queue audio on a device that is using an application-supplied
  *  callback; doing so returns an error. You have to use the audio callback
@@ -572,6 +821,44 @@ extern DECLSPEC Uint32 SDLCALL SDL_GetQueuedAudioSize(SDL_AudioDeviceID dev);
  */
 extern DECLSPEC void SDLCALL SDL_ClearQueuedAudio(SDL_AudioDeviceID dev);
 
+/**
+ *  Get how far ahead of the speakers the queued audio is, in milliseconds.
+ *
+ *  This is SDL_GetQueuedAudioSize() as time at the device's rate: how long
+ *  what you've queued will keep the device playing, and so how late what you
+ *  queue now will be heard.
+ *
+ *  You may not queue audio on a device that is using an application-supplied
+ *  callback; calling this function on such a device always returns 0.
+ *
+ *  \param dev The device ID of which we will query the queue's latency.
+ *  \return Milliseconds of queued audio.
+ *
+ *  \sa SDL_GetQueuedAudioSize
+ *  \sa SDL_GetQueuedAudioUnderruns
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_GetQueuedAudioLatency(SDL_AudioDeviceID dev);
+
+/**
+ *  Get the number of times the device ran out of queued audio.
+ *
+ *  Each time the device needs audio while playing and there isn't enough
+ *  queued, it plays silence and this count goes up once; it doesn't go up
+ *  again until the device has had a full buffer of audio. Silence before
+ *  anything is queued, or after SDL_ClearQueuedAudio(), isn't counted, but
+ *  running out at the end of what you meant to play is.
+ *
+ *  You may not queue audio on a device that is using an application-supplied
+ *  callback; calling this function on such a device always returns 0.
+ *
+ *  \param dev The device ID of which we will query the queue's underruns.
+ *  \return The times the queue has run dry since the device was opened.
+ *
+ *  \sa SDL_QueueAudio
+ *  \sa SDL_GetQueuedAudioLatency
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_GetQueuedAudioUnderruns(SDL_AudioDeviceID dev);
+
 
 /**
  *  \name Audio lock functions
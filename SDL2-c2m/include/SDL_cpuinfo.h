@@ -89,6 +89,42 @@ extern DECLSPEC int SDLCALL SDL_GetCPUCount(void);
  */
 extern DECLSPEC int SDLCALL SDL_GetCPUCacheLineSize(void);
 
+/**
+ *  The number of logical CPUs the topology functions know about: they number
+ *  CPUs as the OS does, from 0 to SDL_CPU_TOPOLOGY_MAX - 1.
+ */
+#define SDL_CPU_TOPOLOGY_MAX 256
+
+/**
+ *  This function returns the number of physical CPU cores, counting the
+ *  logical CPUs that share one by SMT (hyper-threading) once.
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCoreCount(void);
+
+/**
+ *  This function returns the size in bytes of the data (or unified) CPU cache
+ *  at \c level (1 for L1, up to 4), or 0 if there isn't one or it's unknown.
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCacheSize(int level);
+
+/**
+ *  This function returns the physical core logical CPU \c cpu runs on, from 0
+ *  to SDL_GetCPUCoreCount() - 1: SMT siblings have the same one.  It returns
+ *  -1 if there is no such CPU.
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUCore(int cpu);
+
+/**
+ *  This function returns the number of NUMA nodes, 1 on a uniform system.
+ */
+extern DECLSPEC int SDLCALL SDL_GetNUMANodeCount(void);
+
+/**
+ *  This function returns the NUMA node logical CPU \c cpu belongs to, from 0
+ *  to SDL_GetNUMANodeCount() - 1, or -1 if there is no such CPU.
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUNUMANode(int cpu);
+
 /**
  *  This function returns true if the CPU has the RDTSC instruction.
  */
@@ -144,6 +180,59 @@ extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX(void);
  */
 extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX2(void);
 
+/**
+ *  This function returns true if the CPU has AVX-512 Foundation features.
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasAVX512F(void);
+
+/**
+ *  This function returns true if the CPU has the BMI2 instructions.
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasBMI2(void);
+
+/**
+ *  This function returns true if the CPU has NEON features.
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_HasNEON(void);
+
+/**
+ *  \name CPU features
+ *
+ *  The bits of SDL_GetCPUFeatureMask().
+ */
+/* @{ */
+#define SDL_CPUFEATURE_RDTSC    0x00000001
+#define SDL_CPUFEATURE_ALTIVEC  0x00000002
+#define SDL_CPUFEATURE_MMX      0x00000004
+#define SDL_CPUFEATURE_3DNOW    0x00000008
+#define SDL_CPUFEATURE_SSE      0x00000010
+#define SDL_CPUFEATURE_SSE2     0x00000020
+#define SDL_CPUFEATURE_SSE3     0x00000040
+#define SDL_CPUFEATURE_SSE41    0x00000100
+#define SDL_CPUFEATURE_SSE42    0x00000200
+#define SDL_CPUFEATURE_AVX      0x00000400
+#define SDL_CPUFEATURE_AVX2     0x00000800
+#define SDL_CPUFEATURE_AVX512F  0x00001000
+#define SDL_CPUFEATURE_BMI2     0x00002000
+#define SDL_CPUFEATURE_NEON     0x00004000
+/* @} */
+
+/**
+ *  This function returns all the CPU features as SDL_CPUFEATURE_* bits.
+ *  They're detected once, the SDL_Has*() functions test the same bits.
+ *
+ *  \sa SDL_HINT_CPU_FEATURE_MASK
+ */
+extern DECLSPEC Uint32 SDLCALL SDL_GetCPUFeatureMask(void);
+
+/**
+ *  This function chooses among the \c count variants of a kernel, best first:
+ *  \c needs[i] are the SDL_CPUFEATURE_* bits variant \c i needs.  It returns
+ *  the first one the CPU can run, or -1 if none.  Give the plain C variant 0
+ *  to always get one, and keep the result: the features never change.
+ */
+extern DECLSPEC int SDLCALL SDL_GetCPUVariant(const Uint32 *needs, int count);
+
 /**
  *  This function returns the amount of RAM configured in the system, in MB.
  */
@@ -624,6 +624,18 @@ extern DECLSPEC void SDLCALL SDL_FlushEvents(Uint32 minType, Uint32 maxType);
  */
 extern DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event * event);
 
+/**
+ *  \brief Polls for currently pending events, many at a time.
+ *
+ *  Pumps the event loop once and then removes up to \c numevents events of
+ *  any type from the queue; a loop over this takes the queue lock once per
+ *  batch rather than once per event as SDL_PollEvent() does.
+ *
+ *  \return The number of events stored in \c events, or -1 if there was an
+ *          error.
+ */
+extern DECLSPEC int SDLCALL SDL_PollEvents(SDL_Event * events, int numevents);
+
 /**
  *  \brief Waits indefinitely for the next available event.
  *
@@ -123,8 +123,11 @@ extern "C" {
  *
  *  This variable can be set to the following values:
  *    "0" or "nearest" - Nearest pixel sampling
- *    "1" or "linear"  - Linear filtering (supported by OpenGL and Direct3D)
- *    "2" or "best"    - Currently this is the same as "linear"
+ *    "1" or "linear"  - Linear filtering (supported by OpenGL, Direct3D and
+ *                       the software renderer, for 32-bit textures)
+ *    "2" or "best"    - Currently this is the same as "linear", except that
+ *                       the software renderer averages the pixels covered
+ *                       when shrinking
  *
  *  By default nearest pixel sampling is used
  */
@@ -361,6 +364,27 @@ extern "C" {
  */
 #define SDL_HINT_TIMER_RESOLUTION "SDL_TIMER_RESOLUTION"
 
+/**
+ *  \brief  A variable controlling whether SDL_GetFastPerformanceCounter() uses the TSC
+ *
+ *  This variable can be set to the following values:
+ *    "0"       - SDL_GetFastPerformanceCounter() is SDL_GetPerformanceCounter()
+ *    "1"       - The TSC is used if the CPU's is invariant (default)
+ *
+ *  This hint is checked when the timer starts, at SDL_Init() or the first
+ *  timer call.
+ */
+#define SDL_HINT_TIMER_TSC "SDL_TIMER_TSC"
+
+/**
+ *  \brief  A mask of SDL_CPUFEATURE_* bits ANDed with the CPU's features
+ *
+ *  Read once, when the features are first detected.  "0" runs the plain C
+ *  kernels everywhere, e.g. "0xfff" hides AVX-512, BMI2 and NEON, which is
+ *  useful to test the fallbacks.  Decimal, hex with 0x, or octal.
+ */
+#define SDL_HINT_CPU_FEATURE_MASK "SDL_CPU_FEATURE_MASK"
+
 
 
 /**
@@ -630,6 +654,104 @@ extern "C" {
  */
 #define SDL_HINT_WINDOWS_NO_CLOSE_ON_ALT_F4	"SDL_WINDOWS_NO_CLOSE_ON_ALT_F4"
 
+/**
+ *  \brief Tell SDL to split large software blits, fills and stretches into row bands run on several threads.
+ *
+ * Surfaces of fewer than 512x512 pixels are always worked on by the calling
+ * thread, as are blits from a surface onto itself.
+ *
+ * The variable can be set to the following values:
+ *   "0"       - Every blit, fill and stretch runs on the calling thread.
+ *   "N"       - Large ones are split between the calling thread and up to
+ *               N - 1 worker threads (e.g. the result of SDL_GetCPUCount()).
+ *
+ * By default SDL runs them on the calling thread.
+ */
+#define SDL_HINT_BLIT_THREADS   "SDL_BLIT_THREADS"
+
+/**
+ *  \brief Tell the software renderer whether to record drawing and run it in batches.
+ *
+ * Batched, draws of the same kind, color, blend mode and texture are merged
+ * into one fill or blit where nothing else drawn in between overlaps them,
+ * and happen at SDL_RenderPresent(), SDL_RenderFlush() or when the target,
+ * a texture, the viewport or the clip rectangle changes.
+ *
+ * The variable can be set to the following values:
+ *   "0"       - Everything is drawn as it is called.
+ *   "1"       - Drawing is batched.
+ *
+ * By default renderers for windows batch, renderers for surfaces (from
+ * SDL_CreateSoftwareRenderer()) don't, since the application may read the
+ * surface at any time.  The hint is read when the renderer is created.
+ */
+#define SDL_HINT_RENDER_BATCHING   "SDL_RENDER_BATCHING"
+
+/**
+ *  \brief Tell the software renderer whether to keep the surfaces it rotates for SDL_RenderCopyEx() to draw again.
+ *
+ * Up to 32 are kept, in 16 MB, and dropped when their texture is updated,
+ * locked or drawn on.
+ *
+ * The variable can be set to the following values:
+ *   "0"       - Every rotated copy is made afresh.
+ *   "1"       - Rotated copies are kept.
+ *
+ * By default they're kept.  The hint is read when the renderer is created.
+ */
+#define SDL_HINT_RENDER_ROTATE_CACHE   "SDL_RENDER_ROTATE_CACHE"
+
+/**
+ *  \brief Tell SDL which matrix to use for the YUV textures it converts to RGB itself.
+ *
+ * The variable can be set to the following values:
+ *   "JPEG"      - Full range BT.601, as JPEG uses.
+ *   "BT601"     - Limited range BT.601, as SD video uses.
+ *   "BT709"     - Limited range BT.709, as HD video uses.
+ *   "AUTOMATIC" - BT601 for textures up to 576 lines high, BT709 above.
+ *
+ * By default JPEG is used.  The hint is read when the texture is created.
+ */
+#define SDL_HINT_YUV_CONVERSION_MODE   "SDL_YUV_CONVERSION_MODE"
+
+/**
+ *  \brief Tell SDL whether SDL_UpdateWindowSurface() updates only what's changed on the window surface.
+ *
+ * With damage tracking, SDL notes the rectangles of the window surface that
+ * its own fills, blits, stretches and line and point drawing change (merged
+ * into at most 16), and SDL_UpdateWindowSurface() updates just those.
+ * SDL_LockSurface() and the window being exposed or restored mark all of
+ * it changed.  Pixels written directly without locking aren't seen: update
+ * those with SDL_UpdateWindowSurfaceRects().
+ *
+ * The variable can be set to the following values:
+ *   "0"       - SDL_UpdateWindowSurface() updates the whole window.
+ *   "1"       - Only what's changed is updated.
+ *
+ * By default the software renderer's windows track damage, and surfaces
+ * from SDL_GetWindowSurface() don't.  The hint is read when the window
+ * surface is created.
+ */
+#define SDL_HINT_WINDOW_SURFACE_DAMAGE   "SDL_WINDOW_SURFACE_DAMAGE"
+
+/**
+ *  \brief Tell SDL whether to merge bursts of mouse motion and window events in the event queue.
+ *
+ * With coalescing, a mouse motion event queued right after another of the
+ * same mouse, window and button state is merged into it: it gets the newer
+ * position and the sum of both relative motions.  Likewise a window's
+ * SDL_WINDOWEVENT_EXPOSED, _MOVED, _RESIZED or _SIZE_CHANGED queued right
+ * after one of the same kind replaces it.  Event watchers still see every
+ * event.
+ *
+ * The variable can be set to the following values:
+ *   "0"       - Every event is queued.
+ *   "1"       - Consecutive events are merged.
+ *
+ * By default every event is queued.
+ */
+#define SDL_HINT_EVENT_COALESCING   "SDL_EVENT_COALESCING"
+
 /**
  *  \brief  An enumeration of hint priorities
  */
@@ -669,6 +791,45 @@ extern DECLSPEC SDL_bool SDLCALL SDL_SetHint(const char *name,
  */
 extern DECLSPEC const char * SDLCALL SDL_GetHint(const char *name);
 
+/**
+ *  \brief A function turning a hint's string value into a number
+ *
+ *  \param value The hint's value, or NULL if it isn't set
+ *  \param default_value The handle's default value
+ */
+typedef int (SDLCALL *SDL_HintParser)(const char *value, int default_value);
+
+/**
+ *  \brief A hint's parsed value, kept for code which reads it often
+ *
+ *  Declare one, usually static, with SDL_HINT_HANDLE_INIT() and read it
+ *  with SDL_GetHintValue().  Without a parser, "0" and "false" are 0,
+ *  "true" is 1 and anything else is read as a number.
+ */
+typedef struct SDL_HintHandle
+{
+    const char *name;
+    int default_value;          /**< The value when the hint isn't set */
+    SDL_HintParser parse;       /**< NULL, or a function to parse it */
+    int value;                  /**< The last value parsed */
+    int generation;             /**< Which hints the value was parsed from */
+} SDL_HintHandle;
+
+#define SDL_HINT_HANDLE_INIT(name, default_value, parse) \
+    { name, default_value, parse, 0, 0 }
+
+/**
+ *  \brief Get a hint's parsed value through a handle
+ *
+ *  The hint is looked up and parsed again only when some hint has been set
+ *  since the handle was last read, so usually this is a single load.
+ *  Environment variables are read when the value is parsed: changing one
+ *  later isn't seen until a hint is set or cleared.
+ *
+ *  \return The parsed value, or the handle's default if the hint isn't set
+ */
+extern DECLSPEC int SDLCALL SDL_GetHintValue(SDL_HintHandle *handle);
+
 /**
  *  \brief Add a function to watch a particular hint
  *
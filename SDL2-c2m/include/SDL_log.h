@@ -199,6 +199,27 @@ extern DECLSPEC void SDLCALL SDL_LogGetOutputFunction(SDL_LogOutputFunction *cal
  */
 extern DECLSPEC void SDLCALL SDL_LogSetOutputFunction(SDL_LogOutputFunction callback, void *userdata);
 
+/**
+ *  \brief Format and output log messages on a background thread.
+ *
+ *  While it's on, the log functions copy a message's format string pointer
+ *  and arguments into a buffer of the calling thread and return, without
+ *  formatting it.  Format strings must stay valid until the message is
+ *  output (string literals do), string arguments are copied.  Each thread's
+ *  messages are output in the order they were logged.
+ *
+ *  Turning it off outputs the messages still waiting.  Don't while other
+ *  threads are logging.
+ *
+ *  \return 0 on success, or -1 if the background thread couldn't start.
+ */
+extern DECLSPEC int SDLCALL SDL_LogSetAsync(SDL_bool async);
+
+/**
+ *  \brief Output the log messages waiting for the background thread now.
+ */
+extern DECLSPEC void SDLCALL SDL_LogFlush(void);
+
 
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
@@ -0,0 +1,116 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef _SDL_metrics_h
+#define _SDL_metrics_h
+
+/**
+ *  \file SDL_metrics.h
+ *
+ *  Counters and latency histograms, cheap to update from any thread.
+ *
+ *  Each thread updates its own copy of a metric, with a plain load and
+ *  store instead of an atomic add on a shared cache line, and the copies
+ *  are added up when the metric is read.  A histogram counts values in
+ *  log-linear buckets (16 per power of two, so a quantile is within 1/16
+ *  of the value), like HDR histograms.  Metrics are created once and last
+ *  until the program exits; all of them can be written out in Prometheus'
+ *  text format to any stream, a file or a socket (SDL_RWFromTCP()).
+ */
+
+#include "SDL_stdinc.h"
+#include "SDL_rwops.h"
+
+#include "begin_code.h"
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  \brief A counter or a histogram.
+ */
+typedef struct SDL_Metric SDL_Metric;
+
+/**
+ *  Create a counter, or get the one already named \c name.
+ *
+ *  \param name Its name in the export, [a-zA-Z_:][a-zA-Z0-9_:]*.
+ *  \param help What it counts, or NULL.
+ *  \return The counter, or NULL if the name isn't valid or is a histogram's.
+ */
+extern DECLSPEC SDL_Metric *SDLCALL SDL_CreateCounter(const char *name,
+                                                      const char *help);
+
+/**
+ *  Create a histogram, or get the one already named \c name.
+ *
+ *  \return The histogram, or NULL if the name isn't valid or is a counter's.
+ *
+ *  \sa SDL_CreateCounter()
+ */
+extern DECLSPEC SDL_Metric *SDLCALL SDL_CreateHistogram(const char *name,
+                                                        const char *help);
+
+/**
+ *  Add \c value to a counter.
+ */
+extern DECLSPEC void SDLCALL SDL_CounterAdd(SDL_Metric * counter,
+                                            Sint64 value);
+
+/**
+ *  Count \c value (a latency in microseconds, a size, ...) in a histogram.
+ */
+extern DECLSPEC void SDLCALL SDL_HistogramRecord(SDL_Metric * histogram,
+                                                 Uint64 value);
+
+/**
+ *  Get a counter's value, or how many values a histogram has counted.
+ */
+extern DECLSPEC Sint64 SDLCALL SDL_GetMetricCount(SDL_Metric * metric);
+
+/**
+ *  Get the value a fraction \c q (0 to 1) of a histogram's values are at or
+ *  below, as the top of its bucket.
+ *
+ *  \return The value, or 0 if there are none.
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetMetricQuantile(SDL_Metric * metric,
+                                                     double q);
+
+/**
+ *  Write every metric to \c dst in Prometheus' text format.  A histogram's
+ *  buckets are cumulative at each power of two (le="0", "1", "3", "7", ...)
+ *  up to its largest value.
+ *
+ *  \return 0 on success, -1 if \c dst couldn't be written.
+ */
+extern DECLSPEC int SDLCALL SDL_WriteMetrics(SDL_RWops * dst);
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+#include "close_code.h"
+
+#endif /* _SDL_metrics_h */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -30,6 +30,7 @@
 
 #include "SDL_stdinc.h"
 #include "SDL_error.h"
+#include "SDL_atomic.h"
 
 #include "begin_code.h"
 /* Set up for C function definitions, even when using C++ */
@@ -97,6 +98,217 @@ extern DECLSPEC void SDLCALL SDL_DestroyMutex(SDL_mutex * mutex);
 /* @} *//* Mutex functions */
 
 
+#ifdef SDL_HAS_NATIVE_ATOMICS
+/**
+ *  \name Spin mutex functions
+ *
+ *  A lightweight mutex for short critical sections on hot paths.  It's a
+ *  word that needs no creating or destroying (zero is unlocked, see
+ *  ::SDL_SPINMUTEX_INIT), locked inline with one compare and exchange when
+ *  it's free.  A contended lock spins a little, then sleeps (on a futex
+ *  where there is one): unlike ::SDL_SpinLock it doesn't burn a core while
+ *  the holder is descheduled.  It is not recursive.
+ */
+/* @{ */
+
+typedef struct
+{
+    SDL_atomic_t state;     /* 0 unlocked, 1 locked, 2 locked with sleepers */
+} SDL_SpinMutex;
+
+#define SDL_SPINMUTEX_INIT  { { 0 } }
+
+/**
+ *  The contended part of SDL_SpinMutexLock(), spins then sleeps.
+ */
+extern DECLSPEC void SDLCALL SDL_SpinMutexLockContended(SDL_SpinMutex * mutex);
+
+/**
+ *  Wake a thread sleeping in SDL_SpinMutexLockContended().
+ */
+extern DECLSPEC void SDLCALL SDL_SpinMutexWake(SDL_SpinMutex * mutex);
+
+/**
+ *  Lock the spin mutex.
+ */
+SDL_FORCE_INLINE void SDL_SpinMutexLock(SDL_SpinMutex * mutex)
+{
+    int unlocked = 0;
+    if (!SDL_AtomicCompareExchange(&mutex->state, &unlocked, 1,
+                                   SDL_MEMORY_ORDER_ACQUIRE)) {
+        SDL_SpinMutexLockContended(mutex);
+    }
+}
+
+/**
+ *  Try to lock the spin mutex.
+ *
+ *  \return SDL_TRUE if it was locked, SDL_FALSE if it's held.
+ */
+SDL_FORCE_INLINE SDL_bool SDL_SpinMutexTryLock(SDL_SpinMutex * mutex)
+{
+    int unlocked = 0;
+    return SDL_AtomicCompareExchange(&mutex->state, &unlocked, 1,
+                                     SDL_MEMORY_ORDER_ACQUIRE);
+}
+
+/**
+ *  Unlock the spin mutex, held by the current thread.
+ */
+SDL_FORCE_INLINE void SDL_SpinMutexUnlock(SDL_SpinMutex * mutex)
+{
+    if (SDL_AtomicExchange(&mutex->state, 0, SDL_MEMORY_ORDER_RELEASE) == 2) {
+        SDL_SpinMutexWake(mutex);
+    }
+}
+
+/* @} *//* Spin mutex functions */
+#endif /* SDL_HAS_NATIVE_ATOMICS */
+
+
+/**
+ *  \name Reader-writer lock functions
+ *
+ *  Any number of readers or one writer at a time, for data that's read far
+ *  more often than it's changed.  Writers are preferred: once one waits, new
+ *  readers wait behind it, so a steady stream of readers can't starve it.
+ *  It is not recursive, and a reader can't upgrade to writing.
+ */
+/* @{ */
+
+/* The SDL reader-writer lock structure, defined in SDL_sysrwlock.c */
+struct SDL_rwlock;
+typedef struct SDL_rwlock SDL_rwlock;
+
+/**
+ *  Create a reader-writer lock, initialized unlocked.
+ */
+extern DECLSPEC SDL_rwlock *SDLCALL SDL_CreateRWLock(void);
+
+/**
+ *  Lock for reading, shared with other readers.
+ *
+ *  \return 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_LockRWLockForReading(SDL_rwlock * rwlock);
+
+/**
+ *  Lock for writing, exclusively.
+ *
+ *  \return 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_LockRWLockForWriting(SDL_rwlock * rwlock);
+
+/**
+ *  Try to lock for reading.
+ *
+ *  \return 0, SDL_MUTEX_TIMEDOUT, or -1 on error
+ */
+extern DECLSPEC int SDLCALL SDL_TryLockRWLockForReading(SDL_rwlock * rwlock);
+
+/**
+ *  Try to lock for writing.
+ *
+ *  \return 0, SDL_MUTEX_TIMEDOUT, or -1 on error
+ */
+extern DECLSPEC int SDLCALL SDL_TryLockRWLockForWriting(SDL_rwlock * rwlock);
+
+/**
+ *  Unlock, held for reading or writing by the current thread.
+ *
+ *  \return 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_UnlockRWLock(SDL_rwlock * rwlock);
+
+/**
+ *  Destroy a reader-writer lock.
+ */
+extern DECLSPEC void SDLCALL SDL_DestroyRWLock(SDL_rwlock * rwlock);
+
+/* @} *//* Reader-writer lock functions */
+
+
+#ifdef SDL_HAS_NATIVE_ATOMICS
+/**
+ *  \name Sequence lock functions
+ *
+ *  For a small snapshot (a few plain values) read often from many threads:
+ *  readers never write shared memory, they copy the data and retry if a
+ *  writer changed it meanwhile.  Writers exclude each other and never wait
+ *  for readers.
+ *
+ *  \code
+ *  do {
+ *      seq = SDL_SeqLockReadBegin(&lock);
+ *      copy = SDL_AtomicLoad(&shared, SDL_MEMORY_ORDER_RELAXED);
+ *  } while (SDL_SeqLockReadRetry(&lock, seq));
+ *  \endcode
+ *
+ *  The data is read and written with relaxed native atomics, a plain access
+ *  would race with the other side.
+ */
+/* @{ */
+
+typedef struct
+{
+    SDL_atomic_t seq;       /* Odd while it's written */
+} SDL_SeqLock;
+
+#define SDL_SEQLOCK_INIT    { { 0 } }
+
+/**
+ *  Start reading, returns the sequence to pass SDL_SeqLockReadRetry().
+ */
+SDL_FORCE_INLINE int SDL_SeqLockReadBegin(SDL_SeqLock * lock)
+{
+    int seq;
+    while ((seq = SDL_AtomicLoad(&lock->seq, SDL_MEMORY_ORDER_ACQUIRE)) & 1) {
+        SDL_CPUPauseInstruction();
+    }
+    return seq;
+}
+
+/**
+ *  Finish reading.
+ *
+ *  \return SDL_TRUE if it was written meanwhile, and what was read must be
+ *          read again.
+ */
+SDL_FORCE_INLINE SDL_bool SDL_SeqLockReadRetry(SDL_SeqLock * lock, int seq)
+{
+    SDL_AtomicThreadFence(SDL_MEMORY_ORDER_ACQUIRE);
+    return SDL_AtomicLoad(&lock->seq, SDL_MEMORY_ORDER_RELAXED) != seq ?
+           SDL_TRUE : SDL_FALSE;
+}
+
+/**
+ *  Start writing, waits for another writer to finish.
+ */
+SDL_FORCE_INLINE void SDL_SeqLockWriteBegin(SDL_SeqLock * lock)
+{
+    int seq = SDL_AtomicLoad(&lock->seq, SDL_MEMORY_ORDER_RELAXED);
+    while ((seq & 1) ||
+           !SDL_AtomicCompareExchange(&lock->seq, &seq, seq + 1,
+                                      SDL_MEMORY_ORDER_RELAXED)) {
+        SDL_CPUPauseInstruction();
+        seq = SDL_AtomicLoad(&lock->seq, SDL_MEMORY_ORDER_RELAXED);
+    }
+    /* The odd sequence is seen before any of the writes */
+    SDL_AtomicThreadFence(SDL_MEMORY_ORDER_ACQ_REL);
+}
+
+/**
+ *  Finish writing.
+ */
+SDL_FORCE_INLINE void SDL_SeqLockWriteEnd(SDL_SeqLock * lock)
+{
+    SDL_AtomicFetchAdd(&lock->seq, 1, SDL_MEMORY_ORDER_RELEASE);
+}
+
+/* @} *//* Sequence lock functions */
+#endif /* SDL_HAS_NATIVE_ATOMICS */
+
+
 /**
  *  \name Semaphore functions
  */
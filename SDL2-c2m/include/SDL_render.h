@@ -432,6 +432,35 @@ extern DECLSPEC int SDLCALL SDL_LockTexture(SDL_Texture * texture,
  */
 extern DECLSPEC void SDLCALL SDL_UnlockTexture(SDL_Texture * texture);
 
+/**
+ *  \brief Make a streaming texture use memory of the caller's for its pixels.
+ *
+ *  \param texture   The texture, which was created with
+ *                   ::SDL_TEXTUREACCESS_STREAMING.
+ *  \param pixels    The pixels, in the texture's format, which must stay
+ *                   valid until the texture is destroyed or given other
+ *                   pixels, or NULL to give the texture memory of its own
+ *                   again, whose contents are undefined.
+ *  \param pitch     The number of bytes between rows of the pixels.
+ *
+ *  \return 0 on success, or -1 if the texture is not valid or the renderer
+ *          can't draw from memory it doesn't own.
+ *
+ *  The memory can be anything the caller writes frames to, e.g. a mapped
+ *  file or a decoder's output.  SDL_LockTexture() then gives pointers into
+ *  it and SDL_UpdateTexture() from it copies nothing, so a frame is drawn
+ *  with no copy of it made, but changes to it must still be followed by
+ *  either, so the renderer knows the texture has changed.
+ *
+ *  \note Only the software renderer supports this, for textures in one of
+ *        its own formats.
+ *
+ *  \sa SDL_LockTexture()
+ *  \sa SDL_UpdateTexture()
+ */
+extern DECLSPEC int SDLCALL SDL_SetTexturePixels(SDL_Texture * texture,
+                                                 void *pixels, int pitch);
+
 /**
  * \brief Determines whether a window supports the use of render targets
  *
@@ -830,6 +859,17 @@ extern DECLSPEC int SDLCALL SDL_RenderReadPixels(SDL_Renderer * renderer,
  */
 extern DECLSPEC void SDLCALL SDL_RenderPresent(SDL_Renderer * renderer);
 
+/**
+ *  \brief Run any drawing the renderer has batched up.
+ *
+ *  Only needed when the rendering target is accessed by other than the
+ *  renderer, e.g. the surface given to SDL_CreateSoftwareRenderer() with
+ *  SDL_HINT_RENDER_BATCHING on.
+ *
+ *  \return 0 on success, or -1 if some of the drawing failed.
+ */
+extern DECLSPEC int SDLCALL SDL_RenderFlush(SDL_Renderer * renderer);
+
 /**
  *  \brief Destroy the specified texture.
  *
@@ -45,6 +45,18 @@ extern "C" {
 #define SDL_RWOPS_JNIFILE   3   /* Android asset */
 #define SDL_RWOPS_MEMORY    4   /* Memory stream */
 #define SDL_RWOPS_MEMORY_RO 5   /* Read-Only memory stream */
+#define SDL_RWOPS_MAPPED    6   /* Read-Only memory mapped file */
+#define SDL_RWOPS_FD        7   /* POSIX file descriptor */
+#define SDL_RWOPS_SOCKET    8   /* Stream socket */
+
+/**
+ * A buffer for SDL_RWwritev.
+ */
+typedef struct SDL_RWiovec
+{
+    const void *base;
+    size_t len;
+} SDL_RWiovec;
 
 /**
  * This is the read/write operation structure -- very basic.
@@ -90,6 +102,16 @@ typedef struct SDL_RWops
      */
     int (SDLCALL * close) (struct SDL_RWops * context);
 
+    /**
+     *  Write \c n buffers in order, with as few writes to the stream as it
+     *  can.  NULL if the stream has no way to (SDL_AllocRW sets it to NULL),
+     *  SDL_RWwritev then writes them one by one.
+     *
+     *  \return the number of bytes written.
+     */
+    size_t (SDLCALL * writev) (struct SDL_RWops * context,
+                               const SDL_RWiovec * iov, int n);
+
     Uint32 type;
     union
     {
@@ -126,6 +148,23 @@ typedef struct SDL_RWops
             SDL_bool autoclose;
             FILE *fp;
         } stdio;
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+        struct
+        {
+            int fd;
+            SDL_bool writing;   /* buffer holds writes (not reads) */
+            SDL_bool readonly;  /* opened without write access */
+            Uint8 *buffer;
+            size_t size;        /* of buffer */
+            size_t len;         /* bytes in buffer */
+            size_t pos;         /* bytes of buffer already read */
+        } fdio;
+        struct
+        {
+            int fd;
+            SDL_bool autoclose;
+        } sockio;
 #endif
         struct
         {
@@ -165,6 +204,263 @@ extern DECLSPEC SDL_RWops *SDLCALL SDL_RWFromMem(void *mem, int size);
 extern DECLSPEC SDL_RWops *SDLCALL SDL_RWFromConstMem(const void *mem,
                                                       int size);
 
+/**
+ *  Open a file for reading as a read-only memory stream.
+ *
+ *  The file is memory mapped where the platform supports it (no copy is
+ *  made, pages are read as they're touched), otherwise it's read into
+ *  memory once.  The memory is released when the stream is closed.
+ */
+extern DECLSPEC SDL_RWops *SDLCALL SDL_RWFromFileMapped(const char *file);
+
+/**
+ *  Get the memory of a memory stream (from SDL_RWFromMem,
+ *  SDL_RWFromConstMem or SDL_RWFromFileMapped), without copying it.
+ *
+ *  \param context The stream.
+ *  \param size Set to the size of the memory (if not NULL).
+ *  \return The memory, or NULL if the stream isn't a memory stream.
+ */
+extern DECLSPEC const void *SDLCALL SDL_RWMappedData(SDL_RWops * context,
+                                                     size_t *size);
+
+/**
+ *  Open a file on a POSIX file descriptor, with a buffer of its own.
+ *
+ *  Unlike SDL_RWFromFile (stdio), the buffer can be big -- it's page
+ *  aligned, and reads and writes bigger than it go straight to the file.
+ *  A file opened for reading is hinted as read sequentially (for more
+ *  readahead).  Not supported on Windows.
+ *
+ *  \param file The file name.
+ *  \param mode As for fopen: "r", "w" or "a", with an optional "+".
+ *  \param buffer_size Size of the buffer, or 0 for 256 KiB.
+ */
+extern DECLSPEC SDL_RWops *SDLCALL SDL_RWFromFileFD(const char *file,
+                                                    const char *mode,
+                                                    size_t buffer_size);
+
+/**
+ *  Create a stream over a connected stream socket.
+ *
+ *  It can't seek and has no size; reads wait for whole objects.  A closed
+ *  connection is a write error, never SIGPIPE.  Not supported on Windows.
+ *
+ *  \param sock The socket.
+ *  \param autoclose If SDL_TRUE, SDL_RWclose closes the socket.
+ */
+extern DECLSPEC SDL_RWops *SDLCALL SDL_RWFromSocket(int sock,
+                                                    SDL_bool autoclose);
+
+/**
+ *  Connect to \c host (a name or address) on TCP \c port, and create a
+ *  stream over the connection, as SDL_RWFromSocket.
+ */
+extern DECLSPEC SDL_RWops *SDLCALL SDL_RWFromTCP(const char *host,
+                                                 Uint16 port);
+
+/**
+ *  Copy \c len bytes (all there are, if negative) from \c src to \c dst.
+ *
+ *  On Linux, between streams from SDL_RWFromFileFD and SDL_RWFromSocket,
+ *  the kernel copies them (copy_file_range, sendfile or splice) without
+ *  them passing through user memory.  Otherwise they go through one big
+ *  buffer.
+ *
+ *  \return the number of bytes copied (less than \c len on error).
+ */
+extern DECLSPEC Sint64 SDLCALL SDL_RWcopy(SDL_RWops * dst, SDL_RWops * src,
+                                          Sint64 len);
+
+/**
+ *  Write \c n buffers in order (scatter / gather).
+ *
+ *  Streams from SDL_RWFromFileFD and stdio streams (outside Windows) write
+ *  them with one writev; other streams write them one at a time.
+ *
+ *  \return the number of bytes written (less than all on error).
+ */
+extern DECLSPEC size_t SDLCALL SDL_RWwritev(SDL_RWops * context,
+                                            const SDL_RWiovec * iov, int n);
+
+/**
+ *  Read or write at an offset, without moving the stream position.
+ *
+ *  For a stream from SDL_RWFromFileFD these are pread / pwrite, which skip
+ *  the buffer, so many threads can read one stream at once (as long as
+ *  nothing is being written through the buffer).  Other streams seek there
+ *  and back, so they mustn't be shared.
+ *
+ *  \return the number of objects read or written.
+ */
+extern DECLSPEC size_t SDLCALL SDL_RWreadAt(SDL_RWops * context, void *ptr,
+                                            size_t size, size_t maxnum,
+                                            Sint64 offset);
+extern DECLSPEC size_t SDLCALL SDL_RWwriteAt(SDL_RWops * context,
+                                             const void *ptr, size_t size,
+                                             size_t num, Sint64 offset);
+
+/**
+ *  \name Line and record reader
+ *
+ *  Reads a stream a record at a time, returning each as a view into the
+ *  reader's buffer instead of copying it into the caller's.  The buffer is
+ *  refilled a block at a time and only grows for a record longer than it,
+ *  and the delimiter is searched for 16 bytes at a time (SSE2 or NEON).
+ *  Memory streams (see SDL_RWMappedData) aren't copied at all, records
+ *  point into their memory.  Records aren't NUL terminated, and are only
+ *  valid until the next call on the reader.
+ */
+/* @{ */
+typedef struct SDL_RWreader SDL_RWreader;
+
+/**
+ *  Create a reader of \c src, from its position.
+ *
+ *  \param buffer_size Size of the buffer, or 0 for 64 KiB.
+ */
+extern DECLSPEC SDL_RWreader *SDLCALL SDL_RWreaderCreate(SDL_RWops * src,
+                                                         size_t buffer_size);
+
+/**
+ *  Get the next record: up to (not including) \c delim, or the rest of the
+ *  stream after the last one.
+ *
+ *  \param length Set to the length of the record.
+ *  \return the record, or NULL at the end of the stream.
+ */
+extern DECLSPEC const char *SDLCALL SDL_RWreadRecord(SDL_RWreader * reader,
+                                                     char delim,
+                                                     size_t *length);
+
+/**
+ *  Get the next line, as SDL_RWreadRecord with '\\n', without a '\\r' before
+ *  it.
+ */
+extern DECLSPEC const char *SDLCALL SDL_RWreadLine(SDL_RWreader * reader,
+                                                   size_t *length);
+
+/**
+ *  Destroy a reader.  A stream that can seek is left just after the last
+ *  record read, not after what was read ahead of it.
+ */
+extern DECLSPEC void SDLCALL SDL_RWreaderDestroy(SDL_RWreader * reader);
+/* @} *//* Line and record reader */
+
+/**
+ *  \name Asynchronous reads and writes
+ *
+ *  Requests are submitted to a queue, which keeps many in flight (with
+ *  io_uring on Linux, for streams from SDL_RWFromFileFD, or worker threads
+ *  for other streams).  Callbacks are run by SDL_RWasyncPoll, on the
+ *  thread calling it.  The buffer of a request must stay valid until its
+ *  callback is run, and a stream must not be closed while it has requests.
+ */
+/* @{ */
+typedef struct SDL_RWasync SDL_RWasync;
+
+/**
+ *  Completion of a request.
+ *
+ *  \param userdata As submitted.
+ *  \param ptr The request's buffer.
+ *  \param done Number of bytes read or written (less at end of file).
+ *  \param status 0 on success, or -1 on error.
+ */
+typedef void (SDLCALL * SDL_RWasyncCallback) (void *userdata, void *ptr,
+                                              size_t done, int status);
+
+/**
+ *  Create a request queue, for up to \c depth requests in the kernel at
+ *  once (0 for the default).
+ */
+extern DECLSPEC SDL_RWasync *SDLCALL SDL_RWasyncCreate(int depth);
+
+/**
+ *  Submit a read or write of \c size bytes at \c offset.
+ *
+ *  \return 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_RWasyncRead(SDL_RWasync * queue,
+                                            SDL_RWops * context, void *ptr,
+                                            size_t size, Sint64 offset,
+                                            SDL_RWasyncCallback callback,
+                                            void *userdata);
+extern DECLSPEC int SDLCALL SDL_RWasyncWrite(SDL_RWasync * queue,
+                                             SDL_RWops * context,
+                                             const void *ptr, size_t size,
+                                             Sint64 offset,
+                                             SDL_RWasyncCallback callback,
+                                             void *userdata);
+
+/**
+ *  Run the callbacks of completed requests.
+ *
+ *  \param wait If SDL_TRUE, wait for a request to complete (unless none are
+ *              pending).
+ *  \return the number of callbacks run.
+ */
+extern DECLSPEC int SDLCALL SDL_RWasyncPoll(SDL_RWasync * queue,
+                                            SDL_bool wait);
+
+/**
+ *  Count requests whose callbacks haven't been run yet.
+ */
+extern DECLSPEC int SDLCALL SDL_RWasyncPending(SDL_RWasync * queue);
+
+/**
+ *  Wait for all requests (running their callbacks), and destroy a queue.
+ */
+extern DECLSPEC void SDLCALL SDL_RWasyncDestroy(SDL_RWasync * queue);
+/* @} *//* Asynchronous reads and writes */
+
+/**
+ *  \name Journals
+ *
+ *  Append-only files for logs and the like, appended to from any number of
+ *  threads without a lock or a system call: each record is copied into a
+ *  memory mapped segment file, after a slot is reserved in it with an
+ *  atomic add.  Segments are created (with a 6 digit number after the
+ *  journal's path, after any already there), rolled over to when full and
+ *  synced by a background thread.  Unix only.
+ */
+/* @{ */
+typedef struct SDL_RWjournal SDL_RWjournal;
+
+/**
+ *  Open a journal, starting a new segment.
+ *
+ *  \param path The path of the segments, before their number.
+ *  \param segment_size Size of a segment, or 0 for 64 MiB (at most 1 GiB).
+ *  \param sync_interval Milliseconds between syncs of the current segment,
+ *                       or 0 to sync segments only once they're full.
+ */
+extern DECLSPEC SDL_RWjournal *SDLCALL SDL_RWjournalOpen(const char *path,
+                                                         size_t segment_size,
+                                                         Uint32 sync_interval);
+
+/**
+ *  Append a record, of at most a segment's size.  A record is never split
+ *  across segments, and records appended by a thread are in its order.
+ *
+ *  \return 0 on success, or -1 if the journal couldn't roll over to a new
+ *          segment.
+ */
+extern DECLSPEC int SDLCALL SDL_RWjournalAppend(SDL_RWjournal * journal,
+                                                const void *ptr, size_t size);
+
+/**
+ *  Sync everything appended so far to disk.
+ */
+extern DECLSPEC int SDLCALL SDL_RWjournalSync(SDL_RWjournal * journal);
+
+/**
+ *  Close a journal, once appends to it have returned.  Its last segment is
+ *  synced and cut down to what was appended.
+ */
+extern DECLSPEC void SDLCALL SDL_RWjournalClose(SDL_RWjournal * journal);
+/* @} *//* Journals */
+
 /* @} *//* RWFrom functions */
 
 
@@ -333,11 +333,53 @@ extern DECLSPEC void *SDLCALL SDL_calloc(size_t nmemb, size_t size);
 extern DECLSPEC void *SDLCALL SDL_realloc(void *mem, size_t size);
 extern DECLSPEC void SDLCALL SDL_free(void *mem);
 
+/**
+ *  Memory held for small allocations, when SDL_malloc() is SDL's own and
+ *  allocates them from per-thread slabs (all zero otherwise).
+ */
+typedef struct SDL_SlabStats
+{
+    Uint32 slabs;       /**< Slabs of all threads */
+    Uint32 live;        /**< Allocations in them, with those freed by other
+                             threads until their own takes them back */
+    size_t bytes;       /**< Memory of the slabs */
+} SDL_SlabStats;
+
+extern DECLSPEC void SDLCALL SDL_GetSlabStats(SDL_SlabStats *stats);
+
+/**
+ *  The heap's memory use, 0 where the allocator doesn't tell.
+ */
+typedef struct SDL_MemoryStats
+{
+    size_t used;        /**< Bytes allocated */
+    size_t held;        /**< Bytes the heap took from the system */
+    size_t peak;        /**< Highest held */
+} SDL_MemoryStats;
+
+extern DECLSPEC void SDLCALL SDL_GetMemoryStats(SDL_MemoryStats *stats);
+
 extern DECLSPEC char *SDLCALL SDL_getenv(const char *name);
 extern DECLSPEC int SDLCALL SDL_setenv(const char *name, const char *value, int overwrite);
 
 extern DECLSPEC void SDLCALL SDL_qsort(void *base, size_t nmemb, size_t size, int (*compare) (const void *, const void *));
 
+/**
+ *  SDL_qsort() with \c userdata passed to each \c compare call.
+ */
+extern DECLSPEC void SDLCALL SDL_qsort_r(void *base, size_t nmemb, size_t size, int (SDLCALL *compare) (void *userdata, const void *a, const void *b), void *userdata);
+
+/**
+ *  Sort arrays in ascending order without a comparison callback.  Floats go
+ *  by IEEE 754 totalOrder (-0 before +0, NaNs at the ends by their sign),
+ *  pointers by address.
+ */
+extern DECLSPEC void SDLCALL SDL_qsort_int32(Sint32 *base, size_t nmemb);
+extern DECLSPEC void SDLCALL SDL_qsort_int64(Sint64 *base, size_t nmemb);
+extern DECLSPEC void SDLCALL SDL_qsort_float(float *base, size_t nmemb);
+extern DECLSPEC void SDLCALL SDL_qsort_double(double *base, size_t nmemb);
+extern DECLSPEC void SDLCALL SDL_qsort_pointer(void **base, size_t nmemb);
+
 extern DECLSPEC int SDLCALL SDL_abs(int x);
 
 /* !!! FIXME: these have side effects. You probably shouldn't use them. */
@@ -483,6 +525,13 @@ extern DECLSPEC char *SDLCALL SDL_iconv_string(const char *tocode,
 #define SDL_iconv_utf8_ucs2(S)      (Uint16 *)SDL_iconv_string("UCS-2-INTERNAL", "UTF-8", S, SDL_strlen(S)+1)
 #define SDL_iconv_utf8_ucs4(S)      (Uint32 *)SDL_iconv_string("UCS-4-INTERNAL", "UTF-8", S, SDL_strlen(S)+1)
 
+/**
+ *  Returns SDL_TRUE if the \c len bytes at \c buf are well-formed UTF-8
+ *  (RFC 3629: no overlong forms, surrogates or code points past U+10FFFF).
+ *  NUL bytes are characters like any other.
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_utf8_validate(const char *buf, size_t len);
+
 /* force builds using Clang's static analysis tools to use literal C runtime
    here, since there are possibly tests that are ineffective otherwise. */
 #if defined(__clang_analyzer__) && !defined(SDL_DISABLE_ANALYZE_MACROS)
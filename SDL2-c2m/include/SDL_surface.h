@@ -53,6 +53,7 @@ extern "C" {
 #define SDL_PREALLOC        0x00000001  /**< Surface uses preallocated memory */
 #define SDL_RLEACCEL        0x00000002  /**< Surface is RLE encoded */
 #define SDL_DONTFREE        0x00000004  /**< Surface is referenced internally */
+#define SDL_SIMD_ALIGNED    0x00000008  /**< Surface uses aligned memory */
 /* @} *//* Surface flags */
 
 /**
@@ -129,6 +130,38 @@ extern DECLSPEC SDL_Surface *SDLCALL SDL_CreateRGBSurfaceFrom(void *pixels,
                                                               Uint32 Amask);
 extern DECLSPEC void SDLCALL SDL_FreeSurface(SDL_Surface * surface);
 
+/**
+ *  Get a surface of \c format from the surface pool, or a new one if it
+ *  has none that size.
+ *
+ *  For temporary surfaces made over and over (every frame), this saves
+ *  allocating the surface and its pixels each time.  The pixels are
+ *  aligned to 64 bytes, and their contents are undefined.  Indexed formats
+ *  aren't pooled, those surfaces are new (and cleared) every time.
+ *
+ *  \return the surface, or NULL on error.
+ *
+ *  \sa SDL_ReleaseSurface
+ */
+extern DECLSPEC SDL_Surface *SDLCALL SDL_AcquireSurface(int width,
+                                                        int height,
+                                                        Uint32 format);
+
+/**
+ *  Give a surface back to the surface pool.
+ *
+ *  Its color key, color and alpha mod, blend mode, RLE and clip rect are
+ *  reset for the next SDL_AcquireSurface.  Surfaces it can't keep (ones
+ *  not from SDL_AcquireSurface, still referenced or locked, or when the
+ *  pool is full) are freed as by SDL_FreeSurface.
+ */
+extern DECLSPEC void SDLCALL SDL_ReleaseSurface(SDL_Surface * surface);
+
+/**
+ *  Free every surface in the surface pool (SDL_Quit does too).
+ */
+extern DECLSPEC void SDLCALL SDL_FlushSurfacePool(void);
+
 /**
  *  \brief Set the palette used by a surface.
  *
@@ -181,6 +214,23 @@ extern DECLSPEC SDL_Surface *SDLCALL SDL_LoadBMP_RW(SDL_RWops * src,
  */
 #define SDL_LoadBMP(file)   SDL_LoadBMP_RW(SDL_RWFromFile(file, "rb"), 1)
 
+/**
+ *  Load several surfaces from files at once.
+ *
+ *  The files are memory mapped (see SDL_RWFromFileMapped()) and loaded on
+ *  up to SDL_GetCPUCount() threads, the calling thread among them.
+ *
+ *  \param files The names of the files.
+ *  \param num The number of files.
+ *  \param surfaces Filled with the surface of each file, or NULL for a file
+ *                  which couldn't be loaded.  Free them with
+ *                  SDL_FreeSurface().
+ *
+ *  \return The number of surfaces loaded, or -1 if there was an error.
+ */
+extern DECLSPEC int SDLCALL SDL_LoadBMPs(const char **files, int num,
+                                         SDL_Surface ** surfaces);
+
 /**
  *  Save a surface to a seekable SDL data stream (memory or file).
  *
@@ -466,13 +516,40 @@ extern DECLSPEC int SDLCALL SDL_LowerBlit
  *  \brief Perform a fast, low quality, stretch blit between two surfaces of the
  *         same pixel format.
  *
- *  \note This function uses a static buffer, and is not thread-safe.
+ *  This is SDL_SoftStretchFiltered() with ::SDL_STRETCH_NEAREST.
  */
 extern DECLSPEC int SDLCALL SDL_SoftStretch(SDL_Surface * src,
                                             const SDL_Rect * srcrect,
                                             SDL_Surface * dst,
                                             const SDL_Rect * dstrect);
 
+/**
+ *  \brief The filters of SDL_SoftStretchFiltered().
+ */
+typedef enum
+{
+    SDL_STRETCH_NEAREST,    /**< The nearest source pixel */
+    SDL_STRETCH_LINEAR,     /**< The 4 nearest source pixels blended */
+    SDL_STRETCH_AREA        /**< The source pixels covered, averaged */
+} SDL_StretchFilter;
+
+/**
+ *  \brief Perform a filtered stretch blit between two surfaces of the same
+ *         pixel format.
+ *
+ *  Linear and area filtering work on formats of four 8-bit channels, each
+ *  channel filtered the same way (so alpha isn't premultiplied); other
+ *  formats are stretched with ::SDL_STRETCH_NEAREST.  Area filtering is the
+ *  smoother when shrinking.
+ *
+ *  \return 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_SoftStretchFiltered(SDL_Surface * src,
+                                                    const SDL_Rect * srcrect,
+                                                    SDL_Surface * dst,
+                                                    const SDL_Rect * dstrect,
+                                                    SDL_StretchFilter filter);
+
 #define SDL_BlitScaled SDL_UpperBlitScaled
 
 /**
@@ -169,6 +169,23 @@ extern DECLSPEC SDL_threadID SDLCALL SDL_GetThreadID(SDL_Thread * thread);
  */
 extern DECLSPEC int SDLCALL SDL_SetThreadPriority(SDL_ThreadPriority priority);
 
+/**
+ *  Let the current thread run only on the \c count logical CPUs in \c cpus
+ *  (numbered as in SDL_GetCPUCore()), or on any of them if \c count is 0.
+ *
+ *  \return 0 on success, or -1 if it failed or isn't supported
+ */
+extern DECLSPEC int SDLCALL SDL_SetThreadAffinity(const int *cpus, int count);
+
+/**
+ *  Let the current thread run only on the CPUs of NUMA node \c node (see
+ *  SDL_GetCPUNUMANode()), so it keeps its caches and the memory it touches
+ *  first is allocated on its node.
+ *
+ *  \return 0 on success, or -1 if it failed or isn't supported
+ */
+extern DECLSPEC int SDLCALL SDL_SetThreadNUMANode(int node);
+
 /**
  *  Wait for a thread to finish. Threads that haven't been detached will
  *  remain (as a "zombie") until this function cleans them up. Not doing so
@@ -275,6 +292,18 @@ extern DECLSPEC void * SDLCALL SDL_TLSGet(SDL_TLSID id);
  */
 extern DECLSPEC int SDLCALL SDL_TLSSet(SDL_TLSID id, const void *value, void (*destructor)(void*));
 
+/**
+ *  \brief The number of thread local storage IDs reserved for static use.
+ *
+ *  SDL_TLSCreate() never returns the IDs SDL_TLS_STATIC(0) to
+ *  SDL_TLS_STATIC(SDL_TLS_STATIC_SLOTS - 1), so a runtime component can
+ *  claim one as a constant, without creating it first.  Where the compiler
+ *  has thread local variables, getting or setting one is a single load or
+ *  store, without looking up the thread's table.
+ */
+#define SDL_TLS_STATIC_SLOTS 8
+#define SDL_TLS_STATIC(n) ((SDL_TLSID)(n) + 1)
+
 
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
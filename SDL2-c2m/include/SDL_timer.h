@@ -65,11 +65,67 @@ extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceCounter(void);
  */
 extern DECLSPEC Uint64 SDLCALL SDL_GetPerformanceFrequency(void);
 
+/**
+ * \brief Get the current value of a low overhead, high resolution counter
+ *
+ * On x86 Linux with an invariant TSC this reads the TSC directly, otherwise
+ * it's the same as SDL_GetPerformanceCounter().  Its values can only be
+ * compared with each other, not with SDL_GetPerformanceCounter()'s.
+ *
+ * \sa SDL_HINT_TIMER_TSC
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetFastPerformanceCounter(void);
+
+/**
+ * \brief Get the count per second of SDL_GetFastPerformanceCounter()
+ *
+ * For the TSC this is measured against the monotonic clock, the first call
+ * may wait until 20 ms have passed since SDL_Init().
+ */
+extern DECLSPEC Uint64 SDLCALL SDL_GetFastPerformanceFrequency(void);
+
 /**
  * \brief Wait a specified number of milliseconds before returning.
  */
 extern DECLSPEC void SDLCALL SDL_Delay(Uint32 ms);
 
+/**
+ * \brief Wait a specified number of nanoseconds before returning.
+ *
+ * Sleeps until shortly before the deadline, then spins for the rest, so it
+ * usually returns within a few microseconds of it, at the cost of some CPU.
+ */
+extern DECLSPEC void SDLCALL SDL_DelayPrecise(Uint64 ns);
+
+/**
+ * A frame pacer, paces a loop to a fixed period.
+ */
+typedef struct SDL_FramePacer SDL_FramePacer;
+
+/**
+ * \brief Create a frame pacer with a period in nanoseconds, the first frame
+ *        ends one period from now.
+ *
+ * \return The new frame pacer, or NULL on error.
+ */
+extern DECLSPEC SDL_FramePacer *SDLCALL SDL_CreateFramePacer(Uint64 period_ns);
+
+/**
+ * \brief Wait until the end of the current frame.
+ *
+ * Frames end at absolute deadlines, so how long each frame's work took
+ * doesn't make the period drift.  If whole frames were missed they are
+ * skipped, keeping the phase.
+ *
+ * \return The number of frames skipped, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_FramePacerWait(SDL_FramePacer *pacer);
+
+/**
+ * \brief Destroy a frame pacer.
+ */
+extern DECLSPEC void SDLCALL SDL_DestroyFramePacer(SDL_FramePacer *pacer);
+
 /**
  *  Function prototype for the timer callback function.
  *
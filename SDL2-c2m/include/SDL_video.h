@@ -731,6 +731,9 @@ extern DECLSPEC SDL_Surface * SDLCALL SDL_GetWindowSurface(SDL_Window * window);
 /**
  *  \brief Copy the window surface to the screen.
  *
+ *  With ::SDL_HINT_WINDOW_SURFACE_DAMAGE, only the parts SDL has drawn on
+ *  since the last update are copied.
+ *
  *  \return 0 on success, or -1 on error.
  *
  *  \sa SDL_GetWindowSurface()
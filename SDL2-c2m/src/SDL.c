@@ -41,6 +41,7 @@ extern void SDL_TimerQuit(void);
 extern void SDL_TicksInit(void);
 extern void SDL_TicksQuit(void);
 #endif
+extern void SDL_QuitBlitThreads(void);
 #if SDL_VIDEO_DRIVER_WINDOWS
 extern int SDL_HelperWindowCreate(void);
 extern int SDL_HelperWindowDestroy(void);
@@ -355,6 +356,8 @@ SDL_Quit(void)
     SDL_HelperWindowDestroy();
 #endif
     SDL_QuitSubSystem(SDL_INIT_EVERYTHING);
+    SDL_QuitBlitThreads();
+    SDL_FlushSurfacePool();
 
 #if !SDL_TIMERS_DISABLED
     SDL_TicksQuit();
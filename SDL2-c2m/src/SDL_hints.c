@@ -20,12 +20,14 @@
 */
 #include "./SDL_internal.h"
 
+#include "SDL_atomic.h"
 #include "SDL_hints.h"
 #include "SDL_error.h"
 
 
-/* Assuming there aren't many hints set and they aren't being queried in
-   critical performance paths, we'll just use linked lists here.
+/* Hints are kept in a small hash table, each one's name hashed once when
+   it's added.  Code which reads a hint often should use an SDL_HintHandle,
+   which keeps the parsed value until SDL_hint_generation changes.
  */
 typedef struct SDL_HintWatch {
     SDL_HintCallback callback;
@@ -35,13 +37,74 @@ typedef struct SDL_HintWatch {
 
 typedef struct SDL_Hint {
     char *name;
+    Uint32 hash;
     char *value;
     SDL_HintPriority priority;
     SDL_HintWatch *callbacks;
     struct SDL_Hint *next;
 } SDL_Hint;
 
-static SDL_Hint *SDL_hints;
+#define SDL_HINT_BUCKETS 64
+
+static SDL_Hint *SDL_hints[SDL_HINT_BUCKETS];
+
+/* Changed whenever a hint's value may have; never 0, which handles start
+   with */
+static SDL_atomic_t SDL_hint_generation = { 1 };
+
+static Uint32
+SDL_HashHintName(const char *name)
+{
+    /* FNV-1a */
+    Uint32 hash = 2166136261u;
+
+    while (*name) {
+        hash = (hash ^ (Uint8) *name++) * 16777619u;
+    }
+    return hash;
+}
+
+static SDL_Hint *
+SDL_FindHint(const char *name, Uint32 hash)
+{
+    SDL_Hint *hint;
+
+    for (hint = SDL_hints[hash % SDL_HINT_BUCKETS]; hint; hint = hint->next) {
+        if (hint->hash == hash && SDL_strcmp(name, hint->name) == 0) {
+            return hint;
+        }
+    }
+    return NULL;
+}
+
+static SDL_Hint *
+SDL_NewHint(const char *name, Uint32 hash, const char *value,
+            SDL_HintPriority priority)
+{
+    SDL_Hint *hint = (SDL_Hint *)SDL_malloc(sizeof(*hint));
+
+    if (!hint) {
+        return NULL;
+    }
+    hint->name = SDL_strdup(name);
+    hint->hash = hash;
+    hint->value = value ? SDL_strdup(value) : NULL;
+    hint->priority = priority;
+    hint->callbacks = NULL;
+    hint->next = SDL_hints[hash % SDL_HINT_BUCKETS];
+    SDL_hints[hash % SDL_HINT_BUCKETS] = hint;
+    return hint;
+}
+
+static void
+SDL_HintsChanged(void)
+{
+    int generation = SDL_AtomicIncRef(&SDL_hint_generation) + 1;
+
+    if (generation == 0) {
+        SDL_AtomicIncRef(&SDL_hint_generation);
+    }
+}
 
 SDL_bool
 SDL_SetHintWithPriority(const char *name, const char *value,
@@ -50,6 +113,7 @@ SDL_SetHintWithPriority(const char *name, const char *value,
     const char *env;
     SDL_Hint *hint;
     SDL_HintWatch *entry;
+    Uint32 hash;
 
     if (!name || !value) {
         return SDL_FALSE;
@@ -60,37 +124,32 @@ SDL_SetHintWithPriority(const char *name, const char *value,
         return SDL_FALSE;
     }
 
-    for (hint = SDL_hints; hint; hint = hint->next) {
-        if (SDL_strcmp(name, hint->name) == 0) {
-            if (priority < hint->priority) {
-                return SDL_FALSE;
-            }
-            if (!hint->value || !value || SDL_strcmp(hint->value, value) != 0) {
-                for (entry = hint->callbacks; entry; ) {
-                    /* Save the next entry in case this one is deleted */
-                    SDL_HintWatch *next = entry->next;
-                    entry->callback(entry->userdata, name, hint->value, value);
-                    entry = next;
-                }
-                SDL_free(hint->value);
-                hint->value = value ? SDL_strdup(value) : NULL;
+    hash = SDL_HashHintName(name);
+    hint = SDL_FindHint(name, hash);
+    if (hint) {
+        if (priority < hint->priority) {
+            return SDL_FALSE;
+        }
+        if (!hint->value || !value || SDL_strcmp(hint->value, value) != 0) {
+            for (entry = hint->callbacks; entry; ) {
+                /* Save the next entry in case this one is deleted */
+                SDL_HintWatch *next = entry->next;
+                entry->callback(entry->userdata, name, hint->value, value);
+                entry = next;
             }
-            hint->priority = priority;
-            return SDL_TRUE;
+            SDL_free(hint->value);
+            hint->value = value ? SDL_strdup(value) : NULL;
+            SDL_HintsChanged();
         }
+        hint->priority = priority;
+        return SDL_TRUE;
     }
 
     /* Couldn't find the hint, add a new one */
-    hint = (SDL_Hint *)SDL_malloc(sizeof(*hint));
-    if (!hint) {
+    if (!SDL_NewHint(name, hash, value, priority)) {
         return SDL_FALSE;
     }
-    hint->name = SDL_strdup(name);
-    hint->value = value ? SDL_strdup(value) : NULL;
-    hint->priority = priority;
-    hint->callbacks = NULL;
-    hint->next = SDL_hints;
-    SDL_hints = hint;
+    SDL_HintsChanged();
     return SDL_TRUE;
 }
 
@@ -107,23 +166,53 @@ SDL_GetHint(const char *name)
     SDL_Hint *hint;
 
     env = SDL_getenv(name);
-    for (hint = SDL_hints; hint; hint = hint->next) {
-        if (SDL_strcmp(name, hint->name) == 0) {
-            if (!env || hint->priority == SDL_HINT_OVERRIDE) {
-                return hint->value;
-            }
-            break;
-        }
+    hint = SDL_FindHint(name, SDL_HashHintName(name));
+    if (hint && (!env || hint->priority == SDL_HINT_OVERRIDE)) {
+        return hint->value;
     }
     return env;
 }
 
+static int
+SDL_ParseHintValue(const char *value, int default_value)
+{
+    if (!value || !*value) {
+        return default_value;
+    }
+    if (SDL_strcasecmp(value, "false") == 0) {
+        return 0;
+    }
+    if (SDL_strcasecmp(value, "true") == 0) {
+        return 1;
+    }
+    return SDL_atoi(value);
+}
+
+int
+SDL_GetHintValue(SDL_HintHandle *handle)
+{
+    const int generation = SDL_AtomicLoad(&SDL_hint_generation, SDL_MEMORY_ORDER_ACQUIRE);
+
+    if (handle->generation != generation) {
+        const char *value = SDL_GetHint(handle->name);
+
+        if (handle->parse) {
+            handle->value = handle->parse(value, handle->default_value);
+        } else {
+            handle->value = SDL_ParseHintValue(value, handle->default_value);
+        }
+        handle->generation = generation;
+    }
+    return handle->value;
+}
+
 void
 SDL_AddHintCallback(const char *name, SDL_HintCallback callback, void *userdata)
 {
     SDL_Hint *hint;
     SDL_HintWatch *entry;
     const char *value;
+    Uint32 hash;
 
     if (!name || !*name) {
         SDL_InvalidParamError("name");
@@ -144,25 +233,16 @@ SDL_AddHintCallback(const char *name, SDL_HintCallback callback, void *userdata)
     entry->callback = callback;
     entry->userdata = userdata;
 
-    for (hint = SDL_hints; hint; hint = hint->next) {
-        if (SDL_strcmp(name, hint->name) == 0) {
-            break;
-        }
-    }
+    hash = SDL_HashHintName(name);
+    hint = SDL_FindHint(name, hash);
     if (!hint) {
         /* Need to add a hint entry for this watcher */
-        hint = (SDL_Hint *)SDL_malloc(sizeof(*hint));
+        hint = SDL_NewHint(name, hash, NULL, SDL_HINT_DEFAULT);
         if (!hint) {
             SDL_OutOfMemory();
             SDL_free(entry);
             return;
         }
-        hint->name = SDL_strdup(name);
-        hint->value = NULL;
-        hint->priority = SDL_HINT_DEFAULT;
-        hint->callbacks = NULL;
-        hint->next = SDL_hints;
-        SDL_hints = hint;
     }
 
     /* Add it to the callbacks for this hint */
@@ -180,23 +260,22 @@ SDL_DelHintCallback(const char *name, SDL_HintCallback callback, void *userdata)
     SDL_Hint *hint;
     SDL_HintWatch *entry, *prev;
 
-    for (hint = SDL_hints; hint; hint = hint->next) {
-        if (SDL_strcmp(name, hint->name) == 0) {
-            prev = NULL;
-            for (entry = hint->callbacks; entry; entry = entry->next) {
-                if (callback == entry->callback && userdata == entry->userdata) {
-                    if (prev) {
-                        prev->next = entry->next;
-                    } else {
-                        hint->callbacks = entry->next;
-                    }
-                    SDL_free(entry);
-                    break;
-                }
-                prev = entry;
+    hint = SDL_FindHint(name, SDL_HashHintName(name));
+    if (!hint) {
+        return;
+    }
+    prev = NULL;
+    for (entry = hint->callbacks; entry; entry = entry->next) {
+        if (callback == entry->callback && userdata == entry->userdata) {
+            if (prev) {
+                prev->next = entry->next;
+            } else {
+                hint->callbacks = entry->next;
             }
-            return;
+            SDL_free(entry);
+            break;
         }
+        prev = entry;
     }
 }
 
@@ -204,20 +283,24 @@ void SDL_ClearHints(void)
 {
     SDL_Hint *hint;
     SDL_HintWatch *entry;
+    int i;
 
-    while (SDL_hints) {
-        hint = SDL_hints;
-        SDL_hints = hint->next;
+    for (i = 0; i < SDL_HINT_BUCKETS; ++i) {
+        while (SDL_hints[i]) {
+            hint = SDL_hints[i];
+            SDL_hints[i] = hint->next;
 
-        SDL_free(hint->name);
-        SDL_free(hint->value);
-        for (entry = hint->callbacks; entry; ) {
-            SDL_HintWatch *freeable = entry;
-            entry = entry->next;
-            SDL_free(freeable);
+            SDL_free(hint->name);
+            SDL_free(hint->value);
+            for (entry = hint->callbacks; entry; ) {
+                SDL_HintWatch *freeable = entry;
+                entry = entry->next;
+                SDL_free(freeable);
+            }
+            SDL_free(hint);
         }
-        SDL_free(hint);
     }
+    SDL_HintsChanged();
 }
 
 /* vi: set ts=4 sw=4 expandtab: */
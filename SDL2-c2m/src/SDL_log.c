@@ -28,6 +28,10 @@
 
 #include "SDL_error.h"
 #include "SDL_log.h"
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+#include "SDL_timer.h"
 
 #if HAVE_STDIO_H
 #include <stdio.h>
@@ -62,6 +66,9 @@ static SDL_LogPriority SDL_test_priority = DEFAULT_TEST_PRIORITY;
 static SDL_LogOutputFunction SDL_log_function = SDL_LogOutput;
 static void *SDL_log_userdata = NULL;
 
+/* SDL_LogGetPriority() of the predefined categories, 0 until looked up */
+static Uint8 SDL_log_priority_cache[SDL_LOG_CATEGORY_CUSTOM];
+
 static const char *SDL_priority_prefixes[SDL_NUM_LOG_PRIORITIES] = {
     NULL,
     "VERBOSE",
@@ -106,6 +113,7 @@ SDL_LogSetAllPriority(SDL_LogPriority priority)
     SDL_default_priority = priority;
     SDL_assert_priority = priority;
     SDL_application_priority = priority;
+    SDL_zero(SDL_log_priority_cache);
 }
 
 void
@@ -113,6 +121,7 @@ SDL_LogSetPriority(int category, SDL_LogPriority priority)
 {
     SDL_LogLevel *entry;
 
+    SDL_zero(SDL_log_priority_cache);
     for (entry = SDL_loglevels; entry; entry = entry->next) {
         if (entry->category == category) {
             entry->priority = priority;
@@ -167,6 +176,630 @@ SDL_LogResetPriorities(void)
     SDL_assert_priority = DEFAULT_ASSERT_PRIORITY;
     SDL_application_priority = DEFAULT_APPLICATION_PRIORITY;
     SDL_test_priority = DEFAULT_TEST_PRIORITY;
+    SDL_zero(SDL_log_priority_cache);
+}
+
+static SDL_INLINE SDL_LogPriority
+SDL_LogCachedPriority(int category)
+{
+    if (category < 0 || category >= SDL_LOG_CATEGORY_CUSTOM) {
+        return SDL_LogGetPriority(category);
+    }
+    if (!SDL_log_priority_cache[category]) {
+        SDL_log_priority_cache[category] = (Uint8) SDL_LogGetPriority(category);
+    }
+    return (SDL_LogPriority) SDL_log_priority_cache[category];
+}
+
+/* Asynchronous logging: with SDL_LogSetAsync(SDL_TRUE), SDL_LogMessageV()
+   doesn't format a message, it copies the format string's address & the
+   arguments into the calling thread's ring buffer & a background thread
+   formats & outputs them.  String arguments are copied, a message with a
+   conversion that can't be copied (%n, long double, wide characters, ...)
+   is formatted by the thread logging it.  A thread that fills its ring
+   outputs what's waiting itself, rather than dropping messages. */
+
+#define SDL_LOG_RING_SIZE (64 * 1024)   /* Bytes per thread, a power of 2 */
+#define SDL_LOG_RECORD_MAX (SDL_LOG_RING_SIZE / 4)
+#define SDL_LOG_ARGS_MAX 32
+#define SDL_LOG_INTERVAL 20             /* ms the background thread sleeps */
+#define SDL_LOG_RING SDL_TLS_STATIC(1)
+#define SDL_LOG_ALIGN(n) (((n) + 7) & ~(size_t) 7)
+#define SDL_LOG_HEADER SDL_LOG_ALIGN(sizeof(SDL_LogRecord))
+
+/* An argument, strings as their offset in the record */
+typedef union
+{
+    Sint64 i;
+    double d;
+    const void *p;
+} SDL_LogArg;
+
+/* A message in a ring, its arguments & strings follow */
+typedef struct
+{
+    Uint32 size;            /* Bytes, including what follows */
+    Uint32 sequence;        /* Order logged in, across threads */
+    int category;
+    int priority;           /* 0 for padding up to the end of the ring */
+    const char *fmt;
+} SDL_LogRecord;
+
+typedef struct SDL_LogRing
+{
+    SDL_atomic_t head;      /* Where its thread writes next */
+    SDL_atomic_t tail;      /* The oldest record not output yet */
+    SDL_atomic_t dead;      /* Its thread exited */
+    struct SDL_LogRing *next;
+    Uint64 buffer[SDL_LOG_RING_SIZE / sizeof(Uint64)];
+} SDL_LogRing;
+
+/* A conversion of a format string */
+typedef struct
+{
+    char flags[6];
+    int width;              /* -1 without one */
+    int precision;          /* ... */
+    SDL_bool width_arg;     /* '*', passed as an argument */
+    SDL_bool precision_arg;
+    int length;             /* 'h' for "hh", 'l' ... "ll" for "ll" */
+    char conversion;
+} SDL_LogSpec;
+
+static SDL_bool SDL_log_async = SDL_FALSE;
+static SDL_LogRing *SDL_log_rings;
+static SDL_SpinLock SDL_log_rings_lock;
+static SDL_atomic_t SDL_log_sequence;
+static SDL_mutex *SDL_log_drain_lock;
+static SDL_threadID SDL_log_drainer;
+static SDL_sem *SDL_log_wake;
+static SDL_Thread *SDL_log_thread;
+static SDL_atomic_t SDL_log_quit;
+
+/* Parse the conversion after a '%', SDL_FALSE if it can't be copied */
+static SDL_bool
+SDL_LogParseSpec(const char **fmt, SDL_LogSpec *spec)
+{
+    const char *p = *fmt;
+    size_t n = 0;
+
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') {
+        if (n == sizeof(spec->flags) - 1) {
+            return SDL_FALSE;
+        }
+        spec->flags[n++] = *p++;
+    }
+    spec->flags[n] = '\0';
+    spec->width = -1;
+    spec->precision = -1;
+    spec->width_arg = SDL_FALSE;
+    spec->precision_arg = SDL_FALSE;
+    if (*p == '*') {
+        spec->width_arg = SDL_TRUE;
+        ++p;
+    } else {
+        for (; *p >= '0' && *p <= '9'; ++p) {
+            if (spec->width > 99999) {
+                return SDL_FALSE;
+            }
+            spec->width = SDL_max(spec->width, 0) * 10 + (*p - '0');
+        }
+    }
+    if (*p == '.') {
+        spec->precision = 0;
+        if (*++p == '*') {
+            spec->precision_arg = SDL_TRUE;
+            ++p;
+        }
+        for (; *p >= '0' && *p <= '9'; ++p) {
+            if (spec->precision > 99999) {
+                return SDL_FALSE;
+            }
+            spec->precision = spec->precision * 10 + (*p - '0');
+        }
+    }
+    spec->length = 0;
+    switch (*p) {
+    case 'h':
+    case 'l':
+        spec->length = *p++;
+        if (*p == spec->length) {
+            spec->length = (spec->length == 'h') ? 'H' : 'L';
+            ++p;
+        }
+        break;
+    case 'z':
+    case 't':
+    case 'j':
+        spec->length = *p++;
+        break;
+    case 'I':
+        if (SDL_strncmp(p, "I64", 3) != 0) {
+            return SDL_FALSE;
+        }
+        spec->length = 'L';
+        p += 3;
+        break;
+    }
+    spec->conversion = *p;
+    switch (*p++) {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a':
+    case 'A':
+        if (spec->length && spec->length != 'l') {
+            return SDL_FALSE;
+        }
+        break;
+    case 'c': case 's': case 'p': case '%':
+        if (spec->length) {
+            return SDL_FALSE;
+        }
+        break;
+    default:
+        return SDL_FALSE;
+    }
+    *fmt = p;
+    return SDL_TRUE;
+}
+
+/* Copy the arguments of `fmt` from `ap`, strings as pointers & their sizes
+   in `sizes` (0 for the rest).  Returns the number of arguments, or -1 if
+   the message can't be copied. */
+static int
+SDL_LogCapture(const char *fmt, va_list ap, SDL_LogArg *args, size_t *sizes)
+{
+    SDL_LogSpec spec;
+    int n = 0;
+
+    while (*fmt) {
+        if (*fmt++ != '%') {
+            continue;
+        }
+        if (!SDL_LogParseSpec(&fmt, &spec)) {
+            return -1;
+        }
+        if (spec.conversion == '%') {
+            continue;
+        }
+        if (n + 3 > SDL_LOG_ARGS_MAX) {
+            return -1;
+        }
+        if (spec.width_arg) {
+            sizes[n] = 0;
+            args[n++].i = va_arg(ap, int);
+        }
+        if (spec.precision_arg) {
+            sizes[n] = 0;
+            spec.precision = va_arg(ap, int);
+            args[n++].i = spec.precision;
+        }
+        sizes[n] = 0;
+        switch (spec.conversion) {
+        case 'd':
+        case 'i':
+            switch (spec.length) {
+            case 'H': args[n].i = (signed char) va_arg(ap, int); break;
+            case 'h': args[n].i = (short) va_arg(ap, int); break;
+            case 'l': args[n].i = va_arg(ap, long); break;
+            case 'L': args[n].i = va_arg(ap, long long); break;
+            case 'z': args[n].i = (Sint64) va_arg(ap, size_t); break;
+            case 't': args[n].i = va_arg(ap, ptrdiff_t); break;
+            case 'j': args[n].i = (Sint64) va_arg(ap, intmax_t); break;
+            default: args[n].i = va_arg(ap, int); break;
+            }
+            break;
+        case 'c':
+            args[n].i = va_arg(ap, int);
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            switch (spec.length) {
+            case 'H': args[n].i = (unsigned char) va_arg(ap, unsigned int); break;
+            case 'h': args[n].i = (unsigned short) va_arg(ap, unsigned int); break;
+            case 'l': args[n].i = (Sint64) va_arg(ap, unsigned long); break;
+            case 'L': args[n].i = (Sint64) va_arg(ap, unsigned long long); break;
+            case 'z': args[n].i = (Sint64) va_arg(ap, size_t); break;
+            case 't': args[n].i = (Sint64) va_arg(ap, ptrdiff_t); break;
+            case 'j': args[n].i = (Sint64) va_arg(ap, uintmax_t); break;
+            default: args[n].i = va_arg(ap, unsigned int); break;
+            }
+            break;
+        case 'p':
+            args[n].p = va_arg(ap, void *);
+            break;
+        case 's':
+            {
+                const char *string = va_arg(ap, const char *);
+                size_t size = 0;
+
+                if (!string) {
+                    string = "(null)";
+                }
+                /* Up to the precision, past it may not be a string */
+                while (string[size] && (spec.precision < 0 ||
+                       size < (size_t) spec.precision) &&
+                       size < SDL_MAX_LOG_MESSAGE) {
+                    ++size;
+                }
+                args[n].p = string;
+                sizes[n] = size + 1;
+            }
+            break;
+        default:
+            args[n].d = va_arg(ap, double);
+            break;
+        }
+        ++n;
+    }
+    return n;
+}
+
+/* Format `record` as SDL_vsnprintf() would have */
+static void
+SDL_LogFormat(const SDL_LogRecord *record, char *text, size_t maxlen)
+{
+    const SDL_LogArg *arg = (const SDL_LogArg *) ((const Uint8 *) record + SDL_LOG_HEADER);
+    const char *fmt = record->fmt;
+    size_t length = 0;
+    SDL_LogSpec spec;
+
+    while (*fmt && length < maxlen - 1) {
+        char conversion[48];
+        size_t n;
+        int width = -1;
+        int precision;
+        int written;
+
+        if (*fmt != '%') {
+            text[length++] = *fmt++;
+            continue;
+        }
+        ++fmt;
+        SDL_LogParseSpec(&fmt, &spec);  /* Parsed when it was copied */
+        if (spec.conversion == '%') {
+            text[length++] = '%';
+            continue;
+        }
+        precision = spec.precision;
+        if (spec.width_arg) {
+            width = (int) (arg++)->i;
+        } else {
+            width = spec.width;
+        }
+        if (spec.precision_arg) {
+            precision = (int) (arg++)->i;
+        }
+
+        /* Integers are all copied as 64 bits */
+        n = SDL_snprintf(conversion, sizeof(conversion), "%%%s", spec.flags);
+        if (spec.width_arg || width >= 0) {
+            n += SDL_snprintf(conversion + n, sizeof(conversion) - n, "%d", width);
+        }
+        if (precision >= 0) {
+            n += SDL_snprintf(conversion + n, sizeof(conversion) - n, ".%d", precision);
+        }
+        SDL_snprintf(conversion + n, sizeof(conversion) - n, "%s%c",
+                     SDL_strchr("diouxX", spec.conversion) ? "ll" : "",
+                     spec.conversion);
+
+        switch (spec.conversion) {
+        case 'd':
+        case 'i':
+            written = SDL_snprintf(&text[length], maxlen - length, conversion, (long long) arg->i);
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            written = SDL_snprintf(&text[length], maxlen - length, conversion, (unsigned long long) arg->i);
+            break;
+        case 'c':
+            written = SDL_snprintf(&text[length], maxlen - length, conversion, (int) arg->i);
+            break;
+        case 'p':
+            written = SDL_snprintf(&text[length], maxlen - length, conversion, arg->p);
+            break;
+        case 's':
+            written = SDL_snprintf(&text[length], maxlen - length, conversion, (const char *) record + arg->i);
+            break;
+        default:
+            written = SDL_snprintf(&text[length], maxlen - length, conversion, arg->d);
+            break;
+        }
+        ++arg;
+        if (written > 0) {
+            length += SDL_min((size_t) written, maxlen - 1 - length);
+        }
+    }
+    text[length] = '\0';
+}
+
+static void
+SDL_LogOutputMessage(int category, SDL_LogPriority priority, char *message)
+{
+    size_t len = SDL_strlen(message);
+
+    /* Chop off final endline. */
+    if ((len > 0) && (message[len-1] == '\n')) {
+        message[--len] = '\0';
+        if ((len > 0) && (message[len-1] == '\r')) {  /* catch "\r\n", too. */
+            message[--len] = '\0';
+        }
+    }
+
+    if (SDL_log_function) {
+        SDL_log_function(SDL_log_userdata, category, priority, message);
+    }
+}
+
+/* The oldest record of `ring` not output yet, or NULL */
+static SDL_LogRecord *
+SDL_LogPeek(SDL_LogRing *ring)
+{
+    Uint32 head = (Uint32) SDL_AtomicLoad(&ring->head, SDL_MEMORY_ORDER_ACQUIRE);
+    Uint32 tail = (Uint32) SDL_AtomicLoad(&ring->tail, SDL_MEMORY_ORDER_RELAXED);
+
+    while (tail != head) {
+        SDL_LogRecord *record = (SDL_LogRecord *)
+            ((Uint8 *) ring->buffer + (tail & (SDL_LOG_RING_SIZE - 1)));
+
+        if (record->priority) {
+            return record;
+        }
+        tail += record->size;
+        SDL_AtomicStore(&ring->tail, (int) tail, SDL_MEMORY_ORDER_RELEASE);
+    }
+    return NULL;
+}
+
+/* Output what's in the rings, oldest first */
+static void
+SDL_LogDrain(void)
+{
+    static char message[SDL_MAX_LOG_MESSAGE];
+    SDL_LogRing **link;
+
+    SDL_LockMutex(SDL_log_drain_lock);
+    SDL_log_drainer = SDL_ThreadID();
+    for (;;) {
+        SDL_LogRing *ring;
+        SDL_LogRing *oldest_ring = NULL;
+        SDL_LogRecord *oldest = NULL;
+
+        /* Rings are only unlinked here, the lock is for adding them */
+        SDL_AtomicLock(&SDL_log_rings_lock);
+        ring = SDL_log_rings;
+        SDL_AtomicUnlock(&SDL_log_rings_lock);
+        for (; ring; ring = ring->next) {
+            SDL_LogRecord *record = SDL_LogPeek(ring);
+
+            if (record && (!oldest || (Sint32) (record->sequence - oldest->sequence) < 0)) {
+                oldest = record;
+                oldest_ring = ring;
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        SDL_LogFormat(oldest, message, sizeof(message));
+        SDL_LogOutputMessage(oldest->category, (SDL_LogPriority) oldest->priority, message);
+        SDL_AtomicAdd(&oldest_ring->tail, (int) oldest->size);
+    }
+
+    /* Free the rings of threads that exited, now they're empty */
+    SDL_AtomicLock(&SDL_log_rings_lock);
+    for (link = &SDL_log_rings; *link; ) {
+        SDL_LogRing *ring = *link;
+
+        if (SDL_AtomicGet(&ring->dead) && !SDL_LogPeek(ring)) {
+            *link = ring->next;
+            SDL_free(ring);
+        } else {
+            link = &ring->next;
+        }
+    }
+    SDL_AtomicUnlock(&SDL_log_rings_lock);
+    SDL_log_drainer = 0;
+    SDL_UnlockMutex(SDL_log_drain_lock);
+}
+
+static void
+SDL_LogRingExit(void *ring)
+{
+    SDL_AtomicSet(&((SDL_LogRing *) ring)->dead, 1);
+}
+
+/* The calling thread's ring, or NULL */
+static SDL_LogRing *
+SDL_LogGetRing(void)
+{
+    SDL_LogRing *ring = (SDL_LogRing *) SDL_TLSGet(SDL_LOG_RING);
+
+    if (!ring) {
+        ring = (SDL_LogRing *) SDL_calloc(1, sizeof(*ring));
+        if (!ring) {
+            return NULL;
+        }
+        if (SDL_TLSSet(SDL_LOG_RING, ring, SDL_LogRingExit) < 0) {
+            SDL_free(ring);
+            return NULL;
+        }
+        SDL_AtomicLock(&SDL_log_rings_lock);
+        ring->next = SDL_log_rings;
+        SDL_log_rings = ring;
+        SDL_AtomicUnlock(&SDL_log_rings_lock);
+    }
+    return ring;
+}
+
+/* Room for `size` bytes in `ring` at `*head`, or NULL */
+static SDL_LogRecord *
+SDL_LogReserve(SDL_LogRing *ring, Uint32 size, Uint32 *head)
+{
+    Uint32 offset;
+    Uint32 pad;
+
+    *head = (Uint32) SDL_AtomicLoad(&ring->head, SDL_MEMORY_ORDER_RELAXED);
+    offset = *head & (SDL_LOG_RING_SIZE - 1);
+    pad = (offset + size > SDL_LOG_RING_SIZE) ? SDL_LOG_RING_SIZE - offset : 0;
+    while (*head + pad + size - (Uint32) SDL_AtomicLoad(&ring->tail, SDL_MEMORY_ORDER_ACQUIRE) > SDL_LOG_RING_SIZE) {
+        /* Full, output what's waiting, unless that's what logged this */
+        if (SDL_log_drainer == SDL_ThreadID()) {
+            return NULL;
+        }
+        SDL_LogDrain();
+    }
+    if (pad) {
+        SDL_LogRecord *record = (SDL_LogRecord *) ((Uint8 *) ring->buffer + offset);
+
+        record->size = pad;
+        record->priority = 0;
+        *head += pad;
+    }
+    return (SDL_LogRecord *) ((Uint8 *) ring->buffer + (*head & (SDL_LOG_RING_SIZE - 1)));
+}
+
+/* Publish what was written up to `head` */
+static void
+SDL_LogCommit(SDL_LogRing *ring, Uint32 head)
+{
+    Uint32 old = (Uint32) SDL_AtomicLoad(&ring->head, SDL_MEMORY_ORDER_RELAXED);
+    Uint32 tail = (Uint32) SDL_AtomicLoad(&ring->tail, SDL_MEMORY_ORDER_RELAXED);
+
+    SDL_AtomicStore(&ring->head, (int) head, SDL_MEMORY_ORDER_RELEASE);
+
+    /* Over half full, wake the background thread early */
+    if (head - tail > SDL_LOG_RING_SIZE / 2 && old - tail <= SDL_LOG_RING_SIZE / 2 && SDL_log_wake) {
+        SDL_SemPost(SDL_log_wake);
+    }
+}
+
+/* Copy a message into the calling thread's ring, SDL_FALSE if it must be
+   output now */
+static SDL_bool
+SDL_LogDefer(int category, SDL_LogPriority priority, const char *fmt, va_list ap)
+{
+    SDL_LogArg args[SDL_LOG_ARGS_MAX];
+    size_t sizes[SDL_LOG_ARGS_MAX];
+    SDL_LogRing *ring = SDL_LogGetRing();
+    SDL_LogRecord *record;
+    char *message = NULL;
+    size_t size;
+    Uint32 head;
+    va_list copy;
+    int nargs;
+    int i;
+
+    if (!ring) {
+        return SDL_FALSE;
+    }
+    va_copy(copy, ap);
+    nargs = SDL_LogCapture(fmt, copy, args, sizes);
+    va_end(copy);
+    size = SDL_LOG_HEADER;
+    for (i = 0; i < nargs; ++i) {
+        size += sizeof(SDL_LogArg) + sizes[i];
+    }
+    if (nargs < 0 || size > SDL_LOG_RECORD_MAX) {
+        /* Send it formatted */
+        message = SDL_stack_alloc(char, SDL_MAX_LOG_MESSAGE);
+        if (!message) {
+            return SDL_FALSE;
+        }
+        SDL_vsnprintf(message, SDL_MAX_LOG_MESSAGE, fmt, ap);
+        fmt = "%s";
+        nargs = 1;
+        args[0].p = message;
+        sizes[0] = SDL_strlen(message) + 1;
+        size = SDL_LOG_HEADER + sizeof(SDL_LogArg) + sizes[0];
+    }
+    size = SDL_LOG_ALIGN(size);
+    record = SDL_LogReserve(ring, (Uint32) size, &head);
+    if (record) {
+        SDL_LogArg *arg = (SDL_LogArg *) ((Uint8 *) record + SDL_LOG_HEADER);
+        size_t offset = SDL_LOG_HEADER + nargs * sizeof(SDL_LogArg);
+
+        record->size = (Uint32) size;
+        record->sequence = (Uint32) SDL_AtomicIncRef(&SDL_log_sequence);
+        record->category = category;
+        record->priority = priority;
+        record->fmt = fmt;
+        for (i = 0; i < nargs; ++i) {
+            if (sizes[i]) {
+                SDL_memcpy((Uint8 *) record + offset, args[i].p, sizes[i] - 1);
+                ((char *) record)[offset + sizes[i] - 1] = '\0';
+                arg[i].i = (Sint64) offset;
+                offset += sizes[i];
+            } else {
+                arg[i] = args[i];
+            }
+        }
+        SDL_LogCommit(ring, head + (Uint32) size);
+    }
+    if (message) {
+        SDL_stack_free(message);
+    }
+    return record ? SDL_TRUE : SDL_FALSE;
+}
+
+static int SDLCALL
+SDL_LogThread(void *data)
+{
+    (void) data;
+    while (!SDL_AtomicGet(&SDL_log_quit)) {
+        SDL_SemWaitTimeout(SDL_log_wake, SDL_LOG_INTERVAL);
+        SDL_LogDrain();
+    }
+    return 0;
+}
+
+int
+SDL_LogSetAsync(SDL_bool async)
+{
+    if (async == SDL_log_async) {
+        return 0;
+    }
+    if (async) {
+        if (!SDL_log_drain_lock) {
+            SDL_log_drain_lock = SDL_CreateMutex();
+            if (!SDL_log_drain_lock) {
+                return -1;
+            }
+        }
+        SDL_log_wake = SDL_CreateSemaphore(0);
+        if (!SDL_log_wake) {
+            return -1;
+        }
+        SDL_AtomicSet(&SDL_log_quit, 0);
+        SDL_log_thread = SDL_CreateThread(SDL_LogThread, "SDLLog", NULL);
+        if (!SDL_log_thread) {
+            SDL_DestroySemaphore(SDL_log_wake);
+            SDL_log_wake = NULL;
+            return -1;
+        }
+        SDL_log_async = SDL_TRUE;
+        return 0;
+    }
+    SDL_log_async = SDL_FALSE;
+    SDL_AtomicSet(&SDL_log_quit, 1);
+    SDL_SemPost(SDL_log_wake);
+    SDL_WaitThread(SDL_log_thread, NULL);
+    SDL_log_thread = NULL;
+    SDL_DestroySemaphore(SDL_log_wake);
+    SDL_log_wake = NULL;
+    SDL_LogDrain();
+    return 0;
+}
+
+void
+SDL_LogFlush(void)
+{
+    if (SDL_log_drain_lock) {
+        SDL_LogDrain();
+    }
 }
 
 void
@@ -267,7 +900,6 @@ void
 SDL_LogMessageV(int category, SDL_LogPriority priority, const char *fmt, va_list ap)
 {
     char *message;
-    size_t len;
 
     /* Nothing to do if we don't have an output function */
     if (!SDL_log_function) {
@@ -280,7 +912,11 @@ SDL_LogMessageV(int category, SDL_LogPriority priority, const char *fmt, va_list
     }
 
     /* See if we want to do anything with this message */
-    if (priority < SDL_LogGetPriority(category)) {
+    if (priority < SDL_LogCachedPriority(category)) {
+        return;
+    }
+
+    if (SDL_log_async && SDL_LogDefer(category, priority, fmt, ap)) {
         return;
     }
 
@@ -290,17 +926,7 @@ SDL_LogMessageV(int category, SDL_LogPriority priority, const char *fmt, va_list
     }
 
     SDL_vsnprintf(message, SDL_MAX_LOG_MESSAGE, fmt, ap);
-
-    /* Chop off final endline. */
-    len = SDL_strlen(message);
-    if ((len > 0) && (message[len-1] == '\n')) {
-        message[--len] = '\0';
-        if ((len > 0) && (message[len-1] == '\r')) {  /* catch "\r\n", too. */
-            message[--len] = '\0';
-        }
-    }
-
-    SDL_log_function(SDL_log_userdata, category, priority, message);
+    SDL_LogOutputMessage(category, priority, message);
     SDL_stack_free(message);
 }
 
@@ -316,6 +942,8 @@ static void
 SDL_LogOutput(void *userdata, int category, SDL_LogPriority priority,
               const char *message)
 {
+    (void) userdata;
+    (void) category;  /* only some platforms tag messages with it */
 #if defined(__WIN32__) || defined(__WINRT__)
     /* Way too many allocations here, urgh */
     /* Note: One can't call SDL_SetError here, since that function itself logs. */
@@ -0,0 +1,547 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "./SDL_internal.h"
+
+/* Counters and histograms, see SDL_metrics.h.
+
+   A thread's copies of the metrics are in its shard, in pages of
+   SDL_METRIC_PAGE indexed by the metrics' ids, each allocated by the thread
+   the first time it updates one of them.  Only the shard's thread writes to
+   it, so an update is a load and a store of its own cache lines; readers
+   add the shards up.  When an SDL thread exits (its TLS destructor) its
+   shard is left for the next thread that needs one, so its counts are kept
+   and shards don't pile up as threads come and go. */
+
+#include "SDL_atomic.h"
+#include "SDL_bits.h"
+#include "SDL_error.h"
+#include "SDL_metrics.h"
+#include "SDL_thread.h"
+
+#define SDL_METRIC_SHARD SDL_TLS_STATIC(2)
+#define SDL_METRIC_PAGE 64              /* Metrics per page of a shard */
+#define SDL_METRIC_PAGES 64             /* ... so 4096 metrics at most */
+#define SDL_METRIC_SUB_BITS 4           /* log2 of buckets per power of 2 */
+#define SDL_METRIC_SUB (1 << SDL_METRIC_SUB_BITS)
+#define SDL_METRIC_BUCKETS ((64 - SDL_METRIC_SUB_BITS + 1) * SDL_METRIC_SUB)
+#define SDL_METRIC_TEXT 4096            /* Bytes written to a stream at once */
+
+/* A shard's values are only written by its thread, others only need reads
+   that don't tear.  Without 64-bit atomics they're read and written under
+   the shard's lock instead, which only a reader ever waits for. */
+#ifdef SDL_HAS_ATOMIC64
+#define SDL_METRIC_GET(v) SDL_AtomicLoad64(v, SDL_MEMORY_ORDER_RELAXED)
+#define SDL_METRIC_SET(v, x) SDL_AtomicStore64(v, x, SDL_MEMORY_ORDER_RELAXED)
+#define SDL_METRIC_LOCK(shard)
+#define SDL_METRIC_UNLOCK(shard)
+#else
+#define SDL_METRIC_GET(v) ((v)->value)
+#define SDL_METRIC_SET(v, x) ((v)->value = (x))
+#define SDL_METRIC_LOCK(shard) SDL_AtomicLock(&(shard)->lock)
+#define SDL_METRIC_UNLOCK(shard) SDL_AtomicUnlock(&(shard)->lock)
+#endif
+
+typedef enum
+{
+    SDL_METRIC_COUNTER,
+    SDL_METRIC_HISTOGRAM
+} SDL_MetricKind;
+
+struct SDL_Metric
+{
+    int id;                 /* Where its values are in a shard */
+    SDL_MetricKind kind;
+    char *name;
+    char *help;             /* NULL without one */
+    void *next;             /* SDL_Metric, appended to while it's read */
+};
+
+/* A shard's values of SDL_METRIC_PAGE metrics */
+typedef struct
+{
+    SDL_atomic64_t count[SDL_METRIC_PAGE];  /* A counter's */
+    SDL_atomic64_t sum[SDL_METRIC_PAGE];    /* A histogram's values' */
+    void *buckets[SDL_METRIC_PAGE];         /* SDL_METRIC_BUCKETS of them */
+} SDL_MetricPage;
+
+typedef struct SDL_MetricShard
+{
+    SDL_atomic_t owned;     /* A thread's updating it */
+    SDL_SpinLock lock;      /* See SDL_METRIC_LOCK */
+    void *pages[SDL_METRIC_PAGES];
+    struct SDL_MetricShard *next;
+} SDL_MetricShard;
+
+static SDL_Metric *SDL_metrics;
+static SDL_Metric *SDL_metrics_last;
+static int SDL_metric_count;
+static SDL_MetricShard *SDL_metric_shards;  /* Only ever added to */
+static SDL_SpinLock SDL_metrics_lock;
+
+static void
+SDL_MetricShardExit(void *shard)
+{
+    SDL_AtomicSet(&((SDL_MetricShard *) shard)->owned, 0);
+}
+
+/* The calling thread's shard, or NULL */
+static SDL_MetricShard *
+SDL_GetMetricShard(void)
+{
+    SDL_MetricShard *shard = (SDL_MetricShard *) SDL_TLSGet(SDL_METRIC_SHARD);
+
+    if (shard) {
+        return shard;
+    }
+    /* One an exited thread left, or a new one */
+    SDL_AtomicLock(&SDL_metrics_lock);
+    for (shard = SDL_metric_shards; shard; shard = shard->next) {
+        if (SDL_AtomicCAS(&shard->owned, 0, 1)) {
+            break;
+        }
+    }
+    SDL_AtomicUnlock(&SDL_metrics_lock);
+    if (!shard) {
+        shard = (SDL_MetricShard *) SDL_calloc(1, sizeof(*shard));
+        if (!shard) {
+            return NULL;
+        }
+        SDL_AtomicSet(&shard->owned, 1);
+        SDL_AtomicLock(&SDL_metrics_lock);
+        shard->next = SDL_metric_shards;
+        SDL_metric_shards = shard;
+        SDL_AtomicUnlock(&SDL_metrics_lock);
+    }
+    if (SDL_TLSSet(SDL_METRIC_SHARD, shard, SDL_MetricShardExit) < 0) {
+        SDL_AtomicSet(&shard->owned, 0);
+        return NULL;
+    }
+    return shard;
+}
+
+/* The page of `shard` with metric `id`, or NULL.  Only its thread adds one. */
+static SDL_MetricPage *
+SDL_GetMetricPage(SDL_MetricShard *shard, int id)
+{
+    SDL_MetricPage *page = (SDL_MetricPage *) shard->pages[id / SDL_METRIC_PAGE];
+
+    if (!page) {
+        page = (SDL_MetricPage *) SDL_calloc(1, sizeof(*page));
+        if (!page) {
+            return NULL;
+        }
+        SDL_AtomicSetPtr(&shard->pages[id / SDL_METRIC_PAGE], page);
+    }
+    return page;
+}
+
+/* The bucket of `value`: itself below SDL_METRIC_SUB, otherwise its top
+   SDL_METRIC_SUB_BITS + 1 bits & how far they're shifted */
+static int
+SDL_MetricBucket(Uint64 value)
+{
+    Uint32 high = (Uint32) (value >> 32);
+    int shift;
+
+    if (value < SDL_METRIC_SUB) {
+        return (int) value;
+    }
+    shift = (high ? 32 + SDL_MostSignificantBitIndex32(high) :
+             SDL_MostSignificantBitIndex32((Uint32) value)) - SDL_METRIC_SUB_BITS;
+    return shift * SDL_METRIC_SUB + (int) (value >> shift);
+}
+
+/* The largest value in `bucket` */
+static Uint64
+SDL_MetricBucketTop(int bucket)
+{
+    int shift;
+
+    if (bucket < 2 * SDL_METRIC_SUB) {
+        return (Uint64) bucket;
+    }
+    shift = bucket / SDL_METRIC_SUB - 1;
+    return (((Uint64) (bucket - shift * SDL_METRIC_SUB) + 1) << shift) - 1;
+}
+
+/* The power of 2 `bucket` is under: its values are below 1 << it */
+static int
+SDL_MetricBucketPower(int bucket)
+{
+    if (bucket >= SDL_METRIC_SUB) {
+        return bucket / SDL_METRIC_SUB + SDL_METRIC_SUB_BITS;
+    }
+    return bucket ? SDL_MostSignificantBitIndex32((Uint32) bucket) + 1 : 0;
+}
+
+static SDL_bool
+SDL_IsMetricName(const char *name)
+{
+    const char *c;
+
+    for (c = name; *c; ++c) {
+        if (!((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+              *c == '_' || *c == ':' || (c != name && *c >= '0' && *c <= '9'))) {
+            return SDL_FALSE;
+        }
+    }
+    return c != name;
+}
+
+static SDL_Metric *
+SDL_CreateMetric(const char *name, const char *help, SDL_MetricKind kind)
+{
+    SDL_Metric *metric;
+
+    if (!name || !SDL_IsMetricName(name)) {
+        SDL_SetError("Invalid metric name '%s'", name ? name : "(null)");
+        return NULL;
+    }
+    SDL_AtomicLock(&SDL_metrics_lock);
+    for (metric = SDL_metrics; metric; metric = (SDL_Metric *) metric->next) {
+        if (SDL_strcmp(metric->name, name) == 0) {
+            break;
+        }
+    }
+    if (metric) {
+        SDL_AtomicUnlock(&SDL_metrics_lock);
+        if (metric->kind != kind) {
+            SDL_SetError("Metric '%s' is already a %s", name,
+                         metric->kind == SDL_METRIC_COUNTER ? "counter" : "histogram");
+            return NULL;
+        }
+        return metric;
+    }
+    if (SDL_metric_count == SDL_METRIC_PAGE * SDL_METRIC_PAGES) {
+        SDL_AtomicUnlock(&SDL_metrics_lock);
+        SDL_SetError("Too many metrics");
+        return NULL;
+    }
+    metric = (SDL_Metric *) SDL_calloc(1, sizeof(*metric));
+    if (!metric || !(metric->name = SDL_strdup(name)) ||
+        (help && !(metric->help = SDL_strdup(help)))) {
+        SDL_AtomicUnlock(&SDL_metrics_lock);
+        if (metric) {
+            SDL_free(metric->name);
+            SDL_free(metric);
+        }
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    metric->id = SDL_metric_count++;
+    metric->kind = kind;
+    /* Readers walk the list without the lock */
+    if (SDL_metrics_last) {
+        SDL_AtomicSetPtr(&SDL_metrics_last->next, metric);
+    } else {
+        SDL_AtomicSetPtr((void **) &SDL_metrics, metric);
+    }
+    SDL_metrics_last = metric;
+    SDL_AtomicUnlock(&SDL_metrics_lock);
+    return metric;
+}
+
+SDL_Metric *
+SDL_CreateCounter(const char *name, const char *help)
+{
+    return SDL_CreateMetric(name, help, SDL_METRIC_COUNTER);
+}
+
+SDL_Metric *
+SDL_CreateHistogram(const char *name, const char *help)
+{
+    return SDL_CreateMetric(name, help, SDL_METRIC_HISTOGRAM);
+}
+
+void
+SDL_CounterAdd(SDL_Metric * counter, Sint64 value)
+{
+    SDL_MetricShard *shard;
+    SDL_MetricPage *page;
+    SDL_atomic64_t *count;
+
+    if (!counter || counter->kind != SDL_METRIC_COUNTER ||
+        !(shard = SDL_GetMetricShard()) ||
+        !(page = SDL_GetMetricPage(shard, counter->id))) {
+        return;
+    }
+    count = &page->count[counter->id % SDL_METRIC_PAGE];
+    SDL_METRIC_LOCK(shard);
+    SDL_METRIC_SET(count, SDL_METRIC_GET(count) + value);
+    SDL_METRIC_UNLOCK(shard);
+}
+
+void
+SDL_HistogramRecord(SDL_Metric * histogram, Uint64 value)
+{
+    SDL_MetricShard *shard;
+    SDL_MetricPage *page;
+    SDL_atomic64_t *buckets;
+    SDL_atomic64_t *bucket;
+    SDL_atomic64_t *sum;
+    int i;
+
+    if (!histogram || histogram->kind != SDL_METRIC_HISTOGRAM ||
+        !(shard = SDL_GetMetricShard()) ||
+        !(page = SDL_GetMetricPage(shard, histogram->id))) {
+        return;
+    }
+    i = histogram->id % SDL_METRIC_PAGE;
+    buckets = (SDL_atomic64_t *) page->buckets[i];
+    if (!buckets) {
+        buckets = (SDL_atomic64_t *) SDL_calloc(SDL_METRIC_BUCKETS, sizeof(*buckets));
+        if (!buckets) {
+            return;
+        }
+        SDL_AtomicSetPtr(&page->buckets[i], buckets);
+    }
+    bucket = &buckets[SDL_MetricBucket(value)];
+    sum = &page->sum[i];
+    SDL_METRIC_LOCK(shard);
+    SDL_METRIC_SET(bucket, SDL_METRIC_GET(bucket) + 1);
+    SDL_METRIC_SET(sum, SDL_METRIC_GET(sum) + (Sint64) value);
+    SDL_METRIC_UNLOCK(shard);
+}
+
+/* Add up a counter's shards, or a histogram's into `buckets` (zeroed, if not
+   NULL) & `sum`, returns the count.  A histogram's is its buckets' so an
+   export's always adds up, even while it's recorded into. */
+static Sint64
+SDL_MetricTotal(SDL_Metric *metric, Uint64 *buckets, Sint64 *sum)
+{
+    SDL_MetricShard *shard;
+    Sint64 count = 0;
+    int i = metric->id % SDL_METRIC_PAGE;
+    int b;
+
+    SDL_AtomicLock(&SDL_metrics_lock);
+    shard = SDL_metric_shards;
+    SDL_AtomicUnlock(&SDL_metrics_lock);
+    for (; shard; shard = shard->next) {
+        SDL_MetricPage *page = (SDL_MetricPage *)
+            SDL_AtomicGetPtr(&shard->pages[metric->id / SDL_METRIC_PAGE]);
+        SDL_atomic64_t *values;
+
+        if (!page) {
+            continue;
+        }
+        SDL_METRIC_LOCK(shard);
+        if (metric->kind == SDL_METRIC_COUNTER) {
+            count += SDL_METRIC_GET(&page->count[i]);
+        } else if ((values = (SDL_atomic64_t *) SDL_AtomicGetPtr(&page->buckets[i]))) {
+            for (b = 0; b < SDL_METRIC_BUCKETS; ++b) {
+                Sint64 n = SDL_METRIC_GET(&values[b]);
+
+                if (buckets) {
+                    buckets[b] += (Uint64) n;
+                }
+                count += n;
+            }
+            if (sum) {
+                *sum += SDL_METRIC_GET(&page->sum[i]);
+            }
+        }
+        SDL_METRIC_UNLOCK(shard);
+    }
+    return count;
+}
+
+Sint64
+SDL_GetMetricCount(SDL_Metric * metric)
+{
+    if (!metric) {
+        SDL_InvalidParamError("metric");
+        return 0;
+    }
+    return SDL_MetricTotal(metric, NULL, NULL);
+}
+
+Uint64
+SDL_GetMetricQuantile(SDL_Metric * metric, double q)
+{
+    Uint64 *buckets;
+    Uint64 rank;
+    Uint64 seen = 0;
+    Uint64 value = 0;
+    Sint64 count;
+    int b;
+
+    if (!metric || metric->kind != SDL_METRIC_HISTOGRAM) {
+        SDL_InvalidParamError("metric");
+        return 0;
+    }
+    buckets = (Uint64 *) SDL_calloc(SDL_METRIC_BUCKETS, sizeof(*buckets));
+    if (!buckets) {
+        SDL_OutOfMemory();
+        return 0;
+    }
+    count = SDL_MetricTotal(metric, buckets, NULL);
+    q = q < 0.0 ? 0.0 : q > 1.0 ? 1.0 : q;
+    rank = (Uint64) SDL_ceil(q * (double) count);
+    if (rank == 0) {
+        rank = 1;
+    }
+    for (b = 0; count && b < SDL_METRIC_BUCKETS; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            value = SDL_MetricBucketTop(b);
+            break;
+        }
+    }
+    SDL_free(buckets);
+    return value;
+}
+
+/* Text for a stream, written SDL_METRIC_TEXT bytes at a time */
+typedef struct
+{
+    SDL_RWops *dst;
+    size_t used;
+    SDL_bool failed;
+    char text[SDL_METRIC_TEXT];
+} SDL_MetricWriter;
+
+static void
+SDL_MetricFlush(SDL_MetricWriter *writer)
+{
+    if (writer->used && SDL_RWwrite(writer->dst, writer->text, 1,
+                                    writer->used) != writer->used) {
+        writer->failed = SDL_TRUE;
+    }
+    writer->used = 0;
+}
+
+/* A line longer than SDL_METRIC_TEXT is cut off */
+static void
+SDL_MetricPrintf(SDL_MetricWriter *writer, SDL_PRINTF_FORMAT_STRING const char *fmt, ...) SDL_PRINTF_VARARG_FUNC(2);
+static void
+SDL_MetricPrintf(SDL_MetricWriter *writer, SDL_PRINTF_FORMAT_STRING const char *fmt, ...)
+{
+    size_t room = sizeof(writer->text) - writer->used;
+    va_list ap;
+    int length;
+
+    va_start(ap, fmt);
+    length = SDL_vsnprintf(&writer->text[writer->used], room, fmt, ap);
+    va_end(ap);
+    if (length >= 0 && (size_t) length >= room && writer->used) {
+        SDL_MetricFlush(writer);
+        room = sizeof(writer->text);
+        va_start(ap, fmt);
+        length = SDL_vsnprintf(writer->text, room, fmt, ap);
+        va_end(ap);
+    }
+    if (length > 0) {
+        writer->used += (size_t) length < room ? (size_t) length : room - 1;
+    }
+}
+
+/* "# HELP name help", with '\' and newlines escaped */
+static void
+SDL_MetricHelp(SDL_MetricWriter *writer, SDL_Metric *metric)
+{
+    const char *c;
+
+    SDL_MetricPrintf(writer, "# HELP %s ", metric->name);
+    for (c = metric->help; *c; ++c) {
+        if (writer->used + 2 >= sizeof(writer->text)) {
+            SDL_MetricFlush(writer);
+        }
+        if (*c == '\\' || *c == '\n') {
+            writer->text[writer->used++] = '\\';
+        }
+        writer->text[writer->used++] = *c == '\n' ? 'n' : *c;
+    }
+    SDL_MetricPrintf(writer, "\n");
+}
+
+int
+SDL_WriteMetrics(SDL_RWops * dst)
+{
+    SDL_MetricWriter *writer;
+    SDL_Metric *metric;
+    Uint64 *buckets;
+    SDL_bool failed;
+
+    if (!dst) {
+        return SDL_InvalidParamError("dst");
+    }
+    writer = (SDL_MetricWriter *) SDL_malloc(sizeof(*writer));
+    buckets = (Uint64 *) SDL_malloc(SDL_METRIC_BUCKETS * sizeof(*buckets));
+    if (!writer || !buckets) {
+        SDL_free(writer);
+        SDL_free(buckets);
+        return SDL_OutOfMemory();
+    }
+    writer->dst = dst;
+    writer->used = 0;
+    writer->failed = SDL_FALSE;
+    metric = (SDL_Metric *) SDL_AtomicGetPtr((void **) &SDL_metrics);
+    for (; metric; metric = (SDL_Metric *) SDL_AtomicGetPtr(&metric->next)) {
+        Sint64 sum = 0;
+        Sint64 count;
+        Uint64 below = 0;
+        int last = -1;
+        int power;
+        int b;
+
+        if (metric->help) {
+            SDL_MetricHelp(writer, metric);
+        }
+        if (metric->kind == SDL_METRIC_COUNTER) {
+            SDL_MetricPrintf(writer, "# TYPE %s counter\n%s %" SDL_PRIs64 "\n",
+                             metric->name, metric->name,
+                             SDL_MetricTotal(metric, NULL, NULL));
+            continue;
+        }
+        SDL_memset(buckets, 0, SDL_METRIC_BUCKETS * sizeof(*buckets));
+        count = SDL_MetricTotal(metric, buckets, &sum);
+        for (b = 0; b < SDL_METRIC_BUCKETS; ++b) {
+            if (buckets[b]) {
+                last = b;
+            }
+        }
+        SDL_MetricPrintf(writer, "# TYPE %s histogram\n", metric->name);
+        /* Values of up to `power` bits, for each power up to the largest's */
+        b = 0;
+        for (power = 0; last >= 0 && power <= SDL_MetricBucketPower(last); ++power) {
+            for (; b <= last && SDL_MetricBucketPower(b) <= power; ++b) {
+                below += buckets[b];
+            }
+            SDL_MetricPrintf(writer, "%s_bucket{le=\"%" SDL_PRIu64 "\"} %" SDL_PRIu64 "\n",
+                             metric->name, power ? ~(Uint64) 0 >> (64 - power) : 0,
+                             below);
+        }
+        SDL_MetricPrintf(writer, "%s_bucket{le=\"+Inf\"} %" SDL_PRIs64 "\n"
+                         "%s_sum %" SDL_PRIs64 "\n%s_count %" SDL_PRIs64 "\n",
+                         metric->name, count, metric->name, sum, metric->name, count);
+    }
+    SDL_MetricFlush(writer);
+    failed = writer->failed;
+    SDL_free(writer);
+    SDL_free(buckets);
+    if (failed) {
+        return SDL_SetError("Couldn't write the metrics");
+    }
+    return 0;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
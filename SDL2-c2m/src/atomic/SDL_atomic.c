@@ -36,57 +36,24 @@
 #endif
 
 /*
-  If any of the operations are not provided then we must emulate some
-  of them. That means we need a nice implementation of spin locks
-  that avoids the "one big lock" problem. We use a vector of spin
-  locks and pick which one to use based on the address of the operand
-  of the function.
-
-  To generate the index of the lock we first shift by 3 bits to get
-  rid on the zero bits that result from 32 and 64 bit allignment of
-  data. We then mask off all but 5 bits and use those 5 bits as an
-  index into the table.
-
-  Picking the lock this way insures that accesses to the same data at
-  the same time will go to the same lock. OTOH, accesses to different
-  data have only a 1/32 chance of hitting the same lock. That should
-  pretty much eliminate the chances of several atomic operations on
-  different data from waiting on the same "big lock". If it isn't
-  then the table of locks can be expanded to a new size so long as
-  the new size is a power of two.
-
-  Contributed by Bob Pendleton, bob@pendleton.com
+  There's no emulation: a platform without atomic instructions (or a compiler
+  without a way to emit them) doesn't build, rather than quietly serializing
+  everything on spin locks.  Where the compiler has the builtins behind the
+  native ops in SDL_atomic.h those are used, they're sequentially consistent
+  here like the rest of this API.
 */
 
-#if !defined(HAVE_MSC_ATOMICS) && !defined(HAVE_GCC_ATOMICS) && !defined(__MACOSX__) && !defined(__SOLARIS__)
-#define EMULATE_CAS 1
-#endif
-
-#if EMULATE_CAS
-static SDL_SpinLock locks[32];
-
-static SDL_INLINE void
-enterLock(void *a)
-{
-    uintptr_t index = ((((uintptr_t)a) >> 3) & 0x1f);
-
-    SDL_AtomicLock(&locks[index]);
-}
-
-static SDL_INLINE void
-leaveLock(void *a)
-{
-    uintptr_t index = ((((uintptr_t)a) >> 3) & 0x1f);
-
-    SDL_AtomicUnlock(&locks[index]);
-}
+#if !defined(SDL_HAS_NATIVE_ATOMICS) && !defined(HAVE_MSC_ATOMICS) && !defined(HAVE_GCC_ATOMICS) && !defined(__MACOSX__) && !defined(__SOLARIS__)
+#error No atomic instructions for this platform, please define them.
 #endif
 
 
 SDL_bool
 SDL_AtomicCAS(SDL_atomic_t *a, int oldval, int newval)
 {
-#ifdef HAVE_MSC_ATOMICS
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    return SDL_AtomicCompareExchange(a, &oldval, newval, SDL_MEMORY_ORDER_SEQ_CST);
+#elif defined(HAVE_MSC_ATOMICS)
     return (_InterlockedCompareExchange((long*)&a->value, (long)newval, (long)oldval) == (long)oldval);
 #elif defined(__MACOSX__)  /* !!! FIXME: should we favor gcc atomics? */
     return (SDL_bool) OSAtomicCompareAndSwap32Barrier(oldval, newval, &a->value);
@@ -96,17 +63,6 @@ SDL_AtomicCAS(SDL_atomic_t *a, int oldval, int newval)
     return (SDL_bool) ((int) atomic_cas_64((volatile uint64_t*)&a->value, (uint64_t)oldval, (uint64_t)newval) == oldval);
 #elif defined(__SOLARIS__) && !defined(_LP64)
     return (SDL_bool) ((int) atomic_cas_32((volatile uint32_t*)&a->value, (uint32_t)oldval, (uint32_t)newval) == oldval);
-#elif EMULATE_CAS
-    SDL_bool retval = SDL_FALSE;
-
-    enterLock(a);
-    if (a->value == oldval) {
-        a->value = newval;
-        retval = SDL_TRUE;
-    }
-    leaveLock(a);
-
-    return retval;
 #else
     #error Please define your platform.
 #endif
@@ -115,7 +71,9 @@ SDL_AtomicCAS(SDL_atomic_t *a, int oldval, int newval)
 SDL_bool
 SDL_AtomicCASPtr(void **a, void *oldval, void *newval)
 {
-#if defined(HAVE_MSC_ATOMICS) && (_M_IX86)
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    return SDL_AtomicCompareExchangePtr(a, &oldval, newval, SDL_MEMORY_ORDER_SEQ_CST);
+#elif defined(HAVE_MSC_ATOMICS) && (_M_IX86)
     return (_InterlockedCompareExchange((long*)a, (long)newval, (long)oldval) == (long)oldval);
 #elif defined(HAVE_MSC_ATOMICS) && (!_M_IX86)
     return (_InterlockedCompareExchangePointer(a, newval, oldval) == oldval);
@@ -127,17 +85,6 @@ SDL_AtomicCASPtr(void **a, void *oldval, void *newval)
     return __sync_bool_compare_and_swap(a, oldval, newval);
 #elif defined(__SOLARIS__)
     return (SDL_bool) (atomic_cas_ptr(a, oldval, newval) == oldval);
-#elif EMULATE_CAS
-    SDL_bool retval = SDL_FALSE;
-
-    enterLock(a);
-    if (*a == oldval) {
-        *a = newval;
-        retval = SDL_TRUE;
-    }
-    leaveLock(a);
-
-    return retval;
 #else
     #error Please define your platform.
 #endif
@@ -146,7 +93,9 @@ SDL_AtomicCASPtr(void **a, void *oldval, void *newval)
 int
 SDL_AtomicSet(SDL_atomic_t *a, int v)
 {
-#ifdef HAVE_MSC_ATOMICS
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    return SDL_AtomicExchange(a, v, SDL_MEMORY_ORDER_SEQ_CST);
+#elif defined(HAVE_MSC_ATOMICS)
     return _InterlockedExchange((long*)&a->value, v);
 #elif defined(HAVE_GCC_ATOMICS)
     return __sync_lock_test_and_set(&a->value, v);
@@ -166,7 +115,9 @@ SDL_AtomicSet(SDL_atomic_t *a, int v)
 void*
 SDL_AtomicSetPtr(void **a, void *v)
 {
-#if defined(HAVE_MSC_ATOMICS) && (_M_IX86)
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    return SDL_AtomicExchangePtr(a, v, SDL_MEMORY_ORDER_SEQ_CST);
+#elif defined(HAVE_MSC_ATOMICS) && (_M_IX86)
     return (void *) _InterlockedExchange((long *)a, (long) v);
 #elif defined(HAVE_MSC_ATOMICS) && (!_M_IX86)
     return _InterlockedExchangePointer(a, v);
@@ -186,7 +137,9 @@ SDL_AtomicSetPtr(void **a, void *v)
 int
 SDL_AtomicAdd(SDL_atomic_t *a, int v)
 {
-#ifdef HAVE_MSC_ATOMICS
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    return SDL_AtomicFetchAdd(a, v, SDL_MEMORY_ORDER_SEQ_CST);
+#elif defined(HAVE_MSC_ATOMICS)
     return _InterlockedExchangeAdd((long*)&a->value, v);
 #elif defined(HAVE_GCC_ATOMICS)
     return __sync_fetch_and_add(&a->value, v);
@@ -211,21 +164,29 @@ SDL_AtomicAdd(SDL_atomic_t *a, int v)
 int
 SDL_AtomicGet(SDL_atomic_t *a)
 {
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    return SDL_AtomicLoad(a, SDL_MEMORY_ORDER_SEQ_CST);
+#else
     int value;
     do {
         value = a->value;
     } while (!SDL_AtomicCAS(a, value, value));
     return value;
+#endif
 }
 
 void *
 SDL_AtomicGetPtr(void **a)
 {
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    return SDL_AtomicLoadPtr(a, SDL_MEMORY_ORDER_SEQ_CST);
+#else
     void *value;
     do {
         value = *a;
     } while (!SDL_AtomicCASPtr(a, value, value));
     return value;
+#endif
 }
 
 #ifdef __thumb__
@@ -62,6 +62,7 @@ extern AudioBootStrap COREAUDIO_bootstrap;
 extern AudioBootStrap SNDMGR_bootstrap;
 extern AudioBootStrap DISKAUD_bootstrap;
 extern AudioBootStrap DUMMYAUD_bootstrap;
+extern AudioBootStrap BENCHAUD_bootstrap;
 extern AudioBootStrap DCAUD_bootstrap;
 extern AudioBootStrap DART_bootstrap;
 extern AudioBootStrap NDSAUD_bootstrap;
@@ -146,6 +147,16 @@ static const AudioBootStrap *const bootstrap[] = {
     NULL
 };
 
+/* Drivers picked only by their full name (SDL_AUDIODRIVER=bench), not listed
+   by SDL_GetAudioDriver(), so nothing that tries every driver in turn gets
+   one that doesn't play in real time. */
+static const AudioBootStrap *const unlisted_bootstrap[] = {
+#if SDL_AUDIO_DRIVER_DUMMY
+    &BENCHAUD_bootstrap,
+#endif
+    NULL
+};
+
 static SDL_AudioDevice *
 get_audio_device(SDL_AudioDeviceID id)
 {
@@ -418,56 +429,127 @@ SDL_RemoveAudioDevice(const int iscapture, void *handle)
 
 /* buffer queueing support... */
 
+/* A ring of at least SDL_AUDIOQUEUE_MINLEN bytes that holds want bytes. */
+static SDL_AudioQueueRing *
+new_audio_queue_ring(Uint32 want)
+{
+    SDL_AudioQueueRing *ring;
+    Uint32 size = SDL_AUDIOQUEUE_MINLEN;
+
+    if (want > 0x40000000) {
+        return NULL;  /* the byte counts have to stay well away from wrapping. */
+    }
+    while (size < want) {
+        size *= 2;
+    }
+    ring = (SDL_AudioQueueRing *) SDL_malloc(sizeof (SDL_AudioQueueRing) + size);
+    if (ring) {
+        ring->data = (Uint8 *) (ring + 1);
+        ring->size = size;
+        SDL_AtomicSet(&ring->written, 0);
+        SDL_AtomicSet(&ring->read, 0);
+        SDL_AtomicSet(&ring->retired, 0);
+        ring->next = NULL;
+    }
+    return ring;
+}
+
 /* this expects that you managed thread safety elsewhere. */
 static void
-free_audio_queue(SDL_AudioBufferQueue *buffer)
+free_audio_queue(SDL_AudioQueueRing *ring)
 {
-    while (buffer) {
-        SDL_AudioBufferQueue *next = buffer->next;
-        SDL_free(buffer);
-        buffer = next;
+    while (ring) {
+        SDL_AudioQueueRing *next = ring->next;
+        SDL_free(ring);
+        ring = next;
     }
 }
 
+/* Only the queueing thread (holding queue_lock) writes, and only to a ring
+   without a next one; there has to be room for len bytes. */
+static void
+write_audio_queue_ring(SDL_AudioQueueRing *ring, const Uint8 *data, Uint32 len)
+{
+    const Uint32 written = (Uint32) SDL_AtomicGet(&ring->written);
+    const Uint32 pos = written & (ring->size - 1);
+    const Uint32 first = SDL_min(len, ring->size - pos);
+
+    SDL_memcpy(ring->data + pos, data, first);
+    SDL_memcpy(ring->data, data + first, len - first);
+    SDL_MemoryBarrierRelease();  /* the data goes out before the count does. */
+    SDL_AtomicSet(&ring->written, (int) (written + len));
+}
+
+/* Only the device thread reads. This copies up to len bytes of queued audio
+   into stream, or drops them if stream is NULL, and returns how many. */
+static Uint32
+read_audio_queue(SDL_AudioDevice *device, Uint8 *stream, Uint32 len)
+{
+    Uint32 total = 0;
+
+    while (total < len) {
+        SDL_AudioQueueRing *ring = device->queue_head;
+        const Uint32 read = (Uint32) SDL_AtomicGet(&ring->read);
+        const Uint32 avail = (Uint32) SDL_AtomicGet(&ring->written) - read;
+        Uint32 pos, cpy, first;
+
+        if (avail == 0) {
+            SDL_AudioQueueRing *next = (SDL_AudioQueueRing *) SDL_AtomicGetPtr((void **) &ring->next);
+            if (next == NULL) {
+                break;  /* we've played everything queued so far. */
+            }
+            /* more may have been written here just before next was set. */
+            if ((Uint32) SDL_AtomicGet(&ring->written) == read) {
+                device->queue_head = next;
+                SDL_AtomicSet(&ring->retired, 1);  /* the queueing thread frees it. */
+            }
+            continue;
+        }
+
+        cpy = SDL_min(len - total, avail);
+        if (stream) {
+            pos = read & (ring->size - 1);
+            first = SDL_min(cpy, ring->size - pos);
+            SDL_memcpy(stream + total, ring->data + pos, first);
+            SDL_memcpy(stream + total + first, ring->data, cpy - first);
+        }
+        SDL_MemoryBarrierRelease();  /* done with the data before it's overwritten. */
+        SDL_AtomicSet(&ring->read, (int) (read + cpy));
+        total += cpy;
+    }
+
+    SDL_AtomicAdd(&device->queue_read, (int) total);
+    return total;
+}
+
 static void SDLCALL
 SDL_BufferQueueDrainCallback(void *userdata, Uint8 *stream, int _len)
 {
-    /* this function always holds the mixer lock before being called. */
+    /* this function never takes a lock; SDL_QueueAudio() can run alongside. */
     Uint32 len = (Uint32) _len;
     SDL_AudioDevice *device = (SDL_AudioDevice *) userdata;
-    SDL_AudioBufferQueue *buffer;
+    Uint32 cleared, read, got;
 
     SDL_assert(device != NULL);  /* this shouldn't ever happen, right?! */
     SDL_assert(_len >= 0);  /* this shouldn't ever happen, right?! */
 
-    while ((len > 0) && ((buffer = device->buffer_queue_head) != NULL)) {
-        const Uint32 avail = buffer->datalen - buffer->startpos;
-        const Uint32 cpy = SDL_min(len, avail);
-        SDL_assert(device->queued_bytes >= avail);
-
-        SDL_memcpy(stream, buffer->data + buffer->startpos, cpy);
-        buffer->startpos += cpy;
-        stream += cpy;
-        device->queued_bytes -= cpy;
-        len -= cpy;
-
-        if (buffer->startpos == buffer->datalen) {  /* packet is done, put it in the pool. */
-            device->buffer_queue_head = buffer->next;
-            SDL_assert((buffer->next != NULL) || (buffer == device->buffer_queue_tail));
-            buffer->next = device->buffer_queue_pool;
-            device->buffer_queue_pool = buffer;
-        }
+    /* drop anything queued before the last SDL_ClearQueuedAudio(). */
+    cleared = (Uint32) SDL_AtomicGet(&device->queue_cleared);
+    read = (Uint32) SDL_AtomicGet(&device->queue_read);
+    if ((Sint32) (cleared - read) > 0) {
+        read_audio_queue(device, NULL, cleared - read);
+        device->queue_starved = 1;  /* running dry after a clear was asked for. */
     }
 
-    SDL_assert((device->buffer_queue_head != NULL) == (device->queued_bytes != 0));
-
-    if (len > 0) {  /* fill any remaining space in the stream with silence. */
-        SDL_assert(device->buffer_queue_head == NULL);
-        SDL_memset(stream, device->spec.silence, len);
-    }
-
-    if (device->buffer_queue_head == NULL) {
-        device->buffer_queue_tail = NULL;  /* in case we drained the queue entirely. */
+    got = read_audio_queue(device, stream, len);
+    if (got < len) {  /* fill any remaining space in the stream with silence. */
+        SDL_memset(stream + got, device->spec.silence, len - got);
+        if (!device->queue_starved) {
+            device->queue_starved = 1;
+            SDL_AtomicAdd(&device->queue_underruns, 1);
+        }
+    } else {
+        device->queue_starved = 0;
     }
 }
 
@@ -476,10 +558,9 @@ SDL_QueueAudio(SDL_AudioDeviceID devid, const void *_data, Uint32 len)
 {
     SDL_AudioDevice *device = get_audio_device(devid);
     const Uint8 *data = (const Uint8 *) _data;
-    SDL_AudioBufferQueue *orighead;
-    SDL_AudioBufferQueue *origtail;
-    Uint32 origlen;
-    Uint32 datalen;
+    SDL_AudioQueueRing *ring;
+    SDL_AudioQueueRing *next = NULL;
+    Uint32 space;
 
     if (!device) {
         return -1;  /* get_audio_device() will have set the error state */
@@ -489,66 +570,44 @@ SDL_QueueAudio(SDL_AudioDeviceID devid, const void *_data, Uint32 len)
         return SDL_SetError("Audio device has a callback, queueing not allowed");
     }
 
-    current_audio.impl.LockDevice(device);
+    if (len == 0) {
+        return 0;
+    }
 
-    orighead = device->buffer_queue_head;
-    origtail = device->buffer_queue_tail;
-    origlen = origtail ? origtail->datalen : 0;
-
-    while (len > 0) {
-        SDL_AudioBufferQueue *packet = device->buffer_queue_tail;
-        SDL_assert(!packet || (packet->datalen <= SDL_AUDIOBUFFERQUEUE_PACKETLEN));
-        if (!packet || (packet->datalen >= SDL_AUDIOBUFFERQUEUE_PACKETLEN)) {
-            /* tail packet missing or completely full; we need a new packet. */
-            packet = device->buffer_queue_pool;
-            if (packet != NULL) {
-                /* we have one available in the pool. */
-                device->buffer_queue_pool = packet->next;
-            } else {
-                /* Have to allocate a new one! */
-                packet = (SDL_AudioBufferQueue *) SDL_malloc(sizeof (SDL_AudioBufferQueue));
-                if (packet == NULL) {
-                    /* uhoh, reset so we've queued nothing new, free what we can. */
-                    if (!origtail) {
-                        packet = device->buffer_queue_head;  /* whole queue. */
-                    } else {
-                        packet = origtail->next;  /* what we added to existing queue. */
-                        origtail->next = NULL;
-                        origtail->datalen = origlen;
-                    }
-                    device->buffer_queue_head = orighead;
-                    device->buffer_queue_tail = origtail;
-                    device->buffer_queue_pool = NULL;
-
-                    current_audio.impl.UnlockDevice(device);
-
-                    free_audio_queue(packet);  /* give back what we can. */
-
-                    return SDL_OutOfMemory();
-                }
-            }
-            packet->datalen = 0;
-            packet->startpos = 0;
-            packet->next = NULL;
+    SDL_AtomicLock(&device->queue_lock);
 
-            SDL_assert((device->buffer_queue_head != NULL) == (device->queued_bytes != 0));
-            if (device->buffer_queue_tail == NULL) {
-                device->buffer_queue_head = packet;
-            } else {
-                device->buffer_queue_tail->next = packet;
-            }
-            device->buffer_queue_tail = packet;
+    /* free the rings the device thread has finished with. */
+    while ((device->queue_oldest != device->queue_tail) &&
+           SDL_AtomicGet(&device->queue_oldest->retired)) {
+        ring = device->queue_oldest;
+        device->queue_oldest = ring->next;
+        SDL_free(ring);
+    }
+
+    ring = device->queue_tail;
+    space = ring->size - ((Uint32) SDL_AtomicGet(&ring->written) -
+                          (Uint32) SDL_AtomicGet(&ring->read));
+    if (len > space) {
+        /* get the bigger ring first, so we either queue everything or nothing. */
+        next = new_audio_queue_ring(SDL_max(ring->size * 2, len - space));
+        if (next == NULL) {
+            SDL_AtomicUnlock(&device->queue_lock);
+            return SDL_OutOfMemory();
         }
+    }
 
-        datalen = SDL_min(len, SDL_AUDIOBUFFERQUEUE_PACKETLEN - packet->datalen);
-        SDL_memcpy(packet->data + packet->datalen, data, datalen);
-        data += datalen;
-        len -= datalen;
-        packet->datalen += datalen;
-        device->queued_bytes += datalen;
+    /* count it first, so the device thread never reads more than was queued. */
+    SDL_AtomicAdd(&device->queue_written, (int) len);
+    if (next == NULL) {
+        write_audio_queue_ring(ring, data, len);
+    } else {
+        write_audio_queue_ring(ring, data, space);
+        write_audio_queue_ring(next, data + space, len - space);
+        SDL_AtomicSetPtr((void **) &ring->next, next);
+        device->queue_tail = next;
     }
 
-    current_audio.impl.UnlockDevice(device);
+    SDL_AtomicUnlock(&device->queue_lock);
 
     return 0;
 }
@@ -561,8 +620,16 @@ SDL_GetQueuedAudioSize(SDL_AudioDeviceID devid)
 
     /* Nothing to do unless we're set up for queueing. */
     if (device && (device->spec.callback == SDL_BufferQueueDrainCallback)) {
+        /* read before written, so there's never more read than written. */
+        Uint32 read = (Uint32) SDL_AtomicGet(&device->queue_read);
+        const Uint32 cleared = (Uint32) SDL_AtomicGet(&device->queue_cleared);
+        const Uint32 written = (Uint32) SDL_AtomicGet(&device->queue_written);
+
+        if ((Sint32) (cleared - read) > 0) {
+            read = cleared;  /* the device thread hasn't dropped these yet. */
+        }
         current_audio.impl.LockDevice(device);
-        retval = device->queued_bytes + current_audio.impl.GetPendingBytes(device);
+        retval = (written - read) + current_audio.impl.GetPendingBytes(device);
         current_audio.impl.UnlockDevice(device);
     }
 
@@ -573,20 +640,46 @@ void
 SDL_ClearQueuedAudio(SDL_AudioDeviceID devid)
 {
     SDL_AudioDevice *device = get_audio_device(devid);
-    SDL_AudioBufferQueue *buffer = NULL;
-    if (!device) {
+    if (!device || (device->spec.callback != SDL_BufferQueueDrainCallback)) {
         return;  /* nothing to do. */
     }
 
-    /* Blank out the device and release the mutex. Free it afterwards. */
-    current_audio.impl.LockDevice(device);
-    buffer = device->buffer_queue_head;
-    device->buffer_queue_tail = NULL;
-    device->buffer_queue_head = NULL;
-    device->queued_bytes = 0;
-    current_audio.impl.UnlockDevice(device);
+    /* The device thread drops everything queued so far on its next callback;
+       the rings stay around to be filled again. */
+    SDL_AtomicLock(&device->queue_lock);
+    SDL_AtomicSet(&device->queue_cleared, SDL_AtomicGet(&device->queue_written));
+    SDL_AtomicUnlock(&device->queue_lock);
+}
 
-    free_audio_queue(buffer);
+Uint32
+SDL_GetQueuedAudioLatency(SDL_AudioDeviceID devid)
+{
+    SDL_AudioDevice *device = get_audio_device(devid);
+    Uint64 bytes_per_second;
+
+    /* Nothing to do unless we're set up for queueing. */
+    if (!device || (device->spec.callback != SDL_BufferQueueDrainCallback)) {
+        return 0;
+    }
+
+    bytes_per_second = (Uint64) device->spec.freq * device->spec.channels *
+                       (SDL_AUDIO_BITSIZE(device->spec.format) / 8);
+    if (bytes_per_second == 0) {
+        return 0;
+    }
+    return (Uint32) (((Uint64) SDL_GetQueuedAudioSize(devid) * 1000) / bytes_per_second);
+}
+
+Uint32
+SDL_GetQueuedAudioUnderruns(SDL_AudioDeviceID devid)
+{
+    SDL_AudioDevice *device = get_audio_device(devid);
+
+    /* Nothing to do unless we're set up for queueing. */
+    if (!device || (device->spec.callback != SDL_BufferQueueDrainCallback)) {
+        return 0;
+    }
+    return (Uint32) SDL_AtomicGet(&device->queue_underruns);
 }
 
 
@@ -601,6 +694,8 @@ SDL_RunAudio(void *devicep)
     Uint8 *stream;
     void *udata = device->spec.userdata;
     void (SDLCALL *fill) (void *, Uint8 *, int) = device->spec.callback;
+    const int timed = current_audio.impl.TimesStages;
+    Uint64 start = 0, now;
 
     /* The audio mixing is always a high priority thread */
     SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
@@ -629,14 +724,28 @@ SDL_RunAudio(void *devicep)
             stream = device->fake_stream;
         }
 
+        /* The queue's callback doesn't need the lock, so SDL_QueueAudio()
+           never waits on this thread, nor this thread on it. */
         /* !!! FIXME: this should be LockDevice. */
-        SDL_LockMutex(device->mixer_lock);
+        if (timed) {
+            start = SDL_GetPerformanceCounter();
+        }
+        if (fill != SDL_BufferQueueDrainCallback) {
+            SDL_LockMutex(device->mixer_lock);
+        }
         if (device->paused) {
             SDL_memset(stream, silence, stream_len);
         } else {
             (*fill) (udata, stream, stream_len);
         }
-        SDL_UnlockMutex(device->mixer_lock);
+        if (fill != SDL_BufferQueueDrainCallback) {
+            SDL_UnlockMutex(device->mixer_lock);
+        }
+        if (timed) {
+            now = SDL_GetPerformanceCounter();
+            device->fill_ticks += now - start;
+            start = now;
+        }
 
         /* Convert the audio if necessary */
         if (device->enabled && device->convert.needed) {
@@ -649,6 +758,9 @@ SDL_RunAudio(void *devicep)
                            device->convert.len_cvt);
             }
         }
+        if (timed) {
+            device->convert_ticks += SDL_GetPerformanceCounter() - start;
+        }
 
         /* Ready current buffer for play and change current buffer */
         if (stream == device->fake_stream) {
@@ -741,6 +853,19 @@ SDL_AudioInit(const char *driver_name)
         initialized = backend->init(&current_audio.impl);
     }
 
+    for (i = 0; (!initialized) && driver_name && (unlisted_bootstrap[i]); ++i) {
+        const AudioBootStrap *backend = unlisted_bootstrap[i];
+        if (SDL_strcasecmp(backend->name, driver_name) != 0) {
+            continue;
+        }
+
+        tried_to_init = 1;
+        SDL_zero(current_audio);
+        current_audio.name = backend->name;
+        current_audio.desc = backend->desc;
+        initialized = backend->init(&current_audio.impl);
+    }
+
     if (!initialized) {
         /* specific drivers will set the error message if they fail... */
         if (!tried_to_init) {
@@ -889,8 +1014,7 @@ close_audio_device(SDL_AudioDevice * device)
         device->opened = 0;
     }
 
-    free_audio_queue(device->buffer_queue_head);
-    free_audio_queue(device->buffer_queue_pool);
+    free_audio_queue(device->queue_oldest);
 
     SDL_FreeAudioMem(device);
 }
@@ -1167,19 +1291,16 @@ open_audio_device(const char *devname, int iscapture,
     }
 
     if (device->spec.callback == NULL) {  /* use buffer queueing? */
-        /* pool a few packets to start. Enough for two callbacks. */
-        const int packetlen = SDL_AUDIOBUFFERQUEUE_PACKETLEN;
-        const int wantbytes = ((device->convert.needed) ? device->convert.len : device->spec.size) * 2;
-        const int wantpackets = (wantbytes / packetlen) + ((wantbytes % packetlen) ? packetlen : 0);
-        for (i = 0; i < wantpackets; i++) {
-            SDL_AudioBufferQueue *packet = (SDL_AudioBufferQueue *) SDL_malloc(sizeof (SDL_AudioBufferQueue));
-            if (packet) { /* don't care if this fails, we'll deal later. */
-                packet->datalen = 0;
-                packet->startpos = 0;
-                packet->next = device->buffer_queue_pool;
-                device->buffer_queue_pool = packet;
-            }
+        /* start with a ring big enough for two callbacks. */
+        const Uint32 wantbytes = ((device->convert.needed) ? device->convert.len : device->spec.size) * 2;
+        SDL_AudioQueueRing *ring = new_audio_queue_ring(wantbytes);
+        if (ring == NULL) {
+            close_audio_device(device);
+            SDL_OutOfMemory();
+            return 0;
         }
+        device->queue_head = device->queue_tail = device->queue_oldest = ring;
+        device->queue_starved = 1;  /* nothing's been queued to run out of. */
 
         device->spec.callback = SDL_BufferQueueDrainCallback;
         device->spec.userdata = device;
@@ -41,6 +41,24 @@ typedef struct
 } SDL_AudioTypeFilters;
 extern const SDL_AudioTypeFilters sdl_audio_type_filters[];
 
+/* The SIMD converter between two sample formats, or NULL if there's none */
+extern SDL_AudioFilter SDL_ChooseSIMDTypeCVT(SDL_AudioFormat src_fmt,
+                                             SDL_AudioFormat dst_fmt);
+
+/* Mixes samples of src into dst, at a volume of 1 to SDL_MIX_MAXVOLUME */
+typedef void (*SDL_MixKernel) (Uint8 * dst, const Uint8 * src, int samples,
+                               int volume);
+
+/* Mixes samples of num_srcs voices into dst, clamping their sum, each at a
+   volume of 0 to SDL_MIX_MAXVOLUME, or SDL_MIX_MAXVOLUME if volumes is NULL */
+typedef void (*SDL_MixManyKernel) (Uint8 * dst, const Uint8 * const * srcs,
+                                   const int *volumes, int num_srcs,
+                                   int samples);
+
+/* The SIMD mixer of a format, or NULL if there's none */
+extern SDL_MixKernel SDL_ChooseSIMDMix(SDL_AudioFormat format);
+extern SDL_MixManyKernel SDL_ChooseSIMDMixMany(SDL_AudioFormat format);
+
 /* this is used internally to access some autogenerated code. */
 typedef struct
 {
@@ -52,4 +70,17 @@ typedef struct
 } SDL_AudioRateFilters;
 extern const SDL_AudioRateFilters sdl_audio_rate_filters[];
 
+/* The polyphase rate converter for a format & channels, or NULL if
+   there's none */
+extern SDL_AudioFilter SDL_ChooseResampleCVT(SDL_AudioFormat format,
+                                             int channels);
+
+/* Drop a resampler's input, as if it was just made */
+extern int SDL_ResetAudioResampler(SDL_AudioResampler * resampler);
+
+/* The rest of a resampler's output, to the end of its input.  Call until
+   it gives 0 bytes, after which the resampler's reset. */
+extern int SDL_FlushAudioResampler(SDL_AudioResampler * resampler,
+                                   void *dst, int dst_len);
+
 /* vi: set ts=4 sw=4 expandtab: */
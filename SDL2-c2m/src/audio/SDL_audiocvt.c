@@ -842,7 +842,7 @@ SDL_HandTunedTypeCVT(SDL_AudioFormat src_fmt, SDL_AudioFormat dst_fmt)
      *  processor, platform, compiler, or library here.
      */
 
-    return NULL;                /* no specialized converter code available. */
+    return SDL_ChooseSIMDTypeCVT(src_fmt, dst_fmt);  /* NULL if none. */
 }
 
 
@@ -904,7 +904,8 @@ SDL_HandTunedResampleCVT(SDL_AudioCVT * cvt, int dst_channels,
      *  processor, platform, compiler, or library here.
      */
 
-    return NULL;                /* no specialized converter code available. */
+    /* Polyphase, for S16 & F32; NULL if none. */
+    return SDL_ChooseResampleCVT(cvt->dst_format, dst_channels);
 }
 
 static int
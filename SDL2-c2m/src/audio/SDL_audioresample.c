@@ -0,0 +1,661 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* Polyphase windowed-sinc resampling, for SDL_AudioResampler and for
+   SDL_ConvertAudio()'s rate conversion of S16 & F32 samples.
+
+   Each output sample is a dot product of the input around its position
+   with a Kaiser-windowed sinc, low-passed below the lower of the two
+   rates' Nyquist frequencies.  The sinc's taken at SDL_RESAMPLER_PHASES
+   positions between two input samples, a bank of rows made once per
+   cutoff & shared; an output between two rows is the mix of their dot
+   products.  The samples are kept as planes of floats, one per channel,
+   so the dot products are over contiguous memory, in SSE2, AVX2 or NEON.
+
+   A resampler keeps the input its next outputs need, so input given a
+   bit at a time comes out as if given all at once.  The position of each
+   output is exact, as the rates' ratio. */
+
+#include "SDL_audio.h"
+#include "SDL_atomic.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_hints.h"
+#include "SDL_audio_c.h"
+
+#if defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SDL_RESAMPLE_X86 1
+#include <immintrin.h>
+#elif defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    defined(__aarch64__)
+#define SDL_RESAMPLE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define SDL_RESAMPLER_ZEROS 32      /* the sinc's zero crossings each side */
+#define SDL_RESAMPLER_PHASES 128    /* rows between two input samples */
+#define SDL_RESAMPLER_MAX_TAPS 1024 /* most a row has, at low cutoffs */
+#define SDL_RESAMPLER_BANKS 8       /* cutoffs' banks kept */
+#define SDL_RESAMPLER_PASSBAND 0.92 /* middle of the transition band */
+#define SDL_RESAMPLER_BETA 8.0      /* of the Kaiser window, ~80 dB */
+#define SDL_RESAMPLER_NO_END 0x7FFFFFFF /* the input isn't ending */
+
+typedef struct SDL_ResamplerBank
+{
+    double cutoff;              /* fraction of the input's Nyquist */
+    int refs;                   /* resamplers using it */
+    int half;                   /* input samples each side, K */
+    int taps;                   /* 2K, rounded up to 8 with zeros */
+    float *rows;                /* SDL_RESAMPLER_PHASES + 1 rows of taps */
+} SDL_ResamplerBank;
+
+typedef float (*SDL_ResamplerDot) (const float *x, const float *a,
+                                   const float *b, int taps, float mix);
+
+struct SDL_AudioResampler
+{
+    SDL_AudioFormat format;
+    int channels;
+    int src_rate;               /* the two rates, less their common factor */
+    int dst_rate;
+    SDL_ResamplerBank *bank;
+    SDL_ResamplerDot dot;
+
+    float *planes;              /* channels planes of capacity floats */
+    int capacity;               /* input samples, each plane */
+    int have;                   /* input samples there are */
+    int start;                  /* the first one of the next output */
+    int phase;                  /* past start, in 1 / dst_rate samples */
+    int end;                    /* the end of the input when flushing */
+};
+
+static SDL_SpinLock SDL_resampler_lock;
+static SDL_ResamplerBank SDL_resampler_banks[SDL_RESAMPLER_BANKS];
+
+/* Modified Bessel function of the first kind, order 0 */
+static double
+SDL_BesselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    int k;
+
+    for (k = 1; k < 64 && term > sum * 1e-12; ++k) {
+        term *= (x * x) / (4.0 * k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+/* Row p has the sinc at input samples j - (K-1) - p / PHASES, each
+   normalized to sum to 1, so constant input stays constant */
+static int
+SDL_FillResamplerBank(SDL_ResamplerBank * bank, double cutoff)
+{
+    double width = SDL_RESAMPLER_ZEROS / cutoff;
+    const double i0beta = SDL_BesselI0(SDL_RESAMPLER_BETA);
+    int half = (int) SDL_ceil(width);
+    int p, j;
+
+    if (half * 2 > SDL_RESAMPLER_MAX_TAPS) {
+        half = SDL_RESAMPLER_MAX_TAPS / 2;
+        width = half;
+    }
+    bank->half = half;
+    bank->taps = (half * 2 + 7) & ~7;
+    bank->cutoff = cutoff;
+    bank->rows = (float *) SDL_malloc((SDL_RESAMPLER_PHASES + 1) *
+                                      bank->taps * sizeof (float));
+    if (!bank->rows) {
+        return SDL_OutOfMemory();
+    }
+    for (p = 0; p <= SDL_RESAMPLER_PHASES; ++p) {
+        float *row = &bank->rows[p * bank->taps];
+        double sum = 0.0;
+
+        for (j = 0; j < bank->taps; ++j) {
+            const double t = (j - (half - 1)) - (double) p / SDL_RESAMPLER_PHASES;
+            const double w = t / width;
+            double h = 0.0;
+
+            if (j < half * 2 && w > -1.0 && w < 1.0) {
+                const double x = M_PI * cutoff * t;
+
+                h = (x == 0.0) ? cutoff : cutoff * SDL_sin(x) / x;
+                h *= SDL_BesselI0(SDL_RESAMPLER_BETA * SDL_sqrt(1.0 - w * w)) / i0beta;
+            }
+            row[j] = (float) h;
+            sum += h;
+        }
+        for (j = 0; j < bank->taps; ++j) {
+            row[j] = (float) (row[j] / sum);
+        }
+    }
+    return 0;
+}
+
+/* The shared bank for the cutoff, made if there's none */
+static SDL_ResamplerBank *
+SDL_GetResamplerBank(double cutoff)
+{
+    SDL_ResamplerBank *bank = NULL;
+    int i;
+
+    SDL_AtomicLock(&SDL_resampler_lock);
+    for (i = 0; i < SDL_RESAMPLER_BANKS; ++i) {
+        if (SDL_resampler_banks[i].rows &&
+            SDL_resampler_banks[i].cutoff == cutoff) {
+            bank = &SDL_resampler_banks[i];
+            break;
+        }
+    }
+    if (!bank) {
+        /* An empty one, else one nobody's using */
+        for (i = 0; i < SDL_RESAMPLER_BANKS && !bank; ++i) {
+            if (!SDL_resampler_banks[i].rows) {
+                bank = &SDL_resampler_banks[i];
+            }
+        }
+        for (i = 0; i < SDL_RESAMPLER_BANKS && !bank; ++i) {
+            if (SDL_resampler_banks[i].refs == 0) {
+                bank = &SDL_resampler_banks[i];
+                SDL_free(bank->rows);
+                bank->rows = NULL;
+            }
+        }
+        if (!bank) {
+            SDL_AtomicUnlock(&SDL_resampler_lock);
+            SDL_SetError("Too many audio resampling rates in use");
+            return NULL;
+        }
+        if (SDL_FillResamplerBank(bank, cutoff) < 0) {
+            SDL_AtomicUnlock(&SDL_resampler_lock);
+            return NULL;
+        }
+    }
+    ++bank->refs;
+    SDL_AtomicUnlock(&SDL_resampler_lock);
+    return bank;
+}
+
+static void
+SDL_ReleaseResamplerBank(SDL_ResamplerBank * bank)
+{
+    SDL_AtomicLock(&SDL_resampler_lock);
+    --bank->refs;
+    SDL_AtomicUnlock(&SDL_resampler_lock);
+}
+
+/* The two rows' dot products with x, mixed: a + (b - a) * mix.  taps is a
+   multiple of 8. */
+static float
+SDL_ResamplerDotC(const float *x, const float *a, const float *b, int taps,
+                  float mix)
+{
+    float sa = 0.0f, sb = 0.0f;
+    int j;
+
+    for (j = 0; j < taps; ++j) {
+        sa += x[j] * a[j];
+        sb += x[j] * b[j];
+    }
+    return sa + (sb - sa) * mix;
+}
+
+#ifdef SDL_RESAMPLE_X86
+
+static float
+SDL_ResamplerDotSSE2(const float *x, const float *a, const float *b,
+                     int taps, float mix)
+    __attribute__((target("sse2")));
+static float
+SDL_ResamplerDotSSE2(const float *x, const float *a, const float *b,
+                     int taps, float mix)
+{
+    __m128 sa = _mm_setzero_ps(), sb = _mm_setzero_ps(), s;
+    int j;
+
+    for (j = 0; j < taps; j += 4) {
+        const __m128 v = _mm_loadu_ps(x + j);
+
+        sa = _mm_add_ps(sa, _mm_mul_ps(v, _mm_loadu_ps(a + j)));
+        sb = _mm_add_ps(sb, _mm_mul_ps(v, _mm_loadu_ps(b + j)));
+    }
+    s = _mm_add_ps(sa, _mm_mul_ps(_mm_sub_ps(sb, sa), _mm_set1_ps(mix)));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+static float
+SDL_ResamplerDotAVX2(const float *x, const float *a, const float *b,
+                     int taps, float mix)
+    __attribute__((target("avx2")));
+static float
+SDL_ResamplerDotAVX2(const float *x, const float *a, const float *b,
+                     int taps, float mix)
+{
+    __m256 sa = _mm256_setzero_ps(), sb = _mm256_setzero_ps(), s8;
+    __m128 s;
+    int j;
+
+    for (j = 0; j < taps; j += 8) {
+        const __m256 v = _mm256_loadu_ps(x + j);
+
+        sa = _mm256_add_ps(sa, _mm256_mul_ps(v, _mm256_loadu_ps(a + j)));
+        sb = _mm256_add_ps(sb, _mm256_mul_ps(v, _mm256_loadu_ps(b + j)));
+    }
+    s8 = _mm256_add_ps(sa, _mm256_mul_ps(_mm256_sub_ps(sb, sa),
+                                         _mm256_set1_ps(mix)));
+    s = _mm_add_ps(_mm256_castps256_ps128(s8), _mm256_extractf128_ps(s8, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+#endif /* SDL_RESAMPLE_X86 */
+
+#ifdef SDL_RESAMPLE_NEON
+
+static float
+SDL_ResamplerDotNEON(const float *x, const float *a, const float *b,
+                     int taps, float mix)
+{
+    float32x4_t sa = vdupq_n_f32(0.0f), sb = vdupq_n_f32(0.0f);
+    int j;
+
+    for (j = 0; j < taps; j += 4) {
+        const float32x4_t v = vld1q_f32(x + j);
+
+        sa = vmlaq_f32(sa, v, vld1q_f32(a + j));
+        sb = vmlaq_f32(sb, v, vld1q_f32(b + j));
+    }
+    return vaddvq_f32(vmlaq_n_f32(sa, vsubq_f32(sb, sa), mix));
+}
+
+#endif /* SDL_RESAMPLE_NEON */
+
+static SDL_ResamplerDot
+SDL_ChooseResamplerDot(void)
+{
+    const char *hint = SDL_GetHint("SDL_AUDIO_SIMD");
+
+    if (hint && *hint == '0') {
+        return SDL_ResamplerDotC;
+    }
+#ifdef SDL_RESAMPLE_X86
+    {
+        static const Uint32 needs[] = {
+            SDL_CPUFEATURE_AVX2, SDL_CPUFEATURE_SSE2, 0
+        };
+        static const SDL_ResamplerDot dots[] = {
+            SDL_ResamplerDotAVX2, SDL_ResamplerDotSSE2, SDL_ResamplerDotC
+        };
+        return dots[SDL_GetCPUVariant(needs, SDL_arraysize(needs))];
+    }
+#elif defined(SDL_RESAMPLE_NEON)
+    if (SDL_HasNEON()) {
+        return SDL_ResamplerDotNEON;
+    }
+#endif
+    return SDL_ResamplerDotC;
+}
+
+static int
+SDL_gcd(int a, int b)
+{
+    while (b) {
+        const int t = a % b;
+
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+SDL_AudioResampler *
+SDL_NewAudioResampler(SDL_AudioFormat format, Uint8 channels, int src_rate,
+                      int dst_rate)
+{
+    SDL_AudioResampler *resampler;
+    double cutoff = SDL_RESAMPLER_PASSBAND;
+    int common;
+
+    if (format != AUDIO_S16SYS && format != AUDIO_F32SYS) {
+        SDL_SetError("Only AUDIO_S16SYS & AUDIO_F32SYS can be resampled");
+        return NULL;
+    }
+    if (channels == 0) {
+        SDL_InvalidParamError("channels");
+        return NULL;
+    }
+    if (src_rate <= 0 || dst_rate <= 0) {
+        SDL_SetError("Source or destination rate is zero");
+        return NULL;
+    }
+
+    resampler = (SDL_AudioResampler *) SDL_calloc(1, sizeof (*resampler));
+    if (!resampler) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    common = SDL_gcd(src_rate, dst_rate);
+    resampler->format = format;
+    resampler->channels = channels;
+    resampler->src_rate = src_rate / common;
+    resampler->dst_rate = dst_rate / common;
+    if (dst_rate < src_rate) {
+        cutoff *= (double) dst_rate / src_rate;
+    }
+    resampler->bank = SDL_GetResamplerBank(cutoff);
+    if (!resampler->bank) {
+        SDL_free(resampler);
+        return NULL;
+    }
+    resampler->dot = SDL_ChooseResamplerDot();
+    /* The first output's at the first input sample, silence before it */
+    resampler->have = resampler->bank->half - 1;
+    return resampler;
+}
+
+void
+SDL_FreeAudioResampler(SDL_AudioResampler * resampler)
+{
+    if (resampler) {
+        SDL_ReleaseResamplerBank(resampler->bank);
+        SDL_free(resampler->planes);
+        SDL_free(resampler);
+    }
+}
+
+/* Room for count more input samples, and the zeros the padded taps read
+   past them; what's before start is dropped */
+static int
+SDL_ReserveResamplerInput(SDL_AudioResampler * resampler, int count)
+{
+    const int pad = resampler->bank->taps - resampler->bank->half * 2;
+    const int keep = resampler->have - resampler->start;
+    int c;
+
+    if (keep + count + pad > resampler->capacity) {
+        const int capacity = SDL_max(resampler->capacity * 2,
+                                     keep + count + pad);
+        float *planes = (float *) SDL_calloc((size_t) capacity *
+                                             resampler->channels,
+                                             sizeof (float));
+
+        if (!planes) {
+            return SDL_OutOfMemory();
+        }
+        for (c = 0; c < resampler->channels && resampler->planes; ++c) {
+            SDL_memcpy(planes + c * capacity,
+                       resampler->planes + c * resampler->capacity +
+                       resampler->start, keep * sizeof (float));
+        }
+        SDL_free(resampler->planes);
+        resampler->planes = planes;
+        resampler->capacity = capacity;
+    } else if (resampler->start > 0) {
+        for (c = 0; c < resampler->channels; ++c) {
+            float *plane = resampler->planes + c * resampler->capacity;
+
+            SDL_memmove(plane, plane + resampler->start, keep * sizeof (float));
+        }
+    }
+    resampler->have = keep;
+    resampler->start = 0;
+    return 0;
+}
+
+/* Frames of interleaved samples onto the planes, with count more copies
+   of the last one if frames is NULL */
+static void
+SDL_PutResamplerInput(SDL_AudioResampler * resampler, const void *frames,
+                      int count)
+{
+    const int channels = resampler->channels;
+    const int pad = resampler->bank->taps - resampler->bank->half * 2;
+    int c, i;
+
+    for (c = 0; c < channels; ++c) {
+        float *plane = resampler->planes + c * resampler->capacity +
+            resampler->have;
+
+        if (!frames) {
+            const float last = resampler->have ? plane[-1] : 0.0f;
+
+            for (i = 0; i < count; ++i) {
+                plane[i] = last;
+            }
+        } else if (resampler->format == AUDIO_F32SYS) {
+            const float *src = (const float *) frames + c;
+
+            for (i = 0; i < count; ++i, src += channels) {
+                plane[i] = *src;
+            }
+        } else {
+            const Sint16 *src = (const Sint16 *) frames + c;
+
+            for (i = 0; i < count; ++i, src += channels) {
+                plane[i] = *src * (1.0f / 32767.0f);
+            }
+        }
+        for (i = 0; i < pad; ++i) {
+            plane[count + i] = 0.0f;
+        }
+    }
+    resampler->have += count;
+}
+
+/* Up to count interleaved output frames, as many as the input allows, and
+   none at end or past it */
+static int
+SDL_GetResamplerOutput(SDL_AudioResampler * resampler, void *frames,
+                       int count, int end)
+{
+    const SDL_ResamplerBank *bank = resampler->bank;
+    const int channels = resampler->channels;
+    const int last_start = SDL_min(resampler->have - bank->half * 2,
+                                   end - bank->half);
+    int n, c;
+
+    for (n = 0; n < count && resampler->start <= last_start; ++n) {
+        const Uint64 at = (Uint64) resampler->phase * SDL_RESAMPLER_PHASES;
+        const int row = (int) (at / resampler->dst_rate);
+        const float mix = (float) (at % resampler->dst_rate) / resampler->dst_rate;
+        const float *a = &bank->rows[row * bank->taps];
+        const float *b = a + bank->taps;
+
+        for (c = 0; c < channels; ++c) {
+            const float *x = resampler->planes + c * resampler->capacity +
+                resampler->start;
+            float value = resampler->dot(x, a, b, bank->taps, mix);
+
+            if (resampler->format == AUDIO_F32SYS) {
+                ((float *) frames)[n * channels + c] = value;
+            } else {
+                value *= 32767.0f;
+                value = (value < 32767.0f) ? value : 32767.0f;
+                value = (value > -32768.0f) ? value : -32768.0f;
+                value += (value < 0.0f) ? -0.5f : 0.5f;
+                ((Sint16 *) frames)[n * channels + c] = (Sint16) value;
+            }
+        }
+        resampler->phase += resampler->src_rate;
+        resampler->start += resampler->phase / resampler->dst_rate;
+        resampler->phase %= resampler->dst_rate;
+    }
+    return n;
+}
+
+int
+SDL_ResampleAudio(SDL_AudioResampler * resampler, const void *src,
+                  int src_len, void *dst, int dst_len)
+{
+    int frame_size;
+
+    if (!resampler) {
+        return SDL_InvalidParamError("resampler");
+    }
+    frame_size = resampler->channels * (SDL_AUDIO_BITSIZE(resampler->format) / 8);
+    if (src_len < 0 || (src_len % frame_size) != 0 || (src_len && !src)) {
+        return SDL_InvalidParamError("src_len");
+    }
+    if (dst_len < 0 || (dst_len && !dst)) {
+        return SDL_InvalidParamError("dst_len");
+    }
+    if (SDL_ReserveResamplerInput(resampler, src_len / frame_size) < 0) {
+        return -1;
+    }
+    SDL_PutResamplerInput(resampler, src, src_len / frame_size);
+    return SDL_GetResamplerOutput(resampler, dst, dst_len / frame_size,
+                                  SDL_RESAMPLER_NO_END) * frame_size;
+}
+
+/* Back to as it was made, with no input */
+int
+SDL_ResetAudioResampler(SDL_AudioResampler * resampler)
+{
+    resampler->start = resampler->have;
+    resampler->phase = 0;
+    resampler->end = 0;
+    if (SDL_ReserveResamplerInput(resampler, resampler->bank->half - 1) < 0) {
+        return -1;
+    }
+    SDL_PutResamplerInput(resampler, NULL, resampler->bank->half - 1);
+    return 0;
+}
+
+/* What's left of the output, up to the end of the input, which is taken to
+   repeat its last samples; once it's all given, the resampler's reset */
+int
+SDL_FlushAudioResampler(SDL_AudioResampler * resampler, void *dst,
+                        int dst_len)
+{
+    const int frame_size = resampler->channels *
+        (SDL_AUDIO_BITSIZE(resampler->format) / 8);
+    int count;
+
+    if (!resampler->end) {
+        if (SDL_ReserveResamplerInput(resampler,
+                                      resampler->bank->half * 2) < 0) {
+            return -1;
+        }
+        resampler->end = resampler->have;
+        SDL_PutResamplerInput(resampler, NULL, resampler->bank->half * 2);
+    }
+    count = SDL_GetResamplerOutput(resampler, dst, dst_len / frame_size,
+                                   resampler->end);
+    if (count == 0 && SDL_ResetAudioResampler(resampler) < 0) {
+        return -1;
+    }
+    return count * frame_size;
+}
+
+/* SDL_ConvertAudio()'s rate conversion: the whole buffer at once, the first
+   & last samples repeated past its ends.  The ratio's only known as
+   cvt->rate_incr, as that many 1 / 2^20 samples.  Without the memory, the
+   generated arbitrary-rate filter does it. */
+static void
+SDL_ResampleCVT(SDL_AudioCVT * cvt, SDL_AudioFormat format, int channels)
+{
+    const int frame_size = channels * (SDL_AUDIO_BITSIZE(format) / 8);
+    const int src_frames = cvt->len_cvt / frame_size;
+    const int dst_frames = (int) (src_frames * cvt->rate_incr);
+    const int dst_rate = 1 << 20;
+    const int src_rate = (int) (dst_rate / cvt->rate_incr + 0.5);
+    SDL_AudioResampler *resampler = NULL;
+    int i;
+
+    if (src_frames > 0 && src_rate > 0) {
+        resampler = SDL_NewAudioResampler(format, (Uint8) channels,
+                                          src_rate, dst_rate);
+    }
+    if (resampler &&
+        SDL_ReserveResamplerInput(resampler, src_frames +
+                                  resampler->bank->half * 2) == 0) {
+        const int half = resampler->bank->half;
+
+        resampler->have = 0;
+        SDL_PutResamplerInput(resampler, cvt->buf, 1);
+        SDL_PutResamplerInput(resampler, NULL, half - 2);
+        SDL_PutResamplerInput(resampler, cvt->buf, src_frames);
+        SDL_PutResamplerInput(resampler, NULL, half);
+        cvt->len_cvt = SDL_GetResamplerOutput(resampler, cvt->buf, dst_frames,
+                                              SDL_RESAMPLER_NO_END) *
+            frame_size;
+        SDL_FreeAudioResampler(resampler);
+        if (cvt->filters[++cvt->filter_index]) {
+            cvt->filters[cvt->filter_index] (cvt, format);
+        }
+        return;
+    }
+    SDL_FreeAudioResampler(resampler);
+
+    for (i = 0; sdl_audio_rate_filters[i].filter != NULL; i++) {
+        const SDL_AudioRateFilters *filt = &sdl_audio_rate_filters[i];
+
+        if (filt->fmt == format && filt->channels == channels &&
+            filt->upsample == (cvt->rate_incr > 1.0) && filt->multiple == 0) {
+            filt->filter(cvt, format);
+            return;
+        }
+    }
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, format);
+    }
+}
+
+#define SDL_RESAMPLE_CVT(channels) \
+static void SDLCALL \
+SDL_ResampleCVT_c##channels(SDL_AudioCVT * cvt, SDL_AudioFormat format) \
+{ \
+    SDL_ResampleCVT(cvt, format, channels); \
+}
+
+SDL_RESAMPLE_CVT(1)
+SDL_RESAMPLE_CVT(2)
+SDL_RESAMPLE_CVT(4)
+SDL_RESAMPLE_CVT(6)
+SDL_RESAMPLE_CVT(8)
+
+SDL_AudioFilter
+SDL_ChooseResampleCVT(SDL_AudioFormat format, int channels)
+{
+    if (format != AUDIO_S16SYS && format != AUDIO_F32SYS) {
+        return NULL;
+    }
+    switch (channels) {
+    case 1:
+        return SDL_ResampleCVT_c1;
+    case 2:
+        return SDL_ResampleCVT_c2;
+    case 4:
+        return SDL_ResampleCVT_c4;
+    case 6:
+        return SDL_ResampleCVT_c6;
+    case 8:
+        return SDL_ResampleCVT_c8;
+    }
+    return NULL;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,647 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* SDL_AudioStream: audio put in as it comes, converted a block of
+   SDL_AUDIOSTREAM_BLOCK frames at a time, and queued to be got out.
+
+   A block's samples are made floats, their channels mixed to the new
+   ones, resampled and made the new format, through two buffers of floats
+   made with the stream, so a block's conversion stays in the cache.  The
+   channels are mixed as SDL_BuildAudioCVT()'s filters would, by a matrix
+   made from them, before resampling if there are fewer channels after,
+   else after it, so the fewer are resampled. */
+
+#include "SDL_audio.h"
+#include "SDL_audio_c.h"
+
+#define SDL_AUDIOSTREAM_BLOCK 256   /* frames converted at a time */
+
+struct SDL_AudioStream
+{
+    SDL_AudioFormat src_format;
+    int src_channels;
+    int src_frame_size;
+    SDL_AudioFormat dst_format;
+    int dst_channels;
+    int dst_frame_size;
+
+    float *remix;               /* dst_channels rows of src_channels, or NULL */
+    int remix_first;            /* mixed before resampling, not after */
+    SDL_AudioResampler *resampler;  /* NULL if the rates are the same */
+    int resampled_channels;
+    int passthrough;            /* nothing to convert */
+
+    float *work[2];             /* a block of samples, either channels */
+    Uint8 *partial;             /* a frame put in pieces */
+    int partial_len;
+
+    Uint8 *queue;               /* converted, to be got */
+    int queue_size;
+    int queue_head;
+    int queue_len;
+};
+
+/* The matrix for SDL_BuildAudioCVT()'s channel filters, rows of each
+   new channel's share of each old one */
+static int
+SDL_BuildAudioStreamRemix(SDL_AudioStream * stream)
+{
+    const int src_channels = stream->src_channels;
+    const int dst_channels = stream->dst_channels;
+    const int rows = SDL_max(src_channels, dst_channels);
+    const size_t row_size = src_channels * sizeof (float);
+    float *m;
+    int channels = src_channels;
+    int i, j;
+
+    m = (float *) SDL_calloc(rows * src_channels, sizeof (float));
+    if (!m) {
+        return SDL_OutOfMemory();
+    }
+    stream->remix = m;
+    for (i = 0; i < src_channels; ++i) {
+        m[i * src_channels + i] = 1.0f;
+    }
+
+#define ROW(i) (&m[(i) * src_channels])
+
+    /* SDL_ConvertStereo(), every channel twice */
+#define DUPLICATE_CHANNELS() \
+    { \
+        for (i = channels - 1; i >= 0; --i) { \
+            SDL_memmove(ROW(i * 2 + 1), ROW(i), row_size); \
+            SDL_memmove(ROW(i * 2), ROW(i), row_size); \
+        } \
+        channels *= 2; \
+    }
+
+    /* SDL_ConvertSurround() & SDL_ConvertSurround_4(), from stereo */
+#define SURROUND_CHANNELS(count) \
+    { \
+        for (j = 0; j < src_channels; ++j) { \
+            const float ce = ROW(0)[j] * 0.5f + ROW(1)[j] * 0.5f; \
+            ROW(2)[j] = ROW(0)[j] - ce; \
+            ROW(3)[j] = ROW(1)[j] - ce; \
+            if (count == 6) { \
+                ROW(4)[j] = ROW(5)[j] = ce; \
+            } \
+        } \
+        channels = count; \
+    }
+
+    /* SDL_ConvertMono(), every pair of channels averaged */
+#define HALVE_CHANNELS() \
+    { \
+        channels /= 2; \
+        for (i = 0; i < channels; ++i) { \
+            for (j = 0; j < src_channels; ++j) { \
+                ROW(i)[j] = ROW(i * 2)[j] * 0.5f + ROW(i * 2 + 1)[j] * 0.5f; \
+            } \
+        } \
+    }
+
+    if ((channels == 1) && (dst_channels > 1)) {
+        DUPLICATE_CHANNELS();
+    }
+    if ((channels == 2) && (dst_channels == 6)) {
+        SURROUND_CHANNELS(6);
+    }
+    if ((channels == 2) && (dst_channels == 4)) {
+        SURROUND_CHANNELS(4);
+    }
+    while ((channels * 2) <= dst_channels) {
+        DUPLICATE_CHANNELS();
+    }
+    if ((channels == 6) && (dst_channels <= 2)) {
+        channels = 2;           /* SDL_ConvertStrip() */
+    }
+    if ((channels == 6) && (dst_channels == 4)) {
+        channels = 4;           /* SDL_ConvertStrip_2() */
+    }
+    while (((channels % 2) == 0) && ((channels / 2) >= dst_channels)) {
+        HALVE_CHANNELS();
+    }
+
+#undef HALVE_CHANNELS
+#undef SURROUND_CHANNELS
+#undef DUPLICATE_CHANNELS
+#undef ROW
+
+    if (channels != dst_channels) {
+        return SDL_SetError("Can't convert %d channels to %d",
+                            src_channels, dst_channels);
+    }
+    return 0;
+}
+
+/* Frames of samples from src_channels to dst_channels */
+static void
+SDL_RemixAudioStream(const SDL_AudioStream * stream, const float *src,
+                     float *dst, int frames)
+{
+    const int src_channels = stream->src_channels;
+    const int dst_channels = stream->dst_channels;
+    const float *m = stream->remix;
+    int i, c, j;
+
+    for (i = 0; i < frames; ++i) {
+        for (c = 0; c < dst_channels; ++c) {
+            const float *row = &m[c * src_channels];
+            float sum = 0.0f;
+
+            for (j = 0; j < src_channels; ++j) {
+                sum += row[j] * src[j];
+            }
+            *dst++ = sum;
+        }
+        src += src_channels;
+    }
+}
+
+static int
+SDL_IsAudioStreamFormat(SDL_AudioFormat format)
+{
+    switch (format) {
+    case AUDIO_U8:
+    case AUDIO_S8:
+    case AUDIO_U16LSB:
+    case AUDIO_S16LSB:
+    case AUDIO_U16MSB:
+    case AUDIO_S16MSB:
+    case AUDIO_S32LSB:
+    case AUDIO_S32MSB:
+    case AUDIO_F32LSB:
+    case AUDIO_F32MSB:
+        return 1;
+    }
+    return 0;
+}
+
+/* Samples to floats, integers scaled by 1 / 2^(bits - 1) */
+static void
+SDL_DecodeAudioStream(const void *src, SDL_AudioFormat format, float *dst,
+                      int samples)
+{
+    int i;
+
+#define DECODE(type, expr) \
+    { \
+        const type *s = (const type *) src; \
+        for (i = 0; i < samples; ++i) { \
+            const type x = s[i]; \
+            dst[i] = (expr); \
+        } \
+    }
+
+    switch (format) {
+    case AUDIO_U8:
+        DECODE(Uint8, ((int) x - 128) * (1.0f / 128.0f));
+        break;
+    case AUDIO_S8:
+        DECODE(Sint8, x * (1.0f / 128.0f));
+        break;
+    case AUDIO_U16LSB:
+        DECODE(Uint16, ((int) SDL_SwapLE16(x) - 32768) * (1.0f / 32768.0f));
+        break;
+    case AUDIO_S16LSB:
+        DECODE(Uint16, ((Sint16) SDL_SwapLE16(x)) * (1.0f / 32768.0f));
+        break;
+    case AUDIO_U16MSB:
+        DECODE(Uint16, ((int) SDL_SwapBE16(x) - 32768) * (1.0f / 32768.0f));
+        break;
+    case AUDIO_S16MSB:
+        DECODE(Uint16, ((Sint16) SDL_SwapBE16(x)) * (1.0f / 32768.0f));
+        break;
+    case AUDIO_S32LSB:
+        DECODE(Uint32, (float) (((Sint32) SDL_SwapLE32(x)) * (1.0 / 2147483648.0)));
+        break;
+    case AUDIO_S32MSB:
+        DECODE(Uint32, (float) (((Sint32) SDL_SwapBE32(x)) * (1.0 / 2147483648.0)));
+        break;
+    case AUDIO_F32LSB:
+        DECODE(float, SDL_SwapFloatLE(x));
+        break;
+    case AUDIO_F32MSB:
+        DECODE(float, SDL_SwapFloatBE(x));
+        break;
+    }
+
+#undef DECODE
+}
+
+/* Floats to samples, rounded, and clamped to what the format holds */
+static void
+SDL_EncodeAudioStream(const float *src, SDL_AudioFormat format, void *dst,
+                      int samples)
+{
+    int i;
+
+#define ENCODE(type, scale, lo, hi, expr) \
+    { \
+        type *d = (type *) dst; \
+        for (i = 0; i < samples; ++i) { \
+            float x = src[i] * (scale); \
+            x = (x < (hi)) ? x : (hi); \
+            x = (x > (lo)) ? x : (lo); \
+            x += (x < 0.0f) ? -0.5f : 0.5f; \
+            d[i] = (expr); \
+        } \
+    }
+
+    switch (format) {
+    case AUDIO_U8:
+        ENCODE(Uint8, 128.0f, -128.0f, 127.0f, (Uint8) ((int) x + 128));
+        break;
+    case AUDIO_S8:
+        ENCODE(Sint8, 128.0f, -128.0f, 127.0f, (Sint8) x);
+        break;
+    case AUDIO_U16LSB:
+        ENCODE(Uint16, 32768.0f, -32768.0f, 32767.0f,
+               SDL_SwapLE16((Uint16) ((int) x + 32768)));
+        break;
+    case AUDIO_S16LSB:
+        ENCODE(Uint16, 32768.0f, -32768.0f, 32767.0f,
+               SDL_SwapLE16((Uint16) (Sint16) x));
+        break;
+    case AUDIO_U16MSB:
+        ENCODE(Uint16, 32768.0f, -32768.0f, 32767.0f,
+               SDL_SwapBE16((Uint16) ((int) x + 32768)));
+        break;
+    case AUDIO_S16MSB:
+        ENCODE(Uint16, 32768.0f, -32768.0f, 32767.0f,
+               SDL_SwapBE16((Uint16) (Sint16) x));
+        break;
+    case AUDIO_S32LSB:
+    case AUDIO_S32MSB:
+        {
+            Uint32 *d = (Uint32 *) dst;
+
+            /* In doubles, as floats can't hold 2^31 - 1 */
+            for (i = 0; i < samples; ++i) {
+                double x = src[i] * 2147483648.0;
+                Sint32 val;
+
+                x = (x < 2147483647.0) ? x : 2147483647.0;
+                x = (x > -2147483648.0) ? x : -2147483648.0;
+                x += (x < 0.0) ? -0.5 : 0.5;
+                val = (Sint32) x;
+                if (format == AUDIO_S32LSB) {
+                    d[i] = SDL_SwapLE32((Uint32) val);
+                } else {
+                    d[i] = SDL_SwapBE32((Uint32) val);
+                }
+            }
+        }
+        break;
+    case AUDIO_F32LSB:
+        {
+            float *d = (float *) dst;
+
+            for (i = 0; i < samples; ++i) {
+                d[i] = SDL_SwapFloatLE(src[i]);
+            }
+        }
+        break;
+    case AUDIO_F32MSB:
+        {
+            float *d = (float *) dst;
+
+            for (i = 0; i < samples; ++i) {
+                d[i] = SDL_SwapFloatBE(src[i]);
+            }
+        }
+        break;
+    }
+
+#undef ENCODE
+}
+
+/* Room for len more bytes at the end of the queue */
+static Uint8 *
+SDL_ReserveAudioStreamQueue(SDL_AudioStream * stream, int len)
+{
+    if (stream->queue_head + stream->queue_len + len > stream->queue_size) {
+        if (stream->queue_len + len <= stream->queue_size) {
+            SDL_memmove(stream->queue, stream->queue + stream->queue_head,
+                        stream->queue_len);
+        } else {
+            const int size = SDL_max(stream->queue_size * 2,
+                                     stream->queue_len + len);
+            Uint8 *queue = (Uint8 *) SDL_malloc(size);
+
+            if (!queue) {
+                SDL_OutOfMemory();
+                return NULL;
+            }
+            if (stream->queue_len) {
+                SDL_memcpy(queue, stream->queue + stream->queue_head,
+                           stream->queue_len);
+            }
+            SDL_free(stream->queue);
+            stream->queue = queue;
+            stream->queue_size = size;
+        }
+        stream->queue_head = 0;
+    }
+    return stream->queue + stream->queue_head + stream->queue_len;
+}
+
+/* Resampled frames, their channels mixed if that's left, onto the queue;
+   spare is a work buffer samples isn't in */
+static int
+SDL_QueueAudioStream(SDL_AudioStream * stream, const float *samples,
+                     float *spare, int frames)
+{
+    const int len = frames * stream->dst_frame_size;
+    Uint8 *dst = SDL_ReserveAudioStreamQueue(stream, len);
+
+    if (!dst) {
+        return -1;
+    }
+    if (stream->remix && !stream->remix_first) {
+        SDL_RemixAudioStream(stream, samples, spare, frames);
+        samples = spare;
+    }
+    SDL_EncodeAudioStream(samples, stream->dst_format, dst,
+                          frames * stream->dst_channels);
+    stream->queue_len += len;
+    return 0;
+}
+
+/* Resampled output onto the queue, until there's no more for now */
+static int
+SDL_DrainAudioStream(SDL_AudioStream * stream, const float *src, int len,
+                     int flush)
+{
+    /* Never more frames than the work buffer holds after mixing */
+    const int frame_size = stream->resampled_channels * sizeof (float);
+    const int dst_len = SDL_AUDIOSTREAM_BLOCK * frame_size;
+    float *dst = (src == stream->work[0]) ? stream->work[1] : stream->work[0];
+    float *spare = (dst == stream->work[0]) ? stream->work[1] : stream->work[0];
+    int got;
+
+    do {
+        if (flush) {
+            got = SDL_FlushAudioResampler(stream->resampler, dst, dst_len);
+        } else {
+            got = SDL_ResampleAudio(stream->resampler, src, len, dst, dst_len);
+            src = NULL;
+            len = 0;
+        }
+        if (got < 0 || (got && SDL_QueueAudioStream(stream, dst, spare,
+                                                    got / frame_size) < 0)) {
+            return -1;
+        }
+    } while (got > 0);
+    return 0;
+}
+
+/* Up to SDL_AUDIOSTREAM_BLOCK whole frames, converted onto the queue */
+static int
+SDL_ConvertAudioStreamBlock(SDL_AudioStream * stream, const Uint8 * src,
+                            int frames)
+{
+    const int size = SDL_AUDIO_BITSIZE(stream->src_format) / 8;
+    float *samples = stream->work[0];
+    float *spare = stream->work[1];
+
+    /* Samples the caller gave misaligned are copied to read them */
+    if (((size_t) src) & (size - 1)) {
+        SDL_memcpy(spare, src, frames * stream->src_frame_size);
+        src = (const Uint8 *) spare;
+    }
+    SDL_DecodeAudioStream(src, stream->src_format, samples,
+                          frames * stream->src_channels);
+    if (stream->remix && stream->remix_first) {
+        SDL_RemixAudioStream(stream, samples, spare, frames);
+        samples = stream->work[1];
+        spare = stream->work[0];
+    }
+    if (stream->resampler) {
+        return SDL_DrainAudioStream(stream, samples, frames *
+                                    stream->resampled_channels *
+                                    sizeof (float), 0);
+    }
+    return SDL_QueueAudioStream(stream, samples, spare, frames);
+}
+
+SDL_AudioStream *
+SDL_NewAudioStream(SDL_AudioFormat src_format, Uint8 src_channels,
+                   int src_rate, SDL_AudioFormat dst_format,
+                   Uint8 dst_channels, int dst_rate)
+{
+    SDL_AudioStream *stream;
+    int most;
+
+    if (!SDL_IsAudioStreamFormat(src_format)) {
+        SDL_SetError("Invalid source format");
+        return NULL;
+    }
+    if (!SDL_IsAudioStreamFormat(dst_format)) {
+        SDL_SetError("Invalid destination format");
+        return NULL;
+    }
+    if ((src_channels == 0) || (dst_channels == 0)) {
+        SDL_SetError("Source or destination channels is zero");
+        return NULL;
+    }
+    if ((src_rate <= 0) || (dst_rate <= 0)) {
+        SDL_SetError("Source or destination rate is zero");
+        return NULL;
+    }
+
+    stream = (SDL_AudioStream *) SDL_calloc(1, sizeof (*stream));
+    if (!stream) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    stream->src_format = src_format;
+    stream->src_channels = src_channels;
+    stream->src_frame_size = src_channels * (SDL_AUDIO_BITSIZE(src_format) / 8);
+    stream->dst_format = dst_format;
+    stream->dst_channels = dst_channels;
+    stream->dst_frame_size = dst_channels * (SDL_AUDIO_BITSIZE(dst_format) / 8);
+    stream->passthrough = (src_format == dst_format &&
+                           src_channels == dst_channels &&
+                           src_rate == dst_rate);
+    if (stream->passthrough) {
+        return stream;
+    }
+
+    if (src_channels != dst_channels &&
+        SDL_BuildAudioStreamRemix(stream) < 0) {
+        SDL_FreeAudioStream(stream);
+        return NULL;
+    }
+    stream->remix_first = (dst_channels < src_channels);
+    stream->resampled_channels = SDL_min(src_channels, dst_channels);
+    if (src_rate != dst_rate) {
+        stream->resampler = SDL_NewAudioResampler(AUDIO_F32SYS,
+                                                  (Uint8) stream->resampled_channels,
+                                                  src_rate, dst_rate);
+        if (!stream->resampler) {
+            SDL_FreeAudioStream(stream);
+            return NULL;
+        }
+    }
+
+    most = SDL_max(src_channels, dst_channels);
+    stream->work[0] = (float *) SDL_malloc(SDL_AUDIOSTREAM_BLOCK * most *
+                                           sizeof (float) * 2);
+    stream->partial = (Uint8 *) SDL_malloc(stream->src_frame_size);
+    if (!stream->work[0] || !stream->partial) {
+        SDL_FreeAudioStream(stream);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    stream->work[1] = stream->work[0] + SDL_AUDIOSTREAM_BLOCK * most;
+    return stream;
+}
+
+int
+SDL_AudioStreamPut(SDL_AudioStream * stream, const void *buf, int len)
+{
+    const Uint8 *src = (const Uint8 *) buf;
+    int frame_size, frames;
+
+    if (!stream) {
+        return SDL_InvalidParamError("stream");
+    }
+    if (len < 0 || (len && !buf)) {
+        return SDL_InvalidParamError("len");
+    }
+
+    if (stream->passthrough) {
+        Uint8 *dst = SDL_ReserveAudioStreamQueue(stream, len);
+
+        if (!dst) {
+            return -1;
+        }
+        SDL_memcpy(dst, src, len);
+        stream->queue_len += len;
+        return 0;
+    }
+
+    frame_size = stream->src_frame_size;
+    if (stream->partial_len) {
+        const int count = SDL_min(frame_size - stream->partial_len, len);
+
+        SDL_memcpy(stream->partial + stream->partial_len, src, count);
+        stream->partial_len += count;
+        src += count;
+        len -= count;
+        if (stream->partial_len < frame_size) {
+            return 0;
+        }
+        stream->partial_len = 0;
+        if (SDL_ConvertAudioStreamBlock(stream, stream->partial, 1) < 0) {
+            return -1;
+        }
+    }
+    while (len >= frame_size) {
+        frames = SDL_min(len / frame_size, SDL_AUDIOSTREAM_BLOCK);
+        if (SDL_ConvertAudioStreamBlock(stream, src, frames) < 0) {
+            return -1;
+        }
+        src += frames * frame_size;
+        len -= frames * frame_size;
+    }
+    if (len) {
+        SDL_memcpy(stream->partial, src, len);
+        stream->partial_len = len;
+    }
+    return 0;
+}
+
+int
+SDL_AudioStreamGet(SDL_AudioStream * stream, void *buf, int len)
+{
+    if (!stream) {
+        return SDL_InvalidParamError("stream");
+    }
+    if (len < 0 || (len && !buf)) {
+        return SDL_InvalidParamError("len");
+    }
+    len = SDL_min(len, stream->queue_len);
+    len -= len % stream->dst_frame_size;
+    if (len) {
+        SDL_memcpy(buf, stream->queue + stream->queue_head, len);
+        stream->queue_head += len;
+        stream->queue_len -= len;
+        if (!stream->queue_len) {
+            stream->queue_head = 0;
+        }
+    }
+    return len;
+}
+
+int
+SDL_AudioStreamAvailable(SDL_AudioStream * stream)
+{
+    if (!stream) {
+        return SDL_InvalidParamError("stream");
+    }
+    return stream->queue_len - (stream->queue_len % stream->dst_frame_size);
+}
+
+int
+SDL_AudioStreamFlush(SDL_AudioStream * stream)
+{
+    if (!stream) {
+        return SDL_InvalidParamError("stream");
+    }
+    /* A frame not all put in is dropped */
+    stream->queue_len = SDL_AudioStreamAvailable(stream);
+    stream->partial_len = 0;
+    if (stream->resampler) {
+        return SDL_DrainAudioStream(stream, NULL, 0, 1);
+    }
+    return 0;
+}
+
+void
+SDL_AudioStreamClear(SDL_AudioStream * stream)
+{
+    if (stream) {
+        stream->queue_head = 0;
+        stream->queue_len = 0;
+        stream->partial_len = 0;
+        if (stream->resampler) {
+            SDL_ResetAudioResampler(stream->resampler);
+        }
+    }
+}
+
+void
+SDL_FreeAudioStream(SDL_AudioStream * stream)
+{
+    if (stream) {
+        SDL_FreeAudioResampler(stream->resampler);
+        SDL_free(stream->remix);
+        SDL_free(stream->work[0]);
+        SDL_free(stream->partial);
+        SDL_free(stream->queue);
+        SDL_free(stream);
+    }
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,620 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* SSE2, AVX2 & NEON versions of the sample format converters most used:
+   U8 <-> S16, S16 <-> F32 & S32 <-> F32, native byte order.  They give the
+   generated converters' samples, save that floats out of -1 to 1 (or NaN)
+   are clamped instead of wrapping.  Like those, they convert in place:
+   widening ones from the end of the buffer, narrowing ones from the start,
+   each vector loaded before anything's stored over it.  Setting the
+   SDL_AUDIO_SIMD hint to 0 leaves the generated ones, to compare against. */
+
+#include "SDL_audio.h"
+#include "SDL_hints.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_audio_c.h"
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN && defined(__GNUC__) && \
+    !defined(__clang_analyzer__) && (defined(__x86_64__) || defined(__i386__))
+#define SDL_AUDIOCVT_X86 1
+#include <immintrin.h>
+#elif SDL_BYTEORDER == SDL_LIL_ENDIAN && defined(__GNUC__) && \
+    !defined(__clang_analyzer__) && defined(__aarch64__)
+#define SDL_AUDIOCVT_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(SDL_AUDIOCVT_X86) || defined(SDL_AUDIOCVT_NEON)
+
+/* As in SDL_audiotypecvt.c */
+#define DIVBY32767 3.05185094759972e-05f
+#define DIVBY2147483647 4.6566128752458e-10f
+
+/* The samples the vectors don't cover, the same way, min & max in the
+   order SSE has them so NaN clamps to the top */
+static SDL_INLINE Sint16
+SDL_U8ToS16(Uint8 x)
+{
+    return (Sint16) ((Uint16) (x ^ 0x80) << 8);
+}
+
+static SDL_INLINE Uint8
+SDL_S16ToU8(Sint16 x)
+{
+    return (Uint8) (((Uint16) x ^ 0x8000) >> 8);
+}
+
+static SDL_INLINE Sint16
+SDL_F32ToS16(float x)
+{
+    x *= 32767.0f;
+    x = (x < 32767.0f) ? x : 32767.0f;
+    x = (x > -32768.0f) ? x : -32768.0f;
+    return (Sint16) x;
+}
+
+static SDL_INLINE Sint32
+SDL_F32ToS32(float x)
+{
+    double d = (double) x * 2147483647.0;
+
+    d = (d < 2147483647.0) ? d : 2147483647.0;
+    d = (d > -2147483648.0) ? d : -2147483648.0;
+    return (Sint32) d;
+}
+
+typedef void (*SDL_AudioKernel) (Uint8 * buf, int samples);
+
+#ifdef SDL_AUDIOCVT_X86
+
+static void
+SDL_U8ToS16SSE2(Uint8 * buf, int samples)
+    __attribute__((target("sse2")));
+static void
+SDL_U8ToS16SSE2(Uint8 * buf, int samples)
+{
+    const __m128i flip = _mm_set1_epi8((char) 0x80);
+    const __m128i zero = _mm_setzero_si128();
+    Sint16 *dst = (Sint16 *) buf;
+    int i = samples;
+
+    while (i & 15) {
+        --i;
+        dst[i] = SDL_U8ToS16(buf[i]);
+    }
+    while (i > 0) {
+        __m128i v;
+
+        i -= 16;
+        v = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (buf + i)), flip);
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_unpacklo_epi8(zero, v));
+        _mm_storeu_si128((__m128i *) (dst + i + 8), _mm_unpackhi_epi8(zero, v));
+    }
+}
+
+static void
+SDL_S16ToU8SSE2(Uint8 * buf, int samples)
+    __attribute__((target("sse2")));
+static void
+SDL_S16ToU8SSE2(Uint8 * buf, int samples)
+{
+    const __m128i flip = _mm_set1_epi8((char) 0x80);
+    const Sint16 *src = (const Sint16 *) buf;
+    int i;
+
+    for (i = 0; i + 16 <= samples; i += 16) {
+        __m128i a = _mm_srli_epi16(_mm_loadu_si128((const __m128i *) (src + i)), 8);
+        __m128i b = _mm_srli_epi16(_mm_loadu_si128((const __m128i *) (src + i + 8)), 8);
+
+        _mm_storeu_si128((__m128i *) (buf + i),
+                         _mm_xor_si128(_mm_packus_epi16(a, b), flip));
+    }
+    for (; i < samples; ++i) {
+        buf[i] = SDL_S16ToU8(src[i]);
+    }
+}
+
+static void
+SDL_S16ToF32SSE2(Uint8 * buf, int samples)
+    __attribute__((target("sse2")));
+static void
+SDL_S16ToF32SSE2(Uint8 * buf, int samples)
+{
+    const __m128 scale = _mm_set1_ps(DIVBY32767);
+    const Sint16 *src = (const Sint16 *) buf;
+    float *dst = (float *) buf;
+    int i = samples;
+
+    while (i & 7) {
+        --i;
+        dst[i] = ((float) src[i]) * DIVBY32767;
+    }
+    while (i > 0) {
+        __m128i v, lo, hi;
+
+        i -= 8;
+        v = _mm_loadu_si128((const __m128i *) (src + i));
+        lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+}
+
+static void
+SDL_F32ToS16SSE2(Uint8 * buf, int samples)
+    __attribute__((target("sse2")));
+static void
+SDL_F32ToS16SSE2(Uint8 * buf, int samples)
+{
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    const __m128 top = _mm_set1_ps(32767.0f);
+    const __m128 bottom = _mm_set1_ps(-32768.0f);
+    const float *src = (const float *) buf;
+    Sint16 *dst = (Sint16 *) buf;
+    int i;
+
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+
+        a = _mm_max_ps(_mm_min_ps(a, top), bottom);
+        b = _mm_max_ps(_mm_min_ps(b, top), bottom);
+        _mm_storeu_si128((__m128i *) (dst + i),
+                         _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_F32ToS16(src[i]);
+    }
+}
+
+static void
+SDL_S32ToF32SSE2(Uint8 * buf, int samples)
+    __attribute__((target("sse2")));
+static void
+SDL_S32ToF32SSE2(Uint8 * buf, int samples)
+{
+    const __m128 scale = _mm_set1_ps(DIVBY2147483647);
+    const Sint32 *src = (const Sint32 *) buf;
+    float *dst = (float *) buf;
+    int i;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = ((float) src[i]) * DIVBY2147483647;
+    }
+}
+
+/* In doubles, as the generated converter multiplies */
+static void
+SDL_F32ToS32SSE2(Uint8 * buf, int samples)
+    __attribute__((target("sse2")));
+static void
+SDL_F32ToS32SSE2(Uint8 * buf, int samples)
+{
+    const __m128d scale = _mm_set1_pd(2147483647.0);
+    const __m128d top = _mm_set1_pd(2147483647.0);
+    const __m128d bottom = _mm_set1_pd(-2147483648.0);
+    const float *src = (const float *) buf;
+    Sint32 *dst = (Sint32 *) buf;
+    int i;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        __m128 v = _mm_loadu_ps(src + i);
+        __m128d lo = _mm_mul_pd(_mm_cvtps_pd(v), scale);
+        __m128d hi = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), scale);
+
+        lo = _mm_max_pd(_mm_min_pd(lo, top), bottom);
+        hi = _mm_max_pd(_mm_min_pd(hi, top), bottom);
+        _mm_storeu_si128((__m128i *) (dst + i),
+                         _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo),
+                                            _mm_cvttpd_epi32(hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_F32ToS32(src[i]);
+    }
+}
+
+static void
+SDL_U8ToS16AVX2(Uint8 * buf, int samples)
+    __attribute__((target("avx2")));
+static void
+SDL_U8ToS16AVX2(Uint8 * buf, int samples)
+{
+    const __m128i flip = _mm_set1_epi8((char) 0x80);
+    Sint16 *dst = (Sint16 *) buf;
+    int i = samples;
+
+    while (i & 31) {
+        --i;
+        dst[i] = SDL_U8ToS16(buf[i]);
+    }
+    while (i > 0) {
+        __m128i a, b;
+
+        i -= 32;
+        a = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (buf + i)), flip);
+        b = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (buf + i + 16)), flip);
+        _mm256_storeu_si256((__m256i *) (dst + i),
+                            _mm256_slli_epi16(_mm256_cvtepu8_epi16(a), 8));
+        _mm256_storeu_si256((__m256i *) (dst + i + 16),
+                            _mm256_slli_epi16(_mm256_cvtepu8_epi16(b), 8));
+    }
+}
+
+static void
+SDL_S16ToU8AVX2(Uint8 * buf, int samples)
+    __attribute__((target("avx2")));
+static void
+SDL_S16ToU8AVX2(Uint8 * buf, int samples)
+{
+    const __m256i flip = _mm256_set1_epi8((char) 0x80);
+    const Sint16 *src = (const Sint16 *) buf;
+    int i;
+
+    for (i = 0; i + 32 <= samples; i += 32) {
+        __m256i a = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *) (src + i)), 8);
+        __m256i b = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *) (src + i + 16)), 8);
+        /* The packs are per 128-bit lane */
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+
+        _mm256_storeu_si256((__m256i *) (buf + i), _mm256_xor_si256(v, flip));
+    }
+    for (; i < samples; ++i) {
+        buf[i] = SDL_S16ToU8(src[i]);
+    }
+}
+
+static void
+SDL_S16ToF32AVX2(Uint8 * buf, int samples)
+    __attribute__((target("avx2")));
+static void
+SDL_S16ToF32AVX2(Uint8 * buf, int samples)
+{
+    const __m256 scale = _mm256_set1_ps(DIVBY32767);
+    const Sint16 *src = (const Sint16 *) buf;
+    float *dst = (float *) buf;
+    int i = samples;
+
+    while (i & 15) {
+        --i;
+        dst[i] = ((float) src[i]) * DIVBY32767;
+    }
+    while (i > 0) {
+        __m256i lo, hi;
+
+        i -= 16;
+        lo = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (src + i)));
+        hi = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (src + i + 8)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+}
+
+static void
+SDL_F32ToS16AVX2(Uint8 * buf, int samples)
+    __attribute__((target("avx2")));
+static void
+SDL_F32ToS16AVX2(Uint8 * buf, int samples)
+{
+    const __m256 scale = _mm256_set1_ps(32767.0f);
+    const __m256 top = _mm256_set1_ps(32767.0f);
+    const __m256 bottom = _mm256_set1_ps(-32768.0f);
+    const float *src = (const float *) buf;
+    Sint16 *dst = (Sint16 *) buf;
+    int i;
+
+    for (i = 0; i + 16 <= samples; i += 16) {
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        __m256 b = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale);
+        __m256i v;
+
+        a = _mm256_max_ps(_mm256_min_ps(a, top), bottom);
+        b = _mm256_max_ps(_mm256_min_ps(b, top), bottom);
+        v = _mm256_packs_epi32(_mm256_cvttps_epi32(a), _mm256_cvttps_epi32(b));
+        _mm256_storeu_si256((__m256i *) (dst + i),
+                            _mm256_permute4x64_epi64(v, 0xD8));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_F32ToS16(src[i]);
+    }
+}
+
+static void
+SDL_S32ToF32AVX2(Uint8 * buf, int samples)
+    __attribute__((target("avx2")));
+static void
+SDL_S32ToF32AVX2(Uint8 * buf, int samples)
+{
+    const __m256 scale = _mm256_set1_ps(DIVBY2147483647);
+    const Sint32 *src = (const Sint32 *) buf;
+    float *dst = (float *) buf;
+    int i;
+
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = ((float) src[i]) * DIVBY2147483647;
+    }
+}
+
+static void
+SDL_F32ToS32AVX2(Uint8 * buf, int samples)
+    __attribute__((target("avx2")));
+static void
+SDL_F32ToS32AVX2(Uint8 * buf, int samples)
+{
+    const __m256d scale = _mm256_set1_pd(2147483647.0);
+    const __m256d top = _mm256_set1_pd(2147483647.0);
+    const __m256d bottom = _mm256_set1_pd(-2147483648.0);
+    const float *src = (const float *) buf;
+    Sint32 *dst = (Sint32 *) buf;
+    int i;
+
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m256d lo = _mm256_cvtps_pd(_mm_loadu_ps(src + i));
+        __m256d hi = _mm256_cvtps_pd(_mm_loadu_ps(src + i + 4));
+
+        lo = _mm256_max_pd(_mm256_min_pd(_mm256_mul_pd(lo, scale), top), bottom);
+        hi = _mm256_max_pd(_mm256_min_pd(_mm256_mul_pd(hi, scale), top), bottom);
+        _mm256_storeu_si256((__m256i *) (dst + i),
+                            _mm256_set_m128i(_mm256_cvttpd_epi32(hi),
+                                             _mm256_cvttpd_epi32(lo)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_F32ToS32(src[i]);
+    }
+}
+
+#endif /* SDL_AUDIOCVT_X86 */
+
+#ifdef SDL_AUDIOCVT_NEON
+
+static void
+SDL_U8ToS16NEON(Uint8 * buf, int samples)
+{
+    const uint8x16_t flip = vdupq_n_u8(0x80);
+    Sint16 *dst = (Sint16 *) buf;
+    int i = samples;
+
+    while (i & 15) {
+        --i;
+        dst[i] = SDL_U8ToS16(buf[i]);
+    }
+    while (i > 0) {
+        uint8x16_t v;
+
+        i -= 16;
+        v = veorq_u8(vld1q_u8(buf + i), flip);
+        vst1q_s16(dst + i, vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(v), 8)));
+        vst1q_s16(dst + i + 8, vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(v), 8)));
+    }
+}
+
+static void
+SDL_S16ToU8NEON(Uint8 * buf, int samples)
+{
+    const uint8x16_t flip = vdupq_n_u8(0x80);
+    const Sint16 *src = (const Sint16 *) buf;
+    int i;
+
+    for (i = 0; i + 16 <= samples; i += 16) {
+        uint16x8_t a = vreinterpretq_u16_s16(vld1q_s16(src + i));
+        uint16x8_t b = vreinterpretq_u16_s16(vld1q_s16(src + i + 8));
+        uint8x16_t v = vcombine_u8(vshrn_n_u16(a, 8), vshrn_n_u16(b, 8));
+
+        vst1q_u8(buf + i, veorq_u8(v, flip));
+    }
+    for (; i < samples; ++i) {
+        buf[i] = SDL_S16ToU8(src[i]);
+    }
+}
+
+static void
+SDL_S16ToF32NEON(Uint8 * buf, int samples)
+{
+    const Sint16 *src = (const Sint16 *) buf;
+    float *dst = (float *) buf;
+    int i = samples;
+
+    while (i & 7) {
+        --i;
+        dst[i] = ((float) src[i]) * DIVBY32767;
+    }
+    while (i > 0) {
+        int16x8_t v;
+
+        i -= 8;
+        v = vld1q_s16(src + i);
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), DIVBY32767));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), DIVBY32767));
+    }
+}
+
+static void
+SDL_F32ToS16NEON(Uint8 * buf, int samples)
+{
+    const float32x4_t top = vdupq_n_f32(32767.0f);
+    const float32x4_t bottom = vdupq_n_f32(-32768.0f);
+    const float *src = (const float *) buf;
+    Sint16 *dst = (Sint16 *) buf;
+    int i;
+
+    for (i = 0; i + 8 <= samples; i += 8) {
+        float32x4_t a = vmulq_n_f32(vld1q_f32(src + i), 32767.0f);
+        float32x4_t b = vmulq_n_f32(vld1q_f32(src + i + 4), 32767.0f);
+
+        a = vmaxq_f32(vminq_f32(a, top), bottom);
+        b = vmaxq_f32(vminq_f32(b, top), bottom);
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(a)),
+                                        vqmovn_s32(vcvtq_s32_f32(b))));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_F32ToS16(src[i]);
+    }
+}
+
+static void
+SDL_S32ToF32NEON(Uint8 * buf, int samples)
+{
+    const Sint32 *src = (const Sint32 *) buf;
+    float *dst = (float *) buf;
+    int i;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src + i)), DIVBY2147483647));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = ((float) src[i]) * DIVBY2147483647;
+    }
+}
+
+static void
+SDL_F32ToS32NEON(Uint8 * buf, int samples)
+{
+    const float64x2_t top = vdupq_n_f64(2147483647.0);
+    const float64x2_t bottom = vdupq_n_f64(-2147483648.0);
+    const float *src = (const float *) buf;
+    Sint32 *dst = (Sint32 *) buf;
+    int i;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        float32x4_t v = vld1q_f32(src + i);
+        float64x2_t lo = vmulq_n_f64(vcvt_f64_f32(vget_low_f32(v)), 2147483647.0);
+        float64x2_t hi = vmulq_n_f64(vcvt_high_f64_f32(v), 2147483647.0);
+
+        lo = vmaxq_f64(vminq_f64(lo, top), bottom);
+        hi = vmaxq_f64(vminq_f64(hi, top), bottom);
+        vst1q_s32(dst + i, vcombine_s32(vmovn_s64(vcvtq_s64_f64(lo)),
+                                        vmovn_s64(vcvtq_s64_f64(hi))));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_F32ToS32(src[i]);
+    }
+}
+
+#endif /* SDL_AUDIOCVT_NEON */
+
+/* The samples in the buffer go through the kernel, then the buffer's new
+   length goes on to the next filter, as the generated converters do */
+static void
+SDL_RunAudioKernel(SDL_AudioCVT * cvt, SDL_AudioKernel kernel,
+                   int src_size, int dst_size, SDL_AudioFormat dst_fmt)
+{
+    kernel(cvt->buf, cvt->len_cvt / src_size);
+    if (dst_size > src_size) {
+        cvt->len_cvt *= dst_size / src_size;
+    } else if (dst_size < src_size) {
+        cvt->len_cvt /= src_size / dst_size;
+    }
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, dst_fmt);
+    }
+}
+
+#define SDL_AUDIO_KERNEL_FILTER(kernel, src_size, dst_size, dst_fmt) \
+static void SDLCALL \
+SDL_Convert_##kernel(SDL_AudioCVT * cvt, SDL_AudioFormat format) \
+{ \
+    SDL_RunAudioKernel(cvt, SDL_##kernel, src_size, dst_size, dst_fmt); \
+}
+
+#ifdef SDL_AUDIOCVT_X86
+#define SDL_AUDIO_KERNEL_FILTERS(pair, src_size, dst_size, dst_fmt) \
+    SDL_AUDIO_KERNEL_FILTER(pair##SSE2, src_size, dst_size, dst_fmt) \
+    SDL_AUDIO_KERNEL_FILTER(pair##AVX2, src_size, dst_size, dst_fmt)
+#define SDL_AUDIO_KERNEL_ENTRY(src_fmt, dst_fmt, pair) \
+    { src_fmt, dst_fmt, SDL_Convert_##pair##SSE2, SDL_Convert_##pair##AVX2 }
+#else
+#define SDL_AUDIO_KERNEL_FILTERS(pair, src_size, dst_size, dst_fmt) \
+    SDL_AUDIO_KERNEL_FILTER(pair##NEON, src_size, dst_size, dst_fmt)
+#define SDL_AUDIO_KERNEL_ENTRY(src_fmt, dst_fmt, pair) \
+    { src_fmt, dst_fmt, SDL_Convert_##pair##NEON, NULL }
+#endif
+
+SDL_AUDIO_KERNEL_FILTERS(U8ToS16, 1, 2, AUDIO_S16LSB)
+SDL_AUDIO_KERNEL_FILTERS(S16ToU8, 2, 1, AUDIO_U8)
+SDL_AUDIO_KERNEL_FILTERS(S16ToF32, 2, 4, AUDIO_F32LSB)
+SDL_AUDIO_KERNEL_FILTERS(F32ToS16, 4, 2, AUDIO_S16LSB)
+SDL_AUDIO_KERNEL_FILTERS(S32ToF32, 4, 4, AUDIO_F32LSB)
+SDL_AUDIO_KERNEL_FILTERS(F32ToS32, 4, 4, AUDIO_S32LSB)
+
+/* The vector filter (SSE2 or NEON), then the AVX2 one, for each pair */
+static const struct
+{
+    SDL_AudioFormat src_fmt;
+    SDL_AudioFormat dst_fmt;
+    SDL_AudioFilter vector;
+    SDL_AudioFilter avx2;
+} SDL_audio_kernel_filters[] = {
+    SDL_AUDIO_KERNEL_ENTRY(AUDIO_U8, AUDIO_S16LSB, U8ToS16),
+    SDL_AUDIO_KERNEL_ENTRY(AUDIO_S16LSB, AUDIO_U8, S16ToU8),
+    SDL_AUDIO_KERNEL_ENTRY(AUDIO_S16LSB, AUDIO_F32LSB, S16ToF32),
+    SDL_AUDIO_KERNEL_ENTRY(AUDIO_F32LSB, AUDIO_S16LSB, F32ToS16),
+    SDL_AUDIO_KERNEL_ENTRY(AUDIO_S32LSB, AUDIO_F32LSB, S32ToF32),
+    SDL_AUDIO_KERNEL_ENTRY(AUDIO_F32LSB, AUDIO_S32LSB, F32ToS32)
+};
+
+SDL_AudioFilter
+SDL_ChooseSIMDTypeCVT(SDL_AudioFormat src_fmt, SDL_AudioFormat dst_fmt)
+{
+    const char *hint = SDL_GetHint("SDL_AUDIO_SIMD");
+    int i;
+
+    if (hint && *hint == '0') {
+        return NULL;
+    }
+    for (i = 0; i < SDL_arraysize(SDL_audio_kernel_filters); ++i) {
+        if (SDL_audio_kernel_filters[i].src_fmt == src_fmt &&
+            SDL_audio_kernel_filters[i].dst_fmt == dst_fmt) {
+#ifdef SDL_AUDIOCVT_X86
+            if (SDL_HasAVX2()) {
+                return SDL_audio_kernel_filters[i].avx2;
+            }
+            if (!SDL_HasSSE2()) {
+                return NULL;
+            }
+#endif
+            return SDL_audio_kernel_filters[i].vector;
+        }
+    }
+    return NULL;
+}
+
+#else
+
+SDL_AudioFilter
+SDL_ChooseSIMDTypeCVT(SDL_AudioFormat src_fmt, SDL_AudioFormat dst_fmt)
+{
+    return NULL;
+}
+
+#endif /* SDL_AUDIOCVT_X86 || SDL_AUDIOCVT_NEON */
+
+/* vi: set ts=4 sw=4 expandtab: */
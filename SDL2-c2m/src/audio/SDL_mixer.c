@@ -26,6 +26,7 @@
 #include "SDL_timer.h"
 #include "SDL_audio.h"
 #include "SDL_sysaudio.h"
+#include "SDL_audio_c.h"
 
 /* This table is used to add two sound values together and pin
  * the value to avoid overflow.  (used with permission from ARDI)
@@ -94,6 +95,15 @@ SDL_MixAudioFormat(Uint8 * dst, const Uint8 * src, SDL_AudioFormat format,
         return;
     }
 
+    if (volume > 0 && volume <= SDL_MIX_MAXVOLUME) {
+        const SDL_MixKernel mix = SDL_ChooseSIMDMix(format);
+
+        if (mix) {
+            mix(dst, src, (int) (len / (SDL_AUDIO_BITSIZE(format) / 8)), volume);
+            return;
+        }
+    }
+
     switch (format) {
 
     case AUDIO_U8:
@@ -318,4 +328,202 @@ SDL_MixAudioFormat(Uint8 * dst, const Uint8 * src, SDL_AudioFormat format,
     }
 }
 
+/* SDL_MixAudioMany() sums this many samples of all the voices at a time */
+#define SDL_MIX_BLOCK 512
+
+/* Sint32s for 8 & 16-bit formats, doubles for 32-bit ones */
+typedef union
+{
+    Sint32 i[SDL_MIX_BLOCK];
+    double d[SDL_MIX_BLOCK];
+} SDL_MixSums;
+
+#define SDL_MIX_SAMPLES(type, buf, body) \
+    { \
+        const type *samples = (const type *) (buf); \
+        for (i = 0; i < count; ++i) { \
+            const type x = samples[i]; \
+            body; \
+        } \
+    }
+
+/* The sums start as the samples mixed into */
+static void
+SDL_LoadMixSums(SDL_MixSums * sums, const Uint8 * dst, SDL_AudioFormat format,
+                int count)
+{
+    int i;
+
+    switch (format) {
+    case AUDIO_U8:
+        SDL_MIX_SAMPLES(Uint8, dst, sums->i[i] = (int) x - 128);
+        break;
+    case AUDIO_S8:
+        SDL_MIX_SAMPLES(Sint8, dst, sums->i[i] = x);
+        break;
+    case AUDIO_S16LSB:
+        SDL_MIX_SAMPLES(Uint16, dst, sums->i[i] = (Sint16) SDL_SwapLE16(x));
+        break;
+    case AUDIO_S16MSB:
+        SDL_MIX_SAMPLES(Uint16, dst, sums->i[i] = (Sint16) SDL_SwapBE16(x));
+        break;
+    case AUDIO_S32LSB:
+        SDL_MIX_SAMPLES(Uint32, dst, sums->d[i] = (Sint32) SDL_SwapLE32(x));
+        break;
+    case AUDIO_S32MSB:
+        SDL_MIX_SAMPLES(Uint32, dst, sums->d[i] = (Sint32) SDL_SwapBE32(x));
+        break;
+    case AUDIO_F32LSB:
+        SDL_MIX_SAMPLES(float, dst, sums->d[i] = SDL_SwapFloatLE(x));
+        break;
+    case AUDIO_F32MSB:
+        SDL_MIX_SAMPLES(float, dst, sums->d[i] = SDL_SwapFloatBE(x));
+        break;
+    }
+}
+
+/* A voice's samples at its volume, adjusted as SDL_MixAudioFormat() does */
+static void
+SDL_AccumulateMixSums(SDL_MixSums * sums, const Uint8 * src,
+                      SDL_AudioFormat format, int count, int volume)
+{
+    const float fmaxvolume = 1.0f / ((float) SDL_MIX_MAXVOLUME);
+    const float fvolume = (float) volume;
+    int i;
+
+    switch (format) {
+    case AUDIO_U8:
+        SDL_MIX_SAMPLES(Uint8, src, sums->i[i] += (((int) x - 128) * volume) / SDL_MIX_MAXVOLUME);
+        break;
+    case AUDIO_S8:
+        SDL_MIX_SAMPLES(Sint8, src, sums->i[i] += (x * volume) / SDL_MIX_MAXVOLUME);
+        break;
+    case AUDIO_S16LSB:
+        SDL_MIX_SAMPLES(Uint16, src, sums->i[i] += ((Sint16) SDL_SwapLE16(x) * volume) / SDL_MIX_MAXVOLUME);
+        break;
+    case AUDIO_S16MSB:
+        SDL_MIX_SAMPLES(Uint16, src, sums->i[i] += ((Sint16) SDL_SwapBE16(x) * volume) / SDL_MIX_MAXVOLUME);
+        break;
+    case AUDIO_S32LSB:
+        SDL_MIX_SAMPLES(Uint32, src, sums->d[i] += (double) (((Sint64) (Sint32) SDL_SwapLE32(x) * volume) / SDL_MIX_MAXVOLUME));
+        break;
+    case AUDIO_S32MSB:
+        SDL_MIX_SAMPLES(Uint32, src, sums->d[i] += (double) (((Sint64) (Sint32) SDL_SwapBE32(x) * volume) / SDL_MIX_MAXVOLUME));
+        break;
+    case AUDIO_F32LSB:
+        SDL_MIX_SAMPLES(float, src, sums->d[i] += (double) ((SDL_SwapFloatLE(x) * fvolume) * fmaxvolume));
+        break;
+    case AUDIO_F32MSB:
+        SDL_MIX_SAMPLES(float, src, sums->d[i] += (double) ((SDL_SwapFloatBE(x) * fvolume) * fmaxvolume));
+        break;
+    }
+}
+
+/* The sums, clamped as SDL_MixAudioFormat() clamps, back over the samples */
+static void
+SDL_StoreMixSums(const SDL_MixSums * sums, Uint8 * dst, SDL_AudioFormat format,
+                 int count)
+{
+    /* !!! FIXME: are these right? (as SDL_MixAudioFormat()'s) */
+    const double max_audioval = 3.402823466e+38F;
+    const double min_audioval = -3.402823466e+38F;
+    int i;
+
+#define SDL_STORE_MIX_SUMS(type, sum, sum_type, lo, hi, expr) \
+    { \
+        type *samples = (type *) dst; \
+        for (i = 0; i < count; ++i) { \
+            const sum_type x = sums->sum[i]; \
+            const sum_type y = (x > (hi)) ? (hi) : (x < (lo)) ? (lo) : x; \
+            samples[i] = (expr); \
+        } \
+    }
+
+    switch (format) {
+    case AUDIO_U8:
+        SDL_STORE_MIX_SUMS(Uint8, i, Sint32, -128, 0xFE - 128, (Uint8) ((int) y + 128));
+        break;
+    case AUDIO_S8:
+        SDL_STORE_MIX_SUMS(Sint8, i, Sint32, -128, 127, (Sint8) y);
+        break;
+    case AUDIO_S16LSB:
+        SDL_STORE_MIX_SUMS(Uint16, i, Sint32, -32768, 32767, SDL_SwapLE16((Uint16) (Sint16) y));
+        break;
+    case AUDIO_S16MSB:
+        SDL_STORE_MIX_SUMS(Uint16, i, Sint32, -32768, 32767, SDL_SwapBE16((Uint16) (Sint16) y));
+        break;
+    case AUDIO_S32LSB:
+        SDL_STORE_MIX_SUMS(Uint32, d, double, -2147483648.0, 2147483647.0, SDL_SwapLE32((Uint32) (Sint32) y));
+        break;
+    case AUDIO_S32MSB:
+        SDL_STORE_MIX_SUMS(Uint32, d, double, -2147483648.0, 2147483647.0, SDL_SwapBE32((Uint32) (Sint32) y));
+        break;
+    case AUDIO_F32LSB:
+        SDL_STORE_MIX_SUMS(float, d, double, min_audioval, max_audioval, SDL_SwapFloatLE((float) y));
+        break;
+    case AUDIO_F32MSB:
+        SDL_STORE_MIX_SUMS(float, d, double, min_audioval, max_audioval, SDL_SwapFloatBE((float) y));
+        break;
+    }
+
+#undef SDL_STORE_MIX_SUMS
+}
+
+#undef SDL_MIX_SAMPLES
+
+void
+SDL_MixAudioMany(Uint8 * dst, const Uint8 * const * srcs, const int *volumes,
+                 int num_srcs, SDL_AudioFormat format, Uint32 len)
+{
+    SDL_MixSums sums;
+    SDL_MixManyKernel mix;
+    Uint32 samples, done;
+    int size, count, n;
+
+    switch (format) {
+    case AUDIO_U8:
+    case AUDIO_S8:
+    case AUDIO_S16LSB:
+    case AUDIO_S16MSB:
+    case AUDIO_S32LSB:
+    case AUDIO_S32MSB:
+    case AUDIO_F32LSB:
+    case AUDIO_F32MSB:
+        break;
+    default:
+        SDL_SetError("SDL_MixAudioMany(): unknown audio format");
+        return;
+    }
+
+    size = SDL_AUDIO_BITSIZE(format) / 8;
+    samples = len / size;
+
+    /* The vector mixes keep every voice's sums in registers */
+    mix = SDL_ChooseSIMDMixMany(format);
+    for (n = 0; mix && volumes && n < num_srcs; ++n) {
+        if (volumes[n] < 0 || volumes[n] > SDL_MIX_MAXVOLUME) {
+            mix = NULL;
+        }
+    }
+    if (mix) {
+        mix(dst, srcs, volumes, num_srcs, (int) samples);
+        return;
+    }
+
+    for (done = 0; done < samples; done += count) {
+        count = (int) SDL_min(samples - done, SDL_MIX_BLOCK);
+        SDL_LoadMixSums(&sums, dst + done * size, format, count);
+        for (n = 0; n < num_srcs; ++n) {
+            const int volume = volumes ? volumes[n] : SDL_MIX_MAXVOLUME;
+            const Uint8 *src = srcs[n] + done * size;
+
+            if (volume == 0) {
+                continue;
+            }
+            SDL_AccumulateMixSums(&sums, src, format, count, volume);
+        }
+        SDL_StoreMixSums(&sums, dst + done * size, format, count);
+    }
+}
+
 /* vi: set ts=4 sw=4 expandtab: */
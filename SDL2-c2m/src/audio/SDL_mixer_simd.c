@@ -0,0 +1,1052 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* SSE2, AVX2 & NEON versions of SDL_MixAudioFormat()'s mixing of U8, S8,
+   and native byte order S16, S32 & F32, and of SDL_MixAudioMany()'s of
+   S16, S32 & F32.  They give SDL_mixer.c's samples exactly: the
+   volume's applied as it does, truncating toward zero, and the sums are
+   saturated by the vectors' saturating adds, or clamped in doubles.
+   Setting the SDL_AUDIO_SIMD hint to 0 leaves SDL_mixer.c's, to compare
+   against. */
+
+#include "SDL_audio.h"
+#include "SDL_atomic.h"
+#include "SDL_hints.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_audio_c.h"
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN && defined(__GNUC__) && \
+    !defined(__clang_analyzer__) && (defined(__x86_64__) || defined(__i386__))
+#define SDL_MIXER_X86 1
+#include <immintrin.h>
+#elif SDL_BYTEORDER == SDL_LIL_ENDIAN && defined(__GNUC__) && \
+    !defined(__clang_analyzer__) && defined(__aarch64__)
+#define SDL_MIXER_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(SDL_MIXER_X86) || defined(SDL_MIXER_NEON)
+
+#define SDL_MIX_FMAX 3.402823466e+38F   /* as SDL_mixer.c clamps floats */
+
+/* The samples the vectors don't cover, as SDL_mixer.c mixes them */
+static SDL_INLINE Uint8
+SDL_MixU8(Uint8 dst, Uint8 src, int volume)
+{
+    const int sample = dst + (((int) src - 128) * volume) / SDL_MIX_MAXVOLUME;
+
+    return (Uint8) ((sample < 0) ? 0 : (sample > 0xFE) ? 0xFE : sample);
+}
+
+static SDL_INLINE Sint8
+SDL_MixS8(Sint8 dst, Sint8 src, int volume)
+{
+    const int sample = dst + (src * volume) / SDL_MIX_MAXVOLUME;
+
+    return (Sint8) ((sample < -128) ? -128 : (sample > 127) ? 127 : sample);
+}
+
+static SDL_INLINE Sint16
+SDL_MixS16(Sint16 dst, Sint16 src, int volume)
+{
+    const int sample = dst + (src * volume) / SDL_MIX_MAXVOLUME;
+
+    return (Sint16) ((sample < -32768) ? -32768 : (sample > 32767) ? 32767 : sample);
+}
+
+static SDL_INLINE Sint32
+SDL_MixS32(Sint32 dst, Sint32 src, int volume)
+{
+    const Sint64 sample = dst + ((Sint64) src * volume) / SDL_MIX_MAXVOLUME;
+
+    return (Sint32) ((sample < -2147483647 - 1) ? -2147483647 - 1 :
+                     (sample > 2147483647) ? 2147483647 : sample);
+}
+
+static SDL_INLINE float
+SDL_AdjustF32(float src, int volume)
+{
+    return (src * (float) volume) * (1.0f / ((float) SDL_MIX_MAXVOLUME));
+}
+
+static SDL_INLINE float
+SDL_MixF32(float dst, float src, int volume)
+{
+    double sample = ((double) SDL_AdjustF32(src, volume)) + ((double) dst);
+
+    if (sample > SDL_MIX_FMAX) {
+        sample = SDL_MIX_FMAX;
+    } else if (sample < -SDL_MIX_FMAX) {
+        sample = -SDL_MIX_FMAX;
+    }
+    return (float) sample;
+}
+
+/* A voice's volume, SDL_MIX_MAXVOLUME for all of them if there's no list */
+#define SDL_MIX_VOLUME(volumes, j) ((volumes) ? (volumes)[j] : SDL_MIX_MAXVOLUME)
+
+static SDL_INLINE Sint16
+SDL_MixManyS16(Sint16 dst, const Uint8 * const * srcs, const int *volumes,
+               int num_srcs, int i)
+{
+    int sample = dst, j;
+
+    for (j = 0; j < num_srcs; ++j) {
+        sample += (((const Sint16 *) srcs[j])[i] * SDL_MIX_VOLUME(volumes, j)) /
+            SDL_MIX_MAXVOLUME;
+    }
+    return (Sint16) ((sample < -32768) ? -32768 : (sample > 32767) ? 32767 : sample);
+}
+
+static SDL_INLINE Sint32
+SDL_MixManyS32(Sint32 dst, const Uint8 * const * srcs, const int *volumes,
+               int num_srcs, int i)
+{
+    double sample = dst;
+    int j;
+
+    for (j = 0; j < num_srcs; ++j) {
+        sample += (double) (((Sint64) ((const Sint32 *) srcs[j])[i] *
+                             SDL_MIX_VOLUME(volumes, j)) / SDL_MIX_MAXVOLUME);
+    }
+    return (Sint32) ((sample < -2147483648.0) ? -2147483648.0 :
+                     (sample > 2147483647.0) ? 2147483647.0 : sample);
+}
+
+static SDL_INLINE float
+SDL_MixManyF32(float dst, const Uint8 * const * srcs, const int *volumes,
+               int num_srcs, int i)
+{
+    double sample = dst;
+    int j;
+
+    for (j = 0; j < num_srcs; ++j) {
+        const int volume = SDL_MIX_VOLUME(volumes, j);
+
+        if (volume) {
+            sample += (double) SDL_AdjustF32(((const float *) srcs[j])[i], volume);
+        }
+    }
+    if (sample > SDL_MIX_FMAX) {
+        sample = SDL_MIX_FMAX;
+    } else if (sample < -SDL_MIX_FMAX) {
+        sample = -SDL_MIX_FMAX;
+    }
+    return (float) sample;
+}
+
+#ifdef SDL_MIXER_X86
+
+/* x / 128, truncated toward zero as C divides */
+#define SDL_DIV128_EPI16(x) \
+    _mm_srai_epi16(_mm_add_epi16(x, _mm_srli_epi16(_mm_srai_epi16(x, 15), 9)), 7)
+#define SDL_DIV128_EPI32(x) \
+    _mm_srai_epi32(_mm_add_epi32(x, _mm_srli_epi32(_mm_srai_epi32(x, 31), 25)), 7)
+#define SDL_DIV128_EPI16_256(x) \
+    _mm256_srai_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(_mm256_srai_epi16(x, 15), 9)), 7)
+#define SDL_DIV128_EPI32_256(x) \
+    _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(_mm256_srai_epi32(x, 31), 25)), 7)
+
+/* Sixteen signed bytes times the volume, / 128, as 16-bit lanes */
+#define SDL_ADJUST_EPI8(v, vol, lo, hi) \
+    { \
+        lo = _mm_mullo_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8), vol); \
+        hi = _mm_mullo_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8), vol); \
+        lo = SDL_DIV128_EPI16(lo); \
+        hi = SDL_DIV128_EPI16(hi); \
+    }
+
+/* Eight samples times the volume, / 128, as 32-bit lanes */
+#define SDL_ADJUST_EPI16(v, vol, lo, hi) \
+    { \
+        const __m128i plo = _mm_mullo_epi16(v, vol); \
+        const __m128i phi = _mm_mulhi_epi16(v, vol); \
+        lo = SDL_DIV128_EPI32(_mm_unpacklo_epi16(plo, phi)); \
+        hi = SDL_DIV128_EPI32(_mm_unpackhi_epi16(plo, phi)); \
+    }
+
+static void
+SDL_MixU8SSE2(Uint8 * dst, const Uint8 * src, int samples, int volume)
+    __attribute__((target("sse2")));
+static void
+SDL_MixU8SSE2(Uint8 * dst, const Uint8 * src, int samples, int volume)
+{
+    const __m128i flip = _mm_set1_epi8((char) 0x80);
+    const __m128i vol = _mm_set1_epi16((short) volume);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i top = _mm_set1_epi16(0xFE);
+    int i;
+
+    for (i = 0; i + 16 <= samples; i += 16) {
+        const __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (src + i)), flip);
+        const __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i lo, hi;
+
+        SDL_ADJUST_EPI8(v, vol, lo, hi);
+        lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(d, zero));
+        hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(d, zero));
+        lo = _mm_min_epi16(_mm_max_epi16(lo, zero), top);
+        hi = _mm_min_epi16(_mm_max_epi16(hi, zero), top);
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(lo, hi));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixU8(dst[i], src[i], volume);
+    }
+}
+
+static void
+SDL_MixS8SSE2(Uint8 * dst, const Uint8 * src, int samples, int volume)
+    __attribute__((target("sse2")));
+static void
+SDL_MixS8SSE2(Uint8 * dst, const Uint8 * src, int samples, int volume)
+{
+    const __m128i vol = _mm_set1_epi16((short) volume);
+    int i;
+
+    for (i = 0; i + 16 <= samples; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        const __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i lo, hi;
+
+        SDL_ADJUST_EPI8(v, vol, lo, hi);
+        _mm_storeu_si128((__m128i *) (dst + i),
+                         _mm_adds_epi8(d, _mm_packs_epi16(lo, hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = (Uint8) SDL_MixS8((Sint8) dst[i], (Sint8) src[i], volume);
+    }
+}
+
+static void
+SDL_MixS16SSE2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+    __attribute__((target("sse2")));
+static void
+SDL_MixS16SSE2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+{
+    const __m128i vol = _mm_set1_epi16((short) volume);
+    const Sint16 *src = (const Sint16 *) src8;
+    Sint16 *dst = (Sint16 *) dst8;
+    int i;
+
+    for (i = 0; i + 8 <= samples; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        const __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i lo, hi;
+
+        SDL_ADJUST_EPI16(v, vol, lo, hi);
+        _mm_storeu_si128((__m128i *) (dst + i),
+                         _mm_adds_epi16(d, _mm_packs_epi32(lo, hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixS16(dst[i], src[i], volume);
+    }
+}
+
+/* In doubles, which hold the products & sums exactly */
+static void
+SDL_MixS32SSE2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+    __attribute__((target("sse2")));
+static void
+SDL_MixS32SSE2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+{
+    const __m128d vol = _mm_set1_pd((double) volume / SDL_MIX_MAXVOLUME);
+    const __m128d top = _mm_set1_pd(2147483647.0);
+    const __m128d bottom = _mm_set1_pd(-2147483648.0);
+    const Sint32 *src = (const Sint32 *) src8;
+    Sint32 *dst = (Sint32 *) dst8;
+    int i;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        const __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        const __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128d lo = _mm_mul_pd(_mm_cvtepi32_pd(v), vol);
+        __m128d hi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), vol);
+
+        lo = _mm_cvtepi32_pd(_mm_cvttpd_epi32(lo));
+        hi = _mm_cvtepi32_pd(_mm_cvttpd_epi32(hi));
+        lo = _mm_add_pd(lo, _mm_cvtepi32_pd(d));
+        hi = _mm_add_pd(hi, _mm_cvtepi32_pd(_mm_srli_si128(d, 8)));
+        lo = _mm_max_pd(_mm_min_pd(lo, top), bottom);
+        hi = _mm_max_pd(_mm_min_pd(hi, top), bottom);
+        _mm_storeu_si128((__m128i *) (dst + i),
+                         _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo),
+                                            _mm_cvttpd_epi32(hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixS32(dst[i], src[i], volume);
+    }
+}
+
+/* Summed in doubles, as SDL_mixer.c does; the clamp's operands are in the
+   order that lets NaN through, as its comparisons do */
+static void
+SDL_MixF32SSE2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+    __attribute__((target("sse2")));
+static void
+SDL_MixF32SSE2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+{
+    const __m128 vol = _mm_set1_ps((float) volume);
+    const __m128 scale = _mm_set1_ps(1.0f / ((float) SDL_MIX_MAXVOLUME));
+    const __m128d top = _mm_set1_pd(SDL_MIX_FMAX);
+    const __m128d bottom = _mm_set1_pd(-SDL_MIX_FMAX);
+    const float *src = (const float *) src8;
+    float *dst = (float *) dst8;
+    int i;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        const __m128 v = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(src + i), vol), scale);
+        const __m128 d = _mm_loadu_ps(dst + i);
+        __m128d lo = _mm_add_pd(_mm_cvtps_pd(v), _mm_cvtps_pd(d));
+        __m128d hi = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)),
+                                _mm_cvtps_pd(_mm_movehl_ps(d, d)));
+
+        lo = _mm_max_pd(bottom, _mm_min_pd(top, lo));
+        hi = _mm_max_pd(bottom, _mm_min_pd(top, hi));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixF32(dst[i], src[i], volume);
+    }
+}
+
+/* The mixes of many voices: a vector of each voice is added to the sums of
+   a vector of dst, kept in registers, then clamped as one */
+
+static void
+SDL_MixManyS16SSE2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+    __attribute__((target("sse2")));
+static void
+SDL_MixManyS16SSE2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+{
+    Sint16 *dst = (Sint16 *) dst8;
+    int i, j;
+
+    for (i = 0; i + 8 <= samples; i += 8) {
+        const __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16);
+
+        for (j = 0; j < num_srcs; ++j) {
+            const int volume = SDL_MIX_VOLUME(volumes, j);
+            const __m128i vol = _mm_set1_epi16((short) volume);
+            const __m128i v = _mm_loadu_si128((const __m128i *) (srcs[j] + i * 2));
+            __m128i xlo, xhi;
+
+            if (volume) {
+                SDL_ADJUST_EPI16(v, vol, xlo, xhi);
+                lo = _mm_add_epi32(lo, xlo);
+                hi = _mm_add_epi32(hi, xhi);
+            }
+        }
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_packs_epi32(lo, hi));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixManyS16(dst[i], srcs, volumes, num_srcs, i);
+    }
+}
+
+static void
+SDL_MixManyS32SSE2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+    __attribute__((target("sse2")));
+static void
+SDL_MixManyS32SSE2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+{
+    const __m128d top = _mm_set1_pd(2147483647.0);
+    const __m128d bottom = _mm_set1_pd(-2147483648.0);
+    Sint32 *dst = (Sint32 *) dst8;
+    int i, j;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        const __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128d lo = _mm_cvtepi32_pd(d);
+        __m128d hi = _mm_cvtepi32_pd(_mm_srli_si128(d, 8));
+
+        for (j = 0; j < num_srcs; ++j) {
+            const __m128d vol = _mm_set1_pd((double) SDL_MIX_VOLUME(volumes, j) /
+                                            SDL_MIX_MAXVOLUME);
+            const __m128i v = _mm_loadu_si128((const __m128i *) (srcs[j] + i * 4));
+            const __m128d xlo = _mm_mul_pd(_mm_cvtepi32_pd(v), vol);
+            const __m128d xhi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), vol);
+
+            lo = _mm_add_pd(lo, _mm_cvtepi32_pd(_mm_cvttpd_epi32(xlo)));
+            hi = _mm_add_pd(hi, _mm_cvtepi32_pd(_mm_cvttpd_epi32(xhi)));
+        }
+        lo = _mm_max_pd(_mm_min_pd(lo, top), bottom);
+        hi = _mm_max_pd(_mm_min_pd(hi, top), bottom);
+        _mm_storeu_si128((__m128i *) (dst + i),
+                         _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo),
+                                            _mm_cvttpd_epi32(hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixManyS32(dst[i], srcs, volumes, num_srcs, i);
+    }
+}
+
+static void
+SDL_MixManyF32SSE2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+    __attribute__((target("sse2")));
+static void
+SDL_MixManyF32SSE2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+{
+    const __m128 scale = _mm_set1_ps(1.0f / ((float) SDL_MIX_MAXVOLUME));
+    const __m128d top = _mm_set1_pd(SDL_MIX_FMAX);
+    const __m128d bottom = _mm_set1_pd(-SDL_MIX_FMAX);
+    float *dst = (float *) dst8;
+    int i, j;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        const __m128 d = _mm_loadu_ps(dst + i);
+        __m128d lo = _mm_cvtps_pd(d);
+        __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(d, d));
+
+        for (j = 0; j < num_srcs; ++j) {
+            const int volume = SDL_MIX_VOLUME(volumes, j);
+            const __m128 vol = _mm_set1_ps((float) volume);
+            __m128 v;
+
+            if (volume) {
+                v = _mm_loadu_ps((const float *) srcs[j] + i);
+                v = _mm_mul_ps(_mm_mul_ps(v, vol), scale);
+                lo = _mm_add_pd(lo, _mm_cvtps_pd(v));
+                hi = _mm_add_pd(hi, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+            }
+        }
+        lo = _mm_max_pd(bottom, _mm_min_pd(top, lo));
+        hi = _mm_max_pd(bottom, _mm_min_pd(top, hi));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixManyF32(dst[i], srcs, volumes, num_srcs, i);
+    }
+}
+
+/* The AVX2 ones: the unpacks & packs are both per 128-bit lane, so undo
+   each other's order */
+
+#define SDL_ADJUST_EPI8_256(v, vol, lo, hi) \
+    { \
+        lo = _mm256_mullo_epi16(_mm256_srai_epi16(_mm256_unpacklo_epi8(v, v), 8), vol); \
+        hi = _mm256_mullo_epi16(_mm256_srai_epi16(_mm256_unpackhi_epi8(v, v), 8), vol); \
+        lo = SDL_DIV128_EPI16_256(lo); \
+        hi = SDL_DIV128_EPI16_256(hi); \
+    }
+
+#define SDL_ADJUST_EPI16_256(v, vol, lo, hi) \
+    { \
+        const __m256i plo = _mm256_mullo_epi16(v, vol); \
+        const __m256i phi = _mm256_mulhi_epi16(v, vol); \
+        lo = SDL_DIV128_EPI32_256(_mm256_unpacklo_epi16(plo, phi)); \
+        hi = SDL_DIV128_EPI32_256(_mm256_unpackhi_epi16(plo, phi)); \
+    }
+
+static void
+SDL_MixU8AVX2(Uint8 * dst, const Uint8 * src, int samples, int volume)
+    __attribute__((target("avx2")));
+static void
+SDL_MixU8AVX2(Uint8 * dst, const Uint8 * src, int samples, int volume)
+{
+    const __m256i flip = _mm256_set1_epi8((char) 0x80);
+    const __m256i vol = _mm256_set1_epi16((short) volume);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i top = _mm256_set1_epi16(0xFE);
+    int i;
+
+    for (i = 0; i + 32 <= samples; i += 32) {
+        const __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (src + i)), flip);
+        const __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        __m256i lo, hi;
+
+        SDL_ADJUST_EPI8_256(v, vol, lo, hi);
+        lo = _mm256_add_epi16(lo, _mm256_unpacklo_epi8(d, zero));
+        hi = _mm256_add_epi16(hi, _mm256_unpackhi_epi8(d, zero));
+        lo = _mm256_min_epi16(_mm256_max_epi16(lo, zero), top);
+        hi = _mm256_min_epi16(_mm256_max_epi16(hi, zero), top);
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixU8(dst[i], src[i], volume);
+    }
+}
+
+static void
+SDL_MixS8AVX2(Uint8 * dst, const Uint8 * src, int samples, int volume)
+    __attribute__((target("avx2")));
+static void
+SDL_MixS8AVX2(Uint8 * dst, const Uint8 * src, int samples, int volume)
+{
+    const __m256i vol = _mm256_set1_epi16((short) volume);
+    int i;
+
+    for (i = 0; i + 32 <= samples; i += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+        const __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        __m256i lo, hi;
+
+        SDL_ADJUST_EPI8_256(v, vol, lo, hi);
+        _mm256_storeu_si256((__m256i *) (dst + i),
+                            _mm256_adds_epi8(d, _mm256_packs_epi16(lo, hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = (Uint8) SDL_MixS8((Sint8) dst[i], (Sint8) src[i], volume);
+    }
+}
+
+static void
+SDL_MixS16AVX2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+    __attribute__((target("avx2")));
+static void
+SDL_MixS16AVX2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+{
+    const __m256i vol = _mm256_set1_epi16((short) volume);
+    const Sint16 *src = (const Sint16 *) src8;
+    Sint16 *dst = (Sint16 *) dst8;
+    int i;
+
+    for (i = 0; i + 16 <= samples; i += 16) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+        const __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        __m256i lo, hi;
+
+        SDL_ADJUST_EPI16_256(v, vol, lo, hi);
+        _mm256_storeu_si256((__m256i *) (dst + i),
+                            _mm256_adds_epi16(d, _mm256_packs_epi32(lo, hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixS16(dst[i], src[i], volume);
+    }
+}
+
+static void
+SDL_MixS32AVX2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+    __attribute__((target("avx2")));
+static void
+SDL_MixS32AVX2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+{
+    const __m256d vol = _mm256_set1_pd((double) volume / SDL_MIX_MAXVOLUME);
+    const __m256d top = _mm256_set1_pd(2147483647.0);
+    const __m256d bottom = _mm256_set1_pd(-2147483648.0);
+    const Sint32 *src = (const Sint32 *) src8;
+    Sint32 *dst = (Sint32 *) dst8;
+    int i;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        const __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        const __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m256d x = _mm256_mul_pd(_mm256_cvtepi32_pd(v), vol);
+
+        x = _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(x));
+        x = _mm256_add_pd(x, _mm256_cvtepi32_pd(d));
+        x = _mm256_max_pd(_mm256_min_pd(x, top), bottom);
+        _mm_storeu_si128((__m128i *) (dst + i), _mm256_cvttpd_epi32(x));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixS32(dst[i], src[i], volume);
+    }
+}
+
+static void
+SDL_MixF32AVX2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+    __attribute__((target("avx2")));
+static void
+SDL_MixF32AVX2(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+{
+    const __m128 vol = _mm_set1_ps((float) volume);
+    const __m128 scale = _mm_set1_ps(1.0f / ((float) SDL_MIX_MAXVOLUME));
+    const __m256d top = _mm256_set1_pd(SDL_MIX_FMAX);
+    const __m256d bottom = _mm256_set1_pd(-SDL_MIX_FMAX);
+    const float *src = (const float *) src8;
+    float *dst = (float *) dst8;
+    int i;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        const __m128 v = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(src + i), vol), scale);
+        __m256d x = _mm256_add_pd(_mm256_cvtps_pd(v),
+                                  _mm256_cvtps_pd(_mm_loadu_ps(dst + i)));
+
+        x = _mm256_max_pd(bottom, _mm256_min_pd(top, x));
+        _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(x));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixF32(dst[i], src[i], volume);
+    }
+}
+
+static void
+SDL_MixManyS16AVX2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+    __attribute__((target("avx2")));
+static void
+SDL_MixManyS16AVX2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+{
+    Sint16 *dst = (Sint16 *) dst8;
+    int i, j;
+
+    for (i = 0; i + 16 <= samples; i += 16) {
+        /* As SDL_ADJUST_EPI16_256 unpacks, within each 128-bit lane */
+        const __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        __m256i lo = _mm256_srai_epi32(_mm256_unpacklo_epi16(d, d), 16);
+        __m256i hi = _mm256_srai_epi32(_mm256_unpackhi_epi16(d, d), 16);
+
+        for (j = 0; j < num_srcs; ++j) {
+            const int volume = SDL_MIX_VOLUME(volumes, j);
+            const __m256i vol = _mm256_set1_epi16((short) volume);
+            const __m256i v = _mm256_loadu_si256((const __m256i *) (srcs[j] + i * 2));
+            __m256i xlo, xhi;
+
+            if (volume) {
+                SDL_ADJUST_EPI16_256(v, vol, xlo, xhi);
+                lo = _mm256_add_epi32(lo, xlo);
+                hi = _mm256_add_epi32(hi, xhi);
+            }
+        }
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_packs_epi32(lo, hi));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixManyS16(dst[i], srcs, volumes, num_srcs, i);
+    }
+}
+
+static void
+SDL_MixManyS32AVX2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+    __attribute__((target("avx2")));
+static void
+SDL_MixManyS32AVX2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+{
+    const __m256d top = _mm256_set1_pd(2147483647.0);
+    const __m256d bottom = _mm256_set1_pd(-2147483648.0);
+    Sint32 *dst = (Sint32 *) dst8;
+    int i, j;
+
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m256d lo = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *) (dst + i)));
+        __m256d hi = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *) (dst + i + 4)));
+
+        for (j = 0; j < num_srcs; ++j) {
+            const __m256d vol = _mm256_set1_pd((double) SDL_MIX_VOLUME(volumes, j) /
+                                               SDL_MIX_MAXVOLUME);
+            const Sint32 *src = (const Sint32 *) srcs[j] + i;
+            const __m256d xlo = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *) src)), vol);
+            const __m256d xhi = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *) (src + 4))), vol);
+
+            lo = _mm256_add_pd(lo, _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(xlo)));
+            hi = _mm256_add_pd(hi, _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(xhi)));
+        }
+        lo = _mm256_max_pd(_mm256_min_pd(lo, top), bottom);
+        hi = _mm256_max_pd(_mm256_min_pd(hi, top), bottom);
+        _mm_storeu_si128((__m128i *) (dst + i), _mm256_cvttpd_epi32(lo));
+        _mm_storeu_si128((__m128i *) (dst + i + 4), _mm256_cvttpd_epi32(hi));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixManyS32(dst[i], srcs, volumes, num_srcs, i);
+    }
+}
+
+static void
+SDL_MixManyF32AVX2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+    __attribute__((target("avx2")));
+static void
+SDL_MixManyF32AVX2(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+{
+    const __m256 scale = _mm256_set1_ps(1.0f / ((float) SDL_MIX_MAXVOLUME));
+    const __m256d top = _mm256_set1_pd(SDL_MIX_FMAX);
+    const __m256d bottom = _mm256_set1_pd(-SDL_MIX_FMAX);
+    float *dst = (float *) dst8;
+    int i, j;
+
+    for (i = 0; i + 8 <= samples; i += 8) {
+        __m256d lo = _mm256_cvtps_pd(_mm_loadu_ps(dst + i));
+        __m256d hi = _mm256_cvtps_pd(_mm_loadu_ps(dst + i + 4));
+
+        for (j = 0; j < num_srcs; ++j) {
+            const int volume = SDL_MIX_VOLUME(volumes, j);
+            const __m256 vol = _mm256_set1_ps((float) volume);
+            __m256 v;
+
+            if (volume) {
+                v = _mm256_loadu_ps((const float *) srcs[j] + i);
+                v = _mm256_mul_ps(_mm256_mul_ps(v, vol), scale);
+                lo = _mm256_add_pd(lo, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+                hi = _mm256_add_pd(hi, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+            }
+        }
+        lo = _mm256_max_pd(bottom, _mm256_min_pd(top, lo));
+        hi = _mm256_max_pd(bottom, _mm256_min_pd(top, hi));
+        _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(lo));
+        _mm_storeu_ps(dst + i + 4, _mm256_cvtpd_ps(hi));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixManyF32(dst[i], srcs, volumes, num_srcs, i);
+    }
+}
+
+#endif /* SDL_MIXER_X86 */
+
+#ifdef SDL_MIXER_NEON
+
+/* x / 128, truncated toward zero as C divides */
+#define SDL_DIV128_S16(x) \
+    vshrq_n_s16(vaddq_s16(x, vreinterpretq_s16_u16(vshrq_n_u16(vreinterpretq_u16_s16(vshrq_n_s16(x, 15)), 9))), 7)
+#define SDL_DIV128_S32(x) \
+    vshrq_n_s32(vaddq_s32(x, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(x, 31)), 25))), 7)
+#define SDL_DIV128_S64(x) \
+    vshrq_n_s64(vaddq_s64(x, vreinterpretq_s64_u64(vshrq_n_u64(vreinterpretq_u64_s64(vshrq_n_s64(x, 63)), 57))), 7)
+
+static void
+SDL_MixU8NEON(Uint8 * dst, const Uint8 * src, int samples, int volume)
+{
+    const int16x8_t vol = vdupq_n_s16((int16_t) volume);
+    const int16x8_t top = vdupq_n_s16(0xFE);
+    const int16x8_t zero = vdupq_n_s16(0);
+    int i;
+
+    for (i = 0; i + 16 <= samples; i += 16) {
+        const int8x16_t v = vreinterpretq_s8_u8(veorq_u8(vld1q_u8(src + i), vdupq_n_u8(0x80)));
+        const uint8x16_t d = vld1q_u8(dst + i);
+        int16x8_t lo = SDL_DIV128_S16(vmulq_s16(vmovl_s8(vget_low_s8(v)), vol));
+        int16x8_t hi = SDL_DIV128_S16(vmulq_s16(vmovl_s8(vget_high_s8(v)), vol));
+
+        lo = vaddq_s16(lo, vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(d))));
+        hi = vaddq_s16(hi, vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(d))));
+        lo = vminq_s16(vmaxq_s16(lo, zero), top);
+        hi = vminq_s16(vmaxq_s16(hi, zero), top);
+        vst1q_u8(dst + i, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixU8(dst[i], src[i], volume);
+    }
+}
+
+static void
+SDL_MixS8NEON(Uint8 * dst, const Uint8 * src, int samples, int volume)
+{
+    const int16x8_t vol = vdupq_n_s16((int16_t) volume);
+    int i;
+
+    for (i = 0; i + 16 <= samples; i += 16) {
+        const int8x16_t v = vld1q_s8((const int8_t *) (src + i));
+        const int8x16_t d = vld1q_s8((const int8_t *) (dst + i));
+        const int16x8_t lo = SDL_DIV128_S16(vmulq_s16(vmovl_s8(vget_low_s8(v)), vol));
+        const int16x8_t hi = SDL_DIV128_S16(vmulq_s16(vmovl_s8(vget_high_s8(v)), vol));
+
+        vst1q_s8((int8_t *) (dst + i),
+                 vqaddq_s8(d, vcombine_s8(vqmovn_s16(lo), vqmovn_s16(hi))));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = (Uint8) SDL_MixS8((Sint8) dst[i], (Sint8) src[i], volume);
+    }
+}
+
+static void
+SDL_MixS16NEON(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+{
+    const int16x4_t vol = vdup_n_s16((int16_t) volume);
+    const Sint16 *src = (const Sint16 *) src8;
+    Sint16 *dst = (Sint16 *) dst8;
+    int i;
+
+    for (i = 0; i + 8 <= samples; i += 8) {
+        const int16x8_t v = vld1q_s16(src + i);
+        const int32x4_t lo = SDL_DIV128_S32(vmull_s16(vget_low_s16(v), vol));
+        const int32x4_t hi = SDL_DIV128_S32(vmull_s16(vget_high_s16(v), vol));
+
+        vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i),
+                                      vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi))));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixS16(dst[i], src[i], volume);
+    }
+}
+
+static void
+SDL_MixS32NEON(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+{
+    const int32x2_t vol = vdup_n_s32(volume);
+    const Sint32 *src = (const Sint32 *) src8;
+    Sint32 *dst = (Sint32 *) dst8;
+    int i;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        const int32x4_t v = vld1q_s32(src + i);
+        const int64x2_t lo = SDL_DIV128_S64(vmull_s32(vget_low_s32(v), vol));
+        const int64x2_t hi = SDL_DIV128_S64(vmull_s32(vget_high_s32(v), vol));
+
+        vst1q_s32(dst + i, vqaddq_s32(vld1q_s32(dst + i),
+                                      vcombine_s32(vmovn_s64(lo), vmovn_s64(hi))));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixS32(dst[i], src[i], volume);
+    }
+}
+
+static void
+SDL_MixF32NEON(Uint8 * dst8, const Uint8 * src8, int samples, int volume)
+{
+    const float32x4_t vol = vdupq_n_f32((float) volume);
+    const float32x4_t scale = vdupq_n_f32(1.0f / ((float) SDL_MIX_MAXVOLUME));
+    const float64x2_t top = vdupq_n_f64(SDL_MIX_FMAX);
+    const float64x2_t bottom = vdupq_n_f64(-SDL_MIX_FMAX);
+    const float *src = (const float *) src8;
+    float *dst = (float *) dst8;
+    int i;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        const float32x4_t v = vmulq_f32(vmulq_f32(vld1q_f32(src + i), vol), scale);
+        const float32x4_t d = vld1q_f32(dst + i);
+        float64x2_t lo = vaddq_f64(vcvt_f64_f32(vget_low_f32(v)),
+                                   vcvt_f64_f32(vget_low_f32(d)));
+        float64x2_t hi = vaddq_f64(vcvt_high_f64_f32(v), vcvt_high_f64_f32(d));
+
+        /* NaN comes through these, as SDL_mixer.c's comparisons let it */
+        lo = vmaxq_f64(vminq_f64(lo, top), bottom);
+        hi = vmaxq_f64(vminq_f64(hi, top), bottom);
+        vst1q_f32(dst + i, vcvt_high_f32_f64(vcvt_f32_f64(lo), hi));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixF32(dst[i], src[i], volume);
+    }
+}
+
+static void
+SDL_MixManyS16NEON(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+{
+    Sint16 *dst = (Sint16 *) dst8;
+    int i, j;
+
+    for (i = 0; i + 8 <= samples; i += 8) {
+        const int16x8_t d = vld1q_s16(dst + i);
+        int32x4_t lo = vmovl_s16(vget_low_s16(d));
+        int32x4_t hi = vmovl_s16(vget_high_s16(d));
+
+        for (j = 0; j < num_srcs; ++j) {
+            const int16x4_t vol = vdup_n_s16((int16_t) SDL_MIX_VOLUME(volumes, j));
+            const int16x8_t v = vld1q_s16((const Sint16 *) srcs[j] + i);
+
+            lo = vaddq_s32(lo, SDL_DIV128_S32(vmull_s16(vget_low_s16(v), vol)));
+            hi = vaddq_s32(hi, SDL_DIV128_S32(vmull_s16(vget_high_s16(v), vol)));
+        }
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixManyS16(dst[i], srcs, volumes, num_srcs, i);
+    }
+}
+
+static void
+SDL_MixManyS32NEON(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+{
+    const float64x2_t top = vdupq_n_f64(2147483647.0);
+    const float64x2_t bottom = vdupq_n_f64(-2147483648.0);
+    Sint32 *dst = (Sint32 *) dst8;
+    int i, j;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        const int32x4_t d = vld1q_s32(dst + i);
+        float64x2_t lo = vcvtq_f64_s64(vmovl_s32(vget_low_s32(d)));
+        float64x2_t hi = vcvtq_f64_s64(vmovl_s32(vget_high_s32(d)));
+
+        for (j = 0; j < num_srcs; ++j) {
+            const int32x2_t vol = vdup_n_s32(SDL_MIX_VOLUME(volumes, j));
+            const int32x4_t v = vld1q_s32((const Sint32 *) srcs[j] + i);
+
+            lo = vaddq_f64(lo, vcvtq_f64_s64(SDL_DIV128_S64(vmull_s32(vget_low_s32(v), vol))));
+            hi = vaddq_f64(hi, vcvtq_f64_s64(SDL_DIV128_S64(vmull_s32(vget_high_s32(v), vol))));
+        }
+        lo = vmaxq_f64(vminq_f64(lo, top), bottom);
+        hi = vmaxq_f64(vminq_f64(hi, top), bottom);
+        vst1q_s32(dst + i, vcombine_s32(vmovn_s64(vcvtq_s64_f64(lo)),
+                                        vmovn_s64(vcvtq_s64_f64(hi))));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixManyS32(dst[i], srcs, volumes, num_srcs, i);
+    }
+}
+
+static void
+SDL_MixManyF32NEON(Uint8 * dst8, const Uint8 * const * srcs,
+                   const int *volumes, int num_srcs, int samples)
+{
+    const float32x4_t scale = vdupq_n_f32(1.0f / ((float) SDL_MIX_MAXVOLUME));
+    const float64x2_t top = vdupq_n_f64(SDL_MIX_FMAX);
+    const float64x2_t bottom = vdupq_n_f64(-SDL_MIX_FMAX);
+    float *dst = (float *) dst8;
+    int i, j;
+
+    for (i = 0; i + 4 <= samples; i += 4) {
+        const float32x4_t d = vld1q_f32(dst + i);
+        float64x2_t lo = vcvt_f64_f32(vget_low_f32(d));
+        float64x2_t hi = vcvt_high_f64_f32(d);
+
+        for (j = 0; j < num_srcs; ++j) {
+            const int volume = SDL_MIX_VOLUME(volumes, j);
+            float32x4_t v;
+
+            if (volume) {
+                v = vmulq_f32(vmulq_n_f32(vld1q_f32((const float *) srcs[j] + i),
+                                          (float) volume), scale);
+                lo = vaddq_f64(lo, vcvt_f64_f32(vget_low_f32(v)));
+                hi = vaddq_f64(hi, vcvt_high_f64_f32(v));
+            }
+        }
+        lo = vmaxq_f64(vminq_f64(lo, top), bottom);
+        hi = vmaxq_f64(vminq_f64(hi, top), bottom);
+        vst1q_f32(dst + i, vcvt_high_f32_f64(vcvt_f32_f64(lo), hi));
+    }
+    for (; i < samples; ++i) {
+        dst[i] = SDL_MixManyF32(dst[i], srcs, volumes, num_srcs, i);
+    }
+}
+
+#endif /* SDL_MIXER_NEON */
+
+#ifdef SDL_MIXER_X86
+#define SDL_MIX_KERNEL_ENTRY(format, name) \
+    { format, SDL_Mix##name##SSE2, SDL_Mix##name##AVX2 }
+#define SDL_MIX_MANY_ENTRY(format, name) \
+    { format, SDL_MixMany##name##SSE2, SDL_MixMany##name##AVX2 }
+#else
+#define SDL_MIX_KERNEL_ENTRY(format, name) \
+    { format, SDL_Mix##name##NEON, NULL }
+#define SDL_MIX_MANY_ENTRY(format, name) \
+    { format, SDL_MixMany##name##NEON, NULL }
+#endif
+
+/* The vector kernel (SSE2 or NEON), then the AVX2 one, for each format */
+static const struct
+{
+    SDL_AudioFormat format;
+    SDL_MixKernel vector;
+    SDL_MixKernel avx2;
+} SDL_mix_kernels[] = {
+    SDL_MIX_KERNEL_ENTRY(AUDIO_U8, U8),
+    SDL_MIX_KERNEL_ENTRY(AUDIO_S8, S8),
+    SDL_MIX_KERNEL_ENTRY(AUDIO_S16LSB, S16),
+    SDL_MIX_KERNEL_ENTRY(AUDIO_S32LSB, S32),
+    SDL_MIX_KERNEL_ENTRY(AUDIO_F32LSB, F32)
+};
+
+static const struct
+{
+    SDL_AudioFormat format;
+    SDL_MixManyKernel vector;
+    SDL_MixManyKernel avx2;
+} SDL_mix_many_kernels[] = {
+    SDL_MIX_MANY_ENTRY(AUDIO_S16LSB, S16),
+    SDL_MIX_MANY_ENTRY(AUDIO_S32LSB, S32),
+    SDL_MIX_MANY_ENTRY(AUDIO_F32LSB, F32)
+};
+
+/* Mixing's done too often to look the hint up each time, so it's watched */
+static SDL_SpinLock SDL_mix_simd_lock;
+static SDL_bool SDL_mix_simd_watched = SDL_FALSE;
+static SDL_bool SDL_mix_simd = SDL_TRUE;
+
+static void SDLCALL
+SDL_MixSIMDChanged(void *userdata, const char *name, const char *oldValue,
+                   const char *hint)
+{
+    SDL_mix_simd = (hint && *hint == '0') ? SDL_FALSE : SDL_TRUE;
+}
+
+/* 0 for the vector function, 1 for the AVX2 one, or -1 for neither */
+static int
+SDL_ChooseMixSIMD(void)
+{
+    if (!SDL_mix_simd_watched) {
+        SDL_AtomicLock(&SDL_mix_simd_lock);
+        if (!SDL_mix_simd_watched) {
+            SDL_AddHintCallback("SDL_AUDIO_SIMD", SDL_MixSIMDChanged, NULL);
+            SDL_mix_simd_watched = SDL_TRUE;
+        }
+        SDL_AtomicUnlock(&SDL_mix_simd_lock);
+    }
+    if (!SDL_mix_simd) {
+        return -1;
+    }
+#ifdef SDL_MIXER_X86
+    if (SDL_HasAVX2()) {
+        return 1;
+    }
+    if (!SDL_HasSSE2()) {
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+SDL_MixKernel
+SDL_ChooseSIMDMix(SDL_AudioFormat format)
+{
+    const int simd = SDL_ChooseMixSIMD();
+    int i;
+
+    for (i = 0; simd >= 0 && i < SDL_arraysize(SDL_mix_kernels); ++i) {
+        if (SDL_mix_kernels[i].format == format) {
+            return simd ? SDL_mix_kernels[i].avx2 : SDL_mix_kernels[i].vector;
+        }
+    }
+    return NULL;
+}
+
+SDL_MixManyKernel
+SDL_ChooseSIMDMixMany(SDL_AudioFormat format)
+{
+    const int simd = SDL_ChooseMixSIMD();
+    int i;
+
+    for (i = 0; simd >= 0 && i < SDL_arraysize(SDL_mix_many_kernels); ++i) {
+        if (SDL_mix_many_kernels[i].format == format) {
+            return simd ? SDL_mix_many_kernels[i].avx2 : SDL_mix_many_kernels[i].vector;
+        }
+    }
+    return NULL;
+}
+
+#else
+
+SDL_MixKernel
+SDL_ChooseSIMDMix(SDL_AudioFormat format)
+{
+    return NULL;
+}
+
+SDL_MixManyKernel
+SDL_ChooseSIMDMixMany(SDL_AudioFormat format)
+{
+    return NULL;
+}
+
+#endif /* SDL_MIXER_X86 || SDL_MIXER_NEON */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -23,6 +23,7 @@
 #ifndef _SDL_sysaudio_h
 #define _SDL_sysaudio_h
 
+#include "SDL_atomic.h"
 #include "SDL_mutex.h"
 #include "SDL_thread.h"
 
@@ -46,25 +47,25 @@ extern void SDL_RemoveAudioDevice(const int iscapture, void *handle);
 extern void SDL_OpenedAudioDeviceDisconnected(SDL_AudioDevice *device);
 
 
-/* This is the size of a packet when using SDL_QueueAudio(). We allocate
-   these as necessary and pool them, under the assumption that we'll
-   eventually end up with a handful that keep recycling, meeting whatever
-   the app needs. We keep packing data tightly as more arrives to avoid
-   wasting space, and if we get a giant block of data, we'll split them
-   into multiple packets behind the scenes. My expectation is that most
-   apps will have 2-3 of these in the pool. 8k should cover most needs, but
-   if this is crippling for some embedded system, we can #ifdef this.
-   The system preallocates enough packets for 2 callbacks' worth of data. */
-#define SDL_AUDIOBUFFERQUEUE_PACKETLEN (8 * 1024)
+/* Audio queued with SDL_QueueAudio() goes in a ring buffer, written by the
+   thread queueing it and read by the device thread without a lock. If an
+   app queues more than fits, a ring twice the size is chained on; the
+   device thread moves to it once the old one is empty, and the next
+   SDL_QueueAudio() frees the old one. Most apps will end up with a single
+   ring that keeps recycling. The first ring is big enough for two
+   callbacks' worth of data, and at least this many bytes. */
+#define SDL_AUDIOQUEUE_MINLEN (8 * 1024)
 
 /* Used by apps that queue audio instead of using the callback. */
-typedef struct SDL_AudioBufferQueue
+typedef struct SDL_AudioQueueRing
 {
-    Uint8 data[SDL_AUDIOBUFFERQUEUE_PACKETLEN];  /* packet data. */
-    Uint32 datalen;  /* bytes currently in use in this packet. */
-    Uint32 startpos;  /* bytes currently consumed in this packet. */
-    struct SDL_AudioBufferQueue *next;  /* next item in linked list. */
-} SDL_AudioBufferQueue;
+    Uint8 *data;  /* ring data, right after this struct. */
+    Uint32 size;  /* bytes of data, a power of two. */
+    SDL_atomic_t written;  /* bytes ever written, by the queueing thread. */
+    SDL_atomic_t read;  /* bytes ever read, by the device thread. */
+    SDL_atomic_t retired;  /* true once the device thread has moved on. */
+    struct SDL_AudioQueueRing *next;  /* set once nothing more goes in here. */
+} SDL_AudioQueueRing;
 
 typedef struct SDL_AudioDriverImpl
 {
@@ -92,6 +93,7 @@ typedef struct SDL_AudioDriverImpl
     int OnlyHasDefaultOutputDevice;
     int OnlyHasDefaultInputDevice;
     int AllowsArbitraryDeviceNames;
+    int TimesStages;  /* the device thread counts fill_ticks, convert_ticks */
 } SDL_AudioDriverImpl;
 
 
@@ -174,11 +176,21 @@ struct SDL_AudioDevice
     SDL_Thread *thread;
     SDL_threadID threadid;
 
-    /* Queued buffers (if app not using callback). */
-    SDL_AudioBufferQueue *buffer_queue_head; /* device fed from here. */
-    SDL_AudioBufferQueue *buffer_queue_tail; /* queue fills to here. */
-    SDL_AudioBufferQueue *buffer_queue_pool; /* these are unused packets. */
-    Uint32 queued_bytes;  /* number of bytes of audio data in the queue. */
+    /* Queued audio (if app not using callback). */
+    SDL_AudioQueueRing *queue_head;  /* device fed from here. */
+    SDL_AudioQueueRing *queue_tail;  /* queue fills to here. */
+    SDL_AudioQueueRing *queue_oldest;  /* rings to free, up to queue_head. */
+    SDL_SpinLock queue_lock;  /* only between threads queueing at once. */
+    SDL_atomic_t queue_written;  /* bytes ever queued. */
+    SDL_atomic_t queue_read;  /* bytes ever sent to the device or dropped. */
+    SDL_atomic_t queue_cleared;  /* queue_written at the last clear. */
+    SDL_atomic_t queue_underruns;  /* times the device ran out of audio. */
+    int queue_starved;  /* device thread: the last callback ran out. */
+
+    /* Performance counter ticks in the callback and in converting its
+       output, if the driver's TimesStages. */
+    Uint64 fill_ticks;
+    Uint64 convert_ticks;
 
     /* * * */
     /* Data private to this driver */
@@ -35,55 +35,66 @@ struct MS_ADPCM_decodestate
     Sint16 iSamp1;
     Sint16 iSamp2;
 };
-static struct MS_ADPCM_decoder
+struct MS_ADPCM_decoder
 {
     WaveFMT wavefmt;
     Uint16 wSamplesPerBlock;
     Uint16 wNumCoef;
     Sint16 aCoeff[7][2];
-    /* * * */
-    struct MS_ADPCM_decodestate state[2];
-} MS_ADPCM_state;
+};
 
 static int
-InitMS_ADPCM(WaveFMT * format)
+InitMS_ADPCM(struct MS_ADPCM_decoder *decoder, WaveFMT * format)
 {
     Uint8 *rogue_feel;
     int i;
 
     /* Set the rogue pointer to the MS_ADPCM specific data */
-    MS_ADPCM_state.wavefmt.encoding = SDL_SwapLE16(format->encoding);
-    MS_ADPCM_state.wavefmt.channels = SDL_SwapLE16(format->channels);
-    MS_ADPCM_state.wavefmt.frequency = SDL_SwapLE32(format->frequency);
-    MS_ADPCM_state.wavefmt.byterate = SDL_SwapLE32(format->byterate);
-    MS_ADPCM_state.wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
-    MS_ADPCM_state.wavefmt.bitspersample =
+    decoder->wavefmt.encoding = SDL_SwapLE16(format->encoding);
+    decoder->wavefmt.channels = SDL_SwapLE16(format->channels);
+    decoder->wavefmt.frequency = SDL_SwapLE32(format->frequency);
+    decoder->wavefmt.byterate = SDL_SwapLE32(format->byterate);
+    decoder->wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
+    decoder->wavefmt.bitspersample =
         SDL_SwapLE16(format->bitspersample);
     rogue_feel = (Uint8 *) format + sizeof(*format);
     if (sizeof(*format) == 16) {
         /* const Uint16 extra_info = ((rogue_feel[1] << 8) | rogue_feel[0]); */
         rogue_feel += sizeof(Uint16);
     }
-    MS_ADPCM_state.wSamplesPerBlock = ((rogue_feel[1] << 8) | rogue_feel[0]);
+    decoder->wSamplesPerBlock = ((rogue_feel[1] << 8) | rogue_feel[0]);
     rogue_feel += sizeof(Uint16);
-    MS_ADPCM_state.wNumCoef = ((rogue_feel[1] << 8) | rogue_feel[0]);
+    decoder->wNumCoef = ((rogue_feel[1] << 8) | rogue_feel[0]);
     rogue_feel += sizeof(Uint16);
-    if (MS_ADPCM_state.wNumCoef != 7) {
+    if (decoder->wNumCoef != 7) {
         SDL_SetError("Unknown set of MS_ADPCM coefficients");
         return (-1);
     }
-    for (i = 0; i < MS_ADPCM_state.wNumCoef; ++i) {
-        MS_ADPCM_state.aCoeff[i][0] = ((rogue_feel[1] << 8) | rogue_feel[0]);
+    for (i = 0; i < decoder->wNumCoef; ++i) {
+        decoder->aCoeff[i][0] = ((rogue_feel[1] << 8) | rogue_feel[0]);
         rogue_feel += sizeof(Uint16);
-        MS_ADPCM_state.aCoeff[i][1] = ((rogue_feel[1] << 8) | rogue_feel[0]);
+        decoder->aCoeff[i][1] = ((rogue_feel[1] << 8) | rogue_feel[0]);
         rogue_feel += sizeof(Uint16);
     }
+
+    /* Each block has to hold the samples it says it has */
+    if (decoder->wavefmt.channels < 1 || decoder->wavefmt.channels > 2) {
+        SDL_SetError("MS ADPCM decoder can only handle 2 channels");
+        return (-1);
+    }
+    if (decoder->wSamplesPerBlock < 2 ||
+        ((decoder->wSamplesPerBlock - 2) * decoder->wavefmt.channels) % 2 ||
+        decoder->wavefmt.blockalign < 7 * decoder->wavefmt.channels +
+        ((decoder->wSamplesPerBlock - 2) * decoder->wavefmt.channels) / 2) {
+        SDL_SetError("Invalid MS ADPCM block size");
+        return (-1);
+    }
     return (0);
 }
 
 static Sint32
 MS_ADPCM_nibble(struct MS_ADPCM_decodestate *state,
-                Uint8 nybble, Sint16 * coeff)
+                Uint8 nybble, const Sint16 * coeff)
 {
     const Sint32 max_audioval = ((1 << (16 - 1)) - 1);
     const Sint32 min_audioval = -(1 << (16 - 1));
@@ -115,104 +126,89 @@ MS_ADPCM_nibble(struct MS_ADPCM_decodestate *state,
     return (new_sample);
 }
 
-static int
-MS_ADPCM_decode(Uint8 ** audio_buf, Uint32 * audio_len)
+/* Decode one block of blockalign bytes into wSamplesPerBlock frames; the
+   blocks don't depend on each other, so any of them can be decoded alone */
+static void
+MS_ADPCM_decode_block(const struct MS_ADPCM_decoder *decoder,
+                      const Uint8 * encoded, Uint8 * decoded)
 {
+    struct MS_ADPCM_decodestate states[2];
     struct MS_ADPCM_decodestate *state[2];
-    Uint8 *freeable, *encoded, *decoded;
-    Sint32 encoded_len, samplesleft;
+    Sint32 samplesleft;
     Sint8 nybble;
     Uint8 stereo;
-    Sint16 *coeff[2];
+    const Sint16 *coeff[2];
     Sint32 new_sample;
 
-    /* Allocate the proper sized output buffer */
-    encoded_len = *audio_len;
-    encoded = *audio_buf;
-    freeable = *audio_buf;
-    *audio_len = (encoded_len / MS_ADPCM_state.wavefmt.blockalign) *
-        MS_ADPCM_state.wSamplesPerBlock *
-        MS_ADPCM_state.wavefmt.channels * sizeof(Sint16);
-    *audio_buf = (Uint8 *) SDL_malloc(*audio_len);
-    if (*audio_buf == NULL) {
-        return SDL_OutOfMemory();
+    stereo = (decoder->wavefmt.channels == 2);
+    state[0] = &states[0];
+    state[1] = &states[stereo];
+
+    /* Grab the initial information for this block */
+    state[0]->hPredictor = *encoded++;
+    if (stereo) {
+        state[1]->hPredictor = *encoded++;
     }
-    decoded = *audio_buf;
-
-    /* Get ready... Go! */
-    stereo = (MS_ADPCM_state.wavefmt.channels == 2);
-    state[0] = &MS_ADPCM_state.state[0];
-    state[1] = &MS_ADPCM_state.state[stereo];
-    while (encoded_len >= MS_ADPCM_state.wavefmt.blockalign) {
-        /* Grab the initial information for this block */
-        state[0]->hPredictor = *encoded++;
-        if (stereo) {
-            state[1]->hPredictor = *encoded++;
-        }
-        state[0]->iDelta = ((encoded[1] << 8) | encoded[0]);
+    state[0]->iDelta = ((encoded[1] << 8) | encoded[0]);
+    encoded += sizeof(Sint16);
+    if (stereo) {
+        state[1]->iDelta = ((encoded[1] << 8) | encoded[0]);
         encoded += sizeof(Sint16);
-        if (stereo) {
-            state[1]->iDelta = ((encoded[1] << 8) | encoded[0]);
-            encoded += sizeof(Sint16);
-        }
-        state[0]->iSamp1 = ((encoded[1] << 8) | encoded[0]);
+    }
+    state[0]->iSamp1 = ((encoded[1] << 8) | encoded[0]);
+    encoded += sizeof(Sint16);
+    if (stereo) {
+        state[1]->iSamp1 = ((encoded[1] << 8) | encoded[0]);
         encoded += sizeof(Sint16);
-        if (stereo) {
-            state[1]->iSamp1 = ((encoded[1] << 8) | encoded[0]);
-            encoded += sizeof(Sint16);
-        }
-        state[0]->iSamp2 = ((encoded[1] << 8) | encoded[0]);
+    }
+    state[0]->iSamp2 = ((encoded[1] << 8) | encoded[0]);
+    encoded += sizeof(Sint16);
+    if (stereo) {
+        state[1]->iSamp2 = ((encoded[1] << 8) | encoded[0]);
         encoded += sizeof(Sint16);
-        if (stereo) {
-            state[1]->iSamp2 = ((encoded[1] << 8) | encoded[0]);
-            encoded += sizeof(Sint16);
-        }
-        coeff[0] = MS_ADPCM_state.aCoeff[state[0]->hPredictor];
-        coeff[1] = MS_ADPCM_state.aCoeff[state[1]->hPredictor];
+    }
+    coeff[0] = decoder->aCoeff[state[0]->hPredictor % 7];
+    coeff[1] = decoder->aCoeff[state[1]->hPredictor % 7];
+
+    /* Store the two initial samples we start with */
+    decoded[0] = state[0]->iSamp2 & 0xFF;
+    decoded[1] = state[0]->iSamp2 >> 8;
+    decoded += 2;
+    if (stereo) {
+        decoded[0] = state[1]->iSamp2 & 0xFF;
+        decoded[1] = state[1]->iSamp2 >> 8;
+        decoded += 2;
+    }
+    decoded[0] = state[0]->iSamp1 & 0xFF;
+    decoded[1] = state[0]->iSamp1 >> 8;
+    decoded += 2;
+    if (stereo) {
+        decoded[0] = state[1]->iSamp1 & 0xFF;
+        decoded[1] = state[1]->iSamp1 >> 8;
+        decoded += 2;
+    }
 
-        /* Store the two initial samples we start with */
-        decoded[0] = state[0]->iSamp2 & 0xFF;
-        decoded[1] = state[0]->iSamp2 >> 8;
+    /* Decode and store the other samples in this block */
+    samplesleft = (decoder->wSamplesPerBlock - 2) *
+        decoder->wavefmt.channels;
+    while (samplesleft > 0) {
+        nybble = (*encoded) >> 4;
+        new_sample = MS_ADPCM_nibble(state[0], nybble, coeff[0]);
+        decoded[0] = new_sample & 0xFF;
+        new_sample >>= 8;
+        decoded[1] = new_sample & 0xFF;
         decoded += 2;
-        if (stereo) {
-            decoded[0] = state[1]->iSamp2 & 0xFF;
-            decoded[1] = state[1]->iSamp2 >> 8;
-            decoded += 2;
-        }
-        decoded[0] = state[0]->iSamp1 & 0xFF;
-        decoded[1] = state[0]->iSamp1 >> 8;
+
+        nybble = (*encoded) & 0x0F;
+        new_sample = MS_ADPCM_nibble(state[1], nybble, coeff[1]);
+        decoded[0] = new_sample & 0xFF;
+        new_sample >>= 8;
+        decoded[1] = new_sample & 0xFF;
         decoded += 2;
-        if (stereo) {
-            decoded[0] = state[1]->iSamp1 & 0xFF;
-            decoded[1] = state[1]->iSamp1 >> 8;
-            decoded += 2;
-        }
 
-        /* Decode and store the other samples in this block */
-        samplesleft = (MS_ADPCM_state.wSamplesPerBlock - 2) *
-            MS_ADPCM_state.wavefmt.channels;
-        while (samplesleft > 0) {
-            nybble = (*encoded) >> 4;
-            new_sample = MS_ADPCM_nibble(state[0], nybble, coeff[0]);
-            decoded[0] = new_sample & 0xFF;
-            new_sample >>= 8;
-            decoded[1] = new_sample & 0xFF;
-            decoded += 2;
-
-            nybble = (*encoded) & 0x0F;
-            new_sample = MS_ADPCM_nibble(state[1], nybble, coeff[1]);
-            decoded[0] = new_sample & 0xFF;
-            new_sample >>= 8;
-            decoded[1] = new_sample & 0xFF;
-            decoded += 2;
-
-            ++encoded;
-            samplesleft -= 2;
-        }
-        encoded_len -= MS_ADPCM_state.wavefmt.blockalign;
+        ++encoded;
+        samplesleft -= 2;
     }
-    SDL_free(freeable);
-    return (0);
 }
 
 struct IMA_ADPCM_decodestate
@@ -220,33 +216,44 @@ struct IMA_ADPCM_decodestate
     Sint32 sample;
     Sint8 index;
 };
-static struct IMA_ADPCM_decoder
+struct IMA_ADPCM_decoder
 {
     WaveFMT wavefmt;
     Uint16 wSamplesPerBlock;
-    /* * * */
-    struct IMA_ADPCM_decodestate state[2];
-} IMA_ADPCM_state;
+};
 
 static int
-InitIMA_ADPCM(WaveFMT * format)
+InitIMA_ADPCM(struct IMA_ADPCM_decoder *decoder, WaveFMT * format)
 {
     Uint8 *rogue_feel;
 
     /* Set the rogue pointer to the IMA_ADPCM specific data */
-    IMA_ADPCM_state.wavefmt.encoding = SDL_SwapLE16(format->encoding);
-    IMA_ADPCM_state.wavefmt.channels = SDL_SwapLE16(format->channels);
-    IMA_ADPCM_state.wavefmt.frequency = SDL_SwapLE32(format->frequency);
-    IMA_ADPCM_state.wavefmt.byterate = SDL_SwapLE32(format->byterate);
-    IMA_ADPCM_state.wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
-    IMA_ADPCM_state.wavefmt.bitspersample =
+    decoder->wavefmt.encoding = SDL_SwapLE16(format->encoding);
+    decoder->wavefmt.channels = SDL_SwapLE16(format->channels);
+    decoder->wavefmt.frequency = SDL_SwapLE32(format->frequency);
+    decoder->wavefmt.byterate = SDL_SwapLE32(format->byterate);
+    decoder->wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
+    decoder->wavefmt.bitspersample =
         SDL_SwapLE16(format->bitspersample);
     rogue_feel = (Uint8 *) format + sizeof(*format);
     if (sizeof(*format) == 16) {
         /* const Uint16 extra_info = ((rogue_feel[1] << 8) | rogue_feel[0]); */
         rogue_feel += sizeof(Uint16);
     }
-    IMA_ADPCM_state.wSamplesPerBlock = ((rogue_feel[1] << 8) | rogue_feel[0]);
+    decoder->wSamplesPerBlock = ((rogue_feel[1] << 8) | rogue_feel[0]);
+
+    /* Each block has to hold the samples it says it has */
+    if (decoder->wavefmt.channels < 1 || decoder->wavefmt.channels > 2) {
+        SDL_SetError("IMA ADPCM decoder can only handle 2 channels");
+        return (-1);
+    }
+    if (decoder->wSamplesPerBlock < 1 ||
+        (decoder->wSamplesPerBlock - 1) % 8 ||
+        decoder->wavefmt.blockalign < 4 * decoder->wavefmt.channels +
+        ((decoder->wSamplesPerBlock - 1) * decoder->wavefmt.channels) / 2) {
+        SDL_SetError("Invalid IMA ADPCM block size");
+        return (-1);
+    }
     return (0);
 }
 
@@ -306,7 +313,7 @@ IMA_ADPCM_nibble(struct IMA_ADPCM_decodestate *state, Uint8 nybble)
 
 /* Fill the decode buffer with a channel block of data (8 samples) */
 static void
-Fill_IMA_ADPCM_block(Uint8 * decoded, Uint8 * encoded,
+Fill_IMA_ADPCM_block(Uint8 * decoded, const Uint8 * encoded,
                      int channel, int numchannels,
                      struct IMA_ADPCM_decodestate *state)
 {
@@ -334,110 +341,106 @@ Fill_IMA_ADPCM_block(Uint8 * decoded, Uint8 * encoded,
     }
 }
 
-static int
-IMA_ADPCM_decode(Uint8 ** audio_buf, Uint32 * audio_len)
+/* Decode one block, as MS_ADPCM_decode_block() does */
+static void
+IMA_ADPCM_decode_block(const struct IMA_ADPCM_decoder *decoder,
+                       const Uint8 * encoded, Uint8 * decoded)
 {
-    struct IMA_ADPCM_decodestate *state;
-    Uint8 *freeable, *encoded, *decoded;
-    Sint32 encoded_len, samplesleft;
+    struct IMA_ADPCM_decodestate state[2];
+    Sint32 samplesleft;
     unsigned int c, channels;
 
-    /* Check to make sure we have enough variables in the state array */
-    channels = IMA_ADPCM_state.wavefmt.channels;
-    if (channels > SDL_arraysize(IMA_ADPCM_state.state)) {
-        SDL_SetError("IMA ADPCM decoder can only handle %u channels",
-                     (unsigned int)SDL_arraysize(IMA_ADPCM_state.state));
-        return (-1);
-    }
-    state = IMA_ADPCM_state.state;
-
-    /* Allocate the proper sized output buffer */
-    encoded_len = *audio_len;
-    encoded = *audio_buf;
-    freeable = *audio_buf;
-    *audio_len = (encoded_len / IMA_ADPCM_state.wavefmt.blockalign) *
-        IMA_ADPCM_state.wSamplesPerBlock *
-        IMA_ADPCM_state.wavefmt.channels * sizeof(Sint16);
-    *audio_buf = (Uint8 *) SDL_malloc(*audio_len);
-    if (*audio_buf == NULL) {
-        return SDL_OutOfMemory();
-    }
-    decoded = *audio_buf;
-
-    /* Get ready... Go! */
-    while (encoded_len >= IMA_ADPCM_state.wavefmt.blockalign) {
-        /* Grab the initial information for this block */
-        for (c = 0; c < channels; ++c) {
-            /* Fill the state information for this block */
-            state[c].sample = ((encoded[1] << 8) | encoded[0]);
-            encoded += 2;
-            if (state[c].sample & 0x8000) {
-                state[c].sample -= 0x10000;
-            }
-            state[c].index = *encoded++;
-            /* Reserved byte in buffer header, should be 0 */
-            if (*encoded++ != 0) {
-                /* Uh oh, corrupt data?  Buggy code? */ ;
-            }
+    channels = decoder->wavefmt.channels;
 
-            /* Store the initial sample we start with */
-            decoded[0] = (Uint8) (state[c].sample & 0xFF);
-            decoded[1] = (Uint8) (state[c].sample >> 8);
-            decoded += 2;
+    /* Grab the initial information for this block */
+    for (c = 0; c < channels; ++c) {
+        /* Fill the state information for this block */
+        state[c].sample = ((encoded[1] << 8) | encoded[0]);
+        encoded += 2;
+        if (state[c].sample & 0x8000) {
+            state[c].sample -= 0x10000;
+        }
+        state[c].index = *encoded++;
+        /* Reserved byte in buffer header, should be 0 */
+        if (*encoded++ != 0) {
+            /* Uh oh, corrupt data?  Buggy code? */ ;
         }
 
-        /* Decode and store the other samples in this block */
-        samplesleft = (IMA_ADPCM_state.wSamplesPerBlock - 1) * channels;
-        while (samplesleft > 0) {
-            for (c = 0; c < channels; ++c) {
-                Fill_IMA_ADPCM_block(decoded, encoded,
-                                     c, channels, &state[c]);
-                encoded += 4;
-                samplesleft -= 8;
-            }
-            decoded += (channels * 8 * 2);
+        /* Store the initial sample we start with */
+        decoded[0] = (Uint8) (state[c].sample & 0xFF);
+        decoded[1] = (Uint8) (state[c].sample >> 8);
+        decoded += 2;
+    }
+
+    /* Decode and store the other samples in this block */
+    samplesleft = (decoder->wSamplesPerBlock - 1) * channels;
+    while (samplesleft > 0) {
+        for (c = 0; c < channels; ++c) {
+            Fill_IMA_ADPCM_block(decoded, encoded,
+                                 c, channels, &state[c]);
+            encoded += 4;
+            samplesleft -= 8;
         }
-        encoded_len -= IMA_ADPCM_state.wavefmt.blockalign;
+        decoded += (channels * 8 * 2);
     }
-    SDL_free(freeable);
-    return (0);
 }
 
-SDL_AudioSpec *
-SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
-               SDL_AudioSpec * spec, Uint8 ** audio_buf, Uint32 * audio_len)
+/* An opened WAVE: where its data chunk is, and how to decode it */
+struct SDL_WAV
+{
+    SDL_RWops *src;
+    int freesrc;
+    SDL_AudioSpec spec;
+    Uint16 encoding;
+    struct MS_ADPCM_decoder ms;
+    struct IMA_ADPCM_decoder ima;
+    Uint32 blockalign;          /* Encoded bytes per block (ADPCM) */
+    Uint32 blocklen;            /* Decoded bytes per block (ADPCM) */
+    Sint64 data_start;          /* The data chunk's offset in src */
+    Uint32 data_len;            /* Its length, in encoded bytes */
+    Uint32 audio_len;           /* Its length, in decoded bytes */
+    Sint64 end;                 /* The end of the RIFF chunk in src */
+    const Uint8 *mapped;        /* The data chunk, if src is in memory */
+    Uint8 *audio_buf;           /* SDL_GetWAVData()'s copy, if not mapped */
+    Uint32 pos;                 /* The next byte SDL_ReadWAV() returns */
+    Uint8 *encoded;             /* A block read from src (ADPCM) */
+    Uint8 *decoded;             /* The block pos is in, decoded (ADPCM) */
+    Uint32 decoded_block;       /* Which block that is, ~0 for none */
+};
+
+/* Read the RIFF header and the format chunk, and find the data chunk,
+   leaving src just after the data chunk's header */
+static int
+ParseWAV(SDL_RWops * src, SDL_WAV * wav)
 {
     int was_error;
     Chunk chunk;
     int lenread;
     int IEEE_float_encoded, MS_ADPCM_encoded, IMA_ADPCM_encoded;
-    int samplesize;
+    SDL_AudioSpec *spec = &wav->spec;
 
     /* WAV magic header */
+    Sint64 start;
     Uint32 RIFFchunk;
     Uint32 wavelen = 0;
     Uint32 WAVEmagic;
-    Uint32 headerDiff = 0;
+    Uint32 headerlen = 3 * sizeof(Uint32);
 
     /* FMT chunk */
     WaveFMT *format = NULL;
 
     SDL_zero(chunk);
 
-    /* Make sure we are passed a valid data source */
-    was_error = 0;
-    if (src == NULL) {
-        was_error = 1;
-        goto done;
-    }
-
     /* Check the magic header */
+    was_error = 0;
+    start = SDL_RWtell(src);
     RIFFchunk = SDL_ReadLE32(src);
     wavelen = SDL_ReadLE32(src);
     if (wavelen == WAVE) {      /* The RIFFchunk has already been read */
         WAVEmagic = wavelen;
         wavelen = RIFFchunk;
         RIFFchunk = RIFF;
+        headerlen = 2 * sizeof(Uint32);
     } else {
         WAVEmagic = SDL_ReadLE32(src);
     }
@@ -446,7 +449,8 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
         was_error = 1;
         goto done;
     }
-    headerDiff += sizeof(Uint32);       /* for WAVE */
+    /* the RIFF chunk's length counts the WAVE magic */
+    wav->end = start + (headerlen - sizeof(Uint32)) + wavelen;
 
     /* Read the audio data format chunk */
     chunk.data = NULL;
@@ -458,8 +462,6 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
             was_error = 1;
             goto done;
         }
-        /* 2 Uint32's for chunk header+len, plus the lenread */
-        headerDiff += lenread + 2 * sizeof(Uint32);
     } while ((chunk.magic == FACT) || (chunk.magic == LIST) || (chunk.magic == BEXT) || (chunk.magic == JUNK));
 
     /* Decode the audio data format */
@@ -470,7 +472,8 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
         goto done;
     }
     IEEE_float_encoded = MS_ADPCM_encoded = IMA_ADPCM_encoded = 0;
-    switch (SDL_SwapLE16(format->encoding)) {
+    wav->encoding = SDL_SwapLE16(format->encoding);
+    switch (wav->encoding) {
     case PCM_CODE:
         /* We can understand this */
         break;
@@ -480,18 +483,24 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
         break;
     case MS_ADPCM_CODE:
         /* Try to understand this */
-        if (InitMS_ADPCM(format) < 0) {
+        if (InitMS_ADPCM(&wav->ms, format) < 0) {
             was_error = 1;
             goto done;
         }
+        wav->blockalign = wav->ms.wavefmt.blockalign;
+        wav->blocklen = wav->ms.wSamplesPerBlock *
+            wav->ms.wavefmt.channels * sizeof(Sint16);
         MS_ADPCM_encoded = 1;
         break;
     case IMA_ADPCM_CODE:
         /* Try to understand this */
-        if (InitIMA_ADPCM(format) < 0) {
+        if (InitIMA_ADPCM(&wav->ima, format) < 0) {
             was_error = 1;
             goto done;
         }
+        wav->blockalign = wav->ima.wavefmt.blockalign;
+        wav->blocklen = wav->ima.wSamplesPerBlock *
+            wav->ima.wavefmt.channels * sizeof(Sint16);
         IMA_ADPCM_encoded = 1;
         break;
     case MP3_CODE:
@@ -499,8 +508,7 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
         was_error = 1;
         goto done;
     default:
-        SDL_SetError("Unknown WAVE data format: 0x%.4x",
-                     SDL_SwapLE16(format->encoding));
+        SDL_SetError("Unknown WAVE data format: 0x%.4x", wav->encoding);
         was_error = 1;
         goto done;
     }
@@ -545,48 +553,119 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
     spec->channels = (Uint8) SDL_SwapLE16(format->channels);
     spec->samples = 4096;       /* Good default buffer size */
 
-    /* Read the audio data chunk */
-    *audio_buf = NULL;
-    do {
-        SDL_free(*audio_buf);
-        *audio_buf = NULL;
-        lenread = ReadChunk(src, &chunk);
-        if (lenread < 0) {
+    /* Find the audio data chunk, skipping any others */
+    for (;;) {
+        chunk.magic = SDL_ReadLE32(src);
+        chunk.length = SDL_ReadLE32(src);
+        if (chunk.magic == DATA) {
+            break;
+        }
+        if (SDL_RWseek(src, chunk.length, RW_SEEK_CUR) < 0) {
             was_error = 1;
             goto done;
         }
-        *audio_len = lenread;
-        *audio_buf = chunk.data;
-        if (chunk.magic != DATA)
-            headerDiff += lenread + 2 * sizeof(Uint32);
-    } while (chunk.magic != DATA);
-    headerDiff += 2 * sizeof(Uint32);   /* for the data chunk and len */
-
-    if (MS_ADPCM_encoded) {
-        if (MS_ADPCM_decode(audio_buf, audio_len) < 0) {
+        if (chunk.magic == 0 && chunk.length == 0) {
+            SDL_Error(SDL_EFREAD);  /* ran off the end of the file */
             was_error = 1;
             goto done;
         }
     }
-    if (IMA_ADPCM_encoded) {
-        if (IMA_ADPCM_decode(audio_buf, audio_len) < 0) {
+    wav->data_start = SDL_RWtell(src);
+    wav->data_len = chunk.length;
+    if (MS_ADPCM_encoded || IMA_ADPCM_encoded) {
+        wav->audio_len = (wav->data_len / wav->blockalign) * wav->blocklen;
+    } else {
+        wav->audio_len = wav->data_len;
+    }
+
+  done:
+    SDL_free(format);
+    return was_error ? -1 : 0;
+}
+
+/* Decode the whole blocks in encoded, as they're laid out in the data chunk */
+static void
+DecodeBlocks(const SDL_WAV * wav, const Uint8 * encoded, Uint32 blocks,
+             Uint8 * decoded)
+{
+    Uint32 i;
+
+    for (i = 0; i < blocks; ++i) {
+        if (wav->encoding == MS_ADPCM_CODE) {
+            MS_ADPCM_decode_block(&wav->ms, encoded, decoded);
+        } else {
+            IMA_ADPCM_decode_block(&wav->ima, encoded, decoded);
+        }
+        encoded += wav->blockalign;
+        decoded += wav->blocklen;
+    }
+}
+
+SDL_AudioSpec *
+SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
+               SDL_AudioSpec * spec, Uint8 ** audio_buf, Uint32 * audio_len)
+{
+    int was_error;
+    SDL_WAV wav;
+    Uint8 *encoded = NULL;
+    int samplesize;
+
+    SDL_zero(wav);
+
+    /* Make sure we are passed a valid data source */
+    was_error = 0;
+    if (src == NULL) {
+        was_error = 1;
+        goto done;
+    }
+
+    if (ParseWAV(src, &wav) < 0) {
+        was_error = 1;
+        goto done;
+    }
+    *spec = wav.spec;
+
+    /* Read the audio data chunk */
+    *audio_buf = NULL;
+    encoded = (Uint8 *) SDL_malloc(wav.data_len);
+    if (encoded == NULL) {
+        SDL_OutOfMemory();
+        was_error = 1;
+        goto done;
+    }
+    if (SDL_RWread(src, encoded, wav.data_len, 1) != 1) {
+        SDL_Error(SDL_EFREAD);
+        was_error = 1;
+        goto done;
+    }
+
+    if (wav.encoding == MS_ADPCM_CODE || wav.encoding == IMA_ADPCM_CODE) {
+        /* Allocate the proper sized output buffer */
+        *audio_buf = (Uint8 *) SDL_malloc(wav.audio_len);
+        if (*audio_buf == NULL) {
+            SDL_OutOfMemory();
             was_error = 1;
             goto done;
         }
+        DecodeBlocks(&wav, encoded, wav.data_len / wav.blockalign, *audio_buf);
+    } else {
+        *audio_buf = encoded;
+        encoded = NULL;
     }
+    *audio_len = wav.audio_len;
 
     /* Don't return a buffer that isn't a multiple of samplesize */
     samplesize = ((SDL_AUDIO_BITSIZE(spec->format)) / 8) * spec->channels;
     *audio_len &= ~(samplesize - 1);
 
   done:
-    SDL_free(format);
+    SDL_free(encoded);
     if (src) {
         if (freesrc) {
             SDL_RWclose(src);
-        } else {
+        } else if (wav.end) {
             /* seek to the end of the file (given by the RIFF chunk) */
-            SDL_RWseek(src, wavelen - chunk.length - headerDiff, RW_SEEK_CUR);
+            SDL_RWseek(src, wav.end, RW_SEEK_SET);
         }
     }
     if (was_error) {
@@ -604,6 +683,204 @@ SDL_FreeWAV(Uint8 * audio_buf)
     SDL_free(audio_buf);
 }
 
+SDL_WAV *
+SDL_OpenWAV_RW(SDL_RWops * src, int freesrc,
+               SDL_AudioSpec * spec, Uint32 * audio_len)
+{
+    SDL_WAV *wav;
+    Sint64 size;
+    int samplesize;
+
+    if (src == NULL) {
+        return NULL;
+    }
+    wav = (SDL_WAV *) SDL_calloc(1, sizeof(*wav));
+    if (wav == NULL) {
+        SDL_OutOfMemory();
+        goto error;
+    }
+    if (ParseWAV(src, wav) < 0) {
+        goto error;
+    }
+
+    /* A truncated data chunk plays what there is of it */
+    size = SDL_RWsize(src);
+    if (size >= wav->data_start && wav->data_len > size - wav->data_start) {
+        wav->data_len = (Uint32) (size - wav->data_start);
+    }
+    if (wav->encoding == MS_ADPCM_CODE || wav->encoding == IMA_ADPCM_CODE) {
+        wav->audio_len = (wav->data_len / wav->blockalign) * wav->blocklen;
+        wav->encoded = (Uint8 *) SDL_malloc(wav->blockalign + wav->blocklen);
+        if (wav->encoded == NULL) {
+            SDL_OutOfMemory();
+            goto error;
+        }
+        wav->decoded = wav->encoded + wav->blockalign;
+        wav->decoded_block = ~0U;
+    } else {
+        samplesize = ((SDL_AUDIO_BITSIZE(wav->spec.format)) / 8) * wav->spec.channels;
+        wav->audio_len = wav->data_len - (wav->data_len % samplesize);
+    }
+
+    /* Memory streams (SDL_RWFromFileMapped() among them) are used in place */
+    if (src->type == SDL_RWOPS_MEMORY || src->type == SDL_RWOPS_MEMORY_RO ||
+        src->type == SDL_RWOPS_MAPPED) {
+        wav->mapped = (const Uint8 *) SDL_RWMappedData(src, NULL) + wav->data_start;
+    }
+
+    wav->src = src;
+    wav->freesrc = freesrc;
+    *spec = wav->spec;
+    if (audio_len) {
+        *audio_len = wav->audio_len;
+    }
+    return wav;
+
+  error:
+    if (wav) {
+        SDL_free(wav->encoded);
+        SDL_free(wav);
+    }
+    if (freesrc) {
+        SDL_RWclose(src);
+    }
+    return NULL;
+}
+
+/* Read encoded bytes of the data chunk from src (not its memory) */
+static int
+ReadWAVData(SDL_WAV * wav, Uint32 offset, void *buf, Uint32 len)
+{
+    if (SDL_RWseek(wav->src, wav->data_start + offset, RW_SEEK_SET) < 0 ||
+        SDL_RWread(wav->src, buf, len, 1) != 1) {
+        return SDL_Error(SDL_EFREAD);
+    }
+    return 0;
+}
+
+/* Copy len bytes of decoded audio, from pos, into buf */
+static int
+CopyWAVAudio(SDL_WAV * wav, Uint32 pos, Uint8 * buf, Uint32 len)
+{
+    const Uint8 *encoded;
+    Uint32 block, offset, cpy, whole;
+
+    if (wav->encoding != MS_ADPCM_CODE && wav->encoding != IMA_ADPCM_CODE) {
+        if (wav->mapped) {
+            SDL_memcpy(buf, wav->mapped + pos, len);
+            return 0;
+        }
+        return ReadWAVData(wav, pos, buf, len);
+    }
+
+    while (len > 0) {
+        block = pos / wav->blocklen;
+        offset = pos % wav->blocklen;
+
+        /* Whole blocks go straight into buf, as long as they're in memory */
+        whole = len / wav->blocklen;
+        if (offset == 0 && whole > 0 && wav->mapped) {
+            DecodeBlocks(wav, wav->mapped + block * wav->blockalign, whole, buf);
+            cpy = whole * wav->blocklen;
+        } else {
+            if (block != wav->decoded_block) {
+                if (wav->mapped) {
+                    encoded = wav->mapped + block * wav->blockalign;
+                } else if (ReadWAVData(wav, block * wav->blockalign,
+                                       wav->encoded, wav->blockalign) < 0) {
+                    return -1;
+                } else {
+                    encoded = wav->encoded;
+                }
+                DecodeBlocks(wav, encoded, 1, wav->decoded);
+                wav->decoded_block = block;
+            }
+            cpy = SDL_min(len, wav->blocklen - offset);
+            SDL_memcpy(buf, wav->decoded + offset, cpy);
+        }
+        buf += cpy;
+        pos += cpy;
+        len -= cpy;
+    }
+    return 0;
+}
+
+const Uint8 *
+SDL_GetWAVData(SDL_WAV * wav, Uint32 * audio_len)
+{
+    if (wav == NULL) {
+        SDL_InvalidParamError("wav");
+        return NULL;
+    }
+    if (audio_len) {
+        *audio_len = wav->audio_len;
+    }
+    if (wav->mapped && wav->encoding != MS_ADPCM_CODE &&
+        wav->encoding != IMA_ADPCM_CODE) {
+        return wav->mapped;  /* a view of the data chunk, no copy */
+    }
+    if (wav->audio_buf == NULL) {
+        /* an empty chunk still gets a buffer, so this isn't NULL */
+        Uint8 *audio_buf = (Uint8 *) SDL_malloc(wav->audio_len ? wav->audio_len : 1);
+        if (audio_buf == NULL) {
+            SDL_OutOfMemory();
+            return NULL;
+        }
+        if (CopyWAVAudio(wav, 0, audio_buf, wav->audio_len) < 0) {
+            SDL_free(audio_buf);
+            return NULL;
+        }
+        wav->audio_buf = audio_buf;
+    }
+    return wav->audio_buf;
+}
+
+Uint32
+SDL_ReadWAV(SDL_WAV * wav, void *buf, Uint32 len)
+{
+    if (wav == NULL) {
+        SDL_InvalidParamError("wav");
+        return 0;
+    }
+    len = SDL_min(len, wav->audio_len - wav->pos);
+    if (len == 0) {
+        return 0;
+    }
+    if (wav->audio_buf) {
+        SDL_memcpy(buf, wav->audio_buf + wav->pos, len);
+    } else if (CopyWAVAudio(wav, wav->pos, (Uint8 *) buf, len) < 0) {
+        return 0;
+    }
+    wav->pos += len;
+    return len;
+}
+
+int
+SDL_SeekWAV(SDL_WAV * wav, Uint32 pos)
+{
+    if (wav == NULL) {
+        return SDL_InvalidParamError("wav");
+    }
+    if (pos > wav->audio_len) {
+        return SDL_SetError("Seek past the end of the WAVE data");
+    }
+    wav->pos = pos;
+    return 0;
+}
+
+void
+SDL_CloseWAV(SDL_WAV * wav)
+{
+    if (wav) {
+        if (wav->freesrc) {
+            SDL_RWclose(wav->src);
+        }
+        SDL_free(wav->audio_buf);
+        SDL_free(wav->encoded);
+        SDL_free(wav);
+    }
+}
+
 static int
 ReadChunk(SDL_RWops * src, Chunk * chunk)
 {
@@ -20,9 +20,16 @@
 */
 #include "../../SDL_internal.h"
 
-/* Output audio to nowhere... */
+/* Output audio to nowhere...  The "bench" driver (SDL_AUDIODRIVER=bench)
+   does too, but takes each buffer as soon as it's ready instead of at the
+   rate it would play, so the callback and conversion run flat out, and
+   closing the device logs samples/s and the time spent in each.  It's only
+   there when asked for by name: SDL_GetAudioDriver() doesn't list it. */
 
 #include "SDL_audio.h"
+#include "SDL_log.h"
+#include "SDL_timer.h"
+#include "../SDL_audiomem.h"
 #include "../SDL_audio_c.h"
 #include "SDL_dummyaudio.h"
 
@@ -45,4 +52,85 @@ AudioBootStrap DUMMYAUD_bootstrap = {
     "dummy", "SDL dummy audio driver", DUMMYAUD_Init, 1
 };
 
+static void
+BENCHAUD_PlayDevice(_THIS)
+{
+    if (this->hidden->played == 0) {
+        this->hidden->start = SDL_GetPerformanceCounter();
+    }
+    this->hidden->played += this->hidden->mixlen;
+}
+
+static Uint8 *
+BENCHAUD_GetDeviceBuf(_THIS)
+{
+    return (this->hidden->mixbuf);
+}
+
+static void
+BENCHAUD_CloseDevice(_THIS)
+{
+    if (this->hidden == NULL) {
+        return;
+    }
+    if (this->hidden->played > this->hidden->mixlen) {
+        const double freq = (double) SDL_GetPerformanceFrequency();
+        const double seconds =
+            (SDL_GetPerformanceCounter() - this->hidden->start) / freq;
+        /* the first buffer was played when the clock started */
+        const double samples =
+            (double) (this->hidden->played - this->hidden->mixlen) /
+            (SDL_AUDIO_BITSIZE(this->spec.format) / 8) / this->spec.channels;
+        const double buffers =
+            (double) this->hidden->played / this->hidden->mixlen;
+
+        SDL_Log("bench audio: %.0f samples in %.3f s, %.0f samples/s "
+                "(%.1fx real time)", samples, seconds, samples / seconds,
+                samples / seconds / this->spec.freq);
+        SDL_Log("bench audio: per buffer %.1f us in the callback, "
+                "%.1f us converting", this->fill_ticks * 1e6 / freq / buffers,
+                this->convert_ticks * 1e6 / freq / buffers);
+    }
+    SDL_FreeAudioMem(this->hidden->mixbuf);
+    SDL_free(this->hidden);
+    this->hidden = NULL;
+}
+
+static int
+BENCHAUD_OpenDevice(_THIS, void *handle, const char *devname, int iscapture)
+{
+    this->hidden = (struct SDL_PrivateAudioData *)
+        SDL_calloc(1, sizeof(*this->hidden));
+    if (this->hidden == NULL) {
+        return SDL_OutOfMemory();
+    }
+    this->hidden->mixlen = this->spec.size;
+    this->hidden->mixbuf = (Uint8 *) SDL_AllocAudioMem(this->hidden->mixlen);
+    if (this->hidden->mixbuf == NULL) {
+        BENCHAUD_CloseDevice(this);
+        return SDL_OutOfMemory();
+    }
+    SDL_memset(this->hidden->mixbuf, this->spec.silence, this->spec.size);
+    this->fill_ticks = 0;
+    this->convert_ticks = 0;
+    return 0;
+}
+
+static int
+BENCHAUD_Init(SDL_AudioDriverImpl * impl)
+{
+    /* WaitDevice is left a stub: nothing to wait for */
+    impl->OpenDevice = BENCHAUD_OpenDevice;
+    impl->PlayDevice = BENCHAUD_PlayDevice;
+    impl->GetDeviceBuf = BENCHAUD_GetDeviceBuf;
+    impl->CloseDevice = BENCHAUD_CloseDevice;
+    impl->OnlyHasDefaultOutputDevice = 1;
+    impl->TimesStages = 1;
+    return 1;   /* this audio target is available. */
+}
+
+AudioBootStrap BENCHAUD_bootstrap = {
+    "bench", "SDL benchmark audio driver", BENCHAUD_Init, 1
+};
+
 /* vi: set ts=4 sw=4 expandtab: */
@@ -35,6 +35,11 @@ struct SDL_PrivateAudioData
     Uint32 mixlen;
     Uint32 write_delay;
     Uint32 initial_calls;
+
+    /* The bench driver's: performance counter at the first buffer played,
+       and bytes played since */
+    Uint64 start;
+    Uint64 played;
 };
 
 #endif /* _SDL_dummyaudio_h */
@@ -30,11 +30,17 @@
 
 /* CPU feature detection for SDL */
 
+#include "SDL_atomic.h"
 #include "SDL_cpuinfo.h"
+#include "SDL_hints.h"
 
 #ifdef HAVE_SYSCONF
 #include <unistd.h>
 #endif
+#if defined(__LINUX__) && !defined(SDL_CPUINFO_DISABLED)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #ifdef HAVE_SYSCTLBYNAME
 #include <sys/types.h>
 #include <sys/sysctl.h>
@@ -50,18 +56,6 @@
 #include <setjmp.h>
 #endif
 
-#define CPU_HAS_RDTSC   0x00000001
-#define CPU_HAS_ALTIVEC 0x00000002
-#define CPU_HAS_MMX     0x00000004
-#define CPU_HAS_3DNOW   0x00000008
-#define CPU_HAS_SSE     0x00000010
-#define CPU_HAS_SSE2    0x00000020
-#define CPU_HAS_SSE3    0x00000040
-#define CPU_HAS_SSE41   0x00000100
-#define CPU_HAS_SSE42   0x00000200
-#define CPU_HAS_AVX     0x00000400
-#define CPU_HAS_AVX2    0x00000800
-
 #if SDL_ALTIVEC_BLITTERS && HAVE_SETJMP && !__MACOSX__ && !__OpenBSD__
 /* This is the brute force way of detecting instruction sets...
    the idea is borrowed from the libmpeg2 library - thanks!
@@ -229,22 +223,23 @@ CPU_getCPUIDFeatures(void)
     return features;
 }
 
-static SDL_bool
-CPU_OSSavesYMM(void)
+/* The register state the OS saves (XCR0), 0 if it can't be read */
+static int
+CPU_getXCR0(void)
 {
     int a, b, c, d;
 
     /* Check to make sure we can call xgetbv */
     cpuid(0, a, b, c, d);
     if (a < 1) {
-        return SDL_FALSE;
+        return 0;
     }
     cpuid(1, a, b, c, d);
     if (!(c & 0x08000000)) {
-        return SDL_FALSE;
+        return 0;
     }
 
-    /* Call xgetbv to see if YMM register state is saved */
+    /* Call xgetbv to see which register state is saved */
     a = 0;
 #if defined(__GNUC__) && (defined(i386) || defined(__x86_64__))
     asm(".byte 0x0f, 0x01, 0xd0" : "=a" (a) : "c" (0) : "%edx");
@@ -258,7 +253,36 @@ CPU_OSSavesYMM(void)
         mov a, eax
     }
 #endif
-    return ((a & 6) == 6) ? SDL_TRUE : SDL_FALSE;
+    return a;
+}
+
+static SDL_bool
+CPU_OSSavesYMM(void)
+{
+    return ((CPU_getXCR0() & 6) == 6) ? SDL_TRUE : SDL_FALSE;
+}
+
+/* XMM, YMM, the opmask registers and all of ZMM */
+static SDL_bool
+CPU_OSSavesZMM(void)
+{
+    return ((CPU_getXCR0() & 0xE6) == 0xE6) ? SDL_TRUE : SDL_FALSE;
+}
+
+/* A bit of cpuid leaf 7's EBX, the extended features */
+static int
+CPU_haveExtendedFeature(int bit)
+{
+    if (CPU_haveCPUID()) {
+        int a, b, c, d;
+
+        cpuid(0, a, b, c, d);
+        if (a >= 7) {
+            cpuid(7, a, b, c, d);
+            return (b & bit);
+        }
+    }
+    return 0;
 }
 
 static int
@@ -405,17 +429,36 @@ static int
 CPU_haveAVX2(void)
 {
     if (CPU_haveCPUID() && CPU_OSSavesYMM()) {
-        int a, b, c, d;
+        return CPU_haveExtendedFeature(0x00000020);
+    }
+    return 0;
+}
 
-        cpuid(0, a, b, c, d);
-        if (a >= 7) {
-            cpuid(7, a, b, c, d);
-            return (b & 0x00000020);
-        }
+static int
+CPU_haveAVX512F(void)
+{
+    if (CPU_haveCPUID() && CPU_OSSavesZMM()) {
+        return CPU_haveExtendedFeature(0x00010000);
     }
     return 0;
 }
 
+static int
+CPU_haveBMI2(void)
+{
+    return CPU_haveExtendedFeature(0x00000100);
+}
+
+static int
+CPU_haveNEON(void)
+{
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+    return 1;   /* Always there, or required by the build */
+#else
+    return 0;
+#endif
+}
+
 static int SDL_CPUCount = 0;
 
 int
@@ -578,54 +621,93 @@ SDL_GetCPUCacheLineSize(void)
     }
 }
 
-static Uint32 SDL_CPUFeatures = 0xFFFFFFFF;
+static SDL_atomic_t SDL_CPUFeatures = { -1 };
 
+/* Detected once, then a load: the SIMD kernels are chosen with it */
 static Uint32
 SDL_GetCPUFeatures(void)
 {
-    if (SDL_CPUFeatures == 0xFFFFFFFF) {
-        SDL_CPUFeatures = 0;
-        if (CPU_haveRDTSC()) {
-            SDL_CPUFeatures |= CPU_HAS_RDTSC;
-        }
-        if (CPU_haveAltiVec()) {
-            SDL_CPUFeatures |= CPU_HAS_ALTIVEC;
-        }
-        if (CPU_haveMMX()) {
-            SDL_CPUFeatures |= CPU_HAS_MMX;
-        }
-        if (CPU_have3DNow()) {
-            SDL_CPUFeatures |= CPU_HAS_3DNOW;
-        }
-        if (CPU_haveSSE()) {
-            SDL_CPUFeatures |= CPU_HAS_SSE;
-        }
-        if (CPU_haveSSE2()) {
-            SDL_CPUFeatures |= CPU_HAS_SSE2;
-        }
-        if (CPU_haveSSE3()) {
-            SDL_CPUFeatures |= CPU_HAS_SSE3;
-        }
-        if (CPU_haveSSE41()) {
-            SDL_CPUFeatures |= CPU_HAS_SSE41;
-        }
-        if (CPU_haveSSE42()) {
-            SDL_CPUFeatures |= CPU_HAS_SSE42;
-        }
-        if (CPU_haveAVX()) {
-            SDL_CPUFeatures |= CPU_HAS_AVX;
+    Uint32 features = (Uint32) SDL_AtomicGet(&SDL_CPUFeatures);
+
+    if (features == 0xFFFFFFFF) {
+        const char *mask = SDL_GetHint(SDL_HINT_CPU_FEATURE_MASK);
+
+        features = 0;
+    if (CPU_haveRDTSC()) {
+        features |= SDL_CPUFEATURE_RDTSC;
+    }
+    if (CPU_haveAltiVec()) {
+        features |= SDL_CPUFEATURE_ALTIVEC;
+    }
+    if (CPU_haveMMX()) {
+        features |= SDL_CPUFEATURE_MMX;
+    }
+    if (CPU_have3DNow()) {
+        features |= SDL_CPUFEATURE_3DNOW;
+    }
+    if (CPU_haveSSE()) {
+        features |= SDL_CPUFEATURE_SSE;
+    }
+    if (CPU_haveSSE2()) {
+        features |= SDL_CPUFEATURE_SSE2;
+    }
+    if (CPU_haveSSE3()) {
+        features |= SDL_CPUFEATURE_SSE3;
+    }
+    if (CPU_haveSSE41()) {
+        features |= SDL_CPUFEATURE_SSE41;
+    }
+    if (CPU_haveSSE42()) {
+        features |= SDL_CPUFEATURE_SSE42;
+    }
+    if (CPU_haveAVX()) {
+        features |= SDL_CPUFEATURE_AVX;
+    }
+    if (CPU_haveAVX2()) {
+        features |= SDL_CPUFEATURE_AVX2;
+    }
+    if (CPU_haveAVX512F()) {
+        features |= SDL_CPUFEATURE_AVX512F;
+    }
+    if (CPU_haveBMI2()) {
+        features |= SDL_CPUFEATURE_BMI2;
+    }
+    if (CPU_haveNEON()) {
+        features |= SDL_CPUFEATURE_NEON;
+    }
+        if (mask && *mask) {
+            features &= (Uint32) SDL_strtoul(mask, NULL, 0);
         }
-        if (CPU_haveAVX2()) {
-            SDL_CPUFeatures |= CPU_HAS_AVX2;
+        /* Racing threads all find the same features */
+        SDL_AtomicSet(&SDL_CPUFeatures, (int) features);
+    }
+    return features;
+}
+
+Uint32
+SDL_GetCPUFeatureMask(void)
+{
+    return SDL_GetCPUFeatures();
+}
+
+int
+SDL_GetCPUVariant(const Uint32 *needs, int count)
+{
+    const Uint32 features = SDL_GetCPUFeatures();
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        if ((needs[i] & features) == needs[i]) {
+            return i;
         }
     }
-    return SDL_CPUFeatures;
+    return -1;
 }
 
 SDL_bool
 SDL_HasRDTSC(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_RDTSC) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_RDTSC) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -634,7 +716,7 @@ SDL_HasRDTSC(void)
 SDL_bool
 SDL_HasAltiVec(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_ALTIVEC) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_ALTIVEC) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -643,7 +725,7 @@ SDL_HasAltiVec(void)
 SDL_bool
 SDL_HasMMX(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_MMX) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_MMX) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -652,7 +734,7 @@ SDL_HasMMX(void)
 SDL_bool
 SDL_Has3DNow(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_3DNOW) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_3DNOW) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -661,7 +743,7 @@ SDL_Has3DNow(void)
 SDL_bool
 SDL_HasSSE(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_SSE) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_SSE) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -670,7 +752,7 @@ SDL_HasSSE(void)
 SDL_bool
 SDL_HasSSE2(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_SSE2) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_SSE2) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -679,7 +761,7 @@ SDL_HasSSE2(void)
 SDL_bool
 SDL_HasSSE3(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_SSE3) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_SSE3) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -688,7 +770,7 @@ SDL_HasSSE3(void)
 SDL_bool
 SDL_HasSSE41(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_SSE41) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_SSE41) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -697,7 +779,7 @@ SDL_HasSSE41(void)
 SDL_bool
 SDL_HasSSE42(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_SSE42) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_SSE42) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -706,7 +788,7 @@ SDL_HasSSE42(void)
 SDL_bool
 SDL_HasAVX(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_AVX) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_AVX) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -715,7 +797,34 @@ SDL_HasAVX(void)
 SDL_bool
 SDL_HasAVX2(void)
 {
-    if (SDL_GetCPUFeatures() & CPU_HAS_AVX2) {
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_AVX2) {
+        return SDL_TRUE;
+    }
+    return SDL_FALSE;
+}
+
+SDL_bool
+SDL_HasAVX512F(void)
+{
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_AVX512F) {
+        return SDL_TRUE;
+    }
+    return SDL_FALSE;
+}
+
+SDL_bool
+SDL_HasBMI2(void)
+{
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_BMI2) {
+        return SDL_TRUE;
+    }
+    return SDL_FALSE;
+}
+
+SDL_bool
+SDL_HasNEON(void)
+{
+    if (SDL_GetCPUFeatures() & SDL_CPUFEATURE_NEON) {
         return SDL_TRUE;
     }
     return SDL_FALSE;
@@ -767,6 +876,264 @@ SDL_GetSystemRAM(void)
     return SDL_SystemRAM;
 }
 
+/* The physical core and NUMA node of each logical CPU and the cache sizes,
+   found once: from sysfs on Linux and GetLogicalProcessorInformation() on
+   Windows.  Elsewhere each CPU is its own core on node 0, and the cache sizes
+   aren't known. */
+static struct
+{
+    SDL_bool probed;
+    int cores;
+    int nodes;
+    int cache[4];       /* L1 to L4, in bytes */
+    Sint16 core[SDL_CPU_TOPOLOGY_MAX];  /* -1 if there's no such CPU */
+    Sint16 node[SDL_CPU_TOPOLOGY_MAX];
+} SDL_CPUTopology;
+
+#if defined(__LINUX__) && !defined(SDL_CPUINFO_DISABLED)
+/* Reads a small sysfs file into buf, returns the bytes read or -1 */
+static int
+CPU_readSysFile(const char *path, char *buf, int len)
+{
+    int fd = open(path, O_RDONLY);
+    ssize_t n;
+
+    if (fd < 0) {
+        return -1;
+    }
+    n = read(fd, buf, len - 1);
+    close(fd);
+    if (n < 0) {
+        return -1;
+    }
+    buf[n] = '\0';
+    return (int)n;
+}
+
+static int
+CPU_readSysInt(const char *path)
+{
+    char buf[32];
+
+    if (CPU_readSysFile(path, buf, sizeof(buf)) <= 0) {
+        return -1;
+    }
+    return SDL_atoi(buf);
+}
+
+static void
+CPU_probeLinuxTopology(void)
+{
+    int packages[SDL_CPU_TOPOLOGY_MAX], ids[SDL_CPU_TOPOLOGY_MAX];
+    char path[128], buf[1024];
+    int cpu, i, node, level;
+
+    for (cpu = 0; cpu < SDL_CPU_TOPOLOGY_MAX; ++cpu) {
+        int package, id;
+
+        SDL_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        if ((id = CPU_readSysInt(path)) < 0) {
+            continue;
+        }
+        SDL_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        package = CPU_readSysInt(path);
+        /* SMT siblings have the same package and core id */
+        for (i = 0; i < SDL_CPUTopology.cores; ++i) {
+            if (packages[i] == package && ids[i] == id) {
+                break;
+            }
+        }
+        if (i == SDL_CPUTopology.cores) {
+            packages[i] = package;
+            ids[i] = id;
+            ++SDL_CPUTopology.cores;
+        }
+        SDL_CPUTopology.core[cpu] = (Sint16)i;
+    }
+
+    /* Each node lists its CPUs as ranges, "0-3,8-11" */
+    for (node = 0; node < SDL_CPU_TOPOLOGY_MAX; ++node) {
+        const char *list = buf;
+
+        SDL_snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        if (CPU_readSysFile(path, buf, sizeof(buf)) < 0) {
+            continue;
+        }
+        while (*list >= '0' && *list <= '9') {
+            char *end;
+            int first = (int)SDL_strtol(list, &end, 10), last = first;
+
+            if (*end == '-') {
+                last = (int)SDL_strtol(end + 1, &end, 10);
+            }
+            for (cpu = first; cpu <= last && cpu < SDL_CPU_TOPOLOGY_MAX; ++cpu) {
+                SDL_CPUTopology.node[cpu] = (Sint16)node;
+            }
+            list = (*end == ',') ? end + 1 : end;
+        }
+        SDL_CPUTopology.nodes = node + 1;
+    }
+
+    /* Every core has the same caches, read CPU 0's */
+    for (i = 0; ; ++i) {
+        char *unit;
+        int size;
+
+        SDL_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+        if ((level = CPU_readSysInt(path)) < 0) {
+            break;
+        }
+        SDL_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+        if (level < 1 || level > 4 ||
+            CPU_readSysFile(path, buf, sizeof(buf)) <= 0 || buf[0] == 'I') {
+            continue;   /* Instruction caches don't count */
+        }
+        SDL_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+        if (CPU_readSysFile(path, buf, sizeof(buf)) <= 0) {
+            continue;
+        }
+        size = (int)SDL_strtol(buf, &unit, 10);
+        if (*unit == 'K') {
+            size *= 1024;
+        } else if (*unit == 'M') {
+            size *= 1024 * 1024;
+        }
+        SDL_CPUTopology.cache[level - 1] = size;
+    }
+}
+#endif /* __LINUX__ */
+
+#if defined(__WIN32__) && !defined(__WINRT__) && !defined(SDL_CPUINFO_DISABLED)
+/* Only sees the first processor group, up to 64 CPUs */
+static void
+CPU_probeWindowsTopology(void)
+{
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info;
+    DWORD size = 0, i;
+
+    if (GetLogicalProcessorInformation(NULL, &size) ||
+        GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+        return;
+    }
+    info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION *) SDL_malloc(size);
+    if (!info) {
+        return;
+    }
+    if (GetLogicalProcessorInformation(info, &size)) {
+        for (i = 0; i < size / sizeof(*info); ++i) {
+            ULONG_PTR mask = info[i].ProcessorMask;
+            int cpu;
+
+            for (cpu = 0; cpu < (int)(sizeof(mask) * 8) && cpu < SDL_CPU_TOPOLOGY_MAX; ++cpu) {
+                if (!(mask & ((ULONG_PTR)1 << cpu))) {
+                    continue;
+                }
+                if (info[i].Relationship == RelationProcessorCore) {
+                    SDL_CPUTopology.core[cpu] = (Sint16)SDL_CPUTopology.cores;
+                } else if (info[i].Relationship == RelationNumaNode) {
+                    SDL_CPUTopology.node[cpu] = (Sint16)info[i].NumaNode.NodeNumber;
+                }
+            }
+            if (info[i].Relationship == RelationProcessorCore) {
+                ++SDL_CPUTopology.cores;
+            } else if (info[i].Relationship == RelationNumaNode) {
+                SDL_CPUTopology.nodes = SDL_max(SDL_CPUTopology.nodes,
+                    (int)info[i].NumaNode.NodeNumber + 1);
+            } else if (info[i].Relationship == RelationCache) {
+                CACHE_DESCRIPTOR *cache = &info[i].Cache;
+                if (cache->Level >= 1 && cache->Level <= 4 &&
+                    (cache->Type == CacheData || cache->Type == CacheUnified)) {
+                    SDL_CPUTopology.cache[cache->Level - 1] = (int)cache->Size;
+                }
+            }
+        }
+    }
+    SDL_free(info);
+}
+#endif /* __WIN32__ */
+
+static void
+SDL_ProbeCPUTopology(void)
+{
+    int cpu;
+
+    if (SDL_CPUTopology.probed) {
+        return;
+    }
+    for (cpu = 0; cpu < SDL_CPU_TOPOLOGY_MAX; ++cpu) {
+        SDL_CPUTopology.core[cpu] = -1;
+        SDL_CPUTopology.node[cpu] = -1;
+    }
+#if defined(__LINUX__) && !defined(SDL_CPUINFO_DISABLED)
+    CPU_probeLinuxTopology();
+#elif defined(__WIN32__) && !defined(__WINRT__) && !defined(SDL_CPUINFO_DISABLED)
+    CPU_probeWindowsTopology();
+#endif
+    if (SDL_CPUTopology.cores == 0) {
+        int count = SDL_min(SDL_GetCPUCount(), SDL_CPU_TOPOLOGY_MAX);
+        for (cpu = 0; cpu < count; ++cpu) {
+            SDL_CPUTopology.core[cpu] = (Sint16)cpu;
+        }
+        SDL_CPUTopology.cores = count;
+    }
+    /* CPUs no node lists (all of them, without NUMA) are on node 0 */
+    for (cpu = 0; cpu < SDL_CPU_TOPOLOGY_MAX; ++cpu) {
+        if (SDL_CPUTopology.core[cpu] < 0) {
+            SDL_CPUTopology.node[cpu] = -1;
+        } else if (SDL_CPUTopology.node[cpu] < 0) {
+            SDL_CPUTopology.node[cpu] = 0;
+        }
+    }
+    if (SDL_CPUTopology.nodes == 0) {
+        SDL_CPUTopology.nodes = 1;
+    }
+    SDL_CPUTopology.probed = SDL_TRUE;
+}
+
+int
+SDL_GetCPUCoreCount(void)
+{
+    SDL_ProbeCPUTopology();
+    return SDL_CPUTopology.cores;
+}
+
+int
+SDL_GetCPUCacheSize(int level)
+{
+    if (level < 1 || level > 4) {
+        return 0;
+    }
+    SDL_ProbeCPUTopology();
+    return SDL_CPUTopology.cache[level - 1];
+}
+
+int
+SDL_GetCPUCore(int cpu)
+{
+    if (cpu < 0 || cpu >= SDL_CPU_TOPOLOGY_MAX) {
+        return -1;
+    }
+    SDL_ProbeCPUTopology();
+    return SDL_CPUTopology.core[cpu];
+}
+
+int
+SDL_GetNUMANodeCount(void)
+{
+    SDL_ProbeCPUTopology();
+    return SDL_CPUTopology.nodes;
+}
+
+int
+SDL_GetCPUNUMANode(int cpu)
+{
+    if (cpu < 0 || cpu >= SDL_CPU_TOPOLOGY_MAX) {
+        return -1;
+    }
+    SDL_ProbeCPUTopology();
+    return SDL_CPUTopology.node[cpu];
+}
+
 
 #ifdef TEST_MAIN
 
@@ -779,6 +1146,9 @@ main()
     printf("CPU type: %s\n", SDL_GetCPUType());
     printf("CPU name: %s\n", SDL_GetCPUName());
     printf("CacheLine size: %d\n", SDL_GetCPUCacheLineSize());
+    printf("Cores: %d\n", SDL_GetCPUCoreCount());
+    printf("NUMA nodes: %d\n", SDL_GetNUMANodeCount());
+    printf("L1/L2/L3 size: %d/%d/%d\n", SDL_GetCPUCacheSize(1), SDL_GetCPUCacheSize(2), SDL_GetCPUCacheSize(3));
     printf("RDTSC: %d\n", SDL_HasRDTSC());
     printf("Altivec: %d\n", SDL_HasAltiVec());
     printf("MMX: %d\n", SDL_HasMMX());
@@ -790,6 +1160,9 @@ main()
     printf("SSE4.2: %d\n", SDL_HasSSE42());
     printf("AVX: %d\n", SDL_HasAVX());
     printf("AVX2: %d\n", SDL_HasAVX2());
+    printf("AVX-512F: %d\n", SDL_HasAVX512F());
+    printf("BMI2: %d\n", SDL_HasBMI2());
+    printf("NEON: %d\n", SDL_HasNEON());
     printf("RAM: %d MB\n", SDL_GetSystemRAM());
     return 0;
 }
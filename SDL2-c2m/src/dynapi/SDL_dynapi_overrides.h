@@ -597,3 +597,98 @@
 #define SDL_JoystickCurrentPowerLevel SDL_JoystickCurrentPowerLevel_REAL
 #define SDL_GameControllerFromInstanceID SDL_GameControllerFromInstanceID_REAL
 #define SDL_JoystickFromInstanceID SDL_JoystickFromInstanceID_REAL
+#define SDL_RWFromFileMapped SDL_RWFromFileMapped_REAL
+#define SDL_RWMappedData SDL_RWMappedData_REAL
+#define SDL_RWFromFileFD SDL_RWFromFileFD_REAL
+#define SDL_RWreadAt SDL_RWreadAt_REAL
+#define SDL_RWwriteAt SDL_RWwriteAt_REAL
+#define SDL_RWasyncCreate SDL_RWasyncCreate_REAL
+#define SDL_RWasyncRead SDL_RWasyncRead_REAL
+#define SDL_RWasyncWrite SDL_RWasyncWrite_REAL
+#define SDL_RWasyncPoll SDL_RWasyncPoll_REAL
+#define SDL_RWasyncPending SDL_RWasyncPending_REAL
+#define SDL_RWasyncDestroy SDL_RWasyncDestroy_REAL
+#define SDL_RWwritev SDL_RWwritev_REAL
+#define SDL_SpinMutexLockContended SDL_SpinMutexLockContended_REAL
+#define SDL_SpinMutexWake SDL_SpinMutexWake_REAL
+#define SDL_CreateRWLock SDL_CreateRWLock_REAL
+#define SDL_LockRWLockForReading SDL_LockRWLockForReading_REAL
+#define SDL_LockRWLockForWriting SDL_LockRWLockForWriting_REAL
+#define SDL_TryLockRWLockForReading SDL_TryLockRWLockForReading_REAL
+#define SDL_TryLockRWLockForWriting SDL_TryLockRWLockForWriting_REAL
+#define SDL_UnlockRWLock SDL_UnlockRWLock_REAL
+#define SDL_DestroyRWLock SDL_DestroyRWLock_REAL
+#define SDL_GetCPUCoreCount SDL_GetCPUCoreCount_REAL
+#define SDL_GetCPUCacheSize SDL_GetCPUCacheSize_REAL
+#define SDL_GetCPUCore SDL_GetCPUCore_REAL
+#define SDL_GetNUMANodeCount SDL_GetNUMANodeCount_REAL
+#define SDL_GetCPUNUMANode SDL_GetCPUNUMANode_REAL
+#define SDL_SetThreadAffinity SDL_SetThreadAffinity_REAL
+#define SDL_SetThreadNUMANode SDL_SetThreadNUMANode_REAL
+#define SDL_GetSlabStats SDL_GetSlabStats_REAL
+#define SDL_GetMemoryStats SDL_GetMemoryStats_REAL
+#define SDL_utf8_validate SDL_utf8_validate_REAL
+#define SDL_qsort_r SDL_qsort_r_REAL
+#define SDL_qsort_int32 SDL_qsort_int32_REAL
+#define SDL_qsort_int64 SDL_qsort_int64_REAL
+#define SDL_qsort_float SDL_qsort_float_REAL
+#define SDL_qsort_double SDL_qsort_double_REAL
+#define SDL_qsort_pointer SDL_qsort_pointer_REAL
+#define SDL_LogSetAsync SDL_LogSetAsync_REAL
+#define SDL_LogFlush SDL_LogFlush_REAL
+#define SDL_SoftStretchFiltered SDL_SoftStretchFiltered_REAL
+#define SDL_RenderFlush SDL_RenderFlush_REAL
+#define SDL_SetTexturePixels SDL_SetTexturePixels_REAL
+#define SDL_NewAudioResampler SDL_NewAudioResampler_REAL
+#define SDL_ResampleAudio SDL_ResampleAudio_REAL
+#define SDL_FreeAudioResampler SDL_FreeAudioResampler_REAL
+#define SDL_NewAudioStream SDL_NewAudioStream_REAL
+#define SDL_AudioStreamPut SDL_AudioStreamPut_REAL
+#define SDL_AudioStreamGet SDL_AudioStreamGet_REAL
+#define SDL_AudioStreamAvailable SDL_AudioStreamAvailable_REAL
+#define SDL_AudioStreamFlush SDL_AudioStreamFlush_REAL
+#define SDL_AudioStreamClear SDL_AudioStreamClear_REAL
+#define SDL_FreeAudioStream SDL_FreeAudioStream_REAL
+#define SDL_MixAudioMany SDL_MixAudioMany_REAL
+#define SDL_GetQueuedAudioLatency SDL_GetQueuedAudioLatency_REAL
+#define SDL_GetQueuedAudioUnderruns SDL_GetQueuedAudioUnderruns_REAL
+#define SDL_OpenWAV_RW SDL_OpenWAV_RW_REAL
+#define SDL_GetWAVData SDL_GetWAVData_REAL
+#define SDL_ReadWAV SDL_ReadWAV_REAL
+#define SDL_SeekWAV SDL_SeekWAV_REAL
+#define SDL_CloseWAV SDL_CloseWAV_REAL
+#define SDL_PollEvents SDL_PollEvents_REAL
+#define SDL_LoadBMPs SDL_LoadBMPs_REAL
+#define SDL_GetHintValue SDL_GetHintValue_REAL
+#define SDL_GetFastPerformanceCounter SDL_GetFastPerformanceCounter_REAL
+#define SDL_GetFastPerformanceFrequency SDL_GetFastPerformanceFrequency_REAL
+#define SDL_DelayPrecise SDL_DelayPrecise_REAL
+#define SDL_CreateFramePacer SDL_CreateFramePacer_REAL
+#define SDL_FramePacerWait SDL_FramePacerWait_REAL
+#define SDL_DestroyFramePacer SDL_DestroyFramePacer_REAL
+#define SDL_HasAVX512F SDL_HasAVX512F_REAL
+#define SDL_HasBMI2 SDL_HasBMI2_REAL
+#define SDL_HasNEON SDL_HasNEON_REAL
+#define SDL_GetCPUFeatureMask SDL_GetCPUFeatureMask_REAL
+#define SDL_GetCPUVariant SDL_GetCPUVariant_REAL
+#define SDL_RWFromSocket SDL_RWFromSocket_REAL
+#define SDL_RWFromTCP SDL_RWFromTCP_REAL
+#define SDL_RWcopy SDL_RWcopy_REAL
+#define SDL_RWreaderCreate SDL_RWreaderCreate_REAL
+#define SDL_RWreadRecord SDL_RWreadRecord_REAL
+#define SDL_RWreadLine SDL_RWreadLine_REAL
+#define SDL_RWreaderDestroy SDL_RWreaderDestroy_REAL
+#define SDL_AcquireSurface SDL_AcquireSurface_REAL
+#define SDL_ReleaseSurface SDL_ReleaseSurface_REAL
+#define SDL_FlushSurfacePool SDL_FlushSurfacePool_REAL
+#define SDL_CreateCounter SDL_CreateCounter_REAL
+#define SDL_CreateHistogram SDL_CreateHistogram_REAL
+#define SDL_CounterAdd SDL_CounterAdd_REAL
+#define SDL_HistogramRecord SDL_HistogramRecord_REAL
+#define SDL_GetMetricCount SDL_GetMetricCount_REAL
+#define SDL_GetMetricQuantile SDL_GetMetricQuantile_REAL
+#define SDL_WriteMetrics SDL_WriteMetrics_REAL
+#define SDL_RWjournalOpen SDL_RWjournalOpen_REAL
+#define SDL_RWjournalAppend SDL_RWjournalAppend_REAL
+#define SDL_RWjournalSync SDL_RWjournalSync_REAL
+#define SDL_RWjournalClose SDL_RWjournalClose_REAL
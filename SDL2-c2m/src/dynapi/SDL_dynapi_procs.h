@@ -631,3 +631,100 @@ SDL_DYNAPI_PROC(int,SDL_GetDisplayDPI,(int a, float *b, float *c, float *d),(a,b
 SDL_DYNAPI_PROC(SDL_JoystickPowerLevel,SDL_JoystickCurrentPowerLevel,(SDL_Joystick *a),(a),return)
 SDL_DYNAPI_PROC(SDL_GameController*,SDL_GameControllerFromInstanceID,(SDL_JoystickID a),(a),return)
 SDL_DYNAPI_PROC(SDL_Joystick*,SDL_JoystickFromInstanceID,(SDL_JoystickID a),(a),return)
+SDL_DYNAPI_PROC(SDL_RWops*,SDL_RWFromFileMapped,(const char *a),(a),return)
+SDL_DYNAPI_PROC(const void*,SDL_RWMappedData,(SDL_RWops *a, size_t *b),(a,b),return)
+SDL_DYNAPI_PROC(SDL_RWops*,SDL_RWFromFileFD,(const char *a, const char *b, size_t c),(a,b,c),return)
+SDL_DYNAPI_PROC(size_t,SDL_RWreadAt,(SDL_RWops *a, void *b, size_t c, size_t d, Sint64 e),(a,b,c,d,e),return)
+SDL_DYNAPI_PROC(size_t,SDL_RWwriteAt,(SDL_RWops *a, const void *b, size_t c, size_t d, Sint64 e),(a,b,c,d,e),return)
+SDL_DYNAPI_PROC(SDL_RWasync*,SDL_RWasyncCreate,(int a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_RWasyncRead,(SDL_RWasync *a, SDL_RWops *b, void *c, size_t d, Sint64 e, SDL_RWasyncCallback f, void *g),(a,b,c,d,e,f,g),return)
+SDL_DYNAPI_PROC(int,SDL_RWasyncWrite,(SDL_RWasync *a, SDL_RWops *b, const void *c, size_t d, Sint64 e, SDL_RWasyncCallback f, void *g),(a,b,c,d,e,f,g),return)
+SDL_DYNAPI_PROC(int,SDL_RWasyncPoll,(SDL_RWasync *a, SDL_bool b),(a,b),return)
+SDL_DYNAPI_PROC(int,SDL_RWasyncPending,(SDL_RWasync *a),(a),return)
+SDL_DYNAPI_PROC(void,SDL_RWasyncDestroy,(SDL_RWasync *a),(a),)
+SDL_DYNAPI_PROC(size_t,SDL_RWwritev,(SDL_RWops *a, const SDL_RWiovec *b, int c),(a,b,c),return)
+#ifdef SDL_HAS_NATIVE_ATOMICS
+SDL_DYNAPI_PROC(void,SDL_SpinMutexLockContended,(SDL_SpinMutex *a),(a),)
+SDL_DYNAPI_PROC(void,SDL_SpinMutexWake,(SDL_SpinMutex *a),(a),)
+#endif
+SDL_DYNAPI_PROC(SDL_rwlock*,SDL_CreateRWLock,(void),(),return)
+SDL_DYNAPI_PROC(int,SDL_LockRWLockForReading,(SDL_rwlock *a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_LockRWLockForWriting,(SDL_rwlock *a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_TryLockRWLockForReading,(SDL_rwlock *a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_TryLockRWLockForWriting,(SDL_rwlock *a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_UnlockRWLock,(SDL_rwlock *a),(a),return)
+SDL_DYNAPI_PROC(void,SDL_DestroyRWLock,(SDL_rwlock *a),(a),)
+SDL_DYNAPI_PROC(int,SDL_GetCPUCoreCount,(void),(),return)
+SDL_DYNAPI_PROC(int,SDL_GetCPUCacheSize,(int a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_GetCPUCore,(int a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_GetNUMANodeCount,(void),(),return)
+SDL_DYNAPI_PROC(int,SDL_GetCPUNUMANode,(int a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_SetThreadAffinity,(const int *a, int b),(a,b),return)
+SDL_DYNAPI_PROC(int,SDL_SetThreadNUMANode,(int a),(a),return)
+SDL_DYNAPI_PROC(void,SDL_GetSlabStats,(SDL_SlabStats *a),(a),)
+SDL_DYNAPI_PROC(void,SDL_GetMemoryStats,(SDL_MemoryStats *a),(a),)
+SDL_DYNAPI_PROC(SDL_bool,SDL_utf8_validate,(const char *a, size_t b),(a,b),return)
+SDL_DYNAPI_PROC(void,SDL_qsort_r,(void *a, size_t b, size_t c, int (SDLCALL *d)(void *, const void *, const void *), void *e),(a,b,c,d,e),)
+SDL_DYNAPI_PROC(void,SDL_qsort_int32,(Sint32 *a, size_t b),(a,b),)
+SDL_DYNAPI_PROC(void,SDL_qsort_int64,(Sint64 *a, size_t b),(a,b),)
+SDL_DYNAPI_PROC(void,SDL_qsort_float,(float *a, size_t b),(a,b),)
+SDL_DYNAPI_PROC(void,SDL_qsort_double,(double *a, size_t b),(a,b),)
+SDL_DYNAPI_PROC(void,SDL_qsort_pointer,(void **a, size_t b),(a,b),)
+SDL_DYNAPI_PROC(int,SDL_LogSetAsync,(SDL_bool a),(a),return)
+SDL_DYNAPI_PROC(void,SDL_LogFlush,(void),(),)
+SDL_DYNAPI_PROC(int,SDL_SoftStretchFiltered,(SDL_Surface *a, const SDL_Rect *b, SDL_Surface *c, const SDL_Rect *d, SDL_StretchFilter e),(a,b,c,d,e),return)
+SDL_DYNAPI_PROC(int,SDL_RenderFlush,(SDL_Renderer *a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_SetTexturePixels,(SDL_Texture *a, void *b, int c),(a,b,c),return)
+SDL_DYNAPI_PROC(SDL_AudioResampler*,SDL_NewAudioResampler,(SDL_AudioFormat a, Uint8 b, int c, int d),(a,b,c,d),return)
+SDL_DYNAPI_PROC(int,SDL_ResampleAudio,(SDL_AudioResampler *a, const void *b, int c, void *d, int e),(a,b,c,d,e),return)
+SDL_DYNAPI_PROC(void,SDL_FreeAudioResampler,(SDL_AudioResampler *a),(a),)
+SDL_DYNAPI_PROC(SDL_AudioStream*,SDL_NewAudioStream,(SDL_AudioFormat a, Uint8 b, int c, SDL_AudioFormat d, Uint8 e, int f),(a,b,c,d,e,f),return)
+SDL_DYNAPI_PROC(int,SDL_AudioStreamPut,(SDL_AudioStream *a, const void *b, int c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_AudioStreamGet,(SDL_AudioStream *a, void *b, int c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_AudioStreamAvailable,(SDL_AudioStream *a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_AudioStreamFlush,(SDL_AudioStream *a),(a),return)
+SDL_DYNAPI_PROC(void,SDL_AudioStreamClear,(SDL_AudioStream *a),(a),)
+SDL_DYNAPI_PROC(void,SDL_FreeAudioStream,(SDL_AudioStream *a),(a),)
+SDL_DYNAPI_PROC(void,SDL_MixAudioMany,(Uint8 *a, const Uint8 * const *b, const int *c, int d, SDL_AudioFormat e, Uint32 f),(a,b,c,d,e,f),)
+SDL_DYNAPI_PROC(Uint32,SDL_GetQueuedAudioLatency,(SDL_AudioDeviceID a),(a),return)
+SDL_DYNAPI_PROC(Uint32,SDL_GetQueuedAudioUnderruns,(SDL_AudioDeviceID a),(a),return)
+SDL_DYNAPI_PROC(SDL_WAV*,SDL_OpenWAV_RW,(SDL_RWops *a, int b, SDL_AudioSpec *c, Uint32 *d),(a,b,c,d),return)
+SDL_DYNAPI_PROC(const Uint8*,SDL_GetWAVData,(SDL_WAV *a, Uint32 *b),(a,b),return)
+SDL_DYNAPI_PROC(Uint32,SDL_ReadWAV,(SDL_WAV *a, void *b, Uint32 c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_SeekWAV,(SDL_WAV *a, Uint32 b),(a,b),return)
+SDL_DYNAPI_PROC(void,SDL_CloseWAV,(SDL_WAV *a),(a),)
+SDL_DYNAPI_PROC(int,SDL_PollEvents,(SDL_Event *a, int b),(a,b),return)
+SDL_DYNAPI_PROC(int,SDL_LoadBMPs,(const char **a, int b, SDL_Surface **c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_GetHintValue,(SDL_HintHandle *a),(a),return)
+SDL_DYNAPI_PROC(Uint64,SDL_GetFastPerformanceCounter,(void),(),return)
+SDL_DYNAPI_PROC(Uint64,SDL_GetFastPerformanceFrequency,(void),(),return)
+SDL_DYNAPI_PROC(void,SDL_DelayPrecise,(Uint64 a),(a),)
+SDL_DYNAPI_PROC(SDL_FramePacer*,SDL_CreateFramePacer,(Uint64 a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_FramePacerWait,(SDL_FramePacer *a),(a),return)
+SDL_DYNAPI_PROC(void,SDL_DestroyFramePacer,(SDL_FramePacer *a),(a),)
+SDL_DYNAPI_PROC(SDL_bool,SDL_HasAVX512F,(void),(),return)
+SDL_DYNAPI_PROC(SDL_bool,SDL_HasBMI2,(void),(),return)
+SDL_DYNAPI_PROC(SDL_bool,SDL_HasNEON,(void),(),return)
+SDL_DYNAPI_PROC(Uint32,SDL_GetCPUFeatureMask,(void),(),return)
+SDL_DYNAPI_PROC(int,SDL_GetCPUVariant,(const Uint32 *a, int b),(a,b),return)
+SDL_DYNAPI_PROC(SDL_RWops*,SDL_RWFromSocket,(int a, SDL_bool b),(a,b),return)
+SDL_DYNAPI_PROC(SDL_RWops*,SDL_RWFromTCP,(const char *a, Uint16 b),(a,b),return)
+SDL_DYNAPI_PROC(Sint64,SDL_RWcopy,(SDL_RWops *a, SDL_RWops *b, Sint64 c),(a,b,c),return)
+SDL_DYNAPI_PROC(SDL_RWreader*,SDL_RWreaderCreate,(SDL_RWops *a, size_t b),(a,b),return)
+SDL_DYNAPI_PROC(const char*,SDL_RWreadRecord,(SDL_RWreader *a, char b, size_t *c),(a,b,c),return)
+SDL_DYNAPI_PROC(const char*,SDL_RWreadLine,(SDL_RWreader *a, size_t *b),(a,b),return)
+SDL_DYNAPI_PROC(void,SDL_RWreaderDestroy,(SDL_RWreader *a),(a),)
+SDL_DYNAPI_PROC(SDL_Surface*,SDL_AcquireSurface,(int a, int b, Uint32 c),(a,b,c),return)
+SDL_DYNAPI_PROC(void,SDL_ReleaseSurface,(SDL_Surface *a),(a),)
+SDL_DYNAPI_PROC(void,SDL_FlushSurfacePool,(void),(),)
+SDL_DYNAPI_PROC(SDL_Metric*,SDL_CreateCounter,(const char *a, const char *b),(a,b),return)
+SDL_DYNAPI_PROC(SDL_Metric*,SDL_CreateHistogram,(const char *a, const char *b),(a,b),return)
+SDL_DYNAPI_PROC(void,SDL_CounterAdd,(SDL_Metric *a, Sint64 b),(a,b),)
+SDL_DYNAPI_PROC(void,SDL_HistogramRecord,(SDL_Metric *a, Uint64 b),(a,b),)
+SDL_DYNAPI_PROC(Sint64,SDL_GetMetricCount,(SDL_Metric *a),(a),return)
+SDL_DYNAPI_PROC(Uint64,SDL_GetMetricQuantile,(SDL_Metric *a, double b),(a,b),return)
+SDL_DYNAPI_PROC(int,SDL_WriteMetrics,(SDL_RWops *a),(a),return)
+SDL_DYNAPI_PROC(SDL_RWjournal*,SDL_RWjournalOpen,(const char *a, size_t b, Uint32 c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_RWjournalAppend,(SDL_RWjournal *a, const void *b, size_t c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_RWjournalSync,(SDL_RWjournal *a),(a),return)
+SDL_DYNAPI_PROC(void,SDL_RWjournalClose,(SDL_RWjournal *a),(a),)
@@ -36,6 +36,17 @@
 /* An arbitrary limit so we don't have unbounded growth */
 #define SDL_MAX_QUEUED_EVENTS   65535
 
+/* Events pushed from any thread go into a lock-free ring first, and whoever
+   next holds the queue lock moves them onto the queue itself; only when the
+   ring is full does pushing take the lock. */
+#if defined(SDL_HAS_NATIVE_ATOMICS) && !SDL_THREADS_DISABLED
+#define SDL_EVENT_RING          1
+#define SDL_EVENT_RING_SIZE     1024    /* a power of two */
+#endif
+
+/* Whether SDL_PushCoalescedEvent() merges into the last queued event */
+static SDL_bool SDL_coalesce_events = SDL_FALSE;
+
 /* Public data -- the event filter */
 SDL_EventFilter SDL_EventOK = NULL;
 void *SDL_EventOKParam;
@@ -70,6 +81,24 @@ typedef struct _SDL_SysWMEntry
     struct _SDL_SysWMEntry *next;
 } SDL_SysWMEntry;
 
+#ifdef SDL_EVENT_RING
+/* A slot's sequence is its position when it's free to write, one past that
+   once it's written, and its next lap's position once it's been read */
+typedef struct _SDL_EventSlot
+{
+    SDL_atomic_t sequence;
+    SDL_Event event;
+} SDL_EventSlot;
+
+typedef struct _SDL_EventRing
+{
+    SDL_atomic_t write;         /* next position to claim, by any thread */
+    char pad[64 - sizeof(SDL_atomic_t)];  /* keep writers off the reader's line */
+    Uint32 read;                /* next position to read, with the lock held */
+    SDL_EventSlot slots[SDL_EVENT_RING_SIZE];
+} SDL_EventRing;
+#endif
+
 static struct
 {
     SDL_mutex *lock;
@@ -81,8 +110,104 @@ static struct
     SDL_EventEntry *free;
     SDL_SysWMEntry *wmmsg_used;
     SDL_SysWMEntry *wmmsg_free;
+#ifdef SDL_EVENT_RING
+    SDL_EventRing *ring;
+#endif
 } SDL_EventQ = { NULL, SDL_TRUE, 0, 0, NULL, NULL, NULL, NULL, NULL };
 
+static int SDL_AddEvent(SDL_Event * event);
+
+#ifdef SDL_EVENT_RING
+/* Put an event in the ring without taking the lock; 0 if it's full */
+static int
+SDL_PushEventRing(const SDL_Event * event)
+{
+    SDL_EventRing *ring = (SDL_EventRing *) SDL_AtomicLoadPtr((void **) &SDL_EventQ.ring, SDL_MEMORY_ORDER_ACQUIRE);
+    SDL_EventSlot *slot;
+    int pos, diff;
+
+    /* The syswm message lives in the queue entry, so those go the slow way */
+    if (!ring || event->type == SDL_SYSWMEVENT) {
+        return 0;
+    }
+    pos = SDL_AtomicLoad(&ring->write, SDL_MEMORY_ORDER_RELAXED);
+    for (;;) {
+        slot = &ring->slots[pos & (SDL_EVENT_RING_SIZE - 1)];
+        diff = SDL_AtomicLoad(&slot->sequence, SDL_MEMORY_ORDER_ACQUIRE) - pos;
+        if (diff == 0) {
+            if (SDL_AtomicCompareExchange(&ring->write, &pos, pos + 1, SDL_MEMORY_ORDER_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 0;  /* a lap ahead of the reader: the ring is full */
+        } else {
+            pos = SDL_AtomicLoad(&ring->write, SDL_MEMORY_ORDER_RELAXED);
+        }
+    }
+    slot->event = *event;
+    SDL_AtomicStore(&slot->sequence, pos + 1, SDL_MEMORY_ORDER_RELEASE);
+    return 1;
+}
+
+/* Move the ring's events onto the queue -- called with the queue locked.
+   An event still being written stops it; it and those after it are moved
+   next time. */
+static void
+SDL_DrainEventRing(void)
+{
+    SDL_EventRing *ring = SDL_EventQ.ring;
+    SDL_EventSlot *slot;
+
+    if (!ring) {
+        return;
+    }
+    for (;;) {
+        slot = &ring->slots[ring->read & (SDL_EVENT_RING_SIZE - 1)];
+        if (SDL_AtomicLoad(&slot->sequence, SDL_MEMORY_ORDER_ACQUIRE) != (int) (ring->read + 1)) {
+            break;
+        }
+        SDL_AddEvent(&slot->event);
+        SDL_AtomicStore(&slot->sequence, (int) (ring->read + SDL_EVENT_RING_SIZE), SDL_MEMORY_ORDER_RELEASE);
+        ++ring->read;
+    }
+}
+
+static void
+SDL_CreateEventRing(void)
+{
+    SDL_EventRing *ring;
+    int i;
+
+    if (SDL_EventQ.ring) {
+        return;
+    }
+    ring = (SDL_EventRing *) SDL_malloc(sizeof(*ring));
+    if (!ring) {
+        return;  /* no matter, every push takes the lock */
+    }
+    SDL_AtomicStore(&ring->write, 0, SDL_MEMORY_ORDER_RELAXED);
+    ring->read = 0;
+    for (i = 0; i < SDL_EVENT_RING_SIZE; ++i) {
+        SDL_AtomicStore(&ring->slots[i].sequence, i, SDL_MEMORY_ORDER_RELAXED);
+    }
+    SDL_AtomicStorePtr((void **) &SDL_EventQ.ring, ring, SDL_MEMORY_ORDER_RELEASE);
+}
+#else
+#define SDL_PushEventRing(event) 0
+#define SDL_DrainEventRing()
+#define SDL_CreateEventRing()
+#endif /* SDL_EVENT_RING */
+
+static void
+SDL_EventCoalescingChanged(void *userdata, const char *name, const char *oldValue, const char *hint)
+{
+    if (hint && *hint == '1') {
+        SDL_coalesce_events = SDL_TRUE;
+    } else {
+        SDL_coalesce_events = SDL_FALSE;
+    }
+}
+
 
 /* Public functions */
 
@@ -100,12 +225,18 @@ SDL_StopEventLoop(void)
 
     SDL_EventQ.active = SDL_FALSE;
 
+    SDL_DelHintCallback(SDL_HINT_EVENT_COALESCING,
+                        SDL_EventCoalescingChanged, NULL);
+
     if (report && SDL_atoi(report)) {
         SDL_Log("SDL EVENT QUEUE: Maximum events in-flight: %d\n",
                 SDL_EventQ.max_events_seen);
     }
 
     /* Clean out EventQ */
+#ifdef SDL_EVENT_RING
+    SDL_free(SDL_AtomicExchangePtr((void **) &SDL_EventQ.ring, NULL, SDL_MEMORY_ORDER_ACQ_REL));
+#endif
     for (entry = SDL_EventQ.head; entry; ) {
         SDL_EventEntry *next = entry->next;
         SDL_free(entry);
@@ -174,6 +305,11 @@ SDL_StartEventLoop(void)
         return (-1);
     }
 #endif /* !SDL_THREADS_DISABLED */
+    SDL_CreateEventRing();
+
+    /* See if bursts of motion and window events should be merged */
+    SDL_AddHintCallback(SDL_HINT_EVENT_COALESCING,
+                        SDL_EventCoalescingChanged, NULL);
 
     /* Process most event types */
     SDL_EventState(SDL_TEXTINPUT, SDL_DISABLE);
@@ -275,11 +411,23 @@ SDL_PeepEvents(SDL_Event * events, int numevents, SDL_eventaction action,
         }
         return (-1);
     }
-    /* Lock the event queue */
+    /* Add what fits in the ring without locking */
     used = 0;
+    if (action == SDL_ADDEVENT) {
+        while (used < numevents && SDL_PushEventRing(&events[used])) {
+            ++used;
+        }
+        if (used == numevents) {
+            return (used);
+        }
+    }
+
+    /* Lock the event queue */
     if (!SDL_EventQ.lock || SDL_LockMutex(SDL_EventQ.lock) == 0) {
+        /* Everything in the ring came before anything we add or look at */
+        SDL_DrainEventRing();
         if (action == SDL_ADDEVENT) {
-            for (i = 0; i < numevents; ++i) {
+            for (i = used; i < numevents; ++i) {
                 used += SDL_AddEvent(&events[i]);
             }
         } else {
@@ -379,6 +527,7 @@ SDL_FlushEvents(Uint32 minType, Uint32 maxType)
     if (SDL_LockMutex(SDL_EventQ.lock) == 0) {
         SDL_EventEntry *entry, *next;
         Uint32 type;
+        SDL_DrainEventRing();
         for (entry = SDL_EventQ.head; entry; entry = next) {
             next = entry->next;
             type = entry->event.type;
@@ -418,6 +567,13 @@ SDL_PollEvent(SDL_Event * event)
     return SDL_WaitEventTimeout(event, 0);
 }
 
+int
+SDL_PollEvents(SDL_Event * events, int numevents)
+{
+    SDL_PumpEvents();
+    return SDL_PeepEvents(events, numevents, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+}
+
 int
 SDL_WaitEvent(SDL_Event * event)
 {
@@ -478,6 +634,83 @@ SDL_PushEvent(SDL_Event * event)
     return 1;
 }
 
+/* Merge an event into the one queued just before it, if it only updates it */
+static SDL_bool
+SDL_CoalesceEvent(SDL_Event * last, const SDL_Event * event)
+{
+    if (last->type != event->type) {
+        return SDL_FALSE;
+    }
+    switch (event->type) {
+    case SDL_MOUSEMOTION:
+        if (last->motion.windowID != event->motion.windowID ||
+            last->motion.which != event->motion.which ||
+            last->motion.state != event->motion.state) {
+            return SDL_FALSE;
+        }
+        last->motion.timestamp = event->motion.timestamp;
+        last->motion.x = event->motion.x;
+        last->motion.y = event->motion.y;
+        last->motion.xrel += event->motion.xrel;
+        last->motion.yrel += event->motion.yrel;
+        return SDL_TRUE;
+    case SDL_WINDOWEVENT:
+        if (last->window.windowID != event->window.windowID ||
+            last->window.event != event->window.event) {
+            return SDL_FALSE;
+        }
+        switch (event->window.event) {
+        case SDL_WINDOWEVENT_EXPOSED:
+        case SDL_WINDOWEVENT_MOVED:
+        case SDL_WINDOWEVENT_RESIZED:
+        case SDL_WINDOWEVENT_SIZE_CHANGED:
+            last->window = event->window;
+            return SDL_TRUE;
+        default:
+            return SDL_FALSE;
+        }
+    default:
+        return SDL_FALSE;
+    }
+}
+
+/* Like SDL_PushEvent(), but with SDL_HINT_EVENT_COALESCING set, an event
+   that only updates the last one queued (more motion of the same mouse,
+   a newer size for the same window) is merged into it instead */
+int
+SDL_PushCoalescedEvent(SDL_Event * event)
+{
+    SDL_EventWatcher *curr;
+    int posted;
+
+    if (!SDL_coalesce_events || !SDL_EventQ.lock) {
+        return SDL_PushEvent(event);
+    }
+
+    event->common.timestamp = SDL_GetTicks();
+
+    if (SDL_EventOK && !SDL_EventOK(SDL_EventOKParam, event)) {
+        return 0;
+    }
+
+    for (curr = SDL_event_watchers; curr; curr = curr->next) {
+        curr->callback(curr->userdata, event);
+    }
+
+    if (!SDL_EventQ.active || SDL_LockMutex(SDL_EventQ.lock) < 0) {
+        return -1;
+    }
+    SDL_DrainEventRing();
+    if (SDL_EventQ.tail && SDL_CoalesceEvent(&SDL_EventQ.tail->event, event)) {
+        posted = 1;
+    } else {
+        posted = SDL_AddEvent(event);
+    }
+    SDL_UnlockMutex(SDL_EventQ.lock);
+
+    return posted ? 1 : -1;
+}
+
 void
 SDL_SetEventFilter(SDL_EventFilter filter, void *userdata)
 {
@@ -553,6 +786,7 @@ SDL_FilterEvents(SDL_EventFilter filter, void *userdata)
 {
     if (SDL_EventQ.lock && SDL_LockMutex(SDL_EventQ.lock) == 0) {
         SDL_EventEntry *entry, *next;
+        SDL_DrainEventRing();
         for (entry = SDL_EventQ.head; entry; entry = next) {
             next = entry->next;
             if (!filter(userdata, &entry->event)) {
@@ -27,6 +27,12 @@
 #include "SDL_endian.h"
 #include "SDL_events_c.h"
 #include "SDL_gesture_c.h"
+#include "../video/SDL_blit.h"
+
+#if defined(__GNUC__) && defined(__SSE__)
+#define SDL_GESTURE_SSE 1
+#include <xmmintrin.h>
+#endif
 
 /*
 #include <stdio.h>
@@ -54,8 +60,16 @@ typedef struct {
     SDL_FloatPoint p[MAXPATHSIZE];
 } SDL_DollarPath;
 
+/* A normalized path, the coordinates apart so they can be taken 4 at a
+   time; r is each point's distance from the centroid */
 typedef struct {
-    SDL_FloatPoint path[DOLLARNPOINTS];
+    float x[DOLLARNPOINTS];
+    float y[DOLLARNPOINTS];
+    float r[DOLLARNPOINTS];
+} SDL_DollarShape;
+
+typedef struct {
+    SDL_DollarShape shape;
     unsigned long hash;
 } SDL_DollarTemplate;
 
@@ -113,8 +127,21 @@ static unsigned long SDL_HashDollar(SDL_FloatPoint* points)
 }
 
 
+static void SDL_MakeDollarShape(const SDL_FloatPoint *path, SDL_DollarShape *shape)
+{
+    int i;
+    for (i = 0; i < DOLLARNPOINTS; i++) {
+        shape->x[i] = path[i].x;
+        shape->y[i] = path[i].y;
+        shape->r[i] = (float)SDL_sqrt(path[i].x*path[i].x + path[i].y*path[i].y);
+    }
+}
+
 static int SaveTemplate(SDL_DollarTemplate *templ, SDL_RWops *dst)
 {
+    SDL_FloatPoint path[DOLLARNPOINTS];
+    int i;
+
     if (dst == NULL) {
         return 0;
     }
@@ -122,27 +149,15 @@ static int SaveTemplate(SDL_DollarTemplate *templ, SDL_RWops *dst)
     /* No Longer storing the Hash, rehash on load */
     /* if (SDL_RWops.write(dst, &(templ->hash), sizeof(templ->hash), 1) != 1) return 0; */
 
-#if SDL_BYTEORDER == SDL_LIL_ENDIAN
-    if (SDL_RWwrite(dst, templ->path,
-                    sizeof(templ->path[0]),DOLLARNPOINTS) != DOLLARNPOINTS) {
-        return 0;
+    /* Saved as x,y pairs */
+    for (i = 0; i < DOLLARNPOINTS; i++) {
+        path[i].x = SDL_SwapFloatLE(templ->shape.x[i]);
+        path[i].y = SDL_SwapFloatLE(templ->shape.y[i]);
     }
-#else
-    {
-        SDL_DollarTemplate copy = *templ;
-        SDL_FloatPoint *p = copy.path;
-        int i;
-        for (i = 0; i < DOLLARNPOINTS; i++, p++) {
-            p->x = SDL_SwapFloatLE(p->x);
-            p->y = SDL_SwapFloatLE(p->y);
-        }
-
-        if (SDL_RWwrite(dst, copy.path,
-                        sizeof(copy.path[0]),DOLLARNPOINTS) != DOLLARNPOINTS) {
-            return 0;
-        }
+    if (SDL_RWwrite(dst, path,
+                    sizeof(path[0]),DOLLARNPOINTS) != DOLLARNPOINTS) {
+        return 0;
     }
-#endif
 
     return 1;
 }
@@ -193,8 +208,8 @@ static int SDL_AddDollarGesture_one(SDL_GestureTouch* inTouch, SDL_FloatPoint* p
     inTouch->dollarTemplate = dollarTemplate;
 
     templ = &inTouch->dollarTemplate[index];
-    SDL_memcpy(templ->path, path, DOLLARNPOINTS*sizeof(SDL_FloatPoint));
-    templ->hash = SDL_HashDollar(templ->path);
+    SDL_MakeDollarShape(path, &templ->shape);
+    templ->hash = SDL_HashDollar(path);
     inTouch->numDollarTemplates++;
 
     return index;
@@ -235,9 +250,9 @@ int SDL_LoadDollarTemplates(SDL_TouchID touchId, SDL_RWops *src)
     }
 
     while (1) {
-        SDL_DollarTemplate templ;
+        SDL_FloatPoint path[DOLLARNPOINTS];
 
-        if (SDL_RWread(src,templ.path,sizeof(templ.path[0]),DOLLARNPOINTS) < DOLLARNPOINTS) {
+        if (SDL_RWread(src,path,sizeof(path[0]),DOLLARNPOINTS) < DOLLARNPOINTS) {
             if (loaded == 0) {
                 return SDL_SetError("could not read any dollar gesture from rwops");
             }
@@ -246,7 +261,7 @@ int SDL_LoadDollarTemplates(SDL_TouchID touchId, SDL_RWops *src)
 
 #if SDL_BYTEORDER != SDL_LIL_ENDIAN
         for (i = 0; i < DOLLARNPOINTS; i++) {
-            SDL_FloatPoint *p = &templ.path[i];
+            SDL_FloatPoint *p = &path[i];
             p->x = SDL_SwapFloatLE(p->x);
             p->y = SDL_SwapFloatLE(p->y);
         }
@@ -254,7 +269,7 @@ int SDL_LoadDollarTemplates(SDL_TouchID touchId, SDL_RWops *src)
 
         if (touchId >= 0) {
             /* printf("Adding loaded gesture to 1 touch\n"); */
-            if (SDL_AddDollarGesture(touch, templ.path) >= 0)
+            if (SDL_AddDollarGesture(touch, path) >= 0)
                 loaded++;
         }
         else {
@@ -263,7 +278,7 @@ int SDL_LoadDollarTemplates(SDL_TouchID touchId, SDL_RWops *src)
                 touch = &SDL_gestureTouch[i];
                 /* printf("Adding loaded gesture to + touches\n"); */
                 /* TODO: What if this fails? */
-                SDL_AddDollarGesture(touch,templ.path);
+                SDL_AddDollarGesture(touch,path);
             }
             loaded++;
         }
@@ -273,23 +288,63 @@ int SDL_LoadDollarTemplates(SDL_TouchID touchId, SDL_RWops *src)
 }
 
 
-static float dollarDifference(SDL_FloatPoint* points,SDL_FloatPoint* templ,float ang)
+static float dollarDifference(const SDL_DollarShape* points,const SDL_DollarShape* templ,float ang)
 {
-    /*  SDL_FloatPoint p[DOLLARNPOINTS]; */
+    const float c = (float)SDL_cos(ang);
+    const float s = (float)SDL_sin(ang);
     float dist = 0;
-    SDL_FloatPoint p;
     int i;
+#if SDL_GESTURE_SSE
+    __m128 vc = _mm_set1_ps(c), vs = _mm_set1_ps(s), sum = _mm_setzero_ps();
+    float lanes[4];
+
+    for (i = 0; i < DOLLARNPOINTS; i += 4) {
+        const __m128 x = _mm_loadu_ps(&points->x[i]);
+        const __m128 y = _mm_loadu_ps(&points->y[i]);
+        const __m128 dx = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(x, vc), _mm_mul_ps(y, vs)),
+                                     _mm_loadu_ps(&templ->x[i]));
+        const __m128 dy = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(x, vs), _mm_mul_ps(y, vc)),
+                                     _mm_loadu_ps(&templ->y[i]));
+        sum = _mm_add_ps(sum, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))));
+    }
+    _mm_storeu_ps(lanes, sum);
+    dist = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
     for (i = 0; i < DOLLARNPOINTS; i++) {
-        p.x = (float)(points[i].x * SDL_cos(ang) - points[i].y * SDL_sin(ang));
-        p.y = (float)(points[i].x * SDL_sin(ang) + points[i].y * SDL_cos(ang));
-        dist += (float)(SDL_sqrt((p.x-templ[i].x)*(p.x-templ[i].x)+
-                                 (p.y-templ[i].y)*(p.y-templ[i].y)));
+        const float dx = points->x[i] * c - points->y[i] * s - templ->x[i];
+        const float dy = points->x[i] * s + points->y[i] * c - templ->y[i];
+        dist += (float)SDL_sqrt(dx*dx + dy*dy);
     }
+#endif
     return dist/DOLLARNPOINTS;
+}
 
+/* No rotation brings the points nearer the template than the differences
+   of their distances from the centroid */
+static float dollarLowerBound(const SDL_DollarShape* points,const SDL_DollarShape* templ)
+{
+    float dist = 0;
+    int i;
+#if SDL_GESTURE_SSE
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 sum = _mm_setzero_ps();
+    float lanes[4];
+
+    for (i = 0; i < DOLLARNPOINTS; i += 4) {
+        const __m128 d = _mm_sub_ps(_mm_loadu_ps(&points->r[i]), _mm_loadu_ps(&templ->r[i]));
+        sum = _mm_add_ps(sum, _mm_andnot_ps(sign, d));
+    }
+    _mm_storeu_ps(lanes, sum);
+    dist = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    for (i = 0; i < DOLLARNPOINTS; i++) {
+        dist += (float)SDL_fabs(points->r[i] - templ->r[i]);
+    }
+#endif
+    return dist/DOLLARNPOINTS;
 }
 
-static float bestDollarDifference(SDL_FloatPoint* points,SDL_FloatPoint* templ)
+static float bestDollarDifference(const SDL_DollarShape* points,const SDL_DollarShape* templ)
 {
     /*------------BEGIN DOLLAR BLACKBOX------------------
       -TRANSLATED DIRECTLY FROM PSUDEO-CODE AVAILABLE AT-
@@ -420,23 +475,63 @@ static int dollarNormalize(const SDL_DollarPath *path,SDL_FloatPoint *points)
     return numPoints;
 }
 
+typedef struct {
+    const SDL_DollarShape *points;
+    const SDL_DollarTemplate *templates;
+    SDL_SpinLock lock;
+    float bestDiff;
+    int bestTempl;
+} SDL_DollarSearch;
+
+/* Templates first to first + count - 1; the first of the best is kept, as
+   when they're all searched in order */
+static void dollarSearch(void *data,int first,int count)
+{
+    SDL_DollarSearch *search = (SDL_DollarSearch *)data;
+    float bestDiff = 10000;
+    int bestTempl = -1;
+    int i;
+
+    for (i = first; i < first + count; i++) {
+        const SDL_DollarShape *templ = &search->templates[i].shape;
+        float diff;
+        if (dollarLowerBound(search->points,templ) >= bestDiff) continue;
+        diff = bestDollarDifference(search->points,templ);
+        if (diff < bestDiff) {bestDiff = diff; bestTempl = i;}
+    }
+
+    SDL_AtomicLock(&search->lock);
+    if (bestTempl >= 0 &&
+        (bestDiff < search->bestDiff ||
+         (bestDiff == search->bestDiff && bestTempl < search->bestTempl))) {
+        search->bestDiff = bestDiff;
+        search->bestTempl = bestTempl;
+    }
+    SDL_AtomicUnlock(&search->lock);
+}
+
 static float dollarRecognize(const SDL_DollarPath *path,int *bestTempl,SDL_GestureTouch* touch)
 {
     SDL_FloatPoint points[DOLLARNPOINTS];
-    int i;
-    float bestDiff = 10000;
+    SDL_DollarShape shape;
+    SDL_DollarSearch search;
 
     SDL_memset(points, 0, sizeof(points));
 
     dollarNormalize(path,points);
+    SDL_MakeDollarShape(points,&shape);
 
     /* PrintPath(points); */
-    *bestTempl = -1;
-    for (i = 0; i < touch->numDollarTemplates; i++) {
-        float diff = bestDollarDifference(points,touch->dollarTemplate[i].path);
-        if (diff < bestDiff) {bestDiff = diff; *bestTempl = i;}
-    }
-    return bestDiff;
+    search.points = &shape;
+    search.templates = touch->dollarTemplate;
+    search.lock = 0;
+    search.bestDiff = 10000;
+    search.bestTempl = -1;
+    /* Most templates are passed over on the lower bound, so only a very
+       big bank (8192 or more) is shared out like the rows of a blit */
+    SDL_RunBlitBands(32,touch->numDollarTemplates,dollarSearch,&search);
+    *bestTempl = search.bestTempl;
+    return search.bestDiff;
 }
 
 int SDL_GestureAddTouch(SDL_TouchID touchId)
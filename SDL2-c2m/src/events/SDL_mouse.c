@@ -291,7 +291,7 @@ SDL_PrivateSendMouseMotion(SDL_Window * window, SDL_MouseID mouseID, int relativ
         event.motion.y = mouse->y;
         event.motion.xrel = xrel;
         event.motion.yrel = yrel;
-        posted = (SDL_PushEvent(&event) > 0);
+        posted = (SDL_PushCoalescedEvent(&event) > 0);
     }
     if (relative) {
         mouse->last_x = mouse->x;
@@ -123,6 +123,9 @@ SDL_SendWindowEvent(SDL_Window * window, Uint8 windowevent, int data1,
         window->h = data2;
         SDL_OnWindowResized(window);
         break;
+    case SDL_WINDOWEVENT_EXPOSED:
+        SDL_OnWindowExposed(window);
+        break;
     case SDL_WINDOWEVENT_MINIMIZED:
         if (window->flags & SDL_WINDOW_MINIMIZED) {
             return 0;
@@ -196,7 +199,7 @@ SDL_SendWindowEvent(SDL_Window * window, Uint8 windowevent, int data1,
             SDL_FilterEvents(RemovePendingMoveEvents, &event);
         }
 
-        posted = (SDL_PushEvent(&event) > 0);
+        posted = (SDL_PushCoalescedEvent(&event) > 0);
     }
 
     if (windowevent == SDL_WINDOWEVENT_CLOSE) {
@@ -0,0 +1,561 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* Asynchronous reads and writes of SDL_RWops.
+
+   Requests are submitted to a queue, and complete in the background; their
+   callbacks are run by SDL_RWasyncPoll, on the thread which polls.
+
+   On Linux, requests on streams from SDL_RWFromFileFD go to an io_uring, so
+   the kernel keeps them all in flight without a thread each.  Other
+   streams (and every stream where io_uring isn't available -- an old
+   kernel, or a sandbox which blocks it) are served by a few worker threads
+   with SDL_RWreadAt / SDL_RWwriteAt.  Memory streams complete at once.
+*/
+
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+#include "SDL_rwops.h"
+#include "SDL_thread.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define SDL_RWASYNC_URING 1
+#endif
+#endif
+#endif
+
+#define SDL_RWASYNC_THREADS 4
+
+typedef struct SDL_RWasyncRequest
+{
+    struct SDL_RWasyncRequest *next;
+    SDL_RWops *context;
+    void *ptr;
+    size_t size;
+    Sint64 offset;
+    SDL_bool write;
+    SDL_RWasyncCallback callback;
+    void *userdata;
+    size_t done;
+    int status;
+#ifdef SDL_RWASYNC_URING
+    struct iovec iov;
+#endif
+} SDL_RWasyncRequest;
+
+typedef struct
+{
+    SDL_RWasyncRequest *head;
+    SDL_RWasyncRequest *tail;
+} SDL_RWasyncList;
+
+struct SDL_RWasync
+{
+    SDL_mutex *lock;
+    SDL_cond *work_ready;       /* todo has requests (or quit) */
+    SDL_cond *work_done;        /* done has requests */
+    SDL_mutex *stream_lock;     /* seek and read/write of shared streams */
+    SDL_RWasyncList todo;       /* for the worker threads */
+    SDL_RWasyncList done;       /* for SDL_RWasyncPoll */
+    SDL_Thread *threads[SDL_RWASYNC_THREADS];
+    int n_threads;
+    SDL_bool quit;
+    int n_pending;              /* submitted, callback not run yet */
+#ifdef SDL_RWASYNC_URING
+    int ring_fd;                /* or -1 */
+    unsigned n_ring;            /* requests in the ring */
+    unsigned n_entries;
+    void *sq_map;
+    size_t sq_map_size;
+    void *cq_map;
+    size_t cq_map_size;
+    struct io_uring_sqe *sqes;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+#endif
+};
+
+static void
+list_push(SDL_RWasyncList * list, SDL_RWasyncRequest * req)
+{
+    req->next = NULL;
+    if (list->tail) {
+        list->tail->next = req;
+    } else {
+        list->head = req;
+    }
+    list->tail = req;
+}
+
+static SDL_RWasyncRequest *
+list_take(SDL_RWasyncList * list)
+{
+    SDL_RWasyncRequest *req = list->head;
+    if (req) {
+        list->head = req->next;
+        if (list->head == NULL) {
+            list->tail = NULL;
+        }
+    }
+    return req;
+}
+
+/* Do a request on the calling thread */
+static void
+request_run(SDL_RWasync * queue, SDL_RWasyncRequest * req)
+{
+    size_t n;
+    /* only fd streams can be read and written at an offset at once */
+    SDL_bool shared = (req->context->type != SDL_RWOPS_FD);
+
+    if (shared) {
+        SDL_LockMutex(queue->stream_lock);
+    }
+    if (req->write) {
+        n = SDL_RWwriteAt(req->context, req->ptr, 1, req->size, req->offset);
+    } else {
+        n = SDL_RWreadAt(req->context, req->ptr, 1, req->size, req->offset);
+    }
+    if (shared) {
+        SDL_UnlockMutex(queue->stream_lock);
+    }
+    req->done = n;
+    req->status = (n == 0 && req->size) ? -1 : 0;
+}
+
+static int SDLCALL
+worker_thread(void *data)
+{
+    SDL_RWasync *queue = (SDL_RWasync *) data;
+
+    SDL_LockMutex(queue->lock);
+    for (;;) {
+        SDL_RWasyncRequest *req = list_take(&queue->todo);
+        if (req == NULL) {
+            if (queue->quit) {
+                break;
+            }
+            SDL_CondWait(queue->work_ready, queue->lock);
+            continue;
+        }
+        SDL_UnlockMutex(queue->lock);
+        request_run(queue, req);
+        SDL_LockMutex(queue->lock);
+        list_push(&queue->done, req);
+        SDL_CondSignal(queue->work_done);
+    }
+    SDL_UnlockMutex(queue->lock);
+    return 0;
+}
+
+#ifdef SDL_RWASYNC_URING
+
+static void
+uring_close(SDL_RWasync * queue)
+{
+    if (queue->sqes) {
+        munmap(queue->sqes, queue->n_entries * sizeof(struct io_uring_sqe));
+    }
+    if (queue->cq_map && queue->cq_map != queue->sq_map) {
+        munmap(queue->cq_map, queue->cq_map_size);
+    }
+    if (queue->sq_map) {
+        munmap(queue->sq_map, queue->sq_map_size);
+    }
+    if (queue->ring_fd >= 0) {
+        close(queue->ring_fd);
+    }
+    queue->ring_fd = -1;
+}
+
+/* Set up an io_uring (ring_fd stays -1 if that can't be done) */
+static void
+uring_open(SDL_RWasync * queue, unsigned entries)
+{
+    struct io_uring_params p;
+    char *sq, *cq;
+
+    SDL_memset(&p, 0, sizeof(p));
+    queue->ring_fd = (int) syscall(__NR_io_uring_setup, entries, &p);
+    if (queue->ring_fd < 0) {
+        queue->ring_fd = -1;
+        return;
+    }
+    queue->n_entries = p.sq_entries;
+    queue->sq_map_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    queue->cq_map_size = p.cq_off.cqes +
+        p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (queue->cq_map_size > queue->sq_map_size) {
+            queue->sq_map_size = queue->cq_map_size;
+        }
+    }
+    queue->sq_map = mmap(NULL, queue->sq_map_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, queue->ring_fd,
+                         IORING_OFF_SQ_RING);
+    if (queue->sq_map == MAP_FAILED) {
+        queue->sq_map = NULL;
+        uring_close(queue);
+        return;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        queue->cq_map = queue->sq_map;
+    } else {
+        queue->cq_map = mmap(NULL, queue->cq_map_size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, queue->ring_fd,
+                             IORING_OFF_CQ_RING);
+        if (queue->cq_map == MAP_FAILED) {
+            queue->cq_map = NULL;
+            uring_close(queue);
+            return;
+        }
+    }
+    queue->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+                       PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       queue->ring_fd, IORING_OFF_SQES);
+    if (queue->sqes == MAP_FAILED) {
+        queue->sqes = NULL;
+        uring_close(queue);
+        return;
+    }
+    sq = (char *) queue->sq_map;
+    cq = (char *) queue->cq_map;
+    queue->sq_head = (unsigned *) (sq + p.sq_off.head);
+    queue->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+    queue->sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+    queue->sq_array = (unsigned *) (sq + p.sq_off.array);
+    queue->cq_head = (unsigned *) (cq + p.cq_off.head);
+    queue->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+    queue->cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+    queue->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+}
+
+/* Move completions from the ring to the done list (with lock held) */
+static int
+uring_reap(SDL_RWasync * queue)
+{
+    unsigned head = *queue->cq_head;
+    unsigned tail = __atomic_load_n(queue->cq_tail, __ATOMIC_ACQUIRE);
+    int n = 0;
+
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &queue->cqes[head & *queue->cq_mask];
+        SDL_RWasyncRequest *req =
+            (SDL_RWasyncRequest *) (uintptr_t) cqe->user_data;
+        if (cqe->res < 0) {
+            req->done = 0;
+            req->status = -1;
+        } else {
+            req->done = (size_t) cqe->res;
+            req->status = 0;
+        }
+        list_push(&queue->done, req);
+        head++;
+        n++;
+    }
+    __atomic_store_n(queue->cq_head, head, __ATOMIC_RELEASE);
+    queue->n_ring -= n;
+    return n;
+}
+
+/* Wait for a completion in the ring */
+static void
+uring_wait(SDL_RWasync * queue)
+{
+    syscall(__NR_io_uring_enter, queue->ring_fd, 0, 1,
+            IORING_ENTER_GETEVENTS, NULL, 0);
+}
+
+/* Submit a request to the ring (with lock held), 0 on success */
+static int
+uring_submit(SDL_RWasync * queue, SDL_RWasyncRequest * req)
+{
+    struct io_uring_sqe *sqe;
+    unsigned tail, index;
+    long r;
+
+    /* streams buffer, so sync the file with reads and writes before */
+    if (req->context->hidden.fdio.writing || req->context->hidden.fdio.len) {
+        SDL_RWtell(req->context);
+    }
+    while (queue->n_ring >= queue->n_entries) {
+        if (uring_reap(queue) == 0) {
+            uring_wait(queue);
+        }
+    }
+    tail = *queue->sq_tail;
+    index = tail & *queue->sq_mask;
+    sqe = &queue->sqes[index];
+    SDL_memset(sqe, 0, sizeof(*sqe));
+    req->iov.iov_base = req->ptr;
+    req->iov.iov_len = req->size;
+    /* READV / WRITEV work on every kernel with io_uring (5.1) */
+    sqe->opcode = req->write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = req->context->hidden.fdio.fd;
+    sqe->off = (Uint64) req->offset;
+    sqe->addr = (Uint64) (uintptr_t) &req->iov;
+    sqe->len = 1;
+    sqe->user_data = (Uint64) (uintptr_t) req;
+    queue->sq_array[index] = index;
+    __atomic_store_n(queue->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    do {
+        r = syscall(__NR_io_uring_enter, queue->ring_fd, 1, 0, 0, NULL, 0);
+    } while (r < 0 && errno == EINTR);
+    if (r != 1) {
+        /* take it back out of the ring */
+        __atomic_store_n(queue->sq_tail, tail, __ATOMIC_RELEASE);
+        return -1;
+    }
+    queue->n_ring++;
+    return 0;
+}
+
+#endif /* SDL_RWASYNC_URING */
+
+SDL_RWasync *
+SDL_RWasyncCreate(int depth)
+{
+    SDL_RWasync *queue = (SDL_RWasync *) SDL_calloc(1, sizeof(*queue));
+    int i;
+
+    if (queue == NULL) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+#ifdef SDL_RWASYNC_URING
+    queue->ring_fd = -1;
+#endif
+    if (depth <= 0) {
+        depth = 64;
+    }
+    queue->lock = SDL_CreateMutex();
+    queue->stream_lock = SDL_CreateMutex();
+    queue->work_ready = SDL_CreateCond();
+    queue->work_done = SDL_CreateCond();
+    if (!queue->lock || !queue->stream_lock || !queue->work_ready ||
+        !queue->work_done) {
+        SDL_RWasyncDestroy(queue);
+        return NULL;
+    }
+#ifdef SDL_RWASYNC_URING
+    uring_open(queue, (unsigned) depth);
+#endif
+    for (i = 0; i < SDL_RWASYNC_THREADS; i++) {
+        queue->threads[i] = SDL_CreateThread(worker_thread, "SDL_RWasync",
+                                             queue);
+        if (queue->threads[i] == NULL) {
+            break;
+        }
+        queue->n_threads++;
+    }
+    if (queue->n_threads == 0) {
+        SDL_RWasyncDestroy(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+static int
+request_submit(SDL_RWasync * queue, SDL_RWops * context, void *ptr,
+               size_t size, Sint64 offset, SDL_bool write,
+               SDL_RWasyncCallback callback, void *userdata)
+{
+    SDL_RWasyncRequest *req;
+
+    if (!queue || !context || (!ptr && size)) {
+        return SDL_InvalidParamError(!queue ? "queue" : !context ?
+                                     "context" : "ptr");
+    }
+    req = (SDL_RWasyncRequest *) SDL_malloc(sizeof(*req));
+    if (req == NULL) {
+        return SDL_OutOfMemory();
+    }
+    req->context = context;
+    req->ptr = ptr;
+    req->size = size;
+    req->offset = offset;
+    req->write = write;
+    req->callback = callback;
+    req->userdata = userdata;
+    req->done = 0;
+    req->status = 0;
+    SDL_LockMutex(queue->lock);
+    queue->n_pending++;
+    switch (context->type) {
+    case SDL_RWOPS_MEMORY:
+    case SDL_RWOPS_MEMORY_RO:
+    case SDL_RWOPS_MAPPED:
+        /* nothing to wait for */
+        request_run(queue, req);
+        list_push(&queue->done, req);
+        break;
+#ifdef SDL_RWASYNC_URING
+    case SDL_RWOPS_FD:
+        if (queue->ring_fd >= 0 && uring_submit(queue, req) == 0) {
+            break;
+        }
+        /* no ring, or it's full: a worker does it, like any other stream */
+        list_push(&queue->todo, req);
+        SDL_CondSignal(queue->work_ready);
+        break;
+#endif
+    default:
+        list_push(&queue->todo, req);
+        SDL_CondSignal(queue->work_ready);
+        break;
+    }
+    SDL_UnlockMutex(queue->lock);
+    return 0;
+}
+
+int
+SDL_RWasyncRead(SDL_RWasync * queue, SDL_RWops * context, void *ptr,
+                size_t size, Sint64 offset, SDL_RWasyncCallback callback,
+                void *userdata)
+{
+    return request_submit(queue, context, ptr, size, offset, SDL_FALSE,
+                          callback, userdata);
+}
+
+int
+SDL_RWasyncWrite(SDL_RWasync * queue, SDL_RWops * context, const void *ptr,
+                 size_t size, Sint64 offset, SDL_RWasyncCallback callback,
+                 void *userdata)
+{
+    return request_submit(queue, context, (void *) ptr, size, offset,
+                          SDL_TRUE, callback, userdata);
+}
+
+int
+SDL_RWasyncPending(SDL_RWasync * queue)
+{
+    int n;
+    SDL_LockMutex(queue->lock);
+    n = queue->n_pending;
+    SDL_UnlockMutex(queue->lock);
+    return n;
+}
+
+int
+SDL_RWasyncPoll(SDL_RWasync * queue, SDL_bool wait)
+{
+    SDL_RWasyncList done;
+    SDL_RWasyncRequest *req;
+    int n = 0;
+
+    SDL_LockMutex(queue->lock);
+    for (;;) {
+#ifdef SDL_RWASYNC_URING
+        if (queue->n_ring) {
+            uring_reap(queue);
+        }
+#endif
+        if (queue->done.head || !wait || queue->n_pending == 0) {
+            break;
+        }
+#ifdef SDL_RWASYNC_URING
+        /* the ring has requests, and the workers don't */
+        if (queue->n_ring && queue->n_ring == (unsigned) queue->n_pending) {
+            SDL_UnlockMutex(queue->lock);
+            uring_wait(queue);
+            SDL_LockMutex(queue->lock);
+            continue;
+        }
+        if (queue->n_ring) {
+            /* wait on both: check the ring every millisecond */
+            SDL_CondWaitTimeout(queue->work_done, queue->lock, 1);
+            continue;
+        }
+#endif
+        SDL_CondWait(queue->work_done, queue->lock);
+    }
+    done = queue->done;
+    queue->done.head = NULL;
+    queue->done.tail = NULL;
+    SDL_UnlockMutex(queue->lock);
+    /* callbacks may submit more requests */
+    while ((req = list_take(&done)) != NULL) {
+        if (req->callback) {
+            req->callback(req->userdata, req->ptr, req->done, req->status);
+        }
+        SDL_free(req);
+        n++;
+    }
+    SDL_LockMutex(queue->lock);
+    queue->n_pending -= n;
+    SDL_UnlockMutex(queue->lock);
+    return n;
+}
+
+void
+SDL_RWasyncDestroy(SDL_RWasync * queue)
+{
+    int i;
+
+    if (queue == NULL) {
+        return;
+    }
+    if (queue->lock) {
+        while (SDL_RWasyncPending(queue)) {
+            SDL_RWasyncPoll(queue, SDL_TRUE);
+        }
+        SDL_LockMutex(queue->lock);
+        queue->quit = SDL_TRUE;
+        SDL_CondBroadcast(queue->work_ready);
+        SDL_UnlockMutex(queue->lock);
+    }
+    for (i = 0; i < queue->n_threads; i++) {
+        SDL_WaitThread(queue->threads[i], NULL);
+    }
+#ifdef SDL_RWASYNC_URING
+    uring_close(queue);
+#endif
+    if (queue->work_done) {
+        SDL_DestroyCond(queue->work_done);
+    }
+    if (queue->work_ready) {
+        SDL_DestroyCond(queue->work_ready);
+    }
+    if (queue->stream_lock) {
+        SDL_DestroyMutex(queue->stream_lock);
+    }
+    if (queue->lock) {
+        SDL_DestroyMutex(queue->lock);
+    }
+    SDL_free(queue);
+}
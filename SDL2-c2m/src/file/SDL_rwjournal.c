@@ -0,0 +1,507 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* Append-only journals in memory mapped files.
+
+   A journal is a series of segment files, each created at its full size
+   and mapped.  An append reserves its bytes with an atomic add to the
+   segment's cursor and copies the record into the mapping: no lock, no
+   system call.  The append which crosses the end of a segment rolls the
+   journal over to the next one, which a background thread has already
+   created (and faulted in, where it can), and that thread finishes the
+   full segment -- synced, unmapped and cut down to what was written --
+   once every append into it has been copied.  It also syncs the current
+   segment every so often, so appends never wait for the disk.
+
+   A segment struct is kept until the journal is closed, even after it's
+   unmapped: an append that loaded it as the current segment just before
+   the roll reserves past its end, and tries again in the next segment.
+*/
+
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+#include "SDL_rwops.h"
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define SDL_RWJOURNAL_MMAP 1
+#endif
+
+#ifdef SDL_RWJOURNAL_MMAP
+
+#define SDL_RWJOURNAL_SEGMENT (64 * 1024 * 1024)
+#define SDL_RWJOURNAL_SEGMENT_MAX (1024 * 1024 * 1024)
+
+typedef struct SDL_RWjournalSegment
+{
+    struct SDL_RWjournalSegment *next;
+    char *path;
+    int fd;
+    Uint8 *base;                /* or NULL once finished */
+    size_t size;
+    SDL_atomic64_t cursor;      /* bytes reserved, past size once full */
+    SDL_atomic_t committed;     /* bytes copied */
+    Sint64 end;                 /* where the last record ends, or -1 */
+#ifndef SDL_HAS_ATOMIC64
+    SDL_SpinLock lock;          /* of cursor */
+#endif
+} SDL_RWjournalSegment;
+
+struct SDL_RWjournal
+{
+    SDL_RWjournalSegment *current;
+    char *path;
+    size_t segment_size;
+    Uint32 sync_interval;
+    SDL_atomic_t index;         /* of the next segment file to try */
+    SDL_mutex *lock;
+    SDL_cond *rolled;           /* current or spare changed (or quit) */
+    SDL_mutex *sync_lock;       /* msync and munmap */
+    SDL_RWjournalSegment *spare; /* next segment, ready to roll to */
+    SDL_RWjournalSegment *mapped; /* oldest segment not finished */
+    SDL_RWjournalSegment *first;
+    SDL_bool creating;          /* background thread creating the spare */
+    SDL_bool failed;            /* couldn't roll, appends fail */
+    SDL_bool quit;
+    SDL_Thread *thread;
+};
+
+static Sint64
+segment_reserve(SDL_RWjournalSegment * seg, size_t size)
+{
+#ifdef SDL_HAS_ATOMIC64
+    return SDL_AtomicFetchAdd64(&seg->cursor, (Sint64) size,
+                                SDL_MEMORY_ORDER_RELAXED);
+#else
+    Sint64 offset;
+
+    SDL_AtomicLock(&seg->lock);
+    offset = seg->cursor.value;
+    seg->cursor.value += size;
+    SDL_AtomicUnlock(&seg->lock);
+    return offset;
+#endif
+}
+
+/* Bytes reserved in a segment, up to its size */
+static size_t
+segment_used(SDL_RWjournalSegment * seg)
+{
+    Sint64 used;
+
+    if (seg->end >= 0) {
+        return (size_t) seg->end;
+    }
+#ifdef SDL_HAS_ATOMIC64
+    used = SDL_AtomicLoad64(&seg->cursor, SDL_MEMORY_ORDER_RELAXED);
+#else
+    SDL_AtomicLock(&seg->lock);
+    used = seg->cursor.value;
+    SDL_AtomicUnlock(&seg->lock);
+#endif
+    return used < (Sint64) seg->size ? (size_t) used : seg->size;
+}
+
+/* Create the next segment file, at its full size, and map it */
+static SDL_RWjournalSegment *
+segment_create(SDL_RWjournal * journal)
+{
+    SDL_RWjournalSegment *seg;
+    size_t length = SDL_strlen(journal->path) + 16;
+    int flags = MAP_SHARED;
+
+    seg = (SDL_RWjournalSegment *) SDL_calloc(1, sizeof(*seg));
+    if (seg == NULL || (seg->path = (char *) SDL_malloc(length)) == NULL) {
+        SDL_free(seg);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    /* Segments after those a previous run left */
+    do {
+        SDL_snprintf(seg->path, length, "%s.%06d", journal->path,
+                     SDL_AtomicIncRef(&journal->index));
+        seg->fd = open(seg->path, O_RDWR | O_CREAT | O_EXCL
+#ifdef O_CLOEXEC
+                       | O_CLOEXEC
+#endif
+                       , 0644);
+    } while (seg->fd < 0 && errno == EEXIST);
+    if (seg->fd < 0) {
+        SDL_SetError("Couldn't create %s: %s", seg->path, strerror(errno));
+        goto fail;
+    }
+#ifdef __linux__
+    /* Blocks are allocated now, so a full disk fails here and not with a
+       SIGBUS in the middle of an append */
+    if (posix_fallocate(seg->fd, 0, (off_t) journal->segment_size) != 0 &&
+        ftruncate(seg->fd, (off_t) journal->segment_size) < 0) {
+#else
+    if (ftruncate(seg->fd, (off_t) journal->segment_size) < 0) {
+#endif
+        SDL_SetError("Couldn't allocate %s: %s", seg->path, strerror(errno));
+        goto fail;
+    }
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    seg->base = (Uint8 *) mmap(NULL, journal->segment_size,
+                               PROT_READ | PROT_WRITE, flags, seg->fd, 0);
+    if (seg->base == (Uint8 *) MAP_FAILED) {
+        SDL_SetError("Couldn't map %s: %s", seg->path, strerror(errno));
+        seg->base = NULL;
+        goto fail;
+    }
+    seg->size = journal->segment_size;
+    seg->end = -1;
+    return seg;
+
+fail:
+    if (seg->fd >= 0) {
+        close(seg->fd);
+        unlink(seg->path);
+    }
+    SDL_free(seg->path);
+    SDL_free(seg);
+    return NULL;
+}
+
+static void
+segment_sync(SDL_RWjournalSegment * seg)
+{
+    size_t used = segment_used(seg);
+
+    if (seg->base && used) {
+        msync(seg->base, used, MS_SYNC);
+    }
+}
+
+/* Sync a segment, unmap it and cut its file down to what was written */
+static void
+segment_finish(SDL_RWjournalSegment * seg)
+{
+    size_t used = segment_used(seg);
+
+    if (seg->base) {
+        if (used) {
+            msync(seg->base, used, MS_SYNC);
+        }
+        munmap(seg->base, seg->size);
+        seg->base = NULL;
+        if (ftruncate(seg->fd, (off_t) used) < 0) {
+            /* Left at its full size, the rest zeros */
+        }
+        close(seg->fd);
+    }
+}
+
+/* Finish the full segments whose appends are all copied.  Returns SDL_TRUE
+   if one still has appends in progress. */
+static SDL_bool
+journal_finish(SDL_RWjournal * journal, SDL_RWjournalSegment * current)
+{
+    SDL_RWjournalSegment *seg;
+
+    while ((seg = journal->mapped) != current) {
+        if (SDL_AtomicGet(&seg->committed) < (int) seg->end) {
+            return SDL_TRUE;
+        }
+        SDL_LockMutex(journal->sync_lock);
+        segment_finish(seg);
+        journal->mapped = seg->next;
+        SDL_UnlockMutex(journal->sync_lock);
+    }
+    return SDL_FALSE;
+}
+
+static int SDLCALL
+journal_thread(void *data)
+{
+    SDL_RWjournal *journal = (SDL_RWjournal *) data;
+    SDL_RWjournalSegment *current;
+    Uint32 last_sync = SDL_GetTicks();
+    Uint32 timeout;
+    SDL_bool busy;
+
+    SDL_LockMutex(journal->lock);
+    while (!journal->quit) {
+        if (journal->spare == NULL && !journal->failed) {
+            journal->creating = SDL_TRUE;
+            SDL_UnlockMutex(journal->lock);
+            current = segment_create(journal);
+            SDL_LockMutex(journal->lock);
+            journal->spare = current;
+            journal->creating = SDL_FALSE;
+            SDL_CondBroadcast(journal->rolled);
+        }
+        current = journal->current;
+        SDL_UnlockMutex(journal->lock);
+
+        busy = journal_finish(journal, current);
+        if (journal->sync_interval &&
+            SDL_TICKS_PASSED(SDL_GetTicks(),
+                             last_sync + journal->sync_interval)) {
+            SDL_LockMutex(journal->sync_lock);
+            segment_sync(current);
+            SDL_UnlockMutex(journal->sync_lock);
+            last_sync = SDL_GetTicks();
+        }
+
+        SDL_LockMutex(journal->lock);
+        if (!journal->quit && journal->current == current) {
+            /* Soon if a full segment is waiting for its last appends, or
+               the spare couldn't be created */
+            if (busy) {
+                timeout = 1;
+            } else if (journal->spare == NULL && !journal->failed) {
+                timeout = 100;
+            } else if (journal->sync_interval) {
+                timeout = journal->sync_interval;
+            } else {
+                timeout = SDL_MUTEX_MAXWAIT;
+            }
+            SDL_CondWaitTimeout(journal->rolled, journal->lock, timeout);
+        }
+    }
+    SDL_UnlockMutex(journal->lock);
+    return 0;
+}
+
+/* An append didn't fit in seg: roll over to the next segment if it was the
+   first which didn't, otherwise wait for that one to */
+static int
+journal_roll(SDL_RWjournal * journal, SDL_RWjournalSegment * seg,
+             Sint64 offset)
+{
+    SDL_RWjournalSegment *next;
+
+    SDL_LockMutex(journal->lock);
+    if (offset <= (Sint64) seg->size) {
+        seg->end = offset;
+        while (journal->spare == NULL && journal->creating) {
+            SDL_CondWait(journal->rolled, journal->lock);
+        }
+        next = journal->spare;
+        if (next == NULL) {
+            /* The background thread failed to, try here */
+            next = segment_create(journal);
+        }
+        if (next) {
+            seg->next = next;
+            journal->spare = NULL;
+            SDL_AtomicSetPtr((void **) &journal->current, next);
+        } else {
+            journal->failed = SDL_TRUE;
+        }
+        SDL_CondBroadcast(journal->rolled);
+    } else {
+        while (journal->current == seg && !journal->failed) {
+            SDL_CondWait(journal->rolled, journal->lock);
+        }
+    }
+    offset = journal->failed ? -1 : 0;
+    SDL_UnlockMutex(journal->lock);
+    if (offset < 0) {
+        return SDL_SetError("Couldn't roll %s over to a new segment",
+                            journal->path);
+    }
+    return 0;
+}
+
+SDL_RWjournal *
+SDL_RWjournalOpen(const char *path, size_t segment_size, Uint32 sync_interval)
+{
+    SDL_RWjournal *journal;
+    long page = sysconf(_SC_PAGESIZE);
+
+    if (path == NULL) {
+        SDL_InvalidParamError("path");
+        return NULL;
+    }
+    if (segment_size == 0) {
+        segment_size = SDL_RWJOURNAL_SEGMENT;
+    }
+    if (segment_size > SDL_RWJOURNAL_SEGMENT_MAX) {
+        segment_size = SDL_RWJOURNAL_SEGMENT_MAX;
+    }
+    if (page > 0) {
+        segment_size = (segment_size + page - 1) & ~(size_t) (page - 1);
+    }
+    journal = (SDL_RWjournal *) SDL_calloc(1, sizeof(*journal));
+    if (journal == NULL) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    journal->path = SDL_strdup(path);
+    journal->segment_size = segment_size;
+    journal->sync_interval = sync_interval;
+    journal->lock = SDL_CreateMutex();
+    journal->rolled = SDL_CreateCond();
+    journal->sync_lock = SDL_CreateMutex();
+    if (!journal->path || !journal->lock || !journal->rolled ||
+        !journal->sync_lock) {
+        SDL_RWjournalClose(journal);
+        return NULL;
+    }
+    journal->current = segment_create(journal);
+    if (journal->current == NULL) {
+        SDL_RWjournalClose(journal);
+        return NULL;
+    }
+    journal->first = journal->mapped = journal->current;
+    journal->thread = SDL_CreateThread(journal_thread, "SDL_RWjournal",
+                                       journal);
+    if (journal->thread == NULL) {
+        SDL_RWjournalClose(journal);
+        return NULL;
+    }
+    return journal;
+}
+
+int
+SDL_RWjournalAppend(SDL_RWjournal * journal, const void *ptr, size_t size)
+{
+    SDL_RWjournalSegment *seg;
+    Sint64 offset;
+
+    if (journal == NULL) {
+        return SDL_InvalidParamError("journal");
+    }
+    if (size == 0) {
+        return 0;
+    }
+    if (size > journal->segment_size) {
+        return SDL_SetError("Record larger than a segment of %s",
+                            journal->path);
+    }
+    for (;;) {
+        seg = (SDL_RWjournalSegment *) SDL_AtomicGetPtr((void **)
+                                                        &journal->current);
+        offset = segment_reserve(seg, size);
+        if (offset + (Sint64) size <= (Sint64) seg->size) {
+            SDL_memcpy(seg->base + offset, ptr, size);
+            SDL_AtomicAdd(&seg->committed, (int) size);
+            return 0;
+        }
+        if (journal_roll(journal, seg, offset) < 0) {
+            return -1;
+        }
+    }
+}
+
+int
+SDL_RWjournalSync(SDL_RWjournal * journal)
+{
+    SDL_RWjournalSegment *current, *seg;
+
+    if (journal == NULL) {
+        return SDL_InvalidParamError("journal");
+    }
+    current = (SDL_RWjournalSegment *) SDL_AtomicGetPtr((void **)
+                                                        &journal->current);
+    SDL_LockMutex(journal->sync_lock);
+    /* Unless it's been finished since, with everything before it */
+    if (current->base) {
+        for (seg = journal->mapped; seg != current; seg = seg->next) {
+            segment_sync(seg);
+        }
+        segment_sync(current);
+    }
+    SDL_UnlockMutex(journal->sync_lock);
+    return 0;
+}
+
+void
+SDL_RWjournalClose(SDL_RWjournal * journal)
+{
+    SDL_RWjournalSegment *seg, *next;
+
+    if (journal == NULL) {
+        return;
+    }
+    if (journal->thread) {
+        SDL_LockMutex(journal->lock);
+        journal->quit = SDL_TRUE;
+        SDL_CondBroadcast(journal->rolled);
+        SDL_UnlockMutex(journal->lock);
+        SDL_WaitThread(journal->thread, NULL);
+    }
+    for (seg = journal->first; seg; seg = next) {
+        next = seg->next;
+        segment_finish(seg);
+        SDL_free(seg->path);
+        SDL_free(seg);
+    }
+    if (journal->spare) {
+        munmap(journal->spare->base, journal->spare->size);
+        close(journal->spare->fd);
+        unlink(journal->spare->path);
+        SDL_free(journal->spare->path);
+        SDL_free(journal->spare);
+    }
+    if (journal->sync_lock) {
+        SDL_DestroyMutex(journal->sync_lock);
+    }
+    if (journal->rolled) {
+        SDL_DestroyCond(journal->rolled);
+    }
+    if (journal->lock) {
+        SDL_DestroyMutex(journal->lock);
+    }
+    SDL_free(journal->path);
+    SDL_free(journal);
+}
+
+#else
+
+SDL_RWjournal *
+SDL_RWjournalOpen(const char *path, size_t segment_size, Uint32 sync_interval)
+{
+    SDL_Unsupported();
+    return NULL;
+}
+
+int
+SDL_RWjournalAppend(SDL_RWjournal * journal, const void *ptr, size_t size)
+{
+    return SDL_Unsupported();
+}
+
+int
+SDL_RWjournalSync(SDL_RWjournal * journal)
+{
+    return SDL_Unsupported();
+}
+
+void
+SDL_RWjournalClose(SDL_RWjournal * journal)
+{
+}
+
+#endif /* SDL_RWJOURNAL_MMAP */
+
+/* vi: set ts=4 sw=4 expandtab: */
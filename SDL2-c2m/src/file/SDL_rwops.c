@@ -22,7 +22,9 @@
   3. This notice may not be removed or altered from any source distribution.
 */
 /* Need this so Linux systems define fseek64o, ftell64o */
+#ifndef _LARGEFILE64_SOURCE
 #define _LARGEFILE64_SOURCE
+#endif
 #include "../SDL_internal.h"
 
 #if defined(__WIN32__)
@@ -50,6 +52,123 @@
 #include "nacl_io/nacl_io.h"
 #endif
 
+#if (defined(__unix__) || defined(__APPLE__)) && !__NACL__
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define SDL_RWOPS_POSIX 1
+#endif
+
+/* SDL_RWcopy between file descriptors in the kernel (no copy through user
+   memory): copy_file_range between files, sendfile from a file, splice
+   through a pipe from anything else */
+#if defined(__linux__) && defined(SDL_RWOPS_POSIX)
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#define SDL_RWOPS_SENDFILE 1
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  /* SO_NOSIGPIPE instead, see SDL_RWFromSocket */
+#endif
+
+#define SDL_RWOPS_COPY_BUFFER (256 * 1024)  /* SDL_RWcopy without the kernel */
+#define SDL_RWOPS_READER_BUFFER (64 * 1024)  /* SDL_RWreader's default */
+
+/* SDL_RWreader's delimiter search, 16 bytes at a time */
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SDL_RWOPS_FIND_SSE2 1
+#include <emmintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define SDL_RWOPS_FIND_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef SDL_RWOPS_POSIX
+#define SDL_RWOPS_IOV 64        /* buffers per writev call */
+
+/* writev all of iov (which is changed), returning the bytes written; a
+   socket's sent instead, so a closed connection is an error (not SIGPIPE) */
+static size_t
+posix_writev(int fd, struct iovec *iov, int n, SDL_bool sock)
+{
+    size_t total = 0;
+
+    while (n) {
+        ssize_t w;
+        if (sock) {
+            struct msghdr msg;
+            SDL_zero(msg);
+            msg.msg_iov = iov;
+            msg.msg_iovlen = n;
+            w = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        } else {
+            w = writev(fd, iov, n);
+        }
+        if (w < 0 && errno == EINTR) {
+            continue;
+        }
+        if (w <= 0) {
+            SDL_Error(SDL_EFWRITE);
+            break;
+        }
+        total += (size_t) w;
+        /* skip what's done, a short write resumes mid buffer */
+        while (n && (size_t) w >= iov->iov_len) {
+            w -= iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n) {
+            iov->iov_base = (char *) iov->iov_base + w;
+            iov->iov_len -= w;
+        }
+    }
+    return total;
+}
+
+/* writev n buffers (any number), after `first` bytes at `pre` */
+static size_t
+posix_writev_all(int fd, const void *pre, size_t first,
+                 const SDL_RWiovec * vec, int n, SDL_bool sock)
+{
+    struct iovec iov[SDL_RWOPS_IOV];
+    size_t total = 0;
+    int i = 0;
+
+    while (first || i < n) {
+        size_t want = 0;
+        size_t wrote;
+        int count = 0;
+        if (first) {
+            iov[count].iov_base = (void *) pre;
+            iov[count].iov_len = first;
+            want += first;
+            count++;
+        }
+        for (; count < SDL_RWOPS_IOV && i < n; i++) {
+            iov[count].iov_base = (void *) vec[i].base;
+            iov[count].iov_len = vec[i].len;
+            want += vec[i].len;
+            count++;
+        }
+        wrote = posix_writev(fd, iov, count, sock);
+        total += wrote;
+        if (wrote < want) {
+            break;
+        }
+        first = 0;
+    }
+    return total;
+}
+#endif /* SDL_RWOPS_POSIX */
+
 #ifdef __WIN32__
 
 /* Functions to read/write Win32 API file pointers */
@@ -359,6 +478,28 @@ stdio_write(SDL_RWops * context, const void *ptr, size_t size, size_t num)
     return nwrote;
 }
 
+#ifdef SDL_RWOPS_POSIX
+static size_t SDLCALL
+stdio_writev(SDL_RWops * context, const SDL_RWiovec * iov, int n)
+{
+    FILE *fp = context->hidden.stdio.fp;
+    size_t wrote;
+    off_t pos;
+
+    if (fflush(fp) != 0) {
+        SDL_Error(SDL_EFWRITE);
+        return 0;
+    }
+    wrote = posix_writev_all(fileno(fp), NULL, 0, iov, n, SDL_FALSE);
+    /* stdio caches the file position, so tell it where the writes ended */
+    pos = lseek(fileno(fp), 0, SEEK_CUR);
+    if (pos >= 0) {
+        fseeko(fp, pos, SEEK_SET);
+    }
+    return wrote;
+}
+#endif
+
 static int SDLCALL
 stdio_close(SDL_RWops * context)
 {
@@ -376,6 +517,508 @@ stdio_close(SDL_RWops * context)
 }
 #endif /* !HAVE_STDIO_H */
 
+#ifdef SDL_RWOPS_POSIX
+
+/* Functions to read/write POSIX file descriptors, with a buffer of our own */
+
+#define SDL_RWOPS_FD_BUFFER (256 * 1024)
+#define SDL_RWOPS_FD_ALIGN  4096
+
+/* Write out buffered writes; the buffer is then empty */
+static int
+fd_flush(SDL_RWops * context)
+{
+    Uint8 *p = context->hidden.fdio.buffer;
+    size_t left = context->hidden.fdio.len;
+
+    if (!context->hidden.fdio.writing) {
+        return 0;
+    }
+    context->hidden.fdio.writing = SDL_FALSE;
+    context->hidden.fdio.len = 0;
+    context->hidden.fdio.pos = 0;
+    while (left) {
+        ssize_t w = write(context->hidden.fdio.fd, p, left);
+        if (w < 0 && errno == EINTR) {
+            continue;
+        }
+        if (w <= 0) {
+            return SDL_Error(SDL_EFWRITE);
+        }
+        p += w;
+        left -= w;
+    }
+    return 0;
+}
+
+/* Drop buffered reads, moving the file back to the stream position */
+static void
+fd_unread(SDL_RWops * context)
+{
+    size_t unread = context->hidden.fdio.len - context->hidden.fdio.pos;
+
+    if (context->hidden.fdio.writing) {
+        return;
+    }
+    if (unread) {
+        lseek(context->hidden.fdio.fd, -(off_t) unread, SEEK_CUR);
+    }
+    context->hidden.fdio.len = 0;
+    context->hidden.fdio.pos = 0;
+}
+
+static Sint64 SDLCALL
+fd_size(SDL_RWops * context)
+{
+    struct stat info;
+
+    if (fd_flush(context) < 0) {
+        return -1;
+    }
+    if (fstat(context->hidden.fdio.fd, &info) != 0) {
+        return SDL_SetError("Couldn't get size of file");
+    }
+    return (Sint64) info.st_size;
+}
+
+static Sint64 SDLCALL
+fd_seek(SDL_RWops * context, Sint64 offset, int whence)
+{
+    off_t pos;
+    int how;
+
+    switch (whence) {
+    case RW_SEEK_SET:
+        how = SEEK_SET;
+        break;
+    case RW_SEEK_CUR:
+        how = SEEK_CUR;
+        break;
+    case RW_SEEK_END:
+        how = SEEK_END;
+        break;
+    default:
+        return SDL_SetError("Unknown value for 'whence'");
+    }
+    if (fd_flush(context) < 0) {
+        return -1;
+    }
+    fd_unread(context);
+    pos = lseek(context->hidden.fdio.fd, (off_t) offset, how);
+    if (pos < 0) {
+        return SDL_Error(SDL_EFSEEK);
+    }
+    return (Sint64) pos;
+}
+
+static size_t SDLCALL
+fd_read(SDL_RWops * context, void *ptr, size_t size, size_t maxnum)
+{
+    Uint8 *p = (Uint8 *) ptr;
+    size_t total_bytes = size * maxnum;
+    size_t total_read = 0;
+
+    if ((maxnum <= 0) || (size <= 0) || ((total_bytes / maxnum) != size)) {
+        return 0;
+    }
+    if (fd_flush(context) < 0) {
+        return 0;
+    }
+    while (total_read < total_bytes) {
+        size_t want = total_bytes - total_read;
+        size_t avail = context->hidden.fdio.len - context->hidden.fdio.pos;
+        ssize_t r;
+
+        if (avail) {
+            if (avail > want) {
+                avail = want;
+            }
+            SDL_memcpy(p + total_read, context->hidden.fdio.buffer +
+                       context->hidden.fdio.pos, avail);
+            context->hidden.fdio.pos += avail;
+            total_read += avail;
+            continue;
+        }
+        /* big reads skip the buffer */
+        if (want >= context->hidden.fdio.size) {
+            r = read(context->hidden.fdio.fd, p + total_read, want);
+        } else {
+            r = read(context->hidden.fdio.fd, context->hidden.fdio.buffer,
+                     context->hidden.fdio.size);
+            if (r > 0) {
+                context->hidden.fdio.len = (size_t) r;
+                context->hidden.fdio.pos = 0;
+                continue;
+            }
+        }
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0) {
+            SDL_Error(SDL_EFREAD);
+        }
+        if (r <= 0) {
+            break;
+        }
+        total_read += (size_t) r;
+    }
+    return (total_read / size);
+}
+
+static size_t SDLCALL
+fd_write(SDL_RWops * context, const void *ptr, size_t size, size_t num)
+{
+    const Uint8 *p = (const Uint8 *) ptr;
+    size_t total_bytes = size * num;
+    size_t left = total_bytes;
+
+    if ((num <= 0) || (size <= 0) || ((total_bytes / num) != size)) {
+        return 0;
+    }
+    /* buffering it would only fail later, at the flush */
+    if (context->hidden.fdio.readonly) {
+        SDL_Error(SDL_EFWRITE);
+        return 0;
+    }
+    fd_unread(context);
+    if (context->hidden.fdio.len + left > context->hidden.fdio.size) {
+        if (fd_flush(context) < 0) {
+            return 0;
+        }
+    }
+    /* big writes skip the buffer */
+    if (left >= context->hidden.fdio.size) {
+        while (left) {
+            ssize_t w = write(context->hidden.fdio.fd, p, left);
+            if (w < 0 && errno == EINTR) {
+                continue;
+            }
+            if (w <= 0) {
+                SDL_Error(SDL_EFWRITE);
+                break;
+            }
+            p += w;
+            left -= w;
+        }
+        return (total_bytes - left) / size;
+    }
+    SDL_memcpy(context->hidden.fdio.buffer + context->hidden.fdio.len, p,
+               left);
+    context->hidden.fdio.len += left;
+    context->hidden.fdio.writing = SDL_TRUE;
+    return num;
+}
+
+static size_t SDLCALL
+fd_writev(SDL_RWops * context, const SDL_RWiovec * iov, int n)
+{
+    size_t total = 0;
+    size_t wrote;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        total += iov[i].len;
+    }
+    if (context->hidden.fdio.readonly) {
+        SDL_Error(SDL_EFWRITE);
+        return 0;
+    }
+    fd_unread(context);
+    /* small: gather them in the buffer */
+    if (context->hidden.fdio.len + total <= context->hidden.fdio.size) {
+        for (i = 0; i < n; i++) {
+            if (iov[i].len == 0) {
+                continue;
+            }
+            SDL_memcpy(context->hidden.fdio.buffer + context->hidden.fdio.len,
+                       iov[i].base, iov[i].len);
+            context->hidden.fdio.len += iov[i].len;
+        }
+        context->hidden.fdio.writing = (context->hidden.fdio.len != 0);
+        return total;
+    }
+    /* big: one writev of the buffered writes and all of the buffers */
+    wrote = posix_writev_all(context->hidden.fdio.fd,
+                             context->hidden.fdio.buffer,
+                             context->hidden.fdio.len, iov, n, SDL_FALSE);
+    if (wrote < context->hidden.fdio.len) {
+        /* keep what wasn't written, for the next flush */
+        SDL_memmove(context->hidden.fdio.buffer,
+                    context->hidden.fdio.buffer + wrote,
+                    context->hidden.fdio.len - wrote);
+        context->hidden.fdio.len -= wrote;
+        return 0;
+    }
+    wrote -= context->hidden.fdio.len;
+    context->hidden.fdio.len = 0;
+    context->hidden.fdio.pos = 0;
+    context->hidden.fdio.writing = SDL_FALSE;
+    return wrote;
+}
+
+static int SDLCALL
+fd_close(SDL_RWops * context)
+{
+    int status = 0;
+    if (context) {
+        status = fd_flush(context);
+        if (close(context->hidden.fdio.fd) != 0 && status == 0) {
+            status = SDL_Error(SDL_EFWRITE);
+        }
+        free(context->hidden.fdio.buffer);
+        SDL_FreeRW(context);
+    }
+    return status;
+}
+
+/* Functions to read/write stream sockets, unbuffered (the kernel buffers) */
+
+static Sint64 SDLCALL
+socket_size(SDL_RWops * context)
+{
+    return -1;
+}
+
+static Sint64 SDLCALL
+socket_seek(SDL_RWops * context, Sint64 offset, int whence)
+{
+    return SDL_SetError("Can't seek a socket");
+}
+
+static size_t SDLCALL
+socket_read(SDL_RWops * context, void *ptr, size_t size, size_t maxnum)
+{
+    Uint8 *p = (Uint8 *) ptr;
+    size_t total_bytes = size * maxnum;
+    size_t total_read = 0;
+
+    if ((maxnum <= 0) || (size <= 0) || ((total_bytes / maxnum) != size)) {
+        return 0;
+    }
+    /* what's arrived, as soon as it's whole objects: waiting for all of
+       them could wait for data the peer only sends after an answer */
+    while (total_read < total_bytes) {
+        ssize_t r = recv(context->hidden.sockio.fd, p + total_read,
+                         total_bytes - total_read, 0);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0) {
+            SDL_Error(SDL_EFREAD);
+        }
+        if (r <= 0) {
+            break;
+        }
+        total_read += (size_t) r;
+        if (total_read % size == 0) {
+            break;
+        }
+    }
+    return (total_read / size);
+}
+
+static size_t SDLCALL
+socket_write(SDL_RWops * context, const void *ptr, size_t size, size_t num)
+{
+    const Uint8 *p = (const Uint8 *) ptr;
+    size_t total_bytes = size * num;
+    size_t left = total_bytes;
+
+    if ((num <= 0) || (size <= 0) || ((total_bytes / num) != size)) {
+        return 0;
+    }
+    while (left) {
+        ssize_t w = send(context->hidden.sockio.fd, p, left, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) {
+            continue;
+        }
+        if (w <= 0) {
+            SDL_Error(SDL_EFWRITE);
+            break;
+        }
+        p += w;
+        left -= w;
+    }
+    return (total_bytes - left) / size;
+}
+
+static size_t SDLCALL
+socket_writev(SDL_RWops * context, const SDL_RWiovec * iov, int n)
+{
+    return posix_writev_all(context->hidden.sockio.fd, NULL, 0, iov, n,
+                            SDL_TRUE);
+}
+
+static int SDLCALL
+socket_close(SDL_RWops * context)
+{
+    int status = 0;
+    if (context) {
+        if (context->hidden.sockio.autoclose &&
+            close(context->hidden.sockio.fd) != 0) {
+            status = SDL_Error(SDL_EFWRITE);
+        }
+        SDL_FreeRW(context);
+    }
+    return status;
+}
+
+#ifdef SDL_RWOPS_SENDFILE
+
+#ifndef SPLICE_F_MOVE
+#define SPLICE_F_MOVE 1
+#endif
+#ifndef SPLICE_F_MORE
+#define SPLICE_F_MORE 4
+#endif
+
+#define SDL_RWOPS_SENDFILE_MAX 0x7ffff000   /* the most one call moves */
+
+/* Move what's in a pipe to out, by hand if out can't be spliced to */
+static SDL_bool
+posix_drain(int pipe_in, int out, size_t left)
+{
+    char buffer[4096];
+
+    while (left) {
+        ssize_t w = -1;
+#ifdef __NR_splice
+        w = syscall(__NR_splice, pipe_in, NULL, out, NULL, left,
+                    SPLICE_F_MOVE | SPLICE_F_MORE);
+#endif
+        if (w < 0 && errno == EINTR) {
+            continue;
+        }
+        if (w < 0 && (errno == EINVAL || errno == ENOSYS)) {
+            ssize_t r = read(pipe_in, buffer, left < sizeof (buffer) ?
+                             left : sizeof (buffer));
+            char *p = buffer;
+            if (r <= 0) {
+                return SDL_FALSE;
+            }
+            left -= r;
+            while (r) {
+                w = write(out, p, r);
+                if (w < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (w <= 0) {
+                    return SDL_FALSE;
+                }
+                p += w;
+                r -= w;
+            }
+            continue;
+        }
+        if (w <= 0) {
+            return SDL_FALSE;
+        }
+        left -= w;
+    }
+    return SDL_TRUE;
+}
+
+/* Copy up to len bytes (all if negative) from in to out in the kernel,
+   from and to their file positions.  Returns the bytes copied; *more is
+   set if the kernel couldn't copy these, so the rest is left to a loop. */
+static Sint64
+posix_copy(int out, int in, Sint64 len, SDL_bool *more)
+{
+    enum { COPY_RANGE, SENDFILE, SPLICE, NONE } how = COPY_RANGE;
+    struct stat from, to;
+    int pipes[2] = { -1, -1 };
+    Sint64 total = 0;
+
+    *more = SDL_TRUE;
+    if (fstat(in, &from) != 0 || fstat(out, &to) != 0) {
+        return 0;
+    }
+    if (!S_ISREG(from.st_mode) || !S_ISREG(to.st_mode)) {
+        how = S_ISREG(from.st_mode) ? SENDFILE : SPLICE;
+    }
+    while (how != NONE && (len < 0 || total < len)) {
+        size_t want = SDL_RWOPS_SENDFILE_MAX;
+        ssize_t n = -1;
+
+        if (len >= 0 && (Sint64) want > len - total) {
+            want = (size_t) (len - total);
+        }
+        errno = ENOSYS;
+        if (how == COPY_RANGE) {
+#ifdef __NR_copy_file_range
+            n = syscall(__NR_copy_file_range, in, NULL, out, NULL, want, 0);
+#endif
+        } else if (how == SENDFILE) {
+            n = sendfile(out, in, NULL, want);
+        } else {
+#ifdef __NR_splice
+            if (pipes[0] < 0 && pipe(pipes) != 0) {
+                pipes[0] = -1;
+            } else {
+                n = syscall(__NR_splice, in, NULL, pipes[1], NULL,
+                            want < 65536 ? want : 65536,
+                            SPLICE_F_MOVE | SPLICE_F_MORE);
+            }
+#endif
+            if (n > 0 && !posix_drain(pipes[0], out, (size_t) n)) {
+                /* gone from the source, but not all written */
+                SDL_Error(SDL_EFWRITE);
+                *more = SDL_FALSE;
+                break;
+            }
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && total == 0 && (errno == ENOSYS || errno == EINVAL ||
+                                    errno == EXDEV || errno == EBADF ||
+                                    errno == EOPNOTSUPP)) {
+            /* not between these two, try the next way */
+            how = how == COPY_RANGE ? SENDFILE : how == SENDFILE &&
+                !S_ISREG(from.st_mode) ? NONE : how == SENDFILE ? SPLICE :
+                NONE;
+            continue;
+        }
+        if (n < 0) {
+            SDL_Error(SDL_EFWRITE);
+        }
+        if (n <= 0) {
+            *more = SDL_FALSE;  /* the end, or an error */
+            break;
+        }
+        total += n;
+    }
+    if (pipes[0] >= 0) {
+        close(pipes[0]);
+        close(pipes[1]);
+    }
+    if (total == len) {
+        *more = SDL_FALSE;
+    }
+    return total;
+}
+
+/* The descriptor of a stream to copy with, with its buffered writes
+   written (and reads dropped, for dst); -1 if it hasn't one */
+static int
+posix_copy_fd(SDL_RWops * context, SDL_bool dst)
+{
+    if (context->type == SDL_RWOPS_SOCKET) {
+        return context->hidden.sockio.fd;
+    }
+    if (context->type != SDL_RWOPS_FD || fd_flush(context) < 0) {
+        return -1;
+    }
+    if (dst) {
+        fd_unread(context);
+    }
+    return context->hidden.fdio.fd;
+}
+
+#endif /* SDL_RWOPS_SENDFILE */
+
+#endif /* SDL_RWOPS_POSIX */
+
 /* Functions to read/write memory pointers */
 
 static Sint64 SDLCALL
@@ -463,6 +1106,120 @@ mem_close(SDL_RWops * context)
 }
 
 
+/* Functions to read memory mapped (or loaded) files */
+
+#ifdef SDL_RWOPS_POSIX
+static int SDLCALL
+mapped_unmap_close(SDL_RWops * context)
+{
+    if (context) {
+        munmap(context->hidden.mem.base,
+               context->hidden.mem.stop - context->hidden.mem.base);
+        SDL_FreeRW(context);
+    }
+    return 0;
+}
+#endif
+
+static int SDLCALL
+mapped_free_close(SDL_RWops * context)
+{
+    if (context) {
+        SDL_free(context->hidden.mem.base);
+        SDL_FreeRW(context);
+    }
+    return 0;
+}
+
+static SDL_RWops *
+mapped_create(void *data, size_t size, int (SDLCALL * close) (SDL_RWops *))
+{
+    SDL_RWops *rwops = SDL_AllocRW();
+    if (rwops != NULL) {
+        rwops->size = mem_size;
+        rwops->seek = mem_seek;
+        rwops->read = mem_read;
+        rwops->write = mem_writeconst;
+        rwops->close = close;
+        rwops->hidden.mem.base = (Uint8 *) data;
+        rwops->hidden.mem.here = rwops->hidden.mem.base;
+        rwops->hidden.mem.stop = rwops->hidden.mem.base + size;
+        rwops->type = SDL_RWOPS_MAPPED;
+    }
+    return rwops;
+}
+
+#ifdef SDL_RWOPS_POSIX
+/* Map a regular, non-empty file (NULL if it can't be) */
+static SDL_RWops *
+mapped_map(const char *file)
+{
+    SDL_RWops *rwops;
+    struct stat info;
+    void *data;
+    int fd = open(file, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) ||
+        info.st_size <= 0 || (Uint64) info.st_size > SIZE_MAX) {
+        close(fd);
+        return NULL;
+    }
+    data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    madvise(data, (size_t) info.st_size, MADV_WILLNEED);
+    rwops = mapped_create(data, (size_t) info.st_size, mapped_unmap_close);
+    if (rwops == NULL) {
+        munmap(data, (size_t) info.st_size);
+    }
+    return rwops;
+}
+#endif
+
+/* Read a whole file into memory, for files which can't be mapped */
+static SDL_RWops *
+mapped_load(const char *file)
+{
+    SDL_RWops *rwops;
+    SDL_RWops *src = SDL_RWFromFile(file, "rb");
+    Sint64 size;
+    void *data;
+
+    if (src == NULL) {
+        return NULL;
+    }
+    size = SDL_RWsize(src);
+    if (size < 0 || (Uint64) size > SIZE_MAX) {
+        SDL_RWclose(src);
+        SDL_SetError("SDL_RWFromFileMapped(): Couldn't get size of %s", file);
+        return NULL;
+    }
+    /* an empty file still gets a buffer, so the data pointer isn't NULL */
+    data = SDL_malloc(size ? (size_t) size : 1);
+    if (data == NULL) {
+        SDL_RWclose(src);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    if (size && SDL_RWread(src, data, (size_t) size, 1) != 1) {
+        SDL_RWclose(src);
+        SDL_free(data);
+        SDL_SetError("SDL_RWFromFileMapped(): Couldn't read %s", file);
+        return NULL;
+    }
+    SDL_RWclose(src);
+    rwops = mapped_create(data, (size_t) size, mapped_free_close);
+    if (rwops == NULL) {
+        SDL_free(data);
+    }
+    return rwops;
+}
+
 /* Functions to create SDL_RWops structures from various data sources */
 
 SDL_RWops *
@@ -565,6 +1322,9 @@ SDL_RWFromFP(FILE * fp, SDL_bool autoclose)
         rwops->read = stdio_read;
         rwops->write = stdio_write;
         rwops->close = stdio_close;
+#ifdef SDL_RWOPS_POSIX
+        rwops->writev = stdio_writev;
+#endif
         rwops->hidden.stdio.fp = fp;
         rwops->hidden.stdio.autoclose = autoclose;
         rwops->type = SDL_RWOPS_STDFILE;
@@ -636,6 +1396,588 @@ SDL_RWFromConstMem(const void *mem, int size)
     return rwops;
 }
 
+SDL_RWops *
+SDL_RWFromFileMapped(const char *file)
+{
+    SDL_RWops *rwops = NULL;
+    if (!file || !*file) {
+        SDL_SetError("SDL_RWFromFileMapped(): No file specified");
+        return NULL;
+    }
+#ifdef SDL_RWOPS_POSIX
+    rwops = mapped_map(file);
+#endif
+    if (rwops == NULL) {
+        rwops = mapped_load(file);
+    }
+    return rwops;
+}
+
+const void *
+SDL_RWMappedData(SDL_RWops * context, size_t *size)
+{
+    if (context == NULL || (context->type != SDL_RWOPS_MEMORY &&
+        context->type != SDL_RWOPS_MEMORY_RO &&
+        context->type != SDL_RWOPS_MAPPED)) {
+        SDL_SetError("SDL_RWMappedData(): Not a memory stream");
+        return NULL;
+    }
+    if (size) {
+        *size = context->hidden.mem.stop - context->hidden.mem.base;
+    }
+    return context->hidden.mem.base;
+}
+
+SDL_RWops *
+SDL_RWFromFileFD(const char *file, const char *mode, size_t buffer_size)
+{
+#ifdef SDL_RWOPS_POSIX
+    SDL_RWops *rwops;
+    void *buffer;
+    int flags;
+    int fd;
+
+    if (!file || !*file || !mode || !*mode) {
+        SDL_SetError("SDL_RWFromFileFD(): No file or no mode specified");
+        return NULL;
+    }
+    switch (mode[0]) {
+    case 'r':
+        flags = SDL_strchr(mode, '+') ? O_RDWR : O_RDONLY;
+        break;
+    case 'w':
+        flags = (SDL_strchr(mode, '+') ? O_RDWR : O_WRONLY) | O_CREAT |
+            O_TRUNC;
+        break;
+    case 'a':
+        flags = (SDL_strchr(mode, '+') ? O_RDWR : O_WRONLY) | O_CREAT |
+            O_APPEND;
+        break;
+    default:
+        SDL_SetError("SDL_RWFromFileFD(): Unknown mode %s", mode);
+        return NULL;
+    }
+#ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#endif
+    if (buffer_size == 0) {
+        buffer_size = SDL_RWOPS_FD_BUFFER;
+    }
+    /* page aligned, so whole pages are copied to and from the kernel */
+    buffer_size = (buffer_size + SDL_RWOPS_FD_ALIGN - 1) &
+        ~(size_t) (SDL_RWOPS_FD_ALIGN - 1);
+    if (posix_memalign(&buffer, SDL_RWOPS_FD_ALIGN, buffer_size) != 0) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    fd = open(file, flags, 0666);
+    if (fd < 0) {
+        free(buffer);
+        SDL_SetError("Couldn't open %s", file);
+        return NULL;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    /* streaming: ask for more readahead, and drop pages behind us sooner */
+    if ((flags & O_ACCMODE) != O_WRONLY) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+    rwops = SDL_AllocRW();
+    if (rwops == NULL) {
+        close(fd);
+        free(buffer);
+        return NULL;
+    }
+    rwops->size = fd_size;
+    rwops->seek = fd_seek;
+    rwops->read = fd_read;
+    rwops->write = fd_write;
+    rwops->close = fd_close;
+    rwops->writev = fd_writev;
+    rwops->hidden.fdio.fd = fd;
+    rwops->hidden.fdio.writing = SDL_FALSE;
+    rwops->hidden.fdio.readonly =
+        ((flags & O_ACCMODE) == O_RDONLY) ? SDL_TRUE : SDL_FALSE;
+    rwops->hidden.fdio.buffer = (Uint8 *) buffer;
+    rwops->hidden.fdio.size = buffer_size;
+    rwops->hidden.fdio.len = 0;
+    rwops->hidden.fdio.pos = 0;
+    rwops->type = SDL_RWOPS_FD;
+    return rwops;
+#else
+    SDL_Unsupported();
+    return NULL;
+#endif /* SDL_RWOPS_POSIX */
+}
+
+SDL_RWops *
+SDL_RWFromSocket(int sock, SDL_bool autoclose)
+{
+#ifdef SDL_RWOPS_POSIX
+    SDL_RWops *rwops;
+
+    if (sock < 0) {
+        SDL_InvalidParamError("sock");
+        return NULL;
+    }
+    rwops = SDL_AllocRW();
+    if (rwops == NULL) {
+        return NULL;
+    }
+#ifdef SO_NOSIGPIPE
+    {
+        /* a closed connection is a write error, not a signal */
+        int on = 1;
+        setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof (on));
+    }
+#endif
+    rwops->size = socket_size;
+    rwops->seek = socket_seek;
+    rwops->read = socket_read;
+    rwops->write = socket_write;
+    rwops->close = socket_close;
+    rwops->writev = socket_writev;
+    rwops->hidden.sockio.fd = sock;
+    rwops->hidden.sockio.autoclose = autoclose;
+    rwops->type = SDL_RWOPS_SOCKET;
+    return rwops;
+#else
+    SDL_Unsupported();
+    return NULL;
+#endif /* SDL_RWOPS_POSIX */
+}
+
+SDL_RWops *
+SDL_RWFromTCP(const char *host, Uint16 port)
+{
+#ifdef SDL_RWOPS_POSIX
+    struct addrinfo hints, *addrs, *addr;
+    SDL_RWops *rwops;
+    char service[6];
+    int sock = -1;
+
+    if (!host || !*host) {
+        SDL_InvalidParamError("host");
+        return NULL;
+    }
+    SDL_zero(hints);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    SDL_snprintf(service, sizeof (service), "%u", (unsigned) port);
+    if (getaddrinfo(host, service, &hints, &addrs) != 0) {
+        SDL_SetError("Couldn't resolve %s", host);
+        return NULL;
+    }
+    /* the first address which connects, IPv6 or IPv4 */
+    for (addr = addrs; addr; addr = addr->ai_next) {
+        sock = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (sock < 0) {
+            continue;
+        }
+#ifdef FD_CLOEXEC
+        fcntl(sock, F_SETFD, FD_CLOEXEC);
+#endif
+        if (connect(sock, addr->ai_addr, addr->ai_addrlen) == 0) {
+            break;
+        }
+        close(sock);
+        sock = -1;
+    }
+    freeaddrinfo(addrs);
+    if (sock < 0) {
+        SDL_SetError("Couldn't connect to %s:%u", host, (unsigned) port);
+        return NULL;
+    }
+    rwops = SDL_RWFromSocket(sock, SDL_TRUE);
+    if (rwops == NULL) {
+        close(sock);
+    }
+    return rwops;
+#else
+    SDL_Unsupported();
+    return NULL;
+#endif /* SDL_RWOPS_POSIX */
+}
+
+size_t
+SDL_RWreadAt(SDL_RWops * context, void *ptr, size_t size, size_t maxnum,
+             Sint64 offset)
+{
+    size_t total_bytes = size * maxnum;
+    size_t nread;
+    Sint64 pos;
+
+    if ((maxnum <= 0) || (size <= 0) || ((total_bytes / maxnum) != size)) {
+        return 0;
+    }
+#ifdef SDL_RWOPS_POSIX
+    if (context->type == SDL_RWOPS_FD) {
+        Uint8 *p = (Uint8 *) ptr;
+        size_t total_read = 0;
+        /* so buffered writes are seen */
+        if (fd_flush(context) < 0) {
+            return 0;
+        }
+        while (total_read < total_bytes) {
+            ssize_t r = pread(context->hidden.fdio.fd, p + total_read,
+                              total_bytes - total_read,
+                              (off_t) (offset + total_read));
+            if (r < 0 && errno == EINTR) {
+                continue;
+            }
+            if (r < 0) {
+                SDL_Error(SDL_EFREAD);
+            }
+            if (r <= 0) {
+                break;
+            }
+            total_read += (size_t) r;
+        }
+        return (total_read / size);
+    }
+#endif
+    pos = SDL_RWtell(context);
+    if (pos < 0 || SDL_RWseek(context, offset, RW_SEEK_SET) < 0) {
+        return 0;
+    }
+    nread = SDL_RWread(context, ptr, size, maxnum);
+    SDL_RWseek(context, pos, RW_SEEK_SET);
+    return nread;
+}
+
+size_t
+SDL_RWwriteAt(SDL_RWops * context, const void *ptr, size_t size, size_t num,
+              Sint64 offset)
+{
+    size_t total_bytes = size * num;
+    size_t nwrote;
+    Sint64 pos;
+
+    if ((num <= 0) || (size <= 0) || ((total_bytes / num) != size)) {
+        return 0;
+    }
+#ifdef SDL_RWOPS_POSIX
+    if (context->type == SDL_RWOPS_FD) {
+        const Uint8 *p = (const Uint8 *) ptr;
+        size_t total_wrote = 0;
+        /* buffered data would be stale, and writes out of order */
+        if (fd_flush(context) < 0) {
+            return 0;
+        }
+        fd_unread(context);
+        while (total_wrote < total_bytes) {
+            ssize_t w = pwrite(context->hidden.fdio.fd, p + total_wrote,
+                               total_bytes - total_wrote,
+                               (off_t) (offset + total_wrote));
+            if (w < 0 && errno == EINTR) {
+                continue;
+            }
+            if (w <= 0) {
+                SDL_Error(SDL_EFWRITE);
+                break;
+            }
+            total_wrote += (size_t) w;
+        }
+        return (total_wrote / size);
+    }
+#endif
+    pos = SDL_RWtell(context);
+    if (pos < 0 || SDL_RWseek(context, offset, RW_SEEK_SET) < 0) {
+        return 0;
+    }
+    nwrote = SDL_RWwrite(context, ptr, size, num);
+    SDL_RWseek(context, pos, RW_SEEK_SET);
+    return nwrote;
+}
+
+size_t
+SDL_RWwritev(SDL_RWops * context, const SDL_RWiovec * iov, int n)
+{
+    size_t total = 0;
+    int i;
+
+    if (context->writev) {
+        return context->writev(context, iov, n);
+    }
+    for (i = 0; i < n; i++) {
+        if (iov[i].len == 0) {
+            continue;
+        }
+        if (SDL_RWwrite(context, iov[i].base, 1, iov[i].len) != iov[i].len) {
+            break;
+        }
+        total += iov[i].len;
+    }
+    return total;
+}
+
+Sint64
+SDL_RWcopy(SDL_RWops * dst, SDL_RWops * src, Sint64 len)
+{
+    Sint64 total = 0;
+    Uint8 *buffer;
+
+    if (!dst || !src) {
+        return SDL_InvalidParamError(!dst ? "dst" : "src");
+    }
+#ifdef SDL_RWOPS_SENDFILE
+    {
+        int out = posix_copy_fd(dst, SDL_TRUE);
+        int in = posix_copy_fd(src, SDL_FALSE);
+        SDL_bool more = SDL_TRUE;
+
+        /* what src has read ahead goes first */
+        if (out >= 0 && in >= 0 && src->type == SDL_RWOPS_FD) {
+            size_t ahead = src->hidden.fdio.len - src->hidden.fdio.pos;
+            if (len >= 0 && (Sint64) ahead > len) {
+                ahead = (size_t) len;
+            }
+            if (ahead) {
+                total = (Sint64) SDL_RWwrite(dst, src->hidden.fdio.buffer +
+                                             src->hidden.fdio.pos, 1, ahead);
+                src->hidden.fdio.pos += (size_t) total;
+                if ((size_t) total < ahead || total == len ||
+                    posix_copy_fd(dst, SDL_TRUE) < 0) {
+                    return total;
+                }
+            }
+            src->hidden.fdio.len = 0;
+            src->hidden.fdio.pos = 0;
+        }
+        if (out >= 0 && in >= 0) {
+            total += posix_copy(out, in, len < 0 ? len : len - total, &more);
+            if (!more) {
+                return total;
+            }
+        }
+    }
+#endif
+    /* a big buffer, so few reads and writes */
+    buffer = (Uint8 *) SDL_malloc(SDL_RWOPS_COPY_BUFFER);
+    if (buffer == NULL) {
+        SDL_OutOfMemory();
+        return total;
+    }
+    while (len < 0 || total < len) {
+        size_t want = SDL_RWOPS_COPY_BUFFER;
+        size_t got;
+        size_t wrote;
+
+        if (len >= 0 && (Sint64) want > len - total) {
+            want = (size_t) (len - total);
+        }
+        got = SDL_RWread(src, buffer, 1, want);
+        if (got == 0) {
+            break;
+        }
+        wrote = SDL_RWwrite(dst, buffer, 1, got);
+        total += wrote;
+        if (wrote < got) {
+            break;
+        }
+    }
+    SDL_free(buffer);
+    return total;
+}
+
+struct SDL_RWreader
+{
+    SDL_RWops *src;
+    const char *data;           /* the buffer, or a memory stream's memory */
+    char *buffer;               /* NULL for a memory stream */
+    size_t size;                /* of the buffer */
+    size_t pos;                 /* start of the next record in data */
+    size_t len;                 /* bytes in data */
+    size_t scanned;             /* bytes from pos without a delimiter */
+    SDL_bool eof;
+};
+
+/* The first c in the n bytes at p, or NULL */
+static const char *
+reader_find(const char *p, size_t n, char c)
+{
+    size_t i = 0;
+
+#if SDL_RWOPS_FIND_SSE2
+    const __m128i v = _mm_set1_epi8(c);
+    for (; i + 16 <= n; i += 16) {
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_loadu_si128((const __m128i *) (p + i)), v));
+        if (mask) {
+            return p + i + __builtin_ctz(mask);
+        }
+    }
+#elif SDL_RWOPS_FIND_NEON
+    const uint8x16_t v = vdupq_n_u8((Uint8) c);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8((const Uint8 *) (p + i)), v);
+        /* 4 bits per byte, set where a byte is c */
+        Uint64 mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(
+            vreinterpretq_u16_u8(eq), 4)), 0);
+        if (mask) {
+            return p + i + __builtin_ctzll(mask) / 4;
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        if (p[i] == c) {
+            return p + i;
+        }
+    }
+    return NULL;
+}
+
+/* Read more after the partial record, which is moved to the front first (the
+   buffer's doubled if it's all one record) */
+static void
+reader_fill(SDL_RWreader * reader)
+{
+    SDL_RWops *src = reader->src;
+    size_t want;
+    size_t got = 0;
+
+    if (reader->buffer == NULL) {
+        reader->eof = SDL_TRUE;     /* a memory stream's all there */
+        return;
+    }
+    if (reader->pos) {
+        SDL_memmove(reader->buffer, reader->buffer + reader->pos,
+                    reader->len - reader->pos);
+        reader->len -= reader->pos;
+        reader->pos = 0;
+    }
+    if (reader->len == reader->size) {
+        char *bigger = (char *) SDL_realloc(reader->buffer, reader->size * 2);
+        if (bigger == NULL) {
+            SDL_OutOfMemory();
+            reader->eof = SDL_TRUE;
+            return;
+        }
+        reader->buffer = bigger;
+        reader->data = bigger;
+        reader->size *= 2;
+    }
+    want = reader->size - reader->len;
+#ifdef SDL_RWOPS_POSIX
+    /* straight from the file once what the stream read ahead is used, not
+       through its buffer too */
+    if (src->type == SDL_RWOPS_FD && !src->hidden.fdio.writing &&
+        src->hidden.fdio.pos == src->hidden.fdio.len) {
+        ssize_t r;
+        do {
+            r = read(src->hidden.fdio.fd, reader->buffer + reader->len, want);
+        } while (r < 0 && errno == EINTR);
+        if (r < 0) {
+            SDL_Error(SDL_EFREAD);
+        }
+        got = r > 0 ? (size_t) r : 0;
+    } else
+#endif
+    {
+        got = SDL_RWread(src, reader->buffer + reader->len, 1, want);
+    }
+    if (got == 0) {
+        reader->eof = SDL_TRUE;
+    }
+    reader->len += got;
+}
+
+SDL_RWreader *
+SDL_RWreaderCreate(SDL_RWops * src, size_t buffer_size)
+{
+    SDL_RWreader *reader;
+
+    if (!src) {
+        SDL_InvalidParamError("src");
+        return NULL;
+    }
+    reader = (SDL_RWreader *) SDL_calloc(1, sizeof(*reader));
+    if (reader == NULL) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    reader->src = src;
+    if (src->type == SDL_RWOPS_MEMORY || src->type == SDL_RWOPS_MEMORY_RO ||
+        src->type == SDL_RWOPS_MAPPED) {
+        reader->data = (const char *) src->hidden.mem.here;
+        reader->len = src->hidden.mem.stop - src->hidden.mem.here;
+        reader->eof = SDL_TRUE;
+        return reader;
+    }
+    reader->size = buffer_size ? buffer_size : SDL_RWOPS_READER_BUFFER;
+    reader->buffer = (char *) SDL_malloc(reader->size);
+    if (reader->buffer == NULL) {
+        SDL_free(reader);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    reader->data = reader->buffer;
+    return reader;
+}
+
+const char *
+SDL_RWreadRecord(SDL_RWreader * reader, char delim, size_t *length)
+{
+    for (;;) {
+        const char *start = reader->data + reader->pos;
+        size_t avail = reader->len - reader->pos;
+        const char *end = reader_find(start + reader->scanned,
+                                      avail - reader->scanned, delim);
+
+        if (end != NULL || (reader->eof && avail)) {
+            size_t n = end ? (size_t) (end - start) : avail;
+            reader->pos += end ? n + 1 : n;
+            reader->scanned = 0;
+            if (length) {
+                *length = n;
+            }
+            return start;
+        }
+        if (reader->eof) {
+            if (length) {
+                *length = 0;
+            }
+            return NULL;
+        }
+        reader->scanned = avail;
+        reader_fill(reader);
+    }
+}
+
+const char *
+SDL_RWreadLine(SDL_RWreader * reader, size_t *length)
+{
+    size_t n;
+    const char *line = SDL_RWreadRecord(reader, '\n', &n);
+
+    if (line && n && line[n - 1] == '\r') {
+        --n;
+    }
+    if (length) {
+        *length = n;
+    }
+    return line;
+}
+
+void
+SDL_RWreaderDestroy(SDL_RWreader * reader)
+{
+    if (reader == NULL) {
+        return;
+    }
+    if (reader->buffer == NULL) {
+        reader->src->hidden.mem.here += reader->pos;
+    } else {
+        /* back over what was read ahead */
+        if (reader->len > reader->pos) {
+            SDL_RWseek(reader->src, -(Sint64) (reader->len - reader->pos),
+                       RW_SEEK_CUR);
+        }
+        SDL_free(reader->buffer);
+    }
+    SDL_free(reader);
+}
+
 SDL_RWops *
 SDL_AllocRW(void)
 {
@@ -646,6 +1988,7 @@ SDL_AllocRW(void)
         SDL_OutOfMemory();
     } else {
         area->type = SDL_RWOPS_UNKNOWN;
+        area->writev = NULL;
     }
     return area;
 }
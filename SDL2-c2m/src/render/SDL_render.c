@@ -1051,6 +1051,27 @@ SDL_UnlockTexture(SDL_Texture * texture)
     }
 }
 
+int
+SDL_SetTexturePixels(SDL_Texture * texture, void *pixels, int pitch)
+{
+    SDL_Renderer *renderer;
+
+    CHECK_TEXTURE_MAGIC(texture, -1);
+
+    if (texture->access != SDL_TEXTUREACCESS_STREAMING) {
+        return SDL_SetError("SDL_SetTexturePixels(): texture must be streaming");
+    }
+    if (pixels && pitch < texture->w * SDL_BYTESPERPIXEL(texture->format)) {
+        return SDL_InvalidParamError("pitch");
+    }
+
+    renderer = texture->renderer;
+    if (texture->yuv || texture->native || !renderer->SetTexturePixels) {
+        return SDL_Unsupported();
+    }
+    return renderer->SetTexturePixels(renderer, texture, pixels, pitch);
+}
+
 SDL_bool
 SDL_RenderTargetSupported(SDL_Renderer *renderer)
 {
@@ -1838,6 +1859,17 @@ SDL_RenderPresent(SDL_Renderer * renderer)
     renderer->RenderPresent(renderer);
 }
 
+int
+SDL_RenderFlush(SDL_Renderer * renderer)
+{
+    CHECK_RENDERER_MAGIC(renderer, -1);
+
+    if (!renderer->RenderFlush) {
+        return 0;
+    }
+    return renderer->RenderFlush(renderer);
+}
+
 void
 SDL_DestroyTexture(SDL_Texture * texture)
 {
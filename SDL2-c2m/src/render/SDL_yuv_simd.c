@@ -0,0 +1,473 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* SSE2 & AVX2 (chosen at run time) or NEON YUV to 32-bit RGB converters.
+
+   They do the tables' arithmetic in 16 bit lanes: each chroma term is
+   (c - 128) * k + 8192 >> 14, worked out in 32 bits with pmaddwd (or a
+   widening multiply), Y plus the terms then goes through the same for
+   limited range Y, and the sums are clamped to 0..255.  The results are
+   the pixels the tables give.
+*/
+
+#include "SDL_video.h"
+#include "SDL_yuv_sw_c.h"
+#include "../video/SDL_blit.h"
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN && defined(__GNUC__) && \
+    !defined(__clang_analyzer__) && (defined(__x86_64__) || defined(__i386__))
+#define SDL_YUV_X86 1
+#include <immintrin.h>
+#elif SDL_BYTEORDER == SDL_LIL_ENDIAN && defined(__GNUC__) && \
+    !defined(__clang_analyzer__) && defined(__aarch64__)
+#define SDL_YUV_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if SDL_YUV_X86
+/* (c * k + 8192) >> 14 for eight 16 bit c */
+__attribute__((target("sse2"))) static SDL_INLINE __m128i
+YUVTermSSE2(__m128i c, int k)
+{
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i kr = _mm_set1_epi32((8192 << 16) | (k & 0xffff));
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(c, one), kr);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(c, one), kr);
+
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 14), _mm_srai_epi32(hi, 14));
+}
+
+/* The same for the 16 bit c in the low (high == 0) or high half of each
+   32 bit lane, the result in both halves */
+__attribute__((target("sse2"))) static SDL_INLINE __m128i
+YUVPairTermSSE2(__m128i c, int high, int k)
+{
+    const __m128i kr = _mm_set1_epi32((8192 << 16) | (k & 0xffff));
+    __m128i t;
+
+    c = high ? _mm_srli_epi32(c, 16) : _mm_and_si128(c, _mm_set1_epi32(0xffff));
+    t = _mm_srai_epi32(_mm_madd_epi16(_mm_or_si128(c, _mm_set1_epi32(0x10000)), kr), 14);
+    return _mm_or_si128(_mm_and_si128(t, _mm_set1_epi32(0xffff)), _mm_slli_epi32(t, 16));
+}
+
+/* Eight pixels of Y plus the terms */
+__attribute__((target("sse2"))) static SDL_INLINE void
+YUVStoreSSE2(const SDL_SW_YUVTexture * swdata, Uint32 * out,
+             __m128i r, __m128i g, __m128i b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    __m128i bg, ra;
+
+    if (swdata->matrix.y_scale) {
+        const __m128i y16 = _mm_set1_epi16(16);
+
+        r = YUVTermSSE2(_mm_sub_epi16(r, y16), swdata->matrix.y_scale);
+        g = YUVTermSSE2(_mm_sub_epi16(g, y16), swdata->matrix.y_scale);
+        b = YUVTermSSE2(_mm_sub_epi16(b, y16), swdata->matrix.y_scale);
+    }
+    if (swdata->simd_rgb) {
+        __m128i t = r;
+
+        r = b;
+        b = t;
+    }
+    r = _mm_min_epi16(_mm_max_epi16(r, zero), max);
+    g = _mm_min_epi16(_mm_max_epi16(g, zero), max);
+    b = _mm_min_epi16(_mm_max_epi16(b, zero), max);
+    bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+    ra = _mm_or_si128(r, _mm_set1_epi16((short) (swdata->simd_alpha << 8)));
+    _mm_storeu_si128((__m128i *) out, _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i *) (out + 4), _mm_unpackhi_epi16(bg, ra));
+}
+
+__attribute__((target("sse2"))) static int
+YUVRowPairSSE2(const SDL_SW_YUVTexture * swdata,
+               const Uint8 * lum1, const Uint8 * lum2,
+               const Uint8 * cr, const Uint8 * cb, int cstep,
+               Uint32 * out1, Uint32 * out2, int n)
+{
+    const SDL_SW_YUVMatrix *m = &swdata->matrix;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c128 = _mm_set1_epi16(128);
+    const Uint8 *uv = SDL_min(cr, cb);
+    int x;
+
+    for (x = 0; x + 16 <= n; x += 16) {
+        __m128i vcr, vcb, tr, tg, tb, y;
+
+        if (cstep == 1) {
+            vcr = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (cr + x / 2)), zero);
+            vcb = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (cb + x / 2)), zero);
+        } else {
+            __m128i w = _mm_loadu_si128((const __m128i *) (uv + x));
+            __m128i lo = _mm_and_si128(w, _mm_set1_epi16(0xff));
+            __m128i hi = _mm_srli_epi16(w, 8);
+
+            vcr = (cr > cb) ? hi : lo;
+            vcb = (cr > cb) ? lo : hi;
+        }
+        vcr = _mm_sub_epi16(vcr, c128);
+        vcb = _mm_sub_epi16(vcb, c128);
+        tr = YUVTermSSE2(vcr, m->cr_r);
+        tg = _mm_add_epi16(YUVTermSSE2(vcr, m->cr_g), YUVTermSSE2(vcb, m->cb_g));
+        tb = YUVTermSSE2(vcb, m->cb_b);
+
+        y = _mm_unpacklo_epi8(_mm_loadu_si128((const __m128i *) (lum1 + x)), zero);
+        YUVStoreSSE2(swdata, out1 + x, _mm_add_epi16(y, _mm_unpacklo_epi16(tr, tr)),
+                     _mm_add_epi16(y, _mm_unpacklo_epi16(tg, tg)),
+                     _mm_add_epi16(y, _mm_unpacklo_epi16(tb, tb)));
+        y = _mm_unpackhi_epi8(_mm_loadu_si128((const __m128i *) (lum1 + x)), zero);
+        YUVStoreSSE2(swdata, out1 + x + 8, _mm_add_epi16(y, _mm_unpackhi_epi16(tr, tr)),
+                     _mm_add_epi16(y, _mm_unpackhi_epi16(tg, tg)),
+                     _mm_add_epi16(y, _mm_unpackhi_epi16(tb, tb)));
+        y = _mm_unpacklo_epi8(_mm_loadu_si128((const __m128i *) (lum2 + x)), zero);
+        YUVStoreSSE2(swdata, out2 + x, _mm_add_epi16(y, _mm_unpacklo_epi16(tr, tr)),
+                     _mm_add_epi16(y, _mm_unpacklo_epi16(tg, tg)),
+                     _mm_add_epi16(y, _mm_unpacklo_epi16(tb, tb)));
+        y = _mm_unpackhi_epi8(_mm_loadu_si128((const __m128i *) (lum2 + x)), zero);
+        YUVStoreSSE2(swdata, out2 + x + 8, _mm_add_epi16(y, _mm_unpackhi_epi16(tr, tr)),
+                     _mm_add_epi16(y, _mm_unpackhi_epi16(tg, tg)),
+                     _mm_add_epi16(y, _mm_unpackhi_epi16(tb, tb)));
+    }
+    return x;
+}
+
+__attribute__((target("sse2"))) static int
+YUVRowPackedSSE2(const SDL_SW_YUVTexture * swdata, const Uint8 * src,
+                 int lum_ofs, int cr_ofs, int cb_ofs, Uint32 * out, int n)
+{
+    const SDL_SW_YUVMatrix *m = &swdata->matrix;
+    const __m128i lowbytes = _mm_set1_epi16(0xff);
+    const __m128i c128 = _mm_set1_epi16(128);
+    int x;
+
+    for (x = 0; x + 8 <= n; x += 8) {
+        __m128i w = _mm_loadu_si128((const __m128i *) (src + 2 * x));
+        __m128i y = lum_ofs ? _mm_srli_epi16(w, 8) : _mm_and_si128(w, lowbytes);
+        __m128i c = lum_ofs ? _mm_and_si128(w, lowbytes) : _mm_srli_epi16(w, 8);
+        __m128i tr, tg, tb;
+
+        c = _mm_sub_epi16(c, c128);
+        tr = YUVPairTermSSE2(c, cr_ofs >= 2, m->cr_r);
+        tg = _mm_add_epi16(YUVPairTermSSE2(c, cr_ofs >= 2, m->cr_g),
+                           YUVPairTermSSE2(c, cb_ofs >= 2, m->cb_g));
+        tb = YUVPairTermSSE2(c, cb_ofs >= 2, m->cb_b);
+        YUVStoreSSE2(swdata, out + x, _mm_add_epi16(y, tr),
+                     _mm_add_epi16(y, tg), _mm_add_epi16(y, tb));
+    }
+    return x;
+}
+
+/* (c * k + 8192) >> 14 for sixteen 16 bit c, in order */
+__attribute__((target("avx2"))) static SDL_INLINE __m256i
+YUVTermAVX2(__m256i c, int k)
+{
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i kr = _mm256_set1_epi32((8192 << 16) | (k & 0xffff));
+    __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(c, one), kr);
+    __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(c, one), kr);
+
+    return _mm256_packs_epi32(_mm256_srai_epi32(lo, 14), _mm256_srai_epi32(hi, 14));
+}
+
+__attribute__((target("avx2"))) static SDL_INLINE __m256i
+YUVPairTermAVX2(__m256i c, int high, int k)
+{
+    const __m256i kr = _mm256_set1_epi32((8192 << 16) | (k & 0xffff));
+    __m256i t;
+
+    c = high ? _mm256_srli_epi32(c, 16) : _mm256_and_si256(c, _mm256_set1_epi32(0xffff));
+    t = _mm256_srai_epi32(_mm256_madd_epi16(_mm256_or_si256(c, _mm256_set1_epi32(0x10000)), kr), 14);
+    return _mm256_or_si256(_mm256_and_si256(t, _mm256_set1_epi32(0xffff)), _mm256_slli_epi32(t, 16));
+}
+
+/* Sixteen pixels of Y plus the terms; unpacking works in 128 bit lanes,
+   so the halves are put back in order */
+__attribute__((target("avx2"))) static SDL_INLINE void
+YUVStoreAVX2(const SDL_SW_YUVTexture * swdata, Uint32 * out,
+             __m256i r, __m256i g, __m256i b)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(255);
+    __m256i bg, ra, lo, hi;
+
+    if (swdata->matrix.y_scale) {
+        const __m256i y16 = _mm256_set1_epi16(16);
+
+        r = YUVTermAVX2(_mm256_sub_epi16(r, y16), swdata->matrix.y_scale);
+        g = YUVTermAVX2(_mm256_sub_epi16(g, y16), swdata->matrix.y_scale);
+        b = YUVTermAVX2(_mm256_sub_epi16(b, y16), swdata->matrix.y_scale);
+    }
+    if (swdata->simd_rgb) {
+        __m256i t = r;
+
+        r = b;
+        b = t;
+    }
+    r = _mm256_min_epi16(_mm256_max_epi16(r, zero), max);
+    g = _mm256_min_epi16(_mm256_max_epi16(g, zero), max);
+    b = _mm256_min_epi16(_mm256_max_epi16(b, zero), max);
+    bg = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+    ra = _mm256_or_si256(r, _mm256_set1_epi16((short) (swdata->simd_alpha << 8)));
+    lo = _mm256_unpacklo_epi16(bg, ra);
+    hi = _mm256_unpackhi_epi16(bg, ra);
+    _mm256_storeu_si256((__m256i *) out, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i *) (out + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+__attribute__((target("avx2"))) static int
+YUVRowPairAVX2(const SDL_SW_YUVTexture * swdata,
+               const Uint8 * lum1, const Uint8 * lum2,
+               const Uint8 * cr, const Uint8 * cb, int cstep,
+               Uint32 * out1, Uint32 * out2, int n)
+{
+    const SDL_SW_YUVMatrix *m = &swdata->matrix;
+    const __m256i c128 = _mm256_set1_epi16(128);
+    const Uint8 *uv = SDL_min(cr, cb);
+    int x;
+
+    for (x = 0; x + 32 <= n; x += 32) {
+        __m256i vcr, vcb, tr, tg, tb, lo, hi;
+        __m256i tr1, tr2, tg1, tg2, tb1, tb2;
+        int row;
+
+        if (cstep == 1) {
+            vcr = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (cr + x / 2)));
+            vcb = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (cb + x / 2)));
+        } else {
+            __m256i w = _mm256_loadu_si256((const __m256i *) (uv + x));
+
+            lo = _mm256_and_si256(w, _mm256_set1_epi16(0xff));
+            hi = _mm256_srli_epi16(w, 8);
+            vcr = (cr > cb) ? hi : lo;
+            vcb = (cr > cb) ? lo : hi;
+        }
+        vcr = _mm256_sub_epi16(vcr, c128);
+        vcb = _mm256_sub_epi16(vcb, c128);
+        tr = YUVTermAVX2(vcr, m->cr_r);
+        tg = _mm256_add_epi16(YUVTermAVX2(vcr, m->cr_g), YUVTermAVX2(vcb, m->cb_g));
+        tb = YUVTermAVX2(vcb, m->cb_b);
+
+        /* Each term for two pixels: 0-15 and 16-31 */
+        lo = _mm256_unpacklo_epi16(tr, tr);
+        hi = _mm256_unpackhi_epi16(tr, tr);
+        tr1 = _mm256_permute2x128_si256(lo, hi, 0x20);
+        tr2 = _mm256_permute2x128_si256(lo, hi, 0x31);
+        lo = _mm256_unpacklo_epi16(tg, tg);
+        hi = _mm256_unpackhi_epi16(tg, tg);
+        tg1 = _mm256_permute2x128_si256(lo, hi, 0x20);
+        tg2 = _mm256_permute2x128_si256(lo, hi, 0x31);
+        lo = _mm256_unpacklo_epi16(tb, tb);
+        hi = _mm256_unpackhi_epi16(tb, tb);
+        tb1 = _mm256_permute2x128_si256(lo, hi, 0x20);
+        tb2 = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+        for (row = 0; row < 2; ++row) {
+            const Uint8 *lum = row ? lum2 : lum1;
+            Uint32 *out = row ? out2 : out1;
+            __m256i y;
+
+            y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (lum + x)));
+            YUVStoreAVX2(swdata, out + x, _mm256_add_epi16(y, tr1),
+                         _mm256_add_epi16(y, tg1), _mm256_add_epi16(y, tb1));
+            y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (lum + x + 16)));
+            YUVStoreAVX2(swdata, out + x + 16, _mm256_add_epi16(y, tr2),
+                         _mm256_add_epi16(y, tg2), _mm256_add_epi16(y, tb2));
+        }
+    }
+    return x;
+}
+
+__attribute__((target("avx2"))) static int
+YUVRowPackedAVX2(const SDL_SW_YUVTexture * swdata, const Uint8 * src,
+                 int lum_ofs, int cr_ofs, int cb_ofs, Uint32 * out, int n)
+{
+    const SDL_SW_YUVMatrix *m = &swdata->matrix;
+    const __m256i lowbytes = _mm256_set1_epi16(0xff);
+    const __m256i c128 = _mm256_set1_epi16(128);
+    int x;
+
+    for (x = 0; x + 16 <= n; x += 16) {
+        __m256i w = _mm256_loadu_si256((const __m256i *) (src + 2 * x));
+        __m256i y = lum_ofs ? _mm256_srli_epi16(w, 8) : _mm256_and_si256(w, lowbytes);
+        __m256i c = lum_ofs ? _mm256_and_si256(w, lowbytes) : _mm256_srli_epi16(w, 8);
+        __m256i tr, tg, tb;
+
+        c = _mm256_sub_epi16(c, c128);
+        tr = YUVPairTermAVX2(c, cr_ofs >= 2, m->cr_r);
+        tg = _mm256_add_epi16(YUVPairTermAVX2(c, cr_ofs >= 2, m->cr_g),
+                              YUVPairTermAVX2(c, cb_ofs >= 2, m->cb_g));
+        tb = YUVPairTermAVX2(c, cb_ofs >= 2, m->cb_b);
+        YUVStoreAVX2(swdata, out + x, _mm256_add_epi16(y, tr),
+                     _mm256_add_epi16(y, tg), _mm256_add_epi16(y, tb));
+    }
+    return x;
+}
+#endif /* SDL_YUV_X86 */
+
+#if SDL_YUV_NEON
+/* (c * k + 8192) >> 14 for eight 16 bit c */
+static SDL_INLINE int16x8_t
+YUVTermNEON(int16x8_t c, int k)
+{
+    int32x4_t lo = vmlal_n_s16(vdupq_n_s32(8192), vget_low_s16(c), (int16_t) k);
+    int32x4_t hi = vmlal_n_s16(vdupq_n_s32(8192), vget_high_s16(c), (int16_t) k);
+
+    return vcombine_s16(vmovn_s32(vshrq_n_s32(lo, 14)),
+                        vmovn_s32(vshrq_n_s32(hi, 14)));
+}
+
+/* Eight pixels of Y plus the terms */
+static SDL_INLINE void
+YUVStoreNEON(const SDL_SW_YUVTexture * swdata, Uint32 * out,
+             int16x8_t r, int16x8_t g, int16x8_t b)
+{
+    uint8x8x4_t px;
+
+    if (swdata->matrix.y_scale) {
+        const int16x8_t y16 = vdupq_n_s16(16);
+
+        r = YUVTermNEON(vsubq_s16(r, y16), swdata->matrix.y_scale);
+        g = YUVTermNEON(vsubq_s16(g, y16), swdata->matrix.y_scale);
+        b = YUVTermNEON(vsubq_s16(b, y16), swdata->matrix.y_scale);
+    }
+    px.val[0] = vqmovun_s16(swdata->simd_rgb ? r : b);
+    px.val[1] = vqmovun_s16(g);
+    px.val[2] = vqmovun_s16(swdata->simd_rgb ? b : r);
+    px.val[3] = vdup_n_u8(swdata->simd_alpha);
+    vst4_u8((uint8_t *) out, px);
+}
+
+/* The terms of eight chroma samples, for their sixteen pixels */
+static SDL_INLINE void
+YUVStore16NEON(const SDL_SW_YUVTexture * swdata, Uint32 * out,
+               uint8x8_t ylo, uint8x8_t yhi, uint8x8_t vcr, uint8x8_t vcb)
+{
+    const SDL_SW_YUVMatrix *m = &swdata->matrix;
+    const int16x8_t c128 = vdupq_n_s16(128);
+    int16x8_t cr = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vcr)), c128);
+    int16x8_t cb = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vcb)), c128);
+    int16x8x2_t tr = vzipq_s16(YUVTermNEON(cr, m->cr_r), YUVTermNEON(cr, m->cr_r));
+    int16x8_t g = vaddq_s16(YUVTermNEON(cr, m->cr_g), YUVTermNEON(cb, m->cb_g));
+    int16x8x2_t tg = vzipq_s16(g, g);
+    int16x8x2_t tb = vzipq_s16(YUVTermNEON(cb, m->cb_b), YUVTermNEON(cb, m->cb_b));
+    int16x8_t y;
+
+    y = vreinterpretq_s16_u16(vmovl_u8(ylo));
+    YUVStoreNEON(swdata, out, vaddq_s16(y, tr.val[0]),
+                 vaddq_s16(y, tg.val[0]), vaddq_s16(y, tb.val[0]));
+    y = vreinterpretq_s16_u16(vmovl_u8(yhi));
+    YUVStoreNEON(swdata, out + 8, vaddq_s16(y, tr.val[1]),
+                 vaddq_s16(y, tg.val[1]), vaddq_s16(y, tb.val[1]));
+}
+
+static int
+YUVRowPairNEON(const SDL_SW_YUVTexture * swdata,
+               const Uint8 * lum1, const Uint8 * lum2,
+               const Uint8 * cr, const Uint8 * cb, int cstep,
+               Uint32 * out1, Uint32 * out2, int n)
+{
+    const Uint8 *uv = SDL_min(cr, cb);
+    int x;
+
+    for (x = 0; x + 16 <= n; x += 16) {
+        uint8x8_t vcr, vcb;
+        uint8x16_t y;
+
+        if (cstep == 1) {
+            vcr = vld1_u8(cr + x / 2);
+            vcb = vld1_u8(cb + x / 2);
+        } else {
+            uint8x8x2_t w = vld2_u8(uv + x);
+
+            vcr = (cr > cb) ? w.val[1] : w.val[0];
+            vcb = (cr > cb) ? w.val[0] : w.val[1];
+        }
+        y = vld1q_u8(lum1 + x);
+        YUVStore16NEON(swdata, out1 + x, vget_low_u8(y), vget_high_u8(y), vcr, vcb);
+        y = vld1q_u8(lum2 + x);
+        YUVStore16NEON(swdata, out2 + x, vget_low_u8(y), vget_high_u8(y), vcr, vcb);
+    }
+    return x;
+}
+
+static int
+YUVRowPackedNEON(const SDL_SW_YUVTexture * swdata, const Uint8 * src,
+                 int lum_ofs, int cr_ofs, int cb_ofs, Uint32 * out, int n)
+{
+    int x;
+
+    for (x = 0; x + 16 <= n; x += 16) {
+        /* Eight groups of two pixels, a byte of each group in each val */
+        uint8x8x4_t w = vld4_u8(src + 2 * x);
+        uint8x8x2_t y = vzip_u8(w.val[lum_ofs], w.val[lum_ofs + 2]);
+
+        YUVStore16NEON(swdata, out + x, y.val[0], y.val[1],
+                       w.val[cr_ofs], w.val[cb_ofs]);
+    }
+    return x;
+}
+#endif /* SDL_YUV_NEON */
+
+int
+SDL_SW_YUVRowPairSIMD(const SDL_SW_YUVTexture * swdata,
+                      const Uint8 * lum1, const Uint8 * lum2,
+                      const Uint8 * cr, const Uint8 * cb, int cstep,
+                      Uint32 * out1, Uint32 * out2, int n)
+{
+#if SDL_YUV_X86
+    if (swdata->simd & SDL_CPU_AVX2) {
+        return YUVRowPairAVX2(swdata, lum1, lum2, cr, cb, cstep, out1, out2, n);
+    }
+    if (swdata->simd & SDL_CPU_SSE2) {
+        return YUVRowPairSSE2(swdata, lum1, lum2, cr, cb, cstep, out1, out2, n);
+    }
+#elif SDL_YUV_NEON
+    if (swdata->simd & SDL_CPU_NEON) {
+        return YUVRowPairNEON(swdata, lum1, lum2, cr, cb, cstep, out1, out2, n);
+    }
+#endif
+    return 0;
+}
+
+int
+SDL_SW_YUVRowPackedSIMD(const SDL_SW_YUVTexture * swdata,
+                        const Uint8 * src, int lum_ofs, int cr_ofs,
+                        int cb_ofs, Uint32 * out, int n)
+{
+#if SDL_YUV_X86
+    if (swdata->simd & SDL_CPU_AVX2) {
+        return YUVRowPackedAVX2(swdata, src, lum_ofs, cr_ofs, cb_ofs, out, n);
+    }
+    if (swdata->simd & SDL_CPU_SSE2) {
+        return YUVRowPackedSSE2(swdata, src, lum_ofs, cr_ofs, cb_ofs, out, n);
+    }
+#elif SDL_YUV_NEON
+    if (swdata->simd & SDL_CPU_NEON) {
+        return YUVRowPackedNEON(swdata, src, lum_ofs, cr_ofs, cb_ofs, out, n);
+    }
+#endif
+    return 0;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -83,9 +83,11 @@
  */
 
 #include "SDL_assert.h"
+#include "SDL_hints.h"
 #include "SDL_video.h"
 #include "SDL_cpuinfo.h"
 #include "SDL_yuv_sw_c.h"
+#include "../video/SDL_blit.h"
 
 
 /* The colorspace conversion functions */
@@ -856,6 +858,27 @@ Color32DitherYUY2Mod2X(int *colortab, Uint32 * rgb_2_pix,
     }
 }
 
+/*
+ * The YUV to RGB matrices, fixed point of 1 << 14.  For limited range the
+ * chroma terms are divided by the Y scale, so Y plus them is scaled as one.
+ */
+static const SDL_SW_YUVMatrix SDL_SW_YUVMatrixJPEG =
+    { 22970, -11700, -5638, 29032, 0 };
+static const SDL_SW_YUVMatrix SDL_SW_YUVMatrixBT601 =
+    { 22458, -11439, -5512, 28384, 19077 };
+static const SDL_SW_YUVMatrix SDL_SW_YUVMatrixBT709 =
+    { 25226, -7499, -3001, 29724, 19077 };
+
+/*
+ * (x + 8192) >> 14 with the shift rounding down, as the SIMD converters do,
+ * for x of either sign.
+ */
+static int
+SDL_SW_YUVFixed(int x)
+{
+    return ((x + 8192 + (1 << 28)) >> 14) - (1 << 14);
+}
+
 /*
  * How many 1 bits are there in the Uint32.
  * Low performance, do not call often.
@@ -906,18 +929,26 @@ SDL_SW_SetupYUVDisplay(SDL_SW_YUVTexture * swdata, Uint32 target_format)
     b_2_pix_alloc = &swdata->rgb_2_pix[2 * 768];
 
     /*
-     * Set up entries 0-255 in rgb-to-pixel value tables.
+     * Set up the rgb-to-pixel value tables, for Y plus the chroma terms
+     * of -256 to 511.  Full range values are clamped to 0-255, limited
+     * range ones are scaled first.
      */
-    for (i = 0; i < 256; ++i) {
-        r_2_pix_alloc[i + 256] = i >> (8 - number_of_bits_set(Rmask));
-        r_2_pix_alloc[i + 256] <<= free_bits_at_bottom(Rmask);
-        r_2_pix_alloc[i + 256] |= Amask;
-        g_2_pix_alloc[i + 256] = i >> (8 - number_of_bits_set(Gmask));
-        g_2_pix_alloc[i + 256] <<= free_bits_at_bottom(Gmask);
-        g_2_pix_alloc[i + 256] |= Amask;
-        b_2_pix_alloc[i + 256] = i >> (8 - number_of_bits_set(Bmask));
-        b_2_pix_alloc[i + 256] <<= free_bits_at_bottom(Bmask);
-        b_2_pix_alloc[i + 256] |= Amask;
+    for (i = 0; i < 768; ++i) {
+        int value = i - 256;
+
+        if (swdata->matrix.y_scale) {
+            value = SDL_SW_YUVFixed((value - 16) * swdata->matrix.y_scale);
+        }
+        value = SDL_max(0, SDL_min(value, 255));
+        r_2_pix_alloc[i] = value >> (8 - number_of_bits_set(Rmask));
+        r_2_pix_alloc[i] <<= free_bits_at_bottom(Rmask);
+        r_2_pix_alloc[i] |= Amask;
+        g_2_pix_alloc[i] = value >> (8 - number_of_bits_set(Gmask));
+        g_2_pix_alloc[i] <<= free_bits_at_bottom(Gmask);
+        g_2_pix_alloc[i] |= Amask;
+        b_2_pix_alloc[i] = value >> (8 - number_of_bits_set(Bmask));
+        b_2_pix_alloc[i] <<= free_bits_at_bottom(Bmask);
+        b_2_pix_alloc[i] |= Amask;
     }
 
     /*
@@ -928,30 +959,34 @@ SDL_SW_SetupYUVDisplay(SDL_SW_YUVTexture * swdata, Uint32 target_format)
      * through a short pointer will lose the top bits anyway.
      */
     if (SDL_BYTESPERPIXEL(target_format) == 2) {
-        for (i = 0; i < 256; ++i) {
-            r_2_pix_alloc[i + 256] |= (r_2_pix_alloc[i + 256]) << 16;
-            g_2_pix_alloc[i + 256] |= (g_2_pix_alloc[i + 256]) << 16;
-            b_2_pix_alloc[i + 256] |= (b_2_pix_alloc[i + 256]) << 16;
+        for (i = 0; i < 768; ++i) {
+            r_2_pix_alloc[i] |= (r_2_pix_alloc[i]) << 16;
+            g_2_pix_alloc[i] |= (g_2_pix_alloc[i]) << 16;
+            b_2_pix_alloc[i] |= (b_2_pix_alloc[i]) << 16;
         }
     }
 
-    /*
-     * Spread out the values we have to the rest of the array so that
-     * we do not need to check for overflow.
-     */
-    for (i = 0; i < 256; ++i) {
-        r_2_pix_alloc[i] = r_2_pix_alloc[256];
-        r_2_pix_alloc[i + 512] = r_2_pix_alloc[511];
-        g_2_pix_alloc[i] = g_2_pix_alloc[256];
-        g_2_pix_alloc[i + 512] = g_2_pix_alloc[511];
-        b_2_pix_alloc[i] = b_2_pix_alloc[256];
-        b_2_pix_alloc[i + 512] = b_2_pix_alloc[511];
+    /* The SIMD converters do 8 bit components in either order, little
+       endian */
+    swdata->simd = 0;
+    if (SDL_BYTEORDER == SDL_LIL_ENDIAN &&
+        SDL_BYTESPERPIXEL(target_format) == 4 && Gmask == 0x0000FF00 &&
+        (Amask == 0 || Amask == 0xFF000000) &&
+        ((Rmask == 0x00FF0000 && Bmask == 0x000000FF) ||
+         (Rmask == 0x000000FF && Bmask == 0x00FF0000))) {
+        swdata->simd = SDL_GetBlitCPUFeatures() &
+            (SDL_CPU_SSE2 | SDL_CPU_AVX2 | SDL_CPU_NEON);
+        swdata->simd_rgb = (Rmask == 0x000000FF);
+        swdata->simd_alpha = Amask ? 0xFF : 0;
     }
 
     /* You have chosen wisely... */
     switch (swdata->format) {
     case SDL_PIXELFORMAT_YV12:
     case SDL_PIXELFORMAT_IYUV:
+    case SDL_PIXELFORMAT_NV12:
+    case SDL_PIXELFORMAT_NV21:
+        /* NV12 and NV21 have their chroma split out for these */
         if (SDL_BYTESPERPIXEL(target_format) == 2) {
 #if (__GNUC__ > 2) && defined(__i386__) && __OPTIMIZE__ && SDL_ASSEMBLY_ROUTINES
             /* inline assembly functions */
@@ -976,7 +1011,7 @@ SDL_SW_SetupYUVDisplay(SDL_SW_YUVTexture * swdata, Uint32 target_format)
         if (SDL_BYTESPERPIXEL(target_format) == 4) {
 #if (__GNUC__ > 2) && defined(__i386__) && __OPTIMIZE__ && SDL_ASSEMBLY_ROUTINES
             /* inline assembly functions */
-            if (SDL_HasMMX() && (Rmask == 0x00FF0000) &&
+            if (!swdata->simd && SDL_HasMMX() && (Rmask == 0x00FF0000) &&
                 (Gmask == 0x0000FF00) &&
                 (Bmask == 0x000000FF) && (swdata->w & 15) == 0) {
 /* printf("Using MMX 32-bit dither\n"); */
@@ -1027,6 +1062,8 @@ SDL_SW_CreateYUVTexture(Uint32 format, int w, int h)
     int *Cb_b_tab;
     int i;
     int CR, CB;
+    size_t size = (size_t) w * h * 2;
+    const char *mode;
 
     switch (format) {
     case SDL_PIXELFORMAT_YV12:
@@ -1035,6 +1072,12 @@ SDL_SW_CreateYUVTexture(Uint32 format, int w, int h)
     case SDL_PIXELFORMAT_UYVY:
     case SDL_PIXELFORMAT_YVYU:
         break;
+    case SDL_PIXELFORMAT_NV12:
+    case SDL_PIXELFORMAT_NV21:
+        /* Y, the chroma rows of w bytes, then room to split them out */
+        size = (size_t) w * h + (size_t) w * ((h + 1) / 2) +
+               (size_t) (w / 2) * (h / 2) * 2;
+        break;
     default:
         SDL_SetError("Unsupported YUV format");
         return NULL;
@@ -1050,7 +1093,7 @@ SDL_SW_CreateYUVTexture(Uint32 format, int w, int h)
     swdata->target_format = SDL_PIXELFORMAT_UNKNOWN;
     swdata->w = w;
     swdata->h = h;
-    swdata->pixels = (Uint8 *) SDL_malloc(w * h * 2);
+    swdata->pixels = (Uint8 *) SDL_malloc(size);
     swdata->colortab = (int *) SDL_malloc(4 * 256 * sizeof(int));
     swdata->rgb_2_pix = (Uint32 *) SDL_malloc(3 * 768 * sizeof(Uint32));
     if (!swdata->pixels || !swdata->colortab || !swdata->rgb_2_pix) {
@@ -1059,6 +1102,19 @@ SDL_SW_CreateYUVTexture(Uint32 format, int w, int h)
         return NULL;
     }
 
+    /* Choose the matrix */
+    mode = SDL_GetHint(SDL_HINT_YUV_CONVERSION_MODE);
+    if (mode && SDL_strcasecmp(mode, "AUTOMATIC") == 0) {
+        mode = (h <= 576) ? "BT601" : "BT709";
+    }
+    if (mode && SDL_strcasecmp(mode, "BT601") == 0) {
+        swdata->matrix = SDL_SW_YUVMatrixBT601;
+    } else if (mode && SDL_strcasecmp(mode, "BT709") == 0) {
+        swdata->matrix = SDL_SW_YUVMatrixBT709;
+    } else {
+        swdata->matrix = SDL_SW_YUVMatrixJPEG;
+    }
+
     /* Generate the tables for the display surface */
     Cr_r_tab = &swdata->colortab[0 * 256];
     Cr_g_tab = &swdata->colortab[1 * 256];
@@ -1069,10 +1125,10 @@ SDL_SW_CreateYUVTexture(Uint32 format, int w, int h)
            would be done here.  See the Berkeley mpeg_play sources.
          */
         CB = CR = (i - 128);
-        Cr_r_tab[i] = (int) ((0.419 / 0.299) * CR);
-        Cr_g_tab[i] = (int) (-(0.299 / 0.419) * CR);
-        Cb_g_tab[i] = (int) (-(0.114 / 0.331) * CB);
-        Cb_b_tab[i] = (int) ((0.587 / 0.331) * CB);
+        Cr_r_tab[i] = SDL_SW_YUVFixed(swdata->matrix.cr_r * CR);
+        Cr_g_tab[i] = SDL_SW_YUVFixed(swdata->matrix.cr_g * CR);
+        Cb_g_tab[i] = SDL_SW_YUVFixed(swdata->matrix.cb_g * CB);
+        Cb_b_tab[i] = SDL_SW_YUVFixed(swdata->matrix.cb_b * CB);
     }
 
     /* Find the pitch and offset values for the overlay */
@@ -1086,6 +1142,13 @@ SDL_SW_CreateYUVTexture(Uint32 format, int w, int h)
         swdata->planes[1] = swdata->planes[0] + swdata->pitches[0] * h;
         swdata->planes[2] = swdata->planes[1] + swdata->pitches[1] * h / 2;
         break;
+    case SDL_PIXELFORMAT_NV12:
+    case SDL_PIXELFORMAT_NV21:
+        swdata->pitches[0] = w;
+        swdata->pitches[1] = w;
+        swdata->planes[0] = swdata->pixels;
+        swdata->planes[1] = swdata->planes[0] + swdata->pitches[0] * h;
+        break;
     case SDL_PIXELFORMAT_YUY2:
     case SDL_PIXELFORMAT_UYVY:
     case SDL_PIXELFORMAT_YVYU:
@@ -1160,6 +1223,35 @@ SDL_SW_UpdateYUVTexture(SDL_SW_YUVTexture * swdata, const SDL_Rect * rect,
             }
         }
         break;
+    case SDL_PIXELFORMAT_NV12:
+    case SDL_PIXELFORMAT_NV21:
+        {
+            Uint8 *src, *dst;
+            int row;
+            size_t length;
+
+            /* Copy the Y plane */
+            src = (Uint8 *) pixels;
+            dst = swdata->planes[0] + rect->y * swdata->pitches[0] + rect->x;
+            length = rect->w;
+            for (row = 0; row < rect->h; ++row) {
+                SDL_memcpy(dst, src, length);
+                src += pitch;
+                dst += swdata->pitches[0];
+            }
+
+            /* Copy the chroma pairs, a row for each two of Y */
+            src = (Uint8 *) pixels + rect->h * pitch;
+            dst = swdata->planes[1] + rect->y / 2 * swdata->pitches[1] +
+                  (rect->x & ~1);
+            length = SDL_min((rect->w + 1) & ~1, swdata->pitches[1] - (rect->x & ~1));
+            for (row = 0; row < (rect->h + 1) / 2; ++row) {
+                SDL_memcpy(dst, src, length);
+                src += pitch;
+                dst += swdata->pitches[1];
+            }
+        }
+        break;
     case SDL_PIXELFORMAT_YUY2:
     case SDL_PIXELFORMAT_UYVY:
     case SDL_PIXELFORMAT_YVYU:
@@ -1246,11 +1338,13 @@ SDL_SW_LockYUVTexture(SDL_SW_YUVTexture * swdata, const SDL_Rect * rect,
     switch (swdata->format) {
     case SDL_PIXELFORMAT_YV12:
     case SDL_PIXELFORMAT_IYUV:
+    case SDL_PIXELFORMAT_NV12:
+    case SDL_PIXELFORMAT_NV21:
         if (rect
             && (rect->x != 0 || rect->y != 0 || rect->w != swdata->w
                 || rect->h != swdata->h)) {
             return SDL_SetError
-                ("YV12 and IYUV textures only support full surface locks");
+                ("YV12, IYUV, NV12 and NV21 textures only support full surface locks");
         }
         break;
     }
@@ -1269,6 +1363,161 @@ SDL_SW_UnlockYUVTexture(SDL_SW_YUVTexture * swdata)
 {
 }
 
+/* Whether the format has a plane of Y & chroma rows for each two of it */
+static SDL_bool
+SDL_SW_IsPlanarYUV(Uint32 format)
+{
+    return (format == SDL_PIXELFORMAT_YV12 || format == SDL_PIXELFORMAT_IYUV ||
+            format == SDL_PIXELFORMAT_NV12 || format == SDL_PIXELFORMAT_NV21);
+}
+
+/* Splits chroma rows y to y + h - 1 of NV12 or NV21 out into planes for
+   the YV12 functions, after the chroma pairs; returns the planes */
+static void
+SDL_SW_SplitYUVChroma(SDL_SW_YUVTexture * swdata, int y, int h,
+                      Uint8 ** cr, Uint8 ** cb)
+{
+    const int w2 = swdata->w / 2;
+    const int cr_ofs = (swdata->format == SDL_PIXELFORMAT_NV21) ? 0 : 1;
+    const Uint8 *src = swdata->planes[1] + y * swdata->pitches[1];
+    Uint8 *split = swdata->planes[1] + swdata->pitches[1] * ((swdata->h + 1) / 2);
+    Uint8 *dst_cr = split + y * w2;
+    Uint8 *dst_cb = split + (swdata->h / 2 + y) * w2;
+    int row, x;
+
+    *cr = dst_cr;
+    *cb = dst_cb;
+    for (row = 0; row < h; ++row) {
+        for (x = 0; x < w2; ++x) {
+            dst_cr[x] = src[2 * x + cr_ofs];
+            dst_cb[x] = src[2 * x + 1 - cr_ofs];
+        }
+        src += swdata->pitches[1];
+        dst_cr += w2;
+        dst_cb += w2;
+    }
+}
+
+/* A 32-bit pixel from the tables */
+static SDL_INLINE Uint32
+SDL_SW_YUVPixel(const SDL_SW_YUVTexture * swdata, int L, int cr, int cb)
+{
+    const int *colortab = swdata->colortab;
+    const Uint32 *rgb_2_pix = swdata->rgb_2_pix;
+
+    return (rgb_2_pix[0 * 768 + 256 + L + colortab[cr + 0 * 256]] |
+            rgb_2_pix[1 * 768 + 256 + L + colortab[cr + 1 * 256] +
+                      colortab[cb + 2 * 256]] |
+            rgb_2_pix[2 * 768 + 256 + L + colortab[cb + 3 * 256]]);
+}
+
+/* Display1X's job for 32-bit targets, the SIMD converters doing the most
+   of each row: rows row pairs of planar formats or rows of packed ones */
+static void
+SDL_SW_DisplaySIMD(const SDL_SW_YUVTexture * swdata, const Uint8 * lum,
+                   const Uint8 * cr, const Uint8 * cb, Uint8 * out,
+                   int rows, int stride)
+{
+    const int w = swdata->w;
+    const int n = w & ~1;
+    int row, x;
+
+    if (SDL_SW_IsPlanarYUV(swdata->format)) {
+        const int cstep = (swdata->format == SDL_PIXELFORMAT_NV12 ||
+                           swdata->format == SDL_PIXELFORMAT_NV21) ? 2 : 1;
+        const int cpitch = (cstep == 2) ? swdata->pitches[1] : w / 2;
+
+        for (row = 0; row < rows; ++row) {
+            const Uint8 *lum1 = lum + 2 * row * w;
+            const Uint8 *lum2 = lum1 + w;
+            const Uint8 *rowcr = cr + row * cpitch;
+            const Uint8 *rowcb = cb + row * cpitch;
+            Uint32 *out1 = (Uint32 *) (out + 2 * row * stride);
+            Uint32 *out2 = (Uint32 *) (out + (2 * row + 1) * stride);
+
+            x = SDL_SW_YUVRowPairSIMD(swdata, lum1, lum2, rowcr, rowcb, cstep,
+                                      out1, out2, n);
+            for (; x < n; x += 2) {
+                const int c_r = rowcr[x / 2 * cstep];
+                const int c_b = rowcb[x / 2 * cstep];
+
+                out1[x] = SDL_SW_YUVPixel(swdata, lum1[x], c_r, c_b);
+                out1[x + 1] = SDL_SW_YUVPixel(swdata, lum1[x + 1], c_r, c_b);
+                out2[x] = SDL_SW_YUVPixel(swdata, lum2[x], c_r, c_b);
+                out2[x + 1] = SDL_SW_YUVPixel(swdata, lum2[x + 1], c_r, c_b);
+            }
+        }
+    } else {
+        const Uint8 *src = SDL_min(lum, SDL_min(cr, cb));
+        const int lum_ofs = (int) (lum - src);
+        const int cr_ofs = (int) (cr - src);
+        const int cb_ofs = (int) (cb - src);
+
+        for (row = 0; row < rows; ++row) {
+            const Uint8 *group = src + row * swdata->pitches[0];
+            Uint32 *dst = (Uint32 *) (out + row * stride);
+
+            x = SDL_SW_YUVRowPackedSIMD(swdata, group, lum_ofs, cr_ofs,
+                                        cb_ofs, dst, n);
+            for (group += 2 * x; x < n; x += 2, group += 4) {
+                dst[x] = SDL_SW_YUVPixel(swdata, group[lum_ofs],
+                                         group[cr_ofs], group[cb_ofs]);
+                dst[x + 1] = SDL_SW_YUVPixel(swdata, group[lum_ofs + 2],
+                                             group[cr_ofs], group[cb_ofs]);
+            }
+        }
+    }
+}
+
+/* A 1X conversion to be done in bands: of row pairs for planar formats,
+   rows for packed ones */
+typedef struct
+{
+    SDL_SW_YUVTexture *swdata;
+    Uint8 *lum, *cr, *cb;
+    Uint8 *out;
+    int stride;
+    int mod;
+} SDL_SW_YUVBands;
+
+static void
+SDL_SW_DisplayBand(void *data, int y, int h)
+{
+    const SDL_SW_YUVBands *bands = (const SDL_SW_YUVBands *) data;
+    SDL_SW_YUVTexture *swdata = bands->swdata;
+    Uint8 *lum, *cr, *cb, *out;
+    int rows;
+
+    if (SDL_SW_IsPlanarYUV(swdata->format)) {
+        const int cpitch = (swdata->format == SDL_PIXELFORMAT_NV12 ||
+                            swdata->format == SDL_PIXELFORMAT_NV21) ?
+            swdata->pitches[1] : swdata->w / 2;
+
+        lum = bands->lum + 2 * y * swdata->w;
+        cr = bands->cr + y * cpitch;
+        cb = bands->cb + y * cpitch;
+        out = bands->out + 2 * y * bands->stride;
+        rows = 2 * h;
+    } else {
+        lum = bands->lum + y * swdata->pitches[0];
+        cr = bands->cr + y * swdata->pitches[0];
+        cb = bands->cb + y * swdata->pitches[0];
+        out = bands->out + y * bands->stride;
+        rows = h;
+    }
+
+    if (swdata->simd) {
+        SDL_SW_DisplaySIMD(swdata, lum, cr, cb, out, h, bands->stride);
+        return;
+    }
+    if (swdata->format == SDL_PIXELFORMAT_NV12 ||
+        swdata->format == SDL_PIXELFORMAT_NV21) {
+        SDL_SW_SplitYUVChroma(swdata, y, h, &cr, &cb);
+    }
+    swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
+                      lum, cr, cb, out, rows, swdata->w, bands->mod);
+}
+
 int
 SDL_SW_CopyYUVToRGB(SDL_SW_YUVTexture * swdata, const SDL_Rect * srcrect,
                     Uint32 target_format, int w, int h, void *pixels,
@@ -1368,6 +1617,16 @@ SDL_SW_CopyYUVToRGB(SDL_SW_YUVTexture * swdata, const SDL_Rect * srcrect,
         Cr = lum + 1;
         Cb = lum + 3;
         break;
+    case SDL_PIXELFORMAT_NV12:
+        lum = swdata->planes[0];
+        Cr = swdata->planes[1] + 1;
+        Cb = swdata->planes[1];
+        break;
+    case SDL_PIXELFORMAT_NV21:
+        lum = swdata->planes[0];
+        Cr = swdata->planes[1];
+        Cb = swdata->planes[1] + 1;
+        break;
     default:
         return SDL_SetError("Unsupported YUV format in copy");
     }
@@ -1375,12 +1634,33 @@ SDL_SW_CopyYUVToRGB(SDL_SW_YUVTexture * swdata, const SDL_Rect * srcrect,
 
     if (scale_2x) {
         mod -= (swdata->w * 2);
+        if (swdata->format == SDL_PIXELFORMAT_NV12 ||
+            swdata->format == SDL_PIXELFORMAT_NV21) {
+            SDL_SW_SplitYUVChroma(swdata, 0, swdata->h / 2, &Cr, &Cb);
+        }
         swdata->Display2X(swdata->colortab, swdata->rgb_2_pix,
                           lum, Cr, Cb, pixels, swdata->h, swdata->w, mod);
     } else {
+        SDL_SW_YUVBands bands;
+        const SDL_bool planar = SDL_SW_IsPlanarYUV(swdata->format);
+        const int units = planar ? swdata->h / 2 : swdata->h;
+
         mod -= swdata->w;
-        swdata->Display1X(swdata->colortab, swdata->rgb_2_pix,
-                          lum, Cr, Cb, pixels, swdata->h, swdata->w, mod);
+        bands.swdata = swdata;
+        bands.lum = lum;
+        bands.cr = Cr;
+        bands.cb = Cb;
+        bands.out = (Uint8 *) pixels;
+        bands.stride = (pitch / targetbpp) * targetbpp;
+        bands.mod = mod;
+        /* The C functions' rows aren't where the bands think with odd
+           widths, so those are done in one go */
+        if (swdata->w & 1) {
+            SDL_SW_DisplayBand(&bands, 0, units);
+        } else {
+            SDL_RunBlitBands(planar ? 2 * swdata->w : swdata->w, units,
+                             SDL_SW_DisplayBand, &bands);
+        }
     }
     if (stretch) {
         SDL_Rect rect = *srcrect;
@@ -24,6 +24,16 @@
 
 /* This is the software implementation of the YUV texture support */
 
+/* The YUV to RGB matrix the tables are made from, in fixed point of 1 << 14:
+   each of R, G & B is Y plus the Cr and Cb terms, each rounded to an integer,
+   then for limited range Y, less 16 and scaled by y_scale, else 0.  The
+   SIMD converters work out the same pixels. */
+typedef struct
+{
+    int cr_r, cr_g, cb_g, cb_b;
+    int y_scale;
+} SDL_SW_YUVMatrix;
+
 struct SDL_SW_YUVTexture
 {
     Uint32 format;
@@ -41,6 +51,14 @@ struct SDL_SW_YUVTexture
                        unsigned char *cb, unsigned char *out,
                        int rows, int cols, int mod);
 
+    /* For 32-bit targets, SIMD converters do Display1X's job: the CPU
+       features they may use (0 for none), whether R is in the low byte
+       and the alpha they put in */
+    SDL_SW_YUVMatrix matrix;
+    Uint32 simd;
+    SDL_bool simd_rgb;
+    Uint8 simd_alpha;
+
     /* These are just so we don't have to allocate them separately */
     Uint16 pitches[3];
     Uint8 *planes[3];
@@ -69,4 +87,17 @@ int SDL_SW_CopyYUVToRGB(SDL_SW_YUVTexture * swdata, const SDL_Rect * srcrect,
                         int pitch);
 void SDL_SW_DestroyYUVTexture(SDL_SW_YUVTexture * swdata);
 
+/* Functions found in SDL_yuv_simd.c, converting to 32-bit pixels as the
+   tables do and returning how many of the n pixels they did (from the
+   first, an even number): n pixels of two rows sharing a row of chroma,
+   whose samples are cstep bytes apart, or n pixels of a packed 4:2:2 row
+   starting at src */
+int SDL_SW_YUVRowPairSIMD(const SDL_SW_YUVTexture * swdata,
+                          const Uint8 * lum1, const Uint8 * lum2,
+                          const Uint8 * cr, const Uint8 * cb, int cstep,
+                          Uint32 * out1, Uint32 * out2, int n);
+int SDL_SW_YUVRowPackedSIMD(const SDL_SW_YUVTexture * swdata,
+                            const Uint8 * src, int lum_ofs, int cr_ofs,
+                            int cb_ofs, Uint32 * out, int n);
+
 /* vi: set ts=4 sw=4 expandtab: */
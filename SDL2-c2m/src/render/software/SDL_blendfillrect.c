@@ -77,21 +77,10 @@ SDL_BlendFillRect_RGB888(SDL_Surface * dst, const SDL_Rect * rect,
                          SDL_BlendMode blendMode, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
 {
     unsigned inva = 0xff - a;
+    Uint32 color = SDL_BlendColor_8888(blendMode, r, g, b, a);
 
-    switch (blendMode) {
-    case SDL_BLENDMODE_BLEND:
-        FILLRECT(Uint32, DRAW_SETPIXEL_BLEND_RGB888);
-        break;
-    case SDL_BLENDMODE_ADD:
-        FILLRECT(Uint32, DRAW_SETPIXEL_ADD_RGB888);
-        break;
-    case SDL_BLENDMODE_MOD:
-        FILLRECT(Uint32, DRAW_SETPIXEL_MOD_RGB888);
-        break;
-    default:
-        FILLRECT(Uint32, DRAW_SETPIXEL_RGB888);
-        break;
-    }
+    FILLRECT_SPANS(Uint32, SDL_BlendSpan_8888(pixel, width, blendMode, color,
+                                              inva, 0x00FFFFFF));
     return 0;
 }
 
@@ -100,21 +89,10 @@ SDL_BlendFillRect_ARGB8888(SDL_Surface * dst, const SDL_Rect * rect,
                            SDL_BlendMode blendMode, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
 {
     unsigned inva = 0xff - a;
+    Uint32 color = SDL_BlendColor_8888(blendMode, r, g, b, a);
 
-    switch (blendMode) {
-    case SDL_BLENDMODE_BLEND:
-        FILLRECT(Uint32, DRAW_SETPIXEL_BLEND_ARGB8888);
-        break;
-    case SDL_BLENDMODE_ADD:
-        FILLRECT(Uint32, DRAW_SETPIXEL_ADD_ARGB8888);
-        break;
-    case SDL_BLENDMODE_MOD:
-        FILLRECT(Uint32, DRAW_SETPIXEL_MOD_ARGB8888);
-        break;
-    default:
-        FILLRECT(Uint32, DRAW_SETPIXEL_ARGB8888);
-        break;
-    }
+    FILLRECT_SPANS(Uint32, SDL_BlendSpan_8888(pixel, width, blendMode, color,
+                                              inva, 0xFFFFFFFF));
     return 0;
 }
 
@@ -217,6 +195,7 @@ SDL_BlendFillRect(SDL_Surface * dst, const SDL_Rect * rect,
     } else {
         rect = &dst->clip_rect;
     }
+    SDL_AddSurfaceDamage(dst, rect);
 
     if (blendMode == SDL_BLENDMODE_BLEND || blendMode == SDL_BLENDMODE_ADD) {
         r = DRAW_MUL(r, a);
@@ -326,6 +305,7 @@ SDL_BlendFillRects(SDL_Surface * dst, const SDL_Rect * rects, int count,
         if (!SDL_IntersectRect(&rects[i], &dst->clip_rect, &rect)) {
             continue;
         }
+        SDL_AddSurfaceDamage(dst, &rect);
         status = func(dst, &rect, blendMode, r, g, b, a);
     }
     return status;
@@ -506,20 +506,10 @@ SDL_BlendLine_RGB888(SDL_Surface * dst, int x1, int y1, int x2, int y2,
     inva = (a ^ 0xff);
 
     if (y1 == y2) {
-        switch (blendMode) {
-        case SDL_BLENDMODE_BLEND:
-            HLINE(Uint32, DRAW_SETPIXEL_BLEND_RGB888, draw_end);
-            break;
-        case SDL_BLENDMODE_ADD:
-            HLINE(Uint32, DRAW_SETPIXEL_ADD_RGB888, draw_end);
-            break;
-        case SDL_BLENDMODE_MOD:
-            HLINE(Uint32, DRAW_SETPIXEL_MOD_RGB888, draw_end);
-            break;
-        default:
-            HLINE(Uint32, DRAW_SETPIXEL_RGB888, draw_end);
-            break;
-        }
+        HSPAN(Uint32, SDL_BlendSpan_8888(pixel, length, blendMode,
+                                         SDL_BlendColor_8888(blendMode,
+                                                             r, g, b, a),
+                                         inva, 0x00FFFFFF), draw_end);
     } else if (x1 == x2) {
         switch (blendMode) {
         case SDL_BLENDMODE_BLEND:
@@ -597,20 +587,10 @@ SDL_BlendLine_ARGB8888(SDL_Surface * dst, int x1, int y1, int x2, int y2,
     inva = (a ^ 0xff);
 
     if (y1 == y2) {
-        switch (blendMode) {
-        case SDL_BLENDMODE_BLEND:
-            HLINE(Uint32, DRAW_SETPIXEL_BLEND_ARGB8888, draw_end);
-            break;
-        case SDL_BLENDMODE_ADD:
-            HLINE(Uint32, DRAW_SETPIXEL_ADD_ARGB8888, draw_end);
-            break;
-        case SDL_BLENDMODE_MOD:
-            HLINE(Uint32, DRAW_SETPIXEL_MOD_ARGB8888, draw_end);
-            break;
-        default:
-            HLINE(Uint32, DRAW_SETPIXEL_ARGB8888, draw_end);
-            break;
-        }
+        HSPAN(Uint32, SDL_BlendSpan_8888(pixel, length, blendMode,
+                                         SDL_BlendColor_8888(blendMode,
+                                                             r, g, b, a),
+                                         inva, 0xFFFFFFFF), draw_end);
     } else if (x1 == x2) {
         switch (blendMode) {
         case SDL_BLENDMODE_BLEND:
@@ -724,6 +704,14 @@ SDL_BlendLine(SDL_Surface * dst, int x1, int y1, int x2, int y2,
     if (!SDL_IntersectRectAndLine(&dst->clip_rect, &x1, &y1, &x2, &y2)) {
         return 0;
     }
+    {
+        SDL_Point ends[2];
+        ends[0].x = x1;
+        ends[0].y = y1;
+        ends[1].x = x2;
+        ends[1].y = y2;
+        SDL_AddSurfaceDamagePoints(dst, ends, 2);
+    }
 
     func(dst, x1, y1, x2, y2, blendMode, r, g, b, a, SDL_TRUE);
     return 0;
@@ -748,6 +736,7 @@ SDL_BlendLines(SDL_Surface * dst, const SDL_Point * points, int count,
         return SDL_SetError("SDL_BlendLines(): Unsupported surface format");
     }
 
+    SDL_AddSurfaceDamagePoints(dst, points, count);
     for (i = 1; i < count; ++i) {
         x1 = points[i-1].x;
         y1 = points[i-1].y;
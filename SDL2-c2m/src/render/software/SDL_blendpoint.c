@@ -211,6 +211,12 @@ SDL_BlendPoint(SDL_Surface * dst, int x, int y, SDL_BlendMode blendMode, Uint8 r
         y >= (dst->clip_rect.y + dst->clip_rect.h)) {
         return 0;
     }
+    {
+        SDL_Point point;
+        point.x = x;
+        point.y = y;
+        SDL_AddSurfaceDamagePoints(dst, &point, 1);
+    }
 
     if (blendMode == SDL_BLENDMODE_BLEND || blendMode == SDL_BLENDMODE_ADD) {
         r = DRAW_MUL(r, a);
@@ -255,6 +261,19 @@ SDL_BlendPoint(SDL_Surface * dst, int x, int y, SDL_BlendMode blendMode, Uint8 r
     }
 }
 
+/* Blend the points in the clip rect with op, a DRAW_SETPIXELXY operator */
+#define BLENDPOINTS(op) \
+do { \
+    for (i = 0; i < count; ++i) { \
+        x = points[i].x; \
+        y = points[i].y; \
+        if (x < minx || x > maxx || y < miny || y > maxy) { \
+            continue; \
+        } \
+        op(x, y); \
+    } \
+} while (0)
+
 int
 SDL_BlendPoints(SDL_Surface * dst, const SDL_Point * points, int count,
                 SDL_BlendMode blendMode, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
@@ -282,7 +301,51 @@ SDL_BlendPoints(SDL_Surface * dst, const SDL_Point * points, int count,
         b = DRAW_MUL(b, a);
     }
 
-    /* FIXME: Does this function pointer slow things down significantly? */
+    minx = dst->clip_rect.x;
+    maxx = dst->clip_rect.x + dst->clip_rect.w - 1;
+    miny = dst->clip_rect.y;
+    maxy = dst->clip_rect.y + dst->clip_rect.h - 1;
+    SDL_AddSurfaceDamagePoints(dst, points, count);
+
+    /* ARGB8888 and RGB888 without a call per point */
+    if (dst->format->BitsPerPixel == 32 &&
+        dst->format->Rmask == 0x00FF0000) {
+        unsigned inva = a ^ 0xFF;
+
+        if (dst->format->Amask) {
+            switch (blendMode) {
+            case SDL_BLENDMODE_BLEND:
+                BLENDPOINTS(DRAW_SETPIXELXY_BLEND_ARGB8888);
+                break;
+            case SDL_BLENDMODE_ADD:
+                BLENDPOINTS(DRAW_SETPIXELXY_ADD_ARGB8888);
+                break;
+            case SDL_BLENDMODE_MOD:
+                BLENDPOINTS(DRAW_SETPIXELXY_MOD_ARGB8888);
+                break;
+            default:
+                BLENDPOINTS(DRAW_SETPIXELXY_ARGB8888);
+                break;
+            }
+        } else {
+            switch (blendMode) {
+            case SDL_BLENDMODE_BLEND:
+                BLENDPOINTS(DRAW_SETPIXELXY_BLEND_RGB888);
+                break;
+            case SDL_BLENDMODE_ADD:
+                BLENDPOINTS(DRAW_SETPIXELXY_ADD_RGB888);
+                break;
+            case SDL_BLENDMODE_MOD:
+                BLENDPOINTS(DRAW_SETPIXELXY_MOD_RGB888);
+                break;
+            default:
+                BLENDPOINTS(DRAW_SETPIXELXY_RGB888);
+                break;
+            }
+        }
+        return 0;
+    }
+
     switch (dst->format->BitsPerPixel) {
     case 15:
         switch (dst->format->Rmask) {
@@ -321,11 +384,6 @@ SDL_BlendPoints(SDL_Surface * dst, const SDL_Point * points, int count,
         }
     }
 
-    minx = dst->clip_rect.x;
-    maxx = dst->clip_rect.x + dst->clip_rect.w - 1;
-    miny = dst->clip_rect.y;
-    maxy = dst->clip_rect.y + dst->clip_rect.h - 1;
-
     for (i = 0; i < count; ++i) {
         x = points[i].x;
         y = points[i].y;
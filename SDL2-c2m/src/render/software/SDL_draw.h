@@ -22,6 +22,15 @@
 
 #include "../../video/SDL_blit.h"
 
+/* Span fills and blends, 4 pixels at a time */
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SDL_DRAW_SSE2 1
+#include <emmintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define SDL_DRAW_NEON 1
+#include <arm_neon.h>
+#endif
+
 /* This code assumes that r, g, b, a are the source color,
  * and in the blend and add case, the RGB values are premultiplied by a.
  */
@@ -286,12 +295,219 @@ do { \
 #define DRAW_SETPIXELXY4_MOD_RGBA(x, y) \
     DRAW_SETPIXELXY(x, y, Uint32, 4, DRAW_SETPIXEL_MOD_RGBA)
 
+/*
+ * Define span functions, for horizontal lines and rects
+ */
+
+/* Set length 32-bit pixels to color */
+SDL_FORCE_INLINE void
+SDL_FillSpan4(Uint32 * pixel, int length, Uint32 color)
+{
+    int i = 0;
+#if SDL_DRAW_SSE2
+    const __m128i c = _mm_set1_epi32((int) color);
+    for (; i + 4 <= length; i += 4) {
+        _mm_storeu_si128((__m128i *) (pixel + i), c);
+    }
+#elif SDL_DRAW_NEON
+    const uint32x4_t c = vdupq_n_u32(color);
+    for (; i + 4 <= length; i += 4) {
+        vst1q_u32(pixel + i, c);
+    }
+#endif
+    for (; i < length; ++i) {
+        pixel[i] = color;
+    }
+}
+
+/* Set length 16-bit pixels to color, two at a time once 4 byte aligned */
+SDL_FORCE_INLINE void
+SDL_FillSpan2(Uint16 * pixel, int length, Uint16 color)
+{
+    if (length > 0 && ((uintptr_t) pixel & 2)) {
+        *pixel++ = color;
+        --length;
+    }
+    SDL_FillSpan4((Uint32 *) pixel, length / 2,
+                  ((Uint32) color << 16) | color);
+    if (length & 1) {
+        pixel[length - 1] = color;
+    }
+}
+
+/* The color of SDL_BlendPixel_8888 for a blend mode: premultiplied for
+   blending, with alpha 0 to add (keeping the pixel's) and 255 to
+   modulate */
+SDL_FORCE_INLINE Uint32
+SDL_BlendColor_8888(SDL_BlendMode blendMode, unsigned r, unsigned g,
+                    unsigned b, unsigned a)
+{
+    Uint32 rgb = (r << 16) | (g << 8) | b;
+
+    switch (blendMode) {
+    case SDL_BLENDMODE_ADD:
+        return rgb;
+    case SDL_BLENDMODE_MOD:
+        return 0xFF000000 | rgb;
+    default:
+        return (a << 24) | rgb;
+    }
+}
+
+/* Blend color into a pixel with four 8-bit channels, each as the DRAW_SETPIXEL
+   operators do.  keep is 0x00FFFFFF for RGB888, whose top byte is 0. */
+SDL_FORCE_INLINE Uint32
+SDL_BlendPixel_8888(Uint32 pixel, SDL_BlendMode blendMode, Uint32 color,
+                    unsigned inva, Uint32 keep)
+{
+    Uint32 out = 0;
+    int shift;
+
+    for (shift = 0; shift < 32; shift += 8) {
+        unsigned d = (pixel >> shift) & 0xFF;
+        unsigned c = (color >> shift) & 0xFF;
+
+        switch (blendMode) {
+        case SDL_BLENDMODE_BLEND:
+            d = DRAW_MUL(inva, d) + c;
+            break;
+        case SDL_BLENDMODE_ADD:
+            d += c;
+            if (d > 0xFF) d = 0xFF;
+            break;
+        case SDL_BLENDMODE_MOD:
+            d = DRAW_MUL(d, c);
+            break;
+        default:
+            d = c;
+            break;
+        }
+        out |= (Uint32) d << shift;
+    }
+    return out & keep;
+}
+
+#if SDL_DRAW_SSE2
+/* x * y / 255 of 16-bit lanes, exactly as DRAW_MUL */
+SDL_FORCE_INLINE __m128i
+SDL_Mul255SSE2(__m128i x, __m128i y)
+{
+    const __m128i t = _mm_mullo_epi16(x, y);
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(t, _mm_set1_epi16(1)),
+                                        _mm_srli_epi16(t, 8)), 8);
+}
+#elif SDL_DRAW_NEON
+SDL_FORCE_INLINE uint8x8_t
+SDL_Mul255NEON(uint8x8_t x, uint8x8_t y)
+{
+    const uint16x8_t t = vmull_u8(x, y);
+    return vshrn_n_u16(vaddq_u16(vaddq_u16(t, vdupq_n_u16(1)),
+                                 vshrq_n_u16(t, 8)), 8);
+}
+#endif
+
+/* Blend color (from SDL_BlendColor_8888) into length pixels with four 8-bit
+   channels (ARGB8888, RGB888), giving the same pixels as
+   SDL_BlendPixel_8888 */
+SDL_FORCE_INLINE void
+SDL_BlendSpan_8888(Uint32 * pixel, int length, SDL_BlendMode blendMode,
+                   Uint32 color, unsigned inva, Uint32 keep)
+{
+    int i = 0;
+
+    if (blendMode != SDL_BLENDMODE_BLEND && blendMode != SDL_BLENDMODE_ADD &&
+        blendMode != SDL_BLENDMODE_MOD) {
+        SDL_FillSpan4(pixel, length, color & keep);
+        return;
+    }
+#if SDL_DRAW_SSE2
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i c8 = _mm_set1_epi32((int) color);
+        const __m128i c16 = _mm_unpacklo_epi8(c8, zero);
+        const __m128i inva16 = _mm_set1_epi16((short) inva);
+        const __m128i k = _mm_set1_epi32((int) keep);
+
+        for (; i + 4 <= length; i += 4) {
+            __m128i d = _mm_loadu_si128((const __m128i *) (pixel + i));
+            __m128i lo = _mm_unpacklo_epi8(d, zero);
+            __m128i hi = _mm_unpackhi_epi8(d, zero);
+
+            switch (blendMode) {
+            case SDL_BLENDMODE_BLEND:
+                lo = _mm_add_epi16(SDL_Mul255SSE2(lo, inva16), c16);
+                hi = _mm_add_epi16(SDL_Mul255SSE2(hi, inva16), c16);
+                d = _mm_packus_epi16(lo, hi);
+                break;
+            case SDL_BLENDMODE_ADD:
+                d = _mm_adds_epu8(d, c8);
+                break;
+            default:
+                d = _mm_packus_epi16(SDL_Mul255SSE2(lo, c16),
+                                     SDL_Mul255SSE2(hi, c16));
+                break;
+            }
+            _mm_storeu_si128((__m128i *) (pixel + i), _mm_and_si128(d, k));
+        }
+    }
+#elif SDL_DRAW_NEON
+    {
+        const uint8x16_t c8 = vreinterpretq_u8_u32(vdupq_n_u32(color));
+        const uint8x8_t inva8 = vdup_n_u8((Uint8) inva);
+        const uint8x16_t k = vreinterpretq_u8_u32(vdupq_n_u32(keep));
+
+        for (; i + 4 <= length; i += 4) {
+            uint8x16_t d = vreinterpretq_u8_u32(vld1q_u32(pixel + i));
+
+            switch (blendMode) {
+            case SDL_BLENDMODE_BLEND:
+                d = vaddq_u8(vcombine_u8(
+                        SDL_Mul255NEON(vget_low_u8(d), inva8),
+                        SDL_Mul255NEON(vget_high_u8(d), inva8)), c8);
+                break;
+            case SDL_BLENDMODE_ADD:
+                d = vqaddq_u8(d, c8);
+                break;
+            default:
+                d = vcombine_u8(
+                        SDL_Mul255NEON(vget_low_u8(d), vget_low_u8(c8)),
+                        SDL_Mul255NEON(vget_high_u8(d), vget_high_u8(c8)));
+                break;
+            }
+            vst1q_u32(pixel + i, vreinterpretq_u32_u8(vandq_u8(d, k)));
+        }
+    }
+#endif
+    for (; i < length; ++i) {
+        pixel[i] = SDL_BlendPixel_8888(pixel[i], blendMode, color, inva, keep);
+    }
+}
+
 /*
  * Define line drawing macro
  */
 
 #define ABS(_x) ((_x) < 0 ? -(_x) : (_x))
 
+/* Horizontal line as a span, from pixel for length pixels */
+#define HSPAN(type, span, draw_end) \
+{ \
+    int length; \
+    int pitch = (dst->pitch / dst->format->BytesPerPixel); \
+    type *pixel; \
+    if (x1 <= x2) { \
+        pixel = (type *)dst->pixels + y1 * pitch + x1; \
+        length = draw_end ? (x2-x1+1) : (x2-x1); \
+    } else { \
+        pixel = (type *)dst->pixels + y1 * pitch + x2; \
+        if (!draw_end) { \
+            ++pixel; \
+        } \
+        length = draw_end ? (x1-x2+1) : (x1-x2); \
+    } \
+    span; \
+}
+
 /* Horizontal line */
 #define HLINE(type, op, draw_end) \
 { \
@@ -573,4 +789,17 @@ do { \
     } \
 } while (0)
 
+/* Fill rect a row at a time, each a span from pixel for width pixels */
+#define FILLRECT_SPANS(type, span) \
+do { \
+    int width = rect->w; \
+    int height = rect->h; \
+    int pitch = (dst->pitch / dst->format->BytesPerPixel); \
+    type *pixel = (type *)dst->pixels + rect->y * pitch + rect->x; \
+    while (height--) { \
+        span; \
+        pixel += pitch; \
+    } \
+} while (0)
+
 /* vi: set ts=4 sw=4 expandtab: */
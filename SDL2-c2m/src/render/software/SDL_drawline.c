@@ -32,20 +32,7 @@ SDL_DrawLine1(SDL_Surface * dst, int x1, int y1, int x2, int y2, Uint32 color,
               SDL_bool draw_end)
 {
     if (y1 == y2) {
-        int length;
-        int pitch = (dst->pitch / dst->format->BytesPerPixel);
-        Uint8 *pixel;
-        if (x1 <= x2) {
-            pixel = (Uint8 *)dst->pixels + y1 * pitch + x1;
-            length = draw_end ? (x2-x1+1) : (x2-x1);
-        } else {
-            pixel = (Uint8 *)dst->pixels + y1 * pitch + x2;
-            if (!draw_end) {
-                ++pixel;
-            }
-            length = draw_end ? (x1-x2+1) : (x1-x2);
-        }
-        SDL_memset(pixel, color, length);
+        HSPAN(Uint8, SDL_memset(pixel, color, length), draw_end);
     } else if (x1 == x2) {
         VLINE(Uint8, DRAW_FASTSETPIXEL1, draw_end);
     } else if (ABS(x1 - x2) == ABS(y1 - y2)) {
@@ -60,7 +47,8 @@ SDL_DrawLine2(SDL_Surface * dst, int x1, int y1, int x2, int y2, Uint32 color,
               SDL_bool draw_end)
 {
     if (y1 == y2) {
-        HLINE(Uint16, DRAW_FASTSETPIXEL2, draw_end);
+        HSPAN(Uint16, SDL_FillSpan2(pixel, length, (Uint16) color),
+              draw_end);
     } else if (x1 == x2) {
         VLINE(Uint16, DRAW_FASTSETPIXEL2, draw_end);
     } else if (ABS(x1 - x2) == ABS(y1 - y2)) {
@@ -90,7 +78,7 @@ SDL_DrawLine4(SDL_Surface * dst, int x1, int y1, int x2, int y2, Uint32 color,
               SDL_bool draw_end)
 {
     if (y1 == y2) {
-        HLINE(Uint32, DRAW_FASTSETPIXEL4, draw_end);
+        HSPAN(Uint32, SDL_FillSpan4(pixel, length, color), draw_end);
     } else if (x1 == x2) {
         VLINE(Uint32, DRAW_FASTSETPIXEL4, draw_end);
     } else if (ABS(x1 - x2) == ABS(y1 - y2)) {
@@ -157,6 +145,14 @@ SDL_DrawLine(SDL_Surface * dst, int x1, int y1, int x2, int y2, Uint32 color)
     if (!SDL_IntersectRectAndLine(&dst->clip_rect, &x1, &y1, &x2, &y2)) {
         return 0;
     }
+    {
+        SDL_Point ends[2];
+        ends[0].x = x1;
+        ends[0].y = y1;
+        ends[1].x = x2;
+        ends[1].y = y2;
+        SDL_AddSurfaceDamagePoints(dst, ends, 2);
+    }
 
     func(dst, x1, y1, x2, y2, color, SDL_TRUE);
     return 0;
@@ -181,6 +177,7 @@ SDL_DrawLines(SDL_Surface * dst, const SDL_Point * points, int count,
         return SDL_SetError("SDL_DrawLines(): Unsupported surface format");
     }
 
+    SDL_AddSurfaceDamagePoints(dst, points, count);
     for (i = 1; i < count; ++i) {
         x1 = points[i-1].x;
         y1 = points[i-1].y;
@@ -44,6 +44,12 @@ SDL_DrawPoint(SDL_Surface * dst, int x, int y, Uint32 color)
         y >= (dst->clip_rect.y + dst->clip_rect.h)) {
         return 0;
     }
+    {
+        SDL_Point point;
+        point.x = x;
+        point.y = y;
+        SDL_AddSurfaceDamagePoints(dst, &point, 1);
+    }
 
     switch (dst->format->BytesPerPixel) {
     case 1:
@@ -61,12 +67,26 @@ SDL_DrawPoint(SDL_Surface * dst, int x, int y, Uint32 color)
     return 0;
 }
 
+/* Points in the clip rect, with one unsigned compare per axis */
+#define DRAWPOINTS(type) \
+do { \
+    Uint8 *pixels = (Uint8 *)dst->pixels; \
+    for (i = 0; i < count; ++i) { \
+        x = points[i].x; \
+        y = points[i].y; \
+        if ((unsigned)x - minx < w && (unsigned)y - miny < h) { \
+            *(type *)(pixels + y * dst->pitch + x * sizeof(type)) = \
+                (type) color; \
+        } \
+    } \
+} while (0)
+
 int
 SDL_DrawPoints(SDL_Surface * dst, const SDL_Point * points, int count,
                Uint32 color)
 {
-    int minx, miny;
-    int maxx, maxy;
+    unsigned minx, miny;
+    unsigned w, h;
     int i;
     int x, y;
 
@@ -79,32 +99,24 @@ SDL_DrawPoints(SDL_Surface * dst, const SDL_Point * points, int count,
         return SDL_SetError("SDL_DrawPoints(): Unsupported surface format");
     }
 
-    minx = dst->clip_rect.x;
-    maxx = dst->clip_rect.x + dst->clip_rect.w - 1;
-    miny = dst->clip_rect.y;
-    maxy = dst->clip_rect.y + dst->clip_rect.h - 1;
-
-    for (i = 0; i < count; ++i) {
-        x = points[i].x;
-        y = points[i].y;
-
-        if (x < minx || x > maxx || y < miny || y > maxy) {
-            continue;
-        }
-
-        switch (dst->format->BytesPerPixel) {
-        case 1:
-            DRAW_FASTSETPIXELXY1(x, y);
-            break;
-        case 2:
-            DRAW_FASTSETPIXELXY2(x, y);
-            break;
-        case 3:
-            return SDL_Unsupported();
-        case 4:
-            DRAW_FASTSETPIXELXY4(x, y);
-            break;
-        }
+    minx = (unsigned) dst->clip_rect.x;
+    miny = (unsigned) dst->clip_rect.y;
+    w = (unsigned) dst->clip_rect.w;
+    h = (unsigned) dst->clip_rect.h;
+    SDL_AddSurfaceDamagePoints(dst, points, count);
+
+    switch (dst->format->BytesPerPixel) {
+    case 1:
+        DRAWPOINTS(Uint8);
+        break;
+    case 2:
+        DRAWPOINTS(Uint16);
+        break;
+    case 3:
+        return SDL_Unsupported();
+    case 4:
+        DRAWPOINTS(Uint32);
+        break;
     }
     return 0;
 }
@@ -53,6 +53,8 @@ static int SW_UpdateTexture(SDL_Renderer * renderer, SDL_Texture * texture,
 static int SW_LockTexture(SDL_Renderer * renderer, SDL_Texture * texture,
                           const SDL_Rect * rect, void **pixels, int *pitch);
 static void SW_UnlockTexture(SDL_Renderer * renderer, SDL_Texture * texture);
+static int SW_SetTexturePixels(SDL_Renderer * renderer, SDL_Texture * texture,
+                               void *pixels, int pitch);
 static int SW_SetRenderTarget(SDL_Renderer * renderer, SDL_Texture * texture);
 static int SW_UpdateViewport(SDL_Renderer * renderer);
 static int SW_UpdateClipRect(SDL_Renderer * renderer);
@@ -73,6 +75,7 @@ static int SW_RenderReadPixels(SDL_Renderer * renderer, const SDL_Rect * rect,
 static void SW_RenderPresent(SDL_Renderer * renderer);
 static void SW_DestroyTexture(SDL_Renderer * renderer, SDL_Texture * texture);
 static void SW_DestroyRenderer(SDL_Renderer * renderer);
+static int SW_RunCommandQueue(SDL_Renderer * renderer);
 
 
 SDL_RenderDriver SW_RenderDriver = {
@@ -95,13 +98,179 @@ SDL_RenderDriver SW_RenderDriver = {
      0}
 };
 
+/* Batched drawing (SDL_HINT_RENDER_BATCHING) records each draw with the
+   color & blend mode it was called with, to be run at the next present or
+   flush.  The target & its clip rect, the viewport and the textures stay as
+   they were recorded with: the queue is run before any of them change. */
+
+#define SW_MAX_COMMANDS 4096    /* recorded before they're run regardless */
+#define SW_BATCH_LOOKBACK 16    /* how many batches back a command may join */
+
+typedef enum
+{
+    SW_CMD_POINTS,
+    SW_CMD_LINES,
+    SW_CMD_FILLRECTS,
+    SW_CMD_COPY,
+    SW_CMD_COPY_EX
+} SW_CommandType;
+
+typedef struct
+{
+    SW_CommandType type;
+    SDL_BlendMode blendMode;
+    Uint8 r, g, b, a;
+    int first, count;           /* its points or rects */
+    SDL_Texture *texture;       /* copied from, with ... */
+    SDL_Rect srcrect;
+    SDL_Rect dstrect;           /* ... in the target */
+    double angle;
+    SDL_FPoint center;
+    SDL_RendererFlip flip;
+    SDL_Rect bounds;            /* all it may draw on */
+    int next;                   /* the next command of its batch, or -1 */
+} SW_Command;
+
+typedef struct
+{
+    int first, last;            /* commands */
+    SDL_Rect bounds;
+    Uint64 tiles;               /* which of the target's 8x8 it draws on */
+} SW_Batch;
+
+/* Rotated copies are kept for drawing the same again (sprites at a handful
+   of angles), least recently used first to go.  They're thrown away when
+   their texture's pixels may change. */
+
+#define SW_ROTATE_CACHE_SIZE 32
+#define SW_ROTATE_CACHE_BYTES (16 * 1024 * 1024)
+
+typedef struct
+{
+    SDL_Surface *src;
+    SDL_Rect srcrect;
+    int w, h;                   /* scaled to */
+    double angle;
+    SDL_RendererFlip flip;
+    SDL_StretchFilter filter;
+    SDL_BlendMode blendMode;    /* which the rotated surface takes on */
+    Uint8 alphaMod, r, g, b;
+} SW_RotateKey;
+
+typedef struct
+{
+    SW_RotateKey key;
+    SDL_Surface *surface;
+    int w, h;
+    double cangle, sangle;
+    Uint32 last_used;
+} SW_RotatedSurface;
+
 typedef struct
 {
     SDL_Surface *surface;
     SDL_Surface *window;
+    SDL_bool batching;
+    SW_Command *commands;
+    int num_commands, max_commands;
+    SDL_Point *points;          /* the point & line commands' */
+    int num_points, max_points;
+    SDL_Rect *rects;            /* the fill commands' */
+    int num_rects, max_rects;
+    SW_Batch *batches;
+    int max_batches;
+    void *merged;               /* a batch's points or rects run together */
+    size_t merged_size;
+    SDL_bool rotate_cache;
+    SW_RotatedSurface rotated[SW_ROTATE_CACHE_SIZE];
+    int num_rotated;
+    size_t rotated_bytes;
+    Uint32 rotate_clock;
 } SW_RenderData;
 
 
+static void
+SW_DiscardCommandQueue(SW_RenderData * data)
+{
+    data->num_commands = 0;
+    data->num_points = 0;
+    data->num_rects = 0;
+}
+
+
+/* The rotated copies of src, or all of them for NULL */
+static void
+SW_EvictRotated(SW_RenderData * data, SDL_Surface * src)
+{
+    int i = 0;
+
+    while (i < data->num_rotated) {
+        SW_RotatedSurface *entry = &data->rotated[i];
+
+        if (src && entry->key.src != src) {
+            ++i;
+            continue;
+        }
+        data->rotated_bytes -= (size_t) entry->surface->pitch * entry->surface->h;
+        SDL_ReleaseSurface(entry->surface);
+        *entry = data->rotated[--data->num_rotated];
+    }
+}
+
+static SW_RotatedSurface *
+SW_FindRotated(SW_RenderData * data, const SW_RotateKey * key)
+{
+    int i;
+
+    for (i = 0; i < data->num_rotated; ++i) {
+        SW_RotatedSurface *entry = &data->rotated[i];
+
+        if (SDL_memcmp(&entry->key, key, sizeof(*key)) == 0) {
+            entry->last_used = ++data->rotate_clock;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* Keeps surface if there's room for it, pushing out the least recently used
+   ones; returns whether it was kept */
+static SDL_bool
+SW_CacheRotated(SW_RenderData * data, const SW_RotateKey * key,
+                SDL_Surface * surface, int w, int h, double cangle, double sangle)
+{
+    const size_t bytes = (size_t) surface->pitch * surface->h;
+    SW_RotatedSurface *entry;
+
+    if (!data->rotate_cache || bytes > SW_ROTATE_CACHE_BYTES / 4) {
+        return SDL_FALSE;
+    }
+    while (data->num_rotated == SW_ROTATE_CACHE_SIZE ||
+           data->rotated_bytes + bytes > SW_ROTATE_CACHE_BYTES) {
+        SW_RotatedSurface *oldest = &data->rotated[0];
+        int i;
+
+        for (i = 1; i < data->num_rotated; ++i) {
+            if ((Sint32) (data->rotated[i].last_used - oldest->last_used) < 0) {
+                oldest = &data->rotated[i];
+            }
+        }
+        data->rotated_bytes -= (size_t) oldest->surface->pitch * oldest->surface->h;
+        SDL_ReleaseSurface(oldest->surface);
+        *oldest = data->rotated[--data->num_rotated];
+    }
+    entry = &data->rotated[data->num_rotated++];
+    entry->key = *key;
+    entry->surface = surface;
+    entry->w = w;
+    entry->h = h;
+    entry->cangle = cangle;
+    entry->sangle = sangle;
+    entry->last_used = ++data->rotate_clock;
+    data->rotated_bytes += bytes;
+    return SDL_TRUE;
+}
+
 static SDL_Surface *
 SW_ActivateRenderer(SDL_Renderer * renderer)
 {
@@ -114,6 +283,7 @@ SW_ActivateRenderer(SDL_Renderer * renderer)
         SDL_Surface *surface = SDL_GetWindowSurface(renderer->window);
         if (surface) {
             data->surface = data->window = surface;
+            SDL_TrackWindowSurfaceDamage(renderer->window, SDL_TRUE);
 
             SW_UpdateViewport(renderer);
             SW_UpdateClipRect(renderer);
@@ -122,6 +292,17 @@ SW_ActivateRenderer(SDL_Renderer * renderer)
     return data->surface;
 }
 
+static SDL_bool
+SW_GetBatching(SDL_bool default_value)
+{
+    const char *hint = SDL_GetHint(SDL_HINT_RENDER_BATCHING);
+
+    if (!hint || !*hint) {
+        return default_value;
+    }
+    return (*hint == '0' || SDL_strcasecmp(hint, "false") == 0) ? SDL_FALSE : SDL_TRUE;
+}
+
 SDL_Renderer *
 SW_CreateRendererForSurface(SDL_Surface * surface)
 {
@@ -147,6 +328,13 @@ SW_CreateRendererForSurface(SDL_Surface * surface)
     }
     data->surface = surface;
     data->window = surface;
+    /* Applications may read their own surfaces whenever they like */
+    data->batching = SW_GetBatching(SDL_FALSE);
+    {
+        const char *hint = SDL_GetHint(SDL_HINT_RENDER_ROTATE_CACHE);
+
+        data->rotate_cache = (!hint || *hint != '0') ? SDL_TRUE : SDL_FALSE;
+    }
 
     renderer->WindowEvent = SW_WindowEvent;
     renderer->GetOutputSize = SW_GetOutputSize;
@@ -157,6 +345,7 @@ SW_CreateRendererForSurface(SDL_Surface * surface)
     renderer->UpdateTexture = SW_UpdateTexture;
     renderer->LockTexture = SW_LockTexture;
     renderer->UnlockTexture = SW_UnlockTexture;
+    renderer->SetTexturePixels = SW_SetTexturePixels;
     renderer->SetRenderTarget = SW_SetRenderTarget;
     renderer->UpdateViewport = SW_UpdateViewport;
     renderer->UpdateClipRect = SW_UpdateClipRect;
@@ -168,6 +357,7 @@ SW_CreateRendererForSurface(SDL_Surface * surface)
     renderer->RenderCopyEx = SW_RenderCopyEx;
     renderer->RenderReadPixels = SW_RenderReadPixels;
     renderer->RenderPresent = SW_RenderPresent;
+    renderer->RenderFlush = SW_RunCommandQueue;
     renderer->DestroyTexture = SW_DestroyTexture;
     renderer->DestroyRenderer = SW_DestroyRenderer;
     renderer->info = SW_RenderDriver.info;
@@ -182,12 +372,22 @@ SDL_Renderer *
 SW_CreateRenderer(SDL_Window * window, Uint32 flags)
 {
     SDL_Surface *surface;
+    SDL_Renderer *renderer;
 
     surface = SDL_GetWindowSurface(window);
     if (!surface) {
         return NULL;
     }
-    return SW_CreateRendererForSurface(surface);
+    renderer = SW_CreateRendererForSurface(surface);
+    if (renderer) {
+        SW_RenderData *data = (SW_RenderData *) renderer->driverdata;
+
+        /* The window's surface is only seen when it's presented */
+        data->batching = SW_GetBatching(SDL_TRUE);
+        /* ...and then only what's been drawn on needs updating */
+        SDL_TrackWindowSurfaceDamage(window, SDL_TRUE);
+    }
+    return renderer;
 }
 
 static void
@@ -196,6 +396,8 @@ SW_WindowEvent(SDL_Renderer * renderer, const SDL_WindowEvent *event)
     SW_RenderData *data = (SW_RenderData *) renderer->driverdata;
 
     if (event->event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+        /* Drawn on a surface which is going away */
+        SW_DiscardCommandQueue(data);
         data->surface = NULL;
         data->window = NULL;
     }
@@ -253,6 +455,8 @@ static int
 SW_SetTextureColorMod(SDL_Renderer * renderer, SDL_Texture * texture)
 {
     SDL_Surface *surface = (SDL_Surface *) texture->driverdata;
+
+    SW_RunCommandQueue(renderer);
     /* If the color mod is ever enabled (non-white), permanently disable RLE (which doesn't support
      * color mod) to avoid potentially frequent RLE encoding/decoding.
      */
@@ -267,6 +471,8 @@ static int
 SW_SetTextureAlphaMod(SDL_Renderer * renderer, SDL_Texture * texture)
 {
     SDL_Surface *surface = (SDL_Surface *) texture->driverdata;
+
+    SW_RunCommandQueue(renderer);
     /* If the texture ever has multiple alpha values (surface alpha plus alpha channel), permanently
      * disable RLE (which doesn't support this) to avoid potentially frequent RLE encoding/decoding.
      */
@@ -280,6 +486,8 @@ static int
 SW_SetTextureBlendMode(SDL_Renderer * renderer, SDL_Texture * texture)
 {
     SDL_Surface *surface = (SDL_Surface *) texture->driverdata;
+
+    SW_RunCommandQueue(renderer);
     /* If add or mod blending are ever enabled, permanently disable RLE (which doesn't support
      * them) to avoid potentially frequent RLE encoding/decoding.
      */
@@ -298,6 +506,8 @@ SW_UpdateTexture(SDL_Renderer * renderer, SDL_Texture * texture,
     int row;
     size_t length;
 
+    SW_RunCommandQueue(renderer);
+    SW_EvictRotated((SW_RenderData *) renderer->driverdata, surface);
     if(SDL_MUSTLOCK(surface))
         SDL_LockSurface(surface);
     src = (Uint8 *) pixels;
@@ -305,10 +515,13 @@ SW_UpdateTexture(SDL_Renderer * renderer, SDL_Texture * texture,
                         rect->y * surface->pitch +
                         rect->x * surface->format->BytesPerPixel;
     length = rect->w * surface->format->BytesPerPixel;
-    for (row = 0; row < rect->h; ++row) {
-        SDL_memcpy(dst, src, length);
-        src += pitch;
-        dst += surface->pitch;
+    /* Pixels already in place, as from SW_SetTexturePixels(), aren't copied */
+    if (src != dst || pitch != surface->pitch) {
+        for (row = 0; row < rect->h; ++row) {
+            SDL_memcpy(dst, src, length);
+            src += pitch;
+            dst += surface->pitch;
+        }
     }
     if(SDL_MUSTLOCK(surface))
         SDL_UnlockSurface(surface);
@@ -321,6 +534,8 @@ SW_LockTexture(SDL_Renderer * renderer, SDL_Texture * texture,
 {
     SDL_Surface *surface = (SDL_Surface *) texture->driverdata;
 
+    SW_RunCommandQueue(renderer);
+    SW_EvictRotated((SW_RenderData *) renderer->driverdata, surface);
     *pixels =
         (void *) ((Uint8 *) surface->pixels + rect->y * surface->pitch +
                   rect->x * surface->format->BytesPerPixel);
@@ -333,11 +548,51 @@ SW_UnlockTexture(SDL_Renderer * renderer, SDL_Texture * texture)
 {
 }
 
+/* The texture's surface is replaced by one of the caller's pixels, or of
+   its own if there are none, with what's set on the texture carried over */
+static int
+SW_SetTexturePixels(SDL_Renderer * renderer, SDL_Texture * texture,
+                    void *pixels, int pitch)
+{
+    SDL_Surface *surface = (SDL_Surface *) texture->driverdata;
+    const SDL_PixelFormat *fmt = surface->format;
+    SDL_Surface *replacement;
+
+    if (pixels) {
+        replacement = SDL_CreateRGBSurfaceFrom(pixels, texture->w, texture->h,
+                                               fmt->BitsPerPixel, pitch,
+                                               fmt->Rmask, fmt->Gmask,
+                                               fmt->Bmask, fmt->Amask);
+    } else {
+        replacement = SDL_CreateRGBSurface(0, texture->w, texture->h,
+                                           fmt->BitsPerPixel, fmt->Rmask,
+                                           fmt->Gmask, fmt->Bmask,
+                                           fmt->Amask);
+    }
+    if (!replacement) {
+        return -1;
+    }
+    SDL_SetSurfaceColorMod(replacement, texture->r, texture->g, texture->b);
+    SDL_SetSurfaceAlphaMod(replacement, texture->a);
+    SDL_SetSurfaceBlendMode(replacement, texture->blendMode);
+
+    SW_RunCommandQueue(renderer);
+    SW_EvictRotated((SW_RenderData *) renderer->driverdata, surface);
+    SDL_FreeSurface(surface);
+    texture->driverdata = replacement;
+    return 0;
+}
+
 static int
 SW_SetRenderTarget(SDL_Renderer * renderer, SDL_Texture * texture)
 {
     SW_RenderData *data = (SW_RenderData *) renderer->driverdata;
 
+    SW_RunCommandQueue(renderer);
+    /* What's drawn on a texture changes its rotated copies */
+    if (data->surface && data->surface != data->window) {
+        SW_EvictRotated(data, data->surface);
+    }
     if (texture ) {
         data->surface = (SDL_Surface *) texture->driverdata;
     } else {
@@ -357,6 +612,7 @@ SW_UpdateViewport(SDL_Renderer * renderer)
         return 0;
     }
 
+    SW_RunCommandQueue(renderer);
     SDL_SetClipRect(data->surface, &renderer->viewport);
     return 0;
 }
@@ -367,6 +623,7 @@ SW_UpdateClipRect(SDL_Renderer * renderer)
     SW_RenderData *data = (SW_RenderData *) renderer->driverdata;
     SDL_Surface *surface = data->surface;
     if (surface) {
+        SW_RunCommandQueue(renderer);
         if (renderer->clipping_enabled) {
             SDL_SetClipRect(surface, &renderer->clip_rect);
         } else {
@@ -387,6 +644,9 @@ SW_RenderClear(SDL_Renderer * renderer)
         return -1;
     }
 
+    /* Whatever was to be drawn would be cleared away */
+    SW_DiscardCommandQueue((SW_RenderData *) renderer->driverdata);
+
     color = SDL_MapRGBA(surface->format,
                         renderer->r, renderer->g, renderer->b, renderer->a);
 
@@ -398,22 +658,90 @@ SW_RenderClear(SDL_Renderer * renderer)
     return 0;
 }
 
-static int
-SW_RenderDrawPoints(SDL_Renderer * renderer, const SDL_FPoint * points,
-                    int count)
+/* Room for count more items after the num in *buffer, or NULL */
+static void *
+SW_Reserve(void **buffer, int *max, int num, int count, size_t size)
 {
-    SDL_Surface *surface = SW_ActivateRenderer(renderer);
-    SDL_Point *final_points;
-    int i, status;
+    if (count > *max - num) {
+        int new_max = SDL_max(SDL_max(*max * 2, 64), num + count);
+        void *new_buffer = SDL_realloc(*buffer, new_max * size);
 
-    if (!surface) {
-        return -1;
+        if (!new_buffer) {
+            SDL_OutOfMemory();
+            return NULL;
+        }
+        *buffer = new_buffer;
+        *max = new_max;
     }
+    return (Uint8 *) *buffer + num * size;
+}
 
-    final_points = SDL_stack_alloc(SDL_Point, count);
-    if (!final_points) {
-        return SDL_OutOfMemory();
+/* Records a draw with the renderer's color & blend mode, of count points or
+   rects put at *items; returns it, or NULL if there's no memory */
+static SW_Command *
+SW_QueueCommand(SDL_Renderer * renderer, SW_CommandType type, int count,
+                void **items)
+{
+    SW_RenderData *data = (SW_RenderData *) renderer->driverdata;
+    SW_Command *cmd;
+    int first = 0;
+
+    *items = NULL;
+    if (data->num_commands >= SW_MAX_COMMANDS) {
+        SW_RunCommandQueue(renderer);
+    }
+    if (type == SW_CMD_POINTS || type == SW_CMD_LINES) {
+        *items = SW_Reserve((void **) &data->points, &data->max_points,
+                            data->num_points, count, sizeof(SDL_Point));
+        first = data->num_points;
+    } else if (type == SW_CMD_FILLRECTS) {
+        *items = SW_Reserve((void **) &data->rects, &data->max_rects,
+                            data->num_rects, count, sizeof(SDL_Rect));
+        first = data->num_rects;
+    }
+    if (count > 0 && !*items) {
+        return NULL;
     }
+    cmd = (SW_Command *) SW_Reserve((void **) &data->commands,
+                                   &data->max_commands, data->num_commands,
+                                   1, sizeof(SW_Command));
+    if (!cmd) {
+        return NULL;
+    }
+    if (type == SW_CMD_POINTS || type == SW_CMD_LINES) {
+        data->num_points += count;
+    } else if (type == SW_CMD_FILLRECTS) {
+        data->num_rects += count;
+    }
+    ++data->num_commands;
+
+    SDL_zerop(cmd);
+    cmd->type = type;
+    cmd->blendMode = renderer->blendMode;
+    cmd->r = renderer->r;
+    cmd->g = renderer->g;
+    cmd->b = renderer->b;
+    cmd->a = renderer->a;
+    cmd->first = first;
+    cmd->count = count;
+    return cmd;
+}
+
+/* The queue's run right away unless it's batching */
+static int
+SW_QueuedCommand(SDL_Renderer * renderer)
+{
+    SW_RenderData *data = (SW_RenderData *) renderer->driverdata;
+
+    return data->batching ? 0 : SW_RunCommandQueue(renderer);
+}
+
+static void
+SW_FinalPoints(SDL_Renderer * renderer, const SDL_FPoint * points, int count,
+               SDL_Point * final_points)
+{
+    int i;
+
     if (renderer->viewport.x || renderer->viewport.y) {
         int x = renderer->viewport.x;
         int y = renderer->viewport.y;
@@ -428,88 +756,62 @@ SW_RenderDrawPoints(SDL_Renderer * renderer, const SDL_FPoint * points,
             final_points[i].y = (int)points[i].y;
         }
     }
-
-    /* Draw the points! */
-    if (renderer->blendMode == SDL_BLENDMODE_NONE) {
-        Uint32 color = SDL_MapRGBA(surface->format,
-                                   renderer->r, renderer->g, renderer->b,
-                                   renderer->a);
-
-        status = SDL_DrawPoints(surface, final_points, count, color);
-    } else {
-        status = SDL_BlendPoints(surface, final_points, count,
-                                renderer->blendMode,
-                                renderer->r, renderer->g, renderer->b,
-                                renderer->a);
-    }
-    SDL_stack_free(final_points);
-
-    return status;
 }
 
 static int
-SW_RenderDrawLines(SDL_Renderer * renderer, const SDL_FPoint * points,
-                   int count)
+SW_QueueDrawPoints(SDL_Renderer * renderer, SW_CommandType type,
+                   const SDL_FPoint * points, int count)
 {
     SDL_Surface *surface = SW_ActivateRenderer(renderer);
-    SDL_Point *final_points;
-    int i, status;
+    SDL_Point *final_points = NULL;
+    SW_Command *cmd;
+    SDL_Rect bounds;
 
     if (!surface) {
         return -1;
     }
 
-    final_points = SDL_stack_alloc(SDL_Point, count);
-    if (!final_points) {
-        return SDL_OutOfMemory();
+    cmd = SW_QueueCommand(renderer, type, count, (void **) &final_points);
+    if (!cmd) {
+        return -1;
     }
-    if (renderer->viewport.x || renderer->viewport.y) {
-        int x = renderer->viewport.x;
-        int y = renderer->viewport.y;
-
-        for (i = 0; i < count; ++i) {
-            final_points[i].x = (int)(x + points[i].x);
-            final_points[i].y = (int)(y + points[i].y);
-        }
-    } else {
-        for (i = 0; i < count; ++i) {
-            final_points[i].x = (int)points[i].x;
-            final_points[i].y = (int)points[i].y;
-        }
+    SW_FinalPoints(renderer, points, count, final_points);
+    /* Nothing's drawn outside the clip rect */
+    if (SDL_EnclosePoints(final_points, count, NULL, &bounds)) {
+        SDL_IntersectRect(&bounds, &surface->clip_rect, &cmd->bounds);
     }
+    return SW_QueuedCommand(renderer);
+}
 
-    /* Draw the lines! */
-    if (renderer->blendMode == SDL_BLENDMODE_NONE) {
-        Uint32 color = SDL_MapRGBA(surface->format,
-                                   renderer->r, renderer->g, renderer->b,
-                                   renderer->a);
-
-        status = SDL_DrawLines(surface, final_points, count, color);
-    } else {
-        status = SDL_BlendLines(surface, final_points, count,
-                                renderer->blendMode,
-                                renderer->r, renderer->g, renderer->b,
-                                renderer->a);
-    }
-    SDL_stack_free(final_points);
+static int
+SW_RenderDrawPoints(SDL_Renderer * renderer, const SDL_FPoint * points,
+                    int count)
+{
+    return SW_QueueDrawPoints(renderer, SW_CMD_POINTS, points, count);
+}
 
-    return status;
+static int
+SW_RenderDrawLines(SDL_Renderer * renderer, const SDL_FPoint * points,
+                   int count)
+{
+    return SW_QueueDrawPoints(renderer, SW_CMD_LINES, points, count);
 }
 
 static int
 SW_RenderFillRects(SDL_Renderer * renderer, const SDL_FRect * rects, int count)
 {
     SDL_Surface *surface = SW_ActivateRenderer(renderer);
-    SDL_Rect *final_rects;
-    int i, status;
+    SDL_Rect *final_rects = NULL;
+    SW_Command *cmd;
+    int i;
 
     if (!surface) {
         return -1;
     }
 
-    final_rects = SDL_stack_alloc(SDL_Rect, count);
-    if (!final_rects) {
-        return SDL_OutOfMemory();
+    cmd = SW_QueueCommand(renderer, SW_CMD_FILLRECTS, count, (void **) &final_rects);
+    if (!cmd) {
+        return -1;
     }
     if (renderer->viewport.x || renderer->viewport.y) {
         int x = renderer->viewport.x;
@@ -529,99 +831,229 @@ SW_RenderFillRects(SDL_Renderer * renderer, const SDL_FRect * rects, int count)
             final_rects[i].h = SDL_max((int)rects[i].h, 1);
         }
     }
+    for (i = 0; i < count; ++i) {
+        SDL_Rect clipped;
+
+        if (SDL_IntersectRect(&final_rects[i], &surface->clip_rect, &clipped)) {
+            if (SDL_RectEmpty(&cmd->bounds)) {
+                cmd->bounds = clipped;
+            } else {
+                SDL_UnionRect(&cmd->bounds, &clipped, &cmd->bounds);
+            }
+        }
+    }
+    return SW_QueuedCommand(renderer);
+}
 
-    if (renderer->blendMode == SDL_BLENDMODE_NONE) {
-        Uint32 color = SDL_MapRGBA(surface->format,
-                                   renderer->r, renderer->g, renderer->b,
-                                   renderer->a);
-        status = SDL_FillRects(surface, final_rects, count, color);
+static int SDLCALL
+ParseScaleFilter(const char *hint, int default_value)
+{
+    if (!hint || *hint == '0' || SDL_strcasecmp(hint, "nearest") == 0) {
+        return SDL_STRETCH_NEAREST;
+    } else if (*hint == '1' || SDL_strcasecmp(hint, "linear") == 0) {
+        return SDL_STRETCH_LINEAR;
     } else {
-        status = SDL_BlendFillRects(surface, final_rects, count,
-                                    renderer->blendMode,
-                                    renderer->r, renderer->g, renderer->b,
-                                    renderer->a);
+        return SDL_STRETCH_AREA;
     }
-    SDL_stack_free(final_rects);
+}
 
-    return status;
+/* Read on every copy, so through a handle */
+static SDL_StretchFilter
+GetScaleFilter(void)
+{
+    static SDL_HintHandle quality =
+        SDL_HINT_HANDLE_INIT(SDL_HINT_RENDER_SCALE_QUALITY, SDL_STRETCH_NEAREST, ParseScaleFilter);
+
+    return (SDL_StretchFilter) SDL_GetHintValue(&quality);
+}
+
+/* The filter to scale src with, when it can be filtered: "best" averages
+   the pixels when shrinking & blends them when growing */
+static SDL_StretchFilter
+GetStretchFilter(SDL_Surface * src, const SDL_Rect * srcrect, const SDL_Rect * dstrect)
+{
+    SDL_StretchFilter filter = GetScaleFilter();
+    Uint32 colorkey;
+
+    /* Filtering would blend the color key into the pixels next to it */
+    if (src->format->BytesPerPixel != 4 ||
+        SDL_PIXELLAYOUT(src->format->format) != SDL_PACKEDLAYOUT_8888 ||
+        SDL_GetColorKey(src, &colorkey) == 0) {
+        return SDL_STRETCH_NEAREST;
+    }
+    if (filter == SDL_STRETCH_AREA &&
+        dstrect->w >= srcrect->w && dstrect->h >= srcrect->h) {
+        filter = SDL_STRETCH_LINEAR;
+    }
+    return filter;
 }
 
+/* Scaled with filtering: straight into the target when it's a copy, else
+   into a surface blended from */
 static int
-SW_RenderCopy(SDL_Renderer * renderer, SDL_Texture * texture,
-              const SDL_Rect * srcrect, const SDL_FRect * dstrect)
+SW_RenderCopyFiltered(SDL_Surface * surface, SDL_Surface * src,
+                      const SDL_Rect * srcrect, const SDL_Rect * final_rect,
+                      SDL_StretchFilter filter)
 {
-    SDL_Surface *surface = SW_ActivateRenderer(renderer);
-    SDL_Surface *src = (SDL_Surface *) texture->driverdata;
-    SDL_Rect final_rect;
+    SDL_Surface *scaled;
+    SDL_BlendMode blendMode;
+    Uint8 alphaMod, r, g, b;
+    SDL_Rect rect = *final_rect;
+    int retval;
+
+    SDL_GetSurfaceAlphaMod(src, &alphaMod);
+    SDL_GetSurfaceBlendMode(src, &blendMode);
+    SDL_GetSurfaceColorMod(src, &r, &g, &b);
+    if (blendMode == SDL_BLENDMODE_NONE && (alphaMod & r & g & b) == 255 &&
+        src->format->format == surface->format->format) {
+        return SDL_SoftStretchFiltered(src, srcrect, surface, final_rect, filter);
+    }
 
-    if (!surface) {
+    scaled = SDL_AcquireSurface(final_rect->w, final_rect->h,
+                                src->format->format);
+    if (!scaled) {
         return -1;
     }
+    retval = SDL_SoftStretchFiltered(src, srcrect, scaled, NULL, filter);
+    if (!retval) {
+        SDL_SetSurfaceAlphaMod(scaled, alphaMod);
+        SDL_SetSurfaceBlendMode(scaled, blendMode);
+        SDL_SetSurfaceColorMod(scaled, r, g, b);
+        retval = SDL_BlitSurface(scaled, NULL, surface, &rect);
+    }
+    SDL_ReleaseSurface(scaled);
+    return retval;
+}
 
+static void
+SW_FinalRect(SDL_Renderer * renderer, const SDL_FRect * dstrect,
+             SDL_Rect * final_rect)
+{
     if (renderer->viewport.x || renderer->viewport.y) {
-        final_rect.x = (int)(renderer->viewport.x + dstrect->x);
-        final_rect.y = (int)(renderer->viewport.y + dstrect->y);
+        final_rect->x = (int)(renderer->viewport.x + dstrect->x);
+        final_rect->y = (int)(renderer->viewport.y + dstrect->y);
     } else {
-        final_rect.x = (int)dstrect->x;
-        final_rect.y = (int)dstrect->y;
+        final_rect->x = (int)dstrect->x;
+        final_rect->y = (int)dstrect->y;
     }
-    final_rect.w = (int)dstrect->w;
-    final_rect.h = (int)dstrect->h;
+    final_rect->w = (int)dstrect->w;
+    final_rect->h = (int)dstrect->h;
+}
+
+static int
+SW_RunCopy(SDL_Surface * surface, SDL_Surface * src,
+           const SDL_Rect * srcrect, const SDL_Rect * dstrect)
+{
+    SDL_Rect final_rect = *dstrect;
 
     if ( srcrect->w == final_rect.w && srcrect->h == final_rect.h ) {
         return SDL_BlitSurface(src, srcrect, surface, &final_rect);
     } else {
+        SDL_StretchFilter filter = GetStretchFilter(src, srcrect, &final_rect);
+        SDL_Rect clipped;
+
         /* If scaling is ever done, permanently disable RLE (which doesn't support scaling)
          * to avoid potentially frequent RLE encoding/decoding.
          */
         SDL_SetSurfaceRLE(surface, 0);
+
+        /* Filtered stretches are unclipped, so only when it's all visible */
+        if (filter != SDL_STRETCH_NEAREST &&
+            SDL_IntersectRect(&final_rect, &surface->clip_rect, &clipped) &&
+            SDL_RectEquals(&final_rect, &clipped)) {
+            return SW_RenderCopyFiltered(surface, src, srcrect, &final_rect, filter);
+        }
         return SDL_BlitScaled(src, srcrect, surface, &final_rect);
     }
 }
 
 static int
-GetScaleQuality(void)
+SW_RenderCopy(SDL_Renderer * renderer, SDL_Texture * texture,
+              const SDL_Rect * srcrect, const SDL_FRect * dstrect)
 {
-    const char *hint = SDL_GetHint(SDL_HINT_RENDER_SCALE_QUALITY);
+    SDL_Surface *surface = SW_ActivateRenderer(renderer);
+    SW_Command *cmd;
+    void *unused;
 
-    if (!hint || *hint == '0' || SDL_strcasecmp(hint, "nearest") == 0) {
-        return 0;
-    } else {
-        return 1;
+    if (!surface) {
+        return -1;
     }
+
+    cmd = SW_QueueCommand(renderer, SW_CMD_COPY, 0, &unused);
+    if (!cmd) {
+        return -1;
+    }
+    cmd->texture = texture;
+    cmd->srcrect = *srcrect;
+    SW_FinalRect(renderer, dstrect, &cmd->dstrect);
+    SDL_IntersectRect(&cmd->dstrect, &surface->clip_rect, &cmd->bounds);
+    return SW_QueuedCommand(renderer);
 }
 
-static int
-SW_RenderCopyEx(SDL_Renderer * renderer, SDL_Texture * texture,
-                const SDL_Rect * srcrect, const SDL_FRect * dstrect,
-                const double angle, const SDL_FPoint * center, const SDL_RendererFlip flip)
+/* A copy of src's pixels from the surface pool (indexed ones converted) */
+static SDL_Surface *
+SW_CloneSurface(SDL_Surface * src)
 {
-    SDL_Surface *surface = SW_ActivateRenderer(renderer);
-    SDL_Surface *src = (SDL_Surface *) texture->driverdata;
-    SDL_Rect final_rect, tmp_rect;
-    SDL_Surface *surface_rotated, *surface_scaled;
-    int retval, dstwidth, dstheight, abscenterx, abscentery;
-    double cangle, sangle, px, py, p1x, p1y, p2x, p2y, p3x, p3y, p4x, p4y;
+    SDL_Surface *clone;
 
-    if (!surface) {
-        return -1;
+    if (SDL_ISPIXELFORMAT_INDEXED(src->format->format)) {
+        return SDL_ConvertSurface(src, src->format, src->flags);
     }
-
-    if (renderer->viewport.x || renderer->viewport.y) {
-        final_rect.x = (int)(renderer->viewport.x + dstrect->x);
-        final_rect.y = (int)(renderer->viewport.y + dstrect->y);
-    } else {
-        final_rect.x = (int)dstrect->x;
-        final_rect.y = (int)dstrect->y;
+    clone = SDL_AcquireSurface(src->w, src->h, src->format->format);
+    if (!clone) {
+        return NULL;
+    }
+    if (SDL_MUSTLOCK(src)) {
+        SDL_LockSurface(src);
     }
-    final_rect.w = (int)dstrect->w;
-    final_rect.h = (int)dstrect->h;
+    SDL_ConvertPixels(src->w, src->h, src->format->format, src->pixels,
+                      src->pitch, clone->format->format, clone->pixels,
+                      clone->pitch);
+    if (SDL_MUSTLOCK(src)) {
+        SDL_UnlockSurface(src);
+    }
+    return clone;
+}
+
+static int
+SW_RunCopyEx(SW_RenderData * data, SDL_Surface * src,
+             const SDL_Rect * srcrect, const SDL_Rect * dstrect,
+             const double angle, const SDL_FPoint * center, const SDL_RendererFlip flip)
+{
+    SDL_Surface *surface = data->surface;
+    SDL_Rect final_rect = *dstrect, tmp_rect;
+    SDL_Surface *surface_rotated = NULL, *surface_scaled;
+    int retval, dstwidth, dstheight, abscenterx, abscentery;
+    double cangle, sangle, px, py, p1x, p1y, p2x, p2y, p3x, p3y, p4x, p4y;
+    SW_RotateKey key;
+    SW_RotatedSurface *cached;
+
+    SDL_zero(key);
+    key.src = src;
+    key.srcrect = *srcrect;
+    key.w = final_rect.w;
+    key.h = final_rect.h;
+    key.angle = angle;
+    key.flip = flip;
+    key.filter = GetScaleFilter();
+    SDL_GetSurfaceBlendMode(src, &key.blendMode);
+    SDL_GetSurfaceAlphaMod(src, &key.alphaMod);
+    SDL_GetSurfaceColorMod(src, &key.r, &key.g, &key.b);
+    cached = SW_FindRotated(data, &key);
 
     /* SDLgfx_rotateSurface doesn't accept a source rectangle, so crop and scale if we need to */
     tmp_rect = final_rect;
     tmp_rect.x = 0;
     tmp_rect.y = 0;
-    if (srcrect->w == final_rect.w && srcrect->h == final_rect.h && srcrect->x == 0 && srcrect->y == 0) {
+    if (cached) {
+        surface_scaled = src;
+        surface_rotated = cached->surface;
+        dstwidth = cached->w;
+        dstheight = cached->h;
+        cangle = cached->cangle;
+        sangle = cached->sangle;
+        retval = 0;
+    } else if (srcrect->w == final_rect.w && srcrect->h == final_rect.h && srcrect->x == 0 && srcrect->y == 0) {
         surface_scaled = src; /* but if we don't need to, just use the original */
         retval = 0;
     } else {
@@ -630,10 +1062,9 @@ SW_RenderCopyEx(SDL_Renderer * renderer, SDL_Texture * texture,
         SDL_BlendMode blendMode;
         Uint8 alphaMod, r, g, b;
         SDL_bool cloneSource = SDL_FALSE;
+        SDL_StretchFilter filter;
 
-        surface_scaled = SDL_CreateRGBSurface(SDL_SWSURFACE, final_rect.w, final_rect.h, src->format->BitsPerPixel,
-                                              src->format->Rmask, src->format->Gmask,
-                                              src->format->Bmask, src->format->Amask );
+        surface_scaled = SDL_AcquireSurface(final_rect.w, final_rect.h, src->format->format);
         if (!surface_scaled) {
             return -1;
         }
@@ -654,9 +1085,9 @@ SW_RenderCopyEx(SDL_Renderer * renderer, SDL_Texture * texture,
          */
         cloneSource |= blendMode != SDL_BLENDMODE_NONE || (alphaMod & r & g & b) != 255;
         if (cloneSource) {
-            blit_src = SDL_ConvertSurface(src, src->format, src->flags); /* clone src */
+            blit_src = SW_CloneSurface(src);
             if (!blit_src) {
-                SDL_FreeSurface(surface_scaled);
+                SDL_ReleaseSurface(surface_scaled);
                 return -1;
             }
             SDL_SetSurfaceAlphaMod(blit_src, 255); /* disable all blending options in blit_src */
@@ -670,15 +1101,22 @@ SW_RenderCopyEx(SDL_Renderer * renderer, SDL_Texture * texture,
             SDL_SetSurfaceColorMod(surface_scaled, r, g, b);
         }
 
-        retval = SDL_BlitScaled(blit_src, srcrect, surface_scaled, &tmp_rect);
+        filter = GetStretchFilter(src, srcrect, &tmp_rect);
+        if (filter != SDL_STRETCH_NEAREST) {
+            retval = SDL_SoftStretchFiltered(blit_src, srcrect, surface_scaled, &tmp_rect, filter);
+        } else {
+            retval = SDL_BlitScaled(blit_src, srcrect, surface_scaled, &tmp_rect);
+        }
         if (blit_src != src) {
-            SDL_FreeSurface(blit_src);
+            SDL_ReleaseSurface(blit_src);
         }
     }
 
     if (!retval) {
-        SDLgfx_rotozoomSurfaceSizeTrig(tmp_rect.w, tmp_rect.h, -angle, &dstwidth, &dstheight, &cangle, &sangle);
-        surface_rotated = SDLgfx_rotateSurface(surface_scaled, -angle, dstwidth/2, dstheight/2, GetScaleQuality(), flip & SDL_FLIP_HORIZONTAL, flip & SDL_FLIP_VERTICAL, dstwidth, dstheight, cangle, sangle);
+        if (!cached) {
+            SDLgfx_rotozoomSurfaceSizeTrig(tmp_rect.w, tmp_rect.h, -angle, &dstwidth, &dstheight, &cangle, &sangle);
+            surface_rotated = SDLgfx_rotateSurface(surface_scaled, -angle, dstwidth/2, dstheight/2, key.filter != SDL_STRETCH_NEAREST, flip & SDL_FLIP_HORIZONTAL, flip & SDL_FLIP_VERTICAL, dstwidth, dstheight, cangle, sangle);
+        }
         if(surface_rotated) {
             /* Find out where the new origin is by rotating the four final_rect points around the center and then taking the extremes */
             abscenterx = final_rect.x + (int)center->x;
@@ -716,16 +1154,255 @@ SW_RenderCopyEx(SDL_Renderer * renderer, SDL_Texture * texture,
             tmp_rect.h = dstheight;
 
             retval = SDL_BlitSurface(surface_rotated, NULL, surface, &tmp_rect);
-            SDL_FreeSurface(surface_rotated);
+            if (!cached && !SW_CacheRotated(data, &key, surface_rotated, dstwidth, dstheight, cangle, sangle)) {
+                SDL_ReleaseSurface(surface_rotated);
+            }
         }
     }
 
     if (surface_scaled != src) {
-        SDL_FreeSurface(surface_scaled);
+        SDL_ReleaseSurface(surface_scaled);
     }
     return retval;
 }
 
+static int
+SW_RenderCopyEx(SDL_Renderer * renderer, SDL_Texture * texture,
+                const SDL_Rect * srcrect, const SDL_FRect * dstrect,
+                const double angle, const SDL_FPoint * center, const SDL_RendererFlip flip)
+{
+    SDL_Surface *surface = SW_ActivateRenderer(renderer);
+    SW_Command *cmd;
+    void *unused;
+
+    if (!surface) {
+        return -1;
+    }
+
+    cmd = SW_QueueCommand(renderer, SW_CMD_COPY_EX, 0, &unused);
+    if (!cmd) {
+        return -1;
+    }
+    cmd->texture = texture;
+    cmd->srcrect = *srcrect;
+    SW_FinalRect(renderer, dstrect, &cmd->dstrect);
+    cmd->angle = angle;
+    cmd->center = *center;
+    cmd->flip = flip;
+    /* Rotated, it may be anywhere in the clip rect */
+    cmd->bounds = surface->clip_rect;
+    return SW_QueuedCommand(renderer);
+}
+
+static int
+SW_RunCommand(SW_RenderData * data, const SW_Command * cmd, const void *items)
+{
+    SDL_Surface *surface = data->surface;
+    const SDL_Point *points = (const SDL_Point *) items;
+    const SDL_Rect *rects = (const SDL_Rect *) items;
+    SDL_Surface *src = cmd->texture ? (SDL_Surface *) cmd->texture->driverdata : NULL;
+    Uint32 color = 0;
+
+    if (cmd->blendMode == SDL_BLENDMODE_NONE) {
+        color = SDL_MapRGBA(surface->format, cmd->r, cmd->g, cmd->b, cmd->a);
+    }
+    switch (cmd->type) {
+    case SW_CMD_POINTS:
+        if (cmd->blendMode == SDL_BLENDMODE_NONE) {
+            return SDL_DrawPoints(surface, points, cmd->count, color);
+        }
+        return SDL_BlendPoints(surface, points, cmd->count, cmd->blendMode,
+                               cmd->r, cmd->g, cmd->b, cmd->a);
+    case SW_CMD_LINES:
+        if (cmd->blendMode == SDL_BLENDMODE_NONE) {
+            return SDL_DrawLines(surface, points, cmd->count, color);
+        }
+        return SDL_BlendLines(surface, points, cmd->count, cmd->blendMode,
+                              cmd->r, cmd->g, cmd->b, cmd->a);
+    case SW_CMD_FILLRECTS:
+        if (cmd->blendMode == SDL_BLENDMODE_NONE) {
+            return SDL_FillRects(surface, rects, cmd->count, color);
+        }
+        return SDL_BlendFillRects(surface, rects, cmd->count, cmd->blendMode,
+                                  cmd->r, cmd->g, cmd->b, cmd->a);
+    case SW_CMD_COPY:
+        return SW_RunCopy(surface, src, &cmd->srcrect, &cmd->dstrect);
+    case SW_CMD_COPY_EX:
+        return SW_RunCopyEx(data, src, &cmd->srcrect, &cmd->dstrect,
+                            cmd->angle, &cmd->center, cmd->flip);
+    }
+    return 0;
+}
+
+/* Whether b can be run in a with a's first command */
+static SDL_bool
+SW_SameBatch(const SW_Command * a, const SW_Command * b)
+{
+    if (a->type != b->type || a->blendMode != b->blendMode ||
+        a->texture != b->texture) {
+        return SDL_FALSE;
+    }
+    if (!a->texture &&
+        (a->r != b->r || a->g != b->g || a->b != b->b || a->a != b->a)) {
+        return SDL_FALSE;
+    }
+    return SDL_TRUE;
+}
+
+/* A batch's commands one after another, or its points or rects all in one
+   when it has its color & blend mode for them all */
+static int
+SW_RunBatch(SW_RenderData * data, const SW_Batch * batch)
+{
+    const SW_Command *first = &data->commands[batch->first];
+    int i, status = 0;
+
+    if (batch->first != batch->last &&
+        (first->type == SW_CMD_POINTS || first->type == SW_CMD_FILLRECTS)) {
+        const SDL_bool fills = (first->type == SW_CMD_FILLRECTS);
+        const size_t size = fills ? sizeof(SDL_Rect) : sizeof(SDL_Point);
+        const Uint8 *items = fills ? (const Uint8 *) data->rects : (const Uint8 *) data->points;
+        SW_Command merged = *first;
+        int total = 0;          /* no more than there are recorded */
+
+        for (i = batch->first; i >= 0; i = data->commands[i].next) {
+            total += data->commands[i].count;
+        }
+        if (total * size > data->merged_size) {
+            void *buffer = SDL_realloc(data->merged, total * size);
+
+            if (buffer) {
+                data->merged = buffer;
+                data->merged_size = total * size;
+            }
+        }
+        if (total * size <= data->merged_size) {
+            Uint8 *dst = (Uint8 *) data->merged;
+
+            for (i = batch->first; i >= 0; i = data->commands[i].next) {
+                const SW_Command *cmd = &data->commands[i];
+
+                SDL_memcpy(dst, items + cmd->first * size, cmd->count * size);
+                dst += cmd->count * size;
+            }
+            merged.count = total;
+            return SW_RunCommand(data, &merged, data->merged);
+        }
+    }
+
+    for (i = batch->first; i >= 0; i = data->commands[i].next) {
+        const SW_Command *cmd = &data->commands[i];
+        const void *items = NULL;
+
+        if (cmd->type == SW_CMD_POINTS || cmd->type == SW_CMD_LINES) {
+            items = &data->points[cmd->first];
+        } else if (cmd->type == SW_CMD_FILLRECTS) {
+            items = &data->rects[cmd->first];
+        }
+        if (SW_RunCommand(data, cmd, items) < 0) {
+            status = -1;
+        }
+    }
+    return status;
+}
+
+/* The tiles of an 8x8 grid over the surface which rect touches: scattered
+   draws cover much less of them than of their bounds */
+static Uint64
+SW_TileMask(const SDL_Surface * surface, const SDL_Rect * rect)
+{
+    Uint64 mask = 0;
+    int x0, x1, y0, y1, y;
+
+    if (SDL_RectEmpty(rect)) {
+        return 0;
+    }
+    /* rect is within the clip rect, so the surface */
+    x0 = (int) ((Sint64) rect->x * 8 / surface->w);
+    x1 = (int) ((Sint64) (rect->x + rect->w - 1) * 8 / surface->w);
+    y0 = (int) ((Sint64) rect->y * 8 / surface->h);
+    y1 = (int) ((Sint64) (rect->y + rect->h - 1) * 8 / surface->h);
+    for (y = y0; y <= y1; ++y) {
+        mask |= (Uint64) (((1 << (x1 - x0 + 1)) - 1) << x0) << (8 * y);
+    }
+    return mask;
+}
+
+/* Runs the recorded drawing.  Each command joins the latest of the last few
+   batches which it can, provided nothing in a batch after that overlaps it,
+   so whatever overlaps is still drawn in the order it was recorded. */
+static int
+SW_RunCommandQueue(SDL_Renderer * renderer)
+{
+    SW_RenderData *data = (SW_RenderData *) renderer->driverdata;
+    SW_Batch *batches;
+    int i, num_batches = 0, status = 0;
+
+    if (data->num_commands == 0) {
+        return 0;
+    }
+    if (!data->surface) {
+        SW_DiscardCommandQueue(data);
+        return SDL_SetError("Software renderer doesn't have an output surface");
+    }
+
+    batches = (SW_Batch *) SW_Reserve((void **) &data->batches,
+                                      &data->max_batches, 0,
+                                      data->num_commands, sizeof(SW_Batch));
+    for (i = 0; i < data->num_commands; ++i) {
+        SW_Command *cmd = &data->commands[i];
+        const Uint64 tiles = SW_TileMask(data->surface, &cmd->bounds);
+        int b, join = -1;
+
+        cmd->next = -1;
+        /* Without the memory, every command's a batch of its own */
+        for (b = num_batches - 1;
+             batches && b >= 0 && b >= num_batches - SW_BATCH_LOOKBACK; --b) {
+            if (SW_SameBatch(&data->commands[batches[b].first], cmd)) {
+                join = b;
+                break;
+            }
+            if ((batches[b].tiles & tiles) &&
+                SDL_HasIntersection(&batches[b].bounds, &cmd->bounds)) {
+                break;
+            }
+        }
+        if (join >= 0) {
+            SW_Batch *batch = &batches[join];
+
+            data->commands[batch->last].next = i;
+            batch->last = i;
+            batch->tiles |= tiles;
+            if (SDL_RectEmpty(&batch->bounds)) {
+                batch->bounds = cmd->bounds;
+            } else if (!SDL_RectEmpty(&cmd->bounds)) {
+                SDL_UnionRect(&batch->bounds, &cmd->bounds, &batch->bounds);
+            }
+        } else if (batches) {
+            SW_Batch *batch = &batches[num_batches++];
+
+            batch->first = batch->last = i;
+            batch->bounds = cmd->bounds;
+            batch->tiles = tiles;
+        } else {
+            SW_Batch batch;
+
+            batch.first = batch.last = i;
+            if (SW_RunBatch(data, &batch) < 0) {
+                status = -1;
+            }
+        }
+    }
+    for (i = 0; i < num_batches; ++i) {
+        if (SW_RunBatch(data, &batches[i]) < 0) {
+            status = -1;
+        }
+    }
+
+    SW_DiscardCommandQueue(data);
+    return status;
+}
+
 static int
 SW_RenderReadPixels(SDL_Renderer * renderer, const SDL_Rect * rect,
                     Uint32 format, void * pixels, int pitch)
@@ -739,6 +1416,8 @@ SW_RenderReadPixels(SDL_Renderer * renderer, const SDL_Rect * rect,
         return -1;
     }
 
+    SW_RunCommandQueue(renderer);
+
     if (renderer->viewport.x || renderer->viewport.y) {
         final_rect.x = renderer->viewport.x + rect->x;
         final_rect.y = renderer->viewport.y + rect->y;
@@ -767,6 +1446,7 @@ SW_RenderPresent(SDL_Renderer * renderer)
 {
     SDL_Window *window = renderer->window;
 
+    SW_RunCommandQueue(renderer);
     if (window) {
         SDL_UpdateWindowSurface(window);
     }
@@ -777,6 +1457,8 @@ SW_DestroyTexture(SDL_Renderer * renderer, SDL_Texture * texture)
 {
     SDL_Surface *surface = (SDL_Surface *) texture->driverdata;
 
+    SW_RunCommandQueue(renderer);
+    SW_EvictRotated((SW_RenderData *) renderer->driverdata, surface);
     SDL_FreeSurface(surface);
 }
 
@@ -785,6 +1467,15 @@ SW_DestroyRenderer(SDL_Renderer * renderer)
 {
     SW_RenderData *data = (SW_RenderData *) renderer->driverdata;
 
+    if (data) {
+        SW_RunCommandQueue(renderer);
+        SW_EvictRotated(data, NULL);
+        SDL_free(data->commands);
+        SDL_free(data->points);
+        SDL_free(data->rects);
+        SDL_free(data->batches);
+        SDL_free(data->merged);
+    }
     SDL_free(data);
     SDL_free(renderer);
 }
@@ -39,6 +39,15 @@ Andreas Schiffler -- aschiffler at ferzkopp dot net
 
 #include "SDL.h"
 #include "SDL_rotate.h"
+#include "../../video/SDL_blit.h"
+
+/* The x86 32 bit rotozoomers: SSE2 smoothing four pixels at a time & AVX2
+   gathering eight without, both giving the same pixels as the C ones */
+#if defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SDL_ROTATE_X86 1
+#include <immintrin.h>
+#endif
 
 /* ---- Internally used structures */
 
@@ -136,6 +145,228 @@ SDLgfx_rotozoomSurfaceSizeTrig(int width, int height, double angle,
 }
 
 
+/* !
+\brief One anti-aliased pixel of the 32 bit rotozoomer.
+
+Interpolates the source pixels around the 16.16 fixed point position sdx,sdy
+into pc, leaving it as it is where that's not within the source.
+*/
+SDL_FORCE_INLINE void
+_smoothPixel(const SDL_Surface * src, tColorRGBA * pc, int sdx, int sdy, int flipx, int flipy)
+{
+    int t1, t2, dx, dy, ex, ey;
+    const int sw = src->w - 1;
+    const int sh = src->h - 1;
+    tColorRGBA c00, c01, c10, c11, cswap;
+    const tColorRGBA *sp;
+
+    dx = (sdx >> 16);
+    dy = (sdy >> 16);
+    if (flipx) dx = sw - dx;
+    if (flipy) dy = sh - dy;
+    if ((unsigned)dx < (unsigned)sw && (unsigned)dy < (unsigned)sh) {
+        sp = (const tColorRGBA *) ((const Uint8 *) src->pixels + src->pitch * dy) + dx;
+        c00 = *sp;
+        sp += 1;
+        c01 = *sp;
+        sp += (src->pitch/4);
+        c11 = *sp;
+        sp -= 1;
+        c10 = *sp;
+        if (flipx) {
+            cswap = c00; c00=c01; c01=cswap;
+            cswap = c10; c10=c11; c11=cswap;
+        }
+        if (flipy) {
+            cswap = c00; c00=c10; c10=cswap;
+            cswap = c01; c01=c11; c11=cswap;
+        }
+        /*
+        * Interpolate colors
+        */
+        ex = (sdx & 0xffff);
+        ey = (sdy & 0xffff);
+        t1 = ((((c01.r - c00.r) * ex) >> 16) + c00.r) & 0xff;
+        t2 = ((((c11.r - c10.r) * ex) >> 16) + c10.r) & 0xff;
+        pc->r = (((t2 - t1) * ey) >> 16) + t1;
+        t1 = ((((c01.g - c00.g) * ex) >> 16) + c00.g) & 0xff;
+        t2 = ((((c11.g - c10.g) * ex) >> 16) + c10.g) & 0xff;
+        pc->g = (((t2 - t1) * ey) >> 16) + t1;
+        t1 = ((((c01.b - c00.b) * ex) >> 16) + c00.b) & 0xff;
+        t2 = ((((c11.b - c10.b) * ex) >> 16) + c10.b) & 0xff;
+        pc->b = (((t2 - t1) * ey) >> 16) + t1;
+        t1 = ((((c01.a - c00.a) * ex) >> 16) + c00.a) & 0xff;
+        t2 = ((((c11.a - c10.a) * ex) >> 16) + c10.a) & 0xff;
+        pc->a = (((t2 - t1) * ey) >> 16) + t1;
+    }
+}
+
+#if SDL_ROTATE_X86
+/* !
+\brief a + ((b - a) * w >> 16) in 16 bit lanes, as _smoothPixel() works it out.
+
+pmulhw takes weights of 0x8000 and over as negative, 0x10000 less; adding
+(b - a) once more for those puts the product right.
+*/
+__attribute__((target("sse2"))) static SDL_INLINE __m128i
+_lerpSSE2(__m128i a, __m128i b, __m128i w)
+{
+    const __m128i d = _mm_sub_epi16(b, a);
+
+    return _mm_add_epi16(_mm_add_epi16(a, _mm_mulhi_epi16(d, w)),
+                         _mm_and_si128(d, _mm_srai_epi16(w, 15)));
+}
+
+/* !
+\brief The source pixels around a position of the SSE2 rotozoomer.
+
+Returns the two pixels left & right of it (flipped as _smoothPixel() swaps
+them) in the low 64 bits of *top and *bottom.
+*/
+__attribute__((target("sse2"))) static SDL_INLINE void
+_smoothSourceSSE2(const SDL_Surface * src, int dx, int dy, int flipx, int flipy, __m128i *top, __m128i *bottom)
+{
+    const Uint8 *sp = (const Uint8 *) src->pixels + src->pitch * dy + dx * 4;
+    __m128i t = _mm_loadl_epi64((const __m128i *) sp);
+    __m128i b = _mm_loadl_epi64((const __m128i *) (sp + src->pitch));
+
+    if (flipx) {
+        t = _mm_shuffle_epi32(t, _MM_SHUFFLE(3, 2, 0, 1));
+        b = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 2, 0, 1));
+    }
+    if (flipy) {
+        *top = b;
+        *bottom = t;
+    } else {
+        *top = t;
+        *bottom = b;
+    }
+}
+
+/* !
+\brief A row of the anti-aliased 32 bit rotozoomer, four pixels at a time.
+
+Groups of pixels which aren't all within the source, and the last few, are
+done by _smoothPixel().
+*/
+__attribute__((target("sse2"))) static void
+_smoothRowSSE2(const SDL_Surface * src, tColorRGBA * pc, int w, int sdx, int sdy, int icos, int isin, int flipx, int flipy)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i minus_one = _mm_set1_epi32(-1);
+    const __m128i low = _mm_set1_epi32(0xffff);
+    const __m128i sw = _mm_set1_epi32(src->w - 1);
+    const __m128i sh = _mm_set1_epi32(src->h - 1);
+    const __m128i stepx = _mm_set1_epi32(icos * 4);
+    const __m128i stepy = _mm_set1_epi32(isin * 4);
+    __m128i vx = _mm_add_epi32(_mm_set1_epi32(sdx), _mm_setr_epi32(0, icos, icos * 2, icos * 3));
+    __m128i vy = _mm_add_epi32(_mm_set1_epi32(sdy), _mm_setr_epi32(0, isin, isin * 2, isin * 3));
+    int x = 0;
+
+    for (; x + 4 <= w; x += 4) {
+        __m128i dx = _mm_srai_epi32(vx, 16);
+        __m128i dy = _mm_srai_epi32(vy, 16);
+        __m128i inside;
+
+        if (flipx) dx = _mm_sub_epi32(sw, dx);
+        if (flipy) dy = _mm_sub_epi32(sh, dy);
+        inside = _mm_and_si128(
+            _mm_and_si128(_mm_cmpgt_epi32(dx, minus_one), _mm_cmpgt_epi32(sw, dx)),
+            _mm_and_si128(_mm_cmpgt_epi32(dy, minus_one), _mm_cmpgt_epi32(sh, dy)));
+
+        if (_mm_movemask_epi8(inside) != 0xffff) {
+            int i;
+            for (i = 0; i < 4; ++i) {
+                _smoothPixel(src, pc + i, sdx + icos * (x + i), sdy + isin * (x + i), flipx, flipy);
+            }
+        } else {
+            /* Each pixel's weights in the four 16 bit lanes of its channels */
+            const __m128i ex = _mm_and_si128(vx, low);
+            const __m128i ey = _mm_and_si128(vy, low);
+            int cdx[4], cdy[4], i;
+            __m128i top[4], bottom[4], out[2];
+
+            _mm_storeu_si128((__m128i *) cdx, dx);
+            _mm_storeu_si128((__m128i *) cdy, dy);
+            for (i = 0; i < 4; ++i) {
+                _smoothSourceSSE2(src, cdx[i], cdy[i], flipx, flipy, &top[i], &bottom[i]);
+            }
+            for (i = 0; i < 2; ++i) {
+                const __m128i wx = i ? _mm_unpackhi_epi32(ex, ex) : _mm_unpacklo_epi32(ex, ex);
+                const __m128i wy = i ? _mm_unpackhi_epi32(ey, ey) : _mm_unpacklo_epi32(ey, ey);
+                const __m128i ewx = _mm_shufflehi_epi16(_mm_shufflelo_epi16(wx, 0), 0);
+                const __m128i ewy = _mm_shufflehi_epi16(_mm_shufflelo_epi16(wy, 0), 0);
+                /* Left & right pixels of the pair, each in 16 bit lanes */
+                const __m128i t = _mm_unpacklo_epi32(top[2 * i], top[2 * i + 1]);
+                const __m128i b = _mm_unpacklo_epi32(bottom[2 * i], bottom[2 * i + 1]);
+                const __m128i t1 = _lerpSSE2(_mm_unpacklo_epi8(t, zero), _mm_unpackhi_epi8(t, zero), ewx);
+                const __m128i t2 = _lerpSSE2(_mm_unpacklo_epi8(b, zero), _mm_unpackhi_epi8(b, zero), ewx);
+
+                out[i] = _lerpSSE2(t1, t2, ewy);
+            }
+            _mm_storeu_si128((__m128i *) pc, _mm_packus_epi16(out[0], out[1]));
+        }
+        vx = _mm_add_epi32(vx, stepx);
+        vy = _mm_add_epi32(vy, stepy);
+        pc += 4;
+    }
+    sdx += icos * x;
+    sdy += isin * x;
+    for (; x < w; x++) {
+        _smoothPixel(src, pc, sdx, sdy, flipx, flipy);
+        sdx += icos;
+        sdy += isin;
+        pc++;
+    }
+}
+
+/* !
+\brief The non anti-aliased 32 bit rotozoomer, eight pixels at a time.
+
+Gathers the pixels within the source and stores only those.  Returns how
+many of the row's pixels it did, leaving the last few.
+*/
+__attribute__((target("avx2"))) static int
+_nearestRowAVX2(const SDL_Surface * src, tColorRGBA * pc, int w, int sdx, int sdy, int icos, int isin, int flipx, int flipy)
+{
+    const __m256i steps = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i minus_one = _mm256_set1_epi32(-1);
+    const __m256i srcw = _mm256_set1_epi32(src->w);
+    const __m256i srch = _mm256_set1_epi32(src->h);
+    const __m256i sw = _mm256_set1_epi32(src->w - 1);
+    const __m256i sh = _mm256_set1_epi32(src->h - 1);
+    const __m256i pitch = _mm256_set1_epi32(src->pitch);
+    const __m256i stepx = _mm256_set1_epi32(icos * 8);
+    const __m256i stepy = _mm256_set1_epi32(isin * 8);
+    __m256i vx = _mm256_add_epi32(_mm256_set1_epi32(sdx), _mm256_mullo_epi32(steps, _mm256_set1_epi32(icos)));
+    __m256i vy = _mm256_add_epi32(_mm256_set1_epi32(sdy), _mm256_mullo_epi32(steps, _mm256_set1_epi32(isin)));
+    int x = 0;
+
+    for (; x + 8 <= w; x += 8) {
+        __m256i dx = _mm256_srai_epi32(vx, 16);
+        __m256i dy = _mm256_srai_epi32(vy, 16);
+        const __m256i inside = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi32(dx, minus_one), _mm256_cmpgt_epi32(srcw, dx)),
+            _mm256_and_si256(_mm256_cmpgt_epi32(dy, minus_one), _mm256_cmpgt_epi32(srch, dy)));
+
+        if (!_mm256_testz_si256(inside, inside)) {
+            __m256i offsets, pixels;
+
+            if (flipx) dx = _mm256_sub_epi32(sw, dx);
+            if (flipy) dy = _mm256_sub_epi32(sh, dy);
+            offsets = _mm256_add_epi32(_mm256_mullo_epi32(dy, pitch), _mm256_slli_epi32(dx, 2));
+            pixels = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int *) src->pixels,
+                                                 offsets, inside, 1);
+            _mm256_maskstore_epi32((int *) pc, inside, pixels);
+        }
+        vx = _mm256_add_epi32(vx, stepx);
+        vy = _mm256_add_epi32(vy, stepy);
+        pc += 8;
+    }
+    return x;
+}
+#endif /* SDL_ROTATE_X86 */
+
 /* !
 \brief Internal 32 bit rotozoomer with optional anti-aliasing.
 
@@ -158,10 +389,10 @@ Assumes dst surface was allocated with the correct dimensions.
 static void
 _transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy, int isin, int icos, int flipx, int flipy, int smooth)
 {
-    int x, y, t1, t2, dx, dy, xd, yd, sdx, sdy, ax, ay, ex, ey, sw, sh;
-    tColorRGBA c00, c01, c10, c11, cswap;
-    tColorRGBA *pc, *sp;
+    int x, y, dx, dy, xd, yd, sdx, sdy, ax, ay, sw, sh;
+    tColorRGBA *pc;
     int gap;
+    const Uint32 simd = SDL_GetBlitCPUFeatures();
 
     /*
     * Variable setup
@@ -183,46 +414,15 @@ _transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy, int
             dy = cy - y;
             sdx = (ax + (isin * dy)) + xd;
             sdy = (ay - (icos * dy)) + yd;
+#if SDL_ROTATE_X86
+            if (simd & SDL_CPU_SSE2) {
+                _smoothRowSSE2(src, pc, dst->w, sdx, sdy, icos, isin, flipx, flipy);
+                pc = (tColorRGBA *) ((Uint8 *) (pc + dst->w) + gap);
+                continue;
+            }
+#endif
             for (x = 0; x < dst->w; x++) {
-                dx = (sdx >> 16);
-                dy = (sdy >> 16);
-                if (flipx) dx = sw - dx;
-                if (flipy) dy = sh - dy;
-                if ((unsigned)dx < (unsigned)sw && (unsigned)dy < (unsigned)sh) {
-                    sp = (tColorRGBA *) ((Uint8 *) src->pixels + src->pitch * dy) + dx;
-                    c00 = *sp;
-                    sp += 1;
-                    c01 = *sp;
-                    sp += (src->pitch/4);
-                    c11 = *sp;
-                    sp -= 1;
-                    c10 = *sp;
-                    if (flipx) {
-                        cswap = c00; c00=c01; c01=cswap;
-                        cswap = c10; c10=c11; c11=cswap;
-                    }
-                    if (flipy) {
-                        cswap = c00; c00=c10; c10=cswap;
-                        cswap = c01; c01=c11; c11=cswap;
-                    }
-                    /*
-                    * Interpolate colors
-                    */
-                    ex = (sdx & 0xffff);
-                    ey = (sdy & 0xffff);
-                    t1 = ((((c01.r - c00.r) * ex) >> 16) + c00.r) & 0xff;
-                    t2 = ((((c11.r - c10.r) * ex) >> 16) + c10.r) & 0xff;
-                    pc->r = (((t2 - t1) * ey) >> 16) + t1;
-                    t1 = ((((c01.g - c00.g) * ex) >> 16) + c00.g) & 0xff;
-                    t2 = ((((c11.g - c10.g) * ex) >> 16) + c10.g) & 0xff;
-                    pc->g = (((t2 - t1) * ey) >> 16) + t1;
-                    t1 = ((((c01.b - c00.b) * ex) >> 16) + c00.b) & 0xff;
-                    t2 = ((((c11.b - c10.b) * ex) >> 16) + c10.b) & 0xff;
-                    pc->b = (((t2 - t1) * ey) >> 16) + t1;
-                    t1 = ((((c01.a - c00.a) * ex) >> 16) + c00.a) & 0xff;
-                    t2 = ((((c11.a - c10.a) * ex) >> 16) + c10.a) & 0xff;
-                    pc->a = (((t2 - t1) * ey) >> 16) + t1;
-                }
+                _smoothPixel(src, pc, sdx, sdy, flipx, flipy);
                 sdx += icos;
                 sdy += isin;
                 pc++;
@@ -234,7 +434,16 @@ _transformSurfaceRGBA(SDL_Surface * src, SDL_Surface * dst, int cx, int cy, int
             dy = cy - y;
             sdx = (ax + (isin * dy)) + xd;
             sdy = (ay - (icos * dy)) + yd;
-            for (x = 0; x < dst->w; x++) {
+            x = 0;
+#if SDL_ROTATE_X86
+            if (simd & SDL_CPU_AVX2) {
+                x = _nearestRowAVX2(src, pc, dst->w, sdx, sdy, icos, isin, flipx, flipy);
+                sdx += icos * x;
+                sdy += isin * x;
+                pc += x;
+            }
+#endif
+            for (; x < dst->w; x++) {
                 dx = (sdx >> 16);
                 dy = (sdy >> 16);
                 if ((unsigned)dx < (unsigned)src->w && (unsigned)dy < (unsigned)src->h) {
@@ -399,10 +608,13 @@ SDLgfx_rotateSurface(SDL_Surface * src, double angle, int centerx, int centery,
         /*
         * Target surface is 32bit with source RGBA/ABGR ordering
         */
-        rz_dst =
-            SDL_CreateRGBSurface(SDL_SWSURFACE, dstwidth, dstheight + GUARD_ROWS, 32,
-            rz_src->format->Rmask, rz_src->format->Gmask,
-            rz_src->format->Bmask, rz_src->format->Amask);
+        rz_dst = SDL_AcquireSurface(dstwidth, dstheight + GUARD_ROWS,
+                                    rz_src->format->format);
+        /* Pooled pixels aren't cleared, and what's outside the source is
+           left as it was */
+        if (rz_dst != NULL && colorKeyAvailable == 0) {
+            SDL_memset(rz_dst->pixels, 0, rz_dst->pitch * rz_dst->h);
+        }
     } else {
         /*
         * Target surface is 8bit
@@ -454,6 +666,9 @@ SDLgfx_rotateSurface(SDL_Surface * src, double angle, int centerx, int centery,
             rz_dst->format->palette->colors[i] = rz_src->format->palette->colors[i];
         }
         rz_dst->format->palette->ncolors = rz_src->format->palette->ncolors;
+        if (!++rz_dst->format->palette->version) {
+            rz_dst->format->palette->version = 1;
+        }
         /*
         * Call the 8bit transformation routine to do the rotation
         */
@@ -30,6 +30,266 @@
 #include "SDL_stdinc.h"
 #include "SDL_endian.h"
 
+/* UTF-8 validation, by the lookup tables of Keiser & Lemire's "Validating
+   UTF-8 In Less Than One Instruction Per Byte": 16 bytes at a time, the high
+   & low nibbles of each byte's predecessor & its own high nibble each look
+   up the errors they could be part of, a bit per kind, & the pair is wrong
+   where all three agree.  Third & fourth bytes are checked by whether the
+   byte 2 or 3 before is a lead that long.  Blocks of ASCII are skipped.
+   With SSSE3 (checked as SSE4.1) or NEON, the C loop otherwise. */
+#if defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SDL_UTF8_X86 1
+#include <immintrin.h>
+#include "SDL_cpuinfo.h"
+#elif defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    defined(__aarch64__)
+#define SDL_UTF8_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if SDL_UTF8_X86 || SDL_UTF8_NEON
+#define UTF8_TOO_SHORT      0x01    /* A lead, then no continuation */
+#define UTF8_TOO_LONG       0x02    /* ASCII, then a continuation */
+#define UTF8_OVERLONG_3     0x04
+#define UTF8_TOO_LARGE      0x08    /* Past U+10FFFF */
+#define UTF8_SURROGATE      0x10
+#define UTF8_OVERLONG_2     0x20
+#define UTF8_TOO_LARGE_1000 0x40
+#define UTF8_OVERLONG_4     0x40
+#define UTF8_TWO_CONTS      0x80    /* Unless it's a third or fourth byte */
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+static const Uint8 utf8_byte_1_high[16] = {
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+};
+
+static const Uint8 utf8_byte_1_low[16] = {
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY,
+    UTF8_CARRY,
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+};
+
+static const Uint8 utf8_byte_2_high[16] = {
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+        UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+        UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |
+        UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |
+        UTF8_TOO_LARGE,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+
+/* Each byte over this is a lead its block ends too soon after */
+static const Uint8 utf8_incomplete[16] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+};
+#endif
+
+#ifdef SDL_UTF8_X86
+__attribute__((target("ssse3"))) static SDL_bool
+SDL_utf8_validate_ssse3(const Uint8 *p, size_t len)
+{
+    const __m128i byte_1_high =
+        _mm_loadu_si128((const __m128i *) utf8_byte_1_high);
+    const __m128i byte_1_low =
+        _mm_loadu_si128((const __m128i *) utf8_byte_1_low);
+    const __m128i byte_2_high =
+        _mm_loadu_si128((const __m128i *) utf8_byte_2_high);
+    const __m128i incomplete =
+        _mm_loadu_si128((const __m128i *) utf8_incomplete);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i prev = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    __m128i pending = _mm_setzero_si128();
+    SDL_bool last = SDL_FALSE;
+
+    while (!last) {
+        __m128i input;
+
+        if (len >= 16) {
+            input = _mm_loadu_si128((const __m128i *) p);
+            p += 16;
+            len -= 16;
+        } else {
+            /* The rest & NULs after, ASCII to end what's pending */
+            Uint8 tail[16];
+            SDL_memset(tail, 0, sizeof (tail));
+            SDL_memcpy(tail, p, len);
+            input = _mm_loadu_si128((const __m128i *) tail);
+            last = SDL_TRUE;
+        }
+        if (_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, pending);
+            pending = _mm_setzero_si128();
+        } else {
+            __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+            __m128i prev2 = _mm_alignr_epi8(input, prev, 14);
+            __m128i prev3 = _mm_alignr_epi8(input, prev, 13);
+            __m128i special = _mm_and_si128(_mm_and_si128(
+                _mm_shuffle_epi8(byte_1_high,
+                    _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+                _mm_shuffle_epi8(byte_2_high,
+                    _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+            __m128i must23 = _mm_and_si128(_mm_or_si128(
+                _mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80)),
+                _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80))),
+                _mm_set1_epi8((char) 0x80));
+
+            error = _mm_or_si128(error, _mm_xor_si128(must23, special));
+            pending = _mm_subs_epu8(input, incomplete);
+        }
+        prev = input;
+    }
+    error = _mm_or_si128(error, pending);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) ==
+           0xFFFF ? SDL_TRUE : SDL_FALSE;
+}
+#endif
+
+#ifdef SDL_UTF8_NEON
+static SDL_bool
+SDL_utf8_validate_neon(const Uint8 *p, size_t len)
+{
+    const uint8x16_t byte_1_high = vld1q_u8(utf8_byte_1_high);
+    const uint8x16_t byte_1_low = vld1q_u8(utf8_byte_1_low);
+    const uint8x16_t byte_2_high = vld1q_u8(utf8_byte_2_high);
+    const uint8x16_t incomplete = vld1q_u8(utf8_incomplete);
+    uint8x16_t prev = vdupq_n_u8(0);
+    uint8x16_t error = vdupq_n_u8(0);
+    uint8x16_t pending = vdupq_n_u8(0);
+    SDL_bool last = SDL_FALSE;
+
+    while (!last) {
+        uint8x16_t input;
+
+        if (len >= 16) {
+            input = vld1q_u8(p);
+            p += 16;
+            len -= 16;
+        } else {
+            Uint8 tail[16];
+            SDL_memset(tail, 0, sizeof (tail));
+            SDL_memcpy(tail, p, len);
+            input = vld1q_u8(tail);
+            last = SDL_TRUE;
+        }
+        if (vmaxvq_u8(input) < 0x80) {
+            error = vorrq_u8(error, pending);
+            pending = vdupq_n_u8(0);
+        } else {
+            uint8x16_t prev1 = vextq_u8(prev, input, 15);
+            uint8x16_t prev2 = vextq_u8(prev, input, 14);
+            uint8x16_t prev3 = vextq_u8(prev, input, 13);
+            uint8x16_t special = vandq_u8(vandq_u8(
+                vqtbl1q_u8(byte_1_high, vshrq_n_u8(prev1, 4)),
+                vqtbl1q_u8(byte_1_low, vandq_u8(prev1, vdupq_n_u8(0x0F)))),
+                vqtbl1q_u8(byte_2_high, vshrq_n_u8(input, 4)));
+            uint8x16_t must23 = vandq_u8(vorrq_u8(
+                vqsubq_u8(prev2, vdupq_n_u8(0xE0 - 0x80)),
+                vqsubq_u8(prev3, vdupq_n_u8(0xF0 - 0x80))),
+                vdupq_n_u8(0x80));
+
+            error = vorrq_u8(error, veorq_u8(must23, special));
+            pending = vqsubq_u8(input, incomplete);
+        }
+        prev = input;
+    }
+    return vmaxvq_u8(vorrq_u8(error, pending)) == 0 ? SDL_TRUE : SDL_FALSE;
+}
+#endif
+
+/* A code point at a time, ASCII a word at a time */
+static SDL_bool
+SDL_utf8_validate_c(const Uint8 *p, size_t len)
+{
+    const Uint8 *end = p + len;
+
+    while (p < end) {
+        Uint8 c = *p;
+
+        if (c < 0x80) {
+            Uint64 word;
+            if (end - p >= 8) {
+                SDL_memcpy(&word, p, 8);
+                if ((word & 0x8080808080808080ULL) == 0) {
+                    p += 8;
+                    continue;
+                }
+            }
+            ++p;
+        } else if (c >= 0xC2 && c <= 0xDF) {
+            if (end - p < 2 || (p[1] & 0xC0) != 0x80) {
+                return SDL_FALSE;
+            }
+            p += 2;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            if (end - p < 3 || (p[1] & 0xC0) != 0x80 ||
+                (p[2] & 0xC0) != 0x80) {
+                return SDL_FALSE;
+            }
+            if ((c == 0xE0 && p[1] < 0xA0) || (c == 0xED && p[1] > 0x9F)) {
+                return SDL_FALSE;   /* Overlong or a surrogate */
+            }
+            p += 3;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            if (end - p < 4 || (p[1] & 0xC0) != 0x80 ||
+                (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80) {
+                return SDL_FALSE;
+            }
+            if ((c == 0xF0 && p[1] < 0x90) || (c == 0xF4 && p[1] > 0x8F)) {
+                return SDL_FALSE;   /* Overlong or past U+10FFFF */
+            }
+            p += 4;
+        } else {
+            return SDL_FALSE;
+        }
+    }
+    return SDL_TRUE;
+}
+
+SDL_bool
+SDL_utf8_validate(const char *buf, size_t len)
+{
+    const Uint8 *p = (const Uint8 *) buf;
+
+#ifdef SDL_UTF8_X86
+    if (len >= 16 && SDL_HasSSE41()) {
+        return SDL_utf8_validate_ssse3(p, len);
+    }
+#elif defined(SDL_UTF8_NEON)
+    if (len >= 16) {
+        return SDL_utf8_validate_neon(p, len);
+    }
+#endif
+    return SDL_utf8_validate_c(p, len);
+}
+
 #ifdef HAVE_ICONV
 
 /* Depending on which standard the iconv() was implemented with,
@@ -242,6 +502,131 @@ SDL_iconv_open(const char *tocode, const char *fromcode)
     return (SDL_iconv_t) - 1;
 }
 
+/* Bytes per unit of an encoding runs of ASCII can be copied between as
+   blocks: the 8 bit ones & UTF-16/32 (or UCS-2/4) in host order, 0 else */
+static size_t
+SDL_iconv_unit(int fmt)
+{
+    switch (fmt) {
+    case ENCODING_ASCII:
+    case ENCODING_LATIN1:
+    case ENCODING_UTF8:
+        return 1;
+    case ENCODING_UTF16NATIVE:
+    case ENCODING_UCS2NATIVE:
+        return 2;
+    case ENCODING_UTF32NATIVE:
+    case ENCODING_UCS4NATIVE:
+        return 4;
+    }
+    return 0;
+}
+
+/* How many of the n units at src are ASCII, bytes 16 at a time with SSE2 &
+   8 otherwise */
+static size_t
+SDL_iconv_ascii_run(const Uint8 *src, size_t unit, size_t n)
+{
+    size_t i = 0;
+
+    if (unit == 1) {
+#if defined(SDL_UTF8_X86) && defined(__SSE2__)
+        for (; i + 16 <= n; i += 16) {
+            int mask = _mm_movemask_epi8(
+                _mm_loadu_si128((const __m128i *) (src + i)));
+            if (mask) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+#endif
+        for (; i + 8 <= n; i += 8) {
+            Uint64 word;
+            SDL_memcpy(&word, src + i, 8);
+            if (word & 0x8080808080808080ULL) {
+                break;
+            }
+        }
+        while (i < n && src[i] < 0x80) {
+            ++i;
+        }
+    } else {
+        /* Host order, so where the low byte is */
+        size_t low = (SDL_BYTEORDER == SDL_LIL_ENDIAN) ? 0 : unit - 1;
+        size_t j;
+
+        for (; i < n; ++i) {
+            const Uint8 *c = src + i * unit;
+            if (c[low] >= 0x80) {
+                return i;
+            }
+            for (j = 0; j < unit; ++j) {
+                if (j != low && c[j]) {
+                    return i;
+                }
+            }
+        }
+    }
+    return i;
+}
+
+/* n ASCII characters from units of sunit bytes to ones of dunit, each one's
+   low byte & zeros */
+SDL_FORCE_INLINE void
+SDL_iconv_ascii_copy(const Uint8 *src, size_t sunit, Uint8 *dst,
+                     size_t dunit, size_t n)
+{
+    size_t slow = (SDL_BYTEORDER == SDL_LIL_ENDIAN) ? 0 : sunit - 1;
+    size_t dlow = (SDL_BYTEORDER == SDL_LIL_ENDIAN) ? 0 : dunit - 1;
+    size_t i, j;
+
+    for (i = 0; i < n; ++i) {
+        for (j = 0; j < dunit; ++j) {
+            dst[i * dunit + j] = 0;
+        }
+        dst[i * dunit + dlow] = src[i * sunit + slow];
+    }
+}
+
+/* The run of ASCII at the start of the input converted as a block, where
+   both encodings allow it, the pointers & lengths past it.  Returns the
+   characters it was. */
+static size_t
+SDL_iconv_ascii(SDL_iconv_t cd, const char **src, size_t *srclen,
+                char **dst, size_t *dstlen)
+{
+    size_t sunit = SDL_iconv_unit(cd->src_fmt);
+    size_t dunit = SDL_iconv_unit(cd->dst_fmt);
+    const Uint8 *s = (const Uint8 *) *src;
+    Uint8 *d = (Uint8 *) *dst;
+    size_t n;
+
+    if (sunit == 0 || dunit == 0) {
+        return 0;
+    }
+    n = SDL_min(*srclen / sunit, *dstlen / dunit);
+    n = SDL_iconv_ascii_run(s, sunit, n);
+    if (sunit == dunit) {
+        SDL_memcpy(d, s, n * sunit);
+    } else if (sunit == 1 && dunit == 2) {
+        SDL_iconv_ascii_copy(s, 1, d, 2, n);
+    } else if (sunit == 1 && dunit == 4) {
+        SDL_iconv_ascii_copy(s, 1, d, 4, n);
+    } else if (sunit == 2 && dunit == 1) {
+        SDL_iconv_ascii_copy(s, 2, d, 1, n);
+    } else if (sunit == 2 && dunit == 4) {
+        SDL_iconv_ascii_copy(s, 2, d, 4, n);
+    } else if (sunit == 4 && dunit == 1) {
+        SDL_iconv_ascii_copy(s, 4, d, 1, n);
+    } else {
+        SDL_iconv_ascii_copy(s, 4, d, 2, n);
+    }
+    *src += n * sunit;
+    *srclen -= n * sunit;
+    *dst += n * dunit;
+    *dstlen -= n * dunit;
+    return n;
+}
+
 size_t
 SDL_iconv(SDL_iconv_t cd,
           const char **inbuf, size_t * inbytesleft,
@@ -340,6 +725,19 @@ SDL_iconv(SDL_iconv_t cd,
 
     total = 0;
     while (srclen > 0) {
+        /* ASCII first, as a block */
+        size_t run = SDL_iconv_ascii(cd, &src, &srclen, &dst, &dstlen);
+        if (run) {
+            *inbuf = src;
+            *inbytesleft = srclen;
+            *outbuf = dst;
+            *outbytesleft = dstlen;
+            total += run;
+            if (srclen == 0) {
+                break;
+            }
+        }
+
         /* Decode a character */
         switch (cd->src_fmt) {
         case ENCODING_ASCII:
@@ -28,8 +28,22 @@
 /* This file contains portable memory management functions for SDL */
 
 #include "SDL_stdinc.h"
+#include "../thread/SDL_thread_c.h"
+
+/* Each thread allocates from a heap of its own where SDL implements malloc
+   and the compiler has thread local variables, see SDL_ThreadHeap below.
+   Building with SDL_THREAD_HEAPS defined to 1 does so instead of using the C
+   library's malloc. */
+#if (!defined(HAVE_MALLOC) || SDL_THREAD_HEAPS) && \
+    defined(SDL_THREAD_LOCAL) && !SDL_THREADS_DISABLED
+#define SDL_MALLOC_THREAD_HEAPS 1
+#endif
+
+#if defined(HAVE_MALLOC) && !SDL_THREAD_HEAPS
 
-#if defined(HAVE_MALLOC)
+#ifdef __GLIBC__
+#include <malloc.h>             /* mallinfo2() */
+#endif
 
 void *SDL_malloc(size_t size)
 {
@@ -51,6 +65,21 @@ void SDL_free(void *ptr)
     free(ptr);
 }
 
+/* glibc adds up all its arenas, but doesn't keep a peak */
+void
+SDL_GetMemoryStats(SDL_MemoryStats *stats)
+{
+    SDL_zerop(stats);
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    {
+        struct mallinfo2 info = mallinfo2();
+        stats->used = info.uordblks + info.hblkhd;
+        stats->held = info.arena + info.hblkhd;
+    }
+#endif
+}
+
 #else  /* the rest of this is a LOT of tapdancing to implement malloc. :) */
 
 #define LACKS_SYS_TYPES_H
@@ -60,6 +89,16 @@ void SDL_free(void *ptr)
 #define LACKS_STDLIB_H
 #define ABORT
 #define USE_LOCKS 1
+#if SDL_MALLOC_THREAD_HEAPS
+/* The heaps are mspaces, each chunk tagged with its own, and dlmalloc's
+   global space is only there in case one can't be made */
+#define MSPACES 1
+#define FOOTERS 1
+#define USE_DL_PREFIX
+#ifdef HAVE_MALLOC
+#define HAVE_MORECORE 0         /* sbrk() is the C library malloc's */
+#endif
+#endif
 
 /*
   This is a version (aka dlmalloc) of malloc/free/realloc written by
@@ -2082,6 +2121,9 @@ struct malloc_state
     MLOCK_T mutex;              /* locate lock among fields that rarely change */
 #endif                          /* USE_LOCKS */
     msegment seg;
+#if SDL_MALLOC_THREAD_HEAPS
+    struct SDL_ThreadHeap *heap;    /* The thread heap it is, NULL if global */
+#endif
 };
 
 typedef struct malloc_state *mstate;
@@ -3217,7 +3259,7 @@ internal_malloc_stats(mstate m)
 #else /* ONLY_MSPACES */
 #if MSPACES
 #define internal_malloc(m, b)\
-   (m == gm)? dlmalloc(b) : mspace_malloc(m, b)
+   ((m == gm)? dlmalloc(b) : mspace_malloc(m, b))
 #define internal_free(m, mem)\
    if (m == gm) dlfree(mem); else mspace_free(m,mem);
 #else /* MSPACES */
@@ -4943,7 +4985,7 @@ mspace_malloc_stats(mspace msp)
 size_t
 mspace_footprint(mspace msp)
 {
-    size_t result;
+    size_t result = 0;
     mstate ms = (mstate) msp;
     if (ok_magic(ms)) {
         result = ms->footprint;
@@ -4956,7 +4998,7 @@ mspace_footprint(mspace msp)
 size_t
 mspace_max_footprint(mspace msp)
 {
-    size_t result;
+    size_t result = 0;
     mstate ms = (mstate) msp;
     if (ok_magic(ms)) {
         result = ms->max_footprint;
@@ -4986,6 +5028,426 @@ mspace_mallopt(int param_number, int value)
 
 #endif /* MSPACES */
 
+#if SDL_MALLOC_THREAD_HEAPS
+
+/* Per-thread heaps: each thread allocates from an mspace of its own, without
+   a lock, so threads don't contend for the allocator.  Freeing another
+   heap's chunk pushes it on that heap's remote list (lock free, linked
+   through the chunks), which its thread frees into its mspace the next time
+   it allocates.  An SDL thread leaves its heap for the next new thread to
+   adopt when it exits, so the memory is reused; the heap of a thread SDL
+   didn't create stays with it.
+
+   Small allocations (SDL_SLAB_MAX bytes at most) skip dlmalloc's bins: each
+   heap has a slab per size class, a chunk cut into equal slots, and they're
+   popped off its free list.  Like a dlmalloc chunk, a slot has a word before
+   it, the slot's slab with SDL_SLAB_TAG set, a bit always clear in a chunk's
+   head since sizes are multiples of 8.  A slab with free slots is on its
+   class's list, an empty one goes back to the mspace unless it's the last
+   one of its class. */
+
+#define SDL_SLAB_SIZE 16384
+#define SDL_SLAB_CLASSES 16         /* Slots of 16 bytes steps, tag included */
+#define SDL_SLAB_MAX (SDL_SLAB_CLASSES * 16 - sizeof(size_t))
+#define SDL_SLAB_TAG ((size_t) 4)
+
+typedef struct SDL_Slab
+{
+    struct SDL_ThreadHeap *heap;
+    struct SDL_Slab *next;          /* In the class's list, with free slots */
+    struct SDL_Slab *prev;
+    void *free;                     /* Free slots, reused first */
+    char *fresh;                    /* Slots never used, up to the end */
+    Uint32 stride;                  /* Bytes per slot */
+    Uint32 n_slots;
+    Uint32 n_live;
+} SDL_Slab;
+
+/* The first slot, aligned like dlmalloc's chunks once past its tag */
+#define SDL_SLAB_FIRST \
+    ((sizeof(SDL_Slab) + sizeof(size_t) + MALLOC_ALIGNMENT - 1) & \
+        ~(MALLOC_ALIGNMENT - 1))
+
+typedef struct SDL_ThreadHeap
+{
+    mspace space;
+    void *remote;                   /* Chunks freed by other threads */
+    struct SDL_ThreadHeap *next;    /* Abandoned heaps */
+    struct SDL_ThreadHeap *all;     /* Every heap, for SDL_GetSlabStats() */
+    SDL_Slab *slabs[SDL_SLAB_CLASSES];
+    SDL_atomic_t n_slabs;           /* Only the heap's thread stores these */
+    SDL_atomic_t n_live;
+    SDL_atomic64_t used;            /* Usable bytes allocated */
+    SDL_atomic64_t held;            /* The mspace's footprint */
+    SDL_atomic64_t peak;            /* And its highest */
+} SDL_ThreadHeap;
+
+static SDL_THREAD_LOCAL SDL_ThreadHeap *SDL_thread_heap;
+static SDL_ThreadHeap *SDL_abandoned_heaps;
+static SDL_ThreadHeap *SDL_all_heaps;
+static SDL_SpinLock SDL_heaps_lock;
+
+static SDL_INLINE void
+SDL_SlabCount(SDL_atomic_t *count, int n)
+{
+    SDL_AtomicStore(count, SDL_AtomicLoad(count, SDL_MEMORY_ORDER_RELAXED) + n,
+                    SDL_MEMORY_ORDER_RELAXED);
+}
+
+static SDL_INLINE SDL_Slab *
+SDL_SlabOf(void *mem)
+{
+    size_t tag = ((size_t *) mem)[-1];
+    return (tag & SDL_SLAB_TAG) ? (SDL_Slab *) (tag & ~SDL_SLAB_TAG) : NULL;
+}
+
+static SDL_INLINE size_t
+SDL_UsableSize(void *mem)
+{
+    SDL_Slab *slab = SDL_SlabOf(mem);
+    return slab ? slab->stride - sizeof(size_t) : dlmalloc_usable_size(mem);
+}
+
+/* Count size bytes more in use (or less) & publish the footprint if it
+   changed, for SDL_GetMemoryStats() */
+static SDL_INLINE void
+SDL_HeapCount(SDL_ThreadHeap *heap, Sint64 size)
+{
+    mstate ms = (mstate) heap->space;
+    SDL_AtomicStore64(&heap->used,
+                      SDL_AtomicLoad64(&heap->used, SDL_MEMORY_ORDER_RELAXED) +
+                      size, SDL_MEMORY_ORDER_RELAXED);
+    if ((Sint64) ms->footprint !=
+        SDL_AtomicLoad64(&heap->held, SDL_MEMORY_ORDER_RELAXED)) {
+        SDL_AtomicStore64(&heap->held, (Sint64) ms->footprint,
+                          SDL_MEMORY_ORDER_RELAXED);
+        SDL_AtomicStore64(&heap->peak, (Sint64) ms->max_footprint,
+                          SDL_MEMORY_ORDER_RELAXED);
+    }
+}
+
+static void
+SDL_SlabLink(SDL_ThreadHeap *heap, SDL_Slab *slab)
+{
+    SDL_Slab **list = &heap->slabs[slab->stride / 16 - 1];
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list) {
+        (*list)->prev = slab;
+    }
+    *list = slab;
+}
+
+static void
+SDL_SlabUnlink(SDL_ThreadHeap *heap, SDL_Slab *slab)
+{
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        heap->slabs[slab->stride / 16 - 1] = slab->next;
+    }
+}
+
+/* A slot for size bytes, NULL if dlmalloc should allocate it */
+static void *
+SDL_SlabAlloc(SDL_ThreadHeap *heap, size_t size)
+{
+    size_t n = (size + sizeof(size_t) + 15) / 16;
+    SDL_Slab *slab = heap->slabs[n - 1];
+    void *mem;
+
+    if (!slab) {
+        slab = (SDL_Slab *) mspace_malloc(heap->space, SDL_SLAB_SIZE);
+        if (!slab) {
+            return NULL;
+        }
+        slab->heap = heap;
+        slab->free = NULL;
+        slab->fresh = (char *) slab + SDL_SLAB_FIRST;
+        slab->stride = (Uint32) (n * 16);
+        slab->n_slots = (Uint32) ((SDL_SLAB_SIZE - SDL_SLAB_FIRST +
+                                   sizeof(size_t)) / slab->stride);
+        slab->n_live = 0;
+        SDL_SlabLink(heap, slab);
+        SDL_SlabCount(&heap->n_slabs, 1);
+    }
+    if (slab->free) {
+        mem = slab->free;
+        slab->free = *(void **) mem;
+    } else {
+        mem = slab->fresh;
+        slab->fresh += slab->stride;
+        ((size_t *) mem)[-1] = (size_t) slab | SDL_SLAB_TAG;
+    }
+    if (++slab->n_live == slab->n_slots) {
+        SDL_SlabUnlink(heap, slab);
+    }
+    SDL_SlabCount(&heap->n_live, 1);
+    return mem;
+}
+
+static void
+SDL_SlabFree(SDL_ThreadHeap *heap, SDL_Slab *slab, void *mem)
+{
+    *(void **) mem = slab->free;
+    slab->free = mem;
+    SDL_SlabCount(&heap->n_live, -1);
+    if (slab->n_live-- == slab->n_slots) {
+        SDL_SlabLink(heap, slab);
+    } else if (slab->n_live == 0 && (slab->prev || slab->next)) {
+        SDL_SlabUnlink(heap, slab);
+        SDL_SlabCount(&heap->n_slabs, -1);
+        mspace_free(heap->space, slab);
+    }
+}
+
+/* Free mem, from the calling thread's heap */
+static void
+SDL_ThreadHeapFree(SDL_ThreadHeap *heap, void *mem)
+{
+    SDL_Slab *slab = SDL_SlabOf(mem);
+    Sint64 size = (Sint64) SDL_UsableSize(mem);
+    if (slab) {
+        SDL_SlabFree(heap, slab, mem);
+    } else {
+        mspace_free(heap->space, mem);
+    }
+    SDL_HeapCount(heap, -size);
+}
+
+static void
+SDL_DrainThreadHeap(SDL_ThreadHeap *heap)
+{
+    void *mem = SDL_AtomicExchangePtr(&heap->remote, NULL,
+                                      SDL_MEMORY_ORDER_ACQUIRE);
+    while (mem) {
+        void *next = *(void **) mem;
+        SDL_ThreadHeapFree(heap, mem);
+        mem = next;
+    }
+}
+
+/* The calling thread's heap, NULL if there's no memory for one */
+static SDL_ThreadHeap *
+SDL_GetThreadHeap(void)
+{
+    SDL_ThreadHeap *heap = SDL_thread_heap;
+
+    if (heap) {
+        if (SDL_AtomicLoadPtr(&heap->remote, SDL_MEMORY_ORDER_RELAXED)) {
+            SDL_DrainThreadHeap(heap);
+        }
+        return heap;
+    }
+    SDL_AtomicLock(&SDL_heaps_lock);
+    heap = SDL_abandoned_heaps;
+    if (heap) {
+        SDL_abandoned_heaps = heap->next;
+    }
+    SDL_AtomicUnlock(&SDL_heaps_lock);
+    if (!heap) {
+        mspace space = create_mspace(0, 0);
+        if (!space) {
+            return NULL;
+        }
+        heap = (SDL_ThreadHeap *) mspace_calloc(space, 1, sizeof(*heap));
+        if (!heap) {
+            destroy_mspace(space);
+            return NULL;
+        }
+        heap->space = space;
+        ((mstate) space)->heap = heap;
+        SDL_AtomicLock(&SDL_heaps_lock);
+        heap->all = SDL_all_heaps;
+        SDL_all_heaps = heap;
+        SDL_AtomicUnlock(&SDL_heaps_lock);
+    }
+    heap->next = NULL;
+    SDL_thread_heap = heap;
+    SDL_DrainThreadHeap(heap);
+    return heap;
+}
+
+/* Called by SDL_RunThread() once the thread's done */
+void
+SDL_ThreadHeapExit(void)
+{
+    SDL_ThreadHeap *heap = SDL_thread_heap;
+
+    if (heap) {
+        SDL_thread_heap = NULL;
+        SDL_AtomicLock(&SDL_heaps_lock);
+        heap->next = SDL_abandoned_heaps;
+        SDL_abandoned_heaps = heap;
+        SDL_AtomicUnlock(&SDL_heaps_lock);
+    }
+}
+
+/* The heap mem is from, by its slab or its chunk's footer.  From another
+   thread, the owner may clear the PINUSE bit of the chunk's head while it's
+   read here, but not the size, which is all that's used. */
+static SDL_INLINE SDL_ThreadHeap *
+SDL_ThreadHeapOf(void *mem)
+{
+    SDL_Slab *slab = SDL_SlabOf(mem);
+    return slab ? slab->heap : get_mstate_for(mem2chunk(mem))->heap;
+}
+
+void
+SDL_GetSlabStats(SDL_SlabStats *stats)
+{
+    SDL_ThreadHeap *heap;
+
+    SDL_zerop(stats);
+    SDL_AtomicLock(&SDL_heaps_lock);
+    for (heap = SDL_all_heaps; heap; heap = heap->all) {
+        int n_slabs = SDL_AtomicLoad(&heap->n_slabs, SDL_MEMORY_ORDER_RELAXED);
+        stats->slabs += (Uint32) n_slabs;
+        stats->live += (Uint32) SDL_AtomicLoad(&heap->n_live,
+                                               SDL_MEMORY_ORDER_RELAXED);
+        stats->bytes += (size_t) n_slabs * SDL_SLAB_SIZE;
+    }
+    SDL_AtomicUnlock(&SDL_heaps_lock);
+}
+
+void
+SDL_GetMemoryStats(SDL_MemoryStats *stats)
+{
+    SDL_ThreadHeap *heap;
+#if !NO_MALLINFO
+    struct mallinfo info = dlmallinfo();
+    stats->used = info.uordblks;
+#else
+    stats->used = 0;
+#endif
+    stats->held = dlmalloc_footprint();
+    stats->peak = dlmalloc_max_footprint();
+    SDL_AtomicLock(&SDL_heaps_lock);
+    for (heap = SDL_all_heaps; heap; heap = heap->all) {
+        stats->used += (size_t) SDL_AtomicLoad64(&heap->used,
+                                                 SDL_MEMORY_ORDER_RELAXED);
+        stats->held += (size_t) SDL_AtomicLoad64(&heap->held,
+                                                 SDL_MEMORY_ORDER_RELAXED);
+        stats->peak += (size_t) SDL_AtomicLoad64(&heap->peak,
+                                                 SDL_MEMORY_ORDER_RELAXED);
+    }
+    SDL_AtomicUnlock(&SDL_heaps_lock);
+}
+
+void *
+SDL_malloc(size_t size)
+{
+    SDL_ThreadHeap *heap = SDL_GetThreadHeap();
+    void *mem = NULL;
+
+    if (!heap) {
+        return dlmalloc(size);
+    }
+    if (size <= SDL_SLAB_MAX) {
+        mem = SDL_SlabAlloc(heap, size);
+    }
+    if (!mem) {
+        mem = mspace_malloc(heap->space, size);
+    }
+    if (mem) {
+        SDL_HeapCount(heap, (Sint64) SDL_UsableSize(mem));
+    }
+    return mem;
+}
+
+void *
+SDL_calloc(size_t nmemb, size_t size)
+{
+    SDL_ThreadHeap *heap = SDL_GetThreadHeap();
+    void *mem = NULL;
+
+    if (!heap) {
+        return dlcalloc(nmemb, size);
+    }
+    if (nmemb && size <= SDL_SLAB_MAX / nmemb) {
+        mem = SDL_SlabAlloc(heap, nmemb * size);
+        if (mem) {
+            SDL_memset(mem, 0, nmemb * size);
+        }
+    }
+    if (!mem) {
+        mem = mspace_calloc(heap->space, nmemb, size);
+    }
+    if (mem) {
+        SDL_HeapCount(heap, (Sint64) SDL_UsableSize(mem));
+    }
+    return mem;
+}
+
+void
+SDL_free(void *ptr)
+{
+    SDL_ThreadHeap *heap;
+
+    if (!ptr) {
+        return;
+    }
+    heap = SDL_ThreadHeapOf(ptr);
+    if (!heap) {
+        dlfree(ptr);
+    } else if (heap == SDL_thread_heap) {
+        SDL_ThreadHeapFree(heap, ptr);
+    } else {
+        void *head = SDL_AtomicLoadPtr(&heap->remote, SDL_MEMORY_ORDER_RELAXED);
+        do {
+            *(void **) ptr = head;
+        } while (!SDL_AtomicCompareExchangePtr(&heap->remote, &head, ptr,
+                                               SDL_MEMORY_ORDER_RELEASE));
+    }
+}
+
+void *
+SDL_realloc(void *ptr, size_t size)
+{
+    SDL_ThreadHeap *heap, *owner;
+    SDL_Slab *slab;
+    size_t used;
+    void *mem;
+
+    if (!ptr) {
+        return SDL_malloc(size);
+    }
+    slab = SDL_SlabOf(ptr);
+    if (slab) {
+        used = slab->stride - sizeof(size_t);
+        if (size <= used) {
+            return ptr;
+        }
+    } else {
+        heap = SDL_GetThreadHeap();
+        owner = SDL_ThreadHeapOf(ptr);
+        used = dlmalloc_usable_size(ptr);
+        if (owner == heap && size > SDL_SLAB_MAX) {
+            if (!heap) {
+                return dlrealloc(ptr, size);
+            }
+            mem = mspace_realloc(heap->space, ptr, size);
+            if (mem) {
+                SDL_HeapCount(heap, (Sint64) dlmalloc_usable_size(mem) -
+                              (Sint64) used);
+            }
+            return mem;
+        }
+    }
+    /* Moves to another slab or chunk, in this thread's heap */
+    mem = SDL_malloc(size);
+    if (mem) {
+        SDL_memcpy(mem, ptr, used < size ? used : size);
+        SDL_free(ptr);
+    }
+    return mem;
+}
+
+#endif /* SDL_MALLOC_THREAD_HEAPS */
+
 /* -------------------- Alternative MORECORE functions ------------------- */
 
 /*
@@ -5261,4 +5723,32 @@ History:
 
 #endif /* !HAVE_MALLOC */
 
+#if !SDL_MALLOC_THREAD_HEAPS
+void
+SDL_ThreadHeapExit(void)
+{
+}
+
+void
+SDL_GetSlabStats(SDL_SlabStats *stats)
+{
+    SDL_zerop(stats);
+}
+#endif
+
+#if !defined(HAVE_MALLOC) && !SDL_MALLOC_THREAD_HEAPS
+void
+SDL_GetMemoryStats(SDL_MemoryStats *stats)
+{
+#if !NO_MALLINFO
+    struct mallinfo info = dlmallinfo();
+    stats->used = info.uordblks;
+#else
+    stats->used = 0;
+#endif
+    stats->held = dlmalloc_footprint();
+    stats->peak = dlmalloc_max_footprint();
+}
+#endif
+
 /* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,342 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+/* Pattern-defeating quicksort (Orson Peters, 2021), included by SDL_qsort.c
+   once per kind of element.  Before each inclusion define:
+
+     SORT_NAME(x)           the functions' names
+     SORT_T                 what the element pointers point to
+     SORT_CTX               the type of the ctx argument every function takes
+     SORT_STEP              SORT_Ts per element
+     SORT_LESS(a, b)        whether the element at a goes before the one at b
+     SORT_SWAP(a, b)        exchanges two elements
+     SORT_INSERTION         below this many elements, insertion sort
+     SORT_HOLE              1 if elements can be held in a SORT_T variable
+
+   ctx is in scope for all of them.  The pivot stays at the front of its
+   range while it's partitioned, so nothing needs room for an element unless
+   SORT_HOLE says there's a variable for it.  Everything's #undef'd after. */
+
+#define SORT_AT(p, i) ((p) + (ptrdiff_t) (i) * (ptrdiff_t) (SORT_STEP))
+#define SORT_LEN(a, b) ((size_t) ((b) - (a)) / (size_t) (SORT_STEP))
+#define SORT_NINTHER 128        /* Pivots of more are a median of medians */
+#define SORT_PARTIAL_LIMIT 8    /* Moves an almost sorted range may need */
+
+/* Sorts [begin, end).  Unguarded, there's one at begin - 1 no later than any
+   of them, the scan back needn't check where it is. */
+static void
+SORT_NAME(insertion)(SORT_CTX ctx, SORT_T *begin, SORT_T *end,
+                     SDL_bool guarded)
+{
+    SORT_T *cur;
+
+    (void) ctx;
+    for (cur = SORT_AT(begin, 1); cur < end; cur = SORT_AT(cur, 1)) {
+        SORT_T *sift = cur;
+#if SORT_HOLE
+        SORT_T hole = *cur;
+
+        while ((!guarded || sift > begin) &&
+               SORT_LESS(&hole, SORT_AT(sift, -1))) {
+            *sift = *SORT_AT(sift, -1);
+            sift = SORT_AT(sift, -1);
+        }
+        *sift = hole;
+#else
+        while ((!guarded || sift > begin) &&
+               SORT_LESS(sift, SORT_AT(sift, -1))) {
+            SORT_SWAP(sift, SORT_AT(sift, -1));
+            sift = SORT_AT(sift, -1);
+        }
+#endif
+    }
+}
+
+/* Insertion sort, giving up past SORT_PARTIAL_LIMIT moves: SDL_TRUE if it
+   got [begin, end) sorted */
+static SDL_bool
+SORT_NAME(partial_insertion)(SORT_CTX ctx, SORT_T *begin, SORT_T *end)
+{
+    size_t moves = 0;
+    SORT_T *cur;
+
+    (void) ctx;
+    if (begin == end) {
+        return SDL_TRUE;
+    }
+    for (cur = SORT_AT(begin, 1); cur < end; cur = SORT_AT(cur, 1)) {
+        SORT_T *sift = cur;
+
+        while (sift > begin && SORT_LESS(sift, SORT_AT(sift, -1))) {
+            SORT_SWAP(sift, SORT_AT(sift, -1));
+            sift = SORT_AT(sift, -1);
+        }
+        moves += SORT_LEN(sift, cur);
+        if (moves > SORT_PARTIAL_LIMIT) {
+            return SDL_FALSE;
+        }
+    }
+    return SDL_TRUE;
+}
+
+static SDL_INLINE void
+SORT_NAME(sort2)(SORT_CTX ctx, SORT_T *a, SORT_T *b)
+{
+    (void) ctx;
+    if (SORT_LESS(b, a)) {
+        SORT_SWAP(a, b);
+    }
+}
+
+/* a <= b <= c after */
+static SDL_INLINE void
+SORT_NAME(sort3)(SORT_CTX ctx, SORT_T *a, SORT_T *b, SORT_T *c)
+{
+    SORT_NAME(sort2)(ctx, a, b);
+    SORT_NAME(sort2)(ctx, b, c);
+    SORT_NAME(sort2)(ctx, a, b);
+}
+
+static void
+SORT_NAME(sift_down)(SORT_CTX ctx, SORT_T *begin, size_t root, size_t n)
+{
+    (void) ctx;
+    for (;;) {
+        size_t child = 2 * root + 1;
+
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n &&
+            SORT_LESS(SORT_AT(begin, child), SORT_AT(begin, child + 1))) {
+            ++child;
+        }
+        if (!SORT_LESS(SORT_AT(begin, root), SORT_AT(begin, child))) {
+            break;
+        }
+        SORT_SWAP(SORT_AT(begin, root), SORT_AT(begin, child));
+        root = child;
+    }
+}
+
+/* What's left when too many partitions were bad, n log n whatever the
+   input */
+static void
+SORT_NAME(heapsort)(SORT_CTX ctx, SORT_T *begin, SORT_T *end)
+{
+    size_t n = SORT_LEN(begin, end);
+    size_t i;
+
+    for (i = n / 2; i-- > 0;) {
+        SORT_NAME(sift_down)(ctx, begin, i, n);
+    }
+    for (i = n; --i > 0;) {
+        SORT_SWAP(begin, SORT_AT(begin, i));
+        SORT_NAME(sift_down)(ctx, begin, 0, i);
+    }
+}
+
+/* Partitions around the pivot at begin, those equal to it going right.
+   There's one no earlier than it at end - 1 (the median's pick put it
+   there).  Returns where the pivot went, *sorted is whether nothing had to
+   move. */
+static SORT_T *
+SORT_NAME(partition_right)(SORT_CTX ctx, SORT_T *begin, SORT_T *end,
+                           SDL_bool *sorted)
+{
+    SORT_T *first = begin;
+    SORT_T *last = end;
+    SORT_T *pivot;
+
+    (void) ctx;
+    do {
+        first = SORT_AT(first, 1);
+    } while (SORT_LESS(first, begin));
+    if (SORT_AT(first, -1) == begin) {
+        do {
+            last = SORT_AT(last, -1);
+        } while (first < last && !SORT_LESS(last, begin));
+    } else {
+        /* One before first is less, that stops it */
+        do {
+            last = SORT_AT(last, -1);
+        } while (!SORT_LESS(last, begin));
+    }
+    *sorted = (first >= last) ? SDL_TRUE : SDL_FALSE;
+    while (first < last) {
+        SORT_SWAP(first, last);
+        do {
+            first = SORT_AT(first, 1);
+        } while (SORT_LESS(first, begin));
+        do {
+            last = SORT_AT(last, -1);
+        } while (!SORT_LESS(last, begin));
+    }
+    pivot = SORT_AT(first, -1);
+    SORT_SWAP(begin, pivot);
+    return pivot;
+}
+
+/* Partitions around the pivot at begin, those equal to it going left: when
+   the one before the range is equal to it, they all are & are done. */
+static SORT_T *
+SORT_NAME(partition_left)(SORT_CTX ctx, SORT_T *begin, SORT_T *end)
+{
+    SORT_T *first = begin;
+    SORT_T *last = end;
+
+    (void) ctx;
+    do {
+        last = SORT_AT(last, -1);
+    } while (SORT_LESS(begin, last));
+    if (SORT_AT(last, 1) == end) {
+        do {
+            first = SORT_AT(first, 1);
+        } while (first < last && !SORT_LESS(begin, first));
+    } else {
+        do {
+            first = SORT_AT(first, 1);
+        } while (!SORT_LESS(begin, first));
+    }
+    while (first < last) {
+        SORT_SWAP(first, last);
+        do {
+            last = SORT_AT(last, -1);
+        } while (SORT_LESS(begin, last));
+        do {
+            first = SORT_AT(first, 1);
+        } while (!SORT_LESS(begin, first));
+    }
+    SORT_SWAP(begin, last);
+    return last;
+}
+
+/* Sorts [begin, end), recursing into the left part & looping on the right.
+   Not leftmost, the element before begin is no later than any in it. */
+static void
+SORT_NAME(loop)(SORT_CTX ctx, SORT_T *begin, SORT_T *end, int bad_allowed,
+                SDL_bool leftmost)
+{
+    for (;;) {
+        size_t n = SORT_LEN(begin, end);
+        size_t half = n / 2;
+        size_t l_size, r_size;
+        SORT_T *pivot;
+        SDL_bool sorted;
+
+        if (n < (size_t) (SORT_INSERTION)) {
+            SORT_NAME(insertion)(ctx, begin, end, leftmost);
+            return;
+        }
+
+        /* The pivot to begin: a median of three, or of three medians */
+        if (n > SORT_NINTHER) {
+            SORT_NAME(sort3)(ctx, begin, SORT_AT(begin, half),
+                             SORT_AT(end, -1));
+            SORT_NAME(sort3)(ctx, SORT_AT(begin, 1), SORT_AT(begin, half - 1),
+                             SORT_AT(end, -2));
+            SORT_NAME(sort3)(ctx, SORT_AT(begin, 2), SORT_AT(begin, half + 1),
+                             SORT_AT(end, -3));
+            SORT_NAME(sort3)(ctx, SORT_AT(begin, half - 1),
+                             SORT_AT(begin, half), SORT_AT(begin, half + 1));
+            SORT_SWAP(begin, SORT_AT(begin, half));
+        } else {
+            SORT_NAME(sort3)(ctx, SORT_AT(begin, half), begin,
+                             SORT_AT(end, -1));
+        }
+
+        /* Many equal to what's before: they're all in place on the left */
+        if (!leftmost && !SORT_LESS(SORT_AT(begin, -1), begin)) {
+            begin = SORT_AT(SORT_NAME(partition_left)(ctx, begin, end), 1);
+            continue;
+        }
+
+        pivot = SORT_NAME(partition_right)(ctx, begin, end, &sorted);
+        l_size = SORT_LEN(begin, pivot);
+        r_size = SORT_LEN(SORT_AT(pivot, 1), end);
+        if (l_size < n / 8 || r_size < n / 8) {
+            /* A bad split, the input may be a pattern to break up */
+            if (--bad_allowed == 0) {
+                SORT_NAME(heapsort)(ctx, begin, end);
+                return;
+            }
+            if (l_size >= (size_t) (SORT_INSERTION)) {
+                SORT_SWAP(begin, SORT_AT(begin, l_size / 4));
+                SORT_SWAP(SORT_AT(pivot, -1), SORT_AT(pivot, -(ptrdiff_t) (l_size / 4)));
+                if (l_size > SORT_NINTHER) {
+                    SORT_SWAP(SORT_AT(begin, 1), SORT_AT(begin, l_size / 4 + 1));
+                    SORT_SWAP(SORT_AT(begin, 2), SORT_AT(begin, l_size / 4 + 2));
+                    SORT_SWAP(SORT_AT(pivot, -2), SORT_AT(pivot, -(ptrdiff_t) (l_size / 4 + 1)));
+                    SORT_SWAP(SORT_AT(pivot, -3), SORT_AT(pivot, -(ptrdiff_t) (l_size / 4 + 2)));
+                }
+            }
+            if (r_size >= (size_t) (SORT_INSERTION)) {
+                SORT_SWAP(SORT_AT(pivot, 1), SORT_AT(pivot, r_size / 4 + 1));
+                SORT_SWAP(SORT_AT(end, -1), SORT_AT(end, -(ptrdiff_t) (r_size / 4)));
+                if (r_size > SORT_NINTHER) {
+                    SORT_SWAP(SORT_AT(pivot, 2), SORT_AT(pivot, r_size / 4 + 2));
+                    SORT_SWAP(SORT_AT(pivot, 3), SORT_AT(pivot, r_size / 4 + 3));
+                    SORT_SWAP(SORT_AT(end, -2), SORT_AT(end, -(ptrdiff_t) (r_size / 4 + 1)));
+                    SORT_SWAP(SORT_AT(end, -3), SORT_AT(end, -(ptrdiff_t) (r_size / 4 + 2)));
+                }
+            }
+        } else if (sorted &&
+                   SORT_NAME(partial_insertion)(ctx, begin, pivot) &&
+                   SORT_NAME(partial_insertion)(ctx, SORT_AT(pivot, 1), end)) {
+            /* Already partitioned & both sides nearly sorted */
+            return;
+        }
+
+        SORT_NAME(loop)(ctx, begin, pivot, bad_allowed, leftmost);
+        begin = SORT_AT(pivot, 1);
+        leftmost = SDL_FALSE;
+    }
+}
+
+static void
+SORT_NAME(sort)(SORT_CTX ctx, SORT_T *base, size_t nmemb)
+{
+    int bad_allowed = 0;    /* log2(nmemb) */
+    size_t n;
+
+    for (n = nmemb; n > 1; n >>= 1) {
+        ++bad_allowed;
+    }
+    if (nmemb > 1) {
+        SORT_NAME(loop)(ctx, base, SORT_AT(base, nmemb), bad_allowed,
+                        SDL_TRUE);
+    }
+}
+
+#undef SORT_AT
+#undef SORT_LEN
+#undef SORT_NINTHER
+#undef SORT_PARTIAL_LIMIT
+#undef SORT_NAME
+#undef SORT_T
+#undef SORT_CTX
+#undef SORT_STEP
+#undef SORT_LESS
+#undef SORT_SWAP
+#undef SORT_INSERTION
+#undef SORT_HOLE
+
+/* vi: set ts=4 sw=4 expandtab: */
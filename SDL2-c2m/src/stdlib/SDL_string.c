@@ -52,6 +52,44 @@ static int UTF8_TrailingBytes(unsigned char c)
         return 0;
 }
 
+#if !defined(HAVE_VSSCANF) || !defined(HAVE_STRTOL) || \
+    !defined(HAVE_STRTOUL) || !defined(HAVE_STRTOD) || \
+    !defined(HAVE_STRTOLL) || !defined(HAVE_STRTOULL)
+/* Decimal digits at text into *valuep (wrapping around like the scanning
+   loops), returning how many there were.  They're counted first, so nothing
+   past the last digit is read, then on little endian CPUs converted 8 at a
+   time: three multiplies make a word of digits a number, pairs of digits,
+   then fours, then the eight. */
+static size_t
+SDL_ScanDecimal(const char *text, Uint64 *valuep)
+{
+    size_t length = 0;
+    size_t i = 0;
+    Uint64 value = 0;
+
+    while (SDL_isdigit((unsigned char) text[length])) {
+        ++length;
+    }
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    for (; length - i >= 8; i += 8) {
+        Uint64 chunk;
+
+        SDL_memcpy(&chunk, text + i, 8);
+        chunk -= 0x3030303030303030ULL;
+        chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFULL;
+        chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFULL;
+        chunk = (chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFFULL;
+        value = value * 100000000 + chunk;
+    }
+#endif
+    for (; i < length; ++i) {
+        value = value * 10 + (text[i] - '0');
+    }
+    *valuep = value;
+    return length;
+}
+#endif
+
 #if !defined(HAVE_VSSCANF) || !defined(HAVE_STRTOL)
 static size_t
 SDL_ScanLong(const char *text, int radix, long *valuep)
@@ -67,6 +105,11 @@ SDL_ScanLong(const char *text, int radix, long *valuep)
     if (radix == 16 && SDL_strncmp(text, "0x", 2) == 0) {
         text += 2;
     }
+    if (radix == 10) {
+        Uint64 digits;
+        text += SDL_ScanDecimal(text, &digits);
+        value = (long) digits;
+    }
     for (;;) {
         int v;
         if (SDL_isdigit((unsigned char) *text)) {
@@ -103,6 +146,11 @@ SDL_ScanUnsignedLong(const char *text, int radix, unsigned long *valuep)
     if (radix == 16 && SDL_strncmp(text, "0x", 2) == 0) {
         text += 2;
     }
+    if (radix == 10) {
+        Uint64 digits;
+        text += SDL_ScanDecimal(text, &digits);
+        value = (unsigned long) digits;
+    }
     for (;;) {
         int v;
         if (SDL_isdigit((unsigned char) *text)) {
@@ -135,6 +183,11 @@ SDL_ScanUintPtrT(const char *text, int radix, uintptr_t * valuep)
     if (radix == 16 && SDL_strncmp(text, "0x", 2) == 0) {
         text += 2;
     }
+    if (radix == 10) {
+        Uint64 digits;
+        text += SDL_ScanDecimal(text, &digits);
+        value = (uintptr_t) digits;
+    }
     for (;;) {
         int v;
         if (SDL_isdigit((unsigned char) *text)) {
@@ -172,6 +225,11 @@ SDL_ScanLongLong(const char *text, int radix, Sint64 * valuep)
     if (radix == 16 && SDL_strncmp(text, "0x", 2) == 0) {
         text += 2;
     }
+    if (radix == 10) {
+        Uint64 digits;
+        text += SDL_ScanDecimal(text, &digits);
+        value = (Sint64) digits;
+    }
     for (;;) {
         int v;
         if (SDL_isdigit((unsigned char) *text)) {
@@ -208,6 +266,11 @@ SDL_ScanUnsignedLongLong(const char *text, int radix, Uint64 * valuep)
     if (radix == 16 && SDL_strncmp(text, "0x", 2) == 0) {
         text += 2;
     }
+    if (radix == 10) {
+        Uint64 digits;
+        text += SDL_ScanDecimal(text, &digits);
+        value = (Uint64) digits;
+    }
     for (;;) {
         int v;
         if (SDL_isdigit((unsigned char) *text)) {
@@ -231,30 +294,73 @@ SDL_ScanUnsignedLongLong(const char *text, int radix, Uint64 * valuep)
 #endif
 
 #if !defined(HAVE_VSSCANF) || !defined(HAVE_STRTOD)
+/* Up to 19 significant digits & the exponent are integers, then the number
+   is exactly theirs when both are exact doubles (Clinger's fast path: at
+   most 2^53 & 10^22, a single rounding).  Otherwise it's scaled by a power
+   of ten, off by an ulp or so. */
 static size_t
 SDL_ScanFloat(const char *text, double *valuep)
 {
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
     const char *textstart = text;
-    unsigned long lvalue = 0;
-    double value = 0.0;
+    Uint64 mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    double value;
     SDL_bool negative = SDL_FALSE;
 
     if (*text == '-') {
         negative = SDL_TRUE;
         ++text;
     }
-    text += SDL_ScanUnsignedLong(text, 10, &lvalue);
-    value += lvalue;
+    for (; SDL_isdigit((unsigned char) *text); ++text) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*text - '0');
+            digits += (mantissa != 0);
+        } else {
+            ++exponent;
+        }
+    }
     if (*text == '.') {
-        int mult = 10;
-        ++text;
-        while (SDL_isdigit((unsigned char) *text)) {
-            lvalue = *text - '0';
-            value += (double) lvalue / mult;
-            mult *= 10;
-            ++text;
+        for (++text; SDL_isdigit((unsigned char) *text); ++text) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*text - '0');
+                digits += (mantissa != 0);
+                --exponent;
+            }
         }
     }
+    if ((*text == 'e' || *text == 'E') &&
+        (SDL_isdigit((unsigned char) text[1]) ||
+         ((text[1] == '-' || text[1] == '+') &&
+          SDL_isdigit((unsigned char) text[2])))) {
+        SDL_bool below = (text[1] == '-');
+        int e = 0;
+
+        text += SDL_isdigit((unsigned char) text[1]) ? 1 : 2;
+        for (; SDL_isdigit((unsigned char) *text); ++text) {
+            if (e < 100000) {
+                e = e * 10 + (*text - '0');
+            }
+        }
+        exponent += below ? -e : e;
+    }
+    value = (double) mantissa;
+    if (mantissa == 0) {
+        value = 0.0;
+    } else if (mantissa <= ((Uint64) 1 << 53) && exponent >= -22 &&
+               exponent <= 22) {
+        value = exponent < 0 ? value / powers[-exponent] :
+                               value * powers[exponent];
+    } else if (exponent < -300) {
+        /* Not to underflow before the digits are in */
+        value = value * SDL_pow(10.0, exponent + 300) * 1e-300;
+    } else {
+        value = value * SDL_pow(10.0, exponent);
+    }
     if (valuep) {
         if (negative && value) {
             *valuep = -value;
@@ -266,9 +372,453 @@ SDL_ScanFloat(const char *text, double *valuep)
 }
 #endif
 
+/* SIMD versions of memset, memcpy, memcmp & strlen, picked once by the
+   CPU's features (SSE2 or AVX2, NEON is always there on AArch64).  They're
+   used where the C library has none, or instead of it with SDL_STRING_DISPATCH
+   defined to 1.  Under 16 bytes (the vector size), sets & copies are done by
+   two overlapping words at most; vectors go the same way for the first &
+   last ones, aligned stores in between.  Past half the last level cache
+   they're non-temporal, not to evict what's cached for a buffer that won't
+   fit anyway.  strlen reads aligned vectors, never across a page, but past
+   the end of the string, which AddressSanitizer isn't told is fine. */
+#if !SDL_STRING_DISPATCH && defined(HAVE_MEMSET) && defined(HAVE_MEMCPY) && \
+    defined(HAVE_MEMCMP) && defined(HAVE_STRLEN)
+/* The C library's, all of them */
+#elif defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SDL_STRING_X86 1
+#include <immintrin.h>
+#define SDL_STRING_SIMD 1
+#elif defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    defined(__aarch64__)
+#define SDL_STRING_NEON 1
+#include <arm_neon.h>
+#define SDL_STRING_SIMD 1
+#endif
+
+#if SDL_STRING_SIMD
+#include "SDL_atomic.h"
+#include "SDL_cpuinfo.h"
+
+#if defined(__SANITIZE_ADDRESS__)
+#define SDL_STRING_OVERREAD __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SDL_STRING_OVERREAD __attribute__((no_sanitize_address))
+#endif
+#endif
+#ifndef SDL_STRING_OVERREAD
+#define SDL_STRING_OVERREAD
+#endif
+
+#define SDL_STRING_GENERIC 1    /* The C loops or the C library's */
+#define SDL_STRING_VECTOR 2     /* SSE2 or NEON */
+#define SDL_STRING_AVX2 3
+
+static SDL_atomic_t SDL_string_level;
+static size_t SDL_string_streaming = (size_t) 4 << 20;  /* Bytes, at least */
+
+static void
+SDL_StringResolve(void)
+{
+    int level = SDL_STRING_GENERIC;
+    int cache;
+
+    /* The CPU info functions call back in here, the C loops do meanwhile */
+    SDL_AtomicStore(&SDL_string_level, SDL_STRING_GENERIC,
+                    SDL_MEMORY_ORDER_RELAXED);
+    cache = SDL_GetCPUCacheSize(3);
+    if (cache <= 0) {
+        cache = SDL_GetCPUCacheSize(2);
+    }
+    if (cache > 0) {
+        SDL_string_streaming = (size_t) cache / 2;
+    }
+#ifdef SDL_STRING_X86
+    {
+        static const Uint32 needs[] = {
+            SDL_CPUFEATURE_AVX2, SDL_CPUFEATURE_SSE2, 0
+        };
+        static const int levels[] = {
+            SDL_STRING_AVX2, SDL_STRING_VECTOR, SDL_STRING_GENERIC
+        };
+        level = levels[SDL_GetCPUVariant(needs, SDL_arraysize(needs))];
+    }
+#else
+    level = SDL_STRING_VECTOR;
+#endif
+    SDL_AtomicStore(&SDL_string_level, level, SDL_MEMORY_ORDER_RELEASE);
+}
+
+static SDL_INLINE int
+SDL_StringLevel(void)
+{
+    int level = SDL_AtomicLoad(&SDL_string_level, SDL_MEMORY_ORDER_ACQUIRE);
+    if (level == 0) {
+        SDL_StringResolve();
+        level = SDL_AtomicLoad(&SDL_string_level, SDL_MEMORY_ORDER_ACQUIRE);
+    }
+    return level;
+}
+
+/* Sets & copies of len < 16 bytes */
+static SDL_INLINE void
+SDL_memset_small(Uint8 *d, int c, size_t len)
+{
+    Uint64 v8 = (Uint64) (Uint8) c * 0x0101010101010101ULL;
+    Uint32 v4 = (Uint32) v8;
+
+    if (len >= 8) {
+        __builtin_memcpy(d, &v8, 8);
+        __builtin_memcpy(d + len - 8, &v8, 8);
+    } else if (len >= 4) {
+        __builtin_memcpy(d, &v4, 4);
+        __builtin_memcpy(d + len - 4, &v4, 4);
+    } else if (len) {
+        d[0] = d[len / 2] = d[len - 1] = (Uint8) c;
+    }
+}
+
+static SDL_INLINE void
+SDL_memcpy_small(Uint8 *d, const Uint8 *s, size_t len)
+{
+    if (len >= 8) {
+        Uint64 a, b;
+        __builtin_memcpy(&a, s, 8);
+        __builtin_memcpy(&b, s + len - 8, 8);
+        __builtin_memcpy(d, &a, 8);
+        __builtin_memcpy(d + len - 8, &b, 8);
+    } else if (len >= 4) {
+        Uint32 a, b;
+        __builtin_memcpy(&a, s, 4);
+        __builtin_memcpy(&b, s + len - 4, 4);
+        __builtin_memcpy(d, &a, 4);
+        __builtin_memcpy(d + len - 4, &b, 4);
+    } else if (len) {
+        Uint8 a = s[0], b = s[len / 2], e = s[len - 1];
+        d[0] = a;
+        d[len / 2] = b;
+        d[len - 1] = e;
+    }
+}
+
+static SDL_INLINE int
+SDL_memcmp_bytes(const Uint8 *a, const Uint8 *b, size_t len)
+{
+    size_t i;
+    for (i = 0; i < len; ++i) {
+        if (a[i] != b[i]) {
+            return (int) a[i] - (int) b[i];
+        }
+    }
+    return 0;
+}
+
+#ifdef SDL_STRING_X86
+
+__attribute__((target("sse2"), unused)) static void *
+SDL_memset_SSE2(void *dst, int c, size_t len)
+{
+    Uint8 *d = (Uint8 *) dst;
+    Uint8 *p, *end;
+    __m128i v;
+
+    if (len < 16) {
+        SDL_memset_small(d, c, len);
+        return dst;
+    }
+    v = _mm_set1_epi8((char) c);
+    _mm_storeu_si128((__m128i *) d, v);
+    _mm_storeu_si128((__m128i *) (d + len - 16), v);
+    p = (Uint8 *) (((uintptr_t) d + 16) & ~(uintptr_t) 15);
+    end = d + len - 16;
+    if (len >= SDL_string_streaming) {
+        for (; p < end; p += 16) {
+            _mm_stream_si128((__m128i *) p, v);
+        }
+        _mm_sfence();
+    } else {
+        for (; p < end; p += 16) {
+            _mm_store_si128((__m128i *) p, v);
+        }
+    }
+    return dst;
+}
+
+__attribute__((target("avx2"), unused)) static void *
+SDL_memset_AVX2(void *dst, int c, size_t len)
+{
+    Uint8 *d = (Uint8 *) dst;
+    Uint8 *p, *end;
+    __m256i v;
+
+    if (len < 32) {
+        return SDL_memset_SSE2(dst, c, len);
+    }
+    v = _mm256_set1_epi8((char) c);
+    _mm256_storeu_si256((__m256i *) d, v);
+    _mm256_storeu_si256((__m256i *) (d + len - 32), v);
+    p = (Uint8 *) (((uintptr_t) d + 32) & ~(uintptr_t) 31);
+    end = d + len - 32;
+    if (len >= SDL_string_streaming) {
+        for (; p < end; p += 32) {
+            _mm256_stream_si256((__m256i *) p, v);
+        }
+        _mm_sfence();
+    } else {
+        for (; p < end; p += 32) {
+            _mm256_store_si256((__m256i *) p, v);
+        }
+    }
+    return dst;
+}
+
+__attribute__((target("sse2"), unused)) static void *
+SDL_memcpy_SSE2(void *dst, const void *src, size_t len)
+{
+    Uint8 *d = (Uint8 *) dst;
+    const Uint8 *s = (const Uint8 *) src;
+    __m128i head, tail;
+    size_t i;
+
+    if (len < 16) {
+        SDL_memcpy_small(d, s, len);
+        return dst;
+    }
+    head = _mm_loadu_si128((const __m128i *) s);
+    tail = _mm_loadu_si128((const __m128i *) (s + len - 16));
+    i = 16 - ((uintptr_t) d & 15);
+    if (len >= SDL_string_streaming) {
+        for (; i < len - 16; i += 16) {
+            _mm_stream_si128((__m128i *) (d + i),
+                             _mm_loadu_si128((const __m128i *) (s + i)));
+        }
+        _mm_sfence();
+    } else {
+        for (; i < len - 16; i += 16) {
+            _mm_store_si128((__m128i *) (d + i),
+                            _mm_loadu_si128((const __m128i *) (s + i)));
+        }
+    }
+    _mm_storeu_si128((__m128i *) d, head);
+    _mm_storeu_si128((__m128i *) (d + len - 16), tail);
+    return dst;
+}
+
+__attribute__((target("avx2"), unused)) static void *
+SDL_memcpy_AVX2(void *dst, const void *src, size_t len)
+{
+    Uint8 *d = (Uint8 *) dst;
+    const Uint8 *s = (const Uint8 *) src;
+    __m256i head, tail;
+    size_t i;
+
+    if (len < 32) {
+        return SDL_memcpy_SSE2(dst, src, len);
+    }
+    head = _mm256_loadu_si256((const __m256i *) s);
+    tail = _mm256_loadu_si256((const __m256i *) (s + len - 32));
+    i = 32 - ((uintptr_t) d & 31);
+    if (len >= SDL_string_streaming) {
+        for (; i < len - 32; i += 32) {
+            _mm256_stream_si256((__m256i *) (d + i),
+                                _mm256_loadu_si256((const __m256i *) (s + i)));
+        }
+        _mm_sfence();
+    } else {
+        for (; i < len - 32; i += 32) {
+            _mm256_store_si256((__m256i *) (d + i),
+                               _mm256_loadu_si256((const __m256i *) (s + i)));
+        }
+    }
+    _mm256_storeu_si256((__m256i *) d, head);
+    _mm256_storeu_si256((__m256i *) (d + len - 32), tail);
+    return dst;
+}
+
+__attribute__((target("sse2"), unused)) static int
+SDL_memcmp_SSE2(const void *s1, const void *s2, size_t len)
+{
+    const Uint8 *a = (const Uint8 *) s1;
+    const Uint8 *b = (const Uint8 *) s2;
+    size_t i;
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *) (b + i));
+        unsigned same = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+        if (same != 0xFFFF) {
+            i += __builtin_ctz(~same);
+            return (int) a[i] - (int) b[i];
+        }
+    }
+    return SDL_memcmp_bytes(a + i, b + i, len - i);
+}
+
+__attribute__((target("avx2"), unused)) static int
+SDL_memcmp_AVX2(const void *s1, const void *s2, size_t len)
+{
+    const Uint8 *a = (const Uint8 *) s1;
+    const Uint8 *b = (const Uint8 *) s2;
+    size_t i;
+
+    for (i = 0; i + 32 <= len; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+        unsigned same = (unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+        if (same != 0xFFFFFFFFu) {
+            i += __builtin_ctz(~same);
+            return (int) a[i] - (int) b[i];
+        }
+    }
+    return SDL_memcmp_SSE2(a + i, b + i, len - i);
+}
+
+__attribute__((target("sse2"), unused)) SDL_STRING_OVERREAD static size_t
+SDL_strlen_SSE2(const char *string)
+{
+    const char *p = (const char *) ((uintptr_t) string & ~(uintptr_t) 15);
+    __m128i zero = _mm_setzero_si128();
+    unsigned mask = (unsigned) _mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_load_si128((const __m128i *) p), zero));
+
+    mask >>= (string - p);
+    if (mask) {
+        return __builtin_ctz(mask);
+    }
+    for (;;) {
+        p += 16;
+        mask = (unsigned) _mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_load_si128((const __m128i *) p), zero));
+        if (mask) {
+            return (size_t) (p - string) + __builtin_ctz(mask);
+        }
+    }
+}
+
+__attribute__((target("avx2"), unused)) SDL_STRING_OVERREAD static size_t
+SDL_strlen_AVX2(const char *string)
+{
+    const char *p = (const char *) ((uintptr_t) string & ~(uintptr_t) 31);
+    __m256i zero = _mm256_setzero_si256();
+    unsigned mask = (unsigned) _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *) p), zero));
+
+    mask >>= (string - p);
+    if (mask) {
+        return __builtin_ctz(mask);
+    }
+    for (;;) {
+        p += 32;
+        mask = (unsigned) _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *) p), zero));
+        if (mask) {
+            return (size_t) (p - string) + __builtin_ctz(mask);
+        }
+    }
+}
+
+#define SDL_STRING_CALL(level, fn, args) \
+    ((level) == SDL_STRING_AVX2 ? fn##_AVX2 args : fn##_SSE2 args)
+
+#else /* SDL_STRING_NEON */
+
+__attribute__((unused)) static void *
+SDL_memset_NEON(void *dst, int c, size_t len)
+{
+    Uint8 *d = (Uint8 *) dst;
+    Uint8 *p, *end;
+    uint8x16_t v;
+
+    if (len < 16) {
+        SDL_memset_small(d, c, len);
+        return dst;
+    }
+    v = vdupq_n_u8((Uint8) c);
+    vst1q_u8(d, v);
+    vst1q_u8(d + len - 16, v);
+    p = (Uint8 *) (((uintptr_t) d + 16) & ~(uintptr_t) 15);
+    end = d + len - 16;
+    for (; p < end; p += 16) {
+        vst1q_u8(p, v);
+    }
+    return dst;
+}
+
+__attribute__((unused)) static void *
+SDL_memcpy_NEON(void *dst, const void *src, size_t len)
+{
+    Uint8 *d = (Uint8 *) dst;
+    const Uint8 *s = (const Uint8 *) src;
+    uint8x16_t head, tail;
+    size_t i;
+
+    if (len < 16) {
+        SDL_memcpy_small(d, s, len);
+        return dst;
+    }
+    head = vld1q_u8(s);
+    tail = vld1q_u8(s + len - 16);
+    for (i = 16 - ((uintptr_t) d & 15); i < len - 16; i += 16) {
+        vst1q_u8(d + i, vld1q_u8(s + i));
+    }
+    vst1q_u8(d, head);
+    vst1q_u8(d + len - 16, tail);
+    return dst;
+}
+
+__attribute__((unused)) static int
+SDL_memcmp_NEON(const void *s1, const void *s2, size_t len)
+{
+    const Uint8 *a = (const Uint8 *) s1;
+    const Uint8 *b = (const Uint8 *) s2;
+    size_t i;
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        if (vminvq_u8(vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i))) != 0xFF) {
+            return SDL_memcmp_bytes(a + i, b + i, 16);
+        }
+    }
+    return SDL_memcmp_bytes(a + i, b + i, len - i);
+}
+
+__attribute__((unused)) SDL_STRING_OVERREAD static size_t
+SDL_strlen_NEON(const char *string)
+{
+    const Uint8 *p = (const Uint8 *) ((uintptr_t) string & ~(uintptr_t) 15);
+    const Uint8 *s = (const Uint8 *) string;
+
+    if (vminvq_u8(vld1q_u8(p)) == 0) {
+        for (; p + 16 > s; ++s) {
+            if (*s == 0) {
+                return (size_t) (s - (const Uint8 *) string);
+            }
+        }
+    }
+    for (;;) {
+        p += 16;
+        if (vminvq_u8(vld1q_u8(p)) == 0) {
+            for (s = p; *s; ++s) {
+            }
+            return (size_t) (s - (const Uint8 *) string);
+        }
+    }
+}
+
+#define SDL_STRING_CALL(level, fn, args) fn##_NEON args
+
+#endif /* SDL_STRING_X86 */
+#endif /* SDL_STRING_SIMD */
+
 void *
 SDL_memset(SDL_OUT_BYTECAP(len) void *dst, int c, size_t len)
 {
+#if SDL_STRING_SIMD && (SDL_STRING_DISPATCH || !defined(HAVE_MEMSET))
+    int level = SDL_StringLevel();
+    if (level > SDL_STRING_GENERIC) {
+        return SDL_STRING_CALL(level, SDL_memset, (dst, c, len));
+    }
+#endif
 #if defined(HAVE_MEMSET)
     return memset(dst, c, len);
 #else
@@ -313,6 +863,12 @@ SDL_memset(SDL_OUT_BYTECAP(len) void *dst, int c, size_t len)
 void *
 SDL_memcpy(SDL_OUT_BYTECAP(len) void *dst, SDL_IN_BYTECAP(len) const void *src, size_t len)
 {
+#if SDL_STRING_SIMD && (SDL_STRING_DISPATCH || !defined(HAVE_MEMCPY))
+    int level = SDL_StringLevel();
+    if (level > SDL_STRING_GENERIC) {
+        return SDL_STRING_CALL(level, SDL_memcpy, (dst, src, len));
+    }
+#endif
 #ifdef __GNUC__
     /* Presumably this is well tuned for speed.
        On my machine this is twice as fast as the C code below.
@@ -390,6 +946,12 @@ SDL_memmove(SDL_OUT_BYTECAP(len) void *dst, SDL_IN_BYTECAP(len) const void *src,
 int
 SDL_memcmp(const void *s1, const void *s2, size_t len)
 {
+#if SDL_STRING_SIMD && (SDL_STRING_DISPATCH || !defined(HAVE_MEMCMP))
+    int level = SDL_StringLevel();
+    if (level > SDL_STRING_GENERIC) {
+        return SDL_STRING_CALL(level, SDL_memcmp, (s1, s2, len));
+    }
+#endif
 #if defined(HAVE_MEMCMP)
     return memcmp(s1, s2, len);
 #else
@@ -409,6 +971,12 @@ SDL_memcmp(const void *s1, const void *s2, size_t len)
 size_t
 SDL_strlen(const char *string)
 {
+#if SDL_STRING_SIMD && (SDL_STRING_DISPATCH || !defined(HAVE_STRLEN))
+    int level = SDL_StringLevel();
+    if (level > SDL_STRING_GENERIC) {
+        return SDL_STRING_CALL(level, SDL_strlen, (string));
+    }
+#endif
 #if defined(HAVE_STRLEN)
     return strlen(string);
 #else
@@ -500,7 +1068,7 @@ size_t SDL_utf8strlcpy(SDL_OUT_Z_CAP(dst_bytes) char *dst, const char *src, size
                 trailing_bytes = UTF8_TrailingBytes(c);
                 if (trailing_bytes)
                 {
-                    if (bytes - i != trailing_bytes + 1)
+                    if (bytes - i != (size_t)trailing_bytes + 1)
                         bytes = i;
 
                     break;
@@ -531,8 +1099,8 @@ SDL_strlcat(SDL_INOUT_Z_CAP(maxlen) char *dst, const char *src, size_t maxlen)
 char *
 SDL_strdup(const char *string)
 {
-#if defined(HAVE_STRDUP)
-    return strdup(string);
+#if defined(HAVE_STRDUP) && defined(HAVE_MALLOC) && !SDL_THREAD_HEAPS
+    return strdup(string);     /* Only if SDL_free() is free() */
 #else
     size_t len = SDL_strlen(string) + 1;
     char *newstr = SDL_malloc(len);
@@ -646,6 +1214,56 @@ SDL_strstr(const char *haystack, const char *needle)
 #endif /* HAVE_STRSTR */
 }
 
+#if !defined(HAVE__ULTOA) || !defined(HAVE__UI64TOA)
+/* Decimal numbers are written from their last digit back, two per division,
+   their length known first so that's straight to where they go. */
+static const char ntoa_pairs[] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+static char *
+SDL_PrintDecimal(Uint64 value, char *string)
+{
+    static const Uint64 powers[] = {
+        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+        10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+        100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+        100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+        100000000000000000ULL, 1000000000000000000ULL,
+        10000000000000000000ULL
+    };
+    char *bufp;
+    int length;
+
+#if defined(__GNUC__)
+    /* The bit length times log10(2), one short where value is under the
+       power of ten that gives (0 is written like 1) */
+    length = ((64 - __builtin_clzll(value | 1)) * 1233) >> 12;
+    length += 1 - ((value | 1) < powers[length]);
+#else
+    for (length = 1; length < 20 && value >= powers[length]; ++length) {
+    }
+#endif
+    bufp = string + length;
+    *bufp = '\0';
+    while (value >= 100) {
+        const char *pair = &ntoa_pairs[(value % 100) * 2];
+        value /= 100;
+        *--bufp = pair[1];
+        *--bufp = pair[0];
+    }
+    if (value >= 10) {
+        *--bufp = ntoa_pairs[value * 2 + 1];
+        *--bufp = ntoa_pairs[value * 2];
+    } else {
+        *--bufp = (char) ('0' + value);
+    }
+    return string;
+}
+#endif /* decimal conversion */
+
 #if !defined(HAVE__LTOA) || !defined(HAVE__I64TOA) || \
     !defined(HAVE__ULTOA) || !defined(HAVE__UI64TOA)
 static const char ntoa_table[] = {
@@ -703,6 +1321,10 @@ SDL_ultoa(unsigned long value, char *string, int radix)
 #else
     char *bufp = string;
 
+    if (radix == 10) {
+        return SDL_PrintDecimal(value, string);
+    }
+
     if (value) {
         while (value > 0) {
             *bufp++ = ntoa_table[value % radix];
@@ -747,6 +1369,10 @@ SDL_ulltoa(Uint64 value, char *string, int radix)
 #else
     char *bufp = string;
 
+    if (radix == 10) {
+        return SDL_PrintDecimal(value, string);
+    }
+
     if (value) {
         while (value > 0) {
             *bufp++ = ntoa_table[value % radix];
@@ -46,6 +46,9 @@ extern void SDL_SYS_SetupThread(const char *name);
 /* This function sets the current thread priority */
 extern int SDL_SYS_SetThreadPriority(SDL_ThreadPriority priority);
 
+/* This function sets the current thread's CPU affinity, any CPU if count is 0 */
+extern int SDL_SYS_SetThreadAffinity(const int *cpus, int count);
+
 /* This function waits for the thread to finish and frees any data
    allocated by SDL_SYS_CreateThread()
  */
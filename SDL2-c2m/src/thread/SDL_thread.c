@@ -23,17 +23,27 @@
 /* System independent thread management routines for SDL */
 
 #include "SDL_assert.h"
+#include "SDL_cpuinfo.h"
 #include "SDL_thread.h"
 #include "SDL_thread_c.h"
 #include "SDL_systhread.h"
 #include "../SDL_error_c.h"
 
 
+/* The static slots live in their own thread local array where there are
+   thread local variables, and the table's first entries where there aren't. */
+#ifdef SDL_THREAD_LOCAL
+static SDL_THREAD_LOCAL struct {
+    void *data;
+    void (*destructor)(void*);
+} SDL_tls_static[SDL_TLS_STATIC_SLOTS];
+#endif
+
 SDL_TLSID
 SDL_TLSCreate()
 {
     static SDL_atomic_t SDL_tls_id;
-    return SDL_AtomicIncRef(&SDL_tls_id)+1;
+    return SDL_AtomicIncRef(&SDL_tls_id)+1+SDL_TLS_STATIC_SLOTS;
 }
 
 void *
@@ -41,6 +51,13 @@ SDL_TLSGet(SDL_TLSID id)
 {
     SDL_TLSData *storage;
 
+#ifdef SDL_THREAD_LOCAL
+    /* 0 wraps around, past the slots */
+    if (id - 1 < SDL_TLS_STATIC_SLOTS) {
+        return SDL_tls_static[id-1].data;
+    }
+    id -= SDL_TLS_STATIC_SLOTS;
+#endif
     storage = SDL_SYS_GetTLSData();
     if (!storage || id == 0 || id > storage->limit) {
         return NULL;
@@ -56,6 +73,14 @@ SDL_TLSSet(SDL_TLSID id, const void *value, void (*destructor)(void *))
     if (id == 0) {
         return SDL_InvalidParamError("id");
     }
+#ifdef SDL_THREAD_LOCAL
+    if (id <= SDL_TLS_STATIC_SLOTS) {
+        SDL_tls_static[id-1].data = SDL_const_cast(void*, value);
+        SDL_tls_static[id-1].destructor = destructor;
+        return 0;
+    }
+    id -= SDL_TLS_STATIC_SLOTS;
+#endif
 
     storage = SDL_SYS_GetTLSData();
     if (!storage || (id > storage->limit)) {
@@ -87,6 +112,16 @@ SDL_TLSCleanup()
 {
     SDL_TLSData *storage;
 
+#ifdef SDL_THREAD_LOCAL
+    unsigned int slot;
+    for (slot = 0; slot < SDL_TLS_STATIC_SLOTS; ++slot) {
+        if (SDL_tls_static[slot].destructor) {
+            SDL_tls_static[slot].destructor(SDL_tls_static[slot].data);
+        }
+        SDL_tls_static[slot].data = NULL;
+        SDL_tls_static[slot].destructor = NULL;
+    }
+#endif
     storage = SDL_SYS_GetTLSData();
     if (storage) {
         unsigned int i;
@@ -294,6 +329,9 @@ SDL_RunThread(void *data)
             SDL_free(thread);
         }
     }
+
+    /* Nothing more is allocated on this thread */
+    SDL_ThreadHeapExit();
 }
 
 #ifdef SDL_CreateThread
@@ -415,6 +453,39 @@ SDL_SetThreadPriority(SDL_ThreadPriority priority)
     return SDL_SYS_SetThreadPriority(priority);
 }
 
+int
+SDL_SetThreadAffinity(const int *cpus, int count)
+{
+    int i;
+
+    if (count < 0 || (count > 0 && !cpus)) {
+        return SDL_InvalidParamError("cpus");
+    }
+    for (i = 0; i < count; ++i) {
+        if (cpus[i] < 0 || cpus[i] >= SDL_CPU_TOPOLOGY_MAX) {
+            return SDL_InvalidParamError("cpus");
+        }
+    }
+    return SDL_SYS_SetThreadAffinity(cpus, count);
+}
+
+int
+SDL_SetThreadNUMANode(int node)
+{
+    int cpus[SDL_CPU_TOPOLOGY_MAX];
+    int cpu, count = 0;
+
+    for (cpu = 0; cpu < SDL_CPU_TOPOLOGY_MAX; ++cpu) {
+        if (SDL_GetCPUNUMANode(cpu) == node) {
+            cpus[count++] = cpu;
+        }
+    }
+    if (count == 0) {
+        return SDL_InvalidParamError("node");
+    }
+    return SDL_SYS_SetThreadAffinity(cpus, count);
+}
+
 void
 SDL_WaitThread(SDL_Thread * thread, int *status)
 {
@@ -74,6 +74,19 @@ typedef struct {
     } array[1];
 } SDL_TLSData;
 
+/* The compiler's thread local variables, if it has them: the TLS backends
+   and the static TLS slots use them instead of the OS's TLS functions. */
+#if defined(__GNUC__) || defined(__clang__)
+#define SDL_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define SDL_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define SDL_THREAD_LOCAL _Thread_local
+#endif
+
+/* Leaves the thread's SDL_malloc heap for another thread, see SDL_malloc.c */
+extern void SDL_ThreadHeapExit(void);
+
 /* This is how many TLS entries we allocate at once */
 #define TLS_ALLOC_CHUNKSIZE 4
 
@@ -0,0 +1,189 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+/* An implementation of reader-writer locks using a mutex and condition
+   variables, for the backends without native ones.  The state is the number
+   of readers holding the lock, or -1 while a writer does.  Readers only take
+   it while no writer holds it or waits for it. */
+
+#include "SDL_thread.h"
+#include "SDL_systhread_c.h"
+
+
+struct SDL_rwlock
+{
+    int state;
+    int writers;    /* Waiting for it or holding it */
+    SDL_mutex *lock;
+    SDL_cond *readers_cond;
+    SDL_cond *writers_cond;
+};
+
+/* Free the lock, or what's been created of it */
+void
+SDL_DestroyRWLock(SDL_rwlock * rwlock)
+{
+    if (rwlock) {
+        if (rwlock->writers_cond) {
+            SDL_DestroyCond(rwlock->writers_cond);
+        }
+        if (rwlock->readers_cond) {
+            SDL_DestroyCond(rwlock->readers_cond);
+        }
+        if (rwlock->lock) {
+            SDL_DestroyMutex(rwlock->lock);
+        }
+        SDL_free(rwlock);
+    }
+}
+
+SDL_rwlock *
+SDL_CreateRWLock(void)
+{
+    SDL_rwlock *rwlock = (SDL_rwlock *) SDL_calloc(1, sizeof(*rwlock));
+    if (!rwlock) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+#if !SDL_THREADS_DISABLED
+    rwlock->lock = SDL_CreateMutex();
+    rwlock->readers_cond = SDL_CreateCond();
+    rwlock->writers_cond = SDL_CreateCond();
+    if (!rwlock->lock || !rwlock->readers_cond || !rwlock->writers_cond) {
+        SDL_DestroyRWLock(rwlock);
+        rwlock = NULL;
+    }
+#endif
+    return rwlock;
+}
+
+int
+SDL_LockRWLockForReading(SDL_rwlock * rwlock)
+{
+#if SDL_THREADS_DISABLED
+    return 0;
+#else
+    if (rwlock == NULL) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    SDL_LockMutex(rwlock->lock);
+    while (rwlock->state < 0 || rwlock->writers) {
+        SDL_CondWait(rwlock->readers_cond, rwlock->lock);
+    }
+    ++rwlock->state;
+    SDL_UnlockMutex(rwlock->lock);
+    return 0;
+#endif /* SDL_THREADS_DISABLED */
+}
+
+int
+SDL_LockRWLockForWriting(SDL_rwlock * rwlock)
+{
+#if SDL_THREADS_DISABLED
+    return 0;
+#else
+    if (rwlock == NULL) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    SDL_LockMutex(rwlock->lock);
+    /* Counted first, so no new reader gets in */
+    ++rwlock->writers;
+    while (rwlock->state != 0) {
+        SDL_CondWait(rwlock->writers_cond, rwlock->lock);
+    }
+    rwlock->state = -1;
+    SDL_UnlockMutex(rwlock->lock);
+    return 0;
+#endif /* SDL_THREADS_DISABLED */
+}
+
+int
+SDL_TryLockRWLockForReading(SDL_rwlock * rwlock)
+{
+#if SDL_THREADS_DISABLED
+    return 0;
+#else
+    int retval = SDL_MUTEX_TIMEDOUT;
+
+    if (rwlock == NULL) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    SDL_LockMutex(rwlock->lock);
+    if (rwlock->state >= 0 && !rwlock->writers) {
+        ++rwlock->state;
+        retval = 0;
+    }
+    SDL_UnlockMutex(rwlock->lock);
+    return retval;
+#endif /* SDL_THREADS_DISABLED */
+}
+
+int
+SDL_TryLockRWLockForWriting(SDL_rwlock * rwlock)
+{
+#if SDL_THREADS_DISABLED
+    return 0;
+#else
+    int retval = SDL_MUTEX_TIMEDOUT;
+
+    if (rwlock == NULL) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    SDL_LockMutex(rwlock->lock);
+    if (rwlock->state == 0) {
+        ++rwlock->writers;
+        rwlock->state = -1;
+        retval = 0;
+    }
+    SDL_UnlockMutex(rwlock->lock);
+    return retval;
+#endif /* SDL_THREADS_DISABLED */
+}
+
+/* A writer hands the lock to the next writer if there is one, else to all of
+   the readers; the last reader out hands it to a writer. */
+int
+SDL_UnlockRWLock(SDL_rwlock * rwlock)
+{
+#if SDL_THREADS_DISABLED
+    return 0;
+#else
+    if (rwlock == NULL) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    SDL_LockMutex(rwlock->lock);
+    if (rwlock->state < 0) {
+        rwlock->state = 0;
+        if (--rwlock->writers) {
+            SDL_CondSignal(rwlock->writers_cond);
+        } else {
+            SDL_CondBroadcast(rwlock->readers_cond);
+        }
+    } else if (--rwlock->state == 0 && rwlock->writers) {
+        SDL_CondSignal(rwlock->writers_cond);
+    }
+    SDL_UnlockMutex(rwlock->lock);
+    return 0;
+#endif /* SDL_THREADS_DISABLED */
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
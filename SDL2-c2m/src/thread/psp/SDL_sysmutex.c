@@ -26,6 +26,7 @@
 
 #include "SDL_thread.h"
 #include "SDL_systhread_c.h"
+#include "SDL_timer.h"
 
 
 struct SDL_mutex
@@ -131,6 +132,26 @@ SDL_mutexV(SDL_mutex * mutex)
 #endif /* SDL_THREADS_DISABLED */
 }
 
+#ifdef SDL_HAS_NATIVE_ATOMICS
+/* Without a futex a contended spin mutex sleeps a tick until it's free. */
+void
+SDL_SpinMutexLockContended(SDL_SpinMutex * mutex)
+{
+    int unlocked = 0;
+    while (!SDL_AtomicCompareExchange(&mutex->state, &unlocked, 1,
+                                      SDL_MEMORY_ORDER_ACQUIRE)) {
+        unlocked = 0;
+        SDL_Delay(0);
+    }
+}
+
+void
+SDL_SpinMutexWake(SDL_SpinMutex * mutex)
+{
+    (void) mutex;
+}
+#endif
+
 #endif /* SDL_THREAD_PSP */
 
 /* vi: set ts=4 sw=4 expandtab: */
@@ -106,6 +106,14 @@ int SDL_SYS_SetThreadPriority(SDL_ThreadPriority priority)
 
 }
 
+int SDL_SYS_SetThreadAffinity(const int *cpus, int count)
+{
+    /* There's a single CPU */
+    (void) cpus;
+    (void) count;
+    return 0;
+}
+
 #endif /* SDL_THREAD_PSP */
 
 /* vim: ts=4 sw=4
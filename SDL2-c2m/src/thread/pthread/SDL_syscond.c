@@ -24,11 +24,114 @@
 #include <time.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 #include <pthread.h>
 
 #include "SDL_thread.h"
 #include "SDL_sysmutex_c.h"
 
+#if SDL_THREAD_FUTEX
+
+/* A sequence number bumped by each signal (the futex, in the word's high
+   half) and the number of waiters (the low half): a waiter sleeps while it's
+   the one it saw before unlocking, so a signal in between isn't lost.
+   Wakeups can be spurious, as they can with pthreads. */
+struct SDL_cond
+{
+    SDL_atomic64_t word;
+};
+
+SDL_cond *
+SDL_CreateCond(void)
+{
+    SDL_cond *cond = (SDL_cond *) SDL_calloc(1, sizeof(SDL_cond));
+    if (!cond) {
+        SDL_OutOfMemory();
+    }
+    return cond;
+}
+
+void
+SDL_DestroyCond(SDL_cond * cond)
+{
+    SDL_free(cond);
+}
+
+static int
+SDL_CondWake(SDL_cond * cond, int n)
+{
+    Sint64 word;
+
+    if (!cond) {
+        return SDL_SetError("Passed a NULL condition variable");
+    }
+    word = SDL_AtomicFetchAdd64(&cond->word, SDL_FUTEX_HIGH,
+                                SDL_MEMORY_ORDER_RELEASE);
+    if (SDL_FutexHalfValue(word, 0)) {
+        SDL_FutexWake(SDL_FutexHalf(&cond->word, 1), n);
+    }
+    return 0;
+}
+
+int
+SDL_CondSignal(SDL_cond * cond)
+{
+    return SDL_CondWake(cond, 1);
+}
+
+int
+SDL_CondBroadcast(SDL_cond * cond)
+{
+    return SDL_CondWake(cond, INT_MAX);
+}
+
+int
+SDL_CondWaitTimeout(SDL_cond * cond, SDL_mutex * mutex, Uint32 ms)
+{
+    struct timespec left;
+    Sint64 word;
+    int seq, recursive, woken, timedout, retval = 0;
+
+    if (!cond) {
+        return SDL_SetError("Passed a NULL condition variable");
+    }
+    if (ms != SDL_MUTEX_MAXWAIT) {
+        left.tv_sec = ms / 1000;
+        left.tv_nsec = (ms % 1000) * 1000000;
+    }
+    seq = SDL_FutexHalfValue(SDL_AtomicFetchAdd64(&cond->word, SDL_FUTEX_LOW,
+                                                  SDL_MEMORY_ORDER_RELAXED), 1);
+    /* All the way unlocked, like pthread_cond_wait() would leave it */
+    recursive = mutex->recursive;
+    mutex->recursive = 0;
+    if (SDL_UnlockMutex(mutex) < 0) {
+        SDL_AtomicFetchAdd64(&cond->word, -SDL_FUTEX_LOW,
+                             SDL_MEMORY_ORDER_RELAXED);
+        return -1;
+    }
+    do {
+        woken = SDL_FutexWait(SDL_FutexHalf(&cond->word, 1), seq,
+                              ms == SDL_MUTEX_MAXWAIT ? NULL : &left);
+    } while (woken < 0 && errno == EINTR);
+    timedout = woken < 0 && errno == ETIMEDOUT;
+    word = SDL_AtomicFetchAdd64(&cond->word, -SDL_FUTEX_LOW,
+                                SDL_MEMORY_ORDER_ACQUIRE);
+    if (timedout && SDL_FutexHalfValue(word, 1) == seq) {
+        retval = SDL_MUTEX_TIMEDOUT;   /* Not signaled in the meantime */
+    }
+    SDL_LockMutex(mutex);
+    mutex->recursive = recursive;
+    return retval;
+}
+
+int
+SDL_CondWait(SDL_cond * cond, SDL_mutex * mutex)
+{
+    return SDL_CondWaitTimeout(cond, mutex, SDL_MUTEX_MAXWAIT);
+}
+
+#else
+
 struct SDL_cond
 {
     pthread_cond_t cond;
@@ -155,4 +258,6 @@ SDL_CondWait(SDL_cond * cond, SDL_mutex * mutex)
     return 0;
 }
 
+#endif /* SDL_THREAD_FUTEX */
+
 /* vi: set ts=4 sw=4 expandtab: */
@@ -27,6 +27,145 @@
 #include <pthread.h>
 
 #include "SDL_thread.h"
+#include "SDL_sysmutex_c.h"
+
+#if SDL_THREAD_FUTEX
+
+void
+SDL_SpinMutexLockContended(SDL_SpinMutex * mutex)
+{
+    int i, state;
+
+    for (i = 0; i < SDL_FUTEX_SPINS; ++i) {
+        state = SDL_AtomicLoad(&mutex->state, SDL_MEMORY_ORDER_RELAXED);
+        if (state == 0 &&
+            SDL_AtomicCompareExchange(&mutex->state, &state, 1,
+                                      SDL_MEMORY_ORDER_ACQUIRE)) {
+            return;
+        }
+        if (state == 2) {
+            break;  /* Others are asleep already, don't cut in line */
+        }
+        SDL_CPUPauseInstruction();
+    }
+    /* Locked with sleepers from here on: whoever unlocks it wakes one */
+    while (SDL_AtomicExchange(&mutex->state, 2, SDL_MEMORY_ORDER_ACQUIRE) != 0) {
+        SDL_FutexWait(&mutex->state, 2, NULL);
+    }
+}
+
+void
+SDL_SpinMutexWake(SDL_SpinMutex * mutex)
+{
+    SDL_FutexWake(&mutex->state, 1);
+}
+
+SDL_mutex *
+SDL_CreateMutex(void)
+{
+    SDL_mutex *mutex = (SDL_mutex *) SDL_calloc(1, sizeof(*mutex));
+    if (!mutex) {
+        SDL_OutOfMemory();
+    }
+    return mutex;
+}
+
+void
+SDL_DestroyMutex(SDL_mutex * mutex)
+{
+    SDL_free(mutex);
+}
+
+/* Only the holder can find itself as the owner, so it's only checked,
+   set and cleared by the thread holding the lock. */
+static SDL_INLINE SDL_bool
+SDL_MutexOwned(SDL_mutex * mutex)
+{
+    return SDL_AtomicLoadPtr(&mutex->owner, SDL_MEMORY_ORDER_RELAXED) ==
+           (void *) pthread_self();
+}
+
+static SDL_INLINE void
+SDL_MutexTake(SDL_mutex * mutex)
+{
+    SDL_AtomicStorePtr(&mutex->owner, (void *) pthread_self(),
+                       SDL_MEMORY_ORDER_RELAXED);
+    mutex->recursive = 0;
+}
+
+int
+SDL_LockMutex(SDL_mutex * mutex)
+{
+    if (mutex == NULL) {
+        return SDL_SetError("Passed a NULL mutex");
+    }
+    if (SDL_MutexOwned(mutex)) {
+        ++mutex->recursive;
+        return 0;
+    }
+    SDL_SpinMutexLock(&mutex->lock);
+    SDL_MutexTake(mutex);
+    return 0;
+}
+
+int
+SDL_TryLockMutex(SDL_mutex * mutex)
+{
+    if (mutex == NULL) {
+        return SDL_SetError("Passed a NULL mutex");
+    }
+    if (SDL_MutexOwned(mutex)) {
+        ++mutex->recursive;
+        return 0;
+    }
+    if (!SDL_SpinMutexTryLock(&mutex->lock)) {
+        return SDL_MUTEX_TIMEDOUT;
+    }
+    SDL_MutexTake(mutex);
+    return 0;
+}
+
+int
+SDL_UnlockMutex(SDL_mutex * mutex)
+{
+    if (mutex == NULL) {
+        return SDL_SetError("Passed a NULL mutex");
+    }
+    if (!SDL_MutexOwned(mutex)) {
+        return SDL_SetError("mutex not owned by this thread");
+    }
+    if (mutex->recursive) {
+        --mutex->recursive;
+        return 0;
+    }
+    SDL_AtomicStorePtr(&mutex->owner, NULL, SDL_MEMORY_ORDER_RELAXED);
+    SDL_SpinMutexUnlock(&mutex->lock);
+    return 0;
+}
+
+#else
+
+#ifdef SDL_HAS_NATIVE_ATOMICS
+#include <sched.h>
+
+/* Without a futex a contended spin mutex yields until it's free. */
+void
+SDL_SpinMutexLockContended(SDL_SpinMutex * mutex)
+{
+    int unlocked = 0;
+    while (!SDL_AtomicCompareExchange(&mutex->state, &unlocked, 1,
+                                      SDL_MEMORY_ORDER_ACQUIRE)) {
+        unlocked = 0;
+        sched_yield();
+    }
+}
+
+void
+SDL_SpinMutexWake(SDL_SpinMutex * mutex)
+{
+    (void) mutex;
+}
+#endif
 
 #if !SDL_THREAD_PTHREAD_RECURSIVE_MUTEX && \
     !SDL_THREAD_PTHREAD_RECURSIVE_MUTEX_NP
@@ -192,4 +331,6 @@ SDL_UnlockMutex(SDL_mutex * mutex)
     return 0;
 }
 
+#endif /* SDL_THREAD_FUTEX */
+
 /* vi: set ts=4 sw=4 expandtab: */
@@ -23,10 +23,92 @@
 #ifndef _SDL_mutex_c_h
 #define _SDL_mutex_c_h
 
+#include "SDL_atomic.h"
+
+/* On Linux the mutex, semaphore and condition variable are futexes: an
+   uncontended lock or post never leaves user space, and a contended one spins
+   for a bounded while before going to sleep in the kernel. */
+#if defined(__LINUX__) && defined(SDL_HAS_ATOMIC64)
+#define SDL_THREAD_FUTEX 1
+#endif
+
+#if SDL_THREAD_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "SDL_endian.h"
+#include "SDL_mutex.h"
+#include "SDL_timer.h"
+
+/* Tries to take a contended lock or semaphore before sleeping. */
+#define SDL_FUTEX_SPINS 100
+
+
+/* Sleep while the word holds value, until woken or (when not NULL) the
+   relative timeout passes.  Returns 0, or -1 with errno set to EAGAIN (it
+   didn't hold value), ETIMEDOUT or EINTR. */
+static SDL_INLINE int
+SDL_FutexWait(SDL_atomic_t *word, int value, const struct timespec *timeout)
+{
+    return (int) syscall(SYS_futex, &word->value, FUTEX_WAIT_PRIVATE, value,
+                         timeout, NULL, 0);
+}
+
+/* Wake up to n threads sleeping on the word. */
+static SDL_INLINE void
+SDL_FutexWake(SDL_atomic_t *word, int n)
+{
+    syscall(SYS_futex, &word->value, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+/* The semaphore and condition variable keep a futex and the number of
+   threads that may sleep on it in the two halves of one 64-bit word.  Then a
+   post or signal checks for sleepers in the same atomic operation it updates
+   the futex with, and never touches the object after it (a woken waiter may
+   have destroyed it already, SDL_CreateThread() does). */
+#define SDL_FUTEX_LOW   ((Sint64) 1)
+#define SDL_FUTEX_HIGH  ((Sint64) 1 << 32)
+
+static SDL_INLINE SDL_atomic_t *
+SDL_FutexHalf(SDL_atomic64_t *word, int high)
+{
+    return (SDL_atomic_t *) (void *) word +
+           (high ^ (SDL_BYTEORDER == SDL_BIG_ENDIAN));
+}
+
+static SDL_INLINE int
+SDL_FutexHalfValue(Sint64 value, int high)
+{
+    return (int) (Uint32) ((Uint64) value >> (high ? 32 : 0));
+}
+
+/* The time left until end (in SDL_GetTicks), SDL_FALSE once it passed. */
+static SDL_INLINE SDL_bool
+SDL_FutexTimeLeft(Uint32 end, struct timespec *left)
+{
+    Sint32 ms = (Sint32) (end - SDL_GetTicks());
+    if (ms <= 0) {
+        return SDL_FALSE;
+    }
+    left->tv_sec = ms / 1000;
+    left->tv_nsec = (ms % 1000) * 1000000;
+    return SDL_TRUE;
+}
+
+struct SDL_mutex
+{
+    SDL_SpinMutex lock;
+    void *owner;            /* pthread_self() of the holder, atomic */
+    int recursive;          /* Times it's locked again by the holder */
+};
+#else
 struct SDL_mutex
 {
     pthread_mutex_t id;
 };
+#endif
 
 #endif /* _SDL_mutex_c_h */
 /* vi: set ts=4 sw=4 expandtab: */
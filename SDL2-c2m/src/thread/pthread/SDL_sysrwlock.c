@@ -0,0 +1,300 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "SDL_thread.h"
+#include "SDL_sysmutex_c.h"
+
+#if SDL_THREAD_FUTEX
+
+/* The state is the number of readers holding the lock, or -1 while a writer
+   does.  Readers only take it while no writer holds it or waits for it, and
+   sleep on readers_seq; writers sleep on writers_seq.  Each is bumped before
+   waking its sleepers, so a wake between a check and the sleep isn't lost
+   (the sleep sees the sequence changed). */
+struct SDL_rwlock
+{
+    SDL_atomic_t state;
+    SDL_atomic_t writers;       /* Waiting for it or holding it */
+    SDL_atomic_t readers_seq;
+    SDL_atomic_t writers_seq;
+};
+
+SDL_rwlock *
+SDL_CreateRWLock(void)
+{
+    SDL_rwlock *rwlock = (SDL_rwlock *) SDL_calloc(1, sizeof(*rwlock));
+    if (!rwlock) {
+        SDL_OutOfMemory();
+    }
+    return rwlock;
+}
+
+void
+SDL_DestroyRWLock(SDL_rwlock * rwlock)
+{
+    SDL_free(rwlock);
+}
+
+static SDL_INLINE SDL_bool
+SDL_RWLockTakeRead(SDL_rwlock * rwlock)
+{
+    int state = SDL_AtomicLoad(&rwlock->state, SDL_MEMORY_ORDER_SEQ_CST);
+    while (state >= 0 &&
+           !SDL_AtomicLoad(&rwlock->writers, SDL_MEMORY_ORDER_SEQ_CST)) {
+        if (SDL_AtomicCompareExchange(&rwlock->state, &state, state + 1,
+                                      SDL_MEMORY_ORDER_SEQ_CST)) {
+            return SDL_TRUE;
+        }
+    }
+    return SDL_FALSE;
+}
+
+static SDL_INLINE SDL_bool
+SDL_RWLockTakeWrite(SDL_rwlock * rwlock)
+{
+    int unlocked = 0;
+    return SDL_AtomicCompareExchange(&rwlock->state, &unlocked, -1,
+                                     SDL_MEMORY_ORDER_SEQ_CST);
+}
+
+static void
+SDL_RWLockWake(SDL_atomic_t * seq, int n)
+{
+    SDL_AtomicFetchAdd(seq, 1, SDL_MEMORY_ORDER_SEQ_CST);
+    SDL_FutexWake(seq, n);
+}
+
+int
+SDL_LockRWLockForReading(SDL_rwlock * rwlock)
+{
+    int i, seq;
+
+    if (!rwlock) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    for (i = 0; i < SDL_FUTEX_SPINS; ++i) {
+        if (SDL_RWLockTakeRead(rwlock)) {
+            return 0;
+        }
+        SDL_CPUPauseInstruction();
+    }
+    for (;;) {
+        seq = SDL_AtomicLoad(&rwlock->readers_seq, SDL_MEMORY_ORDER_SEQ_CST);
+        if (SDL_RWLockTakeRead(rwlock)) {
+            return 0;
+        }
+        SDL_FutexWait(&rwlock->readers_seq, seq, NULL);
+    }
+}
+
+int
+SDL_LockRWLockForWriting(SDL_rwlock * rwlock)
+{
+    int i, seq;
+
+    if (!rwlock) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    /* Counted first, so no new reader gets in */
+    SDL_AtomicFetchAdd(&rwlock->writers, 1, SDL_MEMORY_ORDER_SEQ_CST);
+    for (i = 0; i < SDL_FUTEX_SPINS; ++i) {
+        if (SDL_RWLockTakeWrite(rwlock)) {
+            return 0;
+        }
+        SDL_CPUPauseInstruction();
+    }
+    for (;;) {
+        seq = SDL_AtomicLoad(&rwlock->writers_seq, SDL_MEMORY_ORDER_SEQ_CST);
+        if (SDL_RWLockTakeWrite(rwlock)) {
+            return 0;
+        }
+        SDL_FutexWait(&rwlock->writers_seq, seq, NULL);
+    }
+}
+
+int
+SDL_TryLockRWLockForReading(SDL_rwlock * rwlock)
+{
+    if (!rwlock) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    return SDL_RWLockTakeRead(rwlock) ? 0 : SDL_MUTEX_TIMEDOUT;
+}
+
+int
+SDL_TryLockRWLockForWriting(SDL_rwlock * rwlock)
+{
+    if (!rwlock) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    SDL_AtomicFetchAdd(&rwlock->writers, 1, SDL_MEMORY_ORDER_SEQ_CST);
+    if (SDL_RWLockTakeWrite(rwlock)) {
+        return 0;
+    }
+    /* Readers may have waited behind it meanwhile */
+    if (SDL_AtomicFetchAdd(&rwlock->writers, -1, SDL_MEMORY_ORDER_SEQ_CST) == 1) {
+        SDL_RWLockWake(&rwlock->readers_seq, INT_MAX);
+    }
+    return SDL_MUTEX_TIMEDOUT;
+}
+
+/* A writer hands the lock to the next writer if there is one, else to all of
+   the readers; the last reader out hands it to a writer. */
+int
+SDL_UnlockRWLock(SDL_rwlock * rwlock)
+{
+    if (!rwlock) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    if (SDL_AtomicLoad(&rwlock->state, SDL_MEMORY_ORDER_RELAXED) < 0) {
+        SDL_AtomicStore(&rwlock->state, 0, SDL_MEMORY_ORDER_SEQ_CST);
+        if (SDL_AtomicFetchAdd(&rwlock->writers, -1, SDL_MEMORY_ORDER_SEQ_CST) > 1) {
+            SDL_RWLockWake(&rwlock->writers_seq, 1);
+        } else {
+            SDL_RWLockWake(&rwlock->readers_seq, INT_MAX);
+        }
+    } else if (SDL_AtomicFetchAdd(&rwlock->state, -1, SDL_MEMORY_ORDER_SEQ_CST) == 1 &&
+               SDL_AtomicLoad(&rwlock->writers, SDL_MEMORY_ORDER_SEQ_CST)) {
+        SDL_RWLockWake(&rwlock->writers_seq, 1);
+    }
+    return 0;
+}
+
+#else
+
+/* Wrapper around POSIX reader-writer locks */
+
+struct SDL_rwlock
+{
+    pthread_rwlock_t id;
+};
+
+SDL_rwlock *
+SDL_CreateRWLock(void)
+{
+    SDL_rwlock *rwlock = (SDL_rwlock *) SDL_malloc(sizeof(*rwlock));
+    pthread_rwlockattr_t attr;
+
+    if (!rwlock) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    pthread_rwlockattr_setkind_np(&attr,
+        PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    if (pthread_rwlock_init(&rwlock->id, &attr) != 0) {
+        SDL_SetError("pthread_rwlock_init() failed");
+        SDL_free(rwlock);
+        rwlock = NULL;
+    }
+    pthread_rwlockattr_destroy(&attr);
+    return rwlock;
+}
+
+void
+SDL_DestroyRWLock(SDL_rwlock * rwlock)
+{
+    if (rwlock) {
+        pthread_rwlock_destroy(&rwlock->id);
+        SDL_free(rwlock);
+    }
+}
+
+int
+SDL_LockRWLockForReading(SDL_rwlock * rwlock)
+{
+    if (!rwlock) {
+        return SDL_SetError("Passed a NULL rwlock");
+    } else if (pthread_rwlock_rdlock(&rwlock->id) != 0) {
+        return SDL_SetError("pthread_rwlock_rdlock() failed");
+    }
+    return 0;
+}
+
+int
+SDL_LockRWLockForWriting(SDL_rwlock * rwlock)
+{
+    if (!rwlock) {
+        return SDL_SetError("Passed a NULL rwlock");
+    } else if (pthread_rwlock_wrlock(&rwlock->id) != 0) {
+        return SDL_SetError("pthread_rwlock_wrlock() failed");
+    }
+    return 0;
+}
+
+int
+SDL_TryLockRWLockForReading(SDL_rwlock * rwlock)
+{
+    int retval;
+
+    if (!rwlock) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    retval = pthread_rwlock_tryrdlock(&rwlock->id);
+    if (retval == EBUSY || retval == EAGAIN) {
+        return SDL_MUTEX_TIMEDOUT;
+    } else if (retval != 0) {
+        return SDL_SetError("pthread_rwlock_tryrdlock() failed");
+    }
+    return 0;
+}
+
+int
+SDL_TryLockRWLockForWriting(SDL_rwlock * rwlock)
+{
+    int retval;
+
+    if (!rwlock) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    retval = pthread_rwlock_trywrlock(&rwlock->id);
+    if (retval == EBUSY) {
+        return SDL_MUTEX_TIMEDOUT;
+    } else if (retval != 0) {
+        return SDL_SetError("pthread_rwlock_trywrlock() failed");
+    }
+    return 0;
+}
+
+int
+SDL_UnlockRWLock(SDL_rwlock * rwlock)
+{
+    if (!rwlock) {
+        return SDL_SetError("Passed a NULL rwlock");
+    } else if (pthread_rwlock_unlock(&rwlock->id) != 0) {
+        return SDL_SetError("pthread_rwlock_unlock() failed");
+    }
+    return 0;
+}
+
+#endif /* SDL_THREAD_FUTEX */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -31,12 +31,139 @@
 
 #include "SDL_thread.h"
 #include "SDL_timer.h"
+#include "SDL_sysmutex_c.h"
 
 /* Wrapper around POSIX 1003.1b semaphores */
 
 #if defined(__MACOSX__) || defined(__IPHONEOS__)
 /* Mac OS X doesn't support sem_getvalue() as of version 10.4 */
 #include "../generic/SDL_syssem.c"
+#elif SDL_THREAD_FUTEX
+
+/* The count is the futex (the word's low half), waiters sleep while it's 0
+   and count themselves in the high half.  A post only enters the kernel when
+   someone might be asleep. */
+struct SDL_semaphore
+{
+    SDL_atomic64_t word;
+};
+
+SDL_sem *
+SDL_CreateSemaphore(Uint32 initial_value)
+{
+    SDL_sem *sem = (SDL_sem *) SDL_malloc(sizeof(SDL_sem));
+    if (sem) {
+        SDL_AtomicStore64(&sem->word, (Sint64) initial_value,
+                          SDL_MEMORY_ORDER_RELAXED);
+    } else {
+        SDL_OutOfMemory();
+    }
+    return sem;
+}
+
+void
+SDL_DestroySemaphore(SDL_sem * sem)
+{
+    SDL_free(sem);
+}
+
+/* Take one if the count in word (the last value seen) is positive, a waiter
+   stops counting itself (less) at the same time. */
+static SDL_INLINE SDL_bool
+SDL_SemTake(SDL_sem * sem, Sint64 word, Sint64 less)
+{
+    while (SDL_FutexHalfValue(word, 0) > 0) {
+        if (SDL_AtomicCompareExchange64(&sem->word, &word,
+                                        word - SDL_FUTEX_LOW - less,
+                                        SDL_MEMORY_ORDER_ACQUIRE)) {
+            return SDL_TRUE;
+        }
+    }
+    return SDL_FALSE;
+}
+
+int
+SDL_SemTryWait(SDL_sem * sem)
+{
+    if (!sem) {
+        return SDL_SetError("Passed a NULL semaphore");
+    }
+    return SDL_SemTake(sem, SDL_AtomicLoad64(&sem->word,
+                                             SDL_MEMORY_ORDER_RELAXED), 0) ?
+           0 : SDL_MUTEX_TIMEDOUT;
+}
+
+int
+SDL_SemWaitTimeout(SDL_sem * sem, Uint32 timeout)
+{
+    struct timespec left;
+    Uint32 end = 0;
+    Sint64 word;
+    int i;
+
+    if (!sem) {
+        return SDL_SetError("Passed a NULL semaphore");
+    }
+    if (timeout != 0 && timeout != SDL_MUTEX_MAXWAIT) {
+        end = SDL_GetTicks() + timeout;
+    }
+    for (i = 0; i < SDL_FUTEX_SPINS; ++i) {
+        word = SDL_AtomicLoad64(&sem->word, SDL_MEMORY_ORDER_RELAXED);
+        if (SDL_SemTake(sem, word, 0)) {
+            return 0;
+        }
+        if (timeout == 0) {
+            return SDL_MUTEX_TIMEDOUT;
+        }
+        SDL_CPUPauseInstruction();
+    }
+    word = SDL_AtomicFetchAdd64(&sem->word, SDL_FUTEX_HIGH,
+                                SDL_MEMORY_ORDER_RELAXED) + SDL_FUTEX_HIGH;
+    while (!SDL_SemTake(sem, word, SDL_FUTEX_HIGH)) {
+        if (timeout == SDL_MUTEX_MAXWAIT) {
+            SDL_FutexWait(SDL_FutexHalf(&sem->word, 0), 0, NULL);
+        } else if (SDL_FutexTimeLeft(end, &left)) {
+            SDL_FutexWait(SDL_FutexHalf(&sem->word, 0), 0, &left);
+        } else {
+            SDL_AtomicFetchAdd64(&sem->word, -SDL_FUTEX_HIGH,
+                                 SDL_MEMORY_ORDER_RELAXED);
+            return SDL_MUTEX_TIMEDOUT;
+        }
+        word = SDL_AtomicLoad64(&sem->word, SDL_MEMORY_ORDER_RELAXED);
+    }
+    return 0;
+}
+
+int
+SDL_SemWait(SDL_sem * sem)
+{
+    return SDL_SemWaitTimeout(sem, SDL_MUTEX_MAXWAIT);
+}
+
+Uint32
+SDL_SemValue(SDL_sem * sem)
+{
+    return sem ? (Uint32) SDL_FutexHalfValue(
+                     SDL_AtomicLoad64(&sem->word, SDL_MEMORY_ORDER_RELAXED), 0)
+               : 0;
+}
+
+int
+SDL_SemPost(SDL_sem * sem)
+{
+    Sint64 word;
+
+    if (!sem) {
+        return SDL_SetError("Passed a NULL semaphore");
+    }
+    word = SDL_AtomicFetchAdd64(&sem->word, SDL_FUTEX_LOW,
+                                SDL_MEMORY_ORDER_RELEASE);
+    if (SDL_FutexHalfValue(word, 1)) {
+        SDL_FutexWake(SDL_FutexHalf(&sem->word, 0), 1);
+    }
+    return 0;
+}
+
 #else
 
 struct SDL_semaphore
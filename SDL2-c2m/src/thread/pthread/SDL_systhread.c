@@ -21,6 +21,9 @@
 
 #include "../../SDL_internal.h"
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <pthread.h>
 
 #if HAVE_PTHREAD_NP_H
@@ -232,6 +235,35 @@ SDL_SYS_SetThreadPriority(SDL_ThreadPriority priority)
 #endif /* linux */
 }
 
+int
+SDL_SYS_SetThreadAffinity(const int *cpus, int count)
+{
+#if __LINUX__ && defined(CPU_SET)
+    cpu_set_t set;
+    int i;
+
+    CPU_ZERO(&set);
+    if (!count) {
+        for (i = 0; i < CPU_SETSIZE; ++i) {
+            CPU_SET(i, &set);
+        }
+    }
+    for (i = 0; i < count; ++i) {
+        if (cpus[i] < CPU_SETSIZE) {
+            CPU_SET(cpus[i], &set);
+        }
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        return SDL_SetError("pthread_setaffinity_np() failed");
+    }
+    return 0;
+#else
+    (void) cpus;
+    (void) count;
+    return SDL_Unsupported();
+#endif /* linux */
+}
+
 void
 SDL_SYS_WaitThread(SDL_Thread * thread)
 {
@@ -24,6 +24,26 @@
 
 #include <pthread.h>
 
+#ifdef SDL_THREAD_LOCAL
+
+/* A thread local variable: no key to create on first use, and no call to
+   get or set it */
+static SDL_THREAD_LOCAL SDL_TLSData *SDL_tls_data;
+
+SDL_TLSData *
+SDL_SYS_GetTLSData()
+{
+    return SDL_tls_data;
+}
+
+int
+SDL_SYS_SetTLSData(SDL_TLSData *data)
+{
+    SDL_tls_data = data;
+    return 0;
+}
+
+#else
 
 #define INVALID_PTHREAD_KEY ((pthread_key_t)-1)
 
@@ -66,4 +86,6 @@ SDL_SYS_SetTLSData(SDL_TLSData *data)
     return 0;
 }
 
+#endif /* SDL_THREAD_LOCAL */
+
 /* vi: set ts=4 sw=4 expandtab: */
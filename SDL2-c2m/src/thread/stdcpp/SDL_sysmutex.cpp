@@ -27,6 +27,7 @@ extern "C" {
 }
 
 #include <system_error>
+#include <thread>
 
 #include "SDL_sysmutex_c.h"
 #include <Windows.h>
@@ -108,4 +109,26 @@ SDL_mutexV(SDL_mutex * mutex)
     return 0;
 }
 
+#ifdef SDL_HAS_NATIVE_ATOMICS
+/* A contended spin mutex yields until it's free. */
+extern "C"
+void
+SDL_SpinMutexLockContended(SDL_SpinMutex * mutex)
+{
+    int unlocked = 0;
+    while (!SDL_AtomicCompareExchange(&mutex->state, &unlocked, 1,
+                                      SDL_MEMORY_ORDER_ACQUIRE)) {
+        unlocked = 0;
+        std::this_thread::yield();
+    }
+}
+
+extern "C"
+void
+SDL_SpinMutexWake(SDL_SpinMutex * mutex)
+{
+    (void) mutex;
+}
+#endif
+
 /* vi: set ts=4 sw=4 expandtab: */
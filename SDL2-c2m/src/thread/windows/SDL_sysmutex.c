@@ -105,6 +105,26 @@ SDL_UnlockMutex(SDL_mutex * mutex)
     return (0);
 }
 
+#ifdef SDL_HAS_NATIVE_ATOMICS
+/* A contended spin mutex yields until it's free. */
+void
+SDL_SpinMutexLockContended(SDL_SpinMutex * mutex)
+{
+    int unlocked = 0;
+    while (!SDL_AtomicCompareExchange(&mutex->state, &unlocked, 1,
+                                      SDL_MEMORY_ORDER_ACQUIRE)) {
+        unlocked = 0;
+        SwitchToThread();
+    }
+}
+
+void
+SDL_SpinMutexWake(SDL_SpinMutex * mutex)
+{
+    (void) mutex;
+}
+#endif
+
 #endif /* SDL_THREAD_WINDOWS */
 
 /* vi: set ts=4 sw=4 expandtab: */
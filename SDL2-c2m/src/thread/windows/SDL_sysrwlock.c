@@ -0,0 +1,120 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#if SDL_THREAD_WINDOWS
+
+/* Reader-writer lock functions using slim reader-writer locks: SRW locks
+   don't say which way they're held, so the owner marks it while writing. */
+
+#include "../../core/windows/SDL_windows.h"
+
+#include "SDL_mutex.h"
+
+
+struct SDL_rwlock
+{
+    SRWLOCK srw;
+    DWORD writer;   /* Thread id of the writer holding it, else 0 */
+};
+
+SDL_rwlock *
+SDL_CreateRWLock(void)
+{
+    SDL_rwlock *rwlock = (SDL_rwlock *) SDL_malloc(sizeof(*rwlock));
+    if (rwlock) {
+        InitializeSRWLock(&rwlock->srw);
+        rwlock->writer = 0;
+    } else {
+        SDL_OutOfMemory();
+    }
+    return rwlock;
+}
+
+void
+SDL_DestroyRWLock(SDL_rwlock * rwlock)
+{
+    /* SRW locks need no cleanup */
+    SDL_free(rwlock);
+}
+
+int
+SDL_LockRWLockForReading(SDL_rwlock * rwlock)
+{
+    if (rwlock == NULL) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    AcquireSRWLockShared(&rwlock->srw);
+    return 0;
+}
+
+int
+SDL_LockRWLockForWriting(SDL_rwlock * rwlock)
+{
+    if (rwlock == NULL) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    AcquireSRWLockExclusive(&rwlock->srw);
+    rwlock->writer = GetCurrentThreadId();
+    return 0;
+}
+
+int
+SDL_TryLockRWLockForReading(SDL_rwlock * rwlock)
+{
+    if (rwlock == NULL) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    return TryAcquireSRWLockShared(&rwlock->srw) ? 0 : SDL_MUTEX_TIMEDOUT;
+}
+
+int
+SDL_TryLockRWLockForWriting(SDL_rwlock * rwlock)
+{
+    if (rwlock == NULL) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    if (!TryAcquireSRWLockExclusive(&rwlock->srw)) {
+        return SDL_MUTEX_TIMEDOUT;
+    }
+    rwlock->writer = GetCurrentThreadId();
+    return 0;
+}
+
+int
+SDL_UnlockRWLock(SDL_rwlock * rwlock)
+{
+    if (rwlock == NULL) {
+        return SDL_SetError("Passed a NULL rwlock");
+    }
+    /* Only the writer can see its own id here, readers can't race it */
+    if (rwlock->writer == GetCurrentThreadId()) {
+        rwlock->writer = 0;
+        ReleaseSRWLockExclusive(&rwlock->srw);
+    } else {
+        ReleaseSRWLockShared(&rwlock->srw);
+    }
+    return 0;
+}
+
+#endif /* SDL_THREAD_WINDOWS */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -227,6 +227,33 @@ SDL_SYS_SetThreadPriority(SDL_ThreadPriority priority)
     return 0;
 }
 
+/* Only CPUs of the first processor group, up to 64 */
+int
+SDL_SYS_SetThreadAffinity(const int *cpus, int count)
+{
+    DWORD_PTR mask = 0;
+    int i;
+
+    if (!count) {
+        DWORD_PTR system;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &system)) {
+            return WIN_SetError("GetProcessAffinityMask()");
+        }
+    }
+    for (i = 0; i < count; ++i) {
+        if (cpus[i] < (int)(sizeof(mask) * 8)) {
+            mask |= (DWORD_PTR)1 << cpus[i];
+        }
+    }
+    if (!mask) {
+        return SDL_InvalidParamError("cpus");
+    }
+    if (!SetThreadAffinityMask(GetCurrentThread(), mask)) {
+        return WIN_SetError("SetThreadAffinityMask()");
+    }
+    return 0;
+}
+
 void
 SDL_SYS_WaitThread(SDL_Thread * thread)
 {
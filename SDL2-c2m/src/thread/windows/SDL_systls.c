@@ -28,6 +28,27 @@
 #include "SDL_thread.h"
 #include "../SDL_thread_c.h"
 
+#ifdef SDL_THREAD_LOCAL
+
+/* A thread local variable: no key to create on first use, and no call to
+   get or set it */
+static SDL_THREAD_LOCAL SDL_TLSData *SDL_tls_data;
+
+SDL_TLSData *
+SDL_SYS_GetTLSData()
+{
+    return SDL_tls_data;
+}
+
+int
+SDL_SYS_SetTLSData(SDL_TLSData *data)
+{
+    SDL_tls_data = data;
+    return 0;
+}
+
+#else
+
 static DWORD thread_local_storage = TLS_OUT_OF_INDEXES;
 static SDL_bool generic_local_storage = SDL_FALSE;
 
@@ -67,6 +88,8 @@ SDL_SYS_SetTLSData(SDL_TLSData *data)
     return 0;
 }
 
+#endif /* SDL_THREAD_LOCAL */
+
 #endif /* SDL_THREAD_WINDOWS */
 
 /* vi: set ts=4 sw=4 expandtab: */
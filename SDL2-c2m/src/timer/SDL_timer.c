@@ -26,6 +26,14 @@
 #include "SDL_cpuinfo.h"
 #include "SDL_thread.h"
 
+#if defined(SDL_TIMER_UNIX) && HAVE_CLOCK_GETTIME
+#include <errno.h>
+#include <time.h>
+#ifdef TIMER_ABSTIME
+#define SDL_PRECISE_ABSTIME 1
+#endif
+#endif
+
 /* #define DEBUG_TIMERS */
 
 typedef struct _SDL_Timer
@@ -386,4 +394,135 @@ SDL_RemoveTimer(SDL_TimerID id)
     return canceled;
 }
 
+/* SDL_DelayPrecise() sleeps until "slack" before the deadline, then spins.
+   The slack grows to cover the worst oversleep seen, and slowly decays back
+   when the scheduler wakes us on time.
+ */
+#define SDL_PRECISE_SLACK_MIN   20000
+#define SDL_PRECISE_SLACK_MAX   2000000
+static SDL_atomic_t SDL_precise_slack = { 200000 };
+
+struct SDL_FramePacer
+{
+    Uint64 period;
+    Uint64 next;
+};
+
+static Uint64
+SDL_PreciseNow(void)
+{
+#if SDL_PRECISE_ABSTIME
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (Uint64)now.tv_sec * 1000000000 + now.tv_nsec;
+#else
+    Uint64 count = SDL_GetPerformanceCounter();
+    Uint64 freq = SDL_GetPerformanceFrequency();
+
+    return (count / freq) * 1000000000 + (count % freq) * 1000000000 / freq;
+#endif
+}
+
+/* Sleep until about `when`, never much after it */
+static void
+SDL_SleepUntil(Uint64 when)
+{
+#if SDL_PRECISE_ABSTIME
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(when / 1000000000);
+    ts.tv_nsec = (long)(when % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        continue;
+    }
+#else
+    Uint64 now = SDL_PreciseNow();
+
+    if (when > now) {
+        SDL_Delay((Uint32)((when - now) / 1000000));
+    }
+#endif
+}
+
+static void
+SDL_DelayUntilPrecise(Uint64 deadline)
+{
+    Uint64 slack = (Uint64)SDL_AtomicGet(&SDL_precise_slack);
+    Uint64 now = SDL_PreciseNow();
+
+    if (deadline > now + slack) {
+        Uint64 wake = deadline - slack;
+        Uint64 late, floor;
+
+        SDL_SleepUntil(wake);
+        now = SDL_PreciseNow();
+        late = (now > wake) ? (now - wake) : 0;
+        floor = late + late / 4;
+        if (late >= slack) {
+            slack = SDL_min(floor, SDL_PRECISE_SLACK_MAX);
+        } else {
+            slack -= slack / 16;
+            slack = SDL_max(slack, SDL_max(floor, SDL_PRECISE_SLACK_MIN));
+        }
+        SDL_AtomicSet(&SDL_precise_slack, (int)slack);
+    }
+    while (now < deadline) {
+        SDL_CPUPauseInstruction();
+        now = SDL_PreciseNow();
+    }
+}
+
+void
+SDL_DelayPrecise(Uint64 ns)
+{
+    SDL_DelayUntilPrecise(SDL_PreciseNow() + ns);
+}
+
+SDL_FramePacer *
+SDL_CreateFramePacer(Uint64 period_ns)
+{
+    SDL_FramePacer *pacer;
+
+    if (!period_ns) {
+        SDL_InvalidParamError("period_ns");
+        return NULL;
+    }
+    pacer = (SDL_FramePacer *)SDL_malloc(sizeof(*pacer));
+    if (!pacer) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    pacer->period = period_ns;
+    pacer->next = SDL_PreciseNow() + period_ns;
+    return pacer;
+}
+
+int
+SDL_FramePacerWait(SDL_FramePacer *pacer)
+{
+    Uint64 now;
+    int dropped = 0;
+
+    if (!pacer) {
+        return SDL_InvalidParamError("pacer");
+    }
+    SDL_DelayUntilPrecise(pacer->next);
+    now = SDL_PreciseNow();
+    pacer->next += pacer->period;
+    if (now >= pacer->next) {
+        /* Missed whole frames: skip them, keeping the phase */
+        Uint64 missed = (now - pacer->next) / pacer->period + 1;
+        pacer->next += missed * pacer->period;
+        dropped = (int)SDL_min(missed, 0x7FFFFFFF);
+    }
+    return dropped;
+}
+
+void
+SDL_DestroyFramePacer(SDL_FramePacer *pacer)
+{
+    SDL_free(pacer);
+}
+
 /* vi: set ts=4 sw=4 expandtab: */
@@ -77,6 +77,18 @@ SDL_GetPerformanceFrequency(void)
     return 1000;
 }
 
+Uint64
+SDL_GetFastPerformanceCounter(void)
+{
+    return SDL_GetPerformanceCounter();
+}
+
+Uint64
+SDL_GetFastPerformanceFrequency(void)
+{
+    return SDL_GetPerformanceFrequency();
+}
+
 void SDL_Delay(Uint32 ms)
 {
     const Uint32 max_delay = 0xffffffffUL / 1000;
@@ -29,6 +29,9 @@
 
 #include "SDL_timer.h"
 #include "SDL_assert.h"
+#include "SDL_atomic.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_hints.h"
 
 /* The clock_gettime provides monotonous time, so we should use it if
    it's available. The clock_gettime function is behind ifdef
@@ -68,6 +71,89 @@ static SDL_bool has_monotonic_time = SDL_FALSE;
 static struct timeval start_tv;
 static SDL_bool ticks_started = SDL_FALSE;
 
+/* The fast counter is the TSC on x86 Linux when the kernel reports it runs
+   at a constant rate through frequency changes and sleep states
+   (constant_tsc and nonstop_tsc).  Its rate is measured against the
+   monotonic clock: from a reading taken at SDL_TicksInit() to one at least
+   SDL_TSC_CALIBRATION ns later, waiting for it the first time if need be.
+   Otherwise the fast counter is SDL_GetPerformanceCounter().
+ */
+#if HAVE_CLOCK_GETTIME && defined(__linux__) && defined(__GNUC__) && \
+    (defined(__i386__) || defined(__x86_64__))
+#define SDL_TIMER_TSC 1
+#define SDL_TSC_CALIBRATION 20000000
+
+static SDL_bool has_tsc = SDL_FALSE;
+static Uint64 tsc_start;
+static Uint64 tsc_start_ns;
+static Uint64 tsc_frequency;
+static SDL_atomic_t tsc_calibrated;
+
+static SDL_INLINE Uint64
+SDL_ReadTSC(void)
+{
+    Uint32 lo, hi;
+
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((Uint64) hi << 32) | lo;
+}
+
+static Uint64
+SDL_MonotonicNS(void)
+{
+    struct timespec now;
+
+    clock_gettime(SDL_MONOTONIC_CLOCK, &now);
+    return (Uint64) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static SDL_bool
+SDL_HasInvariantTSC(void)
+{
+    const char *hint = SDL_GetHint(SDL_HINT_TIMER_TSC);
+    SDL_bool invariant = SDL_FALSE;
+    char line[8192];
+    FILE *cpuinfo;
+
+    if ((hint && *hint == '0') || !SDL_HasRDTSC()) {
+        return SDL_FALSE;
+    }
+    cpuinfo = fopen("/proc/cpuinfo", "r");
+    if (!cpuinfo) {
+        return SDL_FALSE;
+    }
+    while (fgets(line, sizeof (line), cpuinfo)) {
+        if (SDL_strncmp(line, "flags", 5) == 0) {
+            invariant = SDL_strstr(line, " constant_tsc") &&
+                        SDL_strstr(line, " nonstop_tsc");
+            break;
+        }
+    }
+    fclose(cpuinfo);
+    return invariant;
+}
+
+static void
+SDL_CalibrateTSC(void)
+{
+    static SDL_SpinLock lock;
+    Uint64 elapsed;
+
+    SDL_AtomicLock(&lock);
+    if (!SDL_AtomicGet(&tsc_calibrated)) {
+        elapsed = SDL_MonotonicNS() - tsc_start_ns;
+        if (elapsed < SDL_TSC_CALIBRATION) {
+            SDL_Delay((Uint32) ((SDL_TSC_CALIBRATION - elapsed) / 1000000) + 1);
+        }
+        elapsed = SDL_MonotonicNS() - tsc_start_ns;
+        tsc_frequency = (Uint64) ((double) (SDL_ReadTSC() - tsc_start) *
+                                  1000000000.0 / (double) elapsed + 0.5);
+        SDL_AtomicSet(&tsc_calibrated, 1);
+    }
+    SDL_AtomicUnlock(&lock);
+}
+#endif /* SDL_TIMER_TSC */
+
 void
 SDL_TicksInit(void)
 {
@@ -91,6 +177,15 @@ SDL_TicksInit(void)
     {
         gettimeofday(&start_tv, NULL);
     }
+
+#if SDL_TIMER_TSC
+    has_tsc = has_monotonic_time && SDL_HasInvariantTSC();
+    if (has_tsc) {
+        SDL_AtomicSet(&tsc_calibrated, 0);
+        tsc_start_ns = SDL_MonotonicNS();
+        tsc_start = SDL_ReadTSC();
+    }
+#endif
 }
 
 void
@@ -183,6 +278,39 @@ SDL_GetPerformanceFrequency(void)
     return 1000000;
 }
 
+Uint64
+SDL_GetFastPerformanceCounter(void)
+{
+    if (!ticks_started) {
+        SDL_TicksInit();
+    }
+
+#if SDL_TIMER_TSC
+    if (has_tsc) {
+        return SDL_ReadTSC();
+    }
+#endif
+    return SDL_GetPerformanceCounter();
+}
+
+Uint64
+SDL_GetFastPerformanceFrequency(void)
+{
+    if (!ticks_started) {
+        SDL_TicksInit();
+    }
+
+#if SDL_TIMER_TSC
+    if (has_tsc) {
+        if (!SDL_AtomicGet(&tsc_calibrated)) {
+            SDL_CalibrateTSC();
+        }
+        return tsc_frequency;
+    }
+#endif
+    return SDL_GetPerformanceFrequency();
+}
+
 void
 SDL_Delay(Uint32 ms)
 {
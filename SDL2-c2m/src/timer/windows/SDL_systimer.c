@@ -167,6 +167,18 @@ SDL_GetPerformanceFrequency(void)
     return frequency.QuadPart;
 }
 
+Uint64
+SDL_GetFastPerformanceCounter(void)
+{
+    return SDL_GetPerformanceCounter();
+}
+
+Uint64
+SDL_GetFastPerformanceFrequency(void)
+{
+    return SDL_GetPerformanceFrequency();
+}
+
 void
 SDL_Delay(Uint32 ms)
 {
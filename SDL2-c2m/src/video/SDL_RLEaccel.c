@@ -100,6 +100,115 @@
 #define PIXEL_COPY(to, from, len, bpp)          \
     SDL_memcpy(to, from, (size_t)(len) * (bpp))
 
+/*
+ * SSE2 blenders for the 32 bit 888 runs, working out the same pixels as the
+ * macros below four at a time; they return how many pixels they did, and
+ * the macros do the rest. Opaque runs go to SDL_memcpy(), which already
+ * uses the widest copies the CPU has.
+ */
+#if defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SDL_RLE_X86 1
+#include <immintrin.h>
+#endif
+
+#if SDL_RLE_X86
+/* The low 32 bits of x * a in each lane, for a below 0x10000 in both
+   halves of the lane; SSE2 has no 32 bit multiply */
+__attribute__((target("sse2"))) static SDL_INLINE __m128i
+RLEMul32SSE2(__m128i x, __m128i a)
+{
+    return _mm_add_epi32(_mm_mullo_epi16(x, a),
+                         _mm_slli_epi32(_mm_mulhi_epu16(x, a), 16));
+}
+
+/* d + ((s - d) * a >> 8) for the 0xff00ff and 0xff00 components, the same
+   32 bit arithmetic as ALPHA_BLIT32_888 and BLIT_TRANSL_888 */
+__attribute__((target("sse2"))) static SDL_INLINE __m128i
+RLEBlend888SSE2(__m128i s, __m128i d, __m128i a)
+{
+    const __m128i rb = _mm_set1_epi32(0xff00ff);
+    const __m128i g = _mm_set1_epi32(0xff00);
+    __m128i s1 = _mm_and_si128(s, rb);
+    __m128i d1 = _mm_and_si128(d, rb);
+
+    d1 = _mm_add_epi32(d1, _mm_srli_epi32(RLEMul32SSE2(_mm_sub_epi32(s1, d1), a), 8));
+    s = _mm_and_si128(s, g);
+    d = _mm_and_si128(d, g);
+    d = _mm_add_epi32(d, _mm_srli_epi32(RLEMul32SSE2(_mm_sub_epi32(s, d), a), 8));
+    return _mm_or_si128(_mm_and_si128(d1, rb), _mm_and_si128(d, g));
+}
+
+/* ALPHA_BLIT32_888 */
+__attribute__((target("sse2"))) static int
+RLEAlphaBlit888SSE2(Uint32 * dst, const Uint32 * src, int n, unsigned alpha)
+{
+    const __m128i a = _mm_set1_epi16((short) alpha);
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+
+        _mm_storeu_si128((__m128i *) (dst + i), RLEBlend888SSE2(s, d, a));
+    }
+    return i;
+}
+
+/* ALPHA_BLIT32_888_50: the rounded up average less the bit it rounded */
+__attribute__((target("sse2"))) static int
+RLEAlphaBlit888_50SSE2(Uint32 * dst, const Uint32 * src, int n)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i rgb = _mm_set1_epi32(0x00ffffff);
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(s, d),
+                                   _mm_and_si128(_mm_xor_si128(s, d), one));
+
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_and_si128(avg, rgb));
+    }
+    return i;
+}
+
+/* BLIT_TRANSL_888, with each pixel's alpha in its top 8 bits */
+__attribute__((target("sse2"))) static int
+RLEBlitTransl888SSE2(Uint32 * dst, const Uint32 * src, int n)
+{
+    const __m128i opaque = _mm_set1_epi32(0xff000000);
+    int i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i a = _mm_srli_epi32(s, 24);
+
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+        _mm_storeu_si128((__m128i *) (dst + i),
+                         _mm_or_si128(RLEBlend888SSE2(s, d, a), opaque));
+    }
+    return i;
+}
+
+/* These want a 'simd' from SDL_GetBlitCPUFeatures() where they're used */
+#define SIMD_ALPHA_BLIT32_888(dst, src, n, alpha)   \
+    ((simd & SDL_CPU_SSE2) ? RLEAlphaBlit888SSE2(dst, src, n, alpha) : 0)
+#define SIMD_ALPHA_BLIT32_888_50(dst, src, n)       \
+    ((simd & SDL_CPU_SSE2) ? RLEAlphaBlit888_50SSE2(dst, src, n) : 0)
+#define SIMD_BLIT_TRANSL_888(dst, src, n)           \
+    ((simd & SDL_CPU_SSE2) ? RLEBlitTransl888SSE2(dst, src, n) : 0)
+#else
+#define SIMD_ALPHA_BLIT32_888(dst, src, n, alpha)   0
+#define SIMD_ALPHA_BLIT32_888_50(dst, src, n)       0
+#define SIMD_BLIT_TRANSL_888(dst, src, n)           0
+#endif /* SDL_RLE_X86 */
+
+/* For the blenders without a SIMD version */
+#define SIMD_BLIT_TRANSL_NONE(dst, src, n)          0
+
 /*
  * Various colorkey blit methods, for opaque and per-surface alpha
  */
@@ -119,7 +228,10 @@
         int i;                                              \
         Uint32 *src = (Uint32 *)(from);                     \
         Uint32 *dst = (Uint32 *)(to);                       \
-        for (i = 0; i < (int)(length); i++) {               \
+        i = SIMD_ALPHA_BLIT32_888(dst, src, length, alpha); \
+        src += i;                                           \
+        dst += i;                                           \
+        for (; i < (int)(length); i++) {                    \
             Uint32 s = *src++;                              \
             Uint32 d = *dst;                                \
             Uint32 s1 = s & 0xff00ff;                       \
@@ -245,7 +357,10 @@
         int i;                                                  \
         Uint32 *src = (Uint32 *)(from);                         \
         Uint32 *dst = (Uint32 *)(to);                           \
-        for(i = 0; i < (int)(length); i++) {                    \
+        i = SIMD_ALPHA_BLIT32_888_50(dst, src, length);         \
+        src += i;                                               \
+        dst += i;                                               \
+        for(; i < (int)(length); i++) {                         \
             Uint32 s = *src++;                                  \
             Uint32 d = *dst;                                    \
             *dst++ = (((s & 0x00fefefe) + (d & 0x00fefefe)) >> 1) \
@@ -391,7 +506,7 @@
  */
 static void
 RLEClipBlit(int w, Uint8 * srcbuf, SDL_Surface * surf_dst,
-            Uint8 * dstbuf, SDL_Rect * srcrect, unsigned alpha)
+            Uint8 * dstbuf, SDL_Rect * srcrect, unsigned alpha, Uint32 simd)
 {
     SDL_PixelFormat *fmt = surf_dst->format;
 
@@ -457,6 +572,7 @@ SDL_RLEBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
     int x, y;
     int w = surf_src->w;
     unsigned alpha;
+    Uint32 simd;
 
     /* Lock the destination if necessary */
     if (SDL_MUSTLOCK(surf_dst)) {
@@ -517,9 +633,10 @@ SDL_RLEBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
     }
 
     alpha = surf_src->map->info.a;
+    simd = SDL_GetBlitCPUFeatures();
     /* if left or right edge clipping needed, call clip blit */
     if (srcrect->x || srcrect->w != surf_src->w) {
-        RLEClipBlit(w, srcbuf, surf_dst, dstbuf, srcrect, alpha);
+        RLEClipBlit(w, srcbuf, surf_dst, dstbuf, srcrect, alpha, simd);
     } else {
         SDL_PixelFormat *fmt = surf_src->format;
 
@@ -636,15 +753,16 @@ typedef struct
 /* blit a pixel-alpha RLE surface clipped at the right and/or left edges */
 static void
 RLEAlphaClipBlit(int w, Uint8 * srcbuf, SDL_Surface * surf_dst,
-                 Uint8 * dstbuf, SDL_Rect * srcrect)
+                 Uint8 * dstbuf, SDL_Rect * srcrect, Uint32 simd)
 {
     SDL_PixelFormat *df = surf_dst->format;
     /*
      * clipped blitter: Ptype is the destination pixel type,
-     * Ctype the translucent count type, and do_blend the macro
-     * to blend one pixel.
+     * Ctype the translucent count type, do_blend the macro
+     * to blend one pixel and simd_blend the one to blend the
+     * first of a run, if it can.
      */
-#define RLEALPHACLIPBLIT(Ptype, Ctype, do_blend)              \
+#define RLEALPHACLIPBLIT(Ptype, Ctype, do_blend, simd_blend)  \
     do {                                  \
     int linecount = srcrect->h;                   \
     int left = srcrect->x;                        \
@@ -700,8 +818,8 @@ RLEAlphaClipBlit(int w, Uint8 * srcbuf, SDL_Surface * surf_dst,
             if(crun > 0) {                    \
             Ptype *dst = (Ptype *)dstbuf + cofs;          \
             Uint32 *src = (Uint32 *)srcbuf + (cofs - ofs);    \
-            int i;                        \
-            for(i = 0; i < crun; i++)             \
+            int i = simd_blend(dst, src, crun);       \
+            for(; i < crun; i++)                  \
                 do_blend(src[i], dst[i]);             \
             }                             \
             srcbuf += run * 4;                    \
@@ -715,12 +833,15 @@ RLEAlphaClipBlit(int w, Uint8 * srcbuf, SDL_Surface * surf_dst,
     switch (df->BytesPerPixel) {
     case 2:
         if (df->Gmask == 0x07e0 || df->Rmask == 0x07e0 || df->Bmask == 0x07e0)
-            RLEALPHACLIPBLIT(Uint16, Uint8, BLIT_TRANSL_565);
+            RLEALPHACLIPBLIT(Uint16, Uint8, BLIT_TRANSL_565,
+                             SIMD_BLIT_TRANSL_NONE);
         else
-            RLEALPHACLIPBLIT(Uint16, Uint8, BLIT_TRANSL_555);
+            RLEALPHACLIPBLIT(Uint16, Uint8, BLIT_TRANSL_555,
+                             SIMD_BLIT_TRANSL_NONE);
         break;
     case 4:
-        RLEALPHACLIPBLIT(Uint32, Uint16, BLIT_TRANSL_888);
+        RLEALPHACLIPBLIT(Uint32, Uint16, BLIT_TRANSL_888,
+                         SIMD_BLIT_TRANSL_888);
         break;
     }
 }
@@ -734,6 +855,7 @@ SDL_RLEAlphaBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
     int w = surf_src->w;
     Uint8 *srcbuf, *dstbuf;
     SDL_PixelFormat *df = surf_dst->format;
+    Uint32 simd = SDL_GetBlitCPUFeatures();
 
     /* Lock the destination if necessary */
     if (SDL_MUSTLOCK(surf_dst)) {
@@ -805,15 +927,16 @@ SDL_RLEAlphaBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
 
     /* if left or right edge clipping needed, call clip blit */
     if (srcrect->x || srcrect->w != surf_src->w) {
-        RLEAlphaClipBlit(w, srcbuf, surf_dst, dstbuf, srcrect);
+        RLEAlphaClipBlit(w, srcbuf, surf_dst, dstbuf, srcrect, simd);
     } else {
 
         /*
          * non-clipped blitter. Ptype is the destination pixel type,
-         * Ctype the translucent count type, and do_blend the
-         * macro to blend one pixel.
+         * Ctype the translucent count type, do_blend the macro to
+         * blend one pixel and simd_blend the one to blend the first
+         * of a run, if it can.
          */
-#define RLEALPHABLIT(Ptype, Ctype, do_blend)                 \
+#define RLEALPHABLIT(Ptype, Ctype, do_blend, simd_blend)     \
     do {                                 \
         int linecount = srcrect->h;                  \
         do {                             \
@@ -844,8 +967,10 @@ SDL_RLEAlphaBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
             srcbuf += 4;                     \
             if(run) {                        \
             Ptype *dst = (Ptype *)dstbuf + ofs;      \
-            unsigned i;                  \
-            for(i = 0; i < run; i++) {           \
+            unsigned i = simd_blend(dst, (Uint32 *)srcbuf, (int)run); \
+            srcbuf += 4 * i;                 \
+            dst += i;                    \
+            for(; i < run; i++) {                \
                 Uint32 src = *(Uint32 *)srcbuf;      \
                 do_blend(src, *dst);             \
                 srcbuf += 4;                 \
@@ -862,12 +987,15 @@ SDL_RLEAlphaBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
         case 2:
             if (df->Gmask == 0x07e0 || df->Rmask == 0x07e0
                 || df->Bmask == 0x07e0)
-                RLEALPHABLIT(Uint16, Uint8, BLIT_TRANSL_565);
+                RLEALPHABLIT(Uint16, Uint8, BLIT_TRANSL_565,
+                             SIMD_BLIT_TRANSL_NONE);
             else
-                RLEALPHABLIT(Uint16, Uint8, BLIT_TRANSL_555);
+                RLEALPHABLIT(Uint16, Uint8, BLIT_TRANSL_555,
+                             SIMD_BLIT_TRANSL_NONE);
             break;
         case 4:
-            RLEALPHABLIT(Uint32, Uint16, BLIT_TRANSL_888);
+            RLEALPHABLIT(Uint32, Uint16, BLIT_TRANSL_888,
+                         SIMD_BLIT_TRANSL_888);
             break;
         }
     }
@@ -22,6 +22,11 @@
 
 /* Useful functions and variables from SDL_RLEaccel.c */
 
+/* A surface which wants RLE acceleration is blitted as it is this many
+   times, without being locked in between, before it's encoded: surfaces
+   blitted once, or changed every frame, aren't worth encoding */
+#define SDL_RLE_ENCODE_BLITS 3
+
 extern int SDL_RLESurface(SDL_Surface * surface);
 extern int SDL_RLEBlit(SDL_Surface * src, SDL_Rect * srcrect,
                        SDL_Surface * dst, SDL_Rect * dstrect);
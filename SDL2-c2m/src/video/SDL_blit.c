@@ -21,6 +21,7 @@
 #include "../SDL_internal.h"
 
 #include "SDL_video.h"
+#include "SDL_hints.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
 #include "SDL_blit_auto.h"
@@ -29,6 +30,25 @@
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
 
+typedef struct
+{
+    const SDL_BlitInfo *info;
+    SDL_BlitFunc RunBlit;
+} SDL_SoftBlitBands;
+
+/* Rows y to y + h - 1 of an unscaled blit, as a blit of their own */
+static void
+SDL_SoftBlitBand(void *data, int y, int h)
+{
+    const SDL_SoftBlitBands *bands = (const SDL_SoftBlitBands *) data;
+    SDL_BlitInfo info = *bands->info;
+
+    info.src += y * info.src_pitch;
+    info.dst += y * info.dst_pitch;
+    info.src_h = info.dst_h = h;
+    bands->RunBlit(&info);
+}
+
 /* The general purpose software blit routine */
 static int
 SDL_SoftBlit(SDL_Surface * src, SDL_Rect * srcrect,
@@ -84,8 +104,22 @@ SDL_SoftBlit(SDL_Surface * src, SDL_Rect * srcrect,
             info->dst_pitch - info->dst_w * info->dst_fmt->BytesPerPixel;
         RunBlit = (SDL_BlitFunc) src->map->data;
 
-        /* Run the actual software blit */
-        RunBlit(info);
+        /* Run the actual software blit, in bands on the blit threads when
+           the rows are independent: unscaled, whole bytes & not onto the
+           pixels being read */
+        if (info->src_w == info->dst_w && info->src_h == info->dst_h &&
+            info->src_fmt->BitsPerPixel >= 8 &&
+            info->dst_fmt->BitsPerPixel >= 8 &&
+            src->pixels != dst->pixels) {
+            SDL_SoftBlitBands bands;
+
+            bands.info = info;
+            bands.RunBlit = RunBlit;
+            SDL_RunBlitBands(info->dst_w, info->dst_h, SDL_SoftBlitBand,
+                             &bands);
+        } else {
+            RunBlit(info);
+        }
     }
 
     /* We need to unlock the surfaces if they're locked */
@@ -124,44 +158,72 @@ SDL_UseAltivecPrefetch()
 }
 #endif /* __MACOSX__ */
 
-static SDL_BlitFunc
-SDL_ChooseBlitFunc(Uint32 src_format, Uint32 dst_format, int flags,
-                   SDL_BlitFuncEntry * entries)
+static int SDLCALL
+ParseBlitCPUFeatures(const char *override, int default_value)
 {
-    int i, flagcheck;
-    static Uint32 features = 0xffffffff;
+    Uint32 forced = SDL_CPU_ANY;
 
-    /* Get the available CPU features */
-    if (features == 0xffffffff) {
-        const char *override = SDL_getenv("SDL_BLIT_CPU_FEATURES");
+    if (!override) {
+        return default_value;
+    }
+    SDL_sscanf(override, "%u", &forced);
+    return (int) forced;
+}
 
-        features = SDL_CPU_ANY;
+/* The SDL_CPU_* flags the blitters may use.  SDL_BLIT_CPU_FEATURES, a hint
+   or environment variable, overrides them for testing: blits mapped after
+   it's changed use the flags it gives. */
+Uint32
+SDL_GetBlitCPUFeatures(void)
+{
+    static Uint32 features = 0xffffffff;
+    static SDL_HintHandle override =
+        SDL_HINT_HANDLE_INIT("SDL_BLIT_CPU_FEATURES", -1, ParseBlitCPUFeatures);
+    const int forced = SDL_GetHintValue(&override);
 
-        /* Allow an override for testing .. */
-        if (override) {
-            SDL_sscanf(override, "%u", &features);
-        } else {
-            if (SDL_HasMMX()) {
-                features |= SDL_CPU_MMX;
-            }
-            if (SDL_Has3DNow()) {
-                features |= SDL_CPU_3DNOW;
-            }
-            if (SDL_HasSSE()) {
-                features |= SDL_CPU_SSE;
-            }
-            if (SDL_HasSSE2()) {
-                features |= SDL_CPU_SSE2;
+    /* Allow an override for testing .. */
+    if (forced != -1) {
+        return (Uint32) forced;
+    }
+
+    /* Map the CPU's features, from SDL_GetCPUFeatureMask() */
+    if (features == 0xffffffff) {
+        static const Uint32 map[][2] = {
+            { SDL_CPUFEATURE_MMX, SDL_CPU_MMX },
+            { SDL_CPUFEATURE_3DNOW, SDL_CPU_3DNOW },
+            { SDL_CPUFEATURE_SSE, SDL_CPU_SSE },
+            { SDL_CPUFEATURE_SSE2, SDL_CPU_SSE2 },
+            { SDL_CPUFEATURE_SSE41, SDL_CPU_SSE41 },
+            { SDL_CPUFEATURE_AVX2, SDL_CPU_AVX2 },
+            { SDL_CPUFEATURE_NEON, SDL_CPU_NEON }
+        };
+        const Uint32 cpu = SDL_GetCPUFeatureMask();
+        Uint32 found = SDL_CPU_ANY;
+        int i;
+
+        for (i = 0; i < SDL_arraysize(map); ++i) {
+            if (cpu & map[i][0]) {
+                found |= map[i][1];
             }
-            if (SDL_HasAltiVec()) {
-                if (SDL_UseAltivecPrefetch()) {
-                    features |= SDL_CPU_ALTIVEC_PREFETCH;
-                } else {
-                    features |= SDL_CPU_ALTIVEC_NOPREFETCH;
-                }
+        }
+        if (SDL_HasAltiVec()) {
+            if (SDL_UseAltivecPrefetch()) {
+                found |= SDL_CPU_ALTIVEC_PREFETCH;
+            } else {
+                found |= SDL_CPU_ALTIVEC_NOPREFETCH;
             }
         }
+        features = found;  /* Only whole, for racing threads */
     }
+    return features;
+}
+
+static SDL_BlitFunc
+SDL_ChooseBlitFunc(Uint32 src_format, Uint32 dst_format, int flags,
+                   SDL_BlitFuncEntry * entries)
+{
+    int i, flagcheck;
+    Uint32 features = SDL_GetBlitCPUFeatures();
 
     for (i = 0; entries[i].func; ++i) {
         /* Check for matching pixel formats */
@@ -229,12 +291,10 @@ SDL_CalculateBlit(SDL_Surface * surface)
     map->info.dst_fmt = dst->format;
     map->info.dst_pitch = dst->pitch;
 
-    /* See if we can do RLE acceleration */
-    if (map->info.flags & SDL_COPY_RLE_DESIRED) {
-        if (SDL_RLESurface(surface) == 0) {
-            return 0;
-        }
-    }
+    /* RLE acceleration is left to SDL_LowerBlit(), once the surface has
+       been blitted a few times */
+    map->rle_wait = (map->info.flags & SDL_COPY_RLE_DESIRED) ?
+        SDL_RLE_ENCODE_BLITS : 0;
 
     /* Choose a standard blit function */
     if (map->identity && !(map->info.flags & ~SDL_COPY_RLE_DESIRED)) {
@@ -26,6 +26,7 @@
 #include "SDL_cpuinfo.h"
 #include "SDL_endian.h"
 #include "SDL_surface.h"
+#include "SDL_video.h"
 
 /* Table to do pixel byte expansion */
 extern Uint8* SDL_expand_byte[9];
@@ -51,6 +52,9 @@ extern Uint8* SDL_expand_byte[9];
 #define SDL_CPU_SSE2                0x00000008
 #define SDL_CPU_ALTIVEC_PREFETCH    0x00000010
 #define SDL_CPU_ALTIVEC_NOPREFETCH  0x00000020
+#define SDL_CPU_AVX2                0x00000040
+#define SDL_CPU_NEON                0x00000080
+#define SDL_CPU_SSE41               0x00000100
 
 typedef struct
 {
@@ -89,6 +93,7 @@ typedef struct SDL_BlitMap
     SDL_blit blit;
     void *data;
     SDL_BlitInfo info;
+    int rle_wait;               /* blits till the RLE encoding, if waiting */
 
     /* the version count matches the destination; mismatch indicates
        an invalid mapping */
@@ -98,6 +103,7 @@ typedef struct SDL_BlitMap
 
 /* Functions found in SDL_blit.c */
 extern int SDL_CalculateBlit(SDL_Surface * surface);
+extern Uint32 SDL_GetBlitCPUFeatures(void);
 
 /* Functions found in SDL_blit_*.c */
 extern SDL_BlitFunc SDL_CalculateBlit0(SDL_Surface * surface);
@@ -105,6 +111,26 @@ extern SDL_BlitFunc SDL_CalculateBlit1(SDL_Surface * surface);
 extern SDL_BlitFunc SDL_CalculateBlitN(SDL_Surface * surface);
 extern SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface * surface);
 
+/* Functions found in SDL_blit_threads.c: func is run on rows y to y + h - 1
+   of an operation h rows high, w wide, maybe on several threads at once */
+typedef void (*SDL_BlitBandFunc) (void *data, int y, int h);
+extern void SDL_RunBlitBands(int w, int h, SDL_BlitBandFunc func, void *data);
+extern void SDL_QuitBlitThreads(void);
+
+/* Surface flag, set on a window surface whose changes are recorded so
+   SDL_UpdateWindowSurface() only updates those (see
+   SDL_HINT_WINDOW_SURFACE_DAMAGE) */
+#define SDL_TRACKDAMAGE             0x00010000
+
+/* Functions found in SDL_video.c: anything drawing on a surface reports
+   where, and these do nothing unless it has SDL_TRACKDAMAGE.  A NULL rect
+   is the whole surface; points are a bounding box within the clip rect. */
+extern void SDL_AddSurfaceDamage(SDL_Surface * surface, const SDL_Rect * rect);
+extern void SDL_AddSurfaceDamagePoints(SDL_Surface * surface,
+                                       const SDL_Point * points, int count);
+extern void SDL_TrackWindowSurfaceDamage(SDL_Window * window,
+                                         SDL_bool default_value);
+
 /*
  * Useful macros for blitting routines
  */
@@ -440,21 +466,22 @@ do {                                                                    \
     }                                                                   \
 }
 
-/* Blend the RGB values of two pixels with an alpha value */
+/* Blend the RGB values of two pixels with an alpha value (the differences
+   are signed, unsigned ones would spill into the other channels) */
 #define ALPHA_BLEND_RGB(sR, sG, sB, A, dR, dG, dB)                      \
 do {                                                                    \
-    dR = ((((unsigned)(sR-dR)*(unsigned)A)/255)+dR);                    \
-    dG = ((((unsigned)(sG-dG)*(unsigned)A)/255)+dG);                    \
-    dB = ((((unsigned)(sB-dB)*(unsigned)A)/255)+dB);                    \
+    dR = (unsigned)((((int)(sR-dR)*(int)A)/255)+dR);                    \
+    dG = (unsigned)((((int)(sG-dG)*(int)A)/255)+dG);                    \
+    dB = (unsigned)((((int)(sB-dB)*(int)A)/255)+dB);                    \
 } while(0)
 
 
 /* Blend the RGBA values of two pixels */
 #define ALPHA_BLEND_RGBA(sR, sG, sB, sA, dR, dG, dB, dA)                \
 do {                                                                    \
-    dR = ((((unsigned)(sR-dR)*(unsigned)sA)/255)+dR);                   \
-    dG = ((((unsigned)(sG-dG)*(unsigned)sA)/255)+dG);                   \
-    dB = ((((unsigned)(sB-dB)*(unsigned)sA)/255)+dB);                   \
+    dR = (unsigned)((((int)(sR-dR)*(int)sA)/255)+dR);                   \
+    dG = (unsigned)((((int)(sG-dG)*(int)sA)/255)+dG);                   \
+    dB = (unsigned)((((int)(sB-dB)*(int)sA)/255)+dB);                   \
     dA = ((unsigned)sA+(unsigned)dA-((unsigned)sA*dA)/255);             \
 } while(0)
 
@@ -25,6 +25,13 @@
 
 /* Functions to perform alpha blended blitting */
 
+/* SSE2, SSE4.1 & AVX2 blenders, chosen at run time */
+#if defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SDL_BLIT_A_X86 1
+#include <immintrin.h>
+#endif
+
 /* N->1 blending with per-surface alpha */
 static void
 BlitNto1SurfaceAlpha(SDL_BlitInfo * info)
@@ -1264,12 +1271,632 @@ BlitNtoNPixelAlpha(SDL_BlitInfo * info)
     }
 }
 
+#if SDL_BLIT_A_X86
+
+/* Vector versions of the RGB888 and ARGB8888->RGB565/RGB555 blenders above,
+   with the same results to the bit: the MMX ones' for 32-bit destinations
+   (the ones chosen where there's MMX), the C ones' for 16-bit ones.  The
+   last few pixels of a row are blended in a copy, a vector's worth. */
+
+#define BLIT_TARGET_SSE2 __attribute__((target("sse2")))
+#define BLIT_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define BLIT_TARGET_AVX2 __attribute__((target("avx2")))
+
+/* Pixel alpha, as BlitRGBtoRGBPixelAlphaMMX(): s * A >> 8 + d * ~A >> 8 for
+   the colors, s * 255 >> 8 + d * ~A >> 8 for the alpha, the destination as
+   is where A is 0 & the source where it's opaque. */
+typedef struct
+{
+    Uint32 amask;
+    Uint32 ashift;
+} PixelAlphaParams;
+
+static SDL_INLINE __m128i BLIT_TARGET_SSE41
+BlendPixelAlpha4(__m128i s, __m128i d, const PixelAlphaParams * p)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ff = _mm_set1_epi16(0xFF);
+    const __m128i amask = _mm_set1_epi32(p->amask);
+    /* 0x00FF in the alpha channel, all of the source's alpha is kept */
+    const __m128i multmask = _mm_set1_epi64x((Sint64) 0xFF << (p->ashift * 2));
+    __m128i a = _mm_and_si128(s, amask);
+    __m128i transparent = _mm_cmpeq_epi32(a, zero);
+    __m128i opaque = _mm_cmpeq_epi32(a, amask);
+    __m128i a_lo, a_hi, lo, hi;
+
+    a = _mm_srli_epi32(a, p->ashift);
+    a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+    a_lo = _mm_unpacklo_epi32(a, a);    /* 0A0A0A0A, pixels 0 & 1 */
+    a_hi = _mm_unpackhi_epi32(a, a);    /* 0A0A0A0A, pixels 2 & 3 */
+    lo = _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), _mm_or_si128(a_lo, multmask));
+    hi = _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), _mm_or_si128(a_hi, multmask));
+    lo = _mm_add_epi16(_mm_srli_epi16(lo, 8),
+                       _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero),
+                                                      _mm_xor_si128(a_lo, ff)), 8));
+    hi = _mm_add_epi16(_mm_srli_epi16(hi, 8),
+                       _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero),
+                                                      _mm_xor_si128(a_hi, ff)), 8));
+    lo = _mm_packus_epi16(lo, hi);
+    lo = _mm_blendv_epi8(lo, d, transparent);
+    return _mm_blendv_epi8(lo, s, opaque);
+}
+
+static SDL_INLINE __m256i BLIT_TARGET_AVX2
+BlendPixelAlpha8(__m256i s, __m256i d, const PixelAlphaParams * p)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ff = _mm256_set1_epi16(0xFF);
+    const __m256i amask = _mm256_set1_epi32(p->amask);
+    const __m256i multmask = _mm256_set1_epi64x((Sint64) 0xFF << (p->ashift * 2));
+    __m256i a = _mm256_and_si256(s, amask);
+    __m256i transparent = _mm256_cmpeq_epi32(a, zero);
+    __m256i opaque = _mm256_cmpeq_epi32(a, amask);
+    __m256i a_lo, a_hi, lo, hi;
+
+    /* Unpacking & packing are within halves, the pixels keep their order */
+    a = _mm256_srli_epi32(a, p->ashift);
+    a = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+    a_lo = _mm256_unpacklo_epi32(a, a);
+    a_hi = _mm256_unpackhi_epi32(a, a);
+    lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), _mm256_or_si256(a_lo, multmask));
+    hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), _mm256_or_si256(a_hi, multmask));
+    lo = _mm256_add_epi16(_mm256_srli_epi16(lo, 8),
+                          _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero),
+                                                               _mm256_xor_si256(a_lo, ff)), 8));
+    hi = _mm256_add_epi16(_mm256_srli_epi16(hi, 8),
+                          _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero),
+                                                               _mm256_xor_si256(a_hi, ff)), 8));
+    lo = _mm256_packus_epi16(lo, hi);
+    lo = _mm256_blendv_epi8(lo, d, transparent);
+    return _mm256_blendv_epi8(lo, s, opaque);
+}
+
+static void BLIT_TARGET_SSE41
+BlendPixelAlphaRow(const Uint32 * srcp, Uint32 * dstp, int n,
+                   const PixelAlphaParams * p)
+{
+    for (; n >= 4; n -= 4, srcp += 4, dstp += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) srcp);
+        __m128i d = _mm_loadu_si128((const __m128i *) dstp);
+        _mm_storeu_si128((__m128i *) dstp, BlendPixelAlpha4(s, d, p));
+    }
+    if (n) {
+        Uint32 s[4], d[4];
+        SDL_memcpy(s, srcp, n * 4);
+        SDL_memcpy(d, dstp, n * 4);
+        _mm_storeu_si128((__m128i *) d,
+                         BlendPixelAlpha4(_mm_loadu_si128((const __m128i *) s),
+                                          _mm_loadu_si128((const __m128i *) d), p));
+        SDL_memcpy(dstp, d, n * 4);
+    }
+}
+
+static void BLIT_TARGET_SSE41
+BlitRGBtoRGBPixelAlphaSSE41(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    PixelAlphaParams p;
+
+    p.amask = info->src_fmt->Amask;
+    p.ashift = info->src_fmt->Ashift;
+    while (height--) {
+        BlendPixelAlphaRow((const Uint32 *) src, (Uint32 *) dst, width, &p);
+        src += width * 4 + srcskip;
+        dst += width * 4 + dstskip;
+    }
+}
+
+static void BLIT_TARGET_AVX2
+BlitRGBtoRGBPixelAlphaAVX2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    PixelAlphaParams p;
+
+    p.amask = info->src_fmt->Amask;
+    p.ashift = info->src_fmt->Ashift;
+    while (height--) {
+        const Uint32 *srcp = (const Uint32 *) src;
+        Uint32 *dstp = (Uint32 *) dst;
+        int n = width;
+
+        for (; n >= 8; n -= 8, srcp += 8, dstp += 8) {
+            __m256i s = _mm256_loadu_si256((const __m256i *) srcp);
+            __m256i d = _mm256_loadu_si256((const __m256i *) dstp);
+            _mm256_storeu_si256((__m256i *) dstp, BlendPixelAlpha8(s, d, &p));
+        }
+        BlendPixelAlphaRow(srcp, dstp, n, &p);
+        src += width * 4 + srcskip;
+        dst += width * 4 + dstskip;
+    }
+}
+
+/* Surface alpha, as BlitRGBtoRGBSurfaceAlphaMMX(): d + (s - d) * A >> 8 for
+   the colors, which is (s * A + d * (256 - A)) >> 8.  The fourth channel is
+   the destination's (cleared at A = 128 with RGB in the low bits, as by
+   BlitRGBtoRGBSurfaceAlpha128MMX()), or'd with its alpha mask. */
+typedef struct
+{
+    Sint64 smult;               /* A in the color channels, 0 in the other */
+    Sint64 dmult;               /* 256 - A in the color channels, 256 */
+    Uint32 keep;
+    Uint32 dalpha;
+} SurfaceAlphaParams;
+
+static void
+GetSurfaceAlphaParams(const SDL_BlitInfo * info, SurfaceAlphaParams * p)
+{
+    const SDL_PixelFormat *df = info->dst_fmt;
+    const Uint32 shifts[3] = { df->Rshift, df->Gshift, df->Bshift };
+    Uint32 chanmask = 0;
+    int i;
+
+    p->smult = 0;
+    p->dmult = 0x0100010001000100LL;
+    for (i = 0; i < 3; ++i) {
+        chanmask |= (Uint32) 0xFF << shifts[i];
+        p->smult |= (Sint64) info->a << (shifts[i] * 2);
+        p->dmult -= (Sint64) info->a << (shifts[i] * 2);
+    }
+    p->keep = (info->a == 128 && chanmask == 0x00FFFFFF) ? chanmask : 0xFFFFFFFF;
+    p->dalpha = df->Amask;
+}
+
+static SDL_INLINE __m128i BLIT_TARGET_SSE2
+BlendSurfaceAlpha4(__m128i s, __m128i d, const SurfaceAlphaParams * p)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i smult = _mm_set1_epi64x(p->smult);
+    const __m128i dmult = _mm_set1_epi64x(p->dmult);
+    __m128i lo, hi;
+
+    lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), smult),
+                       _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), dmult));
+    hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), smult),
+                       _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), dmult));
+    lo = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+    lo = _mm_and_si128(lo, _mm_set1_epi32(p->keep));
+    return _mm_or_si128(lo, _mm_set1_epi32(p->dalpha));
+}
+
+static SDL_INLINE __m256i BLIT_TARGET_AVX2
+BlendSurfaceAlpha8(__m256i s, __m256i d, const SurfaceAlphaParams * p)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i smult = _mm256_set1_epi64x(p->smult);
+    const __m256i dmult = _mm256_set1_epi64x(p->dmult);
+    __m256i lo, hi;
+
+    lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), smult),
+                          _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), dmult));
+    hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), smult),
+                          _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), dmult));
+    lo = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+    lo = _mm256_and_si256(lo, _mm256_set1_epi32(p->keep));
+    return _mm256_or_si256(lo, _mm256_set1_epi32(p->dalpha));
+}
+
+static void BLIT_TARGET_SSE2
+BlendSurfaceAlphaRow(const Uint32 * srcp, Uint32 * dstp, int n,
+                     const SurfaceAlphaParams * p)
+{
+    for (; n >= 4; n -= 4, srcp += 4, dstp += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) srcp);
+        __m128i d = _mm_loadu_si128((const __m128i *) dstp);
+        _mm_storeu_si128((__m128i *) dstp, BlendSurfaceAlpha4(s, d, p));
+    }
+    if (n) {
+        Uint32 s[4], d[4];
+        SDL_memcpy(s, srcp, n * 4);
+        SDL_memcpy(d, dstp, n * 4);
+        _mm_storeu_si128((__m128i *) d,
+                         BlendSurfaceAlpha4(_mm_loadu_si128((const __m128i *) s),
+                                            _mm_loadu_si128((const __m128i *) d), p));
+        SDL_memcpy(dstp, d, n * 4);
+    }
+}
+
+static void BLIT_TARGET_SSE2
+BlitRGBtoRGBSurfaceAlphaSSE2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    SurfaceAlphaParams p;
+
+    GetSurfaceAlphaParams(info, &p);
+    while (height--) {
+        BlendSurfaceAlphaRow((const Uint32 *) src, (Uint32 *) dst, width, &p);
+        src += width * 4 + srcskip;
+        dst += width * 4 + dstskip;
+    }
+}
+
+static void BLIT_TARGET_AVX2
+BlitRGBtoRGBSurfaceAlphaAVX2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    SurfaceAlphaParams p;
+
+    GetSurfaceAlphaParams(info, &p);
+    while (height--) {
+        const Uint32 *srcp = (const Uint32 *) src;
+        Uint32 *dstp = (Uint32 *) dst;
+        int n = width;
+
+        for (; n >= 8; n -= 8, srcp += 8, dstp += 8) {
+            __m256i s = _mm256_loadu_si256((const __m256i *) srcp);
+            __m256i d = _mm256_loadu_si256((const __m256i *) dstp);
+            _mm256_storeu_si256((__m256i *) dstp, BlendSurfaceAlpha8(s, d, &p));
+        }
+        BlendSurfaceAlphaRow(srcp, dstp, n, &p);
+        src += width * 4 + srcskip;
+        dst += width * 4 + dstskip;
+    }
+}
+
+/* Colorkey & surface alpha, as BlitNtoNSurfaceAlphaKey() for 32-bit pixels
+   with the same byte channels: d + (s - d) * A / 255 for the colors (the
+   division's exact, by 0x8081 >> 23, on the difference's magnitude) &
+   A + d - A * d / 255 for the destination's alpha.  Keyed pixels are left
+   as they are, the others' fourth byte is cleared if it isn't alpha. */
+typedef struct
+{
+    Uint32 ckey;
+    Sint64 colors;              /* 0xFFFF in the color channels */
+    Sint64 alpha;               /* 0xFFFF in the destination's alpha */
+    Uint16 a;
+} SurfaceAlphaKeyParams;
+
+static void
+GetSurfaceAlphaKeyParams(const SDL_BlitInfo * info, SurfaceAlphaKeyParams * p)
+{
+    const SDL_PixelFormat *df = info->dst_fmt;
+
+    p->ckey = info->colorkey;
+    p->colors = ((Sint64) 0xFFFF << (df->Rshift * 2)) |
+        ((Sint64) 0xFFFF << (df->Gshift * 2)) |
+        ((Sint64) 0xFFFF << (df->Bshift * 2));
+    p->alpha = df->Amask ? (Sint64) 0xFFFF << (df->Ashift * 2) : 0;
+    p->a = info->a;
+}
+
+static SDL_INLINE __m128i BLIT_TARGET_SSE2
+BlendSurfaceAlphaKeyHalf(__m128i s, __m128i d, __m128i a,
+                         const SurfaceAlphaKeyParams * p)
+{
+    const __m128i div255 = _mm_set1_epi16((short) 0x8081);
+    __m128i diff, sign, q, da;
+
+    /* |s - d| * A / 255, negated where d > s */
+    diff = _mm_sub_epi16(_mm_max_epi16(s, d), _mm_min_epi16(s, d));
+    q = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(diff, a), div255), 7);
+    sign = _mm_cmpgt_epi16(d, s);
+    q = _mm_add_epi16(d, _mm_sub_epi16(_mm_xor_si128(q, sign), sign));
+    da = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(d, a), div255), 7);
+    da = _mm_sub_epi16(_mm_add_epi16(a, d), da);
+    return _mm_or_si128(_mm_and_si128(q, _mm_set1_epi64x(p->colors)),
+                        _mm_and_si128(da, _mm_set1_epi64x(p->alpha)));
+}
+
+static SDL_INLINE __m128i BLIT_TARGET_SSE2
+BlendSurfaceAlphaKey4(__m128i s, __m128i d, const SurfaceAlphaKeyParams * p)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i a = _mm_set1_epi16(p->a);
+    __m128i keyed = _mm_cmpeq_epi32(s, _mm_set1_epi32(p->ckey));
+    __m128i lo, hi;
+
+    lo = BlendSurfaceAlphaKeyHalf(_mm_unpacklo_epi8(s, zero),
+                                  _mm_unpacklo_epi8(d, zero), a, p);
+    hi = BlendSurfaceAlphaKeyHalf(_mm_unpackhi_epi8(s, zero),
+                                  _mm_unpackhi_epi8(d, zero), a, p);
+    lo = _mm_packus_epi16(lo, hi);
+    return _mm_or_si128(_mm_and_si128(keyed, d), _mm_andnot_si128(keyed, lo));
+}
+
+static SDL_INLINE __m256i BLIT_TARGET_AVX2
+BlendSurfaceAlphaKeyHalf8(__m256i s, __m256i d, __m256i a,
+                          const SurfaceAlphaKeyParams * p)
+{
+    const __m256i div255 = _mm256_set1_epi16((short) 0x8081);
+    __m256i diff, sign, q, da;
+
+    diff = _mm256_sub_epi16(_mm256_max_epi16(s, d), _mm256_min_epi16(s, d));
+    q = _mm256_srli_epi16(_mm256_mulhi_epu16(_mm256_mullo_epi16(diff, a), div255), 7);
+    sign = _mm256_cmpgt_epi16(d, s);
+    q = _mm256_add_epi16(d, _mm256_sub_epi16(_mm256_xor_si256(q, sign), sign));
+    da = _mm256_srli_epi16(_mm256_mulhi_epu16(_mm256_mullo_epi16(d, a), div255), 7);
+    da = _mm256_sub_epi16(_mm256_add_epi16(a, d), da);
+    return _mm256_or_si256(_mm256_and_si256(q, _mm256_set1_epi64x(p->colors)),
+                           _mm256_and_si256(da, _mm256_set1_epi64x(p->alpha)));
+}
+
+static SDL_INLINE __m256i BLIT_TARGET_AVX2
+BlendSurfaceAlphaKey8(__m256i s, __m256i d, const SurfaceAlphaKeyParams * p)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i a = _mm256_set1_epi16(p->a);
+    __m256i keyed = _mm256_cmpeq_epi32(s, _mm256_set1_epi32(p->ckey));
+    __m256i lo, hi;
+
+    lo = BlendSurfaceAlphaKeyHalf8(_mm256_unpacklo_epi8(s, zero),
+                                   _mm256_unpacklo_epi8(d, zero), a, p);
+    hi = BlendSurfaceAlphaKeyHalf8(_mm256_unpackhi_epi8(s, zero),
+                                   _mm256_unpackhi_epi8(d, zero), a, p);
+    lo = _mm256_packus_epi16(lo, hi);
+    return _mm256_blendv_epi8(lo, d, keyed);
+}
+
+static void BLIT_TARGET_SSE2
+BlendSurfaceAlphaKeyRow(const Uint32 * srcp, Uint32 * dstp, int n,
+                        const SurfaceAlphaKeyParams * p)
+{
+    for (; n >= 4; n -= 4, srcp += 4, dstp += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) srcp);
+        __m128i d = _mm_loadu_si128((const __m128i *) dstp);
+        _mm_storeu_si128((__m128i *) dstp, BlendSurfaceAlphaKey4(s, d, p));
+    }
+    if (n) {
+        Uint32 s[4], d[4];
+        SDL_memcpy(s, srcp, n * 4);
+        SDL_memcpy(d, dstp, n * 4);
+        _mm_storeu_si128((__m128i *) d,
+                         BlendSurfaceAlphaKey4(_mm_loadu_si128((const __m128i *) s),
+                                               _mm_loadu_si128((const __m128i *) d), p));
+        SDL_memcpy(dstp, d, n * 4);
+    }
+}
+
+static void BLIT_TARGET_SSE2
+BlitRGBtoRGBSurfaceAlphaKeySSE2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    SurfaceAlphaKeyParams p;
+
+    if (!info->a) {
+        return;
+    }
+    GetSurfaceAlphaKeyParams(info, &p);
+    while (height--) {
+        BlendSurfaceAlphaKeyRow((const Uint32 *) src, (Uint32 *) dst, width, &p);
+        src += width * 4 + srcskip;
+        dst += width * 4 + dstskip;
+    }
+}
+
+static void BLIT_TARGET_AVX2
+BlitRGBtoRGBSurfaceAlphaKeyAVX2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    SurfaceAlphaKeyParams p;
+
+    if (!info->a) {
+        return;
+    }
+    GetSurfaceAlphaKeyParams(info, &p);
+    while (height--) {
+        const Uint32 *srcp = (const Uint32 *) src;
+        Uint32 *dstp = (Uint32 *) dst;
+        int n = width;
+
+        for (; n >= 8; n -= 8, srcp += 8, dstp += 8) {
+            __m256i s = _mm256_loadu_si256((const __m256i *) srcp);
+            __m256i d = _mm256_loadu_si256((const __m256i *) dstp);
+            _mm256_storeu_si256((__m256i *) dstp, BlendSurfaceAlphaKey8(s, d, &p));
+        }
+        BlendSurfaceAlphaKeyRow(srcp, dstp, n, &p);
+        src += width * 4 + srcskip;
+        dst += width * 4 + dstskip;
+    }
+}
+
+/* ARGB8888->RGB565/RGB555 pixel alpha, as BlitARGBto565PixelAlpha() &
+   BlitARGBto555PixelAlpha(): the G0RAB trick in 32-bit lanes, the source as
+   is at an alpha of 31 & the destination at 0. */
+static SDL_INLINE __m128i BLIT_TARGET_SSE41
+BlendARGBto16_4(__m128i s, __m128i d, SDL_bool is565)
+{
+    const __m128i mask = _mm_set1_epi32(is565 ? 0x07e0f81f : 0x03e07c1f);
+    const __m128i low5 = _mm_set1_epi32(0x1f);
+    __m128i alpha = _mm_srli_epi32(s, 27);
+    __m128i solid, blend, d2;
+
+    if (is565) {
+        solid = _mm_or_si128(_mm_or_si128(
+            _mm_and_si128(_mm_srli_epi32(s, 8), _mm_set1_epi32(0xf800)),
+            _mm_and_si128(_mm_srli_epi32(s, 5), _mm_set1_epi32(0x7e0))),
+            _mm_and_si128(_mm_srli_epi32(s, 3), low5));
+        blend = _mm_or_si128(_mm_or_si128(
+            _mm_slli_epi32(_mm_and_si128(s, _mm_set1_epi32(0xfc00)), 11),
+            _mm_and_si128(_mm_srli_epi32(s, 8), _mm_set1_epi32(0xf800))),
+            _mm_and_si128(_mm_srli_epi32(s, 3), low5));
+    } else {
+        solid = _mm_or_si128(_mm_or_si128(
+            _mm_and_si128(_mm_srli_epi32(s, 9), _mm_set1_epi32(0x7c00)),
+            _mm_and_si128(_mm_srli_epi32(s, 6), _mm_set1_epi32(0x3e0))),
+            _mm_and_si128(_mm_srli_epi32(s, 3), low5));
+        blend = _mm_or_si128(_mm_or_si128(
+            _mm_slli_epi32(_mm_and_si128(s, _mm_set1_epi32(0xf800)), 10),
+            _mm_and_si128(_mm_srli_epi32(s, 9), _mm_set1_epi32(0x7c00))),
+            _mm_and_si128(_mm_srli_epi32(s, 3), low5));
+    }
+    d2 = _mm_and_si128(_mm_or_si128(d, _mm_slli_epi32(d, 16)), mask);
+    blend = _mm_mullo_epi32(_mm_sub_epi32(blend, d2), alpha);
+    blend = _mm_and_si128(_mm_add_epi32(d2, _mm_srli_epi32(blend, 5)), mask);
+    blend = _mm_or_si128(blend, _mm_srli_epi32(blend, 16));
+    blend = _mm_and_si128(blend, _mm_set1_epi32(0xffff));
+    blend = _mm_blendv_epi8(blend, solid, _mm_cmpeq_epi32(alpha, low5));
+    return _mm_blendv_epi8(blend, d, _mm_cmpeq_epi32(alpha, _mm_setzero_si128()));
+}
+
+static SDL_INLINE __m256i BLIT_TARGET_AVX2
+BlendARGBto16_8(__m256i s, __m256i d, SDL_bool is565)
+{
+    const __m256i mask = _mm256_set1_epi32(is565 ? 0x07e0f81f : 0x03e07c1f);
+    const __m256i low5 = _mm256_set1_epi32(0x1f);
+    __m256i alpha = _mm256_srli_epi32(s, 27);
+    __m256i solid, blend, d2;
+
+    if (is565) {
+        solid = _mm256_or_si256(_mm256_or_si256(
+            _mm256_and_si256(_mm256_srli_epi32(s, 8), _mm256_set1_epi32(0xf800)),
+            _mm256_and_si256(_mm256_srli_epi32(s, 5), _mm256_set1_epi32(0x7e0))),
+            _mm256_and_si256(_mm256_srli_epi32(s, 3), low5));
+        blend = _mm256_or_si256(_mm256_or_si256(
+            _mm256_slli_epi32(_mm256_and_si256(s, _mm256_set1_epi32(0xfc00)), 11),
+            _mm256_and_si256(_mm256_srli_epi32(s, 8), _mm256_set1_epi32(0xf800))),
+            _mm256_and_si256(_mm256_srli_epi32(s, 3), low5));
+    } else {
+        solid = _mm256_or_si256(_mm256_or_si256(
+            _mm256_and_si256(_mm256_srli_epi32(s, 9), _mm256_set1_epi32(0x7c00)),
+            _mm256_and_si256(_mm256_srli_epi32(s, 6), _mm256_set1_epi32(0x3e0))),
+            _mm256_and_si256(_mm256_srli_epi32(s, 3), low5));
+        blend = _mm256_or_si256(_mm256_or_si256(
+            _mm256_slli_epi32(_mm256_and_si256(s, _mm256_set1_epi32(0xf800)), 10),
+            _mm256_and_si256(_mm256_srli_epi32(s, 9), _mm256_set1_epi32(0x7c00))),
+            _mm256_and_si256(_mm256_srli_epi32(s, 3), low5));
+    }
+    d2 = _mm256_and_si256(_mm256_or_si256(d, _mm256_slli_epi32(d, 16)), mask);
+    blend = _mm256_mullo_epi32(_mm256_sub_epi32(blend, d2), alpha);
+    blend = _mm256_and_si256(_mm256_add_epi32(d2, _mm256_srli_epi32(blend, 5)), mask);
+    blend = _mm256_or_si256(blend, _mm256_srli_epi32(blend, 16));
+    blend = _mm256_and_si256(blend, _mm256_set1_epi32(0xffff));
+    blend = _mm256_blendv_epi8(blend, solid, _mm256_cmpeq_epi32(alpha, low5));
+    return _mm256_blendv_epi8(blend, d, _mm256_cmpeq_epi32(alpha, _mm256_setzero_si256()));
+}
+
+static SDL_INLINE void BLIT_TARGET_SSE41
+BlendARGBto16Row(const Uint32 * srcp, Uint16 * dstp, int n, SDL_bool is565)
+{
+    for (; n >= 4; n -= 4, srcp += 4, dstp += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) srcp);
+        __m128i d = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) dstp));
+        d = BlendARGBto16_4(s, d, is565);
+        _mm_storel_epi64((__m128i *) dstp, _mm_packus_epi32(d, d));
+    }
+    if (n) {
+        Uint32 s[4];
+        Uint16 d[4];
+        __m128i blend;
+        SDL_memcpy(s, srcp, n * 4);
+        SDL_memcpy(d, dstp, n * 2);
+        blend = BlendARGBto16_4(_mm_loadu_si128((const __m128i *) s),
+                                _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) d)),
+                                is565);
+        _mm_storel_epi64((__m128i *) d, _mm_packus_epi32(blend, blend));
+        SDL_memcpy(dstp, d, n * 2);
+    }
+}
+
+static SDL_INLINE void BLIT_TARGET_SSE41
+BlitARGBto16PixelAlphaSSE41(SDL_BlitInfo * info, SDL_bool is565)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+
+    while (height--) {
+        BlendARGBto16Row((const Uint32 *) src, (Uint16 *) dst, width, is565);
+        src += width * 4 + srcskip;
+        dst += width * 2 + dstskip;
+    }
+}
+
+static SDL_INLINE void BLIT_TARGET_AVX2
+BlitARGBto16PixelAlphaAVX2(SDL_BlitInfo * info, SDL_bool is565)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+
+    while (height--) {
+        const Uint32 *srcp = (const Uint32 *) src;
+        Uint16 *dstp = (Uint16 *) dst;
+        int n = width;
+
+        for (; n >= 8; n -= 8, srcp += 8, dstp += 8) {
+            __m256i s = _mm256_loadu_si256((const __m256i *) srcp);
+            __m256i d = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) dstp));
+            d = BlendARGBto16_8(s, d, is565);
+            /* Packing is within halves: pixels 0-3 & 4-7 are quads 0 & 2 */
+            d = _mm256_permute4x64_epi64(_mm256_packus_epi32(d, d), 0x08);
+            _mm_storeu_si128((__m128i *) dstp, _mm256_castsi256_si128(d));
+        }
+        BlendARGBto16Row(srcp, dstp, n, is565);
+        src += width * 4 + srcskip;
+        dst += width * 2 + dstskip;
+    }
+}
+
+static void BLIT_TARGET_SSE41
+BlitARGBto565PixelAlphaSSE41(SDL_BlitInfo * info)
+{
+    BlitARGBto16PixelAlphaSSE41(info, SDL_TRUE);
+}
+
+static void BLIT_TARGET_AVX2
+BlitARGBto565PixelAlphaAVX2(SDL_BlitInfo * info)
+{
+    BlitARGBto16PixelAlphaAVX2(info, SDL_TRUE);
+}
+
+static void BLIT_TARGET_SSE41
+BlitARGBto555PixelAlphaSSE41(SDL_BlitInfo * info)
+{
+    BlitARGBto16PixelAlphaSSE41(info, SDL_FALSE);
+}
+
+static void BLIT_TARGET_AVX2
+BlitARGBto555PixelAlphaAVX2(SDL_BlitInfo * info)
+{
+    BlitARGBto16PixelAlphaAVX2(info, SDL_FALSE);
+}
+
+#endif /* SDL_BLIT_A_X86 */
+
 
 SDL_BlitFunc
 SDL_CalculateBlitA(SDL_Surface * surface)
 {
     SDL_PixelFormat *sf = surface->format;
     SDL_PixelFormat *df = surface->map->dst->format;
+#if SDL_BLIT_A_X86
+    const Uint32 features = SDL_GetBlitCPUFeatures();
+#endif
 
     switch (surface->map->info.flags & ~SDL_COPY_RLE_MASK) {
     case SDL_COPY_BLEND:
@@ -1283,10 +1910,23 @@ SDL_CalculateBlitA(SDL_Surface * surface)
                     && sf->Gmask == 0xff00
                     && ((sf->Rmask == 0xff && df->Rmask == 0x1f)
                         || (sf->Bmask == 0xff && df->Bmask == 0x1f))) {
-                if (df->Gmask == 0x7e0)
+                if (df->Gmask == 0x7e0) {
+#if SDL_BLIT_A_X86
+                    if (features & SDL_CPU_AVX2)
+                        return BlitARGBto565PixelAlphaAVX2;
+                    if (features & SDL_CPU_SSE41)
+                        return BlitARGBto565PixelAlphaSSE41;
+#endif
                     return BlitARGBto565PixelAlpha;
-                else if (df->Gmask == 0x3e0)
+                } else if (df->Gmask == 0x3e0) {
+#if SDL_BLIT_A_X86
+                    if (features & SDL_CPU_AVX2)
+                        return BlitARGBto555PixelAlphaAVX2;
+                    if (features & SDL_CPU_SSE41)
+                        return BlitARGBto555PixelAlphaSSE41;
+#endif
                     return BlitARGBto555PixelAlpha;
+                }
             }
             return BlitNtoNPixelAlpha;
 
@@ -1299,6 +1939,12 @@ SDL_CalculateBlitA(SDL_Surface * surface)
                     && sf->Gshift % 8 == 0
                     && sf->Bshift % 8 == 0
                     && sf->Ashift % 8 == 0 && sf->Aloss == 0) {
+#if SDL_BLIT_A_X86 && defined(__MMX__)
+                    if (features & SDL_CPU_AVX2)
+                        return BlitRGBtoRGBPixelAlphaAVX2;
+                    if (features & SDL_CPU_SSE41)
+                        return BlitRGBtoRGBPixelAlphaSSE41;
+#endif
 #ifdef __3dNOW__
                     if (SDL_Has3DNow())
                         return BlitRGBtoRGBPixelAlphaMMX3DNOW;
@@ -1354,9 +2000,16 @@ SDL_CalculateBlitA(SDL_Surface * surface)
                     && sf->Bmask == df->Bmask && sf->BytesPerPixel == 4) {
 #ifdef __MMX__
                     if (sf->Rshift % 8 == 0
-                        && sf->Gshift % 8 == 0
-                        && sf->Bshift % 8 == 0 && SDL_HasMMX())
-                        return BlitRGBtoRGBSurfaceAlphaMMX;
+                        && sf->Gshift % 8 == 0 && sf->Bshift % 8 == 0) {
+#if SDL_BLIT_A_X86
+                        if (features & SDL_CPU_AVX2)
+                            return BlitRGBtoRGBSurfaceAlphaAVX2;
+                        if (features & SDL_CPU_SSE2)
+                            return BlitRGBtoRGBSurfaceAlphaSSE2;
+#endif
+                        if (SDL_HasMMX())
+                            return BlitRGBtoRGBSurfaceAlphaMMX;
+                    }
 #endif
                     if ((sf->Rmask | sf->Gmask | sf->Bmask) == 0xffffff) {
                         return BlitRGBtoRGBSurfaceAlpha;
@@ -1375,9 +2028,23 @@ SDL_CalculateBlitA(SDL_Surface * surface)
         if (sf->Amask == 0) {
             if (df->BytesPerPixel == 1) {
                 return BlitNto1SurfaceAlphaKey;
-            } else {
-                return BlitNtoNSurfaceAlphaKey;
             }
+#if SDL_BLIT_A_X86
+            if (df->BytesPerPixel == 4 && sf->BytesPerPixel == 4
+                && sf->Rmask == df->Rmask
+                && sf->Gmask == df->Gmask
+                && sf->Bmask == df->Bmask
+                && df->Rshift % 8 == 0 && df->Rloss == 0
+                && df->Gshift % 8 == 0 && df->Gloss == 0
+                && df->Bshift % 8 == 0 && df->Bloss == 0
+                && (df->Amask == 0 || (df->Ashift % 8 == 0 && df->Aloss == 0))) {
+                if (features & SDL_CPU_AVX2)
+                    return BlitRGBtoRGBSurfaceAlphaKeyAVX2;
+                if (features & SDL_CPU_SSE2)
+                    return BlitRGBtoRGBSurfaceAlphaKeySSE2;
+            }
+#endif
+            return BlitNtoNSurfaceAlphaKey;
         }
         break;
     }
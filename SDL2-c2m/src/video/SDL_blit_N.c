@@ -29,6 +29,18 @@
 
 /* Functions to blit from N-bit surfaces to other surfaces */
 
+/* SSE2 & AVX2 (chosen at run time) or NEON blitters for the usual 32-bit
+   byte orders, 24 to 32-bit & 565 to and from 8888, little endian only */
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN && defined(__GNUC__) && \
+    !defined(__clang_analyzer__) && (defined(__x86_64__) || defined(__i386__))
+#define SDL_BLIT_X86 1
+#include <immintrin.h>
+#elif SDL_BYTEORDER == SDL_LIL_ENDIAN && defined(__GNUC__) && \
+    !defined(__clang_analyzer__) && defined(__aarch64__)
+#define SDL_BLIT_NEON 1
+#include <arm_neon.h>
+#endif
+
 #if SDL_ALTIVEC_BLITTERS
 #ifdef HAVE_ALTIVEC_H
 #include <altivec.h>
@@ -870,10 +882,34 @@ GetBlitFeatures(void)
 #pragma altivec_model off
 #endif
 #else
-/* Feature 1 is has-MMX */
-#define GetBlitFeatures() ((Uint32)(SDL_HasMMX() ? 1 : 0))
+/* The SDL_CPU_* flags: feature 1 is has-MMX, 8 has-SSE2, 64 has-AVX2 &
+   128 has-NEON */
+static Uint32
+GetBlitFeatures(void)
+{
+    return SDL_GetBlitCPUFeatures();
+}
 #endif
 
+/* Not the CPU's: the source's or destination's channels are whole bytes
+   (8-8-8 or 8-8-8-8, any order) */
+#define BLIT_FEATURE_SRC_BYTES 0x10000
+#define BLIT_FEATURE_DST_BYTES 0x20000
+
+#define BYTE_CHANNEL(mask, shift) \
+    ((mask) == ((Uint32) 0xFF << (shift)) && ((shift) % 8) == 0)
+
+static SDL_bool
+HasByteChannels(const SDL_PixelFormat * fmt)
+{
+    return ((fmt->BytesPerPixel == 3 || fmt->BytesPerPixel == 4) &&
+            BYTE_CHANNEL(fmt->Rmask, fmt->Rshift) &&
+            BYTE_CHANNEL(fmt->Gmask, fmt->Gshift) &&
+            BYTE_CHANNEL(fmt->Bmask, fmt->Bshift) &&
+            (!fmt->Amask || BYTE_CHANNEL(fmt->Amask, fmt->Ashift))) ?
+        SDL_TRUE : SDL_FALSE;
+}
+
 /* This is now endian dependent */
 #if SDL_BYTEORDER == SDL_LIL_ENDIAN
 #define HI  1
@@ -2454,6 +2490,490 @@ BlitNto2101010(SDL_BlitInfo * info)
     }
 }
 
+#if SDL_BLIT_X86 || SDL_BLIT_NEON
+/* Which source byte each byte of a 32-bit destination pixel comes from, 0x80
+   for none, & the alpha bits to OR in, as BlitNtoN() & BlitNtoNCopyAlpha()
+   would.  Both formats have whole-byte channels. */
+static void
+GetByteSwizzle(const SDL_BlitInfo * info, Uint8 swizzle[4], Uint32 * alpha)
+{
+    const SDL_PixelFormat *srcfmt = info->src_fmt;
+    const SDL_PixelFormat *dstfmt = info->dst_fmt;
+
+    SDL_memset(swizzle, 0x80, 4);
+    swizzle[dstfmt->Rshift / 8] = srcfmt->Rshift / 8;
+    swizzle[dstfmt->Gshift / 8] = srcfmt->Gshift / 8;
+    swizzle[dstfmt->Bshift / 8] = srcfmt->Bshift / 8;
+    *alpha = 0;
+    if (dstfmt->Amask) {
+        if (srcfmt->Amask) {
+            swizzle[dstfmt->Ashift / 8] = srcfmt->Ashift / 8;
+        } else {
+            *alpha = (Uint32) info->a << dstfmt->Ashift;
+        }
+    }
+}
+
+/* The pixels left over after the vectors */
+static void
+BlitByteSwizzle(const Uint8 * src, int srcbpp, Uint32 * dst, int width,
+                const Uint8 swizzle[4], Uint32 alpha)
+{
+    while (width--) {
+        Uint32 pixel = alpha;
+        int i;
+        for (i = 0; i < 4; ++i) {
+            if (swizzle[i] != 0x80) {
+                pixel |= (Uint32) src[swizzle[i]] << (8 * i);
+            }
+        }
+        *dst++ = pixel;
+        src += srcbpp;
+    }
+}
+
+/* The channel of each byte of a 32-bit destination pixel, for a 565 source:
+   0 for red, 1 green, 2 blue & 3 for the one left, which is 0xFF as in the
+   lookup tables of Blit_RGB565_32().  Channels are widened as they are there
+   too, x * 255 / 31 (or 63) rounded down: (x * 1053) >> 7 & (x * 259 + 3) >> 6
+   are the same for every x.  Green's low & high 3 bits are in different bytes
+   there, they're widened apart & added. */
+static void
+Get565Channels(const SDL_PixelFormat * dstfmt, int channel[4])
+{
+    channel[0] = channel[1] = channel[2] = channel[3] = 3;
+    channel[dstfmt->Rshift / 8] = 0;
+    channel[dstfmt->Gshift / 8] = 1;
+    channel[dstfmt->Bshift / 8] = 2;
+}
+
+static void
+Blit565to8888Tail(const Uint16 * src, Uint32 * dst, int width,
+                  const int channel[4])
+{
+    while (width--) {
+        Uint32 c[4];
+        Uint32 r = *src >> 11;
+        Uint32 g = (*src >> 5) & 0x3F;
+        Uint32 b = *src & 0x1F;
+
+        c[0] = (r * 1053) >> 7;
+        c[1] = (((g & 0x38) * 259 + 3) >> 6) + (((g & 7) * 259 + 3) >> 6);
+        c[2] = (b * 1053) >> 7;
+        c[3] = 0xFF;
+        *dst++ = c[channel[0]] | (c[channel[1]] << 8) |
+                 (c[channel[2]] << 16) | (c[channel[3]] << 24);
+        ++src;
+    }
+}
+
+static void
+Blit8888to565Tail(const Uint32 * src, Uint16 * dst, int width)
+{
+    while (width--) {
+        RGB888_RGB565(dst, src);
+        ++dst;
+        ++src;
+    }
+}
+#endif /* SDL_BLIT_X86 || SDL_BLIT_NEON */
+
+#if SDL_BLIT_X86
+/* 32 to 32-bit, each byte of the destination masked out of the source &
+   shifted into place */
+__attribute__((target("sse2"))) static void
+Blit8888to8888SSE2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    Uint8 swizzle[4];
+    Uint32 alpha;
+    __m128i mask[4], left[4], right[4], valpha;
+    int i;
+
+    GetByteSwizzle(info, swizzle, &alpha);
+    for (i = 0; i < 4; ++i) {
+        int shift = 8 * (i - (swizzle[i] & 3));
+
+        mask[i] = _mm_set1_epi32((swizzle[i] == 0x80) ? 0 :
+                                 (int) (0xFFu << (8 * swizzle[i])));
+        left[i] = _mm_cvtsi32_si128((shift > 0) ? shift : 0);
+        right[i] = _mm_cvtsi32_si128((shift < 0) ? -shift : 0);
+    }
+    valpha = _mm_set1_epi32((int) alpha);
+
+    while (height--) {
+        int n = width;
+
+        for (; n >= 4; n -= 4, src += 16, dst += 16) {
+            __m128i pixels = _mm_loadu_si128((const __m128i *) src);
+            __m128i result = valpha;
+
+            for (i = 0; i < 4; ++i) {
+                __m128i byte = _mm_and_si128(pixels, mask[i]);
+                byte = _mm_srl_epi32(_mm_sll_epi32(byte, left[i]), right[i]);
+                result = _mm_or_si128(result, byte);
+            }
+            _mm_storeu_si128((__m128i *) dst, result);
+        }
+        BlitByteSwizzle(src, 4, (Uint32 *) dst, n, swizzle, alpha);
+        src += n * 4 + srcskip;
+        dst += n * 4 + dstskip;
+    }
+}
+
+/* 24 or 32 to 32-bit, each byte of the destination shuffled from the
+   source, 4 pixels from each 128-bit half */
+__attribute__((target("avx2"))) static void
+BlitNto8888AVX2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    int srcbpp = info->src_fmt->BytesPerPixel;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    /* A 24-bit half reads a pixel & a third more than it converts */
+    int least = (srcbpp == 3) ? 10 : 8;
+    Uint8 swizzle[4];
+    Uint8 shuffle[32];
+    Uint32 alpha;
+    __m256i vshuffle, valpha;
+    int i;
+
+    GetByteSwizzle(info, swizzle, &alpha);
+    for (i = 0; i < 32; ++i) {
+        Uint8 byte = swizzle[i & 3];
+        shuffle[i] = (byte == 0x80) ? 0x80 : (Uint8) (((i & 15) / 4) * srcbpp + byte);
+    }
+    vshuffle = _mm256_loadu_si256((const __m256i *) shuffle);
+    valpha = _mm256_set1_epi32((int) alpha);
+
+    while (height--) {
+        int n = width;
+
+        for (; n >= least; n -= 8, src += 8 * srcbpp, dst += 32) {
+            __m256i pixels = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) src)),
+                _mm_loadu_si128((const __m128i *) (src + 4 * srcbpp)), 1);
+
+            _mm256_storeu_si256((__m256i *) dst, _mm256_or_si256(
+                _mm256_shuffle_epi8(pixels, vshuffle), valpha));
+        }
+        BlitByteSwizzle(src, srcbpp, (Uint32 *) dst, n, swizzle, alpha);
+        src += n * srcbpp + srcskip;
+        dst += n * 4 + dstskip;
+    }
+}
+
+/* 565 to 32-bit, channels widened in 16-bit lanes, then interleaved as
+   pairs of them */
+__attribute__((target("sse2"))) static void
+Blit565to8888SSE2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    const __m128i g_mask = _mm_set1_epi16(0x3F);
+    const __m128i b_mask = _mm_set1_epi16(0x1F);
+    const __m128i wide5 = _mm_set1_epi16(1053);
+    const __m128i wide6 = _mm_set1_epi16(259);
+    const __m128i three = _mm_set1_epi16(3);
+    const __m128i g_high = _mm_set1_epi16(0x38);
+    const __m128i g_low = _mm_set1_epi16(0x07);
+    int channel[4];
+
+    Get565Channels(info->dst_fmt, channel);
+
+    while (height--) {
+        int n = width;
+
+        for (; n >= 8; n -= 8, src += 16, dst += 32) {
+            __m128i pixels = _mm_loadu_si128((const __m128i *) src);
+            __m128i r = _mm_srli_epi16(pixels, 11);
+            __m128i g = _mm_and_si128(_mm_srli_epi16(pixels, 5), g_mask);
+            __m128i b = _mm_and_si128(pixels, b_mask);
+            __m128i c[4], low, high, gh, gl;
+
+            c[0] = _mm_srli_epi16(_mm_mullo_epi16(r, wide5), 7);
+            gh = _mm_mullo_epi16(_mm_and_si128(g, g_high), wide6);
+            gl = _mm_mullo_epi16(_mm_and_si128(g, g_low), wide6);
+            gh = _mm_srli_epi16(_mm_add_epi16(gh, three), 6);
+            gl = _mm_srli_epi16(_mm_add_epi16(gl, three), 6);
+            c[1] = _mm_add_epi16(gh, gl);
+            c[2] = _mm_srli_epi16(_mm_mullo_epi16(b, wide5), 7);
+            c[3] = _mm_set1_epi16(0xFF);
+            low = _mm_or_si128(c[channel[0]], _mm_slli_epi16(c[channel[1]], 8));
+            high = _mm_or_si128(c[channel[2]], _mm_slli_epi16(c[channel[3]], 8));
+            _mm_storeu_si128((__m128i *) dst, _mm_unpacklo_epi16(low, high));
+            _mm_storeu_si128((__m128i *) (dst + 16), _mm_unpackhi_epi16(low, high));
+        }
+        Blit565to8888Tail((const Uint16 *) src, (Uint32 *) dst, n, channel);
+        src += n * 2 + srcskip;
+        dst += n * 4 + dstskip;
+    }
+}
+
+__attribute__((target("avx2"))) static void
+Blit565to8888AVX2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    const __m256i g_mask = _mm256_set1_epi16(0x3F);
+    const __m256i b_mask = _mm256_set1_epi16(0x1F);
+    const __m256i wide5 = _mm256_set1_epi16(1053);
+    const __m256i wide6 = _mm256_set1_epi16(259);
+    const __m256i three = _mm256_set1_epi16(3);
+    const __m256i g_high = _mm256_set1_epi16(0x38);
+    const __m256i g_low = _mm256_set1_epi16(0x07);
+    int channel[4];
+
+    Get565Channels(info->dst_fmt, channel);
+
+    while (height--) {
+        int n = width;
+
+        for (; n >= 16; n -= 16, src += 32, dst += 64) {
+            __m256i pixels = _mm256_loadu_si256((const __m256i *) src);
+            __m256i r = _mm256_srli_epi16(pixels, 11);
+            __m256i g = _mm256_and_si256(_mm256_srli_epi16(pixels, 5), g_mask);
+            __m256i b = _mm256_and_si256(pixels, b_mask);
+            __m256i c[4], low, high, first, second, gh, gl;
+
+            c[0] = _mm256_srli_epi16(_mm256_mullo_epi16(r, wide5), 7);
+            gh = _mm256_mullo_epi16(_mm256_and_si256(g, g_high), wide6);
+            gl = _mm256_mullo_epi16(_mm256_and_si256(g, g_low), wide6);
+            gh = _mm256_srli_epi16(_mm256_add_epi16(gh, three), 6);
+            gl = _mm256_srli_epi16(_mm256_add_epi16(gl, three), 6);
+            c[1] = _mm256_add_epi16(gh, gl);
+            c[2] = _mm256_srli_epi16(_mm256_mullo_epi16(b, wide5), 7);
+            c[3] = _mm256_set1_epi16(0xFF);
+            low = _mm256_or_si256(c[channel[0]], _mm256_slli_epi16(c[channel[1]], 8));
+            high = _mm256_or_si256(c[channel[2]], _mm256_slli_epi16(c[channel[3]], 8));
+            /* Interleaving is within halves, pixels 0-3 & 8-11, 4-7 & 12-15 */
+            first = _mm256_unpacklo_epi16(low, high);
+            second = _mm256_unpackhi_epi16(low, high);
+            _mm256_storeu_si256((__m256i *) dst, _mm256_permute2x128_si256(first, second, 0x20));
+            _mm256_storeu_si256((__m256i *) (dst + 32), _mm256_permute2x128_si256(first, second, 0x31));
+        }
+        Blit565to8888Tail((const Uint16 *) src, (Uint32 *) dst, n, channel);
+        src += n * 2 + srcskip;
+        dst += n * 4 + dstskip;
+    }
+}
+
+/* RGB 8-8-8 to 5-6-5, 32-bit results packed to 16 bits, offset by 0x8000
+   for the signed saturation */
+__attribute__((target("sse2"))) static void
+Blit8888to565SSE2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    const __m128i r_mask = _mm_set1_epi32(0xF800);
+    const __m128i g_mask = _mm_set1_epi32(0x07E0);
+    const __m128i b_mask = _mm_set1_epi32(0x001F);
+    const __m128i offset = _mm_set1_epi32(0x8000);
+    const __m128i offset16 = _mm_set1_epi16((short) 0x8000);
+
+    while (height--) {
+        int n = width;
+
+        for (; n >= 8; n -= 8, src += 32, dst += 16) {
+            __m128i result[2];
+            int i;
+
+            for (i = 0; i < 2; ++i) {
+                __m128i pixels = _mm_loadu_si128((const __m128i *) (src + 16 * i));
+
+                result[i] = _mm_or_si128(_mm_or_si128(
+                    _mm_and_si128(_mm_srli_epi32(pixels, 8), r_mask),
+                    _mm_and_si128(_mm_srli_epi32(pixels, 5), g_mask)),
+                    _mm_and_si128(_mm_srli_epi32(pixels, 3), b_mask));
+                result[i] = _mm_sub_epi32(result[i], offset);
+            }
+            _mm_storeu_si128((__m128i *) dst, _mm_add_epi16(
+                _mm_packs_epi32(result[0], result[1]), offset16));
+        }
+        Blit8888to565Tail((const Uint32 *) src, (Uint16 *) dst, n);
+        src += n * 4 + srcskip;
+        dst += n * 2 + dstskip;
+    }
+}
+
+__attribute__((target("avx2"))) static void
+Blit8888to565AVX2(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    const __m256i r_mask = _mm256_set1_epi32(0xF800);
+    const __m256i g_mask = _mm256_set1_epi32(0x07E0);
+    const __m256i b_mask = _mm256_set1_epi32(0x001F);
+    const __m256i offset = _mm256_set1_epi32(0x8000);
+    const __m256i offset16 = _mm256_set1_epi16((short) 0x8000);
+
+    while (height--) {
+        int n = width;
+
+        for (; n >= 16; n -= 16, src += 64, dst += 32) {
+            __m256i result[2];
+            int i;
+
+            for (i = 0; i < 2; ++i) {
+                __m256i pixels = _mm256_loadu_si256((const __m256i *) (src + 32 * i));
+
+                result[i] = _mm256_or_si256(_mm256_or_si256(
+                    _mm256_and_si256(_mm256_srli_epi32(pixels, 8), r_mask),
+                    _mm256_and_si256(_mm256_srli_epi32(pixels, 5), g_mask)),
+                    _mm256_and_si256(_mm256_srli_epi32(pixels, 3), b_mask));
+                result[i] = _mm256_sub_epi32(result[i], offset);
+            }
+            /* Packing is within halves too, put the quarters back in order */
+            _mm256_storeu_si256((__m256i *) dst, _mm256_add_epi16(
+                _mm256_permute4x64_epi64(_mm256_packs_epi32(result[0], result[1]), 0xD8),
+                offset16));
+        }
+        Blit8888to565Tail((const Uint32 *) src, (Uint16 *) dst, n);
+        src += n * 4 + srcskip;
+        dst += n * 2 + dstskip;
+    }
+}
+#endif /* SDL_BLIT_X86 */
+
+#if SDL_BLIT_NEON
+/* 24 or 32 to 32-bit, each byte of the destination looked up in the
+   source, 4 pixels at a time */
+static void
+BlitNto8888NEON(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    int srcbpp = info->src_fmt->BytesPerPixel;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    /* 24-bit reads a pixel & a third more than it converts */
+    int least = (srcbpp == 3) ? 6 : 4;
+    Uint8 swizzle[4];
+    Uint8 table[16];
+    Uint32 alpha;
+    uint8x16_t vtable, valpha;
+    int i;
+
+    GetByteSwizzle(info, swizzle, &alpha);
+    for (i = 0; i < 16; ++i) {
+        Uint8 byte = swizzle[i & 3];
+        /* Out of range indices look up 0 */
+        table[i] = (byte == 0x80) ? 0xFF : (Uint8) ((i / 4) * srcbpp + byte);
+    }
+    vtable = vld1q_u8(table);
+    valpha = vreinterpretq_u8_u32(vdupq_n_u32(alpha));
+
+    while (height--) {
+        int n = width;
+
+        for (; n >= least; n -= 4, src += 4 * srcbpp, dst += 16) {
+            vst1q_u8(dst, vorrq_u8(vqtbl1q_u8(vld1q_u8(src), vtable), valpha));
+        }
+        BlitByteSwizzle(src, srcbpp, (Uint32 *) dst, n, swizzle, alpha);
+        src += n * srcbpp + srcskip;
+        dst += n * 4 + dstskip;
+    }
+}
+
+/* 565 to 32-bit, channels widened in 16-bit lanes */
+static void
+Blit565to8888NEON(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+    int channel[4];
+
+    Get565Channels(info->dst_fmt, channel);
+
+    while (height--) {
+        int n = width;
+
+        for (; n >= 8; n -= 8, src += 16, dst += 32) {
+            uint16x8_t pixels = vld1q_u16((const uint16_t *) src);
+            uint16x8_t r = vshrq_n_u16(pixels, 11);
+            uint16x8_t g = vandq_u16(vshrq_n_u16(pixels, 5), vdupq_n_u16(0x3F));
+            uint16x8_t b = vandq_u16(pixels, vdupq_n_u16(0x1F));
+            uint8x8_t c[4];
+            uint8x8x4_t result;
+
+            c[0] = vmovn_u16(vshrq_n_u16(vmulq_n_u16(r, 1053), 7));
+            c[1] = vmovn_u16(vaddq_u16(
+                vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(3), vandq_u16(g, vdupq_n_u16(0x38)), 259), 6),
+                vshrq_n_u16(vmlaq_n_u16(vdupq_n_u16(3), vandq_u16(g, vdupq_n_u16(0x07)), 259), 6)));
+            c[2] = vmovn_u16(vshrq_n_u16(vmulq_n_u16(b, 1053), 7));
+            c[3] = vdup_n_u8(0xFF);
+            result.val[0] = c[channel[0]];
+            result.val[1] = c[channel[1]];
+            result.val[2] = c[channel[2]];
+            result.val[3] = c[channel[3]];
+            vst4_u8(dst, result);
+        }
+        Blit565to8888Tail((const Uint16 *) src, (Uint32 *) dst, n, channel);
+        src += n * 2 + srcskip;
+        dst += n * 4 + dstskip;
+    }
+}
+
+/* RGB 8-8-8 to 5-6-5, each channel's high bits shifted in under the last */
+static void
+Blit8888to565NEON(SDL_BlitInfo * info)
+{
+    int width = info->dst_w;
+    int height = info->dst_h;
+    Uint8 *src = info->src;
+    int srcskip = info->src_skip;
+    Uint8 *dst = info->dst;
+    int dstskip = info->dst_skip;
+
+    while (height--) {
+        int n = width;
+
+        for (; n >= 8; n -= 8, src += 32, dst += 16) {
+            /* Bytes 2, 1 & 0 are red, green & blue */
+            uint8x8x4_t pixels = vld4_u8(src);
+            uint16x8_t result = vshll_n_u8(pixels.val[2], 8);
+
+            result = vsriq_n_u16(result, vshll_n_u8(pixels.val[1], 8), 5);
+            result = vsriq_n_u16(result, vshll_n_u8(pixels.val[0], 8), 11);
+            vst1q_u16((uint16_t *) dst, result);
+        }
+        Blit8888to565Tail((const Uint32 *) src, (Uint16 *) dst, n);
+        src += n * 4 + srcskip;
+        dst += n * 2 + dstskip;
+    }
+}
+#endif /* SDL_BLIT_NEON */
+
 /* Normal N to N optimized blitters */
 struct blit_table
 {
@@ -2477,6 +2997,21 @@ static const struct blit_table normal_blit_2[] = {
      2, Blit_RGB565_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA},
     {0x00007C00, 0x000003E0, 0x0000001F, 4, 0x00000000, 0x00000000, 0x00000000,
      2, Blit_RGB555_32Altivec, NO_ALPHA | COPY_ALPHA | SET_ALPHA},
+#endif
+#if SDL_BLIT_X86
+    /* has-avx2, 8-8-8-8 destination */
+    {0x0000F800, 0x000007E0, 0x0000001F, 4, 0x00000000, 0x00000000, 0x00000000,
+     SDL_CPU_AVX2 | BLIT_FEATURE_DST_BYTES, Blit565to8888AVX2,
+     NO_ALPHA | COPY_ALPHA | SET_ALPHA},
+    /* has-sse2, 8-8-8-8 destination */
+    {0x0000F800, 0x000007E0, 0x0000001F, 4, 0x00000000, 0x00000000, 0x00000000,
+     SDL_CPU_SSE2 | BLIT_FEATURE_DST_BYTES, Blit565to8888SSE2,
+     NO_ALPHA | COPY_ALPHA | SET_ALPHA},
+#elif SDL_BLIT_NEON
+    /* has-neon, 8-8-8-8 destination */
+    {0x0000F800, 0x000007E0, 0x0000001F, 4, 0x00000000, 0x00000000, 0x00000000,
+     SDL_CPU_NEON | BLIT_FEATURE_DST_BYTES, Blit565to8888NEON,
+     NO_ALPHA | COPY_ALPHA | SET_ALPHA},
 #endif
     {0x0000F800, 0x000007E0, 0x0000001F, 4, 0x00FF0000, 0x0000FF00, 0x000000FF,
      0, Blit_RGB565_ARGB8888, NO_ALPHA | COPY_ALPHA | SET_ALPHA},
@@ -2492,7 +3027,18 @@ static const struct blit_table normal_blit_2[] = {
 };
 
 static const struct blit_table normal_blit_3[] = {
-    /* Default for 24-bit RGB source, never optimized */
+#if SDL_BLIT_X86
+    /* has-avx2, 8-8-8 to 8-8-8-8 */
+    {0x00000000, 0x00000000, 0x00000000, 4, 0x00000000, 0x00000000, 0x00000000,
+     SDL_CPU_AVX2 | BLIT_FEATURE_SRC_BYTES | BLIT_FEATURE_DST_BYTES,
+     BlitNto8888AVX2, NO_ALPHA | COPY_ALPHA | SET_ALPHA},
+#elif SDL_BLIT_NEON
+    /* has-neon, 8-8-8 to 8-8-8-8 */
+    {0x00000000, 0x00000000, 0x00000000, 4, 0x00000000, 0x00000000, 0x00000000,
+     SDL_CPU_NEON | BLIT_FEATURE_SRC_BYTES | BLIT_FEATURE_DST_BYTES,
+     BlitNto8888NEON, NO_ALPHA | COPY_ALPHA | SET_ALPHA},
+#endif
+    /* Default for 24-bit RGB source, optimized by those above */
     {0, 0, 0, 0, 0, 0, 0, 0, BlitNtoN, 0}
 };
 
@@ -2507,6 +3053,30 @@ static const struct blit_table normal_blit_4[] = {
     /* has-altivec */
     {0x00000000, 0x00000000, 0x00000000, 2, 0x0000F800, 0x000007E0, 0x0000001F,
      2, Blit_RGB888_RGB565Altivec, NO_ALPHA},
+#endif
+#if SDL_BLIT_X86
+    /* has-avx2, 8-8-8-8 to 8-8-8-8 */
+    {0x00000000, 0x00000000, 0x00000000, 4, 0x00000000, 0x00000000, 0x00000000,
+     SDL_CPU_AVX2 | BLIT_FEATURE_SRC_BYTES | BLIT_FEATURE_DST_BYTES,
+     BlitNto8888AVX2, NO_ALPHA | COPY_ALPHA | SET_ALPHA},
+    /* has-sse2, 8-8-8-8 to 8-8-8-8 */
+    {0x00000000, 0x00000000, 0x00000000, 4, 0x00000000, 0x00000000, 0x00000000,
+     SDL_CPU_SSE2 | BLIT_FEATURE_SRC_BYTES | BLIT_FEATURE_DST_BYTES,
+     Blit8888to8888SSE2, NO_ALPHA | COPY_ALPHA | SET_ALPHA},
+    /* has-avx2 */
+    {0x00FF0000, 0x0000FF00, 0x000000FF, 2, 0x0000F800, 0x000007E0, 0x0000001F,
+     SDL_CPU_AVX2, Blit8888to565AVX2, NO_ALPHA},
+    /* has-sse2 */
+    {0x00FF0000, 0x0000FF00, 0x000000FF, 2, 0x0000F800, 0x000007E0, 0x0000001F,
+     SDL_CPU_SSE2, Blit8888to565SSE2, NO_ALPHA},
+#elif SDL_BLIT_NEON
+    /* has-neon, 8-8-8-8 to 8-8-8-8 */
+    {0x00000000, 0x00000000, 0x00000000, 4, 0x00000000, 0x00000000, 0x00000000,
+     SDL_CPU_NEON | BLIT_FEATURE_SRC_BYTES | BLIT_FEATURE_DST_BYTES,
+     BlitNto8888NEON, NO_ALPHA | COPY_ALPHA | SET_ALPHA},
+    /* has-neon */
+    {0x00FF0000, 0x0000FF00, 0x000000FF, 2, 0x0000F800, 0x000007E0, 0x0000001F,
+     SDL_CPU_NEON, Blit8888to565NEON, NO_ALPHA},
 #endif
     {0x00FF0000, 0x0000FF00, 0x000000FF, 2, 0x0000F800, 0x000007E0, 0x0000001F,
      0, Blit_RGB888_RGB565, NO_ALPHA},
@@ -2561,8 +3131,13 @@ SDL_CalculateBlitN(SDL_Surface * surface)
         } else {
             /* Now the meat, choose the blitter we want */
             int a_need = NO_ALPHA;
+            Uint32 features = GetBlitFeatures();
             if (dstfmt->Amask)
                 a_need = srcfmt->Amask ? COPY_ALPHA : SET_ALPHA;
+            if (HasByteChannels(srcfmt))
+                features |= BLIT_FEATURE_SRC_BYTES;
+            if (HasByteChannels(dstfmt))
+                features |= BLIT_FEATURE_DST_BYTES;
             table = normal_blit[srcfmt->BytesPerPixel - 1];
             for (which = 0; table[which].dstbpp; ++which) {
                 if (MASKOK(srcfmt->Rmask, table[which].srcR) &&
@@ -2573,7 +3148,7 @@ SDL_CalculateBlitN(SDL_Surface * surface)
                     MASKOK(dstfmt->Bmask, table[which].dstB) &&
                     dstfmt->BytesPerPixel == table[which].dstbpp &&
                     (a_need & table[which].alpha) == a_need &&
-                    ((table[which].blit_features & GetBlitFeatures()) ==
+                    ((table[which].blit_features & features) ==
                      table[which].blit_features))
                     break;
             }
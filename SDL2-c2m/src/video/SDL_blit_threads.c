@@ -0,0 +1,244 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* Large blits, fills and stretches in row bands on a few threads.
+
+   With SDL_HINT_BLIT_THREADS at 2 or more, an operation of at least
+   SDL_BLIT_BANDS_MIN_PIXELS is cut into bands of at least
+   SDL_BLIT_BANDS_MIN_ROWS rows.  The calling thread posts them as a batch,
+   then takes bands the same as the workers do until there are none left
+   and waits for the workers' ones.  The workers are started the first time
+   they're wanted, and wait on a condition variable between batches.  One
+   batch runs at a time: a thread which finds the workers busy (another
+   thread's blit, or a band func blitting) does its operation itself.
+*/
+
+#include "SDL_atomic.h"
+#include "SDL_hints.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+#include "SDL_blit.h"
+
+#define SDL_BLIT_BANDS_MIN_PIXELS (512 * 512)
+#define SDL_BLIT_BANDS_MIN_ROWS 32
+#define SDL_BLIT_BANDS_MAX_THREADS 16
+
+typedef struct
+{
+    SDL_BlitBandFunc func;
+    void *data;
+    int h;
+    int n_bands;
+    SDL_atomic_t next_band;     /* the next one to take */
+    int finished;               /* bands run, under the pool's lock */
+    int users;                  /* workers which took the batch, likewise */
+} SDL_BlitBatch;
+
+static struct
+{
+    SDL_SpinLock init_lock;
+    SDL_mutex *busy;            /* held by the thread with a batch */
+    SDL_mutex *lock;
+    SDL_cond *wake;             /* a new batch (or quit) */
+    SDL_cond *idle;             /* a worker is done with the batch */
+    SDL_BlitBatch *batch;
+    Uint32 generation;          /* of the batch */
+    SDL_Thread *threads[SDL_BLIT_BANDS_MAX_THREADS - 1];
+    int n_threads;
+    SDL_bool quit;
+} SDL_blit_pool;
+
+/* Take & run bands of the batch till there are none left; returns how
+   many were run */
+static int
+SDL_RunBatch(SDL_BlitBatch * batch)
+{
+    int count = 0;
+
+    for (;;) {
+        int band = SDL_AtomicAdd(&batch->next_band, 1);
+        int y, h;
+
+        if (band >= batch->n_bands) {
+            break;
+        }
+        /* Rows are shared out evenly, the first bands get the leftovers */
+        y = band * (batch->h / batch->n_bands) +
+            SDL_min(band, batch->h % batch->n_bands);
+        h = batch->h / batch->n_bands + (band < batch->h % batch->n_bands);
+        batch->func(batch->data, y, h);
+        ++count;
+    }
+    return count;
+}
+
+static int SDLCALL
+SDL_BlitWorker(void *unused)
+{
+    Uint32 generation = 0;
+
+    SDL_LockMutex(SDL_blit_pool.lock);
+    for (;;) {
+        SDL_BlitBatch *batch = SDL_blit_pool.batch;
+        int count;
+
+        if (SDL_blit_pool.quit) {
+            break;
+        }
+        if (!batch || SDL_blit_pool.generation == generation) {
+            SDL_CondWait(SDL_blit_pool.wake, SDL_blit_pool.lock);
+            continue;
+        }
+        generation = SDL_blit_pool.generation;
+        ++batch->users;
+        SDL_UnlockMutex(SDL_blit_pool.lock);
+        count = SDL_RunBatch(batch);
+        SDL_LockMutex(SDL_blit_pool.lock);
+        batch->finished += count;
+        --batch->users;
+        SDL_CondSignal(SDL_blit_pool.idle);
+    }
+    SDL_UnlockMutex(SDL_blit_pool.lock);
+    return 0;
+}
+
+static SDL_bool
+SDL_InitBlitPool(void)
+{
+    SDL_bool ready;
+
+    SDL_AtomicLock(&SDL_blit_pool.init_lock);
+    if (!SDL_blit_pool.lock) {
+        SDL_blit_pool.busy = SDL_CreateMutex();
+        SDL_blit_pool.lock = SDL_CreateMutex();
+        SDL_blit_pool.wake = SDL_CreateCond();
+        SDL_blit_pool.idle = SDL_CreateCond();
+        SDL_blit_pool.quit = SDL_FALSE;
+    }
+    ready = (SDL_blit_pool.busy && SDL_blit_pool.lock &&
+             SDL_blit_pool.wake && SDL_blit_pool.idle) ? SDL_TRUE : SDL_FALSE;
+    SDL_AtomicUnlock(&SDL_blit_pool.init_lock);
+    return ready;
+}
+
+/* Called with the lock */
+static void
+SDL_StartBlitWorkers(int n)
+{
+    n = SDL_min(n, SDL_BLIT_BANDS_MAX_THREADS - 1);
+    while (SDL_blit_pool.n_threads < n) {
+        SDL_Thread *thread = SDL_CreateThread(SDL_BlitWorker, "SDL_blit", NULL);
+
+        if (!thread) {
+            break;
+        }
+        SDL_blit_pool.threads[SDL_blit_pool.n_threads++] = thread;
+    }
+}
+
+void
+SDL_RunBlitBands(int w, int h, SDL_BlitBandFunc func, void *data)
+{
+    const char *hint;
+    int threads;
+    SDL_BlitBatch batch;
+
+    /* The size first, small operations (most of them) don't look at the
+       hint */
+    if (w <= 0 || h < 2 * SDL_BLIT_BANDS_MIN_ROWS ||
+        (Sint64) w * h < SDL_BLIT_BANDS_MIN_PIXELS) {
+        func(data, 0, h);
+        return;
+    }
+    hint = SDL_GetHint(SDL_HINT_BLIT_THREADS);
+    threads = hint ? SDL_atoi(hint) : 0;
+    if (threads < 2 || !SDL_InitBlitPool() ||
+        SDL_TryLockMutex(SDL_blit_pool.busy) != 0) {
+        func(data, 0, h);
+        return;
+    }
+
+    SDL_LockMutex(SDL_blit_pool.lock);
+    SDL_StartBlitWorkers(threads - 1);
+    if (SDL_blit_pool.n_threads == 0) {
+        SDL_UnlockMutex(SDL_blit_pool.lock);
+        SDL_UnlockMutex(SDL_blit_pool.busy);
+        func(data, 0, h);
+        return;
+    }
+    batch.func = func;
+    batch.data = data;
+    batch.h = h;
+    batch.n_bands = SDL_min(SDL_min(threads, SDL_blit_pool.n_threads + 1),
+                            h / SDL_BLIT_BANDS_MIN_ROWS);
+    SDL_AtomicSet(&batch.next_band, 0);
+    batch.finished = 0;
+    batch.users = 0;
+    SDL_blit_pool.batch = &batch;
+    ++SDL_blit_pool.generation;
+    SDL_CondBroadcast(SDL_blit_pool.wake);
+    SDL_UnlockMutex(SDL_blit_pool.lock);
+
+    {
+        int count = SDL_RunBatch(&batch);
+
+        SDL_LockMutex(SDL_blit_pool.lock);
+        batch.finished += count;
+    }
+    /* Workers which are still at a band, or which woke too late to get
+       one, have the batch till they let it go */
+    while (batch.finished < batch.n_bands || batch.users > 0) {
+        SDL_CondWait(SDL_blit_pool.idle, SDL_blit_pool.lock);
+    }
+    SDL_blit_pool.batch = NULL;
+    SDL_UnlockMutex(SDL_blit_pool.lock);
+    SDL_UnlockMutex(SDL_blit_pool.busy);
+}
+
+void
+SDL_QuitBlitThreads(void)
+{
+    int i;
+
+    if (!SDL_blit_pool.lock) {
+        return;
+    }
+    SDL_LockMutex(SDL_blit_pool.lock);
+    SDL_blit_pool.quit = SDL_TRUE;
+    SDL_CondBroadcast(SDL_blit_pool.wake);
+    SDL_UnlockMutex(SDL_blit_pool.lock);
+    for (i = 0; i < SDL_blit_pool.n_threads; ++i) {
+        SDL_WaitThread(SDL_blit_pool.threads[i], NULL);
+    }
+    SDL_blit_pool.n_threads = 0;
+
+    SDL_DestroyCond(SDL_blit_pool.idle);
+    SDL_DestroyCond(SDL_blit_pool.wake);
+    SDL_DestroyMutex(SDL_blit_pool.lock);
+    SDL_DestroyMutex(SDL_blit_pool.busy);
+    SDL_blit_pool.idle = NULL;
+    SDL_blit_pool.wake = NULL;
+    SDL_blit_pool.lock = NULL;
+    SDL_blit_pool.busy = NULL;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -34,11 +34,26 @@
 
 #include "SDL_video.h"
 #include "SDL_assert.h"
+#include "SDL_atomic.h"
+#include "SDL_cpuinfo.h"
 #include "SDL_endian.h"
+#include "SDL_thread.h"
 #include "SDL_pixels_c.h"
 
 #define SAVE_32BIT_BMP
 
+/* Row swapping for bottom-up images, 16 bytes at a time */
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SDL_BMP_SSE2 1
+#include <emmintrin.h>
+#elif defined(__GNUC__) && (defined(__ARM_NEON) || defined(__aarch64__))
+#define SDL_BMP_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Most threads SDL_LoadBMPs() loads on */
+#define SDL_BMP_MAX_THREADS 16
+
 /* Compression encodings for BMP files */
 #ifndef BI_RGB
 #define BI_RGB      0
@@ -50,31 +65,127 @@
 
 static void CorrectAlphaChannel(SDL_Surface *surface)
 {
-    /* Check to see if there is any alpha channel data */
-    SDL_bool hasAlpha = SDL_FALSE;
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-    int alphaChannelOffset = 0;
-#else
-    int alphaChannelOffset = 3;
+    /* Check to see if there is any alpha channel data; the pixels are
+       native ARGB8888 by now, so the alpha is the top byte */
+    Uint32 *pixel = (Uint32 *) surface->pixels;
+    Uint32 *end = pixel + surface->h * surface->pitch / 4;
+    Uint32 alpha = 0;
+
+    /* A block at a time, which the compiler can vectorize */
+    while (pixel < end && !(alpha & 0xFF000000)) {
+        Uint32 *block = pixel + SDL_min(end - pixel, 64);
+        while (pixel < block) {
+            alpha |= *pixel++;
+        }
+    }
+
+    if (!(alpha & 0xFF000000)) {
+        for (pixel = (Uint32 *) surface->pixels; pixel < end; ++pixel) {
+            *pixel |= 0xFF000000;
+        }
+    }
+}
+
+/* Turn a bottom-up image the right way up */
+static void
+SDL_FlipBMPRows(Uint8 * pixels, size_t pitch, int h)
+{
+    Uint8 *a = pixels;
+    Uint8 *b = pixels + (h - 1) * pitch;
+
+    while (a < b) {
+        size_t i = 0;
+#if SDL_BMP_SSE2
+        for (; i + 16 <= pitch; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+            __m128i y = _mm_loadu_si128((const __m128i *) (b + i));
+            _mm_storeu_si128((__m128i *) (a + i), y);
+            _mm_storeu_si128((__m128i *) (b + i), x);
+        }
+#elif SDL_BMP_NEON
+        for (; i + 16 <= pitch; i += 16) {
+            uint8x16_t x = vld1q_u8(a + i);
+            uint8x16_t y = vld1q_u8(b + i);
+            vst1q_u8(a + i, y);
+            vst1q_u8(b + i, x);
+        }
 #endif
-    Uint8 *alpha = ((Uint8*)surface->pixels) + alphaChannelOffset;
-    Uint8 *end = alpha + surface->h * surface->pitch;
+        for (; i < pitch; ++i) {
+            Uint8 t = a[i];
+            a[i] = b[i];
+            b[i] = t;
+        }
+        a += pitch;
+        b -= pitch;
+    }
+}
 
-    while (alpha < end) {
-        if (*alpha != 0) {
-            hasAlpha = SDL_TRUE;
-            break;
+/* Read the pixels of an uncompressed image of 8 bits per pixel or more.
+   Its rows are padded to 4 bytes just as the surface's are, so they're
+   read all at once: copied straight from a memory stream (a mapped file),
+   or read in one go from anything else and flipped in place. */
+static SDL_bool
+SDL_ReadBMPPixels(SDL_RWops * src, SDL_Surface * surface, SDL_bool topDown)
+{
+    const size_t pitch = surface->pitch;
+    const size_t size = surface->h * pitch;
+    Uint8 *pixels = (Uint8 *) surface->pixels;
+    const Uint8 *mapped;
+    size_t mapped_size;
+    Sint64 pos;
+
+    mapped = (const Uint8 *) SDL_RWMappedData(src, &mapped_size);
+    pos = SDL_RWtell(src);
+    if (mapped && pos >= 0 && (Uint64) pos <= mapped_size &&
+        mapped_size - (size_t) pos >= size) {
+        const Uint8 *row = mapped + pos;
+        if (topDown) {
+            SDL_memcpy(pixels, row, size);
+        } else {
+            Uint8 *bits;
+            for (bits = pixels + size; bits > pixels; row += pitch) {
+                bits -= pitch;
+                SDL_memcpy(bits, row, pitch);
+            }
+        }
+        SDL_RWseek(src, size, RW_SEEK_CUR);
+    } else {
+        if (SDL_RWread(src, pixels, 1, size) != size) {
+            SDL_Error(SDL_EFREAD);
+            return SDL_FALSE;
+        }
+        if (!topDown) {
+            SDL_FlipBMPRows(pixels, pitch, surface->h);
         }
-        alpha += 4;
     }
 
-    if (!hasAlpha) {
-        alpha = ((Uint8*)surface->pixels) + alphaChannelOffset;
-        while (alpha < end) {
-            *alpha = SDL_ALPHA_OPAQUE;
-            alpha += 4;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    /* Byte-swap the pixels if needed. Note that the 24bpp
+       case has already been taken care of above. */
+    {
+        int x, y;
+        for (y = 0; y < surface->h; ++y) {
+            Uint8 *bits = pixels + y * pitch;
+            switch (surface->format->BitsPerPixel) {
+            case 15:
+            case 16:{
+                    Uint16 *pix = (Uint16 *) bits;
+                    for (x = 0; x < surface->w; x++)
+                        pix[x] = SDL_Swap16(pix[x]);
+                    break;
+                }
+
+            case 32:{
+                    Uint32 *pix = (Uint32 *) bits;
+                    for (x = 0; x < surface->w; x++)
+                        pix[x] = SDL_Swap32(pix[x]);
+                    break;
+                }
+            }
         }
     }
+#endif
+    return SDL_TRUE;
 }
 
 SDL_Surface *
@@ -351,87 +462,49 @@ SDL_LoadBMP_RW(SDL_RWops * src, int freesrc)
         was_error = SDL_TRUE;
         goto done;
     }
-    top = (Uint8 *)surface->pixels;
-    end = (Uint8 *)surface->pixels+(surface->h*surface->pitch);
-    switch (ExpandBMP) {
-    case 1:
-        bmpPitch = (biWidth + 7) >> 3;
-        pad = (((bmpPitch) % 4) ? (4 - ((bmpPitch) % 4)) : 0);
-        break;
-    case 4:
-        bmpPitch = (biWidth + 1) >> 1;
-        pad = (((bmpPitch) % 4) ? (4 - ((bmpPitch) % 4)) : 0);
-        break;
-    default:
-        pad = ((surface->pitch % 4) ? (4 - (surface->pitch % 4)) : 0);
-        break;
-    }
-    if (topDown) {
-        bits = top;
+    if (!ExpandBMP) {
+        if (!SDL_ReadBMPPixels(src, surface, topDown)) {
+            was_error = SDL_TRUE;
+            goto done;
+        }
     } else {
-        bits = end - surface->pitch;
-    }
-    while (bits >= top && bits < end) {
-        switch (ExpandBMP) {
-        case 1:
-        case 4:{
-                Uint8 pixel = 0;
-                int shift = (8 - ExpandBMP);
-                for (i = 0; i < surface->w; ++i) {
-                    if (i % (8 / ExpandBMP) == 0) {
-                        if (!SDL_RWread(src, &pixel, 1, 1)) {
-                            SDL_SetError("Error reading from BMP");
-                            was_error = SDL_TRUE;
-                            goto done;
-                        }
+        /* Expand 1 and 4 bit pixels a row at a time */
+        top = (Uint8 *)surface->pixels;
+        end = (Uint8 *)surface->pixels+(surface->h*surface->pitch);
+        bmpPitch = (biWidth * ExpandBMP + 7) >> 3;
+        pad = (((bmpPitch) % 4) ? (4 - ((bmpPitch) % 4)) : 0);
+        if (topDown) {
+            bits = top;
+        } else {
+            bits = end - surface->pitch;
+        }
+        while (bits >= top && bits < end) {
+            Uint8 pixel = 0;
+            int shift = (8 - ExpandBMP);
+            for (i = 0; i < surface->w; ++i) {
+                if (i % (8 / ExpandBMP) == 0) {
+                    if (!SDL_RWread(src, &pixel, 1, 1)) {
+                        SDL_SetError("Error reading from BMP");
+                        was_error = SDL_TRUE;
+                        goto done;
                     }
-                    *(bits + i) = (pixel >> shift);
-                    pixel <<= ExpandBMP;
                 }
+                *(bits + i) = (pixel >> shift);
+                pixel <<= ExpandBMP;
             }
-            break;
-
-        default:
-            if (SDL_RWread(src, bits, 1, surface->pitch)
-                != surface->pitch) {
-                SDL_Error(SDL_EFREAD);
-                was_error = SDL_TRUE;
-                goto done;
-            }
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-            /* Byte-swap the pixels if needed. Note that the 24bpp
-               case has already been taken care of above. */
-            switch (biBitCount) {
-            case 15:
-            case 16:{
-                    Uint16 *pix = (Uint16 *) bits;
-                    for (i = 0; i < surface->w; i++)
-                        pix[i] = SDL_Swap16(pix[i]);
-                    break;
-                }
-
-            case 32:{
-                    Uint32 *pix = (Uint32 *) bits;
-                    for (i = 0; i < surface->w; i++)
-                        pix[i] = SDL_Swap32(pix[i]);
-                    break;
+            /* Skip padding bytes, ugh */
+            if (pad) {
+                Uint8 padbyte;
+                for (i = 0; i < pad; ++i) {
+                    SDL_RWread(src, &padbyte, 1, 1);
                 }
             }
-#endif
-            break;
-        }
-        /* Skip padding bytes, ugh */
-        if (pad) {
-            Uint8 padbyte;
-            for (i = 0; i < pad; ++i) {
-                SDL_RWread(src, &padbyte, 1, 1);
+            if (topDown) {
+                bits += surface->pitch;
+            } else {
+                bits -= surface->pitch;
             }
         }
-        if (topDown) {
-            bits += surface->pitch;
-        } else {
-            bits -= surface->pitch;
-        }
     }
     if (correctAlpha) {
         CorrectAlphaChannel(surface);
@@ -450,6 +523,68 @@ SDL_LoadBMP_RW(SDL_RWops * src, int freesrc)
     return (surface);
 }
 
+typedef struct
+{
+    const char **files;
+    SDL_Surface **surfaces;
+    int num;
+    SDL_atomic_t next;          /* the next file to take */
+    SDL_atomic_t loaded;
+} SDL_BMPBatch;
+
+static int SDLCALL
+SDL_LoadBMPWorker(void *data)
+{
+    SDL_BMPBatch *batch = (SDL_BMPBatch *) data;
+
+    for (;;) {
+        int i = SDL_AtomicAdd(&batch->next, 1);
+
+        if (i >= batch->num) {
+            break;
+        }
+        batch->surfaces[i] =
+            SDL_LoadBMP_RW(SDL_RWFromFileMapped(batch->files[i]), 1);
+        if (batch->surfaces[i]) {
+            SDL_AtomicAdd(&batch->loaded, 1);
+        }
+    }
+    return 0;
+}
+
+int
+SDL_LoadBMPs(const char **files, int num, SDL_Surface ** surfaces)
+{
+    SDL_Thread *threads[SDL_BMP_MAX_THREADS - 1];
+    SDL_BMPBatch batch;
+    int n_threads, i;
+
+    if (!files || !surfaces || num < 0) {
+        return SDL_InvalidParamError(!files ? "files" : !surfaces ? "surfaces" : "num");
+    }
+
+    batch.files = files;
+    batch.surfaces = surfaces;
+    batch.num = num;
+    SDL_AtomicSet(&batch.next, 0);
+    SDL_AtomicSet(&batch.loaded, 0);
+
+    /* The calling thread loads files too, alongside the others */
+    n_threads = SDL_min(SDL_min(SDL_GetCPUCount(), num), SDL_BMP_MAX_THREADS) - 1;
+    for (i = 0; i < n_threads; ++i) {
+        threads[i] = SDL_CreateThread(SDL_LoadBMPWorker, "SDL_LoadBMPs", &batch);
+        if (!threads[i]) {
+            break;
+        }
+    }
+    n_threads = i;
+    SDL_LoadBMPWorker(&batch);
+    for (i = 0; i < n_threads; ++i) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    return SDL_AtomicGet(&batch.loaded);
+}
+
 int
 SDL_SaveBMP_RW(SDL_Surface * saveme, SDL_RWops * dst, int freedst)
 {
@@ -23,6 +23,15 @@
 #include "SDL_video.h"
 #include "SDL_blit.h"
 
+/* AVX2 fills, chosen at run time */
+#if defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SDL_FILLRECT_X86 1
+#include <immintrin.h>
+#endif
+
+/* Fills this big go past the cache, which they'd only flush */
+#define SDL_FILLRECT_STREAM_BYTES (4 * 1024 * 1024)
 
 #ifdef __SSE__
 /* *INDENT-OFF* */
@@ -54,7 +63,8 @@
         p += 64; \
     }
 
-#define SSE_END
+#define SSE_END \
+    _mm_sfence();
 
 #define DEFINE_SSE_FILLRECT(bpp, type) \
 static void \
@@ -230,79 +240,144 @@ SDL_FillRect4(Uint8 * pixels, int pitch, Uint32 color, int w, int h)
     }
 }
 
-/* 
- * This function performs a fast fill of the given rectangle with 'color'
- */
-int
-SDL_FillRect(SDL_Surface * dst, const SDL_Rect * rect, Uint32 color)
+#if SDL_FILLRECT_X86
+/* The color repeating every 1, 2 or 4 bytes as it falls offset bytes on */
+static SDL_INLINE Uint32
+SDL_FillColorAt(Uint32 color, uintptr_t offset)
 {
-    SDL_Rect clipped;
-    Uint8 *pixels;
+    const int shift = (int) (offset & 3) * 8;
 
-    if (!dst) {
-        return SDL_SetError("Passed NULL destination surface");
-    }
-
-    /* This function doesn't work on surfaces < 8 bpp */
-    if (dst->format->BitsPerPixel < 8) {
-        return SDL_SetError("SDL_FillRect(): Unsupported surface format");
-    }
+    return shift ? (color >> shift) | (color << (32 - shift)) : color;
+}
 
-    /* If 'rect' == NULL, then fill the whole surface */
-    if (rect) {
-        /* Perform clipping */
-        if (!SDL_IntersectRect(rect, &dst->clip_rect, &clipped)) {
-            return 0;
-        }
-        rect = &clipped;
+/* Under 64 bytes from p, as two vectors overlapping in the middle where
+   they can be; only under 4 bytes are written a byte at a time */
+__attribute__((target("avx2"))) static void
+SDL_FillBytesAVX2(Uint8 * p, int n, Uint32 color)
+{
+    if (n >= 32) {
+        _mm256_storeu_si256((__m256i *) p, _mm256_set1_epi32((int) color));
+        _mm256_storeu_si256((__m256i *) (p + n - 32), _mm256_set1_epi32(
+            (int) SDL_FillColorAt(color, n - 32)));
+    } else if (n >= 16) {
+        _mm_storeu_si128((__m128i *) p, _mm_set1_epi32((int) color));
+        _mm_storeu_si128((__m128i *) (p + n - 16), _mm_set1_epi32(
+            (int) SDL_FillColorAt(color, n - 16)));
+    } else if (n >= 8) {
+        _mm_storel_epi64((__m128i *) p, _mm_set1_epi32((int) color));
+        _mm_storel_epi64((__m128i *) (p + n - 8), _mm_set1_epi32(
+            (int) SDL_FillColorAt(color, n - 8)));
+    } else if (n >= 4) {
+        const Uint32 last = SDL_FillColorAt(color, n - 4);
+
+        SDL_memcpy(p, &color, 4);
+        SDL_memcpy(p + n - 4, &last, 4);
     } else {
-        rect = &dst->clip_rect;
-        /* Don't attempt to fill if the surface's clip_rect is empty */
-        if (SDL_RectEmpty(rect)) {
-            return 0;
+        int i;
+        for (i = 0; i < n; ++i) {
+            p[i] = (Uint8) (color >> (8 * i));
         }
     }
+}
 
-    /* Perform software fill */
-    if (!dst->pixels) {
-        return SDL_SetError("SDL_FillRect(): You must lock the surface");
+/* Rows of n bytes: the whole cache lines with aligned vectors, streamed
+   for big fills, the ends apart so no line is both streamed & stored */
+__attribute__((target("avx2"))) static void
+SDL_FillRectAVX2(Uint8 * pixels, int pitch, Uint32 color, int n, int h,
+                 SDL_bool stream)
+{
+    while (h--) {
+        Uint8 *p = pixels;
+        Uint8 *a = (Uint8 *) (((uintptr_t) p + 63) & ~(uintptr_t) 63);
+        Uint8 *end = (Uint8 *) (((uintptr_t) p + n) & ~(uintptr_t) 63);
+
+        if (n < 64) {
+            SDL_FillBytesAVX2(p, n, color);
+        } else {
+            const __m256i line = _mm256_set1_epi32(
+                (int) SDL_FillColorAt(color, a - p));
+
+            if (end < a) {      /* no whole line, the ends meet */
+                end = a;
+            }
+            SDL_FillBytesAVX2(p, (int) (a - p), color);
+            if (stream) {
+                for (; a < end; a += 64) {
+                    _mm256_stream_si256((__m256i *) a, line);
+                    _mm256_stream_si256((__m256i *) (a + 32), line);
+                }
+            } else {
+                for (; a < end; a += 64) {
+                    _mm256_store_si256((__m256i *) a, line);
+                    _mm256_store_si256((__m256i *) (a + 32), line);
+                }
+            }
+            SDL_FillBytesAVX2(end, (int) (p + n - end),
+                              SDL_FillColorAt(color, end - p));
+        }
+        pixels += pitch;
     }
+    if (stream) {
+        _mm_sfence();
+    }
+}
+#endif /* SDL_FILLRECT_X86 */
 
-    pixels = (Uint8 *) dst->pixels + rect->y * dst->pitch +
-                                     rect->x * dst->format->BytesPerPixel;
+typedef struct
+{
+    Uint8 *pixels;              /* the rectangle's first row */
+    int pitch;
+    int bpp;
+    Uint32 color;               /* repeated to fill 32 bits */
+    int w;
+    SDL_bool avx2;
+    SDL_bool stream;
+} SDL_FillRectBands;
+
+/* Rows y to y + h - 1 of a fill */
+static void
+SDL_FillRectBand(void *data, int y, int h)
+{
+    const SDL_FillRectBands *fill = (const SDL_FillRectBands *) data;
+    Uint8 *pixels = fill->pixels + y * fill->pitch;
+
+#if SDL_FILLRECT_X86
+    if (fill->avx2 && fill->bpp != 3) {
+        SDL_FillRectAVX2(pixels, fill->pitch, fill->color, fill->w * fill->bpp,
+                         h, fill->stream);
+        return;
+    }
+#endif
 
-    switch (dst->format->BytesPerPixel) {
+    switch (fill->bpp) {
     case 1:
         {
-            color |= (color << 8);
-            color |= (color << 16);
 #ifdef __SSE__
             if (SDL_HasSSE()) {
-                SDL_FillRect1SSE(pixels, dst->pitch, color, rect->w, rect->h);
+                SDL_FillRect1SSE(pixels, fill->pitch, fill->color, fill->w, h);
                 break;
             }
 #endif
-            SDL_FillRect1(pixels, dst->pitch, color, rect->w, rect->h);
+            SDL_FillRect1(pixels, fill->pitch, fill->color, fill->w, h);
             break;
         }
 
     case 2:
         {
-            color |= (color << 16);
 #ifdef __SSE__
             if (SDL_HasSSE()) {
-                SDL_FillRect2SSE(pixels, dst->pitch, color, rect->w, rect->h);
+                SDL_FillRect2SSE(pixels, fill->pitch, fill->color, fill->w, h);
                 break;
             }
 #endif
-            SDL_FillRect2(pixels, dst->pitch, color, rect->w, rect->h);
+            SDL_FillRect2(pixels, fill->pitch, fill->color, fill->w, h);
             break;
         }
 
     case 3:
         /* 24-bit RGB is a slow path, at least for now. */
         {
-            SDL_FillRect3(pixels, dst->pitch, color, rect->w, rect->h);
+            SDL_FillRect3(pixels, fill->pitch, fill->color, fill->w, h);
             break;
         }
 
@@ -310,34 +385,201 @@ SDL_FillRect(SDL_Surface * dst, const SDL_Rect * rect, Uint32 color)
         {
 #ifdef __SSE__
             if (SDL_HasSSE()) {
-                SDL_FillRect4SSE(pixels, dst->pitch, color, rect->w, rect->h);
+                SDL_FillRect4SSE(pixels, fill->pitch, fill->color, fill->w, h);
                 break;
             }
 #endif
-            SDL_FillRect4(pixels, dst->pitch, color, rect->w, rect->h);
+            SDL_FillRect4(pixels, fill->pitch, fill->color, fill->w, h);
             break;
         }
     }
+}
+
+/* Get ready to fill dst with color */
+static int
+SDL_SetupFillRect(SDL_FillRectBands * fill, SDL_Surface * dst, Uint32 color)
+{
+    /* Perform software fill */
+    if (!dst->pixels) {
+        return SDL_SetError("SDL_FillRect(): You must lock the surface");
+    }
+
+    fill->pitch = dst->pitch;
+    fill->bpp = dst->format->BytesPerPixel;
+    if (fill->bpp == 1) {
+        color &= 0xFF;
+        color |= (color << 8);
+        color |= (color << 16);
+    } else if (fill->bpp == 2) {
+        color &= 0xFFFF;
+        color |= (color << 16);
+    }
+    fill->color = color;
+#if SDL_FILLRECT_X86
+    fill->avx2 = (SDL_GetBlitCPUFeatures() & SDL_CPU_AVX2) ? SDL_TRUE : SDL_FALSE;
+#else
+    fill->avx2 = SDL_FALSE;
+#endif
+    return 0;
+}
+
+/* Fill a rectangle inside dst */
+static void
+SDL_FillClippedRect(SDL_FillRectBands * fill, SDL_Surface * dst,
+                    const SDL_Rect * rect)
+{
+    fill->pixels = (Uint8 *) dst->pixels + rect->y * dst->pitch +
+                                           rect->x * fill->bpp;
+    fill->w = rect->w;
+    fill->stream = ((Sint64) rect->w * rect->h * fill->bpp >=
+                    SDL_FILLRECT_STREAM_BYTES) ? SDL_TRUE : SDL_FALSE;
+    SDL_RunBlitBands(rect->w, rect->h, SDL_FillRectBand, fill);
+}
+
+/* 
+ * This function performs a fast fill of the given rectangle with 'color'
+ */
+int
+SDL_FillRect(SDL_Surface * dst, const SDL_Rect * rect, Uint32 color)
+{
+    SDL_Rect clipped;
+    SDL_FillRectBands fill;
+
+    if (!dst) {
+        return SDL_SetError("Passed NULL destination surface");
+    }
+
+    /* This function doesn't work on surfaces < 8 bpp */
+    if (dst->format->BitsPerPixel < 8) {
+        return SDL_SetError("SDL_FillRect(): Unsupported surface format");
+    }
+
+    /* If 'rect' == NULL, then fill the whole surface */
+    if (rect) {
+        /* Perform clipping */
+        if (!SDL_IntersectRect(rect, &dst->clip_rect, &clipped)) {
+            return 0;
+        }
+        rect = &clipped;
+    } else {
+        rect = &dst->clip_rect;
+        /* Don't attempt to fill if the surface's clip_rect is empty */
+        if (SDL_RectEmpty(rect)) {
+            return 0;
+        }
+    }
+
+    if (SDL_SetupFillRect(&fill, dst, color) < 0) {
+        return -1;
+    }
+    SDL_AddSurfaceDamage(dst, rect);
+    SDL_FillClippedRect(&fill, dst, rect);
 
     /* We're done! */
     return 0;
 }
 
+/* Top to bottom, then left to right, with rows of the same height together:
+   a clipped rectangle as a key, for surfaces under 65536 pixels across &
+   32768 down (the sort is signed) */
+#define SDL_FILLRECT_KEY(rect) \
+    (((Uint64) (rect)->y << 48) | ((Uint64) (rect)->h << 32) | \
+     ((Uint64) (rect)->x << 16) | (Uint64) (rect)->w)
+
+static int
+SDL_CompareFillRects(const void *a, const void *b)
+{
+    const SDL_Rect *A = (const SDL_Rect *) a;
+    const SDL_Rect *B = (const SDL_Rect *) b;
+
+    if (A->y != B->y) {
+        return (A->y < B->y) ? -1 : 1;
+    }
+    if (A->h != B->h) {
+        return (A->h < B->h) ? -1 : 1;
+    }
+    if (A->x != B->x) {
+        return (A->x < B->x) ? -1 : 1;
+    }
+    return 0;
+}
+
+/* The rectangles are clipped together, sorted in memory order & merged
+   where they're on the same rows & touch or overlap, then filled with the
+   checks & setup of SDL_FillRect() done once */
 int
 SDL_FillRects(SDL_Surface * dst, const SDL_Rect * rects, int count,
               Uint32 color)
 {
-    int i;
-    int status = 0;
+    SDL_FillRectBands fill;
+    SDL_Rect *clipped;
+    Sint64 *keys;
+    int i, n;
 
     if (!rects) {
         return SDL_SetError("SDL_FillRects() passed NULL rects");
     }
+    if (count <= 0) {
+        return 0;
+    }
+    if (!dst) {
+        return SDL_SetError("Passed NULL destination surface");
+    }
+    if (dst->format->BitsPerPixel < 8) {
+        return SDL_SetError("SDL_FillRect(): Unsupported surface format");
+    }
+
+    clipped = (SDL_Rect *) SDL_malloc(count * (sizeof(*clipped) + sizeof(*keys)));
+    if (!clipped) {
+        int status = 0;
+
+        for (i = 0; i < count; ++i) {
+            status += SDL_FillRect(dst, &rects[i], color);
+        }
+        return status;
+    }
+    for (i = 0, n = 0; i < count; ++i) {
+        if (SDL_IntersectRect(&rects[i], &dst->clip_rect, &clipped[n])) {
+            ++n;
+        }
+    }
+    if (n == 0) {
+        SDL_free(clipped);
+        return 0;
+    }
+    if (SDL_SetupFillRect(&fill, dst, color) < 0) {
+        SDL_free(clipped);
+        return -1;
+    }
+
+    /* The typed sort compares inline, much faster than with a callback */
+    if (dst->w <= 0xFFFF && dst->h <= 0x7FFF) {
+        keys = (Sint64 *) (clipped + count);
+        for (i = 0; i < n; ++i) {
+            keys[i] = (Sint64) SDL_FILLRECT_KEY(&clipped[i]);
+        }
+        SDL_qsort_int64(keys, n);
+        for (i = 0; i < n; ++i) {
+            clipped[i].y = (int) ((Uint64) keys[i] >> 48);
+            clipped[i].h = (int) ((keys[i] >> 32) & 0xFFFF);
+            clipped[i].x = (int) ((keys[i] >> 16) & 0xFFFF);
+            clipped[i].w = (int) (keys[i] & 0xFFFF);
+        }
+    } else {
+        SDL_qsort(clipped, n, sizeof(*clipped), SDL_CompareFillRects);
+    }
+    for (i = 0; i < n;) {
+        SDL_Rect rect = clipped[i];
 
-    for (i = 0; i < count; ++i) {
-        status += SDL_FillRect(dst, &rects[i], color);
+        for (++i; i < n && clipped[i].y == rect.y && clipped[i].h == rect.h &&
+                  clipped[i].x <= rect.x + rect.w; ++i) {
+            rect.w = SDL_max(rect.w, clipped[i].x + clipped[i].w - rect.x);
+        }
+        SDL_AddSurfaceDamage(dst, &rect);
+        SDL_FillClippedRect(&fill, dst, &rect);
     }
-    return status;
+    SDL_free(clipped);
+    return 0;
 }
 
 /* vi: set ts=4 sw=4 expandtab: */
@@ -22,6 +22,7 @@
 
 /* General (mostly internal) pixel/color manipulation routines for SDL */
 
+#include "SDL_atomic.h"
 #include "SDL_endian.h"
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
@@ -29,6 +30,10 @@
 #include "SDL_pixels_c.h"
 #include "SDL_RLEaccel_c.h"
 
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SDL_INVMAP_SSE2 1
+#include <emmintrin.h>
+#endif
 
 /* Lookup tables to expand partial bytes to the full 0..255 range */
 
@@ -613,6 +618,288 @@ SDL_FreeFormat(SDL_PixelFormat *format)
     SDL_free(format);
 }
 
+/* Inverse color maps, for SDL_FindColor() on palettes from
+   SDL_AllocPalette().  RGB space is cut into 16x16x16 cells, and the first
+   time a color in a cell is looked for, the palette colors which could be
+   the nearest to anything in it are found: those no further from the cell
+   than the furthest any color's nearest corner can be.  After that only
+   those few are searched, so the answer is just what searching the whole
+   palette gives.  This only holds when every color has the same alpha
+   (then alpha adds the same to every distance); other palettes are always
+   searched through.  A map is made again when the palette's version,
+   colors or size change. */
+#define SDL_INVMAP_BITS 4
+#define SDL_INVMAP_CELLS (1 << (3 * SDL_INVMAP_BITS))
+#define SDL_INVMAP_UNKNOWN 0xFFFF
+#define SDL_INVMAP_MIN_COLORS 16   /* smaller palettes are searched quickly */
+#define SDL_INVMAP_BUCKETS 64
+
+typedef struct SDL_InverseMap
+{
+    const SDL_Palette *palette;
+    Uint32 version;             /* the palette's, when the map was made */
+    int ncolors;
+    const SDL_Color *colors;
+    SDL_bool usable;            /* every color has the same alpha */
+    int padded;                 /* ncolors, up to a multiple of 8 */
+    Sint16 *rgb;                /* padded reds, then greens, then blues */
+    Uint32 *cell_start;         /* where each cell's colors are in pool */
+    Uint16 *cell_count;         /* how many, or SDL_INVMAP_UNKNOWN */
+    Uint8 *pool;
+    int pool_used;
+    int pool_size;
+    struct SDL_InverseMap *next;
+} SDL_InverseMap;
+
+static SDL_SpinLock SDL_invmap_lock;
+static SDL_InverseMap *SDL_invmaps[SDL_INVMAP_BUCKETS];
+
+#define SDL_INVMAP_BUCKET(palette) \
+    ((((uintptr_t) (palette)) >> 4) & (SDL_INVMAP_BUCKETS - 1))
+
+static void
+SDL_FreeInverseMapData(SDL_InverseMap * map)
+{
+    SDL_free(map->rgb);
+    SDL_free(map->cell_start);
+    SDL_free(map->cell_count);
+    SDL_free(map->pool);
+}
+
+/* A palette gets a map (empty till it's used) when it's allocated */
+static void
+SDL_AddInverseMap(const SDL_Palette * palette)
+{
+    SDL_InverseMap *map = (SDL_InverseMap *) SDL_calloc(1, sizeof(*map));
+    SDL_InverseMap **bucket = &SDL_invmaps[SDL_INVMAP_BUCKET(palette)];
+
+    if (!map) {
+        return;  /* no matter, it's searched through */
+    }
+    map->palette = palette;
+    SDL_AtomicLock(&SDL_invmap_lock);
+    map->next = *bucket;
+    *bucket = map;
+    SDL_AtomicUnlock(&SDL_invmap_lock);
+}
+
+static void
+SDL_RemoveInverseMap(const SDL_Palette * palette)
+{
+    SDL_InverseMap **prev = &SDL_invmaps[SDL_INVMAP_BUCKET(palette)];
+    SDL_InverseMap *map;
+
+    SDL_AtomicLock(&SDL_invmap_lock);
+    for (map = *prev; map; prev = &map->next, map = map->next) {
+        if (map->palette == palette) {
+            *prev = map->next;
+            break;
+        }
+    }
+    SDL_AtomicUnlock(&SDL_invmap_lock);
+    if (map) {
+        SDL_FreeInverseMapData(map);
+        SDL_free(map);
+    }
+}
+
+/* Called with the lock */
+static SDL_InverseMap *
+SDL_GetInverseMap(const SDL_Palette * palette)
+{
+    SDL_InverseMap *map;
+
+    for (map = SDL_invmaps[SDL_INVMAP_BUCKET(palette)]; map; map = map->next) {
+        if (map->palette == palette) {
+            return map;
+        }
+    }
+    return NULL;
+}
+
+/* Start the map afresh for the palette as it is now; SDL_FALSE if it can't
+   be used */
+static SDL_bool
+SDL_ResetInverseMap(SDL_InverseMap * map)
+{
+    const SDL_Palette *palette = map->palette;
+    int i;
+
+    map->version = palette->version;
+    map->ncolors = palette->ncolors;
+    map->colors = palette->colors;
+    map->usable = SDL_FALSE;
+    for (i = 1; i < palette->ncolors; ++i) {
+        if (palette->colors[i].a != palette->colors[0].a) {
+            return SDL_FALSE;
+        }
+    }
+
+    if (!map->cell_start) {
+        map->cell_start = (Uint32 *) SDL_malloc(SDL_INVMAP_CELLS * sizeof(*map->cell_start));
+        map->cell_count = (Uint16 *) SDL_malloc(SDL_INVMAP_CELLS * sizeof(*map->cell_count));
+        if (!map->cell_start || !map->cell_count) {
+            SDL_FreeInverseMapData(map);
+            map->cell_start = NULL;
+            map->cell_count = NULL;
+            map->rgb = NULL;
+            map->pool = NULL;
+            return SDL_FALSE;
+        }
+    }
+    SDL_free(map->rgb);
+    map->padded = (palette->ncolors + 7) & ~7;
+    map->rgb = (Sint16 *) SDL_calloc(3 * map->padded, sizeof(*map->rgb));
+    if (!map->rgb) {
+        return SDL_FALSE;
+    }
+    for (i = 0; i < palette->ncolors; ++i) {
+        map->rgb[i] = palette->colors[i].r;
+        map->rgb[map->padded + i] = palette->colors[i].g;
+        map->rgb[2 * map->padded + i] = palette->colors[i].b;
+    }
+    SDL_memset(map->cell_count, 0xFF, SDL_INVMAP_CELLS * sizeof(*map->cell_count));
+    map->pool_used = 0;
+    map->usable = SDL_TRUE;
+    return SDL_TRUE;
+}
+
+/* The squared distances from each color to the nearest and furthest
+   points of the box lo..hi */
+static void
+SDL_InverseMapDistances(const SDL_InverseMap * map, const int *lo,
+                        const int *hi, Uint32 * nearest, Uint32 * furthest)
+{
+    int i = 0, c;
+
+#if SDL_INVMAP_SSE2
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i < map->padded; i += 8) {
+        __m128i near_lo = zero, near_hi = zero, far_lo = zero, far_hi = zero;
+
+        for (c = 0; c < 3; ++c) {
+            const __m128i v = _mm_loadu_si128((const __m128i *) &map->rgb[c * map->padded + i]);
+            const __m128i l = _mm_set1_epi16((short) lo[c]);
+            const __m128i h = _mm_set1_epi16((short) hi[c]);
+            __m128i dn = _mm_max_epi16(_mm_max_epi16(_mm_sub_epi16(l, v), _mm_sub_epi16(v, h)), zero);
+            __m128i df = _mm_max_epi16(_mm_sub_epi16(v, l), _mm_sub_epi16(h, v));
+
+            /* Squares of up to 255 fit 16 bits unsigned, sums need 32 */
+            dn = _mm_mullo_epi16(dn, dn);
+            df = _mm_mullo_epi16(df, df);
+            near_lo = _mm_add_epi32(near_lo, _mm_unpacklo_epi16(dn, zero));
+            near_hi = _mm_add_epi32(near_hi, _mm_unpackhi_epi16(dn, zero));
+            far_lo = _mm_add_epi32(far_lo, _mm_unpacklo_epi16(df, zero));
+            far_hi = _mm_add_epi32(far_hi, _mm_unpackhi_epi16(df, zero));
+        }
+        _mm_storeu_si128((__m128i *) &nearest[i], near_lo);
+        _mm_storeu_si128((__m128i *) &nearest[i + 4], near_hi);
+        _mm_storeu_si128((__m128i *) &furthest[i], far_lo);
+        _mm_storeu_si128((__m128i *) &furthest[i + 4], far_hi);
+    }
+#endif
+    for (; i < map->padded; ++i) {
+        nearest[i] = 0;
+        furthest[i] = 0;
+        for (c = 0; c < 3; ++c) {
+            const int v = map->rgb[c * map->padded + i];
+            const int dn = (v < lo[c]) ? (lo[c] - v) : (v > hi[c]) ? (v - hi[c]) : 0;
+            const int df = SDL_max(v - lo[c], hi[c] - v);
+
+            nearest[i] += dn * dn;
+            furthest[i] += df * df;
+        }
+    }
+}
+
+/* Find the colors which could be nearest to something in the cell */
+static SDL_bool
+SDL_FillInverseCell(SDL_InverseMap * map, int cell)
+{
+    Uint32 nearest[256], furthest[256], limit;
+    int lo[3], hi[3];
+    int c, i, count;
+
+    for (c = 0; c < 3; ++c) {
+        const int at = (cell >> ((2 - c) * SDL_INVMAP_BITS)) & ((1 << SDL_INVMAP_BITS) - 1);
+        lo[c] = at << (8 - SDL_INVMAP_BITS);
+        hi[c] = lo[c] + (1 << (8 - SDL_INVMAP_BITS)) - 1;
+    }
+    SDL_InverseMapDistances(map, lo, hi, nearest, furthest);
+
+    limit = furthest[0];
+    for (i = 1; i < map->ncolors; ++i) {
+        limit = SDL_min(limit, furthest[i]);
+    }
+    if (map->pool_size - map->pool_used < map->ncolors) {
+        int size = SDL_max(map->pool_size * 2, 4096);
+        Uint8 *pool = (Uint8 *) SDL_realloc(map->pool, size);
+        if (!pool) {
+            return SDL_FALSE;
+        }
+        map->pool = pool;
+        map->pool_size = size;
+    }
+    count = 0;
+    for (i = 0; i < map->ncolors; ++i) {
+        if (nearest[i] <= limit) {
+            map->pool[map->pool_used + count++] = (Uint8) i;
+        }
+    }
+    map->cell_start[cell] = map->pool_used;
+    map->cell_count[cell] = (Uint16) count;
+    map->pool_used += count;
+    return SDL_TRUE;
+}
+
+/* Look the color up in the palette's map, if it has a usable one */
+static SDL_bool
+SDL_FindColorInMap(const SDL_Palette * pal, Uint8 r, Uint8 g, Uint8 b,
+                   Uint8 * pixel)
+{
+    SDL_InverseMap *map;
+    SDL_bool found = SDL_FALSE;
+
+    SDL_AtomicLock(&SDL_invmap_lock);
+    map = SDL_GetInverseMap(pal);
+    if (map && (map->version != pal->version || map->ncolors != pal->ncolors ||
+                map->colors != pal->colors)) {
+        SDL_ResetInverseMap(map);
+    }
+    if (map && map->usable) {
+        const int cell = ((r >> (8 - SDL_INVMAP_BITS)) << (2 * SDL_INVMAP_BITS)) |
+                         ((g >> (8 - SDL_INVMAP_BITS)) << SDL_INVMAP_BITS) |
+                         (b >> (8 - SDL_INVMAP_BITS));
+
+        if (map->cell_count[cell] != SDL_INVMAP_UNKNOWN ||
+            SDL_FillInverseCell(map, cell)) {
+            const Uint8 *index = &map->pool[map->cell_start[cell]];
+            const Uint8 *end = index + map->cell_count[cell];
+            unsigned int smallest = ~0;
+
+            /* The colors are in order, so ties go the same way */
+            for (; index < end; ++index) {
+                const SDL_Color *color = &pal->colors[*index];
+                const int rd = color->r - r;
+                const int gd = color->g - g;
+                const int bd = color->b - b;
+                const unsigned int distance = (rd * rd) + (gd * gd) + (bd * bd);
+                if (distance < smallest) {
+                    *pixel = *index;
+                    if (distance == 0) {
+                        break;
+                    }
+                    smallest = distance;
+                }
+            }
+            found = SDL_TRUE;
+        }
+    }
+    SDL_AtomicUnlock(&SDL_invmap_lock);
+    return found;
+}
+
 SDL_Palette *
 SDL_AllocPalette(int ncolors)
 {
@@ -640,6 +927,7 @@ SDL_AllocPalette(int ncolors)
     palette->refcount = 1;
 
     SDL_memset(palette->colors, 0xFF, ncolors * sizeof(*palette->colors));
+    SDL_AddInverseMap(palette);
 
     return palette;
 }
@@ -709,6 +997,7 @@ SDL_FreePalette(SDL_Palette * palette)
     if (--palette->refcount > 0) {
         return;
     }
+    SDL_RemoveInverseMap(palette);
     SDL_free(palette->colors);
     SDL_free(palette);
 }
@@ -778,6 +1067,11 @@ SDL_FindColor(SDL_Palette * pal, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
     int i;
     Uint8 pixel = 0;
 
+    if (pal->ncolors > SDL_INVMAP_MIN_COLORS && pal->ncolors <= 256 &&
+        SDL_FindColorInMap(pal, r, g, b, &pixel)) {
+        return (pixel);
+    }
+
     smallest = ~0;
     for (i = 0; i < pal->ncolors; ++i) {
         rd = pal->colors[i].r - r;
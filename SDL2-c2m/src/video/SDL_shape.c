@@ -62,184 +62,458 @@ SDL_IsShapedWindow(const SDL_Window *window)
         return (SDL_bool)(window->shaper != NULL);
 }
 
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SDL_SHAPE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define SDL_SHAPE_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Fill mask[0..w-1] with 1 for each opaque pixel of row y, 0 otherwise. */
+static void
+SDL_CalculateShapeMaskRow(const SDL_WindowShapeMode *mode,SDL_Surface *shape,int y,Uint8 *mask)
+{
+    const SDL_PixelFormat *format = shape->format;
+    const Uint8 *row = (const Uint8 *)shape->pixels + y*shape->pitch;
+    Uint8 r = 0,g = 0,b = 0,alpha = 0;
+    Uint32 pixel_value = 0;
+    Uint8 cutoff = (mode->mode == ShapeModeDefault ? 1 : mode->parameters.binarizationCutoff);
+    SDL_bool reverse = (mode->mode == ShapeModeReverseBinarizeAlpha ? SDL_TRUE : SDL_FALSE);
+    SDL_Color key;
+    int x = 0;
+
+    if(format->BytesPerPixel == 4 && format->Amask != 0 && format->Aloss == 0 && SDL_SHAPEMODEALPHA(mode->mode)) {
+        /* 8-bit alpha: compare it straight out of the pixel. */
+        const Uint32 *pixels = (const Uint32 *)row;
+        const int shift = format->Ashift;
+#if SDL_SHAPE_SSE2
+        const __m128i count = _mm_cvtsi32_si128(shift);
+        const __m128i low = _mm_set1_epi32(0xFF);
+        const __m128i cut = _mm_set1_epi8((char)cutoff);
+        const __m128i one = _mm_set1_epi8(1);
+        for(;x + 16 <= shape->w;x += 16) {
+            __m128i a0 = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128((const __m128i *)&pixels[x]),count),low);
+            __m128i a1 = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128((const __m128i *)&pixels[x + 4]),count),low);
+            __m128i a2 = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128((const __m128i *)&pixels[x + 8]),count),low);
+            __m128i a3 = _mm_and_si128(_mm_srl_epi32(_mm_loadu_si128((const __m128i *)&pixels[x + 12]),count),low);
+            __m128i a = _mm_packus_epi16(_mm_packs_epi32(a0,a1),_mm_packs_epi32(a2,a3));
+            /* a >= cutoff exactly when max(a, cutoff) == a, a <= cutoff when min is. */
+            __m128i opaque = _mm_cmpeq_epi8(reverse ? _mm_min_epu8(a,cut) : _mm_max_epu8(a,cut),a);
+            _mm_storeu_si128((__m128i *)&mask[x],_mm_and_si128(opaque,one));
+        }
+#elif SDL_SHAPE_NEON
+        const int32x4_t count = vdupq_n_s32(-shift);
+        const uint8x16_t cut = vdupq_n_u8(cutoff);
+        const uint8x16_t one = vdupq_n_u8(1);
+        for(;x + 16 <= shape->w;x += 16) {
+            uint16x8_t a01 = vcombine_u16(vmovn_u32(vshlq_u32(vld1q_u32(&pixels[x]),count)),
+                                          vmovn_u32(vshlq_u32(vld1q_u32(&pixels[x + 4]),count)));
+            uint16x8_t a23 = vcombine_u16(vmovn_u32(vshlq_u32(vld1q_u32(&pixels[x + 8]),count)),
+                                          vmovn_u32(vshlq_u32(vld1q_u32(&pixels[x + 12]),count)));
+            uint8x16_t a = vcombine_u8(vmovn_u16(a01),vmovn_u16(a23));
+            uint8x16_t opaque = (reverse ? vcleq_u8(a,cut) : vcgeq_u8(a,cut));
+            vst1q_u8(&mask[x],vandq_u8(opaque,one));
+        }
+#endif
+        for(;x<shape->w;x++) {
+            alpha = (Uint8)(pixels[x] >> shift);
+            mask[x] = (reverse ? alpha <= cutoff : alpha >= cutoff);
+        }
+        return;
+    }
+
+    for(;x<shape->w;x++) {
+        const Uint8 *pixel = row + x*format->BytesPerPixel;
+        switch(format->BytesPerPixel) {
+            case(1):
+                pixel_value = *(Uint8*)pixel;
+                break;
+            case(2):
+                pixel_value = *(Uint16*)pixel;
+                break;
+            case(3):
+                pixel_value = *(Uint32*)pixel & (~format->Amask);
+                break;
+            case(4):
+                pixel_value = *(Uint32*)pixel;
+                break;
+        }
+        SDL_GetRGBA(pixel_value,format,&r,&g,&b,&alpha);
+        switch(mode->mode) {
+            case(ShapeModeDefault):
+            case(ShapeModeBinarizeAlpha):
+                mask[x] = (alpha >= cutoff ? 1 : 0);
+                break;
+            case(ShapeModeReverseBinarizeAlpha):
+                mask[x] = (alpha <= cutoff ? 1 : 0);
+                break;
+            case(ShapeModeColorKey):
+                key = mode->parameters.colorKey;
+                mask[x] = ((key.r != r || key.g != g || key.b != b) ? 1 : 0);
+                break;
+        }
+    }
+}
+
 /* REQUIRES that bitmap point to a w-by-h bitmap with ppb pixels-per-byte. */
 void
 SDL_CalculateShapeBitmap(SDL_WindowShapeMode mode,SDL_Surface *shape,Uint8* bitmap,Uint8 ppb)
 {
     int x = 0;
     int y = 0;
-    Uint8 r = 0,g = 0,b = 0,alpha = 0;
-    Uint8* pixel = NULL;
-    Uint32 bitmap_pixel,pixel_value = 0,mask_value = 0;
-    SDL_Color key;
+    Uint32 bitmap_pixel;
+    Uint8 *mask = (Uint8 *)SDL_malloc(shape->w + 1);
+    if(mask == NULL) {
+        SDL_OutOfMemory();
+        return;
+    }
     if(SDL_MUSTLOCK(shape))
         SDL_LockSurface(shape);
     for(y = 0;y<shape->h;y++) {
+        SDL_CalculateShapeMaskRow(&mode,shape,y,mask);
         for(x=0;x<shape->w;x++) {
-            alpha = 0;
-            pixel_value = 0;
-            pixel = (Uint8 *)(shape->pixels) + (y*shape->pitch) + (x*shape->format->BytesPerPixel);
-            switch(shape->format->BytesPerPixel) {
-                case(1):
-                    pixel_value = *(Uint8*)pixel;
-                    break;
-                case(2):
-                    pixel_value = *(Uint16*)pixel;
-                    break;
-                case(3):
-                    pixel_value = *(Uint32*)pixel & (~shape->format->Amask);
-                    break;
-                case(4):
-                    pixel_value = *(Uint32*)pixel;
-                    break;
-            }
-            SDL_GetRGBA(pixel_value,shape->format,&r,&g,&b,&alpha);
             bitmap_pixel = y*shape->w + x;
-            switch(mode.mode) {
-                case(ShapeModeDefault):
-                    mask_value = (alpha >= 1 ? 1 : 0);
-                    break;
-                case(ShapeModeBinarizeAlpha):
-                    mask_value = (alpha >= mode.parameters.binarizationCutoff ? 1 : 0);
-                    break;
-                case(ShapeModeReverseBinarizeAlpha):
-                    mask_value = (alpha <= mode.parameters.binarizationCutoff ? 1 : 0);
-                    break;
-                case(ShapeModeColorKey):
-                    key = mode.parameters.colorKey;
-                    mask_value = ((key.r != r || key.g != g || key.b != b) ? 1 : 0);
-                    break;
-            }
-            bitmap[bitmap_pixel / ppb] |= mask_value << (7 - ((ppb - 1) - (bitmap_pixel % ppb)));
+            bitmap[bitmap_pixel / ppb] |= mask[x] << (7 - ((ppb - 1) - (bitmap_pixel % ppb)));
         }
     }
     if(SDL_MUSTLOCK(shape))
         SDL_UnlockSurface(shape);
+    SDL_free(mask);
 }
 
+/* Nodes are allocated this many at a time, and all freed together. */
+#define SDL_SHAPE_TREE_BLOCK 256
+
+/* Deep enough for the quadrants still to visit in a 2^31-pixel-wide shape. */
+#define SDL_SHAPE_TREE_STACK 128
+
+typedef struct SDL_ShapeTreeBlock {
+    struct SDL_ShapeTreeBlock *next;
+    SDL_ShapeTree nodes[SDL_SHAPE_TREE_BLOCK];
+} SDL_ShapeTreeBlock;
+
+/* What a tree's root really is: it owns the tree's nodes, and remembers the
+   mask it was built from so that SDL_UpdateShapeTree() only rebuilds the
+   quadrants where that changes. */
+typedef struct {
+    SDL_ShapeTree root;                 /* must be first */
+    SDL_ShapeTreeBlock *blocks;
+    int used;                           /* nodes handed out of blocks */
+    SDL_ShapeTree *unused;              /* released nodes, through upleft */
+    SDL_WindowShapeMode mode;
+    int w,h;
+    Uint8 *mask;                        /* w*h bytes, 1 for each opaque pixel */
+} SDL_ShapeTreePool;
+
+typedef struct {
+    SDL_ShapeTree *node;
+    SDL_Rect dimensions;
+    SDL_bool fresh;                     /* not built yet, whatever changed */
+} SDL_ShapeTreeTask;
+
 static SDL_ShapeTree*
-RecursivelyCalculateShapeTree(SDL_WindowShapeMode mode,SDL_Surface* mask,SDL_Rect dimensions) {
-    int x = 0,y = 0;
-    Uint8* pixel = NULL;
-    Uint32 pixel_value = 0;
-    Uint8 r = 0,g = 0,b = 0,a = 0;
-    SDL_bool pixel_opaque = SDL_FALSE;
-    int last_opaque = -1;
-    SDL_Color key;
-    SDL_ShapeTree* result = (SDL_ShapeTree*)SDL_malloc(sizeof(SDL_ShapeTree));
-    SDL_Rect next = {0,0,0,0};
-
-    for(y=dimensions.y;y<dimensions.y + dimensions.h;y++) {
-        for(x=dimensions.x;x<dimensions.x + dimensions.w;x++) {
-            pixel_value = 0;
-            pixel = (Uint8 *)(mask->pixels) + (y*mask->pitch) + (x*mask->format->BytesPerPixel);
-            switch(mask->format->BytesPerPixel) {
-                case(1):
-                    pixel_value = *(Uint8*)pixel;
-                    break;
-                case(2):
-                    pixel_value = *(Uint16*)pixel;
-                    break;
-                case(3):
-                    pixel_value = *(Uint32*)pixel & (~mask->format->Amask);
-                    break;
-                case(4):
-                    pixel_value = *(Uint32*)pixel;
-                    break;
-            }
-            SDL_GetRGBA(pixel_value,mask->format,&r,&g,&b,&a);
-            switch(mode.mode) {
-                case(ShapeModeDefault):
-                    pixel_opaque = (a >= 1 ? SDL_TRUE : SDL_FALSE);
-                    break;
-                case(ShapeModeBinarizeAlpha):
-                    pixel_opaque = (a >= mode.parameters.binarizationCutoff ? SDL_TRUE : SDL_FALSE);
-                    break;
-                case(ShapeModeReverseBinarizeAlpha):
-                    pixel_opaque = (a <= mode.parameters.binarizationCutoff ? SDL_TRUE : SDL_FALSE);
-                    break;
-                case(ShapeModeColorKey):
-                    key = mode.parameters.colorKey;
-                    pixel_opaque = ((key.r != r || key.g != g || key.b != b) ? SDL_TRUE : SDL_FALSE);
-                    break;
+SDL_AllocShapeTreeNode(SDL_ShapeTreePool *pool)
+{
+    SDL_ShapeTree *node = pool->unused;
+    SDL_ShapeTreeBlock *block;
+
+    if(node != NULL) {
+        pool->unused = (SDL_ShapeTree *)node->data.children.upleft;
+        return node;
+    }
+    if(pool->blocks == NULL || pool->used == SDL_SHAPE_TREE_BLOCK) {
+        block = (SDL_ShapeTreeBlock *)SDL_malloc(sizeof(SDL_ShapeTreeBlock));
+        if(block == NULL)
+            return NULL;
+        block->next = pool->blocks;
+        pool->blocks = block;
+        pool->used = 0;
+    }
+    return &pool->blocks->nodes[pool->used++];
+}
+
+/* Give every node under a quadrant back to the pool. */
+static void
+SDL_ReleaseShapeTreeChildren(SDL_ShapeTreePool *pool,SDL_ShapeTree *tree)
+{
+    SDL_ShapeTree *stack[SDL_SHAPE_TREE_STACK];
+    SDL_ShapeTree *node;
+    int top = 0;
+
+    stack[top++] = tree;
+    while(top > 0) {
+        node = stack[--top];
+        if(node->kind == QuadShape) {
+            stack[top++] = (SDL_ShapeTree *)node->data.children.upleft;
+            stack[top++] = (SDL_ShapeTree *)node->data.children.upright;
+            stack[top++] = (SDL_ShapeTree *)node->data.children.downleft;
+            stack[top++] = (SDL_ShapeTree *)node->data.children.downright;
+        }
+        if(node != tree) {
+            node->data.children.upleft = (struct SDL_ShapeTree *)pool->unused;
+            pool->unused = node;
+        }
+    }
+}
+
+/* Whether every pixel of a quadrant is opaque, or every one transparent. */
+static SDL_bool
+SDL_IsShapeMaskUniform(const SDL_ShapeTreePool *pool,const SDL_Rect *dimensions,Uint8 *value)
+{
+    const Uint8 *row = pool->mask + dimensions->y*pool->w + dimensions->x;
+    const Uint8 first = *row;
+    int x,y;
+
+    *value = first;
+    for(y=0;y<dimensions->h;y++,row += pool->w) {
+        x = 0;
+#if SDL_SHAPE_SSE2
+        {
+            const __m128i splat = _mm_set1_epi8((char)first);
+            for(;x + 16 <= dimensions->w;x += 16) {
+                if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)&row[x]),splat)) != 0xFFFF)
+                    return SDL_FALSE;
             }
-            if(last_opaque == -1)
-                last_opaque = pixel_opaque;
-            if(last_opaque != pixel_opaque) {
-                const int halfwidth = dimensions.w / 2;
-                const int halfheight = dimensions.h / 2;
-
-                result->kind = QuadShape;
-
-                next.x = dimensions.x;
-                next.y = dimensions.y;
-                next.w = halfwidth;
-                next.h = halfheight;
-                result->data.children.upleft = (struct SDL_ShapeTree *)RecursivelyCalculateShapeTree(mode,mask,next);
-
-                next.x = dimensions.x + halfwidth;
-                next.w = dimensions.w - halfwidth;
-                result->data.children.upright = (struct SDL_ShapeTree *)RecursivelyCalculateShapeTree(mode,mask,next);
-
-                next.x = dimensions.x;
-                next.w = halfwidth;
-                next.y = dimensions.y + halfheight;
-                next.h = dimensions.h - halfheight;
-                result->data.children.downleft = (struct SDL_ShapeTree *)RecursivelyCalculateShapeTree(mode,mask,next);
-
-                next.x = dimensions.x + halfwidth;
-                next.w = dimensions.w - halfwidth;
-                result->data.children.downright = (struct SDL_ShapeTree *)RecursivelyCalculateShapeTree(mode,mask,next);
-
-                return result;
+        }
+#elif SDL_SHAPE_NEON
+        {
+            const uint8x16_t splat = vdupq_n_u8(first);
+            for(;x + 16 <= dimensions->w;x += 16) {
+                if(vminvq_u8(vceqq_u8(vld1q_u8(&row[x]),splat)) == 0)
+                    return SDL_FALSE;
             }
         }
+#endif
+        for(;x<dimensions->w;x++) {
+            if(row[x] != first)
+                return SDL_FALSE;
+        }
     }
+    return SDL_TRUE;
+}
 
+/* Bring the quadtree up to date with the mask, from the root down.  Quadrants
+   that don't touch the dirty rectangle are kept as they are; the rest become
+   leaves if they're uniform now, or are split into four.  A fresh tree has
+   nothing to keep.  The quadrants are split the same way every time, so the
+   tree is the same however it was arrived at. */
+static int
+SDL_BuildShapeTree(SDL_ShapeTreePool *pool,const SDL_Rect *dirty,SDL_bool fresh)
+{
+    SDL_ShapeTreeTask stack[SDL_SHAPE_TREE_STACK];
+    SDL_ShapeTreeTask task;
+    SDL_ShapeTree *children[4];
+    SDL_Rect next[4];
+    int top = 0,i;
+    Uint8 value = 0;
 
-    /* If we never recursed, all the pixels in this quadrant have the same "value". */
-    result->kind = (last_opaque == SDL_TRUE ? OpaqueShape : TransparentShape);
-    result->data.shape = dimensions;
-    return result;
+    stack[top].node = &pool->root;
+    stack[top].dimensions.x = 0;
+    stack[top].dimensions.y = 0;
+    stack[top].dimensions.w = pool->w;
+    stack[top].dimensions.h = pool->h;
+    stack[top++].fresh = fresh;
+    while(top > 0) {
+        task = stack[--top];
+        if(!task.fresh && !SDL_HasIntersection(&task.dimensions,dirty))
+            continue;
+        if(SDL_RectEmpty(&task.dimensions) || SDL_IsShapeMaskUniform(pool,&task.dimensions,&value)) {
+            /* A quadrant with no pixels is transparent, as it always was. */
+            if(SDL_RectEmpty(&task.dimensions))
+                value = 0;
+            if(!task.fresh && task.node->kind == QuadShape)
+                SDL_ReleaseShapeTreeChildren(pool,task.node);
+            task.node->kind = (value ? OpaqueShape : TransparentShape);
+            task.node->data.shape = task.dimensions;
+            continue;
+        }
+
+        next[0].x = task.dimensions.x;
+        next[0].y = task.dimensions.y;
+        next[0].w = task.dimensions.w / 2;
+        next[0].h = task.dimensions.h / 2;
+        next[1].x = task.dimensions.x + next[0].w;
+        next[1].y = next[0].y;
+        next[1].w = task.dimensions.w - next[0].w;
+        next[1].h = next[0].h;
+        next[2].x = next[0].x;
+        next[2].y = task.dimensions.y + next[0].h;
+        next[2].w = next[0].w;
+        next[2].h = task.dimensions.h - next[0].h;
+        next[3].x = next[1].x;
+        next[3].y = next[2].y;
+        next[3].w = next[1].w;
+        next[3].h = next[2].h;
+
+        if(task.fresh || task.node->kind != QuadShape) {
+            /* It was a leaf: everything under it is new. */
+            for(i=0;i<4;i++) {
+                children[i] = SDL_AllocShapeTreeNode(pool);
+                if(children[i] == NULL) {
+                    while(i-- > 0) {
+                        children[i]->data.children.upleft = (struct SDL_ShapeTree *)pool->unused;
+                        pool->unused = children[i];
+                    }
+                    return SDL_OutOfMemory();
+                }
+                children[i]->kind = TransparentShape;
+            }
+            task.node->kind = QuadShape;
+            task.node->data.children.upleft = (struct SDL_ShapeTree *)children[0];
+            task.node->data.children.upright = (struct SDL_ShapeTree *)children[1];
+            task.node->data.children.downleft = (struct SDL_ShapeTree *)children[2];
+            task.node->data.children.downright = (struct SDL_ShapeTree *)children[3];
+            task.fresh = SDL_TRUE;
+        }
+        else {
+            children[0] = (SDL_ShapeTree *)task.node->data.children.upleft;
+            children[1] = (SDL_ShapeTree *)task.node->data.children.upright;
+            children[2] = (SDL_ShapeTree *)task.node->data.children.downleft;
+            children[3] = (SDL_ShapeTree *)task.node->data.children.downright;
+        }
+        /* Pushed in reverse, so they're visited upleft first. */
+        for(i=3;i>=0;i--) {
+            stack[top].node = children[i];
+            stack[top].dimensions = next[i];
+            stack[top++].fresh = task.fresh;
+        }
+    }
+    return 0;
+}
+
+static SDL_bool
+SDL_ShapeModesEqual(const SDL_WindowShapeMode *a,const SDL_WindowShapeMode *b)
+{
+    if(a->mode != b->mode)
+        return SDL_FALSE;
+    if(a->mode == ShapeModeColorKey)
+        return (SDL_bool)(a->parameters.colorKey.r == b->parameters.colorKey.r &&
+                          a->parameters.colorKey.g == b->parameters.colorKey.g &&
+                          a->parameters.colorKey.b == b->parameters.colorKey.b);
+    return (SDL_bool)(a->mode == ShapeModeDefault ||
+                      a->parameters.binarizationCutoff == b->parameters.binarizationCutoff);
 }
 
 SDL_ShapeTree*
-SDL_CalculateShapeTree(SDL_WindowShapeMode mode,SDL_Surface* shape)
+SDL_UpdateShapeTree(SDL_ShapeTree *tree,SDL_WindowShapeMode mode,SDL_Surface* shape)
 {
-    SDL_Rect dimensions = {0,0,shape->w,shape->h};
-    SDL_ShapeTree* result = NULL;
+    SDL_ShapeTreePool *pool = (SDL_ShapeTreePool *)tree;
+    SDL_Rect dirty = {0,0,0,0};
+    SDL_bool fresh = SDL_FALSE;
+    Uint8 *row,*mask;
+    int x0,x1,y0 = -1,y1 = -1,x,y;
+
+    if(pool != NULL && (pool->w != shape->w || pool->h != shape->h || !SDL_ShapeModesEqual(&pool->mode,&mode)))
+    {
+        SDL_FreeShapeTree(&tree);
+        pool = NULL;
+    }
+    if(pool == NULL) {
+        pool = (SDL_ShapeTreePool *)SDL_calloc(1,sizeof(SDL_ShapeTreePool));
+        if(pool == NULL) {
+            SDL_OutOfMemory();
+            return NULL;
+        }
+        pool->mode = mode;
+        pool->w = shape->w;
+        pool->h = shape->h;
+        pool->mask = (Uint8 *)SDL_malloc((size_t)shape->w*shape->h + 1);
+        if(pool->mask == NULL) {
+            SDL_free(pool);
+            SDL_OutOfMemory();
+            return NULL;
+        }
+        fresh = SDL_TRUE;
+    }
+    row = (Uint8 *)SDL_malloc(shape->w + 1);
+    if(row == NULL) {
+        tree = &pool->root;
+        SDL_FreeShapeTree(&tree);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+
+    /* Only rebuild what's inside the bounding box of the pixels that changed. */
+    x0 = shape->w;
+    x1 = -1;
     if(SDL_MUSTLOCK(shape))
         SDL_LockSurface(shape);
-    result = RecursivelyCalculateShapeTree(mode,shape,dimensions);
+    for(y=0;y<shape->h;y++) {
+        mask = pool->mask + y*shape->w;
+        SDL_CalculateShapeMaskRow(&mode,shape,y,row);
+        if(!fresh && SDL_memcmp(row,mask,shape->w) == 0)
+            continue;
+        if(y0 < 0)
+            y0 = y;
+        y1 = y;
+        for(x=0;x<x0 && row[x] == mask[x];x++);
+        if(x < x0)
+            x0 = x;
+        for(x=shape->w - 1;x>x1 && row[x] == mask[x];x--);
+        if(x > x1)
+            x1 = x;
+        SDL_memcpy(mask,row,shape->w);
+    }
     if(SDL_MUSTLOCK(shape))
         SDL_UnlockSurface(shape);
-    return result;
+    SDL_free(row);
+
+    if(fresh || y0 >= 0) {
+        if(y0 >= 0 && x1 >= x0) {
+            dirty.x = x0;
+            dirty.y = y0;
+            dirty.w = x1 - x0 + 1;
+            dirty.h = y1 - y0 + 1;
+        }
+        if(SDL_BuildShapeTree(pool,&dirty,fresh) < 0) {
+            tree = &pool->root;
+            SDL_FreeShapeTree(&tree);
+            return NULL;
+        }
+    }
+    return &pool->root;
+}
+
+SDL_ShapeTree*
+SDL_CalculateShapeTree(SDL_WindowShapeMode mode,SDL_Surface* shape)
+{
+    return SDL_UpdateShapeTree(NULL,mode,shape);
 }
 
 void
 SDL_TraverseShapeTree(SDL_ShapeTree *tree,SDL_TraversalFunction function,void* closure)
 {
+    SDL_ShapeTree *stack[SDL_SHAPE_TREE_STACK];
+    int top = 0;
+
     SDL_assert(tree != NULL);
-    if(tree->kind == QuadShape) {
-        SDL_TraverseShapeTree((SDL_ShapeTree *)tree->data.children.upleft,function,closure);
-        SDL_TraverseShapeTree((SDL_ShapeTree *)tree->data.children.upright,function,closure);
-        SDL_TraverseShapeTree((SDL_ShapeTree *)tree->data.children.downleft,function,closure);
-        SDL_TraverseShapeTree((SDL_ShapeTree *)tree->data.children.downright,function,closure);
+    stack[top++] = tree;
+    while(top > 0) {
+        tree = stack[--top];
+        if(tree->kind == QuadShape) {
+            stack[top++] = (SDL_ShapeTree *)tree->data.children.downright;
+            stack[top++] = (SDL_ShapeTree *)tree->data.children.downleft;
+            stack[top++] = (SDL_ShapeTree *)tree->data.children.upright;
+            stack[top++] = (SDL_ShapeTree *)tree->data.children.upleft;
+        }
+        else
+            function(tree,closure);
     }
-    else
-        function(tree,closure);
 }
 
 void
 SDL_FreeShapeTree(SDL_ShapeTree** shape_tree)
 {
-    if((*shape_tree)->kind == QuadShape) {
-        SDL_FreeShapeTree((SDL_ShapeTree **)&(*shape_tree)->data.children.upleft);
-        SDL_FreeShapeTree((SDL_ShapeTree **)&(*shape_tree)->data.children.upright);
-        SDL_FreeShapeTree((SDL_ShapeTree **)&(*shape_tree)->data.children.downleft);
-        SDL_FreeShapeTree((SDL_ShapeTree **)&(*shape_tree)->data.children.downright);
+    SDL_ShapeTreePool *pool = (SDL_ShapeTreePool *)*shape_tree;
+    SDL_ShapeTreeBlock *block,*next;
+
+    for(block = pool->blocks;block != NULL;block = next) {
+        next = block->next;
+        SDL_free(block);
     }
-    SDL_free(*shape_tree);
+    SDL_free(pool->mask);
+    SDL_free(pool);
     *shape_tree = NULL;
 }
 
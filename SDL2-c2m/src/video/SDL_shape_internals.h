@@ -55,6 +55,9 @@ typedef void(*SDL_TraversalFunction)(SDL_ShapeTree*,void*);
 
 extern void SDL_CalculateShapeBitmap(SDL_WindowShapeMode mode,SDL_Surface *shape,Uint8* bitmap,Uint8 ppb);
 extern SDL_ShapeTree* SDL_CalculateShapeTree(SDL_WindowShapeMode mode,SDL_Surface* shape);
+/* Rebuild only the quadrants of tree where shape changed, or build it anew if
+   tree is NULL or its size or mode differ.  Returns the tree, or NULL. */
+extern SDL_ShapeTree* SDL_UpdateShapeTree(SDL_ShapeTree *tree,SDL_WindowShapeMode mode,SDL_Surface* shape);
 extern void SDL_TraverseShapeTree(SDL_ShapeTree *tree,SDL_TraversalFunction function,void* closure);
 extern void SDL_FreeShapeTree(SDL_ShapeTree** shape_tree);
 
@@ -26,127 +26,27 @@
    April 27, 2000 - Sam Lantinga
 */
 
+#include "SDL_atomic.h"
 #include "SDL_video.h"
 #include "SDL_blit.h"
 
-/* This isn't ready for general consumption yet - it should be folded
-   into the general blitting mechanism.
-*/
-
-#if ((defined(_MFC_VER) && defined(_M_IX86)) || \
-     defined(__WATCOMC__) || \
-     (defined(__GNUC__) && defined(__i386__))) && SDL_ASSEMBLY_ROUTINES
-/* There's a bug with gcc 4.4.1 and -O2 where srcp doesn't get the correct
- * value after the first scanline.  FIXME? */
-/* #define USE_ASM_STRETCH */
-#endif
-
-#ifdef USE_ASM_STRETCH
-
-#ifdef HAVE_MPROTECT
-#include <sys/types.h>
-#include <sys/mman.h>
-#endif
-#ifdef __GNUC__
-#define PAGE_ALIGNED __attribute__((__aligned__(4096)))
-#else
-#define PAGE_ALIGNED
-#endif
-
-#if defined(_M_IX86) || defined(i386)
-#define PREFIX16    0x66
-#define STORE_BYTE  0xAA
-#define STORE_WORD  0xAB
-#define LOAD_BYTE   0xAC
-#define LOAD_WORD   0xAD
-#define RETURN      0xC3
-#else
-#error Need assembly opcodes for this architecture
-#endif
-
-static unsigned char copy_row[4096] PAGE_ALIGNED;
-
-static int
-generate_rowbytes(int src_w, int dst_w, int bpp)
-{
-    static struct
-    {
-        int bpp;
-        int src_w;
-        int dst_w;
-        int status;
-    } last;
-
-    int i;
-    int pos, inc;
-    unsigned char *eip, *fence;
-    unsigned char load, store;
-
-    /* See if we need to regenerate the copy buffer */
-    if ((src_w == last.src_w) && (dst_w == last.dst_w) && (bpp == last.bpp)) {
-        return (last.status);
-    }
-    last.bpp = bpp;
-    last.src_w = src_w;
-    last.dst_w = dst_w;
-    last.status = -1;
-
-    switch (bpp) {
-    case 1:
-        load = LOAD_BYTE;
-        store = STORE_BYTE;
-        break;
-    case 2:
-    case 4:
-        load = LOAD_WORD;
-        store = STORE_WORD;
-        break;
-    default:
-        return SDL_SetError("ASM stretch of %d bytes isn't supported\n", bpp);
-    }
-#ifdef HAVE_MPROTECT
-    /* Make the code writeable */
-    if (mprotect(copy_row, sizeof(copy_row), PROT_READ | PROT_WRITE) < 0) {
-        return SDL_SetError("Couldn't make copy buffer writeable");
-    }
-#endif
-    pos = 0x10000;
-    inc = (src_w << 16) / dst_w;
-    eip = copy_row;
-    fence = copy_row + sizeof(copy_row)-2;
-    for (i = 0; i < dst_w; ++i) {
-        while (pos >= 0x10000L) {
-            if (eip == fence) {
-                return -1;
-            }
-            if (bpp == 2) {
-                *eip++ = PREFIX16;
-            }
-            *eip++ = load;
-            pos -= 0x10000L;
-        }
-        if (eip == fence) {
-            return -1;
-        }
-        if (bpp == 2) {
-            *eip++ = PREFIX16;
-        }
-        *eip++ = store;
-        pos += inc;
-    }
-    *eip++ = RETURN;
+/* Nearest pixel stretching copies rows, stepping through the source pixels
+   in 16.16 fixed point.
 
-#ifdef HAVE_MPROTECT
-    /* Make the code executable but not writeable */
-    if (mprotect(copy_row, sizeof(copy_row), PROT_READ | PROT_EXEC) < 0) {
-        return SDL_SetError("Couldn't make copy buffer executable");
-    }
+   Filtered stretching (bilinear or area, 32-bit pixels of 8-bit channels)
+   is separable: on each axis an output pixel is a weighted sum of source
+   ones, the weights in tables made once per stretch for each axis' sizes,
+   with 14 fraction bits and adding up to exactly 1.  Source rows are
+   filtered across into 16-bit values with 7 fraction bits, kept for the
+   next output rows, then down into the output a pair of them at a time.
+   The SSE2 functions do the same integer arithmetic as the C ones, so both
+   give the same pixels.  Both kinds are done in bands of output rows on
+   the blit threads. */
+#if defined(__GNUC__) && !defined(__clang_analyzer__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SDL_STRETCH_X86 1
+#include <immintrin.h>
 #endif
-    last.status = 0;
-    return (0);
-}
-
-#endif /* USE_ASM_STRETCH */
 
 #define DEFINE_COPY_ROW(name, type)         \
 static void name(type *src, int src_w, type *dst, int dst_w)    \
@@ -172,7 +72,6 @@ DEFINE_COPY_ROW(copy_row2, Uint16)
 DEFINE_COPY_ROW(copy_row4, Uint32)
 /* *INDENT-ON* */
 
-/* The ASM code doesn't handle 24-bpp stretch blits */
 static void
 copy_row3(Uint8 * src, int src_w, Uint8 * dst, int dst_w)
 {
@@ -196,28 +95,387 @@ copy_row3(Uint8 * src, int src_w, Uint8 * dst, int dst_w)
     }
 }
 
-/* Perform a stretch blit between two surfaces of the same format.
-   NOTE:  This function is not safe to call from multiple threads!
-*/
+typedef struct
+{
+    const Uint8 *src;           /* the source rectangle's first row */
+    int src_pitch;
+    int src_w;
+    Uint8 *dst;                 /* likewise the destination's */
+    int dst_pitch;
+    int dst_w;
+    int inc;
+    int bpp;
+} SDL_SoftStretchBands;
+
+/* Destination rows y to y + h - 1 of a stretch, each from the source row
+   the stepping from the first would have got to */
+static void
+SDL_SoftStretchBand(void *data, int y, int h)
+{
+    const SDL_SoftStretchBands *stretch = (const SDL_SoftStretchBands *) data;
+    int dst_row;
+
+    for (dst_row = y; dst_row < y + h; ++dst_row) {
+        Uint8 *srcp = (Uint8 *) stretch->src + stretch->src_pitch *
+            (int) (((Sint64) dst_row * stretch->inc) >> 16);
+        Uint8 *dstp = stretch->dst + dst_row * stretch->dst_pitch;
+
+        switch (stretch->bpp) {
+        case 1:
+            copy_row1(srcp, stretch->src_w, dstp, stretch->dst_w);
+            break;
+        case 2:
+            copy_row2((Uint16 *) srcp, stretch->src_w,
+                      (Uint16 *) dstp, stretch->dst_w);
+            break;
+        case 3:
+            copy_row3(srcp, stretch->src_w, dstp, stretch->dst_w);
+            break;
+        case 4:
+            copy_row4((Uint32 *) srcp, stretch->src_w,
+                      (Uint32 *) dstp, stretch->dst_w);
+            break;
+        }
+    }
+}
+
+#define SDL_STRETCH_ONE (1 << 14)  /* a weight of 1 */
+#define SDL_STRETCH_ROWS 4          /* across-filtered rows kept */
+
+typedef struct
+{
+    int taps;                   /* source pixels per output one, even */
+    int *index;                 /* taps of each output pixel, in range */
+    Sint16 *weight;             /* likewise */
+} SDL_StretchTable;
+
+typedef struct
+{
+    const Uint8 *src;           /* the source rectangle's first row */
+    int src_pitch;
+    Uint8 *dst;                 /* likewise the destination's */
+    int dst_pitch;
+    int dst_w;
+    SDL_StretchTable x;
+    SDL_StretchTable y;
+    SDL_bool sse2;
+    SDL_atomic_t failed;        /* a band couldn't get its rows */
+} SDL_FilteredStretch;
+
+static void
+SDL_FreeStretchTable(SDL_StretchTable * table)
+{
+    SDL_free(table->index);
+    SDL_free(table->weight);
+    table->index = NULL;
+    table->weight = NULL;
+}
+
+/* The weights of the src_n source pixels in each of dst_n output ones */
+static int
+SDL_MakeStretchTable(SDL_StretchTable * table, int src_n, int dst_n,
+                     SDL_StretchFilter filter)
+{
+    int i, k;
+
+    if (filter == SDL_STRETCH_LINEAR) {
+        table->taps = 2;
+    } else {
+        /* The source pixels an output one covers & one it straddles */
+        table->taps = (src_n + dst_n - 1) / dst_n + 1;
+        table->taps += table->taps & 1;
+    }
+    table->index = (int *) SDL_malloc(dst_n * table->taps * sizeof(int));
+    table->weight = (Sint16 *) SDL_malloc(dst_n * table->taps * sizeof(Sint16));
+    if (!table->index || !table->weight) {
+        SDL_FreeStretchTable(table);
+        return SDL_OutOfMemory();
+    }
+
+    for (i = 0; i < dst_n; ++i) {
+        int *index = &table->index[i * table->taps];
+        Sint16 *weight = &table->weight[i * table->taps];
+
+        if (filter == SDL_STRETCH_LINEAR) {
+            /* Where the output pixel's centre is between source ones' */
+            Sint64 pos = (Sint64) (2 * i + 1) * src_n * SDL_STRETCH_ONE /
+                (2 * dst_n) - SDL_STRETCH_ONE / 2;
+
+            pos = SDL_max(pos, 0);
+            pos = SDL_min(pos, (Sint64) (src_n - 1) * SDL_STRETCH_ONE);
+            index[0] = (int) (pos / SDL_STRETCH_ONE);
+            index[1] = SDL_min(index[0] + 1, src_n - 1);
+            weight[1] = (Sint16) (pos % SDL_STRETCH_ONE);
+            weight[0] = (Sint16) (SDL_STRETCH_ONE - weight[1]);
+        } else {
+            /* In 1 / dst_n source pixels, the output one covers i * src_n
+               up to (i + 1) * src_n & source one j, j * dst_n up to
+               (j + 1) * dst_n.  The weights are the overlaps' shares,
+               rounded so that each one's running total is. */
+            const Sint64 start = (Sint64) i * src_n;
+            const Sint64 end = start + src_n;
+            const int first = (int) (start / dst_n);
+            Sint64 covered = 0;
+            int total = 0;
+
+            for (k = 0; k < table->taps; ++k) {
+                const Sint64 from = SDL_max(start, (Sint64) (first + k) * dst_n);
+                const Sint64 to = SDL_min(end, (Sint64) (first + k + 1) * dst_n);
+                int next;
+
+                if (to > from) {
+                    covered += to - from;
+                }
+                next = (int) ((covered * SDL_STRETCH_ONE + src_n / 2) / src_n);
+                index[k] = SDL_min(first + k, src_n - 1);
+                weight[k] = (Sint16) (next - total);
+                total = next;
+            }
+        }
+    }
+    return 0;
+}
+
+/* A source row filtered across: 4 values for each output pixel, 255 * 128
+   at most */
+static void
+SDL_StretchAcross(const Uint8 * src, Sint16 * dst,
+                  const SDL_StretchTable * x, int dst_w)
+{
+    int i, k, c;
+
+    for (i = 0; i < dst_w; ++i) {
+        const int *index = &x->index[i * x->taps];
+        const Sint16 *weight = &x->weight[i * x->taps];
+
+        for (c = 0; c < 4; ++c) {
+            Sint32 sum = 64;
+
+            for (k = 0; k < x->taps; ++k) {
+                sum += src[index[k] * 4 + c] * weight[k];
+            }
+            *dst++ = (Sint16) (sum >> 7);
+        }
+    }
+}
+
+/* Rows filtered across & weighted down, lane by lane; into the sums of the
+   pairs before (when it isn't the first pair), or the output pixels (when
+   it's the last) */
+static void
+SDL_StretchDown(const Sint16 * a, const Sint16 * b, Sint16 wa, Sint16 wb,
+                Sint32 * sum, Uint8 * dst, int lanes, SDL_bool first,
+                SDL_bool last)
+{
+    int i;
+
+    for (i = 0; i < lanes; ++i) {
+        Sint32 value = a[i] * wa + b[i] * wb;
+
+        if (!first) {
+            value += sum[i];
+        }
+        if (last) {
+            dst[i] = (Uint8) ((value + (1 << 20)) >> 21);
+        } else {
+            sum[i] = value;
+        }
+    }
+}
+
+#if SDL_STRETCH_X86
+/* Each output pixel's taps in pairs, their channels interleaved as 16-bit
+   lanes for pmaddwd */
+__attribute__((target("sse2"))) static void
+SDL_StretchAcrossSSE2(const Uint8 * src, Sint16 * dst,
+                      const SDL_StretchTable * x, int dst_w)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(64);
+    int i, k;
+
+    for (i = 0; i < dst_w; ++i, dst += 4) {
+        const int *index = &x->index[i * x->taps];
+        const Sint16 *weight = &x->weight[i * x->taps];
+        __m128i sum = round;
+
+        for (k = 0; k < x->taps; k += 2) {
+            __m128i a = _mm_cvtsi32_si128(*(const int *) (src + index[k] * 4));
+            __m128i b = _mm_cvtsi32_si128(*(const int *) (src + index[k + 1] * 4));
+            __m128i w = _mm_set1_epi32((int) ((Uint16) weight[k] |
+                                              ((Uint32) weight[k + 1] << 16)));
+
+            a = _mm_unpacklo_epi8(_mm_unpacklo_epi8(a, b), zero);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(a, w));
+        }
+        sum = _mm_srai_epi32(sum, 7);
+        _mm_storel_epi64((__m128i *) dst, _mm_packs_epi32(sum, sum));
+    }
+}
+
+/* 8 lanes (2 pixels) at a time, the two rows interleaved for pmaddwd */
+__attribute__((target("sse2"))) static void
+SDL_StretchDownSSE2(const Sint16 * a, const Sint16 * b, Sint16 wa, Sint16 wb,
+                    Sint32 * sum, Uint8 * dst, int lanes, SDL_bool first,
+                    SDL_bool last)
+{
+    const __m128i w = _mm_set1_epi32((int) ((Uint16) wa | ((Uint32) wb << 16)));
+    const __m128i round = _mm_set1_epi32(1 << 20);
+    int i;
+
+    for (i = 0; i + 8 <= lanes; i += 8) {
+        __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(va, vb), w);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(va, vb), w);
+
+        if (!first) {
+            lo = _mm_add_epi32(lo, _mm_loadu_si128((const __m128i *) (sum + i)));
+            hi = _mm_add_epi32(hi, _mm_loadu_si128((const __m128i *) (sum + i + 4)));
+        }
+        if (last) {
+            lo = _mm_srai_epi32(_mm_add_epi32(lo, round), 21);
+            hi = _mm_srai_epi32(_mm_add_epi32(hi, round), 21);
+            lo = _mm_packs_epi32(lo, hi);
+            _mm_storel_epi64((__m128i *) (dst + i), _mm_packus_epi16(lo, lo));
+        } else {
+            _mm_storeu_si128((__m128i *) (sum + i), lo);
+            _mm_storeu_si128((__m128i *) (sum + i + 4), hi);
+        }
+    }
+    SDL_StretchDown(a + i, b + i, wa, wb, sum + i, dst + i, lanes - i,
+                    first, last);
+}
+#endif /* SDL_STRETCH_X86 */
+
+/* Source row src_row filtered across, from the rows kept if it's there */
+static const Sint16 *
+SDL_GetStretchRow(const SDL_FilteredStretch * stretch, Sint16 * rows,
+                  int *kept, int src_row)
+{
+    const int slot = src_row % SDL_STRETCH_ROWS;
+    Sint16 *row = rows + slot * stretch->dst_w * 4;
+
+    if (kept[slot] != src_row) {
+        const Uint8 *src = stretch->src + src_row * stretch->src_pitch;
+
+#if SDL_STRETCH_X86
+        if (stretch->sse2) {
+            SDL_StretchAcrossSSE2(src, row, &stretch->x, stretch->dst_w);
+        } else
+#endif
+            SDL_StretchAcross(src, row, &stretch->x, stretch->dst_w);
+        kept[slot] = src_row;
+    }
+    return row;
+}
+
+/* Output rows y to y + h - 1 of a filtered stretch.  A pair of taps is two
+   rows next to each other (or the same one), which are never in the same
+   slot */
+static void
+SDL_FilteredStretchBand(void *data, int y, int h)
+{
+    SDL_FilteredStretch *stretch = (SDL_FilteredStretch *) data;
+    const int lanes = stretch->dst_w * 4;
+    const int taps = stretch->y.taps;
+    int kept[SDL_STRETCH_ROWS];
+    Sint16 *rows;
+    Sint32 *sum;
+    int i, k;
+
+    rows = (Sint16 *) SDL_malloc(lanes * (SDL_STRETCH_ROWS * sizeof(Sint16) +
+                                          sizeof(Sint32)));
+    if (!rows) {
+        SDL_AtomicSet(&stretch->failed, 1);
+        return;
+    }
+    sum = (Sint32 *) (rows + SDL_STRETCH_ROWS * lanes);
+    for (k = 0; k < SDL_STRETCH_ROWS; ++k) {
+        kept[k] = -1;
+    }
+
+    for (i = y; i < y + h; ++i) {
+        const int *index = &stretch->y.index[i * taps];
+        const Sint16 *weight = &stretch->y.weight[i * taps];
+        Uint8 *dst = stretch->dst + i * stretch->dst_pitch;
+
+        for (k = 0; k < taps; k += 2) {
+            const Sint16 *a = SDL_GetStretchRow(stretch, rows, kept, index[k]);
+            const Sint16 *b = SDL_GetStretchRow(stretch, rows, kept, index[k + 1]);
+            const SDL_bool first = (k == 0) ? SDL_TRUE : SDL_FALSE;
+            const SDL_bool last = (k + 2 == taps) ? SDL_TRUE : SDL_FALSE;
+
+#if SDL_STRETCH_X86
+            if (stretch->sse2) {
+                SDL_StretchDownSSE2(a, b, weight[k], weight[k + 1], sum, dst,
+                                    lanes, first, last);
+                continue;
+            }
+#endif
+            SDL_StretchDown(a, b, weight[k], weight[k + 1], sum, dst, lanes,
+                            first, last);
+        }
+    }
+    SDL_free(rows);
+}
+
+static int
+SDL_SoftStretchFilteredRows(SDL_Surface * src, const SDL_Rect * srcrect,
+                            SDL_Surface * dst, const SDL_Rect * dstrect,
+                            SDL_StretchFilter filter)
+{
+    SDL_FilteredStretch stretch;
+    int status = 0;
+
+    stretch.src = (Uint8 *) src->pixels + (srcrect->y * src->pitch)
+        + (srcrect->x * 4);
+    stretch.src_pitch = src->pitch;
+    stretch.dst = (Uint8 *) dst->pixels + (dstrect->y * dst->pitch)
+        + (dstrect->x * 4);
+    stretch.dst_pitch = dst->pitch;
+    stretch.dst_w = dstrect->w;
+    if (SDL_MakeStretchTable(&stretch.x, srcrect->w, dstrect->w, filter) < 0) {
+        return -1;
+    }
+    if (SDL_MakeStretchTable(&stretch.y, srcrect->h, dstrect->h, filter) < 0) {
+        SDL_FreeStretchTable(&stretch.x);
+        return -1;
+    }
+#if SDL_STRETCH_X86
+    stretch.sse2 = (SDL_GetBlitCPUFeatures() & SDL_CPU_SSE2) ? SDL_TRUE : SDL_FALSE;
+#else
+    stretch.sse2 = SDL_FALSE;
+#endif
+    SDL_AtomicSet(&stretch.failed, 0);
+
+    /* In place, rows could be written before they're read */
+    if (src->pixels == dst->pixels) {
+        SDL_FilteredStretchBand(&stretch, 0, dstrect->h);
+    } else {
+        SDL_RunBlitBands(dstrect->w, dstrect->h, SDL_FilteredStretchBand,
+                         &stretch);
+    }
+    if (SDL_AtomicGet(&stretch.failed)) {
+        status = SDL_OutOfMemory();
+    }
+
+    SDL_FreeStretchTable(&stretch.x);
+    SDL_FreeStretchTable(&stretch.y);
+    return status;
+}
+
+/* Perform a stretch blit between two surfaces of the same format */
 int
-SDL_SoftStretch(SDL_Surface * src, const SDL_Rect * srcrect,
-                SDL_Surface * dst, const SDL_Rect * dstrect)
+SDL_SoftStretchFiltered(SDL_Surface * src, const SDL_Rect * srcrect,
+                        SDL_Surface * dst, const SDL_Rect * dstrect,
+                        SDL_StretchFilter filter)
 {
     int src_locked;
     int dst_locked;
-    int pos, inc;
-    int dst_maxrow;
-    int src_row, dst_row;
-    Uint8 *srcp = NULL;
-    Uint8 *dstp;
+    int status = 0;
     SDL_Rect full_src;
     SDL_Rect full_dst;
-#ifdef USE_ASM_STRETCH
-    SDL_bool use_asm = SDL_TRUE;
-#ifdef __GNUC__
-    int u1, u2;
-#endif
-#endif /* USE_ASM_STRETCH */
     const int bpp = dst->format->BytesPerPixel;
 
     if (src->format->format != dst->format->format) {
@@ -251,6 +509,10 @@ SDL_SoftStretch(SDL_Surface * src, const SDL_Rect * srcrect,
         full_dst.h = dst->h;
         dstrect = &full_dst;
     }
+    if (SDL_RectEmpty(srcrect) || SDL_RectEmpty(dstrect)) {
+        return 0;
+    }
+    SDL_AddSurfaceDamage(dst, dstrect);
 
     /* Lock the destination if it's in hardware */
     dst_locked = 0;
@@ -272,72 +534,31 @@ SDL_SoftStretch(SDL_Surface * src, const SDL_Rect * srcrect,
         src_locked = 1;
     }
 
-    /* Set up the data... */
-    pos = 0x10000;
-    inc = (srcrect->h << 16) / dstrect->h;
-    src_row = srcrect->y;
-    dst_row = dstrect->y;
-
-#ifdef USE_ASM_STRETCH
-    /* Write the opcodes for this stretch */
-    if ((bpp == 3) || (generate_rowbytes(srcrect->w, dstrect->w, bpp) < 0)) {
-        use_asm = SDL_FALSE;
-    }
-#endif
+    /* Perform the stretch blit, filtered where the channels are bytes */
+    if (filter != SDL_STRETCH_NEAREST && bpp == 4 &&
+        SDL_PIXELLAYOUT(dst->format->format) == SDL_PACKEDLAYOUT_8888) {
+        status = SDL_SoftStretchFilteredRows(src, srcrect, dst, dstrect,
+                                             filter);
+    } else {
+        SDL_SoftStretchBands stretch;
 
-    /* Perform the stretch blit */
-    for (dst_maxrow = dst_row + dstrect->h; dst_row < dst_maxrow; ++dst_row) {
-        dstp = (Uint8 *) dst->pixels + (dst_row * dst->pitch)
+        stretch.src = (Uint8 *) src->pixels + (srcrect->y * src->pitch)
+            + (srcrect->x * bpp);
+        stretch.src_pitch = src->pitch;
+        stretch.src_w = srcrect->w;
+        stretch.dst = (Uint8 *) dst->pixels + (dstrect->y * dst->pitch)
             + (dstrect->x * bpp);
-        while (pos >= 0x10000L) {
-            srcp = (Uint8 *) src->pixels + (src_row * src->pitch)
-                + (srcrect->x * bpp);
-            ++src_row;
-            pos -= 0x10000L;
+        stretch.dst_pitch = dst->pitch;
+        stretch.dst_w = dstrect->w;
+        stretch.inc = (srcrect->h << 16) / dstrect->h;
+        stretch.bpp = bpp;
+        /* In place, rows could be written before they're read */
+        if (src->pixels == dst->pixels) {
+            SDL_SoftStretchBand(&stretch, 0, dstrect->h);
+        } else {
+            SDL_RunBlitBands(dstrect->w, dstrect->h, SDL_SoftStretchBand,
+                             &stretch);
         }
-#ifdef USE_ASM_STRETCH
-        if (use_asm) {
-#ifdef __GNUC__
-            __asm__ __volatile__("call *%4":"=&D"(u1), "=&S"(u2)
-                                 :"0"(dstp), "1"(srcp), "r"(copy_row)
-                                 :"memory");
-#elif defined(_MSC_VER) || defined(__WATCOMC__)
-            /* *INDENT-OFF* */
-            {
-                void *code = copy_row;
-                __asm {
-                    push edi
-                    push esi
-                    mov edi, dstp
-                    mov esi, srcp
-                    call dword ptr code
-                    pop esi
-                    pop edi
-                }
-            }
-            /* *INDENT-ON* */
-#else
-#error Need inline assembly for this compiler
-#endif
-        } else
-#endif
-            switch (bpp) {
-            case 1:
-                copy_row1(srcp, srcrect->w, dstp, dstrect->w);
-                break;
-            case 2:
-                copy_row2((Uint16 *) srcp, srcrect->w,
-                          (Uint16 *) dstp, dstrect->w);
-                break;
-            case 3:
-                copy_row3(srcp, srcrect->w, dstp, dstrect->w);
-                break;
-            case 4:
-                copy_row4((Uint32 *) srcp, srcrect->w,
-                          (Uint32 *) dstp, dstrect->w);
-                break;
-            }
-        pos += inc;
     }
 
     /* We need to unlock the surfaces if they're locked */
@@ -347,7 +568,15 @@ SDL_SoftStretch(SDL_Surface * src, const SDL_Rect * srcrect,
     if (src_locked) {
         SDL_UnlockSurface(src);
     }
-    return (0);
+    return status;
+}
+
+int
+SDL_SoftStretch(SDL_Surface * src, const SDL_Rect * srcrect,
+                SDL_Surface * dst, const SDL_Rect * dstrect)
+{
+    return SDL_SoftStretchFiltered(src, srcrect, dst, dstrect,
+                                   SDL_STRETCH_NEAREST);
 }
 
 /* vi: set ts=4 sw=4 expandtab: */
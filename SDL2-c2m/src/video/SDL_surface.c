@@ -25,6 +25,28 @@
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_atomic.h"
+
+/* The surface pool: SDL_ReleaseSurface keeps surfaces for SDL_AcquireSurface
+   to hand out again, newest last, up to a count and a total size */
+#define SDL_SURFACE_POOL_SIZE   16
+#define SDL_SURFACE_POOL_BYTES  (64 * 1024 * 1024)
+#define SDL_SURFACE_ALIGN       64      /* of pooled pixels, a cache line */
+
+/* Just before the pixels of an SDL_SIMD_ALIGNED surface */
+typedef struct
+{
+    void *block;        /* as allocated */
+    size_t size;        /* bytes of pixels there's room for */
+} SDL_AlignedHeader;
+
+static struct
+{
+    SDL_SpinLock lock;
+    SDL_Surface *surfaces[SDL_SURFACE_POOL_SIZE];
+    int count;
+    size_t bytes;
+} SDL_surface_pool;
 
 /* Public routines */
 /*
@@ -114,6 +136,38 @@ SDL_CreateRGBSurface(Uint32 flags,
     return surface;
 }
 
+static void *
+SDL_AllocAligned(size_t size)
+{
+    Uint8 *block = (Uint8 *) SDL_malloc(size + sizeof(SDL_AlignedHeader) +
+                                        SDL_SURFACE_ALIGN - 1);
+    uintptr_t pixels;
+
+    if (!block) {
+        return NULL;
+    }
+    pixels = ((uintptr_t) block + sizeof(SDL_AlignedHeader) +
+              SDL_SURFACE_ALIGN - 1) & ~(uintptr_t) (SDL_SURFACE_ALIGN - 1);
+    ((SDL_AlignedHeader *) pixels)[-1].block = block;
+    ((SDL_AlignedHeader *) pixels)[-1].size = size;
+    return (void *) pixels;
+}
+
+static void
+SDL_FreeAligned(void *pixels)
+{
+    if (pixels) {
+        SDL_free(((SDL_AlignedHeader *) pixels)[-1].block);
+    }
+}
+
+static size_t
+SDL_AlignedSize(SDL_Surface * surface)
+{
+    return surface->pixels ?
+        ((SDL_AlignedHeader *) surface->pixels)[-1].size : 0;
+}
+
 /*
  * Create an RGB surface from an existing memory buffer
  */
@@ -138,6 +192,145 @@ SDL_CreateRGBSurfaceFrom(void *pixels,
     return surface;
 }
 
+SDL_Surface *
+SDL_AcquireSurface(int width, int height, Uint32 format)
+{
+    SDL_Surface *surface = NULL;
+    Uint32 Rmask, Gmask, Bmask, Amask;
+    size_t size;
+    int bpp, i;
+
+    if (width < 0 || height < 0) {
+        SDL_InvalidParamError(width < 0 ? "width" : "height");
+        return NULL;
+    }
+    if (!SDL_PixelFormatEnumToMasks(format, &bpp, &Rmask, &Gmask, &Bmask,
+                                    &Amask)) {
+        return NULL;
+    }
+    if (SDL_ISPIXELFORMAT_INDEXED(format)) {
+        return SDL_CreateRGBSurface(0, width, height, bpp, Rmask, Gmask,
+                                    Bmask, Amask);
+    }
+
+    /* The newest with room for these rows, and not much more (so a few
+       sizes in use each keep their own) */
+    SDL_AtomicLock(&SDL_surface_pool.lock);
+    for (i = SDL_surface_pool.count; i--; ) {
+        SDL_Surface *pooled = SDL_surface_pool.surfaces[i];
+        size_t need = (size_t) pooled->pitch * height;
+
+        size = SDL_AlignedSize(pooled);
+        if (pooled->format->format == format && pooled->w == width &&
+            size >= need && size - need <= size / 4) {
+            surface = pooled;
+            SDL_memmove(&SDL_surface_pool.surfaces[i],
+                        &SDL_surface_pool.surfaces[i + 1],
+                        (SDL_surface_pool.count - i - 1) *
+                        sizeof(SDL_Surface *));
+            SDL_surface_pool.count--;
+            SDL_surface_pool.bytes -= size;
+            break;
+        }
+    }
+    SDL_AtomicUnlock(&SDL_surface_pool.lock);
+    if (surface) {
+        surface->h = height;
+        SDL_SetClipRect(surface, NULL);
+        return surface;
+    }
+
+    surface = SDL_CreateRGBSurface(0, 0, 0, bpp, Rmask, Gmask, Bmask, Amask);
+    if (surface == NULL) {
+        return NULL;
+    }
+    surface->w = width;
+    surface->h = height;
+    surface->pitch = SDL_CalculatePitch(surface);
+    if (width && height) {
+        surface->pixels = SDL_AllocAligned((size_t) surface->pitch * height);
+        if (!surface->pixels) {
+            SDL_FreeSurface(surface);
+            SDL_OutOfMemory();
+            return NULL;
+        }
+        surface->flags |= SDL_SIMD_ALIGNED;
+    }
+    SDL_SetClipRect(surface, NULL);
+    return surface;
+}
+
+void
+SDL_ReleaseSurface(SDL_Surface * surface)
+{
+    SDL_Surface *evicted[SDL_SURFACE_POOL_SIZE];
+    size_t size;
+    int i, n = 0;
+
+    if (surface == NULL) {
+        return;
+    }
+    if (!(surface->flags & SDL_SIMD_ALIGNED) || surface->refcount != 1 ||
+        surface->locked || (surface->flags & (SDL_PREALLOC | SDL_DONTFREE)) ||
+        SDL_AlignedSize(surface) > SDL_SURFACE_POOL_BYTES / 4) {
+        SDL_FreeSurface(surface);
+        return;
+    }
+    size = SDL_AlignedSize(surface);
+
+    /* Back as SDL_AcquireSurface made it */
+    if (surface->flags & SDL_RLEACCEL) {
+        SDL_UnRLESurface(surface, 0);
+    }
+    SDL_SetSurfaceRLE(surface, 0);
+    SDL_SetColorKey(surface, SDL_FALSE, 0);
+    SDL_SetSurfaceColorMod(surface, 0xFF, 0xFF, 0xFF);
+    SDL_SetSurfaceAlphaMod(surface, 0xFF);
+    SDL_SetSurfaceBlendMode(surface, surface->format->Amask ?
+                            SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+    SDL_InvalidateMap(surface->map);
+    surface->userdata = NULL;
+
+    SDL_AtomicLock(&SDL_surface_pool.lock);
+    while (SDL_surface_pool.count == SDL_SURFACE_POOL_SIZE ||
+           SDL_surface_pool.bytes + size > SDL_SURFACE_POOL_BYTES) {
+        SDL_Surface *oldest = SDL_surface_pool.surfaces[0];
+
+        SDL_surface_pool.bytes -= SDL_AlignedSize(oldest);
+        SDL_surface_pool.count--;
+        SDL_memmove(&SDL_surface_pool.surfaces[0],
+                    &SDL_surface_pool.surfaces[1],
+                    SDL_surface_pool.count * sizeof(SDL_Surface *));
+        evicted[n++] = oldest;
+    }
+    SDL_surface_pool.surfaces[SDL_surface_pool.count++] = surface;
+    SDL_surface_pool.bytes += size;
+    SDL_AtomicUnlock(&SDL_surface_pool.lock);
+
+    /* Freed outside the lock */
+    for (i = 0; i < n; ++i) {
+        SDL_FreeSurface(evicted[i]);
+    }
+}
+
+void
+SDL_FlushSurfacePool(void)
+{
+    SDL_Surface *surfaces[SDL_SURFACE_POOL_SIZE];
+    int i, n;
+
+    SDL_AtomicLock(&SDL_surface_pool.lock);
+    n = SDL_surface_pool.count;
+    SDL_memcpy(surfaces, SDL_surface_pool.surfaces, n * sizeof(SDL_Surface *));
+    SDL_surface_pool.count = 0;
+    SDL_surface_pool.bytes = 0;
+    SDL_AtomicUnlock(&SDL_surface_pool.lock);
+
+    for (i = 0; i < n; ++i) {
+        SDL_FreeSurface(surfaces[i]);
+    }
+}
+
 int
 SDL_SetSurfacePalette(SDL_Surface * surface, SDL_Palette * palette)
 {
@@ -515,6 +708,12 @@ SDL_LowerBlit(SDL_Surface * src, SDL_Rect * srcrect,
 /*              src, dst->flags, src->map->info.flags, dst, dst->flags, */
 /*              dst->map->info.flags, src->map->blit); */
     }
+    /* See if we can do RLE acceleration now */
+    if (src->map->rle_wait > 0 && !src->locked &&
+        --src->map->rle_wait == 0) {
+        SDL_RLESurface(src);
+    }
+    SDL_AddSurfaceDamage(dst, dstrect);
     return (src->map->blit(src, srcrect, dst, dstrect));
 }
 
@@ -807,12 +1006,18 @@ SDL_LockSurface(SDL_Surface * surface)
         if (surface->flags & SDL_RLEACCEL) {
             SDL_UnRLESurface(surface, 1);
             surface->flags |= SDL_RLEACCEL;     /* save accel'd state */
+        } else if (surface->map->rle_wait > 0) {
+            /* Still changing, wait a while longer to encode it */
+            surface->map->rle_wait = SDL_RLE_ENCODE_BLITS;
         }
     }
 
     /* Increment the surface lock count, for recursive locks */
     ++surface->locked;
 
+    /* Anything could be written now */
+    SDL_AddSurfaceDamage(surface, NULL);
+
     /* Ready to go.. */
     return (0);
 }
@@ -828,10 +1033,12 @@ SDL_UnlockSurface(SDL_Surface * surface)
         return;
     }
 
-    /* Update RLE encoded surface with new data */
+    /* Blit the new data as it is until it's worth encoding again */
     if ((surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL) {
         surface->flags &= ~SDL_RLEACCEL;        /* stop lying */
-        SDL_RLESurface(surface);
+        if (surface->map->dst) {
+            SDL_CalculateBlit(surface);
+        }
     }
 }
 
@@ -1139,7 +1346,9 @@ SDL_FreeSurface(SDL_Surface * surface)
         SDL_FreeBlitMap(surface->map);
         surface->map = NULL;
     }
-    if (!(surface->flags & SDL_PREALLOC)) {
+    if (surface->flags & SDL_SIMD_ALIGNED) {
+        SDL_FreeAligned(surface->pixels);
+    } else if (!(surface->flags & SDL_PREALLOC)) {
         SDL_free(surface->pixels);
     }
     SDL_free(surface);
@@ -67,6 +67,9 @@ typedef struct SDL_WindowUserData
     struct SDL_WindowUserData *next;
 } SDL_WindowUserData;
 
+/* Most rectangles a window surface's changes are kept as; more are merged */
+#define SDL_WINDOW_MAX_DAMAGE 16
+
 /* Define the SDL window structure, corresponding to toplevel windows */
 struct SDL_Window
 {
@@ -93,6 +96,11 @@ struct SDL_Window
     SDL_Surface *surface;
     SDL_bool surface_valid;
 
+    /* What's changed on the surface since it was last updated, when it has
+       SDL_TRACKDAMAGE */
+    SDL_Rect damage[SDL_WINDOW_MAX_DAMAGE];
+    int num_damage;
+
     SDL_bool is_hiding;
     SDL_bool is_destroying;
 
@@ -391,6 +399,7 @@ extern VideoBootStrap RPI_bootstrap;
 #endif
 #if SDL_VIDEO_DRIVER_DUMMY
 extern VideoBootStrap DUMMY_bootstrap;
+extern VideoBootStrap BENCH_bootstrap;
 #endif
 #if SDL_VIDEO_DRIVER_WAYLAND
 extern VideoBootStrap Wayland_bootstrap;
@@ -417,6 +426,7 @@ extern int SDL_RecreateWindow(SDL_Window * window, Uint32 flags);
 extern void SDL_OnWindowShown(SDL_Window * window);
 extern void SDL_OnWindowHidden(SDL_Window * window);
 extern void SDL_OnWindowResized(SDL_Window * window);
+extern void SDL_OnWindowExposed(SDL_Window * window);
 extern void SDL_OnWindowMinimized(SDL_Window * window);
 extern void SDL_OnWindowRestored(SDL_Window * window);
 extern void SDL_OnWindowEnter(SDL_Window * window);
@@ -107,6 +107,7 @@ static VideoBootStrap *bootstrap[] = {
 #endif
 #if SDL_VIDEO_DRIVER_DUMMY
     &DUMMY_bootstrap,
+    &BENCH_bootstrap,
 #endif
     NULL
 };
@@ -2088,11 +2089,115 @@ SDL_GetWindowSurface(SDL_Window * window)
         if (window->surface) {
             window->surface_valid = SDL_TRUE;
             window->surface->flags |= SDL_DONTFREE;
+            SDL_TrackWindowSurfaceDamage(window, SDL_FALSE);
         }
     }
     return window->surface;
 }
 
+/* Start recording what's drawn on the window's surface, if the hint (or
+   the caller, when it's not set) says to; the whole of it needs updating
+   to begin with */
+void
+SDL_TrackWindowSurfaceDamage(SDL_Window * window, SDL_bool default_value)
+{
+    const char *hint = SDL_GetHint(SDL_HINT_WINDOW_SURFACE_DAMAGE);
+    SDL_bool track = default_value;
+
+    if (hint && *hint) {
+        track = (*hint == '0' || SDL_strcasecmp(hint, "false") == 0) ? SDL_FALSE : SDL_TRUE;
+    }
+    if (!track || !window->surface ||
+        (window->surface->flags & SDL_TRACKDAMAGE)) {
+        return;
+    }
+    window->surface->flags |= SDL_TRACKDAMAGE;
+    window->num_damage = 0;
+    SDL_AddSurfaceDamage(window->surface, NULL);
+}
+
+static Sint64
+SDL_RectArea(const SDL_Rect * rect)
+{
+    return (Sint64) rect->w * rect->h;
+}
+
+/* Add a rectangle to the window's damage: dropped if it's inside one
+   already there, replacing those inside it, and when there are
+   SDL_WINDOW_MAX_DAMAGE, merged into the one which grows the least */
+static void
+SDL_AddWindowDamage(SDL_Window * window, const SDL_Rect * rect)
+{
+    SDL_Rect *damage = window->damage;
+    SDL_Rect both;
+    Sint64 growth, least = 0;
+    int i, n = window->num_damage, best = -1;
+
+    for (i = 0; i < n;) {
+        SDL_UnionRect(&damage[i], rect, &both);
+        if (SDL_RectEquals(&both, &damage[i])) {
+            return;
+        }
+        if (SDL_RectEquals(&both, rect)) {
+            damage[i] = damage[--n];
+            continue;
+        }
+        growth = SDL_RectArea(&both) - SDL_RectArea(&damage[i]);
+        if (best < 0 || growth < least) {
+            best = i;
+            least = growth;
+        }
+        ++i;
+    }
+    if (n < SDL_WINDOW_MAX_DAMAGE) {
+        damage[n++] = *rect;
+    } else {
+        SDL_UnionRect(&damage[best], rect, &damage[best]);
+    }
+    window->num_damage = n;
+}
+
+void
+SDL_AddSurfaceDamage(SDL_Surface * surface, const SDL_Rect * rect)
+{
+    SDL_Window *window;
+    SDL_Rect bounds, clipped;
+
+    if (!(surface->flags & SDL_TRACKDAMAGE) || !_this) {
+        return;
+    }
+    bounds.x = 0;
+    bounds.y = 0;
+    bounds.w = surface->w;
+    bounds.h = surface->h;
+    if (!rect) {
+        clipped = bounds;
+    } else if (!SDL_IntersectRect(rect, &bounds, &clipped)) {
+        return;
+    }
+    for (window = _this->windows; window; window = window->next) {
+        if (window->surface == surface) {
+            SDL_AddWindowDamage(window, &clipped);
+            return;
+        }
+    }
+}
+
+void
+SDL_AddSurfaceDamagePoints(SDL_Surface * surface, const SDL_Point * points,
+                           int count)
+{
+    SDL_Rect rect, clipped;
+
+    if (!(surface->flags & SDL_TRACKDAMAGE)) {
+        return;
+    }
+    if (SDL_EnclosePoints(points, count, NULL, &rect) &&
+        SDL_IntersectRect(&rect, &surface->clip_rect, &clipped)) {
+        SDL_AddSurfaceDamage(surface, &clipped);
+    }
+}
+
 int
 SDL_UpdateWindowSurface(SDL_Window * window)
 {
@@ -2100,6 +2205,22 @@ SDL_UpdateWindowSurface(SDL_Window * window)
 
     CHECK_WINDOW_MAGIC(window, -1);
 
+    /* Only what's been drawn on since last time, if that's known */
+    if (window->surface_valid &&
+        (window->surface->flags & SDL_TRACKDAMAGE)) {
+        int retval;
+
+        if (window->num_damage == 0) {
+            return 0;
+        }
+        retval = SDL_UpdateWindowSurfaceRects(window, window->damage,
+                                              window->num_damage);
+        if (retval == 0) {
+            window->num_damage = 0;
+        }
+        return retval;
+    }
+
     full_rect.x = 0;
     full_rect.y = 0;
     full_rect.w = window->w;
@@ -2291,6 +2412,15 @@ SDL_OnWindowShown(SDL_Window * window)
     SDL_OnWindowRestored(window);
 }
 
+void
+SDL_OnWindowExposed(SDL_Window * window)
+{
+    /* The window system may have lost what was on the window */
+    if (window->surface) {
+        SDL_AddSurfaceDamage(window->surface, NULL);
+    }
+}
+
 void
 SDL_OnWindowHidden(SDL_Window * window)
 {
@@ -2321,6 +2451,8 @@ SDL_OnWindowRestored(SDL_Window * window)
      */
     /*SDL_RaiseWindow(window);*/
 
+    SDL_OnWindowExposed(window);
+
     if (FULLSCREEN_VISIBLE(window)) {
         SDL_UpdateFullscreenMode(window, SDL_TRUE);
     }
@@ -91,7 +91,9 @@ Cocoa_SetWindowShape(SDL_WindowShaper *shaper, SDL_Surface *shape, SDL_WindowSha
 
     [[NSColor clearColor] set];
     NSRectFill([[windata->nswindow contentView] frame]);
-    data->shape = SDL_CalculateShapeTree(*shape_mode,shape);
+    data->shape = SDL_UpdateShapeTree(data->shape,*shape_mode,shape);
+    if(data->shape == NULL)
+        return -1;
 
     closure.view = [windata->nswindow contentView];
     closure.path = [NSBezierPath bezierPath];
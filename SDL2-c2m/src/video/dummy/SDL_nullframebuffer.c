@@ -22,11 +22,15 @@
 
 #if SDL_VIDEO_DRIVER_DUMMY
 
+#include "SDL_timer.h"
 #include "../SDL_sysvideo.h"
+#include "../../events/SDL_events_c.h"
+#include "SDL_nullvideo.h"
 #include "SDL_nullframebuffer_c.h"
 
 
 #define DUMMY_SURFACE   "_SDL_DummySurface"
+#define BENCH_SCANOUT   "_SDL_BenchScanout"
 
 int SDL_DUMMY_CreateWindowFramebuffer(_THIS, SDL_Window * window, Uint32 * format, void ** pixels, int *pitch)
 {
@@ -84,6 +88,79 @@ void SDL_DUMMY_DestroyWindowFramebuffer(_THIS, SDL_Window * window)
     SDL_FreeSurface(surface);
 }
 
+/* The bench driver's framebuffer, and a "display" for frames to go to */
+int SDL_BENCH_CreateWindowFramebuffer(_THIS, SDL_Window * window, Uint32 * format, void ** pixels, int *pitch)
+{
+    SDL_Surface *scanout;
+
+    if (SDL_DUMMY_CreateWindowFramebuffer(_this, window, format, pixels, pitch) < 0) {
+        return -1;
+    }
+    scanout = (SDL_Surface *) SDL_GetWindowData(window, BENCH_SCANOUT);
+    SDL_FreeSurface(scanout);
+    scanout = SDL_CreateRGBSurface(0, window->w, window->h, 32,
+                                   0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+    if (!scanout) {
+        return -1;
+    }
+    SDL_SetWindowData(window, BENCH_SCANOUT, scanout);
+    return 0;
+}
+
+/* Copies the updated rects out (no waiting for a display), timing that
+   and the frame drawn since the last one */
+int SDL_BENCH_UpdateWindowFramebuffer(_THIS, SDL_Window * window, const SDL_Rect * rects, int numrects)
+{
+    SDL_BenchVideoData *data = (SDL_BenchVideoData *) _this->driverdata;
+    const Uint64 now = SDL_GetPerformanceCounter();
+    SDL_Surface *surface, *scanout;
+    int i;
+
+    surface = (SDL_Surface *) SDL_GetWindowData(window, DUMMY_SURFACE);
+    scanout = (SDL_Surface *) SDL_GetWindowData(window, BENCH_SCANOUT);
+    if (!surface || !scanout) {
+        return SDL_SetError("Couldn't find bench surface for window");
+    }
+    if (data->frames == 0) {
+        data->start = now;
+    } else {
+        data->render += now - data->last;
+    }
+
+    for (i = 0; i < numrects; ++i) {
+        SDL_Rect rect;
+
+        if (!SDL_IntersectRect(&rects[i], &surface->clip_rect, &rect) ||
+            !SDL_IntersectRect(&rect, &scanout->clip_rect, &rect)) {
+            continue;
+        }
+        SDL_ConvertPixels(rect.w, rect.h, surface->format->format,
+                          (Uint8 *) surface->pixels + rect.y * surface->pitch +
+                          rect.x * surface->format->BytesPerPixel,
+                          surface->pitch, scanout->format->format,
+                          (Uint8 *) scanout->pixels + rect.y * scanout->pitch +
+                          rect.x * scanout->format->BytesPerPixel,
+                          scanout->pitch);
+        data->pixels += (Uint64) rect.w * rect.h;
+    }
+
+    data->last = SDL_GetPerformanceCounter();
+    data->present += data->last - now;
+    if (++data->frames == data->max_frames) {
+        SDL_SendQuit();
+    }
+    return 0;
+}
+
+void SDL_BENCH_DestroyWindowFramebuffer(_THIS, SDL_Window * window)
+{
+    SDL_Surface *scanout;
+
+    SDL_DUMMY_DestroyWindowFramebuffer(_this, window);
+    scanout = (SDL_Surface *) SDL_SetWindowData(window, BENCH_SCANOUT, NULL);
+    SDL_FreeSurface(scanout);
+}
+
 #endif /* SDL_VIDEO_DRIVER_DUMMY */
 
 /* vi: set ts=4 sw=4 expandtab: */
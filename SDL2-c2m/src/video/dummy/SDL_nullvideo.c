@@ -32,6 +32,12 @@
  *  is a performance problem for a given platform, enable this driver, and
  *  then see if your application runs faster without video overhead.
  *
+ * The "bench" variant (SDL_VIDEODRIVER=bench) is for benchmarks: frames are
+ *  copied out of the framebuffer like a real driver's, as fast as they're
+ *  presented, and SDL_VideoQuit logs frames/s and the time per frame spent
+ *  drawing and presenting.  SDL_VIDEO_BENCH_FRAMES=n sends SDL_QUIT after
+ *  n frames, so a run is the same length every time.
+ *
  * Initial work by Ryan C. Gordon (icculus@icculus.org). A good portion
  *  of this was cut-and-pasted from Stephane Peter's work in the AAlib
  *  SDL video driver.  Renamed to "DUMMY" by Sam Lantinga.
@@ -39,6 +45,8 @@
 
 #include "SDL_video.h"
 #include "SDL_mouse.h"
+#include "SDL_log.h"
+#include "SDL_timer.h"
 #include "../SDL_sysvideo.h"
 #include "../SDL_pixels_c.h"
 #include "../../events/SDL_events_c.h"
@@ -48,11 +56,13 @@
 #include "SDL_nullframebuffer_c.h"
 
 #define DUMMYVID_DRIVER_NAME "dummy"
+#define BENCHVID_DRIVER_NAME "bench"
 
 /* Initialization/Query functions */
 static int DUMMY_VideoInit(_THIS);
 static int DUMMY_SetDisplayMode(_THIS, SDL_VideoDisplay * display, SDL_DisplayMode * mode);
 static void DUMMY_VideoQuit(_THIS);
+static void BENCH_VideoQuit(_THIS);
 
 /* DUMMY driver bootstrap functions */
 
@@ -104,6 +114,57 @@ VideoBootStrap DUMMY_bootstrap = {
     DUMMY_Available, DUMMY_CreateDevice
 };
 
+static int
+BENCH_Available(void)
+{
+    const char *envr = SDL_getenv("SDL_VIDEODRIVER");
+    if ((envr) && (SDL_strcmp(envr, BENCHVID_DRIVER_NAME) == 0)) {
+        return (1);
+    }
+
+    return (0);
+}
+
+static void
+BENCH_DeleteDevice(SDL_VideoDevice * device)
+{
+    SDL_free(device->driverdata);
+    SDL_free(device);
+}
+
+static SDL_VideoDevice *
+BENCH_CreateDevice(int devindex)
+{
+    SDL_VideoDevice *device = DUMMY_CreateDevice(devindex);
+    SDL_BenchVideoData *data;
+    const char *frames = SDL_getenv("SDL_VIDEO_BENCH_FRAMES");
+
+    if (!device) {
+        return (0);
+    }
+    data = (SDL_BenchVideoData *) SDL_calloc(1, sizeof(SDL_BenchVideoData));
+    if (!data) {
+        SDL_free(device);
+        SDL_OutOfMemory();
+        return (0);
+    }
+    data->max_frames = frames ? (Uint32) SDL_atoi(frames) : 0;
+    device->driverdata = data;
+
+    device->VideoQuit = BENCH_VideoQuit;
+    device->CreateWindowFramebuffer = SDL_BENCH_CreateWindowFramebuffer;
+    device->UpdateWindowFramebuffer = SDL_BENCH_UpdateWindowFramebuffer;
+    device->DestroyWindowFramebuffer = SDL_BENCH_DestroyWindowFramebuffer;
+    device->free = BENCH_DeleteDevice;
+
+    return device;
+}
+
+VideoBootStrap BENCH_bootstrap = {
+    BENCHVID_DRIVER_NAME, "SDL benchmark video driver",
+    BENCH_Available, BENCH_CreateDevice
+};
+
 
 int
 DUMMY_VideoInit(_THIS)
@@ -138,6 +199,27 @@ DUMMY_VideoQuit(_THIS)
 {
 }
 
+void
+BENCH_VideoQuit(_THIS)
+{
+    SDL_BenchVideoData *data = (SDL_BenchVideoData *) _this->driverdata;
+    const double freq = (double) SDL_GetPerformanceFrequency();
+    double seconds;
+
+    if (data->frames < 2) {
+        return;
+    }
+    /* From the first present to the last, so frames - 1 of them */
+    seconds = (double) (data->last - data->start) / freq;
+    SDL_Log("bench video: %u frames in %.3f s, %.1f frames/s, "
+            "%.1f Mpixels/s presented", (unsigned) data->frames, seconds,
+            (data->frames - 1) / seconds, data->pixels / seconds / 1e6);
+    SDL_Log("bench video: per frame %.3f ms rendering, %.3f ms presenting",
+            data->render * 1e3 / freq / (data->frames - 1),
+            data->present * 1e3 / freq / data->frames);
+    SDL_zerop(data);
+}
+
 #endif /* SDL_VIDEO_DRIVER_DUMMY */
 
 /* vi: set ts=4 sw=4 expandtab: */
@@ -25,6 +25,20 @@
 
 #include "../SDL_sysvideo.h"
 
+/* The "bench" driver's counters (performance counter ticks): it's the dummy
+   driver, but each frame is copied out as a real one would be, and
+   SDL_VideoQuit logs how fast the frames went */
+typedef struct
+{
+    Uint64 start;       /* at the first frame */
+    Uint64 last;        /* at the end of the last present */
+    Uint64 render;      /* between presents, drawing the frames */
+    Uint64 present;     /* copying them out */
+    Uint64 pixels;      /* copied out */
+    Uint32 frames;
+    Uint32 max_frames;  /* then SDL_QUIT is sent, 0 for no limit */
+} SDL_BenchVideoData;
+
 #endif /* _SDL_nullvideo_h */
 
 /* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,141 @@
+/*
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/* Benchmark of the sample format converters: each pair of formats is timed
+   with the converters SDL picks for this CPU, then again with only the
+   generated ones (SDL_AUDIO_SIMD=0), and their results are compared.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+
+#define SAMPLES ((1 << 20) + 13)  /* Not a multiple of a vector's samples */
+#define CONVERSIONS 50
+
+typedef struct
+{
+    SDL_AudioFormat src_format;
+    SDL_AudioFormat dst_format;
+    const char *name;
+} ConvertTest;
+
+static const ConvertTest tests[] = {
+    { AUDIO_U8, AUDIO_S16SYS, "U8 -> S16" },
+    { AUDIO_S16SYS, AUDIO_U8, "S16 -> U8" },
+    { AUDIO_S16SYS, AUDIO_F32SYS, "S16 -> F32" },
+    { AUDIO_F32SYS, AUDIO_S16SYS, "F32 -> S16" },
+    { AUDIO_S32SYS, AUDIO_F32SYS, "S32 -> F32" },
+    { AUDIO_F32SYS, AUDIO_S32SYS, "F32 -> S32" },
+};
+
+/* Random samples, floats between -1 & 1 */
+static void
+FillSamples(Uint8 * samples, SDL_AudioFormat format)
+{
+    const int size = SDL_AUDIO_BITSIZE(format) / 8;
+    int i;
+
+    for (i = 0; i < SAMPLES * size; ++i) {
+        samples[i] = (Uint8) rand();
+    }
+    if (SDL_AUDIO_ISFLOAT(format)) {
+        float *floats = (float *) samples;
+
+        for (i = 0; i < SAMPLES; ++i) {
+            floats[i] = ((float) rand() / RAND_MAX) * 2.0f - 1.0f;
+        }
+    }
+}
+
+/* Convert the samples into cvt's buffer, CONVERSIONS times, with the
+   converters the hint allows (NULL for all there are); returns the
+   milliseconds a conversion took */
+static double
+Benchmark(const ConvertTest * test, const Uint8 * samples, SDL_AudioCVT * cvt, const char *simd)
+{
+    const int len = SAMPLES * (SDL_AUDIO_BITSIZE(test->src_format) / 8);
+    Uint64 start, total = 0;
+    int i;
+
+    if (simd) {
+        SDL_SetHintWithPriority("SDL_AUDIO_SIMD", simd, SDL_HINT_OVERRIDE);
+    } else {
+        SDL_ClearHints();
+    }
+    /* The converter is picked when the conversion is built */
+    SDL_BuildAudioCVT(cvt, test->src_format, 1, 48000, test->dst_format, 1, 48000);
+    cvt->len = len;
+    cvt->buf = (Uint8 *) SDL_malloc(len * cvt->len_mult);
+    if (!cvt->buf) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory\n");
+        exit(1);
+    }
+    for (i = 0; i < CONVERSIONS; ++i) {
+        SDL_memcpy(cvt->buf, samples, len);
+        start = SDL_GetPerformanceCounter();
+        SDL_ConvertAudio(cvt);
+        total += SDL_GetPerformanceCounter() - start;
+    }
+    return (double) total * 1000.0 / SDL_GetPerformanceFrequency() / CONVERSIONS;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, failed = 0;
+
+    /* Enable standard application logging */
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO);
+
+    if (SDL_Init(0) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't initialize SDL: %s\n", SDL_GetError());
+        return (1);
+    }
+
+    SDL_Log("%d samples, %d conversions each\n", SAMPLES, CONVERSIONS);
+    for (i = 0; i < SDL_arraysize(tests); ++i) {
+        const ConvertTest *test = &tests[i];
+        Uint8 *samples = (Uint8 *) SDL_malloc(SAMPLES * 4);
+        SDL_AudioCVT fast, slow;
+        double fast_ms, slow_ms;
+        int same;
+
+        if (!samples) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory\n");
+            return (1);
+        }
+        FillSamples(samples, test->src_format);
+        fast_ms = Benchmark(test, samples, &fast, NULL);
+        slow_ms = Benchmark(test, samples, &slow, "0");
+        same = (fast.len_cvt == slow.len_cvt &&
+                SDL_memcmp(fast.buf, slow.buf, fast.len_cvt) == 0);
+        if (!same) {
+            failed = 1;
+        }
+        SDL_Log("%-11s %.3f ms, %.3f ms generated (%.1fx), %.0f Msamples/s%s\n",
+                test->name, fast_ms, slow_ms,
+                fast_ms > 0.0 ? slow_ms / fast_ms : 0.0,
+                fast_ms > 0.0 ? SAMPLES / fast_ms / 1000.0 : 0.0,
+                same ? "" : ", DIFFERENT RESULTS");
+
+        SDL_free(fast.buf);
+        SDL_free(slow.buf);
+        SDL_free(samples);
+    }
+
+    SDL_Quit();
+    return (failed);
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
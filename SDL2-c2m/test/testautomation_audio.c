@@ -969,6 +969,231 @@ int audio_openCloseAudioDeviceConnected()
 
 
 
+/* Resample all of src, given chunk bytes at a time (whole frames) into room
+   for dst_chunk bytes, then what's left with nothing more put in.  Returns
+   the bytes put in dst, or -1 on error. */
+static int
+_audio_resampleAll(SDL_AudioResampler *resampler, const Uint8 *src, int src_len, int chunk,
+                   Uint8 *dst, int dst_len, int dst_chunk)
+{
+  int put = 0, got = 0, n;
+
+  do {
+    n = SDL_min(chunk, src_len - put);
+    n = SDL_ResampleAudio(resampler, src + put, n, dst + got, SDL_min(dst_chunk, dst_len - got));
+    if (n < 0) {
+      return -1;
+    }
+    put += SDL_min(chunk, src_len - put);
+    got += n;
+  } while (put < src_len || n > 0);
+  return got;
+}
+
+/**
+ * \brief Resample a sine wave in one go and in pieces, and check what comes out.
+ *
+ * \sa SDL_NewAudioResampler
+ * \sa SDL_ResampleAudio
+ * \sa SDL_FreeAudioResampler
+ */
+int audio_resampleAudio()
+{
+  const int src_frames = 44100 + 4410;   /* A second of 1 kHz, then silence */
+  const int dst_room = 60000;
+  float *src = (float *) SDL_calloc(src_frames, sizeof(float));
+  float *whole = (float *) SDL_calloc(dst_room, sizeof(float));
+  float *pieces = (float *) SDL_calloc(dst_room, sizeof(float));
+  Sint16 stereo[2 * 4800], down[2 * 4800];
+  SDL_AudioResampler *resampler;
+  int i, len, len2, crossings, differ, frames;
+  float peak;
+
+  if (src == NULL || whole == NULL || pieces == NULL) {
+    SDL_free(src);
+    SDL_free(whole);
+    SDL_free(pieces);
+    return TEST_ABORTED;
+  }
+
+  /* Negative cases */
+  resampler = SDL_NewAudioResampler(AUDIO_U8, 1, 44100, 48000);
+  SDLTest_AssertCheck(resampler == NULL, "Validate AUDIO_U8 is refused");
+  resampler = SDL_NewAudioResampler(AUDIO_F32SYS, 0, 44100, 48000);
+  SDLTest_AssertCheck(resampler == NULL, "Validate 0 channels are refused");
+  resampler = SDL_NewAudioResampler(AUDIO_F32SYS, 1, 44100, 0);
+  SDLTest_AssertCheck(resampler == NULL, "Validate a rate of 0 is refused");
+
+  for (i = 0; i < 44100; i++) {
+    src[i] = 0.5f * SDL_sinf(2.0f * (float) M_PI * 1000.0f * i / 44100.0f);
+  }
+
+  resampler = SDL_NewAudioResampler(AUDIO_F32SYS, 1, 44100, 48000);
+  SDLTest_AssertPass("Call to SDL_NewAudioResampler(AUDIO_F32SYS, 1, 44100, 48000)");
+  SDLTest_AssertCheck(resampler != NULL, "Validate result value; expected: non-NULL");
+  if (resampler == NULL) {
+    SDL_free(src);
+    SDL_free(whole);
+    SDL_free(pieces);
+    return TEST_ABORTED;
+  }
+  len = SDL_ResampleAudio(resampler, src, 3, whole, 0);
+  SDLTest_AssertCheck(len == -1, "Validate part of a frame is refused; got: %i", len);
+  len = _audio_resampleAll(resampler, (const Uint8 *) src, src_frames * sizeof(float), src_frames * sizeof(float),
+                           (Uint8 *) whole, dst_room * sizeof(float), dst_room * sizeof(float));
+  SDL_FreeAudioResampler(resampler);
+  SDLTest_AssertPass("Resampled %i frames in one go to %i", src_frames, len / (int) sizeof(float));
+
+  resampler = SDL_NewAudioResampler(AUDIO_F32SYS, 1, 44100, 48000);
+  len2 = _audio_resampleAll(resampler, (const Uint8 *) src, src_frames * sizeof(float), 389 * sizeof(float),
+                            (Uint8 *) pieces, dst_room * sizeof(float), 251 * sizeof(float));
+  SDL_FreeAudioResampler(resampler);
+  SDLTest_AssertPass("Resampled %i frames in pieces to %i", src_frames, len2 / (int) sizeof(float));
+
+  /* All of it but the few milliseconds of the filter's latency */
+  frames = len / (int) sizeof(float);
+  SDLTest_AssertCheck(frames <= 48000 + 4800 && frames >= 48000 + 4800 - 960, "Validate frames out; expected: about %i, got: %i", 48000 + 4800, frames);
+  SDLTest_AssertCheck(len2 == len, "Validate pieces give as much; expected: %i, got: %i", len, len2);
+  for (differ = 0, i = 0; i < frames && len2 == len; i++) {
+    differ += SDL_fabs(whole[i] - pieces[i]) > 1e-5;
+  }
+  SDLTest_AssertCheck(differ == 0, "Validate pieces give the same samples; expected: 0 differing, got: %i", differ);
+
+  /* Away from the ends it's the same wave, 1 kHz at 48 kHz */
+  for (peak = 0.0f, crossings = 0, i = 12000; i < 36000; i++) {
+    peak = SDL_max(peak, (float) SDL_fabs(whole[i]));
+    crossings += (whole[i - 1] < 0.0f) != (whole[i] < 0.0f);
+  }
+  SDLTest_AssertCheck(peak > 0.49f && peak < 0.51f, "Validate amplitude; expected: 0.5, got: %f", peak);
+  SDLTest_AssertCheck(crossings >= 998 && crossings <= 1002, "Validate zero crossings; expected: 1000, got: %i", crossings);
+
+  /* Channels stay apart: left is the negative of right */
+  for (i = 0; i < 4800; i++) {
+    stereo[2 * i] = (Sint16) (8000.0 * SDL_sin(2.0 * M_PI * 100.0 * i / 48000.0));
+    stereo[2 * i + 1] = (Sint16) -stereo[2 * i];
+  }
+  resampler = SDL_NewAudioResampler(AUDIO_S16SYS, 2, 48000, 22050);
+  SDLTest_AssertCheck(resampler != NULL, "Call to SDL_NewAudioResampler(AUDIO_S16SYS, 2, 48000, 22050)");
+  if (resampler != NULL) {
+    len = _audio_resampleAll(resampler, (const Uint8 *) stereo, sizeof(stereo), 1000,
+                             (Uint8 *) down, sizeof(down), sizeof(down));
+    SDL_FreeAudioResampler(resampler);
+    frames = len / 4;
+    SDLTest_AssertCheck(frames > 2000 && frames <= 2205, "Validate frames out; expected: about 2205, got: %i", frames);
+    for (differ = 0, i = 0; i < frames; i++) {
+      differ += SDL_abs(down[2 * i] + down[2 * i + 1]) > 2;
+    }
+    SDLTest_AssertCheck(differ == 0, "Validate channels; expected: 0 mixed, got: %i", differ);
+  }
+
+  SDL_free(src);
+  SDL_free(whole);
+  SDL_free(pieces);
+  return TEST_COMPLETED;
+}
+
+/**
+ * \brief Convert audio through an SDL_AudioStream, put in and got out in pieces.
+ *
+ * \sa SDL_NewAudioStream
+ * \sa SDL_AudioStreamPut
+ * \sa SDL_AudioStreamGet
+ * \sa SDL_AudioStreamAvailable
+ * \sa SDL_AudioStreamFlush
+ * \sa SDL_AudioStreamClear
+ * \sa SDL_FreeAudioStream
+ */
+int audio_audioStream()
+{
+  const int src_frames = 22050;
+  Sint16 *src = (Sint16 *) SDL_calloc(src_frames * 2, sizeof(Sint16));
+  float *dst = (float *) SDL_calloc(30000, sizeof(float));
+  Uint8 bytes[1000], copy[1000];
+  SDL_AudioStream *stream;
+  int i, len, put, got, available, differ, frames;
+  float peak;
+
+  if (src == NULL || dst == NULL) {
+    SDL_free(src);
+    SDL_free(dst);
+    return TEST_ABORTED;
+  }
+
+  /* Negative cases */
+  stream = SDL_NewAudioStream(0x1234, 2, 44100, AUDIO_F32SYS, 1, 48000);
+  SDLTest_AssertCheck(stream == NULL, "Validate an unknown format is refused");
+  stream = SDL_NewAudioStream(AUDIO_S16SYS, 0, 44100, AUDIO_F32SYS, 1, 48000);
+  SDLTest_AssertCheck(stream == NULL, "Validate 0 channels are refused");
+  stream = SDL_NewAudioStream(AUDIO_S16SYS, 2, 0, AUDIO_F32SYS, 1, 48000);
+  SDLTest_AssertCheck(stream == NULL, "Validate a rate of 0 is refused");
+  len = SDL_AudioStreamPut(NULL, bytes, 1);
+  SDLTest_AssertCheck(len == -1, "Validate SDL_AudioStreamPut(NULL, ...) fails; got: %i", len);
+
+  /* The same format is copied through */
+  stream = SDL_NewAudioStream(AUDIO_U8, 1, 8000, AUDIO_U8, 1, 8000);
+  SDLTest_AssertCheck(stream != NULL, "Call to SDL_NewAudioStream(AUDIO_U8, 1, 8000, AUDIO_U8, 1, 8000)");
+  if (stream != NULL) {
+    for (i = 0; i < (int) sizeof(bytes); i++) {
+      bytes[i] = (Uint8) (i * 7);
+    }
+    SDL_AudioStreamPut(stream, bytes, 300);
+    SDL_AudioStreamPut(stream, bytes + 300, sizeof(bytes) - 300);
+    available = SDL_AudioStreamAvailable(stream);
+    SDLTest_AssertCheck(available == (int) sizeof(bytes), "Validate available; expected: %i, got: %i", (int) sizeof(bytes), available);
+    len = SDL_AudioStreamGet(stream, copy, sizeof(copy));
+    SDLTest_AssertCheck(len == (int) sizeof(copy) && SDL_memcmp(bytes, copy, sizeof(copy)) == 0, "Validate the bytes got are the bytes put");
+
+    SDL_AudioStreamPut(stream, bytes, 100);
+    SDL_AudioStreamClear(stream);
+    available = SDL_AudioStreamAvailable(stream);
+    SDLTest_AssertCheck(available == 0, "Validate nothing's available after SDL_AudioStreamClear(); got: %i", available);
+    SDL_FreeAudioStream(stream);
+  }
+
+  /* Stereo S16 at 44.1 kHz to mono float at 48 kHz, put in 999 bytes at a time
+     so frames are split between puts */
+  for (i = 0; i < src_frames; i++) {
+    src[2 * i] = src[2 * i + 1] = (Sint16) (16384.0 * SDL_sin(2.0 * M_PI * 441.0 * i / 44100.0));
+  }
+  stream = SDL_NewAudioStream(AUDIO_S16SYS, 2, 44100, AUDIO_F32SYS, 1, 48000);
+  SDLTest_AssertPass("Call to SDL_NewAudioStream(AUDIO_S16SYS, 2, 44100, AUDIO_F32SYS, 1, 48000)");
+  SDLTest_AssertCheck(stream != NULL, "Validate result value; expected: non-NULL");
+  if (stream == NULL) {
+    SDL_free(src);
+    SDL_free(dst);
+    return TEST_ABORTED;
+  }
+  for (put = 0, got = 0; put < src_frames * 4; put += len) {
+    len = SDL_min(999, src_frames * 4 - put);
+    if (SDL_AudioStreamPut(stream, (const Uint8 *) src + put, len) < 0) {
+      break;
+    }
+    got += SDL_AudioStreamGet(stream, (Uint8 *) dst + got, 333 * sizeof(float));
+  }
+  SDLTest_AssertCheck(put == src_frames * 4, "Validate all was put in; expected: %i, got: %i", src_frames * 4, put);
+  available = SDL_AudioStreamAvailable(stream);
+  SDLTest_AssertCheck(available % sizeof(float) == 0, "Validate whole frames are available; got: %i", available);
+  len = SDL_AudioStreamFlush(stream);
+  SDLTest_AssertCheck(len == 0, "Call to SDL_AudioStreamFlush(); expected: 0, got: %i", len);
+  got += SDL_AudioStreamGet(stream, (Uint8 *) dst + got, 30000 * sizeof(float) - got);
+  available = SDL_AudioStreamAvailable(stream);
+  SDLTest_AssertCheck(available == 0, "Validate all was got; expected: 0 left, got: %i", available);
+  SDL_FreeAudioStream(stream);
+
+  frames = got / (int) sizeof(float);
+  SDLTest_AssertCheck(frames >= 23990 && frames <= 24010, "Validate frames out; expected: about 24000, got: %i", frames);
+  for (peak = 0.0f, differ = 0, i = 2000; i < 22000; i++) {
+    peak = SDL_max(peak, (float) SDL_fabs(dst[i]));
+    differ += SDL_fabs(dst[i] - 0.5 * SDL_sin(2.0 * M_PI * 441.0 * i / 48000.0)) > 0.01;
+  }
+  SDLTest_AssertCheck(peak > 0.49f && peak < 0.51f, "Validate amplitude; expected: 0.5, got: %f", peak);
+  SDLTest_AssertCheck(differ == 0, "Validate the wave; expected: 0 samples off, got: %i", differ);
+
+  SDL_free(src);
+  SDL_free(dst);
+  return TEST_COMPLETED;
+}
+
 /* ================= Test Case References ================== */
 
 /* Audio test cases */
@@ -1022,11 +1247,18 @@ static const SDLTest_TestCaseReference audioTest14 =
 static const SDLTest_TestCaseReference audioTest15 =
         { (SDLTest_TestCaseFp)audio_pauseUnpauseAudio, "audio_pauseUnpauseAudio", "Pause and Unpause audio for various audio specs while testing callback.", TEST_ENABLED };
 
+static const SDLTest_TestCaseReference audioTest16 =
+        { (SDLTest_TestCaseFp)audio_resampleAudio, "audio_resampleAudio", "Resample a sine wave with SDL_AudioResampler.", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference audioTest17 =
+        { (SDLTest_TestCaseFp)audio_audioStream, "audio_audioStream", "Convert audio through an SDL_AudioStream.", TEST_ENABLED };
+
 /* Sequence of Audio test cases */
 static const SDLTest_TestCaseReference *audioTests[] =  {
     &audioTest1, &audioTest2, &audioTest3, &audioTest4, &audioTest5, &audioTest6,
     &audioTest7, &audioTest8, &audioTest9, &audioTest10, &audioTest11,
-    &audioTest12, &audioTest13, &audioTest14, &audioTest15, NULL
+    &audioTest12, &audioTest13, &audioTest14, &audioTest15, &audioTest16,
+    &audioTest17, NULL
 };
 
 /* Audio test suite (global) */
@@ -0,0 +1,213 @@
+/**
+ * Counter and histogram test suite
+ */
+
+#include <stdio.h>
+
+#include "SDL.h"
+#include "SDL_test.h"
+
+#define METRICS_THREADS 4
+#define METRICS_LOOPS 10000
+
+static int SDLCALL
+_metricsCounterThread(void *arg)
+{
+    SDL_Metric *counter = (SDL_Metric *) arg;
+    int i;
+
+    for (i = 0; i < METRICS_LOOPS; i++) {
+        SDL_CounterAdd(counter, 1);
+    }
+    return 0;
+}
+
+/* ================= Test Case Implementation ================== */
+
+/**
+ * @brief Counters updated from several threads, and names.
+ *
+ * @sa SDL_CreateCounter
+ * @sa SDL_CounterAdd
+ * @sa SDL_GetMetricCount
+ */
+int
+metrics_counter(void *arg)
+{
+    SDL_Thread *threads[METRICS_THREADS];
+    SDL_Metric *counter;
+    Sint64 before, count;
+    int i;
+
+    counter = SDL_CreateCounter("1bad", NULL);
+    SDLTest_AssertCheck(counter == NULL, "Verify an invalid name returns NULL");
+
+    counter = SDL_CreateCounter("testautomation_counter_total", "Counted by the test");
+    SDLTest_AssertPass("Call to SDL_CreateCounter()");
+    SDLTest_AssertCheck(counter != NULL, "Verify the counter is not NULL");
+    if (counter == NULL) {
+        return TEST_ABORTED;
+    }
+    SDLTest_AssertCheck(
+        SDL_CreateCounter("testautomation_counter_total", NULL) == counter,
+        "Verify the same name returns the same counter");
+    SDLTest_AssertCheck(
+        SDL_CreateHistogram("testautomation_counter_total", NULL) == NULL,
+        "Verify a histogram can't have a counter's name");
+
+    before = SDL_GetMetricCount(counter);
+    for (i = 0; i < METRICS_THREADS; i++) {
+        threads[i] = SDL_CreateThread(_metricsCounterThread, "MetricsCounter", counter);
+        SDLTest_AssertCheck(threads[i] != NULL, "Verify creating thread %d", i);
+    }
+    for (i = 0; i < METRICS_THREADS; i++) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    SDL_CounterAdd(counter, -5);
+    count = SDL_GetMetricCount(counter) - before;
+    SDLTest_AssertCheck(
+        count == METRICS_THREADS * METRICS_LOOPS - 5,
+        "Verify the threads' adds, expected %d, got %" SDL_PRIs64,
+        METRICS_THREADS * METRICS_LOOPS - 5, count);
+
+    return TEST_COMPLETED;
+}
+
+/**
+ * @brief Histogram counts and quantiles.
+ *
+ * @sa SDL_CreateHistogram
+ * @sa SDL_HistogramRecord
+ * @sa SDL_GetMetricQuantile
+ */
+int
+metrics_histogram(void *arg)
+{
+    SDL_Metric *histogram;
+    Uint64 value;
+    int i;
+
+    histogram = SDL_CreateHistogram("testautomation_histogram", NULL);
+    SDLTest_AssertPass("Call to SDL_CreateHistogram()");
+    SDLTest_AssertCheck(histogram != NULL, "Verify the histogram is not NULL");
+    if (histogram == NULL) {
+        return TEST_ABORTED;
+    }
+    SDLTest_AssertCheck(
+        SDL_CreateCounter("testautomation_histogram", NULL) == NULL,
+        "Verify a counter can't have a histogram's name");
+    SDLTest_AssertCheck(SDL_GetMetricCount(histogram) == 0, "Verify a new histogram is empty");
+    SDLTest_AssertCheck(SDL_GetMetricQuantile(histogram, 0.5) == 0, "Verify an empty histogram's quantile is 0");
+
+    for (i = 1; i <= 1000; i++) {
+        SDL_HistogramRecord(histogram, (Uint64) i);
+    }
+    SDLTest_AssertCheck(
+        SDL_GetMetricCount(histogram) == 1000,
+        "Verify the count, expected 1000, got %" SDL_PRIs64, SDL_GetMetricCount(histogram));
+
+    /* Each within 1/16 of the value */
+    value = SDL_GetMetricQuantile(histogram, 0.5);
+    SDLTest_AssertCheck(
+        value >= 500 && value <= 500 + 500 / 16 + 1,
+        "Verify the median, expected 500 to %d, got %" SDL_PRIu64, 500 + 500 / 16 + 1, value);
+    value = SDL_GetMetricQuantile(histogram, 0.99);
+    SDLTest_AssertCheck(
+        value >= 990 && value <= 990 + 990 / 16 + 1,
+        "Verify the 99th percentile, expected 990 to %d, got %" SDL_PRIu64, 990 + 990 / 16 + 1, value);
+    value = SDL_GetMetricQuantile(histogram, 1.0);
+    SDLTest_AssertCheck(
+        value >= 1000 && value <= 1000 + 1000 / 16 + 1,
+        "Verify the maximum, expected 1000 to %d, got %" SDL_PRIu64, 1000 + 1000 / 16 + 1, value);
+
+    return TEST_COMPLETED;
+}
+
+/**
+ * @brief The Prometheus text export.
+ *
+ * @sa SDL_WriteMetrics
+ */
+int
+metrics_write(void *arg)
+{
+    const size_t size = 256 * 1024;
+    SDL_Metric *counter, *histogram;
+    SDL_RWops *rw;
+    char *text;
+    Sint64 length;
+    int result;
+
+    counter = SDL_CreateCounter("testautomation_write_total", "Line\nbreak");
+    histogram = SDL_CreateHistogram("testautomation_write_bytes", NULL);
+    SDLTest_AssertCheck(counter != NULL && histogram != NULL, "Verify the metrics are not NULL");
+    if (counter == NULL || histogram == NULL) {
+        return TEST_ABORTED;
+    }
+    SDL_CounterAdd(counter, 42 - SDL_GetMetricCount(counter));
+    SDL_HistogramRecord(histogram, 5);
+
+    text = (char *) SDL_calloc(1, size);
+    SDLTest_AssertCheck(text != NULL, "Verify allocating the buffer");
+    if (text == NULL) {
+        return TEST_ABORTED;
+    }
+    rw = SDL_RWFromMem(text, (int) size - 1);
+    result = SDL_WriteMetrics(rw);
+    SDLTest_AssertPass("Call to SDL_WriteMetrics()");
+    SDLTest_AssertCheck(result == 0, "Verify the result, expected 0, got %d", result);
+    length = SDL_RWtell(rw);
+    SDLTest_AssertCheck(length > 0, "Verify something was written, got %" SDL_PRIs64, length);
+    SDL_RWclose(rw);
+
+    SDLTest_AssertCheck(
+        SDL_strstr(text, "# HELP testautomation_write_total Line\\nbreak\n") != NULL,
+        "Verify the counter's escaped help");
+    SDLTest_AssertCheck(
+        SDL_strstr(text, "# TYPE testautomation_write_total counter\ntestautomation_write_total 42\n") != NULL,
+        "Verify the counter's type and value");
+    SDLTest_AssertCheck(
+        SDL_strstr(text, "# TYPE testautomation_write_bytes histogram\n") != NULL,
+        "Verify the histogram's type");
+    SDLTest_AssertCheck(
+        SDL_strstr(text, "testautomation_write_bytes_bucket{le=\"7\"} 1\n") != NULL,
+        "Verify the histogram's bucket at 7");
+    SDLTest_AssertCheck(
+        SDL_strstr(text, "testautomation_write_bytes_bucket{le=\"+Inf\"} 1\n") != NULL &&
+        SDL_strstr(text, "testautomation_write_bytes_count 1\n") != NULL,
+        "Verify the histogram's count");
+
+    /* A stream too small for all of it */
+    rw = SDL_RWFromMem(text, 8);
+    result = SDL_WriteMetrics(rw);
+    SDLTest_AssertCheck(result == -1, "Verify writing to a full stream, expected -1, got %d", result);
+    SDL_RWclose(rw);
+
+    SDL_free(text);
+    return TEST_COMPLETED;
+}
+
+/* ================= Test References ================== */
+
+/* Metrics test cases */
+static const SDLTest_TestCaseReference metricsTest1 =
+        { (SDLTest_TestCaseFp)metrics_counter, "metrics_counter", "Counters updated from several threads, and names", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference metricsTest2 =
+        { (SDLTest_TestCaseFp)metrics_histogram, "metrics_histogram", "Histogram counts and quantiles", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference metricsTest3 =
+        { (SDLTest_TestCaseFp)metrics_write, "metrics_write", "The Prometheus text export", TEST_ENABLED };
+
+/* Sequence of Metrics test cases */
+static const SDLTest_TestCaseReference *metricsTests[] =  {
+    &metricsTest1, &metricsTest2, &metricsTest3, NULL
+};
+
+/* Metrics test suite (global) */
+SDLTest_TestSuiteReference metricsTestSuite = {
+    "Metrics",
+    NULL,
+    metricsTests,
+    NULL
+};
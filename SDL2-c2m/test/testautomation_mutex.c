@@ -0,0 +1,359 @@
+/**
+ * Mutex, semaphore, condition variable and reader-writer lock test suite
+ */
+
+#include <stdio.h>
+
+#include "SDL.h"
+#include "SDL_test.h"
+
+#define MUTEX_THREADS 4
+#define MUTEX_LOOPS 10000
+
+/* Shared by the threads of a test: writers keep both values equal */
+typedef struct
+{
+    SDL_rwlock *rwlock;
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    SDL_SeqLock seqlock;
+#endif
+    SDL_atomic_t a;
+    SDL_atomic_t b;
+    SDL_atomic_t torn;
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    SDL_sem *sem;
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    SDL_SpinMutex spin;
+#endif
+    int count;
+    int spun;
+} _mutexShared;
+
+static int SDLCALL
+_mutexLockThread(void *arg)
+{
+    _mutexShared *shared = (_mutexShared *) arg;
+    int i;
+
+    for (i = 0; i < MUTEX_LOOPS; ++i) {
+        SDL_LockMutex(shared->mutex);
+        SDL_LockMutex(shared->mutex);
+        ++shared->count;
+        SDL_UnlockMutex(shared->mutex);
+        if (shared->count == MUTEX_THREADS * MUTEX_LOOPS) {
+            SDL_CondSignal(shared->cond);
+        }
+        SDL_UnlockMutex(shared->mutex);
+#ifdef SDL_HAS_NATIVE_ATOMICS
+        SDL_SpinMutexLock(&shared->spin);
+        ++shared->spun;
+        SDL_SpinMutexUnlock(&shared->spin);
+#endif
+    }
+    return 0;
+}
+
+static int SDLCALL
+_mutexSemThread(void *arg)
+{
+    _mutexShared *shared = (_mutexShared *) arg;
+    int i;
+
+    for (i = 0; i < MUTEX_LOOPS; ++i) {
+        SDL_SemWait(shared->sem);
+        SDL_AtomicAdd(&shared->a, 1);
+    }
+    return 0;
+}
+
+static int SDLCALL
+_mutexRWLockThread(void *arg)
+{
+    _mutexShared *shared = (_mutexShared *) arg;
+    int i, a, b;
+
+    for (i = 0; i < MUTEX_LOOPS; ++i) {
+        if (i % 10 == 0) {
+            SDL_LockRWLockForWriting(shared->rwlock);
+            a = SDL_AtomicGet(&shared->a);
+            SDL_AtomicSet(&shared->a, a + 1);
+            SDL_AtomicSet(&shared->b, a + 1);
+        } else {
+            SDL_LockRWLockForReading(shared->rwlock);
+            a = SDL_AtomicGet(&shared->a);
+            b = SDL_AtomicGet(&shared->b);
+            if (a != b) {
+                SDL_AtomicAdd(&shared->torn, 1);
+            }
+        }
+        SDL_UnlockRWLock(shared->rwlock);
+    }
+    return 0;
+}
+
+/* Test case functions */
+
+/**
+ * @brief Recursive mutexes, spin mutexes and a condition variable shared by threads
+ */
+int
+mutex_lock(void *arg)
+{
+    _mutexShared shared;
+    SDL_Thread *threads[MUTEX_THREADS];
+    int i, result;
+
+    SDL_zero(shared);
+    shared.mutex = SDL_CreateMutex();
+    SDLTest_AssertCheck(shared.mutex != NULL, "Call to SDL_CreateMutex(), expected: non-NULL");
+    shared.cond = SDL_CreateCond();
+    SDLTest_AssertCheck(shared.cond != NULL, "Call to SDL_CreateCond(), expected: non-NULL");
+    if (shared.mutex == NULL || shared.cond == NULL) {
+        return TEST_ABORTED;
+    }
+
+    result = SDL_UnlockMutex(shared.mutex);
+    SDLTest_AssertCheck(result == -1, "Check unlock of a free mutex, expected: -1, got: %d", result);
+    result = SDL_TryLockMutex(shared.mutex);
+    SDLTest_AssertCheck(result == 0, "Check try lock, expected: 0, got: %d", result);
+    result = SDL_TryLockMutex(shared.mutex);
+    SDLTest_AssertCheck(result == 0, "Check recursive try lock, expected: 0, got: %d", result);
+    SDL_UnlockMutex(shared.mutex);
+    SDL_UnlockMutex(shared.mutex);
+
+    SDL_LockMutex(shared.mutex);
+    for (i = 0; i < MUTEX_THREADS; ++i) {
+        threads[i] = SDL_CreateThread(_mutexLockThread, "Mutex", &shared);
+        SDLTest_AssertCheck(threads[i] != NULL, "Check thread %d was created", i);
+    }
+    while (shared.count < MUTEX_THREADS * MUTEX_LOOPS) {
+        SDL_CondWait(shared.cond, shared.mutex);
+    }
+    SDL_UnlockMutex(shared.mutex);
+    SDLTest_AssertPass("Call to SDL_CondWait() until the threads were done");
+    for (i = 0; i < MUTEX_THREADS; ++i) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    SDLTest_AssertCheck(shared.count == MUTEX_THREADS * MUTEX_LOOPS, "Check count, expected: %d, got: %d", MUTEX_THREADS * MUTEX_LOOPS, shared.count);
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    SDLTest_AssertCheck(shared.spun == MUTEX_THREADS * MUTEX_LOOPS, "Check spin mutex count, expected: %d, got: %d", MUTEX_THREADS * MUTEX_LOOPS, shared.spun);
+#endif
+
+    SDL_DestroyCond(shared.cond);
+    SDL_DestroyMutex(shared.mutex);
+    return TEST_COMPLETED;
+}
+
+/**
+ * @brief Semaphore counts, timeouts, and threads waiting on posts
+ */
+int
+mutex_semaphore(void *arg)
+{
+    _mutexShared shared;
+    SDL_Thread *threads[MUTEX_THREADS];
+    Uint32 start, elapsed, value;
+    int i, result;
+
+    SDL_zero(shared);
+    shared.sem = SDL_CreateSemaphore(2);
+    SDLTest_AssertPass("Call to SDL_CreateSemaphore(2)");
+    SDLTest_AssertCheck(shared.sem != NULL, "Check result value, expected: non-NULL");
+    if (shared.sem == NULL) {
+        return TEST_ABORTED;
+    }
+
+    value = SDL_SemValue(shared.sem);
+    SDLTest_AssertCheck(value == 2, "Check value, expected: 2, got: %u", (unsigned) value);
+    result = SDL_SemTryWait(shared.sem);
+    SDLTest_AssertCheck(result == 0, "Check first try wait, expected: 0, got: %d", result);
+    result = SDL_SemWaitTimeout(shared.sem, 0);
+    SDLTest_AssertCheck(result == 0, "Check second wait, expected: 0, got: %d", result);
+    result = SDL_SemTryWait(shared.sem);
+    SDLTest_AssertCheck(result == SDL_MUTEX_TIMEDOUT, "Check try wait at 0, expected: %d, got: %d", SDL_MUTEX_TIMEDOUT, result);
+
+    start = SDL_GetTicks();
+    result = SDL_SemWaitTimeout(shared.sem, 50);
+    elapsed = SDL_GetTicks() - start;
+    SDLTest_AssertCheck(result == SDL_MUTEX_TIMEDOUT, "Check wait timing out, expected: %d, got: %d", SDL_MUTEX_TIMEDOUT, result);
+    SDLTest_AssertCheck(elapsed >= 40, "Check time waited, expected: >= 40, got: %u", (unsigned) elapsed);
+
+    SDL_SemPost(shared.sem);
+    result = SDL_SemWait(shared.sem);
+    SDLTest_AssertCheck(result == 0, "Check wait after a post, expected: 0, got: %d", result);
+
+    for (i = 0; i < MUTEX_THREADS; ++i) {
+        threads[i] = SDL_CreateThread(_mutexSemThread, "Semaphore", &shared);
+        SDLTest_AssertCheck(threads[i] != NULL, "Check thread %d was created", i);
+    }
+    for (i = 0; i < MUTEX_THREADS * MUTEX_LOOPS; ++i) {
+        SDL_SemPost(shared.sem);
+    }
+    for (i = 0; i < MUTEX_THREADS; ++i) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    result = SDL_AtomicGet(&shared.a);
+    SDLTest_AssertCheck(result == MUTEX_THREADS * MUTEX_LOOPS, "Check waits, expected: %d, got: %d", MUTEX_THREADS * MUTEX_LOOPS, result);
+    value = SDL_SemValue(shared.sem);
+    SDLTest_AssertCheck(value == 0, "Check value, expected: 0, got: %u", (unsigned) value);
+
+    SDL_DestroySemaphore(shared.sem);
+    return TEST_COMPLETED;
+}
+
+/**
+ * @brief Try-locks of a reader-writer lock, then readers and writers in threads
+ */
+int
+mutex_rwlock(void *arg)
+{
+    _mutexShared shared;
+    SDL_Thread *threads[MUTEX_THREADS];
+    int i, result;
+
+    SDL_zero(shared);
+    shared.rwlock = SDL_CreateRWLock();
+    SDLTest_AssertPass("Call to SDL_CreateRWLock()");
+    SDLTest_AssertCheck(shared.rwlock != NULL, "Check result value, expected: non-NULL");
+    if (shared.rwlock == NULL) {
+        return TEST_ABORTED;
+    }
+
+    /* Readers share it, and keep writers out */
+    result = SDL_TryLockRWLockForReading(shared.rwlock);
+    SDLTest_AssertCheck(result == 0, "Check first read lock, expected: 0, got: %d", result);
+    result = SDL_TryLockRWLockForReading(shared.rwlock);
+    SDLTest_AssertCheck(result == 0, "Check second read lock, expected: 0, got: %d", result);
+    result = SDL_TryLockRWLockForWriting(shared.rwlock);
+    SDLTest_AssertCheck(result == SDL_MUTEX_TIMEDOUT, "Check write lock while read, expected: %d, got: %d", SDL_MUTEX_TIMEDOUT, result);
+    SDL_UnlockRWLock(shared.rwlock);
+    SDL_UnlockRWLock(shared.rwlock);
+
+    /* A writer keeps everyone out */
+    result = SDL_TryLockRWLockForWriting(shared.rwlock);
+    SDLTest_AssertCheck(result == 0, "Check write lock, expected: 0, got: %d", result);
+    result = SDL_TryLockRWLockForReading(shared.rwlock);
+    SDLTest_AssertCheck(result == SDL_MUTEX_TIMEDOUT, "Check read lock while written, expected: %d, got: %d", SDL_MUTEX_TIMEDOUT, result);
+    result = SDL_UnlockRWLock(shared.rwlock);
+    SDLTest_AssertCheck(result == 0, "Check unlock, expected: 0, got: %d", result);
+
+    result = SDL_LockRWLockForReading(NULL);
+    SDLTest_AssertCheck(result == -1, "Check read lock of NULL, expected: -1, got: %d", result);
+
+    for (i = 0; i < MUTEX_THREADS; ++i) {
+        threads[i] = SDL_CreateThread(_mutexRWLockThread, "RWLock", &shared);
+        SDLTest_AssertCheck(threads[i] != NULL, "Check thread %d was created", i);
+    }
+    for (i = 0; i < MUTEX_THREADS; ++i) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    SDLTest_AssertPass("Ran %d threads reading and writing", MUTEX_THREADS);
+    result = SDL_AtomicGet(&shared.a);
+    SDLTest_AssertCheck(result == MUTEX_THREADS * MUTEX_LOOPS / 10, "Check writes, expected: %d, got: %d", MUTEX_THREADS * MUTEX_LOOPS / 10, result);
+    result = SDL_AtomicGet(&shared.torn);
+    SDLTest_AssertCheck(result == 0, "Check torn reads, expected: 0, got: %d", result);
+
+    SDL_DestroyRWLock(shared.rwlock);
+    SDLTest_AssertPass("Call to SDL_DestroyRWLock()");
+    return TEST_COMPLETED;
+}
+
+#ifdef SDL_HAS_NATIVE_ATOMICS
+static int SDLCALL
+_mutexSeqLockWriter(void *arg)
+{
+    _mutexShared *shared = (_mutexShared *) arg;
+    int i;
+
+    for (i = 1; i <= MUTEX_LOOPS; ++i) {
+        SDL_SeqLockWriteBegin(&shared->seqlock);
+        SDL_AtomicStore(&shared->a, i, SDL_MEMORY_ORDER_RELAXED);
+        SDL_AtomicStore(&shared->b, i, SDL_MEMORY_ORDER_RELAXED);
+        SDL_SeqLockWriteEnd(&shared->seqlock);
+    }
+    return 0;
+}
+
+static int SDLCALL
+_mutexSeqLockReader(void *arg)
+{
+    _mutexShared *shared = (_mutexShared *) arg;
+    int i, a, b, seq;
+
+    for (i = 0; i < MUTEX_LOOPS; ++i) {
+        do {
+            seq = SDL_SeqLockReadBegin(&shared->seqlock);
+            a = SDL_AtomicLoad(&shared->a, SDL_MEMORY_ORDER_RELAXED);
+            b = SDL_AtomicLoad(&shared->b, SDL_MEMORY_ORDER_RELAXED);
+        } while (SDL_SeqLockReadRetry(&shared->seqlock, seq));
+        if (a != b) {
+            SDL_AtomicAdd(&shared->torn, 1);
+        }
+    }
+    return 0;
+}
+#endif
+
+/**
+ * @brief Readers of a sequence lock only see whole writes
+ */
+int
+mutex_seqlock(void *arg)
+{
+#ifdef SDL_HAS_NATIVE_ATOMICS
+    _mutexShared shared;
+    SDL_SeqLock init = SDL_SEQLOCK_INIT;
+    SDL_Thread *threads[MUTEX_THREADS];
+    int i, result;
+
+    SDL_zero(shared);
+    shared.seqlock = init;
+    threads[0] = SDL_CreateThread(_mutexSeqLockWriter, "SeqLockWriter", &shared);
+    SDLTest_AssertCheck(threads[0] != NULL, "Check writer thread was created");
+    for (i = 1; i < MUTEX_THREADS; ++i) {
+        threads[i] = SDL_CreateThread(_mutexSeqLockReader, "SeqLockReader", &shared);
+        SDLTest_AssertCheck(threads[i] != NULL, "Check reader thread %d was created", i);
+    }
+    for (i = 0; i < MUTEX_THREADS; ++i) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    SDLTest_AssertPass("Ran a writer and %d readers", MUTEX_THREADS - 1);
+    result = SDL_AtomicGet(&shared.torn);
+    SDLTest_AssertCheck(result == 0, "Check torn reads, expected: 0, got: %d", result);
+    result = SDL_AtomicGet(&shared.seqlock.seq);
+    SDLTest_AssertCheck(result == 2 * MUTEX_LOOPS, "Check sequence, expected: %d, got: %d", 2 * MUTEX_LOOPS, result);
+    return TEST_COMPLETED;
+#else
+    SDLTest_Log("Sequence locks need native atomics, skipped");
+    return TEST_SKIPPED;
+#endif
+}
+
+/* ================= Test References ================== */
+
+/* Mutex test cases */
+static const SDLTest_TestCaseReference mutexTest1 =
+        { (SDLTest_TestCaseFp)mutex_lock, "mutex_lock", "Threads sharing an SDL_mutex, an SDL_SpinMutex and an SDL_cond", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference mutexTest2 =
+        { (SDLTest_TestCaseFp)mutex_semaphore, "mutex_semaphore", "Counts, timeouts and threads of an SDL_sem", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference mutexTest3 =
+        { (SDLTest_TestCaseFp)mutex_rwlock, "mutex_rwlock", "Readers and writers of an SDL_rwlock", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference mutexTest4 =
+        { (SDLTest_TestCaseFp)mutex_seqlock, "mutex_seqlock", "Readers and a writer of an SDL_SeqLock", TEST_ENABLED };
+
+/* Sequence of Mutex test cases */
+static const SDLTest_TestCaseReference *mutexTests[] =  {
+    &mutexTest1, &mutexTest2, &mutexTest3, &mutexTest4, NULL
+};
+
+/* Mutex test suite (global) */
+SDLTest_TestSuiteReference mutexTestSuite = {
+    "Mutex",
+    NULL,
+    mutexTests,
+    NULL
+};
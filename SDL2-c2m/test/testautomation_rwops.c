@@ -13,6 +13,10 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 #include <stdio.h>
+#if !defined(__WIN32__)
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 #include "SDL.h"
 #include "SDL_test.h"
@@ -699,6 +703,468 @@ rwops_testFileWriteReadEndian(void)
    return TEST_COMPLETED;
 }
 
+/**
+ * @brief Tests reading a file through a memory mapping.
+ *
+ * \sa SDL_RWFromFileMapped
+ * \sa SDL_RWMappedData
+ */
+int
+rwops_testFileMapped(void)
+{
+   SDL_RWops *rw;
+   const void *data;
+   size_t size = 0;
+   int result;
+
+   rw = SDL_RWFromFileMapped("rwops_nonexistent");
+   SDLTest_AssertCheck(rw == NULL, "Verify mapping a missing file returns NULL");
+
+   rw = SDL_RWFromFile(RWopsReadTestFilename, "r");
+   if (rw != NULL) {
+      data = SDL_RWMappedData(rw, &size);
+      SDLTest_AssertCheck(data == NULL, "Verify SDL_RWMappedData of a stdio stream returns NULL");
+      SDL_RWclose(rw);
+   }
+
+   rw = SDL_RWFromFileMapped(RWopsReadTestFilename);
+   SDLTest_AssertPass("Call to SDL_RWFromFileMapped() succeeded");
+   SDLTest_AssertCheck(rw != NULL, "Verify mapping a file does not return NULL");
+
+   /* Bail out if NULL */
+   if (rw == NULL) return TEST_ABORTED;
+
+   /* The file's bytes, without copying them */
+   data = SDL_RWMappedData(rw, &size);
+   SDLTest_AssertPass("Call to SDL_RWMappedData() succeeded");
+   SDLTest_AssertCheck(data != NULL, "Verify the mapped data is not NULL");
+   SDLTest_AssertCheck(
+       size == sizeof(RWopsHelloWorldTestString) - 1,
+       "Verify the mapped size, expected %i, got %i",
+       (int) sizeof(RWopsHelloWorldTestString) - 1,
+       (int) size);
+   if (data != NULL) {
+      SDLTest_AssertCheck(
+          SDL_memcmp(data, RWopsHelloWorldTestString, sizeof(RWopsHelloWorldTestString) - 1) == 0,
+          "Verify the mapped bytes match the file");
+   }
+
+   /* Run generic tests */
+   _testGenericRWopsValidations( rw, 0 );
+
+   /* Close handle */
+   result = SDL_RWclose(rw);
+   SDLTest_AssertPass("Call to SDL_RWclose() succeeded");
+   SDLTest_AssertCheck(result == 0, "Verify result value is 0; got: %d", result);
+
+   return TEST_COMPLETED;
+}
+
+/**
+ * @brief Tests a file descriptor stream, through its buffer and around it.
+ *
+ * \sa SDL_RWFromFileFD
+ * \sa SDL_RWreadAt
+ * \sa SDL_RWwriteAt
+ */
+int
+rwops_testFileFD(void)
+{
+#if defined(__WIN32__)
+   SDLTest_Log("SDL_RWFromFileFD is not supported on Windows");
+   return TEST_SKIPPED;
+#else
+   SDL_RWops *rw;
+   char big[100], buf[100];
+   size_t s;
+   Sint64 i;
+   int result, n;
+
+   rw = SDL_RWFromFileFD(RWopsWriteTestFilename, "x", 0);
+   SDLTest_AssertCheck(rw == NULL, "Verify an invalid mode returns NULL");
+
+   /* Write test, with a buffer smaller than some of the writes */
+   rw = SDL_RWFromFileFD(RWopsWriteTestFilename, "w+", 16);
+   SDLTest_AssertPass("Call to SDL_RWFromFileFD(..,\"w+\", 16) succeeded");
+   SDLTest_AssertCheck(rw != NULL, "Verify opening file with SDL_RWFromFileFD in write mode does not return NULL");
+
+   /* Bail out if NULL */
+   if (rw == NULL) return TEST_ABORTED;
+
+   SDLTest_AssertCheck(
+      rw->type == SDL_RWOPS_FD,
+      "Verify RWops type is SDL_RWOPS_FD; expected: %d, got: %d", SDL_RWOPS_FD, rw->type);
+
+   /* Run generic tests */
+   _testGenericRWopsValidations( rw, 1 );
+
+   /* Past the buffer's size, then back through it */
+   for (n = 0; n < (int) sizeof(big); n++) {
+      big[n] = (char) ('a' + n % 26);
+   }
+   i = SDL_RWseek(rw, 0, RW_SEEK_END);
+   s = SDL_RWwrite(rw, big, sizeof(big), 1);
+   SDLTest_AssertCheck(s == 1, "Verify writing %i bytes, expected 1 object, got %i", (int) sizeof(big), (int) s);
+   s = SDL_RWwrite(rw, "!", 1, 1);
+   SDLTest_AssertCheck(s == 1, "Verify writing 1 byte, expected 1 object, got %i", (int) s);
+   SDLTest_AssertCheck(
+      SDL_RWsize(rw) == i + (Sint64) sizeof(big) + 1,
+      "Verify size, expected %"SDL_PRIs64", got %"SDL_PRIs64, i + (Sint64) sizeof(big) + 1, SDL_RWsize(rw));
+   SDL_RWseek(rw, i, RW_SEEK_SET);
+   s = SDL_RWread(rw, buf, 1, sizeof(buf));
+   SDLTest_AssertCheck(s == sizeof(buf) && SDL_memcmp(buf, big, sizeof(big)) == 0, "Verify reading back %i bytes", (int) sizeof(buf));
+
+   /* Positional reads and writes leave the position be */
+   i = SDL_RWtell(rw);
+   s = SDL_RWwriteAt(rw, "XY", 2, 1, 0);
+   SDLTest_AssertCheck(s == 1, "Verify SDL_RWwriteAt, expected 1, got %i", (int) s);
+   s = SDL_RWreadAt(rw, buf, 1, 5, 0);
+   SDLTest_AssertCheck(s == 5 && SDL_memcmp(buf, "XYllo", 5) == 0, "Verify SDL_RWreadAt after SDL_RWwriteAt, expected 'XYllo'");
+   s = SDL_RWreadAt(rw, buf, 1, sizeof(buf), SDL_RWsize(rw) - 3);
+   SDLTest_AssertCheck(s == 3, "Verify SDL_RWreadAt at the end, expected 3, got %i", (int) s);
+   SDLTest_AssertCheck(SDL_RWtell(rw) == i, "Verify position, expected %"SDL_PRIs64", got %"SDL_PRIs64, i, SDL_RWtell(rw));
+
+   /* Close handle */
+   result = SDL_RWclose(rw);
+   SDLTest_AssertPass("Call to SDL_RWclose() succeeded");
+   SDLTest_AssertCheck(result == 0, "Verify result value is 0; got: %d", result);
+
+   /* Read test */
+   rw = SDL_RWFromFileFD(RWopsReadTestFilename, "r", 0);
+   SDLTest_AssertCheck(rw != NULL, "Verify opening file with SDL_RWFromFileFD in read mode does not return NULL");
+   if (rw == NULL) return TEST_ABORTED;
+   _testGenericRWopsValidations( rw, 0 );
+   result = SDL_RWclose(rw);
+   SDLTest_AssertCheck(result == 0, "Verify result value is 0; got: %d", result);
+
+   return TEST_COMPLETED;
+#endif
+}
+
+/**
+ * @brief Tests streams over both ends of a socket pair, and SDL_RWcopy into one.
+ *
+ * \sa SDL_RWFromSocket
+ * \sa SDL_RWcopy
+ */
+int
+rwops_testSocket(void)
+{
+#if defined(__WIN32__)
+   SDLTest_Log("SDL_RWFromSocket is not supported on Windows");
+   return TEST_SKIPPED;
+#else
+   SDL_RWops *a, *b, *src;
+   char buf[64];
+   int sv[2];
+   size_t s;
+   Sint64 copied;
+   int result;
+
+   result = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+   SDLTest_AssertCheck(result == 0, "Verify socketpair() succeeded; got: %d", result);
+   if (result != 0) return TEST_ABORTED;
+
+   a = SDL_RWFromSocket(sv[0], SDL_TRUE);
+   b = SDL_RWFromSocket(sv[1], SDL_TRUE);
+   SDLTest_AssertPass("Call to SDL_RWFromSocket() succeeded");
+   SDLTest_AssertCheck(a != NULL && b != NULL, "Verify opening both ends does not return NULL");
+
+   /* Bail out if NULL */
+   if (a == NULL || b == NULL) {
+      if (a != NULL) SDL_RWclose(a); else close(sv[0]);
+      if (b != NULL) SDL_RWclose(b); else close(sv[1]);
+      return TEST_ABORTED;
+   }
+   SDLTest_AssertCheck(
+      a->type == SDL_RWOPS_SOCKET,
+      "Verify RWops type is SDL_RWOPS_SOCKET; expected: %d, got: %d", SDL_RWOPS_SOCKET, a->type);
+
+   /* Either way, whole objects */
+   s = SDL_RWwrite(a, RWopsHelloWorldTestString, sizeof(RWopsHelloWorldTestString) - 1, 1);
+   SDLTest_AssertCheck(s == 1, "Verify writing to one end, expected 1 object, got %i", (int) s);
+   s = SDL_RWread(b, buf, sizeof(RWopsHelloWorldTestString) - 1, 1);
+   SDLTest_AssertCheck(
+      s == 1 && SDL_memcmp(buf, RWopsHelloWorldCompString, sizeof(RWopsHelloWorldCompString) - 1) == 0,
+      "Verify reading it from the other end");
+   s = SDL_RWwrite(b, RWopsAlphabetString, 1, 26);
+   SDLTest_AssertCheck(s == 26, "Verify writing back, expected 26 objects, got %i", (int) s);
+   s = SDL_RWread(a, buf, 2, 13);
+   SDLTest_AssertCheck(
+      s == 13 && SDL_memcmp(buf, RWopsAlphabetString, 26) == 0,
+      "Verify reading it back, expected 13 objects, got %i", (int) s);
+
+   /* No seeking, no size */
+   SDLTest_AssertCheck(SDL_RWseek(a, 0, RW_SEEK_SET) == -1, "Verify SDL_RWseek fails");
+   SDLTest_AssertCheck(SDL_RWsize(a) < 0, "Verify SDL_RWsize fails");
+
+   /* Copies from a file, and from memory */
+   src = SDL_RWFromFileFD(RWopsReadTestFilename, "r", 0);
+   SDLTest_AssertCheck(src != NULL, "Verify opening the file does not return NULL");
+   if (src != NULL) {
+      copied = SDL_RWcopy(a, src, -1);
+      SDLTest_AssertCheck(
+         copied == sizeof(RWopsHelloWorldTestString) - 1,
+         "Verify SDL_RWcopy from a file, expected %i, got %"SDL_PRIs64, (int) sizeof(RWopsHelloWorldTestString) - 1, copied);
+      SDL_RWclose(src);
+   }
+   src = SDL_RWFromConstMem(RWopsAlphabetString, sizeof(RWopsAlphabetString) - 1);
+   copied = SDL_RWcopy(a, src, 10);
+   SDLTest_AssertCheck(copied == 10, "Verify SDL_RWcopy of 10 bytes from memory, got %"SDL_PRIs64, copied);
+   SDL_RWclose(src);
+   s = SDL_RWread(b, buf, 1, sizeof(RWopsHelloWorldTestString) - 1 + 10);
+   SDLTest_AssertCheck(
+      s == sizeof(RWopsHelloWorldTestString) - 1 + 10 &&
+      SDL_memcmp(buf, RWopsHelloWorldCompString, sizeof(RWopsHelloWorldCompString) - 1) == 0 &&
+      SDL_memcmp(buf + sizeof(RWopsHelloWorldCompString) - 1, RWopsAlphabetString, 10) == 0,
+      "Verify reading both copies from the other end");
+
+   /* A closed connection is an error, not SIGPIPE */
+   result = SDL_RWclose(b);
+   SDLTest_AssertCheck(result == 0, "Verify closing one end, result 0; got: %d", result);
+   s = SDL_RWread(a, buf, 1, 1);
+   SDLTest_AssertCheck(s == 0, "Verify reading from a closed connection returns 0, got %i", (int) s);
+   s = SDL_RWwrite(a, buf, 1, 1);
+   if (s == 1) {
+      /* the first write can still make it to the kernel */
+      s = SDL_RWwrite(a, buf, 1, 1);
+   }
+   SDLTest_AssertCheck(s == 0, "Verify writing to a closed connection returns 0, got %i", (int) s);
+
+   result = SDL_RWclose(a);
+   SDLTest_AssertPass("Call to SDL_RWclose() succeeded");
+   SDLTest_AssertCheck(result == 0, "Verify result value is 0; got: %d", result);
+
+   return TEST_COMPLETED;
+#endif
+}
+
+/**
+ * @brief Tests reading lines and records, including ones longer than the buffer.
+ *
+ * \sa SDL_RWreaderCreate
+ * \sa SDL_RWreadRecord
+ * \sa SDL_RWreadLine
+ * \sa SDL_RWreaderDestroy
+ */
+int
+rwops_testReader(void)
+{
+   static const char lines[] = "one\r\ntwo\nthree";
+   static const char *expected[] = { "one", "two", "three" };
+   SDL_RWops *rw;
+   SDL_RWreader *reader;
+   const char *record;
+   char big[200];
+   size_t len;
+   size_t s;
+   int n;
+
+   /* Lines, out of memory */
+   rw = SDL_RWFromConstMem(lines, sizeof(lines) - 1);
+   reader = SDL_RWreaderCreate(rw, 0);
+   SDLTest_AssertPass("Call to SDL_RWreaderCreate() succeeded");
+   SDLTest_AssertCheck(reader != NULL, "Verify the reader is not NULL");
+   if (reader == NULL) {
+      SDL_RWclose(rw);
+      return TEST_ABORTED;
+   }
+   for (n = 0; n < 3; n++) {
+      record = SDL_RWreadLine(reader, &len);
+      SDLTest_AssertCheck(
+         record != NULL && len == SDL_strlen(expected[n]) && SDL_memcmp(record, expected[n], len) == 0,
+         "Verify line %i is '%s'", n, expected[n]);
+   }
+   record = SDL_RWreadLine(reader, &len);
+   SDLTest_AssertCheck(record == NULL, "Verify NULL after the last line");
+   SDL_RWreaderDestroy(reader);
+   SDL_RWclose(rw);
+
+   /* Records, out of a file through a small buffer */
+   rw = SDL_RWFromFile(RWopsWriteTestFilename, "w+");
+   SDLTest_AssertCheck(rw != NULL, "Verify opening file with SDL_RWFromFile does not return NULL");
+   if (rw == NULL) return TEST_ABORTED;
+   for (n = 0; n < (int) sizeof(big); n++) {
+      big[n] = (char) ('a' + n % 26);
+   }
+   s = SDL_RWwrite(rw, "ab,", 3, 1);
+   s += SDL_RWwrite(rw, big, sizeof(big), 1);
+   s += SDL_RWwrite(rw, ",,c", 3, 1);
+   SDLTest_AssertCheck(s == 3, "Verify writing the records, expected 3 objects, got %i", (int) s);
+   SDL_RWseek(rw, 0, RW_SEEK_SET);
+
+   reader = SDL_RWreaderCreate(rw, 16);
+   SDLTest_AssertCheck(reader != NULL, "Verify the reader is not NULL");
+   if (reader == NULL) {
+      SDL_RWclose(rw);
+      return TEST_ABORTED;
+   }
+   record = SDL_RWreadRecord(reader, ',', &len);
+   SDLTest_AssertCheck(record != NULL && len == 2 && SDL_memcmp(record, "ab", 2) == 0, "Verify record 'ab'");
+   record = SDL_RWreadRecord(reader, ',', &len);
+   SDLTest_AssertCheck(
+      record != NULL && len == sizeof(big) && SDL_memcmp(record, big, sizeof(big)) == 0,
+      "Verify a record of %i bytes through a 16 byte buffer, got %i", (int) sizeof(big), (int) len);
+   record = SDL_RWreadRecord(reader, ',', &len);
+   SDLTest_AssertCheck(record != NULL && len == 0, "Verify an empty record");
+   record = SDL_RWreadRecord(reader, ',', &len);
+   SDLTest_AssertCheck(record != NULL && len == 1 && *record == 'c', "Verify the last record 'c', without a delimiter");
+   record = SDL_RWreadRecord(reader, ',', &len);
+   SDLTest_AssertCheck(record == NULL, "Verify NULL after the last record");
+   SDL_RWreaderDestroy(reader);
+
+   /* Destroying it leaves the stream after the last record read */
+   SDL_RWseek(rw, 0, RW_SEEK_SET);
+   reader = SDL_RWreaderCreate(rw, 0);
+   SDLTest_AssertCheck(reader != NULL, "Verify the reader is not NULL");
+   if (reader != NULL) {
+      record = SDL_RWreadRecord(reader, ',', &len);
+      SDLTest_AssertCheck(record != NULL && len == 2, "Verify record 'ab'");
+      SDL_RWreaderDestroy(reader);
+      SDLTest_AssertCheck(SDL_RWtell(rw) == 3, "Verify position after the reader, expected 3, got %"SDL_PRIs64, SDL_RWtell(rw));
+   }
+
+   SDL_RWclose(rw);
+   SDLTest_AssertPass("Call to SDL_RWclose() succeeded");
+
+   return TEST_COMPLETED;
+}
+
+#if !defined(__WIN32__)
+
+#define RWOPS_JOURNAL_THREADS 4
+#define RWOPS_JOURNAL_RECORDS 500
+
+static const char *RWopsJournalFilename = "rwops_journal";
+
+typedef struct
+{
+   SDL_RWjournal *journal;
+   Uint32 thread;
+   int failed;
+} _rwopsJournalWriter;
+
+static int SDLCALL
+_rwopsJournalAppender(void *arg)
+{
+   _rwopsJournalWriter *w = (_rwopsJournalWriter *) arg;
+   Uint32 record[4];
+   Uint32 i;
+
+   for (i = 0; i < RWOPS_JOURNAL_RECORDS; i++) {
+      record[0] = 0x4A524E4C;
+      record[1] = w->thread;
+      record[2] = i;
+      record[3] = ~i;
+      if (SDL_RWjournalAppend(w->journal, record, sizeof(record)) != 0) {
+         w->failed++;
+      }
+   }
+   return 0;
+}
+
+/* Remove the segments, up to the first that isn't there */
+static int
+_rwopsJournalRemove(void)
+{
+   char path[64];
+   int n;
+
+   for (n = 0; ; n++) {
+      SDL_snprintf(path, sizeof(path), "%s.%06d", RWopsJournalFilename, n);
+      if (remove(path) != 0) {
+         return n;
+      }
+   }
+}
+
+#endif
+
+/**
+ * @brief Tests appending to a journal from several threads at once, across segments.
+ *
+ * \sa SDL_RWjournalOpen
+ * \sa SDL_RWjournalAppend
+ * \sa SDL_RWjournalClose
+ */
+int
+rwops_testJournal(void)
+{
+#if defined(__WIN32__)
+   SDLTest_Log("SDL_RWjournal is not supported on Windows");
+   return TEST_SKIPPED;
+#else
+   _rwopsJournalWriter writers[RWOPS_JOURNAL_THREADS];
+   SDL_Thread *threads[RWOPS_JOURNAL_THREADS];
+   Uint32 next[RWOPS_JOURNAL_THREADS];
+   Uint32 record[4];
+   SDL_RWjournal *journal;
+   SDL_RWops *rw;
+   char path[64];
+   int n, i, segments, total, misordered, bad;
+
+   /* Clean up from previous runs (if any) */
+   _rwopsJournalRemove();
+
+   journal = SDL_RWjournalOpen(RWopsJournalFilename, 4096, 0);
+   SDLTest_AssertPass("Call to SDL_RWjournalOpen() succeeded");
+   SDLTest_AssertCheck(journal != NULL, "Verify opening a journal does not return NULL");
+   if (journal == NULL) return TEST_ABORTED;
+
+   for (n = 0; n < RWOPS_JOURNAL_THREADS; n++) {
+      writers[n].journal = journal;
+      writers[n].thread = (Uint32) n;
+      writers[n].failed = 0;
+      threads[n] = SDL_CreateThread(_rwopsJournalAppender, "JournalAppender", &writers[n]);
+      SDLTest_AssertCheck(threads[n] != NULL, "Verify creating thread %i", n);
+   }
+   for (n = 0; n < RWOPS_JOURNAL_THREADS; n++) {
+      SDL_WaitThread(threads[n], NULL);
+      SDLTest_AssertCheck(writers[n].failed == 0, "Verify thread %i's appends succeeded, %i failed", n, writers[n].failed);
+   }
+   SDL_RWjournalClose(journal);
+   SDLTest_AssertPass("Call to SDL_RWjournalClose() succeeded");
+
+   /* Every record, each thread's in its order, across the segments */
+   SDL_memset(next, 0, sizeof(next));
+   total = misordered = bad = 0;
+   for (segments = 0; ; segments++) {
+      SDL_snprintf(path, sizeof(path), "%s.%06d", RWopsJournalFilename, segments);
+      rw = SDL_RWFromFile(path, "rb");
+      if (rw == NULL) {
+         break;
+      }
+      while (SDL_RWread(rw, record, sizeof(record), 1) == 1) {
+         if (record[0] == 0) {
+            continue;   /* the end of a segment a record didn't fit in */
+         }
+         i = (int) record[1];
+         if (record[0] != 0x4A524E4C || i >= RWOPS_JOURNAL_THREADS || record[3] != ~record[2]) {
+            bad++;
+            continue;
+         }
+         if (record[2] != next[i]) {
+            misordered++;
+         }
+         next[i] = record[2] + 1;
+         total++;
+      }
+      SDL_RWclose(rw);
+   }
+   SDLTest_AssertCheck(segments > 1, "Verify the journal rolled over, got %i segments", segments);
+   SDLTest_AssertCheck(bad == 0, "Verify no torn records, got %i", bad);
+   SDLTest_AssertCheck(
+      total == RWOPS_JOURNAL_THREADS * RWOPS_JOURNAL_RECORDS,
+      "Verify the number of records, expected %i, got %i", RWOPS_JOURNAL_THREADS * RWOPS_JOURNAL_RECORDS, total);
+   SDLTest_AssertCheck(misordered == 0, "Verify each thread's records are in order, %i weren't", misordered);
+
+   n = _rwopsJournalRemove();
+   SDLTest_AssertCheck(n == segments, "Verify removing the segments, expected %i, got %i", segments, n);
+
+   return TEST_COMPLETED;
+#endif
+}
+
 
 /* ================= Test References ================== */
 
@@ -733,10 +1199,26 @@ static const SDLTest_TestCaseReference rwopsTest9 =
 static const SDLTest_TestCaseReference rwopsTest10 =
         { (SDLTest_TestCaseFp)rwops_testCompareRWFromMemWithRWFromFile, "rwops_testCompareRWFromMemWithRWFromFile", "Compare RWFromMem and RWFromFile RWops for read and seek", TEST_ENABLED };
 
+static const SDLTest_TestCaseReference rwopsTest11 =
+        { (SDLTest_TestCaseFp)rwops_testFileMapped, "rwops_testFileMapped", "Tests reading a file through a memory mapping", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference rwopsTest12 =
+        { (SDLTest_TestCaseFp)rwops_testFileFD, "rwops_testFileFD", "Tests a file descriptor stream, through its buffer and around it", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference rwopsTest13 =
+        { (SDLTest_TestCaseFp)rwops_testSocket, "rwops_testSocket", "Tests streams over both ends of a socket pair", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference rwopsTest14 =
+        { (SDLTest_TestCaseFp)rwops_testReader, "rwops_testReader", "Tests reading lines and records, including ones longer than the buffer", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference rwopsTest15 =
+        { (SDLTest_TestCaseFp)rwops_testJournal, "rwops_testJournal", "Tests appending to a journal from several threads at once, across segments", TEST_ENABLED };
+
 /* Sequence of RWops test cases */
 static const SDLTest_TestCaseReference *rwopsTests[] =  {
     &rwopsTest1, &rwopsTest2, &rwopsTest3, &rwopsTest4, &rwopsTest5, &rwopsTest6,
-    &rwopsTest7, &rwopsTest8, &rwopsTest9, &rwopsTest10, NULL
+    &rwopsTest7, &rwopsTest8, &rwopsTest9, &rwopsTest10, &rwopsTest11,
+    &rwopsTest12, &rwopsTest13, &rwopsTest14, &rwopsTest15, NULL
 };
 
 /* RWops test suite (global) */
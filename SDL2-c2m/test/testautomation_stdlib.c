@@ -253,6 +253,133 @@ stdlib_getsetenv(void *arg)
   return TEST_COMPLETED;
 }
 
+#define STDLIB_SORT_COUNT 10000
+
+/* Ascending with a userdata of 1, descending with -1 */
+static int SDLCALL
+_stdlibCompareInt32(void *userdata, const void *a, const void *b)
+{
+  Sint32 x = *(const Sint32 *) a, y = *(const Sint32 *) b;
+  return (x < y ? -1 : x > y) * *(const int *) userdata;
+}
+
+/* Records sorted by key, ties keep nothing in particular */
+typedef struct
+{
+  Uint16 key;
+  Uint32 index;
+} _stdlibRecord;
+
+static int
+_stdlibCompareRecord(const void *a, const void *b)
+{
+  return (int) ((const _stdlibRecord *) a)->key - (int) ((const _stdlibRecord *) b)->key;
+}
+
+/**
+ * @brief Call to SDL_qsort, SDL_qsort_r and the typed sorts
+ */
+int
+stdlib_qsort(void *arg)
+{
+  Sint32 *ints = (Sint32 *) SDL_malloc(STDLIB_SORT_COUNT * sizeof(Sint32));
+  Sint64 *longs = (Sint64 *) SDL_malloc(STDLIB_SORT_COUNT * sizeof(Sint64));
+  _stdlibRecord *records = (_stdlibRecord *) SDL_malloc(STDLIB_SORT_COUNT * sizeof(_stdlibRecord));
+  void *pointers[64];
+  char bytes[64];
+  /* totalOrder: negative NaN, -inf, -1, -0, +0, 1, inf, NaN */
+  const Uint32 float_order[] = {
+    0xFFC00000, 0xFF800000, 0xBF800000, 0x80000000,
+    0x00000000, 0x3F800000, 0x7F800000, 0x7FC00000
+  };
+  const Uint64 double_order[] = {
+    0xFFF8000000000000ULL, 0xFFF0000000000000ULL, 0xBFF0000000000000ULL, 0x8000000000000000ULL,
+    0x0000000000000000ULL, 0x3FF0000000000000ULL, 0x7FF0000000000000ULL, 0x7FF8000000000000ULL
+  };
+  const int shuffle[] = { 5, 0, 7, 3, 1, 6, 4, 2 };
+  float floats[8];
+  double doubles[8];
+  Uint32 seed = 1, bits32;
+  Uint64 bits64;
+  int i, failed, direction;
+
+  if (ints == NULL || longs == NULL || records == NULL) {
+    SDL_free(ints);
+    SDL_free(longs);
+    SDL_free(records);
+    return TEST_ABORTED;
+  }
+  for (i = 0; i < STDLIB_SORT_COUNT; i++) {
+    seed = seed * 1103515245 + 12345;
+    ints[i] = (Sint32) seed;
+    longs[i] = ((Sint64) (Sint32) seed << 20) ^ i;
+    records[i].key = (Uint16) (seed >> 24);
+    records[i].index = i;
+  }
+
+  SDL_qsort_int32(ints, STDLIB_SORT_COUNT);
+  SDLTest_AssertPass("Call to SDL_qsort_int32()");
+  for (failed = 0, i = 1; i < STDLIB_SORT_COUNT; i++) {
+    failed += ints[i - 1] > ints[i];
+  }
+  SDLTest_AssertCheck(failed == 0, "Check order, expected: 0 out of order, got: %d", failed);
+
+  direction = -1;
+  SDL_qsort_r(ints, STDLIB_SORT_COUNT, sizeof(Sint32), _stdlibCompareInt32, &direction);
+  SDLTest_AssertPass("Call to SDL_qsort_r() descending");
+  for (failed = 0, i = 1; i < STDLIB_SORT_COUNT; i++) {
+    failed += ints[i - 1] < ints[i];
+  }
+  SDLTest_AssertCheck(failed == 0, "Check order, expected: 0 out of order, got: %d", failed);
+
+  SDL_qsort_int64(longs, STDLIB_SORT_COUNT);
+  SDLTest_AssertPass("Call to SDL_qsort_int64()");
+  for (failed = 0, i = 1; i < STDLIB_SORT_COUNT; i++) {
+    failed += longs[i - 1] > longs[i];
+  }
+  SDLTest_AssertCheck(failed == 0, "Check order, expected: 0 out of order, got: %d", failed);
+
+  SDL_qsort(records, STDLIB_SORT_COUNT, sizeof(_stdlibRecord), _stdlibCompareRecord);
+  SDLTest_AssertPass("Call to SDL_qsort() on %d byte records", (int) sizeof(_stdlibRecord));
+  for (failed = 0, i = 1; i < STDLIB_SORT_COUNT; i++) {
+    failed += records[i - 1].key > records[i].key;
+  }
+  SDLTest_AssertCheck(failed == 0, "Check order, expected: 0 out of order, got: %d", failed);
+  for (bits64 = 0, i = 0; i < STDLIB_SORT_COUNT; i++) {
+    bits64 += records[i].index;
+  }
+  SDLTest_AssertCheck(bits64 == (Uint64) STDLIB_SORT_COUNT * (STDLIB_SORT_COUNT - 1) / 2, "Check every record is still there");
+
+  for (i = 0; i < 8; i++) {
+    SDL_memcpy(&floats[i], &float_order[shuffle[i]], sizeof(float));
+    SDL_memcpy(&doubles[i], &double_order[shuffle[i]], sizeof(double));
+  }
+  SDL_qsort_float(floats, 8);
+  SDL_qsort_double(doubles, 8);
+  SDLTest_AssertPass("Call to SDL_qsort_float() and SDL_qsort_double() with zeros, infinities and NaNs");
+  for (i = 0; i < 8; i++) {
+    SDL_memcpy(&bits32, &floats[i], sizeof(float));
+    SDLTest_AssertCheck(bits32 == float_order[i], "Check float %d, expected: 0x%08x, got: 0x%08x", i, (unsigned) float_order[i], (unsigned) bits32);
+    SDL_memcpy(&bits64, &doubles[i], sizeof(double));
+    SDLTest_AssertCheck(bits64 == double_order[i], "Check double %d, expected: 0x%016" SDL_PRIx64 ", got: 0x%016" SDL_PRIx64, i, double_order[i], bits64);
+  }
+
+  for (i = 0; i < 64; i++) {
+    pointers[i] = &bytes[(i * 37) % 64];
+  }
+  SDL_qsort_pointer(pointers, 64);
+  SDLTest_AssertPass("Call to SDL_qsort_pointer()");
+  for (failed = 0, i = 0; i < 64; i++) {
+    failed += pointers[i] != &bytes[i];
+  }
+  SDLTest_AssertCheck(failed == 0, "Check order, expected: 0 out of place, got: %d", failed);
+
+  SDL_free(ints);
+  SDL_free(longs);
+  SDL_free(records);
+  return TEST_COMPLETED;
+}
+
 /* ================= Test References ================== */
 
 /* Standard C routine test cases */
@@ -265,9 +392,12 @@ static const SDLTest_TestCaseReference stdlibTest2 =
 static const SDLTest_TestCaseReference stdlibTest3 =
         { (SDLTest_TestCaseFp)stdlib_getsetenv, "stdlib_getsetenv", "Call to SDL_getenv and SDL_setenv", TEST_ENABLED };
 
+static const SDLTest_TestCaseReference stdlibTest4 =
+        { (SDLTest_TestCaseFp)stdlib_qsort, "stdlib_qsort", "Call to SDL_qsort, SDL_qsort_r and the typed sorts", TEST_ENABLED };
+
 /* Sequence of Standard C routine test cases */
 static const SDLTest_TestCaseReference *stdlibTests[] =  {
-    &stdlibTest1, &stdlibTest2, &stdlibTest3, NULL
+    &stdlibTest1, &stdlibTest2, &stdlibTest3, &stdlibTest4, NULL
 };
 
 /* Timer test suite (global) */
@@ -14,7 +14,9 @@ extern SDLTest_TestSuiteReference clipboardTestSuite;
 extern SDLTest_TestSuiteReference eventsTestSuite;
 extern SDLTest_TestSuiteReference keyboardTestSuite;
 extern SDLTest_TestSuiteReference mainTestSuite;
+extern SDLTest_TestSuiteReference metricsTestSuite;
 extern SDLTest_TestSuiteReference mouseTestSuite;
+extern SDLTest_TestSuiteReference mutexTestSuite;
 extern SDLTest_TestSuiteReference pixelsTestSuite;
 extern SDLTest_TestSuiteReference platformTestSuite;
 extern SDLTest_TestSuiteReference rectTestSuite;
@@ -35,7 +37,9 @@ SDLTest_TestSuiteReference *testSuites[] =  {
     &eventsTestSuite,
     &keyboardTestSuite,
     &mainTestSuite,
+    &metricsTestSuite,
     &mouseTestSuite,
+    &mutexTestSuite,
     &pixelsTestSuite,
     &platformTestSuite,
     &rectTestSuite,
@@ -0,0 +1,189 @@
+/*
+  Copyright (C) 1997-2016 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/* Benchmark of the alpha blending blitters: each blend is timed with the
+   blitters SDL picks for this CPU, then again with only the MMX & C ones
+   (SDL_BLIT_CPU_FEATURES=1), and their results are compared.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+
+#define WIDTH 1021  /* Not a multiple of a vector's pixels */
+#define HEIGHT 768
+#define BLITS 50
+
+typedef enum
+{
+    BLEND_PIXEL,
+    BLEND_SURFACE,
+    BLEND_SURFACE_KEY
+} BlendKind;
+
+typedef struct
+{
+    const char *name;
+    Uint32 src_format;
+    Uint32 dst_format;
+    BlendKind kind;
+    Uint8 alpha;
+} BlendTest;
+
+static const BlendTest tests[] = {
+    { "pixel alpha", SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_ARGB8888, BLEND_PIXEL, 255 },
+    { "pixel alpha", SDL_PIXELFORMAT_ABGR8888, SDL_PIXELFORMAT_ABGR8888, BLEND_PIXEL, 255 },
+    { "pixel alpha", SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_RGB565, BLEND_PIXEL, 255 },
+    { "pixel alpha", SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_RGB555, BLEND_PIXEL, 255 },
+    { "surface alpha", SDL_PIXELFORMAT_RGB888, SDL_PIXELFORMAT_RGB888, BLEND_SURFACE, 77 },
+    { "surface alpha", SDL_PIXELFORMAT_RGB888, SDL_PIXELFORMAT_ARGB8888, BLEND_SURFACE, 128 },
+    { "colorkey & alpha", SDL_PIXELFORMAT_RGB888, SDL_PIXELFORMAT_RGB888, BLEND_SURFACE_KEY, 77 },
+    { "colorkey & alpha", SDL_PIXELFORMAT_RGB888, SDL_PIXELFORMAT_ARGB8888, BLEND_SURFACE_KEY, 200 },
+};
+
+static SDL_Surface *
+CreateSurface(Uint32 format)
+{
+    SDL_Surface *surface;
+    int bpp, y;
+    Uint32 Rmask, Gmask, Bmask, Amask;
+
+    SDL_PixelFormatEnumToMasks(format, &bpp, &Rmask, &Gmask, &Bmask, &Amask);
+    surface = SDL_CreateRGBSurface(0, WIDTH, HEIGHT, bpp, Rmask, Gmask, Bmask, Amask);
+    if (!surface) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create surface: %s\n", SDL_GetError());
+        exit(1);
+    }
+    for (y = 0; y < surface->h; ++y) {
+        Uint8 *row = (Uint8 *) surface->pixels + y * surface->pitch;
+        int x;
+
+        for (x = 0; x < surface->w * surface->format->BytesPerPixel; ++x) {
+            row[x] = (Uint8) rand();
+        }
+    }
+    /* Copied, not blended */
+    SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+    return surface;
+}
+
+/* Transparent, opaque, keyed & translucent pixels in about equal numbers */
+static void
+MixPixels(SDL_Surface * surface, Uint32 key)
+{
+    Uint32 *pixels = (Uint32 *) surface->pixels;
+    int i;
+
+    for (i = 0; i < surface->w * surface->h; ++i) {
+        switch (rand() % 4) {
+        case 0:
+            pixels[i] &= ~surface->format->Amask;
+            break;
+        case 1:
+            pixels[i] |= surface->format->Amask;
+            break;
+        case 2:
+            pixels[i] = key;
+            break;
+        }
+    }
+}
+
+/* Blend src onto a copy of dst, BLITS times, with the blitters the CPU
+   features allow (NULL for all there are); returns the milliseconds a blit
+   took */
+static double
+Benchmark(SDL_Surface * src, SDL_Surface * dst, SDL_Surface * result, const char *features)
+{
+    Uint64 start, total = 0;
+    int i;
+
+    if (features) {
+        SDL_SetHintWithPriority("SDL_BLIT_CPU_FEATURES", features, SDL_HINT_OVERRIDE);
+    } else {
+        SDL_ClearHints();
+    }
+    /* A new blend mode maps the blit again, choosing its blitter */
+    SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_NONE);
+    SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_BLEND);
+    for (i = 0; i < BLITS; ++i) {
+        SDL_BlitSurface(dst, NULL, result, NULL);
+        start = SDL_GetPerformanceCounter();
+        SDL_BlitSurface(src, NULL, result, NULL);
+        total += SDL_GetPerformanceCounter() - start;
+    }
+    return (double) total * 1000.0 / SDL_GetPerformanceFrequency() / BLITS;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, failed = 0;
+
+    /* Enable standard application logging */
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO);
+
+    if (SDL_Init(0) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't initialize SDL: %s\n", SDL_GetError());
+        return (1);
+    }
+
+    SDL_Log("%dx%d, %d blits each\n", WIDTH, HEIGHT, BLITS);
+    for (i = 0; i < SDL_arraysize(tests); ++i) {
+        const BlendTest *test = &tests[i];
+        SDL_Surface *src = CreateSurface(test->src_format);
+        SDL_Surface *dst = CreateSurface(test->dst_format);
+        SDL_Surface *fast = CreateSurface(test->dst_format);
+        SDL_Surface *slow = CreateSurface(test->dst_format);
+        Uint32 key = ((Uint32 *) src->pixels)[0];
+        double fast_ms, slow_ms;
+        int y, same = 1;
+
+        if (test->kind == BLEND_PIXEL) {
+            MixPixels(src, key);
+        } else {
+            SDL_SetSurfaceAlphaMod(src, test->alpha);
+            if (test->kind == BLEND_SURFACE_KEY) {
+                MixPixels(src, key);
+                SDL_SetColorKey(src, SDL_TRUE, key);
+            }
+        }
+
+        fast_ms = Benchmark(src, dst, fast, NULL);
+        slow_ms = Benchmark(src, dst, slow, "1");
+        for (y = 0; y < HEIGHT; ++y) {
+            if (SDL_memcmp((Uint8 *) fast->pixels + y * fast->pitch,
+                           (Uint8 *) slow->pixels + y * slow->pitch,
+                           WIDTH * fast->format->BytesPerPixel) != 0) {
+                same = 0;
+                failed = 1;
+                break;
+            }
+        }
+        SDL_Log("%-16s %s -> %s (alpha %d): %.3f ms, %.3f ms before (%.1fx)%s\n",
+                test->name, SDL_GetPixelFormatName(test->src_format),
+                SDL_GetPixelFormatName(test->dst_format), test->alpha,
+                fast_ms, slow_ms, fast_ms > 0.0 ? slow_ms / fast_ms : 0.0,
+                same ? "" : ", DIFFERENT RESULTS");
+
+        SDL_FreeSurface(src);
+        SDL_FreeSurface(dst);
+        SDL_FreeSurface(fast);
+        SDL_FreeSurface(slow);
+    }
+
+    SDL_Quit();
+    return (failed);
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,83 @@
+#!/bin/sh
+# Throughput benchmark: generate c2m programs of each size in CONFIGS, as
+# "functions:calls:modules:depth" ( library functions spread over the
+# modules, call sites in main nested in that many while loops ), then
+# translate each with --emit-only and compile it fully.  One CSV row per
+# program goes to OUT: lines per second of the frontend, peak RSS of the
+# compiler and of the C compiler, & the time spent waiting on the backend.
+set -e
+
+C2M="$(cd "$(dirname "$0")/.." && pwd)/c2m"
+WORK="${TMPDIR:-/tmp}/c2m-corpus.$$"
+CONFIGS="${CONFIGS:-100:1000:4:0 1000:10000:16:2 10000:100000:64:4}"
+OUT="${OUT:-bench-results.csv}"
+
+mkdir -p "$WORK"
+trap 'rm -rf "$WORK"' EXIT
+printf 'name = "Corpus"\nversion = "0.1"\ncreator = "bench"\nlibrary = FALSE\n' \
+	> "$WORK/c2m.config"
+
+# Value of a --time-report line, $1 is its name.
+report() {
+	awk -v name="$1" 'index($0, "  " name " ") == 1 {
+		sub("^  " name " +", ""); print $1; exit
+	}' "$WORK/report"
+}
+
+echo "functions,calls,modules,depth,lines,frontend_seconds,lines_per_second,peak_rss_kib,backend_seconds,backend_rss_kib" \
+	> "$OUT"
+for config in $CONFIGS; do
+	IFS=: read functions calls modules depth <<-END
+	$config
+	END
+	rm -rf "$WORK/src" "$WORK/lib" "$WORK/.c2m-cache"
+	mkdir -p "$WORK/src" "$WORK/lib"
+	cp "$(dirname "$0")/../lib/io.c2m" "$WORK/lib/"
+	awk -v n="$functions" -v calls="$calls" -v k="$modules" \
+		-v depth="$depth" -v dir="$WORK" 'BEGIN {
+		per = int((n + k - 1) / k)
+		for(m = 0; m < k; m++) {
+			file = dir "/lib/m" m ".c2m"
+			for(f = 0; f < per && m * per + f < n; f++) {
+				print "f" f "(Sint32 n) {" > file
+				print "\tSint32 local = " f > file
+				print "\tio.print(\"m" m ".f" f " \" + n + \" \" + local)" > file
+				print "}\n" > file
+			}
+			close(file)
+		}
+		file = dir "/src/main.c2m"
+		print "main(list_t args) {" > file
+		indent = "\t"
+		for(d = 0; d < depth; d++) {
+			print indent "while {" > file
+			indent = indent "\t"
+		}
+		for(c = 0; c < calls; c++) {
+			f = c % n
+			print indent "m" int(f / per) ".f" f % per "(" c ")" > file
+		}
+		print indent "exit" > file
+		for(d = depth; d > 0; d--) {
+			indent = substr(indent, 2)
+			print indent "}" > file
+		}
+		print "}" > file
+	}'
+	lines=$(cat "$WORK/src/main.c2m" "$WORK"/lib/*.c2m | wc -l)
+	start=$(date +%s%N)
+	(cd "$WORK" && "$C2M" --emit-only --no-cache --time-report > report)
+	end=$(date +%s%N)
+	rss=$(report "peak RSS")
+	(cd "$WORK" && "$C2M" --no-cache --time-report > report)
+	backend=$(report backend)
+	backend_rss=$(report "backend RSS")
+	awk -v f="$functions" -v c="$calls" -v k="$modules" -v d="$depth" \
+		-v lines="$lines" -v ns=$((end - start)) -v rss="$rss" \
+		-v backend="$backend" -v backend_rss="$backend_rss" 'BEGIN {
+		s = ns / 1e9
+		printf "%d,%d,%d,%d,%d,%.4f,%.0f,%d,%.4f,%d\n", f, c, k, d,
+			lines, s, lines / s, rss, backend / 1000, backend_rss
+	}' >> "$OUT"
+	tail -n 1 "$OUT"
+done
@@ -0,0 +1,34 @@
+#!/bin/sh
+# Frontend scaling check: translate generated programs from 1K to 1M lines
+# with --emit-only and print lines per second, which should stay flat if
+# compile time grows linearly with input size.
+set -e
+
+C2M="$(cd "$(dirname "$0")/.." && pwd)/c2m"
+WORK="${TMPDIR:-/tmp}/c2m-scaling.$$"
+SIZES="${SIZES:-1000 10000 100000 1000000}"
+
+mkdir -p "$WORK/src" "$WORK/lib"
+trap 'rm -rf "$WORK"' EXIT
+cp "$(dirname "$0")/../lib/io.c2m" "$WORK/lib/"
+printf 'name = "Scaling"\nversion = "0.1"\ncreator = "bench"\nlibrary = FALSE\n' \
+	> "$WORK/c2m.config"
+
+echo "lines,seconds,lines_per_second"
+for n in $SIZES; do
+	awk -v n="$n" 'BEGIN {
+		print "main(list_t args) {"
+		for(i = 0; i < n; i += 4) {
+			print "\t// statement " i
+			print "\tint32_t v" i " = " i
+			print "\tio.print(\"line " i "\")"
+			print "\tprintf(\"%d\\n\", v" i ");"
+		}
+		print "}"
+	}' > "$WORK/src/main.c2m"
+	start=$(date +%s%N)
+	(cd "$WORK" && "$C2M" --emit-only --no-cache > /dev/null)
+	end=$(date +%s%N)
+	awk -v n="$n" -v ns=$((end - start)) \
+		'BEGIN { s = ns / 1e9; printf "%d,%.4f,%.0f\n", n, s, n / s }'
+done
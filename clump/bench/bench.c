@@ -0,0 +1,633 @@
+/*
+ * bench.c	Microbenchmarks for clump containers
+ *
+ * Copyright (c) 2012  Douglas P Lau
+ */
+/** \file
+ *
+ * Each container (hash, rhash, rhashf, fhash, tree and btree) is filled with
+ * keys of each type (int, str or bytes) for each size, and these are timed:
+ *
+ *	insert	add every key (in random order) to an empty set
+ *	hit	look up every key (in another random order)
+ *	miss	look up as many keys which aren't in the set
+ *	iterate	visit every key
+ *	remove	remove every key (in random order)
+ *
+ * Small sizes are repeated until at least min_ops operations are timed, and
+ * the fastest repeat is kept.  Results go to stdout as CSV (or JSON), one
+ * row per container, key type, size and operation, with the nanoseconds per
+ * operation and the bytes held per key (from the container's stats).
+ *
+ * Int keys are passed as values to hash, tree and btree (with their int
+ * hash and compare functions) and as 8-byte keys to rhash and fhash, which
+ * is how each is meant to be used.  rhashf is rhash with a Bloom filter in
+ * front (10 bits per key).  Str keys are NUL terminated, bytes keys are 16
+ * bytes.
+ *
+ * Usage: bench [-c containers] [-k keys] [-n sizes] [-m min_ops] [-j]
+ *
+ * Lists are comma separated, sizes may have a K or M suffix (1K to 100M).
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "clump.h"
+
+/** Length of a bytes key */
+#define BENCH_BYTES	16
+
+/** Length of a str key buffer */
+#define BENCH_STR	24
+
+/** Key types */
+enum bench_key { KEY_INT, KEY_STR, KEY_BYTES, N_KEYS };
+
+static const char *KEY_NAMES[] = { "int", "str", "bytes" };
+
+/** Operations */
+enum bench_op { OP_INSERT, OP_HIT, OP_MISS, OP_ITERATE, OP_REMOVE, N_OPS };
+
+static const char *OP_NAMES[] = { "insert", "hit", "miss", "iterate",
+	"remove" };
+
+/** Get a monotonic time in nanoseconds.
+ *
+ * The same clock is used for every measurement on a platform: the
+ * performance counter on Windows, CLOCK_MONOTONIC everywhere else.
+ */
+static uint64_t bench_now(void) {
+#ifdef _WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER t;
+	if(freq.QuadPart == 0)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t);
+	return (uint64_t)(t.QuadPart / freq.QuadPart) * 1000000000 +
+		(uint64_t)(t.QuadPart % freq.QuadPart) * 1000000000 /
+		freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/** Get the next pseudo-random number (xorshift64*).
+ */
+static uint64_t bench_random(uint64_t *state) {
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/** Shuffle an array of keys.
+ */
+static void bench_shuffle(const void **keys, uint32_t n, uint64_t seed) {
+	uint64_t state = seed | 1;
+	uint32_t i;
+	for(i = n; i > 1; i--) {
+		uint32_t j = bench_random(&state) % i;
+		const void *k = keys[i - 1];
+		keys[i - 1] = keys[j];
+		keys[j] = k;
+	}
+}
+
+/** Hash function for bytes keys */
+static uint32_t bench_hash_bytes(const void *key) {
+	return cl_hash_bytes(key, BENCH_BYTES, 0);
+}
+
+/** Compare function for str keys */
+static cl_compare_t bench_compare_str(const void *k0, const void *k1) {
+	int c = strcmp(k0, k1);
+	return c < 0 ? CL_LESS : c > 0 ? CL_GREATER : CL_EQUAL;
+}
+
+/** Compare function for bytes keys */
+static cl_compare_t bench_compare_bytes(const void *k0, const void *k1) {
+	int c = memcmp(k0, k1, BENCH_BYTES);
+	return c < 0 ? CL_LESS : c > 0 ? CL_GREATER : CL_EQUAL;
+}
+
+/** Keys of one type and size.
+ *
+ * Key i of the set is made from 2 * i + 1 and a missing key from 2 * i + 2,
+ * so no missing key is in the set.
+ */
+struct bench_keys {
+	enum bench_key	type;
+	uint32_t	n;
+	uint64_t	*ints;		/* int values (set, then missing) */
+	char		*data;		/* str or bytes keys */
+	const void	**set;		/* keys in the set */
+	const void	**miss;		/* keys not in the set */
+};
+
+/** Make the data of key v.
+ */
+static void bench_key_data(enum bench_key type, char *p, uint64_t v) {
+	if(type == KEY_STR)
+		snprintf(p, BENCH_STR, "key:%llu", (unsigned long long)v);
+	else {
+		uint64_t w = cl_hash_mix(v);
+		memcpy(p, &v, 8);
+		memcpy(p + 8, &w, 8);
+	}
+}
+
+/** Create keys of one type and size.
+ *
+ * @param direct Pass int keys as values instead of pointers.
+ */
+static void bench_keys_init(struct bench_keys *k, enum bench_key type,
+	uint32_t n, bool direct)
+{
+	size_t sz = type == KEY_STR ? BENCH_STR : BENCH_BYTES;
+	uint32_t i;
+
+	k->type = type;
+	k->n = n;
+	k->ints = malloc(sizeof(uint64_t) * 2 * n);
+	k->data = type == KEY_INT ? NULL : malloc(sz * 2 * n);
+	k->set = malloc(sizeof(void *) * n);
+	k->miss = malloc(sizeof(void *) * n);
+	if(!k->ints || (type != KEY_INT && !k->data) || !k->set || !k->miss) {
+		fprintf(stderr, "bench: out of memory for %u keys\n", n);
+		exit(1);
+	}
+	for(i = 0; i < 2 * n; i++) {
+		const void **slot = i < n ? &k->set[i] : &k->miss[i - n];
+		uint64_t v = i < n ? 2 * (uint64_t)i + 1
+		                   : 2 * (uint64_t)(i - n) + 2;
+		k->ints[i] = v;
+		if(type == KEY_INT) {
+			*slot = direct ? (const void *)(uintptr_t)v
+			               : &k->ints[i];
+		} else {
+			bench_key_data(type, k->data + sz * i, v);
+			*slot = k->data + sz * i;
+		}
+	}
+}
+
+/** Free keys.
+ */
+static void bench_keys_free(struct bench_keys *k) {
+	free(k->ints);
+	free(k->data);
+	free(k->set);
+	free(k->miss);
+}
+
+/** Container operations, all on a set of one key type.
+ */
+struct bench_ops {
+	const char	*name;
+	bool		direct;		/* int keys passed as values */
+	void *(*create) (enum bench_key type);
+	void (*destroy) (void *c);
+	void (*add) (void *c, const void *key);
+	bool (*contains) (void *c, const void *key);
+	void (*remove) (void *c, const void *key);
+	uint32_t (*iterate) (void *c);
+	void (*stats) (void *c, struct cl_pool_stats *stats);
+};
+
+static void *hash_create(enum bench_key type) {
+	if(type == KEY_INT)
+		return cl_hash_create_set(cl_hash_int, cl_compare_int);
+	if(type == KEY_STR)
+		return cl_hash_create_set(cl_hash_str, bench_compare_str);
+	return cl_hash_create_set(bench_hash_bytes, bench_compare_bytes);
+}
+
+static void hash_destroy(void *c) {
+	cl_hash_destroy(c);
+}
+
+static void hash_add(void *c, const void *key) {
+	cl_hash_add(c, key);
+}
+
+static bool hash_contains(void *c, const void *key) {
+	return cl_hash_contains(c, key);
+}
+
+static void hash_remove(void *c, const void *key) {
+	cl_hash_remove(c, key);
+}
+
+static uint32_t hash_iterate(void *c) {
+	struct cl_hash_iterator it;
+	uint32_t n = 0;
+	cl_hash_iterator_init(&it, c);
+	while(cl_hash_iterator_next(&it))
+		n++;
+	return n;
+}
+
+static void hash_stats(void *c, struct cl_pool_stats *stats) {
+	cl_hash_stats(c, stats);
+}
+
+static uint16_t bench_key_bytes(enum bench_key type) {
+	return type == KEY_INT ? sizeof(uint64_t) : type == KEY_STR ? 0
+		: BENCH_BYTES;
+}
+
+static void *rhash_create(enum bench_key type) {
+	return cl_rhash_create_set(bench_key_bytes(type));
+}
+
+static void *rhashf_create(enum bench_key type) {
+	struct cl_rhash *hash = cl_rhash_create_set(bench_key_bytes(type));
+	cl_rhash_filter(hash, 10);
+	return hash;
+}
+
+static void rhash_destroy(void *c) {
+	cl_rhash_destroy(c);
+}
+
+static void rhash_add(void *c, const void *key) {
+	cl_rhash_add(c, key);
+}
+
+static bool rhash_contains(void *c, const void *key) {
+	return cl_rhash_contains(c, key);
+}
+
+static void rhash_remove(void *c, const void *key) {
+	cl_rhash_remove(c, key);
+}
+
+static uint32_t rhash_iterate(void *c) {
+	struct cl_rhash_iterator it;
+	const void *key;
+	uint32_t n = 0;
+	CL_RHASH_FOREACH(it, c, key)
+		n++;
+	return n;
+}
+
+static void rhash_stats(void *c, struct cl_pool_stats *stats) {
+	cl_rhash_stats(c, stats);
+}
+
+static void *fhash_create(enum bench_key type) {
+	return cl_fhash_create_set(bench_key_bytes(type));
+}
+
+static void fhash_destroy(void *c) {
+	cl_fhash_destroy(c);
+}
+
+static void fhash_add(void *c, const void *key) {
+	cl_fhash_add(c, key);
+}
+
+static bool fhash_contains(void *c, const void *key) {
+	return cl_fhash_contains(c, key);
+}
+
+static void fhash_remove(void *c, const void *key) {
+	cl_fhash_remove(c, key);
+}
+
+static uint32_t fhash_iterate(void *c) {
+	struct cl_fhash_iterator it;
+	const void *key;
+	uint32_t n = 0;
+	CL_FHASH_FOREACH(it, c, key)
+		n++;
+	return n;
+}
+
+static void fhash_stats(void *c, struct cl_pool_stats *stats) {
+	cl_fhash_stats(c, stats);
+}
+
+static void *tree_create(enum bench_key type) {
+	if(type == KEY_INT)
+		return cl_tree_create_set(cl_compare_int);
+	if(type == KEY_STR)
+		return cl_tree_create_set(bench_compare_str);
+	return cl_tree_create_set(bench_compare_bytes);
+}
+
+static void tree_destroy(void *c) {
+	cl_tree_destroy(c);
+}
+
+static void tree_add(void *c, const void *key) {
+	cl_tree_add(c, key);
+}
+
+static bool tree_contains(void *c, const void *key) {
+	return cl_tree_contains(c, key);
+}
+
+static void tree_remove(void *c, const void *key) {
+	cl_tree_remove_key(c, key);
+}
+
+static uint32_t tree_iterate(void *c) {
+	struct cl_tree_iterator it;
+	const void *key;
+	uint32_t n = 0;
+	CL_TREE_FOREACH(it, c, key)
+		n++;
+	return n;
+}
+
+static void tree_stats(void *c, struct cl_pool_stats *stats) {
+	cl_tree_stats(c, stats);
+}
+
+static void *btree_create(enum bench_key type) {
+	if(type == KEY_INT)
+		return cl_btree_create_set_int();
+	if(type == KEY_STR)
+		return cl_btree_create_set(bench_compare_str);
+	return cl_btree_create_set(bench_compare_bytes);
+}
+
+static void btree_destroy(void *c) {
+	cl_btree_destroy(c);
+}
+
+static void btree_add(void *c, const void *key) {
+	cl_btree_add(c, key);
+}
+
+static bool btree_contains(void *c, const void *key) {
+	return cl_btree_contains(c, key);
+}
+
+static void btree_remove(void *c, const void *key) {
+	cl_btree_remove_key(c, key);
+}
+
+static uint32_t btree_iterate(void *c) {
+	struct cl_btree_iterator it;
+	const void *key;
+	uint32_t n = 0;
+	CL_BTREE_FOREACH(it, c, key)
+		n++;
+	return n;
+}
+
+static void btree_stats(void *c, struct cl_pool_stats *stats) {
+	cl_btree_stats(c, stats);
+}
+
+static const struct bench_ops CONTAINERS[] = {
+	{ "hash", true, hash_create, hash_destroy, hash_add, hash_contains,
+	  hash_remove, hash_iterate, hash_stats },
+	{ "rhash", false, rhash_create, rhash_destroy, rhash_add,
+	  rhash_contains, rhash_remove, rhash_iterate, rhash_stats },
+	{ "rhashf", false, rhashf_create, rhash_destroy, rhash_add,
+	  rhash_contains, rhash_remove, rhash_iterate, rhash_stats },
+	{ "fhash", false, fhash_create, fhash_destroy, fhash_add,
+	  fhash_contains, fhash_remove, fhash_iterate, fhash_stats },
+	{ "tree", true, tree_create, tree_destroy, tree_add, tree_contains,
+	  tree_remove, tree_iterate, tree_stats },
+	{ "btree", true, btree_create, btree_destroy, btree_add,
+	  btree_contains, btree_remove, btree_iterate, btree_stats },
+};
+
+#define N_CONTAINERS (sizeof(CONTAINERS) / sizeof(CONTAINERS[0]))
+
+/** Benchmark options */
+struct bench_config {
+	bool		containers[N_CONTAINERS];
+	bool		keys[N_KEYS];
+	uint32_t	sizes[32];
+	uint32_t	n_sizes;
+	uint64_t	min_ops;
+	bool		json;
+	uint32_t	n_rows;
+};
+
+/** Keep a result from being optimized away */
+static volatile uint32_t bench_sink;
+
+/** Print one result.
+ */
+static void bench_print(struct bench_config *cfg, const char *container,
+	enum bench_key type, uint32_t n, enum bench_op op, uint64_t ns,
+	double bytes)
+{
+	double ns_op = (double)ns / n;
+	if(cfg->json) {
+		printf("%s\n  {\"container\": \"%s\", \"key\": \"%s\", "
+			"\"size\": %u, \"op\": \"%s\", \"ns_per_op\": %.2f, "
+			"\"bytes_per_key\": %.1f}", cfg->n_rows ? "," : "",
+			container, KEY_NAMES[type], n, OP_NAMES[op], ns_op,
+			bytes);
+	} else {
+		printf("%s,%s,%u,%s,%.2f,%.1f\n", container, KEY_NAMES[type],
+			n, OP_NAMES[op], ns_op, bytes);
+	}
+	cfg->n_rows++;
+	fflush(stdout);
+}
+
+/** Run all operations on one container, key type and size.
+ */
+static void bench_run(struct bench_config *cfg, const struct bench_ops *ops,
+	enum bench_key type, uint32_t n)
+{
+	struct bench_keys k;
+	const void **order;
+	uint64_t best[N_OPS];
+	uint64_t reps, r;
+	double bytes = 0;
+	uint32_t i, op;
+
+	bench_keys_init(&k, type, n, ops->direct);
+	order = malloc(sizeof(void *) * n);
+	if(!order) {
+		fprintf(stderr, "bench: out of memory for %u keys\n", n);
+		exit(1);
+	}
+	reps = (cfg->min_ops + n - 1) / n;
+	for(op = 0; op < N_OPS; op++)
+		best[op] = UINT64_MAX;
+	for(r = 0; r < reps; r++) {
+		void *c = ops->create(type);
+		uint64_t t[8];
+		uint32_t found = 0;
+
+		memcpy(order, k.set, sizeof(void *) * n);
+		bench_shuffle(order, n, r * 2 + 1);
+		t[0] = bench_now();
+		for(i = 0; i < n; i++)
+			ops->add(c, order[i]);
+		t[1] = bench_now();
+		bench_shuffle(order, n, r * 2 + 2);
+		t[2] = bench_now();
+		for(i = 0; i < n; i++)
+			found += ops->contains(c, order[i]);
+		t[3] = bench_now();
+		for(i = 0; i < n; i++)
+			found += ops->contains(c, k.miss[i]);
+		t[4] = bench_now();
+		found += ops->iterate(c);
+		t[5] = bench_now();
+		if(r == 0) {
+			struct cl_pool_stats stats;
+			memset(&stats, 0, sizeof(stats));
+			ops->stats(c, &stats);
+			bytes = (double)stats.n_bytes / n;
+			if(found != 2 * n) {
+				fprintf(stderr, "bench: %s %s %u: found %u "
+					"keys, expected %u\n", ops->name,
+					KEY_NAMES[type], n, found, 2 * n);
+				exit(1);
+			}
+		}
+		bench_shuffle(order, n, r * 2 + 3);
+		t[6] = bench_now();
+		for(i = 0; i < n; i++)
+			ops->remove(c, order[i]);
+		t[7] = bench_now();
+		bench_sink += found;
+		ops->destroy(c);
+		if(t[1] - t[0] < best[OP_INSERT])
+			best[OP_INSERT] = t[1] - t[0];
+		if(t[3] - t[2] < best[OP_HIT])
+			best[OP_HIT] = t[3] - t[2];
+		if(t[4] - t[3] < best[OP_MISS])
+			best[OP_MISS] = t[4] - t[3];
+		if(t[5] - t[4] < best[OP_ITERATE])
+			best[OP_ITERATE] = t[5] - t[4];
+		if(t[7] - t[6] < best[OP_REMOVE])
+			best[OP_REMOVE] = t[7] - t[6];
+	}
+	for(op = 0; op < N_OPS; op++)
+		bench_print(cfg, ops->name, type, n, op, best[op], bytes);
+	free(order);
+	bench_keys_free(&k);
+}
+
+/** Parse a size, with a K or M suffix.
+ */
+static uint32_t bench_parse_size(const char *s) {
+	char *end;
+	unsigned long long v = strtoull(s, &end, 10);
+	if(*end == 'K' || *end == 'k')
+		v *= 1000, end++;
+	else if(*end == 'M' || *end == 'm')
+		v *= 1000000, end++;
+	if((*end != '\0' && *end != ',') || v == 0 || v > 100000000) {
+		fprintf(stderr, "bench: bad size \"%s\" (1 to 100M)\n", s);
+		exit(1);
+	}
+	return v;
+}
+
+/** Parse a list of names, setting a flag for each one.
+ */
+static void bench_parse_names(const char *list, const char **names,
+	uint32_t n_names, bool *flags)
+{
+	const char *p = list;
+	memset(flags, 0, sizeof(bool) * n_names);
+	while(*p) {
+		size_t len = strcspn(p, ",");
+		uint32_t i;
+		for(i = 0; i < n_names; i++) {
+			if(strlen(names[i]) == len &&
+			   !strncmp(p, names[i], len))
+				break;
+		}
+		if(i == n_names) {
+			fprintf(stderr, "bench: unknown name \"%.*s\"\n",
+				(int)len, p);
+			exit(1);
+		}
+		flags[i] = true;
+		p += len;
+		if(*p == ',')
+			p++;
+	}
+}
+
+/** Print usage and exit.
+ */
+static void bench_usage(void) {
+	fprintf(stderr, "usage: bench [-c hash,rhash,rhashf,fhash,tree,btree] "
+		"[-k int,str,bytes]\n"
+		"             [-n 1K,10K,100K,1M] [-m min_ops] [-j]\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+	static const char *sizes = "1K,10K,100K,1M";
+	const char *names[N_CONTAINERS];
+	struct bench_config cfg;
+	const char *p;
+	uint32_t c, k, s;
+	int i;
+
+	memset(&cfg, 0, sizeof(cfg));
+	for(c = 0; c < N_CONTAINERS; c++) {
+		names[c] = CONTAINERS[c].name;
+		cfg.containers[c] = true;
+	}
+	for(k = 0; k < N_KEYS; k++)
+		cfg.keys[k] = true;
+	cfg.min_ops = 1000000;
+	for(i = 1; i < argc; i++) {
+		if(!strcmp(argv[i], "-j"))
+			cfg.json = true;
+		else if(i + 1 == argc)
+			bench_usage();
+		else if(!strcmp(argv[i], "-c"))
+			bench_parse_names(argv[++i], names, N_CONTAINERS,
+				cfg.containers);
+		else if(!strcmp(argv[i], "-k"))
+			bench_parse_names(argv[++i], KEY_NAMES, N_KEYS,
+				cfg.keys);
+		else if(!strcmp(argv[i], "-n"))
+			sizes = argv[++i];
+		else if(!strcmp(argv[i], "-m"))
+			cfg.min_ops = strtoull(argv[++i], NULL, 10);
+		else
+			bench_usage();
+	}
+	for(p = sizes; *p; p += strcspn(p, ",") + (p[strcspn(p, ",")] == ','))
+	{
+		if(cfg.n_sizes == sizeof(cfg.sizes) / sizeof(cfg.sizes[0]))
+			bench_usage();
+		cfg.sizes[cfg.n_sizes++] = bench_parse_size(p);
+	}
+	if(cfg.json)
+		printf("[");
+	else
+		printf("container,key,size,op,ns_per_op,bytes_per_key\n");
+	for(c = 0; c < N_CONTAINERS; c++) {
+		if(!cfg.containers[c])
+			continue;
+		for(k = 0; k < N_KEYS; k++) {
+			if(!cfg.keys[k])
+				continue;
+			for(s = 0; s < cfg.n_sizes; s++)
+				bench_run(&cfg, &CONTAINERS[c], k,
+					cfg.sizes[s]);
+		}
+	}
+	if(cfg.json)
+		printf("\n]\n");
+	return 0;
+}
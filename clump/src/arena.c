@@ -0,0 +1,306 @@
+/*
+ * arena.c	A memory arena (region allocator)
+ *
+ * Copyright (c) 2012  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_arena_create		Create a memory arena
+ *	cl_arena_create_with_alloc Create a memory arena with an allocator
+ *	cl_arena_destroy	Destroy a memory arena
+ *	cl_arena_alloc		Allocate memory from an arena
+ *	cl_arena_mark		Get a mark of allocated memory
+ *	cl_arena_release	Release memory allocated after a mark
+ *	cl_arena_reset		Release all memory of an arena
+ *	cl_arena_shrink		Free unused chunks of an arena
+ *	cl_arena_stats		Add up memory statistics of an arena
+ *	cl_arena_allocator	Get an allocator for an arena
+ */
+/** \file
+ *
+ * An arena allocates memory of any size by bumping an offset into a chunk.
+ * Nothing allocated from it is freed on its own: all memory allocated after
+ * a mark is released at once, or all of it by a reset.  That makes it a
+ * good backing store for data with one lifetime, such as everything built
+ * while handling one request.  Containers created with an arena (see
+ * cl_list_create_arena, cl_tree_create_set_arena, cl_hash_create_set_arena
+ * and cl_array_create_arena) keep all their memory in it, so they don't need
+ * to be destroyed -- a release or reset tears them down in O(1).
+ *
+ * Any container can also be created with an arena's allocator (see
+ * cl_arena_allocator); its memory is then given back the same way.
+ *
+ * Chunks are allocated (with malloc, or another allocator) and linked to
+ * the previous chunk.  When an allocation doesn't fit in the current chunk,
+ * a new one is started (big enough for it), and the rest of the current
+ * chunk is left unused.  Chunks of the default size are kept for reuse when
+ * released, until the arena is shrunk or destroyed.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include "clump.h"
+
+/** Default size of a chunk */
+#define CL_ARENA_CHUNK		(64 << 10)
+
+/** Arena chunk header (data follows it).
+ */
+struct cl_arena_chunk {
+	struct cl_arena_chunk	*prev;		/**< previous chunk */
+	size_t			n_size;		/**< bytes of data */
+};
+
+/** Memory arena structure.
+ */
+struct cl_arena {
+	const struct cl_alloc	*al;		/**< allocator of chunks */
+	struct cl_alloc		alloc;		/**< allocator from arena */
+	struct cl_arena_chunk	*chunk;		/**< current chunk */
+	struct cl_arena_chunk	*spare;		/**< free chunk list */
+	size_t			n_used;		/**< bytes used in chunk */
+	size_t			n_chunk;	/**< default chunk size */
+	uint32_t		n_chunks;	/**< chunks in chunk list */
+	uint32_t		n_spare;	/**< chunks in free chunk list */
+	size_t			n_bytes;	/**< bytes of all chunks */
+	size_t			n_alloc;	/**< bytes allocated by callers */
+};
+
+/** Get the data of a chunk (aligned to the header size).
+ */
+static inline char *cl_arena_chunk_data(struct cl_arena_chunk *c) {
+	return (char *)(c + 1);
+}
+
+/** Allocate from an arena (for its allocator).
+ */
+static void *cl_arena_alloc_cb(void *ctx, size_t n) {
+	return cl_arena_alloc(ctx, n, 0);
+}
+
+/** Create a memory arena.
+ *
+ * @param n_chunk Size of each chunk (in bytes), or 0 for the default.
+ * @return Pointer to the memory arena.
+ */
+struct cl_arena *cl_arena_create(size_t n_chunk) {
+	return cl_arena_create_with_alloc(n_chunk, &cl_alloc_default);
+}
+
+/** Create a memory arena with an allocator.
+ *
+ * @param n_chunk Size of each chunk (in bytes), or 0 for the default.
+ * @param al Allocator for the arena and its chunks.
+ * @return Pointer to the memory arena.
+ */
+struct cl_arena *cl_arena_create_with_alloc(size_t n_chunk,
+	const struct cl_alloc *al)
+{
+	struct cl_arena *a = cl_alloc_malloc(al, sizeof(struct cl_arena));
+	a->al = al;
+	a->alloc.fn_malloc = cl_arena_alloc_cb;
+	a->alloc.fn_realloc = NULL;
+	a->alloc.fn_free = NULL;
+	a->alloc.ctx = a;
+	if(n_chunk == 0)
+		n_chunk = CL_ARENA_CHUNK;
+	a->chunk = NULL;
+	a->spare = NULL;
+	a->n_used = 0;
+	a->n_chunk = n_chunk;
+	a->n_chunks = 0;
+	a->n_spare = 0;
+	a->n_bytes = 0;
+	a->n_alloc = 0;
+	return a;
+}
+
+/** Free one chunk.
+ */
+static void cl_arena_chunk_delete(struct cl_arena *a, struct cl_arena_chunk *c)
+{
+	cl_alloc_free(a->al, c, sizeof(struct cl_arena_chunk) + c->n_size);
+}
+
+/** Free a list of chunks.
+ */
+static void cl_arena_chunk_free(struct cl_arena *a, struct cl_arena_chunk *c) {
+	while(c) {
+		struct cl_arena_chunk *prev = c->prev;
+		cl_arena_chunk_delete(a, c);
+		c = prev;
+	}
+}
+
+/** Destroy a memory arena.
+ *
+ * All memory allocated from the arena is freed.
+ *
+ * @param a Memory arena.
+ */
+void cl_arena_destroy(struct cl_arena *a) {
+	assert(a);
+	cl_arena_chunk_free(a, a->chunk);
+	cl_arena_chunk_free(a, a->spare);
+#ifndef NDEBUG
+	a->chunk = NULL;
+	a->spare = NULL;
+#endif
+	cl_alloc_free(a->al, a, sizeof(struct cl_arena));
+}
+
+/** Start a new chunk in an arena.
+ *
+ * @param a Memory arena.
+ * @param n Bytes needed in the chunk (including alignment padding).
+ */
+static void cl_arena_chunk_add(struct cl_arena *a, size_t n) {
+	struct cl_arena_chunk *c;
+
+	if(n <= a->n_chunk && a->spare) {
+		c = a->spare;
+		a->spare = c->prev;
+		a->n_spare--;
+	} else {
+		size_t n_size = n > a->n_chunk ? n : a->n_chunk;
+		c = cl_alloc_malloc(a->al, sizeof(struct cl_arena_chunk) +
+			n_size);
+		c->n_size = n_size;
+		a->n_bytes += n_size;
+	}
+	c->prev = a->chunk;
+	a->chunk = c;
+	a->n_used = 0;
+	a->n_chunks++;
+}
+
+/** Allocate memory from an arena.
+ *
+ * The memory is not initialized.  It stays allocated until the arena is
+ * released to an earlier mark, reset or destroyed.
+ *
+ * @param a Memory arena.
+ * @param n Number of bytes to allocate.
+ * @param align Alignment, a power of 2 (0 for that of a pointer).
+ * @return Pointer to allocated memory.
+ */
+void *cl_arena_alloc(struct cl_arena *a, size_t n, size_t align) {
+	uintptr_t p;
+
+	if(align < sizeof(void *))
+		align = sizeof(void *);
+	assert((align & (align - 1)) == 0);
+	if(a->chunk) {
+		p = (uintptr_t)cl_arena_chunk_data(a->chunk) + a->n_used;
+		p = (p + align - 1) & ~(uintptr_t)(align - 1);
+		if(p + n <= (uintptr_t)cl_arena_chunk_data(a->chunk) +
+			a->chunk->n_size)
+			goto done;
+	}
+	/* Room for any padding malloc's alignment leaves */
+	cl_arena_chunk_add(a, n + align);
+	p = (uintptr_t)cl_arena_chunk_data(a->chunk);
+	p = (p + align - 1) & ~(uintptr_t)(align - 1);
+done:
+	a->n_used = p + n - (uintptr_t)cl_arena_chunk_data(a->chunk);
+	a->n_alloc += n;
+	return (void *)p;
+}
+
+/** Get a mark of the memory allocated from an arena.
+ *
+ * @param a Memory arena.
+ * @return Mark to pass to cl_arena_release.
+ */
+struct cl_arena_mark cl_arena_mark(const struct cl_arena *a) {
+	struct cl_arena_mark mark;
+	mark.chunk = a->chunk;
+	mark.n_used = a->n_used;
+	mark.n_alloc = a->n_alloc;
+	return mark;
+}
+
+/** Release memory allocated from an arena after a mark.
+ *
+ * Marks can be nested; releasing to a mark invalidates any later ones.
+ * Containers created with the arena after the mark are torn down, and
+ * those created before it must not have grown since.
+ *
+ * @param a Memory arena.
+ * @param mark Mark from cl_arena_mark.
+ */
+void cl_arena_release(struct cl_arena *a, struct cl_arena_mark mark) {
+	while(a->chunk != mark.chunk) {
+		struct cl_arena_chunk *c = a->chunk;
+		assert(c);
+		a->chunk = c->prev;
+		a->n_chunks--;
+		if(c->n_size == a->n_chunk) {
+			c->prev = a->spare;
+			a->spare = c;
+			a->n_spare++;
+		} else {
+			a->n_bytes -= c->n_size;
+			cl_arena_chunk_delete(a, c);
+		}
+	}
+	a->n_used = mark.n_used;
+	a->n_alloc = mark.n_alloc;
+}
+
+/** Reset a memory arena.
+ *
+ * Release all memory allocated from an arena, keeping chunks of the default
+ * size for reuse.
+ *
+ * @param a Memory arena.
+ */
+void cl_arena_reset(struct cl_arena *a) {
+	struct cl_arena_mark mark = { NULL, 0, 0 };
+	cl_arena_release(a, mark);
+}
+
+/** Shrink a memory arena.
+ *
+ * Free all chunks which are not holding any memory (after a release).
+ *
+ * @param a Memory arena.
+ */
+void cl_arena_shrink(struct cl_arena *a) {
+	struct cl_arena_chunk *c;
+	for(c = a->spare; c; c = c->prev)
+		a->n_bytes -= c->n_size;
+	cl_arena_chunk_free(a, a->spare);
+	a->spare = NULL;
+	a->n_spare = 0;
+}
+
+/** Add up memory statistics of a memory arena.
+ *
+ * An arena counts as one pool with chunks for blocks; n_used is the bytes
+ * callers asked for, the rest of n_bytes is padding, unused chunk ends and
+ * spare chunks.
+ *
+ * @param a Memory arena.
+ * @param stats Statistics to add to.
+ */
+void cl_arena_stats(const struct cl_arena *a, struct cl_pool_stats *stats) {
+	stats->n_pools++;
+	stats->n_blocks += a->n_chunks;
+	stats->n_spare += a->n_spare;
+	stats->n_bytes += sizeof(struct cl_arena) + a->n_bytes +
+		(size_t)(a->n_chunks + a->n_spare) *
+		sizeof(struct cl_arena_chunk);
+	stats->n_used += a->n_alloc;
+}
+
+/** Get an allocator for a memory arena.
+ *
+ * Memory from the allocator is only given back by releasing or resetting
+ * the arena (it has no free function).  It lives as long as the arena.
+ *
+ * @param a Memory arena.
+ * @return Allocator from the arena.
+ */
+const struct cl_alloc *cl_arena_allocator(struct cl_arena *a) {
+	return &a->alloc;
+}
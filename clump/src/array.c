@@ -6,21 +6,50 @@
  * Public functions:
  *
  *	cl_array_create			Create an array
+ *	cl_array_create_ex		Create an array with aligned storage
+ *	cl_array_create_with_alloc	Create an array with an allocator
+ *	cl_array_create_arena		Create an array in an arena
+ *	cl_array_wrap			Wrap read-only memory as an array
+ *	cl_array_wrap_fixed		Wrap a buffer as a fixed-capacity array
+ *	cl_array_set_growth		Set the growth factor of an array
  *	cl_array_destroy		Destroy an array
  *	cl_array_is_empty		Check if an array is empty
  *	cl_array_count			Count the items in an array
  *	cl_array_borrow			Borrow an item from an array
  *	cl_array_add			Add an item to an array
+ *	cl_array_append_n		Append items to an array
  *	cl_array_insert			Insert an item into an array
+ *	cl_array_insert_n		Insert items into an array
  *	cl_array_remove			Remove an item from an array
+ *	cl_array_remove_range		Remove a range of items from an array
  *	cl_array_pop			Pop an item from an array
  *	cl_array_clear			Clear all items from an array
+ *	cl_array_reserve		Reserve room for items in an array
+ *	cl_array_shrink			Shrink an array to fit its items
+ *	cl_array_resize			Resize an array to a number of items
  */
 /** \file
  *
  * A simple resizable array.
+ *
+ * When full, the store grows by a growth factor (doubling by default), or to
+ * fit all the items of a bulk append or insert if that's more.  With
+ * cl_array_create_ex, the store can be aligned beyond what malloc gives
+ * (for SIMD item types) -- it's over-allocated, with the malloc address
+ * kept just before the store.  An array created with
+ * cl_array_create_with_alloc allocates its store from another allocator
+ * (see struct cl_alloc).  With a memory arena (cl_array_create_arena), a
+ * store it outgrows stays in the arena until that is released or reset.
+ *
+ * An array can also be a view over memory it doesn't own (an mmap'd file,
+ * or a RWops memory buffer), without copying it.  A read-only view
+ * (cl_array_wrap) has a fixed set of items, which can be borrowed or popped
+ * but not written.  A fixed-capacity view (cl_array_wrap_fixed) can be
+ * changed, but never grows past its buffer -- adding to a full one returns
+ * NULL.  Destroying a view leaves the memory alone.
  */
 #include <assert.h>
+#include <stdint.h>
 #include <string.h>
 #include "clump.h"
 
@@ -31,8 +60,19 @@ struct cl_array {
 	size_t			i_size;		/**< size of items */
 	uint32_t		n_size;		/**< size of array */
 	uint32_t		n_items;	/**< number of items */
+	uint16_t		align;		/**< store alignment (or 0) */
+	uint16_t		growth;		/**< growth factor (percent) */
+	uint8_t			view;		/**< view type (or 0) */
+	const struct cl_alloc	*al;		/**< allocator of array */
 };
 
+/** Default growth factor (percent) */
+#define CL_ARRAY_GROWTH 200
+
+/** View types (of memory not owned by the array) */
+#define CL_ARRAY_VIEW_RO	(1)	/**< read-only view */
+#define CL_ARRAY_VIEW_FIXED	(2)	/**< fixed-capacity view */
+
 /** Get the minimum array size.
  *
  * @param n The requested size.
@@ -49,28 +89,183 @@ static uint32_t cl_array_min_size(uint32_t n) {
  * @return The new array.
  */
 struct cl_array *cl_array_create(size_t s, uint32_t n) {
-	struct cl_array *arr = malloc(sizeof(struct cl_array));
-	assert(arr);
+	return cl_array_create_ex(s, n, 0);
+}
+
+/** Allocate a store for an array.
+ *
+ * An aligned store is over-allocated, with the allocated address kept just
+ * before it.
+ *
+ * @param arr The array.
+ * @param n Number of items in store.
+ * @return Pointer to store.
+ */
+static void *cl_array_store_alloc(struct cl_array *arr, uint32_t n) {
+	size_t n_bytes = arr->i_size * n;
+	char *m;
+	void **store;
+	if (!arr->align)
+		return cl_alloc_malloc(arr->al, n_bytes);
+	m = cl_alloc_malloc(arr->al, n_bytes + arr->align);
+	store = (void **) (m + arr->align - ((uintptr_t) m &
+		(arr->align - 1)));
+	store[-1] = m;
+	return store;
+}
+
+/** Free the store of an array.
+ *
+ * @param arr The array.
+ */
+static void cl_array_store_free(struct cl_array *arr) {
+	size_t n_bytes = arr->i_size * arr->n_size;
+	if (arr->align)
+		cl_alloc_free(arr->al, ((void **) arr->store)[-1],
+			n_bytes + arr->align);
+	else
+		cl_alloc_free(arr->al, arr->store, n_bytes);
+}
+
+/** Initialize an array with an allocator.
+ */
+static struct cl_array *cl_array_init(size_t s, uint32_t n, uint32_t align,
+	const struct cl_alloc *al)
+{
+	struct cl_array *arr = cl_alloc_malloc(al, sizeof(struct cl_array));
+	assert(align <= 4096 && (align & (align - 1)) == 0);
+	if (align <= sizeof(void *))
+		align = 0;
 	arr->i_size = s;
 	arr->n_size = cl_array_min_size(n);
 	arr->n_items = 0;
-	arr->store = malloc(arr->i_size * arr->n_size);
-	assert(arr->store);
+	arr->align = align;
+	arr->growth = CL_ARRAY_GROWTH;
+	arr->view = 0;
+	arr->al = al;
+	arr->store = cl_array_store_alloc(arr, arr->n_size);
 	return arr;
 }
 
+/** Create an array with aligned storage.
+ *
+ * @param s Size of items in array.
+ * @param n Initial number of items in array.
+ * @param align Alignment of the store, a power of 2 up to 4096 (or 0 for
+ *              malloc alignment).
+ * @return The new array.
+ */
+struct cl_array *cl_array_create_ex(size_t s, uint32_t n, uint32_t align) {
+	return cl_array_init(s, n, align, &cl_alloc_default);
+}
+
+/** Create an array with an allocator.
+ *
+ * @param al Allocator for the array and its store.
+ * @param s Size of items in array.
+ * @param n Initial number of items in array.
+ * @param align Alignment of the store, a power of 2 up to 4096 (or 0).
+ * @return The new array.
+ */
+struct cl_array *cl_array_create_with_alloc(const struct cl_alloc *al,
+	size_t s, uint32_t n, uint32_t align)
+{
+	return cl_array_init(s, n, align, al);
+}
+
+/** Create an array in an arena.
+ *
+ * The array and its store are allocated from a memory arena, and are freed
+ * when it is released or reset -- destroying the array is optional.
+ *
+ * @param arena Memory arena.
+ * @param s Size of items in array.
+ * @param n Initial number of items in array.
+ * @return The new array.
+ */
+struct cl_array *cl_array_create_arena(struct cl_arena *arena, size_t s,
+	uint32_t n)
+{
+	return cl_array_init(s, n, 0, cl_arena_allocator(arena));
+}
+
+/** Create a view over memory.
+ */
+static struct cl_array *cl_array_view(void *ptr, size_t s, uint32_t n_size,
+	uint32_t n_items, uint8_t view)
+{
+	struct cl_array *arr = cl_alloc_malloc(&cl_alloc_default,
+		sizeof(struct cl_array));
+	assert(ptr || !n_size);
+	assert(n_items <= n_size);
+	arr->store = ptr;
+	arr->i_size = s;
+	arr->n_size = n_size;
+	arr->n_items = n_items;
+	arr->align = 0;
+	arr->growth = CL_ARRAY_GROWTH;
+	arr->view = view;
+	arr->al = &cl_alloc_default;
+	return arr;
+}
+
+/** Wrap read-only memory as an array.
+ *
+ * The memory is not copied, and must outlive the array.  Items can be
+ * borrowed (the pointers must only be read), popped or cleared, but not
+ * added, inserted or removed from the middle.
+ *
+ * @param ptr Memory holding the items.
+ * @param s Size of items.
+ * @param n Number of items.
+ * @return The new array.
+ */
+struct cl_array *cl_array_wrap(const void *ptr, size_t s, uint32_t n) {
+	return cl_array_view((void *) ptr, s, n, n, CL_ARRAY_VIEW_RO);
+}
+
+/** Wrap a buffer as a fixed-capacity array.
+ *
+ * The buffer is not copied, and must outlive the array.  The array works
+ * as usual, except that it never grows: adding or inserting items past the
+ * end of the buffer fails (returning NULL).
+ *
+ * @param ptr Buffer for the items.
+ * @param s Size of items.
+ * @param n_size Number of items the buffer can hold.
+ * @param n_items Number of items already in the buffer.
+ * @return The new array.
+ */
+struct cl_array *cl_array_wrap_fixed(void *ptr, size_t s, uint32_t n_size,
+	uint32_t n_items)
+{
+	return cl_array_view(ptr, s, n_size, n_items, CL_ARRAY_VIEW_FIXED);
+}
+
+/** Set the growth factor of an array.
+ *
+ * @param arr The array.
+ * @param percent New size when the array is full, as a percentage of the
+ *                current size (more than 100).
+ */
+void cl_array_set_growth(struct cl_array *arr, uint32_t percent) {
+	assert(percent > 100 && percent <= UINT16_MAX);
+	arr->growth = percent;
+}
+
 /** Destroy an array.
  *
  * @param arr The array.
  */
 void cl_array_destroy(struct cl_array *arr) {
 	assert(arr);
-	assert(arr->store);
-	free(arr->store);
+	assert(arr->store || arr->view);
+	if (!arr->view)
+		cl_array_store_free(arr);
 #ifndef NDEBUG
 	arr->store = NULL;
 #endif
-	free(arr);
+	cl_alloc_free(arr->al, arr, sizeof(struct cl_array));
 }
 
 /** Test if an array is empty.
@@ -112,47 +307,124 @@ void *cl_array_borrow(struct cl_array *arr, uint32_t i) {
 	return (i < arr->n_items) ? cl_array_item(arr, i) : NULL;
 }
 
-/** Expand an array to double its current size.
+/** Reallocate the store of an array.
+ *
+ * @param arr The array.
+ * @param n New size of array.
+ */
+static void cl_array_realloc(struct cl_array *arr, uint32_t n) {
+	assert(n >= arr->n_items);
+	assert(!arr->view);
+	if (arr->align) {
+		void *store = cl_array_store_alloc(arr, n);
+		memcpy(store, arr->store, arr->i_size * arr->n_items);
+		cl_array_store_free(arr);
+		arr->store = store;
+	} else
+		arr->store = cl_alloc_realloc(arr->al, arr->store,
+			arr->i_size * arr->n_size, arr->i_size * n);
+	arr->n_size = n;
+}
+
+/** Grow an array to hold at least n more items.
+ *
+ * @param arr The array.
+ * @param n Number of items to make room for.
+ * @return false if the array is a view without room for the items.
+ */
+static bool cl_array_grow(struct cl_array *arr, uint32_t n) {
+	uint64_t need = (uint64_t) arr->n_items + n;
+	uint64_t size = (uint64_t) arr->n_size * arr->growth / 100;
+	assert(need <= UINT32_MAX);
+	if (need <= arr->n_size)
+		return true;
+	if (arr->view)
+		return false;
+	if (size < need)
+		size = need;
+	if (size > UINT32_MAX)
+		size = UINT32_MAX;
+	cl_array_realloc(arr, size);
+	return true;
+}
+
+/** Expand an array by its growth factor.
  *
  * @param arr The array.
  */
-static void cl_array_expand(struct cl_array *arr) {
-	arr->n_size *= 2;
-	arr->store = realloc(arr->store, arr->i_size * arr->n_size);
-	assert(arr->store);
+static bool cl_array_expand(struct cl_array *arr) {
+	return cl_array_grow(arr, arr->n_size - arr->n_items + 1);
 }
 
 /** Add an item to the end of an array.
  *
  * @param arr The array.
- * @return Borrowed pointer to item.
+ * @return Borrowed pointer to item, or NULL if a fixed-capacity view is
+ *         full.
  */
 void *cl_array_add(struct cl_array *arr) {
 	uint32_t i = arr->n_items;
-	if (arr->n_items == arr->n_size)
-		cl_array_expand(arr);
+	assert(arr->view != CL_ARRAY_VIEW_RO);
+	if (arr->n_items == arr->n_size && !cl_array_expand(arr))
+		return NULL;
 	arr->n_items++;
 	return cl_array_item(arr, i);
 }
 
+/** Append items to the end of an array.
+ *
+ * The store is grown (at most) once for all the items.
+ *
+ * @param arr The array.
+ * @param items Items to copy into the array, or NULL to leave the new
+ *              items uninitialized.
+ * @param n Number of items to append.
+ * @return Borrowed pointer to first appended item, or NULL if a
+ *         fixed-capacity view doesn't have room.
+ */
+void *cl_array_append_n(struct cl_array *arr, const void *items, uint32_t n) {
+	return cl_array_insert_n(arr, arr->n_items, items, n);
+}
+
 /** Insert an item into an array.
  *
  * @param arr The array.
  * @param i Index of item to insert.
- * @return Borrowed pointer to item.
+ * @return Borrowed pointer to item, or NULL if a fixed-capacity view is
+ *         full.
  */
 void *cl_array_insert(struct cl_array *arr, uint32_t i) {
+	return cl_array_insert_n(arr, i, NULL, 1);
+}
+
+/** Insert items into an array.
+ *
+ * Following items are moved only once, however many items are inserted.
+ *
+ * @param arr The array.
+ * @param i Index of first item to insert.
+ * @param items Items to copy into the array, or NULL to leave the new
+ *              items uninitialized.
+ * @param n Number of items to insert.
+ * @return Borrowed pointer to first inserted item, or NULL if a
+ *         fixed-capacity view doesn't have room.
+ */
+void *cl_array_insert_n(struct cl_array *arr, uint32_t i, const void *items,
+	uint32_t n)
+{
+	char *dst;
 	assert(i <= arr->n_items);
-	if (arr->n_items == arr->n_size)
-		cl_array_expand(arr);
-	if (i < arr->n_items) {
-		void *src = cl_array_item(arr, i);
-		void *dst = cl_array_item(arr, i + 1);
-		size_t n = arr->i_size * (arr->n_items - i);
-		memmove(dst, src, n);
-	}
-	arr->n_items++;
-	return cl_array_item(arr, i);
+	assert(arr->view != CL_ARRAY_VIEW_RO);
+	if (!cl_array_grow(arr, n))
+		return NULL;
+	dst = (char *) arr->store + arr->i_size * i;
+	if (i < arr->n_items)
+		memmove(dst + arr->i_size * n, dst,
+			arr->i_size * (arr->n_items - i));
+	if (items)
+		memcpy(dst, items, arr->i_size * n);
+	arr->n_items += n;
+	return dst;
 }
 
 /** Remove an item from an array.
@@ -162,16 +434,30 @@ void *cl_array_insert(struct cl_array *arr, uint32_t i) {
  * @return true if item was removed.
  */
 bool cl_array_remove(struct cl_array *arr, uint32_t i) {
-	uint32_t j = i + 1;
-	if (i >= arr->n_items)
+	return cl_array_remove_range(arr, i, 1);
+}
+
+/** Remove a range of items from an array.
+ *
+ * Following items are moved only once, however many items are removed.
+ *
+ * @param arr The array.
+ * @param i Index of first item to remove.
+ * @param n Number of items to remove.
+ * @return true if items were removed; false if range is out of bounds.
+ */
+bool cl_array_remove_range(struct cl_array *arr, uint32_t i, uint32_t n) {
+	uint32_t j = i + n;
+	if (i >= arr->n_items || n > arr->n_items - i)
 		return false;
 	if (j < arr->n_items) {
 		void *src = cl_array_item(arr, j);
+		assert(arr->view != CL_ARRAY_VIEW_RO);
 		void *dst = cl_array_item(arr, i);
-		size_t n = arr->i_size * (arr->n_items - j);
-		memmove(dst, src, n);
+		size_t s = arr->i_size * (arr->n_items - j);
+		memmove(dst, src, s);
 	}
-	arr->n_items--;
+	arr->n_items -= n;
 	return true;
 }
 
@@ -198,3 +484,45 @@ void *cl_array_pop(struct cl_array *arr) {
 void cl_array_clear(struct cl_array *arr) {
 	arr->n_items = 0;
 }
+
+/** Reserve room for items in an array.
+ *
+ * Resize an array once so that it can hold n items without expanding.
+ * A view can't be resized, so this does nothing to one.
+ *
+ * @param arr The array.
+ * @param n Number of items to reserve room for.
+ */
+void cl_array_reserve(struct cl_array *arr, uint32_t n) {
+	if (n > arr->n_size && !arr->view)
+		cl_array_realloc(arr, n);
+}
+
+/** Shrink an array to fit its items.
+ *
+ * @param arr The array.
+ */
+void cl_array_shrink(struct cl_array *arr) {
+	uint32_t n = cl_array_min_size(arr->n_items);
+	/* A smaller store in an arena wouldn't give any memory back */
+	if (n < arr->n_size && arr->al->fn_free && !arr->view)
+		cl_array_realloc(arr, n);
+}
+
+/** Resize an array to a number of items.
+ *
+ * Items past the end are dropped; new items are left uninitialized.
+ *
+ * @param arr The array.
+ * @param n New number of items.
+ * @return false if a view doesn't have room (the array is unchanged).
+ */
+bool cl_array_resize(struct cl_array *arr, uint32_t n) {
+	if (n > arr->n_items) {
+		assert(arr->view != CL_ARRAY_VIEW_RO);
+		if (!cl_array_grow(arr, n - arr->n_items))
+			return false;
+	}
+	arr->n_items = n;
+	return true;
+}
@@ -6,6 +6,7 @@
  * Public functions:
  *
  *	cl_bitarray_create	Create a bit array
+ *	cl_bitarray_create_with_alloc Create a bit array with an allocator
  *	cl_bitarray_destroy	Destroy a bit array
  *	cl_bitarray_wrap	Wrap a byte buffer
  *	cl_bitarray_clear	Clear a bit array
@@ -17,6 +18,11 @@
  *	cl_bitarray_push	Push one bit onto a bit array
  *	cl_bitarray_set_range	Set a range of bits
  *	cl_bitarray_push_range	Push a range of bits
+ *	cl_bitarray_peek	Peek at the next bits of a bit array
+ *	cl_bitarray_skip	Skip over bits of a bit array
+ *	cl_bitarray_remaining	Get the number of bits after the position
+ *	cl_bitarray_popcount	Count the set bits in a bit array
+ *	cl_bitarray_find_first_set	Find the first set bit
  */
 /** \file
  *
@@ -24,8 +30,16 @@
  * a byte buffer.  The first bit in the array (index 0) is the highest bit (7)
  * of the first byte.  The ninth bit (8) is the highest bit (7) of the second
  * byte.
+ *
+ * Ranges of bits are read and written through a 64-bit big-endian word
+ * loaded from the buffer, so the bit order of the array is the bit order of
+ * the word.  Near the end of the buffer, the word is loaded a byte at a time
+ * (with zeros past the end).  For reading a stream of bits with peek and
+ * skip, the last word loaded is kept as a read-ahead window, and only
+ * reloaded when the next bits run past it.
  */
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "clump.h"
@@ -36,18 +50,77 @@ struct cl_bitarray {
 	unsigned char	*buf;
 	unsigned int	n_bits;
 	unsigned int	pos;
+	unsigned int	w_pos;		/* first bit of read window */
+	unsigned int	w_bits;		/* bits in read window (0: none) */
+	uint64_t	window;		/* read window (first bit high) */
+	const struct cl_alloc *al;	/* allocator of bit array */
 };
 
+/** Get the number of bytes in the buffer of a bit array.
+ */
+static unsigned int cl_bitarray_n_bytes(const struct cl_bitarray *ba) {
+	return (ba->n_bits + 7) / 8;
+}
+
+/** Load a big-endian word from the buffer of a bit array.
+ *
+ * @param ba Pointer to the bit array.
+ * @param i Index of first byte.
+ * @return Word of bytes starting at i (zero past the end).
+ */
+static uint64_t cl_bitarray_load(const struct cl_bitarray *ba, unsigned int i) {
+	const unsigned char *p = ba->buf + i;
+	unsigned int n = cl_bitarray_n_bytes(ba) - i;
+	uint64_t w = 0;
+	unsigned int b;
+	if(n >= 8) {
+		return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+			((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+			((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+			((uint64_t)p[6] << 8) | p[7];
+	}
+	for(b = 0; b < n; b++)
+		w |= (uint64_t)p[b] << (56 - 8 * b);
+	return w;
+}
+
+/** Store the high bytes of a big-endian word to the buffer of a bit array.
+ *
+ * @param ba Pointer to the bit array.
+ * @param i Index of first byte.
+ * @param w Word to store.
+ * @param n Number of bytes to store (1-8).
+ */
+static void cl_bitarray_store(struct cl_bitarray *ba, unsigned int i,
+	uint64_t w, unsigned int n)
+{
+	unsigned char *p = ba->buf + i;
+	unsigned int b;
+	assert(i + n <= cl_bitarray_n_bytes(ba));
+	for(b = 0; b < n; b++)
+		p[b] = w >> (56 - 8 * b);
+}
+
 /** Create a bit array.
  *
  * @return Pointer to the bit array.
  */
 struct cl_bitarray *cl_bitarray_create(void) {
-	struct cl_bitarray *ba = malloc(sizeof(struct cl_bitarray));
-	assert(ba);
+	return cl_bitarray_create_with_alloc(&cl_alloc_default);
+}
+
+/** Create a bit array with an allocator.
+ *
+ * @param al Allocator for the bit array (not the wrapped buffer).
+ * @return Pointer to the bit array.
+ */
+struct cl_bitarray *cl_bitarray_create_with_alloc(const struct cl_alloc *al) {
+	struct cl_bitarray *ba = cl_alloc_malloc(al, sizeof(struct cl_bitarray));
+	ba->al = al;
 	ba->buf = NULL;
 	ba->n_bits = 0;
 	ba->pos = 0;
+	ba->w_bits = 0;
 	return ba;
 }
 
@@ -60,7 +133,7 @@ void cl_bitarray_destroy(struct cl_bitarray *ba) {
 #ifndef NDEBUG
 	ba->buf = NULL;
 #endif
-	free(ba);
+	cl_alloc_free(ba->al, ba, sizeof(struct cl_bitarray));
 }
 
 /** Wrap a byte buffer.
@@ -75,6 +148,7 @@ void cl_bitarray_wrap(struct cl_bitarray *ba, unsigned char *buf,
 	ba->buf = buf;
 	ba->n_bits = n_bits;
 	ba->pos = 0;
+	ba->w_bits = 0;
 }
 
 /** Clear a bit array.
@@ -86,6 +160,7 @@ void cl_bitarray_clear(struct cl_bitarray *ba) {
 	if(ba->buf)
 		memset(ba->buf, 0, ba->n_bits / 8);
 	ba->pos = 0;
+	ba->w_bits = 0;
 }
 
 /** Get the number of bytes.
@@ -132,14 +207,12 @@ int cl_bitarray_pop(struct cl_bitarray *ba) {
 int cl_bitarray_get_range(struct cl_bitarray *ba, unsigned int i,
 	unsigned int n)
 {
-	if(i + n < ba->n_bits && n < 32) {
-		unsigned int b, r = 0;
-		for(b = i; b < i + n; b++) {
-			unsigned int n_byte = b / 8;
-			unsigned int n_bit = 7 - b % 8;
-			r = (r << 1) | ((ba->buf[n_byte] >> n_bit) & 0x01);
-		}
-		return r;
+	if(n < 32 && i <= ba->n_bits && n <= ba->n_bits - i) {
+		uint64_t w;
+		if(n == 0)
+			return 0;
+		w = cl_bitarray_load(ba, i / 8);
+		return (w << (i % 8)) >> (64 - n);
 	} else
 		return -1;
 }
@@ -169,6 +242,7 @@ int cl_bitarray_set(struct cl_bitarray *ba, unsigned int i, unsigned int v) {
 		unsigned int n_bit = 7 - i % 8;
 		unsigned int mask = ba->buf[n_byte] & ~(0x01 << n_bit);
 		ba->buf[n_byte] = mask | ((v & 0x01) << n_bit);
+		ba->w_bits = 0;
 		return 0;
 	} else
 		return -1;
@@ -195,15 +269,16 @@ int cl_bitarray_push(struct cl_bitarray *ba, unsigned int v) {
 int cl_bitarray_set_range(struct cl_bitarray *ba, unsigned int i,
 	unsigned int n, unsigned int v)
 {
-	if(i + n < ba->n_bits && n < 32) {
-		unsigned int b;
-		for(b = i; b < i + n; b++) {
-			unsigned int n_byte = b / 8;
-			unsigned int n_bit = 7 - b % 8;
-			unsigned int val = (v >> (i + n - b - 1)) & 0x01;
-			unsigned int mask = ba->buf[n_byte] & ~(0x01 << n_bit);
-			ba->buf[n_byte] = mask | ((val & 0x01) << n_bit);
-		}
+	if(n < 32 && i <= ba->n_bits && n <= ba->n_bits - i) {
+		unsigned int shift = 64 - i % 8 - n;
+		uint64_t mask, w;
+		if(n == 0)
+			return 0;
+		mask = (((uint64_t)1 << n) - 1) << shift;
+		w = cl_bitarray_load(ba, i / 8);
+		w = (w & ~mask) | (((uint64_t)v << shift) & mask);
+		cl_bitarray_store(ba, i / 8, w, (i % 8 + n + 7) / 8);
+		ba->w_bits = 0;
 		return 0;
 	} else
 		return -1;
@@ -223,3 +298,116 @@ int cl_bitarray_push_range(struct cl_bitarray *ba, unsigned int n,
 	ba->pos += n;
 	return r;
 }
+
+/** Peek at the next bits of a bit array.
+ *
+ * Bits past the end of the array are zero.  The position is not changed.
+ *
+ * @param ba Pointer to the bit array.
+ * @param n Number of bits to peek at (1-32).
+ * @return Next n bits, starting with the highest bit.
+ */
+uint32_t cl_bitarray_peek(struct cl_bitarray *ba, unsigned int n) {
+	unsigned int off = ba->pos - ba->w_pos;
+	assert(n >= 1 && n <= 32);
+	/* Reload the window when the bits run past it (or precede it) */
+	if(off > ba->w_bits || n > ba->w_bits - off) {
+		if(ba->pos >= ba->n_bits)
+			return 0;
+		ba->w_pos = ba->pos & ~7u;
+		ba->window = cl_bitarray_load(ba, ba->w_pos / 8);
+		ba->w_bits = 64;
+		/* Clear bits past the end (they peek as zero) */
+		if(ba->n_bits - ba->w_pos < 64)
+			ba->window &= ~(UINT64_MAX >> (ba->n_bits - ba->w_pos));
+		off = ba->pos - ba->w_pos;
+	}
+	return (ba->window << off) >> (64 - n);
+}
+
+/** Skip over bits of a bit array.
+ *
+ * @param ba Pointer to the bit array.
+ * @param n Number of bits to skip.
+ */
+void cl_bitarray_skip(struct cl_bitarray *ba, unsigned int n) {
+	ba->pos += n;
+}
+
+/** Get the number of bits after the position of a bit array.
+ *
+ * @param ba Pointer to the bit array.
+ * @return Number of bits left to pop.
+ */
+unsigned int cl_bitarray_remaining(struct cl_bitarray *ba) {
+	return ba->pos < ba->n_bits ? ba->n_bits - ba->pos : 0;
+}
+
+/** Count the set bits in a word.
+ */
+static unsigned int cl_bitarray_count_word(uint64_t w) {
+#ifdef __GNUC__
+	return __builtin_popcountll(w);
+#else
+	unsigned int n = 0;
+	while(w) {
+		w &= w - 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/** Count leading zero bits of a word (not zero).
+ */
+static unsigned int cl_bitarray_lead_word(uint64_t w) {
+#ifdef __GNUC__
+	return __builtin_clzll(w);
+#else
+	unsigned int n = 0;
+	while(!(w >> 63)) {
+		w <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/** Count the set bits in a bit array.
+ *
+ * @param ba Pointer to the bit array.
+ * @return Number of bits set to 1.
+ */
+unsigned int cl_bitarray_popcount(struct cl_bitarray *ba) {
+	unsigned int i, n = 0;
+	unsigned int n_full = ba->n_bits / 64;
+	for(i = 0; i < n_full; i++)
+		n += cl_bitarray_count_word(cl_bitarray_load(ba, i * 8));
+	if(ba->n_bits % 64) {
+		uint64_t w = cl_bitarray_load(ba, n_full * 8);
+		n += cl_bitarray_count_word(w & ~(UINT64_MAX >>
+			(ba->n_bits % 64)));
+	}
+	return n;
+}
+
+/** Find the first set bit in a bit array.
+ *
+ * @param ba Pointer to the bit array.
+ * @param i Array index to start searching from.
+ * @return Index of first bit set to 1 at or after i, or -1 if none.
+ */
+int cl_bitarray_find_first_set(struct cl_bitarray *ba, unsigned int i) {
+	while(i < ba->n_bits) {
+		uint64_t w = cl_bitarray_load(ba, i / 8) << (i % 8);
+		unsigned int n = 64 - i % 8;
+		if(ba->n_bits - i < n) {
+			n = ba->n_bits - i;
+			w &= ~(UINT64_MAX >> n);
+		}
+		if(w)
+			return i + cl_bitarray_lead_word(w);
+		i += n;
+	}
+	return -1;
+}
@@ -0,0 +1,777 @@
+/*
+ * bitset.c	A set of integers
+ *
+ * Copyright (c) 2011-2012  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_bitset_create		Create a bit set
+ *	cl_bitset_copy			Copy a bit set
+ *	cl_bitset_destroy		Destroy a bit set
+ *	cl_bitset_clear			Remove all members of a bit set
+ *	cl_bitset_is_empty		Check if a bit set is empty
+ *	cl_bitset_count			Count the members of a bit set
+ *	cl_bitset_contains		Check if a bit set contains a value
+ *	cl_bitset_add			Add a value to a bit set
+ *	cl_bitset_remove		Remove a value from a bit set
+ *	cl_bitset_union			Add all members of another set
+ *	cl_bitset_intersect		Keep only members of another set
+ *	cl_bitset_difference		Remove all members of another set
+ *	cl_bitset_equals		Check if two bit sets are equal
+ *	cl_bitset_iterator_init		Initialize a bit set iterator
+ *	cl_bitset_iterator_next		Get the next member of a bit set
+ */
+/** \file
+ *
+ * A bit set is a set of uint32_t values.  The values are split into chunks
+ * of 65536 by their high 16 bits, and the chunks are kept in an array
+ * sorted by those bits.  Each chunk has one of two forms, so sparse and
+ * dense sets are both compact (like roaring bitmaps):
+ *
+ *  - An array chunk holds up to CL_BITSET_ARRAY_MAX sorted low 16 bits.
+ *  - A bitmap chunk holds a bit for every value (8 KB).
+ *
+ * A chunk becomes a bitmap when an array would hold too many values, and
+ * an array again when a bitmap drops to half as many.  Set operations on
+ * two bitmaps work a vector of words at a time (with AVX2 or SSE2 when the
+ * compiler targets them).  Empty chunks are removed.
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clump.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/** Number of words in a bitmap chunk */
+#define CL_BITSET_WORDS		(65536 / 64)
+
+/** Most values in an array chunk */
+#define CL_BITSET_ARRAY_MAX	(4096)
+
+/** Bit set chunk structure.
+ */
+struct cl_bitset_chunk {
+	uint16_t		key;		/* high 16 bits of values */
+	uint32_t		n;		/* number of values */
+	uint32_t		cap;		/* capacity of array */
+	uint16_t		*vals;		/* sorted low bits (array) */
+	uint64_t		*words;		/* bits (bitmap), or NULL */
+};
+
+/** Bit set structure.
+ */
+struct cl_bitset {
+	struct cl_bitset_chunk	*chunks;	/* chunks sorted by key */
+	uint32_t		n_chunks;	/* number of chunks */
+	uint32_t		cap;		/* capacity of chunks */
+};
+
+/** Bit set word operations */
+enum cl_bitset_op {
+	CL_BITSET_OR,
+	CL_BITSET_AND,
+	CL_BITSET_ANDNOT,
+};
+
+/** Count the set bits in a word.
+ */
+static unsigned int cl_bitset_count_word(uint64_t w) {
+#ifdef __GNUC__
+	return __builtin_popcountll(w);
+#else
+	unsigned int n = 0;
+	while(w) {
+		w &= w - 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/** Count trailing zero bits of a word (not zero).
+ */
+static unsigned int cl_bitset_trail_word(uint64_t w) {
+#ifdef __GNUC__
+	return __builtin_ctzll(w);
+#else
+	unsigned int n = 0;
+	while(!(w & 1)) {
+		w >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/** Combine the words of two bitmaps.
+ *
+ * @param dst Destination bitmap (first operand).
+ * @param src Second operand.
+ * @param op Word operation.
+ * @return Number of bits set in the result.
+ */
+static uint32_t cl_bitset_words_op(uint64_t *dst, const uint64_t *src,
+	enum cl_bitset_op op)
+{
+	uint32_t n = 0;
+	unsigned int i = 0;
+
+#if defined(__AVX2__)
+	for(; i < CL_BITSET_WORDS; i += 4) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+		if(op == CL_BITSET_OR)
+			a = _mm256_or_si256(a, b);
+		else if(op == CL_BITSET_AND)
+			a = _mm256_and_si256(a, b);
+		else
+			a = _mm256_andnot_si256(b, a);
+		_mm256_storeu_si256((__m256i *)(dst + i), a);
+	}
+#elif defined(__SSE2__)
+	for(; i < CL_BITSET_WORDS; i += 2) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+		if(op == CL_BITSET_OR)
+			a = _mm_or_si128(a, b);
+		else if(op == CL_BITSET_AND)
+			a = _mm_and_si128(a, b);
+		else
+			a = _mm_andnot_si128(b, a);
+		_mm_storeu_si128((__m128i *)(dst + i), a);
+	}
+#else
+	for(; i < CL_BITSET_WORDS; i++) {
+		if(op == CL_BITSET_OR)
+			dst[i] |= src[i];
+		else if(op == CL_BITSET_AND)
+			dst[i] &= src[i];
+		else
+			dst[i] &= ~src[i];
+	}
+#endif
+	for(i = 0; i < CL_BITSET_WORDS; i++)
+		n += cl_bitset_count_word(dst[i]);
+	return n;
+}
+
+/** Check if a bitmap has a bit set.
+ */
+static bool cl_bitset_words_get(const uint64_t *words, uint16_t v) {
+	return (words[v >> 6] >> (v & 63)) & 1;
+}
+
+/** Find a value in an array chunk.
+ *
+ * @return Index of value, or index to insert it (with found false).
+ */
+static uint32_t cl_bitset_chunk_find(const struct cl_bitset_chunk *c,
+	uint16_t v, bool *found)
+{
+	uint32_t lo = 0, hi = c->n;
+	while(lo < hi) {
+		uint32_t mid = (lo + hi) / 2;
+		if(c->vals[mid] < v)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	*found = (lo < c->n && c->vals[lo] == v);
+	return lo;
+}
+
+/** Check if a chunk contains a value.
+ */
+static bool cl_bitset_chunk_contains(const struct cl_bitset_chunk *c,
+	uint16_t v)
+{
+	bool found;
+	if(c->words)
+		return cl_bitset_words_get(c->words, v);
+	cl_bitset_chunk_find(c, v, &found);
+	return found;
+}
+
+/** Make sure an array chunk has room for n values.
+ */
+static void cl_bitset_chunk_reserve(struct cl_bitset_chunk *c, uint32_t n) {
+	if(n > c->cap) {
+		uint32_t cap = c->cap ? c->cap : 4;
+		while(cap < n)
+			cap *= 2;
+		c->vals = realloc(c->vals, cap * sizeof(uint16_t));
+		assert(c->vals);
+		c->cap = cap;
+	}
+}
+
+/** Convert an array chunk to a bitmap.
+ */
+static void cl_bitset_chunk_to_bitmap(struct cl_bitset_chunk *c) {
+	uint32_t i;
+	assert(c->words == NULL);
+	c->words = calloc(CL_BITSET_WORDS, sizeof(uint64_t));
+	assert(c->words);
+	for(i = 0; i < c->n; i++)
+		c->words[c->vals[i] >> 6] |= (uint64_t)1 << (c->vals[i] & 63);
+	free(c->vals);
+	c->vals = NULL;
+	c->cap = 0;
+}
+
+/** Convert a bitmap chunk to an array.
+ */
+static void cl_bitset_chunk_to_array(struct cl_bitset_chunk *c) {
+	uint64_t *words = c->words;
+	uint32_t i, n = 0;
+	assert(words);
+	c->words = NULL;
+	c->cap = 0;
+	cl_bitset_chunk_reserve(c, c->n);
+	for(i = 0; i < CL_BITSET_WORDS; i++) {
+		uint64_t w = words[i];
+		while(w) {
+			c->vals[n++] = i * 64 + cl_bitset_trail_word(w);
+			w &= w - 1;
+		}
+	}
+	assert(n == c->n);
+	free(words);
+}
+
+/** Pick the form of a chunk for its number of values.
+ */
+static void cl_bitset_chunk_fix(struct cl_bitset_chunk *c) {
+	if(c->words) {
+		if(c->n > 0 && c->n <= CL_BITSET_ARRAY_MAX / 2)
+			cl_bitset_chunk_to_array(c);
+	} else if(c->n > CL_BITSET_ARRAY_MAX)
+		cl_bitset_chunk_to_bitmap(c);
+}
+
+/** Free the values of a chunk.
+ */
+static void cl_bitset_chunk_free(struct cl_bitset_chunk *c) {
+	free(c->vals);
+	free(c->words);
+}
+
+/** Copy a chunk.
+ */
+static void cl_bitset_chunk_copy(struct cl_bitset_chunk *c,
+	const struct cl_bitset_chunk *src)
+{
+	c->key = src->key;
+	c->n = src->n;
+	c->cap = 0;
+	c->vals = NULL;
+	c->words = NULL;
+	if(src->words) {
+		c->words = malloc(CL_BITSET_WORDS * sizeof(uint64_t));
+		assert(c->words);
+		memcpy(c->words, src->words, CL_BITSET_WORDS *
+			sizeof(uint64_t));
+	} else {
+		cl_bitset_chunk_reserve(c, src->n);
+		memcpy(c->vals, src->vals, src->n * sizeof(uint16_t));
+	}
+}
+
+/** Find the chunk for a key.
+ *
+ * @return Index of chunk, or index to insert it (with found false).
+ */
+static uint32_t cl_bitset_find(const struct cl_bitset *bs, uint16_t key,
+	bool *found)
+{
+	uint32_t lo = 0, hi = bs->n_chunks;
+	while(lo < hi) {
+		uint32_t mid = (lo + hi) / 2;
+		if(bs->chunks[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	*found = (lo < bs->n_chunks && bs->chunks[lo].key == key);
+	return lo;
+}
+
+/** Make sure a bit set has room for n chunks.
+ */
+static void cl_bitset_reserve(struct cl_bitset *bs, uint32_t n) {
+	if(n > bs->cap) {
+		uint32_t cap = bs->cap ? bs->cap : 4;
+		while(cap < n)
+			cap *= 2;
+		bs->chunks = realloc(bs->chunks, cap *
+			sizeof(struct cl_bitset_chunk));
+		assert(bs->chunks);
+		bs->cap = cap;
+	}
+}
+
+/** Remove the empty chunks of a bit set.
+ */
+static void cl_bitset_compact(struct cl_bitset *bs) {
+	uint32_t i, n = 0;
+	for(i = 0; i < bs->n_chunks; i++) {
+		struct cl_bitset_chunk *c = bs->chunks + i;
+		if(c->n == 0)
+			cl_bitset_chunk_free(c);
+		else {
+			cl_bitset_chunk_fix(c);
+			bs->chunks[n++] = *c;
+		}
+	}
+	bs->n_chunks = n;
+}
+
+/** Create a bit set.
+ *
+ * @return Pointer to new (empty) bit set.
+ */
+struct cl_bitset *cl_bitset_create(void) {
+	struct cl_bitset *bs = malloc(sizeof(struct cl_bitset));
+	assert(bs);
+	bs->chunks = NULL;
+	bs->n_chunks = 0;
+	bs->cap = 0;
+	return bs;
+}
+
+/** Copy a bit set.
+ *
+ * @param bs Bit set to copy.
+ * @return Pointer to new bit set with the same members.
+ */
+struct cl_bitset *cl_bitset_copy(const struct cl_bitset *bs) {
+	struct cl_bitset *copy = cl_bitset_create();
+	uint32_t i;
+	cl_bitset_reserve(copy, bs->n_chunks);
+	for(i = 0; i < bs->n_chunks; i++)
+		cl_bitset_chunk_copy(copy->chunks + i, bs->chunks + i);
+	copy->n_chunks = bs->n_chunks;
+	return copy;
+}
+
+/** Destroy a bit set.
+ *
+ * @param bs Bit set to destroy.
+ */
+void cl_bitset_destroy(struct cl_bitset *bs) {
+	cl_bitset_clear(bs);
+	free(bs->chunks);
+	free(bs);
+}
+
+/** Remove all members of a bit set.
+ *
+ * @param bs Bit set to clear.
+ */
+void cl_bitset_clear(struct cl_bitset *bs) {
+	uint32_t i;
+	for(i = 0; i < bs->n_chunks; i++)
+		cl_bitset_chunk_free(bs->chunks + i);
+	bs->n_chunks = 0;
+}
+
+/** Check if a bit set is empty.
+ *
+ * @param bs Bit set.
+ * @return true if the set has no members.
+ */
+bool cl_bitset_is_empty(const struct cl_bitset *bs) {
+	return bs->n_chunks == 0;
+}
+
+/** Count the members of a bit set.
+ *
+ * @param bs Bit set.
+ * @return Number of members.
+ */
+uint64_t cl_bitset_count(const struct cl_bitset *bs) {
+	uint64_t n = 0;
+	uint32_t i;
+	for(i = 0; i < bs->n_chunks; i++)
+		n += bs->chunks[i].n;
+	return n;
+}
+
+/** Check if a bit set contains a value.
+ *
+ * @param bs Bit set.
+ * @param v Value to check.
+ * @return true if v is a member.
+ */
+bool cl_bitset_contains(const struct cl_bitset *bs, uint32_t v) {
+	bool found;
+	uint32_t i = cl_bitset_find(bs, v >> 16, &found);
+	return found && cl_bitset_chunk_contains(bs->chunks + i, v & 0xFFFF);
+}
+
+/** Add a value to a bit set.
+ *
+ * @param bs Bit set.
+ * @param v Value to add.
+ * @return true if v was added, false if it was already a member.
+ */
+bool cl_bitset_add(struct cl_bitset *bs, uint32_t v) {
+	uint16_t low = v & 0xFFFF;
+	struct cl_bitset_chunk *c;
+	bool found;
+	uint32_t i = cl_bitset_find(bs, v >> 16, &found);
+
+	if(!found) {
+		cl_bitset_reserve(bs, bs->n_chunks + 1);
+		c = bs->chunks + i;
+		memmove(c + 1, c, (bs->n_chunks - i) *
+			sizeof(struct cl_bitset_chunk));
+		bs->n_chunks++;
+		c->key = v >> 16;
+		c->n = 0;
+		c->cap = 0;
+		c->vals = NULL;
+		c->words = NULL;
+	}
+	c = bs->chunks + i;
+	if(c->words) {
+		uint64_t bit = (uint64_t)1 << (low & 63);
+		if(c->words[low >> 6] & bit)
+			return false;
+		c->words[low >> 6] |= bit;
+	} else {
+		uint32_t j = cl_bitset_chunk_find(c, low, &found);
+		if(found)
+			return false;
+		cl_bitset_chunk_reserve(c, c->n + 1);
+		memmove(c->vals + j + 1, c->vals + j, (c->n - j) *
+			sizeof(uint16_t));
+		c->vals[j] = low;
+	}
+	c->n++;
+	cl_bitset_chunk_fix(c);
+	return true;
+}
+
+/** Remove a value from a bit set.
+ *
+ * @param bs Bit set.
+ * @param v Value to remove.
+ * @return true if v was removed, false if it was not a member.
+ */
+bool cl_bitset_remove(struct cl_bitset *bs, uint32_t v) {
+	uint16_t low = v & 0xFFFF;
+	struct cl_bitset_chunk *c;
+	bool found;
+	uint32_t i = cl_bitset_find(bs, v >> 16, &found);
+
+	if(!found)
+		return false;
+	c = bs->chunks + i;
+	if(c->words) {
+		uint64_t bit = (uint64_t)1 << (low & 63);
+		if(!(c->words[low >> 6] & bit))
+			return false;
+		c->words[low >> 6] &= ~bit;
+	} else {
+		uint32_t j = cl_bitset_chunk_find(c, low, &found);
+		if(!found)
+			return false;
+		memmove(c->vals + j, c->vals + j + 1, (c->n - j - 1) *
+			sizeof(uint16_t));
+	}
+	c->n--;
+	if(c->n == 0) {
+		cl_bitset_chunk_free(c);
+		memmove(c, c + 1, (bs->n_chunks - i - 1) *
+			sizeof(struct cl_bitset_chunk));
+		bs->n_chunks--;
+	} else
+		cl_bitset_chunk_fix(c);
+	return true;
+}
+
+/** Add the values of one chunk to another (with the same key).
+ */
+static void cl_bitset_chunk_union(struct cl_bitset_chunk *c,
+	const struct cl_bitset_chunk *src)
+{
+	uint32_t i, j, n;
+	uint16_t *vals;
+
+	if(src->words && !c->words)
+		cl_bitset_chunk_to_bitmap(c);
+	if(c->words) {
+		if(src->words) {
+			c->n = cl_bitset_words_op(c->words, src->words,
+				CL_BITSET_OR);
+			return;
+		}
+		for(i = 0; i < src->n; i++) {
+			uint16_t v = src->vals[i];
+			uint64_t bit = (uint64_t)1 << (v & 63);
+			if(!(c->words[v >> 6] & bit)) {
+				c->words[v >> 6] |= bit;
+				c->n++;
+			}
+		}
+		return;
+	}
+	/* Merge two sorted arrays */
+	vals = malloc((c->n + src->n) * sizeof(uint16_t));
+	assert(vals);
+	for(i = 0, j = 0, n = 0; i < c->n || j < src->n; ) {
+		if(j >= src->n || (i < c->n && c->vals[i] < src->vals[j]))
+			vals[n++] = c->vals[i++];
+		else if(i >= c->n || src->vals[j] < c->vals[i])
+			vals[n++] = src->vals[j++];
+		else {
+			vals[n++] = c->vals[i++];
+			j++;
+		}
+	}
+	free(c->vals);
+	c->vals = vals;
+	c->cap = c->n + src->n;
+	c->n = n;
+}
+
+/** Add all members of another set to a bit set.
+ *
+ * @param bs Bit set.
+ * @param other Other bit set.
+ */
+void cl_bitset_union(struct cl_bitset *bs, const struct cl_bitset *other) {
+	uint32_t cap = bs->n_chunks + other->n_chunks + 1;
+	struct cl_bitset_chunk *chunks;
+	uint32_t i = 0, j = 0, n = 0;
+
+	chunks = malloc(cap * sizeof(struct cl_bitset_chunk));
+	assert(chunks);
+	while(i < bs->n_chunks || j < other->n_chunks) {
+		const struct cl_bitset_chunk *o = other->chunks + j;
+		if(j >= other->n_chunks || (i < bs->n_chunks &&
+			bs->chunks[i].key < o->key))
+		{
+			chunks[n++] = bs->chunks[i++];
+		} else if(i >= bs->n_chunks || o->key < bs->chunks[i].key) {
+			cl_bitset_chunk_copy(chunks + n++, o);
+			j++;
+		} else {
+			cl_bitset_chunk_union(bs->chunks + i, o);
+			cl_bitset_chunk_fix(bs->chunks + i);
+			chunks[n++] = bs->chunks[i++];
+			j++;
+		}
+	}
+	free(bs->chunks);
+	bs->chunks = chunks;
+	bs->n_chunks = n;
+	bs->cap = cap;
+}
+
+/** Filter the values of an array chunk.
+ *
+ * @param keep Keep values contained in src (or those not contained).
+ */
+static void cl_bitset_chunk_filter(struct cl_bitset_chunk *c,
+	const struct cl_bitset_chunk *src, bool keep)
+{
+	uint32_t i, n = 0;
+	for(i = 0; i < c->n; i++) {
+		if(cl_bitset_chunk_contains(src, c->vals[i]) == keep)
+			c->vals[n++] = c->vals[i];
+	}
+	c->n = n;
+}
+
+/** Keep only values of one chunk also in another (with the same key).
+ */
+static void cl_bitset_chunk_intersect(struct cl_bitset_chunk *c,
+	const struct cl_bitset_chunk *src)
+{
+	uint32_t i, n = 0;
+
+	if(!c->words) {
+		cl_bitset_chunk_filter(c, src, true);
+	} else if(src->words) {
+		c->n = cl_bitset_words_op(c->words, src->words,
+			CL_BITSET_AND);
+	} else {
+		/* The result is the values of src in the bitmap */
+		uint64_t *words = c->words;
+		c->words = NULL;
+		c->cap = 0;
+		cl_bitset_chunk_reserve(c, src->n);
+		for(i = 0; i < src->n; i++) {
+			if(cl_bitset_words_get(words, src->vals[i]))
+				c->vals[n++] = src->vals[i];
+		}
+		c->n = n;
+		free(words);
+	}
+}
+
+/** Keep only members of a bit set which are also in another set.
+ *
+ * @param bs Bit set.
+ * @param other Other bit set.
+ */
+void cl_bitset_intersect(struct cl_bitset *bs, const struct cl_bitset *other)
+{
+	uint32_t i, j = 0;
+	for(i = 0; i < bs->n_chunks; i++) {
+		struct cl_bitset_chunk *c = bs->chunks + i;
+		while(j < other->n_chunks && other->chunks[j].key < c->key)
+			j++;
+		if(j < other->n_chunks && other->chunks[j].key == c->key)
+			cl_bitset_chunk_intersect(c, other->chunks + j);
+		else
+			c->n = 0;
+	}
+	cl_bitset_compact(bs);
+}
+
+/** Remove values of one chunk which are in another (with the same key).
+ */
+static void cl_bitset_chunk_difference(struct cl_bitset_chunk *c,
+	const struct cl_bitset_chunk *src)
+{
+	uint32_t i;
+
+	if(!c->words) {
+		cl_bitset_chunk_filter(c, src, false);
+	} else if(src->words) {
+		c->n = cl_bitset_words_op(c->words, src->words,
+			CL_BITSET_ANDNOT);
+	} else {
+		for(i = 0; i < src->n; i++) {
+			uint16_t v = src->vals[i];
+			uint64_t bit = (uint64_t)1 << (v & 63);
+			if(c->words[v >> 6] & bit) {
+				c->words[v >> 6] &= ~bit;
+				c->n--;
+			}
+		}
+	}
+}
+
+/** Remove all members of another set from a bit set.
+ *
+ * @param bs Bit set.
+ * @param other Other bit set.
+ */
+void cl_bitset_difference(struct cl_bitset *bs,
+	const struct cl_bitset *other)
+{
+	uint32_t i, j = 0;
+	for(i = 0; i < bs->n_chunks; i++) {
+		struct cl_bitset_chunk *c = bs->chunks + i;
+		while(j < other->n_chunks && other->chunks[j].key < c->key)
+			j++;
+		if(j < other->n_chunks && other->chunks[j].key == c->key)
+			cl_bitset_chunk_difference(c, other->chunks + j);
+	}
+	cl_bitset_compact(bs);
+}
+
+/** Check if two chunks (with the same key) have the same values.
+ */
+static bool cl_bitset_chunk_equals(const struct cl_bitset_chunk *c0,
+	const struct cl_bitset_chunk *c1)
+{
+	uint32_t i;
+	if(c0->n != c1->n)
+		return false;
+	if(c0->words && c1->words) {
+		return memcmp(c0->words, c1->words, CL_BITSET_WORDS *
+			sizeof(uint64_t)) == 0;
+	}
+	if(!c0->words && !c1->words)
+		return memcmp(c0->vals, c1->vals, c0->n * sizeof(uint16_t)) == 0;
+	if(c0->words) {
+		const struct cl_bitset_chunk *c = c0;
+		c0 = c1;
+		c1 = c;
+	}
+	for(i = 0; i < c0->n; i++) {
+		if(!cl_bitset_words_get(c1->words, c0->vals[i]))
+			return false;
+	}
+	return true;
+}
+
+/** Check if two bit sets have the same members.
+ *
+ * @param bs Bit set.
+ * @param other Other bit set.
+ * @return true if the sets are equal.
+ */
+bool cl_bitset_equals(const struct cl_bitset *bs,
+	const struct cl_bitset *other)
+{
+	uint32_t i;
+	if(bs->n_chunks != other->n_chunks)
+		return false;
+	for(i = 0; i < bs->n_chunks; i++) {
+		if(bs->chunks[i].key != other->chunks[i].key ||
+		   !cl_bitset_chunk_equals(bs->chunks + i, other->chunks + i))
+			return false;
+	}
+	return true;
+}
+
+/** Initialize a bit set iterator.
+ *
+ * The set must not be changed while iterating.
+ *
+ * @param it Iterator.
+ * @param bs Bit set.
+ */
+void cl_bitset_iterator_init(struct cl_bitset_iterator *it,
+	const struct cl_bitset *bs)
+{
+	it->set = bs;
+	it->chunk = 0;
+	it->i = 0;
+}
+
+/** Get the next member of a bit set (in increasing order).
+ *
+ * @param it Iterator.
+ * @param v Next member (written).
+ * @return true if there was another member, false at the end.
+ */
+bool cl_bitset_iterator_next(struct cl_bitset_iterator *it, uint32_t *v) {
+	const struct cl_bitset *bs = it->set;
+
+	for(; it->chunk < bs->n_chunks; it->chunk++, it->i = 0) {
+		const struct cl_bitset_chunk *c = bs->chunks + it->chunk;
+		uint32_t base = (uint32_t)c->key << 16;
+		if(c->words) {
+			uint32_t w = it->i >> 6;
+			uint64_t bits;
+			if(w >= CL_BITSET_WORDS)
+				continue;
+			bits = c->words[w] & (~(uint64_t)0 << (it->i & 63));
+			while(!bits && ++w < CL_BITSET_WORDS)
+				bits = c->words[w];
+			if(bits) {
+				uint32_t low = w * 64 + cl_bitset_trail_word(bits);
+				it->i = low + 1;
+				*v = base | low;
+				return true;
+			}
+		} else if(it->i < c->n) {
+			*v = base | c->vals[it->i++];
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,952 @@
+/*
+ * btree.c	A generic B+ tree-set or -map
+ *
+ * Copyright (c) 2007-2014  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_btree_create_set	Create a B-tree set
+ *	cl_btree_create_map	Create a B-tree map
+ *	cl_btree_create_set_int	Create a B-tree set of int keys
+ *	cl_btree_create_map_int	Create a B-tree map of int keys
+ *	cl_btree_destroy	Destroy a B-tree
+ *	cl_btree_count		Count the entries in a B-tree
+ *	cl_btree_contains	Test if a B-tree contains a key
+ *	cl_btree_peek		Get the first key in a B-tree
+ *	cl_btree_get_key	Get a key from a B-tree
+ *	cl_btree_get		Get a value from a B-tree map
+ *	cl_btree_add		Add a key to a B-tree set
+ *	cl_btree_put		Put a mapping into a B-tree map
+ *	cl_btree_remove_key	Remove a key from a B-tree
+ *	cl_btree_remove		Remove a mapping from a B-tree map
+ *	cl_btree_clear		Clear all entries from a B-tree
+ *	cl_btree_stats		Add up memory statistics of a B-tree
+ *	cl_btree_iterator_create Create a B-tree key iterator
+ *	cl_btree_iterator_init	Initialize a B-tree key iterator
+ *	cl_btree_iterator_destroy Destroy a B-tree key iterator
+ *	cl_btree_iterator_seek	Move an iterator to the first key not less
+ *	cl_btree_iterator_next	Get the next key from an iterator
+ *	cl_btree_iterator_value	Get the value mapped to most recent key
+ */
+/** \file
+ *
+ * A B-tree is a sorted set or map like cl_tree, with the same compare
+ * callback, but each node holds up to CL_BTREE_KEYS keys instead of one, so
+ * a lookup reads a few nodes of contiguous keys instead of one node per
+ * level of a binary tree.
+ * It is a B+ tree: entries are only in leaf nodes, inner nodes hold
+ * separator keys (a copy of the first key of each child after the first),
+ * and the leaves are linked in key order.  An iterator is a leaf and a slot,
+ * so iterating (or a range scan from cl_btree_iterator_seek) never allocates.
+ *
+ * A tree created with cl_btree_create_set_int or cl_btree_create_map_int has
+ * int keys (compared like cl_compare_int), stored in the node as 32-bit ints:
+ * the keys of a node fill one cache line and are searched with SIMD compares
+ * (SSE2) instead of calling the compare function.
+ * Keys returned from an int tree are (void *)(long) of the int.
+ *
+ * Nodes other than the root are at least half full.
+ * NOTE: some functions can be used with either sets or maps, but some must
+ * only be used with either sets or maps.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clump.h"
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define CL_BTREE_SSE2
+#endif
+
+/** Maximum number of keys in one node */
+#define CL_BTREE_KEYS 16
+
+/** Minimum number of keys in one node (except the root) */
+#define CL_BTREE_MIN (CL_BTREE_KEYS / 2)
+
+/** B-tree node structure.
+ */
+struct cl_bnode {
+	union {
+		const void	*keys[CL_BTREE_KEYS];	/*< user-defined keys */
+		int32_t		ikeys[CL_BTREE_KEYS];	/*< int keys */
+	} k;
+	void			*links[CL_BTREE_KEYS + 1]; /*< children (inner),
+						     values (leaf) */
+	struct cl_bnode		*next;		/*< next leaf in key order */
+	uint16_t		n_keys;		/*< number of keys */
+	bool			is_leaf;	/*< flag for leaf node */
+};
+
+/** B-tree structure.
+ */
+struct cl_btree {
+	cl_compare_cb		*fn_compare;	/*< compare function, NULL for
+						    int keys */
+	struct cl_pool		*pool;		/*< node memory pool */
+	struct cl_bnode		*root;		/*< root node of tree */
+	struct cl_bnode		*first;		/*< first leaf node */
+	const void		*mkey;		/*< key for insert/remove */
+	const void		*mvalue;	/*< value for insert/remove */
+	bool			found;		/*< matching key found */
+	unsigned int		n_entries;	/*< number of entries in tree */
+	bool			is_map;		/*< flag for mapping */
+};
+
+/** Get a key from a node */
+static inline const void *cl_bnode_key(const struct cl_btree *tree,
+	const struct cl_bnode *n, uint32_t i)
+{
+	assert(i < n->n_keys);
+	return tree->fn_compare ? n->k.keys[i] : (const void *)(long)n->k.ikeys[i];
+}
+
+/** Set a key in a node */
+static inline void cl_bnode_set_key(const struct cl_btree *tree,
+	struct cl_bnode *n, uint32_t i, const void *key)
+{
+	if(tree->fn_compare)
+		n->k.keys[i] = key;
+	else
+		n->k.ikeys[i] = (int32_t)(long)key;
+}
+
+/** Get a child of an inner node */
+static inline struct cl_bnode *cl_bnode_child(const struct cl_bnode *n,
+	uint32_t i)
+{
+	assert(!n->is_leaf && i <= n->n_keys);
+	return n->links[i];
+}
+
+/** Test if two keys are equal */
+static inline bool cl_btree_equal(const struct cl_btree *tree,
+	const void *key0, const void *key1)
+{
+	return tree->fn_compare
+	    ? tree->fn_compare(key0, key1) == CL_EQUAL
+	    : (int32_t)(long)key0 == (int32_t)(long)key1;
+}
+
+#ifdef CL_BTREE_SSE2
+/** Get a bit mask of the int keys in a node less (or greater) than a key.
+ *
+ * Every slot is compared (4 at a time); the caller masks off unused slots.
+ */
+static inline uint32_t cl_bnode_int_mask(const struct cl_bnode *n, int32_t k,
+	bool greater)
+{
+	__m128i vk = _mm_set1_epi32(k);
+	uint32_t mask = 0;
+	for(uint32_t i = 0; i < CL_BTREE_KEYS; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(n->k.ikeys + i));
+		__m128i c = greater ? _mm_cmpgt_epi32(v, vk)
+		                    : _mm_cmplt_epi32(v, vk);
+		mask |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(c)) << i;
+	}
+	return mask & ((1U << n->n_keys) - 1);
+}
+#endif
+
+/** Count the int keys in a node less than a key */
+static inline uint32_t cl_bnode_int_lower(const struct cl_bnode *n, int32_t k) {
+#ifdef CL_BTREE_SSE2
+	return __builtin_popcount(cl_bnode_int_mask(n, k, false));
+#else
+	uint32_t c = 0;
+	for(uint32_t i = 0; i < n->n_keys; i++)
+		c += n->k.ikeys[i] < k;
+	return c;
+#endif
+}
+
+/** Count the int keys in a node not greater than a key */
+static inline uint32_t cl_bnode_int_upper(const struct cl_bnode *n, int32_t k) {
+#ifdef CL_BTREE_SSE2
+	return n->n_keys - __builtin_popcount(cl_bnode_int_mask(n, k, true));
+#else
+	uint32_t c = 0;
+	for(uint32_t i = 0; i < n->n_keys; i++)
+		c += n->k.ikeys[i] <= k;
+	return c;
+#endif
+}
+
+/** Find the first slot in a node with a key not less than a key.
+ *
+ * @param tree The tree (set or map).
+ * @param n Node to search.
+ * @param key Key to search for.
+ * @return Number of keys in the node less than key.
+ */
+static uint32_t cl_bnode_lower(const struct cl_btree *tree,
+	const struct cl_bnode *n, const void *key)
+{
+	uint32_t lo = 0;
+	uint32_t hi = n->n_keys;
+	if(!tree->fn_compare)
+		return cl_bnode_int_lower(n, (int32_t)(long)key);
+	while(lo < hi) {
+		uint32_t mid = (lo + hi) / 2;
+		if(tree->fn_compare(n->k.keys[mid], key) == CL_LESS)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/** Find the first slot in a node with a key greater than a key.
+ *
+ * @param tree The tree (set or map).
+ * @param n Node to search.
+ * @param key Key to search for.
+ * @return Number of keys in the node not greater than key.
+ */
+static uint32_t cl_bnode_upper(const struct cl_btree *tree,
+	const struct cl_bnode *n, const void *key)
+{
+	uint32_t lo = 0;
+	uint32_t hi = n->n_keys;
+	if(!tree->fn_compare)
+		return cl_bnode_int_upper(n, (int32_t)(long)key);
+	while(lo < hi) {
+		uint32_t mid = (lo + hi) / 2;
+		if(tree->fn_compare(key, n->k.keys[mid]) == CL_LESS)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+/** Create a B-tree node.
+ *
+ * @param tree The tree (set or map).
+ * @param is_leaf Flag for leaf node.
+ * @return Pointer to a new (empty) node.
+ */
+static struct cl_bnode *cl_bnode_create(struct cl_btree *tree, bool is_leaf) {
+	struct cl_bnode *n = cl_pool_alloc(tree->pool);
+	/* zeroed, so SIMD compares of unused slots read initialized memory */
+	memset(n, 0, sizeof(struct cl_bnode));
+	n->is_leaf = is_leaf;
+	return n;
+}
+
+/** Create a B-tree.
+ *
+ * @param fn_compare Function to compare two keys for ordering (NULL for
+ *                   int keys).
+ * @param is_map Flag for mapping.
+ * @return Newly created B-tree.
+ */
+static struct cl_btree *cl_btree_create(cl_compare_cb *fn_compare,
+	bool is_map)
+{
+	struct cl_btree *tree = malloc(sizeof(struct cl_btree));
+	assert(tree);
+	tree->fn_compare = fn_compare;
+	tree->pool = cl_pool_create(sizeof(struct cl_bnode));
+	tree->root = cl_bnode_create(tree, true);
+	tree->first = tree->root;
+	tree->mkey = NULL;
+	tree->mvalue = NULL;
+	tree->found = false;
+	tree->n_entries = 0;
+	tree->is_map = is_map;
+	return tree;
+}
+
+/** Create a B-tree set.
+ *
+ * @param fn_compare Function to compare two keys for ordering.
+ * @return Newly created B-tree set.
+ */
+struct cl_btree *cl_btree_create_set(cl_compare_cb *fn_compare) {
+	assert(fn_compare);
+	return cl_btree_create(fn_compare, false);
+}
+
+/** Create a B-tree map.
+ *
+ * @param fn_compare Function to compare two keys for ordering.
+ * @return Newly created B-tree map.
+ */
+struct cl_btree *cl_btree_create_map(cl_compare_cb *fn_compare) {
+	assert(fn_compare);
+	return cl_btree_create(fn_compare, true);
+}
+
+/** Create a B-tree set of int keys.
+ *
+ * @return Newly created B-tree set.
+ */
+struct cl_btree *cl_btree_create_set_int(void) {
+	return cl_btree_create(NULL, false);
+}
+
+/** Create a B-tree map of int keys.
+ *
+ * @return Newly created B-tree map.
+ */
+struct cl_btree *cl_btree_create_map_int(void) {
+	return cl_btree_create(NULL, true);
+}
+
+/** Destroy a B-tree.
+ *
+ * @param tree The tree (set or map).
+ */
+void cl_btree_destroy(struct cl_btree *tree) {
+	assert(tree);
+	cl_pool_destroy(tree->pool);
+#ifndef NDEBUG
+	tree->fn_compare = NULL;
+	tree->pool = NULL;
+	tree->root = NULL;
+	tree->first = NULL;
+#endif
+	free(tree);
+}
+
+/** Get the count of items.
+ *
+ * @param tree The tree (set or map).
+ * @return Count of items currently in the tree.
+ */
+unsigned int cl_btree_count(struct cl_btree *tree) {
+	return tree->n_entries;
+}
+
+/** Search for the leaf which would hold a key.
+ *
+ * @param tree The tree (set or map).
+ * @param key Key to search for.
+ * @return Leaf node for key.
+ */
+static struct cl_bnode *cl_btree_search(const struct cl_btree *tree,
+	const void *key)
+{
+	struct cl_bnode *n = tree->root;
+	while(!n->is_leaf)
+		n = cl_bnode_child(n, cl_bnode_upper(tree, n, key));
+	return n;
+}
+
+/** Find the slot of a key.
+ *
+ * @param tree The tree (set or map).
+ * @param key Key to search for.
+ * @param slot Set to slot of key in leaf (if found).
+ * @return Leaf containing key, or NULL if key is not in tree.
+ */
+static struct cl_bnode *cl_btree_find(const struct cl_btree *tree,
+	const void *key, uint32_t *slot)
+{
+	struct cl_bnode *n = cl_btree_search(tree, key);
+	uint32_t i = cl_bnode_lower(tree, n, key);
+	if(i < n->n_keys && cl_btree_equal(tree, key, cl_bnode_key(tree, n, i))) {
+		*slot = i;
+		return n;
+	}
+	return NULL;
+}
+
+/** Test if a B-tree contains a key.
+ *
+ * @param tree The tree (set or map).
+ * @param key Key to test for.
+ * @return True if tree contains the key, otherwise false.
+ */
+bool cl_btree_contains(struct cl_btree *tree, const void *key) {
+	uint32_t slot;
+	return cl_btree_find(tree, key, &slot) != NULL;
+}
+
+/** Get (peek) the first key in a B-tree.
+ *
+ * @param tree The tree (set or map).
+ * @return Lowest key in the tree, or NULL if tree is empty.
+ */
+const void *cl_btree_peek(struct cl_btree *tree) {
+	struct cl_bnode *n = tree->first;
+	return n->n_keys ? cl_bnode_key(tree, n, 0) : NULL;
+}
+
+/** Get a matching key from a B-tree.
+ *
+ * @param tree The tree (set or map).
+ * @param key Key to search for.
+ * @return Matching key from the tree, or NULL if key is not in tree.
+ */
+const void *cl_btree_get_key(struct cl_btree *tree, const void *key) {
+	uint32_t slot;
+	struct cl_bnode *n = cl_btree_find(tree, key, &slot);
+	return n ? cl_bnode_key(tree, n, slot) : NULL;
+}
+
+/** Get a value from a B-tree map.
+ *
+ * @param tree The tree (map).
+ * @param key Key to search for.
+ * @return Mapped value from the tree, or NULL if key is not in tree.
+ */
+const void *cl_btree_get(struct cl_btree *tree, const void *key) {
+	uint32_t slot;
+	struct cl_bnode *n;
+	assert(tree->is_map);
+	n = cl_btree_find(tree, key, &slot);
+	return n ? n->links[slot] : NULL;
+}
+
+/** Insert a key (and link) into a node which isn't full.
+ *
+ * @param tree The tree (set or map).
+ * @param n Node to insert into.
+ * @param i Slot of new key.
+ * @param key New key.
+ * @param j Slot of new link.
+ * @param link New link (child or value).
+ */
+static void cl_bnode_insert(const struct cl_btree *tree, struct cl_bnode *n,
+	uint32_t i, const void *key, uint32_t j, void *link)
+{
+	uint32_t n_links = n->is_leaf ? n->n_keys : n->n_keys + 1;
+	assert(n->n_keys < CL_BTREE_KEYS);
+	if(tree->fn_compare) {
+		memmove(n->k.keys + i + 1, n->k.keys + i,
+			(n->n_keys - i) * sizeof(n->k.keys[0]));
+	} else {
+		memmove(n->k.ikeys + i + 1, n->k.ikeys + i,
+			(n->n_keys - i) * sizeof(n->k.ikeys[0]));
+	}
+	memmove(n->links + j + 1, n->links + j,
+		(n_links - j) * sizeof(n->links[0]));
+	n->n_keys++;
+	cl_bnode_set_key(tree, n, i, key);
+	n->links[j] = link;
+}
+
+/** Remove a key (and link) from a node.
+ *
+ * @param tree The tree (set or map).
+ * @param n Node to remove from.
+ * @param i Slot of key.
+ * @param j Slot of link.
+ */
+static void cl_bnode_remove(const struct cl_btree *tree, struct cl_bnode *n,
+	uint32_t i, uint32_t j)
+{
+	uint32_t n_links = n->is_leaf ? n->n_keys : n->n_keys + 1;
+	assert(i < n->n_keys && j < n_links);
+	if(tree->fn_compare) {
+		memmove(n->k.keys + i, n->k.keys + i + 1,
+			(n->n_keys - i - 1) * sizeof(n->k.keys[0]));
+	} else {
+		memmove(n->k.ikeys + i, n->k.ikeys + i + 1,
+			(n->n_keys - i - 1) * sizeof(n->k.ikeys[0]));
+	}
+	memmove(n->links + j, n->links + j + 1,
+		(n_links - j - 1) * sizeof(n->links[0]));
+	n->n_keys--;
+}
+
+/** Split a full node, inserting a key (and link).
+ *
+ * The lower keys stay in the node and a new right node gets the rest.  An
+ * inner node also gives its middle key to the parent as separator.
+ *
+ * @param tree The tree (set or map).
+ * @param n Full node to split.
+ * @param i Slot of new key.
+ * @param key New key.
+ * @param link New link (value for leaf, right child of key for inner).
+ * @param sep Set to separator key for new node.
+ * @return New right node.
+ */
+static struct cl_bnode *cl_bnode_split(struct cl_btree *tree,
+	struct cl_bnode *n, uint32_t i, const void *key, void *link,
+	const void **sep)
+{
+	const void *keys[CL_BTREE_KEYS + 1];
+	void *links[CL_BTREE_KEYS + 2];
+	struct cl_bnode *r = cl_bnode_create(tree, n->is_leaf);
+	uint32_t j = n->is_leaf ? i : i + 1;	/* slot of new link */
+	uint32_t n_links = n->is_leaf ? CL_BTREE_KEYS : CL_BTREE_KEYS + 1;
+	uint32_t half = CL_BTREE_KEYS / 2;
+	uint32_t k;
+
+	assert(n->n_keys == CL_BTREE_KEYS);
+	for(k = 0; k < CL_BTREE_KEYS; k++)
+		keys[k < i ? k : k + 1] = cl_bnode_key(tree, n, k);
+	keys[i] = key;
+	for(k = 0; k < n_links; k++)
+		links[k < j ? k : k + 1] = n->links[k];
+	links[j] = link;
+	if(n->is_leaf) {
+		/* n keeps half + 1 entries, r gets the rest */
+		n->n_keys = half + 1;
+		r->n_keys = CL_BTREE_KEYS - half;
+		for(k = 0; k < r->n_keys; k++) {
+			cl_bnode_set_key(tree, r, k, keys[half + 1 + k]);
+			r->links[k] = links[half + 1 + k];
+		}
+		for(k = i; k < n->n_keys; k++) {
+			cl_bnode_set_key(tree, n, k, keys[k]);
+			n->links[k] = links[k];
+		}
+		r->next = n->next;
+		n->next = r;
+		*sep = keys[half + 1];
+		return r;
+	}
+	/* n keeps half keys, the middle key is the separator, r gets the rest */
+	n->n_keys = half;
+	r->n_keys = CL_BTREE_KEYS - half;
+	for(k = 0; k < r->n_keys; k++)
+		cl_bnode_set_key(tree, r, k, keys[half + 1 + k]);
+	for(k = 0; k <= r->n_keys; k++)
+		r->links[k] = links[half + 1 + k];
+	for(k = i; k < n->n_keys; k++)
+		cl_bnode_set_key(tree, n, k, keys[k]);
+	for(k = j; k <= n->n_keys; k++)
+		n->links[k] = links[k];
+	*sep = keys[half];
+	return r;
+}
+
+/** Insert an entry into a sub-tree.
+ *
+ * @param tree The tree (set or map).
+ * @param n Root node of sub-tree.
+ * @param key Key to insert.
+ * @param value Value to insert (for maps).
+ * @param sep Set to separator key for new node (if split).
+ * @return New right sibling node if n was split, or NULL.
+ */
+static struct cl_bnode *cl_btree_insert_sub(struct cl_btree *tree,
+	struct cl_bnode *n, const void *key, const void *value,
+	const void **sep)
+{
+	uint32_t i;
+	if(!n->is_leaf) {
+		const void *rkey;
+		struct cl_bnode *r;
+		i = cl_bnode_upper(tree, n, key);
+		r = cl_btree_insert_sub(tree, cl_bnode_child(n, i), key, value,
+			&rkey);
+		/* A separator can't keep pointing at a replaced key */
+		if(tree->found && tree->fn_compare && i > 0 &&
+		   cl_bnode_key(tree, n, i - 1) == tree->mkey)
+			cl_bnode_set_key(tree, n, i - 1, key);
+		if(r == NULL)
+			return NULL;
+		if(n->n_keys < CL_BTREE_KEYS) {
+			cl_bnode_insert(tree, n, i, rkey, i + 1, r);
+			return NULL;
+		}
+		return cl_bnode_split(tree, n, i, rkey, r, sep);
+	}
+	i = cl_bnode_lower(tree, n, key);
+	if(i < n->n_keys && cl_btree_equal(tree, key, cl_bnode_key(tree, n, i)))
+	{
+		tree->found = true;
+		tree->mkey = cl_bnode_key(tree, n, i);
+		tree->mvalue = n->links[i];
+		cl_bnode_set_key(tree, n, i, key);
+		n->links[i] = (void *)value;	/* cast away const */
+		return NULL;
+	}
+	tree->n_entries++;
+	if(n->n_keys < CL_BTREE_KEYS) {
+		cl_bnode_insert(tree, n, i, key, i, (void *)value);
+		return NULL;
+	}
+	return cl_bnode_split(tree, n, i, key, (void *)value, sep);
+}
+
+/** Insert an entry into a B-tree.
+ *
+ * @param tree The tree (set or map).
+ * @param key Key to insert.
+ * @param value Value to insert (for maps).
+ * @return True if an entry with a matching key was replaced.
+ */
+static bool cl_btree_insert(struct cl_btree *tree, const void *key,
+	const void *value)
+{
+	const void *sep;
+	struct cl_bnode *r;
+	tree->found = false;
+	r = cl_btree_insert_sub(tree, tree->root, key, value, &sep);
+	if(r) {
+		struct cl_bnode *root = cl_bnode_create(tree, false);
+		root->n_keys = 1;
+		cl_bnode_set_key(tree, root, 0, sep);
+		root->links[0] = tree->root;
+		root->links[1] = r;
+		tree->root = root;
+	}
+	return tree->found;
+}
+
+/** Add a key into a B-tree set.
+ *
+ * @param tree The tree (set).
+ * @param key Key to add.
+ * @return Matching replaced key if it existed, or NULL otherwise.
+ */
+const void *cl_btree_add(struct cl_btree *tree, const void *key) {
+	assert(!tree->is_map);
+	return cl_btree_insert(tree, key, NULL) ? tree->mkey : NULL;
+}
+
+/** Put a key/value pair into a B-tree map.
+ *
+ * @param tree The tree (map).
+ * @param key Key to put.
+ * @param value Value to put.
+ * @return Value previously mapped with key if it existed, or NULL otherwise.
+ */
+const void *cl_btree_put(struct cl_btree *tree, const void *key,
+	const void *value)
+{
+	assert(tree->is_map);
+	return cl_btree_insert(tree, key, value) ? tree->mvalue : NULL;
+}
+
+/** Move keys (and links) from the front of a node to the end of another.
+ *
+ * @param tree The tree (set or map).
+ * @param dst Destination node.
+ * @param src Source node.
+ * @param n_keys Number of keys to move.
+ * @param n_links Number of links to move.
+ */
+static void cl_bnode_shift_left(const struct cl_btree *tree,
+	struct cl_bnode *dst, struct cl_bnode *src, uint32_t n_keys,
+	uint32_t n_links)
+{
+	uint32_t d_links = dst->is_leaf ? dst->n_keys : dst->n_keys + 1;
+	uint32_t s_links = src->is_leaf ? src->n_keys : src->n_keys + 1;
+	assert(dst->n_keys + n_keys <= CL_BTREE_KEYS);
+	for(uint32_t k = 0; k < n_keys; k++) {
+		cl_bnode_set_key(tree, dst, dst->n_keys + k,
+			cl_bnode_key(tree, src, k));
+	}
+	memcpy(dst->links + d_links, src->links, n_links * sizeof(void *));
+	if(tree->fn_compare) {
+		memmove(src->k.keys, src->k.keys + n_keys,
+			(src->n_keys - n_keys) * sizeof(src->k.keys[0]));
+	} else {
+		memmove(src->k.ikeys, src->k.ikeys + n_keys,
+			(src->n_keys - n_keys) * sizeof(src->k.ikeys[0]));
+	}
+	memmove(src->links, src->links + n_links,
+		(s_links - n_links) * sizeof(void *));
+	dst->n_keys += n_keys;
+	src->n_keys -= n_keys;
+}
+
+/** Borrow an entry from the left sibling of an underfull child.
+ *
+ * @param tree The tree (set or map).
+ * @param p Parent node.
+ * @param i Slot of child in parent.
+ */
+static void cl_btree_borrow_left(struct cl_btree *tree, struct cl_bnode *p,
+	uint32_t i)
+{
+	struct cl_bnode *l = cl_bnode_child(p, i - 1);
+	struct cl_bnode *c = cl_bnode_child(p, i);
+	uint32_t last = l->n_keys - 1;
+	if(c->is_leaf) {
+		cl_bnode_insert(tree, c, 0, cl_bnode_key(tree, l, last), 0,
+			l->links[last]);
+		l->n_keys--;
+		cl_bnode_set_key(tree, p, i - 1, cl_bnode_key(tree, c, 0));
+	} else {
+		cl_bnode_insert(tree, c, 0, cl_bnode_key(tree, p, i - 1), 0,
+			l->links[last + 1]);
+		cl_bnode_set_key(tree, p, i - 1, cl_bnode_key(tree, l, last));
+		l->n_keys--;
+	}
+}
+
+/** Borrow an entry from the right sibling of an underfull child.
+ *
+ * @param tree The tree (set or map).
+ * @param p Parent node.
+ * @param i Slot of child in parent.
+ */
+static void cl_btree_borrow_right(struct cl_btree *tree, struct cl_bnode *p,
+	uint32_t i)
+{
+	struct cl_bnode *c = cl_bnode_child(p, i);
+	struct cl_bnode *r = cl_bnode_child(p, i + 1);
+	if(c->is_leaf) {
+		cl_bnode_shift_left(tree, c, r, 1, 1);
+		cl_bnode_set_key(tree, p, i, cl_bnode_key(tree, r, 0));
+	} else {
+		const void *key = cl_bnode_key(tree, r, 0);
+		/* separator moves down, first key of r moves up */
+		cl_bnode_set_key(tree, c, c->n_keys, cl_bnode_key(tree, p, i));
+		c->n_keys++;
+		c->links[c->n_keys] = r->links[0];
+		cl_bnode_remove(tree, r, 0, 0);
+		cl_bnode_set_key(tree, p, i, key);
+	}
+}
+
+/** Merge a child with its right sibling.
+ *
+ * @param tree The tree (set or map).
+ * @param p Parent node.
+ * @param i Slot of (left) child in parent.
+ */
+static void cl_btree_merge(struct cl_btree *tree, struct cl_bnode *p,
+	uint32_t i)
+{
+	struct cl_bnode *c = cl_bnode_child(p, i);
+	struct cl_bnode *r = cl_bnode_child(p, i + 1);
+	if(c->is_leaf) {
+		cl_bnode_shift_left(tree, c, r, r->n_keys, r->n_keys);
+		c->next = r->next;
+	} else {
+		/* separator moves down between the keys of c and r */
+		uint32_t a = c->n_keys + 1;
+		assert(a + r->n_keys <= CL_BTREE_KEYS);
+		cl_bnode_set_key(tree, c, c->n_keys, cl_bnode_key(tree, p, i));
+		for(uint32_t k = 0; k < r->n_keys; k++)
+			cl_bnode_set_key(tree, c, a + k, cl_bnode_key(tree, r, k));
+		memcpy(c->links + a, r->links, (r->n_keys + 1) * sizeof(void *));
+		c->n_keys = a + r->n_keys;
+	}
+	cl_bnode_remove(tree, p, i, i + 1);
+	cl_pool_release(tree->pool, r);
+}
+
+/** Fix an underfull child of an inner node.
+ *
+ * @param tree The tree (set or map).
+ * @param p Parent node.
+ * @param i Slot of child in parent.
+ */
+static void cl_btree_fix(struct cl_btree *tree, struct cl_bnode *p,
+	uint32_t i)
+{
+	if(i > 0 && cl_bnode_child(p, i - 1)->n_keys > CL_BTREE_MIN)
+		cl_btree_borrow_left(tree, p, i);
+	else if(i < p->n_keys && cl_bnode_child(p, i + 1)->n_keys >
+	        CL_BTREE_MIN)
+		cl_btree_borrow_right(tree, p, i);
+	else if(i > 0)
+		cl_btree_merge(tree, p, i - 1);
+	else
+		cl_btree_merge(tree, p, i);
+}
+
+/** Get the first key in a sub-tree.
+ *
+ * @param tree The tree (set or map).
+ * @param n Root node of sub-tree.
+ * @return Lowest key in the sub-tree.
+ */
+static const void *cl_btree_first_key(const struct cl_btree *tree,
+	struct cl_bnode *n)
+{
+	while(!n->is_leaf)
+		n = cl_bnode_child(n, 0);
+	return cl_bnode_key(tree, n, 0);
+}
+
+/** Remove an entry from a sub-tree.
+ *
+ * @param tree The tree (set or map).
+ * @param n Root node of sub-tree.
+ * @param key Key to remove.
+ * @return True if the key was found.
+ */
+static bool cl_btree_remove_sub(struct cl_btree *tree, struct cl_bnode *n,
+	const void *key)
+{
+	uint32_t i;
+	if(n->is_leaf) {
+		i = cl_bnode_lower(tree, n, key);
+		if(i >= n->n_keys ||
+		   !cl_btree_equal(tree, key, cl_bnode_key(tree, n, i)))
+			return false;
+		tree->mkey = cl_bnode_key(tree, n, i);
+		tree->mvalue = n->links[i];
+		cl_bnode_remove(tree, n, i, i);
+		return true;
+	}
+	i = cl_bnode_upper(tree, n, key);
+	if(!cl_btree_remove_sub(tree, cl_bnode_child(n, i), key))
+		return false;
+	/* A separator can't keep pointing at a removed key (it may be freed) */
+	if(tree->fn_compare && i > 0 && cl_bnode_key(tree, n, i - 1) ==
+	   tree->mkey)
+	{
+		cl_bnode_set_key(tree, n, i - 1,
+			cl_btree_first_key(tree, cl_bnode_child(n, i)));
+	}
+	if(cl_bnode_child(n, i)->n_keys < CL_BTREE_MIN)
+		cl_btree_fix(tree, n, i);
+	return true;
+}
+
+/** Remove an entry from a B-tree.
+ *
+ * @param tree The tree (set or map).
+ * @param key Key to remove.
+ * @return True if the key was found.
+ */
+static bool cl_btree_remove_entry(struct cl_btree *tree, const void *key) {
+	struct cl_bnode *root = tree->root;
+	if(!cl_btree_remove_sub(tree, root, key))
+		return false;
+	tree->n_entries--;
+	if(!root->is_leaf && root->n_keys == 0) {
+		tree->root = cl_bnode_child(root, 0);
+		cl_pool_release(tree->pool, root);
+	}
+	return true;
+}
+
+/** Remove a key from a B-tree.
+ *
+ * @param tree The tree (set or map).
+ * @param key Key to remove.
+ * @return Previous key if it existed, or NULL otherwise.
+ */
+const void *cl_btree_remove_key(struct cl_btree *tree, const void *key) {
+	return cl_btree_remove_entry(tree, key) ? tree->mkey : NULL;
+}
+
+/** Remove a mapping from a B-tree map.
+ *
+ * @param tree The tree (map).
+ * @param key Key to remove.
+ * @return Previous value mapped to key if it existed, or NULL otherwise.
+ */
+const void *cl_btree_remove(struct cl_btree *tree, const void *key) {
+	assert(tree->is_map);
+	return cl_btree_remove_entry(tree, key) ? tree->mvalue : NULL;
+}
+
+/** Clear a B-tree.
+ *
+ * Remove all items from a B-tree.
+ *
+ * @param tree The tree (set or map).
+ */
+void cl_btree_clear(struct cl_btree *tree) {
+	cl_pool_clear(tree->pool);
+	tree->root = cl_bnode_create(tree, true);
+	tree->first = tree->root;
+	tree->n_entries = 0;
+}
+
+/** Add up memory statistics of a B-tree.
+ *
+ * Live objects are nodes, not entries.
+ *
+ * @param tree The tree (set or map).
+ * @param stats Statistics to add to (see cl_pool_stats).
+ */
+void cl_btree_stats(const struct cl_btree *tree, struct cl_pool_stats *stats) {
+	cl_pool_stats(tree->pool, stats);
+	stats->n_bytes += sizeof(struct cl_btree);
+}
+
+/** Create a B-tree iterator.
+ *
+ * The iterator starts at the first key.  Changing the tree invalidates it.
+ *
+ * @param tree The tree (set or map).
+ * @return Iterator for tree keys.
+ */
+struct cl_btree_iterator *cl_btree_iterator_create(struct cl_btree *tree) {
+	struct cl_btree_iterator *it = malloc(sizeof(struct cl_btree_iterator));
+	assert(it);
+	cl_btree_iterator_init(it, tree);
+	return it;
+}
+
+/** Initialize a B-tree iterator.
+ *
+ * Initialize a caller's iterator (which can be on the stack) at the first
+ * key.  It doesn't need to be destroyed.
+ *
+ * @param it The iterator.
+ * @param tree The tree (set or map).
+ */
+void cl_btree_iterator_init(struct cl_btree_iterator *it,
+	struct cl_btree *tree)
+{
+	it->tree = tree;
+	it->leaf = tree->first;
+	it->slot = 0;
+	it->value = NULL;
+}
+
+/** Destroy a B-tree iterator.
+ *
+ * @param it The B-tree iterator.
+ */
+void cl_btree_iterator_destroy(struct cl_btree_iterator *it) {
+	assert(it);
+#ifndef NDEBUG
+	it->tree = NULL;
+	it->leaf = NULL;
+#endif
+	free(it);
+}
+
+/** Move a B-tree iterator to a key.
+ *
+ * The next key from the iterator will be the first key not less than key,
+ * so a range scan is a seek followed by calls to next.
+ *
+ * @param it The iterator.
+ * @param key Key to seek.
+ */
+void cl_btree_iterator_seek(struct cl_btree_iterator *it, const void *key) {
+	it->leaf = cl_btree_search(it->tree, key);
+	it->slot = cl_bnode_lower(it->tree, it->leaf, key);
+	it->value = NULL;
+}
+
+/** Get next key from a B-tree iterator.
+ *
+ * @param it The iterator.
+ * @return Next key, or NULL if no more keys.
+ */
+const void *cl_btree_iterator_next(struct cl_btree_iterator *it) {
+	struct cl_bnode *n = it->leaf;
+	while(n && it->slot >= n->n_keys) {
+		n = n->next;
+		it->slot = 0;
+	}
+	it->leaf = n;
+	if(n == NULL) {
+		it->value = NULL;
+		return NULL;
+	}
+	it->value = n->links[it->slot];
+	return cl_bnode_key(it->tree, n, it->slot++);
+}
+
+/** Get the value associated with most recent key from a B-tree iterator.
+ *
+ * @param it The iterator.
+ * @return Value associated with most recent key returned, or NULL.
+ */
+const void *cl_btree_iterator_value(struct cl_btree_iterator *it) {
+	assert(it->tree->is_map);
+	return it->value;
+}
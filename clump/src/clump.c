@@ -7,7 +7,15 @@
  *
  *	cl_compare_int		Compare two integers for sorting
  * 	cl_compare_ptr		Compare two pointers for sorting
+ *	cl_hash_bytes		Hash function for a run of bytes
+ *	cl_hash_mix		Mix the bits of a 64-bit value
+ *	cl_alloc_malloc		Allocate memory with an allocator
+ *	cl_alloc_calloc		Allocate zeroed memory with an allocator
+ *	cl_alloc_realloc	Resize memory with an allocator
+ *	cl_alloc_free		Free memory with an allocator
  */
+#include <assert.h>
+#include <string.h>
 #include "clump.h"
 
 /** Clump library version */
@@ -20,13 +28,9 @@ const char *CL_VERSION = "0.8.1";
  * @return One of CL_LESS, CL_GREATER or CL_EQUAL.
  */
 cl_compare_t cl_compare_int(const void *v0, const void *v1) {
-	int i0 = (int)(long)v0;
-	int i1 = (int)(long)v1;
-	if(i0 > i1)
-		return CL_GREATER;
-	if(i0 < i1)
-		return CL_LESS;
-	return CL_EQUAL;
+	int i0 = (int)(intptr_t)v0;
+	int i1 = (int)(intptr_t)v1;
+	return (cl_compare_t)((i0 > i1) - (i0 < i1));
 }
 
 /** Pointer compare function.
@@ -42,3 +46,163 @@ cl_compare_t cl_compare_ptr(const void *v0, const void *v1) {
 		return CL_LESS;
 	return CL_EQUAL;
 }
+
+/* Hash constants (primes from xxHash64) */
+static const uint64_t CL_HASH_P1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t CL_HASH_P2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t CL_HASH_P3 = 0x165667B19E3779F9ULL;
+static const uint64_t CL_HASH_P4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t CL_HASH_P5 = 0x27D4EB2F165667C5ULL;
+
+/** Rotate a 64-bit value left.
+ */
+static uint64_t cl_hash_rotl(uint64_t v, int r) {
+	return (v << r) | (v >> (64 - r));
+}
+
+/** Mix the bits of a 64-bit value.
+ *
+ * Every bit of the result depends on every bit of the value, so it can be used
+ * as a hash code for integers and pointers.
+ *
+ * @param v Value to mix.
+ * @return Mixed value.
+ */
+uint64_t cl_hash_mix(uint64_t v) {
+	v ^= v >> 33;
+	v *= CL_HASH_P2;
+	v ^= v >> 29;
+	v *= CL_HASH_P3;
+	v ^= v >> 32;
+	return v;
+}
+
+/** Hash function for a run of bytes.
+ *
+ * Hashes 8 bytes at a time (like xxHash64 for short keys).  A seed other
+ * than 0 gives unrelated hash codes, so keys chosen to collide for one seed
+ * (from a network, for example) don't collide for another.
+ *
+ * @param key Pointer to the bytes.
+ * @param n_bytes Number of bytes.
+ * @param seed Hash seed.
+ * @return Hash code.
+ */
+uint32_t cl_hash_bytes(const void *key, size_t n_bytes, uint64_t seed) {
+	const uint8_t *p = key;
+	uint64_t h = seed + CL_HASH_P5 + n_bytes;
+	for(; n_bytes >= 8; n_bytes -= 8, p += 8) {
+		uint64_t w;
+		memcpy(&w, p, 8);
+		h ^= cl_hash_rotl(w * CL_HASH_P2, 31) * CL_HASH_P1;
+		h = cl_hash_rotl(h, 27) * CL_HASH_P1 + CL_HASH_P4;
+	}
+	if(n_bytes >= 4) {
+		uint32_t w;
+		memcpy(&w, p, 4);
+		h ^= w * CL_HASH_P1;
+		h = cl_hash_rotl(h, 23) * CL_HASH_P2 + CL_HASH_P3;
+		n_bytes -= 4;
+		p += 4;
+	}
+	for(; n_bytes > 0; n_bytes--, p++) {
+		h ^= *p * CL_HASH_P5;
+		h = cl_hash_rotl(h, 11) * CL_HASH_P1;
+	}
+	return (uint32_t)cl_hash_mix(h);
+}
+
+/** Allocate with malloc (for cl_alloc_default).
+ */
+static void *cl_alloc_std_malloc(void *ctx, size_t n) {
+	return malloc(n);
+}
+
+/** Resize with realloc (for cl_alloc_default).
+ */
+static void *cl_alloc_std_realloc(void *ctx, void *m, size_t n_old, size_t n)
+{
+	return realloc(m, n);
+}
+
+/** Free with free (for cl_alloc_default).
+ */
+static void cl_alloc_std_free(void *ctx, void *m, size_t n) {
+	free(m);
+}
+
+/** Default allocator: malloc, realloc and free */
+const struct cl_alloc cl_alloc_default = {
+	cl_alloc_std_malloc, cl_alloc_std_realloc, cl_alloc_std_free, NULL
+};
+
+/** Allocate memory with an allocator.
+ *
+ * @param al Allocator.
+ * @param n Number of bytes.
+ * @return Pointer to allocated memory (never NULL).
+ */
+void *cl_alloc_malloc(const struct cl_alloc *al, size_t n) {
+	void *m = al->fn_malloc(al->ctx, n);
+	assert(m);
+	return m;
+}
+
+/** Allocate zeroed memory with an allocator.
+ *
+ * The default allocator uses calloc, which can skip zeroing fresh pages.
+ *
+ * @param al Allocator.
+ * @param n Number of bytes.
+ * @return Pointer to allocated memory (never NULL).
+ */
+void *cl_alloc_calloc(const struct cl_alloc *al, size_t n) {
+	void *m;
+	if(al == &cl_alloc_default)
+		m = calloc(1, n);
+	else if((m = al->fn_malloc(al->ctx, n)))
+		memset(m, 0, n);
+	assert(m);
+	return m;
+}
+
+/** Resize memory with an allocator.
+ *
+ * Without a realloc function, new memory is allocated and the old copied.
+ *
+ * @param al Allocator.
+ * @param m Memory to resize (or NULL).
+ * @param n_old Bytes allocated at m.
+ * @param n New number of bytes.
+ * @return Pointer to resized memory (never NULL).
+ */
+void *cl_alloc_realloc(const struct cl_alloc *al, void *m, size_t n_old,
+	size_t n)
+{
+	void *r;
+	if(al->fn_realloc)
+		r = al->fn_realloc(al->ctx, m, n_old, n);
+	else {
+		r = al->fn_malloc(al->ctx, n);
+		if(r && m) {
+			memcpy(r, m, n_old < n ? n_old : n);
+			cl_alloc_free(al, m, n_old);
+		}
+	}
+	assert(r);
+	return r;
+}
+
+/** Free memory with an allocator.
+ *
+ * An allocator without a free function only gives memory back all at once
+ * (like an arena), so nothing is done.
+ *
+ * @param al Allocator.
+ * @param m Memory to free (or NULL).
+ * @param n Bytes allocated at m.
+ */
+void cl_alloc_free(const struct cl_alloc *al, void *m, size_t n) {
+	if(m && al->fn_free)
+		al->fn_free(al->ctx, m, n);
+}
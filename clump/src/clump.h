@@ -2,6 +2,7 @@
 #define CLUMP_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 
@@ -23,15 +24,85 @@ cl_compare_t cl_compare_ptr(const void *v0, const void *v1);
 /** Hash code function callback */
 typedef uint32_t (cl_hash_cb) (const void *key);
 
+/** Memory allocator, for containers created "_with_alloc".
+ *
+ * Sizes are passed to every function, for allocators which need them.
+ * fn_realloc may be NULL (new memory is allocated and the old copied), and
+ * fn_free may be NULL for memory given back all at once (as by an arena).
+ * An allocator must outlive the containers using it.
+ */
+struct cl_alloc {
+	void *(*fn_malloc) (void *ctx, size_t n);	/**< allocate */
+	void *(*fn_realloc) (void *ctx, void *m, size_t n_old, size_t n);
+							/**< resize */
+	void (*fn_free) (void *ctx, void *m, size_t n);	/**< free */
+	void *ctx;					/**< context */
+};
+
+/* Allocator functions */
+extern const struct cl_alloc cl_alloc_default;
+void *cl_alloc_malloc(const struct cl_alloc *al, size_t n);
+void *cl_alloc_calloc(const struct cl_alloc *al, size_t n);
+void *cl_alloc_realloc(const struct cl_alloc *al, void *m, size_t n_old,
+	size_t n);
+void cl_alloc_free(const struct cl_alloc *al, void *m, size_t n);
+
+/** Memory pool flags */
+#define CL_POOL_MMAP	(1 << 0)	/*< map blocks with mmap */
+#define CL_POOL_HUGE	(1 << 1)	/*< map blocks with huge pages */
+
+/** Memory statistics, added up by cl_pool_stats (and container stats).
+ */
+struct cl_pool_stats {
+	uint32_t	n_pools;	/**< pools (or hash tables) counted */
+	uint32_t	n_blocks;	/**< blocks holding objects */
+	uint32_t	n_spare;	/**< free blocks kept for reuse */
+	uint32_t	n_live;		/**< live objects (or hash entries) */
+	uint32_t	n_high;		/**< high-water mark of live objects */
+	uint32_t	n_free;		/**< free slots in blocks holding objects */
+	size_t		n_bytes;	/**< bytes held */
+	size_t		n_used;		/**< bytes of live objects */
+};
+
+/** Mark of the memory allocated from an arena (see cl_arena_mark).
+ */
+struct cl_arena_mark {
+	void		*chunk;		/**< current chunk */
+	size_t		n_used;		/**< bytes used in chunk */
+	size_t		n_alloc;	/**< bytes allocated by callers */
+};
+
+/* Memory arena functions */
+struct cl_arena *cl_arena_create(size_t n_chunk);
+struct cl_arena *cl_arena_create_with_alloc(size_t n_chunk,
+	const struct cl_alloc *al);
+void cl_arena_destroy(struct cl_arena *a);
+void *cl_arena_alloc(struct cl_arena *a, size_t n, size_t align);
+struct cl_arena_mark cl_arena_mark(const struct cl_arena *a);
+void cl_arena_release(struct cl_arena *a, struct cl_arena_mark mark);
+void cl_arena_reset(struct cl_arena *a);
+void cl_arena_shrink(struct cl_arena *a);
+void cl_arena_stats(const struct cl_arena *a, struct cl_pool_stats *stats);
+const struct cl_alloc *cl_arena_allocator(struct cl_arena *a);
+
 /* Memory pool functions */
 struct cl_pool *cl_pool_create(uint32_t s);
+struct cl_pool *cl_pool_create_ex(uint32_t s, uint32_t align, size_t n_block,
+	uint32_t flags);
+struct cl_pool *cl_pool_create_with_alloc(uint32_t s,
+	const struct cl_alloc *al);
+struct cl_pool *cl_pool_create_arena(uint32_t s, struct cl_arena *arena);
 void cl_pool_destroy(struct cl_pool *p);
 void *cl_pool_alloc(struct cl_pool *p);
 void cl_pool_release(struct cl_pool *p, void *m);
 void cl_pool_clear(struct cl_pool *p);
+void cl_pool_reserve(struct cl_pool *p, uint32_t n);
+void cl_pool_shrink(struct cl_pool *p);
+void cl_pool_stats(const struct cl_pool *p, struct cl_pool_stats *stats);
 
 /* Bit array functions */
 struct cl_bitarray *cl_bitarray_create(void);
+struct cl_bitarray *cl_bitarray_create_with_alloc(const struct cl_alloc *al);
 void cl_bitarray_destroy(struct cl_bitarray *ba);
 void cl_bitarray_wrap(struct cl_bitarray *ba, unsigned char *buf,
 	unsigned int n_bits);
@@ -48,21 +119,89 @@ int cl_bitarray_set_range(struct cl_bitarray *ba, unsigned int i,
 	unsigned int n, unsigned int v);
 int cl_bitarray_push_range(struct cl_bitarray *ba, unsigned int n,
 	unsigned int v);
+uint32_t cl_bitarray_peek(struct cl_bitarray *ba, unsigned int n);
+void cl_bitarray_skip(struct cl_bitarray *ba, unsigned int n);
+unsigned int cl_bitarray_remaining(struct cl_bitarray *ba);
+unsigned int cl_bitarray_popcount(struct cl_bitarray *ba);
+int cl_bitarray_find_first_set(struct cl_bitarray *ba, unsigned int i);
+
+/** Bit set iterator (can be on the stack).
+ */
+struct cl_bitset_iterator {
+	const struct cl_bitset	*set;		/**< bit set */
+	uint32_t		chunk;		/**< current chunk */
+	uint32_t		i;		/**< next index in chunk */
+};
+
+/** Iterate over the members of a bit set, with v a uint32_t */
+#define CL_BITSET_FOREACH(it, set, v) \
+	for(cl_bitset_iterator_init(&(it), (set)); \
+	    cl_bitset_iterator_next(&(it), &(v)); )
+
+/* Bit set functions */
+struct cl_bitset *cl_bitset_create(void);
+struct cl_bitset *cl_bitset_copy(const struct cl_bitset *bs);
+void cl_bitset_destroy(struct cl_bitset *bs);
+void cl_bitset_clear(struct cl_bitset *bs);
+bool cl_bitset_is_empty(const struct cl_bitset *bs);
+uint64_t cl_bitset_count(const struct cl_bitset *bs);
+bool cl_bitset_contains(const struct cl_bitset *bs, uint32_t v);
+bool cl_bitset_add(struct cl_bitset *bs, uint32_t v);
+bool cl_bitset_remove(struct cl_bitset *bs, uint32_t v);
+void cl_bitset_union(struct cl_bitset *bs, const struct cl_bitset *other);
+void cl_bitset_intersect(struct cl_bitset *bs, const struct cl_bitset *other);
+void cl_bitset_difference(struct cl_bitset *bs,
+	const struct cl_bitset *other);
+bool cl_bitset_equals(const struct cl_bitset *bs,
+	const struct cl_bitset *other);
+void cl_bitset_iterator_init(struct cl_bitset_iterator *it,
+	const struct cl_bitset *bs);
+bool cl_bitset_iterator_next(struct cl_bitset_iterator *it, uint32_t *v);
 
 /* Array functions */
 struct cl_array *cl_array_create(size_t s, uint32_t n);
+struct cl_array *cl_array_create_ex(size_t s, uint32_t n, uint32_t align);
+struct cl_array *cl_array_create_with_alloc(const struct cl_alloc *al,
+	size_t s, uint32_t n, uint32_t align);
+struct cl_array *cl_array_create_arena(struct cl_arena *arena, size_t s,
+	uint32_t n);
+struct cl_array *cl_array_wrap(const void *ptr, size_t s, uint32_t n);
+struct cl_array *cl_array_wrap_fixed(void *ptr, size_t s, uint32_t n_size,
+	uint32_t n_items);
+void cl_array_set_growth(struct cl_array *arr, uint32_t percent);
 void cl_array_destroy(struct cl_array *arr);
 bool cl_array_is_empty(struct cl_array *arr);
 uint32_t cl_array_count(struct cl_array *arr);
 void *cl_array_borrow(struct cl_array *arr, uint32_t i);
 void *cl_array_add(struct cl_array *arr);
+void *cl_array_append_n(struct cl_array *arr, const void *items, uint32_t n);
 void *cl_array_insert(struct cl_array *arr, uint32_t i);
+void *cl_array_insert_n(struct cl_array *arr, uint32_t i, const void *items,
+	uint32_t n);
 bool cl_array_remove(struct cl_array *arr, uint32_t i);
+bool cl_array_remove_range(struct cl_array *arr, uint32_t i, uint32_t n);
 void *cl_array_pop(struct cl_array *arr);
 void cl_array_clear(struct cl_array *arr);
+void cl_array_reserve(struct cl_array *arr, uint32_t n);
+void cl_array_shrink(struct cl_array *arr);
+bool cl_array_resize(struct cl_array *arr, uint32_t n);
+
+/** Linked list iterator (can be on the stack).
+ */
+struct cl_list_iterator {
+	struct cl_list		*list;		/**< list */
+	struct cl_list_node	*prev;		/**< previous list node */
+};
+
+/** Iterate over the items of a list, with it a struct cl_list_iterator */
+#define CL_LIST_FOREACH(it, list, item) \
+	for(cl_list_iterator_init(&(it), (list)); \
+	    ((item) = cl_list_iterator_next(&(it))) != NULL; )
 
 /* Linked list functions */
 struct cl_list *cl_list_create(void);
+struct cl_list *cl_list_create_with_alloc(const struct cl_alloc *al);
+struct cl_list *cl_list_create_arena(struct cl_arena *arena);
 void cl_list_destroy(struct cl_list *list);
 bool cl_list_is_empty(struct cl_list *list);
 unsigned int cl_list_count(struct cl_list *list);
@@ -72,16 +211,143 @@ void *cl_list_remove(struct cl_list *list, void *item);
 bool cl_list_contains(struct cl_list *list, void *item);
 void *cl_list_pop(struct cl_list *list);
 void cl_list_clear(struct cl_list *list);
+void cl_list_reserve(struct cl_list *list, uint32_t n);
+void cl_list_shrink(struct cl_list *list);
+void cl_list_stats(const struct cl_list *list, struct cl_pool_stats *stats);
 struct cl_list_iterator *cl_list_iterator_create(struct cl_list *list);
+void cl_list_iterator_init(struct cl_list_iterator *it, struct cl_list *list);
 void cl_list_iterator_destroy(struct cl_list_iterator *it);
 void *cl_list_iterator_next(struct cl_list_iterator *it);
 void cl_list_iterator_remove(struct cl_list_iterator *it);
 
+/** Unrolled list iterator (can be on the stack).
+ */
+struct cl_ulist_iterator {
+	struct cl_ulist		*list;		/**< list */
+	struct cl_ulist_chunk	*chunk;		/**< current chunk */
+	struct cl_ulist_chunk	*prev;		/**< previous chunk */
+	uint32_t		slot;		/**< current slot in chunk */
+	bool			pending;	/**< current not returned yet */
+};
+
+/** Iterate over the items of an unrolled list */
+#define CL_ULIST_FOREACH(it, list, item) \
+	for(cl_ulist_iterator_init(&(it), (list)); \
+	    ((item) = cl_ulist_iterator_next(&(it))) != NULL; )
+
+/* Unrolled list functions */
+struct cl_ulist *cl_ulist_create(void);
+void cl_ulist_destroy(struct cl_ulist *list);
+bool cl_ulist_is_empty(struct cl_ulist *list);
+unsigned int cl_ulist_count(struct cl_ulist *list);
+void *cl_ulist_add(struct cl_ulist *list, void *item);
+void *cl_ulist_add_tail(struct cl_ulist *list, void *item);
+void *cl_ulist_remove(struct cl_ulist *list, void *item);
+bool cl_ulist_contains(struct cl_ulist *list, void *item);
+void *cl_ulist_pop(struct cl_ulist *list);
+void cl_ulist_clear(struct cl_ulist *list);
+void cl_ulist_reserve(struct cl_ulist *list, uint32_t n);
+void cl_ulist_shrink(struct cl_ulist *list);
+void cl_ulist_stats(const struct cl_ulist *list, struct cl_pool_stats *stats);
+struct cl_ulist_iterator *cl_ulist_iterator_create(struct cl_ulist *list);
+void cl_ulist_iterator_init(struct cl_ulist_iterator *it,
+	struct cl_ulist *list);
+void cl_ulist_iterator_destroy(struct cl_ulist_iterator *it);
+void *cl_ulist_iterator_next(struct cl_ulist_iterator *it);
+void cl_ulist_iterator_remove(struct cl_ulist_iterator *it);
+
+/** Link of an item in an intrusive list (embedded in the item).
+ */
+struct cl_ilist_link {
+	struct cl_ilist_link	*next;		/**< next link */
+	struct cl_ilist_link	*prev;		/**< previous link */
+};
+
+/** Intrusive list (can be on the stack, or in another struct).
+ */
+struct cl_ilist {
+	struct cl_ilist_link	head;		/**< head (and tail) link */
+	size_t			offset;		/**< offset of link in items */
+	uint32_t		n_entries;	/**< count of items */
+};
+
+/** Initialize an intrusive list of items of type, linked by member */
+#define CL_ILIST_INIT(list, type, member) \
+	cl_ilist_init((list), offsetof(type, member))
+
+/** Iterate over the items of an intrusive list (don't remove item) */
+#define CL_ILIST_FOREACH(list, item) \
+	for((item) = cl_ilist_first(list); (item) != NULL; \
+	    (item) = cl_ilist_next((list), (item)))
+
+/* Intrusive list functions */
+void cl_ilist_init(struct cl_ilist *list, size_t offset);
+bool cl_ilist_is_empty(const struct cl_ilist *list);
+uint32_t cl_ilist_count(const struct cl_ilist *list);
+void cl_ilist_add(struct cl_ilist *list, void *item);
+void cl_ilist_add_tail(struct cl_ilist *list, void *item);
+void cl_ilist_remove(struct cl_ilist *list, void *item);
+void *cl_ilist_pop(struct cl_ilist *list);
+void cl_ilist_clear(struct cl_ilist *list);
+void *cl_ilist_first(const struct cl_ilist *list);
+void *cl_ilist_next(const struct cl_ilist *list, const void *item);
+
+/** Hash iterator (can be on the stack).
+ */
+struct cl_hash_iterator {
+	struct cl_hash		*hash;	/**< hash struct */
+	struct cl_hash_entry	*curr;	/**< current entry */
+	uint32_t		bucket;	/**< next slot (old table first) */
+};
+
+/** Iterate over the keys of a hash, with it a struct cl_hash_iterator */
+#define CL_HASH_FOREACH(it, hash, key) \
+	for(cl_hash_iterator_init(&(it), (hash)); \
+	    ((key) = cl_hash_iterator_next(&(it))) != NULL; )
+
+/** Buckets of a probe length histogram (the last counts longer probes) */
+#define CL_PROBE_BUCKETS	16
+
+/** Probe statistics of one hash table (see struct cl_probe_stats).
+ */
+struct cl_probe_table {
+	uint32_t	n_size;		/**< slots in table (0 if none) */
+	uint32_t	n_entries;	/**< entries in table */
+	uint32_t	n_max;		/**< longest probe length */
+	uint64_t	n_total;	/**< sum of probe lengths */
+	uint32_t	hist[CL_PROBE_BUCKETS];	/**< entries by probe length */
+};
+
+/** Probe statistics of a hash, from cl_hash_probe_stats or
+ * cl_rhash_probe_stats.
+ *
+ * The probe length of an entry is its distance from its first slot, so a
+ * lookup of it reads n + 1 slots.  A hash being resized has two tables.
+ */
+struct cl_probe_stats {
+	struct cl_probe_table	lo;	/**< old (hash) or low (rhash) table */
+	struct cl_probe_table	hi;	/**< new (hash) or high (rhash) table */
+	uint32_t	n_migrate;	/**< entries left to move to finish a
+					     resize */
+};
+
 /* Hash set/map functions */
 struct cl_hash *cl_hash_create_set(cl_hash_cb *hash_func,
 	cl_compare_cb *compare);
 struct cl_hash *cl_hash_create_map(cl_hash_cb *hash_func,
 	cl_compare_cb *compare);
+struct cl_hash *cl_hash_create_set_sized(cl_hash_cb *hash_func,
+	cl_compare_cb *compare, uint32_t n);
+struct cl_hash *cl_hash_create_map_sized(cl_hash_cb *hash_func,
+	cl_compare_cb *compare, uint32_t n);
+struct cl_hash *cl_hash_create_set_with_alloc(const struct cl_alloc *al,
+	cl_hash_cb *hash_func, cl_compare_cb *compare);
+struct cl_hash *cl_hash_create_map_with_alloc(const struct cl_alloc *al,
+	cl_hash_cb *hash_func, cl_compare_cb *compare);
+struct cl_hash *cl_hash_create_set_arena(struct cl_arena *arena,
+	cl_hash_cb *hash_func, cl_compare_cb *compare);
+struct cl_hash *cl_hash_create_map_arena(struct cl_arena *arena,
+	cl_hash_cb *hash_func, cl_compare_cb *compare);
 void cl_hash_destroy(struct cl_hash *hash);
 uint32_t cl_hash_count(const struct cl_hash *hash);
 bool cl_hash_contains(struct cl_hash *hash, const void *key);
@@ -93,53 +359,450 @@ const void *cl_hash_put(struct cl_hash *hash, const void *key,
 	const void *value);
 const void *cl_hash_remove(struct cl_hash *hash, const void *key);
 void cl_hash_clear(struct cl_hash *hash);
+void cl_hash_reserve(struct cl_hash *hash, uint32_t n);
+void cl_hash_shrink_to_fit(struct cl_hash *hash);
+void cl_hash_stats(const struct cl_hash *hash, struct cl_pool_stats *stats);
+void cl_hash_probe_stats(const struct cl_hash *hash,
+	struct cl_probe_stats *stats);
 struct cl_hash_iterator *cl_hash_iterator_create(struct cl_hash *hash);
+void cl_hash_iterator_init(struct cl_hash_iterator *it, struct cl_hash *hash);
 void cl_hash_iterator_destroy(struct cl_hash_iterator *it);
 const void *cl_hash_iterator_next(struct cl_hash_iterator *it);
 const void *cl_hash_iterator_value(struct cl_hash_iterator *it);
+uint32_t cl_hash_bytes(const void *key, size_t n_bytes, uint64_t seed);
+
+/** Link of an item in an intrusive hash (embedded in the item).
+ */
+struct cl_ihash_link {
+	struct cl_ihash_link	*next;		/**< next link in chain */
+	struct cl_ihash_link	**pprev;	/**< pointer to this link */
+	uint32_t		hcode;		/**< hash code of item */
+};
+
+/** Bucket array of an intrusive hash.
+ */
+struct cl_ihash_table {
+	struct cl_ihash_link	**buckets;	/**< chain heads */
+	uint32_t		n_size;		/**< buckets (power of 2) */
+};
+
+/** Intrusive hash-set (can be on the stack, or in another struct).
+ */
+struct cl_ihash {
+	struct cl_ihash_table	h_new;		/**< current buckets */
+	struct cl_ihash_table	h_old;		/**< buckets being moved */
+	cl_hash_cb		*fn_hash;	/**< hash code function */
+	cl_compare_cb		*fn_compare;	/**< key compare function */
+	size_t			offset;		/**< offset of link in items */
+	uint32_t		n_migrate;	/**< next old bucket to move */
+	uint32_t		n_entries;	/**< count of items */
+};
+
+/** Intrusive hash iterator (can be on the stack).
+ */
+struct cl_ihash_iterator {
+	const struct cl_ihash	*hash;		/**< the hash */
+	struct cl_ihash_link	*next;		/**< next link */
+	uint32_t		bucket;		/**< next bucket */
+	bool			old;		/**< scanning old buckets */
+};
+
+/** Initialize an intrusive hash of items of type, linked by member */
+#define CL_IHASH_INIT(hash, type, member, fn_hash, fn_compare) \
+	cl_ihash_init((hash), offsetof(type, member), (fn_hash), (fn_compare))
+
+/** Iterate over the items of an intrusive hash */
+#define CL_IHASH_FOREACH(it, hash, item) \
+	for(cl_ihash_iterator_init(&(it), (hash)); \
+	    ((item) = cl_ihash_iterator_next(&(it))) != NULL; )
+
+/* Intrusive hash functions */
+void cl_ihash_init(struct cl_ihash *hash, size_t offset, cl_hash_cb *fn_hash,
+	cl_compare_cb *fn_compare);
+void cl_ihash_fini(struct cl_ihash *hash);
+uint32_t cl_ihash_count(const struct cl_ihash *hash);
+void *cl_ihash_get(const struct cl_ihash *hash, const void *key);
+void *cl_ihash_add(struct cl_ihash *hash, void *item);
+void cl_ihash_remove(struct cl_ihash *hash, void *item);
+void *cl_ihash_remove_key(struct cl_ihash *hash, const void *key);
+void cl_ihash_clear(struct cl_ihash *hash);
+void cl_ihash_iterator_init(struct cl_ihash_iterator *it,
+	const struct cl_ihash *hash);
+void *cl_ihash_iterator_next(struct cl_ihash_iterator *it);
+uint64_t cl_hash_mix(uint64_t v);
 uint32_t cl_hash_str(const void *v);
 uint32_t cl_hash_int(const void *v);
 uint32_t cl_hash_ptr(const void *v);
 
+/* Bloom filter functions */
+struct cl_bloom *cl_bloom_create(uint32_t n_keys, uint32_t bits_per_key);
+void cl_bloom_destroy(struct cl_bloom *bf);
+uint32_t cl_bloom_capacity(const struct cl_bloom *bf);
+size_t cl_bloom_bytes(const struct cl_bloom *bf);
+void cl_bloom_clear(struct cl_bloom *bf);
+void cl_bloom_add(struct cl_bloom *bf, uint64_t hcode);
+bool cl_bloom_contains(const struct cl_bloom *bf, uint64_t hcode);
+
+/* Cuckoo filter functions */
+struct cl_cuckoo *cl_cuckoo_create(uint32_t n_keys);
+void cl_cuckoo_destroy(struct cl_cuckoo *cf);
+uint32_t cl_cuckoo_count(const struct cl_cuckoo *cf);
+void cl_cuckoo_clear(struct cl_cuckoo *cf);
+bool cl_cuckoo_add(struct cl_cuckoo *cf, uint64_t hcode);
+bool cl_cuckoo_contains(const struct cl_cuckoo *cf, uint64_t hcode);
+bool cl_cuckoo_remove(struct cl_cuckoo *cf, uint64_t hcode);
+
+/** RHash iterator (can be on the stack).
+ */
+struct cl_rhash_iterator {
+	struct cl_rhash		*hash;		/**< hash struct */
+	uint32_t		n_table;	/**< table number */
+	uint32_t		n_slot;		/**< current slot */
+	uint32_t		n_edit;		/**< edit version number (for
+						     debugging) */
+};
+
+/** Iterate over the keys of an rhash, with it a struct cl_rhash_iterator */
+#define CL_RHASH_FOREACH(it, hash, key) \
+	for(cl_rhash_iterator_init(&(it), (hash)); \
+	    ((key) = cl_rhash_iterator_next(&(it))) != NULL; )
+
 /* RHash set/map functions */
+#define CL_RHASH_INLINE_BYTES 32	/*< largest inline key */
 struct cl_rhash *cl_rhash_create_set(uint16_t key_bytes);
 struct cl_rhash *cl_rhash_create_map(uint16_t key_bytes);
+struct cl_rhash *cl_rhash_create_set_hashed(uint16_t key_bytes);
+struct cl_rhash *cl_rhash_create_map_hashed(uint16_t key_bytes);
+struct cl_rhash *cl_rhash_create_set_inline(uint16_t key_bytes);
+struct cl_rhash *cl_rhash_create_map_inline(uint16_t key_bytes);
+struct cl_rhash *cl_rhash_create_set_sized(uint16_t key_bytes, uint32_t n);
+struct cl_rhash *cl_rhash_create_map_sized(uint16_t key_bytes, uint32_t n);
+struct cl_rhash *cl_rhash_create_set_with_alloc(const struct cl_alloc *al,
+	uint16_t key_bytes);
+struct cl_rhash *cl_rhash_create_map_with_alloc(const struct cl_alloc *al,
+	uint16_t key_bytes);
+void cl_rhash_seed(struct cl_rhash *hash, uint64_t seed);
+void cl_rhash_filter(struct cl_rhash *hash, uint32_t bits_per_key);
 void cl_rhash_destroy(struct cl_rhash *hash);
 uint32_t cl_rhash_count(const struct cl_rhash *hash);
 bool cl_rhash_contains(struct cl_rhash *hash, const void *key);
 void *cl_rhash_peek(struct cl_rhash *hash);
 const void *cl_rhash_get_key(struct cl_rhash *hash, const void *key);
 const void *cl_rhash_get(struct cl_rhash *hash, const void *key);
+uint32_t cl_rhash_get_many(struct cl_rhash *hash, const void **keys,
+	const void **values, uint32_t n_keys);
 const void *cl_rhash_add(struct cl_rhash *hash, const void *key);
+uint32_t cl_rhash_add_many(struct cl_rhash *hash, const void **keys,
+	uint32_t n_keys);
 const void *cl_rhash_put(struct cl_rhash *hash, const void *key,
 	const void *value);
 const void *cl_rhash_remove(struct cl_rhash *hash, const void *key);
 void cl_rhash_clear(struct cl_rhash *hash);
+void cl_rhash_reserve(struct cl_rhash *hash, uint32_t n);
+void cl_rhash_shrink_to_fit(struct cl_rhash *hash);
+void cl_rhash_stats(const struct cl_rhash *hash, struct cl_pool_stats *stats);
+void cl_rhash_probe_stats(const struct cl_rhash *hash,
+	struct cl_probe_stats *stats);
 struct cl_rhash_iterator *cl_rhash_iterator_create(struct cl_rhash *hash);
+void cl_rhash_iterator_init(struct cl_rhash_iterator *it,
+	struct cl_rhash *hash);
 void cl_rhash_iterator_destroy(struct cl_rhash_iterator *it);
 const void *cl_rhash_iterator_next(struct cl_rhash_iterator *it);
 const void *cl_rhash_iterator_value(struct cl_rhash_iterator *it);
 
+/** FHash iterator (can be on the stack).
+ */
+struct cl_fhash_iterator {
+	struct cl_fhash		*hash;		/**< hash struct */
+	uint32_t		n_table;	/**< table number */
+	uint32_t		n_slot;		/**< current slot */
+	uint32_t		n_edit;		/**< edit version number (for
+						     debugging) */
+};
+
+/** Iterate over the keys of an fhash, with it a struct cl_fhash_iterator */
+#define CL_FHASH_FOREACH(it, hash, key) \
+	for(cl_fhash_iterator_init(&(it), (hash)); \
+	    ((key) = cl_fhash_iterator_next(&(it))) != NULL; )
+
+/* FHash set/map functions */
+struct cl_fhash *cl_fhash_create_set(uint16_t key_bytes);
+struct cl_fhash *cl_fhash_create_map(uint16_t key_bytes);
+void cl_fhash_seed(struct cl_fhash *hash, uint64_t seed);
+void cl_fhash_destroy(struct cl_fhash *hash);
+uint32_t cl_fhash_count(const struct cl_fhash *hash);
+bool cl_fhash_contains(struct cl_fhash *hash, const void *key);
+void *cl_fhash_peek(struct cl_fhash *hash);
+const void *cl_fhash_get(struct cl_fhash *hash, const void *key);
+const void *cl_fhash_add(struct cl_fhash *hash, const void *key);
+const void *cl_fhash_put(struct cl_fhash *hash, const void *key,
+	const void *value);
+const void *cl_fhash_remove(struct cl_fhash *hash, const void *key);
+void cl_fhash_clear(struct cl_fhash *hash);
+void cl_fhash_stats(const struct cl_fhash *hash, struct cl_pool_stats *stats);
+struct cl_fhash_iterator *cl_fhash_iterator_create(struct cl_fhash *hash);
+void cl_fhash_iterator_init(struct cl_fhash_iterator *it,
+	struct cl_fhash *hash);
+void cl_fhash_iterator_destroy(struct cl_fhash_iterator *it);
+const void *cl_fhash_iterator_next(struct cl_fhash_iterator *it);
+const void *cl_fhash_iterator_value(struct cl_fhash_iterator *it);
+
+/** No handle (from cl_heap_push on a heap which is not indexed) */
+#define CL_HEAP_NONE	UINT32_MAX
+
+/* Heap priority queue functions */
+struct cl_heap *cl_heap_create(cl_compare_cb *fn_compare);
+struct cl_heap *cl_heap_create_indexed(cl_compare_cb *fn_compare);
+struct cl_heap *cl_heap_create_ex(cl_compare_cb *fn_compare, uint32_t arity,
+	bool indexed);
+void cl_heap_destroy(struct cl_heap *heap);
+bool cl_heap_is_empty(const struct cl_heap *heap);
+uint32_t cl_heap_count(const struct cl_heap *heap);
+const void *cl_heap_peek(const struct cl_heap *heap);
+uint32_t cl_heap_push(struct cl_heap *heap, const void *item);
+const void *cl_heap_pop(struct cl_heap *heap);
+const void *cl_heap_get(const struct cl_heap *heap, uint32_t h);
+void cl_heap_decrease_key(struct cl_heap *heap, uint32_t h, const void *item);
+const void *cl_heap_remove(struct cl_heap *heap, uint32_t h);
+void cl_heap_clear(struct cl_heap *heap);
+void cl_heap_reserve(struct cl_heap *heap, uint32_t n);
+void cl_heap_stats(const struct cl_heap *heap, struct cl_pool_stats *stats);
+
+/** Deepest path through a tree (a red-black tree of 2^32 keys) */
+#define CL_TREE_DEPTH 64
+
+/** Tree iterator (can be on the stack).
+ */
+struct cl_tree_iterator {
+	struct cl_tree		*tree;		/**< the tree */
+	struct cl_node		*path[CL_TREE_DEPTH]; /**< nodes left to visit,
+						     current last */
+	uint32_t		depth;		/**< length of path */
+	bool			reverse;	/**< descending key order */
+	bool			pending;	/**< current not returned yet */
+};
+
+/** Iterate over the keys of a tree, with it a struct cl_tree_iterator */
+#define CL_TREE_FOREACH(it, tree, key) \
+	for(cl_tree_iterator_init(&(it), (tree)); \
+	    ((key) = cl_tree_iterator_next(&(it))) != NULL; )
+
+/** Iterate over the keys of a tree in reverse order */
+#define CL_TREE_FOREACH_REVERSE(it, tree, key) \
+	for(cl_tree_iterator_init_reverse(&(it), (tree)); \
+	    ((key) = cl_tree_iterator_next(&(it))) != NULL; )
+
 /* Tree set/map functions */
 struct cl_tree *cl_tree_create_set(cl_compare_cb *fn_compare);
 struct cl_tree *cl_tree_create_map(cl_compare_cb *fn_compare);
+struct cl_tree *cl_tree_create_set_ranked(cl_compare_cb *fn_compare);
+struct cl_tree *cl_tree_create_map_ranked(cl_compare_cb *fn_compare);
+struct cl_tree *cl_tree_create_set_with_alloc(const struct cl_alloc *al,
+	cl_compare_cb *fn_compare);
+struct cl_tree *cl_tree_create_map_with_alloc(const struct cl_alloc *al,
+	cl_compare_cb *fn_compare);
+struct cl_tree *cl_tree_create_set_arena(struct cl_arena *arena,
+	cl_compare_cb *fn_compare);
+struct cl_tree *cl_tree_create_map_arena(struct cl_arena *arena,
+	cl_compare_cb *fn_compare);
+struct cl_tree *cl_tree_create_set_persistent(cl_compare_cb *fn_compare);
+struct cl_tree *cl_tree_create_map_persistent(cl_compare_cb *fn_compare);
 void cl_tree_destroy(struct cl_tree *tree);
 unsigned int cl_tree_count(struct cl_tree *tree);
 bool cl_tree_contains(struct cl_tree *tree, const void *key);
 const void *cl_tree_peek(struct cl_tree *tree);
 const void *cl_tree_get_key(struct cl_tree *tree, const void *key);
 const void *cl_tree_get(struct cl_tree *tree, const void *key);
+const void *cl_tree_lower_bound(struct cl_tree *tree, const void *key);
+const void *cl_tree_upper_bound(struct cl_tree *tree, const void *key);
+unsigned int cl_tree_rank(struct cl_tree *tree, const void *key);
+const void *cl_tree_select(struct cl_tree *tree, unsigned int k);
 const void *cl_tree_add(struct cl_tree *tree, const void *key);
 const void *cl_tree_put(struct cl_tree *tree, const void *key,
 	const void *value);
 const void *cl_tree_remove_key(struct cl_tree *tree, const void *key);
 const void *cl_tree_remove(struct cl_tree *tree, const void *key);
 void cl_tree_clear(struct cl_tree *tree);
+void cl_tree_build_sorted(struct cl_tree *tree, const void **keys,
+	const void **values, uint32_t n);
+void cl_tree_reserve(struct cl_tree *tree, uint32_t n);
+void cl_tree_shrink(struct cl_tree *tree);
+void cl_tree_stats(const struct cl_tree *tree, struct cl_pool_stats *stats);
+struct cl_tree *cl_tree_snapshot(struct cl_tree *tree);
+void cl_tree_snapshot_release(struct cl_tree *snap);
 struct cl_tree_iterator *cl_tree_iterator_create(struct cl_tree *tree);
+void cl_tree_iterator_init(struct cl_tree_iterator *it, struct cl_tree *tree);
+void cl_tree_iterator_init_reverse(struct cl_tree_iterator *it,
+	struct cl_tree *tree);
 void cl_tree_iterator_destroy(struct cl_tree_iterator *it);
+void cl_tree_iterator_seek(struct cl_tree_iterator *it, const void *key);
 const void *cl_tree_iterator_next(struct cl_tree_iterator *it);
 const void *cl_tree_iterator_value(struct cl_tree_iterator *it);
 
+/** Link of an item in an intrusive tree (embedded in the item).
+ */
+struct cl_itree_link {
+	struct cl_itree_link	*left;		/**< left child (and color) */
+	struct cl_itree_link	*right;		/**< right child */
+};
+
+/** Intrusive tree-set (can be on the stack, or in another struct).
+ */
+struct cl_itree {
+	struct cl_itree_link	*root;		/**< root link */
+	struct cl_itree_link	*match;		/**< link matched by add/remove */
+	cl_compare_cb		*fn_compare;	/**< key compare function */
+	size_t			offset;		/**< offset of link in items */
+	uint32_t		n_entries;	/**< count of items */
+};
+
+/** Intrusive tree iterator (can be on the stack).
+ */
+struct cl_itree_iterator {
+	const struct cl_itree	*tree;		/**< the tree */
+	struct cl_itree_link	*path[CL_TREE_DEPTH]; /**< links left to visit,
+						  * deepest last */
+	uint32_t		depth;		/**< links in path */
+	bool			pending;	/**< top of path is next */
+};
+
+/** Initialize an intrusive tree of items of type, linked by member */
+#define CL_ITREE_INIT(tree, type, member, fn_compare) \
+	cl_itree_init((tree), offsetof(type, member), (fn_compare))
+
+/** Iterate over the items of an intrusive tree */
+#define CL_ITREE_FOREACH(it, tree, item) \
+	for(cl_itree_iterator_init(&(it), (tree)); \
+	    ((item) = cl_itree_iterator_next(&(it))) != NULL; )
+
+/* Intrusive tree functions */
+void cl_itree_init(struct cl_itree *tree, size_t offset,
+	cl_compare_cb *fn_compare);
+uint32_t cl_itree_count(const struct cl_itree *tree);
+void *cl_itree_get(const struct cl_itree *tree, const void *key);
+void *cl_itree_first(const struct cl_itree *tree);
+void *cl_itree_lower_bound(const struct cl_itree *tree, const void *key);
+void *cl_itree_add(struct cl_itree *tree, void *item);
+void *cl_itree_remove_key(struct cl_itree *tree, const void *key);
+void cl_itree_remove(struct cl_itree *tree, void *item);
+void cl_itree_clear(struct cl_itree *tree);
+void cl_itree_iterator_init(struct cl_itree_iterator *it,
+	const struct cl_itree *tree);
+void cl_itree_iterator_seek(struct cl_itree_iterator *it, const void *key);
+void *cl_itree_iterator_next(struct cl_itree_iterator *it);
+
+/** B-tree iterator (can be on the stack).
+ */
+struct cl_btree_iterator {
+	struct cl_btree		*tree;		/**< the tree */
+	struct cl_bnode		*leaf;		/**< leaf of next key */
+	uint32_t		slot;		/**< slot of next key */
+	const void		*value;		/**< value of most recent key */
+};
+
+/** Iterate over the keys of a B-tree, with it a struct cl_btree_iterator */
+#define CL_BTREE_FOREACH(it, tree, key) \
+	for(cl_btree_iterator_init(&(it), (tree)); \
+	    ((key) = cl_btree_iterator_next(&(it))) != NULL; )
+
+/* B-tree set/map functions */
+struct cl_btree *cl_btree_create_set(cl_compare_cb *fn_compare);
+struct cl_btree *cl_btree_create_map(cl_compare_cb *fn_compare);
+struct cl_btree *cl_btree_create_set_int(void);
+struct cl_btree *cl_btree_create_map_int(void);
+void cl_btree_destroy(struct cl_btree *tree);
+unsigned int cl_btree_count(struct cl_btree *tree);
+bool cl_btree_contains(struct cl_btree *tree, const void *key);
+const void *cl_btree_peek(struct cl_btree *tree);
+const void *cl_btree_get_key(struct cl_btree *tree, const void *key);
+const void *cl_btree_get(struct cl_btree *tree, const void *key);
+const void *cl_btree_add(struct cl_btree *tree, const void *key);
+const void *cl_btree_put(struct cl_btree *tree, const void *key,
+	const void *value);
+const void *cl_btree_remove_key(struct cl_btree *tree, const void *key);
+const void *cl_btree_remove(struct cl_btree *tree, const void *key);
+void cl_btree_clear(struct cl_btree *tree);
+void cl_btree_stats(const struct cl_btree *tree,
+	struct cl_pool_stats *stats);
+struct cl_btree_iterator *cl_btree_iterator_create(struct cl_btree *tree);
+void cl_btree_iterator_init(struct cl_btree_iterator *it,
+	struct cl_btree *tree);
+void cl_btree_iterator_destroy(struct cl_btree_iterator *it);
+void cl_btree_iterator_seek(struct cl_btree_iterator *it, const void *key);
+const void *cl_btree_iterator_next(struct cl_btree_iterator *it);
+const void *cl_btree_iterator_value(struct cl_btree_iterator *it);
+
+/** Lookup table of a perfect hash (can be const data, see cl_phash_write_c).
+ */
+struct cl_phash_table {
+	uint32_t		n_keys;		/**< number of keys (and slots) */
+	uint32_t		n_buckets;	/**< number of buckets */
+	uint64_t		seed;		/**< hash seed */
+	uint16_t		key_bytes;	/**< bytes per key (0 for strings) */
+	const uint32_t		*disp;		/**< displacement of each bucket */
+	const char *const	*keys;		/**< key in each slot */
+};
+
+/* Perfect hash functions */
+struct cl_phash *cl_phash_create(const void *const *keys, uint32_t n_keys,
+	uint16_t key_bytes);
+struct cl_phash *cl_phash_create_rhash(struct cl_rhash *hash,
+	uint16_t key_bytes);
+void cl_phash_destroy(struct cl_phash *ph);
+const struct cl_phash_table *cl_phash_table(const struct cl_phash *ph);
+bool cl_phash_write_c(const struct cl_phash *ph, const char *name,
+	const char *path);
+uint32_t cl_phash_get(const struct cl_phash_table *tbl, const void *key);
+uint32_t cl_phash_get_bytes(const struct cl_phash_table *tbl, const void *key,
+	size_t n_bytes);
+const void *cl_phash_key(const struct cl_phash_table *tbl, uint32_t slot);
+
+/* Snapshot functions */
+bool cl_snap_write_rhash(struct cl_rhash *hash, uint16_t key_bytes,
+	uint16_t value_bytes, const char *path);
+bool cl_snap_write_tree(struct cl_tree *tree, uint16_t key_bytes,
+	uint16_t value_bytes, const char *path);
+bool cl_snap_write_btree(struct cl_btree *tree, uint16_t key_bytes,
+	uint16_t value_bytes, const char *path);
+struct cl_snap *cl_snap_open(const char *path, cl_compare_cb *fn_compare);
+void cl_snap_close(struct cl_snap *snap);
+uint32_t cl_snap_count(const struct cl_snap *snap);
+bool cl_snap_contains(const struct cl_snap *snap, const void *key);
+const void *cl_snap_get(const struct cl_snap *snap, const void *key);
+uint32_t cl_snap_seek(const struct cl_snap *snap, const void *key);
+const void *cl_snap_key(const struct cl_snap *snap, uint32_t i);
+const void *cl_snap_value(const struct cl_snap *snap, uint32_t i);
+
+/* Ring buffer (one producer, one consumer) functions */
+struct cl_ring *cl_ring_create(uint32_t n);
+void cl_ring_destroy(struct cl_ring *ring);
+uint32_t cl_ring_count(const struct cl_ring *ring);
+bool cl_ring_push(struct cl_ring *ring, void *item);
+void *cl_ring_pop(struct cl_ring *ring);
+
+/* Queue (many producers, many consumers) functions */
+struct cl_queue *cl_queue_create(uint32_t n);
+void cl_queue_destroy(struct cl_queue *queue);
+uint32_t cl_queue_count(struct cl_queue *queue);
+bool cl_queue_push(struct cl_queue *queue, void *item);
+void *cl_queue_pop(struct cl_queue *queue);
+
+/** Timer wheel expiry callback (item of an expired timer) */
+typedef void (cl_twheel_cb) (void *ctx, void *item);
+
+/* Timer wheel functions */
+struct cl_twheel *cl_twheel_create(uint64_t now);
+void cl_twheel_destroy(struct cl_twheel *wheel);
+uint32_t cl_twheel_count(struct cl_twheel *wheel);
+uint64_t cl_twheel_now(struct cl_twheel *wheel);
+uint64_t cl_twheel_add(struct cl_twheel *wheel, uint64_t delay, void *item);
+bool cl_twheel_cancel(struct cl_twheel *wheel, uint64_t timer);
+uint32_t cl_twheel_advance(struct cl_twheel *wheel, uint64_t now,
+	cl_twheel_cb *fn, void *ctx);
+bool cl_twheel_start(struct cl_twheel *wheel, uint32_t ms_tick,
+	struct cl_queue *queue);
+void cl_twheel_stop(struct cl_twheel *wheel);
+
 /* Huffman codec functions */
 struct cl_hcodec *cl_hcodec_create(void);
 void cl_hcodec_destroy(struct cl_hcodec *ht);
@@ -147,5 +810,47 @@ int cl_hcodec_encode(struct cl_hcodec *ht, const unsigned char *in,
 	unsigned int n_in, unsigned char *out, unsigned int n_out);
 int cl_hcodec_decode(struct cl_hcodec *ht, unsigned char *in,
 	unsigned int n_in, unsigned char *out, unsigned int n_out);
+void cl_hcodec_train(struct cl_hcodec *ht, const unsigned char *sample,
+	unsigned int n);
+bool cl_hcodec_get_codebook(struct cl_hcodec *ht, unsigned char n_bits[256]);
+bool cl_hcodec_set_codebook(struct cl_hcodec *ht,
+	const unsigned char n_bits[256]);
+int cl_hcodec_encode_shared(struct cl_hcodec *ht, const unsigned char *in,
+	unsigned int n_in, unsigned char *out, unsigned int n_out);
+int cl_hcodec_decode_shared(struct cl_hcodec *ht, unsigned char *in,
+	unsigned int n_in, unsigned char *out, unsigned int n_out);
+
+/** Size of blocks for cl_hcodec_encode_blocks */
+#define CL_HCODEC_BLOCK_SIZE	(4096)
+
+/** Job function callback */
+typedef void (cl_job_cb) (void *job);
+
+/** Callback to run jobs (on worker threads), returning when all are done */
+typedef void (cl_run_jobs_cb) (cl_job_cb *run, void **jobs, uint32_t n_jobs);
+
+/* Huffman multi-block functions */
+size_t cl_hcodec_blocks_bound(size_t n_in);
+size_t cl_hcodec_encode_blocks(const unsigned char *in, size_t n_in,
+	unsigned char *out, size_t n_out, cl_run_jobs_cb *run_jobs);
+size_t cl_hcodec_blocks_size(const unsigned char *in, size_t n_in);
+uint32_t cl_hcodec_blocks_count(const unsigned char *in, size_t n_in);
+int cl_hcodec_decode_block(struct cl_hcodec *ht, const unsigned char *in,
+	size_t n_in, uint32_t i, unsigned char *out, unsigned int n_out);
+bool cl_hcodec_decode_blocks(const unsigned char *in, size_t n_in,
+	unsigned char *out, size_t n_out, cl_run_jobs_cb *run_jobs);
+
+/* Sort and search functions */
+void cl_sort_u32(uint32_t *keys, size_t n);
+void cl_sort_u64(uint64_t *keys, size_t n);
+void cl_sort_bytes(void *recs, size_t n, size_t rec_bytes, size_t key_bytes);
+void cl_sort_u64_parallel(uint64_t *keys, size_t n, cl_run_jobs_cb *run_jobs);
+size_t cl_search_u32(const uint32_t *keys, size_t n, uint32_t key);
+size_t cl_search_u64(const uint64_t *keys, size_t n, uint64_t key);
+
+/* Huffman stream functions (SDL_rwops.h has the RWops structure) */
+struct SDL_RWops;
+struct SDL_RWops *cl_hstream_writer(struct SDL_RWops *rw, bool autoclose);
+struct SDL_RWops *cl_hstream_reader(struct SDL_RWops *rw, bool autoclose);
 
 #endif
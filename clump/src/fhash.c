@@ -0,0 +1,1263 @@
+/*
+ * fhash.c	A generic hash-set or -map, probed in groups
+ *
+ * Copyright (c) 2007-2014  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_fhash_create_set	Create a hash set
+ *	cl_fhash_create_map	Create a hash map
+ *	cl_fhash_seed		Set the hash seed of a hash set or map
+ *	cl_fhash_destroy	Destroy a hash set or map
+ *	cl_fhash_count		Count the entries in a hash set or map
+ *	cl_fhash_contains	Test if a hash contains a key
+ *	cl_fhash_peek		Get an arbitrary key
+ *	cl_fhash_get		Get a value from a hash map
+ *	cl_fhash_add		Add an entry to a hash set
+ *	cl_fhash_put		Put a mapping into a hash map
+ *	cl_fhash_remove		Remove a key from a hash set or map
+ *	cl_fhash_clear		Clear all entries from a hash set or map
+ *	cl_fhash_stats		Add up memory statistics of a hash
+ *	cl_fhash_iterator_create Create a hash key iterator
+ *	cl_fhash_iterator_init Initialize a hash key iterator
+ *	cl_fhash_iterator_destroy Destroy a hash key iterator
+ *	cl_fhash_iterator_next	Get the next key from an iterator
+ *	cl_fhash_iterator_value	Get the value mapped to most recent key
+ */
+/** \file
+ *
+ * The fhash module provides hash sets and hash maps with the same interface
+ * and memory layout per entry as rhash, for tables with many keys where the
+ * probes are the cost.
+ *
+ *     ITERATIVE REHASHING
+ *
+ * Resizing is done iteratively, exactly as in rhash: there are low and high
+ * tables, new entries go into the high table, and one entry is moved between
+ * the tables on each add or remove.  See rhash.c for the thresholds.
+ *
+ *     GROUP PROBING
+ *
+ * Next to the entries, each table has one control byte per slot: EMPTY,
+ * DELETED, or the low 7 bits of the entry's hash code (its tag).  The rest of
+ * the hash code picks the first slot to probe.  A probe loads the 16 control
+ * bytes from there and compares all of them with the tag at once (one SSE2
+ * instruction, or a plain loop without SSE2).  Only slots with a matching tag
+ * have their keys compared, so most probes never touch an entry that isn't
+ * the one looked for.  A group with an EMPTY slot ends the probe, otherwise
+ * the next group is probed (triangular steps of whole groups, which visit
+ * every group of a power-of-two table).
+ *
+ *   CTRL   |_12_|_80_|_3A_|_FE_|_12_|_80_| ... 16 bytes ... |
+ *   ENTRY  |_K0_|____|_K2_|____|_K4_|____| ...
+ *
+ * Looking up a key with tag 12 compares the keys K0 and K4 only.
+ *
+ * The first 16 control bytes are repeated after the last one, so a group
+ * starting near the end of the table is still one unaligned load.
+ *
+ * A removed entry's slot becomes EMPTY if every group holding that slot also
+ * has an EMPTY slot (no probe can have gone past it), otherwise DELETED.
+ * DELETED slots are reused by adds, and are counted as used: when a table has
+ * too many, it's rebuilt at the same size without them.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "clump.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** Minimum hash table order */
+static const uint16_t CL_FHASH_MIN_ORDER = 6;
+
+/** Maximum hash table order */
+static const uint16_t CL_FHASH_MAX_ORDER = 31;
+
+/** Number of control bytes probed at once */
+#define CL_FHASH_GROUP 16
+
+/** Control byte of an empty slot */
+static const uint8_t CL_FHASH_EMPTY = 0x80;
+
+/** Control byte of a slot whose entry was removed */
+static const uint8_t CL_FHASH_DELETED = 0xFE;
+
+/** Hash table structure.
+ */
+struct cl_fhash_table {
+	void			*table;		/**< actual hash table */
+	uint8_t			*ctrl;		/**< control bytes */
+	uint32_t		n_entries;	/**< number of entries */
+	uint32_t		n_deleted;	/**< number of DELETED slots */
+	uint32_t		n_peek;		/**< current peek slot */
+	uint16_t		n_bytes;	/**< number of bytes per entry*/
+	uint16_t		order;		/**< table size order */
+	uint16_t		key_bytes;	/**< key size in bytes */
+	uint64_t		seed;		/**< hash seed */
+};
+
+/** Get size of a hash table.
+ *
+ * @param tbl		pointer to hash table.
+ */
+static uint32_t cl_fhash_table_size(const struct cl_fhash_table *tbl) {
+	return 1 << tbl->order;
+}
+
+/** Get the specified hash table entry pointer.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param slot		Slot in the hash table.
+ *
+ * @return Pointer to hash table entry.
+ */
+static void **cl_fhash_table_ptr(struct cl_fhash_table *tbl, uint32_t slot) {
+	uint8_t *base = tbl->table;
+	uint32_t offset = slot * tbl->n_bytes;
+	assert(slot < cl_fhash_table_size(tbl));
+	void *ptr = base + offset;
+	return ptr;
+}
+
+/** Get a bit mask of the control bytes in a group equal to a byte.
+ *
+ * @param ctrl		Pointer to first control byte of the group.
+ * @param byte		Control byte to match.
+ *
+ * @return Bit N set if control byte N matches.
+ */
+static uint32_t cl_fhash_group_match(const uint8_t *ctrl, uint8_t byte) {
+#ifdef __SSE2__
+	__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	__m128i match = _mm_cmpeq_epi8(group, _mm_set1_epi8((char)byte));
+	return (uint32_t)_mm_movemask_epi8(match);
+#else
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < CL_FHASH_GROUP; i++) {
+		if (ctrl[i] == byte)
+			mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
+/** Get a bit mask of the EMPTY or DELETED control bytes in a group.
+ *
+ * @param ctrl		Pointer to first control byte of the group.
+ *
+ * @return Bit N set if control byte N is free.
+ */
+static uint32_t cl_fhash_group_free(const uint8_t *ctrl) {
+#ifdef __SSE2__
+	/* Tags are 7 bits, only free slots have the high bit */
+	__m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return (uint32_t)_mm_movemask_epi8(group);
+#else
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < CL_FHASH_GROUP; i++) {
+		if (ctrl[i] & 0x80)
+			mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
+/** Get the lowest set bit of a group mask.
+ *
+ * @param mask		Group mask (not zero).
+ */
+static uint32_t cl_fhash_mask_first(uint32_t mask) {
+#ifdef __GNUC__
+	return __builtin_ctz(mask);
+#else
+	uint32_t i = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+/** Count leading zero bits of a group mask.
+ *
+ * @param mask		Group mask.
+ */
+static uint32_t cl_fhash_mask_leading(uint32_t mask) {
+	uint32_t n = 0;
+	for (uint32_t bit = 1u << (CL_FHASH_GROUP - 1); bit && !(mask & bit);
+	     bit >>= 1)
+		n++;
+	return n;
+}
+
+/** Calculate a hash code for one entry.
+ *
+ * cl_hash_bytes is mixed so that both the tag (low bits) and the first slot
+ * (high bits) depend on every byte of the key.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param ent		Pointer to hash entry.
+ * @return Hash code for given key.
+ */
+static uint32_t cl_fhash_table_hash(const struct cl_fhash_table *tbl,
+	void **ent)
+{
+	size_t n_bytes = (tbl->key_bytes) ? tbl->key_bytes : strlen(*ent);
+	return cl_hash_bytes(*ent, n_bytes, tbl->seed);
+}
+
+/** Get the tag of a hash code.
+ */
+static uint8_t cl_fhash_tag(uint32_t hcode) {
+	return hcode & 0x7F;
+}
+
+/** Get the first slot to probe for a hash code.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param hcode		Hash code.
+ */
+static uint32_t cl_fhash_table_start(const struct cl_fhash_table *tbl,
+	uint32_t hcode)
+{
+	uint32_t mask = cl_fhash_table_size(tbl) - 1;
+	return (hcode >> 7) & mask;
+}
+
+/** Set the control byte of a slot (and its copy after the table).
+ *
+ * @param tbl		Pointer to hash table.
+ * @param slot		Slot in hash table.
+ * @param byte		Control byte.
+ */
+static void cl_fhash_table_set_ctrl(struct cl_fhash_table *tbl, uint32_t slot,
+	uint8_t byte)
+{
+	tbl->ctrl[slot] = byte;
+	if (slot < CL_FHASH_GROUP)
+		tbl->ctrl[cl_fhash_table_size(tbl) + slot] = byte;
+}
+
+/** Check if a hash table slot has an entry.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param slot		Slot in hash table.
+ */
+static bool cl_fhash_table_slot_full(const struct cl_fhash_table *tbl,
+	uint32_t slot)
+{
+	return !(tbl->ctrl[slot] & 0x80);
+}
+
+/** Zero out hash table.
+ *
+ * @param tbl		pointer to hash table.
+ */
+static void cl_fhash_table_zero(struct cl_fhash_table *tbl) {
+	uint32_t n_size = cl_fhash_table_size(tbl);
+	memset(tbl->table, 0, n_size * tbl->n_bytes);
+	memset(tbl->ctrl, CL_FHASH_EMPTY, n_size + CL_FHASH_GROUP);
+	tbl->n_deleted = 0;
+}
+
+/** Allocate hash table.
+ *
+ * allocate memory for hash table.
+ *
+ * @param tbl		pointer to hash table.
+ */
+static void cl_fhash_table_alloc(struct cl_fhash_table *tbl) {
+	uint32_t n_size = cl_fhash_table_size(tbl);
+	tbl->table = calloc(n_size, tbl->n_bytes);
+	assert(tbl->table);
+	tbl->ctrl = malloc(n_size + CL_FHASH_GROUP);
+	assert(tbl->ctrl);
+	memset(tbl->ctrl, CL_FHASH_EMPTY, n_size + CL_FHASH_GROUP);
+	tbl->n_deleted = 0;
+}
+
+/** Initialize a hash table.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @param n_bytes	Number of bytes per hash table entry.
+ */
+static void cl_fhash_table_init(struct cl_fhash_table *tbl, uint16_t key_bytes,
+	uint16_t n_bytes)
+{
+	tbl->order = CL_FHASH_MIN_ORDER;
+	tbl->n_entries = 0;
+	tbl->n_peek = cl_fhash_table_size(tbl);
+	tbl->key_bytes = key_bytes;
+	tbl->n_bytes = n_bytes;
+	tbl->seed = 0;
+	cl_fhash_table_alloc(tbl);
+}
+
+/** Destroy a hash table.
+ *
+ * @param tbl		Pointer to hash table.
+ */
+static void cl_fhash_table_destroy(struct cl_fhash_table *tbl) {
+	free(tbl->table);
+	free(tbl->ctrl);
+#ifndef NDEBUG
+	tbl->table = NULL;
+	tbl->ctrl = NULL;
+	tbl->order = 0;
+	tbl->n_entries = 0;
+	tbl->n_deleted = 0;
+	tbl->n_peek = 0;
+	tbl->n_bytes = 0;
+	tbl->key_bytes = 0;
+#endif
+}
+
+/** Clone one table to another.
+ *
+ * @param tbl		Pointer to hash table.
+ */
+static void cl_fhash_table_clone(struct cl_fhash_table *tbl,
+	struct cl_fhash_table *src)
+{
+	assert(tbl->n_entries == 0);
+	free(tbl->table);
+	free(tbl->ctrl);
+	tbl->table = src->table;
+	tbl->ctrl = src->ctrl;
+	tbl->n_entries = src->n_entries;
+	tbl->n_deleted = src->n_deleted;
+	tbl->n_peek = src->n_peek;
+	tbl->n_bytes = src->n_bytes;
+	tbl->order = src->order;
+	tbl->key_bytes = src->key_bytes;
+	tbl->seed = src->seed;
+}
+
+/** Update one entry in a hash table.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param slot		Slot in hash table.
+ */
+static void cl_fhash_table_entry_update(struct cl_fhash_table *tbl,
+	uint32_t slot)
+{
+	if (slot < tbl->n_peek)
+		tbl->n_peek = slot;
+}
+
+/** Clear a hash table.
+ *
+ * @param tbl		Pointer to hash table.
+ */
+static void cl_fhash_table_clear(struct cl_fhash_table *tbl) {
+	tbl->n_entries = 0;
+	tbl->n_peek = cl_fhash_table_size(tbl);
+	if (tbl->order != CL_FHASH_MIN_ORDER) {
+		free(tbl->table);
+		free(tbl->ctrl);
+		tbl->order = CL_FHASH_MIN_ORDER;
+		tbl->n_peek = cl_fhash_table_size(tbl);
+		cl_fhash_table_alloc(tbl);
+	} else
+		cl_fhash_table_zero(tbl);
+}
+
+/** Get the hash size minimum limit.
+ *
+ * @param tbl		Pointer to hash table.
+ *
+ * @return Current hash size minimum limit.
+ */
+static uint32_t cl_fhash_table_slimit(const struct cl_fhash_table *tbl) {
+	if (tbl->order > CL_FHASH_MIN_ORDER)
+		return cl_fhash_table_size(tbl) / 4;
+	else
+		return 0;
+}
+
+/** Get the hash size maximum limit.
+ *
+ * A hash table should never be more than 3/4 full, so the limit should be
+ * checked before adding a new entry.
+ *
+ * @param tbl		Pointer to hash table.
+ *
+ * @return Current hash size maximum limit.
+ */
+static uint32_t cl_fhash_table_limit(const struct cl_fhash_table *tbl) {
+	uint32_t n_size = cl_fhash_table_size(tbl);
+	return n_size - (n_size / 4);
+}
+
+/** Copy a hash table entry.
+ */
+static void cl_fhash_table_entry_copy(const struct cl_fhash_table *tbl,
+	void **dst, void **src)
+{
+	memcpy(dst, src, tbl->n_bytes);
+}
+
+/** Check if two hash table keys are equal.
+ */
+static bool cl_fhash_table_key_equals(const struct cl_fhash_table *tbl,
+	void **key1, void **key2)
+{
+	return (tbl->key_bytes)
+	      ? (memcmp(*key1, *key2, tbl->key_bytes) == 0)
+	      : (strcmp(*key1, *key2) == 0);
+}
+
+/** Peek the next entry in a hash table.
+ *
+ * @param tbl		Pointer to hash table.
+ * @return Pointer to hash table entry, or NULL if empty.
+ */
+static void **cl_fhash_table_peek_entry(struct cl_fhash_table *tbl) {
+	uint32_t n_size = cl_fhash_table_size(tbl);
+	for (uint32_t pr = tbl->n_peek; pr < n_size; pr++) {
+		if (cl_fhash_table_slot_full(tbl, pr)) {
+			tbl->n_peek = pr;
+			return cl_fhash_table_ptr(tbl, pr);
+		}
+	}
+	return NULL;
+}
+
+/** Get an arbitrary entry from a hash table.
+ *
+ * @param tbl		Pointer to hash table.
+ * @return Pointer to hash table entry, or NULL if empty.
+ */
+static void **cl_fhash_table_peek(struct cl_fhash_table *tbl) {
+	if (tbl->n_entries > 0)
+		return cl_fhash_table_peek_entry(tbl);
+	else
+		return NULL;
+}
+
+/** Find the slot of a key in a hash table.
+ *
+ * Groups are probed until the key's tag matches a slot holding the key, or a
+ * group has an EMPTY slot.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param key		Pointer to key to lookup.
+ * @param hcode		Hash code of the key.
+ * @param slot		Set to the slot found.
+ *
+ * @return true if found.
+ */
+static bool cl_fhash_table_find(struct cl_fhash_table *tbl, void **key,
+	uint32_t hcode, uint32_t *slot)
+{
+	uint32_t n_size = cl_fhash_table_size(tbl);
+	uint32_t mask = n_size - 1;
+	uint8_t tag = cl_fhash_tag(hcode);
+	uint32_t pos = cl_fhash_table_start(tbl, hcode);
+	for (uint32_t step = 0; step < n_size; step += CL_FHASH_GROUP) {
+		const uint8_t *ctrl = tbl->ctrl + pos;
+		uint32_t match = cl_fhash_group_match(ctrl, tag);
+		while (match) {
+			uint32_t s = (pos + cl_fhash_mask_first(match)) & mask;
+			if (cl_fhash_table_key_equals(tbl, key,
+			    cl_fhash_table_ptr(tbl, s)))
+			{
+				*slot = s;
+				return true;
+			}
+			match &= match - 1;
+		}
+		if (cl_fhash_group_match(ctrl, CL_FHASH_EMPTY))
+			return false;
+		pos = (pos + step + CL_FHASH_GROUP) & mask;
+	}
+	return false;
+}
+
+/** Lookup an entry in a hash table.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param key		Pointer to key to lookup.
+ *
+ * @return Pointer to hash table entry, or NULL if not found.
+ */
+static void **cl_fhash_table_entry(struct cl_fhash_table *tbl, void **key) {
+	uint32_t slot;
+	if (tbl->n_entries == 0)
+		return NULL;
+	if (cl_fhash_table_find(tbl, key, cl_fhash_table_hash(tbl, key), &slot))
+		return cl_fhash_table_ptr(tbl, slot);
+	return NULL;
+}
+
+/** Test if a hash table contains a key.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param key		Key to test for.
+ *
+ * @return True if hash table contains the key, otherwise false.
+ */
+static bool cl_fhash_table_contains(struct cl_fhash_table *tbl, void *key) {
+	return cl_fhash_table_entry(tbl, &key) != NULL;
+}
+
+/** Find the first EMPTY or DELETED slot for a hash code.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param hcode		Hash code.
+ */
+static uint32_t cl_fhash_table_find_free(struct cl_fhash_table *tbl,
+	uint32_t hcode)
+{
+	uint32_t n_size = cl_fhash_table_size(tbl);
+	uint32_t mask = n_size - 1;
+	uint32_t pos = cl_fhash_table_start(tbl, hcode);
+	for (uint32_t step = 0; step < n_size; step += CL_FHASH_GROUP) {
+		uint32_t match = cl_fhash_group_free(tbl->ctrl + pos);
+		if (match)
+			return (pos + cl_fhash_mask_first(match)) & mask;
+		pos = (pos + step + CL_FHASH_GROUP) & mask;
+	}
+	assert(false);
+	return 0;
+}
+
+/** Put an entry into a free slot of a hash table.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param ent		Pointer to hash table entry.
+ * @param hcode		Hash code of the entry's key.
+ */
+static void cl_fhash_table_place(struct cl_fhash_table *tbl, void **ent,
+	uint32_t hcode)
+{
+	uint32_t slot = cl_fhash_table_find_free(tbl, hcode);
+	if (tbl->ctrl[slot] == CL_FHASH_DELETED)
+		tbl->n_deleted--;
+	cl_fhash_table_set_ctrl(tbl, slot, cl_fhash_tag(hcode));
+	cl_fhash_table_entry_copy(tbl, cl_fhash_table_ptr(tbl, slot), ent);
+	tbl->n_entries++;
+	cl_fhash_table_entry_update(tbl, slot);
+}
+
+/** Rebuild a hash table at the same size, without DELETED slots.
+ *
+ * @param tbl		Pointer to hash table.
+ */
+static void cl_fhash_table_purge(struct cl_fhash_table *tbl) {
+	struct cl_fhash_table old = *tbl;
+	uint32_t n_size = cl_fhash_table_size(tbl);
+	tbl->n_entries = 0;
+	tbl->n_peek = n_size;
+	cl_fhash_table_alloc(tbl);
+	for (uint32_t slot = 0; slot < n_size; slot++) {
+		if (cl_fhash_table_slot_full(&old, slot)) {
+			void **e = cl_fhash_table_ptr(&old, slot);
+			cl_fhash_table_place(tbl, e,
+				cl_fhash_table_hash(tbl, e));
+		}
+	}
+	free(old.table);
+	free(old.ctrl);
+}
+
+/** Insert an entry into a hash table.
+ *
+ * If the key is already there, its entry is replaced.  Otherwise the entry
+ * goes into the first EMPTY or DELETED slot of its probe sequence.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param ent		Pointer to hash table entry.  The entry must be
+ *                      tbl->n_bytes in size.
+ * @return Pointer to previous key equal to entry key (or NULL).
+ */
+static void *cl_fhash_table_insert(struct cl_fhash_table *tbl, void **ent) {
+	uint32_t hcode = cl_fhash_table_hash(tbl, ent);
+	uint32_t slot;
+	if (cl_fhash_table_find(tbl, ent, hcode, &slot)) {
+		void **e = cl_fhash_table_ptr(tbl, slot);
+		void *key = *e;
+		cl_fhash_table_entry_copy(tbl, e, ent);
+		return key;
+	}
+	if (tbl->n_entries + tbl->n_deleted >= cl_fhash_table_limit(tbl))
+		cl_fhash_table_purge(tbl);
+	assert(tbl->n_entries < cl_fhash_table_size(tbl) - 1);
+	cl_fhash_table_place(tbl, ent, hcode);
+	return NULL;
+}
+
+/** Check if a slot can be made EMPTY when its entry is removed.
+ *
+ * It can if every group holding the slot has an EMPTY slot too, then no probe
+ * has gone past it.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param slot		Slot in hash table.
+ */
+static bool cl_fhash_table_never_full(const struct cl_fhash_table *tbl,
+	uint32_t slot)
+{
+	uint32_t mask = cl_fhash_table_size(tbl) - 1;
+	uint32_t before = (slot - CL_FHASH_GROUP) & mask;
+	uint32_t empty_before = cl_fhash_group_match(tbl->ctrl + before,
+		CL_FHASH_EMPTY);
+	uint32_t empty_after = cl_fhash_group_match(tbl->ctrl + slot,
+		CL_FHASH_EMPTY);
+	return empty_before && empty_after &&
+	       cl_fhash_mask_leading(empty_before) +
+	       cl_fhash_mask_first(empty_after) < CL_FHASH_GROUP;
+}
+
+/** Remove an entry from a hash table.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param ent		Pointer to hash table entry.  The entry must be
+ *                      tbl->n_bytes in size.
+ * @return Previous key equal to entry key, or NULL.
+ */
+static void *cl_fhash_table_remove(struct cl_fhash_table *tbl, void **ent) {
+	uint32_t slot;
+	if (tbl->n_entries == 0)
+		return NULL;
+	if (!cl_fhash_table_find(tbl, ent, cl_fhash_table_hash(tbl, ent),
+	    &slot))
+		return NULL;
+	void **e = cl_fhash_table_ptr(tbl, slot);
+	void *key = *e;
+	tbl->n_entries--;
+	if (cl_fhash_table_never_full(tbl, slot))
+		cl_fhash_table_set_ctrl(tbl, slot, CL_FHASH_EMPTY);
+	else {
+		cl_fhash_table_set_ctrl(tbl, slot, CL_FHASH_DELETED);
+		tbl->n_deleted++;
+	}
+	memset(e, 0, tbl->n_bytes);
+	return key;
+}
+
+/** Table enum (for iterators) */
+enum cl_fhash_table_num {
+	CL_FHASH_TABLE_LO, CL_FHASH_TABLE_HI, CL_FHASH_TABLE_NONE
+};
+
+/** Hash set/map structure.
+ */
+struct cl_fhash {
+	struct cl_fhash_table	h_lo;		/**< low table */
+	struct cl_fhash_table	h_hi;		/**< high table */
+	struct cl_pool		*pool;		/**< hash iterator pool */
+	bool			is_map;		/**< flag for mapping */
+#ifndef NDEBUG
+	uint32_t		n_edit;		/**< edit version number */
+#endif
+};
+
+/** Create a hash set or map.
+ *
+ * Create a hash set or map, preparing it to be used.
+ *
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @param is_map	True for map, false for set.
+ * @return Pointer to hash set or map.
+ */
+static struct cl_fhash *cl_fhash_create(uint16_t key_bytes, bool is_map) {
+	struct cl_fhash *hash = malloc(sizeof(struct cl_fhash));
+	assert(hash);
+	uint16_t n_bytes = is_map ?
+	                   sizeof(void **) * 2 :
+	                   sizeof(void **);
+	cl_fhash_table_init(&hash->h_lo, key_bytes, n_bytes);
+	cl_fhash_table_init(&hash->h_hi, key_bytes, n_bytes);
+	hash->pool = cl_pool_create(sizeof(struct cl_fhash_iterator));
+	hash->is_map = is_map;
+#ifndef NDEBUG
+	hash->n_edit = 0;
+#endif
+	return hash;
+}
+
+/** Create a hash set.
+ *
+ * Create a hash set, preparing it to be used.
+ *
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @return Pointer to hash set.
+ */
+struct cl_fhash *cl_fhash_create_set(uint16_t key_bytes) {
+	return cl_fhash_create(key_bytes, false);
+}
+
+/** Create a hash map.
+ *
+ * Create a hash map, preparing it to be used.
+ *
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @return Pointer to hash map.
+ */
+struct cl_fhash *cl_fhash_create_map(uint16_t key_bytes) {
+	return cl_fhash_create(key_bytes, true);
+}
+
+/** Set the hash seed of a hash set or map.
+ *
+ * Keys are hashed with the seed (0 by default), so a random seed keeps keys
+ * from picking their hash codes.  It can only be set while empty.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param seed		Hash seed.
+ */
+void cl_fhash_seed(struct cl_fhash *hash, uint64_t seed) {
+	assert(cl_fhash_count(hash) == 0);
+	hash->h_lo.seed = seed;
+	hash->h_hi.seed = seed;
+}
+
+/** Check if a hash is a map.
+ *
+ * @param hash Pointer to hash set or map.
+ * @return true for hash map, false for hash set.
+ */
+static bool cl_fhash_is_map(const struct cl_fhash *hash) {
+	assert(hash->h_lo.n_bytes == hash->h_hi.n_bytes);
+	return hash->is_map;
+}
+
+/** Destroy a hash set or map.
+ *
+ * Destroy a hash set or map, freeing all its resources.
+ *
+ * @param hash Pointer to hash set or map.
+ */
+void cl_fhash_destroy(struct cl_fhash *hash) {
+	assert(hash);
+	cl_fhash_table_destroy(&hash->h_lo);
+	cl_fhash_table_destroy(&hash->h_hi);
+	cl_pool_destroy(hash->pool);
+#ifndef NDEBUG
+	hash->pool = NULL;
+	hash->n_edit = 0;
+#endif
+	free(hash);
+}
+
+/** Update hash edit version.
+ */
+static void cl_fhash_edit(struct cl_fhash *hash) {
+#ifndef NDEBUG
+	hash->n_edit++;
+#endif
+}
+
+/** Get the count of entries.
+ *
+ * @param hash Pointer to hash set or map.
+ * @return Count of entries currently in the hash set or map.
+ */
+uint32_t cl_fhash_count(const struct cl_fhash *hash) {
+	return hash->h_lo.n_entries + hash->h_hi.n_entries;
+}
+
+/** Test if a hash contains a key.
+ *
+ * Test if a hash (set or map) contains the specified key.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param key Key to test for.
+ * @return True if hash contains the key, otherwise false.
+ */
+bool cl_fhash_contains(struct cl_fhash *hash, const void *key) {
+	void *vkey = (void *)key;	/* cast away const */
+	return cl_fhash_table_contains(&hash->h_lo, vkey) ||
+	       cl_fhash_table_contains(&hash->h_hi, vkey);
+}
+
+/** Get an arbitrary key.
+ *
+ * Get an arbitrary key from a hash set or map.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @return Pointer to hash table entry, or NULL if empty.
+ */
+void *cl_fhash_peek(struct cl_fhash *hash) {
+	void **ent = cl_fhash_table_peek(&hash->h_lo);
+	if (!ent)
+		ent = cl_fhash_table_peek(&hash->h_hi);
+	return (ent) ? (*ent) : NULL;
+}
+
+/** Get a value from a hash map.
+ *
+ * Get a value assocated with the given key from a hash map.  NOTE: do not use
+ * this function for hash sets; use cl_fhash_contains instead.
+ *
+ * @param hash		Pointer to hash map.
+ * @param key		Key to look up.
+ * @return value Associated with key, or NULL if not found.
+ */
+const void *cl_fhash_get(struct cl_fhash *hash, const void *key) {
+	if (!cl_fhash_is_map(hash))
+		return NULL;
+	void *vkey = (void *)key;	/* cast away const */
+	void **ent = cl_fhash_table_entry(&hash->h_lo, &vkey);
+	if (ent)
+		return *(ent + 1);
+	else {
+		ent = cl_fhash_table_entry(&hash->h_hi, &vkey);
+		if (ent)
+			return *(ent + 1);
+	}
+	return NULL;
+}
+
+/** Check if one entry from a hash set or map should be moved higher (from
+ * the low table to the high table).
+ *
+ * @param hash Pointer to hash set or map.
+ */
+static bool cl_fhash_should_move_higher(const struct cl_fhash *hash) {
+	int n_lo = hash->h_lo.n_entries;
+	int n_hi = hash->h_hi.n_entries;
+	int n_thresh = cl_fhash_table_limit(&hash->h_hi);
+	return (n_lo > 0) && (n_hi >= n_thresh - n_lo * 2);
+}
+
+/** Move one entry in a hash set or map from low to high table.
+ *
+ * @param hash		Pointer to hash set or map.
+ */
+static void cl_fhash_move_higher(struct cl_fhash *hash) {
+	void **ent = cl_fhash_table_peek(&hash->h_lo);
+	if (ent) {
+		void *tent[2];		/* temporary entry */
+		cl_fhash_table_entry_copy(&hash->h_lo, tent, ent);
+		void *key = cl_fhash_table_remove(&hash->h_lo, tent);
+		if (key)
+			cl_fhash_table_insert(&hash->h_hi, tent);
+	}
+}
+
+/** Move one entry to higher table in a hash set or map if necessary.
+ *
+ * @param hash		Pointer to hash set or map.
+ */
+static void cl_fhash_check_move_higher(struct cl_fhash *hash) {
+	if (cl_fhash_should_move_higher(hash))
+		cl_fhash_move_higher(hash);
+}
+
+/** Check if a hash set or map should expand.
+ *
+ * @param hash Pointer to hash set or map.
+ */
+static bool cl_fhash_should_expand(const struct cl_fhash *hash) {
+	return (hash->h_hi.order < CL_FHASH_MAX_ORDER) &&
+	       (hash->h_lo.n_entries == 0) &&
+	       (hash->h_hi.n_entries >= cl_fhash_table_limit(&hash->h_hi));
+}
+
+/** Expand a hash set or map.
+ *
+ * The low table must be empty to expand.  The old high table becomes the low
+ * table and a new high table is allocated at double the size.
+ *
+ * @param hash Pointer to hash set or map.
+ */
+static void cl_fhash_expand(struct cl_fhash *hash) {
+	cl_fhash_table_clone(&hash->h_lo, &hash->h_hi);
+	hash->h_hi.order++;
+	hash->h_hi.n_entries = 0;
+	hash->h_hi.n_peek = cl_fhash_table_size(&hash->h_hi);
+	cl_fhash_table_alloc(&hash->h_hi);
+}
+
+/** Expand a hash set or map if necessary.
+ *
+ * @param hash		Pointer to hash set or map.
+ */
+static void cl_fhash_check_expand(struct cl_fhash *hash) {
+	if (cl_fhash_should_expand(hash))
+		cl_fhash_expand(hash);
+}
+
+/** Insert an entry into a hash set or map.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param ent		Pointer to hash table entry.  The entry must be
+ *                      tbl->n_bytes in size.
+ * @return Pointer to existing key, or NULL.
+ */
+static void *cl_fhash_insert(struct cl_fhash *hash, void **ent) {
+	void *key = cl_fhash_table_insert(&hash->h_hi, ent);
+	if (!key) {
+		/* Don't allow entry in low table to shadow high table */
+		key = cl_fhash_table_remove(&hash->h_lo, ent);
+		if (!key) {
+			cl_fhash_check_move_higher(hash);
+			cl_fhash_check_expand(hash);
+		}
+	}
+	cl_fhash_edit(hash);
+	return key;
+}
+
+/** Add a new entry to a hash set.
+ *
+ * Add a new entry into a hash set.  The hash table will be expanded if
+ * necessary.  NOTE: do not use this function for hash maps; use cl_fhash_put
+ * instead.
+ *
+ * @param hash		Pointer to hash set.
+ * @param key		Pointer to key to add.
+ * @return Previous equal key, or NULL if key added.
+ */
+const void *cl_fhash_add(struct cl_fhash *hash, const void *key) {
+	if (cl_fhash_is_map(hash))
+		return key;
+	void *vkey = (void *)key;	/* cast away const */
+	return cl_fhash_insert(hash, &vkey);
+}
+
+/** Add a new mapping to a hash map.
+ *
+ * Add a new mapping into a hash map.  The hash table will be expanded if
+ * necessary.  NOTE: do not use this function for hash sets; use cl_fhash_add
+ * instead.
+ *
+ * @param hash		Pointer to hash map.
+ * @param key		Key to put into hash map.
+ * @param value		Value to associate with key.
+ * @return Previous equal key, or NULL.
+ */
+const void *cl_fhash_put(struct cl_fhash *hash, const void *key,
+	const void *value)
+{
+	if (!cl_fhash_is_map(hash))
+		return NULL;
+	void *tent[2];			/* temporary entry */
+	tent[0] = (void *)key;		/* cast away const */
+	tent[1] = (void *)value;	/* cast away const */
+	return cl_fhash_insert(hash, tent);
+}
+
+/** Check if one entry from a hash set or map should be moved lower (from
+ * the high table to the low table).
+ *
+ * @param hash Pointer to hash set or map.
+ */
+static bool cl_fhash_should_move_lower(const struct cl_fhash *hash) {
+	int n_hi = hash->h_hi.n_entries;
+	int n_thresh = cl_fhash_table_slimit(&hash->h_hi);
+	return (n_hi > 0) && (n_thresh > 0);
+}
+
+/** Move one entry in a hash set or map from high to low table.
+ *
+ * @param hash		Pointer to hash set or map.
+ */
+static void cl_fhash_move_lower(struct cl_fhash *hash) {
+	void **ent = cl_fhash_table_peek(&hash->h_hi);
+	if (ent) {
+		void *tent[2];		/* temporary entry */
+		cl_fhash_table_entry_copy(&hash->h_hi, tent, ent);
+		void *key = cl_fhash_table_remove(&hash->h_hi, tent);
+		if (key)
+			cl_fhash_table_insert(&hash->h_lo, tent);
+	}
+}
+
+/** Move one entry to lower table in a hash set or map if necessary.
+ *
+ * @param hash		Pointer to hash set or map.
+ */
+static void cl_fhash_check_move_lower(struct cl_fhash *hash) {
+	if (cl_fhash_should_move_lower(hash))
+		cl_fhash_move_lower(hash);
+}
+
+/** Check if a hash set or map should shrink.
+ *
+ * @param hash Pointer to hash set or map.
+ */
+static bool cl_fhash_should_shrink(const struct cl_fhash *hash) {
+	return (hash->h_hi.order > CL_FHASH_MIN_ORDER) &&
+	       (hash->h_hi.n_entries == 0) &&
+	       (hash->h_lo.n_entries <= cl_fhash_table_slimit(&hash->h_hi));
+}
+
+/** Shrink a hash set or map.
+ *
+ * The high table must be empty to shrink.  The old low table becomes the high
+ * table and a new low table is allocated at half the size.
+ *
+ * @param hash Pointer to hash set or map.
+ */
+static void cl_fhash_shrink(struct cl_fhash *hash) {
+	cl_fhash_table_clone(&hash->h_hi, &hash->h_lo);
+	hash->h_lo.order--;
+	hash->h_lo.n_entries = 0;
+	hash->h_lo.n_peek = cl_fhash_table_size(&hash->h_lo);
+	cl_fhash_table_alloc(&hash->h_lo);
+}
+
+/** Shrink a hash set or map if necessary.
+ *
+ * @param hash		Pointer to hash set or map.
+ */
+static void cl_fhash_check_shrink(struct cl_fhash *hash) {
+	if (cl_fhash_should_shrink(hash))
+		cl_fhash_shrink(hash);
+}
+
+/** Remove an entry from a hash set or map.
+ *
+ * Remove the specified entry from a hash set or map.
+ *
+ * @param hash Pointer to hash table.
+ * @param key Key to be removed.
+ * @return Key removed, or NULL if not found.
+ */
+const void *cl_fhash_remove(struct cl_fhash *hash, const void *key) {
+	void *tent[2];		/* temporary entry */
+	tent[0] = (void *)key;	/* cast away const */
+	tent[1] = NULL;
+	void *pkey = cl_fhash_table_remove(&hash->h_lo, tent);
+	if (!pkey)
+		pkey = cl_fhash_table_remove(&hash->h_hi, tent);
+	if (pkey) {
+		cl_fhash_check_move_lower(hash);
+		cl_fhash_check_shrink(hash);
+		cl_fhash_edit(hash);
+		return pkey;
+	} else
+		return NULL;
+}
+
+/** Clear a hash set or map.
+ *
+ * Remove all entries from a hash set or map.
+ *
+ * @param hash Pointer to hash set or map.
+ */
+void cl_fhash_clear(struct cl_fhash *hash) {
+	assert(hash);
+	cl_fhash_table_clear(&hash->h_lo);
+	cl_fhash_table_clear(&hash->h_hi);
+	cl_pool_clear(hash->pool);
+	cl_fhash_edit(hash);
+}
+
+/** Add up memory statistics of a hash table.
+ */
+static void cl_fhash_table_stats(const struct cl_fhash_table *tbl,
+	struct cl_pool_stats *stats)
+{
+	if (tbl->table) {
+		uint32_t n_size = cl_fhash_table_size(tbl);
+		stats->n_blocks++;
+		stats->n_live += tbl->n_entries;
+		stats->n_high += tbl->n_entries;
+		stats->n_free += n_size - tbl->n_entries;
+		stats->n_bytes += (size_t)n_size * tbl->n_bytes + n_size +
+			CL_FHASH_GROUP;
+		stats->n_used += (size_t)tbl->n_entries * tbl->n_bytes;
+	}
+}
+
+/** Add up memory statistics of a hash set or map.
+ *
+ * Each table counts as a block, with entries as live objects and empty (or
+ * deleted) slots as free.  The iterator pool is added too.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param stats Statistics to add to (see cl_pool_stats).
+ */
+void cl_fhash_stats(const struct cl_fhash *hash, struct cl_pool_stats *stats)
+{
+	cl_pool_stats(hash->pool, stats);
+	stats->n_bytes += sizeof(struct cl_fhash);
+	cl_fhash_table_stats(&hash->h_lo, stats);
+	cl_fhash_table_stats(&hash->h_hi, stats);
+}
+
+/** Create a hash iterator.
+ *
+ * @param hash Pointer to hash set or map.
+ * @return The iterator.
+ */
+struct cl_fhash_iterator *cl_fhash_iterator_create(struct cl_fhash *hash) {
+	struct cl_fhash_iterator *it = cl_pool_alloc(hash->pool);
+	cl_fhash_iterator_init(it, hash);
+	return it;
+}
+
+/** Initialize a hash iterator.
+ *
+ * Initialize a caller's iterator (which can be on the stack).  It doesn't
+ * need to be destroyed.
+ *
+ * @param it The iterator.
+ * @param hash Pointer to hash set or map.
+ */
+void cl_fhash_iterator_init(struct cl_fhash_iterator *it, struct cl_fhash *hash) {
+	assert(hash);
+	it->hash = hash;
+	it->n_table = CL_FHASH_TABLE_LO;
+	it->n_slot = hash->h_lo.n_peek - 1;
+#ifndef NDEBUG
+	it->n_edit = hash->n_edit;
+#else
+	it->n_edit = 0;
+#endif
+}
+
+/** Destroy a hash iterator.
+ *
+ * @param it The iterator.
+ */
+void cl_fhash_iterator_destroy(struct cl_fhash_iterator *it) {
+	assert(it);
+	cl_pool_release(it->hash->pool, it);
+#ifndef NDEBUG
+	it->hash = NULL;
+	it->n_table = CL_FHASH_TABLE_NONE;
+	it->n_slot = -1;
+	it->n_edit = 0;
+#endif
+}
+
+/** Check hash iterator for validity.
+ *
+ * @param it The iterator.
+ */
+static void cl_fhash_iterator_check(struct cl_fhash_iterator *it) {
+#ifndef NDEBUG
+	struct cl_fhash *hash = it->hash;
+	assert(hash);
+	assert(hash->n_edit == it->n_edit);
+#endif
+}
+
+/** Check if hash iterator is done.
+ *
+ * @param it The iterator.
+ * @return true if iterator is done.
+ */
+static bool cl_fhash_iterator_done(const struct cl_fhash_iterator *it) {
+	return it->n_table >= CL_FHASH_TABLE_NONE;
+}
+
+/** Get the current hash table for an iterator.
+ *
+ * @param it The iterator.
+ * @return Current hash table, or NULL if done.
+ */
+static struct cl_fhash_table *cl_fhash_iterator_table(
+	const struct cl_fhash_iterator *it)
+{
+	struct cl_fhash *hash = it->hash;
+	assert(hash);
+	switch(it->n_table) {
+	case CL_FHASH_TABLE_LO:
+		return &hash->h_lo;
+	case CL_FHASH_TABLE_HI:
+		return &hash->h_hi;
+	default:
+		return NULL;
+	}
+}
+
+/** Check if iterator is done with current table.
+ *
+ * @param it The iterator.
+ * @return true if table is done.
+ */
+static bool cl_fhash_iterator_table_done(const struct cl_fhash_iterator *it) {
+	const struct cl_fhash_table *tbl = cl_fhash_iterator_table(it);
+	return (tbl) && (it->n_slot >= cl_fhash_table_size(tbl));
+}
+
+/** Advance to next table in hash iterator.
+ *
+ * @param it The iterator.
+ */
+static void cl_fhash_iterator_next_table(struct cl_fhash_iterator *it) {
+	if (it->n_table == CL_FHASH_TABLE_LO) {
+		it->n_table = CL_FHASH_TABLE_HI;
+		it->n_slot = it->hash->h_hi.n_peek;
+	} else {
+		it->n_table = CL_FHASH_TABLE_NONE;
+		it->n_slot = 0;
+	}
+}
+
+/** Advance to next slot in hash iterator.
+ *
+ * @param it The iterator.
+ */
+static void cl_fhash_iterator_next_slot(struct cl_fhash_iterator *it) {
+	it->n_slot++;
+	while (cl_fhash_iterator_table_done(it))
+		cl_fhash_iterator_next_table(it);
+}
+
+/** Get the current existing entry from a hash iterator.
+ *
+ * @param it The iterator.
+ * @return Current entry in hash iterator, or NULL if entry is empty.
+ */
+static void **cl_fhash_iterator_entry(struct cl_fhash_iterator *it) {
+	struct cl_fhash_table *tbl = cl_fhash_iterator_table(it);
+	if (tbl && cl_fhash_table_slot_full(tbl, it->n_slot))
+		return cl_fhash_table_ptr(tbl, it->n_slot);
+	return NULL;
+}
+
+/** Get the next key from a hash iterator.
+ *
+ * @param it The iterator.
+ * @return Next key in hash iterator, or NULL if done.
+ */
+const void *cl_fhash_iterator_next(struct cl_fhash_iterator *it) {
+	cl_fhash_iterator_check(it);
+	while (!cl_fhash_iterator_done(it)) {
+		cl_fhash_iterator_next_slot(it);
+		void **ent = cl_fhash_iterator_entry(it);
+		if (ent)
+			return *ent;
+	}
+	return NULL;
+}
+
+/** Get the current entry pointer from a hash iterator.
+ *
+ * @param it The iterator.
+ * @return Current entry in hash iterator, or NULL if done.
+ */
+static void **cl_fhash_iterator_ptr(struct cl_fhash_iterator *it) {
+	struct cl_fhash_table *tbl = cl_fhash_iterator_table(it);
+	return (tbl) ? cl_fhash_table_ptr(tbl, it->n_slot) : NULL;
+}
+
+/** Get the value associated with most recent key from a hash iterator.
+ *
+ * @param it The iterator.
+ * @return Value associated with most recent key returned, or NULL.
+ */
+const void *cl_fhash_iterator_value(struct cl_fhash_iterator *it) {
+	cl_fhash_iterator_check(it);
+	if (cl_fhash_is_map(it->hash)) {
+		void **ent = cl_fhash_iterator_ptr(it);
+		if (ent)
+			return *(ent + 1);
+	}
+	return NULL;
+}
@@ -0,0 +1,424 @@
+/*
+ * filter.c	Approximate membership filters
+ *
+ * Copyright (c) 2016  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_bloom_create		Create a blocked Bloom filter
+ *	cl_bloom_destroy	Destroy a Bloom filter
+ *	cl_bloom_capacity	Get the keys a Bloom filter is sized for
+ *	cl_bloom_bytes		Get the bytes held by a Bloom filter
+ *	cl_bloom_clear		Clear all keys from a Bloom filter
+ *	cl_bloom_add		Add a hash code to a Bloom filter
+ *	cl_bloom_contains	Test if a Bloom filter may contain a hash code
+ *	cl_cuckoo_create	Create a cuckoo filter
+ *	cl_cuckoo_destroy	Destroy a cuckoo filter
+ *	cl_cuckoo_count		Count the keys in a cuckoo filter
+ *	cl_cuckoo_clear		Clear all keys from a cuckoo filter
+ *	cl_cuckoo_add		Add a hash code to a cuckoo filter
+ *	cl_cuckoo_contains	Test if a cuckoo filter may contain a hash code
+ *	cl_cuckoo_remove	Remove a hash code from a cuckoo filter
+ */
+/** \file
+ *
+ * A filter answers "is this key in the set?" with "no" or "maybe", in much
+ * less memory than the set, so a lookup that would miss can skip the set
+ * altogether.  Filters hold 64-bit hash codes, not keys: the caller hashes
+ * (cl_hash_mix spreads a 32-bit code well enough).
+ *
+ *     BLOCKED BLOOM FILTER
+ *
+ * A Bloom filter sets CL_BLOOM_WORDS bits for each key, and a key may be in
+ * the set only if all of its bits are set.  Here every bit of a key is in one
+ * block the size of a cache line (picked by the high half of the hash code),
+ * one bit in each of its 64-bit words (picked by the low half times a salt),
+ * so a test reads one cache line.  The bits are tested a vector at a time
+ * (with AVX2 or SSE2 when the compiler targets them).  At 10 bits per key,
+ * about 1% of keys not in the set test true.  Keys can't be removed; clear
+ * the filter and add the keys left instead.
+ *
+ *     CUCKOO FILTER
+ *
+ * A cuckoo filter keeps a 16-bit fingerprint of each key in one of two
+ * buckets of CL_CUCKOO_SLOTS: the bucket picked by the hash code, or that one
+ * xor a hash of the fingerprint (so either bucket leads to the other).  When
+ * both are full, a fingerprint is kicked to its other bucket to make room,
+ * and so on.  A bucket is one 64-bit word, searched for a fingerprint all at
+ * once.  Fingerprints can be removed, as long as only keys which were added
+ * are.  About 0.01% of keys not in the set test true.  Adding fails once the
+ * filter is close to full (about 95% of its slots).
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clump.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/** Words in a Bloom filter block (one cache line) */
+#define CL_BLOOM_WORDS	(8)
+
+/** Fingerprints in a cuckoo filter bucket */
+#define CL_CUCKOO_SLOTS	(4)
+
+/** Most fingerprints kicked out while adding one */
+#define CL_CUCKOO_KICKS	(500)
+
+/** Odd salts picking the bit of each block word (from Parquet's filters) */
+static const uint32_t CL_BLOOM_SALT[CL_BLOOM_WORDS] = {
+	0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+	0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+/** Blocked Bloom filter structure.
+ */
+struct cl_bloom {
+	uint64_t		*blocks;	/* CL_BLOOM_WORDS per block,
+						   aligned to a cache line */
+	void			*mem;		/* allocated memory */
+	uint32_t		n_blocks;	/* number of blocks */
+	uint32_t		n_keys;		/* keys sized for */
+};
+
+/** Cuckoo filter structure.
+ */
+struct cl_cuckoo {
+	uint64_t		*buckets;	/* CL_CUCKOO_SLOTS fingerprints
+						   per bucket, 0 if empty */
+	uint32_t		mask;		/* buckets - 1 (power of 2) */
+	uint32_t		n_keys;		/* number of fingerprints */
+	uint16_t		victim;		/* fingerprint with no room */
+	uint32_t		victim_bucket;	/* one bucket of victim */
+	uint64_t		rng;		/* state of kick choices */
+};
+
+/** Create a blocked Bloom filter.
+ *
+ * @param n_keys	Number of keys to size the filter for.
+ * @param bits_per_key	Bits per key (10 for about 1% false positives).
+ * @return Pointer to Bloom filter.
+ */
+struct cl_bloom *cl_bloom_create(uint32_t n_keys, uint32_t bits_per_key) {
+	struct cl_bloom *bf = malloc(sizeof(struct cl_bloom));
+	uint64_t n_bits = (uint64_t)n_keys * bits_per_key;
+	uint64_t n_blocks = (n_bits + 511) / 512;
+	if(n_blocks == 0)
+		n_blocks = 1;
+	assert(n_blocks <= UINT32_MAX);
+	bf->n_blocks = (uint32_t)n_blocks;
+	bf->n_keys = n_keys;
+	bf->mem = malloc(n_blocks * 64 + 63);
+	bf->blocks = (uint64_t *)(((uintptr_t)bf->mem + 63) & ~(uintptr_t)63);
+	cl_bloom_clear(bf);
+	return bf;
+}
+
+/** Destroy a Bloom filter.
+ *
+ * @param bf		Pointer to Bloom filter.
+ */
+void cl_bloom_destroy(struct cl_bloom *bf) {
+	free(bf->mem);
+	free(bf);
+}
+
+/** Get the number of keys a Bloom filter is sized for.
+ *
+ * Past that, false positives grow quickly.
+ *
+ * @param bf		Pointer to Bloom filter.
+ * @return Number of keys.
+ */
+uint32_t cl_bloom_capacity(const struct cl_bloom *bf) {
+	return bf->n_keys;
+}
+
+/** Get the bytes held by a Bloom filter.
+ *
+ * @param bf		Pointer to Bloom filter.
+ * @return Bytes of the filter and its blocks.
+ */
+size_t cl_bloom_bytes(const struct cl_bloom *bf) {
+	return sizeof(struct cl_bloom) + (size_t)bf->n_blocks * 64 + 63;
+}
+
+/** Clear all keys from a Bloom filter.
+ *
+ * @param bf		Pointer to Bloom filter.
+ */
+void cl_bloom_clear(struct cl_bloom *bf) {
+	memset(bf->blocks, 0, (size_t)bf->n_blocks * 64);
+}
+
+/** Get the block of a hash code.
+ */
+static uint64_t *cl_bloom_block(const struct cl_bloom *bf, uint64_t hcode) {
+	uint32_t b = (uint32_t)(((hcode >> 32) * bf->n_blocks) >> 32);
+	return bf->blocks + (size_t)b * CL_BLOOM_WORDS;
+}
+
+/** Get the bit of each block word for a hash code.
+ */
+static void cl_bloom_mask(uint64_t *mask, uint64_t hcode) {
+	uint32_t x = (uint32_t)hcode;
+	for(int i = 0; i < CL_BLOOM_WORDS; i++)
+		mask[i] = (uint64_t)1 << ((x * CL_BLOOM_SALT[i]) >> 26);
+}
+
+/** Add a hash code to a Bloom filter.
+ *
+ * @param bf		Pointer to Bloom filter.
+ * @param hcode		Hash code of key.
+ */
+void cl_bloom_add(struct cl_bloom *bf, uint64_t hcode) {
+	uint64_t *block = cl_bloom_block(bf, hcode);
+	uint64_t mask[CL_BLOOM_WORDS];
+	cl_bloom_mask(mask, hcode);
+	for(int i = 0; i < CL_BLOOM_WORDS; i++)
+		block[i] |= mask[i];
+}
+
+/** Test if a Bloom filter may contain a hash code.
+ *
+ * @param bf		Pointer to Bloom filter.
+ * @param hcode		Hash code of key.
+ * @return False if the key was never added, true if it may have been.
+ */
+bool cl_bloom_contains(const struct cl_bloom *bf, uint64_t hcode) {
+	const uint64_t *block = cl_bloom_block(bf, hcode);
+	uint64_t mask[CL_BLOOM_WORDS];
+	cl_bloom_mask(mask, hcode);
+#if defined(__AVX2__)
+	__m256i m0 = _mm256_loadu_si256((const __m256i *)mask);
+	__m256i m1 = _mm256_loadu_si256((const __m256i *)(mask + 4));
+	__m256i b0 = _mm256_load_si256((const __m256i *)block);
+	__m256i b1 = _mm256_load_si256((const __m256i *)(block + 4));
+	/* Every bit of the mask is set in the block */
+	return _mm256_testc_si256(b0, m0) && _mm256_testc_si256(b1, m1);
+#elif defined(__SSE2__)
+	int eq = 0xffff;
+	for(int i = 0; i < CL_BLOOM_WORDS; i += 2) {
+		__m128i m = _mm_loadu_si128((const __m128i *)(mask + i));
+		__m128i b = _mm_load_si128((const __m128i *)(block + i));
+		eq &= _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(b, m),
+			m));
+	}
+	return eq == 0xffff;
+#else
+	uint64_t missing = 0;
+	for(int i = 0; i < CL_BLOOM_WORDS; i++)
+		missing |= mask[i] & ~block[i];
+	return missing == 0;
+#endif
+}
+
+/** Create a cuckoo filter.
+ *
+ * @param n_keys	Number of keys to size the filter for.
+ * @return Pointer to cuckoo filter.
+ */
+struct cl_cuckoo *cl_cuckoo_create(uint32_t n_keys) {
+	struct cl_cuckoo *cf = malloc(sizeof(struct cl_cuckoo));
+	/* Buckets up to 95% full */
+	uint64_t n_min = ((uint64_t)n_keys * 20 / 19 + CL_CUCKOO_SLOTS - 1) /
+		CL_CUCKOO_SLOTS;
+	uint64_t n_buckets = 2;
+	while(n_buckets < n_min)
+		n_buckets <<= 1;
+	assert(n_buckets <= (uint64_t)1 << 31);
+	cf->buckets = malloc(n_buckets * sizeof(uint64_t));
+	cf->mask = (uint32_t)(n_buckets - 1);
+	cf->rng = 0x9e3779b97f4a7c15ULL;
+	cl_cuckoo_clear(cf);
+	return cf;
+}
+
+/** Destroy a cuckoo filter.
+ *
+ * @param cf		Pointer to cuckoo filter.
+ */
+void cl_cuckoo_destroy(struct cl_cuckoo *cf) {
+	free(cf->buckets);
+	free(cf);
+}
+
+/** Count the keys in a cuckoo filter.
+ *
+ * @param cf		Pointer to cuckoo filter.
+ * @return Number of keys added and not removed.
+ */
+uint32_t cl_cuckoo_count(const struct cl_cuckoo *cf) {
+	return cf->n_keys;
+}
+
+/** Clear all keys from a cuckoo filter.
+ *
+ * @param cf		Pointer to cuckoo filter.
+ */
+void cl_cuckoo_clear(struct cl_cuckoo *cf) {
+	memset(cf->buckets, 0, ((size_t)cf->mask + 1) * sizeof(uint64_t));
+	cf->n_keys = 0;
+	cf->victim = 0;
+	cf->victim_bucket = 0;
+}
+
+/** Get the fingerprint of a hash code (never 0, which marks a slot empty).
+ */
+static uint16_t cl_cuckoo_fingerprint(uint64_t hcode) {
+	uint16_t fp = (uint16_t)(hcode >> 48);
+	return (fp) ? fp : 1;
+}
+
+/** Get the other bucket of a fingerprint.
+ */
+static uint32_t cl_cuckoo_alt(const struct cl_cuckoo *cf, uint32_t bucket,
+	uint16_t fp)
+{
+	return (bucket ^ (uint32_t)(fp * 0x5bd1e995U)) & cf->mask;
+}
+
+/** Get the fingerprint in a bucket slot.
+ */
+static uint16_t cl_cuckoo_slot(uint64_t bucket, int slot) {
+	return (uint16_t)(bucket >> (slot * 16));
+}
+
+/** Find a fingerprint in a bucket, all slots at once.
+ *
+ * @return Bit 15 set in the 16 bits of each matching slot (0 if none).
+ */
+static uint64_t cl_cuckoo_match(uint64_t bucket, uint16_t fp) {
+	const uint64_t lo = 0x0001000100010001ULL;
+	const uint64_t high = lo << 15;
+	uint64_t x = bucket ^ (fp * lo);
+	/* Bit 15 of a slot is clear only if all of its bits are (no carries
+	 * cross slots, so this is exact) */
+	uint64_t y = ((x & ~high) + ~high) | x;
+	return ~y & high;
+}
+
+/** Get the first slot of a match (not 0).
+ */
+static int cl_cuckoo_first(uint64_t match) {
+#ifdef __GNUC__
+	return __builtin_ctzll(match) / 16;
+#else
+	int slot = 0;
+	while(!(match & 0x8000)) {
+		match >>= 16;
+		slot++;
+	}
+	return slot;
+#endif
+}
+
+/** Put a fingerprint into an empty slot of a bucket.
+ *
+ * @return True if there was an empty slot.
+ */
+static bool cl_cuckoo_put(struct cl_cuckoo *cf, uint32_t b, uint16_t fp) {
+	uint64_t empty = cl_cuckoo_match(cf->buckets[b], 0);
+	if(!empty)
+		return false;
+	int slot = cl_cuckoo_first(empty);
+	cf->buckets[b] |= (uint64_t)fp << (slot * 16);
+	return true;
+}
+
+/** Add a hash code to a cuckoo filter.
+ *
+ * @param cf		Pointer to cuckoo filter.
+ * @param hcode		Hash code of key.
+ * @return True if added, false if the filter is full.
+ */
+bool cl_cuckoo_add(struct cl_cuckoo *cf, uint64_t hcode) {
+	if(cf->victim)
+		return false;
+	uint16_t fp = cl_cuckoo_fingerprint(hcode);
+	uint32_t b = (uint32_t)hcode & cf->mask;
+	cf->n_keys++;
+	if(cl_cuckoo_put(cf, b, fp))
+		return true;
+	b = cl_cuckoo_alt(cf, b, fp);
+	for(int n = 0; n < CL_CUCKOO_KICKS; n++) {
+		if(cl_cuckoo_put(cf, b, fp))
+			return true;
+		/* Swap with a random slot, then move that one */
+		cf->rng ^= cf->rng << 13;
+		cf->rng ^= cf->rng >> 7;
+		cf->rng ^= cf->rng << 17;
+		int slot = (int)(cf->rng >> 62) * 16;
+		uint16_t kicked = cl_cuckoo_slot(cf->buckets[b], slot / 16);
+		cf->buckets[b] ^= (uint64_t)(kicked ^ fp) << slot;
+		fp = kicked;
+		b = cl_cuckoo_alt(cf, b, fp);
+	}
+	/* Kept aside, so no key is lost; the next add fails */
+	cf->victim = fp;
+	cf->victim_bucket = b;
+	return true;
+}
+
+/** Test if a cuckoo filter may contain a hash code.
+ *
+ * @param cf		Pointer to cuckoo filter.
+ * @param hcode		Hash code of key.
+ * @return False if the key isn't in the filter, true if it may be.
+ */
+bool cl_cuckoo_contains(const struct cl_cuckoo *cf, uint64_t hcode) {
+	uint16_t fp = cl_cuckoo_fingerprint(hcode);
+	uint32_t b0 = (uint32_t)hcode & cf->mask;
+	uint32_t b1 = cl_cuckoo_alt(cf, b0, fp);
+	if(cf->victim == fp && (cf->victim_bucket == b0 ||
+	   cf->victim_bucket == b1))
+		return true;
+	return (cl_cuckoo_match(cf->buckets[b0], fp) |
+	        cl_cuckoo_match(cf->buckets[b1], fp)) != 0;
+}
+
+/** Remove a fingerprint from a bucket.
+ */
+static bool cl_cuckoo_take(struct cl_cuckoo *cf, uint32_t b, uint16_t fp) {
+	uint64_t found = cl_cuckoo_match(cf->buckets[b], fp);
+	if(!found)
+		return false;
+	int slot = cl_cuckoo_first(found);
+	cf->buckets[b] &= ~((uint64_t)0xffff << (slot * 16));
+	return true;
+}
+
+/** Remove a hash code from a cuckoo filter.
+ *
+ * Only remove keys which were added, or another key may be removed instead
+ * (one with the same fingerprint and buckets).
+ *
+ * @param cf		Pointer to cuckoo filter.
+ * @param hcode		Hash code of key.
+ * @return True if removed, false if it wasn't in the filter.
+ */
+bool cl_cuckoo_remove(struct cl_cuckoo *cf, uint64_t hcode) {
+	uint16_t fp = cl_cuckoo_fingerprint(hcode);
+	uint32_t b0 = (uint32_t)hcode & cf->mask;
+	uint32_t b1 = cl_cuckoo_alt(cf, b0, fp);
+	if(cf->victim == fp && (cf->victim_bucket == b0 ||
+	   cf->victim_bucket == b1))
+		cf->victim = 0;
+	else if(!cl_cuckoo_take(cf, b0, fp) && !cl_cuckoo_take(cf, b1, fp))
+		return false;
+	cf->n_keys--;
+	/* Room for the victim now, maybe */
+	if(cf->victim) {
+		uint16_t victim = cf->victim;
+		uint32_t b = cf->victim_bucket;
+		if(cl_cuckoo_put(cf, b, victim) ||
+		   cl_cuckoo_put(cf, cl_cuckoo_alt(cf, b, victim), victim))
+			cf->victim = 0;
+	}
+	return true;
+}
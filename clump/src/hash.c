@@ -7,6 +7,12 @@
  *
  *	cl_hash_create_set	Create a hash set
  *	cl_hash_create_map	Create a hash map
+ *	cl_hash_create_set_sized Create a hash set sized for a count
+ *	cl_hash_create_map_sized Create a hash map sized for a count
+ *	cl_hash_create_set_with_alloc Create a hash set with an allocator
+ *	cl_hash_create_map_with_alloc Create a hash map with an allocator
+ *	cl_hash_create_set_arena Create a hash set in an arena
+ *	cl_hash_create_map_arena Create a hash map in an arena
  *	cl_hash_destroy		Destroy a hash set or map
  *	cl_hash_count		Count the entries in a hash set or map
  *	cl_hash_contains	Test if a hash contains a key
@@ -17,7 +23,12 @@
  *	cl_hash_put		Put a mapping into a hash map
  *	cl_hash_remove		Remove a key from a hash set or map
  *	cl_hash_clear		Clear all entries from a hash set or map
+ *	cl_hash_reserve		Reserve room for entries in a hash
+ *	cl_hash_shrink_to_fit	Shrink a hash to fit its entries
+ *	cl_hash_stats		Add up memory statistics of a hash
+ *	cl_hash_probe_stats	Get probe statistics of a hash
  *	cl_hash_iterator_create Create a hash key iterator
+ *	cl_hash_iterator_init	Initialize a hash key iterator
  *	cl_hash_iterator_destroy Destroy a hash key iterator
  *	cl_hash_iterator_next	Get the next key from an iterator
  *	cl_hash_iterator_value	Get the value mapped to most recent key
@@ -34,6 +45,29 @@
  * for keys.
  * NOTE: some functions can be used with either hash sets or maps, but some
  * must only be used with either sets or maps.
+ *
+ * Entries are stored in the table itself (open addressing), with the hash
+ * code of each key, so the compare function is only called when hash codes
+ * match, and resizing never calls the hash function.
+ * Collisions are resolved by linear probing with Robin Hood hashing: each
+ * entry records its probe distance, an insert takes the slot of any entry
+ * closer to its own first slot, and a lookup stops at the first entry closer
+ * than the probe.  That keeps probes short enough to fill the table to 7/8.
+ * Removing an entry shifts the entries after it back one slot.
+ * Adding a key equal to one in the hash replaces that entry.
+ *
+ * Resizing is iterative: a new table (twice or half the size) replaces the
+ * current one, which is kept as the old table until it's empty.  Each add or
+ * remove then moves up to CL_HASH_MIGRATE entries from the old table to the
+ * new, scanning it from slot 0.  Moving an entry removes it (shifting back
+ * the entries after it), so the old table stays a valid table of the entries
+ * not yet moved, and every slot before the scan is empty.  Lookups check both
+ * tables, new entries are only placed in the new table, and no other resize
+ * starts until the old table is empty (the new table has room for that).
+ *
+ * When the number of entries is known up front, create the hash sized for it
+ * (or reserve room) and no resizing happens while it's filled.  Reserving or
+ * shrinking to fit rebuilds the table at once, finishing any migration.
  */
 #include <assert.h>
 #include <stdbool.h>
@@ -45,8 +79,9 @@
 /** Hash set entry structure.
  */
 struct cl_hash_entry {
-	struct cl_hash_entry	*next;	/**< link to next hash entry */
 	const void		*key;	/**< key stored in hash entry */
+	uint32_t		hcode;	/**< hash code of key */
+	uint32_t		dist;	/**< probe distance + 1, 0 if empty */
 };
 
 /** Hash mapping structure.
@@ -56,23 +91,24 @@ struct cl_hash_mapping {
 	const void		*value;	/**< value for hash mapping */
 };
 
-/** Hash iterator structure.
+/** Hash table structure.
  */
-struct cl_hash_iterator {
-	struct cl_hash		*hash;	/**< hash struct */
-	struct cl_hash_entry	*curr;	/**< current entry in bucket */
-	uint32_t		bucket;	/**< current bucket */
+struct cl_hash_table {
+	void			*table;		/**< actual hash table */
+	uint32_t		n_size;		/**< size of hash table */
+	uint32_t		n_entries;	/**< number of entries */
 };
 
-/** Hash table structure.
+/** Hash set/map structure.
  */
 struct cl_hash {
 	cl_hash_cb		*fn_hash;	/**< hash function */
 	cl_compare_cb		*fn_compare;	/**< comparision function */
-	struct cl_pool		*pool;		/**< hash entry / mapping pool*/
-	void			**table;	/**< actual hash table */
-	uint32_t		n_size;		/**< size of hash table */
-	uint32_t		n_entries;	/**< number of entries */
+	struct cl_hash_table	h_new;		/**< current table */
+	struct cl_hash_table	h_old;		/**< table being resized from */
+	uint32_t		n_migrate;	/**< next slot of old table */
+	uint32_t		n_bytes;	/**< number of bytes per entry */
+	const struct cl_alloc	*al;		/**< allocator of hash */
 };
 
 /** Minimum hash table size */
@@ -81,24 +117,52 @@ static const uint32_t CL_HASH_MIN_SIZE = 1 << 6;
 /** Maximum hash table size */
 static const uint32_t CL_HASH_MAX_SIZE = 1U << 31;
 
-/** Get the bucket for a hash value.
+/** Old table slots scanned (or entries moved) per add or remove */
+static const uint32_t CL_HASH_MIGRATE = 16;
+
+/** Get the first slot for a hash value.
  *
- * @param hash Pointer to hash table.
+ * @param tbl Pointer to hash table.
  * @param hcode Hash code.
- * @return Bucket in the hash table for the specified hash value.
+ * @return Slot in the hash table for the specified hash value.
  */
-static uint32_t cl_hash_bucket(const struct cl_hash *hash, uint32_t hcode) {
-	uint32_t n_size = hash->n_size;
+static uint32_t cl_hash_bucket(const struct cl_hash_table *tbl,
+	uint32_t hcode)
+{
+	uint32_t n_size = tbl->n_size;
 	return hcode & (n_size - 1);
 }
 
+/** Get the hash table entry in a slot.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param tbl Pointer to hash table.
+ * @param slot Slot in the hash table.
+ * @return Pointer to hash table entry.
+ */
+static struct cl_hash_entry *cl_hash_slot(const struct cl_hash *hash,
+	const struct cl_hash_table *tbl, uint32_t slot)
+{
+	uint8_t *base = tbl->table;
+	assert(slot < tbl->n_size);
+	return (struct cl_hash_entry *)(base + (size_t)slot * hash->n_bytes);
+}
+
+/** Check if a hash is resizing (has entries in the old table).
+ *
+ * @param hash Pointer to hash set or map.
+ */
+static bool cl_hash_migrating(const struct cl_hash *hash) {
+	return hash->h_old.n_entries > 0;
+}
+
 /** Get the hash entry minimum limit.
  *
  * @param hash Pointer to hash table.
  * @return Current hash entry minimum limit.
  */
 static uint32_t cl_hash_slimit(const struct cl_hash *hash) {
-	uint32_t n_size = hash->n_size;
+	uint32_t n_size = hash->h_new.n_size;
 	if(n_size > CL_HASH_MIN_SIZE)
 		return n_size / 8;
 	else
@@ -107,25 +171,66 @@ static uint32_t cl_hash_slimit(const struct cl_hash *hash) {
 
 /** Get the hash entry limit.
  *
- * A hash table should never be more than 3/4 full, so the limit should be
+ * A hash table should never be more than 7/8 full, so the limit should be
  * checked before adding a new entry.
  *
  * @param hash Pointer to hash table.
  * @return Current hash entry limit.
  */
 static uint32_t cl_hash_limit(const struct cl_hash *hash) {
-	return hash->n_size / 2;
+	return hash->h_new.n_size - hash->h_new.n_size / 8;
+}
+
+/** Get the table size for a number of entries.
+ *
+ * @param n Number of entries.
+ * @return Smallest table size which holds n entries without expanding.
+ */
+static uint32_t cl_hash_size_for(uint32_t n) {
+	uint32_t n_size = CL_HASH_MIN_SIZE;
+	while(n_size < CL_HASH_MAX_SIZE && n_size - n_size / 8 < n)
+		n_size *= 2;
+	return n_size;
 }
 
 /** Allocate hash table.
  *
- * Allocate memory for hash table buckets.
+ * Allocate memory for hash table entries.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param tbl Pointer to hash table.
+ * @param n_size Size of hash table.
  */
-static void cl_hash_table_alloc(struct cl_hash *hash) {
-	uint32_t n_size = hash->n_size;
+static void cl_hash_table_alloc(const struct cl_hash *hash,
+	struct cl_hash_table *tbl, uint32_t n_size)
+{
+	tbl->n_size = n_size;
+	tbl->n_entries = 0;
+	tbl->table = cl_alloc_calloc(hash->al, (size_t)n_size * hash->n_bytes);
+}
 
-	hash->table = calloc(n_size, sizeof(void *));
-	assert(hash->table);
+/** Free a hash table.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param tbl Pointer to hash table.
+ */
+static void cl_hash_table_free(const struct cl_hash *hash,
+	struct cl_hash_table *tbl)
+{
+	cl_alloc_free(hash->al, tbl->table, (size_t)tbl->n_size *
+		hash->n_bytes);
+}
+
+/** Free the old hash table.
+ *
+ * @param hash Pointer to hash set or map.
+ */
+static void cl_hash_old_free(struct cl_hash *hash) {
+	cl_hash_table_free(hash, &hash->h_old);
+	hash->h_old.table = NULL;
+	hash->h_old.n_size = 0;
+	hash->h_old.n_entries = 0;
+	hash->n_migrate = 0;
 }
 
 /** Create a hash set or map.
@@ -134,20 +239,24 @@ static void cl_hash_table_alloc(struct cl_hash *hash) {
  *
  * @param fn_hash Function to calculate a hash code.
  * @param fn_compare Function to compare two keys for equality.
+ * @param n_bytes Number of bytes per entry.
+ * @param n_size Initial size of hash table.
+ * @param al Allocator for the hash and its tables.
  * @return Pointer to hash set.
  */
 static struct cl_hash *cl_hash_create(cl_hash_cb *fn_hash,
-	cl_compare_cb *fn_compare)
+	cl_compare_cb *fn_compare, uint32_t n_bytes, uint32_t n_size,
+	const struct cl_alloc *al)
 {
-	struct cl_hash *hash = malloc(sizeof(struct cl_hash));
+	struct cl_hash *hash = cl_alloc_malloc(al, sizeof(struct cl_hash));
 
-	assert(hash);
-	hash->pool = NULL;
-	hash->n_size = CL_HASH_MIN_SIZE;
-	hash->n_entries = 0;
+	hash->al = al;
+	hash->n_bytes = n_bytes;
 	hash->fn_hash = fn_hash;
 	hash->fn_compare = fn_compare;
-	cl_hash_table_alloc(hash);
+	cl_hash_table_alloc(hash, &hash->h_new, n_size);
+	hash->h_old.table = NULL;
+	cl_hash_old_free(hash);
 	return hash;
 }
 
@@ -162,9 +271,9 @@ static struct cl_hash *cl_hash_create(cl_hash_cb *fn_hash,
 struct cl_hash *cl_hash_create_set(cl_hash_cb *fn_hash,
 	cl_compare_cb *fn_compare)
 {
-	struct cl_hash *hash = cl_hash_create(fn_hash, fn_compare);
-	hash->pool = cl_pool_create(sizeof(struct cl_hash_entry));
-	return hash;
+	return cl_hash_create(fn_hash, fn_compare,
+		sizeof(struct cl_hash_entry), CL_HASH_MIN_SIZE,
+		&cl_alloc_default);
 }
 
 /** Create a hash map.
@@ -178,9 +287,104 @@ struct cl_hash *cl_hash_create_set(cl_hash_cb *fn_hash,
 struct cl_hash *cl_hash_create_map(cl_hash_cb *fn_hash,
 	cl_compare_cb *fn_compare)
 {
-	struct cl_hash *hash = cl_hash_create(fn_hash, fn_compare);
-	hash->pool = cl_pool_create(sizeof(struct cl_hash_mapping));
-	return hash;
+	return cl_hash_create(fn_hash, fn_compare,
+		sizeof(struct cl_hash_mapping), CL_HASH_MIN_SIZE,
+		&cl_alloc_default);
+}
+
+/** Create a hash set sized for a number of entries.
+ *
+ * No resizing happens until more than n entries are added.
+ *
+ * @param fn_hash Function to calculate a hash code.
+ * @param fn_compare Function to compare two keys for equality.
+ * @param n Expected number of entries.
+ * @return Pointer to hash set.
+ */
+struct cl_hash *cl_hash_create_set_sized(cl_hash_cb *fn_hash,
+	cl_compare_cb *fn_compare, uint32_t n)
+{
+	return cl_hash_create(fn_hash, fn_compare,
+		sizeof(struct cl_hash_entry), cl_hash_size_for(n),
+		&cl_alloc_default);
+}
+
+/** Create a hash map sized for a number of entries.
+ *
+ * No resizing happens until more than n mappings are added.
+ *
+ * @param fn_hash Function to calculate a hash code.
+ * @param fn_compare Function to compare two keys for equality.
+ * @param n Expected number of mappings.
+ * @return Pointer to hash map.
+ */
+struct cl_hash *cl_hash_create_map_sized(cl_hash_cb *fn_hash,
+	cl_compare_cb *fn_compare, uint32_t n)
+{
+	return cl_hash_create(fn_hash, fn_compare,
+		sizeof(struct cl_hash_mapping), cl_hash_size_for(n),
+		&cl_alloc_default);
+}
+
+/** Create a hash set with an allocator.
+ *
+ * @param al Allocator for the hash and its tables.
+ * @param fn_hash Function to calculate a hash code.
+ * @param fn_compare Function to compare two keys for equality.
+ * @return Pointer to hash set.
+ */
+struct cl_hash *cl_hash_create_set_with_alloc(const struct cl_alloc *al,
+	cl_hash_cb *fn_hash, cl_compare_cb *fn_compare)
+{
+	return cl_hash_create(fn_hash, fn_compare,
+		sizeof(struct cl_hash_entry), CL_HASH_MIN_SIZE, al);
+}
+
+/** Create a hash map with an allocator.
+ *
+ * @param al Allocator for the hash and its tables.
+ * @param fn_hash Function to calculate a hash code.
+ * @param fn_compare Function to compare two keys for equality.
+ * @return Pointer to hash map.
+ */
+struct cl_hash *cl_hash_create_map_with_alloc(const struct cl_alloc *al,
+	cl_hash_cb *fn_hash, cl_compare_cb *fn_compare)
+{
+	return cl_hash_create(fn_hash, fn_compare,
+		sizeof(struct cl_hash_mapping), CL_HASH_MIN_SIZE, al);
+}
+
+/** Create a hash set in an arena.
+ *
+ * The hash and its tables are allocated from a memory arena, and are freed
+ * when it is released or reset -- destroying the hash is optional.  Tables
+ * outgrown while it's filled stay in the arena until then, so create it for
+ * the expected count (see cl_hash_reserve) when that is known.
+ *
+ * @param arena Memory arena.
+ * @param fn_hash Function to calculate a hash code.
+ * @param fn_compare Function to compare two keys for equality.
+ * @return Pointer to hash set.
+ */
+struct cl_hash *cl_hash_create_set_arena(struct cl_arena *arena,
+	cl_hash_cb *fn_hash, cl_compare_cb *fn_compare)
+{
+	return cl_hash_create_set_with_alloc(cl_arena_allocator(arena),
+		fn_hash, fn_compare);
+}
+
+/** Create a hash map in an arena.
+ *
+ * @param arena Memory arena.
+ * @param fn_hash Function to calculate a hash code.
+ * @param fn_compare Function to compare two keys for equality.
+ * @return Pointer to hash map.
+ */
+struct cl_hash *cl_hash_create_map_arena(struct cl_arena *arena,
+	cl_hash_cb *fn_hash, cl_compare_cb *fn_compare)
+{
+	return cl_hash_create_map_with_alloc(cl_arena_allocator(arena),
+		fn_hash, fn_compare);
 }
 
 /** Destroy a hash table.
@@ -191,15 +395,15 @@ struct cl_hash *cl_hash_create_map(cl_hash_cb *fn_hash,
  */
 void cl_hash_destroy(struct cl_hash *hash) {
 	assert(hash);
-	cl_pool_destroy(hash->pool);
-	free(hash->table);
+	cl_hash_table_free(hash, &hash->h_new);
+	cl_hash_table_free(hash, &hash->h_old);
 #ifndef NDEBUG
 	hash->fn_hash = NULL;
 	hash->fn_compare = NULL;
-	hash->pool = NULL;
-	hash->table = NULL;
+	hash->h_new.table = NULL;
+	hash->h_old.table = NULL;
 #endif
-	free(hash);
+	cl_alloc_free(hash->al, hash, sizeof(struct cl_hash));
 }
 
 /** Get the count of entries.
@@ -208,22 +412,71 @@ void cl_hash_destroy(struct cl_hash *hash) {
  * @return Count of entries currently in the hash set or map.
  */
 uint32_t cl_hash_count(const struct cl_hash *hash) {
-	return hash->n_entries;
+	return hash->h_new.n_entries + hash->h_old.n_entries;
 }
 
-/** Test if a hash entry equals a key.
+/** Check if a hash is a map.
  *
  * @param hash Pointer to hash set or map.
- * @param e Hash entry.
- * @param key Key to compare.
- * @param hcode Hash code.
- * @return True if they are equal.
+ * @return true for hash map, false for hash set.
  */
-static bool cl_hash_equals(const struct cl_hash *hash,
-	const struct cl_hash_entry *e, const void *key, uint32_t hcode)
+static bool cl_hash_is_map(const struct cl_hash *hash) {
+	return hash->n_bytes == sizeof(struct cl_hash_mapping);
+}
+
+/** Find the entry for a key in one table.
+ *
+ * Probing stops at an empty slot, or at an entry with a shorter probe
+ * distance (a Robin Hood insert would have put the key before it).
+ *
+ * @param hash Pointer to hash set or map.
+ * @param tbl Pointer to hash table.
+ * @param key Key to find.
+ * @param hcode Hash code of key.
+ * @return Pointer to hash table entry, or NULL if not found.
+ */
+static struct cl_hash_entry *cl_hash_table_lookup(const struct cl_hash *hash,
+	const struct cl_hash_table *tbl, const void *key, uint32_t hcode)
 {
-	uint32_t hc = hash->fn_hash(e->key);
-	return (hcode == hc) && (hash->fn_compare(key, e->key) == CL_EQUAL);
+	uint32_t mask = tbl->n_size - 1;
+	uint32_t slot;
+	if(tbl->n_entries == 0)
+		return NULL;
+	slot = cl_hash_bucket(tbl, hcode);
+	for(uint32_t dist = 1; ; dist++) {
+		struct cl_hash_entry *e = cl_hash_slot(hash, tbl, slot);
+		if(e->dist < dist)
+			return NULL;
+		if(e->hcode == hcode && hash->fn_compare(key, e->key) ==
+		   CL_EQUAL)
+			return e;
+		slot = (slot + 1) & mask;
+	}
+}
+
+/** Find the entry for a key.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param key Key to find.
+ * @param hcode Hash code of key.
+ * @param tbl Set to table of entry (if found).
+ * @return Pointer to hash table entry, or NULL if not found.
+ */
+static struct cl_hash_entry *cl_hash_lookup(struct cl_hash *hash,
+	const void *key, uint32_t hcode, struct cl_hash_table **tbl)
+{
+	struct cl_hash_entry *e;
+	*tbl = &hash->h_new;
+	e = cl_hash_table_lookup(hash, *tbl, key, hcode);
+	/* Slots of the old table before the scan are empty, so a key whose first
+	 * slot is one of them isn't there */
+	if(e == NULL && cl_hash_migrating(hash) &&
+	   cl_hash_bucket(&hash->h_old, hcode) >= hash->n_migrate)
+	{
+		*tbl = &hash->h_old;
+		e = cl_hash_table_lookup(hash, *tbl, key, hcode);
+	}
+	return e;
 }
 
 /** Test if a hash contains a key.
@@ -235,15 +488,28 @@ static bool cl_hash_equals(const struct cl_hash *hash,
  * @return True if hash contains the key, otherwise false.
  */
 bool cl_hash_contains(struct cl_hash *hash, const void *key) {
-	uint32_t hcode = hash->fn_hash(key);
-	uint32_t bucket = cl_hash_bucket(hash, hcode);
-	struct cl_hash_entry *e = hash->table[bucket];
-	while(e) {
-		if(cl_hash_equals(hash, e, key, hcode))
-			return true;
-		e = e->next;
+	struct cl_hash_table *tbl;
+	return cl_hash_lookup(hash, key, hash->fn_hash(key), &tbl) != NULL;
+}
+
+/** Get an arbitrary entry from one table.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param tbl Pointer to hash table.
+ * @return Pointer to hash table entry, or NULL if table is empty.
+ */
+static struct cl_hash_entry *cl_hash_table_peek(const struct cl_hash *hash,
+	const struct cl_hash_table *tbl)
+{
+	uint32_t n_size = tbl->n_size;
+	if(tbl->n_entries == 0)
+		return NULL;
+	for(uint32_t i = 0; i < n_size; i++) {
+		struct cl_hash_entry *e = cl_hash_slot(hash, tbl, i);
+		if(e->dist)
+			return e;
 	}
-	return false;
+	return NULL;
 }
 
 /** Get an arbitrary key.
@@ -254,13 +520,10 @@ bool cl_hash_contains(struct cl_hash *hash, const void *key) {
  * @return Pointer to key, or NULL if hash is empty.
  */
 const void *cl_hash_peek(struct cl_hash *hash) {
-	uint32_t n_size = hash->n_size;;
-	for(int i = 0; i < n_size; i++) {
-		struct cl_hash_entry *e = hash->table[i];
-		if(e)
-			return e->key;
-	}
-	return NULL;
+	struct cl_hash_entry *e = cl_hash_table_peek(hash, &hash->h_new);
+	if(e == NULL)
+		e = cl_hash_table_peek(hash, &hash->h_old);
+	return (e) ? e->key : NULL;
 }
 
 /** Get a key from a hash set.
@@ -272,15 +535,10 @@ const void *cl_hash_peek(struct cl_hash *hash) {
  * @return Matching key from hash set.
  */
 const void *cl_hash_get_key(struct cl_hash *hash, const void *key) {
-	uint32_t hcode = hash->fn_hash(key);
-	uint32_t bucket = cl_hash_bucket(hash, hcode);
-	struct cl_hash_entry *e = hash->table[bucket];
-	while(e) {
-		if(cl_hash_equals(hash, e, key, hcode))
-			return e->key;
-		e = e->next;
-	}
-	return NULL;
+	struct cl_hash_table *tbl;
+	struct cl_hash_entry *e = cl_hash_lookup(hash, key, hash->fn_hash(key),
+		&tbl);
+	return (e) ? e->key : NULL;
 }
 
 /** Get a value from a hash map.
@@ -293,68 +551,157 @@ const void *cl_hash_get_key(struct cl_hash *hash, const void *key) {
  * @return value Associated with key, or NULL if not found.
  */
 const void *cl_hash_get(struct cl_hash *hash, const void *key) {
-	uint32_t hcode = hash->fn_hash(key);
-	uint32_t bucket = cl_hash_bucket(hash, hcode);
-	struct cl_hash_entry *e = hash->table[bucket];
-	while(e) {
-		if(cl_hash_equals(hash, e, key, hcode)) {
-			struct cl_hash_mapping *m = (struct cl_hash_mapping *)e;
-			return m->value;
+	struct cl_hash_table *tbl;
+	struct cl_hash_entry *e;
+	if(!cl_hash_is_map(hash))
+		return NULL;
+	e = cl_hash_lookup(hash, key, hash->fn_hash(key), &tbl);
+	return (e) ? ((struct cl_hash_mapping *)e)->value : NULL;
+}
+
+/** Place an entry into a hash table.
+ *
+ * The entry's key must not be in the table.  Starting at its first slot,
+ * the entry takes the slot of the first entry with a shorter probe distance,
+ * which is then placed further along the same way.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param tbl Pointer to hash table.
+ * @param ent Entry to place (its dist is ignored).
+ */
+static void cl_hash_place(const struct cl_hash *hash,
+	struct cl_hash_table *tbl, const struct cl_hash_entry *ent)
+{
+	struct cl_hash_mapping tent, swap;	/* temporary entries */
+	uint32_t mask = tbl->n_size - 1;
+	uint32_t slot = cl_hash_bucket(tbl, ent->hcode);
+
+	assert(tbl->n_entries < tbl->n_size);
+	memcpy(&tent, ent, hash->n_bytes);
+	tent.entry.dist = 1;
+	tbl->n_entries++;
+	for(;;) {
+		struct cl_hash_entry *e = cl_hash_slot(hash, tbl, slot);
+		if(e->dist == 0) {
+			memcpy(e, &tent, hash->n_bytes);
+			return;
+		}
+		if(e->dist < tent.entry.dist) {
+			memcpy(&swap, e, hash->n_bytes);
+			memcpy(e, &tent, hash->n_bytes);
+			memcpy(&tent, &swap, hash->n_bytes);
 		}
-		e = e->next;
+		tent.entry.dist++;
+		slot = (slot + 1) & mask;
 	}
-	return NULL;
+}
+
+/** Remove an entry from a hash table.
+ *
+ * Following entries which aren't in their first slot are shifted back one
+ * slot.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param tbl Pointer to hash table.
+ * @param e Entry to remove.
+ */
+static void cl_hash_table_remove(const struct cl_hash *hash,
+	struct cl_hash_table *tbl, struct cl_hash_entry *e)
+{
+	uint32_t mask = tbl->n_size - 1;
+	uint32_t slot = ((uint8_t *)e - (uint8_t *)tbl->table) / hash->n_bytes;
+	for(;;) {
+		struct cl_hash_entry *n;
+		slot = (slot + 1) & mask;
+		n = cl_hash_slot(hash, tbl, slot);
+		if(n->dist <= 1)
+			break;
+		memcpy(e, n, hash->n_bytes);
+		e->dist--;
+		e = n;
+	}
+	memset(e, 0, hash->n_bytes);
+	tbl->n_entries--;
+}
+
+/** Move entries from the old table to the new one.
+ *
+ * Up to CL_HASH_MIGRATE slots of the old table are scanned, moving each entry
+ * found.  Removing an entry can shift the next one into its slot, so a slot is
+ * only passed once it's empty.
+ *
+ * @param hash Pointer to hash set or map.
+ */
+static void cl_hash_migrate(struct cl_hash *hash) {
+	struct cl_hash_table *old = &hash->h_old;
+	struct cl_hash_mapping tent;	/* temporary entry */
+	for(uint32_t i = 0; i < CL_HASH_MIGRATE && old->n_entries > 0; i++) {
+		struct cl_hash_entry *e = cl_hash_slot(hash, old,
+			hash->n_migrate);
+		if(e->dist) {
+			memcpy(&tent, e, hash->n_bytes);
+			cl_hash_table_remove(hash, old, e);
+			cl_hash_place(hash, &hash->h_new, &tent.entry);
+		} else
+			hash->n_migrate++;
+	}
+	if(old->n_entries == 0 && old->table)
+		cl_hash_old_free(hash);
 }
 
 /** Resize a hash table.
  *
- * Resize a hash table by copying all the hash entries into a new table.
+ * Start resizing: the current table becomes the old table, and entries are
+ * moved from it to a new table a few at a time.
  *
  * @param hash Pointer to hash table.
  * @param n_size New size of hash table.
  */
 static void cl_hash_resize(struct cl_hash *hash, uint32_t n_size) {
-	const uint32_t o_size = hash->n_size;
-	void **o_table = hash->table;
-
-	hash->n_size = n_size;
-	cl_hash_table_alloc(hash);
-
-	for(int i = 0; i < o_size; i++) {
-		struct cl_hash_entry *e = o_table[i];
-		while(e) {
-			struct cl_hash_entry *next = e->next;
-			uint32_t hcode = hash->fn_hash(e->key);
-			uint32_t bucket = cl_hash_bucket(hash, hcode);
-			e->next = hash->table[bucket];
-			hash->table[bucket] = e;
-			e = next;
-		}
-	}
-	free(o_table);
+	assert(!cl_hash_migrating(hash));
+	cl_hash_table_free(hash, &hash->h_old);
+	hash->h_old = hash->h_new;
+	hash->n_migrate = 0;
+	cl_hash_table_alloc(hash, &hash->h_new, n_size);
 }
 
 /** Expand a hash table.
  *
- * Expand a hash table by copying all the hash entries into a new, larger table.
+ * Expand a hash table by starting to move all the hash entries into a new,
+ * larger table.
  *
  * @param hash Pointer to hash table.
  */
 static void cl_hash_expand(struct cl_hash *hash) {
-	uint32_t n_size = hash->n_size;
+	uint32_t n_size = hash->h_new.n_size;
 	if(n_size < CL_HASH_MAX_SIZE)
 		cl_hash_resize(hash, n_size * 2);
 }
 
 /** Insert an entry into the hash.
+ *
+ * An entry with an equal key is replaced.
+ *
+ * @param hash Pointer to hash table.
+ * @param ent Entry to insert (key, value for maps).
  */
-static void cl_hash_insert(struct cl_hash *hash, struct cl_hash_entry *e) {
-	uint32_t hcode = hash->fn_hash(e->key);
-	uint32_t bucket = cl_hash_bucket(hash, hcode);
+static void cl_hash_insert(struct cl_hash *hash, struct cl_hash_entry *ent) {
+	struct cl_hash_table *tbl;
+	struct cl_hash_entry *e;
 
-	hash->n_entries++;
-	e->next = hash->table[bucket];
-	hash->table[bucket] = e;
+	ent->hcode = hash->fn_hash(ent->key);
+	e = cl_hash_lookup(hash, ent->key, ent->hcode, &tbl);
+	if(e) {
+		uint32_t dist = e->dist;
+		memcpy(e, ent, hash->n_bytes);
+		e->dist = dist;
+		return;
+	}
+	if(!cl_hash_migrating(hash) &&
+	   hash->h_new.n_entries >= cl_hash_limit(hash))
+		cl_hash_expand(hash);
+	cl_hash_place(hash, &hash->h_new, ent);
+	cl_hash_migrate(hash);
 }
 
 /** Add a new entry to a hash set.
@@ -368,13 +715,11 @@ static void cl_hash_insert(struct cl_hash *hash, struct cl_hash_entry *e) {
  * @return Key added to hash set.
  */
 const void *cl_hash_add(struct cl_hash *hash, const void *key) {
-	struct cl_hash_entry *e = cl_pool_alloc(hash->pool);
+	struct cl_hash_entry ent;
 
-	assert(e);
-	if(hash->n_entries >= cl_hash_limit(hash))
-		cl_hash_expand(hash);
-	e->key = key;
-	cl_hash_insert(hash, e);
+	assert(!cl_hash_is_map(hash));
+	ent.key = key;
+	cl_hash_insert(hash, &ent);
 	return key;
 }
 
@@ -387,32 +732,29 @@ const void *cl_hash_add(struct cl_hash *hash, const void *key) {
  * @param hash Pointer to hash map.
  * @param key Key to put into hash map.
  * @param value Value to associate with key.
- * @return Previous value associated with key.
+ * @return Key put into hash map.
  */
 const void *cl_hash_put(struct cl_hash *hash, const void *key,
 	const void *value)
 {
-	struct cl_hash_mapping *m = cl_pool_alloc(hash->pool);
-	struct cl_hash_entry *e = &m->entry;
+	struct cl_hash_mapping m;
 
-	assert(m);
-	if(hash->n_entries >= cl_hash_limit(hash))
-		cl_hash_expand(hash);
-	e->key = key;
-	m->value = value;
-	cl_hash_insert(hash, e);
+	assert(cl_hash_is_map(hash));
+	m.entry.key = key;
+	m.value = value;
+	cl_hash_insert(hash, &m.entry);
 	return key;
 }
 
 /** Shrink a hash table.
  *
- * Shrink a hash table by copying all the hash entries into a new, smaller
- * table.
+ * Shrink a hash table by starting to move all the hash entries into a new,
+ * smaller table.
  *
  * @param hash Pointer to hash table.
  */
 static void cl_hash_shrink(struct cl_hash *hash) {
-	uint32_t n_size = hash->n_size;
+	uint32_t n_size = hash->h_new.n_size;
 	if(n_size > CL_HASH_MIN_SIZE)
 		cl_hash_resize(hash, n_size / 2);
 }
@@ -426,27 +768,19 @@ static void cl_hash_shrink(struct cl_hash *hash) {
  * @return Key removed, or NULL if not found.
  */
 const void *cl_hash_remove(struct cl_hash *hash, const void *key) {
-	struct cl_hash_entry *prev = NULL;
-	uint32_t hcode = hash->fn_hash(key);
-	uint32_t bucket = cl_hash_bucket(hash, hcode);
-	struct cl_hash_entry *e = hash->table[bucket];
-	while(e) {
-		if(cl_hash_equals(hash, e, key, hcode)) {
-			key = e->key;
-			if(prev)
-				prev->next = e->next;
-			else
-				hash->table[bucket] = e->next;
-			hash->n_entries--;
-			cl_pool_release(hash->pool, e);
-			if(hash->n_entries == cl_hash_slimit(hash))
-				cl_hash_shrink(hash);
-			return key;
-		}
-		prev = e;
-		e = e->next;
-	}
-	return NULL;
+	struct cl_hash_table *tbl;
+	struct cl_hash_entry *e = cl_hash_lookup(hash, key, hash->fn_hash(key),
+		&tbl);
+
+	if(e == NULL)
+		return NULL;
+	key = e->key;
+	cl_hash_table_remove(hash, tbl, e);
+	if(!cl_hash_migrating(hash) &&
+	   hash->h_new.n_entries == cl_hash_slimit(hash))
+		cl_hash_shrink(hash);
+	cl_hash_migrate(hash);
+	return key;
 }
 
 /** Clear a hash set or map.
@@ -457,14 +791,139 @@ const void *cl_hash_remove(struct cl_hash *hash, const void *key) {
  */
 void cl_hash_clear(struct cl_hash *hash) {
 	assert(hash);
-	if(hash->n_size > CL_HASH_MIN_SIZE) {
-		free(hash->table);
-		hash->n_size = CL_HASH_MIN_SIZE;
-		cl_hash_table_alloc(hash);
-	} else
-		memset(hash->table, 0, sizeof(void *) * hash->n_size);
-	cl_pool_clear(hash->pool);
-	hash->n_entries = 0;
+	cl_hash_old_free(hash);
+	if(hash->h_new.n_size > CL_HASH_MIN_SIZE) {
+		cl_hash_table_free(hash, &hash->h_new);
+		cl_hash_table_alloc(hash, &hash->h_new, CL_HASH_MIN_SIZE);
+	} else {
+		memset(hash->h_new.table, 0,
+			(size_t)hash->h_new.n_size * hash->n_bytes);
+		hash->h_new.n_entries = 0;
+	}
+}
+
+/** Rebuild a hash table.
+ *
+ * Place every entry (from both tables) into a new table at once.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param n_size New size of hash table.
+ */
+static void cl_hash_rebuild(struct cl_hash *hash, uint32_t n_size) {
+	struct cl_hash_table tbl;
+
+	cl_hash_table_alloc(hash, &tbl, n_size);
+	for(uint32_t i = 0; i < hash->h_old.n_size; i++) {
+		struct cl_hash_entry *e = cl_hash_slot(hash, &hash->h_old, i);
+		if(e->dist)
+			cl_hash_place(hash, &tbl, e);
+	}
+	for(uint32_t i = 0; i < hash->h_new.n_size; i++) {
+		struct cl_hash_entry *e = cl_hash_slot(hash, &hash->h_new, i);
+		if(e->dist)
+			cl_hash_place(hash, &tbl, e);
+	}
+	cl_hash_old_free(hash);
+	cl_hash_table_free(hash, &hash->h_new);
+	hash->h_new = tbl;
+}
+
+/** Reserve room for entries in a hash set or map.
+ *
+ * Resize a hash (at once) so that it holds n entries without resizing again.
+ * Any migration in progress is finished.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param n Number of entries to reserve room for.
+ */
+void cl_hash_reserve(struct cl_hash *hash, uint32_t n) {
+	uint32_t n_size = cl_hash_size_for(n);
+	if(n_size < hash->h_new.n_size)
+		n_size = hash->h_new.n_size;
+	if(n_size > hash->h_new.n_size || cl_hash_migrating(hash))
+		cl_hash_rebuild(hash, n_size);
+}
+
+/** Shrink a hash set or map to fit its entries.
+ *
+ * Resize a hash (at once) to the smallest table which holds its entries.
+ *
+ * @param hash Pointer to hash set or map.
+ */
+void cl_hash_shrink_to_fit(struct cl_hash *hash) {
+	uint32_t n_size = cl_hash_size_for(cl_hash_count(hash));
+	if(n_size < hash->h_new.n_size || cl_hash_migrating(hash))
+		cl_hash_rebuild(hash, n_size);
+}
+
+/** Add up memory statistics of a hash table.
+ */
+static void cl_hash_table_stats(const struct cl_hash *hash,
+	const struct cl_hash_table *tbl, struct cl_pool_stats *stats)
+{
+	if(tbl->table) {
+		stats->n_blocks++;
+		stats->n_live += tbl->n_entries;
+		stats->n_high += tbl->n_entries;
+		stats->n_free += tbl->n_size - tbl->n_entries;
+		stats->n_bytes += (size_t)tbl->n_size * hash->n_bytes;
+		stats->n_used += (size_t)tbl->n_entries * hash->n_bytes;
+	}
+}
+
+/** Add up memory statistics of a hash set or map.
+ *
+ * Each table (two while resizing) counts as a block, with entries as live
+ * objects and empty slots as free.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param stats Statistics to add to (see cl_pool_stats).
+ */
+void cl_hash_stats(const struct cl_hash *hash, struct cl_pool_stats *stats) {
+	stats->n_pools++;
+	stats->n_bytes += sizeof(struct cl_hash);
+	cl_hash_table_stats(hash, &hash->h_new, stats);
+	cl_hash_table_stats(hash, &hash->h_old, stats);
+}
+
+/** Get probe statistics of one table.
+ */
+static void cl_hash_table_probe_stats(const struct cl_hash *hash,
+	const struct cl_hash_table *tbl, struct cl_probe_table *pt)
+{
+	memset(pt, 0, sizeof(struct cl_probe_table));
+	if(!tbl->table)
+		return;
+	pt->n_size = tbl->n_size;
+	pt->n_entries = tbl->n_entries;
+	for(uint32_t i = 0; i < tbl->n_size; i++) {
+		struct cl_hash_entry *e = cl_hash_slot(hash, tbl, i);
+		if(e->dist) {
+			uint32_t pr = e->dist - 1;
+			if(pr > pt->n_max)
+				pt->n_max = pr;
+			pt->n_total += pr;
+			pt->hist[pr < CL_PROBE_BUCKETS ? pr
+			        : CL_PROBE_BUCKETS - 1]++;
+		}
+	}
+}
+
+/** Get probe statistics of a hash set or map.
+ *
+ * The tables are scanned when called (nothing is counted as the hash is
+ * used), so this costs one pass over the slots.  While resizing, the old
+ * table is emptied into the new one; n_migrate is the entries left in it.
+ *
+ * @param hash Pointer to hash set or map.
+ * @param stats Statistics to fill in.
+ */
+void cl_hash_probe_stats(const struct cl_hash *hash,
+	struct cl_probe_stats *stats)
+{
+	cl_hash_table_probe_stats(hash, &hash->h_old, &stats->lo);
+	cl_hash_table_probe_stats(hash, &hash->h_new, &stats->hi);
+	stats->n_migrate = hash->h_old.table ? hash->h_old.n_entries : 0;
 }
 
 /** Create a hash iterator.
@@ -474,11 +933,24 @@ void cl_hash_clear(struct cl_hash *hash) {
  */
 struct cl_hash_iterator *cl_hash_iterator_create(struct cl_hash *hash) {
 	struct cl_hash_iterator *it = malloc(sizeof(struct cl_hash_iterator));
+	assert(it);
+	cl_hash_iterator_init(it, hash);
+	return it;
+}
+
+/** Initialize a hash iterator.
+ *
+ * Initialize a caller's iterator (which can be on the stack).  It doesn't
+ * need to be destroyed.
+ *
+ * @param it Hash key iterator.
+ * @param hash Pointer to hash set or map.
+ */
+void cl_hash_iterator_init(struct cl_hash_iterator *it, struct cl_hash *hash) {
 	assert(hash);
 	it->hash = hash;
 	it->curr = NULL;
 	it->bucket = 0;
-	return it;
 }
 
 /** Destroy a hash iterator.
@@ -500,21 +972,21 @@ void cl_hash_iterator_destroy(struct cl_hash_iterator *it) {
  */
 const void *cl_hash_iterator_next(struct cl_hash_iterator *it) {
 	struct cl_hash *hash = it->hash;
-	struct cl_hash_entry *e = it->curr;
-	uint32_t n_size = hash->n_size;
+	uint32_t o_size = hash->h_old.n_size;
 	assert(hash);
-	if(e)
-		e = e->next;
-	while(e == NULL && it->bucket < n_size)
-		e = hash->table[it->bucket++];
-	if(e) {
-		it->curr = e;
-		return e->key;
-	} else {
-		it->curr = NULL;
-		it->bucket = 0;
-		return NULL;
+	while(it->bucket < o_size + hash->h_new.n_size) {
+		uint32_t b = it->bucket++;
+		struct cl_hash_entry *e = (b < o_size)
+		    ? cl_hash_slot(hash, &hash->h_old, b)
+		    : cl_hash_slot(hash, &hash->h_new, b - o_size);
+		if(e->dist) {
+			it->curr = e;
+			return e->key;
+		}
 	}
+	it->curr = NULL;
+	it->bucket = 0;
+	return NULL;
 }
 
 /** Get the value associated with most recent key from a hash iterator.
@@ -524,7 +996,7 @@ const void *cl_hash_iterator_next(struct cl_hash_iterator *it) {
  */
 const void *cl_hash_iterator_value(struct cl_hash_iterator *it) {
 	struct cl_hash_mapping *m = (struct cl_hash_mapping *)it->curr;
-	if(m)
+	if(m && cl_hash_is_map(it->hash))
 		return m->value;
 	else
 		return NULL;
@@ -532,33 +1004,25 @@ const void *cl_hash_iterator_value(struct cl_hash_iterator *it) {
 
 /** String hash function.
  *
- * Simple hash function for a C string.
+ * Hash function for a C string (cl_hash_bytes).
  */
 uint32_t cl_hash_str(const void *v) {
-	const unsigned char *str = v;
-	uint32_t hash = 5381;
-	int c;
-	while((c = *str)) {
-		hash = ((hash << 5) + hash) + c;
-		str++;
-	}
-	return hash;
+	return cl_hash_bytes(v, strlen(v), 0);
 }
 
 /** Int hash function.
  *
- * Simple hash function for an int.
+ * Hash function for an int, mixed so sequential ints spread over buckets.
  */
 uint32_t cl_hash_int(const void *v) {
 	int i = (int)(long)v;
-	return i;
+	return (uint32_t)cl_hash_mix((uint32_t)i);
 }
 
 /** Pointer hash function.
  *
- * Simple hash function for a pointer.
+ * Hash function for a pointer, mixed so aligned pointers spread over buckets.
  */
 uint32_t cl_hash_ptr(const void *v) {
-	long p = (long)v;
-	return (p >> (4 * sizeof(long))) ^ p;
+	return (uint32_t)cl_hash_mix((uintptr_t)v);
 }
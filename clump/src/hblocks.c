@@ -0,0 +1,336 @@
+/*
+ * hblocks.c	Multi-block huffman compression
+ *
+ * Copyright (c) 2011-2012  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_hcodec_blocks_bound		Get the most bytes of encoded blocks
+ *	cl_hcodec_encode_blocks		Encode a buffer as blocks
+ *	cl_hcodec_blocks_size		Get the decoded size of blocks
+ *	cl_hcodec_blocks_count		Get the number of blocks
+ *	cl_hcodec_decode_block		Decode one block
+ *	cl_hcodec_decode_blocks		Decode all blocks
+ */
+/** \file
+ *
+ * A large buffer is split into CL_HCODEC_BLOCK_SIZE blocks, each encoded
+ * independently by cl_hcodec_encode.  Since blocks are independent, they
+ * can be encoded and decoded in parallel: the blocks are split into jobs
+ * (each with its own codec), which are run by a callback, so the caller
+ * decides how to run them on worker threads.  Without a callback, jobs
+ * run one after another on the calling thread.
+ *
+ * The encoded format is:
+ *
+ *	uint32	decoded size (in bytes)
+ *	uint32	end offset of each block's data (after the index)
+ *	...	block data
+ *
+ * All integers are little-endian.  The high bit of an end offset is set
+ * for a block which is stored raw (because it didn't compress).  Any block
+ * can be decoded on its own, by looking up its offsets in the index.
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include "clump.h"
+
+/** Blocks encoded or decoded by each job */
+#define CL_HBLOCKS_JOB_BLOCKS	(16)
+
+/** End offset flag for a raw block */
+#define CL_HBLOCKS_RAW		(1u << 31)
+
+/** Multi-block job.
+ */
+struct cl_hblocks_job {
+	const unsigned char	*in;		/* input buffer */
+	size_t			n_in;		/* bytes in input buffer */
+	unsigned char		*out;		/* output buffer */
+	size_t			n_out;		/* bytes in output buffer */
+	uint32_t		first;		/* first block of job */
+	uint32_t		n_blocks;	/* number of blocks in job */
+	bool			ok;		/* all blocks done */
+};
+
+/** Get a little-endian uint32.
+ */
+static uint32_t cl_hblocks_get(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/** Put a little-endian uint32.
+ */
+static void cl_hblocks_put(unsigned char *p, uint32_t v) {
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+/** Get the number of blocks for a decoded size.
+ */
+static uint32_t cl_hblocks_n_blocks(size_t n_bytes) {
+	return (n_bytes + CL_HCODEC_BLOCK_SIZE - 1) / CL_HCODEC_BLOCK_SIZE;
+}
+
+/** Get the size of the header (with the block index).
+ */
+static size_t cl_hblocks_header(uint32_t n_blocks) {
+	return 4 + 4 * (size_t)n_blocks;
+}
+
+/** Get the decoded size of one block.
+ */
+static unsigned int cl_hblocks_block_size(size_t n_bytes, uint32_t i) {
+	size_t start = (size_t)i * CL_HCODEC_BLOCK_SIZE;
+	size_t n = n_bytes - start;
+	return n < CL_HCODEC_BLOCK_SIZE ? n : CL_HCODEC_BLOCK_SIZE;
+}
+
+/** Get the most bytes needed to encode a buffer as blocks.
+ *
+ * @param n_in Number of bytes to encode.
+ * @return Size of output buffer needed by cl_hcodec_encode_blocks.
+ */
+size_t cl_hcodec_blocks_bound(size_t n_in) {
+	return cl_hblocks_header(cl_hblocks_n_blocks(n_in)) + n_in;
+}
+
+/** Run jobs with a callback, or one after another.
+ */
+static void cl_hblocks_run(cl_run_jobs_cb *run_jobs, cl_job_cb *run,
+	struct cl_hblocks_job *jobs, uint32_t n_jobs)
+{
+	void **ptrs;
+	uint32_t i;
+
+	if(run_jobs == NULL || n_jobs < 2) {
+		for(i = 0; i < n_jobs; i++)
+			run(jobs + i);
+		return;
+	}
+	ptrs = malloc(n_jobs * sizeof(void *));
+	assert(ptrs);
+	for(i = 0; i < n_jobs; i++)
+		ptrs[i] = jobs + i;
+	run_jobs(run, ptrs, n_jobs);
+	free(ptrs);
+}
+
+/** Split blocks into jobs and run them.
+ *
+ * @return true if all jobs were ok.
+ */
+static bool cl_hblocks_split(cl_run_jobs_cb *run_jobs, cl_job_cb *run,
+	const unsigned char *in, size_t n_in, unsigned char *out,
+	size_t n_out, uint32_t n_blocks)
+{
+	uint32_t n_jobs = (n_blocks + CL_HBLOCKS_JOB_BLOCKS - 1) /
+		CL_HBLOCKS_JOB_BLOCKS;
+	struct cl_hblocks_job *jobs;
+	uint32_t i;
+	bool ok = true;
+
+	if(n_jobs == 0)
+		return true;
+	jobs = malloc(n_jobs * sizeof(struct cl_hblocks_job));
+	assert(jobs);
+	for(i = 0; i < n_jobs; i++) {
+		struct cl_hblocks_job *job = jobs + i;
+		job->in = in;
+		job->n_in = n_in;
+		job->out = out;
+		job->n_out = n_out;
+		job->first = i * CL_HBLOCKS_JOB_BLOCKS;
+		job->n_blocks = n_blocks - job->first;
+		if(job->n_blocks > CL_HBLOCKS_JOB_BLOCKS)
+			job->n_blocks = CL_HBLOCKS_JOB_BLOCKS;
+		job->ok = false;
+	}
+	cl_hblocks_run(run_jobs, run, jobs, n_jobs);
+	for(i = 0; i < n_jobs; i++)
+		ok = ok && jobs[i].ok;
+	free(jobs);
+	return ok;
+}
+
+/** Encode the blocks of a job.
+ *
+ * Each block is encoded into its own slot (the size of the block) after
+ * the index, and its size is put in the index.
+ */
+static void cl_hblocks_encode_job(void *data) {
+	struct cl_hblocks_job *job = data;
+	struct cl_hcodec *hc = cl_hcodec_create();
+	uint32_t n_blocks = cl_hblocks_n_blocks(job->n_in);
+	unsigned char *slots = job->out + cl_hblocks_header(n_blocks);
+	uint32_t i;
+
+	for(i = job->first; i < job->first + job->n_blocks; i++) {
+		size_t start = (size_t)i * CL_HCODEC_BLOCK_SIZE;
+		unsigned int n = cl_hblocks_block_size(job->n_in, i);
+		int n_enc = cl_hcodec_encode(hc, job->in + start, n,
+			slots + start, n);
+		/* An encoding filling the slot may have been cut short */
+		if(n_enc <= 0 || (unsigned int)n_enc >= n) {
+			memcpy(slots + start, job->in + start, n);
+			cl_hblocks_put(job->out + 4 + 4 * i,
+				n | CL_HBLOCKS_RAW);
+		} else
+			cl_hblocks_put(job->out + 4 + 4 * i, n_enc);
+	}
+	cl_hcodec_destroy(hc);
+	job->ok = true;
+}
+
+/** Encode a buffer as blocks.
+ *
+ * @param in Buffer to encode.
+ * @param n_in Number of bytes to encode (less than 2 GB).
+ * @param out Output buffer.
+ * @param n_out Size of output buffer (at least cl_hcodec_blocks_bound).
+ * @param run_jobs Callback to run jobs, or NULL to run them in turn.
+ * @return Number of bytes encoded, or 0 if the output buffer is too small.
+ */
+size_t cl_hcodec_encode_blocks(const unsigned char *in, size_t n_in,
+	unsigned char *out, size_t n_out, cl_run_jobs_cb *run_jobs)
+{
+	uint32_t n_blocks = cl_hblocks_n_blocks(n_in);
+	size_t header = cl_hblocks_header(n_blocks);
+	size_t end = 0;
+	uint32_t i;
+
+	if(n_in >= CL_HBLOCKS_RAW || n_out < cl_hcodec_blocks_bound(n_in))
+		return 0;
+	cl_hblocks_put(out, n_in);
+	cl_hblocks_split(run_jobs, cl_hblocks_encode_job, in, n_in, out,
+		n_out, n_blocks);
+	/* Pack the slots together, turning sizes into end offsets */
+	for(i = 0; i < n_blocks; i++) {
+		unsigned char *idx = out + 4 + 4 * i;
+		uint32_t e = cl_hblocks_get(idx);
+		uint32_t n = e & ~CL_HBLOCKS_RAW;
+		size_t start = (size_t)i * CL_HCODEC_BLOCK_SIZE;
+		memmove(out + header + end, out + header + start, n);
+		end += n;
+		cl_hblocks_put(idx, end | (e & CL_HBLOCKS_RAW));
+	}
+	return header + end;
+}
+
+/** Check the header of encoded blocks.
+ *
+ * @param n_bytes Decoded size (written).
+ * @return true if the header (with the index) is complete.
+ */
+static bool cl_hblocks_check(const unsigned char *in, size_t n_in,
+	size_t *n_bytes)
+{
+	if(n_in < 4)
+		return false;
+	*n_bytes = cl_hblocks_get(in);
+	return n_in >= cl_hblocks_header(cl_hblocks_n_blocks(*n_bytes));
+}
+
+/** Get the decoded size of encoded blocks.
+ *
+ * @param in Encoded blocks.
+ * @param n_in Number of encoded bytes.
+ * @return Number of bytes the blocks decode to, or 0 if invalid.
+ */
+size_t cl_hcodec_blocks_size(const unsigned char *in, size_t n_in) {
+	size_t n_bytes;
+	return cl_hblocks_check(in, n_in, &n_bytes) ? n_bytes : 0;
+}
+
+/** Get the number of encoded blocks.
+ *
+ * @param in Encoded blocks.
+ * @param n_in Number of encoded bytes.
+ * @return Number of blocks, or 0 if invalid.
+ */
+uint32_t cl_hcodec_blocks_count(const unsigned char *in, size_t n_in) {
+	return cl_hblocks_n_blocks(cl_hcodec_blocks_size(in, n_in));
+}
+
+/** Decode one block.
+ *
+ * @param hc Huffman codec.
+ * @param in Encoded blocks.
+ * @param n_in Number of encoded bytes.
+ * @param i Index of block to decode.
+ * @param out Output buffer.
+ * @param n_out Size of output buffer (at least CL_HCODEC_BLOCK_SIZE, or
+ *              the size of the last block).
+ * @return Number of bytes decoded, or -1 on error.
+ */
+int cl_hcodec_decode_block(struct cl_hcodec *hc, const unsigned char *in,
+	size_t n_in, uint32_t i, unsigned char *out, unsigned int n_out)
+{
+	size_t n_bytes = cl_hcodec_blocks_size(in, n_in);
+	uint32_t n_blocks = cl_hblocks_n_blocks(n_bytes);
+	size_t header = cl_hblocks_header(n_blocks);
+	uint32_t start, end, e;
+	unsigned int n;
+
+	if(i >= n_blocks)
+		return -1;
+	start = i ? cl_hblocks_get(in + 4 * i) & ~CL_HBLOCKS_RAW : 0;
+	e = cl_hblocks_get(in + 4 + 4 * i);
+	end = e & ~CL_HBLOCKS_RAW;
+	n = cl_hblocks_block_size(n_bytes, i);
+	if(start > end || end > n_in - header || n_out < n)
+		return -1;
+	if(e & CL_HBLOCKS_RAW) {
+		if(end - start != n)
+			return -1;
+		memcpy(out, in + header + start, n);
+		return n;
+	}
+	/* The decoder only reads its input, though it isn't const */
+	if(cl_hcodec_decode(hc, (unsigned char *)in + header + start,
+		end - start, out, n) != (int)n)
+		return -1;
+	return n;
+}
+
+/** Decode the blocks of a job.
+ */
+static void cl_hblocks_decode_job(void *data) {
+	struct cl_hblocks_job *job = data;
+	struct cl_hcodec *hc = cl_hcodec_create();
+	uint32_t i;
+
+	job->ok = true;
+	for(i = job->first; i < job->first + job->n_blocks; i++) {
+		size_t start = (size_t)i * CL_HCODEC_BLOCK_SIZE;
+		if(cl_hcodec_decode_block(hc, job->in, job->n_in, i,
+			job->out + start, job->n_out - start) < 0)
+		{
+			job->ok = false;
+			break;
+		}
+	}
+	cl_hcodec_destroy(hc);
+}
+
+/** Decode all blocks.
+ *
+ * @param in Encoded blocks.
+ * @param n_in Number of encoded bytes.
+ * @param out Output buffer.
+ * @param n_out Size of output buffer (at least cl_hcodec_blocks_size).
+ * @param run_jobs Callback to run jobs, or NULL to run them in turn.
+ * @return true if all blocks were decoded, false on error.
+ */
+bool cl_hcodec_decode_blocks(const unsigned char *in, size_t n_in,
+	unsigned char *out, size_t n_out, cl_run_jobs_cb *run_jobs)
+{
+	size_t n_bytes;
+	if(!cl_hblocks_check(in, n_in, &n_bytes) || n_out < n_bytes)
+		return false;
+	return cl_hblocks_split(run_jobs, cl_hblocks_decode_job, in, n_in,
+		out, n_out, cl_hblocks_n_blocks(n_bytes));
+}
@@ -9,6 +9,11 @@
  *	cl_hcodec_destroy	Destroy a huffman codec
  *	cl_hcodec_encode	Encode a block of data
  *	cl_hcodec_decode	Decode a block of data
+ *	cl_hcodec_train		Train a shared codebook from sample data
+ *	cl_hcodec_get_codebook	Get the code lengths of a shared codebook
+ *	cl_hcodec_set_codebook	Set a shared codebook from code lengths
+ *	cl_hcodec_encode_shared	Encode a block with the shared codebook
+ *	cl_hcodec_decode_shared	Decode a block with the shared codebook
  *
  * This is a data compression module intended to compress fixed-length
  * blocks of data (as opposed to streams).  Each block of data is treated
@@ -16,8 +21,24 @@
  * than 100 bytes) and very random blocks will not compress well.  The goal
  * is to compress 4K blocks optimally.  This is not a very fancy module --
  * it simply uses the huffman algorithm with a canonical encoding.
+ *
+ * Decoding is table-driven: the next CL_HCODEC_TABLE_BITS bits of input
+ * (peeked from the bit array) index a table giving the symbol and its code
+ * length.  Longer codes get a second-level table for their prefix.  If a
+ * codebook has codes too long for the tables (which is rare, and can't
+ * happen in a 4K block), symbols are decoded by walking the huffman tree
+ * instead.
+ *
+ * For many small blocks with similar data, the per-block codebook (and
+ * building the tree) costs more than it saves.  A codec can instead be
+ * trained once from sample data, and then encode and decode blocks with
+ * that shared codebook, which isn't stored in the blocks.  Every symbol
+ * gets a code (even ones missing from the sample), and codes are limited
+ * so that the decode tables can hold them all.
  */
 #include <assert.h>	/* assert */
+#include <stdbool.h>	/* bool */
+#include <stdint.h>	/* uint32_t */
 #include <stdlib.h>	/* malloc */
 #include <string.h>	/* memset */
 #include <stdio.h>
@@ -85,29 +106,82 @@ static cl_compare_t cl_hnode_compare(const void *v0, const void *v1) {
 		if(n0->symbol > n1->symbol)
 			return 1;
 	}
+	/* both nodes are internal, compare nodes (so the order is total, and
+	 * the tree doesn't depend on how the queue breaks ties) */
+	if(n0 < n1)
+		return -1;
+	if(n0 > n1)
+		return 1;
 	return 0;
 }
 
+/** Bits indexing the first-level decode table */
+#define CL_HCODEC_TABLE_BITS	(10)
+
+/** Most bits indexing a second-level decode table */
+#define CL_HCODEC_SUB_BITS	(8)
+
+/** Entries for all second-level decode tables */
+#define CL_HCODEC_SUB_SIZE	(2048)
+
+/** Decode table entry flag for a link to a second-level table.
+ *
+ * A symbol entry holds the code length (0 for an unused code) in bits 0-7
+ * and the symbol value in bits 8-15.  A link entry holds the number of bits
+ * indexing the second-level table in bits 0-7 and its offset in bits 8-30.
+ */
+#define CL_HCODEC_LINK		(1u << 31)
+
 /** Huffman codec structure.
  */
 struct cl_hcodec {
 	struct cl_symbol	symbols[MAX_SYMBOLS];	/* symbol table */
 	struct cl_hnode		nodes[MAX_NODES];	/* array of nodes */
-	struct cl_tree		*pqueue;		/* priority queue */
+	struct cl_heap		*pqueue;		/* priority queue */
 	struct cl_bitarray	*bits;			/* bit array */
+	uint32_t		table[1 << CL_HCODEC_TABLE_BITS];
+							/* decode table */
+	uint32_t		sub[CL_HCODEC_SUB_SIZE];/* second-level tables */
+	uint16_t		book[1 << CL_HCODEC_BOOK_MAX_BITS];
+							/* codebook table */
+	unsigned char		shared[MAX_SYMBOLS];	/* shared code lengths */
+	bool			has_shared;		/* shared codebook set */
+	bool			in_use;			/* symbols & tables
+							 * hold shared book */
 };
 
+/** Build the table for decoding the built-in codebook.
+ *
+ * Each entry is indexed by the next CL_HCODEC_BOOK_MAX_BITS bits, and holds
+ * the code length in bits 0-3 and the decoded bit count in bits 4-11.
+ */
+static void cl_hcodec_build_book(struct cl_hcodec *hc) {
+	unsigned int i;
+	memset(hc->book, 0, sizeof(hc->book));
+	for(i = 0; i < MAX_SYMBOLS; i++) {
+		unsigned int n_bits = CL_HCODEC_BOOK[i][1];
+		unsigned int shift = CL_HCODEC_BOOK_MAX_BITS - n_bits;
+		unsigned int e = CL_HCODEC_BOOK[i][0] << shift;
+		unsigned int j;
+		for(j = 0; j < (1u << shift); j++)
+			hc->book[e + j] = (i << 4) | n_bits;
+	}
+}
+
 /** Create a huffman codec.
  */
 struct cl_hcodec *cl_hcodec_create(void) {
 	unsigned int i;
 	struct cl_hcodec *hc = malloc(sizeof(struct cl_hcodec));
 	assert(hc);
-	hc->pqueue = cl_tree_create_set(cl_hnode_compare);
+	hc->pqueue = cl_heap_create(cl_hnode_compare);
 	hc->bits = cl_bitarray_create();
 	memset(hc->symbols, 0, MAX_SYMBOLS * sizeof(struct cl_symbol));
 	for(i = 0; i < MAX_SYMBOLS; i++)
 		hc->symbols[i].value = i;
+	cl_hcodec_build_book(hc);
+	hc->has_shared = false;
+	hc->in_use = false;
 	return hc;
 }
 
@@ -116,7 +190,7 @@ struct cl_hcodec *cl_hcodec_create(void) {
 void cl_hcodec_destroy(struct cl_hcodec *hc) {
 	assert(hc);
 	cl_bitarray_destroy(hc->bits);
-	cl_tree_destroy(hc->pqueue);
+	cl_heap_destroy(hc->pqueue);
 #ifndef NDEBUG
 	hc->pqueue = NULL;
 	hc->bits = NULL;
@@ -132,8 +206,10 @@ static void cl_hcodec_scan_symbols(struct cl_hcodec *hc,
 	unsigned int i;
 	const unsigned char *buf;
 
-	for(i = 0; i < MAX_SYMBOLS; i++)
+	for(i = 0; i < MAX_SYMBOLS; i++) {
 		hc->symbols[i].n_refs = 0;
+		hc->symbols[i].n_bits = 0;
+	}
 	for(buf = in; buf < in + size; buf++)
 		hc->symbols[*buf].n_refs++;
 }
@@ -149,7 +225,7 @@ static struct cl_hnode *cl_hcodec_build_leaf_nodes(struct cl_hcodec *hc) {
 			n->right = NULL;
 			n->symbol = sym;
 			n->weight = sym->n_refs;
-			cl_tree_add(hc->pqueue, n);
+			cl_heap_push(hc->pqueue, n);
 			n++;
 		}
 	}
@@ -160,25 +236,22 @@ static struct cl_hnode *cl_hcodec_build_leaf_nodes(struct cl_hcodec *hc) {
  */
 static struct cl_hnode *cl_hcodec_build(struct cl_hcodec *hc) {
 	struct cl_hnode *n = cl_hcodec_build_leaf_nodes(hc);
-	while(cl_tree_count(hc->pqueue) > 1) {
+	while(cl_heap_count(hc->pqueue) > 1) {
 		const struct cl_hnode *n0, *n1;
-		n0 = cl_tree_peek(hc->pqueue);
+		n0 = cl_heap_pop(hc->pqueue);
 		assert(n0);
-		cl_tree_remove(hc->pqueue, n0);
-		n1 = cl_tree_peek(hc->pqueue);
+		n1 = cl_heap_pop(hc->pqueue);
 		assert(n1);
-		cl_tree_remove(hc->pqueue, n1);
 		assert(n < hc->nodes + MAX_NODES);
 		n->left = (struct cl_hnode *)n1;
 		n->right = (struct cl_hnode *)n0;
 		n->weight = n0->weight + n1->weight;
 		n->symbol = NULL;
-		cl_tree_add(hc->pqueue, n);
+		cl_heap_push(hc->pqueue, n);
 		n++;
 	}
-	n = (struct cl_hnode *)cl_tree_peek(hc->pqueue);
+	n = (struct cl_hnode *)cl_heap_pop(hc->pqueue);
 	assert(n);
-	cl_tree_remove(hc->pqueue, n);
 	return n;
 }
 
@@ -200,46 +273,31 @@ static void cl_hnode_assign_code(struct cl_hnode *n, unsigned int code,
 	}
 }
 
-/** Compare two symbols for canonical ordering.
- */
-static int cl_symbol_canonical_compare(const void *v0, const void *v1) {
-	const struct cl_symbol **ss0 = (const struct cl_symbol **)v0;
-	const struct cl_symbol *s0 = *ss0;
-	const struct cl_symbol **ss1 = (const struct cl_symbol **)v1;
-	const struct cl_symbol *s1 = *ss1;
-	if(s0->n_bits < s1->n_bits)
-		return -1;
-	if(s0->n_bits > s1->n_bits)
-		return 1;
-	if(s0->value < s1->value)
-		return -1;
-	if(s0->value > s1->value)
-		return 1;
-	else
-		return 0;
-}
-
 /** Make the codebook canonical.
+ *
+ * Codes are assigned in order of bit count, then symbol value; the first
+ * code of each bit count follows the last code of the next shorter one.
  */
 static void cl_hcodec_make_canonical(struct cl_hcodec *hc) {
-	struct cl_symbol *csym[MAX_SYMBOLS];
+	unsigned int n_codes[MAX_SYMBOLS];
+	unsigned int next[MAX_SYMBOLS];
 	unsigned int i;
 	unsigned int code = 0;
-	unsigned int n_bits = 0;
 
+	memset(n_codes, 0, sizeof(n_codes));
 	for(i = 0; i < MAX_SYMBOLS; i++)
-		csym[i] = hc->symbols + i;
-	qsort(csym, MAX_SYMBOLS, sizeof(struct cl_symbol *),
-		cl_symbol_canonical_compare);
+		n_codes[hc->symbols[i].n_bits]++;
+	n_codes[0] = 0;
+	next[0] = 0;
+	for(i = 1; i < MAX_SYMBOLS; i++) {
+		code = (code + n_codes[i - 1]) << 1;
+		next[i] = code;
+	}
 	for(i = 0; i < MAX_SYMBOLS; i++) {
-		struct cl_symbol *sym = csym[i];
-		while(n_bits < sym->n_bits) {
-			code <<= 1;
-			n_bits++;
-		}
-		sym->code = code;
-		if(n_bits)
-			code++;
+		struct cl_symbol *sym = hc->symbols + i;
+		sym->code = next[sym->n_bits];
+		if(sym->n_bits)
+			next[sym->n_bits]++;
 	}
 }
 
@@ -275,6 +333,7 @@ int cl_hcodec_encode(struct cl_hcodec *hc, const unsigned char *in,
 {
 	struct cl_hnode *root;
 
+	hc->in_use = false;
 	cl_hcodec_scan_symbols(hc, in, n_in);
 	root = cl_hcodec_build(hc);
 	if(root) {
@@ -289,27 +348,108 @@ int cl_hcodec_encode(struct cl_hcodec *hc, const unsigned char *in,
 		return 0;
 }
 
-/** Decode number of bits for a codebook symbol.
+/** Check that the code lengths of a codebook make a prefix code.
  */
-static int cl_hcodec_decode_codebook_bits(struct cl_hcodec *hc) {
-	unsigned int n_bits;
-	unsigned int code = 0;
-	for(n_bits = 1; n_bits <= CL_HCODEC_BOOK_MAX_BITS; n_bits++) {
-		int b = cl_bitarray_pop(hc->bits);
-		if(b >= 0) {
-			int i;
-			code |= b;
-			for(i = 0; i < MAX_SYMBOLS; i++) {
-				if(CL_HCODEC_BOOK[i][1] == n_bits &&
-				   CL_HCODEC_BOOK[i][0] == code)
-					return i;
-			}
-			code <<= 1;
-		} else
-			break;
+static bool cl_hcodec_check_codebook(struct cl_hcodec *hc) {
+	unsigned int n_codes[MAX_SYMBOLS];
+	unsigned int i;
+	int left = 1;		/* unused codes of the current length */
+
+	memset(n_codes, 0, sizeof(n_codes));
+	for(i = 0; i < MAX_SYMBOLS; i++) {
+		unsigned int n_bits = hc->symbols[i].n_bits;
+		/* Codes are pushed as a range of bits */
+		if(n_bits > 31)
+			return false;
+		n_codes[n_bits]++;
+	}
+	for(i = 1; i < 32 && left <= MAX_SYMBOLS; i++) {
+		left = (left << 1) - n_codes[i];
+		if(left < 0)
+			return false;
 	}
-	/* Symbol not found in codebook */
-	return -1;
+	return true;
+}
+
+/** Decode a canonical huffman codebook.
+ */
+static bool cl_hcodec_decode_codebook(struct cl_hcodec *hc) {
+	unsigned int i;
+	for(i = 0; i < MAX_SYMBOLS; i++) {
+		unsigned int e = hc->book[cl_bitarray_peek(hc->bits,
+			CL_HCODEC_BOOK_MAX_BITS)];
+		unsigned int n_bits = e & 0x0f;
+		if(n_bits == 0 || n_bits > cl_bitarray_remaining(hc->bits))
+			return false;
+		hc->symbols[i].n_bits = e >> 4;
+		cl_bitarray_skip(hc->bits, n_bits);
+	}
+	if(!cl_hcodec_check_codebook(hc))
+		return false;
+	cl_hcodec_make_canonical(hc);
+	return true;
+}
+
+/** Build the decode tables from a canonical codebook.
+ *
+ * @return true on success, or false if codes are too long for the tables.
+ */
+static bool cl_hcodec_build_table(struct cl_hcodec *hc) {
+	unsigned char sub_bits[1 << CL_HCODEC_TABLE_BITS];
+	const unsigned int t_bits = CL_HCODEC_TABLE_BITS;
+	const unsigned int max_bits = t_bits + CL_HCODEC_SUB_BITS;
+	unsigned int i, n_sub = 0;
+
+	for(i = 0; i < MAX_SYMBOLS; i++) {
+		if(hc->symbols[i].n_bits > max_bits)
+			return false;
+	}
+	memset(hc->table, 0, sizeof(hc->table));
+	memset(sub_bits, 0, sizeof(sub_bits));
+	/* Find the longest code for each second-level table */
+	for(i = 0; i < MAX_SYMBOLS; i++) {
+		struct cl_symbol *sym = hc->symbols + i;
+		if(sym->n_bits > t_bits) {
+			unsigned int p = sym->code >> (sym->n_bits - t_bits);
+			unsigned int n = sym->n_bits - t_bits;
+			if(n > sub_bits[p])
+				sub_bits[p] = n;
+		}
+	}
+	/* Link the first-level table to second-level tables */
+	for(i = 0; i < (1u << t_bits); i++) {
+		if(sub_bits[i]) {
+			unsigned int n = 1u << sub_bits[i];
+			if(n_sub + n > CL_HCODEC_SUB_SIZE)
+				return false;
+			memset(hc->sub + n_sub, 0, n * sizeof(uint32_t));
+			hc->table[i] = CL_HCODEC_LINK | (n_sub << 8) |
+				sub_bits[i];
+			n_sub += n;
+		}
+	}
+	/* Fill in entries for each code */
+	for(i = 0; i < MAX_SYMBOLS; i++) {
+		struct cl_symbol *sym = hc->symbols + i;
+		uint32_t e = (sym->value << 8) | sym->n_bits;
+		uint32_t *t;
+		unsigned int j, shift;
+		if(sym->n_bits == 0)
+			continue;
+		if(sym->n_bits <= t_bits) {
+			shift = t_bits - sym->n_bits;
+			t = hc->table + (sym->code << shift);
+		} else {
+			unsigned int n = sym->n_bits - t_bits;
+			uint32_t link = hc->table[sym->code >> n];
+			shift = (link & 0xff) - n;
+			t = hc->sub + ((link & ~CL_HCODEC_LINK) >> 8) +
+				((sym->code & ((1u << n) - 1)) << shift);
+		}
+		for(j = 0; j < (1u << shift); j++)
+			t[j] = e;
+	}
+	return true;
 }
 
 /** Restore one symbol node.
@@ -363,23 +503,7 @@ static struct cl_hnode *cl_hcodec_restore_tree(struct cl_hcodec *hc) {
 	return hc->nodes;
 }
 
-/** Decode a canonical huffman codebook.
- */
-static struct cl_hnode *cl_hcodec_decode_codebook(struct cl_hcodec *hc) {
-	unsigned int i;
-	for(i = 0; i < MAX_SYMBOLS; i++) {
-		struct cl_symbol *sym = hc->symbols + i;
-		int n_bits = cl_hcodec_decode_codebook_bits(hc);
-		if(n_bits >= 0)
-			sym->n_bits = n_bits;
-		else
-			return NULL;
-	}
-	cl_hcodec_make_canonical(hc);
-	return cl_hcodec_restore_tree(hc);
-}
-
-/** Decode one symbol.
+/** Decode one symbol by walking the huffman tree.
  */
 static struct cl_symbol *cl_hcodec_decode_symbol(struct cl_hcodec *hc,
 	struct cl_hnode *root)
@@ -400,27 +524,228 @@ static struct cl_symbol *cl_hcodec_decode_symbol(struct cl_hcodec *hc,
 		return NULL;
 }
 
-/** Decode a block of data.
+/** Decode a block of data by walking the huffman tree.
  */
-int cl_hcodec_decode(struct cl_hcodec *hc, unsigned char *in,
-	unsigned int n_in, unsigned char *out, unsigned int n_out)
+static int cl_hcodec_decode_tree(struct cl_hcodec *hc, unsigned char *out,
+	unsigned int n_out)
 {
-	struct cl_hnode		*root;
-	unsigned int		i;
-	unsigned char		*buf;
-
-	cl_bitarray_wrap(hc->bits, in, n_in * 8);
-	root = cl_hcodec_decode_codebook(hc);
+	struct cl_hnode *root = cl_hcodec_restore_tree(hc);
+	unsigned int i;
 	if(!root)
 		return -1;
-	buf = out;
 	for(i = 0; i < n_out; i++) {
 		struct cl_symbol *sym = cl_hcodec_decode_symbol(hc, root);
-		if(sym) {
-			*buf = sym->value;
-			buf++;
-		} else
+		if(sym)
+			out[i] = sym->value;
+		else
 			break;
 	}
-	return buf - out;
+	return i;
+}
+
+/** Look up the decode table entry for a code.
+ *
+ * @param hc Huffman codec.
+ * @param code Next CL_HCODEC_TABLE_BITS + CL_HCODEC_SUB_BITS bits.
+ */
+static inline uint32_t cl_hcodec_lookup(const struct cl_hcodec *hc,
+	uint32_t code)
+{
+	uint32_t e = hc->table[code >> CL_HCODEC_SUB_BITS];
+	if(e & CL_HCODEC_LINK) {
+		unsigned int s = e & 0xff;
+		unsigned int j = (code >> (CL_HCODEC_SUB_BITS - s)) &
+			((1u << s) - 1);
+		e = hc->sub[((e & ~CL_HCODEC_LINK) >> 8) + j];
+	}
+	return e;
+}
+
+/** Decode a block of data with the decode tables.
+ *
+ * Codes are decoded from 32 bits peeked at once, while those hold at least
+ * one whole code (the bit array is only checked once per peek).
+ */
+static int cl_hcodec_decode_table(struct cl_hcodec *hc, unsigned char *out,
+	unsigned int n_out)
+{
+	const unsigned int max_bits = CL_HCODEC_TABLE_BITS + CL_HCODEC_SUB_BITS;
+	unsigned int left = cl_bitarray_remaining(hc->bits);
+	unsigned int i = 0;
+	while(i < n_out) {
+		uint32_t bits = cl_bitarray_peek(hc->bits, 32);
+		unsigned int n_used = 0;
+		do {
+			uint32_t e = cl_hcodec_lookup(hc,
+				bits >> (32 - max_bits));
+			unsigned int n_bits = e & 0xff;
+			/* Stop at an unused code or the end of input */
+			if(n_bits == 0 || n_bits > left) {
+				cl_bitarray_skip(hc->bits, n_used);
+				return i;
+			}
+			out[i++] = e >> 8;
+			bits <<= n_bits;
+			n_used += n_bits;
+			left -= n_bits;
+		} while(n_used <= 32 - max_bits && i < n_out);
+		cl_bitarray_skip(hc->bits, n_used);
+	}
+	return i;
+}
+
+/** Decode a block of data.
+ */
+int cl_hcodec_decode(struct cl_hcodec *hc, unsigned char *in,
+	unsigned int n_in, unsigned char *out, unsigned int n_out)
+{
+	hc->in_use = false;
+	cl_bitarray_wrap(hc->bits, in, n_in * 8);
+	if(!cl_hcodec_decode_codebook(hc))
+		return -1;
+	if(cl_hcodec_build_table(hc))
+		return cl_hcodec_decode_table(hc, out, n_out);
+	else
+		return cl_hcodec_decode_tree(hc, out, n_out);
+}
+
+/** Put the shared codebook into the symbols and decode tables.
+ */
+static void cl_hcodec_use_shared(struct cl_hcodec *hc) {
+	unsigned int i;
+	if(hc->in_use)
+		return;
+	for(i = 0; i < MAX_SYMBOLS; i++)
+		hc->symbols[i].n_bits = hc->shared[i];
+	cl_hcodec_make_canonical(hc);
+	if(!cl_hcodec_build_table(hc))
+		assert(false);
+	hc->in_use = true;
+}
+
+/** Train a shared codebook from sample data.
+ *
+ * @param hc Huffman codec.
+ * @param sample Sample data.
+ * @param n Number of bytes of sample data.
+ */
+void cl_hcodec_train(struct cl_hcodec *hc, const unsigned char *sample,
+	unsigned int n)
+{
+	const unsigned int max_bits = CL_HCODEC_TABLE_BITS + CL_HCODEC_SUB_BITS;
+	unsigned int i, n_bits;
+
+	cl_hcodec_scan_symbols(hc, sample, n);
+	/* Every symbol needs a code */
+	for(i = 0; i < MAX_SYMBOLS; i++)
+		hc->symbols[i].n_refs++;
+	do {
+		cl_hnode_assign_code(cl_hcodec_build(hc), 0, 0);
+		n_bits = 0;
+		for(i = 0; i < MAX_SYMBOLS; i++) {
+			if(hc->symbols[i].n_bits > n_bits)
+				n_bits = hc->symbols[i].n_bits;
+		}
+		/* Flatten the counts until the codes fit the tables */
+		if(n_bits > max_bits) {
+			for(i = 0; i < MAX_SYMBOLS; i++)
+				hc->symbols[i].n_refs =
+					(hc->symbols[i].n_refs + 1) / 2;
+		}
+	} while(n_bits > max_bits);
+	for(i = 0; i < MAX_SYMBOLS; i++)
+		hc->shared[i] = hc->symbols[i].n_bits;
+	hc->has_shared = true;
+	hc->in_use = false;
+	cl_hcodec_use_shared(hc);
+}
+
+/** Get the code lengths of the shared codebook.
+ *
+ * These can be stored (or given to other codecs) to share the codebook.
+ *
+ * @param hc Huffman codec.
+ * @param n_bits Code length of each symbol (written).
+ * @return true on success, or false if there's no shared codebook.
+ */
+bool cl_hcodec_get_codebook(struct cl_hcodec *hc,
+	unsigned char n_bits[MAX_SYMBOLS])
+{
+	if(!hc->has_shared)
+		return false;
+	memcpy(n_bits, hc->shared, MAX_SYMBOLS);
+	return true;
+}
+
+/** Set the shared codebook from code lengths.
+ *
+ * @param hc Huffman codec.
+ * @param n_bits Code length of each symbol (from cl_hcodec_get_codebook).
+ * @return true on success, or false if the code lengths are invalid.
+ */
+bool cl_hcodec_set_codebook(struct cl_hcodec *hc,
+	const unsigned char n_bits[MAX_SYMBOLS])
+{
+	const unsigned int max_bits = CL_HCODEC_TABLE_BITS + CL_HCODEC_SUB_BITS;
+	unsigned int i;
+
+	hc->in_use = false;
+	for(i = 0; i < MAX_SYMBOLS; i++) {
+		if(n_bits[i] > max_bits)
+			return false;
+		hc->symbols[i].n_bits = n_bits[i];
+	}
+	if(!cl_hcodec_check_codebook(hc))
+		return false;
+	memcpy(hc->shared, n_bits, MAX_SYMBOLS);
+	hc->has_shared = true;
+	cl_hcodec_use_shared(hc);
+	return true;
+}
+
+/** Encode a block of data with the shared codebook.
+ *
+ * The codebook is not stored in the block.
+ *
+ * @return Number of bytes encoded, or -1 if there's no shared codebook, a
+ *         symbol has no code, or the output buffer is too small.
+ */
+int cl_hcodec_encode_shared(struct cl_hcodec *hc, const unsigned char *in,
+	unsigned int n_in, unsigned char *out, unsigned int n_out)
+{
+	const unsigned char *buf;
+	uint64_t n_bits = 0;
+
+	if(!hc->has_shared)
+		return -1;
+	cl_hcodec_use_shared(hc);
+	for(buf = in; buf < in + n_in; buf++) {
+		unsigned int b = hc->symbols[*buf].n_bits;
+		if(b == 0)
+			return -1;
+		n_bits += b;
+	}
+	if(n_bits > (uint64_t)n_out * 8)
+		return -1;
+	cl_bitarray_wrap(hc->bits, out, n_out * 8);
+	cl_bitarray_clear(hc->bits);
+	cl_hcodec_encode_buffer(hc, in, n_in);
+	return cl_bitarray_bytes(hc->bits);
+}
+
+/** Decode a block of data with the shared codebook.
+ *
+ * Since the last byte may be padded, n_out must be the number of bytes
+ * which were encoded.
+ *
+ * @return Number of bytes decoded, or -1 if there's no shared codebook.
+ */
+int cl_hcodec_decode_shared(struct cl_hcodec *hc, unsigned char *in,
+	unsigned int n_in, unsigned char *out, unsigned int n_out)
+{
+	if(!hc->has_shared)
+		return -1;
+	cl_hcodec_use_shared(hc);
+	cl_bitarray_wrap(hc->bits, in, n_in * 8);
+	return cl_hcodec_decode_table(hc, out, n_out);
 }
@@ -0,0 +1,393 @@
+/*
+ * heap.c	A d-ary heap priority queue
+ *
+ * Copyright (c) 2016  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_heap_create		Create a heap
+ *	cl_heap_create_indexed	Create an indexed heap
+ *	cl_heap_create_ex	Create a heap with an arity
+ *	cl_heap_destroy		Destroy a heap
+ *	cl_heap_is_empty	Check if a heap is empty
+ *	cl_heap_count		Count the items in a heap
+ *	cl_heap_peek		Get the lowest item in a heap
+ *	cl_heap_push		Push an item onto a heap
+ *	cl_heap_pop		Pop the lowest item from a heap
+ *	cl_heap_get		Get the item of a handle
+ *	cl_heap_decrease_key	Replace an item with a lower one
+ *	cl_heap_remove		Remove the item of a handle
+ *	cl_heap_clear		Clear all items from a heap
+ *	cl_heap_reserve		Reserve room for items in a heap
+ *	cl_heap_stats		Add up memory statistics of a heap
+ */
+/** \file
+ *
+ * A heap is a priority queue of items (pointers), ordered by a comparison
+ * function, where the lowest item is at the top.  Pushing and popping are
+ * O(log n), and peeking is O(1).
+ *
+ * The items are kept in one contiguous array, as an implicit d-ary tree:
+ * the children of position i are at i * d + 1 through i * d + d.  With the
+ * default arity of 4, the tree is half as deep as a binary heap, and the
+ * children of a node share one cache line.
+ *
+ * An indexed heap also gives a handle for each pushed item, which stays the
+ * same while the item moves within the heap.  With a handle, an item can be
+ * removed (cancelled) or replaced with a lower one (decrease-key) in
+ * O(log n).  A handle is reused after its item is popped or removed.
+ */
+#include <assert.h>
+#include <stdint.h>
+#include "clump.h"
+
+/** Default heap arity */
+#define CL_HEAP_ARITY	(4)
+
+/** Heap structure.
+ */
+struct cl_heap {
+	cl_compare_cb		*fn_compare;	/**< comparison function */
+	const void		**items;	/**< item at each position */
+	uint32_t		*handles;	/**< handle at each position
+						     (indexed only) */
+	uint32_t		*slots;		/**< position of each handle, or
+						     next free handle */
+	uint32_t		n_size;		/**< size of arrays */
+	uint32_t		n_items;	/**< number of items */
+	uint32_t		n_handles;	/**< handles given out */
+	uint32_t		free_handle;	/**< head of free handle list */
+	uint32_t		arity;		/**< children of each node */
+	const struct cl_alloc	*al;		/**< allocator of heap */
+};
+
+/** Create a heap with an arity.
+ *
+ * @param fn_compare Function to compare two items for ordering.
+ * @param arity Number of children of each node (2 or more).
+ * @param indexed If true, keep handles for cl_heap_decrease_key and
+ *                cl_heap_remove.
+ * @return The new heap.
+ */
+struct cl_heap *cl_heap_create_ex(cl_compare_cb *fn_compare, uint32_t arity,
+	bool indexed)
+{
+	const struct cl_alloc *al = &cl_alloc_default;
+	struct cl_heap *heap = cl_alloc_malloc(al, sizeof(struct cl_heap));
+	assert(heap && fn_compare && arity >= 2);
+	heap->fn_compare = fn_compare;
+	heap->n_size = 16;
+	heap->n_items = 0;
+	heap->n_handles = 0;
+	heap->free_handle = CL_HEAP_NONE;
+	heap->arity = arity;
+	heap->al = al;
+	heap->items = cl_alloc_malloc(al, heap->n_size * sizeof(void *));
+	if(indexed) {
+		heap->handles = cl_alloc_malloc(al, heap->n_size *
+			sizeof(uint32_t));
+		heap->slots = cl_alloc_malloc(al, heap->n_size *
+			sizeof(uint32_t));
+	} else {
+		heap->handles = NULL;
+		heap->slots = NULL;
+	}
+	return heap;
+}
+
+/** Create a heap.
+ *
+ * @param fn_compare Function to compare two items for ordering.
+ * @return The new heap.
+ */
+struct cl_heap *cl_heap_create(cl_compare_cb *fn_compare) {
+	return cl_heap_create_ex(fn_compare, CL_HEAP_ARITY, false);
+}
+
+/** Create an indexed heap.
+ *
+ * An indexed heap returns a handle from cl_heap_push, which can be used to
+ * remove the item or decrease its key.  It uses 8 more bytes per item.
+ *
+ * @param fn_compare Function to compare two items for ordering.
+ * @return The new heap.
+ */
+struct cl_heap *cl_heap_create_indexed(cl_compare_cb *fn_compare) {
+	return cl_heap_create_ex(fn_compare, CL_HEAP_ARITY, true);
+}
+
+/** Destroy a heap.
+ *
+ * @param heap The heap.
+ */
+void cl_heap_destroy(struct cl_heap *heap) {
+	assert(heap);
+	cl_alloc_free(heap->al, heap->items, heap->n_size * sizeof(void *));
+	if(heap->slots) {
+		cl_alloc_free(heap->al, heap->handles, heap->n_size *
+			sizeof(uint32_t));
+		cl_alloc_free(heap->al, heap->slots, heap->n_size *
+			sizeof(uint32_t));
+	}
+#ifndef NDEBUG
+	heap->items = NULL;
+	heap->handles = NULL;
+	heap->slots = NULL;
+#endif
+	cl_alloc_free(heap->al, heap, sizeof(struct cl_heap));
+}
+
+/** Test if a heap is empty.
+ *
+ * @param heap The heap.
+ * @return True if heap has no items, otherwise false.
+ */
+bool cl_heap_is_empty(const struct cl_heap *heap) {
+	return heap->n_items == 0;
+}
+
+/** Count the items in a heap.
+ *
+ * @param heap The heap.
+ * @return Count of items in the heap.
+ */
+uint32_t cl_heap_count(const struct cl_heap *heap) {
+	return heap->n_items;
+}
+
+/** Get (peek) the lowest item in a heap.
+ *
+ * @param heap The heap.
+ * @return Lowest item, or NULL if heap is empty.
+ */
+const void *cl_heap_peek(const struct cl_heap *heap) {
+	return heap->n_items ? heap->items[0] : NULL;
+}
+
+/** Resize the arrays of a heap.
+ *
+ * @param heap The heap.
+ * @param n New size of arrays (not less than number of handles).
+ */
+static void cl_heap_resize(struct cl_heap *heap, uint32_t n) {
+	const struct cl_alloc *al = heap->al;
+	assert(n >= heap->n_items && n >= heap->n_handles);
+	heap->items = cl_alloc_realloc(al, heap->items, heap->n_size *
+		sizeof(void *), n * sizeof(void *));
+	if(heap->slots) {
+		heap->handles = cl_alloc_realloc(al, heap->handles,
+			heap->n_size * sizeof(uint32_t), n * sizeof(uint32_t));
+		heap->slots = cl_alloc_realloc(al, heap->slots,
+			heap->n_size * sizeof(uint32_t), n * sizeof(uint32_t));
+	}
+	heap->n_size = n;
+}
+
+/** Put an item at a position in a heap.
+ */
+static inline void cl_heap_place(struct cl_heap *heap, uint32_t i,
+	const void *item, uint32_t h)
+{
+	heap->items[i] = item;
+	if(heap->slots) {
+		heap->handles[i] = h;
+		heap->slots[h] = i;
+	}
+}
+
+/** Get the handle at a position in a heap (or CL_HEAP_NONE) */
+static inline uint32_t cl_heap_handle(const struct cl_heap *heap, uint32_t i) {
+	return heap->slots ? heap->handles[i] : CL_HEAP_NONE;
+}
+
+/** Sift an item up a heap, from a position toward the top.
+ *
+ * @param heap The heap.
+ * @param i Starting position of item.
+ * @param item Item to place.
+ * @param h Handle of item (indexed heaps only).
+ * @return Final position of item.
+ */
+static uint32_t cl_heap_sift_up(struct cl_heap *heap, uint32_t i,
+	const void *item, uint32_t h)
+{
+	while(i > 0) {
+		uint32_t p = (i - 1) / heap->arity;
+		if(heap->fn_compare(item, heap->items[p]) != CL_LESS)
+			break;
+		cl_heap_place(heap, i, heap->items[p], cl_heap_handle(heap, p));
+		i = p;
+	}
+	cl_heap_place(heap, i, item, h);
+	return i;
+}
+
+/** Sift an item down a heap, from a position toward the bottom.
+ *
+ * @param heap The heap.
+ * @param i Starting position of item.
+ * @param item Item to place.
+ * @param h Handle of item (indexed heaps only).
+ */
+static void cl_heap_sift_down(struct cl_heap *heap, uint32_t i,
+	const void *item, uint32_t h)
+{
+	for(;;) {
+		uint32_t c = i * heap->arity + 1;
+		uint32_t e = c + heap->arity;
+		uint32_t m = c;
+		if(c >= heap->n_items)
+			break;
+		if(e > heap->n_items)
+			e = heap->n_items;
+		/* find the lowest child */
+		for(c++; c < e; c++) {
+			if(heap->fn_compare(heap->items[c], heap->items[m]) ==
+			   CL_LESS)
+				m = c;
+		}
+		if(heap->fn_compare(heap->items[m], item) != CL_LESS)
+			break;
+		cl_heap_place(heap, i, heap->items[m], cl_heap_handle(heap, m));
+		i = m;
+	}
+	cl_heap_place(heap, i, item, h);
+}
+
+/** Push an item onto a heap.
+ *
+ * @param heap The heap.
+ * @param item Item to push.
+ * @return Handle of item (indexed heaps), or CL_HEAP_NONE.
+ */
+uint32_t cl_heap_push(struct cl_heap *heap, const void *item) {
+	uint32_t h = CL_HEAP_NONE;
+	if(heap->n_items >= heap->n_size)
+		cl_heap_resize(heap, heap->n_size * 2);
+	if(heap->slots) {
+		if(heap->free_handle != CL_HEAP_NONE) {
+			h = heap->free_handle;
+			heap->free_handle = heap->slots[h];
+		} else
+			h = heap->n_handles++;
+	}
+	cl_heap_sift_up(heap, heap->n_items++, item, h);
+	return h;
+}
+
+/** Remove the item at a position in a heap.
+ *
+ * The last item fills the hole, and is sifted up or down into place.
+ */
+static const void *cl_heap_remove_at(struct cl_heap *heap, uint32_t i) {
+	const void *item = heap->items[i];
+	uint32_t n = --heap->n_items;
+	if(heap->slots) {
+		uint32_t h = heap->handles[i];
+		heap->slots[h] = heap->free_handle;
+		heap->free_handle = h;
+	}
+	if(i < n) {
+		const void *last = heap->items[n];
+		uint32_t h = cl_heap_handle(heap, n);
+		if(cl_heap_sift_up(heap, i, last, h) == i)
+			cl_heap_sift_down(heap, i, last, h);
+	}
+	return item;
+}
+
+/** Pop the lowest item from a heap.
+ *
+ * @param heap The heap.
+ * @return Lowest item, or NULL if heap is empty.
+ */
+const void *cl_heap_pop(struct cl_heap *heap) {
+	return heap->n_items ? cl_heap_remove_at(heap, 0) : NULL;
+}
+
+/** Get the position of a handle (indexed heaps only).
+ */
+static uint32_t cl_heap_slot(const struct cl_heap *heap, uint32_t h) {
+	uint32_t i;
+	assert(heap->slots && h < heap->n_handles);
+	i = heap->slots[h];
+	assert(i < heap->n_items && heap->handles[i] == h);
+	return i;
+}
+
+/** Get the item of a handle (indexed heaps only).
+ *
+ * @param heap The heap (indexed).
+ * @param h Handle from cl_heap_push, of an item still in the heap.
+ * @return Item of handle.
+ */
+const void *cl_heap_get(const struct cl_heap *heap, uint32_t h) {
+	return heap->items[cl_heap_slot(heap, h)];
+}
+
+/** Replace an item with a lower one (indexed heaps only).
+ *
+ * The handle stays the same.  Replacing an item with itself after lowering
+ * its key in place also works.
+ *
+ * @param heap The heap (indexed).
+ * @param h Handle from cl_heap_push, of an item still in the heap.
+ * @param item New item, not greater than the item of handle.
+ */
+void cl_heap_decrease_key(struct cl_heap *heap, uint32_t h, const void *item) {
+	uint32_t i = cl_heap_slot(heap, h);
+	assert(heap->fn_compare(item, heap->items[i]) != CL_GREATER);
+	cl_heap_sift_up(heap, i, item, h);
+}
+
+/** Remove the item of a handle (indexed heaps only).
+ *
+ * @param heap The heap (indexed).
+ * @param h Handle from cl_heap_push, of an item still in the heap.
+ * @return Removed item.
+ */
+const void *cl_heap_remove(struct cl_heap *heap, uint32_t h) {
+	return cl_heap_remove_at(heap, cl_heap_slot(heap, h));
+}
+
+/** Clear a heap.
+ *
+ * Remove all items from a heap.  All handles are freed.
+ *
+ * @param heap The heap.
+ */
+void cl_heap_clear(struct cl_heap *heap) {
+	heap->n_items = 0;
+	heap->n_handles = 0;
+	heap->free_handle = CL_HEAP_NONE;
+}
+
+/** Reserve room for items in a heap.
+ *
+ * @param heap The heap.
+ * @param n Number of items to reserve room for.
+ */
+void cl_heap_reserve(struct cl_heap *heap, uint32_t n) {
+	if(n > heap->n_size)
+		cl_heap_resize(heap, n);
+}
+
+/** Add up memory statistics of a heap.
+ *
+ * The item array counts as a block, with items as live objects.
+ *
+ * @param heap The heap.
+ * @param stats Statistics to add to (see cl_pool_stats).
+ */
+void cl_heap_stats(const struct cl_heap *heap, struct cl_pool_stats *stats) {
+	size_t n_bytes = sizeof(void *);
+	if(heap->slots)
+		n_bytes += 2 * sizeof(uint32_t);
+	stats->n_blocks++;
+	stats->n_live += heap->n_items;
+	stats->n_high += heap->n_items;
+	stats->n_free += heap->n_size - heap->n_items;
+	stats->n_bytes += sizeof(struct cl_heap) + (size_t)heap->n_size *
+		n_bytes;
+	stats->n_used += (size_t)heap->n_items * n_bytes;
+}
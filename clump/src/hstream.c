@@ -0,0 +1,294 @@
+/*
+ * hstream.c	Huffman compressed SDL_RWops streams
+ *
+ * Copyright (c) 2011-2012  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_hstream_writer		Create a compressing RWops
+ *	cl_hstream_reader		Create a decompressing RWops
+ */
+/** \file
+ *
+ * A compressed stream wraps another SDL_RWops, so data can be written or
+ * read through it without holding the whole file in memory.  Data is
+ * buffered into CL_HCODEC_BLOCK_SIZE blocks, which are encoded one at a
+ * time by cl_hcodec_encode.  Each block is written as:
+ *
+ *	uint16	decoded size (1 to CL_HCODEC_BLOCK_SIZE bytes)
+ *	uint16	encoded size (high bit set for a raw block)
+ *	...	block data
+ *
+ * Integers are little-endian, and the stream ends at the end of the
+ * wrapped stream.  A stream is either written or read, and can't seek
+ * (though SDL_RWtell works).  Closing a writer flushes the last block.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SDL_rwops.h"
+#include "clump.h"
+
+/** Encoded size flag for a raw block */
+#define CL_HSTREAM_RAW		(0x8000)
+
+/** Compressed stream structure.
+ */
+struct cl_hstream {
+	SDL_RWops		*rw;		/* wrapped stream */
+	struct cl_hcodec	*hc;		/* huffman codec */
+	bool			autoclose;	/* close wrapped stream */
+	bool			failed;		/* read or write error */
+	unsigned int		n_block;	/* bytes in block */
+	unsigned int		pos;		/* read position in block */
+	Sint64			offset;		/* stream offset of block */
+	unsigned char		block[CL_HCODEC_BLOCK_SIZE];
+							/* decoded block */
+	unsigned char		packed[CL_HCODEC_BLOCK_SIZE];
+							/* encoded block */
+};
+
+/** Get the stream of an RWops.
+ */
+static struct cl_hstream *cl_hstream_get(SDL_RWops *context) {
+	return context->hidden.unknown.data1;
+}
+
+/** Get the size of a stream (unknown).
+ */
+static Sint64 SDLCALL cl_hstream_size(SDL_RWops *context) {
+	return -1;
+}
+
+/** Seek in a stream (only to tell the current offset).
+ */
+static Sint64 SDLCALL cl_hstream_seek(SDL_RWops *context, Sint64 offset,
+	int whence)
+{
+	struct cl_hstream *hs = cl_hstream_get(context);
+	if(offset != 0 || whence != RW_SEEK_CUR)
+		return SDL_SetError("Can't seek in a compressed stream");
+	return hs->offset + hs->pos;
+}
+
+/** Write the block of a stream.
+ */
+static void cl_hstream_flush(struct cl_hstream *hs) {
+	unsigned char head[4];
+	unsigned char *data = hs->packed;
+	unsigned int n = hs->n_block;
+	int n_enc;
+
+	if(n == 0 || hs->failed)
+		return;
+	n_enc = cl_hcodec_encode(hs->hc, hs->block, n, hs->packed, n);
+	/* An encoding filling the buffer may have been cut short */
+	if(n_enc <= 0 || (unsigned int)n_enc >= n) {
+		data = hs->block;
+		n_enc = n | CL_HSTREAM_RAW;
+	}
+	head[0] = n;
+	head[1] = n >> 8;
+	head[2] = n_enc;
+	head[3] = n_enc >> 8;
+	n_enc &= ~CL_HSTREAM_RAW;
+	if(SDL_RWwrite(hs->rw, head, 1, 4) != 4 ||
+		SDL_RWwrite(hs->rw, data, 1, n_enc) != (size_t)n_enc)
+	{
+		hs->failed = true;
+	}
+	hs->offset += n;
+	hs->n_block = 0;
+	hs->pos = 0;
+}
+
+/** Write to a stream.
+ */
+static size_t SDLCALL cl_hstream_write(SDL_RWops *context, const void *ptr,
+	size_t size, size_t num)
+{
+	struct cl_hstream *hs = cl_hstream_get(context);
+	const unsigned char *buf = ptr;
+	size_t n_bytes = size * num;
+
+	while(n_bytes && !hs->failed) {
+		size_t n = CL_HCODEC_BLOCK_SIZE - hs->n_block;
+		if(n > n_bytes)
+			n = n_bytes;
+		memcpy(hs->block + hs->n_block, buf, n);
+		hs->n_block += n;
+		hs->pos = hs->n_block;
+		buf += n;
+		n_bytes -= n;
+		if(hs->n_block == CL_HCODEC_BLOCK_SIZE)
+			cl_hstream_flush(hs);
+	}
+	if(hs->failed) {
+		SDL_SetError("Error writing compressed stream");
+		return 0;
+	}
+	return num;
+}
+
+/** Read the next block of a stream.
+ *
+ * @return true if a block was read, false at the end or on error.
+ */
+static bool cl_hstream_fill(struct cl_hstream *hs) {
+	unsigned char head[4];
+	unsigned int n, n_enc;
+	size_t n_read;
+
+	hs->offset += hs->n_block;
+	hs->n_block = 0;
+	hs->pos = 0;
+	n_read = SDL_RWread(hs->rw, head, 1, 4);
+	if(n_read == 0)
+		return false;
+	n = head[0] | (head[1] << 8);
+	n_enc = head[2] | (head[3] << 8);
+	if(n_read != 4 || n == 0 || n > CL_HCODEC_BLOCK_SIZE)
+		goto fail;
+	if(n_enc & CL_HSTREAM_RAW) {
+		if((n_enc & ~CL_HSTREAM_RAW) != n ||
+			SDL_RWread(hs->rw, hs->block, 1, n) != n)
+			goto fail;
+	} else {
+		if(n_enc > CL_HCODEC_BLOCK_SIZE ||
+			SDL_RWread(hs->rw, hs->packed, 1, n_enc) != n_enc ||
+			cl_hcodec_decode(hs->hc, hs->packed, n_enc, hs->block,
+			n) != (int)n)
+			goto fail;
+	}
+	hs->n_block = n;
+	return true;
+fail:
+	hs->failed = true;
+	SDL_SetError("Corrupt compressed stream");
+	return false;
+}
+
+/** Read from a stream.
+ */
+static size_t SDLCALL cl_hstream_read(SDL_RWops *context, void *ptr,
+	size_t size, size_t maxnum)
+{
+	struct cl_hstream *hs = cl_hstream_get(context);
+	unsigned char *buf = ptr;
+	size_t n_bytes = size * maxnum;
+	size_t n_done = 0;
+
+	if(size == 0)
+		return 0;
+	while(n_done < n_bytes && !hs->failed) {
+		size_t n = hs->n_block - hs->pos;
+		if(n == 0) {
+			if(!cl_hstream_fill(hs))
+				break;
+			continue;
+		}
+		if(n > n_bytes - n_done)
+			n = n_bytes - n_done;
+		memcpy(buf + n_done, hs->block + hs->pos, n);
+		hs->pos += n;
+		n_done += n;
+	}
+	return n_done / size;
+}
+
+/** Refuse to read from a writer.
+ */
+static size_t SDLCALL cl_hstream_no_read(SDL_RWops *context, void *ptr,
+	size_t size, size_t maxnum)
+{
+	SDL_SetError("Can't read from a compressed writer");
+	return 0;
+}
+
+/** Refuse to write to a reader.
+ */
+static size_t SDLCALL cl_hstream_no_write(SDL_RWops *context,
+	const void *ptr, size_t size, size_t num)
+{
+	SDL_SetError("Can't write to a compressed reader");
+	return 0;
+}
+
+/** Close a stream.
+ */
+static int SDLCALL cl_hstream_close(SDL_RWops *context) {
+	struct cl_hstream *hs = cl_hstream_get(context);
+	int status;
+
+	if(context->write == cl_hstream_write)
+		cl_hstream_flush(hs);
+	status = hs->failed ? -1 : 0;
+	if(hs->autoclose && SDL_RWclose(hs->rw) < 0)
+		status = -1;
+	cl_hcodec_destroy(hs->hc);
+	free(hs);
+	SDL_FreeRW(context);
+	return status;
+}
+
+/** Create a compressed stream.
+ */
+static SDL_RWops *cl_hstream_create(SDL_RWops *rw, bool autoclose) {
+	SDL_RWops *context;
+	struct cl_hstream *hs;
+
+	if(rw == NULL)
+		return NULL;
+	context = SDL_AllocRW();
+	if(context == NULL)
+		return NULL;
+	hs = malloc(sizeof(struct cl_hstream));
+	assert(hs);
+	hs->rw = rw;
+	hs->hc = cl_hcodec_create();
+	hs->autoclose = autoclose;
+	hs->failed = false;
+	hs->n_block = 0;
+	hs->pos = 0;
+	hs->offset = 0;
+	context->size = cl_hstream_size;
+	context->seek = cl_hstream_seek;
+	context->close = cl_hstream_close;
+	context->type = SDL_RWOPS_UNKNOWN;
+	context->hidden.unknown.data1 = hs;
+	return context;
+}
+
+/** Create a compressing RWops.
+ *
+ * Data written to it is compressed and written to another stream.
+ *
+ * @param rw Stream to write compressed data to.
+ * @param autoclose Close rw when the new stream is closed.
+ * @return New stream, or NULL on error.
+ */
+struct SDL_RWops *cl_hstream_writer(struct SDL_RWops *rw, bool autoclose) {
+	SDL_RWops *context = cl_hstream_create(rw, autoclose);
+	if(context) {
+		context->read = cl_hstream_no_read;
+		context->write = cl_hstream_write;
+	}
+	return context;
+}
+
+/** Create a decompressing RWops.
+ *
+ * Data read from it is read from another stream and decompressed.
+ *
+ * @param rw Stream to read compressed data from.
+ * @param autoclose Close rw when the new stream is closed.
+ * @return New stream, or NULL on error.
+ */
+struct SDL_RWops *cl_hstream_reader(struct SDL_RWops *rw, bool autoclose) {
+	SDL_RWops *context = cl_hstream_create(rw, autoclose);
+	if(context) {
+		context->read = cl_hstream_read;
+		context->write = cl_hstream_no_write;
+	}
+	return context;
+}
@@ -0,0 +1,369 @@
+/*
+ * ihash.c	An intrusive hash-set
+ *
+ * Copyright (c) 2016  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_ihash_init		Initialize an intrusive hash
+ *	cl_ihash_fini		Free the buckets of an intrusive hash
+ *	cl_ihash_count		Count the items in a hash
+ *	cl_ihash_get		Get the item matching a key
+ *	cl_ihash_add		Add an item to a hash
+ *	cl_ihash_remove_key	Remove the item matching a key
+ *	cl_ihash_remove		Remove an item from a hash
+ *	cl_ihash_clear		Clear all items from a hash
+ *	cl_ihash_iterator_init	Initialize a hash iterator
+ *	cl_ihash_iterator_next	Get the next item from an iterator
+ */
+/** \file
+ *
+ * An intrusive hash is a set of items, chained through a struct
+ * cl_ihash_link embedded in each item (with its hash code) instead of an
+ * entry copied into the table.  Adding an item never allocates, except to
+ * grow the bucket array, and removing one, given the item, is O(1): each link
+ * points back at the pointer to it.
+ *
+ * The hash and compare functions are called with items; keys are items too
+ * (a lookup can use one on the stack with just the key fields set).  The
+ * compare function is only called when hash codes match.  Items must stay put
+ * while they're in a hash.
+ *
+ * Resizing is iterative, as in hash.c: a new bucket array (twice the size)
+ * replaces the current one, which is kept as the old array until each of its
+ * chains is moved.  Each add moves CL_IHASH_MIGRATE chains, from bucket 0 up.
+ * Lookups check both arrays (the old one only for buckets not moved yet), and
+ * new items only go in the new array.  Removing never moves chains, so the
+ * item just returned by an iterator can be removed.
+ */
+#include <assert.h>
+#include <stddef.h>
+#include "clump.h"
+
+/** Minimum bucket array size */
+static const uint32_t CL_IHASH_MIN_SIZE = 1 << 6;
+
+/** Maximum bucket array size */
+static const uint32_t CL_IHASH_MAX_SIZE = 1U << 31;
+
+/** Old chains moved per add */
+static const uint32_t CL_IHASH_MIGRATE = 16;
+
+/** Get the link of an item */
+static inline struct cl_ihash_link *cl_ihash_link(const struct cl_ihash *hash,
+	const void *item)
+{
+	return (struct cl_ihash_link *)((char *)item + hash->offset);
+}
+
+/** Get the item of a link */
+static inline void *cl_ihash_item(const struct cl_ihash *hash,
+	const struct cl_ihash_link *link)
+{
+	return (char *)link - hash->offset;
+}
+
+/** Check if a hash is resizing (has chains in the old array) */
+static bool cl_ihash_migrating(const struct cl_ihash *hash) {
+	return hash->h_old.buckets != NULL;
+}
+
+/** Allocate a bucket array.
+ *
+ * @param tbl Pointer to bucket array.
+ * @param n_size Number of buckets (a power of 2).
+ */
+static void cl_ihash_table_alloc(struct cl_ihash_table *tbl, uint32_t n_size) {
+	tbl->n_size = n_size;
+	tbl->buckets = cl_alloc_calloc(&cl_alloc_default, (size_t)n_size *
+		sizeof(struct cl_ihash_link *));
+}
+
+/** Free a bucket array.
+ *
+ * @param tbl Pointer to bucket array.
+ */
+static void cl_ihash_table_free(struct cl_ihash_table *tbl) {
+	if(tbl->buckets) {
+		cl_alloc_free(&cl_alloc_default, tbl->buckets,
+			(size_t)tbl->n_size * sizeof(struct cl_ihash_link *));
+	}
+	tbl->buckets = NULL;
+	tbl->n_size = 0;
+}
+
+/** Get the bucket of a hash code */
+static inline struct cl_ihash_link **cl_ihash_bucket(
+	const struct cl_ihash_table *tbl, uint32_t hcode)
+{
+	return &tbl->buckets[hcode & (tbl->n_size - 1)];
+}
+
+/** Push a link onto a chain */
+static void cl_ihash_push(struct cl_ihash_link **bucket,
+	struct cl_ihash_link *link)
+{
+	link->next = *bucket;
+	link->pprev = bucket;
+	if(link->next)
+		link->next->pprev = &link->next;
+	*bucket = link;
+}
+
+/** Unlink a link from its chain */
+static void cl_ihash_unlink(struct cl_ihash_link *link) {
+	*link->pprev = link->next;
+	if(link->next)
+		link->next->pprev = link->pprev;
+#ifndef NDEBUG
+	link->next = NULL;
+	link->pprev = NULL;
+#endif
+}
+
+/** Initialize an intrusive hash.
+ *
+ * The hash can be anywhere (on the stack, in another struct), but its
+ * buckets must be freed with cl_ihash_fini.
+ *
+ * @param hash Pointer to the hash.
+ * @param offset Offset of the struct cl_ihash_link in the items.
+ * @param fn_hash Function to calculate the hash code of an item.
+ * @param fn_compare Function to compare a key with an item for equality.
+ */
+void cl_ihash_init(struct cl_ihash *hash, size_t offset, cl_hash_cb *fn_hash,
+	cl_compare_cb *fn_compare)
+{
+	hash->fn_hash = fn_hash;
+	hash->fn_compare = fn_compare;
+	hash->offset = offset;
+	hash->n_entries = 0;
+	hash->n_migrate = 0;
+	hash->h_old.buckets = NULL;
+	hash->h_old.n_size = 0;
+	cl_ihash_table_alloc(&hash->h_new, CL_IHASH_MIN_SIZE);
+}
+
+/** Free the buckets of an intrusive hash.
+ *
+ * The items are only unlinked, it's up to the caller to free them.
+ *
+ * @param hash Pointer to the hash.
+ */
+void cl_ihash_fini(struct cl_ihash *hash) {
+	cl_ihash_table_free(&hash->h_new);
+	cl_ihash_table_free(&hash->h_old);
+	hash->n_entries = 0;
+}
+
+/** Get the count of items in a hash.
+ *
+ * @param hash Pointer to the hash.
+ * @return Count of items in the hash.
+ */
+uint32_t cl_ihash_count(const struct cl_ihash *hash) {
+	return hash->n_entries;
+}
+
+/** Find the link matching a key in one chain */
+static struct cl_ihash_link *cl_ihash_chain_lookup(
+	const struct cl_ihash *hash, struct cl_ihash_link *link,
+	const void *key, uint32_t hcode)
+{
+	for(; link; link = link->next) {
+		if(link->hcode == hcode && hash->fn_compare(key,
+		   cl_ihash_item(hash, link)) == CL_EQUAL)
+			return link;
+	}
+	return NULL;
+}
+
+/** Find the link matching a key.
+ *
+ * @param hash Pointer to the hash.
+ * @param key Key to find.
+ * @param hcode Hash code of key.
+ * @return Matching link, or NULL if not found.
+ */
+static struct cl_ihash_link *cl_ihash_lookup(const struct cl_ihash *hash,
+	const void *key, uint32_t hcode)
+{
+	struct cl_ihash_link *link = cl_ihash_chain_lookup(hash,
+		*cl_ihash_bucket(&hash->h_new, hcode), key, hcode);
+	/* Old chains before the scan are empty */
+	if(link == NULL && cl_ihash_migrating(hash) &&
+	   (hcode & (hash->h_old.n_size - 1)) >= hash->n_migrate)
+	{
+		link = cl_ihash_chain_lookup(hash,
+			*cl_ihash_bucket(&hash->h_old, hcode), key, hcode);
+	}
+	return link;
+}
+
+/** Get the item matching a key.
+ *
+ * @param hash Pointer to the hash.
+ * @param key Key to find.
+ * @return Matching item, or NULL if not found.
+ */
+void *cl_ihash_get(const struct cl_ihash *hash, const void *key) {
+	struct cl_ihash_link *link = cl_ihash_lookup(hash, key,
+		hash->fn_hash(key));
+	return link ? cl_ihash_item(hash, link) : NULL;
+}
+
+/** Move chains from the old bucket array to the new one.
+ *
+ * @param hash Pointer to the hash.
+ */
+static void cl_ihash_migrate(struct cl_ihash *hash) {
+	struct cl_ihash_table *old = &hash->h_old;
+	for(uint32_t i = 0; i < CL_IHASH_MIGRATE && cl_ihash_migrating(hash);
+	    i++)
+	{
+		struct cl_ihash_link *link = old->buckets[hash->n_migrate];
+		while(link) {
+			struct cl_ihash_link *next = link->next;
+			cl_ihash_push(cl_ihash_bucket(&hash->h_new,
+				link->hcode), link);
+			link = next;
+		}
+		old->buckets[hash->n_migrate] = NULL;
+		if(++hash->n_migrate == old->n_size) {
+			cl_ihash_table_free(old);
+			hash->n_migrate = 0;
+		}
+	}
+}
+
+/** Start resizing to twice the size.
+ *
+ * @param hash Pointer to the hash.
+ */
+static void cl_ihash_expand(struct cl_ihash *hash) {
+	uint32_t n_size = hash->h_new.n_size;
+	assert(!cl_ihash_migrating(hash));
+	if(n_size < CL_IHASH_MAX_SIZE) {
+		hash->h_old = hash->h_new;
+		hash->n_migrate = 0;
+		cl_ihash_table_alloc(&hash->h_new, n_size * 2);
+	}
+}
+
+/** Add an item to a hash.
+ *
+ * An item matching it is replaced (it takes that item's place).
+ *
+ * @param hash Pointer to the hash.
+ * @param item Item to add (not in the hash already).
+ * @return Matching replaced item if it existed, or NULL otherwise.
+ */
+void *cl_ihash_add(struct cl_ihash *hash, void *item) {
+	struct cl_ihash_link *link = cl_ihash_link(hash, item);
+	struct cl_ihash_link *m;
+
+	link->hcode = hash->fn_hash(item);
+	m = cl_ihash_lookup(hash, item, link->hcode);
+	if(m) {
+		link->next = m->next;
+		link->pprev = m->pprev;
+		*link->pprev = link;
+		if(link->next)
+			link->next->pprev = &link->next;
+		return cl_ihash_item(hash, m);
+	}
+	if(!cl_ihash_migrating(hash) && hash->n_entries >= hash->h_new.n_size)
+		cl_ihash_expand(hash);
+	cl_ihash_push(cl_ihash_bucket(&hash->h_new, link->hcode), link);
+	hash->n_entries++;
+	cl_ihash_migrate(hash);
+	return NULL;
+}
+
+/** Remove an item from a hash, in O(1).
+ *
+ * @param hash Pointer to the hash.
+ * @param item Item to remove (in the hash).
+ */
+void cl_ihash_remove(struct cl_ihash *hash, void *item) {
+	assert(hash->n_entries > 0);
+	cl_ihash_unlink(cl_ihash_link(hash, item));
+	hash->n_entries--;
+}
+
+/** Remove the item matching a key.
+ *
+ * @param hash Pointer to the hash.
+ * @param key Key to remove.
+ * @return Removed item if it existed, or NULL otherwise.
+ */
+void *cl_ihash_remove_key(struct cl_ihash *hash, const void *key) {
+	void *item = cl_ihash_get(hash, key);
+	if(item)
+		cl_ihash_remove(hash, item);
+	return item;
+}
+
+/** Clear all items from a hash.
+ *
+ * The items are only unlinked, it's up to the caller to free them.  The
+ * bucket array is kept.
+ *
+ * @param hash Pointer to the hash.
+ */
+void cl_ihash_clear(struct cl_ihash *hash) {
+	cl_ihash_table_free(&hash->h_old);
+	hash->n_migrate = 0;
+	for(uint32_t i = 0; i < hash->h_new.n_size; i++)
+		hash->h_new.buckets[i] = NULL;
+	hash->n_entries = 0;
+}
+
+/** Find the first link of a chain, from a bucket on, for an iterator */
+static void cl_ihash_iterator_scan(struct cl_ihash_iterator *it) {
+	const struct cl_ihash *hash = it->hash;
+	while(it->next == NULL) {
+		const struct cl_ihash_table *tbl = it->old ? &hash->h_old
+			: &hash->h_new;
+		if(it->bucket < tbl->n_size)
+			it->next = tbl->buckets[it->bucket++];
+		else if(!it->old && cl_ihash_migrating(hash)) {
+			it->old = true;
+			it->bucket = hash->n_migrate;
+		} else
+			break;
+	}
+}
+
+/** Initialize a hash iterator.
+ *
+ * Initialize a caller's iterator (which can be on the stack).  It doesn't
+ * need to be destroyed.  The item just returned can be removed, but nothing
+ * can be added while iterating.
+ *
+ * @param it The hash iterator.
+ * @param hash Pointer to the hash.
+ */
+void cl_ihash_iterator_init(struct cl_ihash_iterator *it,
+	const struct cl_ihash *hash)
+{
+	it->hash = hash;
+	it->next = NULL;
+	it->bucket = 0;
+	it->old = false;
+	cl_ihash_iterator_scan(it);
+}
+
+/** Get next item from a hash iterator.
+ *
+ * @param it The iterator.
+ * @return Next item, or NULL if no more items.
+ */
+void *cl_ihash_iterator_next(struct cl_ihash_iterator *it) {
+	struct cl_ihash_link *link = it->next;
+	if(link == NULL)
+		return NULL;
+	it->next = link->next;
+	cl_ihash_iterator_scan(it);
+	return cl_ihash_item(it->hash, link);
+}
@@ -0,0 +1,172 @@
+/*
+ * ilist.c	An intrusive doubly-linked list
+ *
+ * Copyright (c) 2016  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_ilist_init			Initialize an intrusive list
+ *	cl_ilist_is_empty		Check if a list is empty
+ *	cl_ilist_count			Count the items in a list
+ *	cl_ilist_add			Add an item to a list
+ *	cl_ilist_add_tail		Add an item to tail of a list
+ *	cl_ilist_remove			Remove an item from a list
+ *	cl_ilist_pop			Pop an item from a list
+ *	cl_ilist_clear			Clear all items from a list
+ *	cl_ilist_first			Get the first item of a list
+ *	cl_ilist_next			Get the item after another
+ */
+/** \file
+ *
+ * An intrusive list links items through a struct cl_ilist_link embedded in
+ * each item, instead of allocating a node pointing at the item.  Adding an
+ * item never allocates, and removing one, given the item, is O(1).
+ *
+ * The list is given the offset of the link in its items (see CL_ILIST_INIT),
+ * and takes and returns pointers to the items themselves.  An item can only
+ * be in one list per link it has, and must stay put while it's in one.
+ * The list is circular, through the head link in struct cl_ilist, so no end
+ * needs special cases.
+ */
+#include <assert.h>
+#include <stddef.h>
+#include "clump.h"
+
+/** Get the link of an item */
+static inline struct cl_ilist_link *cl_ilist_link(const struct cl_ilist *list,
+	const void *item)
+{
+	return (struct cl_ilist_link *)((char *)item + list->offset);
+}
+
+/** Get the item of a link */
+static inline void *cl_ilist_item(const struct cl_ilist *list,
+	const struct cl_ilist_link *link)
+{
+	return (char *)link - list->offset;
+}
+
+/** Initialize an intrusive list.
+ *
+ * The list can be anywhere (on the stack, in another struct) and doesn't need
+ * to be destroyed.
+ *
+ * @param list Pointer to the list.
+ * @param offset Offset of the struct cl_ilist_link in the items.
+ */
+void cl_ilist_init(struct cl_ilist *list, size_t offset) {
+	list->head.next = &list->head;
+	list->head.prev = &list->head;
+	list->offset = offset;
+	list->n_entries = 0;
+}
+
+/** Test if a list is empty.
+ *
+ * @return true if there are no items in the list; false otherwise.
+ */
+bool cl_ilist_is_empty(const struct cl_ilist *list) {
+	return list->head.next == &list->head;
+}
+
+/** Get the count of items in a list.
+ *
+ * @param list Pointer to the list.
+ * @return Count of items in the list.
+ */
+uint32_t cl_ilist_count(const struct cl_ilist *list) {
+	return list->n_entries;
+}
+
+/** Link an item between two links */
+static void cl_ilist_insert(struct cl_ilist *list, void *item,
+	struct cl_ilist_link *prev, struct cl_ilist_link *next)
+{
+	struct cl_ilist_link *link = cl_ilist_link(list, item);
+	link->prev = prev;
+	link->next = next;
+	prev->next = link;
+	next->prev = link;
+	list->n_entries++;
+}
+
+/** Add an item to the head of a list.
+ *
+ * @param list Pointer to the list.
+ * @param item Item to add (not in the list already).
+ */
+void cl_ilist_add(struct cl_ilist *list, void *item) {
+	cl_ilist_insert(list, item, &list->head, list->head.next);
+}
+
+/** Add an item to the tail of a list.
+ *
+ * @param list Pointer to the list.
+ * @param item Item to add (not in the list already).
+ */
+void cl_ilist_add_tail(struct cl_ilist *list, void *item) {
+	cl_ilist_insert(list, item, list->head.prev, &list->head);
+}
+
+/** Remove an item from a list.
+ *
+ * @param list Pointer to the list.
+ * @param item Item to remove (in the list).
+ */
+void cl_ilist_remove(struct cl_ilist *list, void *item) {
+	struct cl_ilist_link *link = cl_ilist_link(list, item);
+	assert(list->n_entries > 0);
+	link->prev->next = link->next;
+	link->next->prev = link->prev;
+#ifndef NDEBUG
+	link->next = NULL;
+	link->prev = NULL;
+#endif
+	list->n_entries--;
+}
+
+/** Pop an item from the head of a list.
+ *
+ * @param list Pointer to the list.
+ * @return Item removed from the list, or NULL if it was empty.
+ */
+void *cl_ilist_pop(struct cl_ilist *list) {
+	void *item = cl_ilist_first(list);
+	if(item)
+		cl_ilist_remove(list, item);
+	return item;
+}
+
+/** Clear all items from a list.
+ *
+ * The items are only unlinked, it's up to the caller to free them.
+ *
+ * @param list Pointer to the list.
+ */
+void cl_ilist_clear(struct cl_ilist *list) {
+	cl_ilist_init(list, list->offset);
+}
+
+/** Get the first item of a list.
+ *
+ * @param list Pointer to the list.
+ * @return First item, or NULL if the list is empty.
+ */
+void *cl_ilist_first(const struct cl_ilist *list) {
+	if(cl_ilist_is_empty(list))
+		return NULL;
+	return cl_ilist_item(list, list->head.next);
+}
+
+/** Get the item after another.
+ *
+ * @param list Pointer to the list.
+ * @param item Item in the list.
+ * @return Next item, or NULL if item is the last one.
+ */
+void *cl_ilist_next(const struct cl_ilist *list, const void *item) {
+	struct cl_ilist_link *next = cl_ilist_link(list, item)->next;
+	if(next == &list->head)
+		return NULL;
+	return cl_ilist_item(list, next);
+}
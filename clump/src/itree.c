@@ -0,0 +1,503 @@
+/*
+ * itree.c	An intrusive tree-set
+ *
+ * Copyright (c) 2016  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_itree_init		Initialize an intrusive tree
+ *	cl_itree_count		Count the items in a tree
+ *	cl_itree_get		Get the item matching a key
+ *	cl_itree_first		Get the first item in a tree
+ *	cl_itree_lower_bound	Get the first item not less than a key
+ *	cl_itree_add		Add an item to a tree
+ *	cl_itree_remove_key	Remove the item matching a key
+ *	cl_itree_remove		Remove an item from a tree
+ *	cl_itree_clear		Clear all items from a tree
+ *	cl_itree_iterator_init	Initialize a tree iterator
+ *	cl_itree_iterator_seek	Move an iterator to a key
+ *	cl_itree_iterator_next	Get the next item from an iterator
+ */
+/** \file
+ *
+ * An intrusive tree is a sorted set of items, linked through a struct
+ * cl_itree_link embedded in each item instead of a node allocated for it.
+ * Adding an item never allocates, so a tree can't run out of memory.
+ *
+ * It's the left-leaning red-black tree of tree.c, with the node colors in the
+ * low bit of the link pointers, and NULL for the leaves.  A node can't swap
+ * keys with another (they're the items), so removing an internal node moves
+ * its successor into its place instead.
+ *
+ * The compare function is called with a key and an item in the tree; keys
+ * are items too (a lookup can use one on the stack with just the key fields
+ * set).  Items must stay put while they're in a tree.
+ */
+#include <assert.h>
+#include <stddef.h>
+#include "clump.h"
+
+/** Check if a link is red */
+static inline bool cl_ilink_is_red(struct cl_itree_link *n) {
+	return ((uintptr_t)n & 1);
+}
+
+/** Get a black pointer to a link */
+static inline struct cl_itree_link *cl_ilink_black(struct cl_itree_link *n) {
+	return (struct cl_itree_link *)((uintptr_t)n & ~(uintptr_t)1);
+}
+
+/** Get a red pointer to a link */
+static inline struct cl_itree_link *cl_ilink_red(struct cl_itree_link *n) {
+	return (struct cl_itree_link *)((uintptr_t)n | 1);
+}
+
+/** Check if a link is a leaf */
+static inline bool cl_ilink_is_leaf(struct cl_itree_link *n) {
+	return cl_ilink_black(n) == NULL;
+}
+
+/** Get a left sublink */
+static inline struct cl_itree_link *cl_ilink_left(struct cl_itree_link *n) {
+	return cl_ilink_black(n)->left;
+}
+
+/** Get a right sublink */
+static inline struct cl_itree_link *cl_ilink_right(struct cl_itree_link *n) {
+	return cl_ilink_black(n)->right;
+}
+
+/** Set a left sublink */
+static inline void cl_ilink_set_left(struct cl_itree_link *n,
+	struct cl_itree_link *c)
+{
+	cl_ilink_black(n)->left = c;
+}
+
+/** Set a right sublink */
+static inline void cl_ilink_set_right(struct cl_itree_link *n,
+	struct cl_itree_link *c)
+{
+	cl_ilink_black(n)->right = c;
+}
+
+/** Give a link the color of another */
+static inline struct cl_itree_link *cl_ilink_color(struct cl_itree_link *n,
+	struct cl_itree_link *c)
+{
+	return cl_ilink_is_red(c) ? cl_ilink_red(n) : cl_ilink_black(n);
+}
+
+/** Get the item of a link */
+static inline void *cl_itree_item(const struct cl_itree *tree,
+	struct cl_itree_link *n)
+{
+	return (char *)cl_ilink_black(n) - tree->offset;
+}
+
+/** Get the link of an item */
+static inline struct cl_itree_link *cl_itree_link(const struct cl_itree *tree,
+	const void *item)
+{
+	return (struct cl_itree_link *)((char *)item + tree->offset);
+}
+
+/** Compare a key with the item of a link */
+static inline cl_compare_t cl_itree_compare(const struct cl_itree *tree,
+	struct cl_itree_link *n, const void *key)
+{
+	return tree->fn_compare(key, cl_itree_item(tree, n));
+}
+
+/** Rotate a link left (see cl_node_rotate_left) */
+static struct cl_itree_link *cl_ilink_rotate_left(struct cl_itree_link *n) {
+	struct cl_itree_link *p = cl_ilink_right(n);
+	cl_ilink_set_right(n, cl_ilink_left(p));
+	cl_ilink_set_left(p, cl_ilink_red(n));
+	return cl_ilink_color(p, n);
+}
+
+/** Rotate a link right (see cl_node_rotate_right) */
+static struct cl_itree_link *cl_ilink_rotate_right(struct cl_itree_link *p) {
+	struct cl_itree_link *n = cl_ilink_left(p);
+	cl_ilink_set_left(p, cl_ilink_right(n));
+	cl_ilink_set_right(n, cl_ilink_red(p));
+	return cl_ilink_color(n, p);
+}
+
+/** Flip the color of a link */
+static inline struct cl_itree_link *cl_ilink_flip(struct cl_itree_link *n) {
+	return cl_ilink_is_red(n) ? cl_ilink_black(n) : cl_ilink_red(n);
+}
+
+/** Flip the colors of a link and its children */
+static struct cl_itree_link *cl_ilink_flip_colors(struct cl_itree_link *n) {
+	cl_ilink_set_left(n, cl_ilink_flip(cl_ilink_left(n)));
+	cl_ilink_set_right(n, cl_ilink_flip(cl_ilink_right(n)));
+	return cl_ilink_flip(n);
+}
+
+/** Move a red link to the left */
+static struct cl_itree_link *cl_ilink_move_red_left(struct cl_itree_link *n) {
+	n = cl_ilink_flip_colors(n);
+	if(cl_ilink_is_red(cl_ilink_left(cl_ilink_right(n)))) {
+		cl_ilink_set_right(n, cl_ilink_rotate_right(cl_ilink_right(n)));
+		return cl_ilink_flip_colors(cl_ilink_rotate_left(n));
+	} else
+		return n;
+}
+
+/** Move a red link to the right */
+static struct cl_itree_link *cl_ilink_move_red_right(struct cl_itree_link *n) {
+	n = cl_ilink_flip_colors(n);
+	if(cl_ilink_is_red(cl_ilink_left(cl_ilink_left(n))))
+		return cl_ilink_flip_colors(cl_ilink_rotate_right(n));
+	else
+		return n;
+}
+
+/** Ensure a subtree leans left after an insert or remove operation */
+static struct cl_itree_link *cl_ilink_lean_left(struct cl_itree_link *n) {
+	if(cl_ilink_is_red(cl_ilink_right(n)) &&
+	  !cl_ilink_is_red(cl_ilink_left(n)))
+		n = cl_ilink_rotate_left(n);
+	if(cl_ilink_is_red(cl_ilink_left(n)) &&
+	   cl_ilink_is_red(cl_ilink_left(cl_ilink_left(n))))
+		n = cl_ilink_rotate_right(n);
+	if(cl_ilink_is_red(cl_ilink_left(n)) &&
+	   cl_ilink_is_red(cl_ilink_right(n)))
+		n = cl_ilink_flip_colors(n);
+	return n;
+}
+
+/** Put link n in the place of link r (same children and color) */
+static struct cl_itree_link *cl_ilink_replace(struct cl_itree_link *r,
+	struct cl_itree_link *n)
+{
+	n->left = cl_ilink_left(r);
+	n->right = cl_ilink_right(r);
+	return cl_ilink_color(n, r);
+}
+
+/** Initialize an intrusive tree.
+ *
+ * The tree can be anywhere (on the stack, in another struct) and doesn't need
+ * to be destroyed.
+ *
+ * @param tree Pointer to the tree.
+ * @param offset Offset of the struct cl_itree_link in the items.
+ * @param fn_compare Function to compare a key with an item.
+ */
+void cl_itree_init(struct cl_itree *tree, size_t offset,
+	cl_compare_cb *fn_compare)
+{
+	tree->root = NULL;
+	tree->fn_compare = fn_compare;
+	tree->offset = offset;
+	tree->n_entries = 0;
+}
+
+/** Get the count of items in a tree.
+ *
+ * @param tree Pointer to the tree.
+ * @return Count of items in the tree.
+ */
+uint32_t cl_itree_count(const struct cl_itree *tree) {
+	return tree->n_entries;
+}
+
+/** Get the item matching a key.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Key to find.
+ * @return Matching item, or NULL if not found.
+ */
+void *cl_itree_get(const struct cl_itree *tree, const void *key) {
+	struct cl_itree_link *n = tree->root;
+	while(!cl_ilink_is_leaf(n)) {
+		switch(cl_itree_compare(tree, n, key)) {
+		case CL_LESS:
+			n = cl_ilink_left(n);
+			break;
+		case CL_EQUAL:
+			return cl_itree_item(tree, n);
+		case CL_GREATER:
+			n = cl_ilink_right(n);
+			break;
+		}
+	}
+	return NULL;
+}
+
+/** Get the first item in a tree.
+ *
+ * @param tree Pointer to the tree.
+ * @return Lowest item, or NULL if the tree is empty.
+ */
+void *cl_itree_first(const struct cl_itree *tree) {
+	struct cl_itree_link *n = tree->root;
+	if(cl_ilink_is_leaf(n))
+		return NULL;
+	while(!cl_ilink_is_leaf(cl_ilink_left(n)))
+		n = cl_ilink_left(n);
+	return cl_itree_item(tree, n);
+}
+
+/** Get the first item not less than a key.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Key to search for.
+ * @return First item not less than key, or NULL if there is none.
+ */
+void *cl_itree_lower_bound(const struct cl_itree *tree, const void *key) {
+	struct cl_itree_link *n = tree->root;
+	struct cl_itree_link *bound = NULL;
+	while(!cl_ilink_is_leaf(n)) {
+		cl_compare_t c = cl_itree_compare(tree, n, key);
+		if(c == CL_GREATER)
+			n = cl_ilink_right(n);
+		else {
+			bound = n;
+			if(c == CL_EQUAL)
+				break;
+			n = cl_ilink_left(n);
+		}
+	}
+	return bound ? cl_itree_item(tree, bound) : NULL;
+}
+
+/** Insert a link into a subtree.
+ *
+ * @param tree Pointer to the tree.
+ * @param r Root link of subtree.
+ * @param n New link (red).
+ * @return New subtree root link.
+ */
+static struct cl_itree_link *cl_itree_insert_sub(struct cl_itree *tree,
+	struct cl_itree_link *r, struct cl_itree_link *n)
+{
+	if(cl_ilink_is_leaf(r))
+		return n;
+	switch(cl_itree_compare(tree, r, cl_itree_item(tree, n))) {
+	case CL_LESS:
+		cl_ilink_set_left(r, cl_itree_insert_sub(tree, cl_ilink_left(r),
+			n));
+		break;
+	case CL_EQUAL:
+		tree->match = cl_ilink_black(r);
+		return cl_ilink_replace(r, cl_ilink_black(n));
+	case CL_GREATER:
+		cl_ilink_set_right(r, cl_itree_insert_sub(tree,
+			cl_ilink_right(r), n));
+		break;
+	}
+	return cl_ilink_lean_left(r);
+}
+
+/** Add an item to a tree.
+ *
+ * An item matching it is replaced (it takes that item's place).
+ *
+ * @param tree Pointer to the tree.
+ * @param item Item to add (not in the tree already).
+ * @return Matching replaced item if it existed, or NULL otherwise.
+ */
+void *cl_itree_add(struct cl_itree *tree, void *item) {
+	struct cl_itree_link *n = cl_itree_link(tree, item);
+	n->left = NULL;
+	n->right = NULL;
+	tree->match = NULL;
+	tree->root = cl_ilink_black(cl_itree_insert_sub(tree, tree->root,
+		cl_ilink_red(n)));
+	if(tree->match)
+		return cl_itree_item(tree, tree->match);
+	tree->n_entries++;
+	return NULL;
+}
+
+/** Remove the lowest link of a subtree.
+ *
+ * @param tree Pointer to the tree.
+ * @param n Root of sub-tree.
+ * @return New root of sub-tree.
+ */
+static struct cl_itree_link *cl_itree_pop_sub(struct cl_itree *tree,
+	struct cl_itree_link *n)
+{
+	if(cl_ilink_is_leaf(cl_ilink_left(n))) {
+		tree->match = cl_ilink_black(n);
+		return NULL;
+	}
+	if(!cl_ilink_is_red(cl_ilink_left(n)) &&
+	   !cl_ilink_is_red(cl_ilink_left(cl_ilink_left(n))))
+		n = cl_ilink_move_red_left(n);
+	cl_ilink_set_left(n, cl_itree_pop_sub(tree, cl_ilink_left(n)));
+	return cl_ilink_lean_left(n);
+}
+
+/** Remove an internal link, moving its successor into its place.
+ *
+ * @param tree Pointer to the tree.
+ * @param n Link to be removed.
+ * @return Successor, the new root of sub-tree.
+ */
+static struct cl_itree_link *cl_itree_remove_internal(struct cl_itree *tree,
+	struct cl_itree_link *n)
+{
+	struct cl_itree_link *nr = cl_itree_pop_sub(tree, cl_ilink_right(n));
+	struct cl_itree_link *mn = tree->match;
+	assert(mn);
+	cl_ilink_set_right(n, nr);
+	tree->match = cl_ilink_black(n);
+	return cl_ilink_replace(n, mn);
+}
+
+/** Remove a link from a subtree.
+ *
+ * @param tree Pointer to the tree.
+ * @param n Root link of sub-tree.
+ * @param key Key of item to remove.
+ * @return New root of sub-tree.
+ */
+static struct cl_itree_link *cl_itree_remove_sub(struct cl_itree *tree,
+	struct cl_itree_link *n, const void *key)
+{
+	if(cl_ilink_is_leaf(n))
+		return n;
+	if(cl_itree_compare(tree, n, key) == CL_LESS) {
+		if(!cl_ilink_is_red(cl_ilink_left(n)) &&
+		   !cl_ilink_is_red(cl_ilink_left(cl_ilink_left(n))))
+			n = cl_ilink_move_red_left(n);
+		cl_ilink_set_left(n, cl_itree_remove_sub(tree, cl_ilink_left(n),
+			key));
+	} else {
+		if(cl_ilink_is_red(cl_ilink_left(n)))
+			n = cl_ilink_rotate_right(n);
+		if(cl_itree_compare(tree, n, key) == CL_EQUAL &&
+		   cl_ilink_is_leaf(cl_ilink_right(n)))
+		{
+			tree->match = cl_ilink_black(n);
+			return NULL;
+		}
+		if(!cl_ilink_is_red(cl_ilink_right(n)) &&
+		   !cl_ilink_is_red(cl_ilink_left(cl_ilink_right(n))))
+			n = cl_ilink_move_red_right(n);
+		if(cl_itree_compare(tree, n, key) == CL_EQUAL)
+			n = cl_itree_remove_internal(tree, n);
+		else {
+			cl_ilink_set_right(n, cl_itree_remove_sub(tree,
+				cl_ilink_right(n), key));
+		}
+	}
+	return cl_ilink_lean_left(n);
+}
+
+/** Remove the item matching a key.
+ *
+ * @param tree Pointer to the tree.
+ * @param key Key to remove.
+ * @return Removed item if it existed, or NULL otherwise.
+ */
+void *cl_itree_remove_key(struct cl_itree *tree, const void *key) {
+	tree->match = NULL;
+	tree->root = cl_ilink_black(cl_itree_remove_sub(tree, tree->root,
+		key));
+	if(tree->match) {
+		tree->n_entries--;
+		return cl_itree_item(tree, tree->match);
+	}
+	return NULL;
+}
+
+/** Remove an item from a tree, in O(log n).
+ *
+ * @param tree Pointer to the tree.
+ * @param item Item to remove (in the tree).
+ */
+void cl_itree_remove(struct cl_itree *tree, void *item) {
+	void *removed = cl_itree_remove_key(tree, item);
+	assert(removed == item);
+	(void)removed;
+}
+
+/** Clear all items from a tree.
+ *
+ * The items are only unlinked, it's up to the caller to free them.
+ *
+ * @param tree Pointer to the tree.
+ */
+void cl_itree_clear(struct cl_itree *tree) {
+	tree->root = NULL;
+	tree->n_entries = 0;
+}
+
+/** Descend a tree iterator down the left links, putting each on the path */
+static void cl_itree_iterator_descend(struct cl_itree_iterator *it,
+	struct cl_itree_link *n)
+{
+	while(!cl_ilink_is_leaf(n)) {
+		assert(it->depth < CL_TREE_DEPTH);
+		it->path[it->depth++] = n;
+		n = cl_ilink_left(n);
+	}
+}
+
+/** Initialize a tree iterator.
+ *
+ * Initialize a caller's iterator (which can be on the stack).  It doesn't
+ * need to be destroyed.  Items are returned in increasing order; the tree
+ * must not change while iterating.
+ *
+ * @param it The tree iterator.
+ * @param tree Pointer to the tree.
+ */
+void cl_itree_iterator_init(struct cl_itree_iterator *it,
+	const struct cl_itree *tree)
+{
+	it->tree = tree;
+	it->depth = 0;
+	it->pending = true;
+	cl_itree_iterator_descend(it, tree->root);
+}
+
+/** Move a tree iterator to a key.
+ *
+ * The next call to cl_itree_iterator_next returns the first item not less
+ * than key.
+ *
+ * @param it The tree iterator.
+ * @param key Key to seek.
+ */
+void cl_itree_iterator_seek(struct cl_itree_iterator *it, const void *key) {
+	struct cl_itree_link *n = it->tree->root;
+	it->depth = 0;
+	it->pending = true;
+	while(!cl_ilink_is_leaf(n)) {
+		cl_compare_t c = cl_itree_compare(it->tree, n, key);
+		if(c == CL_GREATER) {
+			n = cl_ilink_right(n);
+			continue;
+		}
+		assert(it->depth < CL_TREE_DEPTH);
+		it->path[it->depth++] = n;
+		if(c == CL_EQUAL)
+			break;
+		n = cl_ilink_left(n);
+	}
+}
+
+/** Get next item from a tree iterator.
+ *
+ * @param it The iterator.
+ * @return Next item, or NULL if no more items.
+ */
+void *cl_itree_iterator_next(struct cl_itree_iterator *it) {
+	if(it->pending)
+		it->pending = false;
+	else if(it->depth) {
+		struct cl_itree_link *n = it->path[--it->depth];
+		cl_itree_iterator_descend(it, cl_ilink_right(n));
+	}
+	return it->depth ? cl_itree_item(it->tree, it->path[it->depth - 1])
+		: NULL;
+}
@@ -6,6 +6,8 @@
  * Public functions:
  *
  *	cl_list_create			Create a linked list
+ *	cl_list_create_with_alloc	Create a linked list with an allocator
+ *	cl_list_create_arena		Create a linked list in an arena
  *	cl_list_destroy			Destroy a linked list
  *	cl_list_is_empty		Check if a list is empty
  *	cl_list_count			Count the items in a list
@@ -15,7 +17,11 @@
  *	cl_list_contains		Check if a list contains an item
  *	cl_list_pop			Pop an item from a list
  *	cl_list_clear			Clear all items from a list
+ *	cl_list_reserve			Reserve room for items in a list
+ *	cl_list_shrink			Free unused memory of a list
+ *	cl_list_stats			Add up memory statistics of a list
  *	cl_list_iterator_create		Create a list iterator
+ *	cl_list_iterator_init		Initialize a list iterator
  *	cl_list_iterator_destroy	Destroy a list iterator
  *	cl_list_iterator_next		Get next item from an iterator
  *	cl_list_iterator_remove		Remove current item from an iterator
@@ -36,17 +42,11 @@ struct cl_list_node {
 	struct cl_list_node	*next;		/**< link to next node */
 };
 
-/** List iterator structure.
- */
-struct cl_list_iterator {
-	struct cl_list		*list;		/**< list */
-	struct cl_list_node	*prev;		/**< previous list node */
-};
-
 /** Linked list structure.
  */
 struct cl_list {
 	struct cl_pool		*pool;		/**< node memory pool */
+	const struct cl_alloc	*al;		/**< allocator of list */
 	struct cl_list_node	*head;		/**< link to head node */
 	struct cl_list_node	*tail;		/**< link to tail node */
 	unsigned int		n_entries;	/**< number of entries */
@@ -64,16 +64,38 @@ static inline size_t max_size_t(size_t a, size_t b) {
  * @return Pointer to a new list.
  */
 struct cl_list *cl_list_create(void) {
-	struct cl_list *list = malloc(sizeof(struct cl_list));
-	assert(list);
-	list->pool = cl_pool_create(max_size_t(sizeof(struct cl_list_node),
-		sizeof(struct cl_list_iterator)));
+	return cl_list_create_with_alloc(&cl_alloc_default);
+}
+
+/** Create a linked list with an allocator.
+ *
+ * @param al Allocator for the list and its nodes.
+ * @return Pointer to a new list.
+ */
+struct cl_list *cl_list_create_with_alloc(const struct cl_alloc *al) {
+	struct cl_list *list = cl_alloc_malloc(al, sizeof(struct cl_list));
+	list->pool = cl_pool_create_with_alloc(max_size_t(
+		sizeof(struct cl_list_node), sizeof(struct cl_list_iterator)),
+		al);
+	list->al = al;
 	list->head = NULL;
 	list->tail = NULL;
 	list->n_entries = 0;
 	return list;
 }
 
+/** Create a linked list in an arena.
+ *
+ * The list and its nodes are allocated from a memory arena, and are freed
+ * when it is released or reset -- destroying the list is optional.
+ *
+ * @param arena Memory arena.
+ * @return Pointer to a new list.
+ */
+struct cl_list *cl_list_create_arena(struct cl_arena *arena) {
+	return cl_list_create_with_alloc(cl_arena_allocator(arena));
+}
+
 /** Destroy a linked list.
  *
  * Destroy the specified linked list, releasing all its resources.
@@ -88,7 +110,7 @@ void cl_list_destroy(struct cl_list *list) {
 	list->tail = NULL;
 	list->pool = NULL;
 #endif
-	free(list);
+	cl_alloc_free(list->al, list, sizeof(struct cl_list));
 }
 
 /** Test if a list is empty.
@@ -230,6 +252,38 @@ void cl_list_clear(struct cl_list *list) {
 	list->n_entries = 0;
 }
 
+/** Reserve room for items in a linked list.
+ *
+ * Allocate node memory up front, so that adding the next n items does not
+ * call malloc.
+ *
+ * @param list Pointer to the list.
+ * @param n Number of items to reserve room for.
+ */
+void cl_list_reserve(struct cl_list *list, uint32_t n) {
+	cl_pool_reserve(list->pool, n);
+}
+
+/** Shrink a linked list.
+ *
+ * Free node memory which is not in use (after a clear).
+ *
+ * @param list Pointer to the list.
+ */
+void cl_list_shrink(struct cl_list *list) {
+	cl_pool_shrink(list->pool);
+}
+
+/** Add up memory statistics of a linked list.
+ *
+ * @param list Pointer to the list.
+ * @param stats Statistics to add to (see cl_pool_stats).
+ */
+void cl_list_stats(const struct cl_list *list, struct cl_pool_stats *stats) {
+	cl_pool_stats(list->pool, stats);
+	stats->n_bytes += sizeof(struct cl_list);
+}
+
 /** Create a list iterator.
  *
  * Create an iterator which can be used to iterate over items in a list.
@@ -239,9 +293,21 @@ void cl_list_clear(struct cl_list *list) {
  */
 struct cl_list_iterator *cl_list_iterator_create(struct cl_list *list) {
 	struct cl_list_iterator *it = cl_pool_alloc(list->pool);
+	cl_list_iterator_init(it, list);
+	return it;
+}
+
+/** Initialize a list iterator.
+ *
+ * Initialize a caller's iterator (which can be on the stack) to iterate over
+ * items in a list.  It doesn't need to be destroyed.
+ *
+ * @param it Pointer to the iterator.
+ * @param list Pointer to the list.
+ */
+void cl_list_iterator_init(struct cl_list_iterator *it, struct cl_list *list) {
 	it->list = list;
 	it->prev = NULL;
-	return it;
 }
 
 /** Destroy a list iterator.
@@ -0,0 +1,440 @@
+/*
+ * phash.c	Minimal perfect hashes of static key sets
+ *
+ * Copyright (c) 2012  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_phash_create		Create a perfect hash of an array of keys
+ *	cl_phash_create_rhash	Create a perfect hash of the keys of a hash
+ *	cl_phash_destroy	Destroy a perfect hash
+ *	cl_phash_table		Get the lookup table of a perfect hash
+ *	cl_phash_write_c	Write the lookup table of a perfect hash as C
+ *	cl_phash_get		Look up a key in a perfect hash table
+ *	cl_phash_get_bytes	Look up a run of bytes in a perfect hash table
+ *	cl_phash_key		Get the key in a slot of a perfect hash table
+ */
+/** \file
+ *
+ * A perfect hash maps each of a fixed set of n keys to its own slot, from 0
+ * to n - 1, so a lookup hashes the key, reads one slot and compares one key.
+ * It's built once from a finished set (an array or the keys of a hash) and
+ * can't be changed.  The lookup table (struct cl_phash_table) is a few
+ * arrays, so cl_phash_write_c can write it as C source, to be compiled into
+ * a program as const data: keyword tables then need no building at all.
+ *
+ * It's built by hashing and displacing: keys are split into buckets (about
+ * CL_PHASH_LAMBDA per bucket) by one hash, and each key also has a position
+ * f and step g from another.  A key of bucket b is in slot
+ *
+ *	(f + d0 * g + d1) mod n		(disp[b] = d0 * n + d1)
+ *
+ * Buckets are placed largest first, each with the first displacement which
+ * puts all of its keys in free slots.  A bucket of one key goes straight to
+ * a free slot (d0 = 0).  If none of the first CL_PHASH_STEPS * n
+ * displacements fits a bucket, the build starts over with another seed.
+ * A lookup costs two hashes of the key; the table is about one byte per
+ * key, plus the key pointers.
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clump.h"
+
+/** Average keys per bucket */
+#define CL_PHASH_LAMBDA		4
+
+/** Number of seeds tried before giving up */
+#define CL_PHASH_SEEDS		64
+
+/** Steps (d0 values) tried for each bucket before trying another seed */
+#define CL_PHASH_STEPS		256
+
+/** Perfect hash structure.
+ */
+struct cl_phash {
+	struct cl_phash_table	tbl;		/**< lookup table */
+	uint32_t		*disp;		/**< displacement of buckets */
+	const char		**keys;		/**< key of each slot */
+};
+
+/** Hash codes of one key.
+ */
+struct cl_phash_code {
+	uint32_t	bucket;		/**< bucket number */
+	uint32_t	f;		/**< first slot */
+	uint32_t	g;		/**< slot step */
+};
+
+/** Calculate the hash codes of a key.
+ *
+ * @param tbl		Perfect hash table.
+ * @param key		Pointer to key.
+ * @param n_bytes	Bytes in key.
+ * @param hc		Hash codes to fill in.
+ */
+static void cl_phash_code(const struct cl_phash_table *tbl, const void *key,
+	size_t n_bytes, struct cl_phash_code *hc)
+{
+	uint32_t a = cl_hash_bytes(key, n_bytes, tbl->seed);
+	uint32_t b = cl_hash_bytes(key, n_bytes, tbl->seed + 1);
+	uint64_t x = cl_hash_mix(((uint64_t)a << 32) | b);
+	hc->bucket = a % tbl->n_buckets;
+	hc->f = (uint32_t)x % tbl->n_keys;
+	hc->g = (uint32_t)(x >> 32) % tbl->n_keys;
+}
+
+/** Get the slot of a key with a displacement.
+ */
+static uint32_t cl_phash_slot(const struct cl_phash_table *tbl,
+	const struct cl_phash_code *hc, uint32_t disp)
+{
+	uint64_t d0 = disp / tbl->n_keys;
+	uint64_t d1 = disp % tbl->n_keys;
+	return (hc->f + d0 * hc->g + d1) % tbl->n_keys;
+}
+
+/** Get the number of bytes in a key.
+ */
+static size_t cl_phash_key_bytes(const struct cl_phash_table *tbl,
+	const void *key)
+{
+	return tbl->key_bytes ? tbl->key_bytes : strlen(key);
+}
+
+/** Key with its hash codes (for building).
+ */
+struct cl_phash_entry {
+	const char		*key;		/**< key */
+	struct cl_phash_code	hc;		/**< hash codes */
+};
+
+/** Compare entries by bucket (for sorting).
+ */
+static int cl_phash_compare_bucket(const void *v0, const void *v1) {
+	const struct cl_phash_entry *e0 = v0;
+	const struct cl_phash_entry *e1 = v1;
+	return (e0->hc.bucket > e1->hc.bucket) -
+	       (e0->hc.bucket < e1->hc.bucket);
+}
+
+/** Bucket of entries (for building).
+ */
+struct cl_phash_bucket {
+	uint32_t	n_first;	/**< first entry */
+	uint32_t	n_keys;		/**< number of entries */
+};
+
+/** Compare buckets by size, largest first (for sorting).
+ */
+static int cl_phash_compare_size(const void *v0, const void *v1) {
+	const struct cl_phash_bucket *b0 = v0;
+	const struct cl_phash_bucket *b1 = v1;
+	if(b0->n_keys != b1->n_keys)
+		return (b0->n_keys < b1->n_keys) - (b0->n_keys > b1->n_keys);
+	return (b0->n_first > b1->n_first) - (b0->n_first < b1->n_first);
+}
+
+/** Try to place one bucket with a displacement.
+ *
+ * @return true if every key of the bucket has a free slot (and they are
+ *	   all different).
+ */
+static bool cl_phash_fits(const struct cl_phash *ph,
+	const struct cl_phash_entry *ents, const struct cl_phash_bucket *bk,
+	uint32_t disp, uint32_t *slots)
+{
+	for(uint32_t i = 0; i < bk->n_keys; i++) {
+		uint32_t s = cl_phash_slot(&ph->tbl, &ents[bk->n_first + i].hc,
+			disp);
+		if(ph->keys[s])
+			return false;
+		for(uint32_t j = 0; j < i; j++) {
+			if(slots[j] == s)
+				return false;
+		}
+		slots[i] = s;
+	}
+	return true;
+}
+
+/** Try to build a perfect hash with the current seed.
+ *
+ * @param ph		Perfect hash (keys and disp are cleared).
+ * @param ents		Entries of all keys.
+ * @param bks		Bucket array.
+ * @return true on success.
+ */
+static bool cl_phash_build(struct cl_phash *ph, struct cl_phash_entry *ents,
+	struct cl_phash_bucket *bks)
+{
+	struct cl_phash_table *tbl = &ph->tbl;
+	uint32_t n_keys = tbl->n_keys;
+	uint32_t n_free = 0;	/* search position for a free slot */
+	uint64_t n_disp = (uint64_t)n_keys * CL_PHASH_STEPS;
+	uint32_t *slots;
+	uint32_t i, b;
+
+	if(n_disp > UINT32_MAX)
+		n_disp = UINT32_MAX;
+	memset(ph->keys, 0, sizeof(const char *) * n_keys);
+	memset(ph->disp, 0, sizeof(uint32_t) * tbl->n_buckets);
+	for(i = 0; i < n_keys; i++) {
+		const char *k = ents[i].key;
+		cl_phash_code(tbl, k, cl_phash_key_bytes(tbl, k), &ents[i].hc);
+	}
+	qsort(ents, n_keys, sizeof(struct cl_phash_entry),
+		cl_phash_compare_bucket);
+	for(b = 0; b < tbl->n_buckets; b++) {
+		bks[b].n_first = 0;
+		bks[b].n_keys = 0;
+	}
+	for(i = n_keys; i > 0; i--) {
+		struct cl_phash_bucket *bk = &bks[ents[i - 1].hc.bucket];
+		bk->n_first = i - 1;
+		bk->n_keys++;
+	}
+	/* Sorting loses the bucket numbers, but any entry of a bucket has it */
+	qsort(bks, tbl->n_buckets, sizeof(struct cl_phash_bucket),
+		cl_phash_compare_size);
+	slots = malloc(sizeof(uint32_t) * (bks[0].n_keys + 1));
+	assert(slots);
+	for(b = 0; b < tbl->n_buckets && bks[b].n_keys > 0; b++) {
+		const struct cl_phash_bucket *bk = &bks[b];
+		const struct cl_phash_entry *e = &ents[bk->n_first];
+		uint32_t disp;
+
+		if(bk->n_keys == 1) {
+			while(ph->keys[n_free])
+				n_free++;
+			/* d1 which moves f to the free slot */
+			disp = (n_free + n_keys - e->hc.f) % n_keys;
+			slots[0] = n_free;
+		} else {
+			uint64_t d;
+			for(d = 0; d < n_disp; d++) {
+				if(cl_phash_fits(ph, ents, bk, d, slots))
+					break;
+			}
+			if(d == n_disp) {
+				free(slots);
+				return false;
+			}
+			disp = d;
+		}
+		ph->disp[e->hc.bucket] = disp;
+		for(i = 0; i < bk->n_keys; i++)
+			ph->keys[slots[i]] = ents[bk->n_first + i].key;
+	}
+	free(slots);
+	return true;
+}
+
+/** Create a perfect hash of an array of keys.
+ *
+ * The keys must all be different.  They are not copied, and must stay in
+ * place while the perfect hash (not its table, if written as C) is used.
+ *
+ * @param keys		Array of keys.
+ * @param n_keys	Number of keys (at least 1).
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @return Pointer to the perfect hash, or NULL if it couldn't be built
+ *	   (with duplicate keys, for example).
+ */
+struct cl_phash *cl_phash_create(const void *const *keys, uint32_t n_keys,
+	uint16_t key_bytes)
+{
+	struct cl_phash *ph;
+	struct cl_phash_entry *ents;
+	struct cl_phash_bucket *bks;
+
+	assert(n_keys > 0);
+	ph = malloc(sizeof(struct cl_phash));
+	assert(ph);
+	ph->tbl.n_keys = n_keys;
+	ph->tbl.n_buckets = (n_keys + CL_PHASH_LAMBDA - 1) / CL_PHASH_LAMBDA;
+	ph->tbl.key_bytes = key_bytes;
+	ph->disp = malloc(sizeof(uint32_t) * ph->tbl.n_buckets);
+	ph->keys = malloc(sizeof(const char *) * n_keys);
+	ents = malloc(sizeof(struct cl_phash_entry) * n_keys);
+	bks = malloc(sizeof(struct cl_phash_bucket) * ph->tbl.n_buckets);
+	assert(ph->disp && ph->keys && ents && bks);
+	ph->tbl.disp = ph->disp;
+	ph->tbl.keys = ph->keys;
+	for(uint64_t seed = 0; seed < CL_PHASH_SEEDS; seed++) {
+		/* Every other seed, as seed + 1 is the second hash */
+		ph->tbl.seed = cl_hash_mix(seed * 2 + 1);
+		for(uint32_t i = 0; i < n_keys; i++)
+			ents[i].key = keys[i];
+		if(cl_phash_build(ph, ents, bks)) {
+			free(ents);
+			free(bks);
+			return ph;
+		}
+	}
+	free(ents);
+	free(bks);
+	cl_phash_destroy(ph);
+	return NULL;
+}
+
+/** Create a perfect hash of the keys of a hash set or map.
+ *
+ * The hash must not be changed while the perfect hash is used (keys point to
+ * the keys of the hash).
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param key_bytes	Number of bytes in each key (0 for strings), as the hash
+ *			was created with.
+ * @return Pointer to the perfect hash, or NULL if it couldn't be built.
+ */
+struct cl_phash *cl_phash_create_rhash(struct cl_rhash *hash,
+	uint16_t key_bytes)
+{
+	uint32_t n_keys = cl_rhash_count(hash);
+	const void **keys = malloc(sizeof(void *) * (n_keys ? n_keys : 1));
+	struct cl_rhash_iterator it;
+	struct cl_phash *ph;
+	const void *key;
+	uint32_t i = 0;
+
+	assert(keys);
+	CL_RHASH_FOREACH(it, hash, key)
+		keys[i++] = key;
+	ph = cl_phash_create(keys, n_keys, key_bytes);
+	free(keys);
+	return ph;
+}
+
+/** Destroy a perfect hash.
+ *
+ * @param ph		Perfect hash.
+ */
+void cl_phash_destroy(struct cl_phash *ph) {
+	assert(ph);
+	free(ph->disp);
+	free(ph->keys);
+#ifndef NDEBUG
+	ph->disp = NULL;
+	ph->keys = NULL;
+	ph->tbl.disp = NULL;
+	ph->tbl.keys = NULL;
+#endif
+	free(ph);
+}
+
+/** Get the lookup table of a perfect hash.
+ *
+ * @param ph		Perfect hash.
+ * @return Lookup table (valid until the perfect hash is destroyed).
+ */
+const struct cl_phash_table *cl_phash_table(const struct cl_phash *ph) {
+	return &ph->tbl;
+}
+
+/** Write a key as a C string literal.
+ */
+static void cl_phash_write_key(FILE *fp, const char *key, size_t n_bytes) {
+	fputc('"', fp);
+	for(size_t i = 0; i < n_bytes; i++) {
+		unsigned char c = key[i];
+		if(c == '"' || c == '\\')
+			fprintf(fp, "\\%c", c);
+		else if(c >= ' ' && c <= '~' && c != '?')
+			fputc(c, fp);
+		else
+			fprintf(fp, "\\%03o", c);
+	}
+	fputc('"', fp);
+}
+
+/** Write the lookup table of a perfect hash as C.
+ *
+ * The file defines static const arrays and a struct cl_phash_table called
+ * name, which can be used with cl_phash_get (or cl_phash_get_bytes) just like
+ * the table of the perfect hash.  It needs clump.h to be included first.
+ *
+ * @param ph		Perfect hash.
+ * @param name		C identifier of the table.
+ * @param path		Path of file to write.
+ * @return true on success, false on an I/O error.
+ */
+bool cl_phash_write_c(const struct cl_phash *ph, const char *name,
+	const char *path)
+{
+	const struct cl_phash_table *tbl = &ph->tbl;
+	FILE *fp = fopen(path, "w");
+	bool ok;
+
+	if(fp == NULL)
+		return false;
+	fprintf(fp, "/* Perfect hash table written by cl_phash_write_c */\n\n");
+	fprintf(fp, "static const uint32_t %s_disp[%u] = {", name,
+		tbl->n_buckets);
+	for(uint32_t b = 0; b < tbl->n_buckets; b++)
+		fprintf(fp, "%s%u,", b % 8 ? " " : "\n\t", tbl->disp[b]);
+	fprintf(fp, "\n};\n\nstatic const char *const %s_keys[%u] = {\n",
+		name, tbl->n_keys);
+	for(uint32_t i = 0; i < tbl->n_keys; i++) {
+		const char *k = tbl->keys[i];
+		fputc('\t', fp);
+		cl_phash_write_key(fp, k, cl_phash_key_bytes(tbl, k));
+		fprintf(fp, ",\n");
+	}
+	fprintf(fp, "};\n\nstatic const struct cl_phash_table %s = {\n", name);
+	fprintf(fp, "\t%u, %u, 0x%016llxULL, %u, %s_disp, %s_keys\n};\n",
+		tbl->n_keys, tbl->n_buckets, (unsigned long long)tbl->seed,
+		tbl->key_bytes, name, name);
+	ok = !ferror(fp);
+	if(fclose(fp) != 0)
+		ok = false;
+	return ok;
+}
+
+/** Look up a run of bytes in a perfect hash table.
+ *
+ * @param tbl		Perfect hash table.
+ * @param key		Pointer to the bytes (need not end with NUL).
+ * @param n_bytes	Number of bytes.
+ * @return Slot of the key, or tbl->n_keys if it's not in the table.
+ */
+uint32_t cl_phash_get_bytes(const struct cl_phash_table *tbl, const void *key,
+	size_t n_bytes)
+{
+	struct cl_phash_code hc;
+	const char *k;
+	uint32_t s;
+
+	if(tbl->key_bytes && n_bytes != tbl->key_bytes)
+		return tbl->n_keys;
+	cl_phash_code(tbl, key, n_bytes, &hc);
+	s = cl_phash_slot(tbl, &hc, tbl->disp[hc.bucket]);
+	k = tbl->keys[s];
+	if(tbl->key_bytes)
+		return memcmp(k, key, n_bytes) ? tbl->n_keys : s;
+	else
+		return (strncmp(k, key, n_bytes) || k[n_bytes]) ? tbl->n_keys
+		                                                : s;
+}
+
+/** Look up a key in a perfect hash table.
+ *
+ * @param tbl		Perfect hash table.
+ * @param key		Pointer to key.
+ * @return Slot of the key, or tbl->n_keys if it's not in the table.
+ */
+uint32_t cl_phash_get(const struct cl_phash_table *tbl, const void *key) {
+	return cl_phash_get_bytes(tbl, key, cl_phash_key_bytes(tbl, key));
+}
+
+/** Get the key in a slot of a perfect hash table.
+ *
+ * @param tbl		Perfect hash table.
+ * @param slot		Slot number (less than n_keys).
+ * @return Pointer to the key.
+ */
+const void *cl_phash_key(const struct cl_phash_table *tbl, uint32_t slot) {
+	assert(slot < tbl->n_keys);
+	return tbl->keys[slot];
+}
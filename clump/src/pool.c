@@ -6,10 +6,16 @@
  * Public functions:
  *
  *	cl_pool_create		Initialize a memory pool
+ *	cl_pool_create_ex	Initialize a memory pool with block options
+ *	cl_pool_create_with_alloc Initialize a memory pool with an allocator
+ *	cl_pool_create_arena	Initialize a memory pool in an arena
  *	cl_pool_destroy		Destroy a memory pool
  *	cl_pool_alloc		Allocate a new object from a pool
  *	cl_pool_release		Release an object back to a pool
  *	cl_pool_clear		Release all objects back to a pool
+ *	cl_pool_reserve		Reserve blocks for objects in a pool
+ *	cl_pool_shrink		Free unused blocks of a pool
+ *	cl_pool_stats		Add up memory statistics of a pool
  */
 /** \file
  *
@@ -32,10 +38,33 @@
  * Before a slot has been allocated to an object, it is initialized with a
  * freelist pointer to the next free slot.  When the freelist is exhausted,
  * a new block is allocated and initialized.
+ *
+ * With cl_pool_create_ex, the block size and object alignment (up to 64
+ * bytes) can be chosen, and blocks can be mapped with mmap instead of
+ * malloc, using huge pages if possible, to reduce TLB pressure in big pools.
+ * An aligned pool pads slot #0 and each object to the alignment.
+ *
+ * With cl_pool_create_with_alloc, the pool and its blocks are allocated
+ * from another allocator (see struct cl_alloc).  A pool created with
+ * cl_pool_create_arena lives in a memory arena, with its blocks allocated
+ * from it.  Blocks are never freed by the pool then; destroying it only
+ * drops it, and its memory goes when the arena is released or reset.
  */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE		/* MAP_ANONYMOUS with -std=c99 */
+#endif
 #include <assert.h>
 #include <stdlib.h>
 #include "clump.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#ifdef MAP_ANONYMOUS
+#define CL_POOL_HAS_MMAP
+#endif
+#endif
+
+/** Size of a huge page */
+#define CL_POOL_HUGE_PAGE (2 << 20)
 
 /** Memory pool structure.
  */
@@ -45,12 +74,21 @@ struct cl_pool {
 	void		*free_head;	/* head of free list */
 	unsigned int	n_bytes;	/* number of bytes for each object */
 	unsigned int	n_slots;	/* number of slots for each block */
+	unsigned int	o_slot;		/* offset of first slot in block */
+	unsigned int	align;		/* object alignment */
+	unsigned int	flags;		/* CL_POOL_MMAP / CL_POOL_HUGE */
+	const struct cl_alloc *al;	/* allocator of pool and blocks */
+	size_t		n_block;	/* bytes for each block */
+	uint32_t	n_blocks;	/* number of blocks in block list */
+	uint32_t	n_spare;	/* number of blocks in free block list */
+	uint32_t	n_live;		/* number of allocated objects */
+	uint32_t	n_high;		/* high-water mark of n_live */
 };
 
 /** Get the first slot of a block.
  */
-static inline void **cl_pool_block_slot(void **block) {
-	return block + 1;
+static inline void **cl_pool_block_slot(struct cl_pool *p, void **block) {
+	return (void **)((char *)block + p->o_slot);
 }
 
 /** Create a memory pool.
@@ -61,26 +99,154 @@ static inline void **cl_pool_block_slot(void **block) {
  * @param s Size of each object (in bytes).
  * @return Pointer to the memory pool.
  */
-struct cl_pool *cl_pool_create(unsigned int s) {
-	struct cl_pool *p = malloc(sizeof(struct cl_pool));
-	assert(p);
+struct cl_pool *cl_pool_create(uint32_t s) {
+	return cl_pool_create_ex(s, 0, 0, 0);
+}
+
+/** Initialize a memory pool.
+ */
+static struct cl_pool *cl_pool_init(uint32_t s, uint32_t align,
+	size_t n_block, uint32_t flags, const struct cl_alloc *al)
+{
+	struct cl_pool *p = cl_alloc_malloc(al, sizeof(struct cl_pool));
+	assert(align <= 64 && (align & (align - 1)) == 0);
+	if(align < sizeof(void *))
+		align = sizeof(void *);
+#ifndef CL_POOL_HAS_MMAP
+	flags = 0;
+#endif
+	if(al != &cl_alloc_default)
+		flags = 0;	/* blocks come from the allocator */
+	if(flags & CL_POOL_HUGE)
+		flags |= CL_POOL_MMAP;
+	p->align = align;
+	p->flags = flags;
+	p->o_slot = align;
 	p->n_bytes = s > sizeof(void *) ? s : sizeof(void *);
-	p->n_slots = (4096 - sizeof(void *)) / p->n_bytes;
+	p->n_bytes = (p->n_bytes + align - 1) & ~(align - 1);
+	if(n_block == 0)
+		n_block = 4096;
+	if(flags & CL_POOL_HUGE)
+		n_block = (n_block + CL_POOL_HUGE_PAGE - 1) &
+			~(size_t)(CL_POOL_HUGE_PAGE - 1);
+	p->n_slots = 0;
+	if(n_block > p->o_slot)
+		p->n_slots = (n_block - p->o_slot) / p->n_bytes;
 	if(p->n_slots < 8)
 		p->n_slots = 8;
+	p->n_block = p->o_slot + (size_t)p->n_bytes * p->n_slots;
 	p->block_head = NULL;
 	p->block_free = NULL;
 	p->free_head = NULL;
+	p->al = al;
+	p->n_blocks = 0;
+	p->n_spare = 0;
+	p->n_live = 0;
+	p->n_high = 0;
 	return p;
 }
 
+/** Create a memory pool with block options.
+ *
+ * @param s Size of each object (in bytes).
+ * @param align Alignment of each object, a power of 2 up to 64 (or 0).
+ * @param n_block Size of each block (in bytes), or 0 for the default.
+ * @param flags CL_POOL_MMAP to map blocks with mmap, CL_POOL_HUGE to also
+ *              try huge pages (blocks are rounded up to 2 MB).
+ * @return Pointer to the memory pool.
+ */
+struct cl_pool *cl_pool_create_ex(uint32_t s, uint32_t align, size_t n_block,
+	uint32_t flags)
+{
+	return cl_pool_init(s, align, n_block, flags, &cl_alloc_default);
+}
+
+/** Create a memory pool with an allocator.
+ *
+ * @param s Size of each object (in bytes).
+ * @param al Allocator for the pool and its blocks.
+ * @return Pointer to the memory pool.
+ */
+struct cl_pool *cl_pool_create_with_alloc(uint32_t s,
+	const struct cl_alloc *al)
+{
+	return cl_pool_init(s, 0, 0, 0, al);
+}
+
+/** Create a memory pool in an arena.
+ *
+ * The pool and its blocks are allocated from the arena, and stay there
+ * until the arena is released or reset (destroying the pool is optional).
+ *
+ * @param s Size of each object (in bytes).
+ * @param arena Memory arena.
+ * @return Pointer to the memory pool.
+ */
+struct cl_pool *cl_pool_create_arena(uint32_t s, struct cl_arena *arena) {
+	return cl_pool_create_with_alloc(s, cl_arena_allocator(arena));
+}
+
+/** Allocate memory for a new block.
+ *
+ * Blocks aligned beyond a pointer are over-allocated, with the address for
+ * free kept just before the block.
+ */
+static void **cl_pool_block_new(struct cl_pool *p) {
+	char *m;
+	void **block;
+#ifdef CL_POOL_HAS_MMAP
+	if(p->flags & CL_POOL_MMAP) {
+		m = MAP_FAILED;
+  #ifdef MAP_HUGETLB
+		if(p->flags & CL_POOL_HUGE) {
+			m = mmap(NULL, p->n_block, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		}
+  #endif
+		if(m == MAP_FAILED) {
+			m = mmap(NULL, p->n_block, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(m == MAP_FAILED)
+				return NULL;
+  #ifdef MADV_HUGEPAGE
+			/* No reserved huge pages; ask for transparent ones */
+			if(p->flags & CL_POOL_HUGE)
+				madvise(m, p->n_block, MADV_HUGEPAGE);
+  #endif
+		}
+		return (void **)m;
+	}
+#endif
+	if(p->align <= sizeof(void *))
+		return cl_alloc_malloc(p->al, p->n_block);
+	m = cl_alloc_malloc(p->al, p->n_block + p->align);
+	block = (void **)(m + p->align - ((uintptr_t)m & (p->align - 1)));
+	block[-1] = m;
+	return block;
+}
+
+/** Free memory of one block.
+ */
+static void cl_pool_block_delete(struct cl_pool *p, void **block) {
+#ifdef CL_POOL_HAS_MMAP
+	if(p->flags & CL_POOL_MMAP) {
+		munmap(block, p->n_block);
+		return;
+	}
+#endif
+	if(p->align <= sizeof(void *))
+		cl_alloc_free(p->al, block, p->n_block);
+	else
+		cl_alloc_free(p->al, block[-1], p->n_block + p->align);
+}
+
 /** Free memory of a block list.
  */
 static void cl_pool_block_free(struct cl_pool *p, void **block) {
 	while(block) {
-		void *b = block;
+		void **b = block;
 		block = *block;
-		free(b);
+		cl_pool_block_delete(p, b);
 	}
 }
 
@@ -99,18 +265,7 @@ void cl_pool_destroy(struct cl_pool *p) {
 	p->block_free = NULL;
 	p->free_head = NULL;
 #endif
-	free(p);
-}
-
-/** Get the size of a block.
- *
- * Calculate the size of a block.
- *
- * @param p Memory pool.
- * @return Size of one block.
- */
-static inline size_t cl_pool_block_size(struct cl_pool *p) {
-	return sizeof(void *) + p->n_bytes * p->n_slots;
+	cl_alloc_free(p->al, p, sizeof(struct cl_pool));
 }
 
 /** Allocate a block for the memory pool.
@@ -122,9 +277,10 @@ static void **cl_pool_block_alloc(struct cl_pool *p) {
 	if(p->block_free) {
 		void **block = p->block_free;
 		p->block_free = *block;
+		p->n_spare--;
 		return block;
 	} else
-		return malloc(cl_pool_block_size(p));
+		return cl_pool_block_new(p);
 }
 
 /** Initialize a block.
@@ -135,7 +291,7 @@ static void **cl_pool_block_alloc(struct cl_pool *p) {
  * @param block Block pointer.
  */
 static void cl_pool_block_init(struct cl_pool *p, void **block) {
-	void **slot = cl_pool_block_slot(block);
+	void **slot = cl_pool_block_slot(p, block);
 	char *next = (char *)slot;
 	char *last = next + p->n_bytes * p->n_slots;
 	for(next += p->n_bytes; next < last; next += p->n_bytes) {
@@ -160,7 +316,8 @@ static void cl_pool_add_block(struct cl_pool *p) {
 	assert(block);
 	*block = p->block_head;		/* link to previous block head */
 	p->block_head = block;		/* update block head */
-	p->free_head = cl_pool_block_slot(block);
+	p->n_blocks++;
+	p->free_head = cl_pool_block_slot(p, block);
 	cl_pool_block_init(p, block);
 }
 
@@ -177,6 +334,8 @@ void *cl_pool_alloc(struct cl_pool *p) {
 		cl_pool_add_block(p);
 	slot = p->free_head;
 	p->free_head = *slot;
+	if(++p->n_live > p->n_high)
+		p->n_high = p->n_live;
 	return slot;
 }
 
@@ -191,8 +350,10 @@ void cl_pool_release(struct cl_pool *p, void *m) {
 	void **slot = m;
 
 	assert(m);
+	assert(p->n_live);
 	*slot = p->free_head;	/* link object back to free list */
 	p->free_head = m;	/* update head of free list */
+	p->n_live--;
 }
 
 /** Clear a memory pool.
@@ -211,4 +372,66 @@ void cl_pool_clear(struct cl_pool *p) {
 	}
 	p->block_head = NULL;
 	p->free_head = NULL;
+	p->n_spare += p->n_blocks;
+	p->n_blocks = 0;
+	p->n_live = 0;
+}
+
+/** Reserve blocks in a memory pool.
+ *
+ * Allocate enough free blocks up front so that the next n objects can be
+ * allocated without calling malloc.
+ *
+ * @param p Memory pool.
+ * @param n Number of objects to reserve room for.
+ */
+void cl_pool_reserve(struct cl_pool *p, uint32_t n) {
+	uint32_t n_blocks = (n + p->n_slots - 1) / p->n_slots;
+	void **block;
+
+	for(block = p->block_free; block && n_blocks; block = *block)
+		n_blocks--;
+	while(n_blocks--) {
+		block = cl_pool_block_new(p);
+		assert(block);
+		*block = p->block_free;	/* link to head of free block list */
+		p->block_free = block;	/* update free block head */
+		p->n_spare++;
+	}
+}
+
+/** Shrink a memory pool.
+ *
+ * Free all blocks which are not holding any objects (after a clear).
+ *
+ * @param p Memory pool.
+ */
+void cl_pool_shrink(struct cl_pool *p) {
+	if(p->al->fn_free == NULL)
+		return;		/* keep spare blocks for reuse */
+	cl_pool_block_free(p, p->block_free);
+	p->block_free = NULL;
+	p->n_spare = 0;
+}
+
+/** Add up memory statistics of a memory pool.
+ *
+ * The pool's numbers are added to stats, so that one struct can total all
+ * the pools of an application (clear it first).  Every slot of a block in
+ * use is either a live object or on the free list, so n_free / n_live shows
+ * fragmentation, and an n_live which never drops back shows a leak.
+ *
+ * @param p Memory pool.
+ * @param stats Statistics to add to.
+ */
+void cl_pool_stats(const struct cl_pool *p, struct cl_pool_stats *stats) {
+	stats->n_pools++;
+	stats->n_blocks += p->n_blocks;
+	stats->n_spare += p->n_spare;
+	stats->n_live += p->n_live;
+	stats->n_high += p->n_high;
+	stats->n_free += p->n_blocks * p->n_slots - p->n_live;
+	stats->n_bytes += sizeof(struct cl_pool) +
+		(size_t)(p->n_blocks + p->n_spare) * p->n_block;
+	stats->n_used += (size_t)p->n_live * p->n_bytes;
 }
@@ -0,0 +1,299 @@
+/*
+ * queue.c	Lock-free ring buffer and queue
+ *
+ * Copyright (c) 2007-2016  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_ring_create			Create a single producer ring
+ *	cl_ring_destroy			Destroy a ring
+ *	cl_ring_count			Count the items in a ring
+ *	cl_ring_push			Push an item onto a ring
+ *	cl_ring_pop			Pop an item from a ring
+ *	cl_queue_create			Create a multi-producer queue
+ *	cl_queue_destroy		Destroy a queue
+ *	cl_queue_count			Count the items in a queue
+ *	cl_queue_push			Push an item onto a queue
+ *	cl_queue_pop			Pop an item from a queue
+ */
+/** \file
+ *
+ * Bounded FIFOs of (non-NULL) item pointers for handing work between
+ * threads without a mutex.  They're built on SDL atomics, so this module
+ * needs SDL_atomic.h (it's part of the c2m runtime, which compiles SDL in).
+ *
+ * A ring is for one producer thread and one consumer thread.  Each side
+ * owns one index and only reads the other's, keeping a cached copy so it
+ * only touches the other's cache line when the ring looks full (or empty).
+ *
+ * A queue allows any number of producers and consumers (Dmitry Vyukov's
+ * bounded MPMC queue).  Each cell has a sequence number telling whether it's
+ * ready to be pushed or popped at a given position, so a push or pop is one
+ * CAS on its index plus a write of the cell.
+ *
+ * The indices of both are padded to separate cache lines.  Capacity is
+ * rounded up to a power of 2; push fails when full and pop returns NULL
+ * when empty.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include "SDL_atomic.h"
+#include "clump.h"
+
+/** Size of a cache line (for padding) */
+#define CL_CACHE_LINE 64
+
+/** Ring buffer structure.
+ */
+struct cl_ring {
+	SDL_atomic_t		head;		/**< next slot to pop */
+	uint32_t		tail_cache;	/**< consumer copy of tail */
+	char			pad0[CL_CACHE_LINE - 2 * sizeof(uint32_t)];
+	SDL_atomic_t		tail;		/**< next slot to push */
+	uint32_t		head_cache;	/**< producer copy of head */
+	char			pad1[CL_CACHE_LINE - 2 * sizeof(uint32_t)];
+	uint32_t		mask;		/**< capacity - 1 */
+	void			**slots;	/**< item slots */
+};
+
+/** Queue cell structure.
+ */
+struct cl_queue_cell {
+	SDL_atomic_t		seq;		/**< sequence number */
+	void			*item;		/**< item pointer */
+};
+
+/** Queue structure.
+ */
+struct cl_queue {
+	SDL_atomic_t		head;		/**< next position to pop */
+	char			pad0[CL_CACHE_LINE - sizeof(SDL_atomic_t)];
+	SDL_atomic_t		tail;		/**< next position to push */
+	char			pad1[CL_CACHE_LINE - sizeof(SDL_atomic_t)];
+	uint32_t		mask;		/**< capacity - 1 */
+	struct cl_queue_cell	*cells;		/**< cells */
+};
+
+/** Get a capacity rounded up to a power of 2 */
+static uint32_t cl_queue_capacity(uint32_t n) {
+	uint32_t c = 2;
+	assert(n <= (1u << 30));
+	while(c < n)
+		c <<= 1;
+	return c;
+}
+
+/** Load a position with the given memory order */
+static inline uint32_t cl_atomic_load(const SDL_atomic_t *a,
+	SDL_MemoryOrder order)
+{
+	return (uint32_t)SDL_AtomicLoad((SDL_atomic_t *)a, order);
+}
+
+/** Store a position with the given memory order */
+static inline void cl_atomic_store(SDL_atomic_t *a, uint32_t v,
+	SDL_MemoryOrder order)
+{
+	SDL_AtomicStore(a, (int)v, order);
+}
+
+/** Create a ring buffer.
+ *
+ * Only one thread may push and only one thread may pop.
+ *
+ * @param n Minimum number of items the ring can hold.
+ * @return Pointer to new ring.
+ */
+struct cl_ring *cl_ring_create(uint32_t n) {
+	struct cl_ring *ring = malloc(sizeof(struct cl_ring));
+	uint32_t c = cl_queue_capacity(n);
+	assert(ring);
+	cl_atomic_store(&ring->head, 0, SDL_MEMORY_ORDER_RELAXED);
+	ring->tail_cache = 0;
+	cl_atomic_store(&ring->tail, 0, SDL_MEMORY_ORDER_RELAXED);
+	ring->head_cache = 0;
+	ring->mask = c - 1;
+	ring->slots = malloc(c * sizeof(void *));
+	assert(ring->slots);
+	return ring;
+}
+
+/** Destroy a ring buffer.
+ *
+ * @param ring Pointer to ring.
+ */
+void cl_ring_destroy(struct cl_ring *ring) {
+	assert(ring);
+	free(ring->slots);
+	free(ring);
+}
+
+/** Count the items in a ring buffer.
+ *
+ * Exact only on the producer or consumer thread (as a lower or upper
+ * bound), while the other side is running.
+ *
+ * @param ring Pointer to ring.
+ * @return Number of items in ring.
+ */
+uint32_t cl_ring_count(const struct cl_ring *ring) {
+	return cl_atomic_load(&ring->tail, SDL_MEMORY_ORDER_ACQUIRE) -
+	       cl_atomic_load(&ring->head, SDL_MEMORY_ORDER_ACQUIRE);
+}
+
+/** Push an item onto a ring buffer (producer thread only).
+ *
+ * @param ring Pointer to ring.
+ * @param item Item to push (not NULL).
+ * @return true if item was pushed, false if ring is full.
+ */
+bool cl_ring_push(struct cl_ring *ring, void *item) {
+	uint32_t t = cl_atomic_load(&ring->tail, SDL_MEMORY_ORDER_RELAXED);
+	assert(item);
+	if(t - ring->head_cache > ring->mask) {
+		/* Acquire: the consumer's read of the slot is done */
+		ring->head_cache = cl_atomic_load(&ring->head,
+			SDL_MEMORY_ORDER_ACQUIRE);
+		if(t - ring->head_cache > ring->mask)
+			return false;
+	}
+	ring->slots[t & ring->mask] = item;
+	cl_atomic_store(&ring->tail, t + 1, SDL_MEMORY_ORDER_RELEASE);
+	return true;
+}
+
+/** Pop an item from a ring buffer (consumer thread only).
+ *
+ * @param ring Pointer to ring.
+ * @return Oldest item, or NULL if ring is empty.
+ */
+void *cl_ring_pop(struct cl_ring *ring) {
+	uint32_t h = cl_atomic_load(&ring->head, SDL_MEMORY_ORDER_RELAXED);
+	void *item;
+	if(h == ring->tail_cache) {
+		ring->tail_cache = cl_atomic_load(&ring->tail,
+			SDL_MEMORY_ORDER_ACQUIRE);
+		if(h == ring->tail_cache)
+			return NULL;
+	}
+	item = ring->slots[h & ring->mask];
+	/* Read the slot before the producer can reuse it */
+	cl_atomic_store(&ring->head, h + 1, SDL_MEMORY_ORDER_RELEASE);
+	return item;
+}
+
+/** Create a queue.
+ *
+ * Any number of threads may push and pop.
+ *
+ * @param n Minimum number of items the queue can hold.
+ * @return Pointer to new queue.
+ */
+struct cl_queue *cl_queue_create(uint32_t n) {
+	struct cl_queue *queue = malloc(sizeof(struct cl_queue));
+	uint32_t c = cl_queue_capacity(n);
+	uint32_t i;
+	assert(queue);
+	cl_atomic_store(&queue->head, 0, SDL_MEMORY_ORDER_RELAXED);
+	cl_atomic_store(&queue->tail, 0, SDL_MEMORY_ORDER_RELAXED);
+	queue->mask = c - 1;
+	queue->cells = malloc(c * sizeof(struct cl_queue_cell));
+	assert(queue->cells);
+	for(i = 0; i < c; i++) {
+		cl_atomic_store(&queue->cells[i].seq, i,
+			SDL_MEMORY_ORDER_RELAXED);
+		queue->cells[i].item = NULL;
+	}
+	SDL_AtomicThreadFence(SDL_MEMORY_ORDER_RELEASE);
+	return queue;
+}
+
+/** Destroy a queue.
+ *
+ * @param queue Pointer to queue.
+ */
+void cl_queue_destroy(struct cl_queue *queue) {
+	assert(queue);
+	free(queue->cells);
+	free(queue);
+}
+
+/** Count the items in a queue.
+ *
+ * Only a snapshot while other threads push or pop.
+ *
+ * @param queue Pointer to queue.
+ * @return Number of items in queue.
+ */
+uint32_t cl_queue_count(struct cl_queue *queue) {
+	uint32_t h = cl_atomic_load(&queue->head, SDL_MEMORY_ORDER_RELAXED);
+	uint32_t t = cl_atomic_load(&queue->tail, SDL_MEMORY_ORDER_RELAXED);
+	return (t - h <= queue->mask + 1) ? t - h : 0;
+}
+
+/** Push an item onto a queue.
+ *
+ * @param queue Pointer to queue.
+ * @param item Item to push (not NULL).
+ * @return true if item was pushed, false if queue is full.
+ */
+bool cl_queue_push(struct cl_queue *queue, void *item) {
+	uint32_t pos = cl_atomic_load(&queue->tail, SDL_MEMORY_ORDER_RELAXED);
+	struct cl_queue_cell *cell;
+	assert(item);
+	for(;;) {
+		int32_t dif;
+		int p = (int)pos;
+		cell = &queue->cells[pos & queue->mask];
+		/* Acquire: the last pop's read of the item is done */
+		dif = (int32_t)(cl_atomic_load(&cell->seq,
+			SDL_MEMORY_ORDER_ACQUIRE) - pos);
+		if(dif == 0) {
+			/* Claiming the position orders nothing else */
+			if(SDL_AtomicCompareExchange(&queue->tail, &p, p + 1,
+				SDL_MEMORY_ORDER_RELAXED))
+				break;
+			pos = (uint32_t)p;
+		} else if(dif < 0)
+			return false;
+		else
+			pos = cl_atomic_load(&queue->tail,
+				SDL_MEMORY_ORDER_RELAXED);
+	}
+	cell->item = item;
+	cl_atomic_store(&cell->seq, pos + 1, SDL_MEMORY_ORDER_RELEASE);
+	return true;
+}
+
+/** Pop an item from a queue.
+ *
+ * @param queue Pointer to queue.
+ * @return Oldest item, or NULL if queue is empty.
+ */
+void *cl_queue_pop(struct cl_queue *queue) {
+	uint32_t pos = cl_atomic_load(&queue->head, SDL_MEMORY_ORDER_RELAXED);
+	struct cl_queue_cell *cell;
+	void *item;
+	for(;;) {
+		int32_t dif;
+		int p = (int)pos;
+		cell = &queue->cells[pos & queue->mask];
+		/* Acquire: the push's write of the item is visible */
+		dif = (int32_t)(cl_atomic_load(&cell->seq,
+			SDL_MEMORY_ORDER_ACQUIRE) - (pos + 1));
+		if(dif == 0) {
+			if(SDL_AtomicCompareExchange(&queue->head, &p, p + 1,
+				SDL_MEMORY_ORDER_RELAXED))
+				break;
+			pos = (uint32_t)p;
+		} else if(dif < 0)
+			return NULL;
+		else
+			pos = cl_atomic_load(&queue->head,
+				SDL_MEMORY_ORDER_RELAXED);
+	}
+	item = cell->item;
+	cl_atomic_store(&cell->seq, pos + queue->mask + 1,
+		SDL_MEMORY_ORDER_RELEASE);
+	return item;
+}
@@ -7,16 +7,33 @@
  *
  *	cl_rhash_create_set	Create a hash set
  *	cl_rhash_create_map	Create a hash map
+ *	cl_rhash_create_set_hashed Create a hash set storing hash codes
+ *	cl_rhash_create_map_hashed Create a hash map storing hash codes
+ *	cl_rhash_create_set_inline Create a hash set storing keys in the table
+ *	cl_rhash_create_map_inline Create a hash map storing keys in the table
+ *	cl_rhash_create_set_sized Create a hash set sized for a count
+ *	cl_rhash_create_map_sized Create a hash map sized for a count
+ *	cl_rhash_create_set_with_alloc Create a hash set with an allocator
+ *	cl_rhash_create_map_with_alloc Create a hash map with an allocator
+ *	cl_rhash_seed		Set the hash seed of a hash set or map
+ *	cl_rhash_filter		Put a Bloom filter in front of a hash
  *	cl_rhash_destroy	Destroy a hash set or map
  *	cl_rhash_count		Count the entries in a hash set or map
  *	cl_rhash_contains	Test if a hash contains a key
  *	cl_rhash_peek		Get an arbitrary key
  *	cl_rhash_get		Get a value from a hash map
+ *	cl_rhash_get_many	Get values for a batch of keys from a hash map
  *	cl_rhash_add		Add an entry to a hash set
+ *	cl_rhash_add_many	Add a batch of entries to a hash set
  *	cl_rhash_put		Put a mapping into a hash map
  *	cl_rhash_remove		Remove a key from a hash set or map
  *	cl_rhash_clear		Clear all entries from a hash set or map
+ *	cl_rhash_reserve	Reserve room for entries in a hash
+ *	cl_rhash_shrink_to_fit	Shrink a hash to fit its entries
+ *	cl_rhash_stats		Add up memory statistics of a hash
+ *	cl_rhash_probe_stats	Get probe statistics of a hash
  *	cl_rhash_iterator_create Create a hash key iterator
+ *	cl_rhash_iterator_init Initialize a hash key iterator
  *	cl_rhash_iterator_destroy Destroy a hash key iterator
  *	cl_rhash_iterator_next	Get the next key from an iterator
  *	cl_rhash_iterator_value	Get the value mapped to most recent key
@@ -31,6 +48,41 @@
  * NOTE: some functions can be used with either hash sets or maps, but some
  * must only be used with either sets or maps.
  *
+ *     STORED HASH CODES
+ *
+ * A hash created with cl_rhash_create_set_hashed or cl_rhash_create_map_hashed
+ * stores each key's hash code in its entry (one more pointer-sized word).
+ * The hash code of a key is then calculated once per call, probe costs are
+ * read from the table, keys are only compared when the hash codes are equal
+ * and entries move between the low and high tables without being rehashed.
+ *
+ *     INLINE KEYS
+ *
+ * A hash created with cl_rhash_create_set_inline or cl_rhash_create_map_inline
+ * copies fixed-width keys (up to CL_RHASH_INLINE_BYTES) into the table, so a
+ * lookup only reads the table, not the memory of each probed key.
+ * The first word of an entry is the key's hash code (never 0, as it also marks
+ * the slot used), followed by the value (for maps) and then the key.
+ * Keys returned by cl_rhash_peek and cl_rhash_iterator_next point into the
+ * table, and are only valid until the hash is changed.
+ * Keys returned by cl_rhash_add, cl_rhash_put and cl_rhash_remove are the
+ * caller's key.
+ *
+ *     BATCHES
+ *
+ * cl_rhash_get_many and cl_rhash_add_many work on CL_RHASH_BATCH keys at a
+ * time: every key is hashed and the memory of its first slot prefetched
+ * before any is looked up, so the cache misses of a batch overlap.
+ *
+ *     FILTER
+ *
+ * cl_rhash_filter puts a blocked Bloom filter (see filter.c) in front of the
+ * tables, so a lookup of a key which isn't there usually reads one cache line
+ * instead of probing both tables.  This pays off when most lookups miss.
+ * Bloom filters can't remove keys, so each remove leaves stale bits: once
+ * they add up to half the keys the filter is sized for (or the hash outgrows
+ * it), the filter is rebuilt from the keys in the tables.
+ *
  *     ITERATIVE REHASHING
  *
  * When a hash set or map must be resized, it is done iteratively instead of
@@ -68,6 +120,11 @@
  * threshold, the low table becomes the high table and a new low table is
  * allocated at half the size.
  *
+ * When the number of entries is known up front, a hash created sized for it
+ * (or with room reserved) doesn't resize or move entries while it's filled.
+ * Reserving or shrinking to fit rebuilds the high table at once, with every
+ * entry, and leaves the low table empty.
+ *
  *     ROBIN HOOD HASHING
  *
  * In case of hash collisions, open addressing is used instead of chaining
@@ -111,6 +168,16 @@ static int cl_debug_int(void **ent) {
 }
 #endif
 
+/** Prefetch memory which will be read soon */
+#if defined(__GNUC__)
+#define CL_RHASH_PREFETCH(ptr) __builtin_prefetch(ptr)
+#else
+#define CL_RHASH_PREFETCH(ptr) ((void)(ptr))
+#endif
+
+/** Number of keys hashed and prefetched together */
+#define CL_RHASH_BATCH 16
+
 /** Minimum hash table order */
 static const uint16_t CL_HASH_MIN_ORDER = 6;
 
@@ -126,6 +193,12 @@ struct cl_rhash_table {
 	uint16_t		n_bytes;	/**< number of bytes per entry*/
 	uint16_t		order;		/**< table size order */
 	uint16_t		key_bytes;	/**< key size in bytes */
+	uint16_t		hash_slot;	/**< entry word with hash code,
+						     0 if not stored */
+	uint16_t		key_slot;	/**< entry word with inline key,
+						     0 if not inline */
+	uint64_t		seed;		/**< hash seed */
+	const struct cl_alloc	*al;		/**< allocator of table */
 };
 
 /** Get size of a hash table.
@@ -151,37 +224,36 @@ static void **cl_rhash_table_ptr(struct cl_rhash_table *tbl, uint32_t slot) {
 	return ptr;
 }
 
-/** String hash function.
+/** Get the key of one entry.
  *
- * Simple hash function for a C string.
+ * @param tbl		Pointer to hash table.
+ * @param ent		Pointer to hash entry.
+ * @return Pointer to the key (in the entry for inline keys).
  */
-static uint32_t cl_rhash_table_hash_str(const void *key) {
-	const uint8_t *str = key;
-	uint32_t hash = 5381;
-	int c;
-	while ((c = *str)) {
-		hash = ((hash << 5) + hash) + c;
-		str++;
-	}
-	return hash;
+static void *cl_rhash_table_entry_key(const struct cl_rhash_table *tbl,
+	void **ent)
+{
+	return (tbl->key_slot) ? (void *)(ent + tbl->key_slot) : *ent;
 }
 
-/** Fixed-width hash function.
+/** Calculate the hash code of a key.
  *
- * Simple hash function for a fixed-width key.
+ * @param tbl		Pointer to hash table.
+ * @param key		Pointer to key.
+ * @return Hash code for given key.
  */
-static uint32_t cl_rhash_table_hash_fixed(const void *key, uint16_t key_bytes) {
-	const uint8_t *ptr = key;
-	uint32_t hash = 5381;
-	for (uint16_t i = 0; i < key_bytes; i++) {
-		int c = *ptr;
-		hash = ((hash << 5) + hash) + c;
-		ptr++;
-	}
-	return hash;
+static uint32_t cl_rhash_table_hash_key(const struct cl_rhash_table *tbl,
+	const void *key)
+{
+	size_t n_bytes = (tbl->key_bytes) ? tbl->key_bytes : strlen(key);
+	uint32_t hcode = cl_hash_bytes(key, n_bytes, tbl->seed);
+	/* An inline entry's hash code marks its slot used */
+	return (tbl->key_slot && !hcode) ? 1 : hcode;
 }
 
-/** Calculate a hash code for one entry.
+/** Get the hash code for one entry.
+ *
+ * The stored hash code if the table has them, otherwise it's calculated.
  *
  * @param tbl		Pointer to hash table.
  * @param ent		Pointer to hash entry.
@@ -190,9 +262,11 @@ static uint32_t cl_rhash_table_hash_fixed(const void *key, uint16_t key_bytes) {
 static uint32_t cl_rhash_table_hash(const struct cl_rhash_table *tbl,
 	void **ent)
 {
-	return (tbl->key_bytes)
-	      ? cl_rhash_table_hash_fixed(*ent, tbl->key_bytes)
-	      : cl_rhash_table_hash_str(*ent);
+	if (tbl->key_slot)
+		return (uint32_t)(uintptr_t)*ent;
+	return (tbl->hash_slot)
+	      ? (uint32_t)(uintptr_t)ent[tbl->hash_slot]
+	      : cl_rhash_table_hash_key(tbl, *ent);
 }
 
 /** Get masked hash table slot.
@@ -294,8 +368,17 @@ static void cl_rhash_table_zero(struct cl_rhash_table *tbl) {
  * @param tbl		pointer to hash table.
  */
 static void cl_rhash_table_alloc(struct cl_rhash_table *tbl) {
-	tbl->table = calloc(cl_rhash_table_size(tbl), tbl->n_bytes);
-	assert(tbl->table);
+	tbl->table = cl_alloc_calloc(tbl->al,
+		(size_t)cl_rhash_table_size(tbl) * tbl->n_bytes);
+}
+
+/** Free hash table.
+ *
+ * @param tbl		pointer to hash table.
+ */
+static void cl_rhash_table_free(struct cl_rhash_table *tbl) {
+	cl_alloc_free(tbl->al, tbl->table,
+		(size_t)cl_rhash_table_size(tbl) * tbl->n_bytes);
 }
 
 /** Initialize a hash table.
@@ -303,15 +386,23 @@ static void cl_rhash_table_alloc(struct cl_rhash_table *tbl) {
  * @param tbl		Pointer to hash table.
  * @param key_bytes	Number of bytes in each key (0 for strings).
  * @param n_bytes	Number of bytes per hash table entry.
+ * @param hash_slot	Entry word with the hash code, or 0.
+ * @param key_slot	Entry word with the inline key, or 0.
+ * @param al		Allocator of table.
  */
 static void cl_rhash_table_init(struct cl_rhash_table *tbl, uint16_t key_bytes,
-	uint16_t n_bytes)
+	uint16_t n_bytes, uint16_t hash_slot, uint16_t key_slot,
+	const struct cl_alloc *al)
 {
 	tbl->order = CL_HASH_MIN_ORDER;
 	tbl->n_entries = 0;
 	tbl->n_peek = cl_rhash_table_size(tbl);
 	tbl->key_bytes = key_bytes;
 	tbl->n_bytes = n_bytes;
+	tbl->hash_slot = hash_slot;
+	tbl->key_slot = key_slot;
+	tbl->seed = 0;
+	tbl->al = al;
 	cl_rhash_table_alloc(tbl);
 	cl_rhash_table_debug(tbl, NULL, ' ');
 }
@@ -321,7 +412,7 @@ static void cl_rhash_table_init(struct cl_rhash_table *tbl, uint16_t key_bytes,
  * @param tbl		Pointer to hash table.
  */
 static void cl_rhash_table_destroy(struct cl_rhash_table *tbl) {
-	free(tbl->table);
+	cl_rhash_table_free(tbl);
 #ifndef NDEBUG
 	tbl->table = NULL;
 	tbl->order = 0;
@@ -329,6 +420,8 @@ static void cl_rhash_table_destroy(struct cl_rhash_table *tbl) {
 	tbl->n_peek = 0;
 	tbl->n_bytes = 0;
 	tbl->key_bytes = 0;
+	tbl->hash_slot = 0;
+	tbl->key_slot = 0;
 #endif
 }
 
@@ -340,13 +433,16 @@ static void cl_rhash_table_clone(struct cl_rhash_table *tbl,
 	struct cl_rhash_table *src)
 {
 	assert(tbl->n_entries == 0);
-	free(tbl->table);
+	cl_rhash_table_free(tbl);
 	tbl->table = src->table;
 	tbl->n_entries = src->n_entries;
 	tbl->n_peek = src->n_peek;
 	tbl->n_bytes = src->n_bytes;
 	tbl->order = src->order;
 	tbl->key_bytes = src->key_bytes;
+	tbl->hash_slot = src->hash_slot;
+	tbl->key_slot = src->key_slot;
+	tbl->seed = src->seed;
 }
 
 /** Update one entry in a hash table.
@@ -369,7 +465,7 @@ static void cl_rhash_table_clear(struct cl_rhash_table *tbl) {
 	tbl->n_entries = 0;
 	tbl->n_peek = cl_rhash_table_size(tbl);
 	if (tbl->order != CL_HASH_MIN_ORDER) {
-		free(tbl->table);
+		cl_rhash_table_free(tbl);
 		tbl->order = CL_HASH_MIN_ORDER;
 		cl_rhash_table_alloc(tbl);
 	} else
@@ -423,10 +519,17 @@ static void cl_rhash_table_entry_copy(const struct cl_rhash_table *tbl,
 }
 
 /** Check if two hash table keys are equal.
+ *
+ * With stored hash codes, keys with different ones aren't compared.
  */
 static bool cl_rhash_table_key_equals(const struct cl_rhash_table *tbl,
 	void **key1, void **key2)
 {
+	if (tbl->key_slot)
+		return (*key1 == *key2) && (memcmp(key1 + tbl->key_slot,
+		       key2 + tbl->key_slot, tbl->key_bytes) == 0);
+	if (tbl->hash_slot && key1[tbl->hash_slot] != key2[tbl->hash_slot])
+		return false;
 	return (tbl->key_bytes)
 	      ? (memcmp(*key1, *key2, tbl->key_bytes) == 0)
 	      : (strcmp(*key1, *key2) == 0);
@@ -469,13 +572,15 @@ static void **cl_rhash_table_peek(struct cl_rhash_table *tbl) {
  * The cost of an entry is the probe distance from the initial slot.
  *
  * @param tbl		Pointer to hash table.
- * @param key		Pointer to key to lookup.
+ * @param key		Pointer to entry with key to lookup.
+ * @param hcode		Hash code of the key.
  *
  * @return Pointer to hash table entry, or NULL if not found.
  */
-static void **cl_rhash_table_entry(struct cl_rhash_table *tbl, void **key) {
+static void **cl_rhash_table_lookup(struct cl_rhash_table *tbl, void **key,
+	uint32_t hcode)
+{
 	uint32_t n_size = cl_rhash_table_size(tbl);
-	uint32_t hcode = cl_rhash_table_hash(tbl, key);
 	for (uint32_t pr = 0; pr < n_size; pr++) {
 		uint32_t slot = cl_rhash_table_slot(tbl, hcode, pr);
 		void **e = cl_rhash_table_ptr(tbl, slot);
@@ -489,15 +594,17 @@ static void **cl_rhash_table_entry(struct cl_rhash_table *tbl, void **key) {
 	return NULL;
 }
 
-/** Test if a hash table contains a key.
+/** Prefetch the first slot probed for a hash code.
  *
  * @param tbl		Pointer to hash table.
- * @param key		Key to test for.
- *
- * @return True if hash table contains the key, otherwise false.
+ * @param hcode		Hash code.
  */
-static bool cl_rhash_table_contains(struct cl_rhash_table *tbl, void *key) {
-	return cl_rhash_table_entry(tbl, &key) != NULL;
+static void cl_rhash_table_prefetch(struct cl_rhash_table *tbl,
+	uint32_t hcode)
+{
+	if (tbl->n_entries > 0)
+		CL_RHASH_PREFETCH(cl_rhash_table_ptr(tbl,
+			cl_rhash_table_slot(tbl, hcode, 0)));
 }
 
 /** Count the number of slots to the next empty slot in a hash table.
@@ -651,47 +758,69 @@ enum cl_rhash_table_num {
 	CL_RHASH_TABLE_LO, CL_RHASH_TABLE_HI, CL_RHASH_TABLE_NONE
 };
 
-/** Hash iterator structure.
- */
-struct cl_rhash_iterator {
-	struct cl_rhash		*hash;		/**< hash struct */
-	enum cl_rhash_table_num	n_table;	/**< table number */
-	uint32_t		n_slot;		/**< current slot */
-#ifndef NDEBUG
-	uint32_t		n_edit;		/**< edit version number */
-#endif
-};
-
 /** Hash set/map structure.
  */
 struct cl_rhash {
 	struct cl_rhash_table	h_lo;		/**< low table */
 	struct cl_rhash_table	h_hi;		/**< high table */
 	struct cl_pool		*pool;		/**< hash iterator pool */
+	const struct cl_alloc	*al;		/**< allocator of hash */
 	bool			is_map;		/**< flag for mapping */
+	struct cl_bloom		*filter;	/**< filter of keys, or NULL */
+	uint32_t		filter_bits;	/**< filter bits per key */
+	uint32_t		n_stale;	/**< keys removed since filter
+						     was built */
 #ifndef NDEBUG
 	uint32_t		n_edit;		/**< edit version number */
 #endif
 };
 
+/** Largest entry: hash code, value & inline key */
+#define CL_RHASH_ENTRY_WORDS (2 + CL_RHASH_INLINE_BYTES / sizeof(void *))
+
+/** How hash entries hold keys */
+enum cl_rhash_keys {
+	CL_RHASH_KEYS_POINTER,		/**< pointer to caller's key */
+	CL_RHASH_KEYS_HASHED,		/**< pointer and hash code */
+	CL_RHASH_KEYS_INLINE,		/**< hash code and copy of key */
+};
+
 /** Create a hash set or map.
  *
  * Create a hash set or map, preparing it to be used.
  *
  * @param key_bytes	Number of bytes in each key (0 for strings).
  * @param is_map	True for map, false for set.
+ * @param keys		How entries hold keys.
+ * @param al		Allocator for the hash and its tables.
  * @return Pointer to hash set or map.
  */
-static struct cl_rhash *cl_rhash_create(uint16_t key_bytes, bool is_map) {
-	struct cl_rhash *hash = malloc(sizeof(struct cl_rhash));
-	assert(hash);
-	uint16_t n_bytes = is_map ?
-	                   sizeof(void **) * 2 :
-	                   sizeof(void **);
-	cl_rhash_table_init(&hash->h_lo, key_bytes, n_bytes);
-	cl_rhash_table_init(&hash->h_hi, key_bytes, n_bytes);
-	hash->pool = cl_pool_create(sizeof(struct cl_rhash_iterator));
+static struct cl_rhash *cl_rhash_create(uint16_t key_bytes, bool is_map,
+	enum cl_rhash_keys keys, const struct cl_alloc *al)
+{
+	struct cl_rhash *hash = cl_alloc_malloc(al, sizeof(struct cl_rhash));
+	uint16_t words = is_map ? 2 : 1;
+	uint16_t hash_slot = 0;
+	uint16_t key_slot = 0;
+	if (keys == CL_RHASH_KEYS_HASHED)
+		hash_slot = words++;
+	else if (keys == CL_RHASH_KEYS_INLINE) {
+		assert(key_bytes > 0 && key_bytes <= CL_RHASH_INLINE_BYTES);
+		key_slot = words;
+		words += (key_bytes + sizeof(void *) - 1) / sizeof(void *);
+	}
+	uint16_t n_bytes = sizeof(void **) * words;
+	cl_rhash_table_init(&hash->h_lo, key_bytes, n_bytes, hash_slot,
+		key_slot, al);
+	cl_rhash_table_init(&hash->h_hi, key_bytes, n_bytes, hash_slot,
+		key_slot, al);
+	hash->pool = cl_pool_create_with_alloc(sizeof(struct cl_rhash_iterator),
+		al);
+	hash->al = al;
 	hash->is_map = is_map;
+	hash->filter = NULL;
+	hash->filter_bits = 0;
+	hash->n_stale = 0;
 #ifndef NDEBUG
 	hash->n_edit = 0;
 #endif
@@ -706,7 +835,8 @@ static struct cl_rhash *cl_rhash_create(uint16_t key_bytes, bool is_map) {
  * @return Pointer to hash set.
  */
 struct cl_rhash *cl_rhash_create_set(uint16_t key_bytes) {
-	return cl_rhash_create(key_bytes, false);
+	return cl_rhash_create(key_bytes, false, CL_RHASH_KEYS_POINTER,
+		&cl_alloc_default);
 }
 
 /** Create a hash map.
@@ -717,7 +847,126 @@ struct cl_rhash *cl_rhash_create_set(uint16_t key_bytes) {
  * @return Pointer to hash map.
  */
 struct cl_rhash *cl_rhash_create_map(uint16_t key_bytes) {
-	return cl_rhash_create(key_bytes, true);
+	return cl_rhash_create(key_bytes, true, CL_RHASH_KEYS_POINTER,
+		&cl_alloc_default);
+}
+
+/** Create a hash set storing hash codes.
+ *
+ * Create a hash set which stores the hash code of each key in its entry,
+ * preparing it to be used.
+ *
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @return Pointer to hash set.
+ */
+struct cl_rhash *cl_rhash_create_set_hashed(uint16_t key_bytes) {
+	return cl_rhash_create(key_bytes, false, CL_RHASH_KEYS_HASHED,
+		&cl_alloc_default);
+}
+
+/** Create a hash map storing hash codes.
+ *
+ * Create a hash map which stores the hash code of each key in its entry,
+ * preparing it to be used.
+ *
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @return Pointer to hash map.
+ */
+struct cl_rhash *cl_rhash_create_map_hashed(uint16_t key_bytes) {
+	return cl_rhash_create(key_bytes, true, CL_RHASH_KEYS_HASHED,
+		&cl_alloc_default);
+}
+
+/** Create a hash set storing keys in the table.
+ *
+ * Create a hash set which copies each key into its entry, preparing it to be
+ * used.
+ *
+ * @param key_bytes	Number of bytes in each key (1 to CL_RHASH_INLINE_BYTES).
+ * @return Pointer to hash set.
+ */
+struct cl_rhash *cl_rhash_create_set_inline(uint16_t key_bytes) {
+	return cl_rhash_create(key_bytes, false, CL_RHASH_KEYS_INLINE,
+		&cl_alloc_default);
+}
+
+/** Create a hash map storing keys in the table.
+ *
+ * Create a hash map which copies each key into its entry, preparing it to be
+ * used.
+ *
+ * @param key_bytes	Number of bytes in each key (1 to CL_RHASH_INLINE_BYTES).
+ * @return Pointer to hash map.
+ */
+struct cl_rhash *cl_rhash_create_map_inline(uint16_t key_bytes) {
+	return cl_rhash_create(key_bytes, true, CL_RHASH_KEYS_INLINE,
+		&cl_alloc_default);
+}
+
+/** Create a hash set sized for a number of entries.
+ *
+ * No resizing happens until more than n entries are added.
+ *
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @param n		Expected number of entries.
+ * @return Pointer to hash set.
+ */
+struct cl_rhash *cl_rhash_create_set_sized(uint16_t key_bytes, uint32_t n) {
+	struct cl_rhash *hash = cl_rhash_create_set(key_bytes);
+	cl_rhash_reserve(hash, n);
+	return hash;
+}
+
+/** Create a hash map sized for a number of entries.
+ *
+ * No resizing happens until more than n mappings are added.
+ *
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @param n		Expected number of mappings.
+ * @return Pointer to hash map.
+ */
+struct cl_rhash *cl_rhash_create_map_sized(uint16_t key_bytes, uint32_t n) {
+	struct cl_rhash *hash = cl_rhash_create_map(key_bytes);
+	cl_rhash_reserve(hash, n);
+	return hash;
+}
+
+/** Create a hash set with an allocator.
+ *
+ * @param al		Allocator for the hash and its tables.
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @return Pointer to hash set.
+ */
+struct cl_rhash *cl_rhash_create_set_with_alloc(const struct cl_alloc *al,
+	uint16_t key_bytes)
+{
+	return cl_rhash_create(key_bytes, false, CL_RHASH_KEYS_POINTER, al);
+}
+
+/** Create a hash map with an allocator.
+ *
+ * @param al		Allocator for the hash and its tables.
+ * @param key_bytes	Number of bytes in each key (0 for strings).
+ * @return Pointer to hash map.
+ */
+struct cl_rhash *cl_rhash_create_map_with_alloc(const struct cl_alloc *al,
+	uint16_t key_bytes)
+{
+	return cl_rhash_create(key_bytes, true, CL_RHASH_KEYS_POINTER, al);
+}
+
+/** Set the hash seed of a hash set or map.
+ *
+ * Keys are hashed with the seed (0 by default), so a random seed keeps keys
+ * from picking their hash codes.  It can only be set while empty.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param seed		Hash seed.
+ */
+void cl_rhash_seed(struct cl_rhash *hash, uint64_t seed) {
+	assert(hash->h_lo.n_entries == 0 && hash->h_hi.n_entries == 0);
+	hash->h_lo.seed = seed;
+	hash->h_hi.seed = seed;
 }
 
 /** Check if a hash is a map.
@@ -741,11 +990,53 @@ void cl_rhash_destroy(struct cl_rhash *hash) {
 	cl_rhash_table_destroy(&hash->h_lo);
 	cl_rhash_table_destroy(&hash->h_hi);
 	cl_pool_destroy(hash->pool);
+	if (hash->filter)
+		cl_bloom_destroy(hash->filter);
 #ifndef NDEBUG
 	hash->pool = NULL;
 	hash->n_edit = 0;
 #endif
-	free(hash);
+	cl_alloc_free(hash->al, hash, sizeof(struct cl_rhash));
+}
+
+/** Put a key into a temporary entry.
+ *
+ * The key is copied for inline keys, and its hash code filled in if the hash
+ * stores them.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param tent		Temporary entry.
+ * @param key		Key for the entry.
+ */
+static void cl_rhash_entry_key(const struct cl_rhash *hash, void **tent,
+	const void *key)
+{
+	const struct cl_rhash_table *tbl = &hash->h_hi;
+	if (tbl->key_slot) {
+		memcpy(tent + tbl->key_slot, key, tbl->key_bytes);
+		tent[0] = (void *)(uintptr_t)cl_rhash_table_hash_key(tbl, key);
+		return;
+	}
+	tent[0] = (void *)key;		/* cast away const */
+	if (tbl->hash_slot)
+		tent[tbl->hash_slot] =
+			(void *)(uintptr_t)cl_rhash_table_hash_key(tbl, key);
+}
+
+/** Get the key to return for a found entry.
+ *
+ * An inline key is in a temporary entry or the table, so the caller's
+ * equal key is returned instead.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param key		Caller's key.
+ * @param found		Key found in the table, or NULL.
+ * @return Key to return, or NULL.
+ */
+static const void *cl_rhash_found(const struct cl_rhash *hash,
+	const void *key, const void *found)
+{
+	return (found && hash->h_hi.key_slot) ? key : found;
 }
 
 /** Update hash edit version.
@@ -765,6 +1056,103 @@ uint32_t cl_rhash_count(const struct cl_rhash *hash) {
 	return hash->h_lo.n_entries + hash->h_hi.n_entries;
 }
 
+/** Get the filter code of a hash code.
+ *
+ * @param hcode		Hash code of a key.
+ * @return 64-bit code for the filter.
+ */
+static uint64_t cl_rhash_filter_code(uint32_t hcode) {
+	return cl_hash_mix(hcode);
+}
+
+/** Add the keys of one table to the filter.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param tbl		Pointer to hash table.
+ */
+static void cl_rhash_filter_table(struct cl_rhash *hash,
+	struct cl_rhash_table *tbl)
+{
+	uint32_t n_size = tbl->table ? cl_rhash_table_size(tbl) : 0;
+	uint32_t n_left = tbl->n_entries;
+	for (uint32_t slot = 0; slot < n_size && n_left; slot++) {
+		void **e = cl_rhash_table_ptr(tbl, slot);
+		if (cl_rhash_table_entry_exists(tbl, e)) {
+			cl_bloom_add(hash->filter, cl_rhash_filter_code(
+				cl_rhash_table_hash(tbl, e)));
+			n_left--;
+		}
+	}
+}
+
+/** Build the filter of a hash from its keys.
+ *
+ * The filter is sized for twice the keys in the hash (at least 64).
+ *
+ * @param hash		Pointer to hash set or map.
+ */
+static void cl_rhash_filter_build(struct cl_rhash *hash) {
+	uint32_t n_keys = cl_rhash_count(hash);
+	n_keys = (n_keys < 32) ? 64 : n_keys * 2;
+	if (hash->filter)
+		cl_bloom_destroy(hash->filter);
+	hash->filter = cl_bloom_create(n_keys, hash->filter_bits);
+	hash->n_stale = 0;
+	cl_rhash_filter_table(hash, &hash->h_lo);
+	cl_rhash_filter_table(hash, &hash->h_hi);
+}
+
+/** Put a Bloom filter in front of a hash set or map.
+ *
+ * Lookups of keys which aren't in the hash then usually skip the tables.
+ * At 10 bits per key, about 1% of those lookups probe the tables anyway.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param bits_per_key	Filter bits per key, or 0 to remove the filter.
+ */
+void cl_rhash_filter(struct cl_rhash *hash, uint32_t bits_per_key) {
+	hash->filter_bits = bits_per_key;
+	if (bits_per_key)
+		cl_rhash_filter_build(hash);
+	else if (hash->filter) {
+		cl_bloom_destroy(hash->filter);
+		hash->filter = NULL;
+	}
+}
+
+/** Check if the filter rules out a key.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param hcode		Hash code of the key.
+ * @return true if the key is not in the hash.
+ */
+static bool cl_rhash_filter_miss(const struct cl_rhash *hash, uint32_t hcode) {
+	return hash->filter &&
+	       !cl_bloom_contains(hash->filter, cl_rhash_filter_code(hcode));
+}
+
+/** Add a new entry's key to the filter, rebuilding it when outgrown.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param ent		Pointer to the new entry.
+ */
+static void cl_rhash_filter_add(struct cl_rhash *hash, void **ent) {
+	if (cl_rhash_count(hash) > cl_bloom_capacity(hash->filter))
+		cl_rhash_filter_build(hash);
+	else
+		cl_bloom_add(hash->filter, cl_rhash_filter_code(
+			cl_rhash_table_hash(&hash->h_hi, ent)));
+}
+
+/** Count a removed key, rebuilding the filter when too many are stale.
+ *
+ * @param hash		Pointer to hash set or map.
+ */
+static void cl_rhash_filter_remove(struct cl_rhash *hash) {
+	if (++hash->n_stale > cl_bloom_capacity(hash->filter) / 2)
+		cl_rhash_filter_build(hash);
+}
+
 /** Test if a hash contains a key.
  *
  * Test if a hash (set or map) contains the specified key.
@@ -774,9 +1162,13 @@ uint32_t cl_rhash_count(const struct cl_rhash *hash) {
  * @return True if hash contains the key, otherwise false.
  */
 bool cl_rhash_contains(struct cl_rhash *hash, const void *key) {
-	void *vkey = (void *)key;	/* cast away const */
-	return cl_rhash_table_contains(&hash->h_lo, vkey) ||
-	       cl_rhash_table_contains(&hash->h_hi, vkey);
+	void *tent[CL_RHASH_ENTRY_WORDS];	/* temporary entry */
+	cl_rhash_entry_key(hash, tent, key);
+	uint32_t hcode = cl_rhash_table_hash(&hash->h_hi, tent);
+	if (cl_rhash_filter_miss(hash, hcode))
+		return false;
+	return cl_rhash_table_lookup(&hash->h_lo, tent, hcode) ||
+	       cl_rhash_table_lookup(&hash->h_hi, tent, hcode);
 }
 
 /** Get an arbitrary key.
@@ -790,7 +1182,7 @@ void *cl_rhash_peek(struct cl_rhash *hash) {
 	void **ent = cl_rhash_table_peek(&hash->h_lo);
 	if (!ent)
 		ent = cl_rhash_table_peek(&hash->h_hi);
-	return (ent) ? (*ent) : NULL;
+	return (ent) ? cl_rhash_table_entry_key(&hash->h_hi, ent) : NULL;
 }
 
 /** Get a value from a hash map.
@@ -805,18 +1197,85 @@ void *cl_rhash_peek(struct cl_rhash *hash) {
 const void *cl_rhash_get(struct cl_rhash *hash, const void *key) {
 	if (!cl_rhash_is_map(hash))
 		return NULL;
-	void *vkey = (void *)key;	/* cast away const */
-	void **ent = cl_rhash_table_entry(&hash->h_lo, &vkey);
+	void *tent[CL_RHASH_ENTRY_WORDS];	/* temporary entry */
+	cl_rhash_entry_key(hash, tent, key);
+	uint32_t hcode = cl_rhash_table_hash(&hash->h_hi, tent);
+	if (cl_rhash_filter_miss(hash, hcode))
+		return NULL;
+	void **ent = cl_rhash_table_lookup(&hash->h_lo, tent, hcode);
 	if (ent)
 		return *(ent + 1);
 	else {
-		ent = cl_rhash_table_entry(&hash->h_hi, &vkey);
+		ent = cl_rhash_table_lookup(&hash->h_hi, tent, hcode);
 		if (ent)
 			return *(ent + 1);
 	}
 	return NULL;
 }
 
+/** Hash a batch of keys into temporary entries, prefetching their slots.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param tents		Temporary entries.
+ * @param hcodes	Hash codes of the keys.
+ * @param keys		Keys to hash.
+ * @param n_keys	Number of keys (at most CL_RHASH_BATCH).
+ */
+static void cl_rhash_batch(struct cl_rhash *hash,
+	void *tents[][CL_RHASH_ENTRY_WORDS], uint32_t *hcodes,
+	const void **keys, uint32_t n_keys)
+{
+	for (uint32_t i = 0; i < n_keys; i++) {
+		cl_rhash_entry_key(hash, tents[i], keys[i]);
+		hcodes[i] = cl_rhash_table_hash(&hash->h_hi, tents[i]);
+		cl_rhash_table_prefetch(&hash->h_lo, hcodes[i]);
+		cl_rhash_table_prefetch(&hash->h_hi, hcodes[i]);
+	}
+}
+
+/** Get values for a batch of keys from a hash map.
+ *
+ * Get the values associated with many keys from a hash map, overlapping the
+ * memory accesses of nearby keys.  NOTE: do not use this function for hash
+ * sets.
+ *
+ * @param hash		Pointer to hash map.
+ * @param keys		Keys to look up.
+ * @param values	Values associated with each key (NULL if not found).
+ * @param n_keys	Number of keys.
+ * @return Number of keys found.
+ */
+uint32_t cl_rhash_get_many(struct cl_rhash *hash, const void **keys,
+	const void **values, uint32_t n_keys)
+{
+	void *tents[CL_RHASH_BATCH][CL_RHASH_ENTRY_WORDS];
+	uint32_t hcodes[CL_RHASH_BATCH];
+	uint32_t n_found = 0;
+	if (!cl_rhash_is_map(hash))
+		return 0;
+	for (uint32_t b = 0; b < n_keys; b += CL_RHASH_BATCH) {
+		uint32_t n = n_keys - b;
+		if (n > CL_RHASH_BATCH)
+			n = CL_RHASH_BATCH;
+		cl_rhash_batch(hash, tents, hcodes, keys + b, n);
+		for (uint32_t i = 0; i < n; i++) {
+			if (cl_rhash_filter_miss(hash, hcodes[i])) {
+				values[b + i] = NULL;
+				continue;
+			}
+			void **ent = cl_rhash_table_lookup(&hash->h_lo,
+				tents[i], hcodes[i]);
+			if (!ent)
+				ent = cl_rhash_table_lookup(&hash->h_hi,
+					tents[i], hcodes[i]);
+			values[b + i] = (ent) ? *(ent + 1) : NULL;
+			if (ent)
+				n_found++;
+		}
+	}
+	return n_found;
+}
+
 /** Check if one entry from a hash set or map should be moved higher (from
  * the low table to the high table).
  *
@@ -836,7 +1295,7 @@ static bool cl_rhash_should_move_higher(const struct cl_rhash *hash) {
 static void cl_rhash_move_higher(struct cl_rhash *hash) {
 	void **ent = cl_rhash_table_peek(&hash->h_lo);
 	if (ent) {
-		void *tent[2];		/* temporary entry */
+		void *tent[CL_RHASH_ENTRY_WORDS];	/* temporary entry */
 		cl_rhash_table_entry_copy(&hash->h_lo, tent, ent);
 		void *key = cl_rhash_table_remove(&hash->h_lo, ent);
 		if (key)
@@ -902,6 +1361,8 @@ static void *cl_rhash_insert(struct cl_rhash *hash, void **ent) {
 		if (!key) {
 			cl_rhash_check_move_higher(hash);
 			cl_rhash_check_expand(hash);
+			if (hash->filter)
+				cl_rhash_filter_add(hash, ent);
 		}
 	}
 	cl_rhash_edit(hash);
@@ -921,8 +1382,40 @@ static void *cl_rhash_insert(struct cl_rhash *hash, void **ent) {
 const void *cl_rhash_add(struct cl_rhash *hash, const void *key) {
 	if (cl_rhash_is_map(hash))
 		return key;
-	void *vkey = (void *)key;	/* cast away const */
-	return cl_rhash_insert(hash, &vkey);
+	void *tent[CL_RHASH_ENTRY_WORDS];	/* temporary entry */
+	cl_rhash_entry_key(hash, tent, key);
+	return cl_rhash_found(hash, key, cl_rhash_insert(hash, tent));
+}
+
+/** Add a batch of new entries to a hash set.
+ *
+ * Add many entries into a hash set, overlapping the memory accesses of nearby
+ * keys.  NOTE: do not use this function for hash maps.
+ *
+ * @param hash		Pointer to hash set.
+ * @param keys		Pointers to keys to add.
+ * @param n_keys	Number of keys.
+ * @return Number of keys added (not equal to a key already in the set).
+ */
+uint32_t cl_rhash_add_many(struct cl_rhash *hash, const void **keys,
+	uint32_t n_keys)
+{
+	void *tents[CL_RHASH_BATCH][CL_RHASH_ENTRY_WORDS];
+	uint32_t hcodes[CL_RHASH_BATCH];
+	uint32_t n_added = 0;
+	if (cl_rhash_is_map(hash))
+		return 0;
+	for (uint32_t b = 0; b < n_keys; b += CL_RHASH_BATCH) {
+		uint32_t n = n_keys - b;
+		if (n > CL_RHASH_BATCH)
+			n = CL_RHASH_BATCH;
+		cl_rhash_batch(hash, tents, hcodes, keys + b, n);
+		for (uint32_t i = 0; i < n; i++) {
+			if (!cl_rhash_insert(hash, tents[i]))
+				n_added++;
+		}
+	}
+	return n_added;
 }
 
 /** Add a new mapping to a hash map.
@@ -941,10 +1434,10 @@ const void *cl_rhash_put(struct cl_rhash *hash, const void *key,
 {
 	if (!cl_rhash_is_map(hash))
 		return NULL;
-	void *tent[2];			/* temporary entry */
-	tent[0] = (void *)key;		/* cast away const */
+	void *tent[CL_RHASH_ENTRY_WORDS];	/* temporary entry */
+	cl_rhash_entry_key(hash, tent, key);
 	tent[1] = (void *)value;	/* cast away const */
-	return cl_rhash_insert(hash, tent);
+	return cl_rhash_found(hash, key, cl_rhash_insert(hash, tent));
 }
 
 /** Check if one entry from a hash set or map should be moved lower (from
@@ -965,7 +1458,7 @@ static bool cl_rhash_should_move_lower(const struct cl_rhash *hash) {
 static void cl_rhash_move_lower(struct cl_rhash *hash) {
 	void **ent = cl_rhash_table_peek(&hash->h_hi);
 	if (ent) {
-		void *tent[2];		/* temporary entry */
+		void *tent[CL_RHASH_ENTRY_WORDS];	/* temporary entry */
 		cl_rhash_table_entry_copy(&hash->h_hi, tent, ent);
 		void *key = cl_rhash_table_remove(&hash->h_hi, ent);
 		if (key)
@@ -1025,17 +1518,20 @@ static void cl_rhash_check_shrink(struct cl_rhash *hash) {
  * @return Key removed, or NULL if not found.
  */
 const void *cl_rhash_remove(struct cl_rhash *hash, const void *key) {
-	void *tent[2];		/* temporary entry */
-	tent[0] = (void *)key;	/* cast away const */
-	tent[1] = NULL;
+	void *tent[CL_RHASH_ENTRY_WORDS];	/* temporary entry */
+	cl_rhash_entry_key(hash, tent, key);
+	if (cl_rhash_filter_miss(hash, cl_rhash_table_hash(&hash->h_hi, tent)))
+		return NULL;
 	void *pkey = cl_rhash_table_remove(&hash->h_lo, tent);
 	if (!pkey)
 		pkey = cl_rhash_table_remove(&hash->h_hi, tent);
 	if (pkey) {
 		cl_rhash_check_move_lower(hash);
 		cl_rhash_check_shrink(hash);
+		if (hash->filter)
+			cl_rhash_filter_remove(hash);
 		cl_rhash_edit(hash);
-		return pkey;
+		return cl_rhash_found(hash, key, pkey);
 	} else
 		return NULL;
 }
@@ -1051,9 +1547,183 @@ void cl_rhash_clear(struct cl_rhash *hash) {
 	cl_rhash_table_clear(&hash->h_lo);
 	cl_rhash_table_clear(&hash->h_hi);
 	cl_pool_clear(hash->pool);
+	if (hash->filter) {
+		cl_bloom_clear(hash->filter);
+		hash->n_stale = 0;
+	}
+	cl_rhash_edit(hash);
+}
+
+/** Get the table order for a number of entries.
+ *
+ * @param n		Number of entries.
+ * @return Smallest order of a high table which holds n entries without
+ *         expanding.
+ */
+static uint16_t cl_rhash_order_for(uint32_t n) {
+	uint16_t order = CL_HASH_MIN_ORDER;
+	while (order < CL_HASH_MAX_ORDER &&
+	       (1U << order) - (1U << order) / 4 < n)
+		order++;
+	return order;
+}
+
+/** Move every entry of a table into another.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param src		Pointer to table to move entries from.
+ */
+static void cl_rhash_table_move_all(struct cl_rhash_table *tbl,
+	struct cl_rhash_table *src)
+{
+	uint32_t n_size = cl_rhash_table_size(src);
+	for (uint32_t slot = 0; slot < n_size && src->n_entries; slot++) {
+		void **e = cl_rhash_table_ptr(src, slot);
+		if (cl_rhash_table_entry_exists(src, e)) {
+			cl_rhash_table_insert(tbl, e);
+			src->n_entries--;
+		}
+	}
+}
+
+/** Rebuild a hash set or map.
+ *
+ * Every entry is moved into a new high table, and the low table is replaced
+ * with an empty one half the size.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param order		Order of new high table.
+ */
+static void cl_rhash_rebuild(struct cl_rhash *hash, uint16_t order) {
+	struct cl_rhash_table tbl = hash->h_hi;
+	tbl.order = order;
+	tbl.n_entries = 0;
+	tbl.n_peek = cl_rhash_table_size(&tbl);
+	cl_rhash_table_alloc(&tbl);
+	cl_rhash_table_move_all(&tbl, &hash->h_lo);
+	cl_rhash_table_move_all(&tbl, &hash->h_hi);
+	cl_rhash_table_free(&hash->h_hi);
+	cl_rhash_table_free(&hash->h_lo);
+	hash->h_hi = tbl;
+	hash->h_lo = tbl;
+	if (order > CL_HASH_MIN_ORDER)
+		hash->h_lo.order--;
+	hash->h_lo.n_entries = 0;
+	hash->h_lo.n_peek = cl_rhash_table_size(&hash->h_lo);
+	cl_rhash_table_alloc(&hash->h_lo);
 	cl_rhash_edit(hash);
 }
 
+/** Reserve room for entries in a hash set or map.
+ *
+ * Resize a hash (at once) so that it holds n entries without resizing again.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param n		Number of entries to reserve room for.
+ */
+void cl_rhash_reserve(struct cl_rhash *hash, uint32_t n) {
+	uint16_t order = cl_rhash_order_for(n);
+	if (order < hash->h_hi.order)
+		order = hash->h_hi.order;
+	if (order > hash->h_hi.order || hash->h_lo.n_entries > 0)
+		cl_rhash_rebuild(hash, order);
+}
+
+/** Shrink a hash set or map to fit its entries.
+ *
+ * Resize a hash (at once) to the smallest table which holds its entries.
+ *
+ * @param hash		Pointer to hash set or map.
+ */
+void cl_rhash_shrink_to_fit(struct cl_rhash *hash) {
+	uint16_t order = cl_rhash_order_for(cl_rhash_count(hash));
+	if (order < hash->h_hi.order || hash->h_lo.n_entries > 0)
+		cl_rhash_rebuild(hash, order);
+}
+
+/** Add up memory statistics of a hash table.
+ */
+static void cl_rhash_table_stats(const struct cl_rhash_table *tbl,
+	struct cl_pool_stats *stats)
+{
+	if (tbl->table) {
+		uint32_t n_size = cl_rhash_table_size(tbl);
+		stats->n_blocks++;
+		stats->n_live += tbl->n_entries;
+		stats->n_high += tbl->n_entries;
+		stats->n_free += n_size - tbl->n_entries;
+		stats->n_bytes += (size_t)n_size * tbl->n_bytes;
+		stats->n_used += (size_t)tbl->n_entries * tbl->n_bytes;
+	}
+}
+
+/** Add up memory statistics of a hash set or map.
+ *
+ * Each table counts as a block, with entries as live objects and empty
+ * slots as free.  The iterator pool is added too.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param stats		Statistics to add to (see cl_pool_stats).
+ */
+void cl_rhash_stats(const struct cl_rhash *hash, struct cl_pool_stats *stats)
+{
+	cl_pool_stats(hash->pool, stats);
+	stats->n_bytes += sizeof(struct cl_rhash);
+	if (hash->filter)
+		stats->n_bytes += cl_bloom_bytes(hash->filter);
+	cl_rhash_table_stats(&hash->h_lo, stats);
+	cl_rhash_table_stats(&hash->h_hi, stats);
+}
+
+/** Get probe statistics of one table.
+ *
+ * @param tbl		Pointer to hash table.
+ * @param pt		Statistics to fill in.
+ */
+static void cl_rhash_table_probe_stats(const struct cl_rhash_table *tbl,
+	struct cl_probe_table *pt)
+{
+	/* Only reads the table */
+	struct cl_rhash_table *t = (struct cl_rhash_table *)tbl;
+	memset(pt, 0, sizeof(struct cl_probe_table));
+	if (!tbl->table)
+		return;
+	pt->n_size = cl_rhash_table_size(tbl);
+	pt->n_entries = tbl->n_entries;
+	for (uint32_t i = 0; i < pt->n_size && tbl->n_entries; i++) {
+		void **e = cl_rhash_table_ptr(t, i);
+		if (cl_rhash_table_entry_exists(tbl, e)) {
+			uint32_t pr = cl_rhash_table_cost(t, i);
+			if (pr > pt->n_max)
+				pt->n_max = pr;
+			pt->n_total += pr;
+			pt->hist[pr < CL_PROBE_BUCKETS ? pr
+			        : CL_PROBE_BUCKETS - 1]++;
+		}
+	}
+}
+
+/** Get probe statistics of a hash set or map.
+ *
+ * The tables are scanned when called (nothing is counted as the hash is
+ * used), so this costs one pass over the slots, and hashing each key unless
+ * hash codes are stored.  Entries move from the low to the high table while
+ * growing, and back while shrinking; n_migrate is the entries in the smaller
+ * of the two, the fewest moves before one can be dropped.
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param stats		Statistics to fill in.
+ */
+void cl_rhash_probe_stats(const struct cl_rhash *hash,
+	struct cl_probe_stats *stats)
+{
+	uint32_t n_lo = hash->h_lo.table ? hash->h_lo.n_entries : 0;
+	uint32_t n_hi = hash->h_hi.n_entries;
+	cl_rhash_table_probe_stats(&hash->h_lo, &stats->lo);
+	cl_rhash_table_probe_stats(&hash->h_hi, &stats->hi);
+	stats->n_migrate = n_lo < n_hi ? n_lo : n_hi;
+}
+
 /** Create a hash iterator.
  *
  * @param hash Pointer to hash set or map.
@@ -1061,14 +1731,28 @@ void cl_rhash_clear(struct cl_rhash *hash) {
  */
 struct cl_rhash_iterator *cl_rhash_iterator_create(struct cl_rhash *hash) {
 	struct cl_rhash_iterator *it = cl_pool_alloc(hash->pool);
+	cl_rhash_iterator_init(it, hash);
+	return it;
+}
+
+/** Initialize a hash iterator.
+ *
+ * Initialize a caller's iterator (which can be on the stack).  It doesn't
+ * need to be destroyed.
+ *
+ * @param it The iterator.
+ * @param hash Pointer to hash set or map.
+ */
+void cl_rhash_iterator_init(struct cl_rhash_iterator *it, struct cl_rhash *hash) {
 	assert(hash);
 	it->hash = hash;
 	it->n_table = CL_RHASH_TABLE_LO;
 	it->n_slot = hash->h_lo.n_peek - 1;
 #ifndef NDEBUG
 	it->n_edit = hash->n_edit;
+#else
+	it->n_edit = 0;
 #endif
-	return it;
 }
 
 /** Destroy a hash iterator.
@@ -1187,7 +1871,7 @@ const void *cl_rhash_iterator_next(struct cl_rhash_iterator *it) {
 		cl_rhash_iterator_next_slot(it);
 		void **ent = cl_rhash_iterator_entry(it);
 		if (ent)
-			return *ent;
+			return cl_rhash_table_entry_key(&it->hash->h_hi, ent);
 	}
 	return NULL;
 }
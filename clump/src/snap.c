@@ -0,0 +1,597 @@
+/*
+ * snap.c	Read-only snapshots of hash and tree maps
+ *
+ * Copyright (c) 2012  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_snap_write_rhash	Write a snapshot of a hash set or map
+ *	cl_snap_write_tree	Write a snapshot of a tree set or map
+ *	cl_snap_write_btree	Write a snapshot of a B-tree set or map
+ *	cl_snap_open		Open a snapshot
+ *	cl_snap_close		Close a snapshot
+ *	cl_snap_count		Count the entries in a snapshot
+ *	cl_snap_contains	Test if a snapshot contains a key
+ *	cl_snap_get		Get a value from a snapshot
+ *	cl_snap_seek		Find the first key not less than a key
+ *	cl_snap_key		Get the key of an entry
+ *	cl_snap_value		Get the value of an entry
+ */
+/** \file
+ *
+ * A snapshot is a file holding the entries of a set or map, laid out so it
+ * can be mapped (with mmap) and queried in place: there is no load step,
+ * and pages are faulted in as lookups touch them.  It holds no pointers,
+ * only offsets from the start of the file, so it can be mapped anywhere.
+ *
+ * Each entry is a record of key_bytes of key, then value_bytes of value
+ * (copied from the memory each value points to), each padded to 8 bytes so
+ * a value can be read in place as the struct it was copied from.  A key
+ * size of 0 means int keys, as in int trees and maps using cl_compare_int:
+ * the "pointer" is the int, which is stored in 4 bytes.
+ *
+ * A tree snapshot has its records in key order, searched with a binary
+ * search using the compare function given to cl_snap_open (which must order
+ * keys as the tree did).  A hash snapshot has its records in iteration
+ * order, followed by an index of 1 << order slots (at most half full),
+ * each the number of a record + 1, or 0 if empty.  A key is in the slot of
+ * its hash code (cl_hash_bytes of the key, seed 0), or found by linear
+ * probing from there.
+ *
+ *	HEADER (64 bytes) | RECORDS | INDEX (hash snapshots only)
+ *
+ * Snapshots use the byte order of the machine which wrote them; one from
+ * the other byte order fails to open.
+ */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE		/* fileno, mmap with -std=c99 */
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clump.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CL_SNAP_HAS_MMAP
+#endif
+
+/** Magic number of a snapshot ("CLSNAP01" in the writer's byte order) */
+#define CL_SNAP_MAGIC		0x313050414E534C43ULL
+
+/** Snapshot format version */
+#define CL_SNAP_VERSION		1
+
+/** Snapshot flags */
+#define CL_SNAP_SORTED		(1 << 0)	/**< records in key order */
+#define CL_SNAP_HASHED		(1 << 1)	/**< records have an index */
+#define CL_SNAP_INT_KEYS	(1 << 2)	/**< keys are ints */
+
+/** Snapshot file header.
+ */
+struct cl_snap_header {
+	uint64_t	magic;		/**< CL_SNAP_MAGIC */
+	uint32_t	version;	/**< CL_SNAP_VERSION */
+	uint32_t	flags;		/**< snapshot flags */
+	uint32_t	key_bytes;	/**< bytes of key in a record */
+	uint32_t	value_bytes;	/**< bytes of value in a record */
+	uint32_t	n_record;	/**< bytes per record (padded) */
+	uint32_t	n_entries;	/**< number of records */
+	uint32_t	order;		/**< index size order (hashed) */
+	uint32_t	value_off;	/**< offset of value in a record */
+	uint64_t	off_records;	/**< file offset of records */
+	uint64_t	off_index;	/**< file offset of index (hashed) */
+	uint64_t	n_bytes;	/**< file size */
+};
+
+/** Snapshot (read-only view) structure.
+ */
+struct cl_snap {
+	void			*map;		/**< mapped (or read) file */
+	size_t			n_map;		/**< bytes mapped */
+	bool			is_mapped;	/**< map is from mmap */
+	const struct cl_snap_header *hdr;	/**< file header */
+	const uint8_t		*records;	/**< first record */
+	const uint32_t		*index;		/**< hash index, or NULL */
+	cl_compare_cb		*fn_compare;	/**< key compare function */
+};
+
+/** Snapshot writer structure.
+ */
+struct cl_snap_writer {
+	FILE			*fp;		/**< output file */
+	struct cl_snap_header	hdr;		/**< header being written */
+	uint8_t			*rec;		/**< record buffer */
+	uint32_t		*hcodes;	/**< hash code of each record */
+	uint32_t		n_max;		/**< max records (hashed) */
+	bool			failed;		/**< write error */
+};
+
+/** Get the size of a key in a record.
+ */
+static uint32_t cl_snap_key_size(uint16_t key_bytes) {
+	return key_bytes ? key_bytes : sizeof(int32_t);
+}
+
+/** Start writing a snapshot.
+ *
+ * @param w		Writer to initialize.
+ * @param path		Path of file to write.
+ * @param flags		Snapshot flags.
+ * @param key_bytes	Bytes in each key (0 for int keys).
+ * @param value_bytes	Bytes in each value (0 for sets).
+ * @param n_max		Most entries which will be added.
+ * @return true on success, false if the file can't be created.
+ */
+static bool cl_snap_writer_init(struct cl_snap_writer *w, const char *path,
+	uint32_t flags, uint16_t key_bytes, uint16_t value_bytes,
+	uint32_t n_max)
+{
+	uint32_t n_key = cl_snap_key_size(key_bytes);
+
+	memset(&w->hdr, 0, sizeof(struct cl_snap_header));
+	w->hdr.magic = CL_SNAP_MAGIC;
+	w->hdr.version = CL_SNAP_VERSION;
+	w->hdr.flags = flags | (key_bytes ? 0 : CL_SNAP_INT_KEYS);
+	w->hdr.key_bytes = n_key;
+	w->hdr.value_bytes = value_bytes;
+	w->hdr.value_off = (n_key + 7) & ~7u;
+	w->hdr.n_record = value_bytes
+	                ? (w->hdr.value_off + value_bytes + 7) & ~7u
+	                : w->hdr.value_off;
+	w->hdr.off_records = sizeof(struct cl_snap_header);
+	w->n_max = n_max;
+	w->failed = false;
+	w->fp = fopen(path, "wb");
+	if(w->fp == NULL)
+		return false;
+	w->rec = calloc(1, w->hdr.n_record);
+	assert(w->rec);
+	if(flags & CL_SNAP_HASHED) {
+		w->hcodes = malloc(sizeof(uint32_t) * (n_max ? n_max : 1));
+		assert(w->hcodes);
+	} else
+		w->hcodes = NULL;
+	/* Header is written again when finished */
+	if(fwrite(&w->hdr, sizeof(struct cl_snap_header), 1, w->fp) != 1)
+		w->failed = true;
+	return true;
+}
+
+/** Add a record to a snapshot.
+ *
+ * @param w		Snapshot writer.
+ * @param key		Key (int value for int keys).
+ * @param value		Value (ignored for sets).
+ */
+static void cl_snap_writer_add(struct cl_snap_writer *w, const void *key,
+	const void *value)
+{
+	const struct cl_snap_header *hdr = &w->hdr;
+	if(hdr->flags & CL_SNAP_INT_KEYS) {
+		int32_t k = (int32_t)(intptr_t)key;
+		memcpy(w->rec, &k, sizeof(k));
+	} else
+		memcpy(w->rec, key, hdr->key_bytes);
+	if(hdr->value_bytes) {
+		assert(value);
+		memcpy(w->rec + hdr->value_off, value, hdr->value_bytes);
+	}
+	if(w->hcodes) {
+		assert(hdr->n_entries < w->n_max);
+		w->hcodes[hdr->n_entries] = cl_hash_bytes(w->rec,
+			hdr->key_bytes, 0);
+	}
+	if(fwrite(w->rec, hdr->n_record, 1, w->fp) != 1)
+		w->failed = true;
+	w->hdr.n_entries++;
+}
+
+/** Write the hash index of a snapshot.
+ */
+static void cl_snap_writer_index(struct cl_snap_writer *w) {
+	struct cl_snap_header *hdr = &w->hdr;
+	uint32_t order = 1;
+	uint32_t *index;
+	uint32_t mask;
+
+	while(order < 31 && (1u << order) < 2 * (uint64_t)hdr->n_entries)
+		order++;
+	hdr->order = order;
+	hdr->off_index = (hdr->off_records +
+		(uint64_t)hdr->n_entries * hdr->n_record + 7) & ~(uint64_t)7;
+	mask = (1u << order) - 1;
+	index = calloc((size_t)1 << order, sizeof(uint32_t));
+	assert(index);
+	for(uint32_t i = 0; i < hdr->n_entries; i++) {
+		uint32_t slot = w->hcodes[i] & mask;
+		while(index[slot])
+			slot = (slot + 1) & mask;
+		index[slot] = i + 1;
+	}
+	/* Records are padded to 8 bytes, so the index follows them */
+	if(fwrite(index, sizeof(uint32_t), (size_t)1 << order, w->fp) !=
+	   (size_t)1 << order)
+		w->failed = true;
+	free(index);
+}
+
+/** Finish writing a snapshot.
+ *
+ * @param w		Snapshot writer.
+ * @return true on success, false on a write error.
+ */
+static bool cl_snap_writer_finish(struct cl_snap_writer *w) {
+	struct cl_snap_header *hdr = &w->hdr;
+
+	if(hdr->flags & CL_SNAP_HASHED)
+		cl_snap_writer_index(w);
+	hdr->n_bytes = ftell(w->fp);
+	if(fseek(w->fp, 0, SEEK_SET) != 0 ||
+	   fwrite(hdr, sizeof(struct cl_snap_header), 1, w->fp) != 1)
+		w->failed = true;
+	if(fclose(w->fp) != 0)
+		w->failed = true;
+	free(w->rec);
+	free(w->hcodes);
+	return !w->failed;
+}
+
+/** Write a snapshot of a hash set or map.
+ *
+ * The hash must have fixed-width keys (not strings).
+ *
+ * @param hash		Pointer to hash set or map.
+ * @param key_bytes	Bytes in each key (as the hash was created with).
+ * @param value_bytes	Bytes to copy from each value, or 0 for a set.
+ * @param path		Path of file to write.
+ * @return true on success, false on an I/O error.
+ */
+bool cl_snap_write_rhash(struct cl_rhash *hash, uint16_t key_bytes,
+	uint16_t value_bytes, const char *path)
+{
+	struct cl_snap_writer w;
+	struct cl_rhash_iterator it;
+	const void *key;
+
+	assert(key_bytes > 0);
+	if(!cl_snap_writer_init(&w, path, CL_SNAP_HASHED, key_bytes,
+		value_bytes, cl_rhash_count(hash)))
+		return false;
+	CL_RHASH_FOREACH(it, hash, key) {
+		cl_snap_writer_add(&w, key, value_bytes ?
+			cl_rhash_iterator_value(&it) : NULL);
+	}
+	return cl_snap_writer_finish(&w);
+}
+
+/** Write a snapshot of a tree set or map.
+ *
+ * @param tree		The tree.
+ * @param key_bytes	Bytes in each key, or 0 for int keys (cl_compare_int).
+ * @param value_bytes	Bytes to copy from each value, or 0 for a set.
+ * @param path		Path of file to write.
+ * @return true on success, false on an I/O error.
+ */
+bool cl_snap_write_tree(struct cl_tree *tree, uint16_t key_bytes,
+	uint16_t value_bytes, const char *path)
+{
+	struct cl_snap_writer w;
+	struct cl_tree_iterator it;
+	const void *key;
+
+	if(!cl_snap_writer_init(&w, path, CL_SNAP_SORTED, key_bytes,
+		value_bytes, cl_tree_count(tree)))
+		return false;
+	CL_TREE_FOREACH(it, tree, key) {
+		cl_snap_writer_add(&w, key, value_bytes ?
+			cl_tree_iterator_value(&it) : NULL);
+	}
+	return cl_snap_writer_finish(&w);
+}
+
+/** Write a snapshot of a B-tree set or map.
+ *
+ * @param tree		The tree.
+ * @param key_bytes	Bytes in each key, or 0 for int keys (an int tree).
+ * @param value_bytes	Bytes to copy from each value, or 0 for a set.
+ * @param path		Path of file to write.
+ * @return true on success, false on an I/O error.
+ */
+bool cl_snap_write_btree(struct cl_btree *tree, uint16_t key_bytes,
+	uint16_t value_bytes, const char *path)
+{
+	struct cl_snap_writer w;
+	struct cl_btree_iterator it;
+	const void *key;
+
+	if(!cl_snap_writer_init(&w, path, CL_SNAP_SORTED, key_bytes,
+		value_bytes, cl_btree_count(tree)))
+		return false;
+	CL_BTREE_FOREACH(it, tree, key) {
+		cl_snap_writer_add(&w, key, value_bytes ?
+			cl_btree_iterator_value(&it) : NULL);
+	}
+	return cl_snap_writer_finish(&w);
+}
+
+/** Map a snapshot file into memory.
+ *
+ * @param snap		Snapshot.
+ * @param path		Path of file.
+ * @return true on success.
+ */
+static bool cl_snap_map(struct cl_snap *snap, const char *path) {
+#ifdef CL_SNAP_HAS_MMAP
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return false;
+	if(fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+	snap->n_map = st.st_size;
+	snap->map = mmap(NULL, snap->n_map, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(snap->map == MAP_FAILED)
+		return false;
+	snap->is_mapped = true;
+	return true;
+#else
+	FILE *fp = fopen(path, "rb");
+	long n;
+	if(fp == NULL)
+		return false;
+	if(fseek(fp, 0, SEEK_END) != 0 || (n = ftell(fp)) <= 0 ||
+	   fseek(fp, 0, SEEK_SET) != 0)
+	{
+		fclose(fp);
+		return false;
+	}
+	snap->n_map = n;
+	snap->map = malloc(snap->n_map);
+	assert(snap->map);
+	snap->is_mapped = false;
+	if(fread(snap->map, snap->n_map, 1, fp) != 1) {
+		fclose(fp);
+		free(snap->map);
+		return false;
+	}
+	fclose(fp);
+	return true;
+#endif
+}
+
+/** Unmap a snapshot file.
+ */
+static void cl_snap_unmap(struct cl_snap *snap) {
+#ifdef CL_SNAP_HAS_MMAP
+	if(snap->is_mapped) {
+		munmap(snap->map, snap->n_map);
+		return;
+	}
+#endif
+	free(snap->map);
+}
+
+/** Check the header of a snapshot.
+ *
+ * @param snap		Snapshot.
+ * @return true if the header is valid for the mapped size.
+ */
+static bool cl_snap_check(const struct cl_snap *snap) {
+	const struct cl_snap_header *hdr = snap->hdr;
+	uint64_t n_records;
+
+	if(snap->n_map < sizeof(struct cl_snap_header) ||
+	   hdr->magic != CL_SNAP_MAGIC || hdr->version != CL_SNAP_VERSION ||
+	   hdr->n_bytes != snap->n_map || hdr->n_record == 0 ||
+	   hdr->n_record % 8 != 0 ||
+	   hdr->key_bytes > hdr->value_off ||
+	   hdr->value_off + hdr->value_bytes > hdr->n_record)
+		return false;
+	n_records = (uint64_t)hdr->n_entries * hdr->n_record;
+	if(hdr->off_records != sizeof(struct cl_snap_header) ||
+	   hdr->off_records + n_records > hdr->n_bytes)
+		return false;
+	if(hdr->flags & CL_SNAP_HASHED) {
+		if(hdr->order < 1 || hdr->order > 31 ||
+		   hdr->off_index < hdr->off_records + n_records ||
+		   hdr->off_index % 8 != 0 ||
+		   hdr->off_index + ((uint64_t)4 << hdr->order) >
+		   hdr->n_bytes ||
+		   (1u << hdr->order) < hdr->n_entries)
+			return false;
+	}
+	return true;
+}
+
+/** Open a snapshot.
+ *
+ * The file is mapped read-only (on systems with mmap; elsewhere it's read
+ * into memory).  It must not be changed while the snapshot is open.
+ *
+ * @param path		Path of snapshot file.
+ * @param fn_compare	Function which orders keys as the tree written did,
+ *			or NULL to compare bytes with memcmp (or ints for
+ *			int keys).  Unused for hash snapshots.
+ * @return Pointer to the snapshot, or NULL if it can't be opened or isn't
+ *	   a valid snapshot.
+ */
+struct cl_snap *cl_snap_open(const char *path, cl_compare_cb *fn_compare) {
+	struct cl_snap *snap = malloc(sizeof(struct cl_snap));
+	assert(snap);
+	if(!cl_snap_map(snap, path)) {
+		free(snap);
+		return NULL;
+	}
+	snap->hdr = snap->map;
+	if(!cl_snap_check(snap)) {
+		cl_snap_unmap(snap);
+		free(snap);
+		return NULL;
+	}
+	snap->records = (const uint8_t *)snap->map + snap->hdr->off_records;
+	snap->index = (snap->hdr->flags & CL_SNAP_HASHED)
+	            ? (const uint32_t *)((const uint8_t *)snap->map +
+	              snap->hdr->off_index)
+	            : NULL;
+	if(fn_compare == NULL && (snap->hdr->flags & CL_SNAP_INT_KEYS))
+		fn_compare = cl_compare_int;
+	snap->fn_compare = fn_compare;
+	return snap;
+}
+
+/** Close a snapshot.
+ *
+ * Keys and values from the snapshot are no longer valid.
+ *
+ * @param snap		Snapshot.
+ */
+void cl_snap_close(struct cl_snap *snap) {
+	assert(snap);
+	cl_snap_unmap(snap);
+#ifndef NDEBUG
+	snap->map = NULL;
+	snap->hdr = NULL;
+	snap->records = NULL;
+	snap->index = NULL;
+#endif
+	free(snap);
+}
+
+/** Count the entries in a snapshot.
+ *
+ * @param snap		Snapshot.
+ * @return Number of entries.
+ */
+uint32_t cl_snap_count(const struct cl_snap *snap) {
+	return snap->hdr->n_entries;
+}
+
+/** Get a record of a snapshot.
+ */
+static const uint8_t *cl_snap_record(const struct cl_snap *snap, uint32_t i) {
+	return snap->records + (size_t)i * snap->hdr->n_record;
+}
+
+/** Get the key of an entry.
+ *
+ * @param snap		Snapshot.
+ * @param i		Entry number (key order for tree snapshots).
+ * @return Pointer to the key in the snapshot, or the int for int keys.
+ */
+const void *cl_snap_key(const struct cl_snap *snap, uint32_t i) {
+	const uint8_t *rec = cl_snap_record(snap, i);
+	assert(i < snap->hdr->n_entries);
+	if(snap->hdr->flags & CL_SNAP_INT_KEYS) {
+		int32_t k;
+		memcpy(&k, rec, sizeof(k));
+		return (const void *)(long)k;
+	}
+	return rec;
+}
+
+/** Get the value of an entry.
+ *
+ * @param snap		Snapshot.
+ * @param i		Entry number.
+ * @return Pointer to the value in the snapshot, or NULL for sets.
+ */
+const void *cl_snap_value(const struct cl_snap *snap, uint32_t i) {
+	assert(i < snap->hdr->n_entries);
+	return snap->hdr->value_bytes
+	     ? cl_snap_record(snap, i) + snap->hdr->value_off
+	     : NULL;
+}
+
+/** Compare the key of an entry with another key.
+ */
+static cl_compare_t cl_snap_compare(const struct cl_snap *snap, uint32_t i,
+	const void *key)
+{
+	const void *k = cl_snap_key(snap, i);
+	if(snap->fn_compare)
+		return snap->fn_compare(k, key);
+	else {
+		int c = memcmp(k, key, snap->hdr->key_bytes);
+		return c < 0 ? CL_LESS : c > 0 ? CL_GREATER : CL_EQUAL;
+	}
+}
+
+/** Find the first entry with a key not less than a key.
+ *
+ * Only for tree snapshots (their entries are in key order).
+ *
+ * @param snap		Snapshot.
+ * @param key		Key to seek.
+ * @return Entry number, or the count if all keys are less.
+ */
+uint32_t cl_snap_seek(const struct cl_snap *snap, const void *key) {
+	uint32_t lo = 0;
+	uint32_t hi = snap->hdr->n_entries;
+	assert(snap->hdr->flags & CL_SNAP_SORTED);
+	while(lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if(cl_snap_compare(snap, mid, key) == CL_LESS)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/** Find the entry of a key.
+ *
+ * @param snap		Snapshot.
+ * @param key		Key to find.
+ * @return Entry number, or the count if not found.
+ */
+static uint32_t cl_snap_find(const struct cl_snap *snap, const void *key) {
+	const struct cl_snap_header *hdr = snap->hdr;
+
+	if(snap->index) {
+		uint32_t mask = (1u << hdr->order) - 1;
+		uint32_t slot = cl_hash_bytes(key, hdr->key_bytes, 0) & mask;
+		for(uint32_t pr = 0; pr <= mask; pr++) {
+			uint32_t n = snap->index[slot];
+			if(n == 0 || n > hdr->n_entries)
+				break;
+			if(memcmp(cl_snap_record(snap, n - 1), key,
+				hdr->key_bytes) == 0)
+				return n - 1;
+			slot = (slot + 1) & mask;
+		}
+	} else {
+		uint32_t i = cl_snap_seek(snap, key);
+		if(i < hdr->n_entries && cl_snap_compare(snap, i, key) ==
+		   CL_EQUAL)
+			return i;
+	}
+	return hdr->n_entries;
+}
+
+/** Test if a snapshot contains a key.
+ *
+ * @param snap		Snapshot.
+ * @param key		Key to test for.
+ * @return true if the key is in the snapshot.
+ */
+bool cl_snap_contains(const struct cl_snap *snap, const void *key) {
+	return cl_snap_find(snap, key) < snap->hdr->n_entries;
+}
+
+/** Get a value from a snapshot of a map.
+ *
+ * @param snap		Snapshot.
+ * @param key		Key to look up.
+ * @return Pointer to the value in the snapshot, or NULL if not found.
+ */
+const void *cl_snap_get(const struct cl_snap *snap, const void *key) {
+	uint32_t i = cl_snap_find(snap, key);
+	return i < snap->hdr->n_entries ? cl_snap_value(snap, i) : NULL;
+}
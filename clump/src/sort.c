@@ -0,0 +1,394 @@
+/*
+ * sort.c	Sorting and searching kernels
+ *
+ * Copyright (c) 2016  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_sort_u32		Sort an array of 32-bit keys
+ *	cl_sort_u64		Sort an array of 64-bit keys
+ *	cl_sort_bytes		Sort records by fixed-length byte keys
+ *	cl_sort_u64_parallel	Sort 64-bit keys with jobs on worker threads
+ *	cl_search_u32		Find the first key not less than a 32-bit key
+ *	cl_search_u64		Find the first key not less than a 64-bit key
+ */
+/** \file
+ *
+ * The sorts are LSD (least significant digit first) radix sorts, one byte
+ * per pass.  The counts of every byte are taken in a single pass over the
+ * keys, and a pass where all keys have the same byte is skipped, so keys
+ * which only use their low bits sort in fewer passes.  Each pass is stable,
+ * and moves keys between the array and a buffer of the same size.  Small
+ * arrays are insertion sorted instead.
+ *
+ * cl_sort_bytes sorts records by a key at the start of each record, in
+ * memcmp order (so big-endian integers sort as numbers).
+ *
+ * cl_sort_u64_parallel splits the keys into chunks which are sorted by
+ * jobs, and then merged in rounds of jobs (each merging two runs).  The
+ * jobs are run by a callback, as with cl_hcodec_encode_blocks.
+ *
+ * The searches find a lower bound on a sorted array with a branchless
+ * binary search, which only halves the range (so there's no mispredicted
+ * branch per step), and then count the keys less than key in the last few
+ * with SSE2 (or a loop the compiler can vectorize).
+ *
+ * For sorting with a comparison, see CL_SORT_DEFINE in typed.h.
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clump.h"
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define CL_SORT_SSE2
+#endif
+
+/** Arrays smaller than this are insertion sorted */
+#define CL_SORT_SMALL		(64)
+
+/** Keys left for the final count of a search */
+#define CL_SEARCH_SCAN		(16)
+
+/** Smallest chunk sorted by a parallel job */
+#define CL_SORT_CHUNK		(1u << 16)
+
+/** Most jobs of a parallel sort */
+#define CL_SORT_JOBS		(64)
+
+/** Insertion sort 32-bit keys */
+static void cl_sort_insert_u32(uint32_t *keys, size_t n) {
+	size_t i, j;
+	for(i = 1; i < n; i++) {
+		uint32_t k = keys[i];
+		for(j = i; j > 0 && keys[j - 1] > k; j--)
+			keys[j] = keys[j - 1];
+		keys[j] = k;
+	}
+}
+
+/** Insertion sort 64-bit keys */
+static void cl_sort_insert_u64(uint64_t *keys, size_t n) {
+	size_t i, j;
+	for(i = 1; i < n; i++) {
+		uint64_t k = keys[i];
+		for(j = i; j > 0 && keys[j - 1] > k; j--)
+			keys[j] = keys[j - 1];
+		keys[j] = k;
+	}
+}
+
+/** Turn byte counts into starting offsets.
+ *
+ * @param counts Counts of each byte value.
+ * @param n Number of keys.
+ * @return true if the pass is needed (not all keys have the same byte).
+ */
+static bool cl_sort_offsets(size_t counts[256], size_t n) {
+	size_t total = 0;
+	unsigned int b;
+	for(b = 0; b < 256; b++) {
+		size_t c = counts[b];
+		if(c == n)
+			return false;
+		counts[b] = total;
+		total += c;
+	}
+	return true;
+}
+
+/** Radix sort 32-bit keys, using a buffer of n keys.
+ *
+ * @return Array holding the sorted keys (keys or buf).
+ */
+static uint32_t *cl_sort_radix_u32(uint32_t *keys, uint32_t *buf, size_t n) {
+	size_t counts[4][256];
+	size_t i;
+	unsigned int d;
+	memset(counts, 0, sizeof(counts));
+	for(i = 0; i < n; i++) {
+		uint32_t k = keys[i];
+		counts[0][k & 0xFF]++;
+		counts[1][(k >> 8) & 0xFF]++;
+		counts[2][(k >> 16) & 0xFF]++;
+		counts[3][k >> 24]++;
+	}
+	for(d = 0; d < 4; d++) {
+		uint32_t *t;
+		if(!cl_sort_offsets(counts[d], n))
+			continue;
+		for(i = 0; i < n; i++) {
+			uint32_t k = keys[i];
+			buf[counts[d][(k >> (d * 8)) & 0xFF]++] = k;
+		}
+		t = keys;
+		keys = buf;
+		buf = t;
+	}
+	return keys;
+}
+
+/** Radix sort 64-bit keys, using a buffer of n keys.
+ *
+ * @return Array holding the sorted keys (keys or buf).
+ */
+static uint64_t *cl_sort_radix_u64(uint64_t *keys, uint64_t *buf, size_t n) {
+	size_t (*counts)[256] = calloc(8, sizeof(*counts));
+	size_t i;
+	unsigned int d;
+	assert(counts);
+	for(i = 0; i < n; i++) {
+		uint64_t k = keys[i];
+		for(d = 0; d < 8; d++)
+			counts[d][(k >> (d * 8)) & 0xFF]++;
+	}
+	for(d = 0; d < 8; d++) {
+		uint64_t *t;
+		if(!cl_sort_offsets(counts[d], n))
+			continue;
+		for(i = 0; i < n; i++) {
+			uint64_t k = keys[i];
+			buf[counts[d][(k >> (d * 8)) & 0xFF]++] = k;
+		}
+		t = keys;
+		keys = buf;
+		buf = t;
+	}
+	free(counts);
+	return keys;
+}
+
+/** Sort an array of 32-bit keys.
+ *
+ * @param keys Array of keys, sorted in place (increasing).
+ * @param n Number of keys.
+ */
+void cl_sort_u32(uint32_t *keys, size_t n) {
+	uint32_t *buf, *sorted;
+	if(n < CL_SORT_SMALL) {
+		cl_sort_insert_u32(keys, n);
+		return;
+	}
+	buf = malloc(n * sizeof(uint32_t));
+	assert(buf);
+	sorted = cl_sort_radix_u32(keys, buf, n);
+	if(sorted != keys)
+		memcpy(keys, sorted, n * sizeof(uint32_t));
+	free(buf);
+}
+
+/** Sort an array of 64-bit keys.
+ *
+ * @param keys Array of keys, sorted in place (increasing).
+ * @param n Number of keys.
+ */
+void cl_sort_u64(uint64_t *keys, size_t n) {
+	uint64_t *buf, *sorted;
+	if(n < CL_SORT_SMALL) {
+		cl_sort_insert_u64(keys, n);
+		return;
+	}
+	buf = malloc(n * sizeof(uint64_t));
+	assert(buf);
+	sorted = cl_sort_radix_u64(keys, buf, n);
+	if(sorted != keys)
+		memcpy(keys, sorted, n * sizeof(uint64_t));
+	free(buf);
+}
+
+/** Sort records by fixed-length byte keys.
+ *
+ * The sort is stable.  Each pass moves whole records, so for big records
+ * it's better to sort an array of (key, index) records.
+ *
+ * @param recs Array of records, sorted in place.
+ * @param n Number of records.
+ * @param rec_bytes Size of each record.
+ * @param key_bytes Size of the key at the start of each record (compared
+ *                  like memcmp).
+ */
+void cl_sort_bytes(void *recs, size_t n, size_t rec_bytes, size_t key_bytes) {
+	unsigned char *keys = recs;
+	unsigned char *buf;
+	size_t counts[256];
+	size_t i, d;
+	assert(key_bytes <= rec_bytes);
+	if(n < 2)
+		return;
+	buf = malloc(n * rec_bytes);
+	assert(buf);
+	for(d = key_bytes; d-- > 0; ) {
+		unsigned char *t;
+		memset(counts, 0, sizeof(counts));
+		for(i = 0; i < n; i++)
+			counts[keys[i * rec_bytes + d]]++;
+		if(!cl_sort_offsets(counts, n))
+			continue;
+		for(i = 0; i < n; i++) {
+			const unsigned char *r = keys + i * rec_bytes;
+			memcpy(buf + counts[r[d]]++ * rec_bytes, r, rec_bytes);
+		}
+		t = keys;
+		keys = buf;
+		buf = t;
+	}
+	if(keys != recs) {
+		memcpy(recs, keys, n * rec_bytes);
+		free(keys);
+	} else
+		free(buf);
+}
+
+/** Parallel sort job: sort one chunk, or merge two runs.
+ */
+struct cl_sort_job {
+	uint64_t		*src;		/* keys to sort / merge */
+	uint64_t		*dst;		/* buffer / merged keys */
+	size_t			n_left;		/* keys in left run */
+	size_t			n_right;	/* keys in right run (or 0 to
+						   sort a chunk) */
+	uint64_t		*out;		/* array holding sorted chunk */
+};
+
+/** Run one parallel sort job.
+ */
+static void cl_sort_job_run(void *data) {
+	struct cl_sort_job *job = data;
+	const uint64_t *a = job->src;
+	const uint64_t *ae = a + job->n_left;
+	const uint64_t *b = ae;
+	const uint64_t *be = b + job->n_right;
+	uint64_t *o = job->dst;
+	if(!job->n_right) {
+		job->out = cl_sort_radix_u64(job->src, job->dst, job->n_left);
+		return;
+	}
+	while(a < ae && b < be)
+		*o++ = (*b < *a) ? *b++ : *a++;
+	memcpy(o, a, (ae - a) * sizeof(uint64_t));
+	o += ae - a;
+	memcpy(o, b, (be - b) * sizeof(uint64_t));
+}
+
+/** Sort 64-bit keys with jobs on worker threads.
+ *
+ * @param keys Array of keys, sorted in place (increasing).
+ * @param n Number of keys.
+ * @param run_jobs Callback to run jobs, or NULL to sort on the calling
+ *                 thread.
+ */
+void cl_sort_u64_parallel(uint64_t *keys, size_t n, cl_run_jobs_cb *run_jobs)
+{
+	struct cl_sort_job jobs[CL_SORT_JOBS];
+	void *ptrs[CL_SORT_JOBS];
+	size_t starts[CL_SORT_JOBS + 1];
+	uint64_t *buf, *src, *dst;
+	uint32_t n_runs = 1;
+	uint32_t i;
+	while(n_runs < CL_SORT_JOBS && n / (n_runs * 2) >= CL_SORT_CHUNK)
+		n_runs *= 2;
+	if(!run_jobs || n_runs == 1) {
+		cl_sort_u64(keys, n);
+		return;
+	}
+	buf = malloc(n * sizeof(uint64_t));
+	assert(buf);
+	for(i = 0; i <= n_runs; i++)
+		starts[i] = n * i / n_runs;
+	for(i = 0; i < n_runs; i++) {
+		jobs[i].src = keys + starts[i];
+		jobs[i].dst = buf + starts[i];
+		jobs[i].n_left = starts[i + 1] - starts[i];
+		jobs[i].n_right = 0;
+		ptrs[i] = &jobs[i];
+	}
+	run_jobs(cl_sort_job_run, ptrs, n_runs);
+	/* bring each sorted chunk into keys, so all runs start there */
+	for(i = 0; i < n_runs; i++) {
+		if(jobs[i].out != keys + starts[i]) {
+			memcpy(keys + starts[i], jobs[i].out,
+				jobs[i].n_left * sizeof(uint64_t));
+		}
+	}
+	src = keys;
+	dst = buf;
+	for( ; n_runs > 1; n_runs /= 2) {
+		uint64_t *t;
+		for(i = 0; i < n_runs / 2; i++) {
+			size_t s = starts[i * 2];
+			jobs[i].src = src + s;
+			jobs[i].dst = dst + s;
+			jobs[i].n_left = starts[i * 2 + 1] - s;
+			jobs[i].n_right = starts[i * 2 + 2] - starts[i * 2 + 1];
+			ptrs[i] = &jobs[i];
+		}
+		run_jobs(cl_sort_job_run, ptrs, n_runs / 2);
+		for(i = 0; i <= n_runs / 2; i++)
+			starts[i] = starts[i * 2];
+		t = src;
+		src = dst;
+		dst = t;
+	}
+	if(src != keys)
+		memcpy(keys, src, n * sizeof(uint64_t));
+	free(buf);
+}
+
+/** Find the first key not less than a 32-bit key.
+ *
+ * @param keys Sorted array of keys (increasing).
+ * @param n Number of keys.
+ * @param key Key to search for.
+ * @return Index of first key not less than key (n if there are none).
+ */
+size_t cl_search_u32(const uint32_t *keys, size_t n, uint32_t key) {
+	const uint32_t *base = keys;
+	size_t c = 0;
+	size_t i = 0;
+	while(n > CL_SEARCH_SCAN) {
+		size_t half = n / 2;
+		/* no branch: the compiler makes this a conditional move */
+		base = (base[half - 1] < key) ? base + half : base;
+		n -= half;
+	}
+#ifdef CL_SORT_SSE2
+	{
+		/* SSE2 only compares signed, so flip the sign bits */
+		const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+		const __m128i k = _mm_xor_si128(_mm_set1_epi32((int)key), sign);
+		for( ; i + 4 <= n; i += 4) {
+			const __m128i *b = (const __m128i *)(base + i);
+			__m128i v = _mm_xor_si128(_mm_loadu_si128(b), sign);
+			__m128i lt = _mm_cmplt_epi32(v, k);
+			c += __builtin_popcount(_mm_movemask_ps(
+				_mm_castsi128_ps(lt)));
+		}
+	}
+#endif
+	for( ; i < n; i++)
+		c += base[i] < key;
+	return (base - keys) + c;
+}
+
+/** Find the first key not less than a 64-bit key.
+ *
+ * @param keys Sorted array of keys (increasing).
+ * @param n Number of keys.
+ * @param key Key to search for.
+ * @return Index of first key not less than key (n if there are none).
+ */
+size_t cl_search_u64(const uint64_t *keys, size_t n, uint64_t key) {
+	const uint64_t *base = keys;
+	size_t c = 0;
+	size_t i;
+	while(n > CL_SEARCH_SCAN) {
+		size_t half = n / 2;
+		base = (base[half - 1] < key) ? base + half : base;
+		n -= half;
+	}
+	for(i = 0; i < n; i++)
+		c += base[i] < key;
+	return (base - keys) + c;
+}
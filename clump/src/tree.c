@@ -7,19 +7,40 @@
  *
  *	cl_tree_create_set	Create a tree set
  *	cl_tree_create_map	Create a tree map
+ *	cl_tree_create_set_ranked Create a tree set with rank / select
+ *	cl_tree_create_map_ranked Create a tree map with rank / select
+ *	cl_tree_create_set_with_alloc Create a tree set with an allocator
+ *	cl_tree_create_map_with_alloc Create a tree map with an allocator
+ *	cl_tree_create_set_arena Create a tree set in an arena
+ *	cl_tree_create_map_arena Create a tree map in an arena
+ *	cl_tree_create_set_persistent Create a tree set with snapshots
+ *	cl_tree_create_map_persistent Create a tree map with snapshots
  * 	cl_tree_destroy		Destroy a tree
  *	cl_tree_count		Count the entries in a tree
  *	cl_tree_contains	Test if a tree contains a key
  *	cl_tree_peek		Get the first key in a tree
  *	cl_tree_get_key		Get a key from a tree
  *	cl_tree_get		Get a value from a tree map
+ *	cl_tree_lower_bound	Get the first key not less than a key
+ *	cl_tree_upper_bound	Get the first key greater than a key
+ *	cl_tree_rank		Count the keys less than a key
+ *	cl_tree_select		Get the key of a given rank
  *	cl_tree_add		Add a key to a tree set
  *	cl_tree_put		Put a mapping into a tree map
  *	cl_tree_remove_key	Remove a key from a tree
  *	cl_tree_remove		Remove a mapping from a tree map
  *	cl_tree_clear		Clear all entries from a tree
+ *	cl_tree_build_sorted	Build a tree from sorted entries
+ *	cl_tree_reserve		Reserve room for entries in a tree
+ *	cl_tree_shrink		Free unused memory of a tree
+ *	cl_tree_stats		Add up memory statistics of a tree
+ *	cl_tree_snapshot	Take a read-only snapshot of a tree
+ *	cl_tree_snapshot_release Release a tree snapshot
  *	cl_tree_iterator_create Create a tree key iterator
+ *	cl_tree_iterator_init	Initialize a tree key iterator
+ *	cl_tree_iterator_init_reverse Initialize a reverse tree key iterator
  *	cl_tree_iterator_destroy Destroy a tree key iterator
+ *	cl_tree_iterator_seek	Move an iterator to a key
  *	cl_tree_iterator_next	Get the next key from an iterator
  *	cl_tree_iterator_value	Get the value mapped to most recent key
  */
@@ -29,18 +50,26 @@
  * maps.
  * A map uses a bit more memory than a set, but allows an arbitrary value to be
  * mapped to each key.
- * Iterating over the keys is a fast operation.
+ * Iterating over the keys is a fast operation, in either order, and an
+ * iterator can seek to any key, so a range scan is O(log n + k).
  * The tree is implemented as a left-leaning red-black tree, as described by
  * Robert Sedgewick.
  * The node colors (red/black) are stored in the low bit of link pointers to
  * keep memory usage as small as possible.
+ * A ranked tree also keeps the number of keys in each sub-tree, one extra
+ * field per node, which allows rank and select in O(log n).
+ * A persistent tree can take a snapshot in O(1).  After that, writes copy
+ * each node they change (path copying, O(log n) per write) instead of
+ * changing it in place, so the snapshot keeps seeing the old version.
  * NOTE: some functions can be used with either sets or maps, but some must
  * only be used with either sets or maps.
  */
 #include <assert.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "clump.h"
 
 /** Tree node structure.
@@ -58,18 +87,18 @@ struct cl_node_mapping {
 	const void		*value;		/*< value for mapping */
 };
 
-/** Tree branch structure.
+/** Ranked node structure.
  */
-struct cl_tree_branch {
-	struct cl_tree_branch	*branch;	/**< next branch */
-	struct cl_node		*node;		/**< tree node */
+struct cl_node_ranked {
+	struct cl_node		node;		/*< node structure */
+	unsigned int		n_count;	/*< keys in sub-tree */
 };
 
-/** Tree iterator structure.
+/** Ranked node mapping structure.
  */
-struct cl_tree_iterator {
-	struct cl_tree		*tree;		/**< the tree */
-	struct cl_tree_branch	*branch;	/**< next branch */
+struct cl_node_mapping_ranked {
+	struct cl_node_mapping	mapping;	/*< node mapping structure */
+	unsigned int		n_count;	/*< keys in sub-tree */
 };
 
 /** Check if a node is red */
@@ -128,6 +157,109 @@ static inline void cl_node_set_right(struct cl_node *n, struct cl_node *c) {
 	cl_node_black(n)->right = c;
 }
 
+/** Node epoch structure (persistent trees only), after the node.
+ */
+struct cl_node_epoch {
+	struct cl_node		*retired;	/*< next retired node */
+	unsigned int		epoch;		/*< epoch node was created */
+};
+
+/** Tree structure.
+ */
+struct cl_tree {
+	cl_compare_cb		*fn_compare;	/*< comparison function */
+	struct cl_pool		*pool;		/*< tree entry / mapping pool */
+	const struct cl_alloc	*al;		/*< allocator of tree */
+	struct cl_node		*leaf;		/*< sentinel for leaf nodes */
+	struct cl_node		*root;		/*< root node of tree */
+	struct cl_node		*match;		/*< node for insert/remove */
+	unsigned int		n_entries;	/*< number of entries in tree */
+	size_t			o_count;	/*< offset of sub-tree count,
+						    or 0 if not ranked */
+	size_t			o_epoch;	/*< offset of node epoch,
+						    or 0 if not persistent */
+	size_t			n_node;		/*< size of each node */
+	unsigned int		epoch;		/*< epoch of tree / snapshot */
+	struct cl_tree		*origin;	/*< tree of snapshot, or NULL */
+	struct cl_tree		*older;		/*< next older snapshot */
+	struct cl_tree		*newer;		/*< next newer snapshot/tree */
+	struct cl_node		*retired;	/*< nodes only snapshots use */
+	struct cl_node		*retired_tail;	/*< last retired node */
+	bool			is_map;		/*< flag for mapping */
+};
+
+/** Get the epoch structure of a node (persistent trees only) */
+static inline struct cl_node_epoch *cl_node_epoch(struct cl_tree *tree,
+	struct cl_node *n)
+{
+	return (struct cl_node_epoch *)((char *)cl_node_black(n) +
+		tree->o_epoch);
+}
+
+/** Retire a node, which is still used by snapshots.
+ *
+ * The node is kept until every snapshot which could reach it is released.
+ */
+static void cl_tree_retire(struct cl_tree *tree, struct cl_node *n) {
+	struct cl_tree *snap = tree->older;
+	n = cl_node_black(n);
+	cl_node_epoch(tree, n)->retired = NULL;
+	if(snap->retired_tail)
+		cl_node_epoch(tree, snap->retired_tail)->retired = n;
+	else
+		snap->retired = n;
+	snap->retired_tail = n;
+}
+
+/** Own a node before changing it.
+ *
+ * In a persistent tree, a node created before the newest snapshot may be
+ * shared with it, so it is copied (and the original retired).  Only nodes on
+ * the path of an insert or remove are owned, so a write copies O(log n) nodes.
+ *
+ * @param tree The tree (set or map).
+ * @param n Node to change (red or black link).
+ * @return Node which can be changed, with the same color as n.
+ */
+static inline struct cl_node *cl_tree_own(struct cl_tree *tree,
+	struct cl_node *n)
+{
+	struct cl_node *c;
+	if(!tree->older || cl_node_black(n) == tree->leaf ||
+	   cl_node_epoch(tree, n)->epoch > tree->older->epoch)
+		return n;
+	c = cl_pool_alloc(tree->pool);
+	memcpy(c, cl_node_black(n), tree->n_node);
+	cl_node_epoch(tree, c)->epoch = tree->epoch;
+	cl_tree_retire(tree, n);
+	return cl_node_is_red(n) ? cl_node_red(c) : c;
+}
+
+/** Get the sub-tree count of a node (ranked trees only) */
+static inline unsigned int *cl_node_count(struct cl_tree *tree,
+	struct cl_node *n)
+{
+	return (unsigned int *)((char *)cl_node_black(n) + tree->o_count);
+}
+
+/** Update the sub-tree count of a node from its children */
+static inline void cl_node_update(struct cl_tree *tree, struct cl_node *n) {
+	if(tree->o_count) {
+		*cl_node_count(tree, n) = *cl_node_count(tree, cl_node_left(n)) +
+			*cl_node_count(tree, cl_node_right(n)) + 1;
+	}
+}
+
+/** Update sub-tree counts after a rotation from root n to new root p */
+static inline void cl_node_update_rotated(struct cl_tree *tree,
+	struct cl_node *n, struct cl_node *p)
+{
+	if(tree->o_count) {
+		*cl_node_count(tree, p) = *cl_node_count(tree, n);
+		cl_node_update(tree, n);
+	}
+}
+
 /** Rotate a node left.
  *
  * <pre>
@@ -138,10 +270,15 @@ static inline void cl_node_set_right(struct cl_node *n, struct cl_node *c) {
  *      o   q               m   o
  * </pre>
  */
-static struct cl_node *cl_node_rotate_left(struct cl_node *n) {
-	struct cl_node *p = cl_node_right(n);
+static struct cl_node *cl_node_rotate_left(struct cl_tree *tree,
+	struct cl_node *n)
+{
+	struct cl_node *p;
+	n = cl_tree_own(tree, n);
+	p = cl_tree_own(tree, cl_node_right(n));
 	cl_node_set_right(n, cl_node_left(p));
 	cl_node_set_left(p, cl_node_red(n));
+	cl_node_update_rotated(tree, n, p);
 	return cl_node_is_red(n) ? cl_node_red(p) : cl_node_black(p);
 }
 
@@ -155,10 +292,15 @@ static struct cl_node *cl_node_rotate_left(struct cl_node *n) {
  *    m   o                     o   q
  * </pre>
  */
-static struct cl_node *cl_node_rotate_right(struct cl_node *p) {
-	struct cl_node *n = cl_node_left(p);
+static struct cl_node *cl_node_rotate_right(struct cl_tree *tree,
+	struct cl_node *p)
+{
+	struct cl_node *n;
+	p = cl_tree_own(tree, p);
+	n = cl_tree_own(tree, cl_node_left(p));
 	cl_node_set_left(p, cl_node_right(n));
 	cl_node_set_right(n, cl_node_red(p));
+	cl_node_update_rotated(tree, p, n);
 	return cl_node_is_red(p) ? cl_node_red(n) : cl_node_black(n);
 }
 
@@ -168,7 +310,10 @@ static inline struct cl_node *cl_node_flip(struct cl_node *n) {
 }
 
 /** Flip the colors of a node and its children */
-static struct cl_node *cl_node_flip_colors(struct cl_node *n) {
+static struct cl_node *cl_node_flip_colors(struct cl_tree *tree,
+	struct cl_node *n)
+{
+	n = cl_tree_own(tree, n);
 	cl_node_set_left(n, cl_node_flip(cl_node_left(n)));
 	cl_node_set_right(n, cl_node_flip(cl_node_right(n)));
 	return cl_node_flip(n);
@@ -176,51 +321,49 @@ static struct cl_node *cl_node_flip_colors(struct cl_node *n) {
 
 /** Move a red link to the left.
  */
-static struct cl_node *cl_node_move_red_left(struct cl_node *n) {
-	n = cl_node_flip_colors(n);
+static struct cl_node *cl_node_move_red_left(struct cl_tree *tree,
+	struct cl_node *n)
+{
+	n = cl_node_flip_colors(tree, n);
 	if(cl_node_is_red(cl_node_left(cl_node_right(n)))) {
-		cl_node_set_right(n, cl_node_rotate_right(cl_node_right(n)));
-		return cl_node_flip_colors(cl_node_rotate_left(n));
+		cl_node_set_right(n, cl_node_rotate_right(tree,
+			cl_node_right(n)));
+		return cl_node_flip_colors(tree, cl_node_rotate_left(tree, n));
 	} else
 		return n;
 }
 
 /** Move a red link to the right.
  */
-static struct cl_node *cl_node_move_red_right(struct cl_node *n) {
-	n = cl_node_flip_colors(n);
+static struct cl_node *cl_node_move_red_right(struct cl_tree *tree,
+	struct cl_node *n)
+{
+	n = cl_node_flip_colors(tree, n);
 	if(cl_node_is_red(cl_node_left(cl_node_left(n))))
-		return cl_node_flip_colors(cl_node_rotate_right(n));
+		return cl_node_flip_colors(tree, cl_node_rotate_right(tree, n));
 	else
 		return n;
 }
 
 /** Ensure a subtree leans left after an insert or remove operation.
  */
-static struct cl_node *cl_node_lean_left(struct cl_node *n) {
+static struct cl_node *cl_node_lean_left(struct cl_tree *tree,
+	struct cl_node *n)
+{
+	n = cl_tree_own(tree, n);
+	cl_node_update(tree, n);
 	if(cl_node_is_red(cl_node_right(n)) &&
 	  !cl_node_is_red(cl_node_left(n)))
-		n = cl_node_rotate_left(n);
+		n = cl_node_rotate_left(tree, n);
 	if(cl_node_is_red(cl_node_left(n)) &&
 	   cl_node_is_red(cl_node_left(cl_node_left(n))))
-		n = cl_node_rotate_right(n);
+		n = cl_node_rotate_right(tree, n);
 	if(cl_node_is_red(cl_node_left(n)) &&
 	   cl_node_is_red(cl_node_right(n)))
-		n = cl_node_flip_colors(n);
+		n = cl_node_flip_colors(tree, n);
 	return n;
 }
 
-/** Tree structure.
- */
-struct cl_tree {
-	cl_compare_cb		*fn_compare;	/*< comparison function */
-	struct cl_pool		*pool;		/*< tree entry / mapping pool */
-	struct cl_node		*leaf;		/*< sentinel for leaf nodes */
-	struct cl_node		*root;		/*< root node of tree */
-	struct cl_node		*match;		/*< node for insert/remove */
-	unsigned int		n_entries;	/*< number of entries in tree */
-	bool			is_map;		/*< flag for mapping */
-};
 
 /** Test if a node is the leaf sentinel node */
 static inline bool cl_tree_is_leaf(struct cl_tree *tree, struct cl_node *n) {
@@ -322,6 +465,15 @@ static int cl_tree_debug_sub(struct cl_tree *tree, struct cl_node *n) {
 			}
 		}
 
+		/* Sub-tree count mismatch */
+		if(tree->o_count && *cl_node_count(tree, n) !=
+		   *cl_node_count(tree, ln) + *cl_node_count(tree, rn) + 1)
+		{
+			fprintf(stderr, "Count violation\n");
+			cl_node_debug(n, "NODE");
+			return 0;
+		}
+
 		/* Black height mismatch */
 		if(ld && rd && ld != rd) {
 			fprintf(stderr, "Black violation %d != %d\n", ld, rd);
@@ -372,6 +524,10 @@ static struct cl_node *cl_tree_node_create(struct cl_tree *tree,
 	n->left = leaf ? leaf : n;	/* sentinel links to self */
 	n->right = leaf ? leaf : n;
 	n->key = key;
+	if(tree->o_count)
+		*cl_node_count(tree, n) = leaf ? 1 : 0;
+	if(tree->o_epoch)
+		cl_node_epoch(tree, n)->epoch = tree->epoch;
 	/* red unless this is the "leaf" sentinel */
 	return leaf ? cl_node_red(n) : n;
 }
@@ -397,14 +553,27 @@ static struct cl_node_mapping *cl_tree_node_mapping_create(struct cl_tree *tree,
  *
  * @param fn_compare Function to compare two keys for ordering.
  * @param sz Size of each node.
+ * @param o_count Offset of sub-tree count in each node, or 0 if not ranked.
+ * @param al Allocator for the tree and its nodes.
  * @return Newly created tree.
  */
-static struct cl_tree *cl_tree_create(cl_compare_cb *fn_compare, size_t sz) {
-	struct cl_tree *tree = malloc(sizeof(struct cl_tree));
-	assert(tree);
+static struct cl_tree *cl_tree_create(cl_compare_cb *fn_compare, size_t sz,
+	size_t o_count, const struct cl_alloc *al)
+{
+	struct cl_tree *tree = cl_alloc_malloc(al, sizeof(struct cl_tree));
 	assert(fn_compare);
 	tree->fn_compare = fn_compare;
-	tree->pool = cl_pool_create(sz);
+	tree->pool = cl_pool_create_with_alloc(sz, al);
+	tree->al = al;
+	tree->o_count = o_count;
+	tree->o_epoch = 0;
+	tree->n_node = sz;
+	tree->epoch = 0;
+	tree->origin = NULL;
+	tree->older = NULL;
+	tree->newer = NULL;
+	tree->retired = NULL;
+	tree->retired_tail = NULL;
 	tree->leaf = cl_tree_node_create(tree, NULL, NULL);
 	tree->root = tree->leaf;
 	tree->match = NULL;
@@ -419,7 +588,8 @@ static struct cl_tree *cl_tree_create(cl_compare_cb *fn_compare, size_t sz) {
  * @return Newly created tree set.
  */
 struct cl_tree *cl_tree_create_set(cl_compare_cb *fn_compare) {
-	return cl_tree_create(fn_compare, sizeof(struct cl_node));
+	return cl_tree_create(fn_compare, sizeof(struct cl_node), 0,
+		&cl_alloc_default);
 }
 
 /** Create a tree map.
@@ -429,17 +599,142 @@ struct cl_tree *cl_tree_create_set(cl_compare_cb *fn_compare) {
  */
 struct cl_tree *cl_tree_create_map(cl_compare_cb *fn_compare) {
 	struct cl_tree *tree = cl_tree_create(fn_compare,
+		sizeof(struct cl_node_mapping), 0, &cl_alloc_default);
+	tree->is_map = true;
+	return tree;
+}
+
+/** Create a ranked tree set.
+ *
+ * A ranked tree keeps a count of keys in each sub-tree, so cl_tree_rank and
+ * cl_tree_select can be used.
+ *
+ * @param fn_compare Function to compare two keys for ordering.
+ * @return Newly created tree set.
+ */
+struct cl_tree *cl_tree_create_set_ranked(cl_compare_cb *fn_compare) {
+	return cl_tree_create(fn_compare, sizeof(struct cl_node_ranked),
+		offsetof(struct cl_node_ranked, n_count),
+		&cl_alloc_default);
+}
+
+/** Create a ranked tree map.
+ *
+ * @param fn_compare Function to compare two keys for ordering.
+ * @return Newly created tree map.
+ */
+struct cl_tree *cl_tree_create_map_ranked(cl_compare_cb *fn_compare) {
+	struct cl_tree *tree = cl_tree_create(fn_compare,
+		sizeof(struct cl_node_mapping_ranked),
+		offsetof(struct cl_node_mapping_ranked, n_count),
+		&cl_alloc_default);
+	tree->is_map = true;
+	return tree;
+}
+
+/** Create a tree set with an allocator.
+ *
+ * @param al Allocator for the tree and its nodes.
+ * @param fn_compare Function to compare two keys for ordering.
+ * @return Newly created tree set.
+ */
+struct cl_tree *cl_tree_create_set_with_alloc(const struct cl_alloc *al,
+	cl_compare_cb *fn_compare)
+{
+	return cl_tree_create(fn_compare, sizeof(struct cl_node), 0, al);
+}
+
+/** Create a tree map with an allocator.
+ *
+ * @param al Allocator for the tree and its nodes.
+ * @param fn_compare Function to compare two keys for ordering.
+ * @return Newly created tree map.
+ */
+struct cl_tree *cl_tree_create_map_with_alloc(const struct cl_alloc *al,
+	cl_compare_cb *fn_compare)
+{
+	struct cl_tree *tree = cl_tree_create(fn_compare,
+		sizeof(struct cl_node_mapping), 0, al);
+	tree->is_map = true;
+	return tree;
+}
+
+/** Create a tree set in an arena.
+ *
+ * The tree and its nodes are allocated from a memory arena, and are freed
+ * when it is released or reset -- destroying the tree is optional.
+ *
+ * @param arena Memory arena.
+ * @param fn_compare Function to compare two keys for ordering.
+ * @return Newly created tree set.
+ */
+struct cl_tree *cl_tree_create_set_arena(struct cl_arena *arena,
+	cl_compare_cb *fn_compare)
+{
+	return cl_tree_create_set_with_alloc(cl_arena_allocator(arena),
+		fn_compare);
+}
+
+/** Create a tree map in an arena.
+ *
+ * @param arena Memory arena.
+ * @param fn_compare Function to compare two keys for ordering.
+ * @return Newly created tree map.
+ */
+struct cl_tree *cl_tree_create_map_arena(struct cl_arena *arena,
+	cl_compare_cb *fn_compare)
+{
+	return cl_tree_create_map_with_alloc(cl_arena_allocator(arena),
+		fn_compare);
+}
+
+/** Create a persistent tree.
+ *
+ * @param fn_compare Function to compare two keys for ordering.
+ * @param sz Size of each node, without its epoch.
+ * @return Newly created tree.
+ */
+static struct cl_tree *cl_tree_create_persistent(cl_compare_cb *fn_compare,
+	size_t sz)
+{
+	struct cl_tree *tree = cl_tree_create(fn_compare,
+		sz + sizeof(struct cl_node_epoch), 0, &cl_alloc_default);
+	tree->o_epoch = sz;
+	return tree;
+}
+
+/** Create a persistent tree set.
+ *
+ * A persistent tree can use cl_tree_snapshot.  Each node has an extra epoch
+ * (two words), which is used to tell if it's shared with a snapshot.
+ *
+ * @param fn_compare Function to compare two keys for ordering.
+ * @return Newly created tree set.
+ */
+struct cl_tree *cl_tree_create_set_persistent(cl_compare_cb *fn_compare) {
+	return cl_tree_create_persistent(fn_compare, sizeof(struct cl_node));
+}
+
+/** Create a persistent tree map.
+ *
+ * @param fn_compare Function to compare two keys for ordering.
+ * @return Newly created tree map.
+ */
+struct cl_tree *cl_tree_create_map_persistent(cl_compare_cb *fn_compare) {
+	struct cl_tree *tree = cl_tree_create_persistent(fn_compare,
 		sizeof(struct cl_node_mapping));
 	tree->is_map = true;
 	return tree;
 }
 
 /** Destroy a tree.
+ *
+ * All snapshots of the tree must be released first.
  *
  * @param tree The tree (set or map).
  */
 void cl_tree_destroy(struct cl_tree *tree) {
-	assert(tree);
+	assert(tree && !tree->origin && !tree->older);
 	cl_pool_destroy(tree->pool);
 #ifndef NDEBUG
 	tree->fn_compare = NULL;
@@ -448,7 +743,7 @@ void cl_tree_destroy(struct cl_tree *tree) {
 	tree->root = NULL;
 	tree->match = NULL;
 #endif
-	free(tree);
+	cl_alloc_free(tree->al, tree, sizeof(struct cl_tree));
 }
 
 /** Get the count of items.
@@ -541,6 +836,111 @@ const void *cl_tree_get(struct cl_tree *tree, const void *key) {
 	return cl_tree_is_leaf(tree, n) ? NULL : cl_node_value(n);
 }
 
+/** Search for the first node after a key.
+ *
+ * @param tree The tree (set or map).
+ * @param key Key to search for.
+ * @param upper If true, skip a node matching the key.
+ * @return First node not less than (or greater than) key, or leaf node.
+ */
+static struct cl_node *cl_tree_search_bound(struct cl_tree *tree,
+	const void *key, bool upper)
+{
+	struct cl_node *n = tree->root;
+	struct cl_node *b = tree->leaf;
+	while(!cl_tree_is_leaf(tree, n)) {
+		switch(cl_tree_compare(tree, n, key)) {
+		case CL_EQUAL:
+			if(!upper)
+				return n;
+			n = cl_node_right(n);
+			break;
+		case CL_LESS:
+			b = n;
+			n = cl_node_left(n);
+			break;
+		case CL_GREATER:
+			n = cl_node_right(n);
+			break;
+		default:
+			assert(false);
+		}
+	}
+	return b;
+}
+
+/** Get the first key not less than a key.
+ *
+ * @param tree The tree (set or map).
+ * @param key Key to search for.
+ * @return Lowest key in the tree which is not less than key, or NULL.
+ */
+const void *cl_tree_lower_bound(struct cl_tree *tree, const void *key) {
+	return cl_node_key(cl_tree_search_bound(tree, key, false));
+}
+
+/** Get the first key greater than a key.
+ *
+ * @param tree The tree (set or map).
+ * @param key Key to search for.
+ * @return Lowest key in the tree which is greater than key, or NULL.
+ */
+const void *cl_tree_upper_bound(struct cl_tree *tree, const void *key) {
+	return cl_node_key(cl_tree_search_bound(tree, key, true));
+}
+
+/** Count the keys less than a key (ranked trees only).
+ *
+ * @param tree The tree (ranked set or map).
+ * @param key Key to search for.
+ * @return Number of keys in the tree which are less than key.
+ */
+unsigned int cl_tree_rank(struct cl_tree *tree, const void *key) {
+	struct cl_node *n = tree->root;
+	unsigned int r = 0;
+	assert(tree->o_count);
+	while(!cl_tree_is_leaf(tree, n)) {
+		switch(cl_tree_compare(tree, n, key)) {
+		case CL_EQUAL:
+			return r + *cl_node_count(tree, cl_node_left(n));
+		case CL_LESS:
+			n = cl_node_left(n);
+			break;
+		case CL_GREATER:
+			r += *cl_node_count(tree, cl_node_left(n)) + 1;
+			n = cl_node_right(n);
+			break;
+		default:
+			assert(false);
+		}
+	}
+	return r;
+}
+
+/** Get the key of a given rank (ranked trees only).
+ *
+ * @param tree The tree (ranked set or map).
+ * @param k Rank of key, starting from 0 for the lowest key.
+ * @return Key with k lower keys in the tree, or NULL if k >= count.
+ */
+const void *cl_tree_select(struct cl_tree *tree, unsigned int k) {
+	struct cl_node *n = tree->root;
+	assert(tree->o_count);
+	if(k >= tree->n_entries)
+		return NULL;
+	for(;;) {
+		unsigned int l = *cl_node_count(tree, cl_node_left(n));
+		if(k == l)
+			return cl_node_key(n);
+		if(k < l)
+			n = cl_node_left(n);
+		else {
+			k -= l + 1;
+			n = cl_node_right(n);
+		}
+	}
+}
+
 /** Insert a node into a subtree.
  *
  * @param tree The tree (set or map).
@@ -553,6 +953,7 @@ static struct cl_node *cl_tree_insert_sub(struct cl_tree *tree,
 {
 	if(cl_tree_is_leaf(tree, r))
 		return n;
+	r = cl_tree_own(tree, r);
 	switch(cl_tree_compare(tree, r, cl_node_key(n))) {
 	case CL_LESS:
 		cl_node_set_left(r, cl_tree_insert_sub(tree,cl_node_left(r),n));
@@ -565,7 +966,7 @@ static struct cl_node *cl_tree_insert_sub(struct cl_tree *tree,
 			n));
 		break;
 	}
-	return cl_node_lean_left(r);
+	return cl_node_lean_left(tree, r);
 }
 
 /** Insert a node into a tree.
@@ -575,6 +976,7 @@ static struct cl_node *cl_tree_insert_sub(struct cl_tree *tree,
  * @return Existing node with matching key, or NULL if node was inserted.
  */
 static struct cl_node *cl_tree_insert(struct cl_tree *tree, struct cl_node *n) {
+	assert(!tree->origin);
 	tree->match = NULL;
 	tree->root = cl_node_black(cl_tree_insert_sub(tree, tree->root, n));
 	return tree->match;
@@ -640,15 +1042,16 @@ const void *cl_tree_put(struct cl_tree *tree, const void *key,
  * @return New root of sub-tree.
  */
 static struct cl_node *cl_tree_pop_sub(struct cl_tree *tree, struct cl_node *n){
+	n = cl_tree_own(tree, n);
 	if(cl_tree_is_leaf(tree, cl_node_left(n))) {
 		tree->match = cl_node_black(n);
 		return tree->leaf;
 	}
 	if(!cl_node_is_red(cl_node_left(n)) &&
 	   !cl_node_is_red(cl_node_left(cl_node_left(n))))
-		n = cl_node_move_red_left(n);
+		n = cl_node_move_red_left(tree, n);
 	cl_node_set_left(n, cl_tree_pop_sub(tree, cl_node_left(n)));
-	return cl_node_lean_left(n);
+	return cl_node_lean_left(tree, n);
 }
 
 /** Remove an internal node.
@@ -688,15 +1091,16 @@ static struct cl_node *cl_tree_remove_sub(struct cl_tree *tree,
 {
 	if(cl_tree_is_leaf(tree, n))
 		return n;
+	n = cl_tree_own(tree, n);
 	if(cl_tree_compare(tree, n, key) == CL_LESS) {
 		if(!cl_node_is_red(cl_node_left(n)) &&
 		   !cl_node_is_red(cl_node_left(cl_node_left(n))))
-			n = cl_node_move_red_left(n);
+			n = cl_node_move_red_left(tree, n);
 		cl_node_set_left(n, cl_tree_remove_sub(tree, cl_node_left(n),
 			key));
 	} else {
 		if(cl_node_is_red(cl_node_left(n)))
-			n = cl_node_rotate_right(n);
+			n = cl_node_rotate_right(tree, n);
 		if(cl_tree_compare(tree, n, key) == CL_EQUAL &&
 		   cl_tree_is_leaf(tree, cl_node_right(n)))
 		{
@@ -705,7 +1109,7 @@ static struct cl_node *cl_tree_remove_sub(struct cl_tree *tree,
 		}
 		if(!cl_node_is_red(cl_node_right(n)) &&
 		   !cl_node_is_red(cl_node_left(cl_node_right(n))))
-			n = cl_node_move_red_right(n);
+			n = cl_node_move_red_right(tree, n);
 		if(cl_tree_compare(tree, n, key) == CL_EQUAL)
 			n = cl_tree_remove_internal(tree, n);
 		else {
@@ -713,7 +1117,7 @@ static struct cl_node *cl_tree_remove_sub(struct cl_tree *tree,
 				cl_node_right(n), key));
 		}
 	}
-	return cl_node_lean_left(n);
+	return cl_node_lean_left(tree, n);
 }
 
 /** Remove a node from a tree.
@@ -725,6 +1129,7 @@ static struct cl_node *cl_tree_remove_sub(struct cl_tree *tree,
 static struct cl_node *cl_tree_remove_node(struct cl_tree *tree,
 	const void *key)
 {
+	assert(!tree->origin);
 	tree->match = NULL;
 	tree->root = cl_node_black(cl_tree_remove_sub(tree, tree->root, key));
 	return tree->match;
@@ -780,6 +1185,7 @@ const void *cl_tree_remove(struct cl_tree *tree, const void *key) {
  * @param tree The tree (set or map).
  */
 void cl_tree_clear(struct cl_tree *tree) {
+	assert(!tree->origin && !tree->older);
 	cl_pool_clear(tree->pool);
 	tree->leaf = cl_tree_node_create(tree, NULL, NULL);
 	tree->root = tree->leaf;
@@ -787,68 +1193,331 @@ void cl_tree_clear(struct cl_tree *tree) {
 	cl_tree_debug(tree);
 }
 
-/** Create a tree iterator.
+/** Get the most keys in a sub-tree of a given black height.
+ *
+ * A left-leaning red-black tree is a 2-3 tree, so it's 3^h - 1 (a 3-node,
+ * black with a red left child, at each level).
+ */
+static uint64_t cl_tree_build_max(uint32_t h) {
+	uint64_t m = 1;
+	while(h--)
+		m *= 3;
+	return m - 1;
+}
+
+/** Build a node from the next sorted entry.
  *
  * @param tree The tree (set or map).
- * @return Iterator for tree keys.
+ * @param keys Sorted keys.
+ * @param values Values for keys (NULL for sets).
+ * @param i Index of entry, advanced past it.
+ * @param left Left sub-tree of node.
+ * @return New red node.
  */
-struct cl_tree_iterator *cl_tree_iterator_create(struct cl_tree *tree) {
-	struct cl_tree_iterator *it = cl_pool_alloc(tree->pool);
-	it->tree = tree;
-	it->branch = NULL;
-	return it;
+static struct cl_node *cl_tree_build_node(struct cl_tree *tree,
+	const void **keys, const void **values, uint32_t *i,
+	struct cl_node *left)
+{
+	struct cl_node *n = cl_tree_node_create(tree, tree->leaf, keys[*i]);
+	if(tree->is_map)
+		cl_node_set_value(n, values ? values[*i] : NULL);
+	cl_node_set_left(n, left);
+	(*i)++;
+	return n;
 }
 
-/** Destroy a tree iterator.
+/** Build a sub-tree from sorted entries.
  *
- * @param it The tree iterator.
+ * Nodes are created in key order.  The root is a 2-node (black) if the
+ * entries fit in two sub-trees of the next black height, otherwise a 3-node.
+ *
+ * @param tree The tree (set or map).
+ * @param keys Sorted keys.
+ * @param values Values for keys (NULL for sets).
+ * @param i Index of next entry, advanced past the sub-tree's entries.
+ * @param m Number of entries in the sub-tree.
+ * @param h Black height of the sub-tree.
+ * @return Root node of sub-tree.
  */
-void cl_tree_iterator_destroy(struct cl_tree_iterator *it) {
-	assert(it);
-	struct cl_tree *tree = it->tree;
-	struct cl_tree_branch *br = it->branch;
-	while(br) {
-		struct cl_tree_branch *next = br->branch;
-		cl_pool_release(tree->pool, br);
-		br = next;
+static struct cl_node *cl_tree_build_sub(struct cl_tree *tree,
+	const void **keys, const void **values, uint32_t *i, uint32_t m,
+	uint32_t h)
+{
+	struct cl_node *n;
+	uint32_t a, b;
+	if(h == 0) {
+		assert(m == 0);
+		return tree->leaf;
+	}
+	if(m <= 2 * cl_tree_build_max(h - 1) + 1) {
+		a = (m - 1) / 2;
+		n = cl_tree_build_sub(tree, keys, values, i, a, h - 1);
+		n = cl_node_black(cl_tree_build_node(tree, keys, values, i, n));
+		cl_node_set_right(n, cl_tree_build_sub(tree, keys, values, i,
+			m - 1 - a, h - 1));
+		cl_node_update(tree, n);
+		return n;
 	}
+	a = (m - 2) / 3;
+	b = (m - 2 - a) / 2;
+	n = cl_tree_build_sub(tree, keys, values, i, a, h - 1);
+	n = cl_tree_build_node(tree, keys, values, i, n);
+	cl_node_set_right(n, cl_tree_build_sub(tree, keys, values, i, b,
+		h - 1));
+	cl_node_update(tree, n);
+	n = cl_node_black(cl_tree_build_node(tree, keys, values, i, n));
+	cl_node_set_right(n, cl_tree_build_sub(tree, keys, values, i,
+		m - 2 - a - b, h - 1));
+	cl_node_update(tree, n);
+	return n;
+}
+
+/** Build a tree from sorted entries.
+ *
+ * Replace all entries of a tree with n entries in linear time, instead of
+ * adding them one at a time.  The nodes are allocated in key order, so they
+ * are (mostly) contiguous in memory.
+ *
+ * @param tree The tree (set or map).
+ * @param keys Keys, in increasing order with no duplicates.
+ * @param values Values for keys (maps only, or NULL).
+ * @param n Number of entries.
+ */
+void cl_tree_build_sorted(struct cl_tree *tree, const void **keys,
+	const void **values, uint32_t n)
+{
+	uint32_t h = 0;
+	uint32_t i = 0;
 #ifndef NDEBUG
-	it->tree = NULL;
-	it->branch = NULL;
+	for(i = 1; i < n; i++)
+		assert(tree->fn_compare(keys[i - 1], keys[i]) == CL_LESS);
+	i = 0;
 #endif
-	cl_pool_release(tree->pool, it);
+	cl_tree_clear(tree);
+	cl_pool_reserve(tree->pool, n);
+	while(cl_tree_build_max(h) < n)
+		h++;
+	tree->root = cl_tree_build_sub(tree, keys, values, &i, n, h);
+	tree->n_entries = n;
+	cl_tree_debug(tree);
 }
 
-/** Descend a tree iterator.  Take left branch of each node until we reach a
- * leaf.  Put each intervening node on the iterator stack.  Upon return, the
- * iterator node points to the value at the leaf node found.
+/** Reserve room for entries in a tree.
+ *
+ * Allocate node memory up front, so that adding the next n entries does not
+ * call malloc.
+ *
+ * @param tree The tree (set or map).
+ * @param n Number of entries to reserve room for.
+ */
+void cl_tree_reserve(struct cl_tree *tree, uint32_t n) {
+	cl_pool_reserve(tree->pool, n);
+}
+
+/** Shrink a tree.
+ *
+ * Free node memory which is not in use (after a clear).
+ *
+ * @param tree The tree (set or map).
+ */
+void cl_tree_shrink(struct cl_tree *tree) {
+	cl_pool_shrink(tree->pool);
+}
+
+/** Add up memory statistics of a tree.
+ *
+ * The leaf sentinel node counts as a live object.
+ *
+ * @param tree The tree (set or map).
+ * @param stats Statistics to add to (see cl_pool_stats).
+ */
+void cl_tree_stats(const struct cl_tree *tree, struct cl_pool_stats *stats) {
+	cl_pool_stats(tree->pool, stats);
+	stats->n_bytes += sizeof(struct cl_tree);
+}
+
+/** Take a snapshot of a tree (persistent trees only).
+ *
+ * The snapshot is a read-only tree, which can be used with any function that
+ * doesn't change a tree (including iterators).  It keeps the keys and values
+ * of the tree as they are now, while the tree is changed.  This takes O(1),
+ * since nothing is copied until the tree is written.
+ *
+ * Nodes of a snapshot are never changed, so other threads can read it while
+ * the tree is being written.  Taking and releasing snapshots changes the
+ * tree, though, so they must not run at the same time as writes.
+ *
+ * @param tree The tree (persistent set or map).
+ * @return Snapshot of the tree; release with cl_tree_snapshot_release.
+ */
+struct cl_tree *cl_tree_snapshot(struct cl_tree *tree) {
+	struct cl_tree *snap = cl_alloc_malloc(tree->al,
+		sizeof(struct cl_tree));
+	assert(snap && tree->o_epoch && !tree->origin);
+	*snap = *tree;
+	snap->match = NULL;
+	snap->epoch = tree->epoch++;
+	snap->origin = tree;
+	snap->newer = tree;
+	snap->retired = NULL;
+	snap->retired_tail = NULL;
+	if(tree->older)
+		tree->older->newer = snap;
+	tree->older = snap;
+	return snap;
+}
+
+/** Release a tree snapshot.
+ *
+ * Nodes retired while the snapshot was the newest one are handed to the next
+ * older snapshot, or freed if there are none (no reader can reach them).
+ *
+ * @param snap Snapshot from cl_tree_snapshot.
+ */
+void cl_tree_snapshot_release(struct cl_tree *snap) {
+	struct cl_tree *tree = snap->origin;
+	struct cl_tree *older = snap->older;
+	struct cl_node *n = snap->retired;
+	assert(tree);
+	snap->newer->older = older;
+	if(older)
+		older->newer = snap->newer;
+	if(older && n) {
+		if(older->retired_tail)
+			cl_node_epoch(tree, older->retired_tail)->retired = n;
+		else
+			older->retired = n;
+		older->retired_tail = snap->retired_tail;
+	} else {
+		while(n) {
+			struct cl_node *next = cl_node_epoch(tree, n)->retired;
+			cl_pool_release(tree->pool, n);
+			n = next;
+		}
+	}
+#ifndef NDEBUG
+	snap->origin = NULL;
+	snap->root = NULL;
+	snap->retired = NULL;
+	snap->retired_tail = NULL;
+#endif
+	cl_alloc_free(tree->al, snap, sizeof(struct cl_tree));
+}
+
+/** Create a tree iterator.
+ *
+ * @param tree The tree (set or map).
+ * @return Iterator for tree keys.
+ */
+struct cl_tree_iterator *cl_tree_iterator_create(struct cl_tree *tree) {
+	struct cl_tree_iterator *it = malloc(sizeof(struct cl_tree_iterator));
+	assert(it);
+	cl_tree_iterator_init(it, tree);
+	return it;
+}
+
+/** Descend a tree iterator.  Take near branch (left, or right in reverse) of
+ * each node until we reach a leaf.  Put each intervening node on the iterator
+ * path.  Upon return, the last node on the path is the next node.
  */
 static void cl_tree_iterator_descend(struct cl_tree_iterator *it,
 	struct cl_node *n)
 {
 	struct cl_tree *tree = it->tree;
-	struct cl_tree_branch *next = it->branch;
 	while(!cl_tree_is_leaf(tree, n)) {
-		struct cl_tree_branch *br = cl_pool_alloc(tree->pool);
-		br->branch = next;
-		br->node = n;
-		next = br;
-		n = cl_node_left(n);
+		assert(it->depth < CL_TREE_DEPTH);
+		it->path[it->depth++] = n;
+		n = it->reverse ? cl_node_right(n) : cl_node_left(n);
 	}
-	it->branch = next;
 }
 
-/** Ascend a tree iterator.  Go up one branch and descend to the right.
+/** Ascend a tree iterator.  Go up one branch and descend the far branch.
  */
 static void cl_tree_iterator_ascend(struct cl_tree_iterator *it) {
+	struct cl_node *n;
+	assert(it->depth);
+	n = it->path[--it->depth];
+	cl_tree_iterator_descend(it, it->reverse ? cl_node_left(n) :
+		cl_node_right(n));
+}
+
+/** Start a tree iterator at the first key.
+ */
+static void cl_tree_iterator_start(struct cl_tree_iterator *it,
+	struct cl_tree *tree, bool reverse)
+{
+	it->tree = tree;
+	it->depth = 0;
+	it->reverse = reverse;
+	it->pending = true;
+	cl_tree_iterator_descend(it, tree->root);
+}
+
+/** Initialize a tree iterator.
+ *
+ * Initialize a caller's iterator (which can be on the stack).  It doesn't
+ * need to be destroyed.
+ *
+ * @param it The tree iterator.
+ * @param tree The tree (set or map).
+ */
+void cl_tree_iterator_init(struct cl_tree_iterator *it, struct cl_tree *tree) {
+	cl_tree_iterator_start(it, tree, false);
+}
+
+/** Initialize a reverse tree iterator.
+ *
+ * Like cl_tree_iterator_init, but keys are returned in decreasing order.
+ *
+ * @param it The tree iterator.
+ * @param tree The tree (set or map).
+ */
+void cl_tree_iterator_init_reverse(struct cl_tree_iterator *it,
+	struct cl_tree *tree)
+{
+	cl_tree_iterator_start(it, tree, true);
+}
+
+/** Destroy a tree iterator.
+ *
+ * @param it The tree iterator.
+ */
+void cl_tree_iterator_destroy(struct cl_tree_iterator *it) {
+	assert(it);
+#ifndef NDEBUG
+	it->tree = NULL;
+	it->depth = 0;
+#endif
+	free(it);
+}
+
+/** Move a tree iterator to a key.
+ *
+ * The next call to cl_tree_iterator_next returns the first key not less than
+ * key (or, for a reverse iterator, the last key not greater than key).  A
+ * range scan is a seek followed by calls to next, in O(log n + k).
+ *
+ * @param it The tree iterator.
+ * @param key Key to seek.
+ */
+void cl_tree_iterator_seek(struct cl_tree_iterator *it, const void *key) {
 	struct cl_tree *tree = it->tree;
-	struct cl_tree_branch *br = it->branch;
-	assert(br);
-	struct cl_node *n = cl_node_right(br->node);
-	struct cl_tree_branch *next = br->branch;
-	cl_pool_release(tree->pool, br);
-	it->branch = next;
-	cl_tree_iterator_descend(it, n);
+	struct cl_node *n = tree->root;
+	cl_compare_t far = it->reverse ? CL_LESS : CL_GREATER;
+	it->depth = 0;
+	it->pending = true;
+	while(!cl_tree_is_leaf(tree, n)) {
+		cl_compare_t c = cl_tree_compare(tree, n, key);
+		if(c == far) {
+			n = it->reverse ? cl_node_left(n) : cl_node_right(n);
+			continue;
+		}
+		assert(it->depth < CL_TREE_DEPTH);
+		it->path[it->depth++] = n;
+		if(c == CL_EQUAL)
+			break;
+		n = it->reverse ? cl_node_right(n) : cl_node_left(n);
+	}
 }
 
 /** Get next key from a tree iterator.
@@ -857,25 +1526,18 @@ static void cl_tree_iterator_ascend(struct cl_tree_iterator *it) {
  * @return Next key, or NULL if no more keys.
  */
 const void *cl_tree_iterator_next(struct cl_tree_iterator *it) {
-	struct cl_tree *tree = it->tree;
-	struct cl_tree_branch *br = it->branch;
-	if(br)
+	if(it->pending)
+		it->pending = false;
+	else if(it->depth)
 		cl_tree_iterator_ascend(it);
-	else
-		cl_tree_iterator_descend(it, tree->root);
-	br = it->branch;
-	return br ? cl_node_key(br->node) : NULL;
+	return it->depth ? cl_node_key(it->path[it->depth - 1]) : NULL;
 }
-
 /** Get the value associated with most recent key from a tree iterator.
  *
  * @param it The iterator.
  * @return Value associated with most recent key returned, or NULL.
  */
 const void *cl_tree_iterator_value(struct cl_tree_iterator *it) {
-	struct cl_tree *tree = it->tree;
-	struct cl_tree_branch *br = it->branch;
-	struct cl_node *n = br ? br->node : NULL;
-	assert(tree->is_map);
-	return cl_tree_is_leaf(tree, n) ? NULL : cl_node_value(n);
+	assert(it->tree->is_map);
+	return it->depth ? cl_node_value(it->path[it->depth - 1]) : NULL;
 }
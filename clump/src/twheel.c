@@ -0,0 +1,451 @@
+/*
+ * twheel.c	A hierarchical timer wheel
+ *
+ * Copyright (c) 2016  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_twheel_create		Create a timer wheel
+ *	cl_twheel_destroy		Destroy a timer wheel
+ *	cl_twheel_count			Count the pending timers of a wheel
+ *	cl_twheel_now			Get the current tick of a wheel
+ *	cl_twheel_add			Add a timer to a wheel
+ *	cl_twheel_cancel		Cancel a timer
+ *	cl_twheel_advance		Expire timers up to a tick
+ *	cl_twheel_start			Start a timer thread for a wheel
+ *	cl_twheel_stop			Stop the timer thread of a wheel
+ */
+/** \file
+ *
+ * A timer wheel holds any number of pending timers, each with an item
+ * (pointer) which is handed back when it expires.  Adding and cancelling a
+ * timer are O(1), and expiring a batch of timers is O(1) per timer -- there
+ * is no ordered structure to keep balanced.
+ *
+ * Time is counted in ticks.  The wheel has 4 levels of 256 slots: level 0
+ * has one slot per tick, and each slot of level n covers 256^n ticks.  A
+ * timer goes in the slot of the lowest level which reaches it.  Every 256
+ * ticks, the next slot of level 1 is "cascaded": its timers are added again,
+ * which puts them into level 0 (and so on up the levels).  Timers more than
+ * 2^32 ticks away stay on the top level until they come in range.
+ *
+ * Timers are kept in one array, linked into their slots by index, so there
+ * is no allocation per timer once the array has grown.  A timer handle has
+ * the index in the low 32 bits and a generation in the high 32 bits, so
+ * cancelling a timer which has already expired is harmless.
+ *
+ * cl_twheel_start runs a timer thread which advances the wheel with
+ * SDL_GetTicks, and pushes the items of expired timers into a cl_queue for
+ * worker threads.  While it runs, add and cancel take the wheel's mutex.
+ * This module needs SDL's thread, mutex and timer functions (it's part of
+ * the c2m runtime, which compiles SDL in).  Without cl_twheel_start, the
+ * caller advances the wheel itself, and no locking is done.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+#include "clump.h"
+
+/** Bits of slot index on each level */
+#define CL_TWHEEL_BITS		(8)
+
+/** Slots on each level */
+#define CL_TWHEEL_SLOTS		(1u << CL_TWHEEL_BITS)
+
+/** Number of levels */
+#define CL_TWHEEL_LEVELS	(4)
+
+/** List of timers being expired (after all slots) */
+#define CL_TWHEEL_EXPIRING	(CL_TWHEEL_SLOTS * CL_TWHEEL_LEVELS)
+
+/** No timer index (end of a list) */
+#define CL_TWHEEL_NONE		(UINT32_MAX)
+
+/** Timer structure.
+ */
+struct cl_timer {
+	uint64_t		when;		/**< tick to expire */
+	void			*item;		/**< item to hand back */
+	uint32_t		next;		/**< next timer in slot (or free
+						     list) */
+	uint32_t		prev;		/**< previous timer in slot */
+	uint32_t		gen;		/**< generation of handle */
+	uint32_t		slot;		/**< slot (or CL_TWHEEL_NONE if
+						     free) */
+};
+
+/** Timer wheel structure.
+ */
+struct cl_twheel {
+	uint32_t		heads[CL_TWHEEL_EXPIRING + 1];
+						/**< first timer of each slot */
+	struct cl_timer		*timers;	/**< all timers */
+	uint32_t		n_size;		/**< size of timer array */
+	uint32_t		n_timers;	/**< number of pending timers */
+	uint32_t		free_head;	/**< head of free timer list */
+	uint64_t		now;		/**< next tick to expire */
+	SDL_mutex		*mutex;		/**< lock (timer thread only) */
+	SDL_Thread		*thread;	/**< timer thread, or NULL */
+	SDL_atomic_t		running;	/**< timer thread flag */
+	struct cl_queue		*queue;		/**< queue for expired items */
+	uint32_t		ms_tick;	/**< milliseconds per tick */
+	uint32_t		ms_start;	/**< SDL_GetTicks at tick 0 */
+};
+
+/** Create a timer wheel.
+ *
+ * @param now Current tick.
+ * @return Pointer to new timer wheel.
+ */
+struct cl_twheel *cl_twheel_create(uint64_t now) {
+	struct cl_twheel *wheel = malloc(sizeof(struct cl_twheel));
+	uint32_t i;
+	assert(wheel);
+	for(i = 0; i <= CL_TWHEEL_EXPIRING; i++)
+		wheel->heads[i] = CL_TWHEEL_NONE;
+	wheel->n_size = 0;
+	wheel->n_timers = 0;
+	wheel->timers = NULL;
+	wheel->free_head = CL_TWHEEL_NONE;
+	wheel->now = now;
+	wheel->mutex = NULL;
+	wheel->thread = NULL;
+	SDL_AtomicSet(&wheel->running, 0);
+	wheel->queue = NULL;
+	wheel->ms_tick = 1;
+	wheel->ms_start = 0;
+	return wheel;
+}
+
+/** Destroy a timer wheel.
+ *
+ * Pending timers are dropped (their items are not handed back).
+ *
+ * @param wheel Pointer to timer wheel.
+ */
+void cl_twheel_destroy(struct cl_twheel *wheel) {
+	assert(wheel);
+	cl_twheel_stop(wheel);
+	free(wheel->timers);
+#ifndef NDEBUG
+	wheel->timers = NULL;
+#endif
+	free(wheel);
+}
+
+/** Lock a timer wheel (if its timer thread is running) */
+static inline void cl_twheel_lock(struct cl_twheel *wheel) {
+	if(wheel->mutex)
+		SDL_LockMutex(wheel->mutex);
+}
+
+/** Unlock a timer wheel */
+static inline void cl_twheel_unlock(struct cl_twheel *wheel) {
+	if(wheel->mutex)
+		SDL_UnlockMutex(wheel->mutex);
+}
+
+/** Count the pending timers of a wheel.
+ *
+ * @param wheel Pointer to timer wheel.
+ * @return Number of timers which have not expired or been cancelled.
+ */
+uint32_t cl_twheel_count(struct cl_twheel *wheel) {
+	uint32_t n;
+	cl_twheel_lock(wheel);
+	n = wheel->n_timers;
+	cl_twheel_unlock(wheel);
+	return n;
+}
+
+/** Get the current tick of a wheel.
+ *
+ * @param wheel Pointer to timer wheel.
+ * @return Next tick to expire.
+ */
+uint64_t cl_twheel_now(struct cl_twheel *wheel) {
+	uint64_t now;
+	cl_twheel_lock(wheel);
+	now = wheel->now;
+	cl_twheel_unlock(wheel);
+	return now;
+}
+
+/** Link a timer into the head of a slot list.
+ */
+static void cl_twheel_link(struct cl_twheel *wheel, uint32_t i, uint32_t s) {
+	struct cl_timer *t = wheel->timers + i;
+	uint32_t h = wheel->heads[s];
+	t->slot = s;
+	t->prev = CL_TWHEEL_NONE;
+	t->next = h;
+	if(h != CL_TWHEEL_NONE)
+		wheel->timers[h].prev = i;
+	wheel->heads[s] = i;
+}
+
+/** Unlink a timer from its slot list.
+ */
+static void cl_twheel_unlink(struct cl_twheel *wheel, uint32_t i) {
+	struct cl_timer *t = wheel->timers + i;
+	if(t->prev != CL_TWHEEL_NONE)
+		wheel->timers[t->prev].next = t->next;
+	else
+		wheel->heads[t->slot] = t->next;
+	if(t->next != CL_TWHEEL_NONE)
+		wheel->timers[t->next].prev = t->prev;
+}
+
+/** Put a timer into the slot which reaches its tick.
+ */
+static void cl_twheel_insert(struct cl_twheel *wheel, uint32_t i) {
+	uint64_t when = wheel->timers[i].when;
+	uint64_t d;
+	uint32_t level = 0;
+	if(when < wheel->now)
+		when = wheel->now;
+	d = when - wheel->now;
+	if(d > UINT32_MAX) {
+		/* out of range: park it on the top level until it's closer */
+		when = wheel->now + UINT32_MAX;
+		level = CL_TWHEEL_LEVELS - 1;
+	} else {
+		while(d >> (CL_TWHEEL_BITS * (level + 1)))
+			level++;
+	}
+	cl_twheel_link(wheel, i, level * CL_TWHEEL_SLOTS +
+		((when >> (CL_TWHEEL_BITS * level)) & (CL_TWHEEL_SLOTS - 1)));
+}
+
+/** Grow the timer array of a wheel.
+ */
+static void cl_twheel_grow(struct cl_twheel *wheel) {
+	uint32_t n = wheel->n_size ? wheel->n_size * 2 : 64;
+	uint32_t i;
+	assert(n > wheel->n_size);
+	wheel->timers = realloc(wheel->timers, n * sizeof(struct cl_timer));
+	assert(wheel->timers);
+	/* link new timers into the free list, lowest index first */
+	for(i = n; i-- > wheel->n_size; ) {
+		struct cl_timer *t = wheel->timers + i;
+		t->gen = 0;
+		t->slot = CL_TWHEEL_NONE;
+		t->next = wheel->free_head;
+		wheel->free_head = i;
+	}
+	wheel->n_size = n;
+}
+
+/** Add a timer to a wheel.
+ *
+ * @param wheel Pointer to timer wheel.
+ * @param delay Ticks until the timer expires (0 for the next tick).
+ * @param item Item to hand back when the timer expires.
+ * @return Handle of timer, for cl_twheel_cancel.
+ */
+uint64_t cl_twheel_add(struct cl_twheel *wheel, uint64_t delay, void *item) {
+	struct cl_timer *t;
+	uint32_t i;
+	cl_twheel_lock(wheel);
+	if(wheel->free_head == CL_TWHEEL_NONE)
+		cl_twheel_grow(wheel);
+	i = wheel->free_head;
+	t = wheel->timers + i;
+	wheel->free_head = t->next;
+	t->when = wheel->now + delay;
+	t->item = item;
+	cl_twheel_insert(wheel, i);
+	wheel->n_timers++;
+	cl_twheel_unlock(wheel);
+	return ((uint64_t)t->gen << 32) | i;
+}
+
+/** Free a timer (after unlinking it).
+ */
+static void cl_twheel_free(struct cl_twheel *wheel, uint32_t i) {
+	struct cl_timer *t = wheel->timers + i;
+	t->gen++;
+	t->slot = CL_TWHEEL_NONE;
+	t->next = wheel->free_head;
+	wheel->free_head = i;
+	wheel->n_timers--;
+}
+
+/** Cancel a timer.
+ *
+ * @param wheel Pointer to timer wheel.
+ * @param timer Handle from cl_twheel_add.
+ * @return true if the timer was cancelled, or false if it had already
+ *         expired (or been cancelled).
+ */
+bool cl_twheel_cancel(struct cl_twheel *wheel, uint64_t timer) {
+	uint32_t i = (uint32_t)timer;
+	bool pending;
+	cl_twheel_lock(wheel);
+	pending = i < wheel->n_size &&
+		wheel->timers[i].gen == (uint32_t)(timer >> 32) &&
+		wheel->timers[i].slot != CL_TWHEEL_NONE;
+	if(pending) {
+		cl_twheel_unlink(wheel, i);
+		cl_twheel_free(wheel, i);
+	}
+	cl_twheel_unlock(wheel);
+	return pending;
+}
+
+/** Cascade one slot of a level down to lower levels.
+ *
+ * @return Index of the slot on its level.
+ */
+static uint32_t cl_twheel_cascade(struct cl_twheel *wheel, uint32_t level) {
+	uint32_t s = (wheel->now >> (CL_TWHEEL_BITS * level)) &
+		(CL_TWHEEL_SLOTS - 1);
+	uint32_t i = wheel->heads[level * CL_TWHEEL_SLOTS + s];
+	wheel->heads[level * CL_TWHEEL_SLOTS + s] = CL_TWHEEL_NONE;
+	while(i != CL_TWHEEL_NONE) {
+		uint32_t next = wheel->timers[i].next;
+		cl_twheel_insert(wheel, i);
+		i = next;
+	}
+	return s;
+}
+
+/** Expire the timers of the current tick, and move to the next one.
+ *
+ * @return Number of timers expired.
+ */
+static uint32_t cl_twheel_tick(struct cl_twheel *wheel, cl_twheel_cb *fn,
+	void *ctx)
+{
+	uint32_t s = wheel->now & (CL_TWHEEL_SLOTS - 1);
+	uint32_t n = 0;
+	uint32_t level;
+	uint32_t i;
+	for(level = 1; s == 0 && level < CL_TWHEEL_LEVELS; level++) {
+		if(cl_twheel_cascade(wheel, level))
+			break;
+	}
+	/* Move the slot to the expiring list, so the callback can add (to
+	 * the next tick) or cancel timers while it's walked */
+	i = wheel->heads[s];
+	wheel->heads[s] = CL_TWHEEL_NONE;
+	wheel->heads[CL_TWHEEL_EXPIRING] = i;
+	for( ; i != CL_TWHEEL_NONE; i = wheel->timers[i].next)
+		wheel->timers[i].slot = CL_TWHEEL_EXPIRING;
+	wheel->now++;
+	while((i = wheel->heads[CL_TWHEEL_EXPIRING]) != CL_TWHEEL_NONE) {
+		void *item = wheel->timers[i].item;
+		assert(wheel->timers[i].when < wheel->now);
+		cl_twheel_unlink(wheel, i);
+		cl_twheel_free(wheel, i);
+		fn(ctx, item);
+		n++;
+	}
+	return n;
+}
+
+/** Expire timers up to a tick.
+ *
+ * The item of each expired timer is passed to a callback, in tick order
+ * (timers expiring on the same tick are in no particular order).  The
+ * callback may add or cancel timers, but must not advance the wheel.
+ *
+ * @param wheel Pointer to timer wheel (without a timer thread).
+ * @param now Current tick; timers expiring at or before it are expired.
+ * @param fn Callback for each expired item.
+ * @param ctx Context passed to callback.
+ * @return Number of timers expired.
+ */
+uint32_t cl_twheel_advance(struct cl_twheel *wheel, uint64_t now,
+	cl_twheel_cb *fn, void *ctx)
+{
+	uint32_t n = 0;
+	while(wheel->now <= now) {
+		/* with no timers, there's nothing to cascade either */
+		if(wheel->n_timers == 0) {
+			wheel->now = now + 1;
+			break;
+		}
+		n += cl_twheel_tick(wheel, fn, ctx);
+	}
+	return n;
+}
+
+/** Push an expired item into the queue of a timer thread.
+ *
+ * Waits for room if the queue is full.
+ */
+static void cl_twheel_push(void *ctx, void *item) {
+	struct cl_twheel *wheel = ctx;
+	while(!cl_queue_push(wheel->queue, item))
+		SDL_Delay(0);
+}
+
+/** Run a timer thread.
+ */
+static int SDLCALL cl_twheel_run(void *data) {
+	struct cl_twheel *wheel = data;
+	while(SDL_AtomicLoad(&wheel->running, SDL_MEMORY_ORDER_RELAXED)) {
+		uint64_t now = (uint32_t)(SDL_GetTicks() - wheel->ms_start) /
+			wheel->ms_tick;
+		SDL_LockMutex(wheel->mutex);
+		cl_twheel_advance(wheel, now, cl_twheel_push, wheel);
+		SDL_UnlockMutex(wheel->mutex);
+		SDL_Delay(wheel->ms_tick);
+	}
+	return 0;
+}
+
+/** Start a timer thread for a wheel.
+ *
+ * The thread advances the wheel once per tick, by SDL_GetTicks (starting
+ * from the current tick of the wheel), and pushes the item of each expired
+ * timer into a queue.  Ticks of less than a millisecond are not possible,
+ * and long ticks (> 49 days in total) wrap around.
+ *
+ * @param wheel Pointer to timer wheel.
+ * @param ms_tick Milliseconds per tick.
+ * @param queue Queue for expired items (it waits for room when full).
+ * @return true on success, or false if the thread could not be started.
+ */
+bool cl_twheel_start(struct cl_twheel *wheel, uint32_t ms_tick,
+	struct cl_queue *queue)
+{
+	assert(!wheel->thread && ms_tick > 0 && queue);
+	wheel->mutex = SDL_CreateMutex();
+	if(!wheel->mutex)
+		return false;
+	wheel->queue = queue;
+	wheel->ms_tick = ms_tick;
+	wheel->ms_start = SDL_GetTicks() - (uint32_t)(wheel->now * ms_tick);
+	SDL_AtomicSet(&wheel->running, 1);
+	wheel->thread = SDL_CreateThread(cl_twheel_run, "cl_twheel", wheel);
+	if(!wheel->thread) {
+		SDL_AtomicSet(&wheel->running, 0);
+		SDL_DestroyMutex(wheel->mutex);
+		wheel->mutex = NULL;
+		return false;
+	}
+	return true;
+}
+
+/** Stop the timer thread of a wheel.
+ *
+ * Pending timers stay in the wheel; it can be advanced by the caller (or
+ * started again) afterwards.
+ *
+ * @param wheel Pointer to timer wheel.
+ */
+void cl_twheel_stop(struct cl_twheel *wheel) {
+	if(!wheel->thread)
+		return;
+	SDL_AtomicStore(&wheel->running, 0, SDL_MEMORY_ORDER_RELAXED);
+	SDL_WaitThread(wheel->thread, NULL);
+	SDL_DestroyMutex(wheel->mutex);
+	wheel->thread = NULL;
+	wheel->mutex = NULL;
+	wheel->queue = NULL;
+}
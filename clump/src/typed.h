@@ -0,0 +1,492 @@
+/*
+ * typed.h	Typed (macro-templated) containers
+ *
+ * Copyright (c) 2016  Douglas P Lau
+ *
+ * Templates:
+ *
+ *	CL_HMAP_DEFINE		Define a typed hash map
+ *	CL_HEAP_DEFINE		Define a typed heap
+ *	CL_SORT_DEFINE		Define a typed sort
+ */
+/** \file
+ *
+ * The clump containers hold void pointers, and hash and compare keys with
+ * callbacks, so the C compiler can't inline a comparison, and keys bigger
+ * than a pointer must be stored elsewhere.  These templates define a
+ * container for one key (and value) type instead: keys and values are
+ * stored inline, and the hash and compare "functions" are macros (or
+ * inline functions), so an integer key is compared with one instruction.
+ *
+ * Each template defines a structure "struct name" and static inline
+ * functions "name_*" in the file which uses it, for example:
+ *
+ *	CL_HMAP_DEFINE(imap, int64_t, uint32_t, CL_TYPED_HASH_INT,
+ *		CL_TYPED_EQ)
+ *
+ *	struct imap m;
+ *	imap_init(&m);
+ *	imap_put(&m, 42, 7);
+ *	uint32_t *v = imap_get(&m, 42);
+ *	imap_fini(&m);
+ *
+ * A hash map is open addressed, with linear probing, and removal shifts
+ * the following entries back (so there are no tombstones).  A heap is a
+ * binary heap in one array.  Compilers (like c2m) can define one instance
+ * per key / value type.
+ */
+#ifndef CLUMP_TYPED_H
+#define CLUMP_TYPED_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clump.h"
+
+/** Hash an integer key (any width) */
+#define CL_TYPED_HASH_INT(k)	cl_hash_mix((uint64_t)(k))
+
+/** Compare two scalar keys for equality */
+#define CL_TYPED_EQ(a, b)	((a) == (b))
+
+/** Compare two scalar keys for ordering (less than) */
+#define CL_TYPED_LESS(a, b)	((a) < (b))
+
+/** Define a typed hash map.
+ *
+ * @param name Name of structure, and prefix of functions.
+ * @param K Key type.
+ * @param V Value type.
+ * @param HASH Hash of a key: HASH(k) gives an integer.
+ * @param EQ Key equality: EQ(a, b) is true if keys a and b are equal.
+ *
+ * Functions defined (m is a struct name *):
+ *
+ *	name_init(m)		Initialize an empty map
+ *	name_fini(m)		Free a map's storage
+ *	name_count(m)		Count the entries
+ *	name_get(m, k)		Get a pointer to the value of k (or NULL)
+ *	name_put(m, k, v)	Put a mapping (replacing any value of k),
+ *				returning a pointer to the stored value
+ *	name_remove(m, k)	Remove a mapping, true if it existed
+ *	name_clear(m)		Remove all entries
+ *	name_next(m, &i, &k, &v) Get the entry after slot i (start with 0),
+ *				false when there are no more
+ *
+ * Pointers from get and put are valid until the next put or remove.
+ */
+#define CL_HMAP_DEFINE(name, K, V, HASH, EQ)				\
+struct name {								\
+	K		*keys;		/**< key of each slot */	\
+	V		*values;	/**< value of each slot */	\
+	uint8_t		*used;		/**< 1 if slot is used */	\
+	uint32_t	mask;		/**< slots - 1 (or 0) */	\
+	uint32_t	n_entries;	/**< number of entries */	\
+};									\
+									\
+static inline void name##_init(struct name *m) {			\
+	memset(m, 0, sizeof(struct name));				\
+}									\
+									\
+static inline void name##_fini(struct name *m) {			\
+	free(m->keys);							\
+	free(m->values);						\
+	free(m->used);							\
+	memset(m, 0, sizeof(struct name));				\
+}									\
+									\
+static inline uint32_t name##_count(const struct name *m) {		\
+	return m->n_entries;						\
+}									\
+									\
+static inline uint32_t name##_slot(const struct name *m, K k) {		\
+	return (uint32_t)(HASH(k)) & m->mask;				\
+}									\
+									\
+static inline V *name##_get(const struct name *m, K k) {		\
+	uint32_t i;							\
+	if(!m->used)							\
+		return NULL;						\
+	for(i = name##_slot(m, k); m->used[i]; i = (i + 1) & m->mask) {	\
+		if(EQ(m->keys[i], k))					\
+			return m->values + i;				\
+	}								\
+	return NULL;							\
+}									\
+									\
+static inline V *name##_insert(struct name *m, K k, V v) {		\
+	uint32_t i = name##_slot(m, k);					\
+	while(m->used[i]) {						\
+		if(EQ(m->keys[i], k)) {					\
+			m->values[i] = v;				\
+			return m->values + i;				\
+		}							\
+		i = (i + 1) & m->mask;					\
+	}								\
+	m->used[i] = 1;							\
+	m->keys[i] = k;							\
+	m->values[i] = v;						\
+	m->n_entries++;							\
+	return m->values + i;						\
+}									\
+									\
+static inline void name##_grow(struct name *m) {			\
+	struct name o = *m;						\
+	uint32_t n = o.used ? (o.mask + 1) * 2 : 16;			\
+	uint32_t i;							\
+	m->keys = malloc(n * sizeof(K));				\
+	m->values = malloc(n * sizeof(V));				\
+	m->used = calloc(n, 1);						\
+	assert(m->keys && m->values && m->used);			\
+	m->mask = n - 1;						\
+	m->n_entries = 0;						\
+	for(i = 0; o.used && i <= o.mask; i++) {			\
+		if(o.used[i])						\
+			name##_insert(m, o.keys[i], o.values[i]);	\
+	}								\
+	free(o.keys);							\
+	free(o.values);							\
+	free(o.used);							\
+}									\
+									\
+static inline V *name##_put(struct name *m, K k, V v) {			\
+	/* keep the load at most 3/4 */					\
+	if(!m->used || (m->n_entries + 1) * 4 > (m->mask + 1) * 3)	\
+		name##_grow(m);						\
+	return name##_insert(m, k, v);					\
+}									\
+									\
+static inline bool name##_remove(struct name *m, K k) {			\
+	uint32_t i, j;							\
+	if(!m->used)							\
+		return false;						\
+	for(i = name##_slot(m, k); m->used[i]; i = (i + 1) & m->mask) {	\
+		if(EQ(m->keys[i], k))					\
+			break;						\
+	}								\
+	if(!m->used[i])							\
+		return false;						\
+	/* shift back following entries which probed past slot i */	\
+	for(j = (i + 1) & m->mask; m->used[j]; j = (j + 1) & m->mask) {	\
+		uint32_t h = name##_slot(m, m->keys[j]);		\
+		if(((j - h) & m->mask) >= ((j - i) & m->mask)) {	\
+			m->keys[i] = m->keys[j];			\
+			m->values[i] = m->values[j];			\
+			i = j;						\
+		}							\
+	}								\
+	m->used[i] = 0;							\
+	m->n_entries--;							\
+	return true;							\
+}									\
+									\
+static inline void name##_clear(struct name *m) {			\
+	if(m->used)							\
+		memset(m->used, 0, m->mask + 1);			\
+	m->n_entries = 0;						\
+}									\
+									\
+static inline bool name##_next(const struct name *m, uint32_t *it,	\
+	K *k, V *v)							\
+{									\
+	uint32_t i;							\
+	for(i = *it; m->used && i <= m->mask; i++) {			\
+		if(m->used[i]) {					\
+			*k = m->keys[i];				\
+			*v = m->values[i];				\
+			*it = i + 1;					\
+			return true;					\
+		}							\
+	}								\
+	*it = i;							\
+	return false;							\
+}
+
+/** Define a typed heap (lowest item on top).
+ *
+ * @param name Name of structure, and prefix of functions.
+ * @param T Item type.
+ * @param LESS Item order: LESS(a, b) is true if a goes before b.
+ *
+ * Functions defined (h is a struct name *):
+ *
+ *	name_init(h)		Initialize an empty heap
+ *	name_fini(h)		Free a heap's storage
+ *	name_count(h)		Count the items
+ *	name_peek(h)		Get a pointer to the lowest item (or NULL)
+ *	name_push(h, t)		Push an item
+ *	name_pop(h, &t)		Pop the lowest item, false if empty
+ */
+#define CL_HEAP_DEFINE(name, T, LESS)					\
+struct name {								\
+	T		*items;		/**< items, in heap order */	\
+	uint32_t	n_size;		/**< size of item array */	\
+	uint32_t	n_items;	/**< number of items */		\
+};									\
+									\
+static inline void name##_init(struct name *h) {			\
+	memset(h, 0, sizeof(struct name));				\
+}									\
+									\
+static inline void name##_fini(struct name *h) {			\
+	free(h->items);							\
+	memset(h, 0, sizeof(struct name));				\
+}									\
+									\
+static inline uint32_t name##_count(const struct name *h) {		\
+	return h->n_items;						\
+}									\
+									\
+static inline T *name##_peek(const struct name *h) {			\
+	return h->n_items ? h->items : NULL;				\
+}									\
+									\
+static inline void name##_push(struct name *h, T t) {			\
+	uint32_t i = h->n_items++;					\
+	if(i >= h->n_size) {						\
+		h->n_size = h->n_size ? h->n_size * 2 : 16;		\
+		h->items = realloc(h->items, h->n_size * sizeof(T));	\
+		assert(h->items);					\
+	}								\
+	while(i > 0 && LESS(t, h->items[(i - 1) / 2])) {		\
+		h->items[i] = h->items[(i - 1) / 2];			\
+		i = (i - 1) / 2;					\
+	}								\
+	h->items[i] = t;						\
+}									\
+									\
+static inline bool name##_pop(struct name *h, T *t) {			\
+	uint32_t i = 0, n;						\
+	T last;								\
+	if(!h->n_items)							\
+		return false;						\
+	*t = h->items[0];						\
+	n = --h->n_items;						\
+	last = h->items[n];						\
+	for(;;) {							\
+		uint32_t c = i * 2 + 1;					\
+		if(c >= n)						\
+			break;						\
+		if(c + 1 < n && LESS(h->items[c + 1], h->items[c]))	\
+			c++;						\
+		if(!LESS(h->items[c], last))				\
+			break;						\
+		h->items[i] = h->items[c];				\
+		i = c;							\
+	}								\
+	if(n)								\
+		h->items[i] = last;					\
+	return true;							\
+}
+
+/** Define a typed sort (pattern-defeating quicksort).
+ *
+ * @param name Prefix of functions.
+ * @param T Item type.
+ * @param LESS Item order: LESS(a, b) is true if a goes before b.
+ *
+ * Functions defined:
+ *
+ *	name_sort(a, n)		Sort array a of n items
+ *
+ * The sort is quicksort, picking a median of 3 pivot (or median of 3
+ * medians for big ranges).  Small ranges are insertion sorted.  If a
+ * partition moved nothing, the range may already be sorted, so it tries
+ * an insertion sort which gives up after a few moves.  A range whose
+ * pivot was equal to the one before it is split into "equal" and
+ * "greater", so many equal items are fast.  After too many unbalanced
+ * partitions, it swaps some items to break up the pattern, and finally
+ * falls back to heapsort (so the worst case is O(n log n)).  The sort is
+ * not stable.
+ */
+#define CL_SORT_DEFINE(name, T, LESS)					\
+static inline void name##_swap(T *a, size_t i, size_t j) {		\
+	T t = a[i];							\
+	a[i] = a[j];							\
+	a[j] = t;							\
+}									\
+									\
+static inline void name##_insertion(T *a, size_t n) {			\
+	size_t i, j;							\
+	for(i = 1; i < n; i++) {					\
+		T t = a[i];						\
+		for(j = i; j > 0 && LESS(t, a[j - 1]); j--)		\
+			a[j] = a[j - 1];				\
+		a[j] = t;						\
+	}								\
+}									\
+									\
+static inline bool name##_partial_insertion(T *a, size_t n) {		\
+	size_t i, j, moves = 0;						\
+	for(i = 1; i < n; i++) {					\
+		T t = a[i];						\
+		if(!LESS(t, a[i - 1]))					\
+			continue;					\
+		for(j = i; j > 0 && LESS(t, a[j - 1]); j--)		\
+			a[j] = a[j - 1];				\
+		a[j] = t;						\
+		moves += i - j;						\
+		if(moves > 8)						\
+			return false;					\
+	}								\
+	return true;							\
+}									\
+									\
+static inline void name##_sift(T *a, size_t i, size_t n) {		\
+	T t = a[i];							\
+	for(;;) {							\
+		size_t c = i * 2 + 1;					\
+		if(c >= n)						\
+			break;						\
+		if(c + 1 < n && LESS(a[c], a[c + 1]))			\
+			c++;						\
+		if(!LESS(t, a[c]))					\
+			break;						\
+		a[i] = a[c];						\
+		i = c;							\
+	}								\
+	a[i] = t;							\
+}									\
+									\
+static inline void name##_heapsort(T *a, size_t n) {			\
+	size_t i;							\
+	for(i = n / 2; i-- > 0; )					\
+		name##_sift(a, i, n);					\
+	for(i = n; i-- > 1; ) {						\
+		name##_swap(a, 0, i);					\
+		name##_sift(a, 0, i);					\
+	}								\
+}									\
+									\
+static inline void name##_sort3(T *a, size_t i, size_t j, size_t k) {	\
+	if(LESS(a[j], a[i]))						\
+		name##_swap(a, i, j);					\
+	if(LESS(a[k], a[j])) {						\
+		name##_swap(a, j, k);					\
+		if(LESS(a[j], a[i]))					\
+			name##_swap(a, i, j);				\
+	}								\
+}									\
+									\
+/* partition around a[0]: less on the left, not less on the right */	\
+static inline size_t name##_partition_right(T *a, size_t n,		\
+	bool *already)							\
+{									\
+	T p = a[0];							\
+	size_t f = 0, l = n;						\
+	while(LESS(a[++f], p))						\
+		;							\
+	if(f == 1) {							\
+		while(f < l && !LESS(a[--l], p))			\
+			;						\
+	} else {							\
+		while(!LESS(a[--l], p))					\
+			;						\
+	}								\
+	*already = (f >= l);						\
+	while(f < l) {							\
+		name##_swap(a, f, l);					\
+		while(LESS(a[++f], p))					\
+			;						\
+		while(!LESS(a[--l], p))					\
+			;						\
+	}								\
+	a[0] = a[f - 1];						\
+	a[f - 1] = p;							\
+	return f - 1;							\
+}									\
+									\
+/* partition around a[0]: not greater on the left, greater on right */	\
+static inline size_t name##_partition_left(T *a, size_t n) {		\
+	T p = a[0];							\
+	size_t f = 0, l = n;						\
+	while(LESS(p, a[--l]))						\
+		;							\
+	if(l + 1 == n) {						\
+		while(f < l && !LESS(p, a[++f]))			\
+			;						\
+	} else {							\
+		while(!LESS(p, a[++f]))					\
+			;						\
+	}								\
+	while(f < l) {							\
+		name##_swap(a, f, l);					\
+		while(LESS(p, a[--l]))					\
+			;						\
+		while(!LESS(p, a[++f]))					\
+			;						\
+	}								\
+	a[0] = a[l];							\
+	a[l] = p;							\
+	return l;							\
+}									\
+									\
+static inline void name##_loop(T *a, size_t n, unsigned int bad,	\
+	bool leftmost)							\
+{									\
+	for(;;) {							\
+		size_t h = n / 2, p, nl, nr;				\
+		bool already;						\
+		if(n < 24) {						\
+			name##_insertion(a, n);				\
+			return;						\
+		}							\
+		if(n > 128) {						\
+			name##_sort3(a, 0, h, n - 1);			\
+			name##_sort3(a, 1, h - 1, n - 2);		\
+			name##_sort3(a, 2, h + 1, n - 3);		\
+			name##_sort3(a, h - 1, h, h + 1);		\
+			name##_swap(a, 0, h);				\
+		} else							\
+			name##_sort3(a, h, 0, n - 1);			\
+		/* a[-1] is the pivot of the enclosing range */		\
+		if(!leftmost && !LESS(a[-1], a[0])) {			\
+			p = name##_partition_left(a, n) + 1;		\
+			a += p;						\
+			n -= p;						\
+			continue;					\
+		}							\
+		p = name##_partition_right(a, n, &already);		\
+		nl = p;							\
+		nr = n - p - 1;						\
+		if(nl < n / 8 || nr < n / 8) {				\
+			if(--bad == 0) {				\
+				name##_heapsort(a, n);			\
+				return;					\
+			}						\
+			if(nl >= 24) {					\
+				name##_swap(a, 0, nl / 4);		\
+				name##_swap(a, p - 1, p - nl / 4);	\
+			}						\
+			if(nr >= 24) {					\
+				name##_swap(a, p + 1, p + 1 + nr / 4);	\
+				name##_swap(a, n - 1, n - nr / 4);	\
+			}						\
+		} else if(already &&					\
+			name##_partial_insertion(a, nl) &&		\
+			name##_partial_insertion(a + p + 1, nr))	\
+			return;						\
+		/* recurse into the smaller side, loop on the larger */	\
+		if(nl < nr) {						\
+			name##_loop(a, nl, bad, leftmost);		\
+			a += p + 1;					\
+			n = nr;						\
+			leftmost = false;				\
+		} else {						\
+			name##_loop(a + p + 1, nr, bad, false);		\
+			n = nl;						\
+		}							\
+	}								\
+}									\
+									\
+static inline void name##_sort(T *a, size_t n) {			\
+	unsigned int bad = 1;						\
+	size_t m;							\
+	for(m = n; m > 1; m /= 2)					\
+		bad++;							\
+	name##_loop(a, n, bad, true);					\
+}
+
+#endif
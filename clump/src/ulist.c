@@ -0,0 +1,436 @@
+/*
+ * ulist.c	A generic unrolled linked list
+ *
+ * Copyright (c) 2007-2012  Douglas P Lau
+ *
+ * Public functions:
+ *
+ *	cl_ulist_create			Create an unrolled list
+ *	cl_ulist_destroy		Destroy an unrolled list
+ *	cl_ulist_is_empty		Check if a list is empty
+ *	cl_ulist_count			Count the items in a list
+ *	cl_ulist_add			Add an item to a list
+ *	cl_ulist_add_tail		Add an item to tail of a list
+ *	cl_ulist_remove			Remove an item from a list
+ *	cl_ulist_contains		Check if a list contains an item
+ *	cl_ulist_pop			Pop an item from a list
+ *	cl_ulist_clear			Clear all items from a list
+ *	cl_ulist_reserve		Reserve room for items in a list
+ *	cl_ulist_shrink			Free unused memory of a list
+ *	cl_ulist_stats			Add up memory statistics of a list
+ *	cl_ulist_iterator_create	Create a list iterator
+ *	cl_ulist_iterator_init		Initialize a list iterator
+ *	cl_ulist_iterator_destroy	Destroy a list iterator
+ *	cl_ulist_iterator_next		Get next item from an iterator
+ *	cl_ulist_iterator_remove	Remove current item from an iterator
+ */
+/** \file
+ *
+ * An unrolled list is an ordered collection with the same API as a linked
+ * list, but each node (chunk) holds up to CL_ULIST_ITEMS items in a
+ * CL_ULIST_CHUNK byte block, two cache lines.  Iterating, contains and
+ * remove scan an array per chunk instead of chasing a pointer per item, and
+ * a queue or stack allocates a chunk every CL_ULIST_ITEMS items.
+ *
+ * The items of a chunk are kept together in items[first] to
+ * items[first + n_items - 1], so that items can be added or popped at either
+ * end of a chunk without moving the others.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clump.h"
+
+/** Bytes in each chunk (a multiple of the cache line size) */
+#define CL_ULIST_CHUNK 128
+
+/** Number of items in each chunk */
+#define CL_ULIST_ITEMS ((CL_ULIST_CHUNK - sizeof(void *) - \
+	2 * sizeof(uint16_t)) / sizeof(void *))
+
+/** Unrolled list chunk structure.
+ */
+struct cl_ulist_chunk {
+	struct cl_ulist_chunk	*next;		/**< link to next chunk */
+	uint16_t		first;		/**< slot of first item */
+	uint16_t		n_items;	/**< number of items */
+	void			*items[CL_ULIST_ITEMS];	/**< item slots */
+};
+
+/** Unrolled list structure.
+ */
+struct cl_ulist {
+	struct cl_pool		*pool;		/**< chunk memory pool */
+	struct cl_ulist_chunk	*head;		/**< link to head chunk */
+	struct cl_ulist_chunk	*tail;		/**< link to tail chunk */
+	unsigned int		n_entries;	/**< number of entries */
+};
+
+/** Get the max of two size_t values */
+static inline size_t max_size_t(size_t a, size_t b) {
+	return a > b ? a : b;
+}
+
+/** Get the end slot (one past the last item) of a chunk */
+static inline uint32_t cl_ulist_chunk_end(const struct cl_ulist_chunk *c) {
+	return c->first + c->n_items;
+}
+
+/** Create a chunk.
+ *
+ * @param list Pointer to the list.
+ * @param first Slot of first item.
+ * @return New empty chunk.
+ */
+static struct cl_ulist_chunk *cl_ulist_chunk_create(struct cl_ulist *list,
+	uint32_t first)
+{
+	struct cl_ulist_chunk *c = cl_pool_alloc(list->pool);
+	c->next = NULL;
+	c->first = first;
+	c->n_items = 0;
+	return c;
+}
+
+/** Create an unrolled list.
+ *
+ * Allocate a new cl_ulist structure on the heap.
+ *
+ * @return Pointer to a new list.
+ */
+struct cl_ulist *cl_ulist_create(void) {
+	struct cl_ulist *list = malloc(sizeof(struct cl_ulist));
+	assert(list);
+	list->pool = cl_pool_create(max_size_t(sizeof(struct cl_ulist_chunk),
+		sizeof(struct cl_ulist_iterator)));
+	list->head = NULL;
+	list->tail = NULL;
+	list->n_entries = 0;
+	return list;
+}
+
+/** Destroy an unrolled list.
+ *
+ * Destroy the specified list, releasing all its resources.
+ *
+ * @param list Pointer to the list.
+ */
+void cl_ulist_destroy(struct cl_ulist *list) {
+	assert(list);
+	cl_pool_destroy(list->pool);
+#ifndef NDEBUG
+	list->head = NULL;
+	list->tail = NULL;
+	list->pool = NULL;
+#endif
+	free(list);
+}
+
+/** Test if a list is empty.
+ *
+ * @return true if there are no items in the list; false otherwise.
+ */
+bool cl_ulist_is_empty(struct cl_ulist *list) {
+	return list->head == NULL;
+}
+
+/** Get a count of items in a list.
+ *
+ * @param list Pointer to the list.
+ * @return Count of items in the list.
+ */
+unsigned int cl_ulist_count(struct cl_ulist *list) {
+	return list->n_entries;
+}
+
+/** Add an item to a list.
+ *
+ * Add a new item at the head of an unrolled list.
+ *
+ * @param list Pointer to the list.
+ * @param item Pointer to item to add.
+ * @return Pointer to added item.
+ */
+void *cl_ulist_add(struct cl_ulist *list, void *item) {
+	struct cl_ulist_chunk *c = list->head;
+	if(c == NULL || c->n_items == CL_ULIST_ITEMS) {
+		c = cl_ulist_chunk_create(list, CL_ULIST_ITEMS);
+		c->next = list->head;
+		list->head = c;
+		if(list->tail == NULL)
+			list->tail = c;
+	} else if(c->first == 0) {
+		/* Move items to the end of the chunk */
+		uint32_t first = CL_ULIST_ITEMS - c->n_items;
+		memmove(c->items + first, c->items,
+			c->n_items * sizeof(void *));
+		c->first = first;
+	}
+	c->items[--c->first] = item;
+	c->n_items++;
+	list->n_entries++;
+	return item;
+}
+
+/** Add an item to the tail of a list.
+ *
+ * Add a new item at the tail of an unrolled list.
+ *
+ * @param list Pointer to the list.
+ * @param item Pointer to item to add.
+ * @return Pointer to added item.
+ */
+void *cl_ulist_add_tail(struct cl_ulist *list, void *item) {
+	struct cl_ulist_chunk *c = list->tail;
+	if(c == NULL || c->n_items == CL_ULIST_ITEMS) {
+		c = cl_ulist_chunk_create(list, 0);
+		if(list->tail)
+			list->tail->next = c;
+		else
+			list->head = c;
+		list->tail = c;
+	} else if(cl_ulist_chunk_end(c) == CL_ULIST_ITEMS) {
+		/* Move items to the start of the chunk */
+		memmove(c->items, c->items + c->first,
+			c->n_items * sizeof(void *));
+		c->first = 0;
+	}
+	c->items[cl_ulist_chunk_end(c)] = item;
+	c->n_items++;
+	list->n_entries++;
+	return item;
+}
+
+/** Remove the item in one slot of a chunk.
+ *
+ * Later items of the chunk move down one slot.  An empty chunk is unlinked
+ * and released.
+ *
+ * @param list Pointer to the list.
+ * @param p Previous chunk (or NULL for head).
+ * @param c Chunk containing item.
+ * @param slot Slot of item to remove.
+ * @return Next chunk if c was released; c otherwise.
+ */
+static struct cl_ulist_chunk *cl_ulist_remove_slot(struct cl_ulist *list,
+	struct cl_ulist_chunk *p, struct cl_ulist_chunk *c, uint32_t slot)
+{
+	struct cl_ulist_chunk *next = c->next;
+	memmove(c->items + slot, c->items + slot + 1,
+		(cl_ulist_chunk_end(c) - slot - 1) * sizeof(void *));
+	c->n_items--;
+	list->n_entries--;
+	if(c->n_items)
+		return c;
+	if(p)
+		p->next = next;
+	else
+		list->head = next;
+	if(list->tail == c)
+		list->tail = p;
+	cl_pool_release(list->pool, c);
+	return next;
+}
+
+/** Remove an item from a list.
+ *
+ * Remove the specified item from an unrolled list.
+ *
+ * @param list Pointer to the list.
+ * @param item Pointer to the item to remove.
+ * @return Pointer to the removed item, or NULL if not found.
+ */
+void *cl_ulist_remove(struct cl_ulist *list, void *item) {
+	struct cl_ulist_chunk *c, *p = NULL;
+
+	for(c = list->head; c; c = c->next) {
+		uint32_t end = cl_ulist_chunk_end(c);
+		uint32_t i;
+		for(i = c->first; i < end; i++) {
+			if(c->items[i] == item) {
+				cl_ulist_remove_slot(list, p, c, i);
+				return item;
+			}
+		}
+		p = c;
+	}
+	return NULL;
+}
+
+/** Check if a list contains an item.
+ *
+ * Test if a list contains the specified item.
+ *
+ * @param list Pointer to the list.
+ * @param item Pointer to the item to check.
+ * @return true If the list contains the specified item; otherwise false.
+ */
+bool cl_ulist_contains(struct cl_ulist *list, void *item) {
+	struct cl_ulist_chunk *c;
+
+	for(c = list->head; c; c = c->next) {
+		uint32_t end = cl_ulist_chunk_end(c);
+		uint32_t i;
+		for(i = c->first; i < end; i++) {
+			if(c->items[i] == item)
+				return true;
+		}
+	}
+	return false;
+}
+
+/** Pop an item from a list.
+ *
+ * Remove the head item from an unrolled list.  This is useful for using the
+ * list as a stack or FIFO.
+ *
+ * @param list Pointer to the list.
+ * @return Pointer to the head item in the list, or NULL if the list is empty.
+ */
+void *cl_ulist_pop(struct cl_ulist *list) {
+	struct cl_ulist_chunk *c = list->head;
+	if(c) {
+		void *item = c->items[c->first++];
+		c->n_items--;
+		list->n_entries--;
+		if(c->n_items == 0) {
+			list->head = c->next;
+			if(list->tail == c)
+				list->tail = NULL;
+			cl_pool_release(list->pool, c);
+		}
+		return item;
+	} else
+		return NULL;
+}
+
+/** Clear an unrolled list.
+ *
+ * Remove all items from an unrolled list.
+ *
+ * @param list Pointer to the list.
+ */
+void cl_ulist_clear(struct cl_ulist *list) {
+	cl_pool_clear(list->pool);
+	list->head = NULL;
+	list->tail = NULL;
+	list->n_entries = 0;
+}
+
+/** Reserve room for items in an unrolled list.
+ *
+ * Allocate chunk memory up front, so that adding the next n items does not
+ * call malloc.
+ *
+ * @param list Pointer to the list.
+ * @param n Number of items to reserve room for.
+ */
+void cl_ulist_reserve(struct cl_ulist *list, uint32_t n) {
+	cl_pool_reserve(list->pool, (n + CL_ULIST_ITEMS - 1) / CL_ULIST_ITEMS);
+}
+
+/** Shrink an unrolled list.
+ *
+ * Free chunk memory which is not in use (after a clear).
+ *
+ * @param list Pointer to the list.
+ */
+void cl_ulist_shrink(struct cl_ulist *list) {
+	cl_pool_shrink(list->pool);
+}
+
+/** Add up memory statistics of an unrolled list.
+ *
+ * Live objects are chunks, not items.
+ *
+ * @param list Pointer to the list.
+ * @param stats Statistics to add to (see cl_pool_stats).
+ */
+void cl_ulist_stats(const struct cl_ulist *list, struct cl_pool_stats *stats)
+{
+	cl_pool_stats(list->pool, stats);
+	stats->n_bytes += sizeof(struct cl_ulist);
+}
+
+/** Create a list iterator.
+ *
+ * Create an iterator which can be used to iterate over items in a list.
+ *
+ * @param list Pointer to the list.
+ * @return Pointer to a list iterator.
+ */
+struct cl_ulist_iterator *cl_ulist_iterator_create(struct cl_ulist *list) {
+	struct cl_ulist_iterator *it = cl_pool_alloc(list->pool);
+	cl_ulist_iterator_init(it, list);
+	return it;
+}
+
+/** Initialize a list iterator.
+ *
+ * Initialize a caller's iterator (which can be on the stack) to iterate over
+ * items in a list.  It doesn't need to be destroyed.
+ *
+ * @param it Pointer to the iterator.
+ * @param list Pointer to the list.
+ */
+void cl_ulist_iterator_init(struct cl_ulist_iterator *it,
+	struct cl_ulist *list)
+{
+	it->list = list;
+	it->chunk = list->head;
+	it->prev = NULL;
+	it->slot = it->chunk ? it->chunk->first : 0;
+	it->pending = true;
+}
+
+/** Destroy a list iterator.
+ *
+ * @param it Pointer to the list iterator.
+ */
+void cl_ulist_iterator_destroy(struct cl_ulist_iterator *it) {
+	struct cl_ulist *list = it->list;
+#ifndef NDEBUG
+	it->list = NULL;
+	it->chunk = NULL;
+	it->prev = NULL;
+#endif
+	cl_pool_release(list->pool, it);
+}
+
+/** Get next item from an iterator.
+ *
+ * @param it Pointer to the iterator.
+ * @return Pointer to the next item, or NULL at end of list.
+ */
+void *cl_ulist_iterator_next(struct cl_ulist_iterator *it) {
+	struct cl_ulist_chunk *c = it->chunk;
+	if(!it->pending)
+		it->slot++;
+	it->pending = false;
+	while(c && it->slot >= cl_ulist_chunk_end(c)) {
+		it->prev = c;
+		c = c->next;
+		it->slot = c ? c->first : 0;
+	}
+	it->chunk = c;
+	return c ? c->items[it->slot] : NULL;
+}
+
+/** Remove current item from an iterator.
+ *
+ * The next call to cl_ulist_iterator_next returns the item after it.
+ *
+ * @param it Pointer to the iterator.
+ */
+void cl_ulist_iterator_remove(struct cl_ulist_iterator *it) {
+	struct cl_ulist_chunk *c = it->chunk;
+	if(c && !it->pending) {
+		struct cl_ulist_chunk *n = cl_ulist_remove_slot(it->list,
+			it->prev, c, it->slot);
+		if(n != c) {
+			it->chunk = n;
+			it->slot = n ? n->first : 0;
+		}
+		it->pending = true;
+	}
+}
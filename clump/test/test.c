@@ -0,0 +1,1127 @@
+/*
+ * test.c	Tests for clump containers
+ *
+ * Copyright (c) 2012  Douglas P Lau
+ */
+/** \file
+ *
+ * Each test checks one container, and prints what failed to stderr.
+ * The exit status is the number of tests which failed.
+ *
+ * Usage: test
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clump.h"
+#include "typed.h"
+#include "SDL_atomic.h"
+#include "SDL_rwops.h"
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+
+/** Number of keys added to each hash */
+#define TEST_KEYS	1000
+
+/** Report a failed check and return from a test */
+#define TEST_CHECK(cond) do {						\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%d: %s\n", __func__, __LINE__, #cond); \
+		return 1;						\
+	}								\
+} while (0)
+
+/** Add, remove and look up 8-byte keys in a hash set.
+ *
+ * Every other key is removed, so the hash shrinks and entries move between
+ * its tables while some keys are still there.
+ *
+ * @param hash		Hash set (empty, for 8-byte keys).
+ * @return 0 on success, 1 on failure.
+ */
+static int test_rhash_set(struct cl_rhash *hash) {
+	static uint64_t keys[TEST_KEYS];
+	for (uint64_t i = 0; i < TEST_KEYS; i++) {
+		keys[i] = i * 0x9E3779B97F4A7C15ull;
+		TEST_CHECK(cl_rhash_add(hash, &keys[i]) == NULL);
+	}
+	TEST_CHECK(cl_rhash_count(hash) == TEST_KEYS);
+	for (uint32_t i = 0; i < TEST_KEYS; i++) {
+		uint64_t key = keys[i];		/* equal, not the same */
+		TEST_CHECK(cl_rhash_contains(hash, &key));
+	}
+	for (uint32_t i = 0; i < TEST_KEYS; i += 2) {
+		uint64_t key = keys[i];
+		TEST_CHECK(cl_rhash_remove(hash, &key) != NULL);
+		TEST_CHECK(!cl_rhash_contains(hash, &key));
+		TEST_CHECK(cl_rhash_remove(hash, &key) == NULL);
+	}
+	TEST_CHECK(cl_rhash_count(hash) == TEST_KEYS / 2);
+	for (uint32_t i = 0; i < TEST_KEYS; i++) {
+		uint64_t key = keys[i];
+		TEST_CHECK(cl_rhash_contains(hash, &key) == (i % 2 == 1));
+	}
+	cl_rhash_destroy(hash);
+	return 0;
+}
+
+/** Test a hash set storing hash codes */
+static int test_rhash_set_hashed(void) {
+	return test_rhash_set(cl_rhash_create_set_hashed(sizeof(uint64_t)));
+}
+
+/** Test a hash set storing keys in the table */
+static int test_rhash_set_inline(void) {
+	return test_rhash_set(cl_rhash_create_set_inline(sizeof(uint64_t)));
+}
+
+/** Put, get and remove 8-byte keys in an fhash map.
+ *
+ * Enough keys are put for several groups of control bytes to be probed, and
+ * removing every other one leaves DELETED slots which later puts reuse.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_fhash_map(void) {
+	static uint64_t keys[TEST_KEYS];
+	struct cl_fhash *hash = cl_fhash_create_map(sizeof(uint64_t));
+	struct cl_fhash_iterator it;
+	const void *key;
+	uint32_t n_keys = 0;
+	for (uint64_t i = 0; i < TEST_KEYS; i++) {
+		keys[i] = i * 0x9E3779B97F4A7C15ull;
+		TEST_CHECK(cl_fhash_put(hash, &keys[i], &keys[i]) == NULL);
+	}
+	TEST_CHECK(cl_fhash_count(hash) == TEST_KEYS);
+	for (uint32_t i = 0; i < TEST_KEYS; i++) {
+		uint64_t key = keys[i];
+		TEST_CHECK(cl_fhash_get(hash, &key) == &keys[i]);
+	}
+	for (uint32_t i = 0; i < TEST_KEYS; i += 2) {
+		uint64_t key = keys[i];
+		TEST_CHECK(cl_fhash_remove(hash, &key) == &keys[i]);
+		TEST_CHECK(cl_fhash_get(hash, &key) == NULL);
+	}
+	TEST_CHECK(cl_fhash_count(hash) == TEST_KEYS / 2);
+	CL_FHASH_FOREACH(it, hash, key) {
+		TEST_CHECK(((const uint64_t *) key - keys) % 2 == 1);
+		TEST_CHECK(cl_fhash_iterator_value(&it) == key);
+		n_keys++;
+	}
+	TEST_CHECK(n_keys == TEST_KEYS / 2);
+	for (uint32_t i = 0; i < TEST_KEYS; i += 2)
+		TEST_CHECK(cl_fhash_put(hash, &keys[i], &keys[i]) == NULL);
+	TEST_CHECK(cl_fhash_count(hash) == TEST_KEYS);
+	cl_fhash_destroy(hash);
+	return 0;
+}
+
+/** Get an int key (or value) as a pointer */
+#define TEST_INT(i)	((void *) (intptr_t) (i))
+
+/** Put, seek and remove int keys in a B-tree map.
+ *
+ * The keys 1 to TEST_KEYS are put out of order, enough for the tree to have
+ * inner nodes, then every other one is removed so nodes are merged.
+ *
+ * @param tree		B-tree map (empty, int keys compared by value).
+ * @return 0 on success, 1 on failure.
+ */
+static int test_btree_map(struct cl_btree *tree) {
+	struct cl_btree_iterator it;
+	const void *key;
+	intptr_t last = 0;
+	for (int i = 0; i < TEST_KEYS; i++) {
+		int k = (i * 7919) % TEST_KEYS + 1;
+		TEST_CHECK(cl_btree_put(tree, TEST_INT(k), TEST_INT(-k)) == NULL);
+	}
+	TEST_CHECK(cl_btree_count(tree) == TEST_KEYS);
+	TEST_CHECK(cl_btree_peek(tree) == TEST_INT(1));
+	for (int k = 1; k <= TEST_KEYS; k++)
+		TEST_CHECK(cl_btree_get(tree, TEST_INT(k)) == TEST_INT(-k));
+	CL_BTREE_FOREACH(it, tree, key) {
+		TEST_CHECK((intptr_t) key == last + 1);
+		TEST_CHECK(cl_btree_iterator_value(&it) == TEST_INT(-last - 1));
+		last = (intptr_t) key;
+	}
+	TEST_CHECK(last == TEST_KEYS);
+	for (int k = 2; k <= TEST_KEYS; k += 2) {
+		TEST_CHECK(cl_btree_remove(tree, TEST_INT(k)) == TEST_INT(-k));
+		TEST_CHECK(!cl_btree_contains(tree, TEST_INT(k)));
+	}
+	TEST_CHECK(cl_btree_count(tree) == TEST_KEYS / 2);
+	/* A removed key seeks to the next one */
+	cl_btree_iterator_init(&it, tree);
+	cl_btree_iterator_seek(&it, TEST_INT(500));
+	TEST_CHECK(cl_btree_iterator_next(&it) == TEST_INT(501));
+	TEST_CHECK(cl_btree_iterator_next(&it) == TEST_INT(503));
+	cl_btree_iterator_seek(&it, TEST_INT(TEST_KEYS + 1));
+	TEST_CHECK(cl_btree_iterator_next(&it) == NULL);
+	cl_btree_destroy(tree);
+	return 0;
+}
+
+/** Test a B-tree with int keys searched by SIMD compares */
+static int test_btree_map_int(void) {
+	return test_btree_map(cl_btree_create_map_int());
+}
+
+/** Test a B-tree with keys compared by a callback */
+static int test_btree_map_compare(void) {
+	return test_btree_map(cl_btree_create_map(cl_compare_int));
+}
+
+/** Add the odd keys 1 to 2 * TEST_KEYS - 1 to a tree set, out of order.
+ *
+ * @param tree		Tree set (empty, compared by cl_compare_int).
+ * @return 0 on success, 1 on failure.
+ */
+static int test_tree_add_odd(struct cl_tree *tree) {
+	for (int i = 0; i < TEST_KEYS; i++) {
+		int k = 2 * ((i * 7919) % TEST_KEYS) + 1;
+		TEST_CHECK(cl_tree_add(tree, TEST_INT(k)) == NULL);
+	}
+	TEST_CHECK(cl_tree_count(tree) == TEST_KEYS);
+	return 0;
+}
+
+/** Test bounds, seeks and reverse iteration of a tree set.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_tree_range(void) {
+	struct cl_tree *tree = cl_tree_create_set(cl_compare_int);
+	struct cl_tree_iterator it;
+	const void *key;
+	intptr_t last = 2 * TEST_KEYS + 1;
+	if (test_tree_add_odd(tree))
+		return 1;
+	TEST_CHECK(cl_tree_lower_bound(tree, TEST_INT(0)) == TEST_INT(1));
+	TEST_CHECK(cl_tree_lower_bound(tree, TEST_INT(4)) == TEST_INT(5));
+	TEST_CHECK(cl_tree_lower_bound(tree, TEST_INT(5)) == TEST_INT(5));
+	TEST_CHECK(cl_tree_upper_bound(tree, TEST_INT(5)) == TEST_INT(7));
+	TEST_CHECK(cl_tree_upper_bound(tree, TEST_INT(2 * TEST_KEYS - 1))
+		== NULL);
+	/* Keys in [10, 14) */
+	cl_tree_iterator_init(&it, tree);
+	cl_tree_iterator_seek(&it, TEST_INT(10));
+	TEST_CHECK(cl_tree_iterator_next(&it) == TEST_INT(11));
+	TEST_CHECK(cl_tree_iterator_next(&it) == TEST_INT(13));
+	TEST_CHECK(cl_tree_iterator_next(&it) == TEST_INT(15));
+	CL_TREE_FOREACH_REVERSE(it, tree, key) {
+		TEST_CHECK((intptr_t) key == last - 2);
+		last = (intptr_t) key;
+	}
+	TEST_CHECK(last == 1);
+	cl_tree_iterator_init_reverse(&it, tree);
+	cl_tree_iterator_seek(&it, TEST_INT(10));
+	TEST_CHECK(cl_tree_iterator_next(&it) == TEST_INT(9));
+	TEST_CHECK(cl_tree_iterator_next(&it) == TEST_INT(7));
+	cl_tree_destroy(tree);
+	return 0;
+}
+
+/** Test rank and select of a ranked tree set, before and after removes.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_tree_ranked(void) {
+	struct cl_tree *tree = cl_tree_create_set_ranked(cl_compare_int);
+	if (test_tree_add_odd(tree))
+		return 1;
+	for (int j = 0; j < TEST_KEYS; j++) {
+		TEST_CHECK(cl_tree_select(tree, j) == TEST_INT(2 * j + 1));
+		TEST_CHECK(cl_tree_rank(tree, TEST_INT(2 * j + 1)) == (unsigned) j);
+		TEST_CHECK(cl_tree_rank(tree, TEST_INT(2 * j + 2)) ==
+			(unsigned) j + 1);
+	}
+	TEST_CHECK(cl_tree_select(tree, TEST_KEYS) == NULL);
+	/* Leaves 1, 5, 9, ... */
+	for (int k = 3; k < 2 * TEST_KEYS; k += 4)
+		TEST_CHECK(cl_tree_remove_key(tree, TEST_INT(k)) == TEST_INT(k));
+	TEST_CHECK(cl_tree_count(tree) == TEST_KEYS / 2);
+	for (int j = 0; j < TEST_KEYS / 2; j++) {
+		TEST_CHECK(cl_tree_select(tree, j) == TEST_INT(4 * j + 1));
+		TEST_CHECK(cl_tree_rank(tree, TEST_INT(4 * j + 3)) ==
+			(unsigned) j + 1);
+	}
+	TEST_CHECK(cl_tree_select(tree, TEST_KEYS / 2) == NULL);
+	cl_tree_destroy(tree);
+	return 0;
+}
+
+/** Check that every key has its own slot in a perfect hash table.
+ *
+ * @param tbl		Perfect hash table.
+ * @param keys		Keys of the table.
+ * @return 0 on success, 1 on failure.
+ */
+static int test_phash_slots(const struct cl_phash_table *tbl,
+	const void *const *keys)
+{
+	static uint8_t used[TEST_KEYS];
+	memset(used, 0, sizeof(used));
+	for (uint32_t i = 0; i < tbl->n_keys; i++) {
+		uint32_t s = cl_phash_get(tbl, keys[i]);
+		TEST_CHECK(s < tbl->n_keys && !used[s]);
+		TEST_CHECK(cl_phash_key(tbl, s) == keys[i]);
+		used[s] = 1;
+	}
+	return 0;
+}
+
+/** Build perfect hashes of string keys and of the 8-byte keys of a hash.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_phash(void) {
+	static char words[TEST_KEYS][8];
+	static const void *keys[TEST_KEYS];
+	static uint64_t ints[TEST_KEYS];
+	struct cl_rhash *hash = cl_rhash_create_set(sizeof(uint64_t));
+	const struct cl_phash_table *tbl;
+	struct cl_phash *ph;
+	uint64_t key;
+	for (int i = 0; i < TEST_KEYS; i++) {
+		snprintf(words[i], sizeof(words[i]), "k%d", i);
+		keys[i] = words[i];
+	}
+	ph = cl_phash_create(keys, TEST_KEYS, 0);
+	TEST_CHECK(ph != NULL);
+	tbl = cl_phash_table(ph);
+	TEST_CHECK(tbl->n_keys == TEST_KEYS);
+	TEST_CHECK(test_phash_slots(tbl, keys) == 0);
+	/* Not keys, though "k12" starts with one */
+	TEST_CHECK(cl_phash_get(tbl, "k") == TEST_KEYS);
+	TEST_CHECK(cl_phash_get(tbl, "k1000") == TEST_KEYS);
+	TEST_CHECK(cl_phash_get_bytes(tbl, "k12", 2) ==
+		cl_phash_get(tbl, "k1"));
+	TEST_CHECK(cl_phash_get_bytes(tbl, "k1x", 2) != TEST_KEYS);
+	cl_phash_destroy(ph);
+	/* One key */
+	ph = cl_phash_create(keys, 1, 0);
+	TEST_CHECK(ph != NULL);
+	TEST_CHECK(cl_phash_get(cl_phash_table(ph), "k0") == 0);
+	TEST_CHECK(cl_phash_get(cl_phash_table(ph), "k1") == 1);
+	cl_phash_destroy(ph);
+	for (int i = 0; i < TEST_KEYS; i++) {
+		ints[i] = i * 0x9E3779B97F4A7C15ull;
+		cl_rhash_add(hash, &ints[i]);
+	}
+	ph = cl_phash_create_rhash(hash, sizeof(uint64_t));
+	TEST_CHECK(ph != NULL);
+	tbl = cl_phash_table(ph);
+	for (int i = 0; i < TEST_KEYS; i++)
+		keys[i] = cl_phash_key(tbl, i);
+	TEST_CHECK(test_phash_slots(tbl, keys) == 0);
+	for (int i = 0; i < TEST_KEYS; i++) {
+		key = ints[i];
+		TEST_CHECK(*(const uint64_t *) cl_phash_key(tbl,
+			cl_phash_get(tbl, &key)) == key);
+		key++;
+		TEST_CHECK(cl_phash_get(tbl, &key) == TEST_KEYS);
+	}
+	TEST_CHECK(cl_phash_get_bytes(tbl, &key, 4) == TEST_KEYS);
+	cl_phash_destroy(ph);
+	cl_rhash_destroy(hash);
+	return 0;
+}
+
+/** Snapshot file written (and removed) by the tests */
+#define TEST_SNAP	"test.snap"
+
+/** Write and query snapshots of a B-tree map and a hash map.
+ *
+ * The B-tree has int keys (1, 3, 5, ...), the hash 8-byte keys, and both
+ * map to 8-byte values, which are copied into the snapshots.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_snap(void) {
+	static uint64_t keys[TEST_KEYS], values[TEST_KEYS];
+	struct cl_btree *tree = cl_btree_create_map_int();
+	struct cl_rhash *hash = cl_rhash_create_map(sizeof(uint64_t));
+	struct cl_snap *snap;
+	uint64_t key;
+	FILE *fp;
+	for (int i = 0; i < TEST_KEYS; i++) {
+		keys[i] = i * 0x9E3779B97F4A7C15ull;
+		values[i] = i * 3;
+		cl_btree_put(tree, TEST_INT(2 * i + 1), &values[i]);
+		cl_rhash_put(hash, &keys[i], &values[i]);
+	}
+	TEST_CHECK(cl_snap_write_btree(tree, 0, sizeof(uint64_t), TEST_SNAP));
+	cl_btree_destroy(tree);
+	snap = cl_snap_open(TEST_SNAP, NULL);
+	TEST_CHECK(snap != NULL);
+	TEST_CHECK(cl_snap_count(snap) == TEST_KEYS);
+	for (int i = 0; i < TEST_KEYS; i++) {
+		const uint64_t *v = cl_snap_get(snap, TEST_INT(2 * i + 1));
+		TEST_CHECK(v != NULL && *v == values[i]);
+		TEST_CHECK(!cl_snap_contains(snap, TEST_INT(2 * i)));
+		TEST_CHECK(cl_snap_key(snap, i) == TEST_INT(2 * i + 1));
+		TEST_CHECK(cl_snap_value(snap, i) == v);
+		TEST_CHECK(cl_snap_seek(snap, TEST_INT(2 * i)) == (unsigned) i);
+	}
+	TEST_CHECK(cl_snap_seek(snap, TEST_INT(2 * TEST_KEYS)) == TEST_KEYS);
+	cl_snap_close(snap);
+	TEST_CHECK(cl_snap_write_rhash(hash, sizeof(uint64_t),
+		sizeof(uint64_t), TEST_SNAP));
+	cl_rhash_destroy(hash);
+	snap = cl_snap_open(TEST_SNAP, NULL);
+	TEST_CHECK(snap != NULL);
+	TEST_CHECK(cl_snap_count(snap) == TEST_KEYS);
+	for (int i = 0; i < TEST_KEYS; i++) {
+		const uint64_t *v;
+		key = keys[i];
+		v = cl_snap_get(snap, &key);
+		TEST_CHECK(v != NULL && *v == values[i]);
+		key++;
+		TEST_CHECK(!cl_snap_contains(snap, &key));
+	}
+	cl_snap_close(snap);
+	/* Not a snapshot */
+	fp = fopen(TEST_SNAP, "wb");
+	TEST_CHECK(fp != NULL);
+	for (int i = 0; i < 100; i++)
+		fputs("not a snapshot\n", fp);
+	fclose(fp);
+	TEST_CHECK(cl_snap_open(TEST_SNAP, NULL) == NULL);
+	remove(TEST_SNAP);
+	TEST_CHECK(cl_snap_open(TEST_SNAP, NULL) == NULL);
+	return 0;
+}
+
+/** Push int items onto a heap out of order, and pop them in order.
+ *
+ * @param heap		Heap (empty, compared by cl_compare_int).
+ * @return 0 on success, 1 on failure.
+ */
+static int test_heap_sort(struct cl_heap *heap) {
+	for (int i = 0; i < TEST_KEYS; i++) {
+		int k = (i * 7919) % TEST_KEYS + 1;
+		cl_heap_push(heap, TEST_INT(k));
+		TEST_CHECK((intptr_t) cl_heap_peek(heap) <= k);
+	}
+	TEST_CHECK(cl_heap_count(heap) == TEST_KEYS);
+	for (int k = 1; k <= TEST_KEYS; k++) {
+		TEST_CHECK(cl_heap_peek(heap) == TEST_INT(k));
+		TEST_CHECK(cl_heap_pop(heap) == TEST_INT(k));
+	}
+	TEST_CHECK(cl_heap_is_empty(heap));
+	TEST_CHECK(cl_heap_pop(heap) == NULL);
+	cl_heap_destroy(heap);
+	return 0;
+}
+
+/** Test heaps of several arities, and handles of an indexed heap.
+ *
+ * Every third item of the indexed heap is removed by its handle, and every
+ * other one lowered below all the rest (to minus itself).
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_heap(void) {
+	static uint32_t handles[TEST_KEYS + 1];
+	struct cl_heap *heap = cl_heap_create_indexed(cl_compare_int);
+	intptr_t last = -TEST_KEYS - 1;
+	uint32_t n = TEST_KEYS;
+	if (test_heap_sort(cl_heap_create(cl_compare_int)) ||
+	    test_heap_sort(cl_heap_create_ex(cl_compare_int, 2, false)) ||
+	    test_heap_sort(cl_heap_create_ex(cl_compare_int, 8, true)))
+		return 1;
+	cl_heap_reserve(heap, TEST_KEYS);
+	for (int i = 0; i < TEST_KEYS; i++) {
+		int k = (i * 7919) % TEST_KEYS + 1;
+		handles[k] = cl_heap_push(heap, TEST_INT(k));
+		TEST_CHECK(handles[k] != CL_HEAP_NONE);
+	}
+	for (int k = 1; k <= TEST_KEYS; k++) {
+		TEST_CHECK(cl_heap_get(heap, handles[k]) == TEST_INT(k));
+		if (k % 3 == 0) {
+			TEST_CHECK(cl_heap_remove(heap, handles[k]) ==
+				TEST_INT(k));
+			n--;
+		} else if (k % 2 == 0) {
+			cl_heap_decrease_key(heap, handles[k], TEST_INT(-k));
+			TEST_CHECK(cl_heap_get(heap, handles[k]) ==
+				TEST_INT(-k));
+		}
+	}
+	TEST_CHECK(cl_heap_count(heap) == n);
+	while (!cl_heap_is_empty(heap)) {
+		intptr_t k = (intptr_t) cl_heap_pop(heap);
+		TEST_CHECK(k > last && k % 3 != 0);
+		TEST_CHECK(k < 0 ? -k % 2 == 0 : k % 2 == 1);
+		last = k;
+		n--;
+	}
+	TEST_CHECK(n == 0);
+	/* Handles are reused */
+	handles[0] = cl_heap_push(heap, TEST_INT(1));
+	TEST_CHECK(handles[0] < TEST_KEYS);
+	cl_heap_clear(heap);
+	TEST_CHECK(cl_heap_count(heap) == 0);
+	cl_heap_destroy(heap);
+	/* No handles */
+	heap = cl_heap_create(cl_compare_int);
+	TEST_CHECK(cl_heap_push(heap, TEST_INT(1)) == CL_HEAP_NONE);
+	cl_heap_destroy(heap);
+	return 0;
+}
+
+/** Push TEST_KEYS items onto a ring (a thread).
+ *
+ * Items are 1 to TEST_KEYS, pushed again until there's room.
+ */
+static int test_ring_producer(void *ring) {
+	for (intptr_t i = 1; i <= TEST_KEYS; i++) {
+		while (!cl_ring_push(ring, TEST_INT(i)))
+			SDL_Delay(0);
+	}
+	return 0;
+}
+
+/** Test a ring full, empty and between a producer thread and this one.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_ring(void) {
+	struct cl_ring *ring = cl_ring_create(100);
+	SDL_Thread *thread;
+	uint32_t n = 0;
+	while (cl_ring_push(ring, TEST_INT(n + 1)))
+		n++;
+	TEST_CHECK(n == 128);		/* rounded up to a power of 2 */
+	TEST_CHECK(cl_ring_count(ring) == n);
+	for (intptr_t i = 1; i <= n; i++)
+		TEST_CHECK(cl_ring_pop(ring) == TEST_INT(i));
+	TEST_CHECK(cl_ring_pop(ring) == NULL);
+	thread = SDL_CreateThread(test_ring_producer, "ring", ring);
+	TEST_CHECK(thread != NULL);
+	for (intptr_t i = 1; i <= TEST_KEYS; i++) {
+		void *item;
+		while ((item = cl_ring_pop(ring)) == NULL)
+			SDL_Delay(0);
+		TEST_CHECK(item == TEST_INT(i));
+	}
+	SDL_WaitThread(thread, NULL);
+	TEST_CHECK(cl_ring_count(ring) == 0);
+	cl_ring_destroy(ring);
+	return 0;
+}
+
+/** Queue producer threads */
+#define TEST_PRODUCERS	4
+
+/** Push TEST_KEYS items onto a queue (a thread).
+ *
+ * Each producer's items are its number * TEST_KEYS plus 1 to TEST_KEYS.
+ */
+static int test_queue_producer(void *queue) {
+	static SDL_atomic_t n_producer;
+	intptr_t base = SDL_AtomicAdd(&n_producer, 1) * TEST_KEYS;
+	for (intptr_t i = 1; i <= TEST_KEYS; i++) {
+		while (!cl_queue_push(queue, TEST_INT(base + i)))
+			SDL_Delay(0);
+	}
+	return 0;
+}
+
+/** Test a queue with several producer threads.
+ *
+ * Items from one producer are popped in the order pushed, and every item is
+ * popped once.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_queue(void) {
+	struct cl_queue *queue = cl_queue_create(64);
+	SDL_Thread *threads[TEST_PRODUCERS];
+	intptr_t last[TEST_PRODUCERS] = { 0 };
+	for (int i = 0; i < TEST_PRODUCERS; i++) {
+		threads[i] = SDL_CreateThread(test_queue_producer, "queue",
+			queue);
+		TEST_CHECK(threads[i] != NULL);
+	}
+	for (int n = 0; n < TEST_PRODUCERS * TEST_KEYS; n++) {
+		intptr_t item, p;
+		while ((item = (intptr_t) cl_queue_pop(queue)) == 0)
+			SDL_Delay(0);
+		p = (item - 1) / TEST_KEYS;
+		TEST_CHECK(p < TEST_PRODUCERS);
+		TEST_CHECK(item - p * TEST_KEYS == last[p] + 1);
+		last[p]++;
+	}
+	for (int i = 0; i < TEST_PRODUCERS; i++)
+		SDL_WaitThread(threads[i], NULL);
+	TEST_CHECK(cl_queue_pop(queue) == NULL);
+	cl_queue_destroy(queue);
+	return 0;
+}
+
+/** Number of values in the bit set tests (four chunks) */
+#define TEST_BITS	(4 << 16)
+
+/** Check a bit set against the values flagged in an array.
+ *
+ * @param bs		Bit set (values less than TEST_BITS).
+ * @param ref		Flag for each value.
+ * @return 0 on success, 1 on failure.
+ */
+static int test_bitset_check(const struct cl_bitset *bs, const uint8_t *ref) {
+	struct cl_bitset_iterator it;
+	uint64_t n = 0;
+	uint32_t v, prev = 0;
+	for (v = 0; v < TEST_BITS; v++) {
+		TEST_CHECK(cl_bitset_contains(bs, v) == ref[v]);
+		n += ref[v];
+	}
+	TEST_CHECK(cl_bitset_count(bs) == n);
+	TEST_CHECK(cl_bitset_is_empty(bs) == (n == 0));
+	CL_BITSET_FOREACH(it, bs, v) {
+		TEST_CHECK(v < TEST_BITS && ref[v]);
+		TEST_CHECK(v > prev || n == cl_bitset_count(bs));
+		prev = v;
+		n--;
+	}
+	TEST_CHECK(n == 0);
+	return 0;
+}
+
+/** Test a bit set, and the set operations on two of them.
+ *
+ * Multiples of 3 fill the first two chunks (as bitmaps), and multiples of
+ * 1000 the last one (an array).  The other set has all multiples of 5.
+ * Removing most of a bitmap turns it back into an array.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_bitset(void) {
+	static uint8_t ref_a[TEST_BITS], ref_b[TEST_BITS], ref[TEST_BITS];
+	struct cl_bitset *a = cl_bitset_create();
+	struct cl_bitset *b = cl_bitset_create();
+	struct cl_bitset *c;
+	uint32_t v;
+	TEST_CHECK(test_bitset_check(a, ref_a) == 0);
+	for (v = 0; v < TEST_BITS; v++) {
+		ref_a[v] = v < (2 << 16) ? v % 3 == 0 : v >= (3 << 16) &&
+			v % 1000 == 0;
+		ref_b[v] = v % 5 == 0;
+	}
+	/* Add them backwards */
+	for (v = TEST_BITS; v-- > 0; ) {
+		if (ref_b[v])
+			TEST_CHECK(cl_bitset_add(b, v));
+	}
+	for (v = 0; v < TEST_BITS; v++) {
+		if (ref_a[v]) {
+			TEST_CHECK(cl_bitset_add(a, v));
+			TEST_CHECK(!cl_bitset_add(a, v));
+		}
+	}
+	TEST_CHECK(test_bitset_check(a, ref_a) == 0);
+	TEST_CHECK(test_bitset_check(b, ref_b) == 0);
+	TEST_CHECK(!cl_bitset_contains(a, UINT32_MAX));
+	TEST_CHECK(cl_bitset_add(a, UINT32_MAX));
+	TEST_CHECK(cl_bitset_contains(a, UINT32_MAX));
+	TEST_CHECK(cl_bitset_remove(a, UINT32_MAX));
+	TEST_CHECK(!cl_bitset_remove(a, UINT32_MAX));
+	/* Shrink the second chunk to an array */
+	for (v = 1 << 16; v < (2 << 16) - 300; v++) {
+		if (ref_a[v]) {
+			TEST_CHECK(cl_bitset_remove(a, v));
+			ref_a[v] = 0;
+		}
+	}
+	TEST_CHECK(test_bitset_check(a, ref_a) == 0);
+	c = cl_bitset_copy(a);
+	TEST_CHECK(cl_bitset_equals(a, c));
+	cl_bitset_union(c, b);
+	TEST_CHECK(!cl_bitset_equals(a, c));
+	for (v = 0; v < TEST_BITS; v++)
+		ref[v] = ref_a[v] || ref_b[v];
+	TEST_CHECK(test_bitset_check(c, ref) == 0);
+	cl_bitset_destroy(c);
+	c = cl_bitset_copy(a);
+	cl_bitset_intersect(c, b);
+	for (v = 0; v < TEST_BITS; v++)
+		ref[v] = ref_a[v] && ref_b[v];
+	TEST_CHECK(test_bitset_check(c, ref) == 0);
+	cl_bitset_destroy(c);
+	c = cl_bitset_copy(a);
+	cl_bitset_difference(c, b);
+	for (v = 0; v < TEST_BITS; v++)
+		ref[v] = ref_a[v] && !ref_b[v];
+	TEST_CHECK(test_bitset_check(c, ref) == 0);
+	cl_bitset_difference(c, a);
+	TEST_CHECK(cl_bitset_is_empty(c));
+	cl_bitset_clear(a);
+	memset(ref_a, 0, sizeof(ref_a));
+	TEST_CHECK(test_bitset_check(a, ref_a) == 0);
+	TEST_CHECK(cl_bitset_equals(a, c));
+	cl_bitset_destroy(a);
+	cl_bitset_destroy(b);
+	cl_bitset_destroy(c);
+	return 0;
+}
+
+/** Expired timers, checked by test_twheel_expire */
+struct test_twheel {
+	uint64_t	deadline[TEST_KEYS];	/**< tick of each timer */
+	uint8_t		expired[TEST_KEYS];	/**< timer has expired */
+	uint64_t	after;			/**< last tick advanced to */
+	uint64_t	now;			/**< tick advancing to */
+};
+
+/** Check an expired timer (a cl_twheel_cb) */
+static void test_twheel_expire(void *ctx, void *item) {
+	struct test_twheel *tw = ctx;
+	intptr_t i = (intptr_t) item;
+	/* Only once, and only in the ticks just advanced over */
+	tw->expired[i] = !tw->expired[i] && tw->deadline[i] > tw->after &&
+		tw->deadline[i] <= tw->now;
+}
+
+/** Test a timer wheel advanced by hand, and one with a timer thread.
+ *
+ * Timers are spread over the first three levels, with one on the top
+ * level, and every fifth one is cancelled.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_twheel(void) {
+	static struct test_twheel tw;
+	static uint64_t timers[TEST_KEYS];
+	struct cl_twheel *wheel = cl_twheel_create(100);
+	struct cl_queue *queue = cl_queue_create(16);
+	uint32_t n = 0;
+	void *item = NULL;
+	for (int i = 0; i < TEST_KEYS; i++) {
+		uint64_t delay = (i * 7919) % TEST_KEYS * 97;
+		if (i == TEST_KEYS - 1)
+			delay = 1 << 25;
+		tw.deadline[i] = 100 + delay;
+		timers[i] = cl_twheel_add(wheel, delay, TEST_INT(i));
+	}
+	TEST_CHECK(cl_twheel_count(wheel) == TEST_KEYS);
+	for (int i = 0; i < TEST_KEYS; i += 5) {
+		TEST_CHECK(cl_twheel_cancel(wheel, timers[i]));
+		TEST_CHECK(!cl_twheel_cancel(wheel, timers[i]));
+	}
+	TEST_CHECK(cl_twheel_count(wheel) == TEST_KEYS - TEST_KEYS / 5);
+	tw.after = 99;
+	for (tw.now = 99; cl_twheel_count(wheel) > 0; tw.now += 1000) {
+		n += cl_twheel_advance(wheel, tw.now, test_twheel_expire, &tw);
+		TEST_CHECK(cl_twheel_now(wheel) == tw.now + 1);
+		tw.after = tw.now;
+	}
+	TEST_CHECK(n == TEST_KEYS - TEST_KEYS / 5);
+	for (int i = 0; i < TEST_KEYS; i++)
+		TEST_CHECK(tw.expired[i] == (i % 5 != 0));
+	/* An expired timer can't be cancelled */
+	TEST_CHECK(!cl_twheel_cancel(wheel, timers[1]));
+	/* 1 ms ticks, to a queue */
+	TEST_CHECK(cl_twheel_start(wheel, 1, queue));
+	cl_twheel_add(wheel, 5, TEST_INT(1));
+	for (int ms = 0; ms < 5000 && item == NULL; ms++) {
+		item = cl_queue_pop(queue);
+		if (item == NULL)
+			SDL_Delay(1);
+	}
+	TEST_CHECK(item == TEST_INT(1));
+	cl_twheel_stop(wheel);
+	TEST_CHECK(cl_twheel_count(wheel) == 0);
+	cl_twheel_destroy(wheel);
+	cl_queue_destroy(queue);
+	return 0;
+}
+
+/** Fill a buffer with text-like bytes (letters skewed like English).
+ *
+ * @param buf		Buffer to fill.
+ * @param n		Number of bytes.
+ * @param seed		Seed (one text per seed).
+ */
+static void test_text(unsigned char *buf, size_t n, uint64_t seed) {
+	static const char letters[64] =
+		"eeeeeeeetttttaaaaaooooiiiinnnsssshhhrrrddllcumwfgypbvkjxqz      ";
+	for (size_t i = 0; i < n; i++) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		buf[i] = letters[seed >> 58];
+	}
+}
+
+/** Encode and decode a buffer with the per-block codebook.
+ *
+ * @param in		Buffer to encode.
+ * @param n		Number of bytes (compressible).
+ * @return 0 on success, 1 on failure.
+ */
+static int test_hcodec_round_trip(const unsigned char *in, unsigned int n) {
+	struct cl_hcodec *hc = cl_hcodec_create();
+	unsigned char *enc = malloc(n + 1024);
+	unsigned char *dec = malloc(n);
+	int n_enc = cl_hcodec_encode(hc, in, n, enc, n + 1024);
+	TEST_CHECK(n_enc > 0 && (unsigned) n_enc < n);
+	TEST_CHECK(cl_hcodec_decode(hc, enc, n_enc, dec, n) == (int) n);
+	TEST_CHECK(memcmp(in, dec, n) == 0);
+	cl_hcodec_destroy(hc);
+	free(enc);
+	free(dec);
+	return 0;
+}
+
+/** Encode and decode bytes with exponentially skewed counts.
+ *
+ * Symbol k is 1 / 2^(k+1) of the bytes, so its code is k+1 bits long (the
+ * last two symbols' are both n_symbols bits).
+ *
+ * @param n_symbols	Number of symbols (longest code in bits).
+ * @return 0 on success, 1 on failure.
+ */
+static int test_hcodec_skewed(unsigned int n_symbols) {
+	const unsigned int n = 1 << 20;
+	unsigned char *skewed = malloc(n);
+	unsigned int i = 0;
+	for (unsigned int k = 0; k + 1 < n_symbols; k++) {
+		for (unsigned int c = 0; c < n >> (k + 1); c++)
+			skewed[i++] = k * 7;
+	}
+	while (i < n)
+		skewed[i++] = (n_symbols - 1) * 7;
+	/* Interleave the symbols a little */
+	for (i = 0; i < n / 2; i += 3) {
+		unsigned char b = skewed[i];
+		skewed[i] = skewed[n - 1 - i];
+		skewed[n - 1 - i] = b;
+	}
+	if (test_hcodec_round_trip(skewed, n))
+		return 1;
+	free(skewed);
+	return 0;
+}
+
+/** Test the huffman codec's decoders.
+ *
+ * A 4K block of text only has short codes, decoded by the first table.
+ * Codes of up to 16 bits need the second-level tables, and codes of 20 bits
+ * don't fit them, so that block is decoded by walking the tree.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_hcodec(void) {
+	static unsigned char text[CL_HCODEC_BLOCK_SIZE];
+	test_text(text, sizeof(text), 1);
+	return test_hcodec_round_trip(text, sizeof(text)) ||
+	       test_hcodec_skewed(16) ||
+	       test_hcodec_skewed(20);
+}
+
+/** Test a shared codebook, trained by one codec and set on another.
+ *
+ * Small blocks encoded with it are smaller than with their own codebook.
+ * Every symbol has a code, even ones not in the sample.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_hcodec_shared(void) {
+	static unsigned char sample[16384];
+	unsigned char block[300], enc[1024], dec[300], book[256];
+	struct cl_hcodec *a = cl_hcodec_create();
+	struct cl_hcodec *b = cl_hcodec_create();
+	int n;
+	TEST_CHECK(!cl_hcodec_get_codebook(a, book));
+	TEST_CHECK(cl_hcodec_encode_shared(a, block, sizeof(block), enc,
+		sizeof(enc)) == -1);
+	test_text(sample, sizeof(sample), 1);
+	cl_hcodec_train(a, sample, sizeof(sample));
+	TEST_CHECK(cl_hcodec_get_codebook(a, book));
+	TEST_CHECK(cl_hcodec_set_codebook(b, book));
+	for (uint64_t seed = 2; seed < 6; seed++) {
+		test_text(block, sizeof(block), seed);
+		n = cl_hcodec_encode_shared(a, block, sizeof(block), enc,
+			sizeof(enc));
+		TEST_CHECK(n > 0 && n < (int) sizeof(block));
+		TEST_CHECK(cl_hcodec_decode_shared(b, enc, n, dec, sizeof(dec))
+			== sizeof(dec));
+		TEST_CHECK(memcmp(block, dec, sizeof(block)) == 0);
+		/* Its own codebook in between */
+		TEST_CHECK(cl_hcodec_encode(a, block, sizeof(block), enc,
+			sizeof(enc)) > n);
+	}
+	/* Bytes not in the sample */
+	for (unsigned int i = 0; i < sizeof(block); i++)
+		block[i] = i;
+	n = cl_hcodec_encode_shared(a, block, sizeof(block), enc, sizeof(enc));
+	TEST_CHECK(n > 0);
+	TEST_CHECK(cl_hcodec_decode_shared(b, enc, n, dec, sizeof(dec))
+		== sizeof(dec));
+	TEST_CHECK(memcmp(block, dec, sizeof(block)) == 0);
+	TEST_CHECK(cl_hcodec_encode_shared(a, block, sizeof(block), enc, 10)
+		== -1);
+	/* Too many short codes */
+	memset(book, 1, sizeof(book));
+	TEST_CHECK(!cl_hcodec_set_codebook(b, book));
+	cl_hcodec_destroy(a);
+	cl_hcodec_destroy(b);
+	return 0;
+}
+
+/** Run jobs last to first (on this thread), as a cl_run_jobs_cb */
+static void test_run_jobs(cl_job_cb *run, void **jobs, uint32_t n_jobs) {
+	while (n_jobs > 0)
+		run(jobs[--n_jobs]);
+}
+
+/** Test encoding a buffer as blocks, and decoding all or one of them.
+ *
+ * The buffer is text but for one block of random bytes, which is stored
+ * raw, and ends with a partial block.  There are enough blocks for several
+ * jobs, which the callback runs in reverse.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_hcodec_blocks(void) {
+	const uint32_t n_blocks = 40;
+	const size_t n = (n_blocks - 1) * CL_HCODEC_BLOCK_SIZE + 1000;
+	const size_t n_enc = cl_hcodec_blocks_bound(n);
+	unsigned char *in = malloc(n);
+	unsigned char *enc = malloc(n_enc);
+	unsigned char *dec = malloc(n);
+	struct cl_hcodec *hc = cl_hcodec_create();
+	uint64_t seed = 2;
+	size_t m;
+	test_text(in, n, 1);
+	for (size_t i = 3 * CL_HCODEC_BLOCK_SIZE;
+	     i < 4 * CL_HCODEC_BLOCK_SIZE; i++)
+	{
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		in[i] = seed >> 56;
+	}
+	m = cl_hcodec_encode_blocks(in, n, enc, n_enc, test_run_jobs);
+	TEST_CHECK(m > 0 && m < n);
+	TEST_CHECK(cl_hcodec_encode_blocks(in, n, enc, n_enc, NULL) == m);
+	TEST_CHECK(cl_hcodec_blocks_size(enc, m) == n);
+	TEST_CHECK(cl_hcodec_blocks_count(enc, m) == n_blocks);
+	TEST_CHECK(cl_hcodec_decode_blocks(enc, m, dec, n, test_run_jobs));
+	TEST_CHECK(memcmp(in, dec, n) == 0);
+	memset(dec, 0, n);
+	TEST_CHECK(cl_hcodec_decode_blocks(enc, m, dec, n, NULL));
+	TEST_CHECK(memcmp(in, dec, n) == 0);
+	/* The raw block, and the partial last one */
+	TEST_CHECK(cl_hcodec_decode_block(hc, enc, m, 3, dec,
+		CL_HCODEC_BLOCK_SIZE) == CL_HCODEC_BLOCK_SIZE);
+	TEST_CHECK(memcmp(in + 3 * CL_HCODEC_BLOCK_SIZE, dec,
+		CL_HCODEC_BLOCK_SIZE) == 0);
+	TEST_CHECK(cl_hcodec_decode_block(hc, enc, m, n_blocks - 1, dec,
+		CL_HCODEC_BLOCK_SIZE) == 1000);
+	TEST_CHECK(memcmp(in + n - 1000, dec, 1000) == 0);
+	TEST_CHECK(cl_hcodec_decode_block(hc, enc, m, n_blocks, dec,
+		CL_HCODEC_BLOCK_SIZE) == -1);
+	/* Truncated */
+	TEST_CHECK(!cl_hcodec_decode_blocks(enc, m - 1, dec, n, NULL));
+	cl_hcodec_destroy(hc);
+	free(in);
+	free(enc);
+	free(dec);
+	return 0;
+}
+
+/** Compare two 64-bit keys for qsort */
+static int test_compare_u64(const void *a, const void *b) {
+	uint64_t ka = *(const uint64_t *) a;
+	uint64_t kb = *(const uint64_t *) b;
+	return ka < kb ? -1 : ka > kb;
+}
+
+/** Compare keys for the typed sort */
+#define TEST_LESS(a, b)	((a) < (b))
+
+CL_SORT_DEFINE(test_pdq, uint64_t, TEST_LESS)
+
+/** Number of keys in the sort tests (several parallel chunks) */
+#define TEST_SORT_KEYS	(300000)
+
+/** Sort 64-bit keys with each sort, and compare with qsort.
+ *
+ * @param keys		Keys to sort (unchanged).
+ * @param n		Number of keys.
+ * @return 0 on success, 1 on failure.
+ */
+static int test_sort_keys(const uint64_t *keys, size_t n) {
+	uint64_t *ref = malloc(n * sizeof(uint64_t));
+	uint64_t *a = malloc(n * sizeof(uint64_t));
+	uint32_t *b = malloc(n * sizeof(uint32_t));
+	memcpy(ref, keys, n * sizeof(uint64_t));
+	qsort(ref, n, sizeof(uint64_t), test_compare_u64);
+	memcpy(a, keys, n * sizeof(uint64_t));
+	cl_sort_u64(a, n);
+	TEST_CHECK(memcmp(a, ref, n * sizeof(uint64_t)) == 0);
+	memcpy(a, keys, n * sizeof(uint64_t));
+	cl_sort_u64_parallel(a, n, test_run_jobs);
+	TEST_CHECK(memcmp(a, ref, n * sizeof(uint64_t)) == 0);
+	memcpy(a, keys, n * sizeof(uint64_t));
+	cl_sort_u64_parallel(a, n, NULL);
+	TEST_CHECK(memcmp(a, ref, n * sizeof(uint64_t)) == 0);
+	memcpy(a, keys, n * sizeof(uint64_t));
+	test_pdq_sort(a, n);
+	TEST_CHECK(memcmp(a, ref, n * sizeof(uint64_t)) == 0);
+	/* The low halves */
+	for (size_t i = 0; i < n; i++)
+		b[i] = keys[i];
+	cl_sort_u32(b, n);
+	for (size_t i = 1; i < n; i++)
+		TEST_CHECK(b[i - 1] <= b[i]);
+	free(ref);
+	free(a);
+	free(b);
+	return 0;
+}
+
+/** Test the sorts and searches.
+ *
+ * Keys are random, then only use their low bits (so passes are skipped),
+ * then have many duplicates; the first 10 are insertion sorted.  Records
+ * sorted by a big-endian key keep the order of equal keys.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_sort(void) {
+	const size_t n = TEST_SORT_KEYS;
+	uint64_t *keys = malloc(n * sizeof(uint64_t));
+	uint32_t *sorted = malloc(n * sizeof(uint32_t));
+	unsigned char (*recs)[8] = malloc(n * sizeof(*recs));
+	uint64_t seed = 1;
+	for (size_t i = 0; i < n; i++) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		keys[i] = seed ^ (seed >> 29);
+	}
+	if (test_sort_keys(keys, 10) || test_sort_keys(keys, n))
+		return 1;
+	for (size_t i = 0; i < n; i++)
+		keys[i] &= 0xFFFFF;
+	if (test_sort_keys(keys, n))
+		return 1;
+	for (size_t i = 0; i < n; i++)
+		keys[i] = (keys[i] % 100) << 40;
+	if (test_sort_keys(keys, n))
+		return 1;
+	/* Key 0 to 999 (big-endian), then the index it started at */
+	for (size_t i = 0; i < n; i++) {
+		uint32_t k = (i * 7919) % 1000;
+		recs[i][0] = 0;
+		recs[i][1] = 0;
+		recs[i][2] = k >> 8;
+		recs[i][3] = k;
+		k = i;
+		memcpy(recs[i] + 4, &k, sizeof(k));
+	}
+	cl_sort_bytes(recs, n, sizeof(*recs), 4);
+	for (size_t i = 1; i < n; i++) {
+		uint32_t j, k;
+		int c = memcmp(recs[i - 1], recs[i], 4);
+		memcpy(&j, recs[i - 1] + 4, sizeof(j));
+		memcpy(&k, recs[i] + 4, sizeof(k));
+		TEST_CHECK(c < 0 || (c == 0 && j < k));
+	}
+	/* Even keys, each twice */
+	for (size_t i = 0; i < n; i++)
+		sorted[i] = i / 2 * 2;
+	for (uint32_t key = 0; key < 1000; key++) {
+		size_t lb = (key + 1) / 2 * 2;
+		TEST_CHECK(cl_search_u32(sorted, n, key) == lb);
+		TEST_CHECK(cl_search_u32(sorted, 7, key) == (lb < 7 ? lb : 7));
+	}
+	TEST_CHECK(cl_search_u32(sorted, n, n) == n);
+	TEST_CHECK(cl_search_u32(sorted, 0, 0) == 0);
+	for (size_t i = 0; i < n; i++)
+		keys[i] = (uint64_t) i << 33;
+	for (size_t i = 0; i < n; i += 997) {
+		TEST_CHECK(cl_search_u64(keys, n, keys[i]) == i);
+		TEST_CHECK(cl_search_u64(keys, n, keys[i] + 1) == i + 1);
+	}
+	TEST_CHECK(cl_search_u64(keys, n, UINT64_MAX) == n);
+	free(keys);
+	free(sorted);
+	free(recs);
+	return 0;
+}
+
+/** Write a buffer through a compressing RWops, and read it back.
+ *
+ * The buffer is written and read in odd-sized pieces, so they span blocks.
+ * One block is random bytes, which are stored raw.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int test_hstream(void) {
+	const size_t n = 5 * CL_HCODEC_BLOCK_SIZE + 123;
+	unsigned char *in = malloc(n);
+	unsigned char *enc = malloc(2 * n);
+	unsigned char *dec = malloc(n);
+	SDL_RWops *mem = SDL_RWFromMem(enc, 2 * n);
+	SDL_RWops *rw = cl_hstream_writer(mem, false);
+	uint64_t seed = 2;
+	size_t m, i;
+	test_text(in, n, 1);
+	for (i = CL_HCODEC_BLOCK_SIZE; i < 2 * CL_HCODEC_BLOCK_SIZE; i++) {
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		in[i] = seed >> 56;
+	}
+	TEST_CHECK(rw != NULL);
+	for (i = 0; i < n; i += 1000) {
+		size_t len = n - i < 1000 ? n - i : 1000;
+		TEST_CHECK(SDL_RWwrite(rw, in + i, 1, len) == len);
+		TEST_CHECK(SDL_RWtell(rw) == (Sint64) (i + len));
+	}
+	TEST_CHECK(SDL_RWread(rw, dec, 1, 1) == 0);
+	TEST_CHECK(SDL_RWseek(rw, 0, RW_SEEK_SET) < 0);
+	TEST_CHECK(SDL_RWclose(rw) == 0);
+	m = SDL_RWtell(mem);
+	TEST_CHECK(m > 0 && m < n);
+	SDL_RWclose(mem);
+	rw = cl_hstream_reader(SDL_RWFromConstMem(enc, m), true);
+	TEST_CHECK(rw != NULL);
+	for (i = 0; i < n; i += 777) {
+		size_t len = n - i < 777 ? n - i : 777;
+		TEST_CHECK(SDL_RWread(rw, dec + i, 1, 777) == len);
+	}
+	TEST_CHECK(SDL_RWread(rw, dec, 1, 1) == 0);
+	TEST_CHECK(SDL_RWtell(rw) == (Sint64) n);
+	TEST_CHECK(memcmp(in, dec, n) == 0);
+	TEST_CHECK(SDL_RWwrite(rw, in, 1, 1) == 0);
+	TEST_CHECK(SDL_RWclose(rw) == 0);
+	/* Truncated */
+	rw = cl_hstream_reader(SDL_RWFromConstMem(enc, m - 1), true);
+	TEST_CHECK(SDL_RWread(rw, dec, 1, n) < n);
+	TEST_CHECK(SDL_RWclose(rw) < 0);
+	free(in);
+	free(enc);
+	free(dec);
+	return 0;
+}
+
+int main(void) {
+	int failed = 0;
+	failed += test_rhash_set_hashed();
+	failed += test_rhash_set_inline();
+	failed += test_fhash_map();
+	failed += test_btree_map_int();
+	failed += test_btree_map_compare();
+	failed += test_tree_range();
+	failed += test_tree_ranked();
+	failed += test_snap();
+	failed += test_phash();
+	failed += test_heap();
+	failed += test_bitset();
+	failed += test_ring();
+	failed += test_queue();
+	failed += test_twheel();
+	failed += test_hcodec();
+	failed += test_hcodec_blocks();
+	failed += test_hcodec_shared();
+	failed += test_hstream();
+	failed += test_sort();
+	return failed;
+}
@@ -0,0 +1,82 @@
+// Arenas: objects that live as long as the compile ( or a module ) are bump
+// allocated from large blocks & freed together, a block at a time.  Each
+// module has its own arena, so parse jobs on worker threads don't share one.
+
+#define C2M_ARENA_BLOCK 65536
+
+typedef struct c2m_arena_block{
+	struct c2m_arena_block* prev;
+}c2m_arena_block_t;
+
+typedef struct{
+	c2m_arena_block_t* block; // Current block, links to the older ones
+	uint32_t used; // Bytes used in the current block
+	uint32_t size; // Of the current block
+}c2m_arena_t;
+
+static c2m_arena_t* c2m_arena_create(void) {
+	c2m_arena_t* arena = malloc(sizeof(c2m_arena_t));
+
+	arena->block = NULL;
+	arena->used = 0;
+	arena->size = 0;
+	return arena;
+}
+
+// `n` bytes, aligned for any object.
+static void* c2m_arena_alloc(c2m_arena_t* arena, uint32_t n) {
+	uint32_t start = (arena->used + 7) & ~7u;
+
+	if(arena->block == NULL || start + n > arena->size) {
+		uint32_t size = sizeof(c2m_arena_block_t) + n > C2M_ARENA_BLOCK ?
+			sizeof(c2m_arena_block_t) + n : C2M_ARENA_BLOCK;
+		c2m_arena_block_t* block = malloc(size);
+
+		block->prev = arena->block;
+		arena->block = block;
+		arena->size = size;
+		start = (sizeof(c2m_arena_block_t) + 7) & ~7u;
+	}
+	arena->used = start + n;
+	return (char*)arena->block + start;
+}
+
+// Copy of `n` bytes of `text` with a NUL.
+static char* c2m_arena_strndup(c2m_arena_t* arena, const char* text,
+	uint32_t n)
+{
+	char* copy = c2m_arena_alloc(arena, n + 1);
+
+	memcpy(copy, text, n);
+	copy[n] = '\0';
+	return copy;
+}
+
+// Take over `other`'s blocks ( freeing it ), they're freed with `arena`.
+static void c2m_arena_adopt(c2m_arena_t* arena, c2m_arena_t* other) {
+	c2m_arena_block_t* oldest = other->block;
+
+	if(oldest) {
+		// Below the current block, so it keeps filling.
+		while(oldest->prev) oldest = oldest->prev;
+		if(arena->block) {
+			oldest->prev = arena->block->prev;
+			arena->block->prev = other->block;
+		}else{
+			arena->block = other->block;
+			arena->used = other->used;
+			arena->size = other->size;
+		}
+	}
+	free(other);
+}
+
+static void c2m_arena_destroy(c2m_arena_t* arena) {
+	while(arena->block) {
+		c2m_arena_block_t* prev = arena->block->prev;
+
+		free(arena->block);
+		arena->block = prev;
+	}
+	free(arena);
+}
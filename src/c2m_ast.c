@@ -0,0 +1,163 @@
+// Syntax tree: nodes are allocated from the arena of the compile ( or module ),
+// text points into the source buffers (not NUL terminated).
+
+enum {
+	// text = name, module, child = params, body = statements ( or NODE_RETURN
+	// for a pure function, see c2m_eval.c ), indirect = async & record = its
+	// frame's variables ( NODE_PARAM ), see c2m_async.c, traced = recorded
+	// with --trace at run time, see c2m_trace.c
+	NODE_FUNCTION,
+	NODE_PARAM, // text = name, type
+	NODE_WHILE, // body = statements
+	NODE_EXIT,
+	NODE_FAIL,
+	NODE_RAW, // text = C statement, passed through
+	// type, child = name ( NODE_IDENT ), body = value or NULL, indirect = in
+	// a coroutine's frame ( only assigned )
+	NODE_DECLARE,
+	// module, text = function, child = arguments, record = inlined, or the
+	// record returned if the function's pure ( the call's then a value too )
+	NODE_CALL,
+	NODE_STRING, // text = contents without quotes
+	NODE_INTEGER, // text = digits, TYPE_FLOAT64 with a decimal point
+	NODE_BOOL, // text = "1" or "0"
+	NODE_IDENT, // text = name
+	NODE_CONCAT, // child = parts, indirect = built on the heap ( c2m_escape.c )
+	// text = name, child = fields ( NODE_PARAM ), as written, indirect =
+	// C2M_RECORD_ flags
+	NODE_RECORD,
+	NODE_FIELD, // text = field name, child = record value
+	NODE_CONSTRUCT, // record, child = field values, as the fields are written
+	// child = list value, body = index, record = the for loop it's proven in
+	// bounds by, see c2m_loop.c.  A collection's element has its record
+	// instead, indirect is set when it's proven in bounds.
+	NODE_INDEX,
+	NODE_SET, // child = members, "{a, b}" ( none for "∅" )
+	NODE_RANGE, // text = brackets ( "[)" ), child = low, its next = high
+	NODE_SETOP, // text = "∪" or "∩", child = left, its next = right
+	// text = loop variable, child = interval ( NODE_RANGE ), its next = NODE_
+	// REDUCE or none, body = statements, module = C name & record = captured
+	// variables ( NODE_PARAM ), see c2m_parallel.c
+	NODE_PARALLEL,
+	NODE_REDUCE, // text = "+", "*", "min" or "max", child = variable
+	// text = "readable" or "writable" & child = file descriptor ( NODE_RAW ),
+	// or no text & child = NODE_CALL, record = its function
+	NODE_AWAIT,
+	NODE_BENCH, // text = name, body = statements, see c2m_bench.c
+	NODE_RETURN, // type, record, child = value, a pure function's only body
+	// text = loop variable, child = interval ( NODE_RANGE ), list or NODE_
+	// LINES, body = statements, indirect = the list's data is hoisted, see
+	// c2m_loop.c
+	NODE_FOR,
+	NODE_LINES, // child = file name, "lines(name)" a for loop's over
+	NODE_PUSH, // child = collection ( NODE_IDENT ), body = record value
+};
+
+typedef struct c2m_node{
+	uint8_t kind;
+	uint8_t type;
+	uint8_t indirect; // Passed as a pointer: large records ( const ) & lists
+	uint8_t traced;
+	uint32_t line;
+	const char* text;
+	uint32_t length;
+	const char* module;
+	uint32_t module_length;
+	struct c2m_node* child;
+	struct c2m_node* body;
+	struct c2m_node* next;
+	struct c2m_node* record; // NODE_RECORD, if type is TYPE_RECORD
+}c2m_node_t;
+
+static c2m_node_t* c2m_node_create(c2m_arena_t* arena, uint8_t kind,
+	uint32_t line)
+{
+	c2m_node_t* node = c2m_arena_alloc(arena, sizeof(c2m_node_t));
+
+	memset(node, 0, sizeof(c2m_node_t));
+	node->kind = kind;
+	node->line = line;
+	return node;
+}
+
+static inline void c2m_node_text(c2m_node_t* node, const char* text,
+	uint32_t length)
+{
+	node->text = text;
+	node->length = length;
+}
+
+// Returns 1 if the node's text isn't `what`.
+static inline uint8_t c2m_node_match(c2m_node_t* node, const char* what) {
+	uint32_t len = strlen(what);
+
+	return node->length != len || memcmp(node->text, what, len);
+}
+
+// Returns 1 if the node is an integer ( or bool ) literal, its value in `v`,
+// 0 for other nodes & decimal literals.
+// Digits are read like C reads them, that's what they're emitted as: plain
+// decimal ones ( up to 18, which can't overflow ) straight from the text,
+// others by strtoll() from a copy.
+static uint8_t c2m_node_integer(c2m_node_t* node, int64_t* v) {
+	char digits[32];
+	uint32_t i = 0;
+
+	if((node->kind != NODE_INTEGER && node->kind != NODE_BOOL) ||
+		node->type == TYPE_FLOAT64 || node->length >= sizeof(digits))
+	{
+		return 0;
+	}
+	if(node->length <= 18 && node->text[0] != '0') {
+		int64_t value = 0;
+
+		while(i < node->length && (uint8_t)(node->text[i] - '0') < 10)
+			value = value * 10 + (node->text[i++] - '0');
+		if(i == node->length && i) {
+			*v = value;
+			return 1;
+		}
+	}
+	memcpy(digits, node->text, node->length);
+	digits[node->length] = '\0';
+	*v = strtoll(digits, NULL, 0);
+	return 1;
+}
+
+// Append a constant's text to `s` as it prints at runtime: an integer's value
+// in decimal ( "010" is 8, "-0" is 0, like C reads them ), a string or bool's
+// text as written.
+static void c2m_node_append_text(struct cl_array* s, c2m_node_t* node) {
+	char digits[32];
+	int64_t v;
+
+	if(node->kind != NODE_INTEGER || c2m_node_integer(node, &v) == 0) {
+		c2m_string_append_n(s, node->text, node->length);
+	}else if(node->text[0] != '-' && v == INT64_MAX) {
+		// Past INT64_MAX strtoll() saturates, the value's unsigned.
+		memcpy(digits, node->text, node->length);
+		digits[node->length] = '\0';
+		c2m_string_append_n(s, digits, snprintf(digits, sizeof(digits),
+			"%llu", (unsigned long long)strtoull(digits, NULL, 0)));
+	}else{
+		c2m_string_append_n(s, digits, snprintf(digits, sizeof(digits),
+			"%lld", (long long)v));
+	}
+}
+
+// Append `node` to the list whose last `next` pointer is `*tail`.
+static inline void c2m_node_append(c2m_node_t*** tail, c2m_node_t* node) {
+	**tail = node;
+	*tail = &node->next;
+}
+
+typedef void (c2m_walk_cb)(c2m_node_t* node, void* data);
+
+// Call `cb` on every node of the list, depth first, parents before children.
+static void c2m_node_walk(c2m_node_t* node, c2m_walk_cb* cb, void* data) {
+	for(; node; node = node->next) {
+		cb(node, data);
+		c2m_node_walk(node->child, cb, data);
+		c2m_node_walk(node->body, cb, data);
+	}
+}
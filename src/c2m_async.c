@@ -0,0 +1,252 @@
+// Async functions ( a pass & their emitter ): "async name(params) {" in a
+// library module is a coroutine, lowered to a state machine run by the
+// program's event loop ( see c2m_prelude_co ).  Calling one starts it, main()
+// runs the loop once it's done.  In its body "await mod.fn(args)" waits for
+// another async function to return & "await readable fd" ( or writable ) for
+// a file descriptor.  Its variables live in a frame on the heap: the step
+// function copies them into C variables each time it's resumed, & back into
+// the frame before each await.  A switch on the frame's state jumps to where
+// it left off ( the await's line ), so declarations in the body are only
+// assignments.  String arguments are copied into the frame, a coroutine can
+// outlive them.
+
+typedef struct{
+	c2m_t* c2m;
+	c2m_arena_t* arena;
+	c2m_node_t* fn;
+	c2m_node_t** frame; // The end of fn->record
+	uint8_t parallel; // In a parallel loop's body
+	uint8_t loop; // In a for loop's body ( its locals aren't in the frame )
+}c2m_async_scope_t;
+
+static c2m_node_t* c2m_async_callee(c2m_t* c2m, c2m_node_t* call) {
+	c2m_symbol_t* symbol = c2m_symtab_get(c2m->modules, call->module);
+
+	return symbol ? c2m_module_find(symbol->data, call->text) : NULL;
+}
+
+// Link awaits to their function & put its variables in the frame, except
+// those of parallel loops ( their own function's ).
+static void c2m_async_block(c2m_async_scope_t* scope, c2m_node_t* block) {
+	uint8_t async = scope->fn->indirect;
+
+	for(; block; block = block->next) {
+		c2m_node_t* callee;
+
+		if(block->kind == NODE_AWAIT) {
+			block->record = scope->fn;
+			if(async == 0) {
+				c2m_diag(scope->c2m, block->line, 0,
+					"await outside an async function", NULL, 0);
+			}else if(scope->parallel) {
+				c2m_diag(scope->c2m, block->line, 0,
+					"Can't await in a parallel loop", NULL, 0);
+			}else if(scope->loop) {
+				c2m_diag(scope->c2m, block->line, 0,
+					"Can't await in a for loop", NULL, 0);
+			}
+		}else if(block->kind == NODE_CALL && scope->parallel &&
+			(callee = c2m_async_callee(scope->c2m, block)) &&
+			callee->indirect)
+		{
+			c2m_diag_node(scope->c2m, block,
+				"Async function called in a parallel loop");
+		}else if(block->kind == NODE_DECLARE) {
+			block->indirect = async && scope->parallel == 0;
+			if(block->indirect) {
+				c2m_node_append(&scope->frame,
+					c2m_parallel_capture(scope->arena, block));
+			}
+		}else if(block->kind == NODE_WHILE || block->kind == NODE_BENCH) {
+			c2m_async_block(scope, block->body);
+		}else if(block->kind == NODE_FOR) {
+			uint8_t loop = scope->loop;
+
+			scope->loop = 1;
+			c2m_async_block(scope, block->body);
+			scope->loop = loop;
+		}else if(block->kind == NODE_PARALLEL) {
+			uint8_t parallel = scope->parallel;
+
+			scope->parallel = 1;
+			c2m_async_block(scope, block->body);
+			scope->parallel = parallel;
+		}
+	}
+}
+
+static void c2m_async_function(c2m_t* c2m, c2m_node_t* fn,
+	c2m_arena_t* arena)
+{
+	c2m_async_scope_t scope = { c2m, arena, fn, &fn->record, 0, 0 };
+
+	fn->record = NULL;
+	if(fn->indirect) {
+		for(c2m_node_t* param = fn->child; param; param = param->next)
+			c2m_node_append(&scope.frame, c2m_parallel_capture(arena, param));
+	}
+	c2m_async_block(&scope, fn->body);
+}
+
+static void c2m_async(c2m_t* c2m) {
+	c2m_async_function(c2m, c2m->main_fn, c2m->arena);
+	for(c2m_node_t* fn = c2m->imported; fn; fn = fn->next) {
+		c2m_module_t* module = c2m_module_get(c2m, fn->module);
+
+		c2m->file = module->path->store;
+		c2m_async_function(c2m, fn, module->arena);
+	}
+	c2m->file = "src/main.c2m";
+}
+
+// "mod__fn" & `suffix`.
+static void c2m_async_name(c2m_node_t* fn, const char* suffix,
+	struct cl_array* a)
+{
+	c2m_string_append_n(a, fn->module, fn->module_length);
+	c2m_string_append_n(a, "__", 2);
+	c2m_string_append_n(a, fn->text, fn->length);
+	c2m_string_append(a, suffix);
+}
+
+// "c2m_co_t* mod__fn_co(params)", makes the coroutine without starting it.
+static void c2m_async_signature(c2m_node_t* fn, struct cl_array* a) {
+	c2m_string_append(a, "c2m_co_t* ");
+	c2m_async_name(fn, "_co(", a);
+	for(c2m_node_t* param = fn->child; param; param = param->next) {
+		c2m_emit_param(param, param->text, param->length, a);
+		if(param->next) c2m_string_append_n(a, ",", 1);
+	}
+	c2m_string_append_n(a, ")", 1);
+}
+
+// Next to the function's prototype, with the same linkage.
+static void c2m_async_prototype(c2m_t* c2m, c2m_node_t* fn,
+	struct cl_array* a)
+{
+	if(c2m->split == 0 && fn->module != c2m->exports)
+		c2m_string_append(a, "static ");
+	c2m_async_signature(fn, a);
+	c2m_string_append(a, ";\n");
+}
+
+// The frame's type, the coroutine's constructor & the function starting it.
+static void c2m_async_start(c2m_t* c2m, c2m_node_t* fn, struct cl_array* a) {
+	uint8_t local = c2m->split == 0 && fn->module != c2m->exports;
+	uint8_t text = 0;
+
+	c2m_string_append(a, "typedef struct{\nc2m_co_t co;\n");
+	for(c2m_node_t* var = fn->record; var; var = var->next) {
+		c2m_emit_type(var->type, var->record, a);
+		c2m_string_append_n(a, " ", 1);
+		c2m_string_append_n(a, var->text, var->length);
+		c2m_string_append(a, ";\n");
+	}
+	c2m_string_append_n(a, "}", 1);
+	c2m_async_name(fn, "_co_t;\nstatic void ", a);
+	c2m_async_name(fn, "_step(c2m_co_t* c2m_co);\n", a);
+	if(local) c2m_string_append(a, "static ");
+	c2m_async_signature(fn, a);
+	c2m_string_append(a, "{\nsize_t c2m_size = sizeof(");
+	c2m_async_name(fn, "_co_t)", a);
+	for(c2m_node_t* param = fn->child; param; param = param->next) {
+		if(param->type != TYPE_STRING) continue;
+		c2m_string_append(a, " + ");
+		c2m_string_append_n(a, param->text, param->length);
+		c2m_string_append(a, ".n");
+		text = 1;
+	}
+	c2m_string_append(a, ";\n");
+	c2m_async_name(fn, "_co_t* c2m_f = (", a);
+	c2m_async_name(fn, "_co_t*)c2m_co_new(c2m_size, ", a);
+	c2m_async_name(fn, "_step);\n", a);
+	if(text) c2m_string_append(a, "char* c2m_text = (char*)(c2m_f + 1);\n");
+	for(c2m_node_t* param = fn->child; param; param = param->next) {
+		c2m_string_append(a, "c2m_f->");
+		c2m_string_append_n(a, param->text, param->length);
+		if(param->type == TYPE_STRING) {
+			c2m_string_appendf(a, " = (c2m_str_t){ c2m_text, %.*s.n };\n"
+				"memcpy(c2m_text, %.*s.p, %.*s.n);\nc2m_text += %.*s.n",
+				(int)param->length, param->text, (int)param->length,
+				param->text, (int)param->length, param->text,
+				(int)param->length, param->text);
+		}else{
+			c2m_string_append(a, param->indirect ? " = *" : " = ");
+			c2m_string_append_n(a, param->text, param->length);
+		}
+		c2m_string_append(a, ";\n");
+	}
+	c2m_string_append(a, "return &c2m_f->co;\n}\n");
+	if(local) c2m_string_append(a, "static ");
+	c2m_emit_signature(fn, a);
+	c2m_string_append(a, "{\nc2m_co_ready(");
+	c2m_async_name(fn, "_co(", a);
+	for(c2m_node_t* param = fn->child; param; param = param->next) {
+		c2m_string_append_n(a, param->text, param->length);
+		if(param->next) c2m_string_append_n(a, ",", 1);
+	}
+	c2m_string_append(a, "));\n}\n");
+}
+
+// An async function: what starts it & the step resuming it.
+static void c2m_emit_async(c2m_t* c2m, c2m_node_t* fn, struct cl_array* a) {
+	c2m_async_start(c2m, fn, a);
+	c2m_string_append(a, "static void ");
+	c2m_async_name(fn, "_step(c2m_co_t* c2m_co){\n", a);
+	c2m_async_name(fn, "_co_t* c2m_f = (", a);
+	c2m_async_name(fn, "_co_t*)c2m_co; (void)c2m_f;\n", a);
+	for(c2m_node_t* var = fn->record; var; var = var->next) {
+		c2m_emit_param(var, var->text, var->length, a);
+		c2m_string_append(a, var->indirect ? " = &c2m_f->" : " = c2m_f->");
+		c2m_string_append_n(a, var->text, var->length);
+		c2m_string_append(a, "; (void)");
+		c2m_string_append_n(a, var->text, var->length);
+		c2m_string_append(a, ";\n");
+	}
+	c2m_string_append(a, "switch(c2m_co->state){\ncase 0:;\n");
+	c2m_emit_block(c2m, fn->body, a);
+	c2m_string_append(a, "}\nc2m_co_done(c2m_co);\n}\n");
+}
+
+// Save the variables, start what's awaited & return, resuming at the case
+// after it.
+static void c2m_emit_await(c2m_node_t* node, struct cl_array* a) {
+	c2m_node_t* call = node->child;
+	uint32_t n = 0;
+
+	for(c2m_node_t* var = node->record->record; var; var = var->next) {
+		if(var->indirect) continue; // Read only
+		c2m_string_append(a, "c2m_f->");
+		c2m_string_append_n(a, var->text, var->length);
+		c2m_string_append(a, " = ");
+		c2m_string_append_n(a, var->text, var->length);
+		c2m_string_append(a, ";\n");
+	}
+	c2m_string_append(a, "c2m_co->state = ");
+	c2m_string_add_int(a, node->line);
+	c2m_string_append(a, ";\n");
+	if(call->kind == NODE_RAW) {
+		c2m_string_append(a, "c2m_co_wait(c2m_co, (int)(");
+		c2m_string_append_n(a, call->text, call->length);
+		c2m_string_append(a, c2m_node_match(node, "writable") ? "), 0);\n" :
+			"), 1);\n");
+	}else{
+		for(c2m_node_t* arg = call->child; arg; arg = arg->next) {
+			if(arg->kind != NODE_CONCAT) continue;
+			if(n == 0) c2m_string_append(a, "{ char* c2m_end;\n");
+			c2m_emit_concat(arg, n++, a);
+		}
+		c2m_string_append(a, "c2m_co_await(c2m_co, ");
+		c2m_async_name(call, "_co(", a);
+		n = 0;
+		for(c2m_node_t* arg = call->child; arg; arg = arg->next) {
+			if(arg->kind == NODE_CONCAT) c2m_emit_str(n++, a);
+			else c2m_emit_argument(arg, a);
+			if(arg->next) c2m_string_append_n(a, ",", 1);
+		}
+		c2m_string_append(a, n ? "));\n}\n" : "));\n");
+	}
+	c2m_string_append(a, "return;\ncase ");
+	c2m_string_add_int(a, node->line);
+	c2m_string_append(a, ":;\n");
+}
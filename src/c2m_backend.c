@@ -0,0 +1,226 @@
+// C backends: turn the generated C into a binary.  "pipe" starts clang
+// directly ( no shell ) before emitting and is fed the C on stdin as it's
+// emitted, "system" runs clang on main.c through the shell once it's written.
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/wait.h>
+#define C2M_BACKEND_PIPE 1
+#endif
+
+typedef struct{
+	const char* name;
+	uint8_t (*open)(c2m_t* c2m); // Returns 1 on failure
+	void (*write)(c2m_t* c2m, const char* data, uint32_t size);
+	void (*flush)(c2m_t* c2m); // All written, close waits for the compiler
+	uint8_t (*close)(c2m_t* c2m); // Returns 1 if the C compiler failed
+	void (*cancel)(c2m_t* c2m); // Instead of close, output isn't needed
+}c2m_backend_t;
+
+#define C2M_BACKEND_FLAGS 24 // Code generation flags from c2m.config, at most
+#define C2M_BACKEND_ARGS (C2M_BACKEND_FLAGS + 16)
+
+/*
+ * Work out the C compiler's flags from c2m.config ( c2m->flags ): `opt`
+ * ( default 3, always 0 for c2m run ), `march`, `mtune` & `cflags`
+ * ( separated by spaces ).
+*/
+static void c2m_backend_config(c2m_t* c2m) {
+	static const char* levels[] = { "0", "1", "2", "3", "s", "z", "g",
+		"fast" };
+	const char* opt = c2m->run ? "0" : c2m->opt ? c2m->opt : "3";
+	struct cl_array* flag = c2m_string_create(NULL);
+	uint32_t i = 0;
+
+	while(i < sizeof(levels) / sizeof(levels[0]) && strcmp(levels[i], opt))
+		i++;
+	if(i == sizeof(levels) / sizeof(levels[0]))
+		c2m_abort("opt must be 0, 1, 2, 3, s, z, g or fast");
+	c2m_string_appendf(flag, "-O%s", opt);
+	if(c2m->march) c2m_string_appendf(flag, " -march=%s", c2m->march);
+	if(c2m->mtune) c2m_string_appendf(flag, " -mtune=%s", c2m->mtune);
+	if(c2m->cflags) c2m_string_appendf(flag, " %s", c2m->cflags);
+	// Frame pointers, leaf functions' too, so sampling profilers ( ours,
+	// see c2m_profile.c ) can walk the stack of an optimized build.
+	if(c2m->debug) c2m_string_append(flag, " -g");
+	if(c2m->debug || c2m->profile) {
+		c2m_string_append(flag, " -fno-omit-frame-pointer");
+#if defined(__x86_64__) || defined(__aarch64__)
+		c2m_string_append(flag, " -mno-omit-leaf-frame-pointer");
+#endif
+	}
+	cl_array_clear(c2m->flags);
+	// Split into words in place, the arena copy keeps them.
+	for(char* word = strtok(c2m_arena_strndup(c2m->arena, flag->store,
+		c2m_string_length(flag)), " \t"); word; word = strtok(NULL, " \t"))
+	{
+		if(cl_array_count(c2m->flags) == C2M_BACKEND_FLAGS)
+			c2m_abort("Too many cflags");
+		*(char**)cl_array_add(c2m->flags) = word;
+	}
+	c2m_string_destroy(flag);
+	if(c2m->run && c2m->run_compiler) c2m->compiler = c2m->run_compiler;
+	if(c2m->compiler == NULL) c2m->compiler = "clang";
+}
+
+// Append the compiler & its code generation flags, returns the new count.
+static uint32_t c2m_backend_start(c2m_t* c2m, char** args) {
+	uint32_t n = 0;
+
+	args[n++] = c2m->compiler;
+	for(uint32_t i = 0; i < cl_array_count(c2m->flags); i++)
+		args[n++] = *(char**)cl_array_borrow(c2m->flags, i);
+	if(c2m->pgo_flag) args[n++] = c2m->pgo_flag;
+	if(c2m->libreq.par) args[n++] = "-pthread"; // Parallel loops' pool
+	args[n++] = "-I" C2M_RUNTIME_DIR;
+	return n;
+}
+
+// Fill `args` with the C compiler command line for the source `input`.
+static void c2m_backend_args(c2m_t* c2m, char** args, char* input) {
+	uint32_t n = c2m_backend_start(c2m, args);
+
+	if(c2m->prelude) {
+		args[n++] = "-include";
+		args[n++] = c2m->prelude;
+	}
+	if(c2m->exports) {
+		// An object, made into the libraries once it's built.
+		args[n++] = "-fPIC";
+		args[n++] = "-c";
+	}
+	args[n++] = "-x";
+	args[n++] = "c";
+	args[n++] = input;
+	args[n++] = "-o";
+	args[n++] = c2m->output;
+	if(c2m->link_static && c2m->exports == NULL) args[n++] = "-static";
+	args[n] = NULL;
+}
+
+// The command line as one string ( for the shell & the build cache ).
+static void c2m_backend_command(c2m_t* c2m, struct cl_array* command) {
+	char* args[C2M_BACKEND_ARGS];
+
+	c2m_backend_args(c2m, args, "main.c");
+	for(uint32_t i = 0; args[i]; i++) {
+		if(i) c2m_string_append_n(command, " ", 1);
+		c2m_string_append(command, args[i]);
+	}
+}
+
+static uint8_t c2m_backend_system_open(c2m_t* c2m) {
+	return 0;
+}
+
+static void c2m_backend_system_write(c2m_t* c2m, const char* data,
+	uint32_t size)
+{
+}
+
+static void c2m_backend_system_flush(c2m_t* c2m) {
+}
+
+static uint8_t c2m_backend_system_close(c2m_t* c2m) {
+	struct cl_array* command = c2m_string_create(NULL);
+	uint8_t failed;
+
+	c2m_backend_command(c2m, command);
+	failed = system(command->store) != 0;
+	c2m_string_destroy(command);
+	return failed;
+}
+
+static void c2m_backend_system_cancel(c2m_t* c2m) {
+}
+
+#ifdef C2M_BACKEND_PIPE
+static uint8_t c2m_backend_pipe_open(c2m_t* c2m) {
+	int fds[2];
+
+	if(pipe(fds)) return 1;
+	// A failed compile shows up in the exit status, not as a signal.
+	signal(SIGPIPE, SIG_IGN);
+	fflush(stdout);
+	c2m->backend_pid = fork();
+	if(c2m->backend_pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return 1;
+	}
+	if(c2m->backend_pid == 0) {
+		char* args[C2M_BACKEND_ARGS];
+
+		c2m_backend_args(c2m, args, "-");
+		dup2(fds[0], 0);
+		close(fds[0]);
+		close(fds[1]);
+		execvp(args[0], args);
+		_exit(127);
+	}
+	close(fds[0]);
+	c2m->backend_fd = fds[1];
+	return 0;
+}
+
+static void c2m_backend_pipe_write(c2m_t* c2m, const char* data,
+	uint32_t size)
+{
+	while(size && c2m->backend_fd >= 0) {
+		ssize_t n = write(c2m->backend_fd, data, size);
+
+		if(n <= 0) {
+			// Compiler exited early, its status tells why.
+			close(c2m->backend_fd);
+			c2m->backend_fd = -1;
+			return;
+		}
+		data += n;
+		size -= n;
+	}
+}
+
+// The compiler sees the end of its input & finishes on its own.
+static void c2m_backend_pipe_flush(c2m_t* c2m) {
+	if(c2m->backend_fd >= 0) close(c2m->backend_fd);
+	c2m->backend_fd = -1;
+}
+
+static uint8_t c2m_backend_pipe_close(c2m_t* c2m) {
+	int status;
+
+	c2m_backend_pipe_flush(c2m);
+	if(waitpid(c2m->backend_pid, &status, 0) < 0) return 1;
+	return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+static void c2m_backend_pipe_cancel(c2m_t* c2m) {
+	if(c2m->backend_fd >= 0) close(c2m->backend_fd);
+	c2m->backend_fd = -1;
+	kill(c2m->backend_pid, SIGKILL);
+	waitpid(c2m->backend_pid, NULL, 0);
+}
+#endif
+
+static const c2m_backend_t c2m_backends[] = {
+#ifdef C2M_BACKEND_PIPE
+	{ "pipe", c2m_backend_pipe_open, c2m_backend_pipe_write,
+		c2m_backend_pipe_flush, c2m_backend_pipe_close,
+		c2m_backend_pipe_cancel },
+#endif
+	{ "system", c2m_backend_system_open, c2m_backend_system_write,
+		c2m_backend_system_flush, c2m_backend_system_close,
+		c2m_backend_system_cancel },
+};
+
+/*
+ * Returns NULL if there's no backend called `name`.
+*/
+static const c2m_backend_t* c2m_backend_find(const char* name) {
+	for(uint32_t i = 0; i < sizeof(c2m_backends) / sizeof(c2m_backends[0]);
+		i++)
+	{
+		if(strcmp(c2m_backends[i].name, name) == 0) return &c2m_backends[i];
+	}
+	return NULL;
+}
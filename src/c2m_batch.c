@@ -0,0 +1,113 @@
+// Batch mode ( --batch dir ... ): compile several projects in one process.
+// They share the interned names & the parsed library modules ( by source,
+// see c2m->module_cache ), and each project's C compiler keeps running while
+// the next projects are translated, up to -j of them at once.
+
+void c2m_init(c2m_t* c2m, c2m_intern_t* intern);
+void c2m_gconfig(c2m_t* c2m);
+void c2m_compile(c2m_t* c2m);
+void c2m_release(c2m_t* c2m);
+
+typedef struct{
+	const char* dir;
+	c2m_t c2m;
+}c2m_project_t;
+
+// Start a compile with the command line's `options` & the shared `cache`.
+static void c2m_batch_init(c2m_t* c2m, c2m_t* options, c2m_symtab_t* cache) {
+	c2m_init(c2m, options->intern);
+	c2m->emit_only = options->emit_only;
+	c2m->stats = options->stats;
+	c2m->use_cache = options->use_cache;
+	c2m->remote = options->remote;
+	c2m->use_prelude = options->use_prelude;
+	c2m->split = options->split;
+	c2m->lto = options->lto;
+	c2m->distcc = options->distcc;
+	c2m->debug = options->debug;
+	c2m->profile = options->profile;
+	c2m->jobs = options->jobs;
+	c2m->backend = options->backend;
+	c2m->pgo = options->pgo;
+	c2m->pgo_profile = options->pgo_profile;
+	c2m->module_cache = cache;
+	for(uint32_t i = 0; i < cl_array_count(options->lib_path); i++) {
+		*(char**)cl_array_add(c2m->lib_path) =
+			*(char**)cl_array_borrow(options->lib_path, i);
+	}
+	// The compiler ( see c2m_cache_compiler ), hashed once.
+	for(uint32_t i = 0; i < cl_array_count(options->inputs); i++) {
+		*(c2m_input_t*)cl_array_add(c2m->inputs) =
+			*(c2m_input_t*)cl_array_borrow(options->inputs, i);
+	}
+}
+
+// Wait for a project's C compiler & cache the result, returns 1 if it failed.
+static uint8_t c2m_batch_finish(c2m_project_t* project, const char* home) {
+	c2m_t* c2m = &project->c2m;
+	const c2m_backend_t* backend = c2m->backend;
+	uint8_t failed;
+
+	if(chdir(project->dir)) c2m_abort("couldn't enter project directory");
+	failed = backend->close(c2m);
+	c2m->pending = 0;
+	if(failed) {
+		printf("%s: C compiler failed\n", project->dir);
+	}else{
+		printf("%s: Compiled\n", project->dir);
+		if(c2m->exports && c2m_export_link(c2m)) {
+			printf("%s: Linking the library failed\n", project->dir);
+			failed = 1;
+		}else if(c2m->use_cache) {
+			c2m_cache_save(c2m);
+		}
+	}
+	if(chdir(home)) c2m_abort("couldn't return to working directory");
+	return failed;
+}
+
+/*
+ * Compile the projects in `dirs` with the options in `options`, returns how
+ * many failed.  The projects & the module cache are freed, the intern they
+ * share is the caller's.
+*/
+static uint32_t c2m_batch(c2m_t* options, char** dirs, uint32_t count) {
+	c2m_project_t* projects = malloc(sizeof(c2m_project_t) * count);
+	c2m_symtab_t* cache = c2m_symtab_create(options->intern);
+	uint32_t running = 0, oldest = 0, failed = 0;
+	char home[4096];
+
+	if(getcwd(home, sizeof(home)) == NULL)
+		c2m_abort("couldn't get working directory");
+	for(uint32_t i = 0; i < count; i++) {
+		c2m_t* c2m = &projects[i].c2m;
+
+		// Keep at most -j C compilers running.
+		for(; running >= options->jobs; oldest++) {
+			if(projects[oldest].c2m.pending == 0) continue;
+			failed += c2m_batch_finish(&projects[oldest], home);
+			running--;
+		}
+		projects[i].dir = dirs[i];
+		c2m_batch_init(c2m, options, cache);
+		c2m->batch = 1;
+		if(chdir(dirs[i])) {
+			printf("Can't enter %s\n", dirs[i]);
+			failed++;
+			continue;
+		}
+		printf("Entering %s\n", dirs[i]);
+		c2m_gconfig(c2m);
+		c2m_compile(c2m);
+		if(c2m->pending) running++;
+		if(chdir(home)) c2m_abort("couldn't return to working directory");
+	}
+	for(; oldest < count; oldest++) {
+		if(projects[oldest].c2m.pending)
+			failed += c2m_batch_finish(&projects[oldest], home);
+	}
+	for(uint32_t i = 0; i < count; i++) c2m_release(&projects[i].c2m);
+	c2m_module_cache_destroy(cache);
+	free(projects);
+	return failed;
+}
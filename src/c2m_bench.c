@@ -0,0 +1,44 @@
+// Benchmarks: "bench name {" blocks next to main in the main file, ignored by
+// a normal build.  --bench builds <name>-bench instead, main's body replaced
+// by the benches ( see c2m_parse_main ), & runs it.  Each bench's statements
+// run in a loop, in batches timed by the prelude's c2m_bench_next() ( see
+// c2m_prelude_bench ), which calibrates, warms up & prints the results.
+
+// The bench's statements, c2m_bench.n times per batch.  Variables it declares
+// are kept, what's computed for them can't be optimized out.
+static void c2m_emit_bench(c2m_t* c2m, c2m_node_t* node, struct cl_array* a) {
+	c2m_string_append(a, "{ c2m_bench_t c2m_bench;\n"
+		"c2m_bench_start(&c2m_bench, \"");
+	c2m_string_append_n(a, node->text, node->length);
+	c2m_string_append(a, "\", argc, argv);\n"
+		"while(c2m_bench_next(&c2m_bench)){\n"
+		"for(uint64_t c2m_n = c2m_bench.n; c2m_n; c2m_n--){\n");
+	c2m_emit_block(c2m, node->body, a);
+	for(c2m_node_t* var = node->body; var; var = var->next) {
+		if(var->kind != NODE_DECLARE) continue;
+		c2m_string_append(a, "C2M_BENCH_KEEP(");
+		c2m_string_append_n(a, var->child->text, var->child->length);
+		c2m_string_append(a, ");\n");
+	}
+	c2m_string_append(a, "}\n}\n}\n");
+}
+
+// Run the benches just built, only those whose name contains `filter` if it's
+// not NULL.  Returns 1 if they failed.
+static int c2m_bench_run(c2m_t* c2m, const char* filter) {
+	struct cl_array* command = c2m_string_create(NULL);
+	int status;
+
+	c2m_string_appendf(command, "./%s", c2m->output);
+	if(filter) {
+		c2m_string_append(command, " '");
+		for(; *filter; filter++) {
+			if(*filter == '\'') c2m_string_append(command, "'\\''");
+			else c2m_string_append_n(command, filter, 1);
+		}
+		c2m_string_append(command, "'");
+	}
+	status = system(command->store);
+	c2m_string_destroy(command);
+	return status != 0;
+}
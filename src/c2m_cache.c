@@ -0,0 +1,231 @@
+// Build cache: every input is hashed as it's read and the hashes are kept in
+// .c2m-cache/manifest next to the generated C & binary.  If the manifest
+// still matches, translation & the C compiler are skipped.  Otherwise the
+// binary is looked up by the hash of the generated C, so edits that don't
+// change the C (comments, blank lines) skip the C compiler.  Machines can
+// share theirs through a remote cache, see c2m_remote.c.
+
+#include <sys/stat.h>
+
+#define C2M_CACHE_DIR ".c2m-cache"
+#define C2M_CACHE_VERSION "c2m-cache 4"
+
+typedef struct{
+	char* path;
+	uint64_t hash;
+}c2m_input_t;
+
+// c2m_export.c, a restored library's object is linked again.
+static uint8_t c2m_export_link(c2m_t* c2m);
+// c2m_remote.c, what's saved is shared.
+static void c2m_remote_save(c2m_t* c2m);
+
+// FNV-1a, 64 bit.
+#define C2M_HASH_INIT 0xcbf29ce484222325ULL
+
+static inline uint64_t c2m_hash(uint64_t hash, const void* data,
+	uint32_t size)
+{
+	const uint8_t* bytes = data;
+
+	for(uint32_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+// Remember an input file's hash for the manifest.
+static void c2m_cache_input(c2m_t* c2m, const char* path, const char* data,
+	uint32_t size)
+{
+	c2m_input_t* input = cl_array_add(c2m->inputs);
+
+	input->path = c2m_arena_strndup(c2m->arena, path, strlen(path));
+	input->hash = c2m_hash(C2M_HASH_INIT, data, size);
+}
+
+/*
+ * Returns 1 if the file couldn't be hashed.
+*/
+static uint8_t c2m_cache_hash_file(const char* path, uint64_t* hash) {
+	c2m_source_t source;
+
+	if(c2m_source_open(&source, path)) return 1;
+	*hash = c2m_hash(C2M_HASH_INIT, source.data, source.size);
+	c2m_source_close(&source);
+	return 0;
+}
+
+// The compiler itself is an input, a rebuilt c2m must not reuse old output.
+static void c2m_cache_compiler(c2m_t* c2m, const char* argv0) {
+	const char* paths[] = { "/proc/self/exe", argv0 };
+
+	for(uint32_t i = 0; i < 2; i++) {
+		c2m_input_t* input = cl_array_add(c2m->inputs);
+
+		if(c2m_cache_hash_file(paths[i], &input->hash) == 0) {
+			input->path = c2m_arena_strndup(c2m->arena, paths[i],
+				strlen(paths[i]));
+			return;
+		}
+		cl_array_pop(c2m->inputs);
+	}
+	// Can't tell if the compiler changed.
+	c2m->use_cache = 0;
+}
+
+static inline void c2m_cache_path(struct cl_array* path, uint64_t hash,
+	const char* ext)
+{
+	c2m_string_appendf(path, C2M_CACHE_DIR "/%016llx%s",
+		(unsigned long long)hash, ext);
+}
+
+/*
+ * Returns 1 if the file couldn't be copied.
+*/
+static uint8_t c2m_cache_copy(const char* from, const char* to, int mode) {
+	c2m_source_t source;
+	SDL_RWops* output;
+	uint8_t failed;
+
+	if(c2m_source_open(&source, from)) return 1;
+	remove(to); // Don't write through a link into the cache.
+	if((output = SDL_RWFromFile(to, "wb")) == NULL) {
+		c2m_source_close(&source);
+		return 1;
+	}
+	failed = SDL_RWwrite(output, source.data, 1, source.size) != source.size;
+	SDL_RWclose(output);
+	c2m_source_close(&source);
+	if(mode) chmod(to, mode);
+	return failed;
+}
+
+// Options in the manifest: the prelude's, whether it's a c2m run build
+// ( another compiler & -O0, the same inputs ) & --profile's ( its table ).
+static inline unsigned c2m_cache_options(c2m_t* c2m) {
+	return c2m->use_prelude | c2m->run << 1 | c2m->profile << 2;
+}
+
+/*
+ * Returns 1 if the manifest doesn't match the inputs on disk, otherwise the
+ * cached output is restored.
+*/
+static uint8_t c2m_cache_restore(c2m_t* c2m) {
+	char line[1024];
+	uint8_t stale = 0;
+	unsigned long long hash, output = 0;
+	FILE* manifest = fopen(C2M_CACHE_DIR "/manifest", "r");
+
+	if(manifest == NULL) return 1;
+	unsigned long long library, profile;
+	unsigned options, pgo;
+
+	// Options that change the generated C or the binary must match too, so
+	// must the directories modules are found in.
+	if(fgets(line, sizeof(line), manifest) == NULL ||
+		sscanf(line, C2M_CACHE_VERSION " %u %llx %u %llx", &options,
+		&library, &pgo, &profile) != 4 ||
+		options != c2m_cache_options(c2m) ||
+		library != c2m->library_hash || pgo != c2m->pgo ||
+		profile != c2m->pgo_hash)
+	{
+		stale = 1;
+	}
+	while(stale == 0 && fgets(line, sizeof(line), manifest)) {
+		char path[1000];
+		uint64_t current;
+
+		if(sscanf(line, "output %llx", &output) == 1) break;
+		if(sscanf(line, "%llx %999s", &hash, path) != 2 ||
+			c2m_cache_hash_file(path, &current) || current != hash)
+		{
+			stale = 1;
+		}
+	}
+	fclose(manifest);
+	if(stale || output == 0) return 1;
+
+	struct cl_array* path = c2m_string_create(NULL);
+
+	c2m_cache_path(path, output, ".c");
+	stale = c2m_cache_copy(path->store, "main.c", 0);
+	if(stale == 0 && c2m->emit_only == 0) {
+		c2m_string_clear(path);
+		c2m_cache_path(path, output, ".bin");
+		stale = c2m_cache_copy(path->store, c2m->output, 0755);
+	}
+	if(stale == 0 && c2m->exports && c2m->emit_only == 0) {
+		c2m_string_clear(path);
+		c2m_cache_path(path, output, ".h");
+		stale = c2m_cache_copy(path->store, c2m->header, 0) ||
+			c2m_export_link(c2m);
+	}
+	c2m_string_destroy(path);
+	return stale;
+}
+
+/*
+ * Returns 1 if there's no cached binary for the generated C.
+*/
+static uint8_t c2m_cache_lookup(c2m_t* c2m) {
+	struct cl_array* path = c2m_string_create(NULL);
+	struct stat info;
+	uint8_t missing;
+
+	c2m_cache_path(path, c2m->output_hash, ".bin");
+	missing = stat(path->store, &info) != 0;
+	c2m_string_destroy(path);
+	return missing;
+}
+
+/*
+ * Returns 1 if there's no cached binary for the generated C, otherwise it's
+ * copied into place.
+*/
+static uint8_t c2m_cache_binary(c2m_t* c2m) {
+	struct cl_array* path = c2m_string_create(NULL);
+	uint8_t missing;
+
+	c2m_cache_path(path, c2m->output_hash, ".bin");
+	missing = c2m_cache_copy(path->store, c2m->output, 0755);
+	c2m_string_destroy(path);
+	return missing;
+}
+
+// Store main.c (and the binary unless emit only) & write the manifest.
+static void c2m_cache_save(c2m_t* c2m) {
+	struct cl_array* path = c2m_string_create(NULL);
+	FILE* manifest;
+
+	mkdir(C2M_CACHE_DIR, 0755);
+	c2m_cache_path(path, c2m->output_hash, ".c");
+	c2m_cache_copy("main.c", path->store, 0);
+	if(c2m->emit_only == 0) {
+		c2m_string_clear(path);
+		c2m_cache_path(path, c2m->output_hash, ".bin");
+		c2m_cache_copy(c2m->output, path->store, 0755);
+	}
+	if(c2m->exports && c2m->emit_only == 0) {
+		c2m_string_clear(path);
+		c2m_cache_path(path, c2m->output_hash, ".h");
+		c2m_cache_copy(c2m->header, path->store, 0);
+	}
+	c2m_string_destroy(path);
+	if((manifest = fopen(C2M_CACHE_DIR "/manifest", "w")) == NULL) return;
+	fprintf(manifest, C2M_CACHE_VERSION " %u %016llx %u %016llx\n",
+		c2m_cache_options(c2m), (unsigned long long)c2m->library_hash,
+		c2m->pgo, (unsigned long long)c2m->pgo_hash);
+	for(uint32_t i = 0; i < cl_array_count(c2m->inputs); i++) {
+		c2m_input_t* input = cl_array_borrow(c2m->inputs, i);
+
+		fprintf(manifest, "%016llx %s\n", (unsigned long long)input->hash,
+			input->path);
+	}
+	fprintf(manifest, "output %016llx\n",
+		(unsigned long long)c2m->output_hash);
+	fclose(manifest);
+	c2m_remote_save(c2m);
+}
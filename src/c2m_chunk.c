@@ -0,0 +1,221 @@
+// Large main files are split up for the worker threads: lexing in chunks cut
+// at newlines, then main's body in chunks cut before top level statements.
+// Statements are a line each ( a loop's block spans lines up to its "}" ),
+// so the cuts are found from the first token of every line.  Chunks are put
+// back together in order, the tree is the same as from a single pass.
+
+#define C2M_CHUNK_LEX 262144 // Bytes, a smaller file is lexed in one go
+#define C2M_CHUNK_PARSE 65536 // Tokens, a smaller main is parsed in one go
+
+typedef struct{
+	const char* source;
+	uint32_t size;
+	c2m_lexer_t lex;
+}c2m_lex_chunk_t;
+
+typedef struct{
+	c2m_t* c2m;
+	c2m_lexer_t lex; // Shares the file's tokens, starts at the chunk
+	uint32_t end; // Token after the chunk, main's "}" for the last one
+	uint8_t last; // Ends main, see c2m_parse_block()
+	uint8_t return_success;
+	c2m_arena_t* arena;
+	c2m_node_t* first;
+}c2m_parse_chunk_t;
+
+// Lex a chunk ( job ), lines & offsets are from its start.
+static void c2m_chunk_lex_one(void* job) {
+	c2m_lex_chunk_t* chunk = job;
+
+	c2m_lex_from(&chunk->lex, chunk->source, chunk->size, 1);
+}
+
+// Like c2m_lex(), but a large file is lexed by the worker threads.
+static void c2m_chunk_lex(c2m_lexer_t* lex, const char* source, uint32_t size)
+{
+	uint32_t n_chunks = size / C2M_CHUNK_LEX;
+	c2m_lex_chunk_t* chunks;
+	void** jobs;
+	uint32_t from = 0;
+	uint32_t line = 0;
+	uint32_t count = 0;
+
+	if(n_chunks > SDL_GetCPUCount()) n_chunks = SDL_GetCPUCount();
+	if(n_chunks < 2 || c2m_workers_serial) {
+		c2m_lex(lex, source, size);
+		return;
+	}
+	chunks = malloc(sizeof(c2m_lex_chunk_t) * n_chunks);
+	jobs = malloc(sizeof(void*) * n_chunks);
+	for(uint32_t i = 0; i < n_chunks; i++) {
+		uint32_t to = (uint64_t)size * (i + 1) / n_chunks;
+		const char* nl;
+
+		// Quotes & comments end with the line, so cut after a newline.
+		if(i + 1 < n_chunks && to > from && (nl = memchr(&source[to],
+			'\n', size - to)))
+		{
+			to = nl - source + 1;
+		}else if(i + 1 < n_chunks) {
+			to = from;
+		}else{
+			to = size;
+		}
+		chunks[i].source = &source[from];
+		chunks[i].size = to - from;
+		jobs[i] = &chunks[i];
+		from = to;
+	}
+	c2m_workers_run(c2m_chunk_lex_one, jobs, n_chunks);
+	for(uint32_t i = 0; i < n_chunks; i++)
+		count += cl_array_count(chunks[i].lex.tokens) - 1;
+	lex->source = source;
+	lex->size = size;
+	lex->tokens = cl_array_create(sizeof(c2m_token_t), count + 1);
+	lex->pos = 0;
+	for(uint32_t i = 0; i < n_chunks; i++) {
+		struct cl_array* tokens = chunks[i].lex.tokens;
+		uint32_t offset = chunks[i].source - source;
+		uint32_t n = cl_array_count(tokens) - 1; // Not its EOF
+
+		for(uint32_t j = 0; j < n; j++) {
+			c2m_token_t* token = cl_array_borrow(tokens, j);
+
+			c2m_lex_push(lex, token->kind, token->offset + offset,
+				token->length, token->line + line);
+		}
+		line += ((c2m_token_t*)cl_array_borrow(tokens, n))->line - 1;
+		c2m_lex_destroy(&chunks[i].lex);
+	}
+	c2m_lex_push(lex, TOKEN_EOF, size, 0, line + 1);
+	free(jobs);
+	free(chunks);
+}
+
+// Parse a chunk of main's statements ( job ).
+static void c2m_chunk_parse_one(void* job) {
+	c2m_parse_chunk_t* chunk = job;
+	c2m_t worker = *chunk->c2m;
+	c2m_node_t** tail = &chunk->first;
+	jmp_buf jump;
+
+	worker.arena = chunk->arena;
+	worker.recover = &jump;
+	if(setjmp(jump)) {
+		// Main doesn't end, the error's recorded & there's nothing after.
+		chunk->first = NULL;
+		chunk->lex.pos = cl_array_count(chunk->lex.tokens) - 1;
+		return;
+	}
+	if(chunk->last) {
+		chunk->first = c2m_parse_block(&worker, &chunk->lex, 1);
+		chunk->return_success = worker.return_success;
+		return;
+	}
+	while(chunk->lex.pos < chunk->end) {
+		c2m_node_t* node = c2m_parse_next(&worker, &chunk->lex);
+
+		if(node) c2m_node_append(&tail, node);
+	}
+	*tail = NULL;
+}
+
+/*
+ * Find where main's statements can be cut, appends the token index of each
+ * top level statement to `cuts`.  Returns 1 if main doesn't end.
+*/
+static uint8_t c2m_chunk_cuts(c2m_lexer_t* lex, struct cl_array* cuts) {
+	uint32_t n = cl_array_count(lex->tokens);
+	uint32_t depth = 0;
+
+	for(uint32_t i = lex->pos; i < n; ) {
+		c2m_token_t* token = cl_array_borrow(lex->tokens, i);
+
+		if(token->kind == TOKEN_EOF) return 1;
+		if(token->kind == TOKEN_NEWLINE) {
+			i++;
+			continue;
+		}
+		if(depth == 0 && c2m_lex_match(lex, token, "}"))
+			*(uint32_t*)cl_array_add(cuts) = i;
+		// A block ends at a "}" starting a statement, another may follow.
+		while(token->kind == TOKEN_PUNCT &&
+			c2m_lex_match(lex, token, "}") == 0)
+		{
+			if(depth == 0) return 0;
+			depth--;
+			token = cl_array_borrow(lex->tokens, ++i);
+		}
+		if(c2m_lex_match(lex, token, "while") == 0 ||
+			c2m_lex_match(lex, token, "parallel") == 0 ||
+			(c2m_lex_match(lex, token, "for") == 0 &&
+			((c2m_token_t*)cl_array_borrow(lex->tokens, i + 1))->kind ==
+			TOKEN_IDENT))
+		{
+			depth++;
+		}
+		while(token->kind != TOKEN_NEWLINE && token->kind != TOKEN_EOF)
+			token = cl_array_borrow(lex->tokens, ++i);
+	}
+	return 1;
+}
+
+// Parse main's body up to & including its "}", in chunks if it's large.
+static c2m_node_t* c2m_chunk_parse_main(c2m_t* c2m, c2m_lexer_t* lex) {
+	uint32_t n_tokens = cl_array_count(lex->tokens) - lex->pos;
+	uint32_t n_chunks = n_tokens / C2M_CHUNK_PARSE;
+	struct cl_array* cuts;
+	c2m_parse_chunk_t* chunks;
+	c2m_node_t* first = NULL;
+	c2m_node_t** tail = &first;
+	void** jobs;
+	uint32_t n_cuts, from;
+
+	if(n_chunks > SDL_GetCPUCount()) n_chunks = SDL_GetCPUCount();
+	if(n_chunks < 2 || c2m_workers_serial)
+		return c2m_parse_block(c2m, lex, 1);
+	cuts = cl_array_create(sizeof(uint32_t), 1024);
+	// Unterminated, c2m_parse_block() reports it.
+	if(c2m_chunk_cuts(lex, cuts) || (n_cuts = cl_array_count(cuts)) == 0) {
+		cl_array_destroy(cuts);
+		return c2m_parse_block(c2m, lex, 1);
+	}
+	chunks = malloc(sizeof(c2m_parse_chunk_t) * n_chunks);
+	jobs = malloc(sizeof(void*) * n_chunks);
+	from = lex->pos;
+	for(uint32_t i = 0; i < n_chunks; i++) {
+		c2m_parse_chunk_t* chunk = &chunks[i];
+		uint32_t cut = (uint64_t)n_cuts * (i + 1) / n_chunks;
+
+		chunk->c2m = c2m;
+		chunk->lex = *lex;
+		chunk->lex.pos = from;
+		chunk->last = i + 1 == n_chunks;
+		chunk->end = chunk->last ? 0 :
+			*(uint32_t*)cl_array_borrow(cuts, cut < n_cuts ? cut : 0);
+		if(chunk->last == 0 && chunk->end < from) chunk->end = from;
+		chunk->arena = c2m_arena_create();
+		chunk->first = NULL;
+		jobs[i] = chunk;
+		if(chunk->last == 0) from = chunk->end;
+	}
+	cl_array_destroy(cuts);
+	c2m->intern->shared = 1;
+	c2m_workers_run(c2m_chunk_parse_one, jobs, n_chunks);
+	c2m->intern->shared = 0;
+	for(uint32_t i = 0; i < n_chunks; i++) {
+		c2m_node_t* node = chunks[i].first;
+
+		if(node) {
+			*tail = node;
+			while(node->next) node = node->next;
+			tail = &node->next;
+		}
+		c2m_arena_adopt(c2m->arena, chunks[i].arena);
+	}
+	c2m->return_success = chunks[n_chunks - 1].return_success;
+	lex->pos = chunks[n_chunks - 1].lex.pos;
+	free(jobs);
+	free(chunks);
+	return first;
+}
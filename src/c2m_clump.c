@@ -0,0 +1,36 @@
+// Clump for programs that `import clump`: its containers are compiled into
+// the program from the tree c2m was built from ( the compiler adds this
+// directory to the include path, see C2M_RUNTIME_DIR ), so nothing's linked.
+// The modules built on SDL ( queue, twheel & hstream ) need the SDL runtime &
+// aren't included, nor is ulist ( list is the one that's there ).
+//
+// Split builds define C2M_CLUMP_SHARED, each unit then only has the
+// declarations & main's unit the code ( it defines C2M_CLUMP_STATE & includes
+// this again ), as clump's functions aren't static.
+
+#include "../clump/src/clump.h"
+
+#if !defined(C2M_CLUMP_SHARED) || defined(C2M_CLUMP_STATE)
+#include "../clump/src/clump.c"
+#include "../clump/src/pool.c"
+#include "../clump/src/arena.c"
+#include "../clump/src/array.c"
+#include "../clump/src/list.c"
+#include "../clump/src/ilist.c"
+#include "../clump/src/heap.c"
+#include "../clump/src/hash.c"
+#include "../clump/src/ihash.c"
+#include "../clump/src/rhash.c"
+#include "../clump/src/fhash.c"
+#include "../clump/src/filter.c"
+#include "../clump/src/tree.c"
+#include "../clump/src/itree.c"
+#include "../clump/src/btree.c"
+#include "../clump/src/snap.c"
+#include "../clump/src/phash.c"
+#include "../clump/src/bitarray.c"
+#include "../clump/src/bitset.c"
+#include "../clump/src/hcodec.c"
+#include "../clump/src/hblocks.c"
+#include "../clump/src/sort.c"
+#endif
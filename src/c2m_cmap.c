@@ -0,0 +1,182 @@
+// Concurrent read-mostly map, string ( text & length ) -> pointer.  Readers
+// never lock or write shared memory, so lookups scale with threads; writers
+// lock one of C2M_CMAP_SHARDS shards ( an SDL spin mutex ), picked by the top
+// bits of the hash.  Each shard is an insert-only linear probing table: a
+// slot's key is stored last ( release ) & never changes, so a reader loading
+// it ( acquire ) sees its hash, length & value.  A reader-writer lock would
+// make every lookup write the lock, the point is that they don't.  A full
+// table is copied into one twice the size & swapped in, the old one is kept
+// until the map is destroyed since a reader may still be probing it ( the
+// old tables add up to less than the current one ).  Keys aren't copied,
+// they must outlive the map.
+
+#define C2M_CMAP_SHARDS 16 // Power of 2
+#define C2M_CMAP_SHARD_BITS 4
+#define C2M_CMAP_MIN 64 // Initial slots per shard
+
+typedef struct{
+	void* key; // const char*, NULL if empty, set last
+	void* value;
+	uint32_t hash;
+	uint32_t length;
+}c2m_cmap_slot_t;
+
+typedef struct{
+	uint32_t mask; // Slots - 1
+	c2m_cmap_slot_t slots[];
+}c2m_cmap_table_t;
+
+typedef struct{
+	void* table; // c2m_cmap_table_t*
+	uint32_t count;
+	SDL_SpinMutex lock; // Writers
+	struct cl_array* retired; // c2m_cmap_table_t*, swapped out tables
+}c2m_cmap_shard_t;
+
+typedef struct{
+	c2m_cmap_shard_t shards[C2M_CMAP_SHARDS];
+}c2m_cmap_t;
+
+static c2m_cmap_table_t* c2m_cmap_table_create(uint32_t n_slots) {
+	c2m_cmap_table_t* table = calloc(1, sizeof(c2m_cmap_table_t) +
+		n_slots * sizeof(c2m_cmap_slot_t));
+
+	table->mask = n_slots - 1;
+	return table;
+}
+
+static c2m_cmap_t* c2m_cmap_create(void) {
+	c2m_cmap_t* map = malloc(sizeof(c2m_cmap_t));
+
+	for(uint32_t i = 0; i < C2M_CMAP_SHARDS; i++) {
+		map->shards[i].table = c2m_cmap_table_create(C2M_CMAP_MIN);
+		map->shards[i].count = 0;
+		SDL_AtomicSet(&map->shards[i].lock.state, 0);
+		map->shards[i].retired = cl_array_create(
+			sizeof(c2m_cmap_table_t*), 4);
+	}
+	return map;
+}
+
+// Once no thread reads the map any more.
+static void c2m_cmap_destroy(c2m_cmap_t* map) {
+	for(uint32_t i = 0; i < C2M_CMAP_SHARDS; i++) {
+		struct cl_array* retired = map->shards[i].retired;
+
+		for(uint32_t j = 0; j < retired->n_items; j++)
+			free(*(c2m_cmap_table_t**)cl_array_borrow(retired, j));
+		cl_array_destroy(retired);
+		free(map->shards[i].table);
+	}
+	free(map);
+}
+
+static inline uint32_t c2m_cmap_hash(const char* text, uint32_t length) {
+	return cl_hash_bytes(text, length, 0);
+}
+
+static inline c2m_cmap_shard_t* c2m_cmap_shard(c2m_cmap_t* map,
+	uint32_t hash)
+{
+	return &map->shards[hash >> (32 - C2M_CMAP_SHARD_BITS)];
+}
+
+/*
+ * Returns the slot for `text`, the empty slot to insert it in if it's not in
+ * the table.  Tells which in `found`: the slot's key, loaded again, may be a
+ * key put since.
+*/
+static c2m_cmap_slot_t* c2m_cmap_find(c2m_cmap_table_t* table,
+	const char* text, uint32_t length, uint32_t hash, uint8_t* found)
+{
+	for(uint32_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+		c2m_cmap_slot_t* slot = &table->slots[i];
+		const char* key = SDL_AtomicLoadPtr(&slot->key,
+			SDL_MEMORY_ORDER_ACQUIRE);
+
+		*found = key != NULL;
+		if(key == NULL) return slot;
+		if(slot->hash == hash && slot->length == length &&
+			memcmp(key, text, length) == 0)
+		{
+			return slot;
+		}
+	}
+}
+
+// c2m_cmap_find() for writers, the shard's lock held.
+static inline c2m_cmap_slot_t* c2m_cmap_probe(c2m_cmap_table_t* table,
+	const char* text, uint32_t length, uint32_t hash)
+{
+	uint8_t found;
+
+	return c2m_cmap_find(table, text, length, hash, &found);
+}
+
+/*
+ * Returns the value of `text` ( `hash` from c2m_cmap_hash ), NULL if it's not
+ * in the map.  Safe while other threads put.
+*/
+static void* c2m_cmap_get(c2m_cmap_t* map, const char* text, uint32_t length,
+	uint32_t hash)
+{
+	c2m_cmap_table_t* table = SDL_AtomicLoadPtr(&c2m_cmap_shard(map,
+		hash)->table, SDL_MEMORY_ORDER_ACQUIRE);
+	uint8_t found;
+	c2m_cmap_slot_t* slot = c2m_cmap_find(table, text, length, hash, &found);
+
+	if(found == 0) return NULL;
+	return SDL_AtomicLoadPtr(&slot->value, SDL_MEMORY_ORDER_ACQUIRE);
+}
+
+// Copy a shard's table into one twice the size, written before it's shared.
+static void c2m_cmap_grow(c2m_cmap_shard_t* shard) {
+	c2m_cmap_table_t* old = shard->table;
+	c2m_cmap_table_t* table = c2m_cmap_table_create((old->mask + 1) * 2);
+
+	for(uint32_t i = 0; i <= old->mask; i++) {
+		c2m_cmap_slot_t* slot = &old->slots[i];
+
+		if(slot->key) {
+			*c2m_cmap_probe(table, slot->key, slot->length,
+				slot->hash) = *slot;
+		}
+	}
+	*(c2m_cmap_table_t**)cl_array_add(shard->retired) = old;
+	SDL_AtomicStorePtr(&shard->table, table, SDL_MEMORY_ORDER_RELEASE);
+}
+
+/*
+ * Map `key` ( `hash` from c2m_cmap_hash ) to `value`, returns the value it
+ * replaced or NULL.  Safe while other threads get or put.
+*/
+static void* c2m_cmap_put(c2m_cmap_t* map, const char* key, uint32_t length,
+	uint32_t hash, void* value)
+{
+	c2m_cmap_shard_t* shard = c2m_cmap_shard(map, hash);
+	c2m_cmap_table_t* table;
+	c2m_cmap_slot_t* slot;
+	void* old = NULL;
+
+	SDL_SpinMutexLock(&shard->lock);
+	table = shard->table;
+	slot = c2m_cmap_probe(table, key, length, hash);
+	if(slot->key) {
+		old = slot->value;
+		SDL_AtomicStorePtr(&slot->value, value, SDL_MEMORY_ORDER_RELEASE);
+	}else{
+		// At most 3/4 full, so probes end at an empty slot.
+		if((shard->count + 1) * 4 > (table->mask + 1) * 3) {
+			c2m_cmap_grow(shard);
+			table = shard->table;
+			slot = c2m_cmap_probe(table, key, length, hash);
+		}
+		slot->hash = hash;
+		slot->length = length;
+		slot->value = value;
+		SDL_AtomicStorePtr(&slot->key, (void*)key, SDL_MEMORY_ORDER_RELEASE);
+		shard->count++;
+	}
+	SDL_SpinMutexUnlock(&shard->lock);
+	return old;
+}
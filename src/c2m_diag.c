@@ -0,0 +1,142 @@
+// Diagnostics: errors in the source are collected with their file, line &
+// column instead of ending the build, so one build reports all of them.  The
+// parser drops what it was parsing & resynchronizes at the next statement (
+// or top level definition ), type errors drop just their statement.  The build
+// stops before anything is emitted.  c2m_abort() is left for what can't go
+// on at all: missing files, failed writes & the like.
+
+#define C2M_DIAG_MAX 100 // Printed per build, the rest are only counted
+
+typedef struct{
+	const char* file;
+	uint32_t line;
+	uint32_t column; // From 1, 0 if not known
+	struct cl_array* message;
+}c2m_diag_t;
+
+typedef struct{
+	SDL_mutex* lock; // Parse jobs on worker threads report too
+	struct cl_array* list; // c2m_diag_t
+}c2m_diags_t;
+
+static c2m_diags_t* c2m_diags_create(void) {
+	c2m_diags_t* diags = malloc(sizeof(c2m_diags_t));
+
+	diags->lock = SDL_CreateMutex();
+	diags->list = cl_array_create(sizeof(c2m_diag_t), 16);
+	return diags;
+}
+
+static void c2m_diags_clear(c2m_diags_t* diags) {
+	for(uint32_t i = 0; i < cl_array_count(diags->list); i++)
+		c2m_string_destroy(((c2m_diag_t*)cl_array_borrow(diags->list,
+			i))->message);
+	cl_array_clear(diags->list);
+}
+
+static void c2m_diags_destroy(c2m_diags_t* diags) {
+	c2m_diags_clear(diags);
+	cl_array_destroy(diags->list);
+	SDL_DestroyMutex(diags->lock);
+	free(diags);
+}
+
+static inline uint32_t c2m_diag_count(c2m_t* c2m) {
+	return cl_array_count(((c2m_diags_t*)c2m->diags)->list);
+}
+
+// Column of `token`, counted from the start of its line.
+static uint32_t c2m_diag_column(c2m_lexer_t* lex, c2m_token_t* token) {
+	uint32_t start = token->offset;
+
+	while(start && lex->source[start - 1] != '\n') start--;
+	return token->offset - start + 1;
+}
+
+/*
+ * Record an error in c2m->file, `detail` ( `length` bytes, may be NULL ) is
+ * the text it's about.
+*/
+static void c2m_diag(c2m_t* c2m, uint32_t line, uint32_t column,
+	const char* message, const char* detail, uint32_t length)
+{
+	c2m_diags_t* diags = c2m->diags;
+	struct cl_array* text = c2m_string_create(message);
+	c2m_diag_t* diag;
+
+	if(detail && length) {
+		c2m_string_append(text, " \"");
+		c2m_string_append_n(text, detail, length);
+		c2m_string_append(text, "\"");
+	}
+	SDL_LockMutex(diags->lock);
+	diag = cl_array_add(diags->list);
+	diag->file = c2m->file;
+	diag->line = line;
+	diag->column = column;
+	diag->message = text;
+	SDL_UnlockMutex(diags->lock);
+}
+
+// Record an error about a node, named by its text if it has any.
+static inline void c2m_diag_node(c2m_t* c2m, c2m_node_t* node,
+	const char* message)
+{
+	c2m_diag(c2m, node->line, 0, message, node->text, node->length);
+}
+
+static int c2m_diag_compare(const void* a, const void* b) {
+	const c2m_diag_t* x = a;
+	const c2m_diag_t* y = b;
+	int order = strcmp(x->file, y->file);
+
+	if(order) return order;
+	if(x->line != y->line) return x->line < y->line ? -1 : 1;
+	return x->column < y->column ? -1 : x->column > y->column;
+}
+
+// Print the errors so far, in source order, & stop the build if there were any.
+static void c2m_diag_check(c2m_t* c2m) {
+	c2m_diags_t* diags = c2m->diags;
+	uint32_t n = cl_array_count(diags->list);
+
+	if(n == 0) return;
+	qsort(diags->list->store, n, sizeof(c2m_diag_t), c2m_diag_compare);
+	for(uint32_t i = 0; i < n && i < C2M_DIAG_MAX; i++) {
+		c2m_diag_t* diag = cl_array_borrow(diags->list, i);
+
+		if(diag->column) {
+			printf("%s:%u:%u: error: %s\n", diag->file, diag->line,
+				diag->column, (char*)diag->message->store);
+		}else{
+			printf("%s:%u: error: %s\n", diag->file, diag->line,
+				(char*)diag->message->store);
+		}
+	}
+	if(n > C2M_DIAG_MAX) printf("... and %u more\n", n - C2M_DIAG_MAX);
+	printf("%u error%s\n", n, n == 1 ? "" : "s");
+	c2m_diags_clear(diags);
+	c2m_abort("errors in the source");
+}
+
+/*
+ * Record an error at `token` & resume at the recovery point, dropping what's
+ * being parsed.  Without one ( c2m->recover ) the build stops here.
+*/
+static void c2m_error(c2m_t* c2m, c2m_lexer_t* lex, c2m_token_t* token,
+	const char* message)
+{
+	struct cl_array* text = c2m_string_create(message);
+
+	if(token->kind == TOKEN_NEWLINE || token->kind == TOKEN_EOF) {
+		c2m_diag(c2m, token->line, c2m_diag_column(lex, token), message,
+			NULL, 0);
+	}else{
+		c2m_string_append(text, ", found");
+		c2m_diag(c2m, token->line, c2m_diag_column(lex, token),
+			text->store, &lex->source[token->offset], token->length);
+	}
+	c2m_string_destroy(text);
+	if(c2m->recover) longjmp(*c2m->recover, 1);
+	c2m_diag_check(c2m);
+}
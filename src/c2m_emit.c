@@ -0,0 +1,897 @@
+// Emitter: generates C from the syntax tree.  Each statement is preceded by
+// a #line directive, so the C compiler's diagnostics & debug info ( what
+// perf, sanitizers & debuggers go by ) point at the .c2m source.
+
+static void c2m_emit_block(c2m_t* c2m, c2m_node_t* node, struct cl_array* a);
+static const char* c2m_module_file(c2m_t* c2m, const char* name);
+
+// Source of the statements being emitted, per thread: modules are emitted in
+// parallel ( see c2m_module_emit ).
+static _Thread_local const char* c2m_emit_file = "src/main.c2m";
+
+// Concatenated fields of record constructors ( `Pt(n, "p" + n)` ) are built
+// before their statement, as strings c2m_field`n` numbered in the order
+// c2m_emit_value reaches them ( see c2m_emit_fields ).
+static _Thread_local uint32_t c2m_emit_n_fields; // Built so far
+static _Thread_local uint32_t c2m_emit_field; // Next one a constructor uses
+
+static void c2m_emit_line(uint32_t line, struct cl_array* a) {
+	c2m_string_appendf(a, "#line %u \"", line);
+	for(const char* c = c2m_emit_file; *c; c++) {
+		if(*c == '"' || *c == '\\') c2m_string_append_n(a, "\\", 1);
+		c2m_string_append_n(a, c, 1);
+	}
+	c2m_string_append(a, "\"\n");
+}
+
+// The C type of a `type` value, records are named after the program.
+static void c2m_emit_type(uint8_t type, c2m_node_t* record,
+	struct cl_array* a)
+{
+	if(type == TYPE_RECORD || type == TYPE_ROWS) {
+		c2m_string_append(a, "main__");
+		c2m_string_append_n(a, record->text, record->length);
+		if(type == TYPE_ROWS) c2m_string_append(a, "_rows");
+	}else{
+		c2m_string_append(a, c2m_type_c(type));
+	}
+}
+
+static void c2m_emit_argument(c2m_node_t* arg, struct cl_array* a);
+static void c2m_emit_value(c2m_node_t* node, struct cl_array* a);
+
+// Where a collection's element is: its index, checked unless a for loop
+// proved it in bounds ( see c2m_loop.c ).
+static void c2m_emit_row(c2m_node_t* index, struct cl_array* a) {
+	if(index->indirect) {
+		c2m_emit_value(index->body, a);
+		return;
+	}
+	c2m_emit_type(TYPE_RECORD, index->record, a);
+	c2m_string_append(a, "_at(&");
+	c2m_emit_value(index->child, a);
+	c2m_string_append(a, ", ");
+	c2m_emit_value(index->body, a);
+	c2m_string_append_n(a, ")", 1);
+}
+
+// "name[i].field", the field's array in a collection of a "soa" record.
+static inline uint8_t c2m_emit_is_column(c2m_node_t* node) {
+	return node->kind == NODE_FIELD && node->child->kind == NODE_INDEX &&
+		node->child->child->type == TYPE_ROWS &&
+		(node->child->record->indirect & C2M_RECORD_SOA);
+}
+
+// Add [lo, hi) to the words of a set ( clamped to its range ), like
+// c2m_set_range() does when running.
+static void c2m_emit_set_span(uint64_t* w, int64_t lo, int64_t hi) {
+	for(int64_t v = lo < 0 ? 0 : lo; v < hi && v < C2M_SET_BITS; v++)
+		w[v >> 6] |= 1ULL << (v & 63);
+}
+
+/*
+ * Returns 1 if a set is known when compiling ( literals, intervals with
+ * literal bounds & operators on those ), its words are then in `w`.
+*/
+static uint8_t c2m_emit_set_const(c2m_node_t* node, uint64_t* w) {
+	uint64_t right[C2M_SET_BITS / 64];
+	int64_t lo, hi;
+
+	memset(w, 0, C2M_SET_BITS / 8);
+	if(node->kind == NODE_SET) {
+		for(c2m_node_t* member = node->child; member; member = member->next) {
+			if(c2m_node_integer(member, &lo) == 0) return 0;
+			c2m_emit_set_span(w, lo, lo + 1);
+		}
+		return 1;
+	}else if(node->kind == NODE_RANGE) {
+		if(c2m_node_integer(node->child, &lo) == 0 ||
+			c2m_node_integer(node->child->next, &hi) == 0)
+		{
+			return 0;
+		}
+		c2m_emit_set_span(w, lo + (node->text[0] == '('),
+			hi + (node->text[1] == ']'));
+		return 1;
+	}else if(node->kind != NODE_SETOP ||
+		c2m_emit_set_const(node->child, w) == 0 ||
+		c2m_emit_set_const(node->child->next, right) == 0)
+	{
+		return 0;
+	}
+	for(uint32_t i = 0; i < C2M_SET_BITS / 64; i++) {
+		if(c2m_node_match(node, "∪") == 0) w[i] |= right[i];
+		else w[i] &= right[i];
+	}
+	return 1;
+}
+
+static void c2m_emit_set_words(const uint64_t* w, struct cl_array* a) {
+	c2m_string_append(a, "((c2m_set_t){ {");
+	for(uint32_t i = 0; i < C2M_SET_BITS / 64; i++) {
+		c2m_string_appendf(a, " 0x%llxULL%s", (unsigned long long)w[i],
+			i + 1 < C2M_SET_BITS / 64 ? "," : "");
+	}
+	c2m_string_append(a, " } })");
+}
+
+/*
+ * A set value: its words when they're known, otherwise the prelude's kernels
+ * ( see c2m_prelude_set ).  Runtime members of "{a, b}" are added to the
+ * literal ones.
+*/
+static void c2m_emit_set(c2m_node_t* node, struct cl_array* a) {
+	uint64_t w[C2M_SET_BITS / 64];
+	int64_t v;
+
+	if(c2m_emit_set_const(node, w)) {
+		c2m_emit_set_words(w, a);
+	}else if(node->kind == NODE_SET) {
+		memset(w, 0, sizeof(w));
+		for(c2m_node_t* member = node->child; member; member = member->next) {
+			if(c2m_node_integer(member, &v)) c2m_emit_set_span(w, v, v + 1);
+			else c2m_string_append(a, "c2m_set_with(");
+		}
+		c2m_emit_set_words(w, a);
+		for(c2m_node_t* member = node->child; member; member = member->next) {
+			if(c2m_node_integer(member, &v)) continue;
+			c2m_string_append(a, ", ");
+			c2m_emit_value(member, a);
+			c2m_string_append_n(a, ")", 1);
+		}
+	}else if(node->kind == NODE_RANGE) {
+		c2m_string_append(a, "c2m_set_range((int64_t)");
+		c2m_emit_value(node->child, a);
+		c2m_string_append(a, node->text[0] == '(' ? " + 1, (int64_t)" :
+			", (int64_t)");
+		c2m_emit_value(node->child->next, a);
+		c2m_string_append(a, node->text[1] == ']' ? " + 1)" : ")");
+	}else{
+		c2m_string_append(a, c2m_node_match(node, "∪") == 0 ?
+			"c2m_set_union(" : "c2m_set_inter(");
+		c2m_emit_value(node->child, a);
+		c2m_string_append(a, ", ");
+		c2m_emit_value(node->child->next, a);
+		c2m_string_append_n(a, ")", 1);
+	}
+}
+
+static void c2m_emit_value(c2m_node_t* node, struct cl_array* a) {
+	if(node->kind == NODE_STRING) {
+		c2m_string_append(a, "C2M_STR(\"");
+		c2m_string_append_n(a, node->text, node->length);
+		c2m_string_append(a, "\")");
+	}else if(node->kind == NODE_IDENT && node->indirect) {
+		c2m_string_append(a, "(*");
+		c2m_string_append_n(a, node->text, node->length);
+		c2m_string_append_n(a, ")", 1);
+	}else if(node->kind == NODE_IDENT || node->kind == NODE_INTEGER ||
+		node->kind == NODE_BOOL)
+	{
+		c2m_string_append_n(a, node->text, node->length);
+	}else if(c2m_emit_is_column(node)) {
+		c2m_emit_value(node->child->child, a);
+		c2m_string_append_n(a, ".", 1);
+		c2m_string_append_n(a, node->text, node->length);
+		c2m_string_append_n(a, "[", 1);
+		c2m_emit_row(node->child, a);
+		c2m_string_append_n(a, "]", 1);
+	}else if(node->kind == NODE_FIELD) {
+		if(node->child->kind == NODE_IDENT && node->child->indirect) {
+			c2m_string_append_n(a, node->child->text,
+				node->child->length);
+			c2m_string_append(a, "->");
+		}else{
+			c2m_emit_value(node->child, a);
+			c2m_string_append_n(a, ".", 1);
+		}
+		c2m_string_append_n(a, node->text, node->length);
+	}else if(node->kind == NODE_INDEX && node->child->type == TYPE_ARGS) {
+		// In bounds by a for loop ( see c2m_loop.c ), still checked UTF-8.
+		c2m_string_append(a, node->record ? "c2m_args_at(" :
+			"c2m_args_get(");
+		c2m_emit_value(node->child, a);
+		c2m_string_append(a, ", ");
+		c2m_emit_value(node->body, a);
+		c2m_string_append_n(a, ")", 1);
+	}else if(node->kind == NODE_INDEX && node->child->type == TYPE_ROWS &&
+		(node->record->indirect & C2M_RECORD_SOA))
+	{
+		// The element put back together from the field's arrays.
+		c2m_string_append_n(a, "(", 1);
+		c2m_emit_type(TYPE_RECORD, node->record, a);
+		c2m_string_append(a, "){ ");
+		for(c2m_node_t* field = node->record->child; field;
+			field = field->next)
+		{
+			c2m_string_appendf(a, ".%.*s = ", (int)field->length,
+				field->text);
+			c2m_emit_value(node->child, a);
+			c2m_string_appendf(a, ".%.*s[", (int)field->length, field->text);
+			c2m_emit_row(node, a);
+			c2m_string_append(a, field->next ? "], " : "] }");
+		}
+	}else if(node->kind == NODE_INDEX && node->child->type == TYPE_ROWS) {
+		c2m_emit_value(node->child, a);
+		c2m_string_append(a, ".c2m_at[");
+		c2m_emit_row(node, a);
+		c2m_string_append_n(a, "]", 1);
+	}else if(node->kind == NODE_INDEX && node->record) {
+		// Straight into the loop's hoisted elements, no call.
+		c2m_string_appendf(a, "c2m_data_%.*s[", (int)node->record->length,
+			node->record->text);
+		c2m_emit_value(node->body, a);
+		c2m_string_append_n(a, "]", 1);
+	}else if(node->kind == NODE_INDEX) {
+		c2m_string_append(a, "c2m_list_get(");
+		c2m_emit_argument(node->child, a);
+		c2m_string_append(a, ", ");
+		c2m_emit_value(node->body, a);
+		c2m_string_append_n(a, ")", 1);
+	}else if(node->kind == NODE_CONSTRUCT) {
+		c2m_node_t* field = node->record->child;
+
+		// Designated, the struct's fields aren't in the order written.
+		c2m_string_append_n(a, "(", 1);
+		c2m_emit_type(TYPE_RECORD, node->record, a);
+		c2m_string_append(a, "){ ");
+		for(c2m_node_t* value = node->child; value; value = value->next) {
+			c2m_string_append_n(a, ".", 1);
+			c2m_string_append_n(a, field->text, field->length);
+			c2m_string_append(a, " = ");
+			if(value->kind == NODE_CONCAT)
+				c2m_string_appendf(a, "c2m_field%u", c2m_emit_field++);
+			else
+				c2m_emit_value(value, a);
+			c2m_string_append(a, value->next ? ", " : " }");
+			field = field->next;
+		}
+	}else if(node->kind == NODE_SET || node->kind == NODE_RANGE ||
+		node->kind == NODE_SETOP)
+	{
+		c2m_emit_set(node, a);
+	}else if(node->kind == NODE_CALL) {
+		// A pure function's, never inlined
+		c2m_string_append_n(a, node->module, node->module_length);
+		c2m_string_append_n(a, "__", 2);
+		c2m_string_append_n(a, node->text, node->length);
+		c2m_string_append_n(a, "(", 1);
+		for(c2m_node_t* arg = node->child; arg; arg = arg->next) {
+			c2m_emit_argument(arg, a);
+			if(arg->next) c2m_string_append_n(a, ",", 1);
+		}
+		c2m_string_append_n(a, ")", 1);
+	}else{
+		printf("Error on line %d\n", node->line);
+		c2m_abort("Unsupported type");
+	}
+}
+
+// A large record or list argument goes by address, one that's already a
+// pointer as is.
+static void c2m_emit_argument(c2m_node_t* arg, struct cl_array* a) {
+	if(arg->type == TYPE_LIST || (arg->type == TYPE_RECORD &&
+		c2m_record_indirect(arg->record)))
+	{
+		if(arg->kind == NODE_IDENT && arg->indirect) {
+			c2m_string_append_n(a, arg->text, arg->length);
+			return;
+		}
+		c2m_string_append_n(a, "&", 1);
+	}
+	c2m_emit_value(arg, a);
+}
+
+// Most characters a number type takes in decimal ( sign included ).
+static uint32_t c2m_emit_digits(uint8_t type) {
+	switch(type) {
+	case TYPE_UBYTE: return 3;
+	case TYPE_SBYTE: return 4;
+	case TYPE_USHORT: return 5;
+	case TYPE_SSHORT: return 6;
+	case TYPE_UINT32: return 10;
+	case TYPE_SINT32: return 11;
+	case TYPE_UINT64: return 20;
+	case TYPE_SINT64: case TYPE_INTEGER: return 20;
+	case TYPE_FLOAT32: case TYPE_FLOAT64: return 24; // "-1.23456789012346e+308"
+	case TYPE_SET: return C2M_SET_TEXT;
+	default: c2m_abort("Can't concatenate value"); return 0;
+	}
+}
+
+// "c2m_str`n`", a concatenation's result.
+static inline void c2m_emit_str(uint32_t n, struct cl_array* a) {
+	c2m_string_append_n(a, "c2m_str", 7);
+	c2m_string_add_int(a, n);
+}
+
+// A string part: its value, or the variable a pure function's value is kept
+// in ( `name`_`i`, see c2m_emit_concat_buffer ) so it's only called once.
+static void c2m_emit_concat_part(c2m_node_t* part, uint32_t i,
+	const char* name, uint32_t length, struct cl_array* a)
+{
+	if(part->kind == NODE_CALL) {
+		c2m_string_appendf(a, "%.*s_%u", (int)length, name, i);
+		return;
+	}
+	c2m_emit_value(part, a);
+}
+
+// The size of a runtime concatenation's buffer: constants by sizeof, strings
+// by their length & numbers by their widest.
+static void c2m_emit_concat_size(c2m_node_t* node, const char* name,
+	uint32_t length, struct cl_array* a)
+{
+	uint32_t digits = 1; // NUL
+	uint32_t i = 0;
+
+	c2m_string_append_n(a, "1", 1);
+	for(c2m_node_t* part = node->child; part; part = part->next, i++) {
+		if(part->kind == NODE_STRING) {
+			c2m_string_append(a, " + sizeof(\"");
+			c2m_string_append_n(a, part->text, part->length);
+			c2m_string_append(a, "\") - 1");
+		}else if(part->type == TYPE_STRING) {
+			c2m_string_append(a, " + ");
+			c2m_emit_concat_part(part, i, name, length, a);
+			c2m_string_append(a, ".n");
+		}else{
+			digits += c2m_emit_digits(part->type);
+		}
+	}
+	if(digits > 1) {
+		c2m_string_append(a, " + ");
+		c2m_string_add_int(a, digits - 1);
+	}
+}
+
+// Write each part of a runtime concatenation at c2m_end, NUL terminated.
+static void c2m_emit_concat_parts(c2m_node_t* node, const char* name,
+	uint32_t length, struct cl_array* a)
+{
+	uint32_t i = 0;
+
+	for(c2m_node_t* part = node->child; part; part = part->next, i++) {
+		if(part->kind == NODE_STRING) {
+			c2m_string_append(a, "memcpy(c2m_end, \"");
+			c2m_string_append_n(a, part->text, part->length);
+			c2m_string_append(a, "\", sizeof(\"");
+			c2m_string_append_n(a, part->text, part->length);
+			c2m_string_append(a, "\") - 1); c2m_end += sizeof(\"");
+			c2m_string_append_n(a, part->text, part->length);
+			c2m_string_append(a, "\") - 1;\n");
+		}else if(part->type == TYPE_STRING) {
+			c2m_string_append(a, "memcpy(c2m_end, ");
+			c2m_emit_concat_part(part, i, name, length, a);
+			c2m_string_append(a, ".p, ");
+			c2m_emit_concat_part(part, i, name, length, a);
+			c2m_string_append(a, ".n); c2m_end += ");
+			c2m_emit_concat_part(part, i, name, length, a);
+			c2m_string_append(a, ".n;\n");
+		}else if(part->type == TYPE_FLOAT32 || part->type == TYPE_FLOAT64) {
+			c2m_string_append(a, "c2m_end = c2m_cat_float(c2m_end, ");
+			c2m_emit_value(part, a);
+			c2m_string_append(a, part->type == TYPE_FLOAT32 ? ", 6);\n" :
+				", 15);\n");
+		}else if(part->type == TYPE_SET) {
+			c2m_string_append(a, "c2m_end = c2m_cat_set(c2m_end, ");
+			c2m_emit_value(part, a);
+			c2m_string_append(a, ");\n");
+		}else{
+			uint8_t is_unsigned = part->type == TYPE_UBYTE ||
+				part->type == TYPE_USHORT ||
+				part->type == TYPE_UINT32 ||
+				part->type == TYPE_UINT64;
+
+			c2m_string_append(a, is_unsigned ?
+				"c2m_end = c2m_cat_uint(c2m_end, " :
+				"c2m_end = c2m_cat_int(c2m_end, ");
+			c2m_emit_value(part, a);
+			c2m_string_append(a, ");\n");
+		}
+	}
+	c2m_string_append(a, "*c2m_end = '\\0';\n");
+}
+
+// "char c2m_cat`n`[size]" on the stack, or "char* c2m_cat`n` = malloc(size)"
+// if it escapes ( see c2m_escape.c ).  Strings from calls are kept first.
+static void c2m_emit_concat_buffer(c2m_node_t* node, const char* name,
+	uint32_t length, struct cl_array* a)
+{
+	uint32_t i = 0;
+
+	for(c2m_node_t* part = node->child; part; part = part->next, i++) {
+		if(part->kind != NODE_CALL || part->type != TYPE_STRING) continue;
+		c2m_string_append(a, "c2m_str_t ");
+		c2m_emit_concat_part(part, i, name, length, a);
+		c2m_string_append(a, " = ");
+		c2m_emit_value(part, a);
+		c2m_string_append(a, ";\n");
+	}
+	if(node->indirect) {
+		c2m_string_append(a, "char* ");
+		c2m_string_append_n(a, name, length);
+		c2m_string_append(a, " = malloc(");
+		c2m_emit_concat_size(node, name, length, a);
+		c2m_string_append(a, ");\nif(");
+		c2m_string_append_n(a, name, length);
+		c2m_string_append(a, " == NULL) abort();\n");
+	}else{
+		c2m_string_append(a, "char ");
+		c2m_string_append_n(a, name, length);
+		c2m_string_append_n(a, "[", 1);
+		c2m_emit_concat_size(node, name, length, a);
+		c2m_string_append(a, "];\n");
+	}
+}
+
+/*
+ * Runtime concatenation ( what c2m_fold left ) for a call: the size is worked
+ * out before anything's written, then each part's written into buffer `n`
+ * once.  The result is string c2m_str`n`.
+*/
+static void c2m_emit_concat(c2m_node_t* node, uint32_t n, struct cl_array* a)
+{
+	char name[32];
+	uint32_t length = snprintf(name, sizeof(name), "c2m_cat%u", n);
+
+	c2m_emit_concat_buffer(node, name, length, a);
+	c2m_string_appendf(a, "c2m_end = %s;\n", name);
+	c2m_emit_concat_parts(node, name, length, a);
+	c2m_string_append(a, "c2m_str_t ");
+	c2m_emit_str(n, a);
+	c2m_string_appendf(a, " = { %s, c2m_end - %s };\n", name, name);
+}
+
+/*
+ * String variable `var` built by runtime concatenation `node`: its buffer,
+ * c2m_cat_<var>, is in the same scope so it lasts as long as the variable
+ * ( or on the heap if it escapes ).  The variable's declared unless `assign`.
+*/
+static void c2m_emit_concat_var(c2m_node_t* node, const char* var,
+	uint32_t length, uint8_t assign, struct cl_array* a)
+{
+	struct cl_array* name = c2m_string_create(NULL);
+
+	c2m_string_appendf(name, "c2m_cat_%.*s", (int)length, var);
+	if(node->indirect == 0) {
+		c2m_emit_concat_buffer(node, name->store, c2m_string_length(name),
+			a);
+	}
+	if(assign == 0)
+		c2m_string_append(a, "c2m_str_t ");
+	c2m_string_append_n(a, var, length);
+	c2m_string_append(a, ";\n{ ");
+	if(node->indirect) {
+		c2m_emit_concat_buffer(node, name->store, c2m_string_length(name),
+			a);
+	}
+	c2m_string_appendf(a, "char* c2m_end = %s;\n", (char*)name->store);
+	c2m_emit_concat_parts(node, name->store, c2m_string_length(name), a);
+	c2m_string_append_n(a, var, length);
+	c2m_string_appendf(a, " = (c2m_str_t){ %s, c2m_end - %s };\n}\n",
+		(char*)name->store, (char*)name->store);
+	c2m_string_destroy(name);
+}
+
+// A variable declared as a runtime concatenation, in a coroutine it's only
+// assigned.
+static inline void c2m_emit_declare_concat(c2m_node_t* node,
+	struct cl_array* a)
+{
+	c2m_emit_concat_var(node->body, node->child->text, node->child->length,
+		node->indirect, a);
+}
+
+/*
+ * Count the concatenated fields of the record constructors in `node` ( a
+ * statement or value ), & build them if `build`, in the order c2m_emit_value
+ * reaches them.  They last as long as the statement's scope, so a record
+ * declared from one can use it.
+*/
+static uint32_t c2m_emit_fields(c2m_node_t* node, uint8_t build,
+	struct cl_array* a)
+{
+	uint32_t n = 0;
+
+	if(node->kind == NODE_CONCAT) return 0;
+	for(c2m_node_t* child = node->child; child; child = child->next) {
+		if(node->kind == NODE_CONSTRUCT && child->kind == NODE_CONCAT) {
+			char name[32];
+
+			if(build) {
+				c2m_emit_concat_var(child, name, snprintf(name,
+					sizeof(name), "c2m_field%u", c2m_emit_n_fields++),
+					0, a);
+			}
+			n++;
+		}else{
+			n += c2m_emit_fields(child, build, a);
+		}
+	}
+	if(node->body) n += c2m_emit_fields(node->body, build, a);
+	return n;
+}
+
+static void c2m_emit_param(c2m_node_t* param, const char* name,
+	uint32_t length, struct cl_array* a);
+static void c2m_emit_parallel(c2m_t* c2m, c2m_node_t* node,
+	struct cl_array* a);
+static void c2m_emit_parallels(c2m_t* c2m, c2m_node_t* block,
+	struct cl_array* a);
+static void c2m_emit_for(c2m_t* c2m, c2m_node_t* node, struct cl_array* a);
+static void c2m_emit_await(c2m_node_t* node, struct cl_array* a);
+static void c2m_emit_bench(c2m_t* c2m, c2m_node_t* node, struct cl_array* a);
+static void c2m_emit_async(c2m_t* c2m, c2m_node_t* fn, struct cl_array* a);
+
+/*
+ * An inlined call: the arguments into temporaries, then the parameters from
+ * those in a scope of their own ( an argument may be named like one ) & the
+ * function's statements.
+*/
+static void c2m_emit_inline(c2m_t* c2m, c2m_node_t* node, struct cl_array* a) {
+	c2m_node_t* param = node->record->child;
+	const char* file;
+	uint32_t n = 0, i = 0;
+	char name[32];
+
+	c2m_string_append(a, "{\n");
+	for(c2m_node_t* arg = node->child; arg; arg = arg->next) {
+		c2m_emit_param(param, name, snprintf(name, sizeof(name),
+			"c2m_arg%u", i++), a);
+		c2m_string_append(a, " = ");
+		if(arg->kind == NODE_CONCAT) c2m_emit_str(n++, a);
+		else c2m_emit_argument(arg, a);
+		c2m_string_append(a, ";\n");
+		param = param->next;
+	}
+	c2m_string_append(a, "{\n");
+	i = 0;
+	for(param = node->record->child; param; param = param->next) {
+		c2m_emit_param(param, param->text, param->length, a);
+		c2m_string_append(a, " = c2m_arg");
+		c2m_string_add_int(a, i++);
+		c2m_string_append(a, ";\n");
+	}
+	file = c2m_emit_file;
+	c2m_emit_file = c2m_module_file(c2m, node->record->module);
+	c2m_emit_block(c2m, node->record->body, a);
+	c2m_emit_file = file;
+	c2m_string_append(a, n ? "}\n}\n}\n" : "}\n}\n");
+}
+
+static void c2m_emit_call(c2m_t* c2m, c2m_node_t* node, struct cl_array* a) {
+	uint32_t n = 0;
+
+	// Concatenated arguments are built in their own scope first.
+	for(c2m_node_t* arg = node->child; arg; arg = arg->next) {
+		if(arg->kind != NODE_CONCAT) continue;
+		if(n == 0) c2m_string_append(a, "{ char* c2m_end;\n");
+		c2m_emit_concat(arg, n++, a);
+	}
+	if(node->record) {
+		c2m_emit_inline(c2m, node, a);
+		return;
+	}
+	c2m_string_append_n(a, node->module, node->module_length);
+	c2m_string_append_n(a, "__", 2);
+	c2m_string_append_n(a, node->text, node->length);
+	c2m_string_append_n(a, "(", 1);
+	n = 0;
+	for(c2m_node_t* arg = node->child; arg; arg = arg->next) {
+		if(arg->kind == NODE_CONCAT) c2m_emit_str(n++, a);
+		else c2m_emit_argument(arg, a);
+		if(arg->next) c2m_string_append_n(a, ",", 1);
+	}
+	c2m_string_append(a, n ? ");\n}\n" : ");\n");
+}
+
+static void c2m_emit_statement(c2m_t* c2m, c2m_node_t* node,
+	struct cl_array* a)
+{
+	uint32_t n_fields = 0;
+
+	// A declared record's fields are in its scope, others in their own.
+	if(node->kind == NODE_DECLARE || node->kind == NODE_CALL ||
+		node->kind == NODE_PUSH || node->kind == NODE_RETURN)
+	{
+		n_fields = c2m_emit_fields(node, 0, a);
+	}
+	if(n_fields) {
+		if(node->kind != NODE_DECLARE) c2m_string_append(a, "{\n");
+		c2m_emit_field = c2m_emit_n_fields;
+		c2m_emit_fields(node, 1, a);
+	}
+	switch(node->kind) {
+	case NODE_WHILE:
+		// A real C loop ( nested blocks close themselves ), not labels &
+		// goto, so the C compiler's loop optimizations apply.
+		c2m_string_append(a, "while(1){\n");
+		c2m_emit_block(c2m, node->body, a);
+		c2m_string_append(a, "}\n");
+		break;
+	case NODE_PARALLEL:
+		c2m_emit_parallel(c2m, node, a);
+		break;
+	case NODE_FOR:
+		c2m_emit_for(c2m, node, a);
+		break;
+	case NODE_AWAIT:
+		c2m_emit_await(node, a);
+		break;
+	case NODE_BENCH:
+		c2m_emit_bench(c2m, node, a);
+		break;
+	case NODE_EXIT:
+		c2m_string_append(a, "exit(0);\n");
+		break;
+	case NODE_FAIL:
+		c2m_string_append(a, "c2m_fail();\n");
+		break;
+	case NODE_RAW:
+		c2m_string_append_n(a, node->text, node->length);
+		c2m_string_append(a, ";\n");
+		break;
+	case NODE_DECLARE:
+		if(node->body && node->body->kind == NODE_CONCAT) {
+			c2m_emit_declare_concat(node, a);
+			break;
+		}
+		// A coroutine's variable is declared by its step, see c2m_async.c.
+		if(node->indirect == 0) {
+			c2m_emit_type(node->type, node->record, a);
+			c2m_string_append_n(a, " ", 1);
+		}
+		c2m_string_append_n(a, node->child->text, node->child->length);
+		c2m_string_append(a, " = ");
+		if(node->body) c2m_emit_value(node->body, a);
+		else if(node->type == TYPE_RECORD || node->type == TYPE_LIST ||
+			node->type == TYPE_SET || node->type == TYPE_ROWS)
+		{
+			if(node->indirect) {
+				c2m_string_append_n(a, "(", 1);
+				c2m_emit_type(node->type, node->record, a);
+				c2m_string_append_n(a, ")", 1);
+			}
+			c2m_string_append(a, "{ 0 }");
+		}else if(node->type == TYPE_STRING) {
+			c2m_string_append(a, "C2M_STR(\"\")");
+		}else{
+			c2m_string_append_n(a, "0", 1);
+		}
+		c2m_string_append(a, ";\n");
+		break;
+	case NODE_CALL:
+		c2m_emit_call(c2m, node, a);
+		break;
+	case NODE_PUSH:
+		c2m_emit_type(TYPE_RECORD, node->child->record, a);
+		c2m_string_append(a, "_push(&");
+		c2m_emit_value(node->child, a);
+		c2m_string_append(a, ", ");
+		c2m_emit_value(node->body, a);
+		c2m_string_append(a, ");\n");
+		break;
+	case NODE_RETURN:
+		// A concatenation returned is on the heap, see c2m_escape.c.
+		if(node->child->kind == NODE_CONCAT) {
+			c2m_string_append(a, "char* c2m_end;\n");
+			c2m_emit_concat(node->child, 0, a);
+			c2m_string_append(a, "return ");
+			c2m_emit_str(0, a);
+		}else{
+			c2m_string_append(a, "return ");
+			c2m_emit_value(node->child, a);
+		}
+		c2m_string_append(a, ";\n");
+		break;
+	default:
+		printf("Error on line %d\n", node->line);
+		c2m_abort("Not a statement");
+	}
+	if(n_fields && node->kind != NODE_DECLARE) c2m_string_append(a, "}\n");
+}
+
+static void c2m_emit_block(c2m_t* c2m, c2m_node_t* node, struct cl_array* a) {
+	for(; node; node = node->next) {
+		if(node->line) c2m_emit_line(node->line, a);
+		c2m_emit_statement(c2m, node, a);
+	}
+}
+
+// A parameter declared as `name`, nothing writes to a record passed by
+// pointer so it can't alias.  Lists are changed through theirs.
+static void c2m_emit_param(c2m_node_t* param, const char* name,
+	uint32_t length, struct cl_array* a)
+{
+	uint8_t read_only = param->indirect && param->type != TYPE_LIST;
+
+	if(read_only) c2m_string_append(a, "const ");
+	c2m_emit_type(param->type, param->record, a);
+	c2m_string_append(a, read_only ? "* restrict " :
+		param->indirect ? "* " : " ");
+	c2m_string_append_n(a, name, length);
+}
+
+// "void mod__fn(c2m_str_t a, int32_t b, const main__Big* restrict c,...)",
+// a pure function returns its type instead of void.
+static void c2m_emit_signature(c2m_node_t* fn, struct cl_array* a) {
+	if(fn->body && fn->body->kind == NODE_RETURN) {
+		c2m_emit_type(fn->body->type, fn->body->record, a);
+		c2m_string_append_n(a, " ", 1);
+	}else{
+		c2m_string_append(a, "void ");
+	}
+	c2m_string_append_n(a, fn->module, fn->module_length);
+	c2m_string_append_n(a, "__", 2);
+	c2m_string_append_n(a, fn->text, fn->length);
+	c2m_string_append_n(a, "(", 1);
+	for(c2m_node_t* param = fn->child; param; param = param->next) {
+		c2m_emit_param(param, param->text, param->length, a);
+		if(param->next) c2m_string_append_n(a, ",", 1);
+	}
+	c2m_string_append_n(a, ")", 1);
+}
+
+static inline void c2m_emit_prototype(c2m_node_t* fn, struct cl_array* a) {
+	c2m_emit_signature(fn, a);
+	c2m_string_append(a, ";\n");
+}
+
+// The --profile entries of the parallel loops' functions in `block`, named
+// after the function they're in.
+static void c2m_emit_profile_loops(c2m_node_t* fn, c2m_node_t* block,
+	struct cl_array* a)
+{
+	for(; block; block = block->next) {
+		if(block->kind == NODE_WHILE || block->kind == NODE_BENCH ||
+			block->kind == NODE_FOR || block->kind == NODE_PARALLEL)
+		{
+			c2m_emit_profile_loops(fn, block->body, a);
+		}
+		if(block->kind != NODE_PARALLEL) continue;
+		c2m_string_appendf(a, "C2M_PROFILE_FN(%.*s, \"",
+			(int)block->module_length, block->module);
+		if(fn->module) {
+			c2m_string_appendf(a, "%.*s.", (int)fn->module_length,
+				fn->module);
+		}
+		c2m_string_appendf(a, "%.*s parallel for\", \"%s\", %u)\n",
+			(int)fn->length, fn->text, c2m_emit_file, block->line);
+	}
+}
+
+/*
+ * The --profile entry of `fn` ( main's has no module ) & its loops, after
+ * them: c2m_profile.c symbolizes samples with its address, "module.name",
+ * file & line.
+*/
+static void c2m_emit_profile(c2m_node_t* fn, struct cl_array* a) {
+	if(fn->module) {
+		c2m_string_appendf(a, "C2M_PROFILE_FN(%.*s__%.*s, \"%.*s.%.*s\", ",
+			(int)fn->module_length, fn->module, (int)fn->length, fn->text,
+			(int)fn->module_length, fn->module, (int)fn->length, fn->text);
+	}else{
+		c2m_string_appendf(a, "C2M_PROFILE_FN(%.*s, \"%.*s\", ",
+			(int)fn->length, fn->text, (int)fn->length, fn->text);
+	}
+	c2m_string_appendf(a, "\"%s\", %u)\n", c2m_emit_file, fn->line);
+	c2m_emit_profile_loops(fn, fn->body, a);
+}
+
+// Functions are static in a single translation unit, shared when split or
+// exported by a library.  One statement wrappers are inlined, unless it's a
+// loop or traced ( a slice named "module.function" around the body ).
+static void c2m_emit_function(c2m_t* c2m, c2m_node_t* fn, struct cl_array* a) {
+	uint8_t local = c2m->split == 0 && fn->module != c2m->exports;
+	const char* file = c2m_emit_file;
+
+	c2m_emit_file = c2m_module_file(c2m, fn->module);
+	c2m_emit_parallels(c2m, fn->body, a);
+	if(fn->indirect) {
+		c2m_emit_async(c2m, fn, a);
+		c2m_emit_file = file;
+		return;
+	}
+	if(local) c2m_string_append(a, "static ");
+	if(local && fn->traced == 0 && fn->body && fn->body->next == NULL &&
+		fn->body->kind != NODE_WHILE && fn->body->kind != NODE_FOR)
+	{
+		c2m_string_append(a, "C2M_INLINE ");
+	}
+	c2m_emit_signature(fn, a);
+	c2m_string_append(a, "{\n");
+	if(fn->traced) {
+		c2m_string_appendf(a, "c2m_trace_begin(\"%.*s.%.*s\");\n",
+			(int)fn->module_length, fn->module, (int)fn->length, fn->text);
+	}
+	c2m_emit_block(c2m, fn->body, a);
+	if(fn->traced) c2m_string_append(a, "c2m_trace_end();\n");
+	c2m_string_append(a, "}\n");
+	if(c2m->libreq.profile) c2m_emit_profile(fn, a);
+	c2m_emit_file = file;
+}
+
+/*
+ * A collection of `record`: "main__R_rows", its elements ( c2m_at ) or an
+ * array per field for a "soa" record, then main__R_push() & main__R_at(),
+ * which checks an index.  The arrays are doubled when full.
+*/
+static void c2m_emit_rows(c2m_node_t* record, struct cl_array* a) {
+	uint8_t soa = record->indirect & C2M_RECORD_SOA;
+	int length = record->length;
+
+	c2m_string_append(a, "typedef struct{ ");
+	if(soa) {
+		for(c2m_node_t* field = record->child; field; field = field->next) {
+			c2m_emit_type(field->type, field->record, a);
+			c2m_string_appendf(a, "* %.*s; ", (int)field->length,
+				field->text);
+		}
+	}else{
+		c2m_string_appendf(a, "main__%.*s* c2m_at; ", length, record->text);
+	}
+	c2m_string_appendf(a, "size_t c2m_n, c2m_cap; }main__%.*s_rows;\n",
+		length, record->text);
+	c2m_string_appendf(a, "static inline void main__%.*s_push("
+		"main__%.*s_rows* r, main__%.*s v){\n"
+		"if(r->c2m_n == r->c2m_cap){\n"
+		"r->c2m_cap = r->c2m_cap ? r->c2m_cap * 2 : 8;\n", length,
+		record->text, length, record->text, length, record->text);
+	for(c2m_node_t* field = soa ? record->child : NULL; field;
+		field = field->next)
+	{
+		c2m_string_appendf(a, "if((r->%.*s = realloc(r->%.*s, r->c2m_cap * "
+			"sizeof(*r->%.*s))) == NULL) abort();\n", (int)field->length,
+			field->text, (int)field->length, field->text,
+			(int)field->length, field->text);
+	}
+	if(soa) {
+		c2m_string_append(a, "}\n");
+		for(c2m_node_t* field = record->child; field; field = field->next) {
+			c2m_string_appendf(a, "r->%.*s[r->c2m_n] = v.%.*s;\n",
+				(int)field->length, field->text, (int)field->length,
+				field->text);
+		}
+	}else{
+		c2m_string_append(a, "if((r->c2m_at = realloc(r->c2m_at, r->c2m_cap"
+			" * sizeof(*r->c2m_at))) == NULL) abort(); }\n"
+			"r->c2m_at[r->c2m_n] = v;\n");
+	}
+	c2m_string_append(a, "r->c2m_n++; }\n");
+	c2m_string_appendf(a, "static inline size_t main__%.*s_at("
+		"const main__%.*s_rows* r, uint64_t i){\n"
+		"if(i >= r->c2m_n){ fputs(\"No such item\\n\", stderr); exit(1); }"
+		"\nreturn i; }\n", length, record->text, length, record->text);
+}
+
+/*
+ * The program's records as C structs, in the order defined ( a record's
+ * fields are defined before it ), fields laid out by c2m_record_fields().
+*/
+static void c2m_emit_records(c2m_t* c2m, struct cl_array* a) {
+	for(c2m_node_t* record = c2m->records; record; record = record->next) {
+		c2m_node_t** fields = malloc(sizeof(c2m_node_t*) *
+			c2m_record_count(record));
+		uint32_t n = c2m_record_fields(record, fields);
+
+		c2m_string_append(a, "typedef struct{\n");
+		for(uint32_t i = 0; i < n; i++) {
+			c2m_emit_type(fields[i]->type, fields[i]->record, a);
+			c2m_string_append_n(a, " ", 1);
+			c2m_string_append_n(a, fields[i]->text, fields[i]->length);
+			c2m_string_append(a, ";\n");
+		}
+		c2m_string_append(a, "}");
+		c2m_emit_type(TYPE_RECORD, record, a);
+		c2m_string_append(a, ";\n");
+		if(record->indirect & C2M_RECORD_ROWS) c2m_emit_rows(record, a);
+		free(fields);
+	}
+}
+
+// Fill the main section, library functions are emitted per module
+// ( c2m_module_emit ).
+static void c2m_emit(c2m_t* c2m) {
+	c2m_emit_block(c2m, c2m->main_fn->body, c2m->main);
+}
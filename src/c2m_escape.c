@@ -0,0 +1,252 @@
+// Escape analysis ( a pass ): a runtime concatenation is built in a buffer on
+// the stack, in the scope of the declaration or call it's for, unless what's
+// built could be used after that scope ends.  Then the buffer's on the heap &
+// never freed, like a list's strings.  A value escapes when it's returned by
+// a pure function, in a coroutine's frame ( it outlives each step ), named by
+// raw C that isn't just a runtime call, or in a record passed to an async
+// function: a string argument is copied into the callee's frame, a record's
+// fields aren't.  It also escapes through a record built from it, or a
+// parameter that escapes in the function called, so functions are analyzed
+// again until no parameter changes.  Nothing else is copied at all: strings
+// are passed as views & large records by const pointer ( see c2m_emit_param ).
+
+#include <ctype.h>
+
+#define C2M_ESCAPE_VARS 256 // Escaping names a function can have, at most
+
+typedef struct{
+	c2m_t* c2m;
+	const char* text[C2M_ESCAPE_VARS]; // Names that escape
+	uint32_t length[C2M_ESCAPE_VARS];
+	uint32_t n_vars;
+	uint8_t all; // Too many to keep, everything escapes
+	uint8_t changed;
+}c2m_escape_scope_t;
+
+// A function & a bit for each of its parameters that escapes ( all those
+// past the 64th do ).
+typedef struct{
+	c2m_node_t* fn;
+	uint64_t params;
+}c2m_escape_fn_t;
+
+typedef struct{
+	c2m_escape_fn_t* fns;
+	uint32_t n_fns;
+}c2m_escape_t;
+
+static uint8_t c2m_escape_has(c2m_escape_scope_t* scope, const char* text,
+	uint32_t length)
+{
+	if(scope->all) return 1;
+	for(uint32_t i = 0; i < scope->n_vars; i++) {
+		if(scope->length[i] == length &&
+			memcmp(scope->text[i], text, length) == 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void c2m_escape_name(c2m_escape_scope_t* scope, const char* text,
+	uint32_t length)
+{
+	if(c2m_escape_has(scope, text, length)) return;
+	scope->changed = 1;
+	if(scope->n_vars == C2M_ESCAPE_VARS) {
+		scope->all = 1;
+		return;
+	}
+	scope->text[scope->n_vars] = text;
+	scope->length[scope->n_vars++] = length;
+}
+
+// Every identifier in raw C escapes, whether it's a variable or not, except
+// in a call to the runtime: it copies anything it keeps ( c2m_list_push ).
+static void c2m_escape_raw(c2m_escape_scope_t* scope, c2m_node_t* raw) {
+	const char* text = raw->text;
+	uint32_t i = 0;
+
+	if(raw->length > 4 && memcmp(text, "c2m_", 4) == 0) {
+		while(i < raw->length && (isalnum((uint8_t)text[i]) ||
+			text[i] == '_')) i++;
+		if(i < raw->length && text[i] == '(' &&
+			text[raw->length - 1] == ')') return;
+		i = 0;
+	}
+	while(i < raw->length) {
+		uint32_t start = i;
+
+		// Skip string & character literals.
+		if(text[i] == '"' || text[i] == '\'') {
+			while(++i < raw->length && text[i] != text[start])
+				if(text[i] == '\\') i++;
+			i++;
+			continue;
+		}
+		if(isalnum((uint8_t)text[i]) == 0 && text[i] != '_') {
+			i++;
+			continue;
+		}
+		while(++i < raw->length && (isalnum((uint8_t)text[i]) ||
+			text[i] == '_'));
+		// A number's digits ( & suffix ) aren't a name.
+		if(isdigit((uint8_t)text[start]) == 0)
+			c2m_escape_name(scope, &text[start], i - start);
+	}
+}
+
+static void c2m_escape_call(c2m_escape_t* escape, c2m_escape_scope_t* scope,
+	c2m_node_t* call);
+
+// What `value` is built from escapes with it.
+static void c2m_escape_value(c2m_escape_t* escape, c2m_escape_scope_t* scope,
+	c2m_node_t* value)
+{
+	switch(value->kind) {
+	case NODE_IDENT:
+		c2m_escape_name(scope, value->text, value->length);
+		break;
+	case NODE_FIELD:
+		c2m_escape_value(escape, scope, value->child);
+		break;
+	case NODE_CONSTRUCT:
+		for(c2m_node_t* field = value->child; field; field = field->next)
+			c2m_escape_value(escape, scope, field);
+		break;
+	case NODE_CALL:
+		// A pure function's value, built from the parameters it returns.
+		c2m_escape_call(escape, scope, value);
+		break;
+	case NODE_CONCAT:
+		// Its parts are copied, only the buffer escapes.
+		if(value->indirect == 0) {
+			value->indirect = 1;
+			scope->changed = 1;
+			scope->c2m->libreq.stdlib = 1;
+		}
+		break;
+	}
+}
+
+static uint64_t c2m_escape_params(c2m_escape_t* escape, c2m_node_t* fn) {
+	for(uint32_t i = 0; i < escape->n_fns; i++)
+		if(escape->fns[i].fn == fn) return escape->fns[i].params;
+	return ~0ULL; // Not analyzed, assume the worst
+}
+
+static void c2m_escape_call(c2m_escape_t* escape, c2m_escape_scope_t* scope,
+	c2m_node_t* call)
+{
+	c2m_module_t* module = c2m_module_get(scope->c2m, call->module);
+	uint64_t params = c2m_escape_params(escape,
+		c2m_module_find(module, call->text));
+	uint32_t i = 0;
+
+	for(c2m_node_t* arg = call->child; arg; arg = arg->next, i++)
+		if(i >= 64 || (params >> i & 1)) c2m_escape_value(escape, scope, arg);
+}
+
+static void c2m_escape_block(c2m_escape_t* escape,
+	c2m_escape_scope_t* scope, c2m_node_t* block)
+{
+	for(; block; block = block->next) {
+		switch(block->kind) {
+		case NODE_RAW:
+			c2m_escape_raw(scope, block);
+			break;
+		case NODE_AWAIT:
+			if(block->child->kind == NODE_RAW)
+				c2m_escape_raw(scope, block->child);
+			else
+				c2m_escape_call(escape, scope, block->child);
+			break;
+		case NODE_CALL:
+			c2m_escape_call(escape, scope, block);
+			break;
+		case NODE_DECLARE:
+			if(block->indirect) {
+				c2m_escape_name(scope, block->child->text,
+					block->child->length);
+			}
+			if(block->body && c2m_escape_has(scope, block->child->text,
+				block->child->length))
+			{
+				c2m_escape_value(escape, scope, block->body);
+			}
+			break;
+		case NODE_RETURN:
+			c2m_escape_value(escape, scope, block->child);
+			break;
+		case NODE_PUSH:
+			// Kept by the collection, past the statement.
+			c2m_escape_value(escape, scope, block->body);
+			break;
+		case NODE_WHILE: case NODE_PARALLEL: case NODE_BENCH: case NODE_FOR:
+			c2m_escape_block(escape, scope, block->body);
+			break;
+		}
+	}
+}
+
+/*
+ * Analyze one function until what escapes in it settles, returns its
+ * parameters that escape.
+*/
+static uint64_t c2m_escape_function(c2m_escape_t* escape, c2m_t* c2m,
+	c2m_node_t* fn)
+{
+	c2m_escape_scope_t scope;
+	uint64_t params = 0;
+	uint32_t i = 0;
+
+	scope.c2m = c2m;
+	scope.n_vars = 0;
+	scope.all = 0;
+	// A coroutine's frame keeps a copy of a record argument.
+	if(fn->indirect) {
+		for(c2m_node_t* param = fn->child; param; param = param->next) {
+			if(param->type == TYPE_RECORD)
+				c2m_escape_name(&scope, param->text, param->length);
+		}
+	}
+	do {
+		scope.changed = 0;
+		c2m_escape_block(escape, &scope, fn->body);
+	} while(scope.changed);
+	for(c2m_node_t* param = fn->child; param; param = param->next, i++) {
+		if(i < 64 && c2m_escape_has(&scope, param->text, param->length))
+			params |= 1ULL << i;
+	}
+	return params;
+}
+
+static void c2m_escape(c2m_t* c2m) {
+	c2m_escape_t escape;
+	uint32_t n = 1;
+	uint8_t changed;
+
+	for(c2m_node_t* fn = c2m->imported; fn; fn = fn->next) n++;
+	escape.fns = malloc(sizeof(c2m_escape_fn_t) * n);
+	escape.n_fns = n;
+	escape.fns[0].fn = c2m->main_fn;
+	n = 1;
+	for(c2m_node_t* fn = c2m->imported; fn; fn = fn->next)
+		escape.fns[n++].fn = fn;
+	// Parameters start out not escaping & only ever start to.
+	for(uint32_t i = 0; i < escape.n_fns; i++) escape.fns[i].params = 0;
+	do {
+		changed = 0;
+		for(uint32_t i = 0; i < escape.n_fns; i++) {
+			uint64_t params = c2m_escape_function(&escape, c2m,
+				escape.fns[i].fn);
+
+			if(params != escape.fns[i].params) {
+				escape.fns[i].params = params;
+				changed = 1;
+			}
+		}
+	} while(changed);
+	free(escape.fns);
+}
@@ -0,0 +1,202 @@
+// Compile-time evaluation ( for c2m_fold ): a pure function, "name(params) ->
+// type {" with only the value it returns as its body, called with constant
+// arguments is worked out here & the call replaced by the result.  So a
+// string or set ( a lookup table ) built by functions costs nothing at run
+// time.  It's substitution: parameters are bound to the constants passed,
+// then the value's concatenations are joined & its sets left for the emitter
+// ( see c2m_emit_set_const ), calls to other pure functions evaluated the same
+// way.  A pure function can't stop recursing, so evaluation gives up after
+// C2M_EVAL_STEPS nodes or C2M_EVAL_DEPTH calls deep & leaves the call to run
+// time, as it does when anything isn't known.  The function's own nodes are
+// never changed, what's evaluated is new ( in the arena given ).
+
+#define C2M_EVAL_STEPS 100000 // Nodes evaluated for one call, at most
+#define C2M_EVAL_DEPTH 64 // Nested calls
+
+typedef struct{
+	c2m_t* c2m;
+	c2m_arena_t* arena;
+	uint32_t steps; // Left
+	uint32_t depth;
+}c2m_eval_t;
+
+// The pure function `call` calls, or NULL.
+static c2m_node_t* c2m_eval_pure(c2m_t* c2m, c2m_node_t* call) {
+	c2m_symbol_t* symbol = c2m_symtab_get(c2m->modules, call->module);
+	c2m_node_t* fn = symbol ? c2m_module_find(symbol->data, call->text) : NULL;
+
+	return fn && fn->body && fn->body->kind == NODE_RETURN ? fn : NULL;
+}
+
+static c2m_node_t* c2m_eval_copy(c2m_eval_t* eval, c2m_node_t* node) {
+	c2m_node_t* copy = c2m_node_create(eval->arena, node->kind, node->line);
+
+	memcpy(copy, node, sizeof(c2m_node_t));
+	copy->next = NULL;
+	return copy;
+}
+
+static c2m_node_t* c2m_eval_value(c2m_eval_t* eval, c2m_node_t* fn,
+	c2m_node_t* args, c2m_node_t* value);
+
+// Evaluate each of a list of values, linked in a new list ( NULL if any
+// isn't known ).
+static uint8_t c2m_eval_list(c2m_eval_t* eval, c2m_node_t* fn,
+	c2m_node_t* args, c2m_node_t* list, c2m_node_t** first)
+{
+	c2m_node_t** tail = first;
+
+	*first = NULL;
+	for(; list; list = list->next) {
+		c2m_node_t* value = c2m_eval_value(eval, fn, args, list);
+
+		if(value == NULL) return 0;
+		c2m_node_append(&tail, value);
+	}
+	return 1;
+}
+
+// Constant parts joined into one string, like c2m_fold_constants().
+static c2m_node_t* c2m_eval_concat(c2m_eval_t* eval, c2m_node_t* fn,
+	c2m_node_t* args, c2m_node_t* concat)
+{
+	c2m_intern_t* intern = eval->c2m->intern;
+	c2m_node_t* parts;
+	uint32_t length;
+
+	if(c2m_eval_list(eval, fn, args, concat->child, &parts) == 0)
+		return NULL;
+	for(c2m_node_t* part = parts; part; part = part->next) {
+		// A double's digits are the runtime's to print.
+		if((part->kind != NODE_STRING && part->kind != NODE_INTEGER &&
+			part->kind != NODE_BOOL) || part->type == TYPE_FLOAT64)
+		{
+			return NULL;
+		}
+	}
+	c2m_intern_lock(intern);
+	for(c2m_node_t* part = parts; part; part = part->next)
+		c2m_node_append_text(intern->key, part);
+	length = c2m_string_length(intern->key);
+	parts->kind = NODE_STRING;
+	parts->type = TYPE_STRING;
+	c2m_node_text(parts, c2m_intern_key(intern), length);
+	parts->next = NULL;
+	return parts;
+}
+
+// A set with its members, bounds or sides known, members in its range.
+static c2m_node_t* c2m_eval_set(c2m_eval_t* eval, c2m_node_t* fn,
+	c2m_node_t* args, c2m_node_t* set)
+{
+	c2m_node_t* copy = c2m_eval_copy(eval, set);
+	int64_t v;
+
+	if(c2m_eval_list(eval, fn, args, set->child, &copy->child) == 0)
+		return NULL;
+	for(c2m_node_t* part = copy->child; part; part = part->next) {
+		if(set->kind == NODE_SETOP) {
+			if(part->type != TYPE_SET) return NULL;
+		}else if(c2m_node_integer(part, &v) == 0) {
+			return NULL;
+		}else if(set->kind == NODE_SET && (v < 0 || v >= C2M_SET_BITS)) {
+			return NULL;
+		}
+	}
+	copy->type = TYPE_SET;
+	return copy;
+}
+
+// The value returned is the type the function returns: a number's text can
+// be a string, nothing else changes type.
+static c2m_node_t* c2m_eval_typed(c2m_node_t* value, c2m_node_t* ret) {
+	if(ret->type == TYPE_SET) return value->type == TYPE_SET ? value : NULL;
+	if(value->kind != NODE_STRING && value->kind != NODE_INTEGER &&
+		value->kind != NODE_BOOL)
+	{
+		return NULL;
+	}
+	if(ret->type == TYPE_STRING) {
+		value->kind = NODE_STRING;
+	}else if(value->kind == NODE_STRING || ret->type == TYPE_RECORD ||
+		ret->type == TYPE_POINTER)
+	{
+		return NULL;
+	}
+	value->type = ret->type;
+	return value;
+}
+
+// Call a pure function, with `call`'s arguments evaluated in `fn`'s scope.
+static c2m_node_t* c2m_eval_call(c2m_eval_t* eval, c2m_node_t* fn,
+	c2m_node_t* args, c2m_node_t* call)
+{
+	c2m_node_t* callee = c2m_eval_pure(eval->c2m, call);
+	c2m_node_t* values;
+	c2m_node_t* result;
+
+	// Too deep to finish, stop evaluating altogether.
+	if(eval->depth == C2M_EVAL_DEPTH) eval->steps = 0;
+	if(callee == NULL || eval->steps == 0 ||
+		c2m_eval_list(eval, fn, args, call->child, &values) == 0)
+	{
+		return NULL;
+	}
+	eval->depth++;
+	result = c2m_eval_value(eval, callee, values, callee->body->child);
+	eval->depth--;
+	return result ? c2m_eval_typed(result, callee->body) : NULL;
+}
+
+// Evaluate `value` in `fn` with its parameters bound to `args`.
+static c2m_node_t* c2m_eval_value(c2m_eval_t* eval, c2m_node_t* fn,
+	c2m_node_t* args, c2m_node_t* value)
+{
+	if(eval->steps == 0) return NULL;
+	eval->steps--;
+	switch(value->kind) {
+	case NODE_STRING: case NODE_INTEGER: case NODE_BOOL:
+		return c2m_eval_copy(eval, value);
+	case NODE_IDENT:
+		if(fn == NULL) return NULL;
+		for(c2m_node_t* param = fn->child; param && args;
+			param = param->next, args = args->next)
+		{
+			if(param->length == value->length &&
+				memcmp(param->text, value->text, value->length) == 0)
+			{
+				return c2m_eval_copy(eval, args);
+			}
+		}
+		return NULL;
+	case NODE_CONCAT:
+		return c2m_eval_concat(eval, fn, args, value);
+	case NODE_SET: case NODE_RANGE: case NODE_SETOP:
+		return c2m_eval_set(eval, fn, args, value);
+	case NODE_CALL:
+		return c2m_eval_call(eval, fn, args, value);
+	}
+	return NULL;
+}
+
+/*
+ * Returns the constant a call to a pure function with constant arguments
+ * evaluates to ( new nodes in `arena` ), or NULL to leave it to run time.
+*/
+static c2m_node_t* c2m_eval(c2m_t* c2m, c2m_arena_t* arena, c2m_node_t* call)
+{
+	c2m_eval_t eval;
+	c2m_node_t* value;
+
+	eval.c2m = c2m;
+	eval.arena = arena;
+	eval.steps = C2M_EVAL_STEPS;
+	eval.depth = 0;
+	value = c2m_eval_call(&eval, NULL, NULL, call);
+	if(value == NULL && eval.steps == 0) {
+		c2m_log(C2M_LOG_DEBUG, "Too long to evaluate %.*s.%.*s\n",
+			(int)call->module_length, call->module, (int)call->length,
+			call->text);
+	}
+	return value;
+}
@@ -0,0 +1,78 @@
+// Libraries ( library = TRUE in c2m.config ): the functions of
+// src/<name>.c2m are the library, exported as <name>__<function> ( what a
+// c2m program calling <name>.<function> links to ) & declared in a generated
+// <name>.h.  There's no main(), the C is compiled to the object lib<name>.o,
+// which is archived into lib<name>.a & linked into lib<name>.so.  Functions
+// of the modules it imports stay static, unless split.
+
+#include <ctype.h>
+
+/*
+ * Returns 1 if `name` isn't a C identifier.
+*/
+static uint8_t c2m_export_check(const char* name) {
+	if(name == NULL || !(isalpha((unsigned char)name[0]) || name[0] == '_'))
+		return 1;
+	for(const char* c = name; *c; c++)
+		if(!(isalnum((unsigned char)*c) || *c == '_')) return 1;
+	return 0;
+}
+
+// Write <name>.h: the C types the exported functions take & their
+// prototypes, only if it changed so programs using it aren't rebuilt.
+static void c2m_export_header(c2m_t* c2m) {
+	struct cl_array* text = c2m_string_create(NULL);
+
+	c2m_string_appendf(text, "// %s %s, generated by c2m\n"
+		"#ifndef C2M_LIB_%s_H\n#define C2M_LIB_%s_H\n", c2m->name,
+		c2m->version ? c2m->version : "", c2m->name, c2m->name);
+	c2m_string_append(text, "#include <stdint.h>\n");
+	// Another c2m library's header may have them already.
+	c2m_string_append(text, "#ifndef C2M_STR\n");
+	c2m_string_append(text, c2m_prelude_string);
+	c2m_string_append(text, "#endif\n");
+	if(c2m->libreq.list) {
+		c2m_string_append(text, "#ifndef c2m_list_data\n");
+		c2m_string_append(text, c2m_prelude_list_type);
+		c2m_string_append(text, "#endif\n");
+	}
+	if(c2m->libreq.set) {
+		c2m_string_append(text, "#ifndef C2M_SET_WORDS\n");
+		c2m_string_append(text, c2m_prelude_set_type);
+		c2m_string_append(text, "#endif\n");
+	}
+	c2m_string_append(text, "#ifdef __cplusplus\nextern \"C\" {\n#endif\n");
+	for(c2m_node_t* fn = c2m->imported; fn; fn = fn->next)
+		if(fn->module == c2m->exports) c2m_emit_prototype(fn, text);
+	c2m_string_append(text, "#ifdef __cplusplus\n}\n#endif\n#endif\n");
+	c2m_split_write(c2m->header, text);
+	c2m_string_destroy(text);
+}
+
+/*
+ * Archive & link the object into lib<name>.a & lib<name>.so, returns 1 if
+ * either failed.
+*/
+static uint8_t c2m_export_link(c2m_t* c2m) {
+	struct cl_array* archive = c2m_string_create(NULL);
+	struct cl_array* shared = c2m_string_create(NULL);
+	char* ar[] = { "ar", "rcs", NULL, c2m->output, NULL };
+	char* link[C2M_BACKEND_ARGS];
+	char** commands[] = { ar, link };
+	uint32_t n = c2m_backend_start(c2m, link);
+	uint8_t failed;
+
+	c2m_string_appendf(archive, "lib%s.a", c2m->name);
+	c2m_string_appendf(shared, "lib%s.so", c2m->name);
+	// ar replaces the member, it's the same object every build.
+	ar[2] = archive->store;
+	link[n++] = "-shared";
+	link[n++] = c2m->output;
+	link[n++] = "-o";
+	link[n++] = shared->store;
+	link[n] = NULL;
+	failed = c2m_split_run(commands, 2, 2);
+	c2m_string_destroy(archive);
+	c2m_string_destroy(shared);
+	return failed;
+}
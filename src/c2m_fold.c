@@ -0,0 +1,490 @@
+// Constant folding of string concatenation: adjacent constant parts ( string,
+// integer & bool literals ) are merged into one string literal, a
+// concatenation with no runtime parts becomes a plain string.  Identifiers
+// get their type from the function's parameters & declarations, the emitter
+// then writes runtime parts into a buffer of precomputed size.  Declarations
+// & call arguments are type checked on the way.  A pure function's call with
+// constant arguments is replaced by its value, see c2m_eval.c.
+
+// The arena of the function being folded, for what c2m_eval() makes.
+static c2m_arena_t* c2m_fold_arena;
+
+// Record a type error on `line` about `named` & drop the statement it's in,
+// see c2m_fold_statement().
+static void c2m_fold_error(c2m_t* c2m, uint32_t line, c2m_node_t* named,
+	const char* message)
+{
+	c2m_diag(c2m, line, 0, message, named->text, named->length);
+	longjmp(*c2m->recover, 1);
+}
+
+// Scope: one function at a time, kept in c2m->variables.
+static void c2m_fold_scope_clear(c2m_t* c2m) {
+	c2m_symtab_clear(c2m->variables);
+}
+
+// Merge parts `first` up to ( not including ) `end` into one NODE_STRING.
+static c2m_node_t* c2m_fold_constants(c2m_t* c2m, c2m_node_t* first,
+	c2m_node_t* end)
+{
+	c2m_intern_t* intern = c2m->intern;
+	uint32_t length;
+
+	if(first->next == end && first->kind == NODE_STRING) return first;
+	// Joined in the intern's scratch key, no copy of its own.
+	c2m_intern_lock(intern);
+	for(c2m_node_t* part = first; part != end; part = part->next)
+		c2m_node_append_text(intern->key, part);
+	length = c2m_string_length(intern->key);
+	first->kind = NODE_STRING;
+	first->type = TYPE_STRING;
+	c2m_node_text(first, c2m_intern_key(intern), length);
+	first->next = end;
+	return first;
+}
+
+// A decimal literal isn't, it's printed like a double at runtime.
+static inline uint8_t c2m_fold_is_constant(c2m_node_t* part) {
+	return part->kind == NODE_STRING || part->kind == NODE_BOOL ||
+		(part->kind == NODE_INTEGER && part->type != TYPE_FLOAT64);
+}
+
+// Type an identifier from the scope.
+static void c2m_fold_ident(c2m_t* c2m, c2m_node_t* ident) {
+	c2m_symbol_t* var = c2m_symtab_get(c2m->variables, ident->text);
+
+	if(var == NULL) c2m_fold_error(c2m, ident->line, ident, "Unknown variable");
+	ident->type = var->type;
+	ident->record = ((c2m_node_t*)var->data)->record;
+	ident->indirect = ((c2m_node_t*)var->data)->indirect;
+	if(ident->type == TYPE_ARGS) c2m->libreq.args = 1;
+}
+
+static c2m_node_t* c2m_fold_value(c2m_t* c2m, c2m_node_t* value);
+
+static c2m_node_t* c2m_fold_concat(c2m_t* c2m, c2m_node_t* concat) {
+	c2m_node_t** link = &concat->child;
+
+	// Calls first, those evaluated are merged with the other constants.
+	for(; *link; link = &(*link)->next)
+		if((*link)->kind == NODE_CALL) *link = c2m_fold_value(c2m, *link);
+	link = &concat->child;
+	while(*link) {
+		c2m_node_t* part = *link;
+
+		if(c2m_fold_is_constant(part)) {
+			c2m_node_t* end = part->next;
+
+			while(end && c2m_fold_is_constant(end)) end = end->next;
+			*link = c2m_fold_constants(c2m, part, end);
+		}else if(part->kind == NODE_IDENT || part->kind == NODE_FIELD ||
+			part->kind == NODE_INDEX || part->kind == NODE_CALL ||
+			part->kind == NODE_INTEGER)
+		{
+			if(part->kind != NODE_CALL) c2m_fold_value(c2m, part);
+			if(part->type == TYPE_RECORD || part->type == TYPE_POINTER ||
+				part->type == TYPE_ARGS || part->type == TYPE_LIST ||
+				part->type == TYPE_ROWS)
+			{
+				c2m_fold_error(c2m, part->line, part,
+					"Can't concatenate value");
+			}
+			if(part->type != TYPE_STRING) c2m->libreq.concat = 1;
+		}else if(part->kind == NODE_SET || part->kind == NODE_RANGE ||
+			part->kind == NODE_SETOP)
+		{
+			c2m_fold_value(c2m, part);
+			c2m->libreq.concat = 1;
+		}else{
+			c2m_fold_error(c2m, part->line, part, "Can't concatenate value");
+		}
+		link = &(*link)->next;
+	}
+	// Nothing known only at runtime, it's one literal now.
+	if(concat->child->next == NULL && concat->child->kind == NODE_STRING)
+		return concat->child;
+	c2m->libreq.string = 1;
+	return concat;
+}
+
+// Returns 1 if a `value` can't be stored as `type` ( of `record` ).
+static inline uint8_t c2m_fold_mismatch(c2m_node_t* value, uint8_t type,
+	c2m_node_t* record)
+{
+	if(value->type == TYPE_RECORD || type == TYPE_RECORD ||
+		value->type == TYPE_ARGS || type == TYPE_ARGS ||
+		value->type == TYPE_LIST || type == TYPE_LIST ||
+		value->type == TYPE_SET || type == TYPE_SET ||
+		value->type == TYPE_ROWS || type == TYPE_ROWS)
+	{
+		return value->type != type || value->record != record;
+	}
+	return (value->type == TYPE_STRING) != (type == TYPE_STRING);
+}
+
+// "a.b", the field's type from the record.
+static void c2m_fold_field(c2m_t* c2m, c2m_node_t* access) {
+	c2m_node_t* field;
+
+	access->child = c2m_fold_value(c2m, access->child);
+	if(access->child->type != TYPE_RECORD ||
+		(field = c2m_record_field(access->child->record, access->text))
+		== NULL)
+	{
+		c2m_fold_error(c2m, access->line, access, "No such field");
+	}
+	access->type = field->type;
+	access->record = field->record;
+}
+
+// "list[i]", a string from a list or main()'s args, or a record from a
+// collection.
+static void c2m_fold_index(c2m_t* c2m, c2m_node_t* index) {
+	index->child = c2m_fold_value(c2m, index->child);
+	index->body = c2m_fold_value(c2m, index->body);
+	if(index->child->type != TYPE_LIST && index->child->type != TYPE_ARGS &&
+		index->child->type != TYPE_ROWS)
+	{
+		c2m_fold_error(c2m, index->line, index->child, "Not a list");
+	}
+	if(c2m_type_is_integer(index->body->type) == 0)
+		c2m_fold_error(c2m, index->line, index->body, "Index isn't an integer");
+	index->type = TYPE_STRING;
+	index->record = NULL;
+	index->indirect = 0;
+	if(index->child->type == TYPE_ROWS) {
+		index->type = TYPE_RECORD;
+		index->record = index->child->record;
+	}
+}
+
+// Lists are only passed by pointer, a copy would share the heap part.
+static inline void c2m_fold_copy(c2m_t* c2m, c2m_node_t* value) {
+	if(value->type == TYPE_LIST)
+		c2m_fold_error(c2m, value->line, value, "Lists can't be copied");
+}
+
+// "Record(value, ...)", a value for each field in the order written.
+static void c2m_fold_construct(c2m_t* c2m, c2m_node_t* construct) {
+	c2m_node_t* field = construct->record->child;
+
+	for(c2m_node_t** link = &construct->child; *link; link = &(*link)->next)
+	{
+		*link = c2m_fold_value(c2m, *link);
+		c2m_fold_copy(c2m, *link);
+		if(field == NULL || c2m_fold_mismatch(*link, field->type,
+			field->record))
+		{
+			c2m_fold_error(c2m, construct->line, construct->record,
+				"Wrong values for record");
+		}
+		field = field->next;
+	}
+	if(field) {
+		c2m_fold_error(c2m, construct->line, construct->record,
+			"Not enough values for record");
+	}
+}
+
+// "{a, b}" & intervals take integers, a literal member must be in the set's
+// range.  Both sides of "∪" & "∩" are sets.
+static void c2m_fold_set(c2m_t* c2m, c2m_node_t* set) {
+	for(c2m_node_t** link = &set->child; *link; link = &(*link)->next) {
+		c2m_node_t* part = *link = c2m_fold_value(c2m, *link);
+		int64_t v;
+
+		if(set->kind == NODE_SETOP) {
+			if(part->type != TYPE_SET)
+				c2m_fold_error(c2m, set->line, set, "Not a set");
+		}else if(c2m_type_is_integer(part->type) == 0) {
+			c2m_fold_error(c2m, set->line, part, "Not an integer");
+		}else if(set->kind == NODE_SET && c2m_node_integer(part, &v) &&
+			(v < 0 || v >= C2M_SET_BITS))
+		{
+			c2m_fold_error(c2m, set->line, part, "Set member out of range");
+		}
+	}
+	set->type = TYPE_SET;
+}
+
+static void c2m_fold_call(c2m_t* c2m, c2m_node_t* call);
+
+// A pure function's value, evaluated now if its arguments are constant.  Its
+// arguments aren't built in a scope of their own, like a statement's.
+static c2m_node_t* c2m_fold_call_value(c2m_t* c2m, c2m_node_t* call) {
+	c2m_node_t* fn = c2m_module_find(c2m_module_get(c2m, call->module),
+		call->text);
+	c2m_node_t* value;
+
+	c2m_fold_call(c2m, call);
+	if(fn->body == NULL || fn->body->kind != NODE_RETURN)
+		c2m_fold_error(c2m, call->line, call, "Function has no value");
+	for(c2m_node_t* arg = call->child; arg; arg = arg->next) {
+		if(arg->kind == NODE_CONCAT) {
+			c2m_fold_error(c2m, call->line, call,
+				"Declare a concatenation to pass it to a pure function");
+		}
+	}
+	call->type = fn->body->type;
+	call->record = fn->body->record;
+	if((value = c2m_eval(c2m, c2m_fold_arena, call)) == NULL) return call;
+	value->next = call->next;
+	return value;
+}
+
+// Fold & type one value, returns what replaces it.
+static c2m_node_t* c2m_fold_value(c2m_t* c2m, c2m_node_t* value) {
+	c2m_node_t* next = value->next;
+
+	if(value->kind == NODE_CONCAT) {
+		value = c2m_fold_concat(c2m, value);
+		value->type = TYPE_STRING;
+		value->next = next;
+	}else if(value->kind == NODE_IDENT) {
+		c2m_fold_ident(c2m, value);
+	}else if(value->kind == NODE_FIELD) {
+		c2m_fold_field(c2m, value);
+	}else if(value->kind == NODE_CONSTRUCT) {
+		c2m_fold_construct(c2m, value);
+	}else if(value->kind == NODE_INDEX) {
+		c2m_fold_index(c2m, value);
+	}else if(value->kind == NODE_SET || value->kind == NODE_RANGE ||
+		value->kind == NODE_SETOP)
+	{
+		c2m_fold_set(c2m, value);
+	}else if(value->kind == NODE_CALL) {
+		value = c2m_fold_call_value(c2m, value);
+	}
+	return value;
+}
+
+static void c2m_fold_declare(c2m_t* c2m, c2m_node_t* node) {
+	if(node->type == TYPE_ROWS) {
+		if(node->body) {
+			c2m_fold_error(c2m, node->line, node->child,
+				"A collection starts out empty");
+		}
+		node->record->indirect |= C2M_RECORD_ROWS;
+	}
+	if(node->body) {
+		node->body = c2m_fold_value(c2m, node->body);
+		c2m_fold_copy(c2m, node->body);
+		if(c2m_fold_mismatch(node->body, node->type, node->record))
+			c2m_fold_error(c2m, node->line, node->child, "Wrong type of value");
+	}
+	if(c2m_symtab_get(c2m->variables, node->child->text))
+		c2m_fold_error(c2m, node->line, node->child, "Variable declared twice");
+	c2m_symtab_add(c2m->variables, node->child->text, SYMBOL_VARIABLE,
+		node->type, node);
+}
+
+// Arguments are checked against the called function's parameters.
+static void c2m_fold_call(c2m_t* c2m, c2m_node_t* call) {
+	c2m_module_t* module = c2m_module_get(c2m, call->module);
+	c2m_node_t* fn = c2m_module_find(module, call->text);
+	c2m_node_t* param = fn->child;
+
+	for(c2m_node_t** link = &call->child; *link; link = &(*link)->next) {
+		*link = c2m_fold_value(c2m, *link);
+		if(param == NULL || c2m_fold_mismatch(*link, param->type,
+			param->record))
+		{
+			c2m_fold_error(c2m, call->line, call, "Wrong arguments");
+		}
+		// Passed by address, it needs to be somewhere.
+		if((*link)->kind == NODE_CALL && param->indirect) {
+			c2m_fold_error(c2m, call->line, *link,
+				"Declare the record returned to pass it");
+		}
+		param = param->next;
+	}
+	if(param) c2m_fold_error(c2m, call->line, call, "Not enough arguments");
+}
+
+// A pure function's value is the type it returns.
+static void c2m_fold_return(c2m_t* c2m, c2m_node_t* node) {
+	node->child = c2m_fold_value(c2m, node->child);
+	c2m_fold_copy(c2m, node->child);
+	if(c2m_fold_mismatch(node->child, node->type, node->record))
+		c2m_fold_error(c2m, node->line, node->child, "Wrong type of value");
+}
+
+static void c2m_fold_block(c2m_t* c2m, c2m_node_t* node);
+
+// A parallel loop's bounds are integers & a reduction's variable a number
+// declared before it.  The loop's variable is an int64_t, declared by the
+// loop ( its interval ) so another loop can use the same name.
+static void c2m_fold_parallel(c2m_t* c2m, c2m_node_t* node) {
+	c2m_node_t* range = node->child;
+	c2m_node_t* reduce = range->next;
+	c2m_symbol_t* var = c2m_symtab_get(c2m->variables, node->text);
+
+	for(c2m_node_t** link = &range->child; *link; link = &(*link)->next) {
+		*link = c2m_fold_value(c2m, *link);
+		if(c2m_type_is_integer((*link)->type) == 0)
+			c2m_fold_error(c2m, node->line, *link, "Not an integer");
+	}
+	if(reduce) {
+		c2m_fold_ident(c2m, reduce->child);
+		reduce->type = reduce->child->type;
+		if(c2m_type_is_integer(reduce->type) == 0 &&
+			reduce->type != TYPE_FLOAT32 && reduce->type != TYPE_FLOAT64)
+		{
+			c2m_fold_error(c2m, node->line, reduce->child,
+				"Can only reduce a number");
+		}
+	}
+	if(var && ((c2m_node_t*)var->data)->kind != NODE_RANGE &&
+		((c2m_node_t*)var->data)->kind != NODE_FOR)
+	{
+		c2m_fold_error(c2m, node->line, node, "Variable declared twice");
+	}
+	if(var == NULL) {
+		c2m_symtab_add(c2m->variables, node->text, SYMBOL_VARIABLE,
+			TYPE_SINT64, range);
+	}
+	node->type = TYPE_SINT64;
+	c2m_fold_block(c2m, node->body);
+}
+
+// A for loop's over an interval of integers or a list's indices ( or
+// args' ), its variable an int64_t declared by the loop like a parallel
+// loop's, or over a file's lines, its variable a string.
+static void c2m_fold_for(c2m_t* c2m, c2m_node_t* node) {
+	c2m_symbol_t* var = c2m_symtab_get(c2m->variables, node->text);
+	uint8_t type = TYPE_SINT64;
+
+	node->indirect = 0; // Until c2m_loop.c hoists, its variable's a value
+	if(node->child->kind == NODE_LINES) {
+		node->child->child = c2m_fold_value(c2m, node->child->child);
+		if(node->child->child->type != TYPE_STRING) {
+			c2m_fold_error(c2m, node->line, node->child->child,
+				"Not a file name");
+		}
+		node->child->type = type = TYPE_STRING;
+	}else if(node->child->kind == NODE_RANGE) {
+		for(c2m_node_t** link = &node->child->child; *link;
+			link = &(*link)->next)
+		{
+			*link = c2m_fold_value(c2m, *link);
+			if(c2m_type_is_integer((*link)->type) == 0)
+				c2m_fold_error(c2m, node->line, *link, "Not an integer");
+		}
+		node->child->type = TYPE_SINT64;
+	}else{
+		node->child = c2m_fold_value(c2m, node->child);
+		if(node->child->type != TYPE_LIST && node->child->type != TYPE_ARGS &&
+			node->child->type != TYPE_ROWS)
+		{
+			c2m_fold_error(c2m, node->line, node->child,
+				"Not an interval or list");
+		}
+	}
+	if(var && ((c2m_node_t*)var->data)->kind != NODE_RANGE &&
+		((c2m_node_t*)var->data)->kind != NODE_FOR)
+	{
+		c2m_fold_error(c2m, node->line, node, "Variable declared twice");
+	}
+	if(var == NULL) {
+		c2m_symtab_add(c2m->variables, node->text, SYMBOL_VARIABLE, type,
+			node);
+	}else{
+		var->type = type; // Another loop's, which has ended
+	}
+	node->type = type;
+	c2m_fold_block(c2m, node->body);
+}
+
+// "push(name, value)", a record of the collection's type.
+static void c2m_fold_push(c2m_t* c2m, c2m_node_t* node) {
+	node->child = c2m_fold_value(c2m, node->child);
+	if(node->child->kind != NODE_IDENT || node->child->type != TYPE_ROWS)
+		c2m_fold_error(c2m, node->line, node->child, "Not a collection");
+	node->body = c2m_fold_value(c2m, node->body);
+	if(c2m_fold_mismatch(node->body, TYPE_RECORD, node->child->record))
+		c2m_fold_error(c2m, node->line, node->child, "Wrong type of value");
+}
+
+// What's awaited is a call to an async function, or a file descriptor ( C ).
+static void c2m_fold_await(c2m_t* c2m, c2m_node_t* node) {
+	c2m_node_t* call = node->child;
+
+	if(call->kind != NODE_CALL) return;
+	c2m_fold_call(c2m, call);
+	if(c2m_module_find(c2m_module_get(c2m, call->module),
+		call->text)->indirect == 0)
+	{
+		c2m_fold_error(c2m, node->line, call, "Not an async function");
+	}
+}
+
+// Fold & check one statement, after an error the next one is checked.
+static void c2m_fold_statement(c2m_t* c2m, c2m_node_t* node) {
+	jmp_buf* outer = c2m->recover;
+	jmp_buf jump;
+
+	if(node->kind == NODE_WHILE) {
+		c2m_fold_block(c2m, node->body);
+		return;
+	}
+	// A bench has a scope of its own ( main's body is only benches ).
+	if(node->kind == NODE_BENCH) {
+		c2m_fold_scope_clear(c2m);
+		c2m_fold_block(c2m, node->body);
+		return;
+	}
+	if(node->kind != NODE_DECLARE && node->kind != NODE_CALL &&
+		node->kind != NODE_PARALLEL && node->kind != NODE_AWAIT &&
+		node->kind != NODE_RETURN && node->kind != NODE_FOR &&
+		node->kind != NODE_PUSH)
+	{
+		return;
+	}
+	c2m->recover = &jump;
+	if(setjmp(jump) == 0) {
+		if(node->kind == NODE_DECLARE) c2m_fold_declare(c2m, node);
+		else if(node->kind == NODE_PARALLEL) c2m_fold_parallel(c2m, node);
+		else if(node->kind == NODE_AWAIT) c2m_fold_await(c2m, node);
+		else if(node->kind == NODE_RETURN) c2m_fold_return(c2m, node);
+		else if(node->kind == NODE_FOR) c2m_fold_for(c2m, node);
+		else if(node->kind == NODE_PUSH) c2m_fold_push(c2m, node);
+		else c2m_fold_call(c2m, node);
+	}else if(node->kind == NODE_DECLARE &&
+		c2m_symtab_get(c2m->variables, node->child->text) == NULL)
+	{
+		// Declared anyway, so using it isn't an error as well.
+		c2m_symtab_add(c2m->variables, node->child->text,
+			SYMBOL_VARIABLE, node->type, node);
+	}
+	c2m->recover = outer;
+}
+
+static void c2m_fold_block(c2m_t* c2m, c2m_node_t* node) {
+	for(; node; node = node->next) c2m_fold_statement(c2m, node);
+}
+
+static void c2m_fold_function(c2m_t* c2m, c2m_node_t* fn) {
+	c2m_fold_scope_clear(c2m);
+	for(c2m_node_t* param = fn->child; param; param = param->next) {
+		// A coroutine outlives its caller's list.
+		if(fn->indirect && param->type == TYPE_LIST)
+			c2m_diag_node(c2m, param, "An async function can't take a list");
+		c2m_symtab_add(c2m->variables, param->text, SYMBOL_VARIABLE,
+			param->type, param);
+	}
+	c2m_fold_block(c2m, fn->body);
+}
+
+static void c2m_fold(c2m_t* c2m) {
+	c2m_fold_arena = c2m->arena;
+	c2m_fold_function(c2m, c2m->main_fn);
+	for(c2m_node_t* fn = c2m->imported; fn; fn = fn->next) {
+		c2m_module_t* module = c2m_module_get(c2m, fn->module);
+
+		c2m->file = module->path->store;
+		c2m_fold_arena = module->arena;
+		c2m_fold_function(c2m, fn);
+	}
+	c2m->file = "src/main.c2m";
+	c2m_fold_scope_clear(c2m);
+}
@@ -0,0 +1,48 @@
+// Writes c2m_import_table.c: a perfect hash ( Clump PHash ) of the library
+// names `import` accepts, and the c2m_libreq_t field each one sets.  Not part
+// of c2m itself, run `make import-table` after changing c2m_import_names.
+
+#include <stdio.h>
+
+#include "../clump/src/clump.c"
+#include "../clump/src/arena.c"
+#include "../clump/src/pool.c"
+#include "../clump/src/filter.c"
+#include "../clump/src/rhash.c"
+#include "../clump/src/phash.c"
+
+// Each is also the name of its c2m_libreq_t field.
+static const char* c2m_import_names[] = {
+	"stdio", "stdlib", "clump", "sdl", "sdl_window", "sdl_audio", "io",
+	"agg",
+};
+
+int main(int argc, char* argv[]) {
+	uint32_t count = sizeof(c2m_import_names) / sizeof(c2m_import_names[0]);
+
+	if(argc != 2) {
+		fprintf(stderr, "usage: %s c2m_import_table.c\n", argv[0]);
+		return 1;
+	}
+	struct cl_phash* phash = cl_phash_create(
+		(const void* const*)c2m_import_names, count, 0);
+	if(phash == NULL || !cl_phash_write_c(phash, "c2m_import_table", argv[1]))
+	{
+		fprintf(stderr, "%s: can't write %s\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	const struct cl_phash_table* table = cl_phash_table(phash);
+	FILE* file = fopen(argv[1], "a");
+
+	if(file == NULL) return 1;
+	fprintf(file, "\n// c2m_libreq_t field of each slot\n");
+	fprintf(file, "static const uint8_t c2m_import_field[%u] = {\n", count);
+	for(uint32_t i = 0; i < count; i++) {
+		fprintf(file, "\toffsetof(c2m_libreq_t, %s),\n",
+			(const char*)cl_phash_key(table, i));
+	}
+	fprintf(file, "};\n");
+	cl_phash_destroy(phash);
+	return fclose(file) != 0;
+}
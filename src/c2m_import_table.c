@@ -0,0 +1,32 @@
+/* Perfect hash table written by cl_phash_write_c */
+
+static const uint32_t c2m_import_table_disp[2] = {
+	24, 0,
+};
+
+static const char *const c2m_import_table_keys[8] = {
+	"io",
+	"sdl",
+	"sdl_audio",
+	"stdlib",
+	"stdio",
+	"agg",
+	"clump",
+	"sdl_window",
+};
+
+static const struct cl_phash_table c2m_import_table = {
+	8, 2, 0x131fd4912deb3937ULL, 0, c2m_import_table_disp, c2m_import_table_keys
+};
+
+// c2m_libreq_t field of each slot
+static const uint8_t c2m_import_field[8] = {
+	offsetof(c2m_libreq_t, io),
+	offsetof(c2m_libreq_t, sdl),
+	offsetof(c2m_libreq_t, sdl_audio),
+	offsetof(c2m_libreq_t, stdlib),
+	offsetof(c2m_libreq_t, stdio),
+	offsetof(c2m_libreq_t, agg),
+	offsetof(c2m_libreq_t, clump),
+	offsetof(c2m_libreq_t, sdl_window),
+};
@@ -0,0 +1,59 @@
+// Inlining of small library functions ( a pass, needs the modules ): a call
+// to a function scoring at most C2M_INLINE_SCORE links to it ( as its
+// record, walks don't follow that ) & the emitter writes the function's
+// statements in place of the call.  Only leaf functions are inlined ( no
+// calls or loops ), so it doesn't depend on the C compiler or LTO & a split
+// build's units don't call each other for a wrapper.  The function is still
+// emitted, for exports & its prototype.
+
+#define C2M_INLINE_SCORE 8 // Nodes, a few statements
+
+/*
+ * Returns how many nodes are in the tree, more than `limit` if it's bigger or
+ * can't be inlined ( a call or loop ).
+*/
+static uint32_t c2m_inline_score(c2m_node_t* node, uint32_t limit) {
+	uint32_t score = 0;
+
+	for(; node && score <= limit; node = node->next) {
+		if(node->kind == NODE_CALL || node->kind == NODE_WHILE ||
+			node->kind == NODE_PARALLEL || node->kind == NODE_FOR)
+		{
+			return limit + 1;
+		}
+		score += 1 + c2m_inline_score(node->child, limit - score);
+		if(score <= limit) score += c2m_inline_score(node->body, limit - score);
+	}
+	return score;
+}
+
+// Set a call's function to inline, or NULL.  Every call is set again each
+// compile, a parse shared by a batch may point at another project's.
+static void c2m_inline_node(c2m_node_t* call, void* data) {
+	c2m_t* c2m = data;
+	c2m_symbol_t* symbol;
+	c2m_node_t* fn;
+
+	if(call->kind != NODE_CALL) return;
+	if((symbol = c2m_symtab_get(c2m->modules, call->module)) == NULL ||
+		(fn = c2m_module_find(symbol->data, call->text)) == NULL)
+	{
+		call->record = NULL;
+		return;
+	}
+	// A pure function's body is a value, C2M_INLINE for the C compiler to
+	// inline ( & a call's record is the record it returns ).
+	if(fn->body && fn->body->kind == NODE_RETURN) return;
+	call->record = NULL;
+	// Calling an async function starts a coroutine, see c2m_async.c.  A
+	// traced one is kept as a call, so it shows up in the trace.
+	if(fn->indirect == 0 && fn->traced == 0 &&
+		c2m_inline_score(fn->body, C2M_INLINE_SCORE) <= C2M_INLINE_SCORE)
+	{
+		call->record = fn;
+	}
+}
+
+static void c2m_inline(c2m_t* c2m) {
+	c2m_pass_walk(c2m, c2m_inline_node);
+}
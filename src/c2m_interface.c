@@ -0,0 +1,322 @@
+// Module interfaces ( .c2mi ): a library module's parsed functions, written
+// next to the source by --index & mapped instead of tokenizing & parsing it.
+// The file holds a string table ( each identifier once ), the syntax tree as
+// an array of nodes linked by index & the functions' root nodes.  Loading
+// interns the identifiers & rebuilds the node links, C statements & literals
+// point straight into the mapping.  It's checked against the version, a
+// checksum of its contents & the hash of the source it was made from.
+
+#define C2M_INTERFACE_VERSION 2
+
+typedef struct{
+	char magic[4]; // "C2MI"
+	uint32_t version;
+	uint64_t source; // Hash of the module source
+	uint64_t checksum; // Of everything after the header
+	uint32_t libreq; // See c2m_prelude_bits
+	uint32_t n_strings;
+	uint32_t n_nodes;
+	uint32_t n_functions;
+	uint32_t size; // Of the file
+	uint32_t reserved;
+}c2m_interface_header_t;
+
+#define C2M_INTERFACE_NAME 0x80000000 // Interned when loaded
+
+typedef struct{
+	uint32_t offset; // In the text after the tables
+	uint32_t length; // C2M_INTERFACE_NAME for identifiers
+}c2m_interface_string_t;
+
+typedef struct{
+	uint8_t kind;
+	uint8_t type;
+	uint8_t indirect;
+	uint8_t traced;
+	uint32_t line;
+	uint32_t text; // String + 1, 0 for none
+	uint32_t module; // String + 1, 0 for none
+	uint32_t child; // Node + 1, 0 for NULL
+	uint32_t body;
+	uint32_t next;
+}c2m_interface_node_t;
+
+typedef struct{
+	struct cl_array* strings; // c2m_interface_string_t
+	struct cl_array* nodes; // c2m_interface_node_t
+	struct cl_array* text;
+	c2m_symtab_t* names; // Interned identifier -> string + 1
+}c2m_interface_writer_t;
+
+// Literals & C statements point into the source, the rest is interned.
+static inline uint8_t c2m_interface_is_name(uint8_t kind) {
+	return kind != NODE_STRING && kind != NODE_INTEGER &&
+		kind != NODE_BOOL && kind != NODE_RAW;
+}
+
+// Returns the string + 1 for `length` bytes of `text`.
+static uint32_t c2m_interface_string(c2m_interface_writer_t* writer,
+	const char* text, uint32_t length, uint8_t is_name)
+{
+	c2m_interface_string_t* string;
+	c2m_symbol_t* symbol;
+
+	if(text == NULL) return 0;
+	if(is_name && (symbol = c2m_symtab_get(writer->names, text)))
+		return (uintptr_t)symbol->data;
+	string = cl_array_add(writer->strings);
+	string->offset = c2m_string_length(writer->text);
+	string->length = length | (is_name ? C2M_INTERFACE_NAME : 0);
+	c2m_string_append_n(writer->text, text, length);
+	if(is_name) {
+		c2m_symtab_add(writer->names, text, SYMBOL_VARIABLE, 0,
+			(void*)(uintptr_t)cl_array_count(writer->strings));
+	}
+	return cl_array_count(writer->strings);
+}
+
+// Add the list starting at `node`, returns the first node + 1.
+static uint32_t c2m_interface_nodes(c2m_interface_writer_t* writer,
+	c2m_node_t* node)
+{
+	uint32_t first = 0;
+	uint32_t last = 0;
+
+	for(; node; node = node->next) {
+		uint32_t i = cl_array_count(writer->nodes);
+		c2m_interface_node_t* out = cl_array_add(writer->nodes);
+		uint32_t child, body;
+
+		memset(out, 0, sizeof(c2m_interface_node_t));
+		out->kind = node->kind;
+		out->type = node->type;
+		out->indirect = node->indirect;
+		out->traced = node->traced;
+		out->line = node->line;
+		out->text = c2m_interface_string(writer, node->text,
+			node->length, c2m_interface_is_name(node->kind));
+		out->module = c2m_interface_string(writer, node->module,
+			node->module_length, 1);
+		// The array may move while the children are added.
+		child = c2m_interface_nodes(writer, node->child);
+		body = c2m_interface_nodes(writer, node->body);
+		out = cl_array_borrow(writer->nodes, i);
+		out->child = child;
+		out->body = body;
+		if(last) {
+			((c2m_interface_node_t*)cl_array_borrow(writer->nodes,
+				last - 1))->next = i + 1;
+		}else{
+			first = i + 1;
+		}
+		last = i + 1;
+	}
+	return first;
+}
+
+/*
+ * Write the interface of a module parsed from source with hash `source`,
+ * `functions` holds its NODE_FUNCTIONs.  Returns 1 if it couldn't be
+ * written.
+*/
+static uint8_t c2m_interface_write(c2m_t* c2m, const char* path,
+	struct cl_array* functions, uint64_t source, uint32_t libreq)
+{
+	c2m_interface_writer_t writer;
+	c2m_interface_header_t header;
+	struct cl_array* roots = cl_array_create(sizeof(uint32_t), 16);
+	uint32_t n_text;
+	uint64_t checksum = C2M_HASH_INIT;
+	SDL_RWops* output;
+	uint8_t failed;
+
+	writer.strings = cl_array_create(sizeof(c2m_interface_string_t), 64);
+	writer.nodes = cl_array_create(sizeof(c2m_interface_node_t), 256);
+	writer.text = c2m_string_create(NULL);
+	writer.names = c2m_symtab_create(c2m->intern);
+	for(uint32_t i = 0; i < cl_array_count(functions); i++) {
+		c2m_node_t* fn = *(c2m_node_t**)cl_array_borrow(functions, i);
+		c2m_node_t* next = fn->next;
+
+		// One function, not the list it's on.
+		fn->next = NULL;
+		*(uint32_t*)cl_array_add(roots) =
+			c2m_interface_nodes(&writer, fn) - 1;
+		fn->next = next;
+	}
+	n_text = c2m_string_length(writer.text);
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "C2MI", 4);
+	header.version = C2M_INTERFACE_VERSION;
+	header.source = source;
+	header.libreq = libreq;
+	header.n_strings = cl_array_count(writer.strings);
+	header.n_nodes = cl_array_count(writer.nodes);
+	header.n_functions = cl_array_count(roots);
+	header.size = sizeof(header) +
+		header.n_strings * sizeof(c2m_interface_string_t) +
+		header.n_nodes * sizeof(c2m_interface_node_t) +
+		header.n_functions * sizeof(uint32_t) + n_text;
+	checksum = c2m_hash(checksum, writer.strings->store,
+		header.n_strings * sizeof(c2m_interface_string_t));
+	checksum = c2m_hash(checksum, writer.nodes->store,
+		header.n_nodes * sizeof(c2m_interface_node_t));
+	checksum = c2m_hash(checksum, roots->store,
+		header.n_functions * sizeof(uint32_t));
+	header.checksum = c2m_hash(checksum, writer.text->store, n_text);
+	failed = (output = SDL_RWFromFile(path, "wb")) == NULL ||
+		SDL_RWwrite(output, &header, sizeof(header), 1) != 1 ||
+		SDL_RWwrite(output, writer.strings->store,
+			sizeof(c2m_interface_string_t), header.n_strings) !=
+			header.n_strings ||
+		SDL_RWwrite(output, writer.nodes->store,
+			sizeof(c2m_interface_node_t), header.n_nodes) !=
+			header.n_nodes ||
+		SDL_RWwrite(output, roots->store, sizeof(uint32_t),
+			header.n_functions) != header.n_functions ||
+		SDL_RWwrite(output, writer.text->store, 1, n_text) != n_text;
+	if(output) SDL_RWclose(output);
+	if(failed) remove(path);
+	c2m_symtab_destroy(writer.names);
+	c2m_string_destroy(writer.text);
+	cl_array_destroy(writer.nodes);
+	cl_array_destroy(writer.strings);
+	cl_array_destroy(roots);
+	return failed;
+}
+
+/*
+ * Returns 1 unless every string & link in the interface is in bounds.
+*/
+static uint8_t c2m_interface_check(const c2m_interface_header_t* header,
+	const c2m_interface_string_t* strings, const c2m_interface_node_t* nodes,
+	const uint32_t* roots, uint32_t n_text)
+{
+	for(uint32_t i = 0; i < header->n_strings; i++) {
+		uint32_t length = strings[i].length & ~C2M_INTERFACE_NAME;
+
+		if(strings[i].offset > n_text ||
+			length > n_text - strings[i].offset)
+		{
+			return 1;
+		}
+	}
+	for(uint32_t i = 0; i < header->n_nodes; i++) {
+		const c2m_interface_node_t* node = &nodes[i];
+
+		// No records, those belong to the program.
+		if(node->kind > NODE_AWAIT || node->kind == NODE_RECORD ||
+			node->kind == NODE_CONSTRUCT ||
+			node->type == TYPE_RECORD ||
+			node->text > header->n_strings ||
+			node->module > header->n_strings ||
+			node->child > header->n_nodes ||
+			node->body > header->n_nodes || node->next > header->n_nodes)
+		{
+			return 1;
+		}
+	}
+	for(uint32_t i = 0; i < header->n_functions; i++) {
+		if(roots[i] >= header->n_nodes ||
+			nodes[roots[i]].kind != NODE_FUNCTION ||
+			nodes[roots[i]].text == 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Load the interface at `path` if it was made from source `hash`: functions
+ * are added to `functions` with their nodes from `arena`, the file stays
+ * mapped in `map`.  Returns 1 if it's missing or doesn't check out.
+*/
+static uint8_t c2m_interface_load(c2m_t* c2m, const char* path, uint64_t hash,
+	c2m_source_t* map, c2m_arena_t* arena, c2m_symtab_t* functions,
+	c2m_libreq_t* libreq)
+{
+	const c2m_interface_header_t* header;
+	const c2m_interface_string_t* strings;
+	const c2m_interface_node_t* nodes;
+	const uint32_t* roots;
+	const char** text;
+	c2m_node_t** created;
+	const char* data;
+	uint32_t tables;
+
+	if(c2m_source_open(map, path)) return 1;
+	header = (const void*)map->data;
+	if(map->size < sizeof(c2m_interface_header_t) ||
+		memcmp(header->magic, "C2MI", 4) ||
+		header->version != C2M_INTERFACE_VERSION ||
+		header->source != hash || header->size != map->size ||
+		header->n_strings > map->size / sizeof(c2m_interface_string_t) ||
+		header->n_nodes > map->size / sizeof(c2m_interface_node_t) ||
+		header->n_functions > map->size / sizeof(uint32_t) ||
+		(tables = sizeof(c2m_interface_header_t) +
+			header->n_strings * sizeof(c2m_interface_string_t) +
+			header->n_nodes * sizeof(c2m_interface_node_t) +
+			header->n_functions * sizeof(uint32_t)) > map->size ||
+		c2m_hash(C2M_HASH_INIT, map->data + sizeof(*header),
+			map->size - sizeof(*header)) != header->checksum)
+	{
+		c2m_source_close(map);
+		return 1;
+	}
+	strings = (const void*)(header + 1);
+	nodes = (const void*)(strings + header->n_strings);
+	roots = (const void*)(nodes + header->n_nodes);
+	data = map->data + tables;
+	if(c2m_interface_check(header, strings, nodes, roots,
+		map->size - tables))
+	{
+		c2m_source_close(map);
+		return 1;
+	}
+	text = malloc(sizeof(char*) * (header->n_strings + 1));
+	created = malloc(sizeof(c2m_node_t*) * (header->n_nodes + 1));
+	text[0] = NULL;
+	for(uint32_t i = 0; i < header->n_strings; i++) {
+		const c2m_interface_string_t* string = &strings[i];
+		uint32_t length = string->length & ~C2M_INTERFACE_NAME;
+
+		text[i + 1] = string->length & C2M_INTERFACE_NAME ?
+			c2m_intern(c2m->intern, data + string->offset, length) :
+			data + string->offset;
+	}
+	created[0] = NULL;
+	for(uint32_t i = 0; i < header->n_nodes; i++) {
+		created[i + 1] = c2m_node_create(arena, nodes[i].kind,
+			nodes[i].line);
+	}
+	for(uint32_t i = 0; i < header->n_nodes; i++) {
+		const c2m_interface_node_t* in = &nodes[i];
+		c2m_node_t* node = created[i + 1];
+
+		node->type = in->type;
+		node->indirect = in->indirect;
+		node->traced = in->traced;
+		if(in->text) {
+			c2m_node_text(node, text[in->text],
+				strings[in->text - 1].length & ~C2M_INTERFACE_NAME);
+		}
+		if(in->module) {
+			node->module = text[in->module];
+			node->module_length =
+				strings[in->module - 1].length & ~C2M_INTERFACE_NAME;
+		}
+		node->child = created[in->child];
+		node->body = created[in->body];
+		node->next = created[in->next];
+	}
+	for(uint32_t i = 0; i < header->n_functions; i++) {
+		c2m_node_t* fn = created[roots[i] + 1];
+
+		c2m_symtab_add(functions, fn->text, SYMBOL_FUNCTION, 0, fn);
+	}
+	c2m_libreq_unpack(libreq, header->libreq);
+	free(created);
+	free(text);
+	return 0;
+}
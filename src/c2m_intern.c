@@ -0,0 +1,137 @@
+// String interning: every distinct identifier is stored once in an arena, so
+// interned strings can be compared by pointer.  Lookups of interned strings
+// don't lock ( a c2m_cmap_t ), only adding one takes the lock.
+
+#define C2M_INTERN_BLOCK 16384
+
+typedef struct{
+	c2m_cmap_t* map; // string -> itself
+	struct cl_array* blocks; // char*, arena blocks
+	char* block; // Current block
+	uint32_t used; // Bytes used in the current block
+	struct cl_array* key; // Scratch space to NUL terminate lookups
+	SDL_SpinMutex lock; // Only taken while worker threads are running
+	uint8_t shared; // They are
+	// Counters ( --stats ), lookups only while counting ( shared by threads )
+	uint8_t counting;
+	SDL_atomic_t n_lookups;
+	uint32_t n_strings;
+	uint32_t n_bytes;
+	uint32_t n_allocs;
+}c2m_intern_t;
+
+static c2m_intern_t* c2m_intern_create(void) {
+	c2m_intern_t* intern = malloc(sizeof(c2m_intern_t));
+
+	intern->map = c2m_cmap_create();
+	intern->blocks = cl_array_create(sizeof(char*), 8);
+	intern->block = NULL;
+	intern->used = C2M_INTERN_BLOCK;
+	intern->key = c2m_string_create(NULL);
+	SDL_AtomicSet(&intern->lock.state, 0);
+	intern->shared = 0;
+	intern->counting = 0;
+	SDL_AtomicSet(&intern->n_lookups, 0);
+	intern->n_strings = 0;
+	intern->n_bytes = 0;
+	intern->n_allocs = 0;
+	return intern;
+}
+
+// Free the table & every string in it, after the compiles sharing it.
+static void c2m_intern_destroy(c2m_intern_t* intern) {
+	for(uint32_t i = 0; i < cl_array_count(intern->blocks); i++)
+		free(*(char**)cl_array_borrow(intern->blocks, i));
+	cl_array_destroy(intern->blocks);
+	c2m_cmap_destroy(intern->map);
+	c2m_string_destroy(intern->key);
+	free(intern);
+}
+
+// Copy `n` bytes + a NUL into the arena.
+static const char* c2m_intern_copy(c2m_intern_t* intern, const char* text,
+	uint32_t n)
+{
+	char* copy;
+
+	if(intern->used + n + 1 > C2M_INTERN_BLOCK) {
+		uint32_t size = n + 1 > C2M_INTERN_BLOCK ? n + 1 :
+			C2M_INTERN_BLOCK;
+
+		intern->block = malloc(size);
+		intern->used = 0;
+		intern->n_allocs++;
+		*(char**)cl_array_add(intern->blocks) = intern->block;
+	}
+	copy = intern->block + intern->used;
+	memcpy(copy, text, n);
+	copy[n] = '\0';
+	intern->used += n + 1;
+	intern->n_strings++;
+	intern->n_bytes += n + 1;
+	return copy;
+}
+
+static inline void c2m_intern_lock(c2m_intern_t* intern) {
+	if(intern->shared) SDL_SpinMutexLock(&intern->lock);
+	intern->key->n_items = 1;
+	((char*)intern->key->store)[0] = '\0';
+}
+
+// Intern the NUL terminated string in the scratch key & unlock.
+static const char* c2m_intern_key(c2m_intern_t* intern) {
+	uint32_t length = c2m_string_length(intern->key);
+	uint32_t hash = c2m_cmap_hash(intern->key->store, length);
+	const char* found = c2m_cmap_get(intern->map, intern->key->store,
+		length, hash);
+
+	if(intern->counting) SDL_AtomicIncRef(&intern->n_lookups);
+	if(found == NULL) {
+		found = c2m_intern_copy(intern, intern->key->store, length);
+		c2m_cmap_put(intern->map, found, length, hash, (void*)found);
+	}
+	if(intern->shared) SDL_SpinMutexUnlock(&intern->lock);
+	return found;
+}
+
+/*
+ * Returns the interned copy of `length` bytes of `text` (needn't be NUL
+ * terminated).
+*/
+static const char* c2m_intern(c2m_intern_t* intern, const char* text,
+	uint32_t length)
+{
+	const char* found = c2m_cmap_get(intern->map, text, length,
+		c2m_cmap_hash(text, length));
+
+	if(found) {
+		if(intern->counting) SDL_AtomicIncRef(&intern->n_lookups);
+		return found;
+	}
+	c2m_intern_lock(intern);
+	c2m_string_append_n(intern->key, text, length);
+	return c2m_intern_key(intern);
+}
+
+static inline const char* c2m_intern_str(c2m_intern_t* intern,
+	const char* text)
+{
+	return c2m_intern(intern, text, strlen(text));
+}
+
+// Intern "a.b".
+static const char* c2m_intern_qualified(c2m_intern_t* intern, const char* a,
+	uint32_t a_length, const char* b, uint32_t b_length)
+{
+	c2m_intern_lock(intern);
+	c2m_string_append_n(intern->key, a, a_length);
+	c2m_string_append_n(intern->key, ".", 1);
+	c2m_string_append_n(intern->key, b, b_length);
+	return c2m_intern_key(intern);
+}
+
+static void c2m_intern_stats(c2m_intern_t* intern) {
+	printf("Interned %u strings (%u bytes) in %u blocks, %u lookups\n",
+		intern->n_strings, intern->n_bytes, intern->n_allocs,
+		(uint32_t)SDL_AtomicGet(&intern->n_lookups));
+}
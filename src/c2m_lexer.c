@@ -0,0 +1,327 @@
+// Tokenizer: turns a source buffer into a compact token stream in one pass.
+// The parser then works on tokens instead of re-probing the raw bytes.  Runs
+// of blanks & identifier characters are scanned 16 bytes at a time with SSE2
+// ( if the CPU has it ) or NEON, the rest byte by byte.
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#define C2M_LEX_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define C2M_LEX_NEON 1
+#endif
+
+// Set by c2m_lex_init() before any lexing, 1 to use SSE2.
+static uint8_t c2m_lex_sse2 = 0;
+
+enum {
+	TOKEN_EOF,
+	TOKEN_NEWLINE,
+	TOKEN_IDENT,
+	TOKEN_NUMBER,
+	TOKEN_STRING, // offset & length include the quotes
+	TOKEN_CHAR,
+	TOKEN_PUNCT, // Any other single character.
+};
+
+typedef struct{
+	uint8_t kind;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t line;
+}c2m_token_t;
+
+typedef struct{
+	const char* source;
+	uint32_t size;
+	struct cl_array* tokens;
+	uint32_t pos;
+}c2m_lexer_t;
+
+static inline uint8_t c2m_lex_isident(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+		(c >= '0' && c <= '9') || c == '_';
+}
+
+static inline void c2m_lex_push(c2m_lexer_t* lex, uint8_t kind,
+	uint32_t offset, uint32_t length, uint32_t line)
+{
+	c2m_token_t* token = cl_array_add(lex->tokens);
+
+	token->kind = kind;
+	token->offset = offset;
+	token->length = length;
+	token->line = line;
+}
+
+static void c2m_lex_init(void) {
+#ifdef C2M_LEX_SSE2
+	c2m_lex_sse2 = (SDL_GetCPUFeatureMask() & SDL_CPUFEATURE_SSE2) != 0;
+#endif
+}
+
+static inline uint8_t c2m_lex_isblank(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+#ifdef C2M_LEX_SSE2
+// Bytes of `v` in [lo, hi] ( ASCII, bytes over 0x7f never are ).
+__attribute__((target("sse2")))
+static inline __m128i c2m_lex_range_sse2(__m128i v, char lo, char hi) {
+	return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+		_mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), v));
+}
+
+/*
+ * Skip whole blocks of 16 bytes matching `ident` ( 1 ) or blanks ( 0 ),
+ * returns the first byte that doesn't match or where less than a block is
+ * left.
+*/
+__attribute__((target("sse2")))
+static uint32_t c2m_lex_scan_sse2(const char* source, uint32_t i,
+	uint32_t size, uint8_t ident)
+{
+	while(i + 16 <= size) {
+		__m128i v = _mm_loadu_si128((const __m128i*)&source[i]);
+		__m128i match;
+		uint32_t mask;
+
+		if(ident) {
+			match = _mm_or_si128(_mm_or_si128(
+				c2m_lex_range_sse2(v, '0', '9'),
+				c2m_lex_range_sse2(_mm_or_si128(v,
+				_mm_set1_epi8(0x20)), 'a', 'z')),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+		}else{
+			match = _mm_or_si128(_mm_or_si128(
+				_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+		}
+		mask = ~_mm_movemask_epi8(match) & 0xffff;
+		if(mask) return i + __builtin_ctz(mask);
+		i += 16;
+	}
+	return i;
+}
+#endif
+
+#ifdef C2M_LEX_NEON
+// Same as c2m_lex_scan_sse2, NEON is always there.
+static uint32_t c2m_lex_scan_neon(const char* source, uint32_t i,
+	uint32_t size, uint8_t ident)
+{
+	while(i + 16 <= size) {
+		uint8x16_t v = vld1q_u8((const uint8_t*)&source[i]);
+		uint8x16_t match;
+		uint64_t mask;
+
+		if(ident) {
+			uint8x16_t lower = vorrq_u8(v, vdupq_n_u8(0x20));
+
+			match = vorrq_u8(vorrq_u8(
+				vcleq_u8(vsubq_u8(v, vdupq_n_u8('0')),
+				vdupq_n_u8(9)),
+				vcleq_u8(vsubq_u8(lower, vdupq_n_u8('a')),
+				vdupq_n_u8('z' - 'a'))),
+				vceqq_u8(v, vdupq_n_u8('_')));
+		}else{
+			match = vorrq_u8(vorrq_u8(
+				vceqq_u8(v, vdupq_n_u8(' ')),
+				vceqq_u8(v, vdupq_n_u8('\t'))),
+				vceqq_u8(v, vdupq_n_u8('\r')));
+		}
+		// 4 bits per byte, set where a byte doesn't match.
+		mask = ~vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(
+			vreinterpretq_u16_u8(match), 4)), 0);
+		if(mask) return i + __builtin_ctzll(mask) / 4;
+		i += 16;
+	}
+	return i;
+}
+#endif
+
+#define C2M_LEX_SHORT 8 // Most runs are shorter, those stay byte by byte
+
+static inline uint8_t c2m_lex_class(char c, uint8_t ident) {
+	return ident ? c2m_lex_isident(c) : c2m_lex_isblank(c);
+}
+
+// Offset of the first byte from `i` that isn't an identifier character
+// ( `ident` = 1 ) or a blank ( 0 ).
+static inline uint32_t c2m_lex_scan(const char* source, uint32_t i,
+	uint32_t size, uint8_t ident)
+{
+	uint32_t end = size - i > C2M_LEX_SHORT ? i + C2M_LEX_SHORT : size;
+
+	while(i < end && c2m_lex_class(source[i], ident)) i++;
+	if(i < end || i == size) return i;
+#if defined(C2M_LEX_SSE2)
+	if(c2m_lex_sse2) i = c2m_lex_scan_sse2(source, i, size, ident);
+#elif defined(C2M_LEX_NEON)
+	i = c2m_lex_scan_neon(source, i, size, ident);
+#endif
+	while(i < size && c2m_lex_class(source[i], ident)) i++;
+	return i;
+}
+
+// Offset of the end of the line containing `i` (or the end of the buffer).
+static inline uint32_t c2m_lex_line_end(c2m_lexer_t* lex, uint32_t i) {
+	const char* nl = memchr(&lex->source[i], '\n', lex->size - i);
+
+	return nl ? nl - lex->source : lex->size;
+}
+
+// Skip over a quoted literal, returns the offset after the closing quote.
+// Only the current line is searched.
+static uint32_t c2m_lex_quoted(c2m_lexer_t* lex, uint32_t i, char quote) {
+	uint32_t end = c2m_lex_line_end(lex, i);
+
+	i++;
+	while(1) {
+		const char* q = memchr(&lex->source[i], quote, end - i);
+		uint32_t escapes = 0;
+
+		if(q == NULL) c2m_abort("closing quote is missing");
+		i = q - lex->source;
+		while(lex->source[i - 1 - escapes] == '\\') escapes++;
+		if(escapes % 2 == 0) return i + 1;
+		i++;
+	}
+}
+
+// Lex part of a file, `line` is the line `source` starts on.  It must be
+// UTF-8, that's what its string literals are at runtime.
+static void c2m_lex_from(c2m_lexer_t* lex, const char* source, uint32_t size,
+	uint32_t line)
+{
+	uint32_t i = 0;
+
+	if(SDL_utf8_validate(source, size) == SDL_FALSE)
+		c2m_abort("source isn't UTF-8");
+	lex->source = source;
+	lex->size = size;
+	lex->tokens = cl_array_create(sizeof(c2m_token_t), size / 4);
+	lex->pos = 0;
+	while(i < size) {
+		char c = source[i];
+		uint32_t start = i;
+
+		if(c2m_lex_isblank(c)) {
+			i = c2m_lex_scan(source, i + 1, size, 0);
+		}else if(c == '\n') {
+			c2m_lex_push(lex, TOKEN_NEWLINE, i, 1, line);
+			line++;
+			i++;
+		}else if(c == '/' && i + 1 < size && source[i + 1] == '/') {
+			// Comments run to the end of the line, newline is kept.
+			i = c2m_lex_line_end(lex, i);
+		}else if(c == '"' || c == '\'') {
+			i = c2m_lex_quoted(lex, i, c);
+			c2m_lex_push(lex, c == '"' ? TOKEN_STRING : TOKEN_CHAR,
+				start, i - start, line);
+		}else if(c >= '0' && c <= '9') {
+			i = c2m_lex_scan(source, i + 1, size, 1);
+			// A decimal point with digits after it, "2.5" is one number.
+			if(i + 1 < size && source[i] == '.' &&
+				source[i + 1] >= '0' && source[i + 1] <= '9')
+			{
+				i = c2m_lex_scan(source, i + 2, size, 1);
+			}
+			c2m_lex_push(lex, TOKEN_NUMBER, start, i - start, line);
+		}else if(c2m_lex_isident(c)) {
+			i = c2m_lex_scan(source, i + 1, size, 1);
+			c2m_lex_push(lex, TOKEN_IDENT, start, i - start, line);
+		}else{
+			// A UTF-8 symbol ( "∪" ) is one token, continuation bytes
+			// included.
+			i++;
+			if(c & 0x80)
+				while(i < size && (source[i] & 0xC0) == 0x80) i++;
+			c2m_lex_push(lex, TOKEN_PUNCT, start, i - start, line);
+		}
+	}
+	c2m_lex_push(lex, TOKEN_EOF, size, 0, line);
+}
+
+void c2m_lex(c2m_lexer_t* lex, const char* source, uint32_t size) {
+	c2m_lex_from(lex, source, size, 1);
+}
+
+static inline void c2m_lex_destroy(c2m_lexer_t* lex) {
+	cl_array_destroy(lex->tokens);
+}
+
+static inline c2m_token_t* c2m_lex_peek(c2m_lexer_t* lex, uint32_t ahead) {
+	uint32_t last = cl_array_count(lex->tokens) - 1;
+	uint32_t i = lex->pos + ahead;
+
+	return cl_array_borrow(lex->tokens, i < last ? i : last);
+}
+
+static inline c2m_token_t* c2m_lex_next(c2m_lexer_t* lex) {
+	c2m_token_t* token = c2m_lex_peek(lex, 0);
+
+	if(token->kind != TOKEN_EOF) lex->pos++;
+	return token;
+}
+
+// Returns 1 if the token doesn't have text `what`.
+static inline uint8_t c2m_lex_match(c2m_lexer_t* lex, c2m_token_t* token,
+	const char* what)
+{
+	uint32_t len = strlen(what);
+
+	return token->length != len ||
+		memcmp(&lex->source[token->offset], what, len);
+}
+
+// Like c2m_expect: returns 1 if not what expected, otherwise consumes it.
+static inline uint8_t c2m_lex_expect(c2m_lexer_t* lex, const char* what) {
+	if(c2m_lex_match(lex, c2m_lex_peek(lex, 0), what)) return 1;
+	lex->pos++;
+	return 0;
+}
+
+// Returns 1 if the next token isn't a newline, otherwise consumes it.
+static inline uint8_t c2m_lex_newline(c2m_lexer_t* lex) {
+	if(c2m_lex_peek(lex, 0)->kind != TOKEN_NEWLINE) return 1;
+	lex->pos++;
+	return 0;
+}
+
+// Append the text of a token.
+static inline void c2m_lex_append(c2m_lexer_t* lex, struct cl_array* a,
+	c2m_token_t* token)
+{
+	c2m_string_append_n(a, &lex->source[token->offset], token->length);
+}
+
+// Append source text from the start of token `from` to the start of `to`.
+static inline void c2m_lex_append_range(c2m_lexer_t* lex, struct cl_array* a,
+	c2m_token_t* from, c2m_token_t* to)
+{
+	c2m_string_append_n(a, &lex->source[from->offset],
+		to->offset - from->offset);
+}
+
+// Find the next token of text `what` before the end of the line.
+static c2m_token_t* c2m_lex_find(c2m_lexer_t* lex, const char* what) {
+	for(uint32_t i = 0;; i++) {
+		c2m_token_t* token = c2m_lex_peek(lex, i);
+
+		if(token->kind == TOKEN_NEWLINE || token->kind == TOKEN_EOF)
+			return NULL;
+		if(c2m_lex_match(lex, token, what) == 0)
+			return token;
+	}
+}
+
+// Skip tokens until the end of the line (newline is consumed).
+static void c2m_lex_skip_line(c2m_lexer_t* lex) {
+	c2m_token_t* token;
+
+	do {
+		token = c2m_lex_next(lex);
+	} while(token->kind != TOKEN_NEWLINE && token->kind != TOKEN_EOF);
+}
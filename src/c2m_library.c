@@ -0,0 +1,382 @@
+// Library search path: modules are looked up in the project's lib/, then the
+// -L directories, then the config's `path` ( directories separated by ':' ).
+// A directory may have a c2m.index ( written by --index ), a hash table of
+// its modules & their functions with signatures & byte ranges in the source.
+// It's mapped & looked up in place, so finding a module doesn't probe every
+// directory.  An indexed module is loaded from its interface ( .c2mi, see
+// c2m_interface.c ) if it has one, otherwise only the imported functions are
+// parsed.
+
+#ifdef C2M_SOURCE_MMAP
+#include <dirent.h>
+#define C2M_LIBRARY_DIRENT 1
+#endif
+
+#define C2M_INDEX_FILE "c2m.index"
+#define C2M_INDEX_VERSION 2
+
+typedef struct{
+	char magic[4]; // "C2MX"
+	uint32_t version;
+	uint32_t n_buckets; // Power of 2
+	uint32_t n_entries;
+	uint32_t strings; // Offset of the keys & signatures
+	uint32_t reserved;
+}c2m_index_header_t;
+
+// A module ( key "module" ) or a function ( key "module.function" ).
+typedef struct{
+	uint64_t hash; // Of the key, 0 for an empty bucket
+	uint64_t source; // Module: hash of the source
+	uint32_t key; // Offset in the strings
+	uint32_t key_length;
+	uint32_t start; // Function: its bytes in the source, module: libreq bits
+	uint32_t end; // Module: size of the source
+	uint32_t line; // Function: line it starts on
+	uint32_t signature; // Function: offset of a type byte per parameter
+	uint32_t n_params;
+	uint32_t flags; // Module: C2M_INDEX_INTERFACE
+}c2m_index_entry_t;
+
+#define C2M_INDEX_INTERFACE 1 // There's a <module>.c2mi
+
+typedef struct{
+	char* path;
+	c2m_source_t index; // data is NULL without a c2m.index
+}c2m_libdir_t;
+
+static inline uint64_t c2m_index_hash(const char* key, uint32_t length) {
+	uint64_t hash = c2m_hash(C2M_HASH_INIT, key, length);
+
+	return hash ? hash : 1;
+}
+
+static inline const c2m_index_header_t* c2m_index_header(
+	const c2m_source_t* index)
+{
+	return (const c2m_index_header_t*)index->data;
+}
+
+/*
+ * Returns 1 if `index` isn't a c2m.index this compiler can read.
+*/
+static uint8_t c2m_index_check(const c2m_source_t* index) {
+	const c2m_index_header_t* header = c2m_index_header(index);
+
+	return index->size < sizeof(c2m_index_header_t) ||
+		memcmp(header->magic, "C2MX", 4) ||
+		header->version != C2M_INDEX_VERSION ||
+		header->n_buckets == 0 ||
+		(header->n_buckets & (header->n_buckets - 1)) ||
+		header->n_buckets > index->size / sizeof(c2m_index_entry_t) ||
+		header->strings < sizeof(c2m_index_header_t) +
+			header->n_buckets * sizeof(c2m_index_entry_t) ||
+		header->strings > index->size;
+}
+
+// Look up `key` in an index, NULL if it's not there.
+static const c2m_index_entry_t* c2m_index_get(const c2m_source_t* index,
+	const char* key, uint32_t length)
+{
+	const c2m_index_header_t* header = c2m_index_header(index);
+	const c2m_index_entry_t* table = (const void*)(header + 1);
+	const char* strings = index->data + header->strings;
+	uint32_t n_strings = index->size - header->strings;
+	uint64_t hash = c2m_index_hash(key, length);
+	uint32_t mask = header->n_buckets - 1;
+
+	for(uint32_t i = hash & mask, n = 0; n <= mask; i = (i + 1) & mask, n++)
+	{
+		const c2m_index_entry_t* entry = &table[i];
+
+		if(entry->hash == 0) return NULL;
+		if(entry->hash == hash && entry->key_length == length &&
+			entry->key <= n_strings && length <= n_strings - entry->key &&
+			memcmp(strings + entry->key, key, length) == 0)
+		{
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static void c2m_library_add(c2m_t* c2m, const char* path, uint32_t length) {
+	c2m_libdir_t* dir = cl_array_add(c2m->lib_dirs);
+	struct cl_array* index = c2m_string_create(NULL);
+
+	if(length == 0) {
+		cl_array_pop(c2m->lib_dirs);
+		return;
+	}
+	dir->path = malloc(length + 1);
+	memcpy(dir->path, path, length);
+	dir->path[length] = '\0';
+	c2m_string_appendf(index, "%s/" C2M_INDEX_FILE, dir->path);
+	if(c2m_source_open(&dir->index, index->store)) {
+		dir->index.data = NULL;
+	}else if(c2m_index_check(&dir->index)) {
+		printf("Ignoring %s, it's from another version\n",
+			(char*)index->store);
+		c2m_source_close(&dir->index);
+		dir->index.data = NULL;
+	}
+	c2m_string_destroy(index);
+	c2m->library_hash = c2m_hash(c2m->library_hash, path, length);
+	c2m->library_hash = c2m_hash(c2m->library_hash, "\n", 1);
+}
+
+// Set up the search path, once the config is read.
+static void c2m_library_init(c2m_t* c2m) {
+	const char* path = c2m->path;
+
+	c2m_library_add(c2m, "lib", 3);
+	for(uint32_t i = 0; i < cl_array_count(c2m->lib_path); i++) {
+		const char* dir = *(char**)cl_array_borrow(c2m->lib_path, i);
+
+		c2m_library_add(c2m, dir, strlen(dir));
+	}
+	while(path && *path) {
+		const char* end = strchr(path, ':');
+		uint32_t length = end ? (uint32_t)(end - path) : strlen(path);
+
+		c2m_library_add(c2m, path, length);
+		path += length + (end != NULL);
+	}
+}
+
+static void c2m_library_destroy(c2m_t* c2m) {
+	for(uint32_t i = 0; i < cl_array_count(c2m->lib_dirs); i++) {
+		c2m_libdir_t* dir = cl_array_borrow(c2m->lib_dirs, i);
+
+		if(dir->index.data) c2m_source_close(&dir->index);
+		free(dir->path);
+	}
+	cl_array_destroy(c2m->lib_dirs);
+}
+
+/*
+ * Find module `name` on the search path & append its source file to `path`.
+ * Returns its index entry ( & sets `index` ), or NULL if it isn't indexed.
+*/
+static const c2m_index_entry_t* c2m_library_find(c2m_t* c2m,
+	const char* name, struct cl_array* path, const c2m_source_t** index)
+{
+	uint32_t length = strlen(name);
+	struct stat info;
+
+	for(uint32_t i = 0; i < cl_array_count(c2m->lib_dirs); i++) {
+		c2m_libdir_t* dir = cl_array_borrow(c2m->lib_dirs, i);
+		const c2m_index_entry_t* entry;
+
+		if(dir->index.data &&
+			(entry = c2m_index_get(&dir->index, name, length)))
+		{
+			c2m_string_appendf(path, "%s/%s.c2m", dir->path, name);
+			*index = &dir->index;
+			return entry;
+		}
+		c2m_string_appendf(path, "%s/%s.c2m", dir->path, name);
+		if(stat(path->store, &info) == 0) return NULL;
+		c2m_string_clear(path);
+	}
+	// Not found, opening it reports the error.
+	c2m_string_appendf(path, "lib/%s.c2m", name);
+	return NULL;
+}
+
+// Index a module's functions ( see c2m_library_index_module ).
+static void c2m_library_index_functions(c2m_t* worker, c2m_lexer_t* lex,
+	const char* name, struct cl_array* entries, struct cl_array* strings,
+	struct cl_array* fns)
+{
+	c2m_symtab_t* functions = c2m_symtab_create(worker->intern);
+
+	while(c2m_lex_peek(lex, 0)->kind != TOKEN_EOF) {
+		if(c2m_lex_expect(lex, "import") == 0) {
+			c2m_parse_import(worker, lex);
+			continue;
+		}
+		if(c2m_lex_newline(lex) == 0) continue;
+
+		c2m_token_t* start = c2m_lex_peek(lex, 0);
+		c2m_node_t* fn = c2m_parse_function(worker, lex, name);
+		c2m_token_t* end = cl_array_borrow(lex->tokens, lex->pos - 1);
+		c2m_index_entry_t* entry;
+
+		if(c2m_symtab_get(functions, fn->text)) {
+			c2m_diag_node(worker, fn, "function defined twice");
+			continue;
+		}
+		c2m_symtab_add(functions, fn->text, SYMBOL_FUNCTION, 0, fn);
+		*(c2m_node_t**)cl_array_add(fns) = fn;
+		entry = cl_array_add(entries);
+		memset(entry, 0, sizeof(c2m_index_entry_t));
+		entry->key = c2m_string_length(strings);
+		c2m_string_appendf(strings, "%s.%s", name, fn->text);
+		entry->key_length = c2m_string_length(strings) - entry->key;
+		entry->start = start->offset;
+		entry->end = end->offset + end->length;
+		entry->line = start->line;
+		entry->signature = c2m_string_length(strings);
+		for(c2m_node_t* param = fn->child; param; param = param->next) {
+			c2m_string_append_n(strings, (char*)&param->type, 1);
+			entry->n_params++;
+		}
+	}
+	c2m_symtab_destroy(functions);
+}
+
+/*
+ * Index module `name` ( source in `source`, read from `path` ) into `entries`,
+ * keys & signatures go to `strings`, & write its interface.  Returns 1 if it
+ * doesn't parse on its own ( a module using the program's records ), nothing
+ * is added then.
+*/
+static uint8_t c2m_library_index_module(c2m_t* c2m, const char* name,
+	const char* path, c2m_source_t* source, struct cl_array* entries,
+	struct cl_array* strings)
+{
+	struct cl_array* fns = cl_array_create(sizeof(c2m_node_t*), 16);
+	struct cl_array* interface = c2m_string_create(path);
+	c2m_t worker = *c2m;
+	jmp_buf* outer = c2m_abort_jump;
+	uint32_t n_entries = cl_array_count(entries);
+	uint32_t length = strlen(name);
+	uint8_t failed = 0;
+	c2m_index_entry_t* entry;
+	c2m_lexer_t lex;
+	jmp_buf jump;
+
+	worker.arena = c2m_arena_create();
+	worker.diags = c2m_diags_create();
+	worker.file = path;
+	memset(&worker.libreq, 0, sizeof(c2m_libreq_t));
+	lex.tokens = NULL;
+	// Any error, even one the parser recovers from, leaves it out.
+	c2m_abort_jump = &jump;
+	worker.recover = &jump;
+	if(setjmp(jump) == 0) {
+		c2m_lex(&lex, source->data, source->size);
+		c2m_library_index_functions(&worker, &lex, name, entries,
+			strings, fns);
+		failed = c2m_diag_count(&worker) != 0;
+	}else{
+		failed = 1;
+	}
+	c2m_abort_jump = outer;
+	c2m_diags_destroy(worker.diags);
+	if(lex.tokens) c2m_lex_destroy(&lex);
+	if(failed == 0) {
+		entry = cl_array_add(entries);
+		memset(entry, 0, sizeof(c2m_index_entry_t));
+		entry->key = c2m_string_length(strings);
+		c2m_string_append_n(strings, name, length);
+		entry->key_length = length;
+		entry->source = c2m_hash(C2M_HASH_INIT, source->data,
+			source->size);
+		entry->start = c2m_prelude_bits(&worker);
+		entry->end = source->size;
+		c2m_string_append(interface, "i");
+		if(c2m_interface_write(c2m, interface->store, fns, entry->source,
+			entry->start) == 0)
+		{
+			entry->flags = C2M_INDEX_INTERFACE;
+		}
+	}else{
+		while(cl_array_count(entries) > n_entries) cl_array_pop(entries);
+	}
+	c2m_arena_destroy(worker.arena);
+	c2m_string_destroy(interface);
+	cl_array_destroy(fns);
+	return failed;
+}
+
+static int c2m_library_compare(const void* a, const void* b) {
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Write `dir`/c2m.index for every module in the directory ( --index ).
+static void c2m_library_index(c2m_t* c2m, const char* dir) {
+#ifdef C2M_LIBRARY_DIRENT
+	struct cl_array* names = cl_array_create(sizeof(char*), 16);
+	struct cl_array* entries =
+		cl_array_create(sizeof(c2m_index_entry_t), 64);
+	struct cl_array* strings = c2m_string_create(NULL);
+	struct cl_array* path = c2m_string_create(NULL);
+	c2m_index_header_t header = { { 'C', '2', 'M', 'X' },
+		C2M_INDEX_VERSION, 8, 0, 0, 0 };
+	c2m_index_entry_t* table;
+	uint32_t n_modules = 0;
+	struct dirent* file;
+	SDL_RWops* output;
+	DIR* listing;
+
+	if((listing = opendir(dir)) == NULL) return;
+	while((file = readdir(listing))) {
+		uint32_t length = strlen(file->d_name);
+
+		if(length > 4 && strcmp(file->d_name + length - 4, ".c2m") == 0)
+		{
+			*(const char**)cl_array_add(names) = c2m_intern(c2m->intern,
+				file->d_name, length - 4);
+		}
+	}
+	closedir(listing);
+	// Same modules, same index.
+	qsort(names->store, cl_array_count(names), sizeof(char*),
+		c2m_library_compare);
+	for(uint32_t i = 0; i < cl_array_count(names); i++) {
+		const char* name = *(char**)cl_array_borrow(names, i);
+		c2m_source_t source;
+
+		c2m_string_clear(path);
+		c2m_string_appendf(path, "%s/%s.c2m", dir, name);
+		if(c2m_source_open(&source, path->store)) continue;
+		if(c2m_library_index_module(c2m, name, path->store, &source,
+			entries, strings))
+			printf("Not indexing %s\n", (char*)path->store);
+		else
+			n_modules++;
+		c2m_source_close(&source);
+	}
+	// At most half full, so probes stay short.
+	header.n_entries = cl_array_count(entries);
+	while(header.n_buckets < header.n_entries * 2) header.n_buckets *= 2;
+	header.strings = sizeof(c2m_index_header_t) +
+		header.n_buckets * sizeof(c2m_index_entry_t);
+	table = calloc(header.n_buckets, sizeof(c2m_index_entry_t));
+	for(uint32_t i = 0; i < header.n_entries; i++) {
+		c2m_index_entry_t* entry = cl_array_borrow(entries, i);
+		uint32_t bucket;
+
+		entry->hash = c2m_index_hash(
+			(char*)strings->store + entry->key, entry->key_length);
+		bucket = entry->hash & (header.n_buckets - 1);
+		while(table[bucket].hash)
+			bucket = (bucket + 1) & (header.n_buckets - 1);
+		table[bucket] = *entry;
+	}
+	c2m_string_clear(path);
+	c2m_string_appendf(path, "%s/" C2M_INDEX_FILE, dir);
+	if((output = SDL_RWFromFile(path->store, "wb")) == NULL ||
+		SDL_RWwrite(output, &header, sizeof(header), 1) != 1 ||
+		SDL_RWwrite(output, table, sizeof(c2m_index_entry_t),
+			header.n_buckets) != header.n_buckets ||
+		SDL_RWwrite(output, strings->store, 1, c2m_string_length(strings))
+			!= c2m_string_length(strings))
+	{
+		printf("Can't write %s\n", (char*)path->store);
+		c2m_abort("couldn't write library index");
+	}
+	SDL_RWclose(output);
+	printf("Indexed %u modules, %u functions in %s\n", n_modules,
+		header.n_entries - n_modules, dir);
+	free(table);
+	c2m_string_destroy(path);
+	c2m_string_destroy(strings);
+	cl_array_destroy(entries);
+	cl_array_destroy(names);
+#else
+	c2m_abort("--index needs dirent.h");
+#endif
+}
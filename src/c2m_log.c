@@ -0,0 +1,34 @@
+// Leveled log for compiler chatter, off unless asked for ( --log[=N], N is 1
+// for C2M_LOG_INFO, 2 for C2M_LOG_DEBUG ) & compiled out above C2M_LOG.
+// Messages go through SDL_log's application category, formatted & written
+// to stderr by its background thread ( SDL_LogSetAsync() ).  Progress &
+// errors aren't logged, they're always printed.
+
+#define C2M_LOG_INFO 1
+#define C2M_LOG_DEBUG 2
+
+#ifndef C2M_LOG
+#define C2M_LOG C2M_LOG_DEBUG
+#endif
+
+static uint8_t c2m_log_level = 0;
+
+#define c2m_log(level, ...) do{ \
+	if(C2M_LOG >= (level) && c2m_log_level >= (level)) { \
+		SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, \
+			(level) == C2M_LOG_DEBUG ? SDL_LOG_PRIORITY_DEBUG : \
+			SDL_LOG_PRIORITY_INFO, __VA_ARGS__); \
+	} \
+}while(0)
+
+static void c2m_log_quit(void) {
+	SDL_LogSetAsync(SDL_FALSE);
+}
+
+static void c2m_log_enable(uint8_t level) {
+	c2m_log_level = level;
+	SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, level >= C2M_LOG_DEBUG ?
+		SDL_LOG_PRIORITY_DEBUG : SDL_LOG_PRIORITY_INFO);
+	// Written synchronously if the thread can't start.
+	if(SDL_LogSetAsync(SDL_TRUE) == 0) atexit(c2m_log_quit);
+}
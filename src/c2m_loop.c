@@ -0,0 +1,270 @@
+// For loops ( a pass & their emitter ): "for i in [lo, hi) {" & "for i in
+// list {" ( see c2m_parse_for ) are counted C loops over an int64_t, with
+// what doesn't change taken out of them: the bound's worked out once, before
+// the loop ( a list's length as it is then ), & a list's data pointer is too
+// when nothing in the body can change the list ( a call passed a list or raw
+// C naming it ).  Indexing a list is bounds checked ( c2m_list_get ),
+// except by a loop's variable over that same list when it's unchanged: the
+// index is always below the length.  Unless raw C in the body names the
+// variable, it could change it.  main()'s args never change, only each
+// argument's UTF-8 is checked then ( c2m_args_at ).  What's left is a shape C
+// compilers vectorize: the bound & data in locals, no calls to check.
+// A collection's ( "for i in name {" ) is counted the same, indexing it by i
+// isn't checked when nothing in the body pushes to it.  "for line in
+// lines(name) {" reads the file a buffer at a time, each line's a string in
+// the buffer ( see c2m_prelude_lines ), nothing's copied.
+
+#include <ctype.h>
+
+#define C2M_LOOP_DEPTH 64 // For loops nested, those deeper prove nothing
+
+typedef struct{
+	c2m_node_t* loops[C2M_LOOP_DEPTH]; // Enclosing for loops, innermost last
+	uint32_t n_loops;
+}c2m_loop_scope_t;
+
+// Returns 1 if raw C `raw` has the identifier `name` in it ( not in a
+// literal ).
+static uint8_t c2m_loop_raw_names(c2m_node_t* raw, c2m_node_t* name) {
+	const char* text = raw->text;
+	uint32_t i = 0;
+
+	while(i < raw->length) {
+		uint32_t start = i;
+
+		if(text[i] == '"' || text[i] == '\'') {
+			while(++i < raw->length && text[i] != text[start])
+				if(text[i] == '\\') i++;
+			i++;
+			continue;
+		}
+		if(isalnum((uint8_t)text[i]) == 0 && text[i] != '_') {
+			i++;
+			continue;
+		}
+		while(++i < raw->length && (isalnum((uint8_t)text[i]) ||
+			text[i] == '_'));
+		if(i - start == name->length &&
+			memcmp(&text[start], name->text, name->length) == 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static inline uint8_t c2m_loop_is(c2m_node_t* value, c2m_node_t* name) {
+	return value->kind == NODE_IDENT && value->length == name->length &&
+		memcmp(value->text, name->text, name->length) == 0;
+}
+
+// Returns 1 if a call in `value` is passed `name`, or any list if it's a
+// list ( two parameters can be the same list ).
+static uint8_t c2m_loop_value_passes(c2m_node_t* value, c2m_node_t* name) {
+	for(; value; value = value->next) {
+		if(value->kind == NODE_CALL) {
+			for(c2m_node_t* arg = value->child; arg; arg = arg->next) {
+				if(c2m_loop_is(arg, name) || (name->type == TYPE_LIST &&
+					arg->type == TYPE_LIST))
+				{
+					return 1;
+				}
+			}
+		}
+		if(c2m_loop_value_passes(value->child, name) ||
+			c2m_loop_value_passes(value->body, name))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Returns 1 if the statements in `block` could change `name`: it's passed to
+ * a call ( a list ), pushed to ( a collection ) or named by raw C
+ * ( anything ).
+*/
+static uint8_t c2m_loop_changes(c2m_node_t* block, c2m_node_t* name) {
+	for(; block; block = block->next) {
+		switch(block->kind) {
+		case NODE_RAW:
+			if(c2m_loop_raw_names(block, name)) return 1;
+			break;
+		case NODE_AWAIT:
+			if(block->child->kind == NODE_RAW) {
+				if(c2m_loop_raw_names(block->child, name)) return 1;
+				break;
+			}
+			if(c2m_loop_value_passes(block->child, name)) return 1;
+			break;
+		case NODE_CALL:
+			if(c2m_loop_value_passes(block, name)) return 1;
+			break;
+		case NODE_DECLARE: case NODE_RETURN:
+			if(c2m_loop_value_passes(block->kind == NODE_DECLARE ?
+				block->body : block->child, name))
+			{
+				return 1;
+			}
+			break;
+		case NODE_PUSH:
+			if(c2m_loop_is(block->child, name) ||
+				c2m_loop_value_passes(block->body, name))
+			{
+				return 1;
+			}
+			break;
+		case NODE_WHILE: case NODE_PARALLEL: case NODE_BENCH: case NODE_FOR:
+			if(c2m_loop_changes(block->body, name)) return 1;
+			break;
+		}
+	}
+	return 0;
+}
+
+// Prove an index in bounds by the innermost loop with its variable.
+static void c2m_loop_index(c2m_node_t* index, void* data) {
+	c2m_loop_scope_t* scope = data;
+	c2m_node_t* i = index->body;
+
+	if(index->kind != NODE_INDEX) return;
+	// A collection's element keeps its record, see c2m_fold_index.
+	if(index->child->type == TYPE_ROWS) index->indirect = 0;
+	else index->record = NULL;
+	if(i->kind != NODE_IDENT || index->child->kind != NODE_IDENT) return;
+	for(uint32_t n = scope->n_loops; n--; ) {
+		c2m_node_t* loop = scope->loops[n];
+
+		if(loop->length != i->length ||
+			memcmp(loop->text, i->text, i->length))
+		{
+			continue;
+		}
+		// The loop's over the list, which is unchanged ( or args ).
+		if(c2m_loop_is(loop->child, index->child) &&
+			(loop->indirect || loop->child->type == TYPE_ARGS ||
+			(loop->child->type == TYPE_ROWS &&
+			c2m_loop_changes(loop->body, loop->child) == 0)) &&
+			c2m_loop_changes(loop->body, loop) == 0)
+		{
+			if(loop->child->type == TYPE_ROWS) index->indirect = 1;
+			else index->record = loop;
+		}
+		return;
+	}
+}
+
+static void c2m_loop_block(c2m_loop_scope_t* scope, c2m_node_t* block) {
+	c2m_loop_scope_t none;
+
+	none.n_loops = 0;
+	for(; block; block = block->next) {
+		switch(block->kind) {
+		case NODE_FOR:
+			c2m_node_walk(block->child, c2m_loop_index, scope);
+			block->indirect = block->child->type == TYPE_LIST &&
+				block->child->kind == NODE_IDENT &&
+				c2m_loop_changes(block->body, block->child) == 0;
+			if(scope->n_loops == C2M_LOOP_DEPTH) {
+				c2m_loop_block(&none, block->body);
+				break;
+			}
+			scope->loops[scope->n_loops++] = block;
+			c2m_loop_block(scope, block->body);
+			scope->n_loops--;
+			break;
+		case NODE_PARALLEL:
+			// Its body's another function, the loops' locals aren't there.
+			c2m_node_walk(block->child, c2m_loop_index, scope);
+			c2m_loop_block(&none, block->body);
+			break;
+		case NODE_WHILE: case NODE_BENCH:
+			c2m_loop_block(scope, block->body);
+			break;
+		case NODE_DECLARE: case NODE_PUSH:
+			c2m_node_walk(block->body, c2m_loop_index, scope);
+			break;
+		case NODE_CALL: case NODE_RETURN: case NODE_AWAIT:
+			c2m_node_walk(block->child, c2m_loop_index, scope);
+			break;
+		}
+	}
+}
+
+static void c2m_loop(c2m_t* c2m) {
+	c2m_loop_scope_t scope;
+
+	scope.n_loops = 0;
+	c2m_loop_block(&scope, c2m->main_fn->body);
+	for(c2m_node_t* fn = c2m->imported; fn; fn = fn->next)
+		c2m_loop_block(&scope, fn->body);
+}
+
+// A loop over a file's lines, its reader ( c2m_lines_i, see
+// c2m_prelude_lines ) in a block of its own.
+static void c2m_emit_lines(c2m_t* c2m, c2m_node_t* node, struct cl_array* a) {
+	c2m_node_t* path = node->child->child;
+	int length = node->length;
+
+	c2m_string_appendf(a, "{\nc2m_lines_t c2m_lines_%.*s;\n", length,
+		node->text);
+	if(path->kind == NODE_CONCAT) {
+		c2m_string_append(a, "{ char* c2m_end;\n");
+		c2m_emit_concat(path, 0, a);
+	}
+	c2m_string_appendf(a, "c2m_lines_open(&c2m_lines_%.*s, ", length,
+		node->text);
+	if(path->kind == NODE_CONCAT) c2m_emit_str(0, a);
+	else c2m_emit_value(path, a);
+	c2m_string_append(a, path->kind == NODE_CONCAT ? ");\n}\n" : ");\n");
+	c2m_string_appendf(a, "for(c2m_str_t %.*s; c2m_lines_next(&c2m_lines_%.*s,"
+		" &%.*s); ){\n", length, node->text, length, node->text, length,
+		node->text);
+	c2m_emit_block(c2m, node->body, a);
+	c2m_string_appendf(a, "}\nc2m_lines_close(&c2m_lines_%.*s);\n}\n",
+		length, node->text);
+}
+
+/*
+ * "for(int64_t i = lo; i < c2m_end_i; i++)" in a block of its own, where the
+ * bound & a list's hoisted data ( c2m_data_i ) are declared first.
+*/
+static void c2m_emit_for(c2m_t* c2m, c2m_node_t* node, struct cl_array* a) {
+	c2m_node_t* over = node->child;
+	int length = node->length;
+
+	if(over->kind == NODE_LINES) {
+		c2m_emit_lines(c2m, node, a);
+		return;
+	}
+	c2m_string_appendf(a, "{\nint64_t c2m_end_%.*s = ", length, node->text);
+	if(over->kind == NODE_RANGE) {
+		c2m_string_append(a, "(int64_t)");
+		c2m_emit_value(over->child->next, a);
+		c2m_string_append(a, over->text[1] == ']' ? " + 1;\n" : ";\n");
+		c2m_string_appendf(a, "for(int64_t %.*s = (int64_t)", length,
+			node->text);
+		c2m_emit_value(over->child, a);
+		if(over->text[0] == '(') c2m_string_append(a, " + 1");
+	}else if(over->type == TYPE_ARGS || over->type == TYPE_ROWS) {
+		c2m_emit_value(over, a);
+		c2m_string_appendf(a, "%s;\nfor(int64_t %.*s = 0",
+			over->type == TYPE_ARGS ? ".n" : ".c2m_n", length, node->text);
+	}else{
+		c2m_string_append(a, "(");
+		c2m_emit_argument(over, a);
+		c2m_string_append(a, ")->n;\n");
+		if(node->indirect) {
+			c2m_string_appendf(a, "const c2m_str_t* restrict c2m_data_%.*s "
+				"= c2m_list_data(", length, node->text);
+			c2m_emit_argument(over, a);
+			c2m_string_append(a, ");\n");
+		}
+		c2m_string_appendf(a, "for(int64_t %.*s = 0", length, node->text);
+	}
+	c2m_string_appendf(a, "; %.*s < c2m_end_%.*s; %.*s++){\n", length,
+		node->text, length, node->text, length, node->text);
+	c2m_emit_block(c2m, node->body, a);
+	c2m_string_append(a, "}\n}\n");
+}
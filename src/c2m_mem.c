@@ -0,0 +1,185 @@
+// Memory report ( --mem-report[=N] ): the compiler's heap use, current &
+// peak bytes & allocations per size class, from the malloc() & realloc()
+// wrappers of --time-report & ones for calloc() & free().  Blocks are
+// measured with the C library ( malloc_usable_size() or its kin, bytes are
+// 0 without one ).  With N, every Nth allocation's call stack is sampled &
+// the sites seen most are listed, for addr2line.  SDL's allocations aren't
+// wrapped, SDL_GetMemoryStats() reports the whole heap after them.
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#include <execinfo.h>
+#define C2M_MEM_SIZE(pointer) malloc_usable_size(pointer)
+#define C2M_MEM_BACKTRACE 1
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#include <execinfo.h>
+#define C2M_MEM_SIZE(pointer) malloc_size(pointer)
+#define C2M_MEM_BACKTRACE 1
+#elif defined(_WIN32)
+#include <malloc.h>
+#define C2M_MEM_SIZE(pointer) _msize(pointer)
+#else
+#define C2M_MEM_SIZE(pointer) ((void)(pointer), (size_t)0)
+#endif
+
+#define C2M_MEM_CLASSES 12 // Up to 16 bytes, 32, ... 16 KiB & bigger
+#define C2M_MEM_SITES 64 // Distinct call stacks sampled, at most
+#define C2M_MEM_DEPTH 8 // Frames per call stack
+
+typedef struct{
+	void* frames[C2M_MEM_DEPTH];
+	int depth;
+	uint32_t count;
+	uint64_t bytes;
+}c2m_mem_site_t;
+
+static uint8_t c2m_mem_enabled = 0;
+static uint32_t c2m_mem_rate = 0; // Sample 1 in N allocations, 0 for none
+static SDL_atomic64_t c2m_mem_current;
+static SDL_atomic64_t c2m_mem_peak;
+static SDL_atomic_t c2m_mem_counts[C2M_MEM_CLASSES];
+static SDL_atomic_t c2m_mem_tick;
+static c2m_mem_site_t c2m_mem_sites[C2M_MEM_SITES];
+static uint32_t c2m_mem_n_sites = 0;
+static SDL_SpinLock c2m_mem_lock; // The sites
+static uint32_t c2m_mem_dropped = 0; // Samples with no site left for them
+
+static void c2m_mem_enable(uint32_t rate) {
+	c2m_mem_enabled = 1;
+	c2m_mem_rate = rate;
+}
+
+static inline uint32_t c2m_mem_class(size_t size) {
+	uint32_t n = 0;
+
+	for(size_t limit = 16; size > limit && n < C2M_MEM_CLASSES - 1;
+		limit <<= 1)
+	{
+		n++;
+	}
+	return n;
+}
+
+// Record the call stack of a sampled allocation of `size` bytes.
+static void c2m_mem_sample(size_t size) {
+#ifdef C2M_MEM_BACKTRACE
+	void* frames[C2M_MEM_DEPTH];
+	int depth = backtrace(frames, C2M_MEM_DEPTH);
+	c2m_mem_site_t* site = NULL;
+
+	SDL_AtomicLock(&c2m_mem_lock);
+	for(uint32_t i = 0; i < c2m_mem_n_sites; i++) {
+		if(c2m_mem_sites[i].depth == depth && memcmp(c2m_mem_sites[i].frames,
+			frames, depth * sizeof(void*)) == 0)
+		{
+			site = &c2m_mem_sites[i];
+			break;
+		}
+	}
+	if(site == NULL && c2m_mem_n_sites < C2M_MEM_SITES) {
+		site = &c2m_mem_sites[c2m_mem_n_sites++];
+		memcpy(site->frames, frames, depth * sizeof(void*));
+		site->depth = depth;
+	}
+	if(site) {
+		site->count++;
+		site->bytes += size;
+	}else{
+		c2m_mem_dropped++;
+	}
+	SDL_AtomicUnlock(&c2m_mem_lock);
+#else
+	(void)size;
+#endif
+}
+
+// `pointer` was allocated, in place of `old` bytes ( realloc()'s ).
+static void c2m_mem_alloc(void* pointer, size_t old) {
+	size_t size;
+	int64_t current;
+	int64_t peak;
+
+	if(pointer == NULL) return;
+	size = C2M_MEM_SIZE(pointer);
+	SDL_AtomicIncRef(&c2m_mem_counts[c2m_mem_class(size)]);
+	current = SDL_AtomicFetchAdd64(&c2m_mem_current, (int64_t)(size - old),
+		SDL_MEMORY_ORDER_RELAXED) + (int64_t)(size - old);
+	peak = SDL_AtomicLoad64(&c2m_mem_peak, SDL_MEMORY_ORDER_RELAXED);
+	while(current > peak && SDL_AtomicCompareExchange64(&c2m_mem_peak, &peak,
+		current, SDL_MEMORY_ORDER_RELAXED) == SDL_FALSE) {}
+	if(c2m_mem_rate && (uint32_t)SDL_AtomicIncRef(&c2m_mem_tick) %
+		c2m_mem_rate == 0)
+	{
+		c2m_mem_sample(size);
+	}
+}
+
+static inline void* c2m_mem_calloc(size_t n, size_t size) {
+	void* pointer = calloc(n, size);
+
+	if(c2m_mem_enabled) c2m_mem_alloc(pointer, 0);
+	return pointer;
+}
+
+static inline void c2m_mem_free(void* pointer) {
+	if(c2m_mem_enabled && pointer) {
+		SDL_AtomicFetchAdd64(&c2m_mem_current,
+			-(int64_t)C2M_MEM_SIZE(pointer), SDL_MEMORY_ORDER_RELAXED);
+	}
+	free(pointer);
+}
+
+#define calloc(n, size) c2m_mem_calloc(n, size)
+#define free(pointer) c2m_mem_free(pointer)
+
+static int c2m_mem_site_compare(const void* a, const void* b) {
+	const c2m_mem_site_t* x = a;
+	const c2m_mem_site_t* y = b;
+
+	return x->count < y->count ? 1 : x->count > y->count ? -1 : 0;
+}
+
+static inline double c2m_mem_kib(int64_t bytes) {
+	return bytes > 0 ? bytes / 1024.0 : 0.0; // Freeing what came before
+}
+
+static void c2m_mem_report(void) {
+	SDL_MemoryStats heap;
+	size_t limit = 16;
+
+	SDL_GetMemoryStats(&heap);
+	fputs("Memory report:\n", stdout);
+	printf("  %-14s %10.1f KiB\n", "current", c2m_mem_kib(SDL_AtomicLoad64(
+		&c2m_mem_current, SDL_MEMORY_ORDER_RELAXED)));
+	printf("  %-14s %10.1f KiB\n", "peak", c2m_mem_kib(SDL_AtomicLoad64(
+		&c2m_mem_peak, SDL_MEMORY_ORDER_RELAXED)));
+	printf("  %-14s %10.1f KiB used, %.1f KiB held\n", "heap",
+		heap.used / 1024.0, heap.held / 1024.0);
+	for(uint32_t i = 0; i < C2M_MEM_CLASSES; i++, limit <<= 1) {
+		int count = SDL_AtomicGet(&c2m_mem_counts[i]);
+
+		if(count == 0) continue;
+		if(i == C2M_MEM_CLASSES - 1)
+			printf("  > %-12zu %10d allocs\n", limit >> 1, count);
+		else printf("  <= %-11zu %10d allocs\n", limit, count);
+	}
+	if(c2m_mem_rate == 0) return;
+	printf("Sampled 1 in %u allocations, by call stack:\n", c2m_mem_rate);
+	qsort(c2m_mem_sites, c2m_mem_n_sites, sizeof(c2m_mem_site_t),
+		c2m_mem_site_compare);
+	for(uint32_t i = 0; i < c2m_mem_n_sites && i < 10; i++) {
+		printf("  %8u samples %10.1f KiB\n", c2m_mem_sites[i].count,
+			c2m_mem_sites[i].bytes / 1024.0);
+		fflush(stdout);
+#ifdef C2M_MEM_BACKTRACE
+		// Past this function's & the wrappers' frames.
+		if(c2m_mem_sites[i].depth > 2) {
+			backtrace_symbols_fd(c2m_mem_sites[i].frames + 2,
+				c2m_mem_sites[i].depth - 2, 1);
+		}
+#endif
+	}
+	if(c2m_mem_dropped) printf("  %u samples from other sites\n",
+		c2m_mem_dropped);
+}
@@ -0,0 +1,507 @@
+// Library modules: each <module>.c2m on the search path is parsed once into a
+// function table, imports are then resolved from the table.  A module in a
+// library index ( see c2m_library.c ) is loaded from its interface, if there's
+// none only its imported functions are parsed, each when first looked up.
+// Any other module is prescanned ( see c2m_prescan.c ) & parsed the same way.
+// Modules called from main are parsed on worker threads, each into its own
+// node pool & source buffer, and their functions are emitted in parallel into
+// per-module buffers.  In batch mode a parsed module is kept whole in
+// c2m->module_cache & reused by every project with the same module source.
+
+typedef struct{
+	const char* name; // Interned
+	c2m_symtab_t* functions; // name -> NODE_FUNCTION
+	c2m_arena_t* arena; // The module's syntax tree
+	c2m_source_t source;
+	c2m_source_t interface; // The .c2mi it was loaded from, data may be NULL
+	struct cl_array* path; // Of the source, found on the search path
+	const c2m_index_entry_t* entry; // In a library index, or NULL
+	const c2m_source_t* library; // Index the entry is in
+	uint8_t lazy; // Functions are parsed as they're found ( not all used )
+	uint8_t whole; // Every function's used, no prescan ( a library's own )
+	c2m_libreq_t libreq; // Headers the module imports
+	struct cl_array* output; // C for the module's imported functions
+	uint32_t index; // In c2m->module_list
+	c2m_phase_t time; // Parsing, for --time-report
+	uint64_t hash; // Of the source
+	uint8_t shared; // Functions, arena & source belong to the module cache
+	c2m_t* c2m;
+}c2m_module_t;
+
+// Lex & parse a source file, the buffer is kept until the compile is done.
+static void c2m_parse_file(c2m_t* c2m, const char* filename,
+	c2m_lexer_t* lex)
+{
+	c2m_source_t* source = cl_array_add(c2m->sources);
+
+	if(c2m_source_open(source, filename)) {
+		cl_array_pop(c2m->sources);
+		printf("Can't open %s\n", filename);
+		c2m_abort("couldn't open input file");
+	}
+	c2m_cache_input(c2m, filename, source->data, source->size);
+	c2m_chunk_lex(lex, source->data, source->size);
+}
+
+static inline void c2m_libreq_merge(c2m_libreq_t* dest, c2m_libreq_t* src) {
+	dest->stdlib |= src->stdlib;
+	dest->stdio |= src->stdio;
+	dest->clump |= src->clump;
+	dest->sdl |= src->sdl;
+	dest->sdl_window |= src->sdl_window;
+	dest->sdl_audio |= src->sdl_audio;
+	dest->string |= src->string;
+	dest->concat |= src->concat;
+	dest->io |= src->io;
+	dest->args |= src->args;
+	dest->list |= src->list;
+	dest->set |= src->set;
+	dest->par |= src->par;
+	dest->co |= src->co;
+	dest->trace |= src->trace;
+	dest->bench |= src->bench;
+	dest->agg |= src->agg;
+}
+
+static c2m_module_t* c2m_module_create(c2m_t* c2m, const char* name) {
+	c2m_module_t* module = malloc(sizeof(c2m_module_t));
+
+	module->name = name;
+	module->functions = c2m_symtab_create(c2m->intern);
+	module->arena = c2m_arena_create();
+	module->source.data = NULL;
+	module->interface.data = NULL;
+	module->path = c2m_string_create(NULL);
+	module->entry = c2m_library_find(c2m, name, module->path,
+		&module->library);
+	module->lazy = 0;
+	module->whole = 0;
+	module->shared = 0;
+	memset(&module->libreq, 0, sizeof(c2m_libreq_t));
+	module->output = c2m_string_create(NULL);
+	module->c2m = c2m;
+	module->index = cl_array_count(c2m->module_list);
+	memset(&module->time, 0, sizeof(c2m_phase_t));
+	c2m_symtab_add(c2m->modules, name, SYMBOL_MODULE, 0, module);
+	*(c2m_module_t**)cl_array_add(c2m->module_list) = module;
+	c2m_log(C2M_LOG_INFO, "Opening %s\n", (char*)module->path->store);
+	return module;
+}
+
+// The module cache key, "name:hash" ( interned ).
+static const char* c2m_module_key(c2m_module_t* module) {
+	char key[128];
+	int length = snprintf(key, sizeof(key), "%s:%016llx", module->name,
+		(unsigned long long)module->hash);
+
+	return c2m_intern(module->c2m->intern, key, length);
+}
+
+/*
+ * Take the parse from the module cache if it has this source, returns 1 if
+ * the module needs parsing.  Only reads the cache, it's filled on the main
+ * thread by c2m_module_done().
+*/
+static uint8_t c2m_module_shared(c2m_module_t* module) {
+	c2m_symbol_t* symbol;
+	c2m_module_t* cached;
+
+	if(module->c2m->module_cache == NULL || (symbol = c2m_symtab_get(
+		module->c2m->module_cache, c2m_module_key(module))) == NULL)
+	{
+		return 1;
+	}
+	cached = symbol->data;
+	c2m_source_close(&module->source);
+	c2m_symtab_destroy(module->functions);
+	c2m_arena_destroy(module->arena);
+	module->functions = cached->functions;
+	module->arena = cached->arena;
+	module->source = cached->source;
+	module->interface = cached->interface;
+	module->libreq = cached->libreq;
+	module->shared = 1;
+	c2m_log(C2M_LOG_INFO, "Reusing %s\n", (char*)module->path->store);
+	return 0;
+}
+
+static void c2m_module_record_node(c2m_node_t* node, void* data) {
+	if(node->type == TYPE_RECORD || node->kind == NODE_CONSTRUCT)
+		*(uint8_t*)data = 1;
+}
+
+// Returns 1 if anything in the tree has a record type, those depend on the
+// program's records so the parse can't be shared.
+static uint8_t c2m_module_uses_records(c2m_module_t* module) {
+	struct cl_rhash_iterator iter;
+	uint8_t uses = 0;
+
+	cl_rhash_iterator_init(&iter, module->functions->map);
+	while(cl_rhash_iterator_next(&iter)) {
+		c2m_symbol_t* symbol = (void*)cl_rhash_iterator_value(&iter);
+		c2m_node_t* fn = symbol->data;
+
+		// Not the whole list, functions' next links imports together.
+		c2m_node_walk(fn->child, c2m_module_record_node, &uses);
+		c2m_node_walk(fn->body, c2m_module_record_node, &uses);
+	}
+	return uses;
+}
+
+// Parse a module ( job ), only touches the module & the interning pool.
+static void c2m_module_parse(void* job) {
+	c2m_module_t* module = job;
+	c2m_t worker = *module->c2m;
+	c2m_timer_t timer;
+	c2m_lexer_t lex;
+
+	module->time.name = module->name; // A slice of the trace
+	c2m_time_begin(&timer);
+	worker.arena = module->arena;
+	worker.file = module->path->store;
+	worker.recover = NULL;
+	memset(&worker.libreq, 0, sizeof(c2m_libreq_t));
+	if(c2m_source_open(&module->source, module->path->store)) {
+		printf("Can't open %s\n", (char*)module->path->store);
+		c2m_abort("couldn't open input file");
+	}
+	module->hash = c2m_hash(C2M_HASH_INIT, module->source.data,
+		module->source.size);
+	if(c2m_module_shared(module) == 0) {
+		c2m_time_end(&timer, &module->time);
+		return;
+	}
+	// An index that's out of date is ignored.
+	if(module->entry && module->entry->source == module->hash &&
+		module->entry->end == module->source.size)
+	{
+		struct cl_array* interface = c2m_string_create(
+			module->path->store);
+
+		c2m_string_append(interface, "i");
+		if((module->entry->flags & C2M_INDEX_INTERFACE) == 0 ||
+			c2m_interface_load(&worker, interface->store, module->hash,
+			&module->interface, module->arena, module->functions,
+			&module->libreq))
+		{
+			module->interface.data = NULL;
+			c2m_libreq_unpack(&module->libreq, module->entry->start);
+			module->lazy = 1;
+		}else{
+			c2m_log(C2M_LOG_INFO, "Loading %s\n",
+				(char*)interface->store);
+		}
+		c2m_string_destroy(interface);
+		c2m_time_end(&timer, &module->time);
+		return;
+	}
+	// Kept whole in the module cache, for every project's imports.
+	if(module->whole == 0 && worker.module_cache == NULL &&
+		c2m_prescan(&worker, module->source.data, module->source.size,
+		module->functions) == 0)
+	{
+		module->libreq = worker.libreq;
+		module->lazy = 1;
+		module->entry = NULL; // Out of date, every function's in the table
+		c2m_time_end(&timer, &module->time);
+		return;
+	}
+	c2m_lex(&lex, module->source.data, module->source.size);
+	c2m_parse_module(&worker, &lex, module->name, module->functions);
+	c2m_lex_destroy(&lex);
+	module->libreq = worker.libreq;
+	c2m_time_end(&timer, &module->time);
+}
+
+// Back on the main thread after parsing a module.
+static void c2m_module_done(c2m_t* c2m, c2m_module_t* module) {
+	c2m_cache_input(c2m, module->path->store, module->source.data,
+		module->source.size);
+	c2m_libreq_merge(&c2m->libreq, &module->libreq);
+	c2m_time_module(module->name, &module->time);
+	// Indexed modules are only partly parsed, & quick to look up anyway.
+	if(c2m->module_cache && module->shared == 0 && module->lazy == 0 &&
+		c2m_module_uses_records(module) == 0)
+	{
+		// The cache owns the parse from now on.
+		c2m_module_t* cached = malloc(sizeof(c2m_module_t));
+
+		*cached = *module;
+		cached->output = NULL;
+		cached->path = NULL;
+		c2m_symtab_add(c2m->module_cache, c2m_module_key(module),
+			SYMBOL_MODULE, 0, cached);
+		module->shared = 1;
+	}
+}
+
+// Get a module ( name is interned ), parsing it on first use.
+static c2m_module_t* c2m_module_get(c2m_t* c2m, const char* name) {
+	c2m_symbol_t* symbol = c2m_symtab_get(c2m->modules, name);
+
+	if(symbol) return symbol->data;
+
+	c2m_module_t* module = c2m_module_create(c2m, name);
+
+	c2m_module_parse(module);
+	c2m_module_done(c2m, module);
+	return module;
+}
+
+// The source file of module `name` ( interned ), for #line.
+static const char* c2m_module_file(c2m_t* c2m, const char* name) {
+	return c2m_module_get(c2m, name)->path->store;
+}
+
+// Parse every module main calls into, in parallel.
+static void c2m_module_preload(c2m_t* c2m) {
+	struct cl_array* jobs = cl_array_create(sizeof(void*), 8);
+
+	for(uint32_t i = 0; i < cl_array_count(c2m->imports); i++) {
+		c2m_symbol_t* import =
+			*(c2m_symbol_t**)cl_array_borrow(c2m->imports, i);
+		c2m_node_t* call = import->data;
+
+		if(c2m_symtab_get(c2m->modules, call->module)) continue;
+		*(void**)cl_array_add(jobs) = c2m_module_create(c2m,
+			call->module);
+	}
+	c2m->intern->shared = 1;
+	c2m_workers_run(c2m_module_parse, jobs->store, cl_array_count(jobs));
+	c2m->intern->shared = 0;
+	for(uint32_t i = 0; i < cl_array_count(jobs); i++) {
+		c2m_module_done(c2m, *(void**)cl_array_borrow(jobs, i));
+	}
+	cl_array_destroy(jobs);
+}
+
+// Parse a function of the module from its bytes in the source, [start, end)
+// starting on `line`.
+static c2m_node_t* c2m_module_parse_range(c2m_module_t* module,
+	uint32_t start, uint32_t end, uint32_t line)
+{
+	c2m_t worker = *module->c2m;
+	c2m_lexer_t lex;
+	c2m_node_t* fn;
+
+	worker.arena = module->arena;
+	worker.file = module->path->store;
+	worker.recover = NULL;
+	memset(&worker.libreq, 0, sizeof(c2m_libreq_t));
+	c2m_lex_from(&lex, module->source.data + start, end - start, line);
+	fn = c2m_parse_function(&worker, &lex, module->name);
+	c2m_lex_destroy(&lex);
+	// A prescanned function's trace isn't known before ( an index has it ).
+	c2m_libreq_merge(&module->c2m->libreq, &worker.libreq);
+	return fn;
+}
+
+// Parse an indexed module's function `name` from its bytes in the source.
+static c2m_node_t* c2m_module_parse_indexed(c2m_module_t* module,
+	const char* name)
+{
+	const char* key = c2m_intern_qualified(module->c2m->intern,
+		module->name, strlen(module->name), name, strlen(name));
+	const c2m_index_entry_t* entry =
+		c2m_index_get(module->library, key, strlen(key));
+	c2m_node_t* fn;
+
+	if(entry == NULL || entry->start >= entry->end ||
+		entry->end > module->source.size)
+	{
+		return NULL;
+	}
+	fn = c2m_module_parse_range(module, entry->start, entry->end,
+		entry->line);
+	c2m_symtab_add(module->functions, fn->text, SYMBOL_FUNCTION, 0, fn);
+	return fn;
+}
+
+static c2m_node_t* c2m_module_find(c2m_module_t* module, const char* name) {
+	c2m_symbol_t* symbol = c2m_symtab_get(module->functions, name);
+
+	if(symbol && symbol->kind == SYMBOL_UNPARSED) {
+		c2m_prescan_def_t* def = symbol->data;
+
+		symbol->data = c2m_module_parse_range(module, def->start,
+			def->end, def->line);
+		symbol->kind = SYMBOL_FUNCTION;
+	}
+	if(symbol) return symbol->data;
+	return module->lazy && module->entry ?
+		c2m_module_parse_indexed(module, name) : NULL;
+}
+
+// Emit a module's imported functions into its output buffer.
+static void c2m_module_emit_functions(c2m_module_t* module) {
+	c2m_t* c2m = module->c2m;
+
+	for(c2m_node_t* fn = c2m->imported; fn; fn = fn->next) {
+		if(fn->module == module->name)
+			c2m_emit_function(c2m, fn, module->output);
+	}
+}
+
+// Emit a module's imported functions & write them once it's the module's
+// turn ( job ).  Jobs start in module order, so every earlier module is
+// already being emitted by another thread while this one waits.
+static void c2m_module_emit_one(void* job) {
+	c2m_module_t* module = job;
+
+	c2m_module_emit_functions(module);
+	c2m_output_wait(module->c2m, module->index);
+	c2m_output_section(module->c2m, module->output);
+	c2m_output_done(module->c2m);
+	c2m_string_destroy(module->output);
+	module->output = NULL;
+}
+
+// Emit & write all imported functions, grouped by module in the order the
+// modules were first used.
+static void c2m_module_emit(c2m_t* c2m) {
+	c2m_workers_run(c2m_module_emit_one, c2m->module_list->store,
+		cl_array_count(c2m->module_list));
+}
+
+// Free every module along with its arena & source buffer.
+static void c2m_module_destroy_all(c2m_t* c2m) {
+	for(uint32_t i = 0; i < cl_array_count(c2m->module_list); i++) {
+		c2m_module_t* module =
+			*(c2m_module_t**)cl_array_borrow(c2m->module_list, i);
+
+		if(module->shared == 0) {
+			c2m_symtab_destroy(module->functions);
+			c2m_arena_destroy(module->arena);
+			if(module->source.data) c2m_source_close(&module->source);
+			if(module->interface.data)
+				c2m_source_close(&module->interface);
+		}
+		if(module->output) c2m_string_destroy(module->output);
+		c2m_string_destroy(module->path);
+		free(module);
+	}
+	cl_array_clear(c2m->module_list);
+	c2m_symtab_destroy(c2m->modules);
+	c2m->modules = c2m_symtab_create(c2m->intern);
+}
+
+// Free a batch's module cache & the parses it owns, see c2m_module_done().
+static void c2m_module_cache_destroy(c2m_symtab_t* cache) {
+	struct cl_rhash_iterator iter;
+
+	cl_rhash_iterator_init(&iter, cache->map);
+	while(cl_rhash_iterator_next(&iter)) {
+		c2m_symbol_t* symbol = (void*)cl_rhash_iterator_value(&iter);
+		c2m_module_t* cached = symbol->data;
+
+		c2m_symtab_destroy(cached->functions);
+		c2m_arena_destroy(cached->arena);
+		if(cached->source.data) c2m_source_close(&cached->source);
+		if(cached->interface.data) c2m_source_close(&cached->interface);
+		free(cached);
+	}
+	c2m_symtab_destroy(cache);
+}
+
+// Record a call's ( or exported function's ) function as needed, once per
+// module & function.
+static void c2m_import_need(c2m_t* c2m, c2m_node_t* call) {
+	const char* name = c2m_intern_qualified(c2m->intern, call->module,
+		call->module_length, call->text, call->length);
+
+	if(c2m_symtab_get(c2m->import_table, name)) return;
+
+	c2m_log(C2M_LOG_DEBUG, "Import module: %s & Function: %s\n",
+		call->module, call->text);
+	*(c2m_symbol_t**)cl_array_add(c2m->imports) = c2m_symtab_add(
+		c2m->import_table, name, SYMBOL_IMPORT, 0, call);
+	*(const char**)cl_array_add(c2m->import_files) = c2m->file;
+}
+
+static void c2m_import_add(c2m_node_t* call, void* data) {
+	if(call->kind == NODE_CALL) c2m_import_need(data, call);
+}
+
+static int c2m_import_compare(const void* a, const void* b) {
+	uint32_t x = (*(c2m_node_t**)a)->line, y = (*(c2m_node_t**)b)->line;
+
+	return x < y ? -1 : x > y;
+}
+
+// A library's functions are all needed, in the order they're written so its
+// header is too.  Its module is src/<name>.c2m, not found on the search path.
+static void c2m_import_exports(c2m_t* c2m) {
+	c2m_module_t* module = c2m_module_create(c2m, c2m->exports);
+	struct cl_rhash_iterator iter;
+	c2m_node_t** functions;
+	uint32_t n = 0;
+
+	c2m_string_clear(module->path);
+	c2m_string_appendf(module->path, "src/%s.c2m", c2m->exports);
+	module->entry = NULL;
+	module->whole = 1;
+	c2m_module_parse(module);
+	c2m_module_done(c2m, module);
+	functions = malloc(sizeof(c2m_node_t*) *
+		(c2m_symtab_count(module->functions) + 1));
+	cl_rhash_iterator_init(&iter, module->functions->map);
+	while(cl_rhash_iterator_next(&iter)) {
+		functions[n++] = ((c2m_symbol_t*)(void*)
+			cl_rhash_iterator_value(&iter))->data;
+	}
+	qsort(functions, n, sizeof(c2m_node_t*), c2m_import_compare);
+	c2m->file = module->path->store;
+	for(uint32_t i = 0; i < n; i++) c2m_import_need(c2m, functions[i]);
+	free(functions);
+	if(n == 0) c2m_diag(c2m, 1, 0, "Library exports no functions", "", 0);
+}
+
+/*
+ * Reachability: starting from main, find every library function that can be
+ * called and add it to c2m->imported, nothing else is emitted.  Unreachable
+ * statements are pruned first so their calls don't import anything.
+*/
+static void c2m_module_resolve(c2m_t* c2m) {
+	c2m_node_t** tail = &c2m->imported;
+	uint32_t pruned = c2m_pass_prune(c2m->main_fn->body);
+
+	c2m_node_walk(c2m->main_fn->body, c2m_import_add, c2m);
+	if(c2m->exports) c2m_import_exports(c2m);
+	c2m_module_preload(c2m);
+	// Imports found while resolving are appended, so count each time.
+	for(uint32_t i = 0; i < cl_array_count(c2m->imports); i++) {
+		c2m_symbol_t* import =
+			*(c2m_symbol_t**)cl_array_borrow(c2m->imports, i);
+		c2m_node_t* call = import->data;
+		c2m_module_t* module = c2m_module_get(c2m, call->module);
+		c2m_node_t* fn = c2m_module_find(module, call->text);
+		const char* name = call->text;
+
+		if(fn == NULL) {
+			c2m->file = *(const char**)cl_array_borrow(
+				c2m->import_files, i);
+			c2m_diag(c2m, call->line, 0, "No such function",
+				import->name, strlen(import->name));
+			continue;
+		}
+		c2m_log(C2M_LOG_DEBUG, "Open function %s\n", name);
+		c2m_node_append(&tail, fn);
+		pruned += c2m_pass_prune(fn->body);
+		// Calls made by library functions are imported as well.
+		c2m->file = module->path->store;
+		c2m_node_walk(fn->body, c2m_import_add, c2m);
+	}
+	c2m->file = "src/main.c2m";
+	*tail = NULL; // A shared function may still link to another project's
+	if(c2m->stats) {
+		uint32_t parsed = 0;
+
+		for(uint32_t i = 0; i < cl_array_count(c2m->module_list); i++) {
+			parsed += c2m_symtab_count((*(c2m_module_t**)
+				cl_array_borrow(c2m->module_list, i))->functions);
+		}
+		printf("Emitting %u of %u library functions, pruned %u "
+			"unreachable statements\n", cl_array_count(c2m->imports),
+			parsed, pruned);
+	}
+}
@@ -0,0 +1,124 @@
+// Streaming output: each finished top-level definition goes straight to
+// main.c and to the backend, so the C compiler runs while the rest is still
+// being emitted.  Emitters running on worker threads
+// take turns, in module order, so the output stays the same.
+
+// Writes are collected here & flushed at module boundaries, anything bigger
+// than the buffer goes out together with it in one SDL_RWwritev() ( a
+// writev() on POSIX ).
+#define C2M_OUTPUT_BUFFER 65536
+
+typedef struct{
+	SDL_RWops* file; // main.c
+	const c2m_backend_t* backend; // NULL if not compiling
+	SDL_mutex* lock;
+	SDL_cond* turn_changed;
+	uint32_t turn; // Index of the module that may write next
+	uint32_t used; // Bytes in buffer
+	char buffer[C2M_OUTPUT_BUFFER];
+}c2m_output_t;
+
+static void c2m_output_open(c2m_t* c2m, const c2m_backend_t* backend) {
+	c2m_output_t* out = malloc(sizeof(c2m_output_t));
+
+#ifdef C2M_SOURCE_MMAP
+	// Writes are already gathered, so the file's own buffer is a page.
+	out->file = SDL_RWFromFileFD("main.c", "w", 1);
+#else
+	out->file = SDL_RWFromFile("main.c", "w+");
+#endif
+	if(out->file == NULL) c2m_abort("couldn't create output file");
+	if(backend && backend->open(c2m))
+		c2m_abort("couldn't start the C compiler");
+	if(backend) c2m_abort_build = c2m;
+	out->backend = backend;
+	out->lock = SDL_CreateMutex();
+	out->turn_changed = SDL_CreateCond();
+	out->turn = 0;
+	out->used = 0;
+	c2m->out = out;
+}
+
+// Write the buffer, then `n` bytes of `data` ( may be 0 ).
+static void c2m_output_flush_with(c2m_t* c2m, const char* data, uint32_t n) {
+	c2m_output_t* out = c2m->out;
+	c2m_timer_t timer;
+
+	c2m_time_begin(&timer);
+	SDL_RWiovec iov[2] = {
+		{ out->buffer, out->used },
+		{ data, n },
+	};
+
+	if(SDL_RWwritev(out->file, iov, 2) != (size_t)out->used + n)
+		c2m_abort("Failed to write");
+	if(out->backend) {
+		out->backend->write(c2m, out->buffer, out->used);
+		out->backend->write(c2m, data, n);
+	}
+	out->used = 0;
+	c2m_time_end(&timer, &c2m_phases[C2M_PHASE_WRITE]);
+}
+
+static inline void c2m_output_flush(c2m_t* c2m) {
+	c2m_output_flush_with(c2m, NULL, 0);
+}
+
+static void c2m_output_n(c2m_t* c2m, const char* data, uint32_t n) {
+	c2m_output_t* out = c2m->out;
+
+	c2m->output_hash = c2m_hash(c2m->output_hash, data, n);
+	if(out->used + n <= C2M_OUTPUT_BUFFER) {
+		memcpy(out->buffer + out->used, data, n);
+		out->used += n;
+	}else if(n >= C2M_OUTPUT_BUFFER) {
+		c2m_output_flush_with(c2m, data, n);
+	}else{
+		c2m_output_flush(c2m);
+		memcpy(out->buffer, data, n);
+		out->used = n;
+	}
+}
+
+static inline void c2m_output(c2m_t* c2m, const char* string) {
+	c2m_output_n(c2m, string, strlen(string));
+}
+
+// Write a section & empty it.
+static inline void c2m_output_section(c2m_t* c2m, struct cl_array* section) {
+	c2m_output_n(c2m, section->store, c2m_string_length(section));
+	c2m_string_clear(section);
+}
+
+// Block until it's module `turn`'s turn to write.
+static void c2m_output_wait(c2m_t* c2m, uint32_t turn) {
+	c2m_output_t* out = c2m->out;
+
+	SDL_LockMutex(out->lock);
+	while(out->turn != turn)
+		SDL_CondWait(out->turn_changed, out->lock);
+	SDL_UnlockMutex(out->lock);
+}
+
+// Let the next module write, whatever's buffered goes to the compiler now.
+static void c2m_output_done(c2m_t* c2m) {
+	c2m_output_t* out = c2m->out;
+
+	c2m_output_flush(c2m);
+	SDL_LockMutex(out->lock);
+	out->turn++;
+	SDL_CondBroadcast(out->turn_changed);
+	SDL_UnlockMutex(out->lock);
+}
+
+// Close main.c, the backend is closed ( or cancelled ) by the caller.
+static void c2m_output_close(c2m_t* c2m) {
+	c2m_output_t* out = c2m->out;
+
+	c2m_output_flush(c2m);
+	if(SDL_RWclose(out->file)) c2m_abort("Failed to write");
+	SDL_DestroyCond(out->turn_changed);
+	SDL_DestroyMutex(out->lock);
+	free(out);
+	c2m->out = NULL;
+}
@@ -0,0 +1,282 @@
+// Parallel loops ( a pass & their emitter ): "parallel for i in [lo, hi) {"
+// runs its body on the runtime's thread pool ( see c2m_prelude_par ).  The
+// body becomes its own C function over a chunk of the interval, the loop a
+// call to c2m_par_for().  The pass finds the variables the body can see &
+// captures them: they're copied into a context struct when the loop starts
+// & each chunk reads its own copy.  Lists aren't captured, pushing from many
+// threads at once would race.  A reduction's variable is each thread's
+// accumulator in the body ( padded to a cache line so they don't share one ),
+// combined into the variable once the loop's done.
+
+#define C2M_PARALLEL_SCOPE 256 // Variables a loop can see, at most
+
+typedef struct{
+	c2m_t* c2m;
+	c2m_arena_t* arena; // The function's ( main's or its module's )
+	c2m_node_t* fn;
+	c2m_node_t* vars[C2M_PARALLEL_SCOPE]; // NODE_DECLARE, _PARAM or _PARALLEL
+	uint32_t n_vars;
+}c2m_parallel_scope_t;
+
+static void c2m_parallel_see(c2m_parallel_scope_t* scope, c2m_node_t* var) {
+	if(scope->n_vars == C2M_PARALLEL_SCOPE) {
+		c2m_diag(scope->c2m, var->line, 0, "Too many variables for a "
+			"parallel loop", var->text, var->length);
+		return;
+	}
+	scope->vars[scope->n_vars++] = var;
+}
+
+// A captured copy of `var`, as the parameter it's declared like.
+static c2m_node_t* c2m_parallel_capture(c2m_arena_t* arena, c2m_node_t* var)
+{
+	c2m_node_t* capture = c2m_node_create(arena, NODE_PARAM, var->line);
+
+	if(var->kind == NODE_DECLARE) {
+		c2m_node_text(capture, var->child->text, var->child->length);
+		capture->type = var->type;
+		capture->record = var->record;
+	}else{
+		c2m_node_text(capture, var->text, var->length);
+		capture->type = var->kind == NODE_PARAM || var->kind == NODE_FOR ?
+			var->type : TYPE_SINT64;
+		capture->record = var->kind == NODE_PARAM ? var->record : NULL;
+		capture->indirect = var->kind == NODE_PARAM ? var->indirect : 0;
+	}
+	return capture;
+}
+
+static inline uint8_t c2m_parallel_named(c2m_node_t* a, c2m_node_t* b) {
+	return a->length == b->length && memcmp(a->text, b->text, a->length) == 0;
+}
+
+// Name the loop ( "module__function_par<line>" ) & capture what it sees, but
+// lists, unused args & the loop's own variables.
+static void c2m_parallel_loop(c2m_parallel_scope_t* scope, c2m_node_t* node) {
+	c2m_node_t* reduce = node->child->next;
+	c2m_node_t** tail = &node->record;
+	struct cl_array* name = c2m_string_create(NULL);
+	const char* module = scope->fn->module ? scope->fn->module : "main";
+
+	c2m_string_appendf(name, "%s__%.*s_par%u", module, (int)scope->fn->length,
+		scope->fn->text, node->line);
+	node->record = NULL;
+	for(uint32_t i = 0; i < scope->n_vars; i++) {
+		c2m_node_t* capture = c2m_parallel_capture(scope->arena,
+			scope->vars[i]);
+
+		if(capture->type == TYPE_LIST || c2m_parallel_named(capture, node) ||
+			(capture->type == TYPE_ARGS && scope->c2m->libreq.args == 0) ||
+			(reduce && c2m_parallel_named(capture, reduce->child)))
+		{
+			continue;
+		}
+		c2m_node_append(&tail, capture);
+	}
+	node->module_length = c2m_string_length(name);
+	node->module = c2m_arena_strndup(scope->arena, name->store,
+		node->module_length);
+	c2m_string_destroy(name);
+}
+
+static void c2m_parallel_block(c2m_parallel_scope_t* scope,
+	c2m_node_t* block)
+{
+	uint32_t n_vars = scope->n_vars;
+
+	for(; block; block = block->next) {
+		if(block->kind == NODE_DECLARE) {
+			c2m_parallel_see(scope, block);
+		}else if(block->kind == NODE_WHILE || block->kind == NODE_BENCH) {
+			c2m_parallel_block(scope, block->body);
+		}else if(block->kind == NODE_FOR) {
+			uint32_t outer = scope->n_vars;
+
+			c2m_parallel_see(scope, block);
+			c2m_parallel_block(scope, block->body);
+			scope->n_vars = outer;
+		}else if(block->kind == NODE_PARALLEL) {
+			uint32_t outer = scope->n_vars;
+
+			c2m_parallel_loop(scope, block);
+			c2m_parallel_see(scope, block);
+			c2m_parallel_block(scope, block->body);
+			scope->n_vars = outer;
+		}
+	}
+	scope->n_vars = n_vars;
+}
+
+static void c2m_parallel_function(c2m_t* c2m, c2m_node_t* fn,
+	c2m_arena_t* arena)
+{
+	c2m_parallel_scope_t* scope = malloc(sizeof(c2m_parallel_scope_t));
+
+	scope->c2m = c2m;
+	scope->arena = arena;
+	scope->fn = fn;
+	scope->n_vars = 0;
+	for(c2m_node_t* param = fn->child; param; param = param->next)
+		c2m_parallel_see(scope, param);
+	c2m_parallel_block(scope, fn->body);
+	free(scope);
+}
+
+static void c2m_parallel(c2m_t* c2m) {
+	if(c2m->libreq.par == 0) {
+		// The libreq pass hasn't run yet, look for a loop first.
+		c2m_pass_walk(c2m, c2m_pass_libreq_node);
+		if(c2m->libreq.par == 0) return;
+	}
+	c2m_parallel_function(c2m, c2m->main_fn, c2m->arena);
+	for(c2m_node_t* fn = c2m->imported; fn; fn = fn->next)
+		c2m_parallel_function(c2m, fn, c2m_module_get(c2m, fn->module)->arena);
+}
+
+// "*(T*)c2m_acc", a reduction's accumulator as the type of its variable.
+static void c2m_parallel_acc(c2m_node_t* reduce, struct cl_array* a) {
+	c2m_string_append(a, "*(");
+	c2m_emit_type(reduce->type, NULL, a);
+	c2m_string_append(a, "*)c2m_acc");
+}
+
+// The loop's context type & its body as a function over [c2m_lo, c2m_hi).
+static void c2m_parallel_hoist(c2m_t* c2m, c2m_node_t* node,
+	struct cl_array* a)
+{
+	c2m_node_t* reduce = node->child->next;
+
+	if(node->record) {
+		c2m_string_append(a, "typedef struct{\n");
+		for(c2m_node_t* var = node->record; var; var = var->next) {
+			c2m_emit_param(var, var->text, var->length, a);
+			c2m_string_append(a, ";\n");
+		}
+		c2m_string_append_n(a, "}", 1);
+		c2m_string_append_n(a, node->module, node->module_length);
+		c2m_string_append(a, "_t;\n");
+	}
+	c2m_string_append(a, "static void ");
+	c2m_string_append_n(a, node->module, node->module_length);
+	c2m_string_append(a, "(void* c2m_ctx, int64_t c2m_lo, int64_t c2m_hi,"
+		" void* c2m_acc){\n");
+	if(node->record) {
+		c2m_string_append(a, "const ");
+		c2m_string_append_n(a, node->module, node->module_length);
+		c2m_string_append(a, "_t* c2m_c = c2m_ctx;\n");
+	}
+	for(c2m_node_t* var = node->record; var; var = var->next) {
+		c2m_emit_param(var, var->text, var->length, a);
+		c2m_string_append(a, " = c2m_c->");
+		c2m_string_append_n(a, var->text, var->length);
+		c2m_string_append(a, "; (void)");
+		c2m_string_append_n(a, var->text, var->length);
+		c2m_string_append(a, ";\n");
+	}
+	if(reduce) {
+		c2m_emit_type(reduce->type, NULL, a);
+		c2m_string_append_n(a, " ", 1);
+		c2m_string_append_n(a, reduce->child->text, reduce->child->length);
+		c2m_string_append(a, " = ");
+		c2m_parallel_acc(reduce, a);
+		c2m_string_append(a, ";\n");
+	}
+	c2m_string_append(a, "for(int64_t ");
+	c2m_string_append_n(a, node->text, node->length);
+	c2m_string_append(a, " = c2m_lo; ");
+	c2m_string_append_n(a, node->text, node->length);
+	c2m_string_append(a, " < c2m_hi; ");
+	c2m_string_append_n(a, node->text, node->length);
+	c2m_string_append(a, "++){\n");
+	c2m_emit_block(c2m, node->body, a);
+	c2m_string_append(a, "}\n");
+	if(reduce) {
+		c2m_parallel_acc(reduce, a);
+		c2m_string_append(a, " = ");
+		c2m_string_append_n(a, reduce->child->text, reduce->child->length);
+		c2m_string_append(a, ";\n");
+	}
+	c2m_string_append(a, "}\n");
+}
+
+// Emit the functions of the parallel loops in `block`, before the function
+// they're in.  Inner loops go first, the outer loop's body calls them.
+static void c2m_emit_parallels(c2m_t* c2m, c2m_node_t* block,
+	struct cl_array* a)
+{
+	for(; block; block = block->next) {
+		if(block->kind == NODE_WHILE || block->kind == NODE_BENCH ||
+			block->kind == NODE_FOR)
+		{
+			c2m_emit_parallels(c2m, block->body, a);
+		}else if(block->kind == NODE_PARALLEL) {
+			c2m_emit_parallels(c2m, block->body, a);
+			c2m_parallel_hoist(c2m, block, a);
+		}
+	}
+}
+
+// The loop: capture, start the accumulators at the operator's identity ( the
+// variable itself for min & max ), run & combine them into the variable.
+static void c2m_emit_parallel(c2m_t* c2m, c2m_node_t* node,
+	struct cl_array* a)
+{
+	c2m_node_t* range = node->child;
+	c2m_node_t* reduce = range->next;
+	const char* op = reduce ? reduce->text : NULL;
+	uint8_t min = reduce && c2m_node_match(reduce, "min") == 0;
+	uint8_t max = reduce && c2m_node_match(reduce, "max") == 0;
+
+	c2m_string_append(a, "{\n");
+	if(node->record) {
+		c2m_string_append_n(a, node->module, node->module_length);
+		c2m_string_append(a, "_t c2m_ctx = {");
+		for(c2m_node_t* var = node->record; var; var = var->next) {
+			c2m_string_append_n(a, " ", 1);
+			c2m_string_append_n(a, var->text, var->length);
+			c2m_string_append_n(a, ",", 1);
+		}
+		c2m_string_append(a, " };\n");
+	}
+	if(reduce) {
+		c2m_string_append(a, "struct{ _Alignas(64) ");
+		c2m_emit_type(reduce->type, NULL, a);
+		c2m_string_append(a, " v; }c2m_acc[C2M_PAR_MAX];\n"
+			"unsigned c2m_n = c2m_par_count();\n"
+			"for(unsigned c2m_w = 0; c2m_w < c2m_n; c2m_w++) "
+			"c2m_acc[c2m_w].v = ");
+		if(min || max) {
+			c2m_string_append_n(a, reduce->child->text,
+				reduce->child->length);
+		}else{
+			c2m_string_append(a, op[0] == '*' ? "1" : "0");
+		}
+		c2m_string_append(a, ";\n");
+	}
+	c2m_string_append(a, "c2m_par_for(");
+	c2m_string_append_n(a, node->module, node->module_length);
+	c2m_string_append(a, node->record ? ", &c2m_ctx, (int64_t)" :
+		", 0, (int64_t)");
+	c2m_emit_value(range->child, a);
+	c2m_string_append(a, range->text[0] == '(' ? " + 1, (int64_t)" :
+		", (int64_t)");
+	c2m_emit_value(range->child->next, a);
+	c2m_string_append(a, range->text[1] == ']' ? " + 1, " : ", ");
+	c2m_string_append(a, reduce ? "c2m_acc, sizeof(c2m_acc[0]));\n" :
+		"0, 0);\n");
+	if(reduce) {
+		c2m_string_append(a, "for(unsigned c2m_w = 0; c2m_w < c2m_n; "
+			"c2m_w++) ");
+		if(min || max) {
+			c2m_string_appendf(a, "if(c2m_acc[c2m_w].v %s ", min ? "<" : ">");
+			c2m_string_append_n(a, reduce->child->text,
+				reduce->child->length);
+			c2m_string_append(a, ") ");
+		}
+		c2m_string_append_n(a, reduce->child->text, reduce->child->length);
+		c2m_string_append(a, min || max ? " = " : op[0] == '*' ? " *= " :
+			" += ");
+		c2m_string_append(a, "c2m_acc[c2m_w].v;\n");
+	}
+	c2m_string_append(a, "}\n");
+}
@@ -0,0 +1,988 @@
+// Parser: builds the syntax tree from the token stream, no C is emitted here.
+
+static c2m_node_t* c2m_parse_block(c2m_t* c2m, c2m_lexer_t* lex,
+	uint8_t is_main);
+static c2m_node_t* c2m_chunk_parse_main(c2m_t* c2m, c2m_lexer_t* lex);
+
+// Report an error at the next token, see c2m_error().
+static inline void c2m_parse_error(c2m_t* c2m, c2m_lexer_t* lex,
+	const char* message)
+{
+	c2m_error(c2m, lex, c2m_lex_peek(lex, 0), message);
+}
+
+static inline c2m_node_t* c2m_parse_node(c2m_t* c2m, uint8_t kind,
+	c2m_token_t* token)
+{
+	return c2m_node_create(c2m->arena, kind, token->line);
+}
+
+// Set the node's text to the interned identifier `token`.
+static inline void c2m_parse_name(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_node_t* node, c2m_token_t* token)
+{
+	c2m_node_text(node, c2m_intern(c2m->intern, &lex->source[token->offset],
+		token->length), token->length);
+}
+
+/*
+ * Returns NULL if `token` doesn't name a type.
+*/
+static inline c2m_symbol_t* c2m_parse_type(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_token_t* token)
+{
+	return c2m_symtab_get(c2m->types, c2m_intern(c2m->intern,
+		&lex->source[token->offset], token->length));
+}
+
+static c2m_node_t* c2m_parse_value(c2m_t* c2m, c2m_lexer_t* lex);
+static c2m_node_t* c2m_parse_call_args(c2m_t* c2m, c2m_lexer_t* lex);
+
+// "Record(value, ...)", leaves the closing parenthesis to the caller.
+static c2m_node_t* c2m_parse_construct(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_token_t* token)
+{
+	c2m_symbol_t* type = c2m_parse_type(c2m, lex, token);
+	c2m_node_t* node = c2m_parse_node(c2m, NODE_CONSTRUCT, token);
+	c2m_node_t** tail = &node->child;
+
+	if(type == NULL || type->type != TYPE_RECORD)
+		c2m_error(c2m, lex, token, "Not a record");
+	node->type = TYPE_RECORD;
+	node->record = type->data;
+	lex->pos += 2;
+	while(c2m_lex_match(lex, c2m_lex_peek(lex, 0), ")")) {
+		if(node->child && c2m_lex_expect(lex, ","))
+			c2m_parse_error(c2m, lex, "No closing parenthesis for record");
+		c2m_node_t* value = c2m_parse_value(c2m, lex);
+		if(value == NULL) c2m_parse_error(c2m, lex, "Unrecognized value");
+		c2m_node_append(&tail, value);
+	}
+	return node;
+}
+
+// Returns 1 if two tokens don't have the same text.
+static inline uint8_t c2m_parse_differ(c2m_lexer_t* lex, c2m_token_t* a,
+	c2m_token_t* b)
+{
+	return a->length != b->length || memcmp(&lex->source[a->offset],
+		&lex->source[b->offset], a->length);
+}
+
+// A number with a decimal point ( "2.5" ) is a double, like in C.
+static inline uint8_t c2m_parse_number_type(c2m_node_t* node) {
+	return memchr(node->text, '.', node->length) ? TYPE_FLOAT64 :
+		TYPE_INTEGER;
+}
+
+// A literal from the parser, bounds of builders aren't in the source.
+static inline c2m_node_t* c2m_parse_literal(c2m_t* c2m, c2m_token_t* token,
+	const char* digits)
+{
+	c2m_node_t* node = c2m_parse_node(c2m, NODE_INTEGER, token);
+
+	c2m_node_text(node, digits, strlen(digits));
+	node->type = TYPE_INTEGER;
+	return node;
+}
+
+/*
+ * "{x|x<5}": the condition bounds x, so a builder is an interval of the set's
+ * range ( "<", "<=", ">" or ">=" ).  Leaves the closing bracket to the
+ * caller.
+*/
+static c2m_node_t* c2m_parse_builder(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_token_t* token)
+{
+	c2m_token_t* name = c2m_lex_peek(lex, 1);
+	c2m_node_t* node = c2m_parse_node(c2m, NODE_RANGE, token);
+	c2m_token_t* op;
+	c2m_node_t* bound;
+	uint8_t equal;
+
+	lex->pos += 3;
+	if(c2m_parse_differ(lex, c2m_lex_next(lex), name))
+		c2m_parse_error(c2m, lex, "Expected the builder's variable");
+	op = c2m_lex_next(lex);
+	if(c2m_lex_match(lex, op, "<") && c2m_lex_match(lex, op, ">"))
+		c2m_parse_error(c2m, lex, "Expected \"<\" or \">\" in builder");
+	// "<=" is two tokens, side by side.
+	equal = c2m_lex_peek(lex, 0)->offset == op->offset + 1 &&
+		c2m_lex_expect(lex, "=") == 0;
+	if((bound = c2m_parse_value(c2m, lex)) == NULL)
+		c2m_parse_error(c2m, lex, "Expected a bound in builder");
+	if(c2m_lex_match(lex, c2m_lex_peek(lex, 0), "}"))
+		c2m_parse_error(c2m, lex, "No closing bracket for builder");
+	if(lex->source[op->offset] == '<') {
+		node->child = c2m_parse_literal(c2m, op, "0");
+		node->child->next = bound;
+		c2m_node_text(node, c2m_intern(c2m->intern, equal ? "[]" : "[)",
+			2), 2);
+	}else{
+		node->child = bound;
+		bound->next = c2m_parse_literal(c2m, op, "255");
+		c2m_node_text(node, c2m_intern(c2m->intern, equal ? "[]" : "(]",
+			2), 2);
+	}
+	node->type = TYPE_SET;
+	return node;
+}
+
+// "{a, b, ...}" or a builder, leaves the closing bracket to the caller.
+static c2m_node_t* c2m_parse_set(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_token_t* token)
+{
+	c2m_node_t* node;
+	c2m_node_t** tail;
+
+	if(c2m_lex_peek(lex, 1)->kind == TOKEN_IDENT &&
+		c2m_lex_match(lex, c2m_lex_peek(lex, 2), "|") == 0)
+	{
+		return c2m_parse_builder(c2m, lex, token);
+	}
+	node = c2m_parse_node(c2m, NODE_SET, token);
+	node->type = TYPE_SET;
+	tail = &node->child;
+	lex->pos++;
+	while(c2m_lex_match(lex, c2m_lex_peek(lex, 0), "}")) {
+		if(node->child && c2m_lex_expect(lex, ","))
+			c2m_parse_error(c2m, lex, "No closing bracket for set");
+		c2m_node_t* value = c2m_parse_value(c2m, lex);
+		if(value == NULL) c2m_parse_error(c2m, lex, "Unrecognized value");
+		c2m_node_append(&tail, value);
+	}
+	return node;
+}
+
+// "[a, b]", "(a, b)" ( not inclusive ) or mixed, leaves the closing bracket
+// to the caller.
+static c2m_node_t* c2m_parse_interval(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_token_t* token)
+{
+	c2m_node_t* node = c2m_parse_node(c2m, NODE_RANGE, token);
+	c2m_token_t* close;
+	char brackets[2];
+
+	lex->pos++;
+	if((node->child = c2m_parse_value(c2m, lex)) == NULL ||
+		c2m_lex_expect(lex, ",") ||
+		(node->child->next = c2m_parse_value(c2m, lex)) == NULL)
+	{
+		c2m_parse_error(c2m, lex, "Expected \"low, high\" in interval");
+	}
+	close = c2m_lex_peek(lex, 0);
+	if(c2m_lex_match(lex, close, "]") && c2m_lex_match(lex, close, ")"))
+		c2m_parse_error(c2m, lex, "No closing bracket for interval");
+	brackets[0] = lex->source[token->offset];
+	brackets[1] = lex->source[close->offset];
+	c2m_node_text(node, c2m_intern(c2m->intern, brackets, 2), 2);
+	node->type = TYPE_SET;
+	return node;
+}
+
+/*
+ * Returns NULL if not a value.
+*/
+static c2m_node_t* c2m_parse_value(c2m_t* c2m, c2m_lexer_t* lex) {
+	c2m_token_t* token = c2m_lex_peek(lex, 0);
+	c2m_node_t* node;
+
+	if(token->kind == TOKEN_STRING) {
+		node = c2m_parse_node(c2m, NODE_STRING, token);
+		c2m_node_text(node, &lex->source[token->offset + 1],
+			token->length - 2);
+		node->type = TYPE_STRING;
+	}else if(c2m_lex_match(lex, token, "TRUE") == 0) {
+		node = c2m_parse_node(c2m, NODE_BOOL, token);
+		c2m_node_text(node, "1", 1);
+		node->type = TYPE_UBYTE;
+	}else if(c2m_lex_match(lex, token, "FALSE") == 0) {
+		node = c2m_parse_node(c2m, NODE_BOOL, token);
+		c2m_node_text(node, "0", 1);
+		node->type = TYPE_UBYTE;
+	}else if(token->kind == TOKEN_NUMBER) {
+		node = c2m_parse_node(c2m, NODE_INTEGER, token);
+		c2m_node_text(node, &lex->source[token->offset], token->length);
+		node->type = c2m_parse_number_type(node);
+	}else if(c2m_lex_match(lex, token, "-") == 0 &&
+		c2m_lex_peek(lex, 1)->kind == TOKEN_NUMBER &&
+		c2m_lex_peek(lex, 1)->offset == token->offset + 1)
+	{
+		// Negative literal, "-" right before the digits.
+		node = c2m_parse_node(c2m, NODE_INTEGER, token);
+		c2m_node_text(node, &lex->source[token->offset],
+			c2m_lex_peek(lex, 1)->length + 1);
+		node->type = c2m_parse_number_type(node);
+		lex->pos++;
+	}else if(token->kind == TOKEN_IDENT &&
+		c2m_lex_match(lex, c2m_lex_peek(lex, 1), "(") == 0)
+	{
+		node = c2m_parse_construct(c2m, lex, token);
+	}else if(token->kind == TOKEN_IDENT &&
+		c2m_lex_match(lex, c2m_lex_peek(lex, 1), ".") == 0 &&
+		c2m_lex_peek(lex, 2)->kind == TOKEN_IDENT &&
+		c2m_lex_match(lex, c2m_lex_peek(lex, 3), "(") == 0)
+	{
+		// "mod.fn(args)", what a pure function returns
+		node = c2m_parse_call_args(c2m, lex);
+	}else if(token->kind == TOKEN_IDENT) {
+		node = c2m_parse_node(c2m, NODE_IDENT, token);
+		c2m_parse_name(c2m, lex, node, token);
+		// "a.b.c" & "a[i]", in any order ( "a[i].b" )
+		for(;;) {
+			if(c2m_lex_match(lex, c2m_lex_peek(lex, 1), ".") == 0 &&
+				c2m_lex_peek(lex, 2)->kind == TOKEN_IDENT)
+			{
+				c2m_node_t* field = c2m_parse_node(c2m, NODE_FIELD,
+					c2m_lex_peek(lex, 2));
+
+				c2m_parse_name(c2m, lex, field, c2m_lex_peek(lex, 2));
+				field->child = node;
+				node = field;
+				lex->pos += 2;
+				continue;
+			}
+			if(c2m_lex_match(lex, c2m_lex_peek(lex, 1), "[")) break;
+
+			c2m_node_t* index = c2m_parse_node(c2m, NODE_INDEX,
+				c2m_lex_peek(lex, 1));
+
+			lex->pos += 2;
+			index->child = node;
+			index->body = c2m_parse_value(c2m, lex);
+			if(index->body == NULL)
+				c2m_parse_error(c2m, lex, "Expected index after \"[\"");
+			if(c2m_lex_match(lex, c2m_lex_peek(lex, 0), "]"))
+				c2m_parse_error(c2m, lex, "Expected \"]\" after index");
+			node = index;
+		}
+	}else if(c2m_lex_match(lex, token, "∅") == 0) {
+		node = c2m_parse_node(c2m, NODE_SET, token);
+		node->type = TYPE_SET;
+	}else if(c2m_lex_match(lex, token, "{") == 0) {
+		node = c2m_parse_set(c2m, lex, token);
+	}else if(c2m_lex_match(lex, token, "[") == 0 ||
+		c2m_lex_match(lex, token, "(") == 0)
+	{
+		node = c2m_parse_interval(c2m, lex, token);
+	}else{
+		return NULL;
+	}
+	lex->pos++;
+	// "a ∪ b ∩ c", no precedence: the right is done first, a ∪ ( b ∩ c ).
+	if(c2m_lex_match(lex, c2m_lex_peek(lex, 0), "∪") == 0 ||
+		c2m_lex_match(lex, c2m_lex_peek(lex, 0), "∩") == 0)
+	{
+		c2m_token_t* op = c2m_lex_next(lex);
+		c2m_node_t* setop = c2m_parse_node(c2m, NODE_SETOP, op);
+
+		c2m_parse_name(c2m, lex, setop, op);
+		setop->type = TYPE_SET;
+		setop->child = node;
+		if((node->next = c2m_parse_value(c2m, lex)) == NULL)
+			c2m_parse_error(c2m, lex, "Expected a set after operator");
+		return setop;
+	}
+	if(c2m_lex_expect(lex, "+") == 0) {
+		c2m_node_t* concat = c2m_parse_node(c2m, NODE_CONCAT, token);
+		c2m_node_t* rest = c2m_parse_value(c2m, lex);
+
+		if(rest == NULL)
+			c2m_parse_error(c2m, lex, "Expected value after \"+\"");
+		concat->type = node->type;
+		concat->child = node;
+		// Flatten "a" + "b" + "c" into one list of parts.
+		node->next = rest->kind == NODE_CONCAT ? rest->child : rest;
+		return concat;
+	}
+	return node;
+}
+
+// "mod.fn(args", leaves the closing parenthesis to the caller.
+static c2m_node_t* c2m_parse_call_args(c2m_t* c2m, c2m_lexer_t* lex) {
+	c2m_token_t* module = c2m_lex_next(lex);
+
+	if(module->kind != TOKEN_IDENT || c2m_lex_expect(lex, "."))
+		c2m_error(c2m, lex, module, "no module function separator");
+	c2m_token_t* function = c2m_lex_next(lex);
+	if(function->kind != TOKEN_IDENT)
+		c2m_error(c2m, lex, function, "need a function name after module");
+
+	c2m_node_t* call = c2m_parse_node(c2m, NODE_CALL, module);
+	c2m_node_t** tail = &call->child;
+	call->module = c2m_intern(c2m->intern, &lex->source[module->offset],
+		module->length);
+	call->module_length = module->length;
+	c2m_parse_name(c2m, lex, call, function);
+	if(c2m_lex_expect(lex, "("))
+		c2m_parse_error(c2m, lex, "No opening parenthesis after function call");
+	while(c2m_lex_match(lex, c2m_lex_peek(lex, 0), ")")) {
+		if(call->child && c2m_lex_expect(lex, ","))
+			c2m_parse_error(c2m, lex, "No closing parenthesis for fn call");
+		c2m_node_t* arg = c2m_parse_value(c2m, lex);
+		if(arg == NULL) c2m_parse_error(c2m, lex, "Unrecognized value");
+		c2m_node_append(&tail, arg);
+	}
+	return call;
+}
+
+static c2m_node_t* c2m_parse_call(c2m_t* c2m, c2m_lexer_t* lex) {
+	c2m_node_t* call = c2m_parse_call_args(c2m, lex);
+
+	lex->pos++;
+	if(c2m_lex_newline(lex))
+		c2m_parse_error(c2m, lex, "Missing newline after function call");
+	return call;
+}
+
+/*
+ * "for i in [lo, hi) {", the body runs for each integer of the interval in
+ * order, or "for i in list {" for each index the list ( or main()'s args )
+ * had when the loop started.  i is an int64_t, see c2m_loop.c.  "for line in
+ * lines(name) {" runs it for each line of the file named, line a string.
+*/
+static c2m_node_t* c2m_parse_for(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_token_t* token)
+{
+	c2m_node_t* node = c2m_parse_node(c2m, NODE_FOR, token);
+
+	c2m_parse_name(c2m, lex, node, c2m_lex_peek(lex, 1));
+	lex->pos += 3;
+	if(c2m_lex_match(lex, c2m_lex_peek(lex, 0), "lines") == 0 &&
+		c2m_lex_match(lex, c2m_lex_peek(lex, 1), "(") == 0)
+	{
+		node->child = c2m_parse_node(c2m, NODE_LINES, c2m_lex_peek(lex, 0));
+		lex->pos += 2;
+		if((node->child->child = c2m_parse_value(c2m, lex)) == NULL ||
+			c2m_lex_expect(lex, ")"))
+		{
+			c2m_parse_error(c2m, lex, "Expected lines(file name)");
+		}
+	}else if((node->child = c2m_parse_value(c2m, lex)) == NULL) {
+		c2m_parse_error(c2m, lex, "Expected an interval or list to loop over");
+	}
+	if(c2m_lex_expect(lex, "{") || c2m_lex_newline(lex))
+		c2m_parse_error(c2m, lex, "Missing bracket + newline for for loop.");
+	node->body = c2m_parse_block(c2m, lex, 0);
+	return node;
+}
+
+/*
+ * "parallel for i in [0, n) {", the body runs for each integer of the
+ * interval ( i is an int64_t ) spread over the program's threads.  A
+ * reduction, "parallel for i in [0, n) reduce + total {", combines each
+ * thread's "total" into the variable once the loop's done.
+*/
+static c2m_node_t* c2m_parse_parallel(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_token_t* token)
+{
+	c2m_node_t* node = c2m_parse_node(c2m, NODE_PARALLEL, token);
+	c2m_token_t* name;
+	c2m_token_t* open;
+
+	lex->pos += 2;
+	if((name = c2m_lex_next(lex))->kind != TOKEN_IDENT)
+		c2m_error(c2m, lex, name, "Expected the loop's variable");
+	c2m_parse_name(c2m, lex, node, name);
+	if(c2m_lex_expect(lex, "in"))
+		c2m_parse_error(c2m, lex, "Expected \"in\" after the variable");
+	open = c2m_lex_peek(lex, 0);
+	if(c2m_lex_match(lex, open, "[") && c2m_lex_match(lex, open, "("))
+		c2m_parse_error(c2m, lex, "Expected an interval to loop over");
+	node->child = c2m_parse_interval(c2m, lex, open);
+	node->child->type = TYPE_SINT64;
+	lex->pos++;
+	if(c2m_lex_expect(lex, "reduce") == 0) {
+		c2m_token_t* op = c2m_lex_next(lex);
+		c2m_token_t* var = c2m_lex_next(lex);
+		c2m_node_t* reduce = c2m_parse_node(c2m, NODE_REDUCE, op);
+
+		if(c2m_lex_match(lex, op, "+") && c2m_lex_match(lex, op, "*") &&
+			c2m_lex_match(lex, op, "min") && c2m_lex_match(lex, op, "max"))
+		{
+			c2m_error(c2m, lex, op, "Expected +, *, min or max to reduce");
+		}
+		if(var->kind != TOKEN_IDENT)
+			c2m_error(c2m, lex, var, "Expected a variable to reduce into");
+		c2m_parse_name(c2m, lex, reduce, op);
+		reduce->child = c2m_parse_node(c2m, NODE_IDENT, var);
+		c2m_parse_name(c2m, lex, reduce->child, var);
+		node->child->next = reduce;
+	}
+	if(c2m_lex_expect(lex, "{") || c2m_lex_newline(lex)) {
+		c2m_parse_error(c2m, lex,
+			"Missing bracket + newline for parallel loop.");
+	}
+	node->body = c2m_parse_block(c2m, lex, 0);
+	return node;
+}
+
+/*
+ * "await mod.fn(args)" waits for an async function to return, "await
+ * readable fd" ( or writable ) for a file descriptor, a C expression up to
+ * the end of the line.
+*/
+static c2m_node_t* c2m_parse_await(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_token_t* token)
+{
+	c2m_node_t* node = c2m_parse_node(c2m, NODE_AWAIT, token);
+	c2m_token_t* what = c2m_lex_peek(lex, 1);
+	c2m_token_t* first;
+	c2m_token_t* last;
+
+	lex->pos++;
+	if((c2m_lex_match(lex, what, "readable") &&
+		c2m_lex_match(lex, what, "writable")) ||
+		c2m_lex_match(lex, c2m_lex_peek(lex, 1), ".") == 0)
+	{
+		node->child = c2m_parse_call(c2m, lex);
+		return node;
+	}
+	lex->pos++;
+	c2m_parse_name(c2m, lex, node, what);
+	first = c2m_lex_peek(lex, 0);
+	if(first->kind == TOKEN_NEWLINE || first->kind == TOKEN_EOF)
+		c2m_error(c2m, lex, what, "Expected a file descriptor to wait on");
+	do {
+		last = c2m_lex_next(lex);
+	} while(c2m_lex_peek(lex, 0)->kind != TOKEN_NEWLINE &&
+		c2m_lex_peek(lex, 0)->kind != TOKEN_EOF);
+	node->child = c2m_parse_node(c2m, NODE_RAW, first);
+	c2m_node_text(node->child, &lex->source[first->offset],
+		last->offset + last->length - first->offset);
+	if(c2m_lex_newline(lex))
+		c2m_parse_error(c2m, lex, "Missing newline after await");
+	return node;
+}
+
+// Parse one statement, returns NULL for blank lines.
+// "Record[] name", an empty collection of the record ( see c2m_record.c ).
+static c2m_node_t* c2m_parse_rows(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_token_t* token)
+{
+	c2m_symbol_t* type = c2m_parse_type(c2m, lex, token);
+	c2m_token_t* name = c2m_lex_peek(lex, 3);
+	c2m_node_t* node;
+
+	if(type == NULL || type->type != TYPE_RECORD)
+		c2m_error(c2m, lex, token, "Not a record");
+	lex->pos += 4;
+	node = c2m_parse_node(c2m, NODE_DECLARE, token);
+	node->type = TYPE_ROWS;
+	node->record = type->data;
+	node->child = c2m_parse_node(c2m, NODE_IDENT, name);
+	c2m_parse_name(c2m, lex, node->child, name);
+	node->child->type = TYPE_ROWS;
+	if(c2m_lex_newline(lex))
+		c2m_parse_error(c2m, lex, "Missing newline after declaration");
+	return node;
+}
+
+// "push(name, value)", a record added to the end of a collection.
+static c2m_node_t* c2m_parse_push(c2m_t* c2m, c2m_lexer_t* lex,
+	c2m_token_t* token)
+{
+	c2m_node_t* node = c2m_parse_node(c2m, NODE_PUSH, token);
+
+	lex->pos += 2;
+	node->child = c2m_parse_value(c2m, lex);
+	if(node->child == NULL || c2m_lex_expect(lex, ","))
+		c2m_parse_error(c2m, lex, "Expected push(collection, value)");
+	node->body = c2m_parse_value(c2m, lex);
+	if(node->body == NULL || c2m_lex_expect(lex, ")"))
+		c2m_parse_error(c2m, lex, "Expected push(collection, value)");
+	if(c2m_lex_newline(lex))
+		c2m_parse_error(c2m, lex, "Missing newline after push");
+	return node;
+}
+
+static c2m_node_t* c2m_parse_statement(c2m_t* c2m, c2m_lexer_t* lex) {
+	c2m_token_t* token = c2m_lex_peek(lex, 0);
+	c2m_token_t* after = c2m_lex_peek(lex, 1);
+	c2m_symbol_t* type;
+	c2m_node_t* node;
+
+	if(c2m_lex_match(lex, token, "while") == 0) {
+		lex->pos++;
+		if(c2m_lex_expect(lex, "{") || c2m_lex_newline(lex)) {
+			c2m_parse_error(c2m, lex,
+				"Missing bracket + newline for while loop.");
+		}
+		node = c2m_parse_node(c2m, NODE_WHILE, token);
+		node->body = c2m_parse_block(c2m, lex, 0);
+	}else if(c2m_lex_match(lex, token, "for") == 0 &&
+		after->kind == TOKEN_IDENT &&
+		c2m_lex_match(lex, c2m_lex_peek(lex, 2), "in") == 0)
+	{
+		node = c2m_parse_for(c2m, lex, token);
+	}else if(c2m_lex_match(lex, token, "parallel") == 0 &&
+		c2m_lex_match(lex, after, "for") == 0)
+	{
+		node = c2m_parse_parallel(c2m, lex, token);
+	}else if(c2m_lex_match(lex, token, "await") == 0) {
+		node = c2m_parse_await(c2m, lex, token);
+	}else if(c2m_lex_match(lex, token, "exit") == 0 &&
+		after->kind == TOKEN_NEWLINE)
+	{
+		lex->pos += 2;
+		node = c2m_parse_node(c2m, NODE_EXIT, token);
+	}else if(c2m_lex_match(lex, token, "fail") == 0 &&
+		after->kind == TOKEN_NEWLINE)
+	{
+		lex->pos += 2;
+		node = c2m_parse_node(c2m, NODE_FAIL, token);
+	}else if(c2m_lex_newline(lex) == 0) {
+		node = NULL;
+	}else if(token->kind == TOKEN_IDENT &&
+		c2m_lex_match(lex, after, "[") == 0 &&
+		c2m_lex_match(lex, c2m_lex_peek(lex, 2), "]") == 0 &&
+		c2m_lex_peek(lex, 3)->kind == TOKEN_IDENT)
+	{
+		node = c2m_parse_rows(c2m, lex, token);
+	}else if(token->kind == TOKEN_IDENT && after->kind == TOKEN_IDENT &&
+		(type = c2m_parse_type(c2m, lex, token)))
+	{
+		// "Type name" or "Type name = value"
+		lex->pos += 2;
+		node = c2m_parse_node(c2m, NODE_DECLARE, token);
+		node->type = type->type;
+		node->record = type->data;
+		node->child = c2m_parse_node(c2m, NODE_IDENT, after);
+		c2m_parse_name(c2m, lex, node->child, after);
+		node->child->type = node->type;
+		if(c2m_lex_expect(lex, "=") == 0) {
+			node->body = c2m_parse_value(c2m, lex);
+			if(node->body == NULL) {
+				c2m_parse_error(c2m, lex,
+					"Expected value after \"=\"");
+			}
+		}
+		c2m_lex_expect(lex, ";"); // Still allowed from when this was C
+		if(c2m_lex_newline(lex)) {
+			c2m_parse_error(c2m, lex,
+				"Missing newline after declaration");
+		}
+	}else{
+		// check for C function call
+		c2m_token_t* end = c2m_lex_find(lex, ";");
+
+		if(end == NULL && c2m_lex_match(lex, token, "push") == 0 &&
+			c2m_lex_match(lex, after, "(") == 0)
+		{
+			return c2m_parse_push(c2m, lex, token);
+		}
+		if(end == NULL) {
+			// C-- function call
+			return c2m_parse_call(c2m, lex);
+		}
+
+		node = c2m_parse_node(c2m, NODE_RAW, token);
+		c2m_node_text(node, &lex->source[token->offset],
+			end->offset - token->offset);
+		lex->pos = end - (c2m_token_t*)lex->tokens->store + 1;
+		if(c2m_lex_newline(lex)) {
+			c2m_parse_error(c2m, lex,
+				"Missing newline for c function call");
+		}
+	}
+	return node;
+}
+
+// Skip a failed statement: the rest of the line from `start` & any block it
+// opened ( its "{" ... "}" ).
+static void c2m_parse_skip(c2m_lexer_t* lex, uint32_t start) {
+	uint32_t depth = 0;
+	c2m_token_t* token;
+
+	lex->pos = start;
+	do {
+		while((token = c2m_lex_next(lex))->kind != TOKEN_NEWLINE &&
+			token->kind != TOKEN_EOF)
+		{
+			if(c2m_lex_match(lex, token, "{") == 0) depth++;
+			else if(depth && c2m_lex_match(lex, token, "}") == 0) depth--;
+		}
+	} while(depth && token->kind != TOKEN_EOF);
+}
+
+// Parse a statement, one with an error is recorded & skipped ( NULL ).
+static c2m_node_t* c2m_parse_next(c2m_t* c2m, c2m_lexer_t* lex) {
+	jmp_buf* outer = c2m->recover;
+	uint32_t start = lex->pos;
+	c2m_node_t* node;
+	jmp_buf jump;
+
+	c2m->recover = &jump;
+	if(setjmp(jump) == 0) {
+		node = c2m_parse_statement(c2m, lex);
+	}else{
+		c2m_parse_skip(lex, start);
+		node = NULL;
+	}
+	c2m->recover = outer;
+	return node;
+}
+
+// Parse statements up to and including the closing bracket.
+static c2m_node_t* c2m_parse_block(c2m_t* c2m, c2m_lexer_t* lex,
+	uint8_t is_main)
+{
+	c2m_node_t* first = NULL;
+	c2m_node_t** tail = &first;
+
+	while(1) {
+		c2m_token_t* token = c2m_lex_peek(lex, 0);
+
+		if(token->kind == TOKEN_EOF) {
+			c2m_error(c2m, lex, token, "Missing closing bracket");
+		}else if(is_main &&
+			(c2m_lex_match(lex, token, "exit") == 0 ||
+			c2m_lex_match(lex, token, "fail") == 0) &&
+			c2m_lex_peek(lex, 1)->kind == TOKEN_NEWLINE &&
+			c2m_lex_match(lex, c2m_lex_peek(lex, 2), "}") == 0)
+		{
+			// Last statement of main becomes the return value.
+			if(c2m_lex_match(lex, token, "fail") == 0)
+				c2m->return_success = 0;
+			lex->pos += 3;
+			return first;
+		}else if(c2m_lex_expect(lex, "}") == 0) {
+			return first;
+		}else{
+			c2m_node_t* node = c2m_parse_next(c2m, lex);
+			if(node) c2m_node_append(&tail, node);
+		}
+	}
+}
+
+static c2m_node_t* c2m_parse_params(c2m_t* c2m, c2m_lexer_t* lex) {
+	c2m_node_t* first = NULL;
+	c2m_node_t** tail = &first;
+
+	while(c2m_lex_expect(lex, ")")) {
+		if(first && c2m_lex_expect(lex, ","))
+			c2m_parse_error(c2m, lex, "closing parenthesis missing");
+		c2m_token_t* token = c2m_lex_next(lex);
+		c2m_symbol_t* type = token->kind == TOKEN_IDENT ?
+			c2m_parse_type(c2m, lex, token) : NULL;
+		if(type == NULL) c2m_error(c2m, lex, token, "Unknown type");
+		c2m_token_t* name = c2m_lex_next(lex);
+		if(name->kind != TOKEN_IDENT)
+			c2m_error(c2m, lex, name, "Expected parameter name");
+		c2m_node_t* param = c2m_parse_node(c2m, NODE_PARAM, name);
+		c2m_parse_name(c2m, lex, param, name);
+		param->type = type->type;
+		param->record = type->data;
+		param->indirect = type->type == TYPE_LIST ||
+			(type->type == TYPE_RECORD &&
+			c2m_record_indirect(param->record));
+		c2m_node_append(&tail, param);
+	}
+	return first;
+}
+
+// The library names are a perfect hash, see c2m_import_gen.c
+static void c2m_parse_import(c2m_t* c2m, c2m_lexer_t* lex) {
+	c2m_token_t* library = c2m_lex_next(lex);
+	uint32_t slot = library->kind == TOKEN_IDENT ? cl_phash_get_bytes(
+		&c2m_import_table, &lex->source[library->offset],
+		library->length) : c2m_import_table.n_keys;
+
+	if(slot == c2m_import_table.n_keys) {
+		c2m_error(c2m, lex, library, "unknown import");
+	}else{
+		((uint8_t*)&c2m->libreq)[c2m_import_field[slot]] = 1;
+		// agg's runtime works on lists, on the parallel loops' pool.
+		if(c2m->libreq.agg) c2m->libreq.list = c2m->libreq.par = 1;
+	}
+}
+
+/*
+ * "-> type {", a pure function: its body is only the value it returns, on a
+ * line of its own ( see c2m_eval.c ).
+*/
+static c2m_node_t* c2m_parse_return(c2m_t* c2m, c2m_lexer_t* lex) {
+	c2m_token_t* token;
+	c2m_symbol_t* type;
+	c2m_node_t* node;
+
+	if(c2m_lex_expect(lex, ">"))
+		c2m_parse_error(c2m, lex, "Expected \"->\" before the return type");
+	token = c2m_lex_next(lex);
+	type = token->kind == TOKEN_IDENT ? c2m_parse_type(c2m, lex, token) : NULL;
+	if(type == NULL) c2m_error(c2m, lex, token, "Unknown type");
+	if(type->type == TYPE_LIST || type->type == TYPE_ARGS)
+		c2m_error(c2m, lex, token, "A list can't be returned");
+	node = c2m_parse_node(c2m, NODE_RETURN, token);
+	node->type = type->type;
+	node->record = type->data;
+	if(c2m_lex_expect(lex, "{") || c2m_lex_newline(lex))
+		c2m_parse_error(c2m, lex, "Expected \"{\\n\" after return type");
+	while(c2m_lex_newline(lex) == 0);
+	if((node->child = c2m_parse_value(c2m, lex)) == NULL)
+		c2m_parse_error(c2m, lex, "Expected the value returned");
+	if(c2m_lex_newline(lex))
+		c2m_parse_error(c2m, lex, "Missing newline after value");
+	while(c2m_lex_newline(lex) == 0);
+	if(c2m_lex_expect(lex, "}"))
+		c2m_parse_error(c2m, lex, "A pure function only has its value");
+	return node;
+}
+
+// Parse a library function of module `mod`, the next token is its name (
+// or "trace", see c2m_trace.c, or "async", see c2m_async.c ).
+static c2m_node_t* c2m_parse_function(c2m_t* c2m, c2m_lexer_t* lex,
+	const char* mod)
+{
+	c2m_token_t* token = c2m_lex_peek(lex, 0);
+	uint8_t traced = c2m_lex_match(lex, token, "trace") == 0 &&
+		c2m_lex_peek(lex, 1)->kind == TOKEN_IDENT;
+	uint8_t async;
+
+	if(traced) {
+		lex->pos++;
+		token = c2m_lex_peek(lex, 0);
+	}
+	async = c2m_lex_match(lex, token, "async") == 0 &&
+		c2m_lex_peek(lex, 1)->kind == TOKEN_IDENT;
+	if(async && traced) c2m_error(c2m, lex, token, "async can't be traced");
+	if(async) {
+		lex->pos++;
+		token = c2m_lex_peek(lex, 0);
+	}
+
+	if(token->kind != TOKEN_IDENT || c2m_lex_match(
+		lex, c2m_lex_peek(lex, 1), "("))
+	{
+		c2m_error(c2m, lex, token, "opening parenthesis missing");
+	}
+	lex->pos += 2;
+
+	c2m_node_t* fn = c2m_parse_node(c2m, NODE_FUNCTION, token);
+	fn->module = mod;
+	fn->module_length = strlen(mod);
+	fn->indirect = async;
+	fn->traced = traced;
+	if(traced) c2m->libreq.trace = 1;
+	c2m_parse_name(c2m, lex, fn, token);
+	fn->child = c2m_parse_params(c2m, lex);
+	if(c2m_lex_expect(lex, "-") == 0) {
+		if(async || traced) {
+			c2m_error(c2m, lex, token,
+				"A pure function can't be async or traced");
+		}
+		fn->body = c2m_parse_return(c2m, lex);
+		return fn;
+	}
+	if(c2m_lex_expect(lex, "{") || c2m_lex_newline(lex))
+		c2m_parse_error(c2m, lex, "Expected \"{\\n\" after parameters");
+	fn->body = c2m_parse_block(c2m, lex, 0);
+	return fn;
+}
+
+// Skip a failed top level definition ( starting at `start` ) up to the next
+// one: a line starting with "name(", "trace", "async", "import" or "bench" in
+// the first column.
+static void c2m_parse_resync(c2m_lexer_t* lex, uint32_t start) {
+	lex->pos = start;
+	c2m_lex_skip_line(lex);
+	while(1) {
+		c2m_token_t* token = c2m_lex_peek(lex, 0);
+
+		if(token->kind == TOKEN_EOF) return;
+		if(token->kind == TOKEN_IDENT && (token->offset == 0 ||
+			lex->source[token->offset - 1] == '\n') &&
+			(c2m_lex_match(lex, c2m_lex_peek(lex, 1), "(") == 0 ||
+			c2m_lex_match(lex, token, "trace") == 0 ||
+			c2m_lex_match(lex, token, "async") == 0 ||
+			c2m_lex_match(lex, token, "import") == 0 ||
+			c2m_lex_match(lex, token, "bench") == 0))
+		{
+			return;
+		}
+		c2m_lex_skip_line(lex);
+	}
+}
+
+/*
+ * Parse every function of a library module into the `functions` table.
+*/
+static void c2m_parse_module(c2m_t* c2m, c2m_lexer_t* lex, const char* mod,
+	c2m_symtab_t* functions)
+{
+	jmp_buf* outer = c2m->recover;
+	jmp_buf jump;
+
+	c2m->recover = &jump;
+	while(c2m_lex_peek(lex, 0)->kind != TOKEN_EOF) {
+		uint32_t start = lex->pos;
+
+		if(setjmp(jump)) {
+			c2m_parse_resync(lex, start);
+			continue;
+		}
+		if(c2m_lex_expect(lex, "import") == 0) {
+			c2m_parse_import(c2m, lex);
+			continue;
+		}
+		if(c2m_lex_newline(lex) == 0) continue;
+
+		c2m_node_t* fn = c2m_parse_function(c2m, lex, mod);
+
+		if(c2m_symtab_get(functions, fn->text)) {
+			c2m_diag_node(c2m, fn, "function defined twice");
+			continue;
+		}
+		c2m_symtab_add(functions, fn->text, SYMBOL_FUNCTION, 0, fn);
+	}
+	c2m->recover = outer;
+}
+
+/*
+ * "Name( Type field ... )", fields are separated by commas or newlines.
+ * Records are only defined in the main file, before any module is parsed, so
+ * the type table doesn't change while modules are parsed in parallel.
+*/
+static c2m_node_t* c2m_parse_record(c2m_t* c2m, c2m_lexer_t* lex) {
+	c2m_token_t* token = c2m_lex_next(lex);
+	c2m_node_t* record = c2m_parse_node(c2m, NODE_RECORD, token);
+	c2m_node_t** tail = &record->child;
+
+	lex->pos++;
+	c2m_parse_name(c2m, lex, record, token);
+	if(c2m_symtab_get(c2m->types, record->text))
+		c2m_error(c2m, lex, token, "type defined twice");
+	while(c2m_lex_expect(lex, ")")) {
+		if(c2m_lex_newline(lex) == 0 || c2m_lex_expect(lex, ",") == 0)
+			continue;
+
+		c2m_token_t* type_name = c2m_lex_next(lex);
+		c2m_symbol_t* type = type_name->kind == TOKEN_IDENT ?
+			c2m_parse_type(c2m, lex, type_name) : NULL;
+		c2m_token_t* name = c2m_lex_next(lex);
+
+		if(type == NULL || name->kind != TOKEN_IDENT) {
+			c2m_error(c2m, lex, type_name,
+				"Expected \"Type name\" in record");
+		}
+		c2m_node_t* field = c2m_parse_node(c2m, NODE_PARAM, name);
+		c2m_parse_name(c2m, lex, field, name);
+		if(c2m_record_field(record, field->text)) {
+			// The first one stands, the record is still usable.
+			c2m_diag(c2m, name->line, c2m_diag_column(lex, name),
+				"field defined twice", field->text, field->length);
+			continue;
+		}
+		field->type = type->type;
+		field->record = type->data;
+		c2m_node_append(&tail, field);
+	}
+	if(record->child == NULL)
+		c2m_error(c2m, lex, token, "record without fields");
+	c2m_symtab_add(c2m->types, record->text, SYMBOL_TYPE, TYPE_RECORD,
+		record);
+	tail = &c2m->records;
+	while(*tail) tail = &(*tail)->next;
+	c2m_node_append(&tail, record);
+	return record;
+}
+
+// "bench name {", statements timed by --bench ( see c2m_bench.c ).
+static c2m_node_t* c2m_parse_bench(c2m_t* c2m, c2m_lexer_t* lex) {
+	c2m_node_t* bench = c2m_parse_node(c2m, NODE_BENCH, c2m_lex_next(lex));
+
+	c2m_parse_name(c2m, lex, bench, c2m_lex_next(lex));
+	if(c2m_lex_expect(lex, "{") || c2m_lex_newline(lex))
+		c2m_parse_error(c2m, lex, "Expected \"{\\n\" after the bench's name");
+	bench->body = c2m_parse_block(c2m, lex, 0);
+	return bench;
+}
+
+/*
+ * Parse the program's main file, returns the main function.  With --bench its
+ * body is the benches instead, in the order written.
+*/
+static c2m_node_t* c2m_parse_main(c2m_t* c2m, c2m_lexer_t* lex) {
+	c2m_node_t* volatile main_fn = NULL;
+	c2m_node_t* volatile benches = NULL;
+	volatile uint8_t seen_main = 0; // Even if its header had errors
+	jmp_buf* outer = c2m->recover;
+	jmp_buf jump;
+
+	c2m->recover = &jump;
+	while(c2m_lex_peek(lex, 0)->kind != TOKEN_EOF) {
+		c2m_token_t* token = c2m_lex_peek(lex, 0);
+		uint32_t start = lex->pos;
+
+		if(setjmp(jump)) {
+			c2m_parse_resync(lex, start);
+			continue;
+		}
+		if(c2m_lex_newline(lex) == 0) {
+		}else if(seen_main == 0 && c2m_lex_expect(lex, "main") == 0) {
+			c2m_token_t* args;
+
+			seen_main = 1;
+			if(c2m_lex_expect(lex, "(")) {
+				c2m_parse_error(c2m, lex,
+					"Expected \"(\" after \"main\"");
+			}
+			args = c2m_lex_peek(lex, 1);
+			if(c2m_lex_expect(lex, "list_t") ||
+				c2m_lex_expect(lex, "args"))
+			{
+				c2m_parse_error(c2m, lex,
+					"Expected \"list_t args\" after \"main(\"");
+			}
+			if(c2m_lex_expect(lex, ")")) {
+				c2m_parse_error(c2m, lex,
+					"Expected \")\" after \"list_t args\"");
+			}
+			if(c2m_lex_expect(lex, "{") || c2m_lex_newline(lex)) {
+				c2m_parse_error(c2m, lex,
+					"Expected \"{\\n\" after \")\"");
+			}
+			main_fn = c2m_parse_node(c2m, NODE_FUNCTION, token);
+			c2m_node_text(main_fn, "main", 4);
+			main_fn->child = c2m_parse_node(c2m, NODE_PARAM, args);
+			c2m_parse_name(c2m, lex, main_fn->child, args);
+			main_fn->child->type = TYPE_ARGS;
+			main_fn->body = c2m_chunk_parse_main(c2m, lex);
+		}else if(c2m_lex_match(lex, token, "bench") == 0 &&
+			c2m_lex_peek(lex, 1)->kind == TOKEN_IDENT)
+		{
+			c2m_node_t* bench = c2m_parse_bench(c2m, lex);
+			c2m_node_t* last = benches;
+
+			if(c2m->bench == 0) continue; // Parsed for its errors only
+			while(last && last->next) last = last->next;
+			if(last) last->next = bench;
+			else benches = bench;
+		}else if(c2m_lex_match(lex, token, "soa") == 0 &&
+			c2m_lex_peek(lex, 1)->kind == TOKEN_IDENT &&
+			c2m_lex_match(lex, c2m_lex_peek(lex, 2), "(") == 0)
+		{
+			// Its collections are laid out an array per field.
+			lex->pos++;
+			c2m_parse_record(c2m, lex)->indirect = C2M_RECORD_SOA;
+		}else if(token->kind == TOKEN_IDENT && c2m_lex_match(lex,
+			c2m_lex_peek(lex, 1), "(") == 0)
+		{
+			c2m_parse_record(c2m, lex);
+		}else{
+			c2m_error(c2m, lex, token, "Unable to process text");
+		}
+	}
+	c2m->recover = outer;
+	if(seen_main == 0)
+		c2m_error(c2m, lex, c2m_lex_peek(lex, 0), "No main function");
+	// Only its header had errors, nothing to resolve
+	if(main_fn == NULL) c2m_diag_check(c2m);
+	if(c2m->bench) {
+		if(benches == NULL)
+			c2m_error(c2m, lex, c2m_lex_peek(lex, 0), "No bench to run");
+		main_fn->body = benches;
+		c2m->return_success = 1;
+	}
+	return main_fn;
+}
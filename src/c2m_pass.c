@@ -0,0 +1,109 @@
+// Pass pipeline: passes run in order over the syntax tree between parsing
+// and emitting.  Register new ones with c2m_pass_add().
+
+typedef void (c2m_pass_fn)(c2m_t* c2m);
+
+typedef struct{
+	const char* name;
+	c2m_pass_fn* run;
+}c2m_pass_t;
+
+static void c2m_pass_add(c2m_t* c2m, const char* name, c2m_pass_fn* run) {
+	c2m_pass_t* pass = cl_array_add(c2m->passes);
+
+	pass->name = name;
+	pass->run = run;
+}
+
+static void c2m_pass_run_all(c2m_t* c2m) {
+	for(uint32_t i = 0; i < cl_array_count(c2m->passes); i++) {
+		c2m_pass_t* pass = cl_array_borrow(c2m->passes, i);
+
+		c2m_trace_begin(pass->name);
+		pass->run(c2m);
+		c2m_trace_end();
+	}
+}
+
+// Call `cb` on every node of every function in the program.
+static void c2m_pass_walk(c2m_t* c2m, c2m_walk_cb* cb) {
+	c2m_node_walk(c2m->main_fn, cb, c2m);
+	c2m_node_walk(c2m->imported, cb, c2m);
+}
+
+// Returns 1 if raw C directly in the loop `body` could break out of it.
+static uint8_t c2m_pass_may_break(c2m_node_t* body) {
+	for(; body; body = body->next)
+		if(body->kind == NODE_RAW) return 1;
+	return 0;
+}
+
+/*
+ * Dead code: drop statements that can't run, those after exit, fail or a
+ * while loop ( loops only end by exiting, or a C break ) in the same block.
+ * Returns how many were dropped.
+*/
+static uint32_t c2m_pass_prune(c2m_node_t* block) {
+	uint32_t dropped = 0;
+
+	for(c2m_node_t* node = block; node; node = node->next) {
+		if(node->kind == NODE_WHILE) {
+			dropped += c2m_pass_prune(node->body);
+			if(c2m_pass_may_break(node->body)) continue;
+		}else if(node->kind == NODE_PARALLEL || node->kind == NODE_BENCH ||
+			node->kind == NODE_FOR)
+		{
+			dropped += c2m_pass_prune(node->body);
+			continue;
+		}else if(node->kind != NODE_EXIT && node->kind != NODE_FAIL) {
+			continue;
+		}
+		for(c2m_node_t* dead = node->next; dead; dead = dead->next)
+			dropped++;
+		node->next = NULL;
+	}
+	return dropped;
+}
+
+// Work out which C headers the generated code needs.
+static void c2m_pass_libreq_node(c2m_node_t* node, void* data) {
+	c2m_t* c2m = data;
+
+	if(node->kind == NODE_EXIT || node->kind == NODE_FAIL)
+		c2m->libreq.stdlib = 1;
+	if(node->type == TYPE_LIST) c2m->libreq.list = 1;
+	if(node->type == TYPE_SET) c2m->libreq.set = 1;
+	if(node->type == TYPE_ROWS) // realloc(), & the message for an index
+		c2m->libreq.stdlib = c2m->libreq.stdio = 1;
+	if(node->kind == NODE_PARALLEL) c2m->libreq.par = 1;
+	if(node->kind == NODE_FUNCTION && node->indirect) c2m->libreq.co = 1;
+	if(node->kind == NODE_BENCH) c2m->libreq.bench = 1;
+	if(node->kind == NODE_LINES) c2m->libreq.lines = 1;
+}
+
+static void c2m_pass_libreq(c2m_t* c2m) {
+	c2m_pass_walk(c2m, c2m_pass_libreq_node);
+	c2m_node_walk(c2m->records, c2m_pass_libreq_node, c2m);
+	// Started from main(), a library's left to the program loading it.
+	if(c2m->profile && c2m->exports == NULL) c2m->libreq.profile = 1;
+}
+
+// c2m_fold.c, c2m_parallel.c, c2m_async.c, c2m_escape.c, c2m_loop.c &
+// c2m_inline.c, included once the modules are.
+static void c2m_fold(c2m_t* c2m);
+static void c2m_parallel(c2m_t* c2m);
+static void c2m_async(c2m_t* c2m);
+static void c2m_escape(c2m_t* c2m);
+static void c2m_loop(c2m_t* c2m);
+static void c2m_inline(c2m_t* c2m);
+
+static void c2m_pass_init(c2m_t* c2m) {
+	c2m->passes = cl_array_create(sizeof(c2m_pass_t), 8);
+	c2m_pass_add(c2m, "fold", c2m_fold);
+	c2m_pass_add(c2m, "parallel", c2m_parallel);
+	c2m_pass_add(c2m, "async", c2m_async);
+	c2m_pass_add(c2m, "escape", c2m_escape);
+	c2m_pass_add(c2m, "loop", c2m_loop);
+	c2m_pass_add(c2m, "libreq", c2m_pass_libreq);
+	c2m_pass_add(c2m, "inline", c2m_inline);
+}
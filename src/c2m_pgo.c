@@ -0,0 +1,116 @@
+// Profile guided builds.  --pgo-generate builds with clang's instrumentation,
+// which writes a raw profile to .c2m-cache/pgo/ each time the binary runs.
+// With a `pgo_train` command in c2m.config the training is run right away:
+// the raw profiles are merged with llvm-profdata into
+// .c2m-cache/pgo/<name>.profdata & the program's built again with it.
+// --pgo-use <profile> builds with a profile from an earlier training, a raw
+// one is merged first.  The profile is a build cache input, a new one
+// rebuilds.
+
+#define C2M_PGO_DIR C2M_CACHE_DIR "/pgo"
+
+enum {
+	C2M_PGO_OFF,
+	C2M_PGO_GENERATE,
+	C2M_PGO_USE,
+};
+
+/*
+ * Merge the raw profiles `raw` ( may be a shell glob ) into `profdata`.
+ * Returns 1 if llvm-profdata failed.
+*/
+static uint8_t c2m_pgo_merge(const char* raw, const char* profdata) {
+	struct cl_array* command = c2m_string_create(NULL);
+	uint8_t failed;
+
+	c2m_string_appendf(command, "llvm-profdata merge -output=%s %s",
+		profdata, raw);
+	fflush(stdout);
+	failed = system(command->store) != 0;
+	c2m_string_destroy(command);
+	return failed;
+}
+
+// Work out the C compiler flag for the build ( c2m->pgo_flag ).
+static void c2m_pgo_prepare(c2m_t* c2m) {
+	struct cl_array* flag = c2m_string_create(NULL);
+	const char* profile = c2m->pgo_profile;
+	size_t length = profile ? strlen(profile) : 0;
+	c2m_source_t source;
+
+	if(c2m->pgo == C2M_PGO_OFF) {
+		c2m_string_destroy(flag);
+		return;
+	}
+	mkdir(C2M_CACHE_DIR, 0755);
+	mkdir(C2M_PGO_DIR, 0755);
+	if(c2m->pgo == C2M_PGO_GENERATE) {
+		// %p: a profile per process, so parallel training runs don't clash.
+		c2m_string_append(flag,
+			"-fprofile-instr-generate=" C2M_PGO_DIR "/%p.profraw");
+	}else{
+		if(length < 9 || strcmp(&profile[length - 9], ".profdata")) {
+			struct cl_array* merged = c2m_string_create(NULL);
+
+			c2m_string_appendf(merged, C2M_PGO_DIR "/%s.profdata",
+				c2m->name);
+			if(c2m_pgo_merge(profile, merged->store))
+				c2m_abort("couldn't merge profile");
+			profile = c2m_arena_strndup(c2m->arena, merged->store,
+				c2m_string_length(merged));
+			c2m_string_destroy(merged);
+		}
+		if(c2m_source_open(&source, profile)) c2m_abort("No such profile");
+		c2m_cache_input(c2m, profile, source.data, source.size);
+		// Same C & flags with another profile is another binary.
+		c2m->pgo_hash = c2m_hash(C2M_HASH_INIT, source.data, source.size);
+		c2m->output_hash = c2m_hash(c2m->output_hash, &c2m->pgo_hash,
+			sizeof(uint64_t));
+		c2m_source_close(&source);
+		c2m_string_appendf(flag, "-fprofile-instr-use=%s", profile);
+	}
+	c2m->pgo_flag = c2m_arena_strndup(c2m->arena, flag->store,
+		c2m_string_length(flag));
+	c2m_string_destroy(flag);
+}
+
+/*
+ * --pgo-generate with a training command: build instrumented, train, merge,
+ * then build again with the profile.
+*/
+static void c2m_pgo_build(c2m_t* options) {
+	c2m_t* c2m = malloc(sizeof(c2m_t));
+	struct cl_array* profdata = c2m_string_create(NULL);
+	char* profile;
+
+	c2m_batch_init(c2m, options, NULL);
+	c2m->pgo = C2M_PGO_GENERATE;
+	c2m_gconfig(c2m);
+	c2m_compile(c2m);
+	if(c2m->pgo_train == NULL) {
+		printf("Instrumented, run %s & build with --pgo-use\n", c2m->name);
+		c2m_release(c2m);
+		free(c2m);
+		c2m_string_destroy(profdata);
+		return;
+	}
+	// Old runs' profiles would be merged in too.
+	system("rm -f " C2M_PGO_DIR "/*.profraw");
+	printf("Training: %s\n", c2m->pgo_train);
+	fflush(stdout);
+	if(system(c2m->pgo_train)) c2m_abort("Training command failed");
+	c2m_string_appendf(profdata, C2M_PGO_DIR "/%s.profdata", c2m->name);
+	if(c2m_pgo_merge(C2M_PGO_DIR "/*.profraw", profdata->store))
+		c2m_abort("couldn't merge profile");
+	profile = strdup(profdata->store);
+	c2m_release(c2m);
+	c2m_batch_init(c2m, options, NULL);
+	c2m->pgo = C2M_PGO_USE;
+	c2m->pgo_profile = profile;
+	c2m_gconfig(c2m);
+	c2m_compile(c2m);
+	c2m_release(c2m);
+	free(c2m);
+	free(profile);
+	c2m_string_destroy(profdata);
+}
@@ -0,0 +1,869 @@
+// Preludes: the C headers selected by c2m->libreq.  With --prelude each
+// combination is written once to .c2m-cache/prelude-<hash>.h & precompiled
+// next to it, the C compiler is then given "-include" so it loads the
+// precompiled header instead of parsing the headers again.  main.c keeps its
+// includes, guarded with C2M_PRELUDE, so it still builds on its own.
+
+// Where the runtimes included as "<c2m_*.c>" are ( c2m_trace.c, c2m_profile.c
+// & c2m_clump.c ), given to the C compiler with -I.  The Makefile sets it to
+// the src/ directory of the tree it builds, "make install" copies them here.
+#ifndef C2M_RUNTIME_DIR
+#define C2M_RUNTIME_DIR "/usr/local/share/c2m/src"
+#endif
+
+// Strings carry their length, literals get it from sizeof.  The bytes are
+// NUL terminated as well, for C functions ( p is NULL in a zeroed record ).
+static const char c2m_prelude_string[] =
+	"#include <stddef.h>\n"
+	"typedef struct{ const char* p; size_t n; }c2m_str_t;\n"
+	"#define C2M_STR(s) ((c2m_str_t){ s, sizeof(s) - 1 })\n";
+
+// Hints for the C compiler: one-statement library functions are always
+// inlined, `fail` is a call to a cold function that doesn't return so the
+// paths leading to it are laid out of the way.
+static const char c2m_prelude_hints[] =
+	"#if defined(__GNUC__) || defined(__clang__)\n"
+	"#define C2M_INLINE inline __attribute__((always_inline))\n"
+	"#define C2M_COLD __attribute__((cold, noreturn))\n"
+	"#else\n"
+	"#define C2M_INLINE inline\n"
+	"#define C2M_COLD\n"
+	"#endif\n";
+
+static const char c2m_prelude_fail[] =
+	"static C2M_COLD void c2m_fail(void){ exit(1); }\n";
+
+// Numbers to decimal for runtime string concatenation, each writes at p (
+// into the room c2m_emit_concat() sized for it ) & returns the end.  Integers
+// go two digits at a time.  Floats get `sig` significant digits ( FLT_DIG or
+// DBL_DIG ) without trailing zeros, fixed point unless that would be long.
+static const char c2m_prelude_concat[] =
+	"#include <stdio.h>\n"
+	"static const char c2m_cat_pairs[200] =\n"
+	"\"0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849\"\n"
+	"\"5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899\";\n"
+	"static inline char* c2m_cat_uint(char* p, uint64_t v){\n"
+	"char digits[20]; int n = 20;\n"
+	"while(v >= 100){ const char* d = &c2m_cat_pairs[v % 100 * 2];\n"
+	"v /= 100; digits[--n] = d[1]; digits[--n] = d[0]; }\n"
+	"if(v >= 10){ digits[--n] = c2m_cat_pairs[v * 2 + 1];\n"
+	"digits[--n] = c2m_cat_pairs[v * 2]; }\n"
+	"else digits[--n] = '0' + v;\n"
+	"memcpy(p, &digits[n], 20 - n);\n"
+	"return p + 20 - n; }\n"
+	"static inline char* c2m_cat_int(char* p, int64_t v){\n"
+	"if(v < 0){ *p++ = '-'; return c2m_cat_uint(p, -(uint64_t)v); }\n"
+	"return c2m_cat_uint(p, v); }\n"
+	"static char* c2m_cat_float(char* p, double v, int sig){\n"
+	"static const double scale[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,\n"
+	"1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };\n"
+	"char digits[20]; int n = 20, i = 0, frac = sig; uint64_t whole;\n"
+	"if(v != v){ memcpy(p, \"nan\", 3); return p + 3; }\n"
+	"if(v < 0){ *p++ = '-'; v = -v; }\n"
+	"if(v - v != 0){ memcpy(p, \"inf\", 3); return p + 3; }\n"
+	"if(v == 0){ *p++ = '0'; return p; }\n"
+	"if(v < 1e-4 || v >= scale[sig])\n"
+	"return p + snprintf(p, 25, \"%.*g\", sig, v);\n"
+	"for(whole = (uint64_t)v; whole; whole /= 10) frac--;\n"
+	"if(v < 1) for(double t = v * 10; t < 1; t *= 10) frac++;\n"
+	"whole = (uint64_t)(v * scale[frac] + 0.5);\n"
+	"while(frac && whole % 10 == 0){ whole /= 10; frac--; }\n"
+	"do{ digits[--n] = '0' + whole % 10; whole /= 10;\n"
+	"if(++i == frac) digits[--n] = '.';\n"
+	"}while(whole || i <= frac);\n"
+	"memcpy(p, &digits[n], 20 - n);\n"
+	"return p + 20 - n; }\n";
+
+// Buffered output for io.c2m: one buffer per thread, written straight to
+// the file descriptor when full, on io.flush() & at exit ( the main thread's
+// ).  Line buffered mode also writes out every line.  main() calls
+// c2m_io_start() with the mode from c2m.config, so the prelude is the same
+// for both.  Split builds define C2M_IO_SHARED, the state is then in main's
+// unit ( c2m_prelude_io_state ) instead of one copy per unit.
+static const char c2m_prelude_io[] =
+	"#include <stdio.h>\n"
+	"#include <stdlib.h>\n"
+	"#include <string.h>\n"
+	"#if defined(__unix__) || defined(__APPLE__)\n"
+	"#include <unistd.h>\n"
+	"#define C2M_IO_WRITE(p, n) write(1, p, n)\n"
+	"#else\n"
+	"#define C2M_IO_WRITE(p, n) fwrite(p, 1, n, stdout)\n"
+	"#endif\n"
+	"#ifdef C2M_IO_SHARED\n"
+	"extern _Thread_local char c2m_io_buffer[65536];\n"
+	"extern _Thread_local size_t c2m_io_used;\n"
+	"extern int c2m_io_line;\n"
+	"#else\n"
+	"static _Thread_local char c2m_io_buffer[65536];\n"
+	"static _Thread_local size_t c2m_io_used;\n"
+	"static int c2m_io_line;\n"
+	"#endif\n"
+	"static void c2m_io_out(const char* p, size_t n){\n"
+	"while(n){ long w = (long)C2M_IO_WRITE(p, n);\n"
+	"if(w <= 0) return;\n"
+	"p += w; n -= w; } }\n"
+	"static void c2m_io_flush(void){\n"
+	"c2m_io_out(c2m_io_buffer, c2m_io_used); c2m_io_used = 0; }\n"
+	"static void c2m_io_write(const char* s, size_t n){\n"
+	"if(c2m_io_used + n > sizeof(c2m_io_buffer)) c2m_io_flush();\n"
+	"if(n > sizeof(c2m_io_buffer)){ c2m_io_out(s, n); return; }\n"
+	"memcpy(c2m_io_buffer + c2m_io_used, s, n); c2m_io_used += n; }\n"
+	"static void c2m_io_print(c2m_str_t s){\n"
+	"c2m_io_write(s.p, s.n);\n"
+	"if(c2m_io_line && memchr(s.p, '\\n', s.n)) c2m_io_flush(); }\n"
+	"static void c2m_io_println(c2m_str_t s){\n"
+	"c2m_io_write(s.p, s.n); c2m_io_write(\"\\n\", 1);\n"
+	"if(c2m_io_line) c2m_io_flush(); }\n"
+	"static void c2m_io_start(int line){\n"
+	"c2m_io_line = line; atexit(c2m_io_flush); }\n";
+
+// main()'s args, argv as is: nothing's copied or measured at startup.  An
+// argument's length is found & its UTF-8 checked when it's used, one that
+// isn't UTF-8 ends the program.
+static const char c2m_prelude_args[] =
+	"#include <stdio.h>\n"
+	"#include <stdlib.h>\n"
+	"typedef struct{ char** v; uint32_t n; }c2m_args_t;\n"
+	"static int c2m_args_utf8(const char* arg, size_t* length){\n"
+	"const unsigned char* s = (const unsigned char*)arg;\n"
+	"const unsigned char* p = s;\n"
+	"while(*p){ uint32_t c = *p, k; if(c < 0x80){ p++; continue; }\n"
+	"k = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC2 ? 1 : 0;\n"
+	"if(k == 0 || c > 0xF4) return 0;\n"
+	"c &= 0x3F >> k;\n"
+	"for(uint32_t j = 1; j <= k; j++){\n"
+	"if((p[j] & 0xC0) != 0x80) return 0;\n"
+	"c = c << 6 | (p[j] & 0x3F); }\n"
+	"if((k == 2 && (c < 0x800 || (c >= 0xD800 && c < 0xE000))) ||\n"
+	"(k == 3 && (c < 0x10000 || c > 0x10FFFF))) return 0;\n"
+	"p += k + 1; }\n"
+	"*length = p - s; return 1; }\n"
+	"static c2m_str_t c2m_args_at(c2m_args_t args, uint64_t i){\n"
+	"size_t n;\n"
+	"if(c2m_args_utf8(args.v[i], &n) == 0){\n"
+	"fputs(\"Argument isn't UTF-8\\n\", stderr); exit(1); }\n"
+	"return (c2m_str_t){ args.v[i], n }; }\n"
+	"static c2m_str_t c2m_args_get(c2m_args_t args, uint64_t i){\n"
+	"if(i >= args.n){ fputs(\"No such argument\\n\", stderr); exit(1); }\n"
+	"return c2m_args_at(args, i); }\n";
+
+// list_t: a growable array of strings, the first 4 ( see c2m_type_size() )
+// inline so a short list isn't allocated.  c2m_list_data() is where they are,
+// indexing is bounds checked ( c2m_list_get ) except in a for loop that
+// proves it can't be out ( see c2m_loop.c ).  Pushed strings are copied,
+// concatenated ones only last for their call.  The type is also in a
+// library's header, guarded the same as the string's.
+static const char c2m_prelude_list_type[] =
+	"typedef struct{ c2m_str_t* heap; uint32_t n, cap; c2m_str_t small[4]; }"
+	"c2m_list_t;\n"
+	"#define c2m_list_data(l) ((l)->cap ? (l)->heap : (l)->small)\n";
+
+static const char c2m_prelude_list[] =
+	"#include <stdio.h>\n"
+	"#include <stdlib.h>\n"
+	"#include <string.h>\n"
+	"static c2m_str_t c2m_list_get(const c2m_list_t* l, uint64_t i){\n"
+	"if(i >= l->n){ fputs(\"No such item\\n\", stderr); exit(1); }\n"
+	"return c2m_list_data(l)[i]; }\n"
+	"static void c2m_list_push(c2m_list_t* l, c2m_str_t s){\n"
+	"char* copy = malloc(s.n + 1);\n"
+	"if(copy == NULL) abort();\n"
+	"if(s.n) memcpy(copy, s.p, s.n);\n"
+	"copy[s.n] = '\\0'; s.p = copy;\n"
+	"if(l->cap == 0 && l->n < 4){ l->small[l->n++] = s; return; }\n"
+	"if(l->n == l->cap || l->cap == 0){\n"
+	"uint32_t cap = l->cap ? l->cap * 2 : 8;\n"
+	"c2m_str_t* heap = realloc(l->cap ? l->heap : NULL,\n"
+	"cap * sizeof(c2m_str_t));\n"
+	"if(heap == NULL) abort();\n"
+	"if(l->cap == 0) memcpy(heap, l->small, sizeof(l->small));\n"
+	"l->heap = heap; l->cap = cap; }\n"
+	"l->heap[l->n++] = s; }\n";
+
+// set_t: the integers 0 to 255 as a 256 bit value, four words the C compiler
+// keeps in one AVX2 ( or two SSE2 ) registers, so "∪" & "∩" are one OR or AND
+// of those.  Intervals & builders are filled a word at a time from masks,
+// not a member at a time.  Sets known when compiling are emitted as their
+// words ( see c2m_emit_set ), a member out of range found when running ends
+// the program.  The type is also in a library's header.
+#define C2M_SET_BITS 256
+#define C2M_SET_TEXT 1170 // "{0, 1, ..., 255}", see c2m_cat_set()
+
+static const char c2m_prelude_set_type[] =
+	"#define C2M_SET_WORDS 4\n"
+	"typedef struct{ uint64_t w[C2M_SET_WORDS]; }c2m_set_t;\n";
+
+static const char c2m_prelude_set[] =
+	"#include <stdio.h>\n"
+	"#include <stdlib.h>\n"
+	"static inline c2m_set_t c2m_set_union(c2m_set_t a, c2m_set_t b){\n"
+	"for(int i = 0; i < C2M_SET_WORDS; i++) a.w[i] |= b.w[i];\n"
+	"return a; }\n"
+	"static inline c2m_set_t c2m_set_inter(c2m_set_t a, c2m_set_t b){\n"
+	"for(int i = 0; i < C2M_SET_WORDS; i++) a.w[i] &= b.w[i];\n"
+	"return a; }\n"
+	"static inline c2m_set_t c2m_set_range(int64_t lo, int64_t hi){\n"
+	"c2m_set_t s;\n"
+	"for(int i = 0; i < C2M_SET_WORDS; i++){\n"
+	"int64_t l = lo - i * 64, h = hi - i * 64;\n"
+	"if(l < 0) l = 0;\n"
+	"if(h > 64) h = 64;\n"
+	"s.w[i] = l < h ? ~0ULL >> (64 - (h - l)) << l : 0; }\n"
+	"return s; }\n"
+	"static inline c2m_set_t c2m_set_with(c2m_set_t s, int64_t v){\n"
+	"if(v < 0 || v >= C2M_SET_WORDS * 64){\n"
+	"fputs(\"Set member out of range\\n\", stderr); exit(1); }\n"
+	"s.w[v >> 6] |= 1ULL << (v & 63);\n"
+	"return s; }\n";
+
+// A set concatenated to a string, needs c2m_cat_uint().
+static const char c2m_prelude_set_cat[] =
+	"static char* c2m_cat_set(char* p, c2m_set_t s){\n"
+	"*p++ = '{';\n"
+	"for(int i = 0; i < C2M_SET_WORDS * 64; i++){\n"
+	"if((s.w[i >> 6] >> (i & 63) & 1) == 0) continue;\n"
+	"if(p[-1] != '{'){ *p++ = ','; *p++ = ' '; }\n"
+	"p = c2m_cat_uint(p, i); }\n"
+	"*p++ = '}';\n"
+	"return p; }\n";
+
+static const char c2m_prelude_io_state[] =
+	"_Thread_local char c2m_io_buffer[65536];\n"
+	"_Thread_local size_t c2m_io_used;\n"
+	"int c2m_io_line;\n";
+
+// Parallel loops ( see c2m_parallel.c ): a pool of threads, one per core,
+// started by the first loop & waiting on a condition variable in between.
+// c2m_par_for() cuts the interval into chunks, about 8 per thread, handed out
+// by an atomic counter so uneven iterations balance out.  A thread's chunks
+// run with its own accumulator, `stride` bytes apart ( a cache line ), & it
+// flushes its output ( C2M_PAR_DONE ) before the loop returns.  A loop in a
+// loop's body runs on the thread it's on.  Without pthreads every loop runs
+// on the calling thread.  Split builds define C2M_PAR_SHARED, the pool is
+// then in main's unit ( c2m_prelude_par_state ).
+static const char c2m_prelude_par[] =
+	"#define C2M_PAR_MAX 64\n"
+	"typedef void (*c2m_par_fn)(void* ctx, int64_t lo, int64_t hi, void* acc);"
+	"\n"
+	"#if defined(__unix__) || defined(__APPLE__)\n"
+	"#include <pthread.h>\n"
+	"#include <stdatomic.h>\n"
+	"#include <unistd.h>\n"
+	"typedef struct{ pthread_mutex_t lock; pthread_cond_t go, done;\n"
+	"pthread_once_t once; c2m_par_fn fn; void* ctx; char* accs;\n"
+	"size_t stride; int64_t hi, chunk; _Atomic int64_t next;\n"
+	"unsigned n, busy, gen; }c2m_par_t;\n"
+	"#define C2M_PAR_INIT { PTHREAD_MUTEX_INITIALIZER, "
+	"PTHREAD_COND_INITIALIZER,\\\n"
+	"PTHREAD_COND_INITIALIZER, PTHREAD_ONCE_INIT }\n"
+	"#ifdef C2M_PAR_SHARED\n"
+	"extern c2m_par_t c2m_par;\n"
+	"extern _Thread_local int c2m_par_inside;\n"
+	"#else\n"
+	"static c2m_par_t c2m_par = C2M_PAR_INIT;\n"
+	"static _Thread_local int c2m_par_inside;\n"
+	"#endif\n"
+	"static void c2m_par_run(unsigned w){\n"
+	"void* acc = c2m_par.accs ? c2m_par.accs + w * c2m_par.stride : 0;\n"
+	"int64_t lo, hi;\n"
+	"while((lo = atomic_fetch_add_explicit(&c2m_par.next, c2m_par.chunk,\n"
+	"memory_order_relaxed)) < c2m_par.hi){\n"
+	"hi = c2m_par.hi - lo > c2m_par.chunk ? lo + c2m_par.chunk : c2m_par.hi;"
+	"\n"
+	"c2m_par.fn(c2m_par.ctx, lo, hi, acc); } }\n"
+	"static void* c2m_par_worker(void* arg){\n"
+	"unsigned w = (unsigned)(uintptr_t)arg, gen = 0;\n"
+	"c2m_par_inside = 1;\n"
+	"pthread_mutex_lock(&c2m_par.lock);\n"
+	"while(1){\n"
+	"while(c2m_par.gen == gen) pthread_cond_wait(&c2m_par.go, &c2m_par.lock);"
+	"\n"
+	"gen = c2m_par.gen;\n"
+	"pthread_mutex_unlock(&c2m_par.lock);\n"
+	"c2m_par_run(w); C2M_PAR_DONE;\n"
+	"pthread_mutex_lock(&c2m_par.lock);\n"
+	"if(--c2m_par.busy == 0) pthread_cond_signal(&c2m_par.done); }\n"
+	"return 0; }\n"
+	"static void c2m_par_start(void){\n"
+	"long n = sysconf(_SC_NPROCESSORS_ONLN);\n"
+	"pthread_t thread;\n"
+	"if(n > C2M_PAR_MAX) n = C2M_PAR_MAX;\n"
+	"c2m_par.n = 1;\n"
+	"for(long i = 1; i < n; i++){\n"
+	"if(pthread_create(&thread, 0, c2m_par_worker, (void*)(uintptr_t)i))"
+	" break;\n"
+	"pthread_detach(thread); c2m_par.n++; } }\n"
+	"static unsigned c2m_par_count(void){\n"
+	"pthread_once(&c2m_par.once, c2m_par_start);\n"
+	"return c2m_par.n; }\n"
+	"static void c2m_par_for(c2m_par_fn fn, void* ctx, int64_t lo, int64_t hi,"
+	"\n"
+	"void* accs, size_t stride){\n"
+	"unsigned n = c2m_par_count();\n"
+	"if(hi <= lo) return;\n"
+	"if(n == 1 || c2m_par_inside || hi - lo == 1){ fn(ctx, lo, hi, accs);"
+	" return; }\n"
+	"pthread_mutex_lock(&c2m_par.lock);\n"
+	"c2m_par.fn = fn; c2m_par.ctx = ctx;\n"
+	"c2m_par.accs = accs; c2m_par.stride = stride;\n"
+	"c2m_par.hi = hi; c2m_par.chunk = (hi - lo) / (n * 8);\n"
+	"if(c2m_par.chunk == 0) c2m_par.chunk = 1;\n"
+	"atomic_store_explicit(&c2m_par.next, lo, memory_order_relaxed);\n"
+	"c2m_par.busy = n - 1; c2m_par.gen++;\n"
+	"pthread_cond_broadcast(&c2m_par.go);\n"
+	"pthread_mutex_unlock(&c2m_par.lock);\n"
+	"c2m_par_inside = 1; c2m_par_run(0); c2m_par_inside = 0;\n"
+	"pthread_mutex_lock(&c2m_par.lock);\n"
+	"while(c2m_par.busy) pthread_cond_wait(&c2m_par.done, &c2m_par.lock);\n"
+	"pthread_mutex_unlock(&c2m_par.lock); }\n"
+	"#else\n"
+	"static unsigned c2m_par_count(void){ return 1; }\n"
+	"static void c2m_par_for(c2m_par_fn fn, void* ctx, int64_t lo, int64_t hi,"
+	"\n"
+	"void* accs, size_t stride){ if(hi > lo) fn(ctx, lo, hi, accs); }\n"
+	"#endif\n";
+
+static const char c2m_prelude_par_state[] =
+	"#if defined(__unix__) || defined(__APPLE__)\n"
+	"c2m_par_t c2m_par = C2M_PAR_INIT;\n"
+	"_Thread_local int c2m_par_inside;\n"
+	"#endif\n";
+
+// Group-by & hash join for agg.c2m, on the parallel loops' pool.  A row is
+// "key\tvalue", split at its first tab.  Both sides' rows are hashed ( in
+// parallel ) & radix partitioned by the top bits of the hash, enough
+// partitions that each has about C2M_AGG_ROWS rows.  The pool then takes the
+// partitions a chunk at a time, each one's table is small enough to stay in
+// cache: open addressing, the group's count, sum, min & max inline in its
+// slot, or the build side's rows chained by key for a join.  Each partition
+// writes its output rows to its own buffer, pushed to the output list in
+// partition order once they're all done.
+static const char c2m_prelude_agg[] =
+	"#include <stdio.h>\n"
+	"#include <stdlib.h>\n"
+	"#include <string.h>\n"
+	"#define C2M_AGG_ROWS 2048\n"
+	"#define C2M_AGG_MAX_BITS 10\n"
+	"typedef struct{ const char* p; uint32_t n, len; uint64_t h; }\n"
+	"c2m_agg_key_t;\n"
+	"typedef struct{ char* p; size_t n, cap; }c2m_agg_out_t;\n"
+	"typedef struct{ uint64_t h; const char* p; uint32_t n, count;\n"
+	"double sum, min, max; }c2m_agg_group_t;\n"
+	"typedef struct{ c2m_str_t* rows; c2m_agg_key_t* keys[2];\n"
+	"uint32_t* start[2]; c2m_agg_out_t* out; }c2m_agg_t;\n"
+	"static void* c2m_agg_alloc(size_t n){\n"
+	"void* m = calloc(n ? n : 1, 1);\n"
+	"if(m == 0) abort();\n"
+	"return m; }\n"
+	"static uint64_t c2m_agg_hash(const char* p, size_t n){\n"
+	"uint64_t h = 0x9E3779B97F4A7C15ull ^ n, w;\n"
+	"for(; n >= 8; p += 8, n -= 8){ memcpy(&w, p, 8);\n"
+	"h = (h ^ w) * 0xFF51AFD7ED558CCDull; h ^= h >> 32; }\n"
+	"w = 0; memcpy(&w, p, n); h = (h ^ w) * 0xC4CEB9FE1A85EC53ull;\n"
+	"return h ^ h >> 29; }\n"
+	"static unsigned c2m_agg_bits(uint32_t n){\n"
+	"unsigned bits = 0;\n"
+	"while((n >> bits) > C2M_AGG_ROWS && bits < C2M_AGG_MAX_BITS) bits++;\n"
+	"return bits; }\n"
+	"static unsigned c2m_agg_part(uint64_t h, unsigned bits){\n"
+	"return bits ? (unsigned)(h >> (64 - bits)) : 0; }\n"
+	"static uint32_t c2m_agg_size(uint32_t n){\n"
+	"uint32_t size = 16;\n"
+	"while(size < n * 2) size *= 2;\n"
+	"return size; }\n"
+	"static int c2m_agg_same(const c2m_agg_key_t* a, uint64_t h,\n"
+	"const char* p, uint32_t n){\n"
+	"return a->h == h && a->n == n && memcmp(a->p, p, n) == 0; }\n"
+	"static void c2m_agg_hash_rows(void* ctx, int64_t lo, int64_t hi,\n"
+	"void* acc){\n"
+	"c2m_agg_t* a = ctx; (void)acc;\n"
+	"for(int64_t i = lo; i < hi; i++){\n"
+	"c2m_str_t s = a->rows[i]; c2m_agg_key_t* k = &a->keys[0][i];\n"
+	"const char* tab = s.n ? memchr(s.p, '\\t', s.n) : 0;\n"
+	"k->p = s.p; k->len = (uint32_t)s.n;\n"
+	"k->n = tab ? (uint32_t)(tab - s.p) : k->len;\n"
+	"k->h = c2m_agg_hash(k->p, k->n); } }\n"
+	"static c2m_agg_key_t* c2m_agg_split(c2m_list_t* l, unsigned bits,\n"
+	"uint32_t* start){\n"
+	"uint32_t n = l->n, parts = 1u << bits;\n"
+	"uint32_t* at = c2m_agg_alloc(parts * sizeof(uint32_t));\n"
+	"c2m_agg_key_t* keys = c2m_agg_alloc(n * sizeof(c2m_agg_key_t));\n"
+	"c2m_agg_t a;\n"
+	"a.rows = c2m_list_data(l);\n"
+	"a.keys[0] = c2m_agg_alloc(n * sizeof(c2m_agg_key_t));\n"
+	"c2m_par_for(c2m_agg_hash_rows, &a, 0, n, 0, 0);\n"
+	"for(uint32_t i = 0; i < n; i++)\n"
+	"start[c2m_agg_part(a.keys[0][i].h, bits) + 1]++;\n"
+	"for(uint32_t p = 0; p < parts; p++){\n"
+	"start[p + 1] += start[p]; at[p] = start[p]; }\n"
+	"for(uint32_t i = 0; i < n; i++)\n"
+	"keys[at[c2m_agg_part(a.keys[0][i].h, bits)]++] = a.keys[0][i];\n"
+	"free(a.keys[0]); free(at);\n"
+	"return keys; }\n"
+	"static char* c2m_agg_room(c2m_agg_out_t* o, uint32_t n){\n"
+	"char* p;\n"
+	"if(o->n + n + 4 > o->cap){\n"
+	"o->cap = o->cap ? o->cap * 2 : 4096;\n"
+	"if(o->cap < o->n + n + 4) o->cap = o->n + n + 4;\n"
+	"if((o->p = realloc(o->p, o->cap)) == 0) abort(); }\n"
+	"memcpy(o->p + o->n, &n, 4);\n"
+	"p = o->p + o->n + 4; o->n += n + 4;\n"
+	"return p; }\n"
+	"static void c2m_agg_group_part(void* ctx, int64_t lo, int64_t hi,\n"
+	"void* acc){\n"
+	"c2m_agg_t* a = ctx; (void)acc;\n"
+	"for(int64_t p = lo; p < hi; p++){\n"
+	"uint32_t first = a->start[0][p], last = a->start[0][p + 1];\n"
+	"uint32_t mask = c2m_agg_size(last - first) - 1;\n"
+	"c2m_agg_group_t* t;\n"
+	"if(first == last) continue;\n"
+	"t = c2m_agg_alloc((mask + 1) * sizeof(c2m_agg_group_t));\n"
+	"for(uint32_t i = first; i < last; i++){\n"
+	"c2m_agg_key_t* k = &a->keys[0][i];\n"
+	"uint32_t s = k->h & mask;\n"
+	"double x = k->n < k->len ? strtod(k->p + k->n + 1, 0) : 0;\n"
+	"while(t[s].count && (t[s].h != k->h || t[s].n != k->n ||\n"
+	"memcmp(t[s].p, k->p, k->n))) s = (s + 1) & mask;\n"
+	"if(t[s].count++ == 0){\n"
+	"t[s].h = k->h; t[s].p = k->p; t[s].n = k->n; t[s].min = t[s].max = x; }\n"
+	"t[s].sum += x;\n"
+	"if(x < t[s].min) t[s].min = x;\n"
+	"if(x > t[s].max) t[s].max = x; }\n"
+	"for(uint32_t s = 0; s <= mask; s++){\n"
+	"char num[96], *o; int m;\n"
+	"if(t[s].count == 0) continue;\n"
+	"m = snprintf(num, sizeof(num), \"\\t%u\\t%.15g\\t%.15g\\t%.15g\",\n"
+	"t[s].count, t[s].sum, t[s].min, t[s].max);\n"
+	"o = c2m_agg_room(&a->out[p], t[s].n + m);\n"
+	"memcpy(o, t[s].p, t[s].n); memcpy(o + t[s].n, num, m); }\n"
+	"free(t); } }\n"
+	"static uint32_t c2m_agg_find(const uint32_t* t, uint32_t mask,\n"
+	"const c2m_agg_key_t* build, const c2m_agg_key_t* k){\n"
+	"uint32_t s = k->h & mask;\n"
+	"while(t[s] && !c2m_agg_same(&build[t[s] - 1], k->h, k->p, k->n))\n"
+	"s = (s + 1) & mask;\n"
+	"return s; }\n"
+	"static void c2m_agg_join_part(void* ctx, int64_t lo, int64_t hi,\n"
+	"void* acc){\n"
+	"c2m_agg_t* a = ctx; (void)acc;\n"
+	"for(int64_t p = lo; p < hi; p++){\n"
+	"uint32_t first = a->start[0][p], last = a->start[0][p + 1];\n"
+	"uint32_t n = a->start[1][p + 1] - a->start[1][p];\n"
+	"c2m_agg_key_t* build = &a->keys[1][a->start[1][p]];\n"
+	"uint32_t mask = c2m_agg_size(n) - 1, *t, *next;\n"
+	"if(first == last || n == 0) continue;\n"
+	"t = c2m_agg_alloc((mask + 1) * sizeof(uint32_t));\n"
+	"next = c2m_agg_alloc(n * sizeof(uint32_t));\n"
+	"for(uint32_t i = n; i-- > 0;){\n"
+	"uint32_t s = c2m_agg_find(t, mask, build, &build[i]);\n"
+	"next[i] = t[s]; t[s] = i + 1; }\n"
+	"for(uint32_t i = first; i < last; i++){\n"
+	"c2m_agg_key_t* k = &a->keys[0][i];\n"
+	"uint32_t kl = k->len - k->n - (k->n < k->len);\n"
+	"uint32_t r = t[c2m_agg_find(t, mask, build, k)];\n"
+	"for(; r; r = next[r - 1]){\n"
+	"c2m_agg_key_t* e = &build[r - 1];\n"
+	"uint32_t el = e->len - e->n - (e->n < e->len);\n"
+	"char* o = c2m_agg_room(&a->out[p], k->n + kl + el + 2);\n"
+	"memcpy(o, k->p, k->n); o += k->n; *o++ = '\\t';\n"
+	"memcpy(o, k->p + k->len - kl, kl); o += kl; *o++ = '\\t';\n"
+	"memcpy(o, e->p + e->len - el, el); } }\n"
+	"free(t); free(next); } }\n"
+	"static void c2m_agg_finish(c2m_agg_t* a, unsigned parts, c2m_list_t* l){\n"
+	"for(unsigned p = 0; p < parts; p++){\n"
+	"c2m_agg_out_t* o = &a->out[p];\n"
+	"for(size_t at = 0; at < o->n;){\n"
+	"uint32_t n; memcpy(&n, o->p + at, 4);\n"
+	"c2m_list_push(l, (c2m_str_t){ o->p + at + 4, n }); at += n + 4; }\n"
+	"free(o->p); }\n"
+	"free(a->out); free(a->keys[0]); free(a->start[0]);\n"
+	"if(a->keys[1]){ free(a->keys[1]); free(a->start[1]); } }\n"
+	"static void c2m_agg_group(c2m_list_t* rows, c2m_list_t* out){\n"
+	"unsigned bits = c2m_agg_bits(rows->n), parts = 1u << bits;\n"
+	"c2m_agg_t a = { 0 };\n"
+	"a.start[0] = c2m_agg_alloc((parts + 1) * sizeof(uint32_t));\n"
+	"a.keys[0] = c2m_agg_split(rows, bits, a.start[0]);\n"
+	"a.out = c2m_agg_alloc(parts * sizeof(c2m_agg_out_t));\n"
+	"c2m_par_for(c2m_agg_group_part, &a, 0, parts, 0, 0);\n"
+	"c2m_agg_finish(&a, parts, out); }\n"
+	"static void c2m_agg_join(c2m_list_t* left, c2m_list_t* right,\n"
+	"c2m_list_t* out){\n"
+	"unsigned bits = c2m_agg_bits(left->n > right->n ? left->n : right->n);\n"
+	"unsigned parts = 1u << bits;\n"
+	"c2m_agg_t a = { 0 };\n"
+	"for(int side = 0; side < 2; side++){\n"
+	"a.start[side] = c2m_agg_alloc((parts + 1) * sizeof(uint32_t));\n"
+	"a.keys[side] = c2m_agg_split(side ? right : left, bits,\n"
+	"a.start[side]); }\n"
+	"a.out = c2m_agg_alloc(parts * sizeof(c2m_agg_out_t));\n"
+	"c2m_par_for(c2m_agg_join_part, &a, 0, parts, 0, 0);\n"
+	"c2m_agg_finish(&a, parts, out); }\n";
+
+// Coroutines ( async functions, see c2m_async.c ): a frame per call, run by
+// an event loop on the main thread.  Ready coroutines are queued & stepped in
+// order, one waiting on a file descriptor is resumed by epoll ( poll() off
+// Linux, without either right away, as it is for a descriptor that can't be
+// polled like a regular file's ).  Awaiting a call queues the callee, which
+// queues its caller when it returns.  A descriptor is waited on by one
+// coroutine at a time.  main() runs the loop once its statements are done,
+// until nothing's left.  Split builds define C2M_CO_SHARED, the loop is then
+// in main's unit ( c2m_prelude_co_state ).
+static const char c2m_prelude_co[] =
+	"#include <stdlib.h>\n"
+	"#include <string.h>\n"
+	"typedef struct c2m_co{ void (*step)(struct c2m_co* co);\n"
+	"struct c2m_co* parent; struct c2m_co* next; int state, fd, write; }"
+	"c2m_co_t;\n"
+	"typedef struct{ c2m_co_t* head; c2m_co_t** tail; c2m_co_t* waiting;\n"
+	"int epoll, n_waiting; }c2m_co_loop_t;\n"
+	"#define C2M_CO_INIT { 0, 0, 0, -1, 0 }\n"
+	"#ifdef C2M_CO_SHARED\n"
+	"extern c2m_co_loop_t c2m_co;\n"
+	"#else\n"
+	"static c2m_co_loop_t c2m_co = C2M_CO_INIT;\n"
+	"#endif\n"
+	"static void c2m_co_ready(c2m_co_t* co){\n"
+	"co->next = 0;\n"
+	"if(c2m_co.head) *c2m_co.tail = co; else c2m_co.head = co;\n"
+	"c2m_co.tail = &co->next; }\n"
+	"static c2m_co_t* c2m_co_new(size_t size, void (*step)(c2m_co_t*)){\n"
+	"c2m_co_t* co = calloc(1, size);\n"
+	"if(co == 0) abort();\n"
+	"co->step = step;\n"
+	"return co; }\n"
+	"static void c2m_co_await(c2m_co_t* co, c2m_co_t* callee){\n"
+	"callee->parent = co; c2m_co_ready(callee); }\n"
+	"static void c2m_co_done(c2m_co_t* co){\n"
+	"if(co->parent) c2m_co_ready(co->parent);\n"
+	"free(co); }\n"
+	"#if defined(__linux__)\n"
+	"#include <errno.h>\n"
+	"#include <sys/epoll.h>\n"
+	"#include <unistd.h>\n"
+	"static void c2m_co_wait(c2m_co_t* co, int fd, int write){\n"
+	"struct epoll_event ev;\n"
+	"if(c2m_co.epoll < 0 && (c2m_co.epoll = epoll_create1(EPOLL_CLOEXEC)) < 0)"
+	"\n"
+	"abort();\n"
+	"ev.events = (write ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT;\n"
+	"ev.data.ptr = co;\n"
+	"if(epoll_ctl(c2m_co.epoll, EPOLL_CTL_MOD, fd, &ev) && (errno != ENOENT ||"
+	"\n"
+	"epoll_ctl(c2m_co.epoll, EPOLL_CTL_ADD, fd, &ev))){ c2m_co_ready(co);"
+	" return; }\n"
+	"c2m_co.n_waiting++; }\n"
+	"static void c2m_co_poll(void){\n"
+	"struct epoll_event ev[64];\n"
+	"int n = epoll_wait(c2m_co.epoll, ev, 64, -1);\n"
+	"for(int i = 0; i < n; i++){ c2m_co.n_waiting--;"
+	" c2m_co_ready(ev[i].data.ptr); } }\n"
+	"#elif defined(__unix__) || defined(__APPLE__)\n"
+	"#include <poll.h>\n"
+	"#include <unistd.h>\n"
+	"static void c2m_co_wait(c2m_co_t* co, int fd, int write){\n"
+	"co->fd = fd; co->write = write;\n"
+	"co->next = c2m_co.waiting; c2m_co.waiting = co;\n"
+	"c2m_co.n_waiting++; }\n"
+	"static void c2m_co_poll(void){\n"
+	"struct pollfd* fds = malloc(sizeof(struct pollfd) * c2m_co.n_waiting);\n"
+	"int i = 0;\n"
+	"if(fds == 0) abort();\n"
+	"for(c2m_co_t* co = c2m_co.waiting; co; co = co->next, i++){\n"
+	"fds[i].fd = co->fd; fds[i].events = co->write ? POLLOUT : POLLIN; }\n"
+	"if(poll(fds, i, -1) > 0){\n"
+	"i = 0;\n"
+	"for(c2m_co_t** link = &c2m_co.waiting; *link; i++){\n"
+	"c2m_co_t* co = *link;\n"
+	"if(fds[i].revents == 0){ link = &co->next; continue; }\n"
+	"*link = co->next; c2m_co.n_waiting--; c2m_co_ready(co); } }\n"
+	"free(fds); }\n"
+	"#else\n"
+	"static void c2m_co_wait(c2m_co_t* co, int fd, int write){\n"
+	"(void)fd; (void)write; c2m_co_ready(co); }\n"
+	"static void c2m_co_poll(void){}\n"
+	"#endif\n"
+	"static void c2m_co_loop(void){\n"
+	"while(c2m_co.head || c2m_co.n_waiting){\n"
+	"while(c2m_co.head){\n"
+	"c2m_co_t* co = c2m_co.head;\n"
+	"c2m_co.head = co->next;\n"
+	"co->step(co); }\n"
+	"if(c2m_co.n_waiting) c2m_co_poll(); } }\n";
+
+static const char c2m_prelude_co_state[] =
+	"c2m_co_loop_t c2m_co = C2M_CO_INIT;\n";
+
+// Benchmarks ( --bench, see c2m_bench.c ): c2m_bench_next() runs before each
+// batch of a bench's iterations.  The batch is doubled until it takes
+// C2M_BENCH_BATCH ns, batches then warm up for C2M_BENCH_WARMUP ns & the next
+// C2M_BENCH_SAMPLES are timed.  The median, 10th & 90th percentile time per
+// iteration are printed.  C2M_BENCH_KEEP() makes a value the bench computed
+// count, so the C compiler can't drop it.  With an argument, only benches
+// whose name contains it run.
+static const char c2m_prelude_bench[] =
+	"#include <stdio.h>\n"
+	"#include <stdlib.h>\n"
+	"#include <string.h>\n"
+	"#include <time.h>\n"
+	"#define C2M_BENCH_BATCH 1000000\n"
+	"#define C2M_BENCH_WARMUP 100000000\n"
+	"#define C2M_BENCH_SAMPLES 31\n"
+	"#if defined(__GNUC__) || defined(__clang__)\n"
+	"#define C2M_BENCH_KEEP(v) __asm__ __volatile__(\"\" : : \"r\"(&(v)) :"
+	" \"memory\")\n"
+	"#else\n"
+	"static void* volatile c2m_bench_sink;\n"
+	"#define C2M_BENCH_KEEP(v) (c2m_bench_sink = (void*)&(v))\n"
+	"#endif\n"
+	"typedef struct{ const char* name; uint64_t n, start, warm;\n"
+	"int phase, i; double t[C2M_BENCH_SAMPLES]; }c2m_bench_t;\n"
+	"static uint64_t c2m_bench_now(void){ struct timespec t;\n"
+	"#ifdef CLOCK_MONOTONIC\n"
+	"clock_gettime(CLOCK_MONOTONIC, &t);\n"
+	"#else\n"
+	"timespec_get(&t, TIME_UTC);\n"
+	"#endif\n"
+	"return (uint64_t)t.tv_sec * 1000000000u + t.tv_nsec; }\n"
+	"static int c2m_bench_cmp(const void* a, const void* b){\n"
+	"double x = *(const double*)a, y = *(const double*)b;\n"
+	"return (x > y) - (x < y); }\n"
+	"static void c2m_bench_start(c2m_bench_t* b, const char* name, int argc,\n"
+	"char** argv){\n"
+	"memset(b, 0, sizeof(*b)); b->name = name; b->n = 1;\n"
+	"if(argc > 1 && strstr(name, argv[1]) == 0) b->phase = 4; }\n"
+	"static int c2m_bench_next(c2m_bench_t* b){\n"
+	"uint64_t now = c2m_bench_now(), t = now - b->start;\n"
+	"switch(b->phase){\n"
+	"case 0: b->phase = 1; break;\n"
+	"case 1: if(t < C2M_BENCH_BATCH && b->n < 1ull << 40){ b->n *= 2; break; }\n"
+	"b->phase = 2; b->warm = now; break;\n"
+	"case 2: if(now - b->warm >= C2M_BENCH_WARMUP) b->phase = 3; break;\n"
+	"case 3: b->t[b->i++] = (double)t / b->n;\n"
+	"if(b->i < C2M_BENCH_SAMPLES) break;\n"
+	"qsort(b->t, C2M_BENCH_SAMPLES, sizeof(double), c2m_bench_cmp);\n"
+	"printf(\"%-24s %12.1f ns/iter  p10 %.1f  p90 %.1f  (%llu x %d)\\n\",\n"
+	"b->name, b->t[C2M_BENCH_SAMPLES / 2], b->t[C2M_BENCH_SAMPLES / 10],\n"
+	"b->t[C2M_BENCH_SAMPLES * 9 / 10], (unsigned long long)b->n,\n"
+	"C2M_BENCH_SAMPLES);\n"
+	"fflush(stdout);\n"
+	"default: return 0; }\n"
+	"b->start = c2m_bench_now(); return 1; }\n";
+
+// For loops over a file's lines ( see c2m_emit_for ): the file's read into a
+// buffer C2M_LINES_BUFFER bytes at a time & each line's a view into it, the
+// newline found by memchr() ( vectorized by the C library ), replaced by a NUL
+// & a '\r' before it dropped.  A line's only valid for its iteration, the
+// next read moves what's left to the front ( list.push copies it ).  The
+// buffer's doubled for a line longer than it.  A file that can't be opened
+// has no lines.
+static const char c2m_prelude_lines[] =
+	"#include <stdlib.h>\n"
+	"#include <string.h>\n"
+	"#define C2M_LINES_BUFFER 65536\n"
+	"#if defined(__unix__) || defined(__APPLE__)\n"
+	"#include <errno.h>\n"
+	"#include <fcntl.h>\n"
+	"#include <unistd.h>\n"
+	"typedef int c2m_lines_file_t;\n"
+	"#define C2M_LINES_NONE -1\n"
+	"static int c2m_lines_file(const char* path){\n"
+	"return open(path, O_RDONLY); }\n"
+	"static long c2m_lines_read(int f, char* p, size_t n){ long r;\n"
+	"while((r = read(f, p, n)) < 0 && errno == EINTR);\n"
+	"return r; }\n"
+	"#define c2m_lines_shut(f) close(f)\n"
+	"#else\n"
+	"#include <stdio.h>\n"
+	"typedef FILE* c2m_lines_file_t;\n"
+	"#define C2M_LINES_NONE 0\n"
+	"#define c2m_lines_file(path) fopen(path, \"rb\")\n"
+	"#define c2m_lines_read(f, p, n) (long)fread(p, 1, n, f)\n"
+	"#define c2m_lines_shut(f) fclose(f)\n"
+	"#endif\n"
+	"typedef struct{ char* buf; size_t cap, pos, end, scan;\n"
+	"c2m_lines_file_t f; int eof; }c2m_lines_t;\n"
+	"static void c2m_lines_open(c2m_lines_t* l, c2m_str_t path){\n"
+	"l->cap = C2M_LINES_BUFFER; l->pos = l->end = l->scan = 0;\n"
+	"if((l->buf = malloc(l->cap)) == 0) abort();\n"
+	"l->f = c2m_lines_file(path.p); l->eof = l->f == C2M_LINES_NONE; }\n"
+	"static int c2m_lines_cut(c2m_lines_t* l, size_t at, c2m_str_t* line){\n"
+	"size_t n = at - l->pos;\n"
+	"if(n && l->buf[at - 1] == '\\r') n--;\n"
+	"l->buf[l->pos + n] = 0; line->p = &l->buf[l->pos]; line->n = n;\n"
+	"l->pos = l->scan = at < l->end ? at + 1 : at;\n"
+	"return 1; }\n"
+	"static int c2m_lines_next(c2m_lines_t* l, c2m_str_t* line){\n"
+	"for(;;){\n"
+	"char* nl = memchr(&l->buf[l->scan], '\\n', l->end - l->scan);\n"
+	"long got;\n"
+	"if(nl) return c2m_lines_cut(l, nl - l->buf, line);\n"
+	"l->scan = l->end;\n"
+	"if(l->eof) return l->pos < l->end && c2m_lines_cut(l, l->end, line);\n"
+	"if(l->pos){ memmove(l->buf, &l->buf[l->pos], l->end - l->pos);\n"
+	"l->end -= l->pos; l->scan = l->end; l->pos = 0; }\n"
+	"if(l->end + 1 >= l->cap && (l->buf = realloc(l->buf, l->cap *= 2)) == 0)"
+	"\n"
+	"abort();\n"
+	"got = c2m_lines_read(l->f, &l->buf[l->end], l->cap - l->end - 1);\n"
+	"if(got > 0) l->end += got; else l->eof = 1; } }\n"
+	"static void c2m_lines_close(c2m_lines_t* l){\n"
+	"if(l->f != C2M_LINES_NONE) c2m_lines_shut(l->f);\n"
+	"free(l->buf); }\n";
+
+// Start of main()'s body, starts the runtimes the program uses.
+static void c2m_prelude_main(c2m_t* c2m, struct cl_array* a) {
+	if(c2m->libreq.io) {
+		c2m_string_append(a, c2m->io && strcmp(c2m->io, "line") == 0 ?
+			"c2m_io_start(1);\n" : "c2m_io_start(0);\n");
+	}
+	if(c2m->libreq.args)
+		c2m_string_append(a, "c2m_args_t args = { argv, (uint32_t)argc };\n");
+	if(c2m->libreq.trace) c2m_string_append(a, "c2m_trace_start_env();\n");
+	if(c2m->libreq.profile)
+		c2m_string_append(a, "c2m_profile_start_env();\n");
+}
+
+// A library has no main(), its runtimes start when it's loaded instead.
+static void c2m_prelude_library(c2m_t* c2m, struct cl_array* a) {
+	if(c2m->libreq.io == 0 && c2m->libreq.trace == 0) return;
+	c2m_string_append(a, "__attribute__((constructor))\n"
+		"static void c2m_library_start(void){\n");
+	c2m_prelude_main(c2m, a);
+	c2m_string_append(a, "}\n");
+}
+
+// Append the #include lines for the headers the program needs ( and the
+// helpers they go with ).
+static void c2m_prelude_includes(c2m_t* c2m, struct cl_array* a) {
+	c2m_string_append(a, "#include <stdint.h>\n"); // No matter what 32-64 compat
+	c2m_string_append(a, c2m_prelude_string);
+	c2m_string_append(a, c2m_prelude_hints);
+	if(c2m->libreq.stdio) c2m_string_append(a, "#include <stdio.h>\n");
+	if(c2m->libreq.stdlib) {
+		c2m_string_append(a, "#include <stdlib.h>\n");
+		c2m_string_append(a, c2m_prelude_fail);
+	}
+	if(c2m->libreq.clump) c2m_string_append(a, "#include <c2m_clump.c>\n");
+	if(c2m->libreq.sdl) c2m_string_append(a, "#include <c2m_sdl.c>\n");
+	if(c2m->libreq.sdl_window)
+		c2m_string_append(a, "#include <c2m_window.c>\n");
+	if(c2m->libreq.sdl_audio)
+		c2m_string_append(a, "#include <c2m_audio.c>\n");
+	if(c2m->libreq.string) c2m_string_append(a, "#include <string.h>\n");
+	if(c2m->libreq.concat) c2m_string_append(a, c2m_prelude_concat);
+	if(c2m->libreq.io) c2m_string_append(a, c2m_prelude_io);
+	if(c2m->libreq.args) c2m_string_append(a, c2m_prelude_args);
+	if(c2m->libreq.list) {
+		c2m_string_append(a, c2m_prelude_list_type);
+		c2m_string_append(a, c2m_prelude_list);
+	}
+	if(c2m->libreq.set) {
+		c2m_string_append(a, c2m_prelude_set_type);
+		c2m_string_append(a, c2m_prelude_set);
+		if(c2m->libreq.concat) c2m_string_append(a, c2m_prelude_set_cat);
+	}
+	if(c2m->libreq.par) {
+		c2m_string_append(a, c2m->libreq.io ?
+			"#define C2M_PAR_DONE c2m_io_flush()\n" :
+			"#define C2M_PAR_DONE\n");
+		c2m_string_append(a, c2m_prelude_par);
+	}
+	if(c2m->libreq.agg) c2m_string_append(a, c2m_prelude_agg);
+	if(c2m->libreq.co) c2m_string_append(a, c2m_prelude_co);
+	if(c2m->libreq.trace) c2m_string_append(a, "#include <c2m_trace.c>\n");
+	if(c2m->libreq.bench) c2m_string_append(a, c2m_prelude_bench);
+	if(c2m->libreq.lines) c2m_string_append(a, c2m_prelude_lines);
+	if(c2m->libreq.profile)
+		c2m_string_append(a, "#include <c2m_profile.c>\n");
+}
+
+static inline uint32_t c2m_prelude_bits(c2m_t* c2m) {
+	return c2m->libreq.stdio | c2m->libreq.stdlib << 1 |
+		c2m->libreq.clump << 2 | c2m->libreq.sdl << 3 |
+		c2m->libreq.sdl_window << 4 | c2m->libreq.sdl_audio << 5 |
+		c2m->libreq.string << 6 | c2m->libreq.concat << 7 |
+		c2m->libreq.io << 8 | c2m->libreq.args << 9 |
+		c2m->libreq.list << 10 | c2m->libreq.set << 11 |
+		c2m->libreq.par << 12 | c2m->libreq.co << 13 |
+		c2m->libreq.trace << 14 | c2m->libreq.bench << 15 |
+		c2m->libreq.agg << 16 | c2m->libreq.lines << 17 |
+		c2m->libreq.profile << 18;
+}
+
+// The other way around, for bits stored in a library index or interface.
+static inline void c2m_libreq_unpack(c2m_libreq_t* libreq, uint32_t bits) {
+	libreq->stdio = bits & 1;
+	libreq->stdlib = bits >> 1 & 1;
+	libreq->clump = bits >> 2 & 1;
+	libreq->sdl = bits >> 3 & 1;
+	libreq->sdl_window = bits >> 4 & 1;
+	libreq->sdl_audio = bits >> 5 & 1;
+	libreq->string = bits >> 6 & 1;
+	libreq->concat = bits >> 7 & 1;
+	libreq->io = bits >> 8 & 1;
+	libreq->args = bits >> 9 & 1;
+	libreq->list = bits >> 10 & 1;
+	libreq->set = bits >> 11 & 1;
+	libreq->par = bits >> 12 & 1;
+	libreq->co = bits >> 13 & 1;
+	libreq->trace = bits >> 14 & 1;
+	libreq->bench = bits >> 15 & 1;
+	libreq->agg = bits >> 16 & 1;
+	libreq->lines = bits >> 17 & 1;
+	libreq->profile = bits >> 18 & 1;
+}
+
+/*
+ * Make sure the prelude for this program's headers is built & set
+ * c2m->prelude, returns 1 if it couldn't be ( the build goes on without ).
+*/
+static uint8_t c2m_prelude_prepare(c2m_t* c2m) {
+	struct cl_array* header = c2m_string_create(NULL);
+	struct cl_array* text = c2m_string_create(NULL);
+	struct cl_array* command = c2m_string_create(NULL);
+	struct cl_array* pch = c2m_string_create(NULL);
+	struct stat info;
+	uint8_t failed = 0;
+	uint64_t hash;
+
+	mkdir(C2M_CACHE_DIR, 0755);
+	c2m_string_append(text, "#define C2M_PRELUDE\n");
+	c2m_prelude_includes(c2m, text);
+	// Same compiler & flags as the program, a mismatched PCH isn't used.
+	c2m_string_append(command, c2m->compiler);
+	for(uint32_t i = 0; i < cl_array_count(c2m->flags); i++) {
+		c2m_string_append_n(command, " ", 1);
+		c2m_string_append(command, *(char**)cl_array_borrow(c2m->flags, i));
+	}
+	c2m_string_append(command, " -I" C2M_RUNTIME_DIR);
+	// Named by both, so a c2m that emits other helpers doesn't reuse it.
+	hash = c2m_hash(C2M_HASH_INIT, text->store, c2m_string_length(text));
+	hash = c2m_hash(hash, command->store, c2m_string_length(command));
+	c2m_string_appendf(header, C2M_CACHE_DIR "/prelude-%016llx.h",
+		(unsigned long long)hash);
+	c2m_string_appendf(command, " -x c-header %s -o %s.pch",
+		(char*)header->store, (char*)header->store);
+	c2m_string_appendf(pch, "%s.pch", (char*)header->store);
+	if(stat(pch->store, &info)) {
+		SDL_RWops* file = SDL_RWFromFile(header->store, "w");
+
+		if(file == NULL || SDL_RWwrite(file, text->store, 1,
+			c2m_string_length(text)) != c2m_string_length(text))
+		{
+			failed = 1;
+		}
+		if(file) SDL_RWclose(file);
+		fputs("Building prelude\n", stdout);
+		if(failed == 0 && system(command->store)) failed = 1;
+	}
+	c2m_string_destroy(text);
+	c2m_string_destroy(command);
+	c2m_string_destroy(pch);
+	if(failed) {
+		c2m_string_destroy(header);
+		return 1;
+	}
+	c2m->prelude = header->store; // Kept for the rest of the compile
+	return 0;
+}
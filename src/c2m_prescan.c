@@ -0,0 +1,246 @@
+// Prescan of a library module that isn't indexed ( see c2m_module_parse ):
+// each top level definition's name & bytes in the source are found by
+// matching its braces instead of lexing it, then it's parsed the first time
+// it's looked up ( c2m_module_find ).  So importing a few functions of a
+// large module costs a scan of its bytes, not a parse of all of them.  Quotes
+// & comments end with the line ( as lexed ), braces in them don't count.  The
+// bytes in between are skipped 16 at a time with SSE2 ( if the CPU has it )
+// or NEON, like the lexer's runs.  Imports are parsed once the scan's done.
+// Anything else at the top level, a definition that doesn't end or one
+// defined twice leaves the module to be parsed whole, which reports it.
+
+// A definition's bytes, up to & including the newline after its "}".
+typedef struct{
+	uint32_t start;
+	uint32_t end;
+	uint32_t line; // It starts on
+}c2m_prescan_def_t;
+
+static inline uint8_t c2m_prescan_stop(char c) {
+	return c == '{' || c == '}' || c == '"' || c == '\'' || c == '/' ||
+		c == '\n';
+}
+
+#ifdef C2M_LEX_SSE2
+// Skip whole blocks of 16 bytes with nothing to stop at.
+__attribute__((target("sse2")))
+static uint32_t c2m_prescan_skip_sse2(const char* source, uint32_t i,
+	uint32_t size)
+{
+	while(i + 16 <= size) {
+		__m128i v = _mm_loadu_si128((const __m128i*)&source[i]);
+		__m128i stop = _mm_or_si128(_mm_or_si128(_mm_or_si128(
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('{')),
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('}'))),
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('\'')))),
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')),
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+		uint32_t mask = _mm_movemask_epi8(stop);
+
+		if(mask) return i + __builtin_ctz(mask);
+		i += 16;
+	}
+	return i;
+}
+#endif
+
+#ifdef C2M_LEX_NEON
+// Same as c2m_prescan_skip_sse2.
+static uint32_t c2m_prescan_skip_neon(const char* source, uint32_t i,
+	uint32_t size)
+{
+	while(i + 16 <= size) {
+		uint8x16_t v = vld1q_u8((const uint8_t*)&source[i]);
+		uint8x16_t stop = vorrq_u8(vorrq_u8(vorrq_u8(
+			vceqq_u8(v, vdupq_n_u8('{')),
+			vceqq_u8(v, vdupq_n_u8('}'))),
+			vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')),
+			vceqq_u8(v, vdupq_n_u8('\'')))),
+			vorrq_u8(vceqq_u8(v, vdupq_n_u8('/')),
+			vceqq_u8(v, vdupq_n_u8('\n'))));
+		// 4 bits per byte, set where a byte is one to stop at.
+		uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(
+			vreinterpretq_u16_u8(stop), 4)), 0);
+
+		if(mask) return i + __builtin_ctzll(mask) / 4;
+		i += 16;
+	}
+	return i;
+}
+#endif
+
+// Offset of the first brace, quote, slash or newline from `i` ( or `size` ).
+static inline uint32_t c2m_prescan_skip(const char* source, uint32_t i,
+	uint32_t size)
+{
+#if defined(C2M_LEX_SSE2)
+	if(c2m_lex_sse2) i = c2m_prescan_skip_sse2(source, i, size);
+#elif defined(C2M_LEX_NEON)
+	i = c2m_prescan_skip_neon(source, i, size);
+#endif
+	while(i < size && c2m_prescan_stop(source[i]) == 0) i++;
+	return i;
+}
+
+/*
+ * Returns the offset after the "}" ending the definition at `i` & counts the
+ * lines it spans in `line`, or 0 if it doesn't end: a quote doesn't, or its
+ * first line has no "{".
+*/
+static uint32_t c2m_prescan_end(const char* source, uint32_t i,
+	uint32_t size, uint32_t* line)
+{
+	uint32_t depth = 0;
+
+	while((i = c2m_prescan_skip(source, i, size)) < size) {
+		char c = source[i++];
+
+		if(c == '{') {
+			depth++;
+		}else if(c == '}') {
+			if(depth == 0) return 0;
+			if(--depth == 0) return i;
+		}else if(c == '\n') {
+			if(depth == 0) return 0;
+			(*line)++;
+		}else if(c == '/') {
+			// A comment, up to the newline.
+			if(i < size && source[i] == '/') {
+				while(i < size && source[i] != '\n') i++;
+			}
+		}else{
+			while(i < size && source[i] != c && source[i] != '\n')
+				i += source[i] == '\\' && i + 1 < size ? 2 : 1;
+			if(i >= size || source[i] != c) return 0;
+			i++;
+		}
+	}
+	return 0;
+}
+
+// Offset after the blanks from `i`.
+static inline uint32_t c2m_prescan_blanks(const char* source, uint32_t i,
+	uint32_t size)
+{
+	while(i < size && c2m_lex_isblank(source[i])) i++;
+	return i;
+}
+
+// Offset after the identifier at `i`.
+static inline uint32_t c2m_prescan_word(const char* source, uint32_t i,
+	uint32_t size)
+{
+	while(i < size && c2m_lex_isident(source[i])) i++;
+	return i;
+}
+
+// Returns 1 if only blanks & maybe a comment are left on the line at `i`,
+// which is moved past its newline.
+static uint8_t c2m_prescan_line_end(const char* source, uint32_t* i,
+	uint32_t size)
+{
+	uint32_t at = c2m_prescan_blanks(source, *i, size);
+
+	if(at + 1 < size && source[at] == '/' && source[at + 1] == '/')
+		while(at < size && source[at] != '\n') at++;
+	if(at < size && source[at] != '\n') return 0;
+	*i = at < size ? at + 1 : size;
+	return 1;
+}
+
+// Parse the import on `def`'s line, an error's recorded & the line skipped.
+static void c2m_prescan_import(c2m_t* c2m, const char* source,
+	c2m_prescan_def_t* def)
+{
+	jmp_buf* outer = c2m->recover;
+	c2m_lexer_t lex;
+	jmp_buf jump;
+
+	c2m_lex_from(&lex, &source[def->start], def->end - def->start,
+		def->line);
+	c2m->recover = &jump;
+	if(setjmp(jump) == 0) {
+		lex.pos++; // "import"
+		c2m_parse_import(c2m, &lex);
+	}
+	c2m->recover = outer;
+	c2m_lex_destroy(&lex);
+}
+
+/*
+ * Add every top level definition of `source` to `functions` unparsed
+ * ( SYMBOL_UNPARSED, in c2m->arena ) & parse the imports.  Returns 1 if the
+ * module has to be parsed whole, `functions` is left empty then.
+*/
+static uint8_t c2m_prescan(c2m_t* c2m, const char* source, uint32_t size,
+	c2m_symtab_t* functions)
+{
+	struct cl_array* imports = cl_array_create(sizeof(c2m_prescan_def_t), 4);
+	uint32_t i = 0, line = 1;
+	uint8_t failed = 0;
+
+	while(i < size && failed == 0) {
+		uint32_t start = i, name, length, end;
+		c2m_prescan_def_t def;
+		const char* key;
+
+		if(c2m_prescan_line_end(source, &i, size)) {
+			line++;
+			continue;
+		}
+		name = c2m_prescan_blanks(source, i, size);
+		length = c2m_prescan_word(source, name, size) - name;
+		def.start = start;
+		def.line = line;
+		if(length == 6 && memcmp(&source[name], "import", 6) == 0) {
+			// Its library's checked by c2m_parse_import().
+			i = c2m_prescan_word(source, c2m_prescan_blanks(source,
+				name + length, size), size);
+			failed = c2m_prescan_line_end(source, &i, size) == 0;
+			def.end = i;
+			*(c2m_prescan_def_t*)cl_array_add(imports) = def;
+			line++;
+			continue;
+		}
+		// "trace name(" & "async name(", see c2m_parse_function().
+		for(uint32_t n = 0; n < 2 && length == 5 &&
+			(memcmp(&source[name], "trace", 5) == 0 ||
+			memcmp(&source[name], "async", 5) == 0); n++)
+		{
+			end = c2m_prescan_blanks(source, name + length, size);
+			if(end == name + length || end == size ||
+				c2m_lex_isident(source[end]) == 0)
+			{
+				break;
+			}
+			name = end;
+			length = c2m_prescan_word(source, name, size) - name;
+		}
+		end = c2m_prescan_blanks(source, name + length, size);
+		if(length == 0 || end == size || source[end] != '(' ||
+			(i = c2m_prescan_end(source, end, size, &line)) == 0 ||
+			c2m_prescan_line_end(source, &i, size) == 0)
+		{
+			failed = 1;
+			break;
+		}
+		line++;
+		def.end = i;
+		key = c2m_intern(c2m->intern, &source[name], length);
+		if(c2m_symtab_get(functions, key)) {
+			failed = 1;
+			break;
+		}
+		c2m_symtab_add(functions, key, SYMBOL_UNPARSED, 0, memcpy(
+			c2m_arena_alloc(c2m->arena, sizeof(def)), &def, sizeof(def)));
+	}
+	if(failed) {
+		c2m_symtab_clear(functions);
+	}else{
+		for(uint32_t n = 0; n < cl_array_count(imports); n++)
+			c2m_prescan_import(c2m, source, cl_array_borrow(imports, n));
+	}
+	cl_array_destroy(imports);
+	return failed;
+}
@@ -0,0 +1,327 @@
+// Sampling profiler ( C2M_PROFILE=<file> for a program built with --profile
+// ): SIGPROF at C2M_PROFILE_HZ of CPU time, each sample the interrupted
+// thread's stack walked by its frame pointers, written at exit as folded
+// stacks ( "main (src/main.c2m:1);util.sum (lib/util.c2m:4) 12", a line per
+// distinct stack with its count ) for flamegraph.pl, speedscope & the like.
+// Frames are symbolized by the entries the compiler puts after each function
+// ( C2M_PROFILE_FN, gathered in a section by the linker, so a split build's
+// static functions are there too ): its address, "module.function", file &
+// the line it's defined on, the nearest one at or before a PC is its
+// function.  So attribution's per function, a line within one needs debug
+// info ( --debug & perf ).  Samples go into a pool allocated at start, a
+// thread claims C2M_PROFILE_CHUNK of them at a time with one atomic add &
+// fills them from its handler with nothing else shared.  A sample's depth is
+// published last ( release ), so one cut off by exit isn't read.  Walking
+// stops at the first return address outside the program's text, code not
+// built with frame pointers ( the C library ) is never walked through: time
+// in it is "[outside c2m]", with no callers.
+//
+// Only the C library & POSIX are used, like c2m_trace.c, on Linux ( x86-64 &
+// AArch64, the others record nothing ).  The pool's state is static, only
+// main's unit starts it.
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define C2M_PROFILE 1
+#include <errno.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#endif
+
+// Entries only work with functions in the order they're defined, GCC
+// otherwise moves main() & cold code to sections of their own.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("no-reorder-functions")
+#endif
+
+#define C2M_PROFILE_HZ 1000
+#define C2M_PROFILE_DEPTH 32 // Frames kept per sample, the innermost
+#define C2M_PROFILE_CHUNK 256 // Samples a thread claims at once
+#define C2M_PROFILE_SAMPLES (C2M_PROFILE_CHUNK * 256) // A minute or so
+
+// A function the compiler emitted, see c2m_emit_profile().
+typedef struct{
+	void (*fn)(void);
+	const char* name; // "module.function"
+	const char* file;
+	uint32_t line;
+}c2m_profile_fn_t;
+
+#ifdef C2M_PROFILE
+#define C2M_PROFILE_FN(fn, name, file, line) \
+	__attribute__((used, section("c2m_profile_fns"))) \
+	static const c2m_profile_fn_t c2m_profile_##fn = \
+		{ (void (*)(void))fn, name, file, line };
+
+// Every unit's entries, from the linker.
+extern const c2m_profile_fn_t __start_c2m_profile_fns[] __attribute__((weak));
+extern const c2m_profile_fn_t __stop_c2m_profile_fns[] __attribute__((weak));
+#define C2M_PROFILE_FNS __start_c2m_profile_fns
+#define C2M_PROFILE_N_FNS ((uint32_t)(__stop_c2m_profile_fns - \
+	__start_c2m_profile_fns))
+#else
+#define C2M_PROFILE_FN(fn, name, file, line)
+#define C2M_PROFILE_FNS ((const c2m_profile_fn_t*)NULL)
+#define C2M_PROFILE_N_FNS 0u
+#endif
+
+typedef struct{
+	atomic_uint n; // Frames in pc, 0 until it's written
+	uintptr_t pc[C2M_PROFILE_DEPTH]; // Innermost first
+}c2m_profile_sample_t;
+
+typedef struct{
+	const char* path;
+	c2m_profile_sample_t* samples;
+	atomic_uint claimed; // Samples handed out to threads
+	atomic_uint dropped; // Taken once the pool ran out
+}c2m_profile_state_t;
+
+static c2m_profile_state_t c2m_profile;
+// This thread's samples left: [next, end) of c2m_profile.samples.
+static _Thread_local uint32_t c2m_profile_next;
+static _Thread_local uint32_t c2m_profile_end;
+
+#ifdef C2M_PROFILE
+// Set by the linker: the program's code is in between.
+extern const char __executable_start[];
+extern const char etext[];
+
+static inline uint8_t c2m_profile_ours(uintptr_t pc) {
+	return pc >= (uintptr_t)__executable_start && pc < (uintptr_t)etext;
+}
+
+// The interrupted PC, frame & stack pointers.
+static inline void c2m_profile_registers(void* context, uintptr_t* pc,
+	uintptr_t* fp, uintptr_t* sp)
+{
+	ucontext_t* uc = context;
+
+#if defined(__x86_64__)
+	// REG_RIP & co. are only named with _GNU_SOURCE.
+	*pc = uc->uc_mcontext.gregs[16];
+	*fp = uc->uc_mcontext.gregs[10];
+	*sp = uc->uc_mcontext.gregs[15];
+#else
+	*pc = uc->uc_mcontext.pc;
+	*fp = uc->uc_mcontext.regs[29];
+	*sp = uc->uc_mcontext.sp;
+#endif
+}
+
+/*
+ * A frame is its caller's frame pointer & the return address, pushed by our
+ * code's prologue.  Each must be above the last, aligned & not too far from
+ * it, or it's not a frame.
+*/
+static uint32_t c2m_profile_walk(uintptr_t* pc, uintptr_t fp, uintptr_t sp)
+{
+	uint32_t n = 1;
+
+	if(c2m_profile_ours(pc[0]) == 0) return 1;
+	while(n < C2M_PROFILE_DEPTH && fp >= sp && fp % sizeof(uintptr_t) == 0) {
+		const uintptr_t* frame = (const uintptr_t*)fp;
+		uintptr_t ret = frame[1];
+
+		if(c2m_profile_ours(ret) == 0) break;
+		pc[n++] = ret - 1; // In the call, not after it
+		sp = fp + 2 * sizeof(uintptr_t);
+		fp = frame[0];
+		if(fp < sp || fp - sp > (1u << 20)) break;
+	}
+	return n;
+}
+
+static void c2m_profile_signal(int sig, siginfo_t* info, void* context) {
+	c2m_profile_sample_t* sample;
+	uintptr_t fp, sp;
+	uint32_t i = c2m_profile_next;
+	int saved = errno;
+
+	(void)sig;
+	(void)info;
+	if(i == c2m_profile_end) {
+		i = atomic_fetch_add_explicit(&c2m_profile.claimed,
+			C2M_PROFILE_CHUNK, memory_order_relaxed);
+		if(i >= C2M_PROFILE_SAMPLES) {
+			atomic_fetch_add_explicit(&c2m_profile.dropped, 1,
+				memory_order_relaxed);
+			errno = saved;
+			return;
+		}
+		c2m_profile_end = i + C2M_PROFILE_CHUNK;
+	}
+	c2m_profile_next = i + 1;
+	sample = &c2m_profile.samples[i];
+	c2m_profile_registers(context, &sample->pc[0], &fp, &sp);
+	atomic_store_explicit(&sample->n, c2m_profile_walk(sample->pc, fp, sp),
+		memory_order_release);
+	errno = saved;
+}
+
+static void c2m_profile_timer(long usec) {
+	struct itimerval timer = { { 0, usec }, { 0, usec } };
+
+	setitimer(ITIMER_PROF, &timer, NULL);
+}
+#endif
+
+// A function's entry & where it is in C2M_PROFILE_FNS.
+typedef struct{
+	uintptr_t start;
+	uint32_t index;
+}c2m_profile_entry_t;
+
+static int c2m_profile_by_start(const void* a, const void* b) {
+	uintptr_t x = ((const c2m_profile_entry_t*)a)->start;
+	uintptr_t y = ((const c2m_profile_entry_t*)b)->start;
+
+	return x < y ? -1 : x > y;
+}
+
+static int c2m_profile_by_text(const void* a, const void* b) {
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// The frame at `pc`, appended to `out` ( `size` bytes from `at` ).
+static size_t c2m_profile_frame(const c2m_profile_entry_t* entries,
+	uint32_t n, uintptr_t pc, char* out, size_t at, size_t size)
+{
+	const c2m_profile_fn_t* fn = NULL;
+	uint32_t lo = 0, hi = n;
+	int length;
+
+	// The last entry starting at or before pc.
+	while(lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+
+		if(entries[mid].start <= pc) lo = mid + 1;
+		else hi = mid;
+	}
+#ifdef C2M_PROFILE
+	if(c2m_profile_ours(pc) == 0) {
+		length = snprintf(&out[at], size - at, "[outside c2m]");
+	}else
+#endif
+	if(lo == 0) {
+		length = snprintf(&out[at], size - at, "[runtime]");
+	}else{
+		fn = &C2M_PROFILE_FNS[entries[lo - 1].index];
+		length = snprintf(&out[at], size - at, "%s (%s:%u)", fn->name,
+			fn->file, (unsigned)fn->line);
+	}
+	if(length < 0) return at;
+	return at + (size_t)length < size ? at + length : size - 1;
+}
+
+/*
+ * Stop sampling & write the folded stacks, returns 1 if the file couldn't be
+ * written.  Nothing's written if profiling's off.
+*/
+static uint8_t c2m_profile_flush(void) {
+	uint32_t n_fns = C2M_PROFILE_N_FNS, claimed, n_stacks = 0;
+	c2m_profile_entry_t* entries;
+	char** stacks;
+	FILE* file;
+
+	if(c2m_profile.samples == NULL) return 0;
+#ifdef C2M_PROFILE
+	c2m_profile_timer(0);
+	signal(SIGPROF, SIG_IGN);
+#endif
+	claimed = atomic_load(&c2m_profile.claimed);
+	if(claimed > C2M_PROFILE_SAMPLES) claimed = C2M_PROFILE_SAMPLES;
+	entries = malloc(sizeof(c2m_profile_entry_t) * (n_fns + 1));
+	stacks = malloc(sizeof(char*) * (claimed + 1));
+	if(entries == NULL || stacks == NULL ||
+		(file = fopen(c2m_profile.path, "w")) == NULL)
+	{
+		free(entries);
+		free(stacks);
+		return 1;
+	}
+	for(uint32_t i = 0; i < n_fns; i++) {
+		entries[i].start = (uintptr_t)C2M_PROFILE_FNS[i].fn;
+		entries[i].index = i;
+	}
+	qsort(entries, n_fns, sizeof(c2m_profile_entry_t),
+		c2m_profile_by_start);
+	// Each sample as text, outermost frame first.
+	for(uint32_t i = 0; i < claimed; i++) {
+		c2m_profile_sample_t* sample = &c2m_profile.samples[i];
+		uint32_t depth = atomic_load_explicit(&sample->n,
+			memory_order_acquire);
+		size_t at = 0, size = depth * 256 + 1; // Cut off past that
+		char* text;
+
+		if(depth == 0 || (text = malloc(size)) == NULL) continue;
+		while(depth--) {
+			at = c2m_profile_frame(entries, n_fns, sample->pc[depth], text,
+				at, size);
+			if(depth && at + 1 < size) text[at++] = ';';
+		}
+		text[at] = '\0';
+		stacks[n_stacks++] = text;
+	}
+	qsort(stacks, n_stacks, sizeof(char*), c2m_profile_by_text);
+	for(uint32_t i = 0; i < n_stacks;) {
+		uint32_t same = i + 1;
+
+		while(same < n_stacks && strcmp(stacks[same], stacks[i]) == 0)
+			free(stacks[same++]);
+		fprintf(file, "%s %u\n", stacks[i], same - i);
+		free(stacks[i]);
+		i = same;
+	}
+	if(atomic_load(&c2m_profile.dropped)) {
+		fprintf(stderr, "Profile: %u samples dropped, the buffer's full\n",
+			atomic_load(&c2m_profile.dropped));
+	}
+	free(c2m_profile.samples);
+	c2m_profile.samples = NULL;
+	free(entries);
+	free(stacks);
+	return fclose(file) != 0;
+}
+
+static void c2m_profile_exit(void) {
+	if(c2m_profile_flush())
+		fprintf(stderr, "Couldn't write the profile %s\n", c2m_profile.path);
+}
+
+/*
+ * Start sampling, to write `path` at exit.  NULL or "" leaves profiling off,
+ * as does a platform it can't sample on.
+*/
+static void c2m_profile_start(const char* path) {
+#ifdef C2M_PROFILE
+	struct sigaction action;
+
+	if(path == NULL || path[0] == '\0' || c2m_profile.samples) return;
+	// Pages are only touched as samples are taken.
+	c2m_profile.samples = calloc(C2M_PROFILE_SAMPLES,
+		sizeof(c2m_profile_sample_t));
+	if(c2m_profile.samples == NULL) return;
+	c2m_profile.path = path;
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = c2m_profile_signal;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGPROF, &action, NULL);
+	atexit(c2m_profile_exit);
+	c2m_profile_timer(1000000 / C2M_PROFILE_HZ);
+#else
+	(void)path;
+#endif
+}
+
+// A program's runtime: started from the environment.
+static void c2m_profile_start_env(void) {
+	c2m_profile_start(getenv("C2M_PROFILE"));
+}
@@ -0,0 +1,104 @@
+// Records: value types compiled to plain C structs, never boxed.  Fields are
+// laid out largest alignment first so there's no padding between them, a
+// record parameter is passed by value when it fits in two registers and by
+// const pointer otherwise.  A collection of a record ( "Record[] name", see
+// c2m_emit_rows ) is an array of the structs, or an array per field when the
+// record's defined "soa Record(...)": a scan over one field then reads only
+// that field's bytes, contiguous, a shape C compilers vectorize.  "name[i]"
+// & "name[i].field" read either the same way.
+
+#define C2M_RECORD_BY_VALUE 16 // Largest record passed by value, in bytes
+
+#define C2M_RECORD_SOA 1 // A collection's an array per field
+#define C2M_RECORD_ROWS 2 // Kept in a collection, its C type is emitted
+
+static uint32_t c2m_type_size(uint8_t type, c2m_node_t* record);
+
+static uint32_t c2m_type_align(uint8_t type, c2m_node_t* record) {
+	uint32_t align = 1;
+
+	if(type == TYPE_STRING || type == TYPE_LIST) return sizeof(void*);
+	if(type == TYPE_SET) return 8;
+	if(type != TYPE_RECORD) return c2m_type_size(type, NULL);
+	for(c2m_node_t* field = record->child; field; field = field->next) {
+		uint32_t field_align = c2m_type_align(field->type, field->record);
+
+		if(field_align > align) align = field_align;
+	}
+	return align;
+}
+
+/*
+ * Fill `fields` ( one per field ) with the record's fields in layout order:
+ * alignment descending, as written when it's the same.  Returns the count.
+*/
+static uint32_t c2m_record_fields(c2m_node_t* record, c2m_node_t** fields) {
+	uint32_t n = 0;
+
+	for(c2m_node_t* field = record->child; field; field = field->next) {
+		uint32_t align = c2m_type_align(field->type, field->record);
+		uint32_t i = n++;
+
+		while(i && c2m_type_align(fields[i - 1]->type, fields[i - 1]->record)
+			< align)
+		{
+			fields[i] = fields[i - 1];
+			i--;
+		}
+		fields[i] = field;
+	}
+	return n;
+}
+
+static inline uint32_t c2m_record_count(c2m_node_t* record) {
+	uint32_t n = 0;
+
+	for(c2m_node_t* field = record->child; field; field = field->next) n++;
+	return n;
+}
+
+static uint32_t c2m_type_size(uint8_t type, c2m_node_t* record) {
+	switch(type) {
+	case TYPE_UBYTE: case TYPE_SBYTE: return 1;
+	case TYPE_USHORT: case TYPE_SSHORT: return 2;
+	case TYPE_UINT32: case TYPE_SINT32: case TYPE_FLOAT32: return 4;
+	case TYPE_UINT64: case TYPE_SINT64: case TYPE_FLOAT64: return 8;
+	case TYPE_INTEGER: return 8;
+	case TYPE_STRING: return sizeof(void*) + sizeof(size_t); // c2m_str_t
+	case TYPE_LIST: // c2m_list_t, 4 strings inline
+		return sizeof(void*) + 8 + 4 * c2m_type_size(TYPE_STRING, NULL);
+	case TYPE_SET: return 32; // c2m_set_t, 4 words
+	case TYPE_RECORD: break;
+	default: return sizeof(void*); // Pointers
+	}
+
+	uint32_t align = c2m_type_align(type, record);
+	uint32_t size = 0;
+	c2m_node_t** fields = malloc(sizeof(c2m_node_t*) *
+		c2m_record_count(record));
+	uint32_t n = c2m_record_fields(record, fields);
+
+	for(uint32_t i = 0; i < n; i++) {
+		uint32_t field_align = c2m_type_align(fields[i]->type,
+			fields[i]->record);
+
+		size = (size + field_align - 1) / field_align * field_align;
+		size += c2m_type_size(fields[i]->type, fields[i]->record);
+	}
+	free(fields);
+	return (size + align - 1) / align * align;
+}
+
+// Returns 1 if a `record` parameter is passed as a const pointer.
+static inline uint8_t c2m_record_indirect(c2m_node_t* record) {
+	return c2m_type_size(TYPE_RECORD, record) > C2M_RECORD_BY_VALUE;
+}
+
+/*
+ * Returns NULL if `record` has no field `name` ( interned ).
+*/
+static c2m_node_t* c2m_record_field(c2m_node_t* record, const char* name) {
+	for(c2m_node_t* field = record->child; field; field = field->next)
+		if(field->text == name) return field;
+	return NULL;
+}
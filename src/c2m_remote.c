@@ -0,0 +1,221 @@
+// Remote build cache ( --remote-cache=<url>, or $C2M_REMOTE_CACHE ): the
+// .c2m-cache of every machine pointed at the same HTTP blob store ( anything
+// taking GET & PUT of a path, an S3-compatible bucket with
+// $C2M_REMOTE_CACHE_SIGV4 & $C2M_REMOTE_CACHE_USER ) is shared.  Blobs are
+// named by content, so nothing's ever overwritten by something different:
+// "<hash>.c", ".bin" & ".h" by the hash of the generated C & the C compiler
+// command ( c2m->output_hash ), each a build's manifest by the hash of what's
+// known before translating ( c2m_remote_key ).  A manifest fetched is then
+// checked like a local one, so a key that doesn't cover every input only
+// misses.  Every name is also hashed with the namespace: this c2m & the C
+// compiler's version, so different compilers never share.  Builds for the
+// host's CPU ( "native" ) aren't shared.  The generated C is the same for the
+// same inputs ( no times, addresses or absolute paths but those given ), or
+// keys would never match.  The store is trusted: binaries from it are run.
+// Transfers are curl's, a failed one is a miss & the build goes on.
+
+#if defined(__unix__) || defined(__APPLE__)
+#define C2M_REMOTE 1
+#endif
+
+/*
+ * Run curl with `args` ( after "curl -fs" ) on the URL of blob `name`,
+ * returns 1 if it failed.
+*/
+static uint8_t c2m_remote_curl(c2m_t* c2m, const char** args,
+	uint64_t name, const char* ext)
+{
+#ifdef C2M_REMOTE
+	const char* sigv4 = getenv("C2M_REMOTE_CACHE_SIGV4");
+	const char* user = getenv("C2M_REMOTE_CACHE_USER");
+	struct cl_array* url = c2m_string_create(NULL);
+	size_t length = strlen(c2m->remote);
+	const char* argv[12] = { "curl", "-fs" };
+	uint32_t n = 2;
+	int status = 1;
+	pid_t pid;
+
+	c2m_string_appendf(url, "%s%s%016llx%s", c2m->remote,
+		length && c2m->remote[length - 1] == '/' ? "" : "/",
+		(unsigned long long)name, ext);
+	while(*args) argv[n++] = *args++;
+	if(sigv4 && user) {
+		argv[n++] = "--aws-sigv4";
+		argv[n++] = sigv4;
+		argv[n++] = "--user";
+		argv[n++] = user;
+	}
+	argv[n++] = url->store;
+	argv[n] = NULL;
+	fflush(stdout);
+	if((pid = fork()) == 0) {
+		// The C compiler would wait for curl to close its input.
+		if(c2m->backend_fd >= 0) close(c2m->backend_fd);
+		execvp(argv[0], (char**)argv);
+		_exit(127);
+	}
+	if(pid > 0 && waitpid(pid, &status, 0) != pid) status = 1;
+	c2m_string_destroy(url);
+	return pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+#else
+	return 1;
+#endif
+}
+
+// A blob's name in the store, the namespace's & `hash` hashed together.
+static inline uint64_t c2m_remote_name(c2m_t* c2m, uint64_t hash) {
+	return c2m_hash(c2m->remote_ns, &hash, sizeof(hash));
+}
+
+/*
+ * Fetch blob `hash` + `ext` into .c2m-cache ( unless it's there already ),
+ * returns 1 if it couldn't be.
+*/
+static uint8_t c2m_remote_get(c2m_t* c2m, uint64_t hash, const char* ext) {
+	struct cl_array* path = c2m_string_create(NULL);
+	struct cl_array* part = c2m_string_create(NULL);
+	const char* args[] = { "-o", NULL, NULL };
+	struct stat info;
+	uint8_t missing = 0;
+
+	c2m_cache_path(path, hash, ext);
+	if(stat(path->store, &info)) {
+		// Into place once it's all there, a cut off transfer isn't used.
+		c2m_string_appendf(part, "%s.part", (char*)path->store);
+		args[1] = part->store;
+		missing = c2m_remote_curl(c2m, args, c2m_remote_name(c2m, hash),
+			ext) || rename(part->store, path->store);
+		if(missing) remove(part->store);
+	}
+	c2m_string_destroy(part);
+	c2m_string_destroy(path);
+	return missing;
+}
+
+// Store `path` as blob `hash` + `ext`, a failure's only a later miss.
+static void c2m_remote_put(c2m_t* c2m, const char* path, uint64_t hash,
+	const char* ext)
+{
+	const char* args[] = { "-T", path, NULL };
+
+	if(c2m_remote_curl(c2m, args, c2m_remote_name(c2m, hash), ext))
+		c2m_log(C2M_LOG_DEBUG, "Couldn't store %016llx%s remotely\n",
+			(unsigned long long)hash, ext);
+}
+
+/*
+ * Work out the namespace ( this c2m & `compiler --version` ) & the key of
+ * the build's manifest: its options, the inputs read so far ( c2m.config )
+ * & the source translated first.  Returns 1 if the build can't be shared.
+*/
+static uint8_t c2m_remote_key(c2m_t* c2m) {
+	struct cl_array* command = c2m_string_create(NULL);
+	uint64_t options[4] = { c2m_cache_options(c2m), c2m->library_hash,
+		c2m->pgo, c2m->pgo_hash };
+	c2m_input_t* self = cl_array_borrow(c2m->inputs, 0);
+	uint64_t hash = C2M_HASH_INIT, source;
+	uint8_t failed = 0;
+	char line[256];
+	FILE* version;
+
+	for(uint32_t i = 0; i < cl_array_count(c2m->flags); i++) {
+		if(strstr(*(char**)cl_array_borrow(c2m->flags, i), "native"))
+			failed = 1;
+	}
+	c2m_string_appendf(command, "%s --version 2>/dev/null", c2m->compiler);
+	if(failed || (version = popen(command->store, "r")) == NULL) {
+		c2m_string_destroy(command);
+		return 1;
+	}
+	hash = c2m_hash(hash, C2M_CACHE_VERSION, sizeof(C2M_CACHE_VERSION));
+	while(fgets(line, sizeof(line), version))
+		hash = c2m_hash(hash, line, strlen(line));
+	// c2m itself is the first input, see c2m_cache_compiler.
+	c2m->remote_ns = c2m_hash(hash, &self->hash, sizeof(self->hash));
+	hash = c2m->remote_ns;
+	for(uint32_t i = 1; i < cl_array_count(c2m->inputs); i++) {
+		c2m_input_t* input = cl_array_borrow(c2m->inputs, i);
+
+		hash = c2m_hash(hash, &input->hash, sizeof(input->hash));
+		hash = c2m_hash(hash, input->path, strlen(input->path));
+	}
+	c2m_string_clear(command);
+	c2m_string_appendf(command, "src/%s.c2m", c2m->exports ? c2m->exports :
+		"main");
+	failed = pclose(version) != 0 ||
+		c2m_cache_hash_file(command->store, &source);
+	hash = c2m_hash(hash, options, sizeof(options));
+	c2m->remote_key = failed ? 0 : c2m_hash(hash, &source, sizeof(source));
+	c2m_string_destroy(command);
+	return failed;
+}
+
+/*
+ * Fetch the manifest for this build & the output it names, returns 1 if
+ * they aren't all there.  They're checked by c2m_cache_restore() after.
+*/
+static uint8_t c2m_remote_restore(c2m_t* c2m) {
+	struct cl_array* path;
+	unsigned long long output = 0;
+	char line[1024];
+	FILE* manifest;
+
+	if(c2m->remote == NULL || c2m_remote_key(c2m)) return 1;
+	mkdir(C2M_CACHE_DIR, 0755);
+	if(c2m_remote_get(c2m, c2m->remote_key, ".manifest")) return 1;
+	// In place of the local one, the key isn't content.
+	path = c2m_string_create(NULL);
+	c2m_cache_path(path, c2m->remote_key, ".manifest");
+	if(rename(path->store, C2M_CACHE_DIR "/manifest") == 0 &&
+		(manifest = fopen(C2M_CACHE_DIR "/manifest", "r")))
+	{
+		while(fgets(line, sizeof(line), manifest))
+			if(sscanf(line, "output %llx", &output) == 1) break;
+		fclose(manifest);
+	}
+	c2m_string_destroy(path);
+	return output == 0 || c2m_remote_get(c2m, output, ".c") ||
+		(c2m->emit_only == 0 && c2m_remote_get(c2m, output, ".bin")) ||
+		(c2m->emit_only == 0 && c2m->exports &&
+		c2m_remote_get(c2m, output, ".h"));
+}
+
+/*
+ * Returns 1 if the store has no binary for the generated C either, otherwise
+ * it's in .c2m-cache for c2m_cache_binary().
+*/
+static uint8_t c2m_remote_binary(c2m_t* c2m) {
+	if(c2m->remote == NULL || c2m->remote_key == 0 ||
+		c2m_remote_get(c2m, c2m->output_hash, ".bin"))
+	{
+		return 1;
+	}
+	c2m->remote_hit = 1;
+	return 0;
+}
+
+// Store what c2m_cache_save() kept ( the output unless it came from the
+// store ), the manifest last: it's only fetched with everything it names.
+static void c2m_remote_save(c2m_t* c2m) {
+	struct cl_array* path;
+
+	if(c2m->remote == NULL || c2m->remote_key == 0) return;
+	path = c2m_string_create(NULL);
+	if(c2m->remote_hit == 0) {
+		c2m_cache_path(path, c2m->output_hash, ".c");
+		c2m_remote_put(c2m, path->store, c2m->output_hash, ".c");
+	}
+	if(c2m->remote_hit == 0 && c2m->emit_only == 0) {
+		c2m_string_clear(path);
+		c2m_cache_path(path, c2m->output_hash, ".bin");
+		c2m_remote_put(c2m, path->store, c2m->output_hash, ".bin");
+		if(c2m->exports) {
+			c2m_string_clear(path);
+			c2m_cache_path(path, c2m->output_hash, ".h");
+			c2m_remote_put(c2m, path->store, c2m->output_hash, ".h");
+		}
+	}
+	c2m_remote_put(c2m, C2M_CACHE_DIR "/manifest", c2m->remote_key,
+		".manifest");
+	c2m_string_destroy(path);
+}
@@ -0,0 +1,41 @@
+// c2m run [args]: build the program for trying it & run it, passing `args`
+// on.  What's slow while iterating is the C compiler optimizing, so this
+// build's at -O0, with `run_compiler` from c2m.config instead of `compiler`
+// if it's set: one that compiles fast ( tcc ) over one that optimizes well.
+// It's <name>-run, so the real build isn't replaced, & cached like any build
+// ( its command's in the output hash, so it's a binary of its own ).
+
+#if defined(__unix__) || defined(__APPLE__)
+#define C2M_RUN_EXEC 1
+#endif
+
+/*
+ * Run the program just built with `args` ( NULL terminated ), in place of
+ * c2m if it can be.  Returns its exit status, or 1 if it couldn't be run.
+*/
+static int c2m_run(c2m_t* c2m, char** args) {
+	struct cl_array* command = c2m_string_create(NULL);
+	int status;
+
+	c2m_string_appendf(command, "./%s", c2m->output);
+	fflush(stdout);
+#ifdef C2M_RUN_EXEC
+	// argv[0] is the program's, the rest are already in place after it.
+	args[-1] = command->store;
+	execv(args[-1], &args[-1]);
+	printf("Couldn't run %s\n", (char*)command->store);
+	status = 1;
+#else
+	for(; *args; args++) {
+		c2m_string_append(command, " \"");
+		for(const char* c = *args; *c; c++) {
+			if(*c == '"') c2m_string_append(command, "\\\"");
+			else c2m_string_append_n(command, c, 1);
+		}
+		c2m_string_append(command, "\"");
+	}
+	status = system(command->store);
+#endif
+	c2m_string_destroy(command);
+	return status;
+}
@@ -0,0 +1,54 @@
+// The SDL runtime c2m runs on: threads, timers, RWops, logging, metrics & CPU
+// info, only the host's backends.  Built once into libc2m_runtime.a by the
+// Makefile & linked by the compiler, main.c reaches it through c2m_runtime.h.
+#define _GNU_SOURCE // Before any system header, for CPU affinity & futexes
+#include <sys/mman.h>
+
+#if defined(_WIN32)
+#include "../SDL2-c2m/src/timer/windows/SDL_systimer.c"
+#elif defined(__HAIKU__)
+#include "../SDL2-c2m/src/timer/haiku/SDL_systimer.c"
+#elif defined(__PSP__)
+#include "../SDL2-c2m/src/timer/psp/SDL_systimer.c"
+#else
+#include "../SDL2-c2m/src/timer/unix/SDL_systimer.c"
+#endif
+
+#include "../SDL2-c2m/src/SDL_hints.c"
+#include "../SDL2-c2m/src/atomic/SDL_atomic.c"
+#include "../SDL2-c2m/src/atomic/SDL_spinlock.c"
+
+#if defined(_WIN32)
+#include "../SDL2-c2m/src/thread/windows/SDL_sysmutex.c"
+#include "../SDL2-c2m/src/thread/windows/SDL_sysrwlock.c"
+#include "../SDL2-c2m/src/thread/windows/SDL_syssem.c"
+#include "../SDL2-c2m/src/thread/windows/SDL_systhread.c"
+#include "../SDL2-c2m/src/thread/windows/SDL_systls.c"
+#elif defined(__PSP__)
+#include "../SDL2-c2m/src/thread/psp/SDL_syscond.c"
+#include "../SDL2-c2m/src/thread/psp/SDL_sysmutex.c"
+#include "../SDL2-c2m/src/thread/generic/SDL_sysrwlock.c"
+#include "../SDL2-c2m/src/thread/psp/SDL_syssem.c"
+#include "../SDL2-c2m/src/thread/psp/SDL_systhread.c"
+#else
+#include "../SDL2-c2m/src/thread/pthread/SDL_syscond.c"
+#include "../SDL2-c2m/src/thread/pthread/SDL_sysmutex.c"
+#include "../SDL2-c2m/src/thread/pthread/SDL_sysrwlock.c"
+#include "../SDL2-c2m/src/thread/pthread/SDL_syssem.c"
+#include "../SDL2-c2m/src/thread/pthread/SDL_systhread.c"
+#include "../SDL2-c2m/src/thread/pthread/SDL_systls.c"
+#endif
+
+#include "../SDL2-c2m/src/thread/SDL_thread.c"
+#include "../SDL2-c2m/src/SDL_log.c"
+#include "../SDL2-c2m/src/SDL_metrics.c"
+#include "../SDL2-c2m/src/SDL_error.c"
+#include "../SDL2-c2m/src/stdlib/SDL_getenv.c"
+#include "../SDL2-c2m/src/stdlib/SDL_stdlib.c"
+#include "../SDL2-c2m/src/stdlib/SDL_string.c"
+#include "../SDL2-c2m/src/stdlib/SDL_iconv.c"
+#include "../SDL2-c2m/src/stdlib/SDL_malloc.c"
+#include "../SDL2-c2m/src/file/SDL_rwops.c"
+#include "../SDL2-c2m/src/file/SDL_rwasync.c"
+#include "../SDL2-c2m/src/file/SDL_rwjournal.c"
+#include "../SDL2-c2m/src/cpuinfo/SDL_cpuinfo.c"
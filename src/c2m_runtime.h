@@ -0,0 +1,5 @@
+// The SDL API of libc2m_runtime.a ( see c2m_runtime.c ).  It's built without
+// the dynamic API stubs, so declare & call the _REAL functions, as SDL does.
+#include <sys/mman.h>
+#include "../SDL2-c2m/src/SDL_internal.h"
+#include "SDL.h"
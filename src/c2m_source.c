@@ -0,0 +1,39 @@
+// Read-only source buffers, from SDL_RWFromFileMapped(): files are memory
+// mapped where possible, & read into memory once otherwise.  Buffers aren't
+// NUL terminated, the lexer works from the size.
+
+// POSIX: c2m_output & c2m_library check this for writev() & dirent.h too.
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define C2M_SOURCE_MMAP 1
+#endif
+
+typedef struct{
+	const char* data;
+	uint32_t size;
+	SDL_RWops* rw; // Owns data
+}c2m_source_t;
+
+/*
+ * Returns 1 if the file couldn't be opened.
+*/
+static uint8_t c2m_source_open(c2m_source_t* source, const char* filename) {
+	SDL_RWops* rw = SDL_RWFromFileMapped(filename);
+	size_t size;
+
+	if(rw == NULL) return 1;
+	source->data = SDL_RWMappedData(rw, &size);
+	if(size > UINT32_MAX) {
+		SDL_RWclose(rw);
+		return 1;
+	}
+	source->size = size;
+	source->rw = rw;
+	return 0;
+}
+
+static void c2m_source_close(c2m_source_t* source) {
+	SDL_RWclose(source->rw);
+}
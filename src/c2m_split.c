@@ -0,0 +1,292 @@
+// Separate compilation ( --split ): one translation unit per module plus
+// main in .c2m-build, sharing a generated c2m.h with the headers &
+// prototypes.  Units are compiled to objects by up to -j C compilers at once,
+// then linked.  A unit is only rewritten if its C changed & only recompiled
+// if it was rewritten ( or c2m.h was ), so unchanged modules are reused.  An
+// object is removed before it's rebuilt, a failed compile leaves none.  The
+// biggest units start first, so a long one doesn't finish alone at the end.
+// With --distcc each unit's compiled through distcc on the build nodes in
+// $DISTCC_HOSTS ( preprocessed here, so units needn't be self-contained ),
+// as many at once as they have slots.  distcc picks the least busy node for
+// each & compiles here when none can, linking is always here.
+
+#define C2M_SPLIT_DIR ".c2m-build"
+#define C2M_SPLIT_ARGS C2M_BACKEND_ARGS // A unit's command, or the link's
+
+typedef struct{
+	struct cl_array* source; // Path of the .c
+	struct cl_array* object; // Path of the .o
+	uint32_t size; // Of its C
+	uint8_t changed;
+}c2m_unit_t;
+
+/*
+ * Write `text` to `path` unless it already holds exactly that, returns 1 if
+ * the file was written.
+*/
+static uint8_t c2m_split_write(const char* path, struct cl_array* text) {
+	c2m_source_t old;
+	uint32_t length = c2m_string_length(text);
+	SDL_RWops* file;
+
+	if(c2m_source_open(&old, path) == 0) {
+		uint8_t same = old.size == length &&
+			memcmp(old.data, text->store, length) == 0;
+
+		c2m_source_close(&old);
+		if(same) return 0;
+	}
+	if((file = SDL_RWFromFile(path, "w")) == NULL ||
+		SDL_RWwrite(file, text->store, 1, length) != length)
+	{
+		printf("Can't write %s\n", path);
+		c2m_abort("couldn't write translation unit");
+	}
+	SDL_RWclose(file);
+	return 1;
+}
+
+// Write a unit, it needs compiling if it was rewritten or has no object.
+static void c2m_split_unit(c2m_unit_t* unit, const char* name,
+	struct cl_array* text, uint8_t header_changed)
+{
+	struct stat info;
+
+	unit->source = c2m_string_create(NULL);
+	unit->object = c2m_string_create(NULL);
+	c2m_string_appendf(unit->source, C2M_SPLIT_DIR "/%s.c", name);
+	c2m_string_appendf(unit->object, C2M_SPLIT_DIR "/%s.o", name);
+	unit->size = c2m_string_length(text);
+	unit->changed = c2m_split_write(unit->source->store, text) ||
+		header_changed || stat(unit->object->store, &info) != 0;
+}
+
+// Emit a module's functions ( job ), c2m_split_compile writes the unit.
+static void c2m_split_module(void* job) {
+	c2m_module_t* module = job;
+
+	c2m_module_emit_functions(module);
+}
+
+// Fill `args` with the command to compile `unit`, or link if it's NULL.
+static void c2m_split_args(c2m_t* c2m, char** args, c2m_unit_t* unit) {
+	uint32_t n = 0;
+
+	if(unit && c2m->distcc) args[n++] = "distcc";
+	n += c2m_backend_start(c2m, &args[n]);
+
+	if(c2m->lto) args[n++] = "-flto";
+	if(unit && c2m->exports) args[n++] = "-fPIC";
+	if(unit) {
+		args[n++] = "-c";
+		args[n++] = unit->source->store;
+		args[n++] = "-o";
+		args[n++] = unit->object->store;
+	}else if(c2m->exports) {
+		args[n++] = "-r"; // Into one object, like a single unit's
+	}else if(c2m->link_static) {
+		args[n++] = "-static";
+	}
+	args[n] = NULL;
+}
+
+/*
+ * Run `commands` ( NULL terminated argument lists ), at most `jobs` at once.
+ * Returns 1 if any failed.
+*/
+static uint8_t c2m_split_run(char*** commands, uint32_t count, uint32_t jobs)
+{
+	uint8_t failed = 0;
+#ifdef C2M_BACKEND_PIPE
+	uint32_t running = 0;
+	int status;
+
+	fflush(stdout);
+	for(uint32_t i = 0; i < count || running; ) {
+		if(i < count && running < jobs && failed == 0) {
+			pid_t pid = fork();
+
+			if(pid == 0) {
+				execvp(commands[i][0], commands[i]);
+				_exit(127);
+			}
+			if(pid < 0) failed = 1;
+			else running++;
+			i++;
+			continue;
+		}
+		if(running == 0) break;
+		if(wait(&status) < 0) return 1;
+		running--;
+		if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = 1;
+	}
+#else
+	for(uint32_t i = 0; i < count && failed == 0; i++) {
+		struct cl_array* command = c2m_string_create(NULL);
+
+		for(uint32_t j = 0; commands[i][j]; j++) {
+			if(j) c2m_string_append_n(command, " ", 1);
+			c2m_string_append(command, commands[i][j]);
+		}
+		failed = system(command->store) != 0;
+		c2m_string_destroy(command);
+	}
+#endif
+	return failed;
+}
+
+/*
+ * Returns how many units distcc's hosts compile at once ( "distcc -j" ), 0
+ * if it can't be run.
+*/
+static uint32_t c2m_split_distcc(void) {
+	FILE* distcc = popen("distcc -j 2>/dev/null", "r");
+	unsigned slots = 0;
+
+	if(distcc == NULL) return 0;
+	if(fscanf(distcc, "%u", &slots) != 1) slots = 0;
+	if(pclose(distcc) != 0) slots = 0;
+	return slots;
+}
+
+// Biggest first.
+static int c2m_split_order(const void* a, const void* b) {
+	const c2m_unit_t* x = *(c2m_unit_t* const*)a;
+	const c2m_unit_t* y = *(c2m_unit_t* const*)b;
+
+	return (x->size < y->size) - (x->size > y->size);
+}
+
+// Compile what changed, then link everything.
+static void c2m_split_build(c2m_t* c2m, c2m_unit_t* units, uint32_t n_units) {
+	char*** commands = malloc(sizeof(char**) * (n_units + 1));
+	char** link = malloc(sizeof(char*) * (n_units + C2M_SPLIT_ARGS));
+	c2m_unit_t** changed = malloc(sizeof(c2m_unit_t*) * n_units);
+	uint32_t n_commands = 0;
+	uint32_t jobs = c2m->jobs;
+	uint32_t n = 0;
+
+	for(uint32_t i = 0; i < n_units; i++)
+		if(units[i].changed) changed[n_commands++] = &units[i];
+	qsort(changed, n_commands, sizeof(c2m_unit_t*), c2m_split_order);
+	if(c2m->distcc && n_commands) {
+		uint32_t slots = c2m_split_distcc();
+
+		if(slots == 0) {
+			fputs("distcc can't be run, compiling here\n", stdout);
+			c2m->distcc = 0;
+		}else if(slots > jobs) {
+			jobs = slots;
+		}
+	}
+	for(uint32_t i = 0; i < n_commands; i++) {
+		remove(changed[i]->object->store);
+		commands[i] = malloc(sizeof(char*) * C2M_SPLIT_ARGS);
+		c2m_split_args(c2m, commands[i], changed[i]);
+	}
+	free(changed);
+	fputs("Stage 2\n", stdout);
+	printf("Compiling %u of %u units\n", n_commands, n_units);
+	if(c2m_split_run(commands, n_commands, jobs))
+		c2m_abort("C compiler failed");
+	c2m_split_args(c2m, link, NULL);
+	while(link[n]) n++;
+	for(uint32_t i = 0; i < n_units; i++)
+		link[n++] = units[i].object->store;
+	link[n++] = "-o";
+	link[n++] = c2m->output;
+	link[n] = NULL;
+	if(c2m_split_run(&link, 1, 1)) c2m_abort("Linking failed");
+	fputs("Compiled\n", stdout);
+	for(uint32_t i = 0; i < n_commands; i++) free(commands[i]);
+	free(commands);
+	free(link);
+}
+
+static void c2m_split_compile(c2m_t* c2m) {
+	uint32_t n_modules = cl_array_count(c2m->module_list);
+	uint32_t n_units = n_modules + 1;
+	c2m_unit_t* units = malloc(sizeof(c2m_unit_t) * n_units);
+	struct cl_array* text = c2m_string_create("//");
+	char* flags[C2M_SPLIT_ARGS];
+	uint8_t header_changed;
+	c2m_timer_t timer;
+
+	c2m_time_begin(&timer);
+	mkdir(C2M_SPLIT_DIR, 0755);
+	// Shared header: C headers, records & every imported function's
+	// prototype.  The compiler & flags ( & profile ) are noted so changing
+	// them rebuilds everything.
+	c2m_split_args(c2m, flags, NULL);
+	for(uint32_t i = 0; flags[i]; i++) {
+		c2m_string_append_n(text, " ", 1);
+		c2m_string_append(text, flags[i]);
+	}
+	if(c2m->pgo_flag)
+		c2m_string_appendf(text, " %016llx", (unsigned long long)c2m->pgo_hash);
+	c2m_string_append_n(text, "\n", 1);
+	if(c2m->libreq.io) c2m_string_append(text, "#define C2M_IO_SHARED\n");
+	if(c2m->libreq.par) c2m_string_append(text, "#define C2M_PAR_SHARED\n");
+	if(c2m->libreq.co) c2m_string_append(text, "#define C2M_CO_SHARED\n");
+	if(c2m->libreq.trace)
+		c2m_string_append(text, "#define C2M_TRACE_SHARED\n");
+	if(c2m->libreq.clump)
+		c2m_string_append(text, "#define C2M_CLUMP_SHARED\n");
+	c2m_prelude_includes(c2m, text);
+	c2m_emit_records(c2m, text);
+	for(c2m_node_t* fn = c2m->imported; fn; fn = fn->next) {
+		c2m_emit_prototype(fn, text);
+		if(fn->indirect) c2m_async_prototype(c2m, fn, text);
+	}
+	header_changed = c2m_split_write(C2M_SPLIT_DIR "/c2m.h", text);
+
+	c2m_workers_run(c2m_split_module, c2m->module_list->store, n_modules);
+	for(uint32_t i = 0; i < n_modules; i++) {
+		c2m_module_t* module =
+			*(c2m_module_t**)cl_array_borrow(c2m->module_list, i);
+
+		c2m_string_clear(text);
+		c2m_string_append(text, "#include \"c2m.h\"\n");
+		c2m_string_append_n(text, module->output->store,
+			c2m_string_length(module->output));
+		c2m_split_unit(&units[i], module->name, text, header_changed);
+	}
+	c2m_string_clear(text);
+	c2m_string_append(text, "#include \"c2m.h\"\n");
+	if(c2m->libreq.io) c2m_string_append(text, c2m_prelude_io_state);
+	if(c2m->libreq.par) c2m_string_append(text, c2m_prelude_par_state);
+	if(c2m->libreq.co) c2m_string_append(text, c2m_prelude_co_state);
+	if(c2m->libreq.trace) c2m_string_append(text, "C2M_TRACE_STATE\n");
+	if(c2m->libreq.clump) {
+		c2m_string_append(text,
+			"#define C2M_CLUMP_STATE\n#include <c2m_clump.c>\n");
+	}
+	if(c2m->exports) {
+		c2m_prelude_library(c2m, text);
+	}else{
+		c2m_emit_parallels(c2m, c2m->main_fn->body, text);
+		c2m_string_append(text, "int main(int argc, char* argv[]){\n");
+		c2m_prelude_main(c2m, text);
+		c2m_emit(c2m);
+		c2m_string_append_n(text, c2m->main->store,
+			c2m_string_length(c2m->main));
+		if(c2m->libreq.co) c2m_string_append(text, "c2m_co_loop();\n");
+		c2m_string_append(text, c2m->return_success ?
+			"return 0; }\n" : "return 1; }\n");
+		if(c2m->libreq.profile) c2m_emit_profile(c2m->main_fn, text);
+	}
+	// Not a module name, those are C identifiers.
+	c2m_split_unit(&units[n_modules], "c2m-main", text, header_changed);
+	c2m_string_destroy(text);
+	c2m_time_end(&timer, &c2m_phases[C2M_PHASE_EMIT]);
+	if(c2m->emit_only == 0) {
+		c2m_time_begin(&timer);
+		c2m_split_build(c2m, units, n_units);
+		c2m_time_end(&timer, &c2m_phases[C2M_PHASE_BACKEND]);
+	}
+	for(uint32_t i = 0; i < n_units; i++) {
+		c2m_string_destroy(units[i].source);
+		c2m_string_destroy(units[i].object);
+	}
+	free(units);
+}
@@ -1,35 +1,83 @@
+#include <stdarg.h>
 #include "../clump/src/array.c"
 
+// Strings are a cl_array of chars, always NUL terminated, the terminator is
+// counted in n_items.
+
+// Make room for `n` more characters with a single capacity check.
+static inline void c2m_string_reserve(struct cl_array *arr, uint32_t n) {
+	cl_array_grow(arr, n);
+}
+
 static inline struct cl_array *c2m_string_create(const char* initial_value) {
-	return cl_array_create(1, initial_value ? strlen(initial_value) : 0);
+	struct cl_array *arr = cl_array_create(1,
+		initial_value ? strlen(initial_value) + 1 : 0);
+
+	*(char*)cl_array_add(arr) = '\0';
+	if(initial_value) {
+		uint32_t len = strlen(initial_value);
+
+		c2m_string_reserve(arr, len);
+		memcpy((char*)arr->store, initial_value, len + 1);
+		arr->n_items += len;
+	}
+	return arr;
+}
+
+// Append `n` bytes of `what` (which needn't be NUL terminated).
+static inline void c2m_string_append_n(struct cl_array *arr, const char* what,
+	uint32_t n)
+{
+	c2m_string_reserve(arr, n);
+	memcpy((char*)arr->store + arr->n_items - 1, what, n);
+	arr->n_items += n;
+	((char*)arr->store)[arr->n_items - 1] = '\0';
 }
 
 static inline void c2m_string_append(struct cl_array *arr, const char* what) {
-	cl_array_pop(arr);
-	for(int i = 0; i < strlen(what); i++) {
-		char* value = cl_array_add(arr);
-		*value = what[i];
-	}
-	char* value = cl_array_add(arr);
-	*value = '\0';
+	c2m_string_append_n(arr, what, strlen(what));
 }
 
 static inline void c2m_string_destroy(struct cl_array *arr) {
 	cl_array_destroy(arr);
 }
 
+// Empty the string, keeping its storage.
+static inline void c2m_string_clear(struct cl_array *arr) {
+	arr->n_items = 1;
+	((char*)arr->store)[0] = '\0';
+}
+
+// Length of the string, not counting the NUL terminator.
+static inline uint32_t c2m_string_length(struct cl_array *arr) {
+	return arr->n_items - 1;
+}
+
+// Decimal `v`, by SDL_lltoa()'s two digits at a time.
 static inline void c2m_string_add_int(struct cl_array *arr, int64_t v) {
-	if(v < 0) {
-		char* value = cl_array_add(arr);
-		*value = '-';
-		v = -v;
-	}
-	while(v) {
-		char c = '\0';
-		char* value = cl_array_add(arr);
-		int8_t d = v % 10;
+	char digits[21];
+
+	SDL_lltoa(v, digits, 10);
+	c2m_string_append(arr, digits);
+}
+
+// printf-style append, formats straight into the string's storage.
+static void c2m_string_appendf(struct cl_array *arr, const char* format, ...) {
+	va_list args;
+	uint32_t avail = arr->n_size - arr->n_items + 1;
+	int len;
 
-		*value = '0' + d;
-		v /= 10;
+	va_start(args, format);
+	len = vsnprintf((char*)arr->store + arr->n_items - 1, avail, format,
+		args);
+	va_end(args);
+	if(len < 0) return;
+	if((uint32_t)len >= avail) {
+		c2m_string_reserve(arr, len);
+		va_start(args, format);
+		vsnprintf((char*)arr->store + arr->n_items - 1, len + 1, format,
+			args);
+		va_end(args);
 	}
+	arr->n_items += len;
 }
@@ -0,0 +1,145 @@
+// Symbol tables: name -> symbol maps on a clump rhash, one table per
+// namespace (modules, a module's functions, imports, variables & types).
+// Names are interned, symbols come from a pool owned by the table.
+
+enum {
+	SYMBOL_MODULE, // data = c2m_module_t*
+	SYMBOL_FUNCTION, // data = c2m_node_t* ( NODE_FUNCTION )
+	SYMBOL_IMPORT, // data = first NODE_CALL
+	SYMBOL_VARIABLE, // type, data = declaring c2m_node_t*
+	SYMBOL_TYPE, // type, data = NODE_RECORD for records
+	SYMBOL_UNPARSED, // data = c2m_prescan_def_t*, see c2m_prescan.c
+};
+
+typedef struct{
+	const char* name; // Interned
+	uint8_t kind;
+	uint8_t type;
+	void* data;
+}c2m_symbol_t;
+
+typedef struct{
+	struct cl_rhash* map; // name -> c2m_symbol_t*
+	struct cl_pool* symbols;
+	c2m_intern_t* intern;
+}c2m_symtab_t;
+
+static c2m_symtab_t* c2m_symtab_create(c2m_intern_t* intern) {
+	c2m_symtab_t* tab = malloc(sizeof(c2m_symtab_t));
+
+	tab->map = cl_rhash_create_map_hashed(0);
+	tab->symbols = cl_pool_create(sizeof(c2m_symbol_t));
+	tab->intern = intern;
+	return tab;
+}
+
+static void c2m_symtab_destroy(c2m_symtab_t* tab) {
+	cl_rhash_destroy(tab->map);
+	cl_pool_destroy(tab->symbols);
+	free(tab);
+}
+
+// Empty the table, keeping its storage.
+static void c2m_symtab_clear(c2m_symtab_t* tab) {
+	cl_rhash_clear(tab->map);
+	cl_pool_clear(tab->symbols);
+}
+
+static inline uint32_t c2m_symtab_count(c2m_symtab_t* tab) {
+	return cl_rhash_count(tab->map);
+}
+
+/*
+ * Returns NULL if there's no symbol `name` ( must be interned ).
+*/
+static inline c2m_symbol_t* c2m_symtab_get(c2m_symtab_t* tab,
+	const char* name)
+{
+	return (c2m_symbol_t*)cl_rhash_get(tab->map, name);
+}
+
+/*
+ * Add symbol `name` ( must be interned ), it must not be in the table already.
+*/
+static c2m_symbol_t* c2m_symtab_add(c2m_symtab_t* tab, const char* name,
+	uint8_t kind, uint8_t type, void* data)
+{
+	c2m_symbol_t* symbol = cl_pool_alloc(tab->symbols);
+
+	symbol->name = name;
+	symbol->kind = kind;
+	symbol->type = type;
+	symbol->data = data;
+	cl_rhash_put(tab->map, name, symbol);
+	return symbol;
+}
+
+static void c2m_symtab_add_types(c2m_symtab_t* tab) {
+	static const struct{ const char* name; uint8_t type; }builtin[] = {
+		{ "string_t", TYPE_STRING },
+		{ "uint8_t", TYPE_UBYTE },
+		{ "int8_t", TYPE_SBYTE },
+		{ "uint16_t", TYPE_USHORT },
+		{ "int16_t", TYPE_SSHORT },
+		{ "uint32_t", TYPE_UINT32 },
+		{ "int32_t", TYPE_SINT32 },
+		{ "uint64_t", TYPE_UINT64 },
+		{ "int64_t", TYPE_SINT64 },
+		{ "float", TYPE_FLOAT32 },
+		{ "double", TYPE_FLOAT64 },
+		{ "list_t", TYPE_LIST },
+		{ "set_t", TYPE_SET },
+		// The spec's names ( spec/global_definitions.md )
+		{ "String", TYPE_STRING },
+		{ "Uint8", TYPE_UBYTE },
+		{ "Sint8", TYPE_SBYTE },
+		{ "Uint16", TYPE_USHORT },
+		{ "Sint16", TYPE_SSHORT },
+		{ "Uint32", TYPE_UINT32 },
+		{ "Sint32", TYPE_SINT32 },
+		{ "Uint64", TYPE_UINT64 },
+		{ "Sint64", TYPE_SINT64 },
+		{ "Float32", TYPE_FLOAT32 },
+		{ "Float64", TYPE_FLOAT64 },
+		{ "List", TYPE_LIST },
+		{ "Set", TYPE_SET },
+	};
+
+	for(uint32_t i = 0; i < sizeof(builtin) / sizeof(builtin[0]); i++) {
+		c2m_symtab_add(tab, c2m_intern_str(tab->intern,
+			builtin[i].name), SYMBOL_TYPE, builtin[i].type, NULL);
+	}
+}
+
+// The C type a value of `type` is stored as.
+static const char* c2m_type_c(uint8_t type) {
+	static const char* names[] = {
+		[TYPE_STRING] = "c2m_str_t",
+		[TYPE_UBYTE] = "uint8_t",
+		[TYPE_SBYTE] = "int8_t",
+		[TYPE_USHORT] = "uint16_t",
+		[TYPE_SSHORT] = "int16_t",
+		[TYPE_UINT32] = "uint32_t",
+		[TYPE_SINT32] = "int32_t",
+		[TYPE_UINT64] = "uint64_t",
+		[TYPE_SINT64] = "int64_t",
+		[TYPE_FLOAT32] = "float",
+		[TYPE_FLOAT64] = "double",
+		[TYPE_POINTER] = "void*",
+		[TYPE_INTEGER] = "int64_t",
+		[TYPE_ARGS] = "c2m_args_t",
+		[TYPE_LIST] = "c2m_list_t",
+		[TYPE_RECORD] = NULL, // Named by the record, see c2m_emit_type()
+		[TYPE_SET] = "c2m_set_t",
+		[TYPE_ROWS] = NULL, // Named by the record too
+	};
+
+	return names[type];
+}
+
+// Returns 1 if `type` is an integer type ( bools are TYPE_UBYTE ).
+static inline uint8_t c2m_type_is_integer(uint8_t type) {
+	return type != TYPE_STRING && type != TYPE_FLOAT32 &&
+		type != TYPE_FLOAT64 && type != TYPE_POINTER && type != TYPE_ARGS &&
+		type != TYPE_LIST && type != TYPE_RECORD && type != TYPE_SET;
+}
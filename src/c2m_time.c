@@ -0,0 +1,131 @@
+// Compile time profile ( --time-report ): wall time & allocations per phase,
+// timed with SDL's fast performance counter.  Allocations are counted by
+// sending the compiler's own malloc() & realloc() calls ( not SDL's ) through
+// here, only once the report is switched on.  They're measured here for
+// --mem-report too ( see c2m_mem.c ).  With --trace each timed phase is also a
+// slice of the trace ( see c2m_trace.c ).
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define C2M_TIME_RUSAGE 1
+#endif
+
+enum {
+	C2M_PHASE_CONFIG, // c2m.config
+	C2M_PHASE_PARSE, // Lex & parse src/main.c2m
+	C2M_PHASE_IMPORT, // Library modules, per module below
+	C2M_PHASE_PASSES,
+	C2M_PHASE_EMIT, // Generate C, includes writing it
+	C2M_PHASE_WRITE, // main.c & the backend's pipe
+	C2M_PHASE_BACKEND, // Waiting for the C compiler once it's all written
+	C2M_PHASE_COUNT
+};
+
+typedef struct{
+	const char* name;
+	uint64_t ticks;
+	uint32_t allocs;
+}c2m_phase_t;
+
+// A phase ( or module ) being timed.
+typedef struct{
+	uint64_t start;
+	uint32_t allocs;
+}c2m_timer_t;
+
+static uint8_t c2m_time_enabled = 0;
+static SDL_atomic_t c2m_time_allocs;
+static c2m_phase_t c2m_phases[C2M_PHASE_COUNT] = {
+	{ "config" }, { "parse main" }, { "import" }, { "passes" },
+	{ "emit" }, { "  write" }, { "backend" },
+};
+static c2m_phase_t c2m_time_modules[64]; // From first use
+static uint32_t c2m_time_n_modules = 0;
+
+static inline void* c2m_time_malloc(size_t size) {
+	void* pointer;
+
+	if(c2m_time_enabled) SDL_AtomicIncRef(&c2m_time_allocs);
+	pointer = malloc(size);
+	if(c2m_mem_enabled) c2m_mem_alloc(pointer, 0);
+	return pointer;
+}
+
+static inline void* c2m_time_realloc(void* pointer, size_t size) {
+	size_t old = c2m_mem_enabled && pointer ? C2M_MEM_SIZE(pointer) : 0;
+
+	if(c2m_time_enabled) SDL_AtomicIncRef(&c2m_time_allocs);
+	pointer = realloc(pointer, size);
+	if(c2m_mem_enabled) c2m_mem_alloc(pointer, old);
+	return pointer;
+}
+
+#define malloc(size) c2m_time_malloc(size)
+#define realloc(pointer, size) c2m_time_realloc(pointer, size)
+
+static void c2m_time_enable(void) {
+	c2m_time_enabled = 1;
+	SDL_AtomicSet(&c2m_time_allocs, 0);
+	SDL_GetFastPerformanceCounter(); // Start the clock on this thread
+}
+
+static inline void c2m_time_begin(c2m_timer_t* timer) {
+	timer->start = 0;
+	timer->allocs = 0;
+	if(c2m_time_enabled == 0 && c2m_trace.enabled == 0) return;
+	timer->start = SDL_GetFastPerformanceCounter();
+	timer->allocs = SDL_AtomicGet(&c2m_time_allocs);
+}
+
+// Add the time & allocations since c2m_time_begin() to `phase`.
+static inline void c2m_time_end(c2m_timer_t* timer, c2m_phase_t* phase) {
+	if(c2m_time_enabled == 0 && c2m_trace.enabled == 0) return;
+	uint64_t end = SDL_GetFastPerformanceCounter();
+
+	c2m_trace_complete(phase->name, timer->start, end);
+	phase->ticks += end - timer->start;
+	phase->allocs += SDL_AtomicGet(&c2m_time_allocs) - timer->allocs;
+}
+
+// Record module `name`'s parse `time` ( on whichever thread parsed it, so its
+// allocations aren't told apart from other modules' ).
+static void c2m_time_module(const char* name, c2m_phase_t* time) {
+	if(c2m_time_enabled == 0 || c2m_time_n_modules == 64) return;
+	c2m_time_modules[c2m_time_n_modules] = *time;
+	c2m_time_modules[c2m_time_n_modules++].name = name;
+}
+
+static inline double c2m_time_ms(uint64_t ticks) {
+	return ticks * 1000.0 / SDL_GetFastPerformanceFrequency();
+}
+
+static void c2m_time_report(void) {
+	uint64_t total = 0;
+
+	fputs("Time report:\n", stdout);
+	for(uint32_t i = 0; i < C2M_PHASE_COUNT; i++) {
+		printf("  %-14s %10.3f ms %8u allocs\n", c2m_phases[i].name,
+			c2m_time_ms(c2m_phases[i].ticks), c2m_phases[i].allocs);
+		if(i == C2M_PHASE_IMPORT) {
+			for(uint32_t j = 0; j < c2m_time_n_modules; j++) {
+				printf("    %-12s %10.3f ms\n", c2m_time_modules[j].name,
+					c2m_time_ms(c2m_time_modules[j].ticks));
+			}
+		}
+		if(i != C2M_PHASE_WRITE) total += c2m_phases[i].ticks;
+	}
+	printf("  %-14s %10.3f ms %8u allocs\n", "total", c2m_time_ms(total),
+		SDL_AtomicGet(&c2m_time_allocs));
+#ifdef C2M_TIME_RUSAGE
+	struct rusage self, children;
+
+	getrusage(RUSAGE_SELF, &self);
+	getrusage(RUSAGE_CHILDREN, &children);
+#ifdef __APPLE__
+	self.ru_maxrss /= 1024; // Bytes, not KiB
+	children.ru_maxrss /= 1024;
+#endif
+	printf("  %-14s %10ld KiB\n", "peak RSS", self.ru_maxrss);
+	printf("  %-14s %10ld KiB\n", "backend RSS", children.ru_maxrss);
+#endif
+}
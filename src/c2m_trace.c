@@ -0,0 +1,473 @@
+// Tracing ( --trace=<file> for the compiler, C2M_TRACE=<file> for a program
+// with `trace` functions ): slices, counters & flows between threads, written
+// as Chrome trace JSON if the file name ends in ".json", as a Perfetto
+// protobuf trace otherwise.  Each thread records into its own chunks of
+// events, nothing's shared while recording but the list of threads ( pushed
+// onto with a compare & swap the first time a thread records ).  A chunk's
+// count is published with release, so c2m_trace_flush() can read what's
+// there while threads are still going.  Names aren't copied, they must last
+// until the trace is written.  Off it costs a load & a branch per event.
+//
+// Only the C library is used ( not SDL or clump ), so a generated program can
+// include this file as a runtime, as it does c2m_clump.c.  The compiler sets
+// C2M_TRACE_NOW() & C2M_TRACE_FREQ() to SDL's performance counter first.
+// Split builds define C2M_TRACE_SHARED, the state is then in main's unit (
+// C2M_TRACE_STATE ) instead of one copy per unit.  The compiler defines
+// C2M_TRACE_COMPILER, it starts & writes its trace itself ( --trace ).
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define C2M_TRACE_PID() ((int32_t)getpid())
+#else
+#define C2M_TRACE_PID() 1
+#endif
+
+#ifndef C2M_TRACE_NOW
+static inline uint64_t c2m_trace_clock(void) {
+	struct timespec now;
+
+	timespec_get(&now, TIME_UTC);
+	return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+#define C2M_TRACE_NOW() c2m_trace_clock()
+#define C2M_TRACE_FREQ() 1000000000u
+#endif
+
+#define C2M_TRACE_CHUNK 4096 // Events per chunk
+
+enum {
+	C2M_TRACE_BEGIN,
+	C2M_TRACE_END,
+	C2M_TRACE_COMPLETE, // value is the end
+	C2M_TRACE_COUNTER,
+	C2M_TRACE_FLOW_START, // value is the flow's id
+	C2M_TRACE_FLOW_END,
+};
+
+typedef struct{
+	uint64_t ts;
+	uint64_t value;
+	const char* name;
+	uint32_t kind;
+}c2m_trace_event_t;
+
+typedef struct c2m_trace_chunk{
+	_Atomic(struct c2m_trace_chunk*) next;
+	atomic_uint n;
+	c2m_trace_event_t events[C2M_TRACE_CHUNK];
+}c2m_trace_chunk_t;
+
+typedef struct c2m_trace_thread{
+	struct c2m_trace_thread* next;
+	c2m_trace_chunk_t* first;
+	c2m_trace_chunk_t* last; // The owner's
+	_Atomic(const char*) name;
+	uint32_t tid;
+}c2m_trace_thread_t;
+
+typedef struct{
+	uint8_t enabled;
+	const char* path;
+	_Atomic(c2m_trace_thread_t*) threads;
+	atomic_uint n_threads;
+}c2m_trace_state_t;
+
+#define C2M_TRACE_STATE \
+	c2m_trace_state_t c2m_trace; \
+	_Thread_local c2m_trace_thread_t* c2m_trace_self;
+
+#ifdef C2M_TRACE_SHARED
+extern c2m_trace_state_t c2m_trace;
+extern _Thread_local c2m_trace_thread_t* c2m_trace_self;
+#else
+static c2m_trace_state_t c2m_trace;
+static _Thread_local c2m_trace_thread_t* c2m_trace_self;
+#endif
+
+// This thread's events, NULL if out of memory.
+static c2m_trace_thread_t* c2m_trace_thread(void) {
+	c2m_trace_thread_t* self = calloc(1, sizeof(c2m_trace_thread_t));
+
+	if(self == NULL || (self->first = calloc(1, sizeof(c2m_trace_chunk_t)))
+		== NULL)
+	{
+		free(self);
+		return NULL;
+	}
+	self->last = self->first;
+	self->tid = atomic_fetch_add(&c2m_trace.n_threads, 1) + 1;
+	self->next = atomic_load_explicit(&c2m_trace.threads,
+		memory_order_relaxed);
+	while(!atomic_compare_exchange_weak_explicit(&c2m_trace.threads,
+		&self->next, self, memory_order_release, memory_order_relaxed));
+	c2m_trace_self = self;
+	return self;
+}
+
+static void c2m_trace_record(uint32_t kind, const char* name, uint64_t ts,
+	uint64_t value)
+{
+	c2m_trace_thread_t* self = c2m_trace_self;
+	c2m_trace_chunk_t* chunk;
+	uint32_t n;
+
+	if(self == NULL && (self = c2m_trace_thread()) == NULL) return;
+	chunk = self->last;
+	n = atomic_load_explicit(&chunk->n, memory_order_relaxed);
+	if(n == C2M_TRACE_CHUNK) {
+		c2m_trace_chunk_t* next = calloc(1, sizeof(c2m_trace_chunk_t));
+
+		if(next == NULL) return; // Dropped
+		atomic_store_explicit(&chunk->next, next, memory_order_release);
+		self->last = chunk = next;
+		n = 0;
+	}
+	chunk->events[n].ts = ts;
+	chunk->events[n].value = value;
+	chunk->events[n].name = name;
+	chunk->events[n].kind = kind;
+	atomic_store_explicit(&chunk->n, n + 1, memory_order_release);
+}
+
+static inline uint64_t c2m_trace_now(void) {
+	return C2M_TRACE_NOW();
+}
+
+static inline void c2m_trace_begin(const char* name) {
+	if(c2m_trace.enabled)
+		c2m_trace_record(C2M_TRACE_BEGIN, name, C2M_TRACE_NOW(), 0);
+}
+
+// Ends this thread's innermost slice.
+static inline void c2m_trace_end(void) {
+	if(c2m_trace.enabled)
+		c2m_trace_record(C2M_TRACE_END, NULL, C2M_TRACE_NOW(), 0);
+}
+
+// A slice timed already, from c2m_trace_now() readings.
+static inline void c2m_trace_complete(const char* name, uint64_t start,
+	uint64_t end)
+{
+	if(c2m_trace.enabled)
+		c2m_trace_record(C2M_TRACE_COMPLETE, name, start, end);
+}
+
+static inline void c2m_trace_counter(const char* name, int64_t value) {
+	if(c2m_trace.enabled) {
+		c2m_trace_record(C2M_TRACE_COUNTER, name, C2M_TRACE_NOW(),
+			(uint64_t)value);
+	}
+}
+
+// An arrow from here to where c2m_trace_flow_end() gets the same `id`,
+// usually on another thread.  Both should be inside a slice.
+static inline void c2m_trace_flow_start(const char* name, uint64_t id) {
+	if(c2m_trace.enabled)
+		c2m_trace_record(C2M_TRACE_FLOW_START, name, C2M_TRACE_NOW(), id);
+}
+
+static inline void c2m_trace_flow_end(const char* name, uint64_t id) {
+	if(c2m_trace.enabled)
+		c2m_trace_record(C2M_TRACE_FLOW_END, name, C2M_TRACE_NOW(), id);
+}
+
+static void c2m_trace_thread_name(const char* name) {
+	c2m_trace_thread_t* self = c2m_trace_self;
+
+	if(c2m_trace.enabled == 0) return;
+	if(self == NULL && (self = c2m_trace_thread()) == NULL) return;
+	atomic_store_explicit(&self->name, name, memory_order_release);
+}
+
+// Ticks to nanoseconds, without overflowing for a long run.
+static inline uint64_t c2m_trace_ns(uint64_t ticks) {
+	const uint64_t freq = C2M_TRACE_FREQ();
+
+	return ticks / freq * 1000000000u + ticks % freq * 1000000000u / freq;
+}
+
+// Chrome's trace format, times in microseconds.
+static void c2m_trace_json_string(FILE* file, const char* text) {
+	fputc('"', file);
+	for(; text && *text; text++) {
+		if(*text == '"' || *text == '\\') fputc('\\', file);
+		if((unsigned char)*text < 0x20) fprintf(file, "\\u%04x", *text);
+		else fputc(*text, file);
+	}
+	fputc('"', file);
+}
+
+static void c2m_trace_json_event(FILE* file, int32_t pid, uint32_t tid,
+	const c2m_trace_event_t* event)
+{
+	static const char* phases[] = { "B", "E", "X", "C", "s", "f" };
+	uint64_t ns = c2m_trace_ns(event->ts);
+
+	fprintf(file, ",\n{\"ph\":\"%s\",\"pid\":%d,\"tid\":%u,\"ts\":%llu.%03u",
+		phases[event->kind], pid, tid, (unsigned long long)(ns / 1000),
+		(unsigned)(ns % 1000));
+	if(event->name) {
+		fputs(",\"name\":", file);
+		c2m_trace_json_string(file, event->name);
+	}
+	switch(event->kind) {
+	case C2M_TRACE_COMPLETE:
+		ns = c2m_trace_ns(event->value) - ns;
+		fprintf(file, ",\"dur\":%llu.%03u", (unsigned long long)(ns / 1000),
+			(unsigned)(ns % 1000));
+		break;
+	case C2M_TRACE_COUNTER:
+		fprintf(file, ",\"args\":{\"value\":%lld}",
+			(long long)(int64_t)event->value);
+		break;
+	case C2M_TRACE_FLOW_START:
+	case C2M_TRACE_FLOW_END:
+		fprintf(file, ",\"cat\":\"flow\",\"id\":%llu%s",
+			(unsigned long long)event->value,
+			event->kind == C2M_TRACE_FLOW_END ? ",\"bp\":\"e\"" : "");
+		break;
+	}
+	fputc('}', file);
+}
+
+// Perfetto's TracePacket, by hand: fields are ( number << 3 | wire type ).
+typedef struct{
+	uint8_t data[512];
+	uint32_t n;
+}c2m_trace_proto_t;
+
+static void c2m_trace_varint(c2m_trace_proto_t* p, uint64_t v) {
+	while(v >= 0x80) {
+		p->data[p->n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	p->data[p->n++] = (uint8_t)v;
+}
+
+static inline void c2m_trace_field(c2m_trace_proto_t* p, uint32_t field,
+	uint64_t v)
+{
+	c2m_trace_varint(p, (uint64_t)field << 3);
+	c2m_trace_varint(p, v);
+}
+
+static void c2m_trace_fixed64(c2m_trace_proto_t* p, uint32_t field,
+	uint64_t v)
+{
+	c2m_trace_varint(p, (uint64_t)field << 3 | 1);
+	for(uint32_t i = 0; i < 8; i++) p->data[p->n++] = (uint8_t)(v >> i * 8);
+}
+
+// Bytes ( a string or a message ), cut short to fit.
+static void c2m_trace_bytes(c2m_trace_proto_t* p, uint32_t field,
+	const void* data, uint32_t size)
+{
+	if(size > 256) size = 256;
+	c2m_trace_varint(p, (uint64_t)field << 3 | 2);
+	c2m_trace_varint(p, size);
+	memcpy(&p->data[p->n], data, size);
+	p->n += size;
+}
+
+// Write `body` as a TracePacket of the Trace ( field 1 ).
+static void c2m_trace_packet(FILE* file, c2m_trace_proto_t* body) {
+	c2m_trace_proto_t head = { .n = 0 };
+
+	c2m_trace_varint(&head, 1 << 3 | 2);
+	c2m_trace_varint(&head, body->n);
+	fwrite(head.data, 1, head.n, file);
+	fwrite(body->data, 1, body->n, file);
+}
+
+static inline uint64_t c2m_trace_counter_uuid(const char* name) {
+	uint64_t hash = 14695981039346656037u; // FNV-1a
+
+	while(*name) hash = (hash ^ (uint8_t)*name++) * 1099511628211u;
+	return hash | 1ull << 63; // Apart from the threads' tracks
+}
+
+// A TrackDescriptor ( field 60 ) for a thread, or for a counter.
+static void c2m_trace_proto_track(FILE* file, int32_t pid,
+	const c2m_trace_thread_t* thread, const char* counter)
+{
+	c2m_trace_proto_t packet = { .n = 0 }, track = { .n = 0 };
+	c2m_trace_proto_t sub = { .n = 0 };
+
+	if(counter) {
+		c2m_trace_field(&track, 1, c2m_trace_counter_uuid(counter));
+		c2m_trace_bytes(&track, 2, counter, strlen(counter));
+		c2m_trace_bytes(&track, 8, "", 0); // CounterDescriptor
+	}else{
+		const char* name = atomic_load_explicit(&thread->name,
+			memory_order_acquire);
+
+		c2m_trace_field(&track, 1, thread->tid);
+		c2m_trace_field(&sub, 1, (uint32_t)pid);
+		c2m_trace_field(&sub, 2, thread->tid);
+		if(name) c2m_trace_bytes(&sub, 5, name, strlen(name));
+		c2m_trace_bytes(&track, 4, sub.data, sub.n); // ThreadDescriptor
+	}
+	c2m_trace_bytes(&packet, 60, track.data, track.n);
+	c2m_trace_packet(file, &packet);
+}
+
+// A TrackEvent ( field 11 ) of `type` ( SLICE_BEGIN 1, SLICE_END 2, INSTANT 3,
+// COUNTER 4 ), on the thread's sequence.
+static void c2m_trace_proto_event(FILE* file, uint32_t tid, uint32_t type,
+	const c2m_trace_event_t* event, uint64_t ts)
+{
+	c2m_trace_proto_t packet = { .n = 0 }, track_event = { .n = 0 };
+
+	c2m_trace_field(&track_event, 9, type);
+	if(type == 4) {
+		c2m_trace_field(&track_event, 11, c2m_trace_counter_uuid(event->name));
+		c2m_trace_field(&track_event, 30, event->value);
+	}else{
+		c2m_trace_field(&track_event, 11, tid);
+		if(type != 2 && event->name)
+			c2m_trace_bytes(&track_event, 23, event->name, strlen(event->name));
+		if(event->kind == C2M_TRACE_FLOW_START)
+			c2m_trace_fixed64(&track_event, 47, event->value);
+		if(event->kind == C2M_TRACE_FLOW_END)
+			c2m_trace_fixed64(&track_event, 48, event->value);
+	}
+	c2m_trace_field(&packet, 8, c2m_trace_ns(ts));
+	c2m_trace_field(&packet, 10, tid); // trusted_packet_sequence_id
+	c2m_trace_bytes(&packet, 11, track_event.data, track_event.n);
+	c2m_trace_packet(file, &packet);
+}
+
+static void c2m_trace_proto_events(FILE* file, uint32_t tid,
+	const c2m_trace_event_t* event)
+{
+	switch(event->kind) {
+	case C2M_TRACE_BEGIN:
+		c2m_trace_proto_event(file, tid, 1, event, event->ts);
+		break;
+	case C2M_TRACE_END:
+		c2m_trace_proto_event(file, tid, 2, event, event->ts);
+		break;
+	case C2M_TRACE_COMPLETE:
+		c2m_trace_proto_event(file, tid, 1, event, event->ts);
+		c2m_trace_proto_event(file, tid, 2, event, event->value);
+		break;
+	case C2M_TRACE_COUNTER:
+		c2m_trace_proto_event(file, tid, 4, event, event->ts);
+		break;
+	default:
+		c2m_trace_proto_event(file, tid, 3, event, event->ts);
+	}
+}
+
+// Counters' tracks are described once, before their first value.
+static void c2m_trace_proto_counters(FILE* file, int32_t pid) {
+	const char** names = NULL;
+	uint32_t n_names = 0;
+
+	for(c2m_trace_thread_t* thread = atomic_load_explicit(&c2m_trace.threads,
+		memory_order_acquire); thread; thread = thread->next)
+	{
+		for(c2m_trace_chunk_t* chunk = thread->first; chunk;
+			chunk = atomic_load_explicit(&chunk->next, memory_order_acquire))
+		{
+			uint32_t n = atomic_load_explicit(&chunk->n, memory_order_acquire);
+
+			for(uint32_t i = 0; i < n; i++) {
+				const char* name = chunk->events[i].name;
+				const char** grown;
+				uint32_t j = 0;
+
+				if(chunk->events[i].kind != C2M_TRACE_COUNTER) continue;
+				while(j < n_names && strcmp(names[j], name)) j++;
+				if(j < n_names) continue;
+				if((grown = realloc(names, (n_names + 1) * sizeof(char*)))
+					== NULL)
+				{
+					continue;
+				}
+				names = grown;
+				names[n_names++] = name;
+				c2m_trace_proto_track(file, pid, NULL, name);
+			}
+		}
+	}
+	free(names);
+}
+
+// Write out everything recorded so far, returns 1 if the file couldn't be.
+static uint8_t c2m_trace_flush(void) {
+	const char* path = c2m_trace.path;
+	size_t length = path ? strlen(path) : 0;
+	uint8_t json = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+	int32_t pid = C2M_TRACE_PID();
+	FILE* file;
+
+	if(c2m_trace.enabled == 0) return 0;
+	if((file = fopen(path, "wb")) == NULL) return 1;
+	// The process' name first, so each event after it starts with a comma.
+	if(json) {
+		fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+			"{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,"
+			"\"args\":{\"name\":\"c2m\"}}", pid);
+	}
+	else c2m_trace_proto_counters(file, pid);
+	for(c2m_trace_thread_t* thread = atomic_load_explicit(&c2m_trace.threads,
+		memory_order_acquire); thread; thread = thread->next)
+	{
+		const char* name = atomic_load_explicit(&thread->name,
+			memory_order_acquire);
+
+		if(json && name) {
+			fprintf(file, ",\n{\"ph\":\"M\",\"name\":\"thread_name\","
+				"\"pid\":%d,\"tid\":%u,\"args\":{\"name\":", pid, thread->tid);
+			c2m_trace_json_string(file, name);
+			fputs("}}", file);
+		}else if(json == 0) {
+			c2m_trace_proto_track(file, pid, thread, NULL);
+		}
+		for(c2m_trace_chunk_t* chunk = thread->first; chunk;
+			chunk = atomic_load_explicit(&chunk->next, memory_order_acquire))
+		{
+			uint32_t n = atomic_load_explicit(&chunk->n, memory_order_acquire);
+
+			for(uint32_t i = 0; i < n; i++) {
+				if(json) {
+					c2m_trace_json_event(file, pid, thread->tid,
+						&chunk->events[i]);
+				}else{
+					c2m_trace_proto_events(file, thread->tid,
+						&chunk->events[i]);
+				}
+			}
+		}
+	}
+	if(json) fputs("\n]}\n", file);
+	return fclose(file) != 0;
+}
+
+// Start recording, to write `path` at c2m_trace_flush().  NULL or "" leaves
+// tracing off.
+static void c2m_trace_start(const char* path) {
+	if(path == NULL || path[0] == '\0') return;
+	c2m_trace.path = path;
+	c2m_trace.enabled = 1;
+	c2m_trace_thread_name("main");
+}
+
+#ifndef C2M_TRACE_COMPILER
+static void c2m_trace_exit(void) {
+	c2m_trace_flush();
+}
+
+// A program's runtime: started from the environment, written at exit.
+static void c2m_trace_start_env(void) {
+	c2m_trace_start(getenv("C2M_TRACE"));
+	if(c2m_trace.enabled) atexit(c2m_trace_exit);
+}
+#endif
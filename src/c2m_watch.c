@@ -0,0 +1,132 @@
+// Watch mode ( --watch ): stay resident & rebuild whenever src/, lib/ or
+// c2m.config change ( inotify ).  Parsed modules stay in a module cache as
+// in a batch, so only edited modules are parsed again, & with --split only
+// their units go through the C compiler again.  A failed build doesn't end
+// the session, c2m_abort() returns here & the next change is waited for.
+// Ctrl-C ( or SIGTERM ) ends it, the module cache is freed on the way out.
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#define C2M_WATCH_INOTIFY 1
+#endif
+
+#define C2M_WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE)
+#define C2M_WATCH_SETTLE 20 // ms without changes before rebuilding
+
+// Undo what an aborted compile left running.
+static void c2m_watch_recover(c2m_t* c2m) {
+	c2m_output_t* out = c2m->out;
+
+	if(out) {
+		if(out->backend) out->backend->cancel(c2m);
+		out->backend = NULL;
+		c2m_output_close(c2m);
+	}
+	// Aborted mid-parse, maybe holding the lock.
+	SDL_AtomicSet(&c2m->intern->lock.state, 0);
+	c2m->intern->shared = 0;
+}
+
+static void c2m_watch_build(c2m_t* options, c2m_symtab_t* cache) {
+	c2m_t* c2m = malloc(sizeof(c2m_t));
+	uint64_t start = SDL_GetPerformanceCounter();
+	uint8_t failed = 0;
+	jmp_buf jump;
+
+	c2m_batch_init(c2m, options, cache);
+	c2m_abort_jump = &jump;
+	if(setjmp(jump) == 0) {
+		c2m_gconfig(c2m);
+		c2m_compile(c2m);
+	}else{
+		failed = 1;
+		c2m_watch_recover(c2m);
+	}
+	c2m_abort_jump = NULL;
+	c2m_release(c2m);
+	free(c2m);
+	printf("%s in %.1f ms, watching for changes\n",
+		failed ? "Failed" : "Built",
+		(SDL_GetPerformanceCounter() - start) * 1000.0 /
+		SDL_GetPerformanceFrequency());
+	fflush(stdout);
+}
+
+#ifdef C2M_WATCH_INOTIFY
+static volatile sig_atomic_t c2m_watch_stopped = 0;
+
+static void c2m_watch_stop(int sig) {
+	(void)sig;
+	c2m_watch_stopped = 1;
+}
+
+/*
+ * Returns 1 if the events in `buffer` ( `size` bytes ) touch an input, the
+ * build's own output ( main.c, the binary, caches ) is ignored.
+*/
+static uint8_t c2m_watch_changed(const char* buffer, ssize_t size, int root)
+{
+	uint8_t changed = 0;
+
+	for(ssize_t i = 0; i < size; ) {
+		const struct inotify_event* event = (const void*)&buffer[i];
+
+		if(event->len && (event->wd != root ||
+			strcmp(event->name, "c2m.config") == 0))
+		{
+			changed = 1;
+		}
+		i += sizeof(struct inotify_event) + event->len;
+	}
+	return changed;
+}
+
+static void c2m_watch(c2m_t* options) {
+	char buffer[4096]
+		__attribute__((aligned(__alignof__(struct inotify_event))));
+	c2m_symtab_t* cache = c2m_symtab_create(options->intern);
+	struct sigaction stop;
+	int fd = inotify_init1(IN_CLOEXEC);
+	int root;
+
+	if(fd < 0 || (root = inotify_add_watch(fd, ".", C2M_WATCH_EVENTS)) < 0 ||
+		inotify_add_watch(fd, "src", C2M_WATCH_EVENTS) < 0)
+	{
+		c2m_abort("couldn't watch the project");
+	}
+	// A program without modules has no lib/.
+	inotify_add_watch(fd, "lib", C2M_WATCH_EVENTS);
+	// Not restarted, the read() waiting for changes returns.
+	stop.sa_handler = c2m_watch_stop;
+	sigemptyset(&stop.sa_mask);
+	stop.sa_flags = 0;
+	sigaction(SIGINT, &stop, NULL);
+	sigaction(SIGTERM, &stop, NULL);
+	c2m_workers_serial = 1;
+	c2m_watch_build(options, cache);
+	while(c2m_watch_stopped == 0) {
+		struct pollfd ready = { fd, POLLIN, 0 };
+		ssize_t size = read(fd, buffer, sizeof(buffer));
+		uint8_t changed;
+
+		if(c2m_watch_stopped) break;
+		if(size <= 0) c2m_abort("lost the watch");
+		changed = c2m_watch_changed(buffer, size, root);
+		// Editors write in several steps, wait for them to settle.
+		while(poll(&ready, 1, C2M_WATCH_SETTLE) > 0) {
+			if((size = read(fd, buffer, sizeof(buffer))) <= 0) break;
+			changed |= c2m_watch_changed(buffer, size, root);
+		}
+		if(changed && c2m_watch_stopped == 0)
+			c2m_watch_build(options, cache);
+	}
+	close(fd);
+	c2m_module_cache_destroy(cache);
+	fputs("Stopped watching\n", stdout);
+}
+#else
+static void c2m_watch(c2m_t* options) {
+	c2m_abort("--watch needs inotify ( Linux )");
+}
+#endif
@@ -0,0 +1,312 @@
+// Worker pool: a work-stealing scheduler on SDL threads, one per CPU core.
+// The threads are started the first time there's more than one job, & park on
+// an SDL semaphore while there's nothing to do.  Each thread ( the calling one
+// is deque 0 ) has a Chase-Lev deque: the owner pushes & pops tasks at the
+// bottom, idle threads steal from the top of a randomly picked victim ( on
+// their own NUMA node first, each thread is kept on one's CPUs ).  Tasks
+// are spawned into a group & joined, a joining thread runs the group's tasks
+// left in its own deque instead of waiting, so jobs can spawn jobs ( a module
+// parse lexes its chunks in parallel ) without starting more threads.  While
+// watching everything runs on the calling thread, so c2m_abort() can return
+// to the watch loop.
+
+#define C2M_MAX_WORKERS 32
+#define C2M_DEQUE_SIZE 256 // Tasks per deque, a power of 2
+
+static uint8_t c2m_workers_serial = 0;
+
+typedef void (c2m_job_fn)(void* job);
+
+typedef struct{
+	SDL_atomic_t pending; // Tasks spawned & not finished, + 1 till joined
+	SDL_sem* done; // Posted by whichever takes pending to 0
+}c2m_group_t;
+
+// Owned by the spawner until the group's joined.
+typedef struct{
+	c2m_job_fn* run;
+	void* job;
+	c2m_group_t* group;
+}c2m_task_t;
+
+typedef struct{
+	SDL_atomic_t top; // Next task to steal
+	SDL_atomic_t bottom; // Next free slot, the owner's end
+	void* tasks[C2M_DEQUE_SIZE]; // c2m_task_t*
+	uint32_t seed; // The owner's victim picker
+	int node; // The NUMA node the owner runs on
+}c2m_deque_t;
+
+static struct{
+	c2m_deque_t deques[C2M_MAX_WORKERS];
+	uint32_t n_workers; // Including the calling thread, 0 until started
+	int n_nodes; // NUMA nodes
+	SDL_atomic_t n_parked;
+	SDL_sem* park;
+}c2m_sched;
+
+// SDL's static TLS slot holding the thread's deque index + 1, unset is 0.
+#define C2M_SCHED_SELF SDL_TLS_STATIC(0)
+
+static inline uint32_t c2m_sched_self(void) {
+	uintptr_t self = (uintptr_t)SDL_TLSGet(C2M_SCHED_SELF);
+
+	return self ? (uint32_t)self - 1 : 0;
+}
+
+// Owner only, false if the deque's full.  Releasing bottom publishes the
+// task ( & what it points to ) to whichever thread steals it.
+static SDL_bool c2m_deque_push(c2m_deque_t* deque, c2m_task_t* task) {
+	int bottom = SDL_AtomicLoad(&deque->bottom, SDL_MEMORY_ORDER_RELAXED);
+	int top = SDL_AtomicLoad(&deque->top, SDL_MEMORY_ORDER_ACQUIRE);
+
+	if(bottom - top >= C2M_DEQUE_SIZE) return SDL_FALSE;
+	SDL_AtomicStorePtr(&deque->tasks[bottom & (C2M_DEQUE_SIZE - 1)], task,
+		SDL_MEMORY_ORDER_RELAXED);
+	SDL_AtomicStore(&deque->bottom, bottom + 1, SDL_MEMORY_ORDER_RELEASE);
+	return SDL_TRUE;
+}
+
+// Owner only, the newest task or NULL.  Claiming bottom first means a thief
+// can only race for the last task, which the CAS on top settles.  The claim
+// & the load of top after it are sequentially consistent, a thief loads them
+// the other way around, so one of the two sees the other's.
+static c2m_task_t* c2m_deque_pop(c2m_deque_t* deque) {
+	int bottom = SDL_AtomicLoad(&deque->bottom, SDL_MEMORY_ORDER_RELAXED) - 1;
+	int top;
+	c2m_task_t* task;
+
+	SDL_AtomicExchange(&deque->bottom, bottom, SDL_MEMORY_ORDER_SEQ_CST);
+	top = SDL_AtomicLoad(&deque->top, SDL_MEMORY_ORDER_SEQ_CST);
+	if(top > bottom) {
+		SDL_AtomicStore(&deque->bottom, top, SDL_MEMORY_ORDER_RELAXED);
+		return NULL;
+	}
+	task = SDL_AtomicLoadPtr(&deque->tasks[bottom & (C2M_DEQUE_SIZE - 1)],
+		SDL_MEMORY_ORDER_RELAXED);
+	if(top == bottom) {
+		if(!SDL_AtomicCompareExchange(&deque->top, &top, top + 1,
+			SDL_MEMORY_ORDER_SEQ_CST))
+		{
+			task = NULL;
+		}
+		SDL_AtomicStore(&deque->bottom, bottom + 1, SDL_MEMORY_ORDER_RELAXED);
+	}
+	return task;
+}
+
+// Any thread, the oldest task or NULL ( empty, or another thread won it ).
+static c2m_task_t* c2m_deque_steal(c2m_deque_t* deque) {
+	int top = SDL_AtomicLoad(&deque->top, SDL_MEMORY_ORDER_SEQ_CST);
+	c2m_task_t* task;
+
+	if(top >= SDL_AtomicLoad(&deque->bottom, SDL_MEMORY_ORDER_SEQ_CST))
+		return NULL;
+	task = SDL_AtomicLoadPtr(&deque->tasks[top & (C2M_DEQUE_SIZE - 1)],
+		SDL_MEMORY_ORDER_RELAXED);
+	return SDL_AtomicCompareExchange(&deque->top, &top, top + 1,
+		SDL_MEMORY_ORDER_SEQ_CST) ? task : NULL;
+}
+
+static void c2m_task_run(c2m_task_t* task) {
+	c2m_group_t* group = task->group;
+
+	c2m_trace_begin("task");
+	c2m_trace_flow_end("spawn", (uintptr_t)task);
+	task->run(task->job);
+	c2m_trace_end();
+	if(SDL_AtomicFetchAdd(&group->pending, -1, SDL_MEMORY_ORDER_ACQ_REL) == 1)
+		SDL_SemPost(group->done);
+}
+
+// A task from the thread's own deque, or one stolen from a random victim.
+static c2m_task_t* c2m_sched_find(uint32_t self) {
+	c2m_deque_t* deque = &c2m_sched.deques[self];
+	c2m_task_t* task = c2m_deque_pop(deque);
+	uint32_t start;
+
+	if(task) return task;
+	deque->seed ^= deque->seed << 13;
+	deque->seed ^= deque->seed >> 17;
+	deque->seed ^= deque->seed << 5;
+	start = deque->seed % c2m_sched.n_workers;
+	// The same node's victims first, then the others'.
+	for(int pass = 0; pass < (c2m_sched.n_nodes > 1 ? 2 : 1); pass++) {
+		for(uint32_t i = 0; i < c2m_sched.n_workers; i++) {
+			uint32_t victim = (start + i) % c2m_sched.n_workers;
+			c2m_deque_t* other = &c2m_sched.deques[victim];
+
+			if(victim == self || (other->node == deque->node) == pass)
+				continue;
+			if((task = c2m_deque_steal(other))) return task;
+		}
+	}
+	return NULL;
+}
+
+static SDL_bool c2m_sched_idle(void) {
+	for(uint32_t i = 0; i < c2m_sched.n_workers; i++) {
+		c2m_deque_t* deque = &c2m_sched.deques[i];
+
+		if(SDL_AtomicLoad(&deque->top, SDL_MEMORY_ORDER_SEQ_CST) <
+			SDL_AtomicLoad(&deque->bottom, SDL_MEMORY_ORDER_SEQ_CST))
+		{
+			return SDL_FALSE;
+		}
+	}
+	return SDL_TRUE;
+}
+
+static int c2m_sched_worker(void* data) {
+	uint32_t self = (uint32_t)(uintptr_t)data;
+	c2m_task_t* task;
+
+	SDL_TLSSet(C2M_SCHED_SELF, (void*)(uintptr_t)(self + 1), NULL);
+	c2m_trace_thread_name("c2m_worker");
+	// Not fatal, the thread just floats between nodes.  With one node there's
+	// nothing to gain, & it'd undo affinity the process was started with.
+	if(c2m_sched.n_nodes > 1)
+		SDL_SetThreadNUMANode(c2m_sched.deques[self].node);
+	while(1) {
+		if((task = c2m_sched_find(self))) {
+			c2m_task_run(task);
+			continue;
+		}
+		// Parked is counted before looking again, & spawners push before
+		// checking the count ( both with a full barrier between ), so a task
+		// can't be pushed unseen while every thread sleeps.
+		c2m_trace_counter("parked workers",
+			SDL_AtomicAdd(&c2m_sched.n_parked, 1) + 1);
+		if(c2m_sched_idle()) SDL_SemWait(c2m_sched.park);
+		c2m_trace_counter("parked workers",
+			SDL_AtomicAdd(&c2m_sched.n_parked, -1) - 1);
+	}
+	return 0;
+}
+
+// Put worker i on the node of the i-th CPU, counting node by node: a node's
+// CPUs fill up before the next node's.  Worker 0, the calling thread, isn't
+// moved.
+static void c2m_sched_place(uint32_t n_workers) {
+	uint32_t worker = 0;
+
+	c2m_sched.n_nodes = SDL_GetNUMANodeCount();
+	for(uint32_t i = 0; i < n_workers; i++) c2m_sched.deques[i].node = 0;
+	for(int node = 0; node < c2m_sched.n_nodes; node++) {
+		for(int cpu = 0; cpu < SDL_CPU_TOPOLOGY_MAX; cpu++) {
+			if(worker == n_workers) return;
+			if(SDL_GetCPUNUMANode(cpu) == node)
+				c2m_sched.deques[worker++].node = node;
+		}
+	}
+}
+
+// Start the threads, from the thread that'll spawn the outermost tasks.
+static void c2m_sched_start(void) {
+	uint32_t n_workers = SDL_GetCPUCount();
+	char name[16];
+
+	if(n_workers > C2M_MAX_WORKERS) n_workers = C2M_MAX_WORKERS;
+	c2m_sched.park = SDL_CreateSemaphore(0);
+	SDL_AtomicSet(&c2m_sched.n_parked, 0);
+	for(uint32_t i = 0; i < n_workers; i++)
+		c2m_sched.deques[i].seed = 0x9E3779B9u * (i + 1);
+	if(c2m_sched.park == NULL) n_workers = 1;
+	c2m_sched_place(n_workers);
+	c2m_sched.n_workers = n_workers;
+	for(uint32_t i = 1; i < n_workers; i++) {
+		SDL_Thread* thread;
+
+		snprintf(name, sizeof(name), "c2m_worker%u", i);
+		thread = SDL_CreateThread(c2m_sched_worker, name,
+			(void*)(uintptr_t)i);
+
+		// Not fatal, a thread that didn't start leaves its deque empty.
+		if(thread) SDL_DetachThread(thread);
+	}
+}
+
+static void c2m_group_init(c2m_group_t* group) {
+	SDL_AtomicSet(&group->pending, 1);
+	if((group->done = SDL_CreateSemaphore(0)) == NULL)
+		c2m_abort("couldn't create a semaphore");
+}
+
+// Run `task` on whichever thread gets to it first.  It's run right away if
+// this thread's deque is full.
+static void c2m_group_spawn(c2m_group_t* group, c2m_task_t* task) {
+	task->group = group;
+	SDL_AtomicAdd(&group->pending, 1);
+	c2m_trace_flow_start("spawn", (uintptr_t)task);
+	if(!c2m_deque_push(&c2m_sched.deques[c2m_sched_self()], task)) {
+		c2m_task_run(task);
+		return;
+	}
+	SDL_AtomicThreadFence(SDL_MEMORY_ORDER_SEQ_CST); // Push, then look
+	if(SDL_AtomicLoad(&c2m_sched.n_parked, SDL_MEMORY_ORDER_RELAXED))
+		SDL_SemPost(c2m_sched.park);
+}
+
+// Returns once all of the group's tasks are done, & frees the group.  While
+// the newest task in this thread's deque is the group's it's run here, a task
+// of an outer group isn't ( it could wait on the job this thread's in ).  The
+// rest were stolen, so then the joiner drops its count & waits for the last.
+static void c2m_group_join(c2m_group_t* group) {
+	c2m_deque_t* deque = &c2m_sched.deques[c2m_sched_self()];
+	c2m_task_t* task;
+
+	while((task = c2m_deque_pop(deque))) {
+		if(task->group != group) {
+			c2m_deque_push(deque, task);
+			break;
+		}
+		c2m_task_run(task);
+	}
+	if(SDL_AtomicFetchAdd(&group->pending, -1, SDL_MEMORY_ORDER_ACQ_REL) != 1)
+		SDL_SemWait(group->done);
+	SDL_DestroySemaphore(group->done);
+}
+
+typedef struct{
+	c2m_job_fn* run;
+	void** jobs;
+	uint32_t n_jobs;
+	SDL_atomic_t next; // Index of the next job to hand out
+}c2m_workers_t;
+
+// Jobs are handed out in order ( an emit waits for the ones before it ).
+static void c2m_worker(void* data) {
+	c2m_workers_t* workers = data;
+	int i;
+
+	while((i = SDL_AtomicFetchAdd(&workers->next, 1, SDL_MEMORY_ORDER_RELAXED))
+		< (int)workers->n_jobs)
+		workers->run(workers->jobs[i]);
+}
+
+// Run `run` on each of `jobs`, returns once all of them are done.
+static void c2m_workers_run(c2m_job_fn* run, void** jobs, uint32_t n_jobs) {
+	c2m_task_t tasks[C2M_MAX_WORKERS];
+	c2m_workers_t workers;
+	c2m_group_t group;
+	uint32_t n_tasks;
+
+	if(n_jobs < 2 || c2m_workers_serial) {
+		for(uint32_t i = 0; i < n_jobs; i++) run(jobs[i]);
+		return;
+	}
+	if(c2m_sched.n_workers == 0) c2m_sched_start();
+	n_tasks = c2m_sched.n_workers < n_jobs ? c2m_sched.n_workers : n_jobs;
+	workers.run = run;
+	workers.jobs = jobs;
+	workers.n_jobs = n_jobs;
+	SDL_AtomicSet(&workers.next, 0);
+	c2m_group_init(&group);
+	for(uint32_t i = 1; i < n_tasks; i++) {
+		tasks[i].run = c2m_worker;
+		tasks[i].job = &workers;
+		c2m_group_spawn(&group, &tasks[i]);
+	}
+	c2m_worker(&workers);
+	c2m_group_join(&group);
+}
@@ -1,49 +1,36 @@
+#define _GNU_SOURCE // Before any system header, for CPU affinity & futexes
 #include <stdio.h>
-
-// RWOPS support ( includes thread & timer support )
-#define _GNU_SOURCE
-#include <sys/mman.h>
-// Timer
-#include "../SDL2-c2m/src/timer/windows/SDL_systimer.c"
-#include "../SDL2-c2m/src/timer/unix/SDL_systimer.c"
-#include "../SDL2-c2m/src/timer/haiku/SDL_systimer.c"
-#include "../SDL2-c2m/src/timer/psp/SDL_systimer.c"
-
-//
-#include "../SDL2-c2m/src/SDL_hints.c"
-#include "../SDL2-c2m/src/atomic/SDL_atomic.c"
-#include "../SDL2-c2m/src/atomic/SDL_spinlock.c"
-
-#include "../SDL2-c2m/src/thread/psp/SDL_syscond.c"
-#include "../SDL2-c2m/src/thread/psp/SDL_sysmutex.c"
-#include "../SDL2-c2m/src/thread/psp/SDL_syssem.c"
-#include "../SDL2-c2m/src/thread/psp/SDL_systhread.c"
-
-#include "../SDL2-c2m/src/thread/pthread/SDL_syscond.c"
-#include "../SDL2-c2m/src/thread/pthread/SDL_sysmutex.c"
-#include "../SDL2-c2m/src/thread/pthread/SDL_syssem.c"
-#include "../SDL2-c2m/src/thread/pthread/SDL_systhread.c"
-#include "../SDL2-c2m/src/thread/pthread/SDL_systls.c"
-
-#include "../SDL2-c2m/src/thread/windows/SDL_sysmutex.c"
-#include "../SDL2-c2m/src/thread/windows/SDL_syssem.c"
-#include "../SDL2-c2m/src/thread/windows/SDL_systhread.c"
-#include "../SDL2-c2m/src/thread/windows/SDL_systls.c"
-
-//
-#include "../SDL2-c2m/src/thread/SDL_thread.c"
-#include "../SDL2-c2m/src/SDL_log.c"
-#include "../SDL2-c2m/src/SDL_error.c"
-#include "../SDL2-c2m/src/stdlib/SDL_getenv.c"
-#include "../SDL2-c2m/src/stdlib/SDL_stdlib.c"
-#include "../SDL2-c2m/src/stdlib/SDL_string.c"
-#include "../SDL2-c2m/src/stdlib/SDL_malloc.c"
-#include "../SDL2-c2m/src/file/SDL_rwops.c"
-
+#include <setjmp.h>
+
+// SDL: RWops, threads, timers ( the prebuilt runtime, see c2m_runtime.c )
+#include "c2m_runtime.h"
+
+// --trace, on SDL's clock ( also a generated program's runtime )
+#define C2M_TRACE_NOW() SDL_GetFastPerformanceCounter()
+#define C2M_TRACE_FREQ() SDL_GetFastPerformanceFrequency()
+#define C2M_TRACE_COMPILER
+#include "c2m_trace.c"
+// --mem-report & --time-report, wrap the allocations of everything included
+// after them
+#include "c2m_mem.c"
+#include "c2m_time.c"
 // String support ( includes Clump Array )
 #include "c2m_string.c"
+// Arenas ( syntax tree & other per compile objects )
+#include "c2m_arena.c"
+// Clump hash functions
+#include "../clump/src/clump.c"
+// Clump Arena ( pools can live in one )
+#include "../clump/src/arena.c"
+// Clump Pool ( symbols )
+#include "../clump/src/pool.c"
+// Clump Bloom & cuckoo filters ( a hash table's, if it's given one )
+#include "../clump/src/filter.c"
+// Clump Robin Hood hash ( symbol tables )
+#include "../clump/src/rhash.c"
+// Clump perfect hash ( keyword tables, see c2m_import_table.c )
+#include "../clump/src/phash.c"
 // Clump List
-//#include "../clump/src/pool.c"
 //#include "../clump/src/list.c"
 
 enum {
@@ -60,623 +47,711 @@ enum {
 	TYPE_FLOAT64,
 	TYPE_POINTER,
 	TYPE_INTEGER,
+	TYPE_ARGS, // main()'s args, a view of argv ( c2m_args_t )
+	TYPE_LIST, // Strings, passed by pointer ( c2m_list_t )
+	TYPE_RECORD, // See the node's record
+	TYPE_SET, // Integers 0 to 255, a bitset value ( c2m_set_t )
+	TYPE_ROWS, // "Record[]", a collection of the node's record
 }c2m_type_t;
 
+// Set while watching ( see c2m_watch.c ), a failed build returns there.
+static jmp_buf* c2m_abort_jump = NULL;
+
+static void c2m_abort(const char* reason); // After the backends
+
+// Leveled log, off by default
+#include "c2m_log.c"
+// Tokenizer ( needs c2m_abort )
+#include "c2m_lexer.c"
+// Syntax tree
+#include "c2m_ast.c"
+// Identifier interning & symbol tables
+#include "c2m_cmap.c"
+#include "c2m_intern.c"
+#include "c2m_symbol.c"
+// Record ( value type ) layout
+#include "c2m_record.c"
+
+// C headers & prelude files the generated code needs.
 typedef struct{
-	char* module; // 24 + null byte
-	char* function;
-	void* next;
-}c2m_func_t;
+	uint8_t stdlib;
+	uint8_t stdio;
+	uint8_t clump;
+	uint8_t sdl;
+	uint8_t sdl_window;
+	uint8_t sdl_audio;
+	uint8_t string; // memcpy() & strlen() for runtime concatenation
+	uint8_t concat; // c2m_cat_int() & c2m_cat_uint()
+	uint8_t io; // Buffered output runtime, see c2m_prelude_io
+	uint8_t args; // main() uses args, see c2m_prelude_args
+	uint8_t list; // c2m_list_t & c2m_list_push(), see c2m_prelude_list
+	uint8_t set; // c2m_set_t & its kernels, see c2m_prelude_set
+	uint8_t par; // Parallel loops' thread pool, see c2m_prelude_par
+	uint8_t co; // Coroutines' event loop, see c2m_prelude_co
+	uint8_t trace; // `trace` functions' recorder, see c2m_trace.c
+	uint8_t bench; // Benchmarks' timing, see c2m_prelude_bench
+	uint8_t agg; // Group-by & join runtime, see c2m_prelude_agg
+	uint8_t lines; // For loops over a file's lines, see c2m_prelude_lines
+	uint8_t profile; // Sampling profiler, see c2m_profile.c
+}c2m_libreq_t;
 
 typedef struct{
 	char* name;
 	char* version;
 	char* creator;
-	char* library;
+	char* library; // "1" ( TRUE ) exports src/<name>.c2m, see c2m_export.c
+	const char* exports; // Its module name ( interned ), NULL for a program
+	char* output; // What the C compiler makes: the program or lib<name>.o
+	char* header; // <name>.h, a library's
+	char* path; // Library directories after lib/, separated by ':'
+	char* io; // "line" or "block" ( default ) buffered output, see io.c2m
+	char* pgo_train; // Command that trains a --pgo-generate build
+	char* compiler; // The C compiler, "clang" if not set
+	char* run_compiler; // c2m run's, "compiler" if not set
+	char* opt; // Optimization level, "3" if not set
+	char* march; // Target CPU, mtune what it's tuned for
+	char* mtune;
+	char* cflags; // More flags, separated by spaces
+	char* lto_config; // "1" ( TRUE ) for lto
+	char* static_config; // "1" ( TRUE ) to link statically
+	struct cl_array* flags; // char*, code generation, see c2m_backend_config
+	uint8_t link_static;
 	struct cl_array* main;
-	struct cl_array* functions;
-	struct cl_array* libfuncs;
-	struct cl_array* varnames;
-	uint8_t in_main;
-	uint8_t in_func;
+	c2m_intern_t* intern; // Identifiers
+	c2m_symtab_t* variables;
+	c2m_symtab_t* types;
 	uint8_t return_success;
-	uint32_t goto_count;
-	uint32_t block_count;
-	struct{
-		uint8_t stdlib;
-		uint8_t stdio;
-		uint8_t clump;
-		uint8_t sdl;
-		uint8_t sdl_window;
-		uint8_t sdl_audio;
-	}libreq;
-	c2m_func_t* imports;
+	uint8_t emit_only; // Stop after writing main.c
+	uint8_t stats; // Print allocation counters
+	uint8_t use_cache; // Look up & store builds in .c2m-cache
+	const char* remote; // Shared build cache's URL or NULL, see c2m_remote.c
+	uint64_t remote_ns; // Its namespace ( c2m & the C compiler's version )
+	uint64_t remote_key; // This build's manifest in it, 0 if not shared
+	uint8_t remote_hit; // The binary came from it
+	uint64_t output_hash; // Of the generated C & the C compiler command
+	struct cl_array* inputs; // c2m_input_t, every file read
+	void* out; // c2m_output_t, main.c & the backend while emitting
+	uint8_t use_prelude; // Precompile the headers ( --prelude )
+	uint8_t split; // A translation unit per module ( --split )
+	uint8_t lto; // Link time optimization for split builds ( --lto )
+	uint8_t distcc; // Split builds' units compiled by distcc ( --distcc )
+	uint8_t debug; // Debug info & frame pointers ( --debug )
+	uint8_t profile; // Frame pointers & C2M_PROFILE's runtime ( --profile )
+	uint8_t bench; // Build & run the benches instead, see c2m_bench.c
+	uint8_t run; // Build quickly & run it ( c2m run ), see c2m_run.c
+	uint32_t jobs; // C compilers to run at once ( -j )
+	char* prelude; // Precompiled header to -include, or NULL
+	const void* backend; // c2m_backend_t, turns main.c into a binary
+	int backend_fd; // Pipe to the C compiler ( pipe backend )
+	int backend_pid;
+	c2m_libreq_t libreq;
+	c2m_symtab_t* import_table; // "module.function" -> first call
+	struct cl_array* imports; // c2m_symbol_t*, in the order found
+	struct cl_array* import_files; // const char*, where each was called
+	c2m_arena_t* arena; // Syntax tree, config values & input paths
+	c2m_node_t* main_fn;
+	c2m_node_t* records; // NODE_RECORD, in the order defined
+	c2m_node_t* imported; // Imported functions, linked through next
+	struct cl_array* passes;
+	struct cl_array* sources; // Source buffers the tree points into
+	c2m_symtab_t* modules; // Parsed library modules
+	struct cl_array* module_list; // c2m_module_t*, in the order first used
+	uint8_t batch; // One of several projects, see c2m_batch.c
+	uint8_t pending; // Batch: the C compiler's still running
+	c2m_symtab_t* module_cache; // Batch: "name:hash" -> parsed module
+	struct cl_array* lib_path; // char*, -L directories
+	struct cl_array* lib_dirs; // c2m_libdir_t, the search path
+	uint64_t library_hash; // Of the search path, for the build cache
+	void* diags; // c2m_diags_t, errors found so far ( shared by workers )
+	const char* file; // Being parsed or checked, for diagnostics
+	jmp_buf* recover; // Where c2m_error() resumes, NULL to stop the build
+	uint8_t pgo; // C2M_PGO_*, see c2m_pgo.c
+	const char* pgo_profile; // --pgo-use
+	char* pgo_flag; // For the C compiler, NULL without PGO
+	uint64_t pgo_hash; // Of the profile used
 }c2m_t;
 
+// Source buffers ( mmap )
+#include "c2m_source.c"
+// Error reporting & recovery
+#include "c2m_diag.c"
+// Build cache & C compiler backends
+#include "c2m_cache.c"
+#include "c2m_prelude.c"
+#include "c2m_backend.c"
+#include "c2m_remote.c"
+
+// The build the C compiler is reading, set by c2m_output_open().  An abort
+// that doesn't return to c2m_watch kills the compiler while it's still being
+// written to, or it'd go on to compile half a program after c2m has exited.
+static c2m_t* c2m_abort_build = NULL;
+
 static void c2m_abort(const char* reason) {
 	printf("Aborting because: \"%s\"\n", reason);
-	exit(1);
-}
-
-void c2m_skip_whitespace(int32_t* i, const char* string) {
-	char value;
-
-	value = string[*i];
-	while(value == ' ' || value == '\t') {
-		(*i) = (*i) + 1;
-		value = string[*i];
-	}
-}
+	if(c2m_abort_jump) longjmp(*c2m_abort_jump, 1);
+	if(c2m_abort_build && c2m_abort_build->backend_fd >= 0) {
+		const c2m_backend_t* backend = c2m_abort_build->backend;
 
-// Returns 1 if not what expected.
-static uint8_t c2m_expect(int32_t* i, const char* string, char* what) {
-	if(strncmp(&string[*i], what, strlen(what))) {
-		return 1;
+		backend->cancel(c2m_abort_build);
 	}
-
-	*i += strlen(what);
-	return 0;
-}
-
-static uint8_t c2m_checknum(int32_t* i, const char* string, char** dest) {
-	char temp[256];
-	uint8_t howmany = 0;
-	if(string[*i] >= '0' && string[*i] <= '9') {
-		while(string[*i] >= '0' && string[*i] <= '9') {
-			temp[howmany] = string[*i];
-			howmany++;
-			if(howmany == 255) c2m_abort("Maxed out number length");
-			*i = *i + 1;
-		}
-		printf("Malloc....\n");
-		*dest = malloc(howmany + 1);
-		printf("Malloc done....\n");
-		memcpy(*dest, temp, howmany);
-		(*dest)[howmany] = 0;
-		return 0;
-	}
-	return 1;
-}
-
-static uint32_t c2m_count(int32_t* i, const char* string, char what) {
-	int count = 0;
-
-	for(int j = *i; j < strlen(string); j++) {
-		if(string[j] == what)
-			return j - *i;
-		if(string[j] == '\n' || string[j] == '\0')
-			return 0;
-	}
-//	printf("Expected character \"%c\":", what);
-//	printf("%s\n", &string[*i]);
-	return 0;
-}
-
-static inline
-void c2m_read(int32_t* i, const char* string, char* dest, uint32_t len) {
-	memcpy(dest, &string[*i], len), dest[len] = 0;
-	*i += len;
-}
-
-static uint8_t
-c2m_process_value(int32_t* i, const char* string, char** dest, uint8_t* type) {
-	// Probably more whitespace
-	c2m_skip_whitespace(i, string);
-	// Check for type
-	if(c2m_expect(i, string, "\"") == 0) {
-		*type = TYPE_STRING;
-		// String Declaration
-		uint32_t len = c2m_count(i, string, '\"');
-		if(len == 0) c2m_abort("closing double quote is missing");
-		*dest = malloc(len + 1);
-		c2m_read(i, string, *dest, len);
-		if(c2m_expect(i, string, "\"\n")) {
-			c2m_expect(i, string, "\"");
-			c2m_skip_whitespace(i, string);
-			if(c2m_expect(i, string, "+") == 0) {
-				uint8_t type2 = 0;
-				char* dest2 = NULL;
-				if(c2m_process_value(i, string, &dest2, &type2))
-					c2m_abort("Unrecognized value");
-				printf("Processed append onto string....");
-				printf("O: %s\n", dest2);
-				if(type2 == TYPE_INTEGER) {
-					*dest = realloc(*dest,
-						len + strlen(dest2) + 1);
-					memcpy(*dest + len, dest2, strlen(dest2));
-				}
-			}
-		}
-	}else if(c2m_expect(i, string, "TRUE") == 0) {
-		*type = TYPE_UBYTE;
-		// Byte declaration: 1
-		*dest = malloc(2);
-		(*dest)[0] = '1', (*dest)[1] = 0;
-		c2m_expect(i, string, "\n");
-	}else if(c2m_expect(i, string, "FALSE") == 0) {
-		*type = TYPE_UBYTE;
-		// Byte declaration: 0
-		*dest = malloc(2);
-		(*dest)[0] = '0', (*dest)[1] = 0;
-		c2m_expect(i, string, "\n");
-	}else if(c2m_checknum(i, string, dest) == 0) {
-		*type = TYPE_INTEGER;
-		c2m_skip_whitespace(i, string);
-		printf("processed number %s", *dest);
-		if(string[*i] != '\0') {
-			printf("ERROR: %d %c", string[*i], string[*i]);
-			c2m_abort("Not null after integer!");
-		}
-	}else{
-		const char* what = &string[*i];
-		*dest = malloc(strlen(what) + 1);
-		memcpy(*dest, what, strlen(what) + 1);
-		*i = *i + strlen(what);
-		c2m_expect(i, string, "\n");
-//		(*dest)[0] = '0', (*dest)[strlen(what)] = 0;
-//		printf("not proper at all %s\n", &string[*i]);
-		// Not a proper declaration.
-//		return 1;
-	}
-	return 0;
+	exit(1);
 }
+// Parser, passes & emitter
+#include "c2m_import_table.c"
+#include "c2m_parse.c"
+#include "c2m_pass.c"
+#include "c2m_emit.c"
+// Streaming output
+#include "c2m_output.c"
+// Library modules ( parsed & emitted on worker threads )
+#include "c2m_worker.c"
+#include "c2m_chunk.c"
+#include "c2m_interface.c"
+#include "c2m_prescan.c"
+#include "c2m_library.c"
+#include "c2m_module.c"
+// Compile-time evaluation of pure functions ( for c2m_fold )
+#include "c2m_eval.c"
+// Constant folding & type checks ( a pass, needs the modules )
+#include "c2m_fold.c"
+// Parallel loops ( a pass & their emitter )
+#include "c2m_parallel.c"
+// Async functions ( a pass & their emitter )
+#include "c2m_async.c"
+// Stack or heap buffers for concatenations ( a pass )
+#include "c2m_escape.c"
+// For loops ( a pass & their emitter )
+#include "c2m_loop.c"
+// Inlining small library functions ( a pass too )
+#include "c2m_inline.c"
+// Benchmarks ( --bench )
+#include "c2m_bench.c"
+// Quick builds that run at once ( c2m run )
+#include "c2m_run.c"
+// Separate compilation
+#include "c2m_split.c"
+// Libraries ( library = TRUE )
+#include "c2m_export.c"
+// Many projects in one process ( --batch ) & rebuilding on change ( --watch )
+#include "c2m_batch.c"
+#include "c2m_watch.c"
+// Profile guided builds ( --pgo-generate & --pgo-use )
+#include "c2m_pgo.c"
 
 /*
  * Returns 1 if not a variable declaration.
 */
-static uint8_t c2m_declare_var(int32_t* i, const char* string, char** dest) {
-	// After name probably whitespace
-	c2m_skip_whitespace(i, string);
+static uint8_t c2m_declare_var(c2m_t* c2m, c2m_lexer_t* lex, char** dest) {
 	// Check for equals
-	if(c2m_expect(i, string, "=")) return 1;
+	if(c2m_lex_expect(lex, "=")) return 1;
 	//
-	uint8_t type = 0;
-	return c2m_process_value(i, string, dest, &type);
+	c2m_node_t* value = c2m_parse_value(c2m, lex);
+	if(value == NULL || value->kind == NODE_CONCAT) return 1;
+	*dest = c2m_arena_strndup(c2m->arena, value->text, value->length);
+	return c2m_lex_newline(lex) && c2m_lex_peek(lex, 0)->kind != TOKEN_EOF;
 }
 
 void c2m_gconfig(c2m_t* c2m) {
-	SDL_RWops *file;
+	c2m_source_t config;
 
-	if((file = SDL_RWFromFile("c2m.config", "rb")) == NULL) {
+	if(c2m_source_open(&config, "c2m.config")) {
 		c2m_abort("No c2m.config found!");
 	}
-
-	uint64_t size = SDL_RWsize(file);
-	char filecontents[size + 1];
-
-	SDL_RWread(file, filecontents, size, 1);
-	for(int32_t i = 0; i < size;) {
-		if(strncmp(&filecontents[i], "name", 4) == 0) {
-			i += 4;
-			if(c2m_declare_var(&i, filecontents, &c2m->name))
-				c2m_abort("Improper variable declaration.");
-		}else if(strncmp(&filecontents[i], "version", 7) == 0) {
-			i += 7;
-			if(c2m_declare_var(&i, filecontents, &c2m->version))
-				c2m_abort("Improper variable declaration.");
-		}else if(strncmp(&filecontents[i], "creator", 7) == 0) {
-			i += 7;
-			if(c2m_declare_var(&i, filecontents, &c2m->creator))
-				c2m_abort("Improper variable declaration.");
-		}else if(strncmp(&filecontents[i], "library", 7) == 0) {
-			i += 7;
-			if(c2m_declare_var(&i, filecontents, &c2m->library))
-				c2m_abort("Improper variable declaration.");
+	c2m_cache_input(c2m, "c2m.config", config.data, config.size);
+
+	c2m_lexer_t lex;
+	c2m_lex(&lex, config.data, config.size);
+	while(c2m_lex_peek(&lex, 0)->kind != TOKEN_EOF) {
+		char** dest = NULL;
+
+		if(c2m_lex_newline(&lex) == 0) {
+			continue;
+		}else if(c2m_lex_expect(&lex, "name") == 0) {
+			dest = &c2m->name;
+		}else if(c2m_lex_expect(&lex, "version") == 0) {
+			dest = &c2m->version;
+		}else if(c2m_lex_expect(&lex, "creator") == 0) {
+			dest = &c2m->creator;
+		}else if(c2m_lex_expect(&lex, "library") == 0) {
+			dest = &c2m->library;
+		}else if(c2m_lex_expect(&lex, "path") == 0) {
+			dest = &c2m->path;
+		}else if(c2m_lex_expect(&lex, "io") == 0) {
+			dest = &c2m->io;
+		}else if(c2m_lex_expect(&lex, "pgo_train") == 0) {
+			dest = &c2m->pgo_train;
+		}else if(c2m_lex_expect(&lex, "compiler") == 0) {
+			dest = &c2m->compiler;
+		}else if(c2m_lex_expect(&lex, "run_compiler") == 0) {
+			dest = &c2m->run_compiler;
+		}else if(c2m_lex_expect(&lex, "opt") == 0) {
+			dest = &c2m->opt;
+		}else if(c2m_lex_expect(&lex, "march") == 0) {
+			dest = &c2m->march;
+		}else if(c2m_lex_expect(&lex, "mtune") == 0) {
+			dest = &c2m->mtune;
+		}else if(c2m_lex_expect(&lex, "cflags") == 0) {
+			dest = &c2m->cflags;
+		}else if(c2m_lex_expect(&lex, "lto") == 0) {
+			dest = &c2m->lto_config;
+		}else if(c2m_lex_expect(&lex, "static") == 0) {
+			dest = &c2m->static_config;
 		}else{
 			break;
 		}
+		if(c2m_declare_var(c2m, &lex, dest))
+			c2m_abort("Improper variable declaration.");
+	}
+	c2m_lex_destroy(&lex);
+	c2m_source_close(&config);
+	if(c2m->io && strcmp(c2m->io, "line") && strcmp(c2m->io, "block"))
+		c2m_abort("io must be \"line\" or \"block\"");
+	if(c2m->lto_config && strcmp(c2m->lto_config, "1") == 0) c2m->lto = 1;
+	if(c2m->static_config && strcmp(c2m->static_config, "1") == 0)
+		c2m->link_static = 1;
+	c2m_backend_config(c2m);
+	if(c2m->name == NULL) c2m_abort("c2m.config has no name");
+	if(c2m->library && strcmp(c2m->library, "1") == 0) {
+		struct cl_array* path = c2m_string_create(NULL);
+
+		if(c2m->bench) c2m_abort("--bench needs a program, not a library");
+		if(c2m->run) c2m_abort("c2m run needs a program, not a library");
+		// Also the prefix of every C name it exports.
+		if(c2m_export_check(c2m->name))
+			c2m_abort("A library's name must be a C identifier");
+		c2m->exports = c2m_intern(c2m->intern, c2m->name,
+			strlen(c2m->name));
+		c2m_string_appendf(path, "lib%s.o", c2m->name);
+		c2m->output = c2m_arena_strndup(c2m->arena, path->store,
+			c2m_string_length(path));
+		c2m_string_clear(path);
+		c2m_string_appendf(path, "%s.h", c2m->name);
+		c2m->header = c2m_arena_strndup(c2m->arena, path->store,
+			c2m_string_length(path));
+		c2m_string_destroy(path);
+	}else if(c2m->bench || c2m->run) {
+		struct cl_array* path = c2m_string_create(NULL);
+
+		c2m_string_appendf(path, c2m->bench ? "%s-bench" : "%s-run",
+			c2m->name);
+		c2m->output = c2m_arena_strndup(c2m->arena, path->store,
+			c2m_string_length(path));
+		c2m_string_destroy(path);
+	}else{
+		c2m->output = c2m->name;
 	}
-//	printf("name = '%s'\n", c2m->name);
-//	printf("version = '%s'\n", c2m->version);
-//	printf("creator = '%s'\n", c2m->creator);
-//	printf("library = '%s'\n", c2m->library);
 }
 
-static inline void c2m_output(SDL_RWops *output, const char* string) {
-	if(SDL_RWwrite(output, string, 1, strlen(string)) != strlen(string)) {
-		c2m_abort("Failed to write");
-	}
+// `intern` is shared by a batch, NULL for a new one.
+void c2m_init(c2m_t* c2m, c2m_intern_t* intern) {
+	c2m_lex_init();
+	c2m->main = c2m_string_create(NULL);
+	c2m->name = NULL;
+	c2m->version = NULL;
+	c2m->creator = NULL;
+	c2m->library = NULL;
+	c2m->exports = NULL;
+	c2m->output = NULL;
+	c2m->header = NULL;
+	c2m->path = NULL;
+	c2m->io = NULL;
+	c2m->pgo_train = NULL;
+	c2m->compiler = NULL;
+	c2m->run_compiler = NULL;
+	c2m->opt = NULL;
+	c2m->march = NULL;
+	c2m->mtune = NULL;
+	c2m->cflags = NULL;
+	c2m->lto_config = NULL;
+	c2m->static_config = NULL;
+	c2m->flags = cl_array_create(sizeof(char*), 8);
+	c2m->link_static = 0;
+	c2m->intern = intern ? intern : c2m_intern_create();
+	c2m->variables = c2m_symtab_create(c2m->intern);
+	c2m->types = c2m_symtab_create(c2m->intern);
+	c2m_symtab_add_types(c2m->types);
+	c2m->return_success = 1;
+	c2m->emit_only = 0;
+	c2m->stats = 0;
+	c2m->use_cache = 1;
+	c2m->remote = NULL;
+	c2m->remote_ns = 0;
+	c2m->remote_key = 0;
+	c2m->remote_hit = 0;
+	c2m->output_hash = C2M_HASH_INIT;
+	c2m->inputs = cl_array_create(sizeof(c2m_input_t), 16);
+	c2m->out = NULL;
+	c2m->use_prelude = 0;
+	c2m->split = 0;
+	c2m->lto = 0;
+	c2m->distcc = 0;
+	c2m->debug = 0;
+	c2m->profile = 0;
+	c2m->bench = 0;
+	c2m->run = 0;
+	c2m->jobs = SDL_GetCPUCount();
+	c2m->prelude = NULL;
+	c2m->backend = &c2m_backends[0];
+	c2m->backend_fd = -1;
+	c2m->import_table = c2m_symtab_create(c2m->intern);
+	c2m->imports = cl_array_create(sizeof(c2m_symbol_t*), 16);
+	c2m->import_files = cl_array_create(sizeof(char*), 16);
+	c2m->libreq.stdio = 0;
+	c2m->libreq.stdlib = 0;
+	c2m->libreq.clump = 0;
+	c2m->libreq.sdl = 0;
+	c2m->libreq.sdl_window = 0;
+	c2m->libreq.sdl_audio = 0;
+	c2m->libreq.string = 0;
+	c2m->libreq.concat = 0;
+	c2m->libreq.io = 0;
+	c2m->libreq.args = 0;
+	c2m->libreq.list = 0;
+	c2m->libreq.set = 0;
+	c2m->libreq.par = 0;
+	c2m->libreq.co = 0;
+	c2m->libreq.trace = 0;
+	c2m->libreq.bench = 0;
+	c2m->libreq.agg = 0;
+	c2m->libreq.lines = 0;
+	c2m->libreq.profile = 0;
+	c2m->arena = c2m_arena_create();
+	c2m->main_fn = NULL;
+	c2m->records = NULL;
+	c2m->imported = NULL;
+	c2m->sources = cl_array_create(sizeof(c2m_source_t), 8);
+	c2m->modules = c2m_symtab_create(c2m->intern);
+	c2m->module_list = cl_array_create(sizeof(void*), 8);
+	c2m->batch = 0;
+	c2m->pending = 0;
+	c2m->module_cache = NULL;
+	c2m->lib_path = cl_array_create(sizeof(char*), 4);
+	c2m->lib_dirs = cl_array_create(sizeof(c2m_libdir_t), 4);
+	c2m->library_hash = C2M_HASH_INIT;
+	c2m->diags = c2m_diags_create();
+	c2m->file = "src/main.c2m";
+	c2m->recover = NULL;
+	c2m->pgo = C2M_PGO_OFF;
+	c2m->pgo_profile = NULL;
+	c2m->pgo_flag = NULL;
+	c2m->pgo_hash = 0;
+	c2m_pass_init(c2m);
 }
 
-void c2m_modular_func_call(c2m_t* c2m, int32_t* i, const char* string,
-	struct cl_array* mof)
-{
-	c2m_skip_whitespace(i, string);
-	uint32_t len = c2m_count(i, string, '.');
-	if(len == 0) {
-		printf("Where = %s", &string[*i]);
-		c2m_abort("no module function separator");
-	}
-	char* module_name = malloc(len);
-	c2m_read(i, string, module_name, len);
-	c2m_expect(i, string, ".");
-	uint32_t len2 = c2m_count(i, string, '(');
-	if(len == 0) c2m_abort("need an opening parenthesis");
-	char* function_name = malloc(len2);
-	c2m_read(i, string, function_name, len2);
-//	c2m_expect(i, string, "\n");
-	fputs("Import module: ", stdout);
-	fputs(module_name, stdout);
-	fputs(" & Function: ", stdout);
-	fputs(function_name, stdout);
-	fputs("\n", stdout);
-	uint8_t found_module = 0;
-	// Search for module
-	c2m_func_t** current = &c2m->imports;
-	while(1) {
-		if(*current == NULL) {
-			*current = malloc(sizeof(c2m_func_t));
-			(*current)->module = module_name;
-			(*current)->function = function_name;
-			(*current)->next = NULL;
-			break;
-		}
-		if(strcmp((*current)->module, module_name) == 0 &&
-		   strcmp((*current)->function, function_name) == 0)
-		{
-			free(module_name);
-			free(function_name);
-			module_name = (*current)->module;
-			function_name = (*current)->function;
-			break;
-		}
-		current = (void*)&((*current)->next);
-	}
-	c2m_string_append(mof, module_name);
-	c2m_string_append(mof, "__");
-	c2m_string_append(mof, function_name);
-	c2m_string_append(mof, "(");
-	if(c2m_expect(i, string, "("))
-		c2m_abort("No opening parenthesis after function call");
-	
-	uint32_t len3 = c2m_count(i, string, ')');
-	if(len == 0) c2m_abort("No closing parenthesis for fn call");
-	char* parameter = malloc(len3);
-	c2m_read(i, string, parameter, len3);
-	uint8_t add_comma = 0;
-	
-	for(int32_t k = 0; k < len3;) {
-		char* returnv = NULL;
-		uint8_t type = 0;
-		c2m_process_value(&k, parameter, &returnv, &type);
-		if(add_comma) {
-			c2m_string_append(mof, ",");
-		}
-		if(type == TYPE_STRING) {
-			c2m_string_append(mof, "\"");
-			c2m_string_append(mof, returnv);
-			c2m_string_append(mof, "\"");
-		}else{
-			c2m_abort("Unsupported type");
-		}
-		free(returnv);
-		add_comma = 1;
-	}
-	c2m_string_append(mof, ");\n");
-	if(c2m_expect(i, string, ")\n"))
-		c2m_abort("Missing newline after function call");
+// Release the source buffers, the tree can't be used after this.
+static void c2m_close_sources(c2m_t* c2m) {
+	for(uint32_t i = 0; i < cl_array_count(c2m->sources); i++)
+		c2m_source_close(cl_array_borrow(c2m->sources, i));
+	cl_array_clear(c2m->sources);
 }
 
-void c2m_infunc(c2m_t* c2m, int32_t* i, const char* string, struct cl_array* a){
-	c2m_skip_whitespace(i, string);
-	if(c2m_expect(i, string, "while") == 0) {
-		c2m->goto_count++;
-		uint32_t add = c2m->goto_count;
-
-		c2m_string_append(a, "C2M_WHILE");
-		while(add) {
-			char lnum = '0' + (add % 10);
-			add /= 10;
-			char dest[2];
-			dest[0] = lnum;
-			dest[1] = '\0';
-			c2m_string_append(a, dest);
-		}
-		c2m_string_append(a, ":\n");
-		c2m->block_count++;
+// Free a finished ( or aborted ) compile, not the intern or module cache.
+void c2m_release(c2m_t* c2m) {
+	if(c2m_abort_build == c2m) c2m_abort_build = NULL;
+	c2m_module_destroy_all(c2m);
+	c2m_symtab_destroy(c2m->modules);
+	cl_array_destroy(c2m->module_list);
+	c2m_close_sources(c2m);
+	cl_array_destroy(c2m->sources);
+	c2m_string_destroy(c2m->main);
+	c2m_symtab_destroy(c2m->variables);
+	c2m_symtab_destroy(c2m->types);
+	c2m_symtab_destroy(c2m->import_table);
+	cl_array_destroy(c2m->imports);
+	cl_array_destroy(c2m->import_files);
+	cl_array_destroy(c2m->passes);
+	cl_array_destroy(c2m->inputs); // Paths may be another compile's
+	c2m_arena_destroy(c2m->arena);
+	free(c2m->prelude);
+	cl_array_destroy(c2m->lib_path);
+	cl_array_destroy(c2m->flags);
+	c2m_library_destroy(c2m);
+	c2m_diags_destroy(c2m->diags);
+}
 
-		c2m_skip_whitespace(i, string);
-		if(c2m_expect(i, string, "{\n")) {
-			c2m_abort("Missing bracket + newline for while loop.");
-		}
-	}else if(c2m_expect(i, string, "exit\n") == 0) {
-		c2m->libreq.stdlib = 1;
-		c2m_string_append(a, "exit(0);");
-	}else if(c2m_expect(i, string, "fail\n") == 0) {
-		c2m->libreq.stdlib = 1;
-		c2m_string_append(a, "exit(1);");
-	}else if(c2m_expect(i, string, "}") == 0) {
-		printf("CLOSE BRACKET;\n");
-		if(c2m->block_count) {
-			c2m_string_append(a, "goto ");
-		// TODO: Repeated code in while
-		uint32_t add = c2m->goto_count;
-
-		c2m_string_append(a, "C2M_WHILE");
-		while(add) {
-			char lnum = '0' + (add % 10);
-			add /= 10;
-			char dest[2];
-			dest[0] = lnum;
-			dest[1] = '\0';
-			c2m_string_append(a, dest);
-		}
-		//
-			c2m_string_append(a, ";\n");
-			c2m->block_count--;
-		}else{
-			c2m->in_func = 0;
-			c2m_string_append(a, "}\n");
-		}
-	}else if(c2m_expect(i, string, "\n") == 0) {
-	}else if(c2m_expect(i, string, "int32_t") == 0) {
-		// check for C function call
-		uint32_t len = c2m_count(i, string, '\n');
-		char call[len + 1];
-
-		c2m_string_append(a, "int32_t");
-		c2m_read(i, string, call, len), call[len] = '\0';
-		c2m_string_append(a, call);
-		c2m_string_append(a, ";\n");
+void c2m_compile(c2m_t* c2m) {
+	fputs("Compiling ", stdout);
+	fputs(c2m->name, stdout);
+	fputs(" version ", stdout);
+	fputs(c2m->version, stdout);
+	fputs("\n", stdout);
+	const c2m_backend_t* backend = c2m->backend;
+	c2m_timer_t timer;
+	c2m_lexer_t lex;
+
+	c2m_library_init(c2m);
+	c2m_pgo_prepare(c2m);
+	if(c2m->use_cache && (c2m_cache_restore(c2m) == 0 ||
+		(c2m_remote_restore(c2m) == 0 && c2m_cache_restore(c2m) == 0)))
+	{
+		fputs("Up to date\n", stdout);
+		return;
+	}
+	c2m_time_begin(&timer);
+	if(c2m->exports) {
+		// Nothing runs of its own, the exported functions are the roots.
+		c2m->main_fn = c2m_node_create(c2m->arena, NODE_FUNCTION, 0);
+		c2m_node_text(c2m->main_fn, "main", 4);
 	}else{
-		// check for C function call
-		uint32_t len = c2m_count(i, string, ';');
-		char call[len + 1];
-
-		if(len == 0) {
-			// C-- function call
-			c2m_modular_func_call(c2m, i, string, a);
-			return;
-		}
-
-		c2m_read(i, string, call, len), call[len] = '\0';
-		c2m_string_append(a, call);
-		c2m_string_append(a, ";\n");
-		if(c2m_expect(i, string, ";\n")) {
-			c2m_abort("Missing newline for c function call");
-		}
+		c2m_parse_file(c2m, "src/main.c2m", &lex);
+		c2m->main_fn = c2m_parse_main(c2m, &lex);
+		c2m_lex_destroy(&lex);
 	}
-}
-
-static uint8_t
-c2m_process_var(int32_t* i, const char* string, struct cl_array* a) {
-	c2m_skip_whitespace(i, string);
-	if(c2m_expect(i, string, "string_t") == 0) {
-		uint32_t len = c2m_count(i, string, ',');
-		if(len) {
-			char par_name[len + 1];
-			
-			c2m_read(i, string, par_name, len), par_name[len] = '\0';
-			c2m_string_append(a, "char* ");
-			c2m_string_append(a, par_name);
-			c2m_string_append(a, ",");
-		}else{
-			c2m_string_append(a, "char* ");
-			c2m_string_append(a, &(string[*i]));
-			c2m_string_append(a, "){\n");
-			return 0;
+	c2m_time_end(&timer, &c2m_phases[C2M_PHASE_PARSE]);
+
+	c2m_time_begin(&timer);
+	c2m_module_resolve(c2m);
+	c2m_time_end(&timer, &c2m_phases[C2M_PHASE_IMPORT]);
+	// Syntax errors in any file, checking types after them would only
+	// report what they left out.
+	c2m_diag_check(c2m);
+	c2m_time_begin(&timer);
+	c2m_pass_run_all(c2m);
+	c2m_time_end(&timer, &c2m_phases[C2M_PHASE_PASSES]);
+	c2m_diag_check(c2m);
+	if(c2m->stats) c2m_intern_stats(c2m->intern);
+	if(c2m->split) {
+		c2m_split_compile(c2m);
+		if(c2m->exports) {
+			c2m_export_header(c2m);
+			if(c2m->emit_only == 0 && c2m_export_link(c2m))
+				c2m_abort("Linking the library failed");
 		}
-	}else{
-		fputs("Unknown Variable Type: ", stdout);
-		fputs(&string[*i], stdout);
-		fputs("\n", stdout);
-		c2m_abort("Unknown type");
+		c2m_module_destroy_all(c2m);
+		c2m_close_sources(c2m);
+		return;
 	}
-	return 1;
-}
 
-static void
-c2m_import(c2m_t* c2m, int32_t* i, const char* string, const char* mod,
-	const char* function)
-{
-	if(c2m_expect(i, string, "import stdio") == 0) {
-		c2m->libreq.stdio = 1;
-	}else if(c2m_expect(i, string, "import stdlib") == 0) {
-		c2m->libreq.stdlib = 1;
-	}else if(c2m_expect(i, string, "import clump") == 0) {
-		c2m->libreq.clump = 1;
-	}else if(c2m_expect(i, string, "import sdl") == 0) {
-		c2m->libreq.sdl = 1;
-	}else if(c2m_expect(i, string, "import sdl_window") == 0) {
-		c2m->libreq.sdl_window = 1;
-	}else if(c2m_expect(i, string, "import sdl_audio") == 0) {
-		c2m->libreq.sdl_audio = 1;
-	}else if(c2m_expect(i, string, "\n") == 0) {
+	if(c2m->use_prelude && c2m->emit_only == 0 && c2m_prelude_prepare(c2m))
+		fputs("Couldn't build prelude, compiling without\n", stdout);
+
+	// The C compiler starts now & is fed each definition once it's emitted.
+	c2m_time_begin(&timer);
+	c2m_output_open(c2m, c2m->emit_only ? NULL : backend);
+	// Include requirements from C
+	struct cl_array* includes = c2m_string_create(NULL);
+	if(c2m->use_prelude) c2m_string_append(includes, "#ifndef C2M_PRELUDE\n");
+	c2m_prelude_includes(c2m, includes);
+	if(c2m->use_prelude) c2m_string_append(includes, "#endif\n");
+	c2m_emit_records(c2m, includes);
+	// Library functions call each other in any order.
+	for(c2m_node_t* fn = c2m->imported; fn; fn = fn->next) {
+		if(fn->module != c2m->exports)
+			c2m_string_append(includes, "static ");
+		c2m_emit_prototype(fn, includes);
+		if(fn->indirect) c2m_async_prototype(c2m, fn, includes);
+	}
+	c2m_output_section(c2m, includes);
+	c2m_string_destroy(includes);
+	// Functions
+	c2m_module_emit(c2m);
+	struct cl_array* start = c2m_string_create(NULL);
+	if(c2m->exports) {
+		c2m_prelude_library(c2m, start);
+		c2m_output_section(c2m, start);
 	}else{
-		uint32_t len = c2m_count(i, string, '(');
-		if(len == 0) {
-			printf("ERROR @: %s", &(string[*i]));
-			c2m_abort("opening parenthesis missing");
+		c2m_emit_parallels(c2m, c2m->main_fn->body, start);
+		c2m_string_append(start, "int main(int argc, char* argv[]){\n");
+		c2m_prelude_main(c2m, start);
+		c2m_output(c2m, start->store);
+		c2m_emit(c2m);
+		c2m_output_section(c2m, c2m->main);
+		if(c2m->libreq.co) c2m_output(c2m, "c2m_co_loop();\n");
+		c2m_output(c2m, c2m->return_success ?
+			"return 0; }\n" : "return 1; }\n");
+		if(c2m->libreq.profile) {
+			c2m_string_clear(start);
+			c2m_emit_profile(c2m->main_fn, start);
+			c2m_output_section(c2m, start);
 		}
-		char func_name[len + 1];
+	}
+	c2m_string_destroy(start);
+	c2m_output_close(c2m);
+	if(c2m->exports) c2m_export_header(c2m);
+	c2m_time_end(&timer, &c2m_phases[C2M_PHASE_EMIT]);
+	c2m_module_destroy_all(c2m);
+	c2m_close_sources(c2m);
 
-		c2m_read(i, string, func_name, len), func_name[len] = '\0';
-		if(strcmp(func_name, function)) {
-			while(string[*i] != '}') *i = *i + 1;
-			c2m_expect(i, string, "}\n");
+	struct cl_array* clang_command = c2m_string_create(NULL);
+	c2m_backend_command(c2m, clang_command);
+	c2m->output_hash = c2m_hash(c2m->output_hash, clang_command->store,
+		c2m_string_length(clang_command));
+	c2m_string_destroy(clang_command);
+	if(c2m->emit_only == 0) {
+		fputs("Stage 2\n", stdout);
+		c2m_time_begin(&timer);
+		if(c2m->use_cache && (c2m_cache_lookup(c2m) == 0 ||
+			c2m_remote_binary(c2m) == 0))
+		{
+			// Same C as an earlier build, that binary is already there.
+			backend->cancel(c2m);
+			if(c2m_cache_binary(c2m))
+				c2m_abort("couldn't restore cached binary");
+			fputs("Compiled ( cached )\n", stdout);
+		}else if(c2m->batch) {
+			// Finished by c2m_batch_finish, next project meanwhile.
+			backend->flush(c2m);
+			c2m->pending = 1;
+			c2m_time_end(&timer, &c2m_phases[C2M_PHASE_BACKEND]);
 			return;
+		}else{
+			if(backend->close(c2m))
+				c2m_abort("C compiler failed");
+			fputs("Compiled\n", stdout);
 		}
-		printf("Open function %s\n", func_name);
-		c2m_expect(i, string, "(");
-		c2m_skip_whitespace(i, string);
-
-		uint32_t len2 = c2m_count(i, string, ')');
-		if(len2 == 0) c2m_abort("closing parenthesis missing");
-		char parameters[len2 + 1];
-		c2m_read(i, string, parameters, len2), parameters[len2] = '\0';
-		c2m_expect(i, string, ")");
-		c2m_skip_whitespace(i, string);
-		c2m_expect(i, string, "{\n");
-
-		c2m_string_append(c2m->libfuncs, "static void ");
-		c2m_string_append(c2m->libfuncs, mod);
-		c2m_string_append(c2m->libfuncs, "__");
-		c2m_string_append(c2m->libfuncs, func_name);
-		c2m_string_append(c2m->libfuncs, "(");
-
-		int j = 0;
-		while(c2m_process_var(&j, parameters, c2m->libfuncs));
-
-//		printf("AFTER VAR: %s", &(string[*i]));
-		c2m->in_func = 1;
-		while(*i < strlen(string) && c2m->in_func) {
-			c2m_infunc(c2m, i, string, c2m->libfuncs);
-		}
+		if(c2m->exports && c2m_export_link(c2m))
+			c2m_abort("Linking the library failed");
+		c2m_time_end(&timer, &c2m_phases[C2M_PHASE_BACKEND]);
 	}
+	if(c2m->use_cache) c2m_cache_save(c2m);
 }
 
-void c2m_loop(c2m_t* c2m, int32_t* i, const char* string) {
-	if(c2m_expect(i, string, "//") == 0) {
-		while(string[*i] != '\n' && string[*i] != '\0') *i = *i + 1;
-	}
-	if(c2m->in_main) {
-		// Skip indentation.
-		c2m_skip_whitespace(i, string);
-		if(c2m_expect(i, string, "exit\n}") == 0) {
-			c2m->in_main = 0;
-		}else if(c2m_expect(i, string, "fail\n}") == 0) {
-			c2m->return_success = 0;
-			c2m->in_main = 0;
-		}else if(c2m_expect(i, string, "}") == 0) {
-			printf("MAIN / CLOSE BRACKET;\n");
-			if(c2m->block_count) {
-				c2m_string_append(c2m->main, "goto ");
-				// TODO: Repeated code in while
-				uint32_t add = c2m->goto_count;
-
-				c2m_string_append(c2m->main, "C2M_WHILE");
-				while(add) {
-					char lnum = '0' + (add % 10);
-					add /= 10;
-					char dest[2];
-					dest[0] = lnum;
-					dest[1] = '\0';
-					c2m_string_append(c2m->main, dest);
-				}
-				//
-				c2m_string_append(c2m->main, ";\n");
-				c2m->block_count--;
-			}else{
-				c2m->in_main = 0;
-			}
+int main(int argc, char* argv[]) {
+	char** batch = NULL;
+	uint32_t n_batch = 0;
+	uint8_t watch = 0;
+	uint8_t index = 0;
+	const char* bench_filter = NULL; // --bench=<part of a name>
+	char** run_args = NULL; // c2m run's, for the program
+	c2m_t c2m;
+
+	c2m_init(&c2m, NULL);
+	c2m.remote = getenv("C2M_REMOTE_CACHE");
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--emit-only") == 0) {
+			c2m.emit_only = 1;
+		}else if(strncmp(argv[i], "--backend=", 10) == 0) {
+			c2m.backend = c2m_backend_find(argv[i] + 10);
+			if(c2m.backend == NULL) c2m_abort("Unknown backend");
+		}else if(strcmp(argv[i], "--split") == 0) {
+			// Units are cached in .c2m-build instead.
+			c2m.split = 1;
+			c2m.use_cache = 0;
+		}else if(strcmp(argv[i], "--lto") == 0) {
+			c2m.lto = 1;
+		}else if(strcmp(argv[i], "--distcc") == 0) {
+			// On other machines, so units & not one big one.
+			c2m.distcc = 1;
+			c2m.split = 1;
+			c2m.use_cache = 0;
+		}else if(strcmp(argv[i], "--debug") == 0) {
+			c2m.debug = 1;
+		}else if(strcmp(argv[i], "--profile") == 0) {
+			c2m.profile = 1;
+		}else if(strncmp(argv[i], "--bench", 7) == 0 &&
+			(argv[i][7] == '\0' || argv[i][7] == '='))
+		{
+			c2m.bench = 1;
+			if(argv[i][7]) bench_filter = &argv[i][8];
+		}else if(strncmp(argv[i], "-j", 2) == 0) {
+			const char* jobs = argv[i][2] ? &argv[i][2] :
+				(i + 1 < argc ? argv[++i] : "");
+
+			c2m.jobs = atoi(jobs);
+			if(c2m.jobs == 0) c2m_abort("-j needs a job count");
+		}else if(strncmp(argv[i], "-L", 2) == 0) {
+			const char* dir = argv[i][2] ? &argv[i][2] :
+				(i + 1 < argc ? argv[++i] : "");
+
+			if(dir[0] == '\0') c2m_abort("-L needs a directory");
+			*(const char**)cl_array_add(c2m.lib_path) = dir;
+		}else if(strcmp(argv[i], "--pgo-generate") == 0) {
+			c2m.pgo = C2M_PGO_GENERATE;
+		}else if(strncmp(argv[i], "--pgo-use", 9) == 0 &&
+			(argv[i][9] == '\0' || argv[i][9] == '='))
+		{
+			const char* profile = argv[i][9] ? &argv[i][10] :
+				(i + 1 < argc ? argv[++i] : "");
+
+			if(profile[0] == '\0') c2m_abort("--pgo-use needs a profile");
+			c2m.pgo = C2M_PGO_USE;
+			c2m.pgo_profile = profile;
+		}else if(strcmp(argv[i], "--index") == 0) {
+			index = 1;
+		}else if(strcmp(argv[i], "--prelude") == 0) {
+			c2m.use_prelude = 1;
+		}else if(strcmp(argv[i], "--no-cache") == 0) {
+			c2m.use_cache = 0;
+		}else if(strncmp(argv[i], "--remote-cache=", 15) == 0) {
+			c2m.remote = argv[i][15] ? &argv[i][15] : NULL;
+		}else if(strcmp(argv[i], "--stats") == 0) {
+			c2m.stats = 1;
+			c2m.intern->counting = 1;
+		}else if(strcmp(argv[i], "--time-report") == 0) {
+			c2m_time_enable();
+		}else if(strncmp(argv[i], "--trace=", 8) == 0) {
+			c2m_trace_start(&argv[i][8]);
+		}else if(strncmp(argv[i], "--mem-report", 12) == 0 &&
+			(argv[i][12] == '\0' || argv[i][12] == '='))
+		{
+			c2m_mem_enable(argv[i][12] ? (uint32_t)atoi(&argv[i][13]) : 0);
+		}else if(strncmp(argv[i], "--log", 5) == 0 &&
+			(argv[i][5] == '\0' || argv[i][5] == '='))
+		{
+			c2m_log_enable(argv[i][5] ? (uint8_t)atoi(&argv[i][6]) : 1);
+		}else if(strcmp(argv[i], "--watch") == 0) {
+			watch = 1;
+		}else if(strcmp(argv[i], "run") == 0) {
+			// The rest are the program's.
+			c2m.run = 1;
+			run_args = &argv[i + 1];
+			break;
+		}else if(strcmp(argv[i], "--batch") == 0) {
+			// The rest are project directories.
+			batch = &argv[i + 1];
+			n_batch = argc - i - 1;
+			break;
 		}else{
-			c2m_infunc(c2m, i, string, c2m->main);
+			printf("Unknown option: %s\n", argv[i]);
+			c2m_abort("Unknown command line option");
 		}
-	}else if(c2m->in_func) {
-		c2m_infunc(c2m, i, string, c2m->functions);
-	}else if(c2m_expect(i, string, "main(") == 0) {
-		c2m_skip_whitespace(i, string);
-		if(c2m_expect(i, string, "list_t args")) {
-			c2m_abort("Expected \"list_t args\" after \"main(\"");
-		}
-		c2m_skip_whitespace(i, string);
-		if(c2m_expect(i, string, ")")) {
-			c2m_abort("Expected \")\" after \"list_t args\"");
-		}
-		c2m_skip_whitespace(i, string);
-		if(c2m_expect(i, string, "{\n")) {
-			c2m_abort("Expected \"{\\n\" after \")\"");
-		}
-		c2m->in_main = 1;
-	}else if(c2m_expect(i, string, "\n") == 0) {
-	}else{
-		c2m_skip_whitespace(i, string);
-		printf("Error: %s", &(string[*i]));
-		printf("Error: %d", string[*i]);
-		c2m_abort("Unable to process text");
 	}
-}
-
-void c2m_compile(c2m_t* c2m) {
-	fputs("Compiling ", stdout);
-	fputs(c2m->name, stdout);
-	fputs(" version ", stdout);
-	fputs(c2m->version, stdout);
-	fputs("\n", stdout);
-	SDL_RWops *output;
-	SDL_RWops *input;
-
-	if((output = SDL_RWFromFile("main.c", "w+")) == NULL) {
-		c2m_abort("couldn't create output file");
+	c2m_timer_t timer;
+
+	if(c2m.run && (watch || c2m.bench || c2m.pgo == C2M_PGO_GENERATE))
+		c2m_abort("c2m run can't --watch, --bench or --pgo-generate");
+	if(index) {
+		// Index every directory on the search path, then stop.
+		c2m_gconfig(&c2m);
+		c2m_library_init(&c2m);
+		for(uint32_t i = 0; i < cl_array_count(c2m.lib_dirs); i++) {
+			c2m_libdir_t* dir = cl_array_borrow(c2m.lib_dirs, i);
+
+			c2m_library_index(&c2m, dir->path);
+		}
+		return 0;
 	}
-	if((input = SDL_RWFromFile("src/main.c2m", "rb")) == NULL) {
-		c2m_abort("couldn't open input file");
+	if(c2m.use_cache) c2m_cache_compiler(&c2m, argv[0]);
+	if(watch) {
+		c2m_watch(&c2m);
+		c2m_intern_destroy(c2m.intern);
+		return 0;
 	}
-	uint64_t size = SDL_RWsize(input);
-	char filecontents[size + 1];
+	if(batch) {
+		uint32_t failed = c2m_batch(&c2m, batch, n_batch);
 
-	SDL_RWread(input, filecontents, size, 1);
-	SDL_RWclose(input);
+		c2m_intern_destroy(c2m.intern);
 
-	c2m->functions = c2m_string_create(NULL);
-	c2m->libfuncs = c2m_string_create(NULL);
-	c2m->main = c2m_string_create(NULL);
-	c2m->varnames = c2m_string_create(NULL);
-	c2m->in_main = 0;
-	c2m->in_func = 0;
-	c2m->return_success = 1;
-	c2m->imports = NULL;
-	c2m->libreq.stdio = 0;
-	c2m->libreq.stdlib = 0;
-	c2m->libreq.clump = 0;
-	c2m->libreq.sdl = 0;
-	c2m->libreq.sdl_window = 0;
-	c2m->libreq.sdl_audio = 0;
-	c2m->goto_count = 0;
-	c2m->block_count = 0;
-	for(int32_t i = 0; i < size;) {
-		c2m_loop(c2m, &i, filecontents);
+		if(c2m_trace_flush()) fputs("Couldn't write the trace\n", stdout);
+		if(c2m_time_enabled) c2m_time_report();
+		if(c2m_mem_enabled) c2m_mem_report();
+		return failed != 0;
 	}
-	c2m_func_t* current = c2m->imports;
-	while(1) {
-		if(current == NULL) {
-			break;
-		}
-		struct cl_array * filename = c2m_string_create(NULL);
-		c2m_string_append(filename, "lib/");
-		c2m_string_append(filename, current->module);
-		c2m_string_append(filename, ".c2m");
-		fputs("Opening ", stdout);
-		fputs(filename->store, stdout);
-		fputs("\n", stdout);
-		if((input = SDL_RWFromFile(filename->store, "rb")) == NULL) {
-			c2m_abort("couldn't open input file");
-		}
-		uint64_t size = SDL_RWsize(input);
-		char libcontents[size + 1];
-		SDL_RWread(input, libcontents, size, 1);
-		SDL_RWclose(input);
-		for(int32_t i = 0; i < size;) {
-			c2m_import(c2m, &i, libcontents, current->module, current->function);
-		}
-		current = current->next;
+	if(c2m.pgo == C2M_PGO_GENERATE) {
+		c2m_pgo_build(&c2m);
+		if(c2m_trace_flush()) fputs("Couldn't write the trace\n", stdout);
+		if(c2m_time_enabled) c2m_time_report();
+		if(c2m_mem_enabled) c2m_mem_report();
+		return 0;
 	}
-	// Include requirements from C
-	c2m_output(output, "#include <stdint.h>\n"); // No matter what 32-64 compat
-	if(c2m->libreq.stdio) c2m_output(output, "#include <stdio.h>\n");
-	if(c2m->libreq.stdlib) c2m_output(output, "#include <stdlib.h>\n");
-	if(c2m->libreq.clump) c2m_output(output, "#include <c2m_clump.c>\n");
-	if(c2m->libreq.sdl) c2m_output(output, "#include <c2m_sdl.c>\n");
-	if(c2m->libreq.sdl_window) c2m_output(output, "#include <c2m_window.c>\n");
-	if(c2m->libreq.sdl_audio) c2m_output(output, "#include <c2m_audio.c>\n");
-	// Functions
-	if(c2m->functions->n_items) c2m_output(output, c2m->functions->store);
-	if(c2m->libfuncs->n_items) c2m_output(output, c2m->libfuncs->store);
-	c2m_output(output, "int main(int argc, char* argv[]){\n");
-	c2m_output(output, c2m->main->store);
-	c2m_output(output, c2m->return_success ?
-		"return 0; }\n" : "return 1; }\n");
-	SDL_RWclose(output);
-	fputs("Stage 2\n", stdout);
-	struct cl_array* clang_command = c2m_string_create(NULL);
-	c2m_string_append(clang_command, "clang -O3 main.c -o ");
-	c2m_string_append(clang_command, c2m->name);
-	system(clang_command->store);
-	fputs("Compiled\n", stdout);
-}
-
-int main(int argc, char* argv[]) {
-	c2m_t c2m;
+	c2m_time_begin(&timer);
 	c2m_gconfig(&c2m);
+	c2m_time_end(&timer, &c2m_phases[C2M_PHASE_CONFIG]);
 	c2m_compile(&c2m);
+	if(c2m_trace_flush()) fputs("Couldn't write the trace\n", stdout);
+	if(c2m_time_enabled) c2m_time_report();
+	if(c2m_mem_enabled) c2m_mem_report();
+	if(c2m.bench && c2m.emit_only == 0)
+		return c2m_bench_run(&c2m, bench_filter);
+	if(c2m.run && c2m.emit_only == 0) return c2m_run(&c2m, run_args);
 }